@@ -0,0 +1,37 @@
+// $approxCountDistinct and $approxPercentile estimate in fixed memory per group.
+load('jstests/aggregation/extras/utils.js');
+
+var t = db.approx_accumulators;
+t.drop();
+
+var bulk = t.initializeUnorderedBulkOp();
+for (var i = 0; i < 20000; i++) {
+    bulk.insert({day: i % 2, user: i % 5000, latency: i});
+}
+assert.writeOK(bulk.execute());
+
+var res = t.aggregate([{$group: {_id: "$day",
+                                 users: {$approxCountDistinct: "$user"},
+                                 median: {$approxPercentile: {input: "$latency", p: 0.5}},
+                                 p99: {$approxPercentile: {input: "$latency", p: 0.99}}}},
+                       {$sort: {_id: 1}}]).toArray();
+assert.eq(2, res.length);
+for (var day = 0; day < 2; day++) {
+    // Each day sees every other user.
+    assert.lte(Math.abs(res[day].users - 2500), 2500 * 0.06, tojson(res[day]));
+    assert.lte(Math.abs(res[day].median - 10000), 100, tojson(res[day]));
+    assert.lte(Math.abs(res[day].p99 - 19800), 100, tojson(res[day]));
+}
+
+// Groups without numbers have no percentile, and nothing distinct counts as zero.
+t.insert({day: 2, latency: "slow"});
+res = t.aggregate([{$match: {day: 2}},
+                   {$group: {_id: null,
+                             users: {$approxCountDistinct: "$user"},
+                             median: {$approxPercentile: {input: "$latency", p: 0.5}}}}]).toArray();
+assert.eq([{_id: null, users: NumberLong(0), median: null}], res);
+
+// p has to be between 0 and 1.
+assertErrorCode(t, [{$group: {_id: null, p: {$approxPercentile: {input: "$latency", p: 2}}}}],
+                28614);
+assertErrorCode(t, [{$group: {_id: null, p: {$approxPercentile: "$latency"}}}], 28613);
@@ -0,0 +1,38 @@
+// $group streams its input when it comes sorted on the group key. The results must be the same as
+// grouping everything at once, including for keys the sort order doesn't keep together, like
+// missing and null fields or arrays.
+
+var t = db.jstests_group_streaming;
+t.drop();
+
+for (var i = 0; i < 200; i++) {
+    t.insert({a: i % 7, b: i});
+}
+t.insert({b: 1000});
+t.insert({a: null, b: 2000});
+
+var pipeline = [{$group: {_id: "$a", total: {$sum: "$b"}, n: {$sum: 1}}}];
+
+function results(stages) {
+    var out = t.aggregate(stages).toArray();
+    out.sort(function(x, y) { return tojson(x._id) < tojson(y._id) ? -1 : 1; });
+    return out;
+}
+
+var expected = results(pipeline);
+assert.eq(8, expected.length);
+
+// With an index covering the group, the cursor returns documents in group key order.
+t.ensureIndex({a: 1, b: 1});
+var explain = t.aggregate(pipeline, {explain: true});
+assert.eq({a: 1}, explain.stages[0].$cursor.sort, tojson(explain));
+assert.eq(expected, results(pipeline));
+
+// A $sort on the group key lets the $group stream as well.
+t.dropIndexes();
+t.insert({a: [1, 2], b: 3000});
+t.insert({a: [1, 2], b: 4000});
+t.insert({a: [3], b: 5000});
+expected = results(pipeline);
+assert.eq(10, expected.length);
+assert.eq(expected, results([{$sort: {a: -1}}].concat(pipeline)));
@@ -0,0 +1,64 @@
+// $lookup joins each document to the documents of another collection with a matching field.
+
+var orders = db.jstests_lookup_orders;
+var items = db.jstests_lookup_items;
+orders.drop();
+items.drop();
+
+items.insert({_id: 1, sku: "a", tags: ["x", "y"]});
+items.insert({_id: 2, sku: "b", tags: ["y"]});
+items.insert({_id: 3, sku: "b"});
+items.insert({_id: 4, sku: null});
+items.insert({_id: 5});
+items.insert({_id: 6, sku: ["a", "c"]});
+items.insert({_id: 7, sku: 1.0});
+
+// Enough orders for several batches, each key repeated so the cache is used.
+for (var i = 0; i < 350; i++) {
+    orders.insert({_id: i, item: ["a", "b", "c", "d"][i % 4]});
+}
+orders.insert({_id: 1000}); // missing matches null and missing
+orders.insert({_id: 1001, item: 1}); // numbers match across types
+orders.insert({_id: 1002, item: ["a", "c"]}); // arrays match as a whole or as an element
+
+function lookUp(localField, foreignField) {
+    var results = orders.aggregate([
+        {$lookup: {from: items.getName(), localField: localField, foreignField: foreignField,
+                   as: "matches"}},
+        {$project: {ids: "$matches._id"}},
+        {$sort: {_id: 1}}
+    ]).toArray();
+
+    var byId = {};
+    results.forEach(function(doc) {
+        byId[doc._id] = doc.ids.sort();
+    });
+    return byId;
+}
+
+var joined = lookUp("item", "sku");
+assert.eq([1, 6], joined[0]);
+assert.eq([2, 3], joined[1]);
+assert.eq([6], joined[2]);
+assert.eq([], joined[3]);
+assert.eq([1, 6], joined[348]);
+assert.eq([4, 5], joined[1000]);
+assert.eq([7], joined[1001]);
+assert.eq([6], joined[1002]);
+
+// No order has a 'tag', which matches the items without 'tags' like null would.
+joined = lookUp("tag", "tags");
+assert.eq([3, 4, 5, 6, 7], joined[0]);
+
+// The join is also available in explain, and bad specs are rejected.
+var explain = orders.aggregate([{$lookup: {from: "x", localField: "a", foreignField: "b",
+                                           as: "c"}}],
+                               {explain: true});
+assert.eq({from: "x", as: "c", localField: "a", foreignField: "b"},
+          explain.stages[1].$lookup, tojson(explain));
+
+assert.commandFailed(orders.runCommand("aggregate", {pipeline: [{$lookup: {from: "x"}}]}));
+assert.commandFailed(orders.runCommand("aggregate",
+                                       {pipeline: [{$lookup: {from: "x", localField: "a",
+                                                              foreignField: "b", as: "c",
+                                                              bad: "d"}}]}));
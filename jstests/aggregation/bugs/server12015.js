@@ -0,0 +1,64 @@
+// Tests that an aggregation which only needs indexed fields gets a covered plan, and that it
+// returns the same results as one which fetches the documents.
+
+load("jstests/libs/analyze_plan.js");
+
+var coll = db.server12015;
+coll.drop();
+
+for (var i = 0; i < 100; i++) {
+    coll.insert({_id: i, a: i % 10, b: i, c: "c" + i});
+}
+assert.eq(null, db.getLastError());
+assert.commandWorked(coll.ensureIndex({a: 1, b: 1}));
+
+function winningPlan(pipeline) {
+    var explained = coll.runCommand("aggregate", {pipeline: pipeline, explain: true});
+    assert.commandWorked(explained);
+    return explained.stages[0].$cursor.queryPlanner.winningPlan;
+}
+
+function assertResults(pipeline, covered) {
+    var plan = winningPlan(pipeline);
+    assert.eq(covered, isIndexOnly(plan), tojson(plan));
+
+    // Forcing the documents to be fetched must not change the results.
+    var expected = coll.aggregate([{$project: {whole: "$$ROOT"}},
+                                   {$project: {_id: "$whole._id",
+                                               a: "$whole.a",
+                                               b: "$whole.b",
+                                               c: "$whole.c"}}].concat(pipeline)).toArray();
+    assert.eq(expected, coll.aggregate(pipeline).toArray(), tojson(pipeline));
+}
+
+// $group keyed on an indexed field
+assertResults([{$match: {a: {$gte: 2}}},
+               {$group: {_id: "$a", total: {$sum: "$b"}}},
+               {$sort: {_id: 1}}],
+              true);
+
+// $sort provided by the index
+assertResults([{$match: {a: {$gt: 0}}},
+               {$sort: {a: 1, b: 1}},
+               {$project: {_id: 0, a: 1, b: 1}}],
+              true);
+
+// $limit and $skip after the covered cursor
+assertResults([{$match: {a: 5}},
+               {$sort: {a: -1, b: -1}},
+               {$skip: 2},
+               {$limit: 3},
+               {$project: {_id: 0, b: 1}}],
+              true);
+
+// A field which is not in the index needs a fetch
+assertResults([{$match: {a: {$gte: 2}}},
+               {$group: {_id: "$a", last: {$max: "$c"}}},
+               {$sort: {_id: 1}}],
+              false);
+
+// So does _id
+assertResults([{$match: {a: 3}}, {$project: {a: 1}}], false);
+
+// So does a pipeline needing whole documents
+assertResults([{$match: {a: 3}}, {$sort: {a: 1, b: 1}}], false);
@@ -86,6 +86,14 @@ test(input,
      [{$project: {c: {$concat: ["hello there ", "_id"]}}}],
      [{_id:1, c:"hello there _id"}, {_id:2, c:"hello there _id"}, {_id:3, c:"hello there _id"}]);
 
+// indexes are built once the output is written, so a unique index it violates fails the $out
+// and leaves the old output alone
+output.ensureIndex({d:1}, {unique: true});
+assertErrorCode(input, [{$project: {d: {$literal: 1}}}, {$out: output.getName()}], 16995);
+assert.eq(output.find().toArray(),
+          [{_id:1, c:"hello there _id"}, {_id:2, c:"hello there _id"}, {_id:3, c:"hello there _id"}]);
+output.dropIndex({d:1});
+
 // test with capped collection
 cappedOutput.drop();
 db.createCollection(cappedOutput.getName(), {capped: true, size: 2});
@@ -238,5 +238,18 @@ RUNNING_IN_SHARDED_AGG_TEST = true; // global
 load("jstests/aggregation/bugs/server9444.js"); // external sort
 load("jstests/aggregation/bugs/server11675.js"); // text support
 
+// The merging half of a $group runs on one of the shards holding data, and on the same one each
+// time. Merges that read or write unsharded collections stay on the primary shard.
+var groupPipeline = [{$group: {_id: "$counter", total: {$sum: 1}}}];
+res = db.ts1.aggregate(groupPipeline, {explain: true});
+assert.commandWorked(res);
+assert("mergingShard" in res);
+assert(res.mergingShard in res.shards);
+assert.eq(res.mergingShard, db.ts1.aggregate(groupPipeline, {explain: true}).mergingShard);
+assert.eq(shardedAggTest.getDB("config").databases.findOne({_id: "aggShard"}).primary,
+          db.ts1.aggregate(groupPipeline.concat([{$out: "ts1_grouped"}]),
+                           {explain: true}).mergingShard);
+assert.eq(aggregateNoOrder(db.ts1, groupPipeline).length, db.ts1.distinct("counter").length);
+
 // shut everything down
 shardedAggTest.stop();
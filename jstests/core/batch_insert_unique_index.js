@@ -0,0 +1,56 @@
+// Batched inserts into a collection with unique indexes, which insert each index's keys for the
+// whole batch in key order, report duplicates within the batch and against existing documents
+// on the right document, and leave no keys behind for documents that failed.
+(function() {
+    "use strict";
+    var coll = db.batch_insert_unique_index;
+    coll.drop();
+
+    assert.commandWorked(coll.ensureIndex({a: 1}, {unique: true}));
+    assert.commandWorked(coll.ensureIndex({b: 1}));
+    assert.commandWorked(coll.ensureIndex({c: 1}, {unique: true, sparse: true}));
+
+    // Keys arriving out of order, with an array making one document multikey.
+    var docs = [];
+    for (var i = 0; i < 50; i++) {
+        docs.push({_id: i, a: (i * 37) % 50, b: [i, i + 100]});
+    }
+    var res = coll.insert(docs);
+    assert.writeOK(res);
+    assert.eq(50, coll.count());
+    assert.eq(50, coll.find().hint({a: 1}).itcount());
+    assert.eq(100, coll.find({b: {$gte: 0}}).hint({b: 1}).itcount());
+
+    // A duplicate within an ordered batch stops it at the second document with the key.
+    docs = [];
+    for (var i = 100; i < 120; i++) {
+        docs.push({_id: i, a: i});
+    }
+    docs[10].a = 105;
+    res = coll.insert(docs);
+    assert.eq(10, res.nInserted, tojson(res));
+    assert.eq(1, res.getWriteErrorCount());
+    assert.eq(10, res.getWriteErrorAt(0).index);
+    assert.eq(ErrorCodes.DuplicateKey, res.getWriteErrorAt(0).code);
+    assert.eq(60, coll.find().hint({a: 1}).itcount());
+
+    // An unordered batch inserts everything else, including around a duplicate of an existing
+    // document.
+    docs = [];
+    for (var i = 200; i < 220; i++) {
+        docs.push({_id: i, a: i, c: i});
+    }
+    docs[3].c = 210;
+    docs[7].a = 1;
+    res = coll.insert(docs, {ordered: false});
+    assert.eq(18, res.nInserted, tojson(res));
+    assert.eq(2, res.getWriteErrorCount());
+    assert.eq(78, coll.count());
+    assert.eq(78, coll.find().hint({a: 1}).itcount());
+    assert.eq(18, coll.find({c: {$exists: true}}).hint({c: 1}).itcount());
+    assert.eq(1, coll.find({c: 210}).itcount());
+    assert.eq(1, coll.find({a: 1}).itcount());
+
+    var validate = coll.validate(true);
+    assert(validate.valid, tojson(validate));
+})();
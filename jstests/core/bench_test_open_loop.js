@@ -0,0 +1,37 @@
+// Tests benchRun's open-loop mode, latency percentiles and interval stats.
+
+t = db.bench_test_open_loop;
+t.drop();
+
+t.insert( { _id : 1 , x : 1 } );
+
+seconds = 2;
+
+benchArgs = { ops : [ { op : "findOne" , ns : t.getFullName() , query : { _id : 1 } , rate : 100 } ,
+                      { op : "update" , ns : t.getFullName() , query : { _id : 1 } ,
+                        update : { $inc : { x : 1 } } , rate : 50 } ] ,
+              parallel : 2 , seconds : seconds , intervalSeconds : 0.5 ,
+              host : db.getMongo().host };
+
+if (jsTest.options().auth) {
+    benchArgs['db'] = 'admin';
+    benchArgs['username'] = jsTest.options().adminUser;
+    benchArgs['password'] = jsTest.options().adminPassword;
+}
+res = benchRun( benchArgs );
+
+assert( res.openLoop , "A1" );
+
+// The ops are issued on a schedule, so their counts are close to rate * seconds.
+assert.lte( res.opLatencies.findOne.count , 100 * seconds * 1.5 , "B1" );
+assert.gte( res.opLatencies.findOne.count , 100 * seconds * 0.5 , "B2" );
+assert.lte( res.opLatencies.update.count , 50 * seconds * 1.5 , "B3" );
+
+assert.lte( res.opLatencies.findOne.p50Micros , res.opLatencies.findOne.p99Micros , "C1" );
+assert.lte( res.opLatencies.findOne.p99Micros , res.opLatencies.findOne.maxMicros , "C2" );
+
+assert.gte( res.intervals.length , 1 , "D1" );
+
+// Either every op has a rate or none does.
+delete benchArgs.ops[1].rate;
+assert.throws( function() { benchRun( benchArgs ); } , [] , "E1" );
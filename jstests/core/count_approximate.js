@@ -0,0 +1,34 @@
+// A count with {approximate: true} over a single index range may be answered from the storage
+// engine's estimate of the range size. Engines that can't estimate fall back to an exact count.
+(function() {
+    "use strict";
+    var coll = db.count_approximate;
+    coll.drop();
+
+    assert.commandWorked(coll.ensureIndex({a: 1}));
+    for (var i = 0; i < 100; i++) {
+        assert.writeOK(coll.insert({a: i}));
+    }
+
+    var cmd = {count: coll.getName(), query: {a: {$gte: 10, $lt: 60}}, approximate: true};
+    var res = assert.commandWorked(db.runCommand(cmd));
+    assert.gte(res.n, 0);
+    assert.lte(res.n, 100);
+
+    var explain = assert.commandWorked(db.runCommand({explain: cmd,
+                                                      verbosity: "executionStats"}));
+    var countStage = explain.executionStats.executionStages;
+    assert.eq("COUNT", countStage.stage);
+    if (!countStage.estimated) {
+        assert.eq(50, countStage.nCounted);
+    }
+
+    // Limit still bounds an estimated count.
+    cmd.limit = 5;
+    assert.lte(assert.commandWorked(db.runCommand(cmd)).n, 5);
+
+    // Without the flag the count is exact.
+    assert.eq(50, coll.count({a: {$gte: 10, $lt: 60}}));
+
+    assert.commandFailed(db.runCommand({count: coll.getName(), approximate: 1}));
+})();
@@ -0,0 +1,47 @@
+// dbHash hashes several collections at once, and gives the same per-collection hashes with
+// yielding scans and with either hash algorithm, whatever order the collections finish in.
+(function() {
+    "use strict";
+    var mydb = db.getSisterDB("dbhash_parallel");
+    mydb.dropDatabase();
+
+    for (var i = 0; i < 10; i++) {
+        var bulk = mydb["c" + i].initializeUnorderedBulkOp();
+        for (var j = 0; j < i * 100; j++) {
+            bulk.insert({_id: j, x: i * j});
+        }
+        if (i > 0) {
+            assert.writeOK(bulk.execute());
+        }
+        else {
+            assert.commandWorked(mydb.createCollection("c0"));
+        }
+    }
+
+    var md5 = assert.commandWorked(mydb.runCommand({dbHash: 1}));
+    assert.eq(10, Object.keySet(md5.collections).length, tojson(md5));
+    assert.eq(md5, assert.commandWorked(mydb.runCommand({dbHash: 1, algorithm: "md5"})),
+              "md5 is the default");
+
+    var yielding = assert.commandWorked(mydb.runCommand({dbHash: 1, yield: true}));
+    assert.eq(md5.collections, yielding.collections);
+    assert.eq(md5.md5, yielding.md5);
+
+    var murmur = assert.commandWorked(mydb.runCommand({dbHash: 1, algorithm: "murmur3"}));
+    var murmurAgain = assert.commandWorked(mydb.runCommand({dbHash: 1, algorithm: "murmur3",
+                                                            yield: true}));
+    assert.eq(murmur.collections, murmurAgain.collections);
+    assert.neq(md5.collections.c5, murmur.collections.c5);
+    assert.neq(murmur.collections.c4, murmur.collections.c5);
+
+    // A change to one collection only changes its own hash.
+    assert.writeOK(mydb.c3.update({_id: 0}, {$set: {y: 1}}));
+    var changed = assert.commandWorked(mydb.runCommand({dbHash: 1, algorithm: "murmur3"}));
+    assert.neq(murmur.collections.c3, changed.collections.c3);
+    assert.eq(murmur.collections.c4, changed.collections.c4);
+
+    assert.commandFailed(mydb.runCommand({dbHash: 1, algorithm: "sha1"}));
+    assert.commandFailed(mydb.runCommand({dbHash: 1, algorithm: 1}));
+
+    mydb.dropDatabase();
+})();
@@ -0,0 +1,48 @@
+// distinct uses a DISTINCT index scan for a multikey field and for an indexed field that follows
+// equality-bound fields, and falls back to fetching when the keys can't give every value.
+(function() {
+    "use strict";
+    var coll = db.distinct_multikey_suffix;
+    coll.drop();
+
+    function distinct(key, query) {
+        return assert.commandWorked(coll.runCommand("distinct", {key: key, query: query}));
+    }
+
+    function sorted(arr) {
+        return arr.sort(function(x, y) { return x - y; });
+    }
+
+    for (var i = 0; i < 50; i++) {
+        assert.writeOK(coll.insert({a: i % 5, b: i % 7, tags: [i % 3, (i % 3) + 10]}));
+    }
+
+    // Suffix field under an equality prefix.
+    assert.commandWorked(coll.ensureIndex({a: 1, b: 1}));
+    var res = distinct("b", {a: 2});
+    assert.eq([0, 1, 2, 3, 4, 5, 6], sorted(res.values));
+    assert.eq(0, res.stats.nscannedObjects);
+    assert(/^DISTINCT/.test(res.stats.planSummary), tojson(res.stats));
+
+    // A range on the prefix can't skip by the suffix field.
+    res = distinct("b", {a: {$gte: 3}});
+    assert.eq([0, 1, 2, 3, 4, 5, 6], sorted(res.values));
+    assert(!/^DISTINCT/.test(res.stats.planSummary), tojson(res.stats));
+
+    // Multikey index, with and without a query on the equality prefix.
+    assert.commandWorked(coll.ensureIndex({tags: 1}));
+    res = distinct("tags", {});
+    assert.eq([0, 1, 2, 10, 11, 12], sorted(res.values));
+    assert(/^DISTINCT/.test(res.stats.planSummary), tojson(res.stats));
+
+    assert.commandWorked(coll.ensureIndex({a: 1, tags: 1}));
+    res = distinct("tags", {a: 1});
+    assert.eq([0, 1, 2, 10, 11, 12], sorted(res.values));
+    assert.eq(0, res.stats.nscannedObjects);
+    assert(/^DISTINCT/.test(res.stats.planSummary), tojson(res.stats));
+
+    // Bounds on the multikey field would hide the other elements of matching arrays.
+    res = distinct("tags", {a: 1, tags: 0});
+    assert.eq([0, 10], sorted(res.values));
+    assert(!/^DISTINCT/.test(res.stats.planSummary), tojson(res.stats));
+})();
@@ -0,0 +1,22 @@
+// Explain's executionStats report what the storage engine did for the operation.
+
+var t = db.explain_storage_stats;
+t.drop();
+
+for (var i = 0; i < 100; i++) {
+    t.insert({ _id: i, a: i });
+}
+
+var explain = t.find({ a: { $gte: 50 } }).explain("executionStats");
+assert.commandWorked(explain);
+
+var storageStats = explain.executionStats.storageStats;
+assert(storageStats, tojson(explain.executionStats));
+["bytesRead", "cacheMisses", "ioWaitMicros"].forEach(function(field) {
+    assert(storageStats.hasOwnProperty(field), tojson(storageStats));
+    assert.gte(storageStats[field], 0, tojson(storageStats));
+});
+
+// The counters don't go into the queryPlanner verbosity.
+explain = t.find({ a: { $gte: 50 } }).explain("queryPlanner");
+assert(!explain.hasOwnProperty("executionStats"), tojson(explain));
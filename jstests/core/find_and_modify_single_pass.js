@@ -0,0 +1,57 @@
+// findAndModify returns the document it updates or removes from the same plan that changes it.
+// Check that the document picked follows the sort, and that the returned images are right.
+(function() {
+    "use strict";
+    var coll = db.find_and_modify_single_pass;
+    coll.drop();
+
+    assert.commandWorked(coll.ensureIndex({priority: 1}));
+    for (var i = 0; i < 20; i++) {
+        assert.writeOK(coll.insert({_id: i, priority: (i * 7) % 20, state: "ready", n: 0}));
+    }
+
+    // The pre-image of the highest priority ready document.
+    var doc = coll.findAndModify({query: {state: "ready"},
+                                  sort: {priority: -1},
+                                  update: {$set: {state: "taken"}, $inc: {n: 1}}});
+    assert.eq({_id: 17, priority: 19, state: "ready", n: 0}, doc);
+
+    // The post-image of the next one, through a projection.
+    doc = coll.findAndModify({query: {state: "ready"},
+                              sort: {priority: -1},
+                              update: {$set: {state: "taken"}, $inc: {n: 1}},
+                              fields: {state: 1, n: 1},
+                              new: true});
+    assert.eq({_id: 14, state: "taken", n: 1}, doc);
+    assert.eq(2, coll.count({state: "taken"}));
+
+    // A sort on an unindexed field, and a no-op update still returns the matched document.
+    doc = coll.findAndModify({query: {state: "ready"}, sort: {_id: 1}, update: {$set: {n: 0}}});
+    assert.eq(0, doc._id);
+
+    // Removes return the removed document and follow the sort too.
+    doc = coll.findAndModify({query: {state: "taken"}, sort: {priority: 1}, remove: true});
+    assert.eq(14, doc._id);
+    assert.eq(null, coll.findOne({_id: 14}));
+    assert.eq(19, coll.count());
+
+    // No match.
+    assert.eq(null, coll.findAndModify({query: {state: "none"}, update: {$inc: {n: 1}}}));
+    assert.eq(null, coll.findAndModify({query: {state: "none"}, remove: true}));
+
+    // Upserts return the inserted document if asked for the post-image, null otherwise.
+    doc = coll.findAndModify({query: {_id: 100}, update: {$set: {state: "new"}},
+                              upsert: true, new: true});
+    assert.eq({_id: 100, state: "new"}, doc);
+    assert.eq(null, coll.findAndModify({query: {_id: 101}, update: {$set: {state: "new"}},
+                                        upsert: true}));
+    assert.eq({_id: 101, state: "new"}, coll.findOne({_id: 101}));
+
+    var res = db.runCommand({findAndModify: coll.getName(),
+                             query: {_id: 102},
+                             update: {$set: {state: "new"}},
+                             upsert: true});
+    assert.commandWorked(res);
+    assert.eq(false, res.lastErrorObject.updatedExisting);
+    assert.eq(102, res.lastErrorObject.upserted);
+})();
@@ -0,0 +1,56 @@
+// Phrase searches over a text index with termPositions return the same documents as over a plain
+// text index, while fetching fewer documents that turn out not to contain the phrase.
+(function() {
+    "use strict";
+    var plain = db.fts_phrase_positions_plain;
+    var positions = db.fts_phrase_positions;
+    plain.drop();
+    positions.drop();
+
+    assert.commandWorked(plain.ensureIndex({a: "text"}));
+    assert.commandWorked(positions.ensureIndex({a: "text"}, {termPositions: true}));
+    assert.commandFailed(db.fts_phrase_positions_bad.ensureIndex({a: "text"},
+                                                                 {termPositions: "yes"}));
+    assert.commandFailed(db.fts_phrase_positions_bad.ensureIndex({a: "text"},
+                                                                 {termPositions: true,
+                                                                  textIndexVersion: 1}));
+
+    var words = ["table", "top", "chair", "leg", "the", "red", "wooden"];
+    var docs = [];
+    for (var i = 0; i < 500; i++) {
+        var text = [];
+        for (var j = 0; j < 3 + i % 11; j++) {
+            text.push(words[(i * 7 + j * j) % words.length]);
+        }
+        docs.push({_id: i, a: text.join(" ")});
+    }
+    docs.push({_id: 500, a: ["red table", "top chair"]});
+    docs.push({_id: 501, a: "table " + Array(40).join("table ") + "top"});
+    docs.forEach(function(doc) {
+        assert.writeOK(plain.insert(doc));
+        assert.writeOK(positions.insert(doc));
+    });
+
+    function ids(coll, search) {
+        return coll.find({$text: {$search: search}}, {_id: 1}).sort({_id: 1}).toArray();
+    }
+
+    ["\"table top\"",
+     "\"the table\"",
+     "\"red wooden chair\"",
+     "chair \"table top\"",
+     "\"table top\" -leg",
+     "table -\"table top\"",
+     "\"top table\" \"chair leg\""].forEach(function(search) {
+        assert.eq(ids(plain, search), ids(positions, search), search);
+    });
+
+    // A phrase can't span two strings of an array.
+    assert.eq([], positions.find({_id: 500, $text: {$search: "\"table top\""}}).toArray());
+
+    function docsExamined(coll, search) {
+        return coll.find({$text: {$search: search}}).explain("executionStats")
+                   .executionStats.totalDocsExamined;
+    }
+    assert.lt(docsExamined(positions, "\"top table\""), docsExamined(plain, "\"top table\""));
+})();
@@ -0,0 +1,69 @@
+// A text search sorted by score with a limit returns the same best results, with the same scores,
+// as the full search, while reading fewer index keys.
+(function() {
+    "use strict";
+    var coll = db.fts_score_sort_limit;
+    coll.drop();
+
+    assert.commandWorked(coll.ensureIndex({a: "text"}, {default_language: "none"}));
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 2000; i++) {
+        var words = [];
+        for (var j = 0; j < i % 23; j++) {
+            words.push("common");
+        }
+        for (var j = 0; j < i % 7; j++) {
+            words.push("rare");
+        }
+        words.push("filler" + (i % 31));
+        bulk.insert({_id: i, a: words.join(" "), b: i % 2});
+    }
+    assert.writeOK(bulk.execute());
+
+    function findTextStage(stage) {
+        if (stage.stage === "TEXT") {
+            return stage;
+        }
+        var children = stage.inputStages || (stage.inputStage ? [stage.inputStage] : []);
+        for (var i = 0; i < children.length; i++) {
+            var found = findTextStage(children[i]);
+            if (found) {
+                return found;
+            }
+        }
+        return null;
+    }
+
+    function scores(query, limit) {
+        var cursor = coll.find(query, {score: {$meta: "textScore"}})
+                         .sort({score: {$meta: "textScore"}});
+        if (limit) {
+            cursor = cursor.limit(limit);
+        }
+        return cursor.toArray().map(function(doc) { return doc.score; });
+    }
+
+    [{$text: {$search: "common"}},
+     {$text: {$search: "common rare"}},
+     {$text: {$search: "rare common common"}},
+     {$text: {$search: "common rare"}, b: 1}].forEach(function(query) {
+        var all = scores(query);
+        [1, 10, 100].forEach(function(limit) {
+            assert.eq(all.slice(0, limit), scores(query, limit), tojson(query));
+        });
+    });
+
+    // A single common term stops reading early.
+    var query = {$text: {$search: "common"}};
+    var proj = {score: {$meta: "textScore"}};
+    var explain = coll.find(query, proj).sort({score: {$meta: "textScore"}}).limit(5)
+                      .explain("executionStats");
+    var text = findTextStage(explain.executionStats.executionStages);
+    assert.neq(null, text, tojson(explain));
+    assert.lt(text.keysExamined, coll.find(query).itcount(), tojson(text));
+
+    // Negated terms can only be checked once documents are fetched, so every key is read.
+    var negated = {$text: {$search: "common -rare"}};
+    assert.eq(scores(negated).slice(0, 10), scores(negated, 10));
+})();
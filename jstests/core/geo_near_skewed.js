@@ -0,0 +1,54 @@
+// $near over very unevenly spread points - a dense cluster, then nothing for a long way, then a
+// few outliers - returns the nearest documents in order, with and without a limit, as the search
+// annuli grow and shrink to fit the results found.
+(function() {
+    "use strict";
+    var coll = db.geo_near_skewed;
+
+    // Spherical distances are close enough to flat ones here to only need checking for "2d".
+    function checkSorted(test, docs, center) {
+        if (test.type !== "2d") {
+            return;
+        }
+        for (var i = 1; i < docs.length; i++) {
+            assert.lte(Math.sqrt(Math.pow(docs[i - 1].loc[0] - center[0], 2) +
+                                 Math.pow(docs[i - 1].loc[1] - center[1], 2)),
+                       Math.sqrt(Math.pow(docs[i].loc[0] - center[0], 2) +
+                                 Math.pow(docs[i].loc[1] - center[1], 2)));
+        }
+    }
+
+    [{type: "2d", near: "$near"}, {type: "2dsphere", near: "$nearSphere"}].forEach(function(test) {
+        coll.drop();
+        assert.commandWorked(coll.ensureIndex({loc: test.type}));
+
+        var bulk = coll.initializeUnorderedBulkOp();
+        for (var i = 0; i < 2000; i++) {
+            bulk.insert({loc: [(i % 40) / 1000, Math.floor(i / 40) / 1000]});
+        }
+        for (var i = 0; i < 5; i++) {
+            bulk.insert({loc: [60 + i, 40 + i]});
+        }
+        assert.writeOK(bulk.execute());
+
+        var center = [0.02, 0.025];
+        var query = {loc: {}};
+        query.loc[test.near] = center;
+
+        // Small limits, stopping inside the cluster.
+        [1, 5, 100].forEach(function(limit) {
+            var docs = coll.find(query, {_id: 0}).limit(limit).toArray();
+            assert.eq(limit, docs.length);
+            checkSorted(test, docs, center);
+        });
+
+        // Crossing the empty region to the outliers, which come last.
+        var docs = coll.find(query, {_id: 0}).limit(2005).toArray();
+        assert.eq(2005, docs.length);
+        checkSorted(test, docs, center);
+        assert.eq([64, 44], docs[2004].loc);
+
+        // A batch size rather than a limit still returns everything.
+        assert.eq(2005, coll.find(query).batchSize(10).itcount());
+    });
+})();
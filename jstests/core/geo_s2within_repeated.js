@@ -0,0 +1,39 @@
+// Repeating a $geoWithin or $geoIntersects query, whose covering is then reused, and testing
+// points well inside the region, which skip the exact containment test, return the same
+// documents as the first run.
+(function() {
+    "use strict";
+    var coll = db.geo_s2within_repeated;
+    coll.drop();
+
+    assert.commandWorked(coll.ensureIndex({loc: "2dsphere"}));
+    for (var x = 0; x < 20; x++) {
+        for (var y = 0; y < 20; y++) {
+            assert.writeOK(coll.insert({loc: {type: "Point", coordinates: [x / 2, y / 2]}}));
+        }
+    }
+    // A document with several points, whose cells are indexed together.
+    assert.writeOK(coll.insert({loc: {type: "MultiPoint", coordinates: [[2.1, 2.1], [2.2, 2.2]]}}));
+
+    var square = {type: "Polygon",
+                  coordinates: [[[0.9, 0.9], [4.2, 0.9], [4.2, 4.2], [0.9, 4.2], [0.9, 0.9]]]};
+    var within = {loc: {$geoWithin: {$geometry: square}}};
+    var intersects = {loc: {$geoIntersects: {$geometry: square}}};
+
+    // Points 1, 1.5, ..., 4 on each axis, and the multipoint.
+    for (var i = 0; i < 3; i++) {
+        assert.eq(50, coll.find(within).itcount());
+        assert.eq(50, coll.find(intersects).itcount());
+    }
+
+    // The same polygon starting from another vertex is a different cache entry, with the same
+    // results.
+    var rotated = {type: "Polygon",
+                   coordinates: [[[4.2, 0.9], [4.2, 4.2], [0.9, 4.2], [0.9, 0.9], [4.2, 0.9]]]};
+    assert.eq(50, coll.find({loc: {$geoWithin: {$geometry: rotated}}}).itcount());
+
+    // A smaller region doesn't pick up the larger one's covering.
+    var small = {type: "Polygon", coordinates: [[[1.9, 1.9], [2.6, 1.9], [2.6, 2.6], [1.9, 2.6],
+                                                 [1.9, 1.9]]]};
+    assert.eq(5, coll.find({loc: {$geoWithin: {$geometry: small}}}).itcount());
+})();
@@ -0,0 +1,37 @@
+// Hashed indexes can be built with the MurmurHash3 based hashVersion 1.
+
+var t = db.hashindex_version;
+t.drop();
+
+for ( var i = 0; i < 100; i++ ) {
+    t.insert( { a : i , b : { c : i } } );
+}
+t.insert( { b : 1 } );
+
+assert.commandWorked( t.ensureIndex( { a : "hashed" } , { hashVersion : 1 } ) );
+assert.commandWorked( t.ensureIndex( { b : "hashed" } ) );
+assert.commandFailed( t.ensureIndex( { a : "hashed" } , { name : "v2" , hashVersion : 2 } ) );
+
+var idx = t.getIndexes().filter( function( i ) { return i.name == "a_hashed"; } )[0];
+assert.eq( 1 , idx.hashVersion );
+
+// Point queries and missing fields use the index's hash function.
+for ( var i = 0; i < 100; i += 7 ) {
+    assert.eq( 1 , t.find( { a : i } ).hint( { a : "hashed" } ).itcount() );
+    assert.eq( 1 , t.find( { a : NumberLong( i ) } ).hint( { a : "hashed" } ).itcount() );
+}
+assert.eq( 1 , t.find( { a : null } ).hint( { a : "hashed" } ).itcount() );
+assert.eq( 1 , t.find( { b : { c : 5 } } ).hint( { b : "hashed" } ).itcount() );
+
+// The new hash function differs from MD5 but still squashes numeric types.
+if ( db.adminCommand( "getParameter" , { enableTestCommands : 1 } ) ) {
+    var hash = function( v , version ) {
+        return db.runCommand( { _hashBSONElement : v , hashVersion : version } ).out;
+    };
+    var res = db.runCommand( { _hashBSONElement : 1 , hashVersion : 1 } );
+    if ( res.ok ) {
+        assert.neq( hash( 3 , 0 ) , hash( 3 , 1 ) );
+        assert.eq( hash( NumberInt( 3 ) , 1 ) , hash( NumberLong( 3 ) , 1 ) );
+        assert.eq( hash( 3.2 , 1 ) , hash( 3 , 1 ) );
+    }
+}
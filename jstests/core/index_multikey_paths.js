@@ -0,0 +1,27 @@
+// Bounds on the fields of a multikey index which don't hold arrays can still be intersected.
+(function() {
+    "use strict";
+    var coll = db.index_multikey_paths;
+    coll.drop();
+
+    function keysExamined(query) {
+        return coll.find(query).explain("executionStats").executionStats.totalKeysExamined;
+    }
+
+    assert.commandWorked(coll.ensureIndex({a: 1, b: 1}));
+    for (var i = 0; i < 100; i++) {
+        assert.writeOK(coll.insert({a: i, b: [i, i + 1]}));
+    }
+
+    // Only 'b' is multikey, so the range on 'a' is tight.
+    assert.eq(9, coll.find({a: {$gt: 10, $lt: 20}}).itcount());
+    assert.lte(keysExamined({a: {$gt: 10, $lt: 20}}), 20);
+
+    // The range on 'b' must not be intersected: each bound is met by a different element.
+    assert.eq(1, coll.find({a: 15, b: {$gt: 15.5, $lt: 15.2}}).itcount());
+
+    // Once 'a' holds an array too, neither is its range.
+    assert.writeOK(coll.insert({a: [11, 50], b: 3}));
+    assert.eq(10, coll.find({a: {$gt: 10, $lt: 20}}).itcount());
+    assert.eq(1, coll.find({a: {$gt: 40, $lt: 15}}).itcount());
+})();
@@ -0,0 +1,78 @@
+// Partial indexes only hold the documents matching their partialFilterExpression, and are only
+// used by queries which imply that filter.
+load("jstests/libs/analyze_plan.js");
+
+(function() {
+    "use strict";
+    var coll = db.index_partial;
+    coll.drop();
+
+    function numKeys(indexName) {
+        var res = coll.validate();
+        assert.commandWorked(res);
+        return res.keysPerIndex[coll.getFullName() + ".$" + indexName];
+    }
+
+    function usesIndex(query) {
+        var explain = coll.find(query).explain();
+        return isIxscan(explain.queryPlanner.winningPlan);
+    }
+
+    // Bad specs are rejected.
+    assert.commandFailed(coll.createIndex({a: 1}, {partialFilterExpression: 5}));
+    assert.commandFailed(coll.createIndex({a: 1}, {partialFilterExpression: {a: {$exists: true}},
+                                                   sparse: true}));
+    assert.commandFailed(coll.createIndex({a: 1}, {partialFilterExpression: {$or: [{a: 1}]}}));
+    assert.commandFailed(coll.createIndex({a: 1}, {partialFilterExpression: {a: /x/}}));
+    assert.commandFailed(coll.createIndex({a: 1},
+                                          {partialFilterExpression: {a: {$exists: false}}}));
+
+    // Documents are only indexed while they match the filter.
+    for (var i = 0; i < 10; i++) {
+        assert.writeOK(coll.insert({_id: i, a: i, status: i < 3 ? "active" : "done"}));
+    }
+    assert.commandWorked(coll.createIndex({a: 1}, {partialFilterExpression: {status: "active"}}));
+    assert.eq(3, numKeys("a_1"));
+
+    assert.writeOK(coll.insert({_id: 10, a: 10, status: "active"}));
+    assert.writeOK(coll.insert({_id: 11, a: 11}));
+    assert.eq(4, numKeys("a_1"));
+
+    assert.writeOK(coll.update({_id: 11}, {$set: {status: "active"}}));
+    assert.eq(5, numKeys("a_1"));
+    assert.writeOK(coll.update({_id: 0}, {$set: {status: "done"}}));
+    assert.eq(4, numKeys("a_1"));
+    assert.writeOK(coll.remove({_id: 1}));
+    assert.eq(3, numKeys("a_1"));
+    assert.writeOK(coll.remove({_id: 5}));
+    assert.eq(3, numKeys("a_1"));
+
+    // The index is only used, and gives complete results, when the query implies the filter.
+    assert(usesIndex({a: {$gt: 0}, status: "active"}));
+    assert.eq(3, coll.find({a: {$gt: 0}, status: "active"}).itcount());
+    assert(!usesIndex({a: {$gt: 0}}));
+    assert.eq(9, coll.find({a: {$gt: 0}}).itcount());
+    assert(!usesIndex({a: {$gt: 0}, status: "done"}));
+    assert.eq(6, coll.find({a: {$gt: 0}, status: "done"}).itcount());
+
+    // A query of the same shape with other values must not reuse a cached plan on the index.
+    assert.eq(3, coll.find({status: "active"}).sort({a: 1}).itcount());
+    assert.eq(7, coll.find({status: "done"}).sort({a: 1}).itcount());
+
+    // The index can't be hinted for queries it can't answer.
+    assert.throws(function() {
+        coll.find({a: {$gt: 0}}).hint({a: 1}).itcount();
+    });
+    assert.eq(3, coll.find({a: {$gt: 0}, status: "active"}).hint({a: 1}).itcount());
+
+    // Distinct doesn't use it to find values.
+    assert.eq(10, coll.distinct("a").length);
+
+    // Unique partial indexes only enforce uniqueness among the documents they hold.
+    coll.drop();
+    assert.commandWorked(coll.createIndex({a: 1}, {unique: true,
+                                                   partialFilterExpression: {b: {$gt: 0}}}));
+    assert.writeOK(coll.insert({a: 1, b: 1}));
+    assert.writeOK(coll.insert({a: 1, b: -1}));
+    assert.writeError(coll.insert({a: 1, b: 2}));
+})();
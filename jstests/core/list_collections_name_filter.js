@@ -0,0 +1,37 @@
+// listCollections filters which only look at the name give the same results as when every
+// collection's options are read.
+(function() {
+    "use strict";
+    var mydb = db.getSisterDB("list_collections_name_filter");
+    mydb.dropDatabase();
+
+    for (var i = 0; i < 20; i++) {
+        assert.commandWorked(mydb.createCollection("c" + i, i % 2 ? {capped: true, size: 4096}
+                                                                  : {}));
+    }
+
+    function names(filter, batchSize) {
+        var cmd = {listCollections: 1, filter: filter};
+        if (batchSize !== undefined) {
+            cmd.cursor = {batchSize: batchSize};
+        }
+        var res = assert.commandWorked(mydb.runCommand(cmd));
+        return new DBCommandCursor(mydb.getMongo(), res).toArray().map(function(c) {
+            return c.name;
+        });
+    }
+
+    assert.eq(["c3"], names({name: "c3"}));
+    assert.eq([], names({name: "missing"}));
+    assert.eq(["c1", "c3"], names({name: {$in: ["c3", "missing", "c1"]}}));
+    assert.eq(["c3"], names({name: {$in: ["c3", "c4"]}, "options.capped": true}));
+    assert.eq(["c1", "c10", "c11"], names({name: /^c1/}, 1).slice(0, 3));
+    assert.eq(["c2", "c3"], names({$or: [{name: "c2"}, {name: "c3"}]}));
+    assert.eq(10, names({"options.capped": true}).length);
+
+    // Options are still returned for collections matched on the name alone.
+    var res = assert.commandWorked(mydb.runCommand({listCollections: 1, filter: {name: "c1"}}));
+    assert.eq(true, res.cursor.firstBatch[0].options.capped, tojson(res));
+
+    mydb.dropDatabase();
+})();
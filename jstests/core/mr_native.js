@@ -0,0 +1,59 @@
+// Map and reduce functions of common shapes run without JavaScript; check they give the same
+// results as equivalent functions that don't have those shapes.
+
+var t = db.mr_native;
+t.drop();
+
+var keys = [ "a", "b", 1, 2.5, true, null, ObjectId(), new Date( 1000 ), NumberLong( 3 ), [ 1 ],
+             { x : 1 } ];
+var values = [ 1, -2.5, NumberInt( 4 ), 0, -0, NumberLong( 5 ), "str", NaN ];
+for ( var i = 0; i < 500; i++ ) {
+    var doc = { v : values[ i % values.length ], sub : { k : keys[ i % keys.length ] } };
+    if ( i % 7 != 0 )
+        doc.k = keys[ i % keys.length ];
+    if ( i % 13 == 0 )
+        doc.sub = 5;
+    t.insert( doc );
+}
+
+function check( map , reduce , jsMap , jsReduce , options ) {
+    function run( m , r ) {
+        var res = t.mapReduce( m , r , Object.extend( { out : { inline : 1 } } , options || {} ) );
+        assert.commandWorked( res );
+        return res.results.sort( function( x , y ) { return bsonWoCompare( x , y ); } );
+    }
+    assert.eq( tojson( run( jsMap , jsReduce ) ) , tojson( run( map , reduce ) ) ,
+               map + " " + reduce );
+}
+
+var maps = [
+    [ function() { emit( this.k , this.v ); },
+      function() { var key = this.k; emit( key , this.v ); } ],
+    [ function() { emit( this.sub.k , this.v ); },
+      function() { var key = this.sub.k; emit( key , this.v ); } ],
+    [ function() { emit( this.k , 1 ); },
+      function() { var one = 1; emit( this.k , one ); } ],
+];
+
+var reduces = [
+    [ function( k , vals ) { return Array.sum( vals ); },
+      function( k , vals ) { var s = vals[0]; for ( var i = 1; i < vals.length; i++ ) s += vals[i]; return s; } ],
+    [ function( k , vals ) { var total = 0; for ( var i = 0; i < vals.length; i++ ) { total += vals[i]; } return total; },
+      function( k , vals ) { var total = 0; var n = vals.length; for ( var i = 0; i < n; i++ ) total += vals[i]; return total; } ],
+    [ function( k , vals ) { var s = 0; vals.forEach( function( x ) { s += x; } ); return s; },
+      function( k , vals ) { var s = 0; vals.forEach( function( x ) { s = s + x; } ); return s; } ],
+    [ function( k , vals ) { return Math.max.apply( Math , vals ); },
+      function( k , vals ) { var m = Math.max; return m.apply( Math , vals ); } ],
+    [ function( k , vals ) { return Math.min.apply( null , vals ); },
+      function( k , vals ) { var m = Math.min; return m.apply( null , vals ); } ],
+];
+
+maps.forEach( function( m ) {
+    reduces.forEach( function( r ) {
+        check( m[0] , r[0] , m[1] , r[1] );
+    } );
+} );
+
+// Numeric values only, so every reduce runs natively, with a finalizer.
+check( maps[0][0] , reduces[0][0] , maps[0][1] , reduces[0][1] ,
+       { query : { v : { $type : 1 } } , finalize : function( k , v ) { return v * 2; } } );
@@ -0,0 +1,44 @@
+// Multi deletes remove their documents in batches, with each index's keys for the batch removed
+// together. Check that the indexes match the documents afterwards and that limited deletes stop
+// at their limit.
+(function() {
+    "use strict";
+    var coll = db.remove_multi_index_batch;
+    coll.drop();
+
+    assert.commandWorked(coll.ensureIndex({a: 1}));
+    assert.commandWorked(coll.ensureIndex({b: 1}));
+    assert.commandWorked(coll.ensureIndex({c: 1}, {partialFilterExpression: {c: {$gt: 50}}}));
+
+    var docs = [];
+    for (var i = 0; i < 500; i++) {
+        docs.push({_id: i, a: i % 10, b: [i, -i], c: i % 100});
+    }
+    assert.writeOK(coll.insert(docs));
+
+    // Deleting through the index being changed.
+    var res = coll.remove({a: {$lt: 5}});
+    assert.writeOK(res);
+    assert.eq(250, res.nRemoved);
+    assert.eq(250, coll.find().itcount());
+    assert.eq(250, coll.find({a: {$gte: 0}}).hint({a: 1}).itcount());
+    assert.eq(250, coll.find({b: {$gte: 0}}).hint({b: 1}).itcount());
+    assert.eq(0, coll.find({a: {$lt: 5}}).hint({a: 1}).itcount());
+
+    // A collection scan, removing keys from a multikey and a partial index.
+    res = coll.remove({c: {$gte: 40}});
+    assert.writeOK(res);
+    assert.eq(150, res.nRemoved);
+    assert.eq(100, coll.find().itcount());
+    assert.eq(0, coll.find({c: {$gt: 50}}).hint({c: 1}).itcount());
+    assert.eq(200, coll.find({b: {$exists: true}}).hint({b: 1}).itcount());
+
+    // A single delete removes one document only.
+    res = coll.remove({}, {justOne: true});
+    assert.writeOK(res);
+    assert.eq(1, res.nRemoved);
+    assert.eq(99, coll.find().itcount());
+
+    var validate = coll.validate(true);
+    assert(validate.valid, tojson(validate));
+})();
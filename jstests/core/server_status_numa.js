@@ -0,0 +1,23 @@
+// The numa serverStatus section is only returned when asked for, and then reports the number of
+// NUMA nodes, with where the process' memory is when there are several.
+(function() {
+    "use strict";
+    var status = db.serverStatus();
+    assert.commandWorked(status);
+    assert(!status.hasOwnProperty("numa"), tojson(status.numa));
+
+    status = db.serverStatus({numa: 1});
+    assert.commandWorked(status);
+    var numa = status.numa;
+    assert.gte(numa.numNodes, 1, tojson(numa));
+    if (numa.nodes) {
+        assert.eq(numa.numNodes, numa.nodes.length, tojson(numa));
+        var total = 0;
+        numa.nodes.forEach(function(node, i) {
+            assert.eq(i, node.node, tojson(numa));
+            assert.gte(node.residentPages, 0, tojson(numa));
+            total += node.residentPages;
+        });
+        assert.gt(total, 0, tojson(numa));
+    }
+})();
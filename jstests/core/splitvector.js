@@ -250,6 +250,51 @@ var case9 = function() {
 }
 case9();
 
+// Case 10: split points estimated from a random sample of the documents, where the storage
+// engine can sample, are close to the exact ones and in order
+var case10 = function() {
+    var filler = new Array(100).join("x");
+    var numDocs = 20000;
+    var bulk = f.initializeUnorderedBulkOp();
+    for ( var i = 0; i < numDocs; i++ ) {
+        bulk.insert( { x: i, y: filler } );
+    }
+    assert.writeOK( bulk.execute() );
+
+    var exact = db.runCommand( { splitVector: f.getFullName() , keyPattern: {x:1} ,
+                                 maxChunkSize: 1 } );
+    assert.commandWorked( exact , "10a" );
+    assert.lt( 1 , exact.splitKeys.length , "10b" );
+
+    var res = db.runCommand( { splitVector: f.getFullName() , keyPattern: {x:1} ,
+                               maxChunkSize: 1 , sampleSize: 1000 } );
+    assert.commandWorked( res , "10c" );
+
+    if ( !res.sampled ) {
+        assert.eq( exact.splitKeys , res.splitKeys , "10d" );
+        return;
+    }
+
+    assert.gte( res.splitKeys.length , exact.splitKeys.length / 2 , "10e: " + tojson(res) );
+    assert.lte( res.splitKeys.length , exact.splitKeys.length * 2 , "10f: " + tojson(res) );
+    for ( var i = 0; i < res.splitKeys.length; i++ ) {
+        assertFieldNamesMatch( res.splitKeys[i] , {x : 1} );
+        if ( i > 0 ) {
+            assert.lt( res.splitKeys[i - 1].x , res.splitKeys[i].x , "10g: " + tojson(res) );
+        }
+    }
+
+    // A chunk holding too little of the sample falls back to walking the index
+    res = db.runCommand( { splitVector: f.getFullName() , keyPattern: {x:1} ,
+                           min: {x: 0} , max: {x: 100} , maxChunkSize: 1 , sampleSize: 1000 } );
+    assert.commandWorked( res , "10h" );
+    assert( !res.sampled , "10i: " + tojson(res) );
+}
+
+resetCollection();
+f.ensureIndex( { x: 1 } );
+case10();
+
 // -------------------------
 // Repeat all cases using prefix shard key.
 //
@@ -0,0 +1,28 @@
+// touch reads in a collection spread over many extents and several indexes, on every storage
+// engine that supports it.
+(function() {
+    "use strict";
+    var coll = db.touch_large;
+    coll.drop();
+
+    assert.commandWorked(coll.ensureIndex({a: 1}));
+    assert.commandWorked(coll.ensureIndex({b: 1}));
+
+    var big = new Array(1024).join("x");
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 20000; i++) {
+        bulk.insert({a: i, b: -i, s: big});
+    }
+    assert.writeOK(bulk.execute());
+
+    var res = coll.runCommand("touch", {data: true, index: true});
+    if (res.code === ErrorCodes.CommandNotSupported) {
+        return;
+    }
+    assert.commandWorked(res);
+    assert.gte(res.data.numRanges, 1, tojson(res));
+    assert.eq(3, res.indexes.num, tojson(res));
+
+    assert.commandWorked(coll.runCommand("touch", {data: true}));
+    assert.commandWorked(coll.runCommand("touch", {index: true}));
+})();
@@ -0,0 +1,64 @@
+// Single-field $inc and $set of fixed-width values may be applied by overwriting the old value in
+// place. Check that they give the same results as the general update path, including where they
+// have to fall back to it.
+(function() {
+    "use strict";
+    var t = db.update_fixed_width;
+    t.drop();
+
+    function update(query, mod, nModified) {
+        var res = t.update(query, mod);
+        assert.writeOK(res);
+        if (db.getMongo().writeMode() == "commands") {
+            assert.eq(nModified, res.nModified, tojson(mod));
+        }
+    }
+
+    assert.writeOK(t.insert({_id: 1,
+                             i: NumberInt(1),
+                             l: NumberLong(1),
+                             d: 1.5,
+                             b: false,
+                             dt: new Date(0),
+                             a: {b: {c: NumberInt(5)}},
+                             arr: [{x: 1}]}));
+
+    update({_id: 1}, {$inc: {i: NumberInt(2)}}, 1);
+    update({_id: 1}, {$inc: {l: NumberLong(-3)}}, 1);
+    update({_id: 1}, {$inc: {d: 1}}, 1);
+    update({_id: 1}, {$inc: {"a.b.c": NumberInt(1)}}, 1);
+    update({_id: 1}, {$set: {b: true}}, 1);
+    update({_id: 1}, {$set: {dt: new Date(1000)}}, 1);
+    var doc = t.findOne();
+    assert.eq(NumberInt(3), doc.i, tojson(doc));
+    assert.eq(NumberLong(-2), doc.l, tojson(doc));
+    assert.eq(2.5, doc.d, tojson(doc));
+    assert.eq(NumberInt(6), doc.a.b.c, tojson(doc));
+    assert.eq(true, doc.b, tojson(doc));
+    assert.eq(new Date(1000), doc.dt, tojson(doc));
+
+    // No-ops are not counted as modifications.
+    update({_id: 1}, {$inc: {i: NumberInt(0)}}, 0);
+    update({_id: 1}, {$set: {b: true}}, 0);
+    update({_id: 1}, {$set: {d: 2.5}}, 0);
+
+    // Changes of width fall back to the general path.
+    update({_id: 1}, {$inc: {i: NumberInt(2147483647)}}, 1);
+    assert.eq(NumberLong(2147483650), t.findOne().i);
+    update({_id: 1}, {$set: {b: NumberInt(1)}}, 1);
+    assert.eq(NumberInt(1), t.findOne().b);
+    update({_id: 1}, {$inc: {"arr.0.x": 1}}, 1);
+    assert.eq(2, t.findOne().arr[0].x);
+    update({_id: 1}, {$inc: {missing: 1}}, 1);
+    assert.eq(1, t.findOne().missing);
+
+    // Indexed fields keep their index entries up to date.
+    assert.commandWorked(t.ensureIndex({d: 1}));
+    update({_id: 1}, {$inc: {d: 1}}, 1);
+    assert.eq(1, t.find({d: 3.5}).hint({d: 1}).itcount());
+    assert.eq(0, t.find({d: 2.5}).hint({d: 1}).itcount());
+
+    // Replacement documents are never shortcut.
+    update({_id: 1}, {d: 7}, 1);
+    assert.eq({_id: 1, d: 7}, t.findOne());
+})();
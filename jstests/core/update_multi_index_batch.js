@@ -0,0 +1,43 @@
+// Multi-updates changing indexed fields write their documents in batches, with each index's key
+// changes applied together. Check that the indexes match the documents afterwards, that no
+// document is updated twice, and that errors still stop the update at the failing document.
+(function() {
+    "use strict";
+    var coll = db.update_multi_index_batch;
+    coll.drop();
+
+    assert.commandWorked(coll.ensureIndex({a: 1}));
+    assert.commandWorked(coll.ensureIndex({b: 1}));
+    assert.commandWorked(coll.ensureIndex({u: 1}, {unique: true}));
+
+    var docs = [];
+    for (var i = 0; i < 300; i++) {
+        docs.push({_id: i, a: i % 7, b: [i, -i], u: i});
+    }
+    assert.writeOK(coll.insert(docs));
+
+    // Scanning the index being changed must not see a document again.
+    var res = coll.update({a: {$gte: 0}}, {$inc: {a: 10}}, {multi: true});
+    assert.writeOK(res);
+    assert.eq(300, res.nMatched);
+    assert.eq(300, coll.find({a: {$gte: 10, $lt: 17}}).hint({a: 1}).itcount());
+    assert.eq(0, coll.find({a: {$lt: 10}}).hint({a: 1}).itcount());
+
+    // Multikey keys, and documents growing enough to move.
+    var big = new Array(1000).join("x");
+    res = coll.update({}, {$push: {b: 1000}, $set: {pad: big}}, {multi: true});
+    assert.writeOK(res);
+    assert.eq(300, res.nMatched);
+    assert.eq(300, coll.find({b: 1000}).hint({b: 1}).itcount());
+    assert.eq(300, coll.find({b: {$lte: 0}}).hint({b: 1}).itcount());
+    assert.eq(300, coll.find().hint({u: 1}).itcount());
+
+    // A unique key taken by a later document still fails where it did one document at a time.
+    res = coll.update({}, {$inc: {u: 1}}, {multi: true});
+    assert.writeError(res);
+    assert.eq(300, coll.find().hint({u: 1}).itcount());
+    assert.eq(300, coll.find().itcount());
+
+    var validate = coll.validate(true);
+    assert(validate.valid, tojson(validate));
+})();
@@ -0,0 +1,38 @@
+// A background validate finds the same keys in each index as a foreground one, and checks them
+// against the documents of the collection.
+(function() {
+    "use strict";
+    var coll = db.validate_background;
+    coll.drop();
+
+    assert.commandWorked(coll.ensureIndex({a: 1}));
+    assert.commandWorked(coll.ensureIndex({b: 1}, {sparse: true}));
+    assert.commandWorked(coll.ensureIndex({c: "hashed"}));
+    assert.commandWorked(coll.ensureIndex({t: "text"}));
+    assert.commandWorked(coll.ensureIndex({loc: "2dsphere"}));
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 1000; i++) {
+        var doc = {_id: i, a: [i, i + 1, {x: i}], c: i % 3 ? i : i + 0.5, t: "some words " + i,
+                   loc: {type: "Point", coordinates: [i % 180, i % 90]}};
+        if (i % 2) {
+            doc.b = NumberLong(i);
+        }
+        bulk.insert(doc);
+    }
+    assert.writeOK(bulk.execute());
+
+    var foreground = assert.commandWorked(coll.validate(true));
+    var background = assert.commandWorked(db.runCommand({validate: coll.getName(),
+                                                         background: true}));
+    assert(background.valid, tojson(background));
+    assert(background.background, tojson(background));
+    assert.eq(1000, background.nrecords);
+    assert.eq(foreground.nIndexes, background.nIndexes);
+    assert.eq(foreground.keysPerIndex, background.keysPerIndex);
+
+    // Non-regular collections can't be validated in the background.
+    assert.commandFailed(db.runCommand({validate: "system.indexes", background: true}));
+    assert.commandFailed(db.runCommand({validate: "validate_background_missing",
+                                        background: true}));
+})();
@@ -0,0 +1,54 @@
+/* test a journal striped across several directories with --journalStripeDirs
+   runs mongod, kill -9's, recovers with the same stripe directories
+*/
+
+var testname = "striped";
+var path = MongoRunner.dataPath + testname + "dur";
+var stripes = [MongoRunner.dataPath + testname + "stripe1",
+               MongoRunner.dataPath + testname + "stripe2"];
+stripes.forEach(function(dir) { resetDbpath(dir); });
+
+function log(str) {
+    print("\n" + testname + " " + str);
+}
+
+// documents large enough that a group commit is split across all the stripes
+var big = 'x';
+while (big.length < 4 * 1024 * 1024) big += big;
+
+log("run mongod with a striped journal");
+var conn = startMongodEmpty("--port", 30001, "--dbpath", path, "--journal", "--smallfiles",
+                            "--journalStripeDirs", stripes.join(","));
+var d = conn.getDB("test");
+for (var i = 0; i < 10; i++) {
+    d.foo.insert({ _id: i, big: big });
+    d.foo.update({ _id: i }, { $set: { a: i } });
+    var res = d.runCommand({ getLastError: 1, j: true });
+    assert.commandWorked(res);
+    assert.eq(null, res.err);
+}
+
+log("kill -9");
+stopMongod(30001, /*signal*/9);
+
+stripes.forEach(function(dir) {
+    var files = listFiles(dir).filter(function(f) { return /j\._/.test(f.name); });
+    assert.gt(files.length, 0, "no journal files in stripe directory " + dir);
+    assert.gt(files[0].size, 8192, "nothing was striped into " + dir);
+});
+
+log("restart mongod and recover");
+conn = startMongodNoReset("--port", 30002, "--dbpath", path, "--journal", "--smallfiles",
+                          "--journalStripeDirs", stripes.join(","));
+d = conn.getDB("test");
+assert.eq(10, d.foo.count());
+for (var i = 0; i < 10; i++) {
+    var doc = d.foo.findOne({ _id: i });
+    assert.eq(i, doc.a);
+    assert.eq(big.length, doc.big.length);
+}
+
+log("stopping mongod 30002");
+stopMongod(30002);
+
+print(testname + " SUCCESS");
@@ -0,0 +1,50 @@
+// Tests that a leading $group computed in parallel over a collection's iterators gives the same
+// results as the serial implementation.
+
+var mongod = MongoRunner.runMongod({});
+var db = mongod.getDB("test");
+var coll = db.aggregation_parallel_group;
+coll.drop();
+
+// Use enough data to span several extents so there are several iterators to split.
+for (var i = 0; i < 20000; i++) {
+    coll.insert({a: i % 37, b: i, s: "x" + (i % 5)});
+}
+assert.eq(null, db.getLastError());
+
+function setThreads(n) {
+    assert.commandWorked(db.adminCommand({setParameter: 1, aggregationParallelGroupThreads: n}));
+}
+
+function runPipeline(pipeline) {
+    return coll.aggregate(pipeline).toArray();
+}
+
+var pipelines = [
+    [{$group: {_id: "$a", count: {$sum: 1}, total: {$sum: "$b"}}}, {$sort: {_id: 1}}],
+    [{$group: {_id: "$s", avg: {$avg: "$b"}, min: {$min: "$b"}, max: {$max: "$b"}}},
+     {$sort: {_id: 1}}],
+    [{$group: {_id: null, docs: {$sum: 1}}}],
+    [{$group: {_id: {a: "$a", s: "$s"}, count: {$sum: 1}}}, {$sort: {_id: 1}}],
+];
+
+for (var i = 0; i < pipelines.length; i++) {
+    setThreads(0);
+    var expected = runPipeline(pipelines[i]);
+    setThreads(4);
+    assert.eq(expected, runPipeline(pipelines[i]), tojson(pipelines[i]));
+}
+
+// Errors hit by a partial group are reported to the client.
+setThreads(4);
+var res = db.runCommand({aggregate: coll.getName(),
+                         pipeline: [{$group: {_id: "$b", x: {$sum: {$divide: [1, 0]}}}}]});
+assert.commandFailed(res);
+
+// An empty collection gives no groups.
+coll.drop();
+coll.insert({});
+coll.remove({});
+assert.eq([], runPipeline([{$group: {_id: "$a", count: {$sum: 1}}}]));
+
+MongoRunner.stopMongod(mongod);
@@ -0,0 +1,44 @@
+// Tests that connections serviced by a shared pool of worker threads keep their per-connection
+// state (last error, cursors) when consecutive requests run on different threads.
+
+var mongod = MongoRunner.runMongod({setParameter: "connectionWorkerThreads=2"});
+var coll = mongod.getDB("test").connection_worker_threads;
+coll.drop();
+
+// Use more connections than there are worker threads.
+var conns = [];
+for (var i = 0; i < 10; i++) {
+    conns.push(new Mongo(mongod.host));
+}
+
+for (var i = 0; i < conns.length; i++) {
+    var connColl = conns[i].getDB("test").connection_worker_threads;
+    connColl.insert({_id: i});
+    assert.eq(null, conns[i].getDB("test").getLastError());
+}
+
+// A duplicate key error is only visible to the connection which caused it.
+conns[0].getDB("test").connection_worker_threads.insert({_id: 1});
+for (var i = 1; i < conns.length; i++) {
+    assert.eq(null, conns[i].getDB("test").getLastError());
+}
+assert.neq(null, conns[0].getDB("test").getLastError());
+
+// Cursors opened on one connection can be iterated across many requests.
+for (var i = 0; i < 1000; i++) {
+    coll.insert({x: i});
+}
+var cursors = conns.map(function(conn) {
+    return conn.getDB("test").connection_worker_threads.find({x: {$exists: true}}).batchSize(2);
+});
+cursors.forEach(function(cursor) {
+    assert.eq(1000, cursor.itcount());
+});
+
+assert.eq(1010, coll.count());
+
+conns.forEach(function(conn) {
+    assert.commandWorked(conn.getDB("admin").runCommand({ping: 1}));
+});
+
+MongoRunner.stopMongod(mongod);
@@ -0,0 +1,52 @@
+// cursorBatchTargetBytes caps the bytes of each cursor batch, and cursorBatchMaxTimeMS returns
+// non-empty batches early once they have been building long enough.
+(function() {
+    "use strict";
+
+    var mongod = MongoRunner.runMongod({});
+    var testDB = mongod.getDB("test");
+    var coll = testDB.cursor_batch_budget;
+    coll.drop();
+
+    var padding = new Array(1000).join("x");
+    for (var i = 0; i < 100; i++) {
+        assert.writeOK(coll.insert({_id: i, padding: padding}));
+    }
+
+    // Byte target, for the first batch and for getMores.
+    assert.commandWorked(testDB.adminCommand({setParameter: 1, cursorBatchTargetBytes: 10000}));
+    var cursor = coll.find();
+    cursor.next();
+    assert.lte(cursor.objsLeftInBatch(), 10);
+    var seen = 1 + cursor.objsLeftInBatch();
+    while (cursor.objsLeftInBatch() > 0) {
+        cursor.next();
+    }
+    cursor.next();
+    assert.lte(cursor.objsLeftInBatch(), 10);
+    seen += 1 + cursor.objsLeftInBatch();
+    while (cursor.hasNext()) {
+        cursor.next();
+        seen++;
+    }
+    assert.eq(100, seen);
+
+    // Aggregation cursors honor it too.
+    var res = testDB.runCommand({aggregate: coll.getName(), pipeline: [], cursor: {}});
+    assert.commandWorked(res);
+    assert.lte(res.cursor.firstBatch.length, 11);
+
+    assert.commandWorked(testDB.adminCommand({setParameter: 1, cursorBatchTargetBytes: 0}));
+
+    // Time budget: a slow filter returns a partial first batch.
+    assert.commandWorked(testDB.adminCommand({setParameter: 1, cursorBatchMaxTimeMS: 100}));
+    cursor = coll.find({$where: "sleep(20); return true;"});
+    cursor.next();
+    assert.lt(cursor.objsLeftInBatch(), 50);
+    assert.eq(99, cursor.itcount());
+
+    // Single batch queries are never cut short by time.
+    assert.eq(60, coll.find({$where: "sleep(5); return true;"}).limit(-60).itcount());
+
+    MongoRunner.stopMongod(mongod);
+}());
@@ -0,0 +1,45 @@
+// With idBloomFilterEnabled, _id lookups that miss are answered from the collection's _id filter
+// once the background builder has built it, and inserts and deletes keep it accurate.
+
+var mongod = MongoRunner.runMongod({setParameter: "idBloomFilterEnabled=true"});
+assert.commandWorked(mongod.adminCommand({setParameter: 1, idBloomFilterBuildIntervalSecs: 1}));
+var coll = mongod.getDB("test").id_bloom_filter;
+
+function filterStats() {
+    return mongod.adminCommand({serverStatus: 1}).metrics.idBloomFilter;
+}
+
+for (var i = 0; i < 1000; i++) {
+    assert.writeOK(coll.insert({_id: i}));
+}
+
+var builds = filterStats().builds;
+assert.soon(function() { return filterStats().builds > builds; },
+            "the _id filter was not built");
+
+// Every existing _id is still found, whatever its numeric type.
+for (var i = 0; i < 1000; i += 7) {
+    assert.eq(i, coll.findOne({_id: i})._id);
+    assert.eq(i, coll.findOne({_id: NumberLong(i)})._id);
+}
+
+// Nearly all misses are answered by the filter.
+var negatives = filterStats().negatives;
+for (var i = 1000; i < 2000; i++) {
+    assert.eq(null, coll.findOne({_id: i}));
+}
+assert.gt(filterStats().negatives - negatives, 900);
+
+// Documents inserted after the build are found, and deleted ones are gone.
+assert.writeOK(coll.insert({_id: "new"}));
+assert.eq("new", coll.findOne({_id: "new"})._id);
+assert.writeOK(coll.remove({_id: 5}));
+assert.eq(null, coll.findOne({_id: 5}));
+assert.writeOK(coll.insert({_id: 5, again: true}));
+assert.eq(true, coll.findOne({_id: 5}).again);
+
+// An upsert that misses in the filter still inserts.
+assert.writeOK(coll.update({_id: "upserted"}, {$set: {x: 1}}, {upsert: true}));
+assert.eq(1, coll.findOne({_id: "upserted"}).x);
+
+MongoRunner.stopMongod(mongod);
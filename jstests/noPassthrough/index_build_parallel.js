@@ -0,0 +1,54 @@
+// Tests that a foreground index build that generates its keys on several threads builds the same
+// indexes as the serial implementation.
+
+var mongod = MongoRunner.runMongod({});
+var db = mongod.getDB("test");
+var coll = db.index_build_parallel;
+coll.drop();
+
+// Use enough data to span several extents so there are several iterators to split.
+for (var i = 0; i < 20000; i++) {
+    coll.insert({a: i % 37, b: i, c: [i % 3, i % 7], s: "x" + (i % 5)});
+}
+assert.eq(null, db.getLastError());
+
+function setThreads(n) {
+    assert.commandWorked(db.adminCommand({setParameter: 1, indexBuildParallelThreads: n}));
+}
+
+function scan(keyPattern, sort) {
+    return coll.find({}, {_id: 1}).hint(keyPattern).sort(sort || keyPattern).toArray();
+}
+
+var keyPatterns = [
+    {a: 1, b: -1},
+    {s: 1},
+    {c: 1},
+    {a: 1, c: 1},
+];
+
+for (var i = 0; i < keyPatterns.length; i++) {
+    setThreads(0);
+    assert.commandWorked(coll.ensureIndex(keyPatterns[i]));
+    var expected = scan(keyPatterns[i]);
+    assert.commandWorked(coll.dropIndex(keyPatterns[i]));
+
+    setThreads(4);
+    assert.commandWorked(coll.ensureIndex(keyPatterns[i]));
+    assert.eq(expected, scan(keyPatterns[i]), tojson(keyPatterns[i]));
+    assert.commandWorked(coll.validate(true));
+    assert.commandWorked(coll.dropIndex(keyPatterns[i]));
+}
+
+// Multikey indexes are flagged as such.
+setThreads(4);
+assert.commandWorked(coll.ensureIndex({c: 1}));
+assert(coll.find({c: 1}).hint({c: 1}).explain().queryPlanner.winningPlan.inputStage.isMultiKey);
+
+// Duplicates fail a unique build, found after merging the sorters of all the threads.
+assert.commandFailed(coll.ensureIndex({a: 1}, {unique: true}));
+assert.eq(20000, coll.count());
+assert.commandWorked(coll.ensureIndex({b: 1}, {unique: true}));
+assert.eq(20000, scan({b: 1}).length);
+
+MongoRunner.stopMongod(mongod);
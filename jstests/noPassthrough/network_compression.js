@@ -0,0 +1,73 @@
+// Tests that connections which agree on a compressor through isMaster exchange compressed
+// messages, and that replication still works over them.
+
+var mongod = MongoRunner.runMongod({});
+var admin = mongod.getDB("admin");
+var coll = mongod.getDB("test").network_compression;
+
+function compressionStats(conn) {
+    var res = conn.getDB("admin").runCommand({serverStatus: 1});
+    assert.commandWorked(res);
+    return res.network.compression;
+}
+
+// A client that does not ask for compression does not get it
+var res = admin.runCommand({isMaster: 1});
+assert.commandWorked(res);
+assert.eq(undefined, res.compression, tojson(res));
+
+// Ask for it on this connection, so the replies to the queries below come back compressed
+res = admin.runCommand({isMaster: 1, compression: ["unknown", "snappy"]});
+assert.commandWorked(res);
+assert.eq(["snappy"], res.compression, tojson(res));
+
+var big = new Array(10 * 1024).join("compressible ");
+for (var i = 0; i < 100; i++) {
+    coll.insert({_id: i, s: big});
+}
+assert.eq(null, coll.getDB().getLastError());
+
+var before = compressionStats(mongod);
+var docs = coll.find().toArray();
+assert.eq(100, docs.length);
+docs.forEach(function(doc) {
+    assert.eq(big, doc.s, "document " + doc._id + " changed");
+});
+var after = compressionStats(mongod);
+assert.gt(after.messagesOut, before.messagesOut, tojson(after));
+assert.lt(after.bytesOut - before.bytesOut,
+          after.uncompressedBytesOut - before.uncompressedBytesOut,
+          tojson(after));
+
+// Servers with compression turned off don't agree to it
+assert.commandWorked(admin.runCommand({setParameter: 1, networkMessageCompression: false}));
+res = admin.runCommand({isMaster: 1, compression: ["snappy"]});
+assert.commandWorked(res);
+assert.eq(undefined, res.compression, tojson(res));
+
+MongoRunner.stopMongod(mongod);
+
+// Secondaries fetch the oplog of the primary over compressed connections
+var replTest = new ReplSetTest({name: 'networkCompression', nodes: 2});
+replTest.startSet();
+replTest.initiate();
+var master = replTest.getMaster();
+replTest.awaitSecondaryNodes();
+var slave = replTest.liveNodes.slaves[0];
+
+var masterColl = master.getDB("test").network_compression;
+for (var i = 0; i < 100; i++) {
+    masterColl.insert({_id: i, s: big});
+}
+assert.eq(null, masterColl.getDB().getLastError());
+replTest.awaitReplication();
+
+slave.setSlaveOk();
+var slaveColl = slave.getDB("test").network_compression;
+assert.eq(100, slaveColl.count());
+slaveColl.find().forEach(function(doc) {
+    assert.eq(big, doc.s, "document " + doc._id + " changed");
+});
+assert.gt(compressionStats(slave).messagesIn, 0, tojson(compressionStats(slave)));
+
+replTest.stopSet();
@@ -0,0 +1,61 @@
+// Tests that queries return the same results when the plan is worked a batch at a time
+// (internalQueryExecBatchSize) as when it is worked one unit of work at a time.
+
+var mongod = MongoRunner.runMongod({});
+var admin = mongod.getDB("admin");
+var coll = mongod.getDB("test").query_exec_batch;
+
+for (var i = 0; i < 1000; i++) {
+    coll.insert({_id: i, a: i % 10, b: i, c: "c" + i});
+}
+assert.eq(null, coll.getDB().getLastError());
+assert.commandWorked(coll.ensureIndex({b: 1}));
+
+function runQueries() {
+    return [
+        // Collection scan with a filter and a projection
+        coll.find({a: 3}, {_id: 0, b: 1}).toArray(),
+        // Index scan and fetch, with a filter on the fetched documents
+        coll.find({b: {$gte: 100, $lt: 700}, a: {$in: [1, 2]}}).toArray(),
+        // Skip and limit
+        coll.find({b: {$gte: 10}}).skip(15).limit(30).toArray(),
+        coll.find().skip(995).toArray(),
+        coll.find({a: 5}).limit(7).batchSize(2).toArray(),
+        // Blocking sort
+        coll.find({a: {$lt: 3}}).sort({c: -1}).limit(50).toArray(),
+        // Covered by the index
+        coll.find({b: {$gt: 900}}, {_id: 0, b: 1}).hint({b: 1}).toArray(),
+        // Index scan in reverse
+        coll.find({b: {$lt: 50}}).sort({b: -1}).toArray(),
+        // Nothing matches
+        coll.find({a: 11}).toArray(),
+        [coll.count({a: 4})]
+    ];
+}
+
+var res = admin.runCommand({getParameter: 1, internalQueryExecBatchSize: 1});
+assert.commandWorked(res);
+assert.eq(0, res.internalQueryExecBatchSize);
+var expected = runQueries();
+
+[1, 2, 7, 101, 5000].forEach(function(batchSize) {
+    assert.commandWorked(admin.runCommand({setParameter: 1, internalQueryExecBatchSize: batchSize}));
+    assert.eq(expected, runQueries(), "batch size " + batchSize);
+});
+
+// Updates and removes while a batched query has results of a batch it hasn't returned yet
+assert.commandWorked(admin.runCommand({setParameter: 1, internalQueryExecBatchSize: 500}));
+var cursor = coll.find({a: {$gte: 0}}).batchSize(10);
+var seen = 0;
+while (cursor.hasNext()) {
+    var doc = cursor.next();
+    seen++;
+    if (seen == 10) {
+        coll.remove({b: {$gte: 900}});
+        coll.update({}, {$set: {pad: new Array(1024).join("x")}}, {multi: true});
+        assert.eq(null, coll.getDB().getLastError());
+    }
+}
+assert.lte(900, seen);
+
+MongoRunner.stopMongod(mongod);
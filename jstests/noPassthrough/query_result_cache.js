@@ -0,0 +1,83 @@
+// Queries and aggregations flagged with cacheResults are answered from the query result cache
+// until their collection is next written, and the results never go stale.
+
+var mongod = MongoRunner.runMongod({});
+var db = mongod.getDB("test");
+var coll = db.query_result_cache;
+
+function cacheStats() {
+    return db.serverStatus().queryResultCache;
+}
+
+for (var i = 0; i < 100; i++) {
+    assert.writeOK(coll.insert({_id: i, a: i % 10}));
+}
+
+function cachedFind() {
+    return coll.find({a: {$lt: 3}}).sort({_id: 1})._addSpecial("$cacheResults", true).toArray();
+}
+
+var pipeline = [{$group: {_id: "$a", count: {$sum: 1}}}, {$sort: {_id: 1}}];
+function cachedAggregate() {
+    return assert.commandWorked(db.runCommand({aggregate: coll.getName(),
+                                               pipeline: pipeline,
+                                               cacheResults: true})).result;
+}
+
+// The first run fills the cache and the second is answered from it.
+var stats = cacheStats();
+var found = cachedFind();
+assert.eq(30, found.length);
+assert.eq(stats.hits, cacheStats().hits);
+assert.eq(stats.inserts + 1, cacheStats().inserts);
+assert.eq(found, cachedFind());
+assert.eq(stats.hits + 1, cacheStats().hits);
+
+var grouped = cachedAggregate();
+assert.eq(10, grouped.length);
+assert.eq(grouped, cachedAggregate());
+assert.eq(stats.hits + 2, cacheStats().hits);
+
+// Queries that don't ask for it are neither served from nor put in the cache.
+stats = cacheStats();
+assert.eq(30, coll.find({a: {$lt: 3}}).sort({_id: 1}).itcount());
+assert.eq(stats.hits, cacheStats().hits);
+assert.eq(stats.misses, cacheStats().misses);
+
+// A write makes the cached results stale, and the next run sees it.
+assert.writeOK(coll.insert({_id: 100, a: 0}));
+stats = cacheStats();
+assert.eq(31, cachedFind().length);
+assert.eq(11, cachedAggregate()[0].count);
+assert.eq(stats.staleMisses + 2, cacheStats().staleMisses);
+assert.eq(31, cachedFind().length);
+assert.eq(stats.hits + 1, cacheStats().hits);
+
+assert.writeOK(coll.update({_id: 0}, {$set: {a: 5}}));
+assert.eq(30, cachedFind().length);
+assert.writeOK(coll.remove({_id: 1}));
+assert.eq(29, cachedFind().length);
+
+// Results needing a getMore are not cached.
+stats = cacheStats();
+assert.eq(101 - 1, coll.find().batchSize(10)._addSpecial("$cacheResults", true).itcount());
+assert.eq(stats.inserts, cacheStats().inserts);
+
+// Neither are aggregations reading other collections.
+stats = cacheStats();
+assert.commandWorked(db.runCommand({aggregate: coll.getName(),
+                                    pipeline: [{$out: "query_result_cache_out"}],
+                                    cacheResults: true}));
+assert.eq(stats.inserts, cacheStats().inserts);
+
+// A dropped and recreated collection doesn't get the results of the old one.
+cachedFind();
+coll.drop();
+assert.writeOK(coll.insert({_id: 0, a: 0}));
+assert.eq(1, cachedFind().length);
+
+assert.commandFailed(db.runCommand({aggregate: coll.getName(),
+                                    pipeline: pipeline,
+                                    cacheResults: 1}));
+
+MongoRunner.stopMongod(mongod);
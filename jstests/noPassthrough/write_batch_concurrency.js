@@ -0,0 +1,54 @@
+// With writeBatchConcurrency, unordered update and delete batches may be split across threads on
+// engines with document-level locking. Results, upserted _ids and errors must match serial
+// execution, in item order.
+
+var mongod = MongoRunner.runMongod({setParameter: "writeBatchConcurrency=4"});
+var coll = mongod.getDB("test").write_batch_concurrency;
+coll.drop();
+assert.commandWorked(coll.ensureIndex({u: 1}, {unique: true, sparse: true}));
+
+for (var i = 0; i < 200; i++) {
+    assert.writeOK(coll.insert({_id: i, u: i, x: 0}));
+}
+
+// Updates of existing documents, upserts, and duplicate key errors at known indexes.
+var updates = [];
+for (var i = 0; i < 300; i++) {
+    if (i < 200 && i % 50 == 7) {
+        // Collides with the unique value of another document.
+        updates.push({q: {_id: i}, u: {$set: {u: i + 1}}});
+    }
+    else {
+        updates.push({q: {_id: i}, u: {$set: {x: 1}}, upsert: true});
+    }
+}
+var res = coll.runCommand({update: coll.getName(), updates: updates, ordered: false});
+assert.commandWorked(res);
+
+var errorIndexes = res.writeErrors.map(function(e) { return e.index; });
+assert.eq([7, 57, 107, 157], errorIndexes);
+res.writeErrors.forEach(function(e) { assert.eq(11000, e.code); });
+
+assert.eq(100, res.upserted.length);
+for (var i = 0; i < res.upserted.length; i++) {
+    assert.eq(200 + i, res.upserted[i].index);
+    assert.eq(200 + i, res.upserted[i]._id);
+}
+assert.eq(296, res.n);
+assert.eq(196, res.nModified);
+assert.eq(296, coll.count({x: 1}));
+
+// Deletes.
+var deletes = [];
+for (var i = 0; i < 300; i += 2) {
+    deletes.push({q: {_id: i}, limit: 1});
+}
+res = coll.runCommand({delete: coll.getName(), deletes: deletes, ordered: false});
+assert.commandWorked(res);
+assert.eq(150, res.n);
+assert.eq(150, coll.count());
+
+// getLastError reports on the last item of the batch.
+assert.eq(1, mongod.getDB("test").getLastErrorObj().n);
+
+MongoRunner.stopMongod(mongod);
@@ -0,0 +1,44 @@
+// Tests that fetches on storage engines which can prefetch records read ahead of the index scan
+// below them, and still return the same results whether or not they do.
+
+var ss = db.serverStatus();
+var engine = ss.storageEngine.name;
+if (engine !== "wiredTiger" && engine !== "rocksdb") {
+    print("Skipping fetch_prefetch.js since this storage engine does not prefetch records");
+}
+else {
+    var t = db.jstests_fetch_prefetch;
+    t.drop();
+    t.ensureIndex({a: 1});
+    for (var i = 0; i < 200; i++) {
+        t.insert({a: i, b: i % 3});
+    }
+
+    function setLookahead(value) {
+        var res = db.adminCommand({setParameter: 1, internalQueryExecFetchLookahead: value});
+        assert.commandWorked(res);
+        return res.was;
+    }
+
+    function getFetchStage(explain) {
+        var stage = explain.executionStats.executionStages;
+        while (stage.stage != "FETCH") {
+            stage = stage.inputStage;
+        }
+        return stage;
+    }
+
+    var query = {a: {$gte: 50}, b: 1};
+    var oldLookahead = setLookahead(0);
+    var expected = t.find(query).sort({a: 1}).toArray();
+    assert.eq(0, getFetchStage(t.find(query).explain("executionStats")).docsPrefetched);
+
+    setLookahead(16);
+    assert.eq(expected, t.find(query).sort({a: 1}).toArray());
+    var fetch = getFetchStage(t.find(query).explain("executionStats"));
+    assert.gt(fetch.docsPrefetched, 0, tojson(fetch));
+    assert.eq(150, fetch.docsExamined, tojson(fetch));
+
+    setLookahead(oldLookahead);
+    t.drop();
+}
@@ -0,0 +1,75 @@
+// Tests the buildIndexHistograms command, and that the planner uses the histograms it builds to
+// drop candidate plans which examine many more keys than the best one.
+
+var t = db.jstests_index_histograms;
+t.drop();
+
+t.ensureIndex({a: 1});
+t.ensureIndex({b: 1});
+t.ensureIndex({c: "2dsphere"});
+
+// Every value of a is unique, and every document has b > 0.
+for (var i = 0; i < 1000; i++) {
+    t.insert({a: i, b: (i % 10) + 1});
+}
+
+var minKeys = db.adminCommand({getParameter: 1, internalQueryHistogramPruneMinKeys: 1});
+assert.commandWorked(minKeys);
+minKeys = minKeys.internalQueryHistogramPruneMinKeys;
+assert.commandWorked(db.adminCommand({setParameter: 1, internalQueryHistogramPruneMinKeys: 10}));
+
+function getRejectedPlans(query) {
+    var explain = t.find(query).explain();
+    return explain.queryPlanner.rejectedPlans;
+}
+
+var query = {a: 500, b: {$gt: 0}};
+
+// Without histograms both indexes are tried.
+assert.eq(1, t.find(query).itcount());
+assert.eq(1, getRejectedPlans(query).length);
+
+// Bad arguments.
+assert.commandFailed(t.runCommand("buildIndexHistograms", {buckets: 0}));
+assert.commandFailed(t.runCommand("buildIndexHistograms", {sampleSize: "a"}));
+assert.commandFailed(t.runCommand("buildIndexHistograms", {index: "nosuchindex"}));
+assert.commandFailed(db.runCommand({buildIndexHistograms: "jstests_index_histograms_missing"}));
+
+// Only the btree indexes get a histogram.
+var res = t.runCommand("buildIndexHistograms", {buckets: 10});
+assert.commandWorked(res);
+assert.eq(3, res.histograms.length, tojson(res));
+res.histograms.forEach(function(hist) {
+    assert.neq("c_2dsphere", hist.name, tojson(hist));
+    assert.eq(1000, hist.numKeys, tojson(hist));
+    assert.eq(10, hist.buckets.length, tojson(hist));
+});
+
+res = t.runCommand("buildIndexHistograms", {index: "a_1", buckets: 5, sampleSize: 100});
+assert.commandWorked(res);
+assert.eq(1, res.histograms.length, tojson(res));
+assert.eq({a: 1}, res.histograms[0].key);
+assert.eq(5, res.histograms[0].buckets.length);
+
+// The scan of all of b is dropped before the plans are ranked.
+assert.eq(1, t.find(query).itcount());
+assert.eq(0, getRejectedPlans(query).length);
+
+// Queries the histograms are wrong about still get the right answer.
+assert.eq(100, t.find({a: {$gte: 0}, b: 5}).itcount());
+assert.eq(0, t.find({a: 5000, b: {$gt: 0}}).itcount());
+
+// Enough writes make the histograms stale, and they are no longer used.
+for (var i = 0; i < 300; i++) {
+    t.insert({a: i + 1000, b: 1});
+}
+assert.eq(1, getRejectedPlans(query).length);
+
+// Dropping an index forgets the histograms.
+assert.commandWorked(t.runCommand("buildIndexHistograms"));
+assert.eq(0, getRejectedPlans(query).length);
+assert.commandWorked(t.dropIndex({c: "2dsphere"}));
+assert.eq(1, getRejectedPlans(query).length);
+
+assert.commandWorked(db.adminCommand({setParameter: 1,
+                                      internalQueryHistogramPruneMinKeys: minKeys}));
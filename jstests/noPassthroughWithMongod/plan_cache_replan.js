@@ -0,0 +1,48 @@
+// Tests that a cached plan which does much worse than it did when it was picked is evicted from
+// the plan cache and the query is planned again.
+
+var t = db.jstests_plan_cache_replan;
+t.drop();
+
+t.ensureIndex({a: 1});
+t.ensureIndex({b: 1});
+
+// Many documents have a == 1, and many have b == 1, but every other value of either is unique.
+for (var i = 0; i < 1000; i++) {
+    t.insert({a: 1, b: i + 10});
+    t.insert({a: i + 10, b: 1});
+}
+
+function getReplanned() {
+    return db.serverStatus().metrics.queryExecutor.replanned;
+}
+
+function getShapes() {
+    var res = t.runCommand('planCacheListQueryShapes');
+    assert.commandWorked(res);
+    return res.shapes;
+}
+
+// The {a: 1} index wins for this query, and is quickly done with it.
+assert.eq(1, t.find({a: 500, b: 1}).itcount());
+assert.eq(1, getShapes().length, tojson(getShapes()));
+
+// The same plan does a lot of work for a query of the same shape which is best answered with the
+// {b: 1} index. The cached plan gets replanned, and the answer is still right.
+var replannedBefore = getReplanned();
+assert.eq(1, t.find({a: 1, b: 500}).itcount());
+assert.eq(replannedBefore + 1, getReplanned());
+
+// Replanning puts the new winner in the cache, which does fine with queries like the last one.
+assert.eq(1, getShapes().length, tojson(getShapes()));
+assert.eq(1, t.find({a: 1, b: 600}).itcount());
+assert.eq(replannedBefore + 1, getReplanned());
+
+// No trial is needed once replanning is turned off.
+assert.commandWorked(db.adminCommand({setParameter: 1, internalQueryCacheEvictionRatio: 0}));
+assert.eq(1, t.find({a: 500, b: 1}).itcount());
+assert.eq(1, t.find({a: 1, b: 700}).itcount());
+assert.eq(replannedBefore + 1, getReplanned());
+assert.commandWorked(db.adminCommand({setParameter: 1, internalQueryCacheEvictionRatio: 10}));
+
+t.drop();
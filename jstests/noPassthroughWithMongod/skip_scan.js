@@ -0,0 +1,49 @@
+// Tests that a compound index whose first field has few values can answer a query on its second
+// field alone, by skipping from one value of the first field to the next.
+
+var t = db.jstests_skip_scan;
+t.drop();
+
+t.ensureIndex({status: 1, ts: 1});
+var statuses = ["active", "done", "failed"];
+for (var i = 0; i < 3000; i++) {
+    t.insert({status: statuses[i % 3], ts: i});
+}
+
+function getWinningScan(query) {
+    var stage = t.find(query).explain("executionStats").executionStats.executionStages;
+    while (stage.inputStage) {
+        stage = stage.inputStage;
+    }
+    return stage;
+}
+
+var query = {ts: {$gte: 1000, $lt: 1010}};
+
+// Without a histogram we don't know how many values status has, so the collection is scanned.
+assert.eq(10, t.find(query).itcount());
+assert.eq("COLLSCAN", getWinningScan(query).stage);
+
+assert.commandWorked(t.runCommand("buildIndexHistograms"));
+
+assert.eq(10, t.find(query).itcount());
+var scan = getWinningScan(query);
+assert.eq("IXSCAN", scan.stage, tojson(scan));
+assert.eq({status: 1, ts: 1}, scan.keyPattern);
+// Ten matching keys, and a few more to find each value of status.
+assert.lt(scan.keysExamined, 30, tojson(scan));
+
+// The results are the same as without the index.
+assert.eq(t.find(query).sort({ts: 1}).toArray(),
+          t.find(query).sort({ts: 1}).hint({$natural: 1}).toArray());
+
+// A predicate on status lets the regular plans use the index instead.
+scan = getWinningScan({status: "done", ts: {$gte: 1000, $lt: 1010}});
+assert.eq("IXSCAN", scan.stage, tojson(scan));
+assert.lte(scan.keysExamined, 4, tojson(scan));
+
+assert.commandWorked(db.adminCommand({setParameter: 1, internalQueryPlannerEnableSkipScan: false}));
+assert.eq("COLLSCAN", getWinningScan(query).stage);
+assert.commandWorked(db.adminCommand({setParameter: 1, internalQueryPlannerEnableSkipScan: true}));
+
+t.drop();
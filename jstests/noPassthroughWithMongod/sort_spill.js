@@ -0,0 +1,50 @@
+// Tests that a blocking sort in find which buffers more than internalQueryExecMaxBlockingSortBytes
+// spills to disk when internalQueryExecAllowBlockingSortSpill is set, and fails otherwise.
+
+var t = db.jstests_sort_spill;
+t.drop();
+
+var big = new Array(1024 * 1024).join("x");
+for (var i = 0; i < 40; i++) {
+    t.insert({a: (i * 7) % 40, big: big});
+}
+
+function getParam(name) {
+    var cmd = {getParameter: 1};
+    cmd[name] = 1;
+    var res = db.adminCommand(cmd);
+    assert.commandWorked(res);
+    return res[name];
+}
+
+function setParam(name, value) {
+    var cmd = {setParameter: 1};
+    cmd[name] = value;
+    assert.commandWorked(db.adminCommand(cmd));
+}
+
+var oldAllow = getParam("internalQueryExecAllowBlockingSortSpill");
+
+// 40MB of documents is more than a blocking sort may buffer.
+setParam("internalQueryExecAllowBlockingSortSpill", false);
+assert.throws(function() { t.find().sort({a: 1}).itcount(); });
+
+setParam("internalQueryExecAllowBlockingSortSpill", true);
+var results = t.find({}, {a: 1}).sort({a: -1}).toArray();
+assert.eq(40, results.length);
+for (var i = 0; i < results.length; i++) {
+    assert.eq(39 - i, results[i].a);
+}
+
+var explain = t.find().sort({a: 1}).explain("executionStats");
+var stage = explain.executionStats.executionStages;
+while (stage.stage != "SORT") {
+    stage = stage.inputStage;
+}
+assert(stage.usedDisk, tojson(stage));
+
+// Sorts with a limit keep only what they return, and never spill.
+assert.eq(0, t.find().sort({a: 1}).limit(1).next().a);
+
+setParam("internalQueryExecAllowBlockingSortSpill", oldAllow);
+t.drop();
@@ -0,0 +1,37 @@
+// The TTL monitor deletes expired documents in batches of ttlDeleteBatchSize, spread over
+// several collections, and reports each index's progress in serverStatus.
+(function() {
+    "use strict";
+    var admin = db.getSiblingDB("admin");
+    assert.commandWorked(admin.runCommand({setParameter: 1, ttlMonitorSleepSecs: 1}));
+    assert.commandWorked(admin.runCommand({setParameter: 1, ttlDeleteBatchSize: 10}));
+
+    var colls = [db.ttl_batches_a, db.ttl_batches_b];
+    var past = new Date(new Date().getTime() - 3600 * 1000);
+    colls.forEach(function(coll) {
+        coll.drop();
+        var bulk = coll.initializeUnorderedBulkOp();
+        for (var i = 0; i < 95; i++) {
+            bulk.insert({x: past});
+        }
+        for (var i = 0; i < 5; i++) {
+            bulk.insert({x: new Date()});
+        }
+        assert.writeOK(bulk.execute());
+        assert.commandWorked(coll.ensureIndex({x: 1}, {expireAfterSeconds: 600}));
+    });
+
+    colls.forEach(function(coll) {
+        assert.soon(function() { return coll.count() == 5; }, "expired documents left", 60 * 1000);
+    });
+
+    colls.forEach(function(coll) {
+        var stats = db.serverStatus().ttl.indexes[coll.getFullName() + ".$x_1"];
+        assert(stats, tojson(db.serverStatus().ttl));
+        assert.eq(95, stats.deletedDocuments, tojson(stats));
+        assert.gte(stats.batches, 10, tojson(stats));
+    });
+
+    assert.commandWorked(admin.runCommand({setParameter: 1, ttlDeleteBatchSize: 1000}));
+    assert.commandWorked(admin.runCommand({setParameter: 1, ttlMonitorSleepSecs: 60}));
+})();
@@ -0,0 +1,56 @@
+// Tests that initial sync copies the sync source's oplog while it clones, so that it still
+// completes when the source's oplog rolls over during the clone. Afterwards the new member must
+// have the same documents as the primary and no leftover buffer collection.
+
+var replTest = new ReplSetTest({name: 'initialSyncOplogBuffer', nodes: 1, oplogSize: 2});
+replTest.startSet();
+replTest.initiate();
+var master = replTest.getMaster();
+
+var masterDB = master.getDB("test");
+for (var c = 0; c < 4; c++) {
+    var coll = masterDB.getCollection("coll" + c);
+    for (var i = 0; i < 5000; i++) {
+        coll.insert({_id: i, s: "initial sync oplog buffer " + c});
+    }
+    assert.eq(null, masterDB.getLastError());
+}
+
+// Keep writing large documents while the new member syncs, enough to roll over the 2MB oplog
+// several times.
+var writer = startParallelShell(
+    'var big = new Array(16 * 1024).join("x");' +
+    'for (var i = 0; i < 1000; i++) {' +
+    '    db.churn.update({_id: i % 10}, {$set: {big: big, i: i}}, true);' +
+    '}' +
+    'db.getLastError();' +
+    'db.done.insert({_id: 1});' +
+    'db.getLastError();',
+    master.port);
+
+var newNode = replTest.add();
+replTest.reInitiate();
+replTest.awaitSecondaryNodes();
+writer();
+replTest.awaitReplication();
+
+var res = newNode.getDB("admin").runCommand({getParameter: 1, initialSyncBufferOplog: 1});
+assert.commandWorked(res);
+assert.eq(true, res.initialSyncBufferOplog);
+
+newNode.setSlaveOk();
+var newDB = newNode.getDB("test");
+for (var c = 0; c < 4; c++) {
+    var collName = "coll" + c;
+    assert.eq(masterDB.getCollection(collName).count(), newDB.getCollection(collName).count(),
+              collName);
+}
+assert.eq(masterDB.churn.find().sort({_id: 1}).toArray(),
+          newDB.churn.find().sort({_id: 1}).toArray());
+assert.eq(1, newDB.done.count());
+
+assert.eq(0, newNode.getDB("local").getCollectionNames().filter(function(name) {
+    return name == "temp_oplog_buffer";
+}).length, "initial sync left its oplog buffer behind");
+
+replTest.stopSet();
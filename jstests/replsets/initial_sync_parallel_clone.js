@@ -0,0 +1,49 @@
+// Tests that initial sync copies the collections of a database over several connections at once,
+// and that the new member ends up with the same documents and indexes as the primary.
+
+var replTest = new ReplSetTest({name: 'initialSyncParallelClone', nodes: 1});
+replTest.startSet();
+replTest.initiate();
+var master = replTest.getMaster();
+
+var dbNames = ["foo", "bar"];
+var numColls = 6;
+for (var d = 0; d < dbNames.length; d++) {
+    var masterDB = master.getDB(dbNames[d]);
+    for (var c = 0; c < numColls; c++) {
+        var coll = masterDB.getCollection("coll" + c);
+        for (var i = 0; i < 1000 * (c + 1); i++) {
+            coll.insert({_id: i, x: i % 10, s: "initial sync " + c});
+        }
+        assert.eq(null, masterDB.getLastError());
+        assert.commandWorked(coll.ensureIndex({x: 1}));
+    }
+}
+
+// Add a member that clones up to four collections at once.
+var newNode = replTest.add({setParameter: "initialSyncCollectionCloners=4"});
+replTest.reInitiate();
+replTest.awaitSecondaryNodes();
+replTest.awaitReplication();
+
+var res = newNode.getDB("admin").runCommand({getParameter: 1, initialSyncCollectionCloners: 1});
+assert.commandWorked(res);
+assert.eq(4, res.initialSyncCollectionCloners);
+
+newNode.setSlaveOk();
+for (var d = 0; d < dbNames.length; d++) {
+    var masterDB = master.getDB(dbNames[d]);
+    var newDB = newNode.getDB(dbNames[d]);
+    for (var c = 0; c < numColls; c++) {
+        var collName = "coll" + c;
+        assert.eq(masterDB.getCollection(collName).count(),
+                  newDB.getCollection(collName).count(),
+                  dbNames[d] + "." + collName);
+        assert.eq(masterDB.getCollection(collName).getIndexes().length,
+                  newDB.getCollection(collName).getIndexes().length,
+                  dbNames[d] + "." + collName);
+        assert.commandWorked(newDB.getCollection(collName).validate());
+    }
+}
+
+replTest.stopSet();
@@ -0,0 +1,44 @@
+// Tests that secondaries keep up with the primary when they stream the oplog of their sync source
+// in exhaust mode, and when they fall back to issuing getmores.
+
+function runTest(exhaust) {
+    var name = 'oplogFetcherExhaust' + (exhaust ? 'On' : 'Off');
+    var replTest = new ReplSetTest({name: name, nodes: 3,
+                                    nodeOptions: {setParameter: "bgSyncOplogFetcherExhaust=" +
+                                                                exhaust}});
+    replTest.startSet();
+    replTest.initiate();
+    var master = replTest.getMaster();
+    replTest.awaitSecondaryNodes();
+
+    var res = master.getDB("admin").runCommand({getParameter: 1, bgSyncOplogFetcherExhaust: 1});
+    assert.commandWorked(res);
+    assert.eq(exhaust, res.bgSyncOplogFetcherExhaust);
+
+    // Batches of various sizes, with pauses in between so the secondaries see the end of the
+    // oplog a few times
+    var coll = master.getDB("test").foo;
+    var numDocs = 0;
+    for (var round = 0; round < 5; round++) {
+        for (var i = 0; i < 1000 * round + 1; i++) {
+            coll.insert({_id: numDocs++, s: "streaming " + round});
+        }
+        assert.eq(null, master.getDB("test").getLastError());
+        assert.writeOK(coll.update({}, {$inc: {round: 1}}, {multi: true}));
+        sleep(500);
+    }
+    assert.writeOK(coll.insert({_id: numDocs++}, {writeConcern: {w: 3, wtimeout: 60 * 1000}}));
+
+    replTest.awaitReplication();
+    replTest.liveNodes.slaves.forEach(function(slave) {
+        slave.setSlaveOk();
+        var slaveColl = slave.getDB("test").foo;
+        assert.eq(numDocs, slaveColl.count(), slave.host);
+        assert.eq(numDocs - 1, slaveColl.find({round: 5}).count(), slave.host);
+    });
+
+    replTest.stopSet();
+}
+
+runTest(true);
+runTest(false);
@@ -0,0 +1,78 @@
+// Tests that tailers of the oplog waiting at the same entry are sent the batch the first of them
+// read, and that every tailer still sees every entry.
+
+var replTest = new ReplSetTest({name: 'oplogReadBuffer', nodes: 1});
+replTest.startSet();
+replTest.initiate();
+var master = replTest.getMaster();
+var oplog = master.getDB("local").oplog.rs;
+var coll = master.getDB("test").foo;
+
+function bufferStats() {
+    return master.getDB("admin").serverStatus().oplogReadBuffer;
+}
+
+function openTailer(fromTs) {
+    var cursor = oplog.find({ts: {$gte: fromTs}})
+                      .addOption(DBQuery.Option.tailable)
+                      .addOption(DBQuery.Option.oplogReplay);
+    // The first batch is the entry the tailer starts at.
+    assert.eq(fromTs, cursor.next().ts);
+    assert(!cursor.hasNext());
+    return cursor;
+}
+
+function readAll(cursor) {
+    var ids = [];
+    while (cursor.hasNext()) {
+        var entry = cursor.next();
+        if (entry.ns == coll.getFullName()) {
+            ids.push(entry.o._id);
+        }
+    }
+    return ids;
+}
+
+assert.writeOK(coll.insert({_id: -1}, {writeConcern: {w: 1}}));
+var lastTs = oplog.find().sort({$natural: -1}).limit(1).next().ts;
+var tailers = [openTailer(lastTs), openTailer(lastTs), openTailer(lastTs)];
+
+var expected = [];
+for (var round = 0; round < 3; round++) {
+    var before = bufferStats();
+    for (var i = 0; i < 10; i++) {
+        var id = round * 10 + i;
+        assert.writeOK(coll.insert({_id: id}));
+        expected.push(id);
+    }
+
+    // The first tailer reads and publishes the batch, the others are sent it.
+    tailers.forEach(function(cursor) {
+        assert.eq(expected.slice(round * 10), readAll(cursor));
+    });
+
+    var after = bufferStats();
+    assert.eq(before.published + 1, after.published, tojson(after));
+    assert.eq(before.hits + 2, after.hits, tojson(after));
+}
+
+// A tailer starting further back does not match any batch, and reads the oplog itself.
+var before = bufferStats();
+var lagging = oplog.find({ts: {$gte: lastTs}})
+                   .addOption(DBQuery.Option.tailable)
+                   .addOption(DBQuery.Option.oplogReplay)
+                   .batchSize(5);
+assert.eq([-1].concat(expected), readAll(lagging));
+assert.eq(before.hits, bufferStats().hits);
+
+// Turning the buffer off leaves every tailer reading for itself.
+assert.commandWorked(master.getDB("admin").runCommand({setParameter: 1,
+                                                       oplogReadBufferSizeMB: 0}));
+before = bufferStats();
+assert.writeOK(coll.insert({_id: 100}));
+tailers.forEach(function(cursor) {
+    assert.eq([100], readAll(cursor));
+});
+assert.eq(before.published, bufferStats().published);
+
+replTest.stopSet();
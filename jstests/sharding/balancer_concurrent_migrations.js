@@ -0,0 +1,81 @@
+//
+// Tests that the balancer can run several migrations at once, each between its own pair of
+// shards, and that it records their progress in the changelog.
+//
+
+var st = new ShardingTest({shards : 4,
+                           mongos : 1,
+                           other : {mongosOptions :
+                                        {setParameter : "balancerMaxConcurrentMigrations=4"}}});
+
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB("admin");
+var config = mongos.getDB("config");
+var shards = config.shards.find().sort({_id : 1}).toArray();
+
+var res = admin.runCommand({getParameter : 1, balancerMaxConcurrentMigrations : 1});
+assert.commandWorked(res);
+assert.eq(4, res.balancerMaxConcurrentMigrations);
+
+assert.commandWorked(admin.runCommand({enableSharding : "foo"}));
+admin.runCommand({movePrimary : "foo", to : shards[0]._id});
+
+// Put the chunks of each collection on a different shard, so each collection has a chunk to
+// move from a different donor
+var collNames = ["a", "b"];
+for (var i = 0; i < collNames.length; i++) {
+    var coll = mongos.getCollection("foo." + collNames[i]);
+    assert.commandWorked(admin.runCommand({shardCollection : coll + "", key : {_id : 1}}));
+    for (var j = 0; j < 8; j++) {
+        assert.commandWorked(admin.runCommand({split : coll + "", middle : {_id : j}}));
+    }
+
+    if (i == 0) continue;
+
+    config.chunks.find({ns : coll + ""}).forEach(function(chunk) {
+        assert.commandWorked(admin.runCommand({moveChunk : coll + "",
+                                               find : chunk.min,
+                                               to : shards[i]._id,
+                                               _waitForDelete : true}));
+    });
+}
+
+st.startBalancer();
+
+for (var i = 0; i < collNames.length; i++) {
+    st.awaitBalance(collNames[i], "foo", 5 * 60 * 1000);
+}
+
+st.stopBalancer();
+
+// Every migration issued by the balancer is in the changelog
+var entries = config.changelog.find({what : "balancer.moveChunk"}).toArray();
+printjson(entries);
+assert.neq(0, entries.length);
+
+var moved = 0;
+entries.forEach(function(entry) {
+    assert(entry.details.from, tojson(entry));
+    assert(entry.details.to, tojson(entry));
+    assert.neq(entry.details.from, entry.details.to, tojson(entry));
+    assert.gte(entry.details.executionTimeMillis, 0, tojson(entry));
+    assert.gte(entry.details.concurrentMigrations, 1, tojson(entry));
+    assert.lte(entry.details.concurrentMigrations, 4, tojson(entry));
+    if (entry.details.ok) moved++;
+});
+assert.neq(0, moved);
+
+// All the documents can still be found
+for (var i = 0; i < collNames.length; i++) {
+    var coll = mongos.getCollection("foo." + collNames[i]);
+    for (var j = 0; j < 8; j++) {
+        assert.writeOK(coll.insert({_id : j}));
+    }
+    assert.eq(8, coll.find().itcount());
+}
+
+jsTest.log("DONE!");
+
+st.stop();
@@ -0,0 +1,82 @@
+// Tests $near finds and the geoNear command on a collection spread over several shards: results
+// from all shards are merged nearest first.
+
+var st = new ShardingTest({ shards: 3, mongos: 1 });
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB("admin");
+var coll = mongos.getCollection("test.geo_near_find");
+var shards = mongos.getDB("config").shards.find().toArray();
+
+assert.commandWorked(admin.runCommand({ enableSharding: "test" }));
+assert.commandWorked(admin.runCommand({ shardCollection: coll + "", key: { _id: 1 } }));
+
+// Points i along the x axis, with chunks of 10 round-robined over the shards so that the nearest
+// results come from every shard.
+var numPts = 90;
+for (var i = 0; i < numPts; i++) {
+    assert.writeOK(coll.insert({ _id: i, loc: [i, 0] }));
+}
+for (var i = 10; i < numPts; i += 10) {
+    assert.commandWorked(admin.runCommand({ split: coll + "", middle: { _id: i } }));
+    assert.commandWorked(admin.runCommand({ moveChunk: coll + "",
+                                            find: { _id: i },
+                                            to: shards[(i / 10) % shards.length]._id,
+                                            _waitForDelete: true }));
+}
+
+function checkNearest(docs, from, expectedCount) {
+    assert.eq(expectedCount, docs.length, tojson(docs));
+    var expected = [];
+    for (var i = 0; i < numPts; i++) {
+        expected.push(i);
+    }
+    expected.sort(function(a, b) {
+        return (Math.abs(a - from) - Math.abs(b - from)) || (a - b);
+    });
+    for (var i = 0; i < docs.length; i++) {
+        assert.eq(Math.abs(expected[i] - from), Math.abs(docs[i]._id - from), tojson(docs));
+        assert.eq(undefined, docs[i].$geoNearDistance, tojson(docs[i]));
+    }
+}
+
+[ "2d", "2dsphere" ].forEach(function(indexType) {
+    coll.dropIndexes();
+    assert.commandWorked(coll.ensureIndex({ loc: indexType }));
+    var nearOp = indexType == "2d" ? "$near" : "$nearSphere";
+
+    var query = { loc: {} };
+    query.loc[nearOp] = [44.5, 0];
+    checkNearest(coll.find(query).limit(20).toArray(), 44.5, 20);
+    checkNearest(coll.find(query, { _id: 1 }).limit(30).toArray(), 44.5, 30);
+    checkNearest(coll.find(query).batchSize(3).limit(25).toArray(), 44.5, 25);
+    checkNearest(coll.find({ $and: [ query, { _id: { $gte: 0 } } ] }).limit(10).toArray(),
+                 44.5, 10);
+
+    // A requested distance is kept, and the added one is not returned.
+    var docs = coll.find(query, { d: { $meta: "geoNearDistance" } }).limit(5).toArray();
+    checkNearest(docs, 44.5, 5);
+    for (var i = 1; i < docs.length; i++) {
+        assert.lte(docs[i - 1].d, docs[i].d, tojson(docs));
+    }
+
+    // An explicit sort still decides the order.
+    docs = coll.find(query).sort({ _id: -1 }).limit(5).toArray();
+    assert.eq(5, docs.length);
+    for (var i = 1; i < docs.length; i++) {
+        assert.gt(docs[i - 1]._id, docs[i]._id, tojson(docs));
+    }
+
+    var res = coll.runCommand("geoNear", { near: [44.5, 0],
+                                           spherical: indexType == "2dsphere",
+                                           num: 15 });
+    assert.commandWorked(res);
+    checkNearest(res.results.map(function(r) { return r.obj; }), 44.5, 15);
+    for (var i = 1; i < res.results.length; i++) {
+        assert.lte(res.results[i - 1].dis, res.results[i].dis, tojson(res.results));
+    }
+    assert.eq(res.results[res.results.length - 1].dis, res.stats.maxDistance);
+});
+
+st.stop();
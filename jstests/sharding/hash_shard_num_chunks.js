@@ -27,10 +27,28 @@ shards.forEach(
     }
 );
 
+// The chunks were created on their shards, with no migrations, and every shard has the collection
+// with its shard key index.
+assert.eq(0, s.config.changelog.count({what: /^moveChunk/, ns: dbname + "." + coll}));
+[s.shard0, s.shard1, s.shard2].forEach(function(shard) {
+    var indexes = shard.getDB(dbname).getCollection(coll).getIndexes();
+    assert(indexes.some(function(index) { return friendlyEqual(index.key, {a: "hashed"}); }),
+           tojson(indexes));
+});
+
+// Documents are routed to every shard.
+for (var i = 0; i < 300; i++) {
+    assert.writeOK(db.getCollection(coll).insert({a: i}));
+}
+assert.eq(300, db.getCollection(coll).find().itcount());
+[s.shard0, s.shard1, s.shard2].forEach(function(shard) {
+    assert.gt(shard.getDB(dbname).getCollection(coll).count(), 0);
+});
+
 // Check that the collection gets dropped correctly (which doesn't happen if pre-splitting
 // fails to create the collection on all shards).
 res = db.runCommand({ "drop" : coll });
-assert.eq(res.ok, 1, "couldn't drop empty, pre-split collection");
+assert.eq(res.ok, 1, "couldn't drop pre-split collection");
 
 s.stop();
 
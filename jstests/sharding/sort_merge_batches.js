@@ -0,0 +1,72 @@
+// Tests that sorted queries merge the results of several shards correctly when the shards return
+// them over many batches, which are fetched ahead of time.
+
+var s = new ShardingTest({ name: "sort_merge_batches", shards: 3, mongos: 1 });
+s.stopBalancer();
+
+s.adminCommand({ enablesharding: "test" });
+s.adminCommand({ shardcollection: "test.data", key: { _id: 1 } });
+
+var db = s.getDB("test");
+
+var N = 3000;
+for (var i = 0; i < N; i++) {
+    db.data.insert({ _id: i, x: (i * 7919) % N, y: i % 10 });
+}
+assert.eq(null, db.getLastError());
+
+// Put one chunk on each shard, which spreads the values of x over all of them
+s.adminCommand({ split: "test.data", middle: { _id: 1000 } });
+s.adminCommand({ split: "test.data", middle: { _id: 2000 } });
+["shard0000", "shard0001", "shard0002"].forEach(function(shard, i) {
+    // Fails harmlessly for the chunk which is on the primary shard already
+    s.adminCommand({ movechunk: "test.data", find: { _id: i * 1000 }, to: shard,
+                     _waitForDelete: true });
+});
+assert.eq(1, s.config.chunks.find({ shard: "shard0000" }).itcount());
+assert.eq(1, s.config.chunks.find({ shard: "shard0001" }).itcount());
+assert.eq(1, s.config.chunks.find({ shard: "shard0002" }).itcount());
+
+function checkSorted(cursor, expectedCount, compare) {
+    var prev = null;
+    var count = 0;
+    while (cursor.hasNext()) {
+        var doc = cursor.next();
+        if (prev != null) {
+            assert.lte(compare(prev, doc), 0, "out of order: " + tojson(prev) + " " + tojson(doc));
+        }
+        prev = doc;
+        count++;
+    }
+    assert.eq(expectedCount, count);
+}
+
+function byX(a, b) {
+    return a.x - b.x;
+}
+
+function byYThenXDesc(a, b) {
+    return (a.y != b.y) ? (a.y - b.y) : (b.x - a.x);
+}
+
+[2, 17, 100, 0].forEach(function(batchSize) {
+    checkSorted(db.data.find().sort({ x: 1 }).batchSize(batchSize), N, byX);
+    checkSorted(db.data.find().sort({ y: 1, x: -1 }).batchSize(batchSize), N, byYThenXDesc);
+
+    // Limits and skips must still be applied exactly
+    var docs = db.data.find().sort({ x: 1 }).skip(10).limit(250).batchSize(batchSize).toArray();
+    assert.eq(250, docs.length);
+    for (var i = 0; i < docs.length; i++) {
+        assert.eq(10 + i, docs[i].x);
+    }
+});
+
+// Abandoning a cursor with a batch outstanding must not break later queries
+var cursor = db.data.find().sort({ x: 1 }).batchSize(5);
+for (var i = 0; i < 20; i++) {
+    cursor.next();
+}
+cursor.close();
+assert.eq(N, db.data.find().sort({ x: -1 }).itcount());
+
+s.stop();
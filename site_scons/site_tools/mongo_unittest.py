@@ -57,6 +57,26 @@ def build_cpp_unit_test(env, target, source, **kwargs):
     env.Install("#/build/unittests/", target)
     return result
 
+def build_cpp_benchmark(env, target, source, **kwargs):
+
+    libdeps = kwargs.get('LIBDEPS', [])
+    libdeps.append( '$BUILD_DIR/mongo/unittest/benchmark_main' )
+
+    includeCrutch = True
+    if "NO_CRUTCH" in kwargs:
+        includeCrutch = not kwargs["NO_CRUTCH"]
+
+    if includeCrutch:
+        libdeps.append( '$BUILD_DIR/mongo/unittest/unittest_crutch' )
+
+    kwargs['LIBDEPS'] = libdeps
+
+    # Benchmarks are not registered as unit tests; they only run when asked to.
+    result = env.Program(target, source, **kwargs)
+    env.Alias('benchmarks', result[0])
+    env.Install("#/build/benchmarks/", target)
+    return result
+
 def generate(env):
     # Capture the top level env so we can use it to generate the unit test list file
     # indepenently of which environment CppUnitTest was called in. Otherwise we will get "Two
@@ -68,4 +88,5 @@ def generate(env):
     env.Append(BUILDERS=dict(_UnitTestList=unit_test_list_builder))
     env.AddMethod(register_unit_test, 'RegisterUnitTest')
     env.AddMethod(build_cpp_unit_test, 'CppUnitTest')
+    env.AddMethod(build_cpp_benchmark, 'CppBenchmark')
     env.Alias('$UNITTEST_ALIAS', '$UNITTEST_LIST')
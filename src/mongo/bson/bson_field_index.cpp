@@ -0,0 +1,107 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bson_field_index.h"
+
+namespace mongo {
+
+    TSP_DEFINE(BSONFieldIndex::Scope, bsonFieldIndexScope);
+
+    BSONFieldIndex::BSONFieldIndex(const BSONObj& obj)
+        : _obj(obj),
+          _lookups(0) {
+    }
+
+    BSONElement BSONFieldIndex::getField(const StringData& name) const {
+        if (_slots.empty()) {
+            if (++_lookups < 2) {
+                BSONObjIterator i(_obj);
+                while (i.more()) {
+                    BSONElement e = i.next();
+                    if (name == e.fieldNameStringData())
+                        return e;
+                }
+                return BSONElement();
+            }
+            _build();
+        }
+
+        const size_t mask = _slots.size() - 1;
+        for (size_t i = StringData::Hasher()(name) & mask; _slots[i]; i = (i + 1) & mask) {
+            BSONElement e(_slots[i]);
+            if (name == e.fieldNameStringData())
+                return e;
+        }
+        return BSONElement();
+    }
+
+    void BSONFieldIndex::_build() const {
+        // At most half full, so probe sequences stay short.
+        size_t size = 16;
+        for (int n = _obj.nFields(); size < size_t(n) * 2; size *= 2) {
+        }
+        _slots.assign(size, NULL);
+
+        const size_t mask = size - 1;
+        BSONObjIterator it(_obj);
+        while (it.more()) {
+            BSONElement e = it.next();
+            const StringData name = e.fieldNameStringData();
+            size_t i = StringData::Hasher()(name) & mask;
+            while (_slots[i] && BSONElement(_slots[i]).fieldNameStringData() != name) {
+                i = (i + 1) & mask;
+            }
+            // The first of duplicate fields wins, as with BSONObj::getField().
+            if (!_slots[i])
+                _slots[i] = e.rawdata();
+        }
+    }
+
+    BSONFieldIndex::Scope::Scope(const BSONFieldIndex& index)
+        : _index(NULL),
+          _prev(NULL) {
+        if (index.obj().objsize() < kMinObjSize)
+            return;
+
+        _index = &index;
+        // Release rather than reset: the thread local storage must never delete a Scope.
+        _prev = bsonFieldIndexScope.release();
+        bsonFieldIndexScope.reset(this);
+    }
+
+    BSONFieldIndex::Scope::~Scope() {
+        if (!_index)
+            return;
+
+        bsonFieldIndexScope.release();
+        bsonFieldIndexScope.reset(_prev);
+    }
+
+}  // namespace mongo
@@ -0,0 +1,100 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/util/assert_util.h"  // TODO: remove apple dep for this in threadlocal.h
+#include "mongo/util/concurrency/threadlocal.h"
+
+namespace mongo {
+
+    /**
+     * A field name to element table for one document, for code that looks up many fields of the
+     * same wide document, e.g. generating the keys of every index on an insert. The first lookup
+     * scans the document like BSONObj::getField() does; the table is built on the second.
+     *
+     * While a BSONFieldIndex::Scope is alive, BSONObj::getField() on the indexed document goes
+     * through the table, so code that is only handed the BSONObj benefits too. The document's
+     * buffer must outlive the index.
+     */
+    class BSONFieldIndex {
+    public:
+        explicit BSONFieldIndex(const BSONObj& obj);
+
+        /** Same result as obj().getField(name): the first field called 'name', or EOO. */
+        BSONElement getField(const StringData& name) const;
+
+        const BSONObj& obj() const { return _obj; }
+
+        /**
+         * Makes BSONObj::getField() on the indexed document use the index on this thread, for the
+         * lifetime of the scope. Does nothing for documents smaller than kMinObjSize, which are
+         * as quick to scan. Scopes must be destroyed in the reverse order of their creation.
+         */
+        class Scope {
+            MONGO_DISALLOW_COPYING(Scope);
+        public:
+            explicit Scope(const BSONFieldIndex& index);
+            ~Scope();
+
+        private:
+            friend class BSONFieldIndex;
+
+            const BSONFieldIndex* _index; // NULL if the document is too small to bother
+            Scope* _prev;
+        };
+
+        /** Returns the index in scope on this thread for the document at 'objdata', or NULL. */
+        static const BSONFieldIndex* inScope(const char* objdata);
+
+        static const int kMinObjSize = 2048;
+
+    private:
+        void _build() const;
+
+        BSONObj _obj;
+        mutable int _lookups;
+        mutable std::vector<const char*> _slots; // open addressing on field name, NULL if empty
+    };
+
+    TSP_DECLARE(BSONFieldIndex::Scope, bsonFieldIndexScope);
+
+    inline const BSONFieldIndex* BSONFieldIndex::inScope(const char* objdata) {
+        for (const Scope* s = bsonFieldIndexScope.get(); s; s = s->_prev) {
+            if (s->_index->_obj.objdata() == objdata)
+                return s->_index;
+        }
+        return NULL;
+    }
+
+}  // namespace mongo
@@ -0,0 +1,104 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/bson/bson_field_index.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+
+    using namespace mongo;
+
+    std::string fieldName(int i) {
+        return str::stream() << "field" << i;
+    }
+
+    BSONObj wideObj(int nFields) {
+        BSONObjBuilder b;
+        for (int i = 0; i < nFields; i++) {
+            b.append(fieldName(i), i);
+        }
+        return b.obj();
+    }
+
+    TEST(BSONFieldIndex, FindsEveryField) {
+        BSONObj obj = wideObj(300);
+        BSONFieldIndex index(obj);
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < 300; i++) {
+                BSONElement e = index.getField(fieldName(i));
+                ASSERT_EQUALS(i, e.numberInt());
+                ASSERT_EQUALS(obj.getField(fieldName(i)).rawdata(), e.rawdata());
+            }
+            ASSERT(index.getField("missing").eoo());
+            ASSERT(index.getField("field").eoo());
+        }
+    }
+
+    TEST(BSONFieldIndex, FirstDuplicateWins) {
+        BSONObj obj = BSON("a" << 1 << "b" << 2 << "a" << 3);
+        BSONFieldIndex index(obj);
+        ASSERT_EQUALS(1, index.getField("a").numberInt());
+        ASSERT_EQUALS(1, index.getField("a").numberInt());
+        ASSERT_EQUALS(2, index.getField("b").numberInt());
+    }
+
+    TEST(BSONFieldIndex, ScopeRoutesGetField) {
+        BSONObj obj = wideObj(300);
+        ASSERT_GREATER_THAN_OR_EQUALS(obj.objsize(), BSONFieldIndex::kMinObjSize);
+        ASSERT(BSONFieldIndex::inScope(obj.objdata()) == NULL);
+        {
+            BSONFieldIndex index(obj);
+            BSONFieldIndex::Scope scope(index);
+            ASSERT(BSONFieldIndex::inScope(obj.objdata()) == &index);
+
+            BSONObj other = wideObj(300);
+            BSONFieldIndex otherIndex(other);
+            {
+                BSONFieldIndex::Scope otherScope(otherIndex);
+                ASSERT(BSONFieldIndex::inScope(other.objdata()) == &otherIndex);
+                ASSERT(BSONFieldIndex::inScope(obj.objdata()) == &index);
+                ASSERT_EQUALS(299, obj.getField("field299").numberInt());
+                ASSERT_EQUALS(299, obj["field299"].numberInt());
+            }
+            ASSERT(BSONFieldIndex::inScope(other.objdata()) == NULL);
+        }
+        ASSERT(BSONFieldIndex::inScope(obj.objdata()) == NULL);
+    }
+
+    TEST(BSONFieldIndex, SmallDocumentsAreNotScoped) {
+        BSONObj obj = BSON("a" << 1);
+        BSONFieldIndex index(obj);
+        BSONFieldIndex::Scope scope(index);
+        ASSERT(BSONFieldIndex::inScope(obj.objdata()) == NULL);
+        ASSERT_EQUALS(1, obj.getField("a").numberInt());
+    }
+
+}  // namespace
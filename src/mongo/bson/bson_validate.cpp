@@ -28,7 +28,7 @@
  */
 
 #include <cstring>
-#include <deque>
+#include <vector>
 
 #include "mongo/base/data_view.h"
 #include "mongo/bson/bson_validate.h"
@@ -167,6 +167,47 @@ namespace mongo {
             int _startPosition;
         };
 
+        /**
+         * The objects being validated, innermost last. Documents are rarely nested deeply, so the
+         * first kInlineFrames levels live in the stack object itself and validating a typical
+         * document doesn't allocate.
+         */
+        class ValidationFrameStack {
+        public:
+            ValidationFrameStack() : _size(0) {}
+
+            ValidationObjectFrame& push() {
+                ValidationObjectFrame frame = ValidationObjectFrame();
+                if (_size < kInlineFrames) {
+                    _inline[_size++] = frame;
+                    return _inline[_size - 1];
+                }
+                _size++;
+                _overflow.push_back(frame);
+                return _overflow.back();
+            }
+
+            void pop() {
+                if (_size > kInlineFrames)
+                    _overflow.pop_back();
+                _size--;
+            }
+
+            ValidationObjectFrame& back() {
+                return _size > kInlineFrames ? _overflow.back() : _inline[_size - 1];
+            }
+
+            size_t size() const { return _size; }
+            bool empty() const { return _size == 0; }
+
+        private:
+            static const size_t kInlineFrames = 32;
+
+            ValidationObjectFrame _inline[kInlineFrames];
+            std::vector<ValidationObjectFrame> _overflow;
+            size_t _size;
+        };
+
         /**
          * WARNING: only pass in a non-EOO idElem if it has been fully validated already!
          */
@@ -267,7 +308,7 @@ namespace mongo {
         }
 
         Status validateBSONIterative(Buffer* buffer) {
-            std::deque<ValidationObjectFrame> frames;
+            ValidationFrameStack frames;
             ValidationObjectFrame* curr = NULL;
             ValidationState::State state = ValidationState::BeginObj;
 
@@ -277,8 +318,7 @@ namespace mongo {
             while (state != ValidationState::Done) {
                 switch (state) {
                 case ValidationState::BeginObj:
-                    frames.push_back(ValidationObjectFrame());
-                    curr = &frames.back();
+                    curr = &frames.push();
                     curr->setStartPosition(buffer->position());
                     curr->setIsCodeWithScope(false);
                     if (!buffer->readNumber<int>(&curr->expectedSize)) {
@@ -288,24 +328,30 @@ namespace mongo {
                     // fall through
                 case ValidationState::WithinObj: {
                     const bool atTopLevel = frames.size() == 1;
-                    // check if we've finished validating idElem and are at start of next element.
-                    if (atTopLevel && idElemStartPos) {
-                        idElem = BSONElement(buffer->getBasePtr() + idElemStartPos);
-                        buffer->setIdElem(idElem);
-                        idElemStartPos = 0;
-                    }
-
-                    const uint64_t elemStartPos = buffer->position();
                     ValidationState::State nextState = state;
-                    Status status = validateElementInfo(buffer, &nextState, idElem);
-                    if (!status.isOK())
-                        return status;
 
-                    // we've already validated that fieldname is safe to access as long as we aren't
-                    // at the end of the object, since EOO doesn't have a fieldname.
-                    if (nextState != ValidationState::EndObj && idElem.eoo() && atTopLevel) {
-                        if (strcmp(buffer->getBasePtr() + elemStartPos + 1/*type*/, "_id") == 0) {
-                            idElemStartPos = elemStartPos;
+                    // Most elements are scalars, which leave us in this object: validate those in
+                    // this loop rather than going around the state machine once per element.
+                    while (nextState == ValidationState::WithinObj) {
+                        // check if we've finished validating idElem and are at start of next
+                        // element.
+                        if (atTopLevel && idElemStartPos) {
+                            idElem = BSONElement(buffer->getBasePtr() + idElemStartPos);
+                            buffer->setIdElem(idElem);
+                            idElemStartPos = 0;
+                        }
+
+                        const uint64_t elemStartPos = buffer->position();
+                        Status status = validateElementInfo(buffer, &nextState, idElem);
+                        if (!status.isOK())
+                            return status;
+
+                        // we've already validated that fieldname is safe to access as long as we
+                        // aren't at the end of the object, since EOO doesn't have a fieldname.
+                        if (nextState != ValidationState::EndObj && idElem.eoo() && atTopLevel) {
+                            if (strcmp(buffer->getBasePtr() + elemStartPos + 1/*type*/, "_id") == 0) {
+                                idElemStartPos = elemStartPos;
+                            }
                         }
                     }
 
@@ -317,7 +363,7 @@ namespace mongo {
                     if ( actualLength != curr->expectedSize ) {
                         return makeError("bson length doesn't match what we found", idElem);
                     }
-                    frames.pop_back();
+                    frames.pop();
                     if (frames.empty()) {
                         state = ValidationState::Done;
                     }
@@ -331,8 +377,7 @@ namespace mongo {
                     break;
                 }
                 case ValidationState::BeginCodeWScope: {
-                    frames.push_back(ValidationObjectFrame());
-                    curr = &frames.back();
+                    curr = &frames.push();
                     curr->setStartPosition(buffer->position());
                     curr->setIsCodeWithScope(true);
                     if ( !buffer->readNumber<int>( &curr->expectedSize ) )
@@ -349,7 +394,7 @@ namespace mongo {
                         return makeError("bson length for CodeWScope doesn't match what we found",
                                          idElem);
                     }
-                    frames.pop_back();
+                    frames.pop();
                     if (frames.empty())
                         return makeError("unnested CodeWScope", idElem);
                     curr = &frames.back();
@@ -239,6 +239,21 @@ namespace {
         ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() / 2));
     }
 
+    TEST(BSONValidateFast, DeeplyNestedObject) {
+        // Deeper than the validator keeps inline, with an invalid length at the bottom.
+        BSONObj x = BSON("a" << 1);
+        for (int i = 0; i < 100; i++) {
+            x = BSON("b" << x << "c" << i);
+        }
+        ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+
+        std::string copy(x.objdata(), x.objsize());
+        const size_t innermost = copy.find("\x10" "a");
+        ASSERT_NOT_EQUALS(innermost, std::string::npos);
+        DataView(&copy[innermost - 4]).writeLE<int32_t>(13);
+        ASSERT_NOT_OK(validateBSON(copy.data(), copy.size()));
+    }
+
     TEST(BSONValidateFast, ErrorWithId) {
         BufBuilder bb;
         BSONObjBuilder ob(bb);
@@ -31,6 +31,7 @@
 
 #include "mongo/db/jsobj.h"
 
+#include "mongo/bson/bson_field_index.h"
 #include "mongo/bson/bson_validate.h"
 #include "mongo/db/json.h"
 #include "mongo/util/allocator.h"
@@ -644,6 +645,9 @@ namespace mongo {
     }
 
     BSONElement BSONObj::getField(const StringData& name) const {
+        if (const BSONFieldIndex* index = BSONFieldIndex::inScope(objdata()))
+            return index->getField(name);
+
         BSONObjIterator i(*this);
         while ( i.more() ) {
             BSONElement e = i.next();
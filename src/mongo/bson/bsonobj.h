@@ -172,6 +172,11 @@ namespace mongo {
         */
         bool isOwned() const { return _ownedBuffer.get() != 0; }
 
+        /** the buffer holding this object's data if isOwned(), otherwise an empty one.  a copy
+            keeps objdata() valid for as long as it is held.
+        */
+        const SharedBuffer& sharedBuffer() const { return _ownedBuffer; }
+
         /** assure the data buffer is under the control of this BSONObj and not a remote buffer
             @see isOwned()
         */
@@ -0,0 +1,126 @@
+// bsonobj_bench.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/benchmark.h"
+
+namespace mongo {
+namespace {
+
+    using unittest::doNotOptimizeAway;
+
+    BSONObj makeFlatObject() {
+        BSONObjBuilder bob;
+        bob.append("_id", OID::gen());
+        bob.append("name", "a moderately long string value");
+        bob.append("count", 42);
+        bob.append("total", 12345678901LL);
+        bob.append("ratio", 0.75);
+        bob.append("active", true);
+        bob.appendDate("created", Date_t(1420070400000ULL));
+        bob.append("tags", BSON_ARRAY("red" << "green" << "blue"));
+        bob.append("address", BSON("city" << "New York" << "zip" << "10001"));
+        bob.appendNull("deleted");
+        return bob.obj();
+    }
+
+    BENCHMARK(BSONObjBuilder, TenIntFields) {
+        while (state.keepRunning()) {
+            BSONObjBuilder bob;
+            bob.append("a", 1);
+            bob.append("b", 2);
+            bob.append("c", 3);
+            bob.append("d", 4);
+            bob.append("e", 5);
+            bob.append("f", 6);
+            bob.append("g", 7);
+            bob.append("h", 8);
+            bob.append("i", 9);
+            bob.append("j", 10);
+            doNotOptimizeAway(bob.obj());
+        }
+    }
+
+    BENCHMARK(BSONObjBuilder, MixedTypes) {
+        while (state.keepRunning()) {
+            doNotOptimizeAway(makeFlatObject());
+        }
+    }
+
+    BENCHMARK(BSONObjBuilder, ThousandElementArray) {
+        while (state.keepRunning()) {
+            BSONObjBuilder bob;
+            BSONArrayBuilder arr(bob.subarrayStart("values"));
+            for (int i = 0; i < 1000; i++) {
+                arr.append(i);
+            }
+            arr.doneFast();
+            doNotOptimizeAway(bob.obj());
+        }
+    }
+
+    BENCHMARK(BSONObjIterator, MixedTypes) {
+        const BSONObj obj = makeFlatObject();
+        while (state.keepRunning()) {
+            int types = 0;
+            BSONObjIterator it(obj);
+            while (it.more()) {
+                types += it.next().type();
+            }
+            doNotOptimizeAway(types);
+        }
+    }
+
+    BENCHMARK(BSONObj, GetFieldLast) {
+        const BSONObj obj = makeFlatObject();
+        while (state.keepRunning()) {
+            doNotOptimizeAway(obj["deleted"]);
+        }
+    }
+
+    BENCHMARK(BSONObj, WoCompare) {
+        const BSONObj lhs = makeFlatObject();
+        const BSONObj rhs = lhs.copy();
+        while (state.keepRunning()) {
+            doNotOptimizeAway(lhs.woCompare(rhs));
+        }
+    }
+
+    BENCHMARK(BSONObj, Valid) {
+        const BSONObj obj = makeFlatObject();
+        while (state.keepRunning()) {
+            doNotOptimizeAway(obj.valid());
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
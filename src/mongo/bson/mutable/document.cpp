@@ -29,8 +29,8 @@
 
 #include "mongo/bson/mutable/document.h"
 
-#include <boost/scoped_ptr.hpp>
 #include <boost/static_assert.hpp>
+#include <boost/thread/tss.hpp>
 #include <cstdlib>
 #include <cstring>
 #include <limits>
@@ -420,6 +420,14 @@ namespace mutablebson {
         const size_t kFastReps = 128;
 #endif
 
+        // How many Impls each thread keeps for reuse, and how much memory one may hold on to
+        // and still be kept. Updates use two Documents at a time, one for the document and one
+        // for the oplog entry. Impls that grew to build unusually large documents are freed
+        // rather than pinned in an idle thread.
+        const size_t kMaxPooledImpls = 2;
+        const size_t kMaxPooledBufferBytes = 64 * 1024;
+        const size_t kMaxPooledSlowReps = 1024;
+
         // An ElementRep contains the information necessary to locate the data for an Element,
         // and the topology information for how the Element is related to other Elements in the
         // document.
@@ -588,6 +596,14 @@ namespace mutablebson {
             _leafBuilder.abandon();
         }
 
+        // Returns an Impl in the state the constructor would leave it in. Reuses one given to
+        // 'release' on this thread if there is one.
+        static Impl* acquire(Document::InPlaceMode inPlaceMode);
+
+        // Takes ownership of 'impl'. Resets it and keeps it for 'acquire' on this thread,
+        // unless this thread keeps enough Impls already or 'impl' holds too much memory.
+        static void release(Impl* impl);
+
         void reset(Document::InPlaceMode inPlaceMode) {
             // Clear out the state in the vectors.
             _slowElements.clear();
@@ -1107,8 +1123,63 @@ namespace mutablebson {
         // Queue of damage events and status bit for whether  in-place updates are possible.
         DamageVector _damages;
         Document::InPlaceMode _inPlaceMode;
+
+        // The Impls kept by a thread, deleted with it.
+        class Pool {
+        public:
+            ~Pool() {
+                for (size_t i = 0; i < _free.size(); ++i) {
+                    delete _free[i];
+                }
+            }
+
+            std::vector<Impl*> _free;
+        };
+
+        static boost::thread_specific_ptr<Pool> _pool;
+
+        // True if this Impl holds little enough memory to be worth keeping in a Pool.
+        bool smallEnoughToPool() const {
+            return (static_cast<size_t>(_leafBuf.getSize()) <= kMaxPooledBufferBytes) &&
+                (_fieldNames.capacity() <= kMaxPooledBufferBytes) &&
+                (_fieldNameScratch.capacity() <= kMaxPooledBufferBytes) &&
+                (_slowElements.capacity() <= kMaxPooledSlowReps) &&
+                (_damages.capacity() <= kMaxPooledSlowReps);
+        }
     };
 
+    boost::thread_specific_ptr<Document::Impl::Pool> Document::Impl::_pool;
+
+    Document::Impl* Document::Impl::acquire(Document::InPlaceMode inPlaceMode) {
+        Pool* pool = _pool.get();
+        if (!pool || pool->_free.empty())
+            return new Impl(inPlaceMode);
+
+        Impl* impl = pool->_free.back();
+        pool->_free.pop_back();
+        impl->_inPlaceMode = inPlaceMode;
+        return impl;
+    }
+
+    void Document::Impl::release(Impl* impl) {
+        Pool* pool = _pool.get();
+        if (!pool) {
+            pool = new Pool();
+            _pool.reset(pool);
+        }
+
+        if (pool->_free.size() >= kMaxPooledImpls || !impl->smallEnoughToPool()) {
+            delete impl;
+            return;
+        }
+
+        // Resetting drops the Impl's references to the BSONObjs it was built from, so a
+        // pooled Impl never keeps a caller's buffers alive.
+        impl->reset(Document::kInPlaceDisabled);
+        pool->_free.reserve(kMaxPooledImpls);
+        pool->_free.push_back(impl);
+    }
+
     Status Element::addSiblingLeft(Element e) {
         verify(ok());
         verify(e.ok());
@@ -2222,13 +2293,13 @@ namespace mutablebson {
     }
 
     Document::Document()
-        : _impl(new Impl(Document::kInPlaceDisabled))
+        : _impl(Impl::acquire(Document::kInPlaceDisabled))
         , _root(makeRootElement()) {
         dassert(_root._repIdx == kRootRepIdx);
     }
 
     Document::Document(const BSONObj& value, InPlaceMode inPlaceMode)
-        : _impl(new Impl(inPlaceMode))
+        : _impl(Impl::acquire(inPlaceMode))
         , _root(makeRootElement(value)) {
         dassert(_root._repIdx == kRootRepIdx);
     }
@@ -2247,7 +2318,9 @@ namespace mutablebson {
         dassert(_root._repIdx == kRootRepIdx);
     }
 
-    Document::~Document() {}
+    Document::~Document() {
+        Impl::release(_impl);
+    }
 
     void Document::reserveDamageEvents(size_t expectedEvents) {
         return getImpl().reserveDamageEvents(expectedEvents);
@@ -2655,15 +2728,11 @@ namespace mutablebson {
     }
 
     inline Document::Impl& Document::getImpl() {
-        // Don't use scoped_ptr<Impl>::operator* since it may generate assertions that the
-        // pointer is non-null, but we already know that to be always and forever true, and
-        // otherwise the assertion code gets spammed into every method that inlines the call to
-        // this function. We just dereference the pointer returned from 'get' ourselves.
-        return *_impl.get();
+        return *_impl;
     }
 
     inline const Document::Impl& Document::getImpl() const {
-        return *_impl.get();
+        return *_impl;
     }
 
 } // namespace mutablebson
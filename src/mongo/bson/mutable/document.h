@@ -263,6 +263,11 @@ namespace mutablebson {
          *  it may (though it is not required to) preserve the memory allocation of the
          *  internal data structures of Document. If you need to logically create and destroy
          *  many Documents in serial, it may be faster to reset.
+         *
+         *  Destroying a Document hands its internal state to a small per-thread pool, from
+         *  which the next Document constructed on that thread takes it, as if by 'reset'. So
+         *  Documents created and destroyed one after the other on the same thread, like those
+         *  of successive update operations, reuse their memory as well.
          */
         void reset();
 
@@ -509,7 +514,8 @@ namespace mutablebson {
         Element makeRootElement(const BSONObj& value);
         Element makeElement(ConstElement element, const StringData* fieldName);
 
-        const boost::scoped_ptr<Impl> _impl;
+        // Owned. Taken from and returned to the per-thread pool of Impls in document.cpp.
+        Impl* const _impl;
 
         // The root element of this document.
         const Element _root;
@@ -1089,6 +1089,52 @@ namespace {
         ASSERT_EQUALS(false, e3Child.getValueBool());
     }
 
+    TEST(Document, LifecycleConstructAfterDestroy) {
+        // A Document constructed after another was destroyed on this thread may reuse its
+        // internal state. Verify that none of that state shows through.
+        {
+            mongo::BSONObj obj = mongo::fromjson("{ a : 1, b : { c : [ 1, 2, 3 ] }, d : 'x' }");
+            mmb::Document doc(obj, mmb::Document::kInPlaceEnabled);
+            ASSERT_OK(doc.root()["a"].setValueInt(5));
+            for (int i = 0; i < 300; ++i) {
+                ASSERT_OK(doc.root().appendInt("n", i));
+            }
+            ASSERT_FALSE(doc.isInPlaceModeEnabled());
+        }
+
+        mmb::Document empty;
+        ASSERT_FALSE(empty.isInPlaceModeEnabled());
+        ASSERT_FALSE(empty.root().leftChild().ok());
+        ASSERT_FALSE(empty.root().hasValue());
+        ASSERT_EQUALS(mongo::BSONObj(), empty.getObject());
+
+        mongo::BSONObj obj = mongo::fromjson("{ x : 1 }");
+        mmb::Document doc(obj, mmb::Document::kInPlaceEnabled);
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
+        ASSERT_EQUALS(obj, doc.getObject());
+
+        mmb::DamageVector damages;
+        const char* source = NULL;
+        size_t size = 0;
+        ASSERT_TRUE(doc.getInPlaceUpdates(&damages, &source, &size));
+        ASSERT_TRUE(damages.empty());
+    }
+
+    TEST(Document, LifecycleConstructAfterDestroyingLargeDocument) {
+        // Documents that grew large are not kept for reuse, but that should not be visible
+        // either.
+        {
+            mmb::Document doc;
+            const std::string big(128 * 1024, 'x');
+            ASSERT_OK(doc.root().appendString("big", big));
+        }
+
+        mmb::Document doc;
+        ASSERT_FALSE(doc.root().leftChild().ok());
+        ASSERT_OK(doc.root().appendInt("a", 1));
+        ASSERT_EQUALS(mongo::fromjson("{ a : 1 }"), doc.getObject());
+    }
+
     TEST(Document, RenameDeserialization) {
         // Regression test for a bug where certain rename operations failed to deserialize up
         // the tree correctly, resulting in a lost rename
@@ -0,0 +1,150 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/util/builder.h"
+
+#include <algorithm>
+
+#include "mongo/base/init.h"
+#include "mongo/base/status.h"
+#include "mongo/util/concurrency/threadlocal.h"
+
+namespace mongo {
+
+namespace {
+
+    const int kMinClassLog2 = 10; // 1KB
+    const int kMaxClassLog2 = 20; // 1MB
+    const int kNumClasses = kMaxClassLog2 - kMinClassLog2 + 1;
+    const int kBuffersPerClass = 4;
+    const size_t kMaxPooledBytes = 1024 * 1024;
+
+    /** Returns the size class of buffers of 'size' bytes, or -1 if they aren't pooled. */
+    int sizeClass(size_t size) {
+        if (size < (size_t(1) << kMinClassLog2) || size > (size_t(1) << kMaxClassLog2))
+            return -1;
+        if (size & (size - 1))
+            return -1;
+
+        int c = 0;
+        while ((size_t(1) << (kMinClassLog2 + c)) < size)
+            c++;
+        return c;
+    }
+
+    class ThreadBufferPool {
+        MONGO_DISALLOW_COPYING(ThreadBufferPool);
+    public:
+        ThreadBufferPool() : _bytes(0) {
+            memset(_counts, 0, sizeof(_counts));
+        }
+
+        ~ThreadBufferPool();
+
+        void* take(int c) {
+            if (_counts[c] == 0)
+                return NULL;
+            _bytes -= size_t(1) << (kMinClassLog2 + c);
+            return _buffers[c][--_counts[c]];
+        }
+
+        /** Returns false if the pool is full and 'p' should be freed. */
+        bool put(void* p, int c) {
+            const size_t size = size_t(1) << (kMinClassLog2 + c);
+            if (_counts[c] == kBuffersPerClass || _bytes + size > kMaxPooledBytes)
+                return false;
+            _bytes += size;
+            _buffers[c][_counts[c]++] = p;
+            return true;
+        }
+
+    private:
+        void* _buffers[kNumClasses][kBuffersPerClass];
+        int _counts[kNumClasses];
+        size_t _bytes;
+    };
+
+    /// Until the pool's thread local storage is initialized, buffers go straight to malloc.
+    bool isBufferPoolInitialized = false;
+
+    MONGO_INITIALIZER(BufferPool)(InitializerContext*) {
+        isBufferPoolInitialized = true;
+        return Status::OK();
+    }
+
+}  // namespace
+
+    TSP_DECLARE(ThreadBufferPool, threadBufferPool);
+    TSP_DEFINE(ThreadBufferPool, threadBufferPool);
+
+    ThreadBufferPool::~ThreadBufferPool() {
+        for (int c = 0; c < kNumClasses; c++) {
+            for (int i = 0; i < _counts[c]; i++) {
+                free(_buffers[c][i]);
+            }
+        }
+        // This runs at thread exit; make builders destroyed after it free their buffers instead.
+        threadBufferPool.release();
+    }
+
+    void* BufferPool::allocate(size_t size) {
+        const int c = sizeClass(size);
+        if (c >= 0 && isBufferPoolInitialized) {
+            void* p = threadBufferPool.getMake()->take(c);
+            if (p)
+                return p;
+        }
+        return mongoMalloc(size);
+    }
+
+    void* BufferPool::reallocate(void* p, size_t oldSize, size_t newSize) {
+        if (!p)
+            return allocate(newSize);
+
+        if (sizeClass(newSize) < 0 || !isBufferPoolInitialized)
+            return mongoRealloc(p, newSize);
+
+        void* moved = allocate(newSize);
+        memcpy(moved, p, std::min(oldSize, newSize));
+        release(p, oldSize);
+        return moved;
+    }
+
+    void BufferPool::release(void* p, size_t size) {
+        const int c = sizeClass(size);
+        if (c >= 0 && isBufferPoolInitialized) {
+            ThreadBufferPool* pool = threadBufferPool.get();
+            if (pool && pool->put(p, c))
+                return;
+        }
+        free(p);
+    }
+
+}  // namespace mongo
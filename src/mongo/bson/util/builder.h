@@ -75,11 +75,33 @@ namespace mongo {
     template <typename Allocator>
     class StringBuilderImpl;
 
+    /**
+     * A per-thread cache of the buffers BufBuilders allocate, so that the buffers of builders
+     * that are destroyed are reused by the next ones rather than going back to malloc. Only
+     * power-of-two sizes from 1KB to 1MB are cached, at most 1MB per thread: those are the sizes
+     * buffers have once they have grown, and smaller ones are cheap to malloc.
+     *
+     * The buffers are ordinary mongoMalloc() memory, so a buffer handed off with
+     * BufBuilder::decouple(), e.g. to a Message, is still released with free().
+     */
+    class BufferPool {
+    public:
+        static void* allocate(size_t size);
+
+        /** Moves 'p', of 'oldSize' bytes, to a buffer of 'newSize' bytes. */
+        static void* reallocate(void* p, size_t oldSize, size_t newSize);
+
+        /** 'size' must be what 'p' was allocated with. */
+        static void release(void* p, size_t size);
+    };
+
     class TrivialAllocator { 
     public:
-        void* Malloc(size_t sz) { return mongoMalloc(sz); }
-        void* Realloc(void *p, size_t sz) { return mongoRealloc(p, sz); }
-        void Free(void *p) { free(p); }
+        void* Malloc(size_t sz) { return BufferPool::allocate(sz); }
+        void* Realloc(void *p, size_t oldSz, size_t sz) {
+            return BufferPool::reallocate(p, oldSz, sz);
+        }
+        void Free(void *p, size_t sz) { BufferPool::release(p, sz); }
     };
 
     class StackAllocator {
@@ -89,7 +111,7 @@ namespace mongo {
             if( sz <= SZ ) return buf;
             return mongoMalloc(sz);
         }
-        void* Realloc(void *p, size_t sz) { 
+        void* Realloc(void *p, size_t oldSz, size_t sz) { 
             if( p == buf ) {
                 if( sz <= SZ ) return buf;
                 void *d = mongoMalloc(sz);
@@ -100,7 +122,7 @@ namespace mongo {
             }
             return mongoRealloc(p, sz);
         }
-        void Free(void *p) { 
+        void Free(void *p, size_t sz) { 
             if( p != buf )
                 free(p); 
         }
@@ -130,7 +152,7 @@ namespace mongo {
 
         void kill() {
             if ( data ) {
-                al.Free(data);
+                al.Free(data, size);
                 data = 0;
             }
         }
@@ -141,7 +163,7 @@ namespace mongo {
         void reset( int maxSize ) {
             l = 0;
             if ( maxSize && size > maxSize ) {
-                al.Free(data);
+                al.Free(data, size);
                 data = (char*)al.Malloc(maxSize);
                 if ( data == 0 )
                     msgasserted( 15913 , "out of memory BufBuilder::reset" );
@@ -256,7 +278,7 @@ namespace mongo {
                 ss << "BufBuilder attempted to grow() to " << a << " bytes, past the 64MB limit.";
                 msgasserted(13548, ss.str().c_str());
             }
-            data = (char *) al.Realloc(data, a);
+            data = (char *) al.Realloc(data, size, a);
             if ( data == NULL )
                 msgasserted( 16070 , "out of memory BufBuilder::grow_reallocate" );
             size = a;
@@ -44,6 +44,24 @@ namespace mongo {
         ASSERT_EQUALS( 0, strcmp( "eliot", bb.buf() ) );
     }
 
+    TEST(Builder, BufferPoolReusesBuffers) {
+        void* p = BufferPool::allocate(4096);
+        BufferPool::release(p, 4096);
+        void* q = BufferPool::allocate(4096);
+        ASSERT_EQUALS(p, q);
+        BufferPool::release(q, 4096);
+    }
+
+    TEST(Builder, GrowKeepsContents) {
+        BufBuilder bb;
+        for (int i = 0; i < 100000; i++) {
+            bb.appendNum(i);
+        }
+        for (int i = 0; i < 100000; i++) {
+            ASSERT_EQUALS(i, ConstDataView(bb.buf()).readLE<int>(i * sizeof(int)));
+        }
+    }
+
     TEST(Builder, StringBuilderAddress) {
         const void* longPtr = reinterpret_cast<const void*>(-1);
         const void* shortPtr = reinterpret_cast<const void*>(0xDEADBEEF);
@@ -39,6 +39,7 @@
 #include "mongo/client/syncclusterconnection.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
 #include "mongo/s/shard.h"
 
 namespace mongo {
@@ -51,9 +52,9 @@ namespace mongo {
 
     void PoolForHost::clear() {
         while ( ! _pool.empty() ) {
-            StoredConnection sc = _pool.top();
+            StoredConnection sc = _pool.back();
             delete sc.conn;
-            _pool.pop();
+            _pool.pop_back();
         }
     }
 
@@ -74,7 +75,7 @@ namespace mongo {
         }
         else {
             // The connection is probably fine, save for later
-            _pool.push(c);
+            _pool.push_back(c);
         }
     }
 
@@ -99,10 +100,12 @@ namespace mongo {
         time_t now = time(0);
         
         while ( ! _pool.empty() ) {
-            StoredConnection sc = _pool.top();
-            _pool.pop();
-            
-            if ( ! sc.ok( now ) )  {
+            StoredConnection sc = _pool.back();
+            _pool.pop_back();
+
+            // Recently used or checked connections skip the check, which getStaleConnections
+            // makes in the background
+            if ( now - sc.lastChecked >= _healthCheckSecs && ! sc.ok( now ) )  {
                 pool->onDestroy( sc.conn );
                 delete sc.conn;
                 continue;
@@ -119,8 +122,8 @@ namespace mongo {
 
     void PoolForHost::flush() {
         while (!_pool.empty()) {
-            StoredConnection c = _pool.top();
-            _pool.pop();
+            StoredConnection c = _pool.back();
+            _pool.pop_back();
             delete c.conn;
         }
     }
@@ -128,31 +131,41 @@ namespace mongo {
     void PoolForHost::getStaleConnections( vector<DBClientBase*>& stale ) {
         time_t now = time(0);
 
-        vector<StoredConnection> all;
+        // The longest idle connections are at the front
+        std::deque<StoredConnection> all;
         while ( ! _pool.empty() ) {
-            StoredConnection c = _pool.top();
-            _pool.pop();
-            
-            if ( c.ok( now ) )
+            StoredConnection c = _pool.front();
+            _pool.pop_front();
+
+            const int remaining = static_cast<int>( all.size() + _pool.size() );
+            if ( _idleTimeoutSecs != kNoIdleTimeout &&
+                 now - c.when >= _idleTimeoutSecs &&
+                 remaining >= _minPoolSize ) {
+                _idleClosed++;
+                stale.push_back( c.conn );
+            }
+            else if ( c.ok( now ) )
                 all.push_back( c );
             else
                 stale.push_back( c.conn );
         }
 
-        for ( size_t i=0; i<all.size(); i++ ) {
-            _pool.push( all[i] );
-        }
+        _pool.swap( all );
     }
 
 
     PoolForHost::StoredConnection::StoredConnection( DBClientBase * c ) {
         conn = c;
         when = time(0);
+        lastChecked = when;
     }
 
     bool PoolForHost::StoredConnection::ok( time_t now ) {
         // Poke the connection to see if we're still ok
-        return conn->isStillConnected();
+        if ( ! conn->isStillConnected() )
+            return false;
+        lastChecked = now;
+        return true;
     }
 
     void PoolForHost::createdOne( DBClientBase * base) {
@@ -173,30 +186,44 @@ namespace mongo {
 
     const int PoolForHost::kPoolSizeUnlimited(-1);
 
+    const int PoolForHost::kNoIdleTimeout(-1);
+
     DBConnectionPool::DBConnectionPool()
         : _mutex("DBConnectionPool") , 
           _name( "dbconnectionpool" ) , 
           _maxPoolSize(PoolForHost::kPoolSizeUnlimited) ,
+          _minPoolSize(0) ,
+          _idleTimeoutSecs(PoolForHost::kNoIdleTimeout) ,
+          _healthCheckSecs(0) ,
           _hooks( new list<DBConnectionHook*>() ) {
     }
 
+    PoolForHost& DBConnectionPool::_getPool_inlock( const string& ident , double socketTimeout ) {
+        PoolForHost& p = _pools[PoolKey(ident,socketTimeout)];
+        p.setMaxPoolSize(_maxPoolSize);
+        p.setMinPoolSize(_minPoolSize);
+        p.setIdleTimeout(_idleTimeoutSecs);
+        p.setHealthCheckInterval(_healthCheckSecs);
+        p.initializeHostName(ident);
+        return p;
+    }
+
+    void DBConnectionPool::_recordCheckout( unsigned long long startMicros ) {
+        _checkouts.fetchAndAdd(1);
+        _checkoutMicros.fetchAndAdd(curTimeMicros64() - startMicros);
+    }
+
     DBClientBase* DBConnectionPool::_get(const string& ident , double socketTimeout ) {
         uassert(17382, "Can't use connection pool during shutdown",
                 !inShutdown());
         scoped_lock L(_mutex);
-        PoolForHost& p = _pools[PoolKey(ident,socketTimeout)];
-        p.setMaxPoolSize(_maxPoolSize);
-        p.initializeHostName(ident);
-        return p.get( this , socketTimeout );
+        return _getPool_inlock(ident, socketTimeout).get( this , socketTimeout );
     }
 
     DBClientBase* DBConnectionPool::_finishCreate( const string& host , double socketTimeout , DBClientBase* conn ) {
         {
             scoped_lock L(_mutex);
-            PoolForHost& p = _pools[PoolKey(host,socketTimeout)];
-            p.setMaxPoolSize(_maxPoolSize);
-            p.initializeHostName(host);
-            p.createdOne( conn );
+            _getPool_inlock(host, socketTimeout).createdOne( conn );
         }
         
         try {
@@ -212,6 +239,7 @@ namespace mongo {
     }
 
     DBClientBase* DBConnectionPool::get(const ConnectionString& url, double socketTimeout) {
+        const unsigned long long start = curTimeMicros64();
         DBClientBase * c = _get( url.toString() , socketTimeout );
         if ( c ) {
             try {
@@ -221,6 +249,7 @@ namespace mongo {
                 delete c;
                 throw;
             }
+            _recordCheckout( start );
             return c;
         }
 
@@ -228,10 +257,13 @@ namespace mongo {
         c = url.connect( errmsg, socketTimeout );
         uassert( 13328 ,  _name + ": connect failed " + url.toString() + " : " + errmsg , c );
 
-        return _finishCreate( url.toString() , socketTimeout , c );
+        c = _finishCreate( url.toString() , socketTimeout , c );
+        _recordCheckout( start );
+        return c;
     }
 
     DBClientBase* DBConnectionPool::get(const string& host, double socketTimeout) {
+        const unsigned long long start = curTimeMicros64();
         DBClientBase * c = _get( host , socketTimeout );
         if ( c ) {
             try {
@@ -241,6 +273,7 @@ namespace mongo {
                 delete c;
                 throw;
             }
+            _recordCheckout( start );
             return c;
         }
 
@@ -251,7 +284,9 @@ namespace mongo {
         c = cs.connect( errmsg, socketTimeout );
         if ( ! c )
             throw SocketException( SocketException::CONNECT_ERROR , host , 11002 , str::stream() << _name << " error: " << errmsg );
-        return _finishCreate( host , socketTimeout , c );
+        c = _finishCreate( host , socketTimeout , c );
+        _recordCheckout( start );
+        return c;
     }
 
     void DBConnectionPool::onRelease(DBClientBase* conn) {
@@ -339,6 +374,7 @@ namespace mongo {
 
         int avail = 0;
         long long created = 0;
+        long long idleClosed = 0;
 
 
         map<ConnectionString::ConnectionType,long long> createdByType;
@@ -355,10 +391,12 @@ namespace mongo {
                 BSONObjBuilder temp( bb.subobjStart( s ) );
                 temp.append( "available" , i->second.numAvailable() );
                 temp.appendNumber( "created" , i->second.numCreated() );
+                temp.appendNumber( "idleClosed" , i->second.numIdleClosed() );
                 temp.done();
 
                 avail += i->second.numAvailable();
                 created += i->second.numCreated();
+                idleClosed += i->second.numIdleClosed();
 
                 long long& x = createdByType[i->second.type()];
                 x += i->second.numCreated();
@@ -394,6 +432,9 @@ namespace mongo {
 
         b.append( "totalAvailable" , avail );
         b.appendNumber( "totalCreated" , created );
+        b.appendNumber( "totalIdleClosed" , idleClosed );
+        b.appendNumber( "totalCheckouts" , _checkouts.load() );
+        b.appendNumber( "totalCheckoutMicros" , _checkoutMicros.load() );
     }
 
     bool DBConnectionPool::serverNameCompare::operator()( const string& a , const string& b ) const{
@@ -30,7 +30,7 @@
 #pragma once
 
 #include <boost/noncopyable.hpp>
-#include <stack>
+#include <deque>
 
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/client/export_macros.h"
@@ -53,18 +53,29 @@ namespace mongo {
         // Sentinel value indicating pool has no cleanup limit
         static const int kPoolSizeUnlimited;
 
+        // Sentinel value indicating idle connections are never closed
+        static const int kNoIdleTimeout;
+
         PoolForHost() :
             _created(0),
+            _idleClosed(0),
             _minValidCreationTimeMicroSec(0),
             _type(ConnectionString::INVALID),
-            _maxPoolSize(kPoolSizeUnlimited) {
+            _maxPoolSize(kPoolSizeUnlimited),
+            _minPoolSize(0),
+            _idleTimeoutSecs(kNoIdleTimeout),
+            _healthCheckSecs(0) {
         }
 
         PoolForHost(const PoolForHost& other) :
             _created(other._created),
+            _idleClosed(other._idleClosed),
             _minValidCreationTimeMicroSec(other._minValidCreationTimeMicroSec),
             _type(other._type),
-            _maxPoolSize(other._maxPoolSize) {
+            _maxPoolSize(other._maxPoolSize),
+            _minPoolSize(other._minPoolSize),
+            _idleTimeoutSecs(other._idleTimeoutSecs),
+            _healthCheckSecs(other._healthCheckSecs) {
             verify(_created == 0);
             verify(other._pool.size() == 0);
         }
@@ -81,15 +92,37 @@ namespace mongo {
          */
         void setMaxPoolSize( int maxPoolSize ) { _maxPoolSize = maxPoolSize; }
 
+        /**
+         * Sets the number of idle connections which are kept even past the idle timeout
+         */
+        void setMinPoolSize( int minPoolSize ) { _minPoolSize = minPoolSize; }
+
+        /**
+         * Sets how long a connection may sit unused in the pool before getStaleConnections
+         * closes it, or kNoIdleTimeout
+         */
+        void setIdleTimeout( int idleTimeoutSecs ) { _idleTimeoutSecs = idleTimeoutSecs; }
+
+        /**
+         * Sets how long after a connection was last known to be good it is checked again on
+         * checkout. Connections used or probed more recently are handed out without a check.
+         */
+        void setHealthCheckInterval( int healthCheckSecs ) { _healthCheckSecs = healthCheckSecs; }
+
         int numAvailable() const { return (int)_pool.size(); }
 
         void createdOne( DBClientBase * base );
         long long numCreated() const { return _created; }
 
+        /**
+         * Number of connections closed for having been idle too long
+         */
+        long long numIdleClosed() const { return _idleClosed; }
+
         ConnectionString::ConnectionType type() const { verify(_created); return _type; }
 
         /**
-         * gets a connection or return NULL
+         * gets the most recently returned connection or return NULL
          */
         DBClientBase * get( DBConnectionPool * pool , double socketTimeout );
 
@@ -100,6 +133,10 @@ namespace mongo {
 
         void flush();
 
+        /**
+         * Checks every pooled connection, and removes the ones which are broken or have been idle
+         * longer than the idle timeout, keeping at least the minimum pool size of idle ones.
+         */
         void getStaleConnections( std::vector<DBClientBase*>& stale );
 
         /**
@@ -127,18 +164,33 @@ namespace mongo {
             bool ok( time_t now );
 
             DBClientBase* conn;
+
+            // When the connection was returned to the pool
             time_t when;
+
+            // When the connection was last known to be good
+            time_t lastChecked;
         };
 
         std::string _hostName;
-        std::stack<StoredConnection> _pool;
+
+        // Most recently returned at the back, so checkouts reuse the warmest connections and the
+        // ones at the front are the first to go idle
+        std::deque<StoredConnection> _pool;
 
         int64_t _created;
+        int64_t _idleClosed;
         uint64_t _minValidCreationTimeMicroSec;
         ConnectionString::ConnectionType _type;
 
         // The maximum number of connections we'll save in the pool
         int _maxPoolSize;
+
+        // The number of idle connections the idle timeout leaves open
+        int _minPoolSize;
+
+        int _idleTimeoutSecs;
+        int _healthCheckSecs;
     };
 
     class DBConnectionHook {
@@ -191,6 +243,23 @@ namespace mongo {
          */
         void setMaxPoolSize( int maxPoolSize ) { _maxPoolSize = maxPoolSize; }
 
+        /**
+         * Sets the number of idle connections per-host which are never closed for being idle.
+         */
+        void setMinPoolSize( int minPoolSize ) { _minPoolSize = minPoolSize; }
+
+        /**
+         * Sets how many seconds a connection may sit unused in the pool before the periodic
+         * cleanup closes it. PoolForHost::kNoIdleTimeout, the default, keeps them open.
+         */
+        void setIdleTimeout( int idleTimeoutSecs ) { _idleTimeoutSecs = idleTimeoutSecs; }
+
+        /**
+         * Sets how many seconds since a connection was last used or checked by the periodic
+         * cleanup it is handed out without checking it is still connected. 0 checks every time.
+         */
+        void setHealthCheckInterval( int healthCheckSecs ) { _healthCheckSecs = healthCheckSecs; }
+
         void onCreate( DBClientBase * conn );
         void onHandedOut( DBClientBase * conn );
         void onDestroy( DBClientBase * conn );
@@ -240,6 +309,16 @@ namespace mongo {
 
         DBClientBase* _finishCreate( const std::string& ident , double socketTimeout, DBClientBase* conn );
 
+        /**
+         * Returns the pool for the host, with this pool's settings applied. Requires _mutex.
+         */
+        PoolForHost& _getPool_inlock( const std::string& ident , double socketTimeout );
+
+        /**
+         * Counts a checkout which started at startMicros.
+         */
+        void _recordCheckout( unsigned long long startMicros );
+
         struct PoolKey {
             PoolKey( const std::string& i , double t ) : ident( i ) , timeout( t ) {}
             std::string ident;
@@ -260,8 +339,16 @@ namespace mongo {
         // 0 effectively disables the pool
         int _maxPoolSize;
 
+        int _minPoolSize;
+        int _idleTimeoutSecs;
+        int _healthCheckSecs;
+
         PoolMap _pools;
 
+        // Connections handed out, and the total time callers waited for them
+        AtomicInt64 _checkouts;
+        AtomicInt64 _checkoutMicros;
+
         // pointers owned by me, right now they leak on shutdown
         // _hooks itself also leaks because it creates a shutdown race condition
         std::list<DBConnectionHook*> * _hooks;
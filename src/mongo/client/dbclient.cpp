@@ -39,12 +39,14 @@
 #include "mongo/client/sasl_client_authenticate.h"
 #include "mongo/client/syncclusterconnection.h"
 #include "mongo/db/auth/internal_user_auth.h"
+#include "mongo/db/dbmessage.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/s/stale_exception.h"  // for RecvStaleConfigException
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
+#include "mongo/util/net/message_compressor.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/net/ssl_options.h"
 #include "mongo/util/password_digest.h"
@@ -255,6 +257,7 @@ namespace mongo {
     const BSONField<BSONObj> Query::ReadPrefField("$readPreference");
     const BSONField<string> Query::ReadPrefModeField("mode");
     const BSONField<BSONArray> Query::ReadPrefTagsField("tags");
+    const BSONField<int> Query::ReadPrefMaxStalenessField("maxStalenessSeconds");
 
     Query::Query( const string &json ) : obj( fromjson( json ) ) {}
 
@@ -1061,13 +1064,43 @@ namespace mongo {
         int sslModeVal = sslGlobalParams.sslMode.load();
         if (sslModeVal == SSLGlobalParams::SSLMode_preferSSL ||
             sslModeVal == SSLGlobalParams::SSLMode_requireSSL) {
-            return p->secure( sslManager(), _server.host() );
+            if ( !p->secure( sslManager(), _server.host() ) ) {
+                return false;
+            }
         }
 #endif
 
+        if ( isMessageCompressionEnabled() ) {
+            _negotiateMessageCompression();
+        }
+
         return true;
     }
 
+    void DBClientConnection::_negotiateMessageCompression() {
+        BSONObjBuilder cmd;
+        cmd.append( "isMaster", 1 );
+        appendMessageCompressionRequest( &cmd );
+
+        BSONObj info;
+        try {
+            if ( !runCommand( "admin", cmd.obj(), info ) ) {
+                return;
+            }
+        }
+        catch ( const DBException& e ) {
+            // Servers that can't be asked get uncompressed messages, and the next operation
+            // reports any problem with the connection
+            LOG( 1 ) << "couldn't negotiate message compression with " << toString()
+                     << causedBy( e ) << endl;
+            return;
+        }
+
+        p->setCompressMessages( isMessageCompressionAccepted( info ) );
+        LOG( 2 ) << "message compression with " << toString() << ": "
+                 << p->compressMessages() << endl;
+    }
+
     void DBClientConnection::logout(const string& dbname, BSONObj& info){
         authCache.erase(dbname);
         runCommand(dbname, BSON("logout" << 1), info);
@@ -1550,6 +1583,10 @@ namespace mongo {
     }
 
     bool DBClientConnection::recv( Message &m ) {
+        uassert( 28628,
+                 str::stream() << "can't receive a lazy reply from " << toString()
+                               << " while pipelined requests are in flight",
+                 _pipelinedInFlight.empty() );
         if (port().recv(m)) {
             return true;
         }
@@ -1564,6 +1601,18 @@ namespace mongo {
                  it fails
         */
         checkConnection();
+
+        // The next reply could be to a pipelined request, so take our turn in the pipeline
+        if ( !_pipelinedInFlight.empty() ) {
+            if ( !recvPipelined( sayPipelined( toSend ), response ) ) {
+                if ( assertOk )
+                    uasserted( 10278 , str::stream() << "dbclient error communicating with server: " << getServerAddress() );
+
+                return false;
+            }
+            return true;
+        }
+
         try {
             if ( !port().call(toSend, response) ) {
                 _failed = true;
@@ -1580,6 +1629,140 @@ namespace mongo {
         return true;
     }
 
+    int DBClientConnection::sayPipelined( Message& toSend ) {
+        while ( _pipelinedInFlight.size() >= kMaxPipelinedRequests ||
+                ( !_pipelinedInFlight.empty() &&
+                  _pipelinedInFlightBytes + toSend.size() > kMaxPipelinedBytes ) ) {
+            if ( !_recvNextPipelined() ) {
+                break;  // say() below reports the failure
+            }
+        }
+
+        say( toSend );
+
+        const int requestId = toSend.header().getId();
+        _pipelinedInFlight[requestId] = toSend.size();
+        _pipelinedInFlightBytes += toSend.size();
+        return requestId;
+    }
+
+    bool DBClientConnection::recvPipelined( int requestId, Message& response ) {
+        std::map<int, Message>::iterator it = _pipelinedReplies.find( requestId );
+        while ( it == _pipelinedReplies.end() ) {
+            if ( _pipelinedInFlight.count( requestId ) == 0 ) {
+                // Lost with the connection, or never sent
+                uassert( 28629,
+                         str::stream() << "no pipelined request " << requestId << " on "
+                                       << toString(),
+                         _failed );
+                return false;
+            }
+            if ( !_recvNextPipelined() ) {
+                return false;
+            }
+            it = _pipelinedReplies.find( requestId );
+        }
+
+        response = it->second;
+        _pipelinedReplies.erase( it );
+        return true;
+    }
+
+    void DBClientConnection::discardPipelined( int requestId ) {
+        if ( _pipelinedReplies.erase( requestId ) ) {
+            return;
+        }
+        if ( _pipelinedInFlight.count( requestId ) ) {
+            _pipelinedDiscarded.insert( requestId );
+        }
+    }
+
+    bool DBClientConnection::_recvNextPipelined() {
+        Message reply;
+        if ( !port().recv( reply ) ) {
+            // Whatever was in flight is gone with the connection
+            _failed = true;
+            _pipelinedInFlight.clear();
+            _pipelinedInFlightBytes = 0;
+            _pipelinedDiscarded.clear();
+            return false;
+        }
+
+        const int responseTo = reply.header().getResponseTo();
+        std::map<int, int>::iterator it = _pipelinedInFlight.find( responseTo );
+        massert( 28630,
+                 str::stream() << "reply to unknown request " << responseTo << " from "
+                               << toString(),
+                 it != _pipelinedInFlight.end() );
+        _pipelinedInFlightBytes -= it->second;
+        _pipelinedInFlight.erase( it );
+
+        if ( _pipelinedDiscarded.erase( responseTo ) == 0 ) {
+            _pipelinedReplies[responseTo] = reply;
+        }
+        return true;
+    }
+
+namespace {
+    int sayPipelinedQuery( DBClientConnection* conn,
+                           const string& ns,
+                           const BSONObj& query,
+                           const BSONObj* fieldsToReturn,
+                           int queryOptions ) {
+        Message toSend;
+        assembleRequest( ns, query, -1, 0, fieldsToReturn, queryOptions, toSend );
+        return conn->sayPipelined( toSend );
+    }
+} // namespace
+
+    PipelinedQuery::PipelinedQuery( DBClientConnection* conn,
+                                    const string& ns,
+                                    const BSONObj& query,
+                                    const BSONObj* fieldsToReturn,
+                                    int queryOptions )
+        : _conn( conn ),
+          _requestId( sayPipelinedQuery( conn, ns, query, fieldsToReturn, queryOptions ) ),
+          _done( false ) {
+    }
+
+    PipelinedQuery::~PipelinedQuery() {
+        if ( !_done ) {
+            _conn->discardPipelined( _requestId );
+        }
+    }
+
+    BSONObj PipelinedQuery::join() {
+        if ( _done ) {
+            return _result;
+        }
+        _done = true;
+
+        Message response;
+        uassert( 10278,
+                 str::stream() << "dbclient error communicating with server: "
+                               << _conn->getServerAddress(),
+                 _conn->recvPipelined( _requestId, response ) );
+
+        QueryResult::View qr = response.singleData().view2ptr();
+        if ( qr.getNReturned() == 0 ) {
+            return _result;
+        }
+
+        // Watches for "not master", as for any other reply
+        bool retry;
+        string host;
+        _conn->checkResponse( qr.data(), qr.getNReturned(), &retry, &host );
+
+        BSONObj first( qr.data() );
+        if ( ( qr.getResultFlags() & ResultFlag_ErrSet ) &&
+             strcmp( first.firstElementFieldName(), "$err" ) == 0 ) {
+            uasserted( 13106, "PipelinedQuery::join(): " + first.toString() );
+        }
+
+        _result = first.getOwned();
+        return _result;
+    }
+
     BSONElement getErrField(const BSONObj& o) {
         BSONElement first = o.firstElement();
         if( strcmp(first.fieldName(), "$err") == 0 )
@@ -134,6 +134,18 @@ namespace {
                 uasserted(16383, str::stream() << "Unknown read preference mode: " << mode);
             }
 
+            int maxStalenessSeconds = 0;
+            if (prefDoc.hasField(Query::ReadPrefMaxStalenessField.name())) {
+                const BSONElement& maxStalenessElem =
+                    prefDoc[Query::ReadPrefMaxStalenessField.name()];
+                uassert(28615, "maxStalenessSeconds for read preference should be a "
+                               "non-negative number",
+                        maxStalenessElem.isNumber() && maxStalenessElem.numberInt() >= 0);
+                maxStalenessSeconds = maxStalenessElem.numberInt();
+                uassert(28616, "maxStalenessSeconds is not allowed with primary read preference",
+                        maxStalenessSeconds == 0 || pref != mongo::ReadPreference_PrimaryOnly);
+            }
+
             if (prefDoc.hasField(Query::ReadPrefTagsField.name())) {
                 const BSONElement& tagsElem = prefDoc[Query::ReadPrefTagsField.name()];
                 uassert(16385, "tags for read preference should be an array",
@@ -145,10 +157,10 @@ namespace {
                             tags.getTagBSON().firstElement().Obj().isEmpty());
                 }
 
-                return new ReadPreferenceSetting(pref, tags);
+                return new ReadPreferenceSetting(pref, tags, maxStalenessSeconds);
             }
             else {
-                return new ReadPreferenceSetting(pref, TagSet());
+                return new ReadPreferenceSetting(pref, TagSet(), maxStalenessSeconds);
             }
         }
 
@@ -158,6 +170,27 @@ namespace {
                 mongo::ReadPreference_SecondaryPreferred : mongo::ReadPreference_PrimaryOnly;
         return new ReadPreferenceSetting(pref, TagSet());
     }
+
+    /**
+     * Counts a request to a replica set member as in flight for as long as it is in scope, so
+     * that the monitor can steer other requests to less loaded members.
+     */
+    class InFlightRequest {
+        MONGO_DISALLOW_COPYING(InFlightRequest);
+    public:
+        InFlightRequest(const ReplicaSetMonitorPtr& monitor, const HostAndPort& host)
+            : _monitor(monitor), _host(host) {
+            _monitor->noteRequestStarted(_host);
+        }
+
+        ~InFlightRequest() {
+            _monitor->noteRequestFinished(_host);
+        }
+
+    private:
+        const ReplicaSetMonitorPtr _monitor;
+        const HostAndPort _host;
+    };
 } // namespace
 
     // --------------------------------
@@ -552,6 +585,7 @@ namespace {
                         break;
                     }
 
+                    InFlightRequest inFlight(_getMonitor(), _lastSlaveOkHost);
                     auto_ptr<DBClientCursor> cursor = conn->query(ns, query,
                             nToReturn, nToSkip, fieldsToReturn, queryOptions,
                             batchSize);
@@ -612,6 +646,7 @@ namespace {
                         break;
                     }
 
+                    InFlightRequest inFlight(_getMonitor(), _lastSlaveOkHost);
                     return conn->findOne(ns,query,fieldsToReturn,queryOptions);
                 }
                 catch ( const DBException &dbExcep ) {
@@ -972,6 +1007,7 @@ namespace {
                             *actualServer = conn->getServerAddress();
                         }
 
+                        InFlightRequest inFlight(_getMonitor(), _lastSlaveOkHost);
                         return conn->call(toSend, response, assertOk);
                     }
                     catch ( const DBException& dbExcep ) {
@@ -1090,6 +1126,8 @@ namespace {
         BSONObjBuilder bob;
         bob.append( "pref", readPrefToString( pref ) );
         bob.append( "tags", tags.getTagBSON() );
+        if ( maxStalenessSeconds > 0 )
+            bob.append( "maxStalenessSeconds", maxStalenessSeconds );
         return bob.obj();
     }
 }
@@ -346,18 +346,23 @@ namespace mongo {
          *     tag set will have this in a reset state (meaning, this
          *     object's copy of tag will have the iterator in the initial
          *     position).
+         * @param maxStalenessSeconds if positive, secondaries that are further behind the
+         *     primary are not selected.
          */
-        ReadPreferenceSetting(ReadPreference pref, const TagSet& tag):
-            pref(pref), tags(tag) {
+        ReadPreferenceSetting(ReadPreference pref, const TagSet& tag,
+                              int maxStalenessSeconds = 0):
+            pref(pref), tags(tag), maxStalenessSeconds(maxStalenessSeconds) {
         }
 
         inline bool equals(const ReadPreferenceSetting& other) const {
-            return pref == other.pref && tags == other.tags;
+            return pref == other.pref && tags == other.tags &&
+                maxStalenessSeconds == other.maxStalenessSeconds;
         }
 
         BSONObj toBSON() const;
 
         const ReadPreference pref;
         TagSet tags;
+        int maxStalenessSeconds; // 0 if unlimited
     };
 }
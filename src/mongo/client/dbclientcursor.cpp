@@ -50,6 +50,11 @@ namespace mongo {
 
     void DBClientCursor::_finishConsInit() {
         _originalHost = _client->getServerAddress();
+        _prefetchConn = NULL;
+        _prefetchPipelined = false;
+        _prefetchRequestId = 0;
+        _readAhead = false;
+        _readAheadTried = false;
     }
 
     int DBClientCursor::nextBatchSize() {
@@ -151,9 +156,7 @@ namespace mongo {
         return ok;
     }
 
-    void DBClientCursor::requestMore() {
-        verify( cursorId && batch.pos == batch.nReturned );
-
+    void DBClientCursor::_assembleGetMore( Message& toSend ) {
         if (haveLimit) {
             nToReturn -= batch.nReturned;
             verify(nToReturn > 0);
@@ -164,9 +167,43 @@ namespace mongo {
         b.appendNum(nextBatchSize());
         b.appendNum(cursorId);
 
-        Message toSend;
         toSend.setData(dbGetMore, b.buf(), b.len());
+    }
+
+    void DBClientCursor::requestMore() {
+        verify( cursorId && batch.pos == batch.nReturned );
+
         auto_ptr<Message> response(new Message());
+        _readAheadTried = false;
+
+        if ( _prefetchPipelined ) {
+            // The request was pipelined on our connection by prefetchMore()
+            _prefetchPipelined = false;
+            DBClientConnection* conn = static_cast<DBClientConnection*>( _client );
+            uassert( 28603,
+                     "recv failed while getting more results",
+                     conn->recvPipelined( _prefetchRequestId, *response ) );
+            this->batch.m = response;
+            dataReceived();
+            return;
+        }
+
+        if ( _prefetchConn ) {
+            // The request was sent by prefetchMore() already
+            auto_ptr<ScopedDbConnection> conn( _prefetchConn );
+            _prefetchConn = NULL;
+
+            uassert( 28603, "recv failed while getting more results", (*conn)->recv( *response ) );
+            _client = conn->get();
+            this->batch.m = response;
+            dataReceived();
+            _client = 0;
+            conn->done();
+            return;
+        }
+
+        Message toSend;
+        _assembleGetMore( toSend );
 
         if ( _client ) {
             _client->call( toSend, *response );
@@ -185,6 +222,56 @@ namespace mongo {
         }
     }
 
+    void DBClientCursor::prefetchMore() {
+        if ( _prefetchConn || _prefetchPipelined || !cursorId || (opts & QueryOption_Exhaust) ) {
+            return;
+        }
+
+        if ( haveLimit && nToReturn <= batch.nReturned ) {
+            // Everything requested has been returned already
+            return;
+        }
+
+        const int savedNToReturn = nToReturn;
+
+        if ( _scopedHost.empty() ) {
+            // Only a plain connection can tell the reply apart from those to other requests
+            DBClientConnection* conn = dynamic_cast<DBClientConnection*>( _client );
+            if ( !conn || conn->type() != ConnectionString::MASTER ) {
+                return;
+            }
+
+            try {
+                Message toSend;
+                _assembleGetMore( toSend );
+                _prefetchRequestId = conn->sayPipelined( toSend );
+                _prefetchPipelined = true;
+            }
+            catch ( DBException& e ) {
+                LOG(1) << "failed to prefetch more results of cursor " << cursorId << " from "
+                       << conn->toString() << causedBy( e ) << endl;
+                nToReturn = savedNToReturn;
+            }
+            return;
+        }
+
+        try {
+            auto_ptr<ScopedDbConnection> conn( new ScopedDbConnection( _scopedHost ) );
+
+            Message toSend;
+            _assembleGetMore( toSend );
+            (*conn)->say( toSend );
+
+            _prefetchConn = conn.release();
+        }
+        catch ( DBException& e ) {
+            // more() will request the batch the regular way and report any error
+            LOG(1) << "failed to prefetch more results of cursor " << cursorId << " from "
+                   << _scopedHost << causedBy( e ) << endl;
+            nToReturn = savedNToReturn;
+        }
+    }
+
     /** with QueryOption_Exhaust, the server just blasts data at us (marked at end with cursorid==0). */
     void DBClientCursor::exhaustReceiveMore() {
         verify( cursorId && batch.pos == batch.nReturned );
@@ -215,9 +302,10 @@ namespace mongo {
                 throw UserException( 13127 , "getMore: cursor didn't exist on server, possible restart or timeout?" );
         }
 
-        if ( cursorId == 0 || ! ( opts & QueryOption_CursorTailable ) ) {
+        if ( cursorId == 0 || ! ( opts & QueryOption_CursorTailable ) ||
+             ( opts & QueryOption_Exhaust ) ) {
             // only set initially: we don't want to kill it on end of data
-            // if it's a tailable cursor
+            // if it's a tailable cursor. An exhaust stream ends with a cursor id of 0 though.
             cursorId = qr.getCursorId();
         }
 
@@ -254,7 +342,10 @@ namespace mongo {
         if ( cursorId == 0 )
             return false;
 
-        requestMore();
+        if ( opts & QueryOption_Exhaust )
+            exhaustReceiveMore();
+        else
+            requestMore();
         return batch.pos < batch.nReturned;
     }
 
@@ -271,6 +362,12 @@ namespace mongo {
         batch.pos++;
         BSONObj o(batch.data);
         batch.data += o.objsize();
+
+        if ( _readAhead && !_readAheadTried && batch.pos * 2 >= batch.nReturned ) {
+            _readAheadTried = true;
+            prefetchMore();
+        }
+
         /* todo would be good to make data null at end of batch for safety */
         return o;
     }
@@ -332,6 +429,9 @@ namespace mongo {
 
     void DBClientCursor::attach( AScopedConnection * conn ) {
         verify( _scopedHost.size() == 0 );
+        massert( 28631,
+                 "can't attach a cursor whose next batch is being read ahead",
+                 !_prefetchPipelined );
         verify( conn );
         verify( conn->get() );
 
@@ -356,6 +456,18 @@ namespace mongo {
     DBClientCursor::~DBClientCursor() {
         DESTRUCTOR_GUARD (
 
+        if ( _prefetchConn ) {
+            // The reply to the outstanding request would be left on the socket
+            _prefetchConn->kill();
+            delete _prefetchConn;
+            _prefetchConn = NULL;
+        }
+
+        if ( _prefetchPipelined ) {
+            static_cast<DBClientConnection*>( _client )->discardPipelined( _prefetchRequestId );
+            _prefetchPipelined = false;
+        }
+
         if ( cursorId && _ownCursor && ! inShutdown() ) {
             BufBuilder b;
             b.appendNum( (int)0 ); // reserved
@@ -41,6 +41,7 @@
 namespace mongo {
 
     class AScopedConnection;
+    class ScopedDbConnection;
 
     /** for mock purposes only -- do not create variants of DBClientCursor, nor hang code here
         @see DBClientMockCursor
@@ -124,6 +125,9 @@ namespace mongo {
 
         bool tailable() const { return (opts & QueryOption_CursorTailable) != 0; }
 
+        /** true if the server streams the batches without waiting for getmores */
+        bool exhausting() const { return (opts & QueryOption_Exhaust) != 0; }
+
         /** see ResultFlagType (constants.h) for flag values
             mostly these flags are for internal purposes -
             ResultFlag_ErrSet is the possible exception to that
@@ -136,6 +140,24 @@ namespace mongo {
         /// Change batchSize after construction. Can change after requesting first batch.
         void setBatchSize(int newBatchSize) { batchSize = newBatchSize; }
 
+        /**
+         * Sends the request for the next batch without waiting for the reply, so that the server
+         * can produce it while the current batch is still being consumed. The next call to more()
+         * which needs the next batch receives it.
+         *
+         * Only has an effect on cursors which were attached to a connection pool with attach(),
+         * or which run on a DBClientConnection, where the request is pipelined, and which are
+         * neither dead nor exhaust cursors. Does nothing if a request is already outstanding.
+         */
+        void prefetchMore();
+
+        /**
+         * Read-ahead: once half of a batch has been consumed, the next one is requested with
+         * prefetchMore(), so it travels over the network while the rest of the batch is being
+         * processed. At most one batch is read ahead. Off by default.
+         */
+        void setReadAhead( bool readAhead = true ) { _readAhead = readAhead; }
+
         DBClientCursor( DBClientBase* client, const std::string &_ns, BSONObj _query, int _nToReturn,
                         int _nToSkip, const BSONObj *_fieldsToReturn, int queryOptions , int bs ) :
             _client(client),
@@ -241,10 +263,22 @@ namespace mongo {
         std::string _lazyHost;
         bool wasError;
 
+        // Connection on which the request sent by prefetchMore() is outstanding, if any. Owned.
+        ScopedDbConnection* _prefetchConn;
+
+        // Whether the request sent by prefetchMore() is pipelined on _client instead, and its id
+        bool _prefetchPipelined;
+        int _prefetchRequestId;
+
+        // See setReadAhead(). Whether the current batch was read ahead of already.
+        bool _readAhead;
+        bool _readAheadTried;
+
         void dataReceived() { bool retry; std::string lazyHost; dataReceived( retry, lazyHost ); }
         void dataReceived( bool& retry, std::string& lazyHost );
         void requestMore();
         void exhaustReceiveMore(); // for exhaust
+        void _assembleGetMore( Message& toSend );
 
         // Don't call from a virtual function
         void _assertIfNull() const { uassert(13348, "connection died", this); }
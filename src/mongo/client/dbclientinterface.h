@@ -378,6 +378,7 @@ namespace mongo {
         static const BSONField<BSONObj> ReadPrefField;
         static const BSONField<std::string> ReadPrefModeField;
         static const BSONField<BSONArray> ReadPrefTagsField;
+        static const BSONField<int> ReadPrefMaxStalenessField;
 
         BSONObj obj;
         Query() : obj(BSONObj()) { }
@@ -1239,7 +1240,7 @@ namespace mongo {
            Connect timeout is fixed, but short, at 5 seconds.
          */
         DBClientConnection(bool _autoReconnect=false, DBClientReplicaSet* cp=0, double so_timeout=0) :
-            clientSet(cp), _failed(false), autoReconnect(_autoReconnect), autoReconnectBackoff(1000, 2000), _so_timeout(so_timeout) {
+            clientSet(cp), _failed(false), autoReconnect(_autoReconnect), autoReconnectBackoff(1000, 2000), _so_timeout(so_timeout), _pipelinedInFlightBytes(0) {
             _numConnections.fetchAndAdd(1);
         }
 
@@ -1331,6 +1332,39 @@ namespace mongo {
 
         virtual bool lazySupported() const { return true; }
 
+        /**
+         * Pipelining: sends 'toSend' without waiting for its reply, so that several requests can
+         * be outstanding on the connection at once. The reply is collected with recvPipelined(),
+         * or dropped with discardPipelined(). Replies are matched to their request by responseTo,
+         * so they can be collected in any order.
+         *
+         * Past kMaxPipelinedRequests requests or kMaxPipelinedBytes of requests waiting for their
+         * reply, the oldest replies are received and kept before sending more, so that the
+         * server never blocks on sending replies nobody reads while we block on sending it more.
+         *
+         * @return the id of the request, for recvPipelined() and discardPipelined()
+         */
+        int sayPipelined( Message& toSend );
+
+        /**
+         * Waits for the reply to the pipelined request 'requestId'. Returns false, as call()
+         * does, if the connection failed.
+         */
+        bool recvPipelined( int requestId, Message& response );
+
+        /**
+         * Drops the reply to the pipelined request 'requestId', now or when it arrives.
+         */
+        void discardPipelined( int requestId );
+
+        /**
+         * Number of pipelined requests sent whose reply was not received yet.
+         */
+        size_t numPipelinedInFlight() const { return _pipelinedInFlight.size(); }
+
+        static const size_t kMaxPipelinedRequests = 128;
+        static const int kMaxPipelinedBytes = 1024 * 1024;
+
         static int getNumConnections() {
             return _numConnections.load();
         }
@@ -1375,6 +1409,22 @@ namespace mongo {
         double _so_timeout;
         bool _connect( std::string& errmsg );
 
+        // asks the server through isMaster to compress the messages on this connection
+        void _negotiateMessageCompression();
+
+        // Receives the next reply to a pipelined request. Returns false if the connection failed.
+        bool _recvNextPipelined();
+
+        // Pipelined requests waiting for their reply, to the size of the request
+        std::map<int, int> _pipelinedInFlight;
+        int _pipelinedInFlightBytes;
+
+        // Replies received ahead of being asked for
+        std::map<int, Message> _pipelinedReplies;
+
+        // Requests whose reply is dropped on arrival
+        std::set<int> _pipelinedDiscarded;
+
         static AtomicInt32 _numConnections;
         static bool _lazyKillCursor; // lazy means we piggy back kill cursors on next op
 
@@ -1383,6 +1433,40 @@ namespace mongo {
 #endif
     };
 
+    /**
+     * A query returning a single batch - a findOne() or a command, on the "<db>.$cmd" namespace -
+     * pipelined on a DBClientConnection: it is sent when constructed, and its result collected by
+     * join(). Many can be in flight on one connection, to pay one round trip for a whole lot of
+     * independent reads, and they can be joined in any order. One destroyed before being joined
+     * has its reply dropped.
+     *
+     * The connection must outlive the queries sent on it.
+     */
+    class MONGO_CLIENT_API PipelinedQuery : boost::noncopyable {
+    public:
+        PipelinedQuery( DBClientConnection* conn,
+                        const std::string& ns,
+                        const BSONObj& query,
+                        const BSONObj* fieldsToReturn = 0,
+                        int queryOptions = 0 );
+
+        ~PipelinedQuery();
+
+        /**
+         * Waits for the reply and returns the document it holds, or an empty object if none
+         * matched. Throws if the connection failed or the server returned an error.
+         */
+        BSONObj join();
+
+        bool isDone() const { return _done; }
+
+    private:
+        DBClientConnection* const _conn;
+        const int _requestId;
+        bool _done;
+        BSONObj _result;
+    };
+
     /** pings server to check if it's up
      */
     MONGO_CLIENT_API bool serverAlive( const std::string &uri );
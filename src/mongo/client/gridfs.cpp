@@ -34,7 +34,14 @@
 
 #include "mongo/client/gridfs.h"
 
+#include <algorithm>
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
 #include <fcntl.h>
 #include <fstream>
 #include <iostream>
@@ -44,6 +51,7 @@
 #include <io.h>
 #endif
 
+#include "mongo/client/connpool.h"
 #include "mongo/client/dbclientcursor.h"
 
 #ifndef MIN
@@ -55,6 +63,136 @@ namespace mongo {
 
     const unsigned DEFAULT_CHUNK_SIZE = 255 * 1024;
 
+namespace {
+
+    /**
+     * Inserts chunks over several pooled connections at once, one thread per connection. At most
+     * two chunks per connection wait in the queue, so reading the file never gets far ahead of
+     * storing it.
+     */
+    class ChunkUploader : boost::noncopyable {
+    public:
+        ChunkUploader( const string& host, const string& ns, unsigned connections )
+            : _host( host ),
+              _ns( ns ),
+              _maxQueued( connections * 2 ),
+              _closed( false ),
+              _joined( false ) {
+            for ( unsigned i = 0; i < connections; i++ ) {
+                _threads.create_thread( boost::bind( &ChunkUploader::_work, this ) );
+            }
+        }
+
+        ~ChunkUploader() {
+            DESTRUCTOR_GUARD( _close(); );
+        }
+
+        void add( const BSONObj& chunk ) {
+            boost::unique_lock<boost::mutex> lk( _mutex );
+            while ( _queue.size() >= _maxQueued && _error.empty() ) {
+                _changed.wait( lk );
+            }
+            _throwIfFailed_inlock();
+            _queue.push_back( chunk );
+            _changed.notify_all();
+        }
+
+        /**
+         * Waits for all the chunks to be stored, and throws if any couldn't be.
+         */
+        void finish() {
+            _close();
+            boost::unique_lock<boost::mutex> lk( _mutex );
+            _throwIfFailed_inlock();
+        }
+
+    private:
+        void _throwIfFailed_inlock() {
+            uassert( 28632, "Error storing GridFS chunk: " + _error, _error.empty() );
+        }
+
+        void _close() {
+            {
+                boost::unique_lock<boost::mutex> lk( _mutex );
+                if ( _joined ) {
+                    return;
+                }
+                _closed = true;
+                _changed.notify_all();
+            }
+            _threads.join_all();
+            _joined = true;
+        }
+
+        void _setError( const string& error ) {
+            boost::unique_lock<boost::mutex> lk( _mutex );
+            if ( _error.empty() ) {
+                _error = error;
+            }
+            _changed.notify_all();
+        }
+
+        void _work() {
+            try {
+                ScopedDbConnection conn( _host );
+                while ( true ) {
+                    BSONObj chunk;
+                    {
+                        boost::unique_lock<boost::mutex> lk( _mutex );
+                        while ( _queue.empty() && !_closed && _error.empty() ) {
+                            _changed.wait( lk );
+                        }
+                        if ( !_error.empty() || _queue.empty() ) {
+                            break;
+                        }
+                        chunk = _queue.front();
+                        _queue.pop_front();
+                        _changed.notify_all();
+                    }
+                    conn->insert( _ns, chunk );
+                }
+
+                // Wait for this connection's inserts to be applied
+                const string error = conn->getLastError();
+                conn.done();
+                if ( !error.empty() ) {
+                    _setError( error );
+                }
+            }
+            catch ( const DBException& e ) {
+                _setError( e.toString() );
+            }
+        }
+
+        const string _host;
+        const string _ns;
+        const size_t _maxQueued;
+
+        boost::thread_group _threads;
+
+        // Protects everything below
+        boost::mutex _mutex;
+        boost::condition_variable _changed;
+        std::deque<BSONObj> _queue;
+        bool _closed;
+        bool _joined;
+        string _error;
+    };
+
+    void insertChunk( DBClientBase& client,
+                      ChunkUploader* uploader,
+                      const string& ns,
+                      const BSONObj& chunk ) {
+        if ( uploader ) {
+            uploader->add( chunk );
+        }
+        else {
+            client.insert( ns, chunk );
+        }
+    }
+
+} // namespace
+
     GridFSChunk::GridFSChunk( BSONObj o ) {
         _data = o;
     }
@@ -72,6 +210,7 @@ namespace mongo {
         _filesNS = dbName + "." + prefix + ".files";
         _chunksNS = dbName + "." + prefix + ".chunks";
         _chunkSize = DEFAULT_CHUNK_SIZE;
+        _uploadConnections = 1;
 
         client.ensureIndex( _filesNS , BSON( "filename" << 1 ) );
         client.ensureIndex( _chunksNS , BSON( "files_id" << 1 << "n" << 1 ) , /*unique=*/true );
@@ -90,6 +229,11 @@ namespace mongo {
         return _chunkSize;
     }
 
+    void GridFS::setUploadConnections( unsigned int connections ) {
+        massert( 28634, "invalid number of upload connections", connections != 0 );
+        _uploadConnections = connections;
+    }
+
     BSONObj GridFS::storeFile( const char* data , size_t length , const string& remoteName , const string& contentType) {
         char const * const end = data + length;
 
@@ -97,16 +241,26 @@ namespace mongo {
         id.init();
         BSONObj idObj = BSON("_id" << id);
 
+        boost::scoped_ptr<ChunkUploader> uploader;
+        if ( _uploadConnections > 1 ) {
+            uploader.reset( new ChunkUploader( _client.getServerAddress(), _chunksNS,
+                                               _uploadConnections ) );
+        }
+
         int chunkNumber = 0;
         while (data < end) {
             int chunkLen = MIN(_chunkSize, (unsigned)(end-data));
             GridFSChunk c(idObj, chunkNumber, data, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
+            insertChunk( _client, uploader.get(), _chunksNS, c._data );
 
             chunkNumber++;
             data += chunkLen;
         }
 
+        if ( uploader ) {
+            uploader->finish();
+        }
+
         return insertFile(remoteName, id, length, contentType);
     }
 
@@ -125,6 +279,12 @@ namespace mongo {
         id.init();
         BSONObj idObj = BSON("_id" << id);
 
+        boost::scoped_ptr<ChunkUploader> uploader;
+        if ( _uploadConnections > 1 ) {
+            uploader.reset( new ChunkUploader( _client.getServerAddress(), _chunksNS,
+                                               _uploadConnections ) );
+        }
+
         int chunkNumber = 0;
         gridfs_offset length = 0;
         while (!feof(fd)) {
@@ -141,16 +301,20 @@ namespace mongo {
             }
 
             GridFSChunk c(idObj, chunkNumber, buf, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
+            delete[] buf;
+            insertChunk( _client, uploader.get(), _chunksNS, c._data );
 
             length += chunkLen;
             chunkNumber++;
-            delete[] buf;
         }
 
         if (fd != stdin)
             fclose( fd );
 
+        if ( uploader ) {
+            uploader->finish();
+        }
+
         return insertFile((remoteName.empty() ? fileName : remoteName), id, length, contentType);
     }
 
@@ -242,20 +406,69 @@ namespace mongo {
         return GridFSChunk(o);
     }
 
+    auto_ptr<DBClientCursor> GridFile::getChunks( int first, int last ) const {
+        _exists();
+        if ( last < 0 ) {
+            last = getNumChunks();
+        }
+
+        BSONObjBuilder b;
+        b.appendAs( _obj["_id"] , "files_id" );
+        b.append( "n" , BSON( "$gte" << first << "$lt" << last ) );
+
+        Query query( b.obj() );
+        query.sort( BSON( "n" << 1 ) ).hint( BSON( "files_id" << 1 << "n" << 1 ) );
+
+        auto_ptr<DBClientCursor> cursor = _grid->_client.query( _grid->_chunksNS , query );
+        uassert( 28633, "couldn't query the chunks of " + getFilename(), cursor.get() );
+        cursor->setReadAhead();
+        return cursor;
+    }
+
     gridfs_offset GridFile::write( ostream & out ) const {
+        return write( out, 0, getContentLength() );
+    }
+
+    gridfs_offset GridFile::write( ostream & out,
+                                   gridfs_offset offset,
+                                   gridfs_offset length ) const {
         _exists();
 
-        const int num = getNumChunks();
+        const gridfs_offset size = getContentLength();
+        if ( offset >= size || length == 0 ) {
+            return 0;
+        }
+        const gridfs_offset end = length > size - offset ? size : offset + length;
 
-        for ( int i=0; i<num; i++ ) {
-            GridFSChunk c = getChunk( i );
+        const gridfs_offset chunkSize = getChunkSize();
+        const int first = static_cast<int>( offset / chunkSize );
+        const int last = static_cast<int>( ( end + chunkSize - 1 ) / chunkSize );
+
+        auto_ptr<DBClientCursor> chunks = getChunks( first, last );
+
+        gridfs_offset written = 0;
+        for ( int i = first; i < last; i++ ) {
+            uassert( 10014 ,  "chunk is empty!" , chunks->more() );
+            BSONObj chunk = chunks->nextSafe();
+            uassert( 28635,
+                     str::stream() << "expected chunk " << i << " of " << getFilename()
+                                   << " but got " << chunk["n"],
+                     chunk["n"].numberInt() == i );
 
             int len;
-            const char * data = c.data( len );
-            out.write( data , len );
+            const char * data = chunk["data"].binDataClean( len );
+
+            // The part of [offset, end) in this chunk
+            const gridfs_offset chunkStart = i * chunkSize;
+            const gridfs_offset from = std::max( offset, chunkStart ) - chunkStart;
+            const gridfs_offset to = std::min( end, chunkStart + len ) - chunkStart;
+            if ( to > from ) {
+                out.write( data + from , to - from );
+                written += to - from;
+            }
         }
 
-        return getContentLength();
+        return written;
     }
 
     gridfs_offset GridFile::write( const string& where ) const {
@@ -83,6 +83,16 @@ namespace mongo {
 
         unsigned int getChunkSize() const;
 
+        /**
+         * Number of connections storeFile() inserts chunks over, in parallel. With more than one,
+         * the connections come from the global connection pool for the server of the client
+         * given to the constructor, so they must be able to write the chunks without logging in
+         * of their own. Defaults to 1, where chunks go over the client.
+         */
+        void setUploadConnections( unsigned int connections );
+
+        unsigned int getUploadConnections() const { return _uploadConnections; }
+
         /**
          * puts the file reference by fileName into the db
          * @param fileName local filename relative to process
@@ -139,6 +149,7 @@ namespace mongo {
         std::string _filesNS;
         std::string _chunksNS;
         unsigned int _chunkSize;
+        unsigned int _uploadConnections;
 
         // insert fileobject. All chunks must be in DB.
         BSONObj insertFile(const std::string& name, const OID& id, gridfs_offset length, const std::string& contentType);
@@ -195,11 +206,24 @@ namespace mongo {
 
         GridFSChunk getChunk( int n ) const;
 
+        /**
+         * Cursor over chunks [first, last) of the file, in order, reading the next batch of
+         * chunks ahead while the current one is consumed. 'last' of -1 means the end of the file.
+         */
+        std::auto_ptr<DBClientCursor> getChunks( int first = 0, int last = -1 ) const;
+
         /**
            write the file to the output stream
          */
         gridfs_offset write( std::ostream & out ) const;
 
+        /**
+         * Writes bytes [offset, offset + length) of the file, or up to its end, to the output
+         * stream. Only the chunks holding them are read.
+         * @return the number of bytes written
+         */
+        gridfs_offset write( std::ostream & out, gridfs_offset offset, gridfs_offset length ) const;
+
         /**
            write the file to this filename
          */
@@ -254,6 +254,35 @@ namespace mongo {
 
     // --------  ParallelSortClusteredCursor -----------
 
+    // Added to the results of a $near query, by each shard, to merge them in distance order.
+    static const char kGeoNearDistanceField[] = "$geoNearDistance";
+
+    /**
+     * Returns true if 'filter' has a $near, $nearSphere or $geoNear predicate. These can only be
+     * at the top level of a query or in a top level $and.
+     */
+    static bool hasGeoNear( const BSONObj& filter ) {
+        BSONForEach( e, filter ) {
+            if ( str::equals( e.fieldName(), "$and" ) && e.type() == Array ) {
+                BSONForEach( clause, e.embeddedObject() ) {
+                    if ( clause.type() == Object && hasGeoNear( clause.embeddedObject() ) ) {
+                        return true;
+                    }
+                }
+            }
+            else if ( e.type() == Object ) {
+                BSONForEach( op, e.embeddedObject() ) {
+                    if ( str::equals( op.fieldName(), "$near" ) ||
+                         str::equals( op.fieldName(), "$nearSphere" ) ||
+                         str::equals( op.fieldName(), "$geoNear" ) ) {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
     ParallelSortClusteredCursor::ParallelSortClusteredCursor( const QuerySpec& qSpec, const CommandInfo& cInfo )
         : _qSpec( qSpec ), _cInfo( cInfo ), _totalTries( 0 )
     {
@@ -289,6 +318,7 @@ namespace mongo {
         _numServers = _servers.size();
         _lastFrom = 0;
         _cursors = 0;
+        _mergeNeedsReplay = false;
 
         if( ! _qSpec.isEmpty() ){
             _needToSkip = _qSpec.ntoskip();
@@ -379,6 +409,18 @@ namespace mongo {
         uassert( 17306,
                  "have to have all text meta sort keys in projection",
                  textMetaSortKeyFields.empty() );
+
+        // Each shard returns the results of a $near query nearest first, so without a sort they
+        // are merged on the distance each shard adds to them.
+        if ( _sortKey.isEmpty() && ! _qSpec.isEmpty() && ! isCommand() &&
+             hasGeoNear( _qSpec.filter() ) ) {
+            BSONObjBuilder fields;
+            fields.appendElements( _fields );
+            fields.append( kGeoNearDistanceField,
+                           BSON( "$meta" << LiteParsedQuery::metaGeoNearDistance ) );
+            _geoNearMergeFields = fields.obj();
+            _sortKey = BSON( kGeoNearDistanceField << 1 );
+        }
     }
 
     void ParallelConnectionMetadata::cleanup( bool full ){
@@ -753,11 +795,14 @@ namespace mongo {
 
                         // Query limits split for multiple shards
 
+                        const BSONObj* fields = !_geoNearMergeFields.isEmpty() ?
+                            &_geoNearMergeFields :
+                            _qSpec.fields().isEmpty() ? 0 : _qSpec.fieldsData();
+
                         state->cursor.reset( new DBClientCursor( state->conn->get(), ns, _qSpec.query(),
                                                                  isCommand() ? 1 : 0, // nToReturn (0 if query indicates multi)
                                                                  0, // nToSkip
-                                                                 // Does this need to be a ptr?
-                                                                 _qSpec.fields().isEmpty() ? 0 : _qSpec.fieldsData(), // fieldsToReturn
+                                                                 fields, // fieldsToReturn
                                                                  _qSpec.options(), // options
                                                                  // NtoReturn is weird.
                                                                  // If zero, it means use default size, so we do that for all cursors
@@ -1497,54 +1542,110 @@ namespace mongo {
         return false;
     }
 
+    bool ParallelSortClusteredCursor::_mergeHasMore( int i ) {
+        if (_cursors[i].get() && _cursors[i].get()->more()) {
+            return true;
+        }
+
+        if (_cursors[i].getMData())
+            _cursors[i].getMData()->pcState->done = true;
+        return false;
+    }
+
+    bool ParallelSortClusteredCursor::_mergeBefore( int a, int b ) {
+        if (!_mergeHasMore(a)) {
+            return false;
+        }
+        if (!_mergeHasMore(b)) {
+            return true;
+        }
+
+        const int comp = _cursors[a].get()->peekFirst().woSortOrder(
+                                                _cursors[b].get()->peekFirst(), _sortKey, true);
+        if (comp != 0) {
+            return comp < 0;
+        }
+
+        // Keep the order stable for equal results
+        return a < b;
+    }
+
+    int ParallelSortClusteredCursor::_mergeBuild( int node ) {
+        if (node >= _numServers) {
+            return node - _numServers;
+        }
+
+        const int left = _mergeBuild(2 * node);
+        const int right = _mergeBuild(2 * node + 1);
+        if (_mergeBefore(left, right)) {
+            _mergeTree[node] = right;
+            return left;
+        }
+
+        _mergeTree[node] = left;
+        return right;
+    }
+
     BSONObj ParallelSortClusteredCursor::next() {
-        BSONObj best = BSONObj();
         int bestFrom = -1;
 
-        for( int j = 0; j < _numServers; j++ ){
+        if (_sortKey.isEmpty()) {
+            for( int j = 0; j < _numServers; j++ ){
 
-            // Iterate _numServers times, starting one past the last server we used.
-            // This means we actually start at server #1, not #0, but shouldn't matter
+                // Iterate _numServers times, starting one past the last server we used.
+                // This means we actually start at server #1, not #0, but shouldn't matter
 
-            int i = ( j + _lastFrom + 1 ) % _numServers;
+                int i = ( j + _lastFrom + 1 ) % _numServers;
 
-            // Check to see if the cursor is finished
-            if (!_cursors[i].get() || !_cursors[i].get()->more()) {
-                if (_cursors[i].getMData())
-                    _cursors[i].getMData()->pcState->done = true;
-                continue;
+                // Check to see if the cursor is finished
+                if (_mergeHasMore(i)) {
+                    bestFrom = i;
+                    break;
+                }
             }
-
-            // We know we have at least one result in this cursor
-            BSONObj me = _cursors[i].get()->peekFirst();
-
-            // If this is the first non-empty cursor, save the result as best
-            if (bestFrom < 0) {
-                best = me;
-                bestFrom = i;
-                if( _sortKey.isEmpty() ) break;
-                continue;
+        }
+        else if (_numServers > 0) {
+            // A loser tree takes log(_numServers) comparisons per result, rather than comparing
+            // the next results of all servers.
+            if (_mergeTree.empty()) {
+                _mergeTree.resize(_numServers);
+                _mergeTree[0] = _mergeBuild(1);
             }
+            else if (_mergeNeedsReplay) {
+                int winner = _mergeTree[0];
+                for (int node = (winner + _numServers) / 2; node > 0; node /= 2) {
+                    if (_mergeBefore(_mergeTree[node], winner)) {
+                        std::swap(_mergeTree[node], winner);
+                    }
+                }
+                _mergeTree[0] = winner;
+            }
+            _mergeNeedsReplay = false;
 
-            // Otherwise compare the result to the current best result
-            int comp = best.woSortOrder( me , _sortKey , true );
-            if ( comp < 0 )
-                continue;
-
-            best = me;
-            bestFrom = i;
+            if (_mergeHasMore(_mergeTree[0])) {
+                bestFrom = _mergeTree[0];
+            }
         }
 
         _lastFrom = bestFrom;
 
         uassert(10019, "no more elements", bestFrom >= 0);
-        _cursors[bestFrom].get()->next();
+        DBClientCursor* cursor = _cursors[bestFrom].get();
+        BSONObj best = cursor->peekFirst();
+        cursor->next();
+        _mergeNeedsReplay = true;
 
         // Make sure the result data won't go away after the next call to more()
-        if (!_cursors[bestFrom].get()->moreInCurrentBatch()) {
+        if (!_geoNearMergeFields.isEmpty() && best.hasField(kGeoNearDistanceField)) {
+            best = best.removeField(kGeoNearDistanceField);
+        }
+        else if (!cursor->moreInCurrentBatch()) {
             best = best.getOwned();
         }
 
+        // Have the shard produce its next batch while this one is being merged
+        cursor->prefetchMore();
+
         if (_cursors[bestFrom].getMData())
             _cursors[bestFrom].getMData()->pcState->count++;
 
@@ -276,6 +276,35 @@ namespace mongo {
         DBClientCursorHolder * _cursors;
         int _needToSkip;
 
+        /**
+         * Returns whether the cursor of server 'i' has any results left. Marks it as done if not.
+         */
+        bool _mergeHasMore( int i );
+
+        /**
+         * Returns whether the next result of server 'a' sorts before the next result of server
+         * 'b'. Servers with no results left sort last.
+         */
+        bool _mergeBefore( int a, int b );
+
+        /**
+         * Plays the matches of the subtree under 'node' of the loser tree and returns the winner.
+         */
+        int _mergeBuild( int node );
+
+        // Loser tree for merging the sorted results of the servers. Node 0 holds the server with
+        // the next result, the internal nodes 1 to _numServers - 1 hold the losers of their
+        // matches and leaf _numServers + i stands for server i. Built on the first call to next().
+        std::vector<int> _mergeTree;
+
+        // Set when the winner of the loser tree has been advanced, so its matches need to be
+        // replayed. This happens lazily, like the fetch of the next batch it may need.
+        bool _mergeNeedsReplay;
+
+        // For a $near query without a sort, the projection sent when more than one shard is
+        // queried: it adds each result's distance, which the merge orders on and next() removes.
+        BSONObj _geoNearMergeFields;
+
         /**
          * Setups the shard version of the connection. When using a replica
          * set connection and the primary cannot be reached, the version
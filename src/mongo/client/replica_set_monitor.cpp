@@ -39,6 +39,7 @@
 #include "mongo/db/server_options.h"
 #include "mongo/client/connpool.h"
 #include "mongo/client/replica_set_monitor_internal.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/concurrency/mutex.h" // for StaticObserver
 #include "mongo/util/background.h"
 #include "mongo/util/exit.h"
@@ -83,6 +84,8 @@ namespace {
      *          setsLock                 -- mutex protecting _seedServers and _sets, destroyed last
      *          seedServers              -- list (map) of servers
      *          sets                     -- list (map) of ReplicaSetMonitors
+     *          refreshThreadsMutex      -- mutex protecting refreshThreads
+     *          refreshThreads           -- count of background refresh and isMaster threads
      *          replicaSetMonitorWatcher -- background job to check Replica Set members
      *          staticObserver           -- sentinel to detect process termination
      *
@@ -98,6 +101,94 @@ namespace {
     StringMap<set<HostAndPort> > seedServers;
     StringMap<ReplicaSetMonitorPtr> sets;
 
+    boost::mutex refreshThreadsMutex;
+    boost::condition_variable refreshThreadsDone; // notified when refreshThreads drops to 0
+    int refreshThreads = 0;
+
+    void runRefreshThread(const stdx::function<void()>& work) {
+        try {
+            work();
+        }
+        catch (const std::exception& e) {
+            error() << "background replica set refresh failed: " << e.what();
+        }
+
+        boost::mutex::scoped_lock lk(refreshThreadsMutex);
+        if (--refreshThreads == 0)
+            refreshThreadsDone.notify_all();
+    }
+
+    /**
+     * Runs work on a new detached thread, which ReplicaSetMonitor::cleanup() waits for.
+     * Throws if the thread can't be started.
+     *
+     * refreshThreadsMutex is never held while taking any other lock, so this is safe to call
+     * while holding a SetState::mutex.
+     */
+    void startRefreshThread(const stdx::function<void()>& work) {
+        {
+            boost::mutex::scoped_lock lk(refreshThreadsMutex);
+            refreshThreads++;
+        }
+
+        try {
+            boost::thread thread(runRefreshThread, work);
+            thread.detach();
+        }
+        catch (...) {
+            boost::mutex::scoped_lock lk(refreshThreadsMutex);
+            if (--refreshThreads == 0)
+                refreshThreadsDone.notify_all();
+            throw;
+        }
+    }
+
+    /**
+     * Calls isMaster on host, returning an empty reply if it couldn't be reached.
+     */
+    BSONObj callIsMaster(const HostAndPort& host, int64_t* pingMicros) {
+        BSONObj reply; // empty on error
+        try {
+            ScopedDbConnection conn(ConnectionString(host), socketTimeoutSecs);
+            bool ignoredOutParam = false;
+            Timer timer;
+            conn->isMaster(ignoredOutParam, &reply);
+            *pingMicros = timer.micros();
+            conn.done(); // return to pool on success.
+        }
+        catch (...) {
+            reply = BSONObj(); // should be a no-op but want to be sure
+        }
+        return reply;
+    }
+
+    /**
+     * Refreshes set with concurrent isMaster calls. If that only joined a scan which was already
+     * in progress, and so may have contacted hosts before this refresh was wanted, refreshes again.
+     */
+    void refreshInBackground(const SetStatePtr& set) {
+        try {
+            bool startedNewScan = false;
+            while (!startedNewScan) {
+                boost::mutex::scoped_lock lk(set->mutex);
+                ReplicaSetMonitor::Refresher refresher(set);
+                startedNewScan = refresher.startedNewScan();
+                lk.unlock();
+
+                refresher.refreshAllConcurrently();
+            }
+        }
+        catch (const std::exception& e) {
+            warning() << "background refresh of replica set " << set->name << " failed: "
+                      << e.what();
+        }
+
+        boost::mutex::scoped_lock lk(set->mutex);
+        set->refreshingInBackground = false;
+        set->backgroundRefreshes++;
+        set->cv.notify_all();
+    }
+
     // global background job responsible for checking every X amount of time
     class ReplicaSetMonitorWatcher : public BackgroundJob {
     public:
@@ -194,7 +285,7 @@ namespace {
                 LOG(1) << "checking replica set: " << it->first;
                 ReplicaSetMonitorPtr m = it->second;
 
-                m->startOrContinueRefresh().refreshAll();
+                m->startOrContinueRefresh().refreshAllConcurrently();
 
                 const int numFails = m->getConsecutiveFailedScans();
                 if (numFails >= ReplicaSetMonitor::maxConsecutiveFailedChecks) {
@@ -278,25 +369,28 @@ namespace {
     }
 
     HostAndPort ReplicaSetMonitor::getHostOrRefresh(const ReadPreferenceSetting& criteria) {
-        {
-            boost::mutex::scoped_lock lk(_state->mutex);
-            HostAndPort out = _state->getMatchingHost(criteria);
+        boost::mutex::scoped_lock lk(_state->mutex);
+        HostAndPort out = _state->getMatchingHost(criteria);
+        if (!out.empty())
+            return out;
+
+        // Rather than contacting hosts from this thread, wait for the background refresh shared
+        // by every thread looking for a host in this set. If one is already running it may have
+        // contacted hosts before we got here, so in that case also wait for the one after it
+        // before giving up.
+        const int64_t lastRefresh = _state->backgroundRefreshes +
+                                    (_state->refreshingInBackground ? 2 : 1);
+        while (true) {
+            _startBackgroundRefresh_inlock();
+            _state->cv.wait(lk);
+
+            out = _state->getMatchingHost(criteria);
             if (!out.empty())
                 return out;
-        }
 
-        {
-            Refresher refresher = startOrContinueRefresh();
-            HostAndPort out = refresher.refreshUntilMatches(criteria);
-            if (!out.empty() || refresher.startedNewScan())
-                return out;
+            if (_state->backgroundRefreshes >= lastRefresh)
+                return HostAndPort();
         }
-
-        // We didn't find any matching hosts and the scan we just finished may have stale data from
-        // before we joined. Therefore we should participate in a new scan to make sure all hosts
-        // are contacted at least once (possibly by other threads) before this function gives up.
-
-        return startOrContinueRefresh().refreshUntilMatches(criteria);
     }
 
     HostAndPort ReplicaSetMonitor::getMasterOrUassert() {
@@ -315,6 +409,19 @@ namespace {
         return out;
     }
 
+    void ReplicaSetMonitor::startBackgroundRefresh() {
+        boost::mutex::scoped_lock lk(_state->mutex);
+        _startBackgroundRefresh_inlock();
+    }
+
+    void ReplicaSetMonitor::_startBackgroundRefresh_inlock() {
+        if (_state->refreshingInBackground)
+            return;
+
+        startRefreshThread(stdx::bind(refreshInBackground, _state));
+        _state->refreshingInBackground = true;
+    }
+
     void ReplicaSetMonitor::failedHost(const HostAndPort& host) {
         boost::mutex::scoped_lock lk(_state->mutex);
         Node* node = _state->findNode(host);
@@ -323,6 +430,20 @@ namespace {
         DEV _state->checkInvariants();
     }
 
+    void ReplicaSetMonitor::noteRequestStarted(const HostAndPort& host) {
+        boost::mutex::scoped_lock lk(_state->mutex);
+        Node* node = _state->findNode(host);
+        if (node)
+            node->inFlightRequests++;
+    }
+
+    void ReplicaSetMonitor::noteRequestFinished(const HostAndPort& host) {
+        boost::mutex::scoped_lock lk(_state->mutex);
+        Node* node = _state->findNode(host);
+        if (node && node->inFlightRequests > 0)
+            node->inFlightRequests--;
+    }
+
     bool ReplicaSetMonitor::isPrimary(const HostAndPort& host) const {
         boost::mutex::scoped_lock lk(_state->mutex);
         Node* node = _state->findNode(host);
@@ -469,6 +590,11 @@ namespace {
         replicaSetMonitorWatcher.cancel();
         replicaSetMonitorWatcher.stop();
         replicaSetMonitorWatcher.wait();
+        {
+            boost::mutex::scoped_lock lk(refreshThreadsMutex);
+            while (refreshThreads > 0)
+                refreshThreadsDone.wait(lk);
+        }
         scoped_lock lock(setsLock);
         sets = StringMap<ReplicaSetMonitorPtr>();
         seedServers = StringMap<set<HostAndPort> >();
@@ -762,22 +888,11 @@ namespace {
                 continue;
 
             case NextStep::CONTACT_HOST: {
-                BSONObj reply; // empty on error
                 int64_t pingMicros = 0;
 
                 DEV _set->checkInvariants();
                 lk.unlock(); // relocked after attempting to call isMaster
-                try {
-                    ScopedDbConnection conn(ConnectionString(ns.host), socketTimeoutSecs);
-                    bool ignoredOutParam = false;
-                    Timer timer;
-                    conn->isMaster(ignoredOutParam, &reply);
-                    pingMicros = timer.micros();
-                    conn.done(); // return to pool on success.
-                }
-                catch (...) {
-                    reply = BSONObj(); // should be a no-op but want to be sure
-                }
+                const BSONObj reply = callIsMaster(ns.host, &pingMicros);
                 lk.lock();
 
                 // Ignore the reply and return if we are no longer the current scan. This might
@@ -794,6 +909,49 @@ namespace {
         }
     }
 
+    void Refresher::refreshAllConcurrently() {
+        boost::mutex::scoped_lock lk(_set->mutex);
+        while (true) {
+            const NextStep ns = getNextStep();
+            switch(ns.step) {
+            case NextStep::DONE:
+                DEV _set->checkInvariants();
+                return;
+
+            case NextStep::WAIT:
+                DEV _set->checkInvariants();
+                _set->cv.wait(lk);
+                continue;
+
+            case NextStep::CONTACT_HOST:
+                try {
+                    startRefreshThread(stdx::bind(&Refresher::_contactHost, *this, ns.host));
+                }
+                catch (const std::exception& e) {
+                    warning() << "couldn't start a thread to call isMaster on " << ns.host
+                              << ": " << e.what();
+                    failedHost(ns.host);
+                }
+            }
+        }
+    }
+
+    void Refresher::_contactHost(Refresher refresher, const HostAndPort& host) {
+        int64_t pingMicros = 0;
+        const BSONObj reply = callIsMaster(host, &pingMicros);
+
+        boost::mutex::scoped_lock lk(refresher._set->mutex);
+
+        // Ignore the reply if we are no longer the current scan.
+        if (refresher._scan != refresher._set->currentScan)
+            return;
+
+        if (reply.isEmpty())
+            refresher.failedHost(host);
+        else
+            refresher.receivedIsMaster(host, pingMicros, reply);
+    }
+
     void IsMasterReply::parse(const BSONObj& obj) {
         try {
             raw = obj.getOwned(); // don't use obj again after this line
@@ -822,6 +980,9 @@ namespace {
             }
 
             tags = raw.getObjectField("tags");
+
+            const BSONElement lastWriteElem = raw["lastWrite"];
+            lastWrite = lastWriteElem.type() == Timestamp ? lastWriteElem._opTime() : OpTime();
         } catch (const std::exception& e) {
             ok = false;
             log() << "exception while parsing isMaster reply: " << e.what() << " " << obj;
@@ -870,6 +1031,8 @@ namespace {
         if (!tags.binaryEqual(reply.tags))
             tags = reply.tags.getOwned();
 
+        lastWrite = reply.lastWrite;
+
         if (reply.latencyMicros >= 0) { // TODO upper bound?
             if (latencyMicros == unknownLatency) {
                 latencyMicros = reply.latencyMicros;
@@ -887,6 +1050,8 @@ namespace {
         : name(name.toString())
         , consecutiveFailedScans(0)
         , seedNodes(seedNodes)
+        , refreshingInBackground(false)
+        , backgroundRefreshes(0)
         , latencyThresholdMicros(serverGlobalParams.defaultLocalThresholdMillis * 1000)
         , rand(int64_t(time(0)))
         , roundRobin(0)
@@ -950,7 +1115,8 @@ namespace {
 
                 std::vector<const Node*> matchingNodes;
                 for (size_t i = 0; i < nodes.size(); i++ ) {
-                    if (nodes[i].matches(criteria.pref) && nodes[i].matches(tag)) {
+                    if (nodes[i].matches(criteria.pref) && nodes[i].matches(tag) &&
+                            !isTooStale(nodes[i], criteria.maxStalenessSeconds)) {
                         matchingNodes.push_back(&nodes[i]);
                     }
                 }
@@ -977,9 +1143,19 @@ namespace {
                     // only in tests
                     return matchingNodes[roundRobin++ % matchingNodes.size()]->host;
                 }
+                else if (matchingNodes.size() == 1) {
+                    return matchingNodes.front()->host;
+                }
                 else {
-                    // normal case
-                    return matchingNodes[rand.nextInt32(matchingNodes.size())]->host;
+                    // normal case: of two random nodes, take the less loaded one
+                    const size_t first = rand.nextInt32(matchingNodes.size());
+                    size_t second = rand.nextInt32(matchingNodes.size() - 1);
+                    if (second >= first)
+                        second++;
+                    const Node* node = matchingNodes[first];
+                    if (matchingNodes[second]->inFlightRequests < node->inFlightRequests)
+                        node = matchingNodes[second];
+                    return node->host;
                 };
             }
 
@@ -991,6 +1167,30 @@ namespace {
         }
     }
 
+    bool SetState::isTooStale(const Node& node, int maxStalenessSeconds) const {
+        if (maxStalenessSeconds <= 0 || node.isMaster)
+            return false;
+
+        OpTime freshest;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (!nodes[i].isUp)
+                continue;
+            if (nodes[i].isMaster) {
+                freshest = nodes[i].lastWrite;
+                break;
+            }
+            if (nodes[i].lastWrite > freshest)
+                freshest = nodes[i].lastWrite;
+        }
+
+        if (freshest.isNull())
+            return false; // no node reports its last write
+        if (node.lastWrite.isNull())
+            return true;
+        return int64_t(freshest.getSecs()) - int64_t(node.lastWrite.getSecs())
+            > maxStalenessSeconds;
+    }
+
     Node* SetState::findNode(const HostAndPort& host) {
         const Nodes::iterator it = std::lower_bound(nodes.begin(), nodes.end(), host, compareHosts);
         if (it == nodes.end() || it->host != host)
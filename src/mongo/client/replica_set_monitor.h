@@ -67,9 +67,9 @@ namespace mongo {
         /**
          * Returns a host matching criteria or an empty HostAndPort if no host matches.
          *
-         * If no host matches initially, will then attempt to refresh our view of the set by
-         * contacting other hosts. May still return no result if no host matches following a
-         * refresh.
+         * If no host matches initially, will then wait for a background refresh of our view of
+         * the set, starting one if none is running. All callers waiting on the same set share one
+         * refresh. May still return no result if no host matches following a refresh.
          */
         HostAndPort getHostOrRefresh(const ReadPreferenceSetting& criteria);
 
@@ -89,6 +89,12 @@ namespace mongo {
          */
         Refresher startOrContinueRefresh();
 
+        /**
+         * Starts refreshing our view of the set on a background thread and returns without
+         * waiting, unless a background refresh of this set is already running.
+         */
+        void startBackgroundRefresh();
+
         /**
          * Notifies this Monitor that a host has failed and should be considered down.
          *
@@ -97,6 +103,14 @@ namespace mongo {
          */
         void failedHost(const HostAndPort& host);
 
+        /**
+         * Notifies this Monitor that a request was sent to, or a reply received from, a host that
+         * was returned by getHostOrRefresh.  Among otherwise equally good hosts, those with fewer
+         * requests in flight are preferred.
+         */
+        void noteRequestStarted(const HostAndPort& host);
+        void noteRequestFinished(const HostAndPort& host);
+
         /**
          * Returns true if this node is the master based ONLY on local data. Be careful, return may
          * be stale.
@@ -175,6 +189,8 @@ namespace mongo {
          * Permanently stops all monitoring on replica sets and clears all cached information
          * as well. As a consequence, NEVER call this if you have other threads that have a
          * DBClientReplicaSet instance.
+         *
+         * Waits for background refreshes and the isMaster calls they made to finish.
          */
         static void cleanup();
 
@@ -214,6 +230,11 @@ namespace mongo {
         static bool useDeterministicHostSelection;
 
     private:
+        /**
+         * Requires _state->mutex.
+         */
+        void _startBackgroundRefresh_inlock();
+
         const SetStatePtr _state; // never NULL
     };
 
@@ -248,6 +269,12 @@ namespace mongo {
          */
         void refreshAll() { _refreshUntilMatches(NULL); }
 
+        /**
+         * Refresh all hosts, calling isMaster on every host the scan can try at once, each from
+         * its own thread, rather than one host at a time. Returns once the scan is done.
+         */
+        void refreshAllConcurrently();
+
         //
         // Remaining methods are only for testing and internal use.
         // Callers are responsible for holding SetState::mutex before calling any of these methods.
@@ -327,6 +354,12 @@ namespace mongo {
          */
         HostAndPort _refreshUntilMatches(const ReadPreferenceSetting* criteria);
 
+        /**
+         * Calls isMaster on host, then reports the result to the scan refresher belongs to.
+         * Runs on its own thread for refreshAllConcurrently. Handles own locking.
+         */
+        static void _contactHost(Refresher refresher, const HostAndPort& host);
+
         // Both pointers are never NULL
         SetStatePtr _set;
         ScanStatePtr _scan; // May differ from _set->currentScan if a new scan has started.
@@ -39,6 +39,7 @@
 #include <set>
 
 #include "mongo/base/disallow_copying.h"
+#include "mongo/bson/optime.h"
 #include "mongo/client/dbclient_rs.h" // for TagSet and ReadPreferenceSettings
 #include "mongo/client/replica_set_monitor.h"
 #include "mongo/db/jsobj.h"
@@ -70,6 +71,7 @@ namespace mongo {
         HostAndPort primary; // empty if not present
         std::set<HostAndPort> normalHosts; // both "hosts" and "passives"
         BSONObj tags;
+        OpTime lastWrite; // null if not present
 
         // remaining fields aren't in isMaster reply, but are known to caller.
         HostAndPort host;
@@ -84,7 +86,8 @@ namespace mongo {
         struct Node {
             explicit Node(const HostAndPort& host)
                     : host(host)
-                    , latencyMicros(unknownLatency) {
+                    , latencyMicros(unknownLatency)
+                    , inFlightRequests(0) {
                 markFailed();
             }
 
@@ -123,6 +126,8 @@ namespace mongo {
             bool isMaster; // implies isUp
             int64_t latencyMicros; // unknownLatency if unknown
             BSONObj tags; // owned
+            OpTime lastWrite; // null if unknown
+            int inFlightRequests; // sent through ReplicaSetMonitor::noteRequestStarted
         };
         typedef std::vector<Node> Nodes;
 
@@ -138,6 +143,14 @@ namespace mongo {
          */
         HostAndPort getMatchingHost(const ReadPreferenceSetting& criteria) const;
 
+        /**
+         * Returns true if we know that the secondary 'node' is more than maxStalenessSeconds
+         * behind the primary, or the freshest node if there is no primary, as of their last
+         * isMaster replies. Nodes that don't report their last write are never known to be
+         * fresh enough, unless no node reports one.
+         */
+        bool isTooStale(const Node& node, int maxStalenessSeconds) const;
+
         /**
          * Returns the Node with the given host, or NULL if no Node has that host.
          */
@@ -177,6 +190,8 @@ namespace mongo {
         HostAndPort lastSeenMaster; // empty if we have never seen a master. can be same as current
         Nodes nodes; // maintained sorted and unique by host
         ScanStatePtr currentScan; // NULL if no scan in progress
+        bool refreshingInBackground; // set while startBackgroundRefresh's thread runs
+        int64_t backgroundRefreshes; // completed by startBackgroundRefresh's thread
         int64_t latencyThresholdMicros;
         mutable PseudoRandom rand; // only used for host selection to balance load
         mutable int roundRobin; // used when useDeterministicHostSelection is true
@@ -783,3 +783,45 @@ TEST(ReplicaSetMonitorTests, OutOfBandFailedHost) {
         }
     }
 }
+
+// Secondaries further behind the primary than maxStalenessSeconds are not selected
+TEST(ReplicaSetMonitorTests, MaxStalenessExcludesLaggingSecondaries) {
+    SetStatePtr state = boost::make_shared<SetState>("name", basicSeedsSet);
+    Refresher refresher(state);
+
+    for (size_t i = 0; i != basicSeeds.size(); ++i) {
+        NextStep ns = refresher.getNextStep();
+        ASSERT_EQUALS(ns.step, NextStep::CONTACT_HOST);
+    }
+
+    // a is primary, b is 5 seconds behind it and c is 60 seconds behind it
+    const unsigned lastWriteSecs[] = {100, 95, 40};
+    for (size_t i = 0; i != basicSeeds.size(); ++i) {
+        bool primary = (i == 0);
+
+        refresher.receivedIsMaster(basicSeeds[i], -1, BSON(
+                "setName" << "name"
+             << "ismaster" << primary
+             << "secondary" << !primary
+             << "hosts" << BSON_ARRAY("a" << "b" << "c")
+             << "lastWrite" << OpTime(lastWriteSecs[i], 0)
+             << "ok" << true
+             ));
+    }
+
+    NextStep ns = refresher.getNextStep();
+    ASSERT_EQUALS(ns.step, NextStep::DONE);
+
+    const ReadPreferenceSetting fresh(ReadPreference_SecondaryOnly, TagSet(), 10);
+    const ReadPreferenceSetting anyAge(ReadPreference_SecondaryOnly, TagSet());
+    bool sawStale = false;
+    for (int i = 0; i < 20; i++) {
+        ASSERT_EQUALS(state->getMatchingHost(fresh), HostAndPort("b"));
+        sawStale = sawStale || state->getMatchingHost(anyAge) == HostAndPort("c");
+    }
+    ASSERT(sawStale);
+
+    // No secondary is fresh enough, so secondaryPreferred falls back to the primary
+    const ReadPreferenceSetting veryFresh(ReadPreference_SecondaryPreferred, TagSet(), 1);
+    ASSERT_EQUALS(state->getMatchingHost(veryFresh), HostAndPort("a"));
+}
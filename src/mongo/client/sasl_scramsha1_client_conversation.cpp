@@ -176,7 +176,7 @@ namespace mongo {
             return StatusWith<bool>(ex.toStatus());
         }
 
-        scram::generateSaltedPassword(
+        scram::generateSaltedPasswordCached(
                             _saslClientSession->getParameter(SaslClientSession::parameterPassword),
                             reinterpret_cast<const unsigned char*>(decodedSalt.c_str()),
                             decodedSalt.size(),
@@ -242,6 +242,8 @@ namespace mongo_test {
             delete _dummyServer;
 
             mongo::pool.setMaxPoolSize(_maxPoolSizePerHost);
+            mongo::pool.setMinPoolSize(0);
+            mongo::pool.setIdleTimeout(mongo::PoolForHost::kNoIdleTimeout);
         }
 
     protected:
@@ -426,4 +428,44 @@ namespace mongo_test {
 
         conn1Again.done();
     }
+
+    TEST_F(DummyServerFixture, CheckOutMostRecentlyReturned) {
+        ScopedDbConnection conn1(TARGET_HOST);
+        ScopedDbConnection conn2(TARGET_HOST);
+
+        DBClientBase* conn2Ptr = conn2.get();
+        conn1.done();
+        conn2.done();
+
+        ScopedDbConnection conn3(TARGET_HOST);
+        ASSERT_EQUALS(conn2Ptr, conn3.get());
+        conn3.done();
+    }
+
+    TEST_F(DummyServerFixture, CloseIdleConnsDownToMinPoolSize) {
+        mongo::pool.setMinPoolSize(1);
+        mongo::pool.setIdleTimeout(0);
+
+        ScopedDbConnection conn1(TARGET_HOST);
+        ScopedDbConnection conn2(TARGET_HOST);
+        ScopedDbConnection conn3(TARGET_HOST);
+
+        DBClientBase* conn3Ptr = conn3.get();
+        conn1.done();
+        conn2.done();
+        conn3.done();
+
+        mongo::pool.taskDoWork();
+
+        mongo::BSONObjBuilder b;
+        mongo::pool.appendInfo(b);
+        const mongo::BSONObj info = b.obj();
+        ASSERT_EQUALS(1, info["totalAvailable"].numberInt());
+        ASSERT_EQUALS(2, info["totalIdleClosed"].numberLong());
+
+        // The most recently used connection is the one kept
+        ScopedDbConnection conn4(TARGET_HOST);
+        ASSERT_EQUALS(conn3Ptr, conn4.get());
+        conn4.done();
+    }
 }
@@ -31,17 +31,109 @@
 #include "mongo/crypto/mechanism_scram.h"
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <map>
 #include <vector>
 
 #include "mongo/crypto/crypto.h"
 #include "mongo/platform/random.h"
 #include "mongo/util/base64.h"
+#include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 namespace scram {
 
     using boost::scoped_ptr;
 
+namespace {
+
+    const size_t maxCachedDerivations = 1000;
+
+    /**
+     * A bounded, process-wide map from the inputs of a SCRAM key derivation to its result, so
+     * repeated authentications with the same credentials only pay for the derivation once.
+     * Keys contain a digest of the password rather than the password itself.
+     */
+    template <typename Value>
+    class DerivationCache {
+    public:
+        bool get(const std::string& key, Value* value) {
+            boost::mutex::scoped_lock lk(_mutex);
+            typename std::map<std::string, Value>::const_iterator it = _entries.find(key);
+            if (it == _entries.end()) {
+                return false;
+            }
+            *value = it->second;
+            return true;
+        }
+
+        void put(const std::string& key, const Value& value) {
+            boost::mutex::scoped_lock lk(_mutex);
+            if (_entries.size() >= maxCachedDerivations) {
+                _entries.clear();
+            }
+            _entries[key] = value;
+        }
+
+    private:
+        boost::mutex _mutex;
+        std::map<std::string, Value> _entries;
+    };
+
+    struct SaltedPassword {
+        unsigned char bytes[hashSize];
+    };
+
+    DerivationCache<SaltedPassword> saltedPasswordCache;
+    DerivationCache<BSONObj> credentialsCache;
+
+    std::string makeCacheKey(const StringData& hashedPassword,
+                             const unsigned char* salt,
+                             size_t saltLen,
+                             int iterationCount) {
+        unsigned char passwordDigest[hashSize];
+        fassert(28636, crypto::sha1(reinterpret_cast<const unsigned char*>(
+                                            hashedPassword.rawData()),
+                                    hashedPassword.size(),
+                                    passwordDigest));
+
+        return mongoutils::str::stream()
+            << std::string(reinterpret_cast<const char*>(passwordDigest), hashSize)
+            << std::string(reinterpret_cast<const char*>(salt), saltLen)
+            << ':' << iterationCount;
+    }
+
+    // Computes storedKey and serverKey from saltedPassword as defined in RFC5802
+    void generateSecretsFromSaltedPassword(const unsigned char saltedPassword[hashSize],
+                                           unsigned char storedKey[hashSize],
+                                           unsigned char serverKey[hashSize]) {
+        unsigned char clientKey[hashSize];
+        unsigned int hashLen = 0;
+
+        // clientKey = HMAC(saltedPassword, "Client Key")
+        fassert(17498, 
+                crypto::hmacSha1(saltedPassword,
+                                 hashSize,
+                                 reinterpret_cast<const unsigned char*>(clientKeyConst.data()),
+                                 clientKeyConst.size(),
+                                 clientKey,
+                                 &hashLen));
+
+        // storedKey = H(clientKey)
+        fassert(17499, crypto::sha1(clientKey, hashSize, storedKey));
+
+        // serverKey = HMAC(saltedPassword, "Server Key")
+        fassert(17500, 
+                crypto::hmacSha1(saltedPassword,
+                                 hashSize,
+                                 reinterpret_cast<const unsigned char*>(serverKeyConst.data()),
+                                 serverKeyConst.size(),
+                                 serverKey,
+                                 &hashLen));
+    }
+
+} // namespace
+
     // Compute the SCRAM step Hi() as defined in RFC5802
     static void HMACIteration(const unsigned char input[],
                               size_t inputLen,
@@ -103,6 +195,24 @@ namespace scram {
                       saltedPassword);
     }
 
+    void generateSaltedPasswordCached(const StringData& hashedPassword,
+                                      const unsigned char* salt,
+                                      const int saltLen,
+                                      const int iterationCount,
+                                      unsigned char saltedPassword[hashSize]) {
+        const std::string key = makeCacheKey(hashedPassword, salt, saltLen, iterationCount);
+
+        SaltedPassword cached;
+        if (saltedPasswordCache.get(key, &cached)) {
+            memcpy(saltedPassword, cached.bytes, hashSize);
+            return;
+        }
+
+        generateSaltedPassword(hashedPassword, salt, saltLen, iterationCount, cached.bytes);
+        saltedPasswordCache.put(key, cached);
+        memcpy(saltedPassword, cached.bytes, hashSize);
+    }
+
     void generateSecrets(const std::string& hashedPassword,
                          const unsigned char salt[],
                          size_t saltLen,
@@ -111,35 +221,13 @@ namespace scram {
                          unsigned char serverKey[hashSize]) {
 
         unsigned char saltedPassword[hashSize];
-        unsigned char clientKey[hashSize];
-        unsigned int hashLen = 0;
-
-        generateSaltedPassword(hashedPassword,
-                               salt,
-                               saltLen,
-                               iterationCount,
-                               saltedPassword);
-
-        // clientKey = HMAC(saltedPassword, "Client Key")
-        fassert(17498, 
-                crypto::hmacSha1(saltedPassword,
-                                 hashSize,
-                                 reinterpret_cast<const unsigned char*>(clientKeyConst.data()),
-                                 clientKeyConst.size(),
-                                 clientKey,
-                                 &hashLen));
-
-        // storedKey = H(clientKey)
-        fassert(17499, crypto::sha1(clientKey, hashSize, storedKey));
+        generateSaltedPasswordCached(hashedPassword,
+                                     salt,
+                                     saltLen,
+                                     iterationCount,
+                                     saltedPassword);
 
-        // serverKey = HMAC(saltedPassword, "Server Key")
-        fassert(17500, 
-                crypto::hmacSha1(saltedPassword,
-                                 hashSize,
-                                 reinterpret_cast<const unsigned char*>(serverKeyConst.data()),
-                                 serverKeyConst.size(),
-                                 serverKey,
-                                 &hashLen));
+        generateSecretsFromSaltedPassword(saltedPassword, storedKey, serverKey);
     }
 
     BSONObj generateCredentials(const std::string& hashedPassword, int iterationCount) {
@@ -157,15 +245,17 @@ namespace scram {
             base64::encode(reinterpret_cast<char*>(userSalt), sizeof(userSalt));
 
         // Compute SCRAM secrets serverKey and storedKey
+        // The salt is new, so there is no point caching the SaltedPassword
+        unsigned char saltedPassword[hashSize];
         unsigned char storedKey[hashSize];
         unsigned char serverKey[hashSize];
 
-        generateSecrets(hashedPassword,
-                        reinterpret_cast<unsigned char*>(userSalt),
-                        saltLenQWords*sizeof(uint64_t),
-                        iterationCount,
-                        storedKey,
-                        serverKey);
+        generateSaltedPassword(hashedPassword,
+                               reinterpret_cast<unsigned char*>(userSalt),
+                               saltLenQWords*sizeof(uint64_t),
+                               iterationCount,
+                               saltedPassword);
+        generateSecretsFromSaltedPassword(saltedPassword, storedKey, serverKey);
 
         std::string encodedStoredKey =
             base64::encode(reinterpret_cast<char*>(storedKey), hashSize);
@@ -178,6 +268,19 @@ namespace scram {
                     serverKeyFieldName << encodedServerKey);
     }
 
+    BSONObj generateCredentialsCached(const std::string& hashedPassword, int iterationCount) {
+        const std::string key = makeCacheKey(hashedPassword, NULL, 0, iterationCount);
+
+        BSONObj credentials;
+        if (credentialsCache.get(key, &credentials)) {
+            return credentials;
+        }
+
+        credentials = generateCredentials(hashedPassword, iterationCount);
+        credentialsCache.put(key, credentials);
+        return credentials;
+    }
+
     std::string generateClientProof(const unsigned char saltedPassword[hashSize],
                                     const std::string& authMessage) {
 
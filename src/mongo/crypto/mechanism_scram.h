@@ -54,9 +54,21 @@ namespace scram {
                                 const int iterationCount,
                                 unsigned char saltedPassword[hashSize]);
 
+    /*
+     * Like generateSaltedPassword, but keeps recent results in a bounded process-wide cache
+     * keyed by a digest of the password, the salt and the iteration count, so repeated
+     * authentications with the same credentials skip the expensive iterated hash.
+     */
+    void generateSaltedPasswordCached(const StringData& hashedPassword,
+                                      const unsigned char* salt,
+                                      const int saltLen,
+                                      const int iterationCount,
+                                      unsigned char saltedPassword[hashSize]);
+
     /*
      * Computes the SCRAM secrets storedKey and serverKey using the salt 'salt'
      * and iteration count 'iterationCount' as defined in RFC5802 (server side). 
+     * The SaltedPassword is cached as by generateSaltedPasswordCached.
      */
     void generateSecrets(const std::string& hashedPassword,
                          const unsigned char salt[],
@@ -71,6 +83,12 @@ namespace scram {
      */
     BSONObj generateCredentials(const std::string& hashedPassword, int iterationCount);
 
+    /*
+     * Like generateCredentials, but returns the credentials generated for the same password and
+     * iteration count by an earlier call while they remain in a bounded process-wide cache.
+     */
+    BSONObj generateCredentialsCached(const std::string& hashedPassword, int iterationCount);
+
     /*
      * Computes the ClientProof from SaltedPassword and authMessage (client side).
      */
@@ -53,6 +53,10 @@ namespace mongo {
 
 namespace {
     const std::string ADMIN_DBNAME = "admin";
+
+    // Bounds the memory of sessions that touch many namespaces, such as ones that run listDatabases
+    // followed by a query on every collection.
+    const size_t kMaxAuthorizedActionsCacheSize = 1000;
 }  // namespace
 
     AuthorizationSession::AuthorizationSession(AuthzSessionExternalState* externalState) 
@@ -74,6 +78,12 @@ namespace {
     void AuthorizationSession::startRequest(OperationContext* txn) {
         _externalState->startRequest(txn);
         _refreshUserInfoAsNeeded(txn);
+
+        const OID generation = getAuthorizationManager().getCacheGeneration();
+        if (generation != _authorizedActionsCacheGeneration) {
+            _invalidateAuthorizedActionsCache();
+            _authorizedActionsCacheGeneration = generation;
+        }
     }
 
     Status AuthorizationSession::addAndAuthorizeUser(
@@ -95,6 +105,7 @@ namespace {
         clearImpersonatedUserData();
 
         _buildAuthenticatedRolesVector();
+        _invalidateAuthorizedActionsCache();
         return Status::OK();
     }
 
@@ -109,6 +120,7 @@ namespace {
         }
         clearImpersonatedUserData();
         _buildAuthenticatedRolesVector();
+        _invalidateAuthorizedActionsCache();
     }
 
     UserNameIterator AuthorizationSession::getAuthenticatedUserNames() {
@@ -135,6 +147,7 @@ namespace {
     void AuthorizationSession::grantInternalAuthorization() {
         _authenticatedUsers.add(internalSecurity.user);
         _buildAuthenticatedRolesVector();
+        _invalidateAuthorizedActionsCache();
     }
 
     PrivilegeVector AuthorizationSession::getDefaultPrivileges() {
@@ -491,6 +504,7 @@ namespace {
 
     void AuthorizationSession::_refreshUserInfoAsNeeded(OperationContext* txn) {
         AuthorizationManager& authMan = getAuthorizationManager();
+        bool usersChanged = false;
         UserSet::iterator it = _authenticatedUsers.begin();
         while (it != _authenticatedUsers.end()) {
             User* user = *it;
@@ -507,6 +521,7 @@ namespace {
                     // Success! Replace the old User object with the updated one.
                     fassert(17067, _authenticatedUsers.replaceAt(it, updatedUser) == user);
                     authMan.releaseUser(user);
+                    usersChanged = true;
                     LOG(1) << "Updated session cache of user information for " << name;
                     break;
                 }
@@ -514,6 +529,7 @@ namespace {
                     // User does not exist anymore; remove it from _authenticatedUsers.
                     fassert(17068, _authenticatedUsers.removeAt(it) == user);
                     authMan.releaseUser(user);
+                    usersChanged = true;
                     log() << "Removed deleted user " << name <<
                         " from session cache of user information.";
                     continue;  // No need to advance "it" in this case.
@@ -529,6 +545,9 @@ namespace {
             ++it;
         }
         _buildAuthenticatedRolesVector();
+        if (usersChanged) {
+            _invalidateAuthorizedActionsCache();
+        }
     }
 
     void AuthorizationSession::_buildAuthenticatedRolesVector() {
@@ -548,24 +567,37 @@ namespace {
     bool AuthorizationSession::_isAuthorizedForPrivilege(const Privilege& privilege) {
         const ResourcePattern& target(privilege.getResourcePattern());
 
+        // The localhost exception ends as soon as the first user is created, without anything
+        // marking this session's users as changed, so those checks are never cached.
+        if (_externalState->shouldAllowLocalhost()) {
+            return _getAuthorizedActions(target).isSupersetOf(privilege.getActions());
+        }
+
+        AuthorizedActionsCache::iterator it = _authorizedActionsCache.find(target);
+        if (it == _authorizedActionsCache.end()) {
+            if (_authorizedActionsCache.size() >= kMaxAuthorizedActionsCacheSize) {
+                _authorizedActionsCache.clear();
+            }
+            it = _authorizedActionsCache.insert(
+                    std::make_pair(target, _getAuthorizedActions(target))).first;
+        }
+        return it->second.isSupersetOf(privilege.getActions());
+    }
+
+    ActionSet AuthorizationSession::_getAuthorizedActions(const ResourcePattern& target) {
         ResourcePattern resourceSearchList[resourceSearchListCapacity];
         const int resourceSearchListLength = buildResourceSearchList(target, resourceSearchList);
 
-        ActionSet unmetRequirements = privilege.getActions();
+        ActionSet actions;
 
         PrivilegeVector defaultPrivileges = getDefaultPrivileges();
         for (PrivilegeVector::iterator it = defaultPrivileges.begin();
                 it != defaultPrivileges.end(); ++it) {
 
             for (int i = 0; i < resourceSearchListLength; ++i) {
-                if (!(it->getResourcePattern() == resourceSearchList[i]))
-                    continue;
-
-                ActionSet userActions = it->getActions();
-                unmetRequirements.removeAllActionsFromSet(userActions);
-
-                if (unmetRequirements.empty())
-                    return true;
+                if (it->getResourcePattern() == resourceSearchList[i]) {
+                    actions.addAllActionsFromSet(it->getActions());
+                }
             }
         }
 
@@ -573,15 +605,15 @@ namespace {
                 it != _authenticatedUsers.end(); ++it) {
             User* user = *it;
             for (int i = 0; i < resourceSearchListLength; ++i) {
-                ActionSet userActions = user->getActionsForResource(resourceSearchList[i]);
-                unmetRequirements.removeAllActionsFromSet(userActions);
-
-                if (unmetRequirements.empty())
-                    return true;
+                actions.addAllActionsFromSet(user->getActionsForResource(resourceSearchList[i]));
             }
         }
 
-        return false;
+        return actions;
+    }
+
+    void AuthorizationSession::_invalidateAuthorizedActionsCache() {
+        _authorizedActionsCache.clear();
     }
 
     void AuthorizationSession::setImpersonatedUserData(std::vector<UserName> usernames,
@@ -42,6 +42,7 @@
 #include "mongo/db/auth/user_name.h"
 #include "mongo/db/auth/user_set.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/platform/unordered_map.h"
 
 namespace mongo {
 
@@ -58,6 +59,11 @@ namespace mongo {
      * the cached information about any users who have been marked as invalid.  This guarantees that
      * every operation looks at one consistent view of each user for every auth check required over
      * the lifetime of the operation.
+     *
+     * The actions the authenticated users may perform on each resource checked are cached, so
+     * repeated checks against the same resource don't walk every user's privileges again.  The
+     * cache is dropped whenever the set of authenticated users or their User objects change, and
+     * whenever the AuthorizationManager's user cache generation moves on.
      */
     class AuthorizationSession {
         MONGO_DISALLOW_COPYING(AuthorizationSession);
@@ -229,6 +235,13 @@ namespace mongo {
         // lock on the admin database (to update out-of-date user privilege information).
         bool _isAuthorizedForPrivilege(const Privilege& privilege);
 
+        // Returns every action this connection may perform on "target", taking into account
+        // privileges granted on each resource pattern that matches it.
+        ActionSet _getAuthorizedActions(const ResourcePattern& target);
+
+        // Drops the cached results of earlier authorization checks.
+        void _invalidateAuthorizedActionsCache();
+
         boost::scoped_ptr<AuthzSessionExternalState> _externalState;
 
         // All Users who have been authenticated on this connection.
@@ -237,6 +250,12 @@ namespace mongo {
         // users set is changed.
         std::vector<RoleName> _authenticatedRoleNames;
 
+        // Results of _getAuthorizedActions for the resources checked so far, and the user cache
+        // generation of the AuthorizationManager they were computed under.
+        typedef unordered_map<ResourcePattern, ActionSet> AuthorizedActionsCache;
+        AuthorizedActionsCache _authorizedActionsCache;
+        OID _authorizedActionsCacheGeneration;
+
         // A vector of impersonated UserNames and a vector of those users' RoleNames.
         // These are used in the auditing system. They are not used for authz checks.
         std::vector<UserName> _impersonatedUserNames;
@@ -0,0 +1,80 @@
+// capped_insert_notifier.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/cstdint.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    /**
+     * Lets tailable awaitData cursors on a capped collection sleep until something is inserted
+     * into it, instead of polling.  Every committed insert bumps a version; a reader takes the
+     * version before it looks for new documents and, if it found none, waits for the version to
+     * move past it.  Taking the version first means an insert landing between the read and the
+     * wait is never missed.
+     *
+     * Shared by the Collection and any readers waiting on it, so waiters can outlive the
+     * Collection object they got it from.
+     */
+    class CappedInsertNotifier {
+        MONGO_DISALLOW_COPYING(CappedInsertNotifier);
+    public:
+        CappedInsertNotifier();
+
+        /**
+         * Wakes all waiters.  Called once an insert into the collection commits, and when the
+         * collection goes away.
+         */
+        void notifyAll();
+
+        /**
+         * Returns the current version, to be passed to waitUntil() later.
+         */
+        uint64_t getVersion() const;
+
+        /**
+         * Blocks until the version differs from 'prevVersion' or the wall clock reaches
+         * 'deadline', whichever comes first.
+         */
+        void waitUntil(uint64_t prevVersion, Date_t deadline) const;
+
+    private:
+        mutable boost::mutex _mutex; // protects _version
+        mutable boost::condition_variable _notifier;
+        uint64_t _version;
+    };
+
+}
@@ -38,6 +38,8 @@
 
 #include "mongo/base/counter.h"
 #include "mongo/base/owned_pointer_map.h"
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/bson/bson_field_index.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/curop.h"
@@ -58,6 +60,29 @@ namespace mongo {
     using boost::scoped_ptr;
     using logger::LogComponent;
 
+namespace {
+
+    AtomicUInt64 writeEpochCounter;
+
+    unsigned long long nextWriteEpoch() {
+        return writeEpochCounter.addAndFetch(1);
+    }
+
+    class BumpWriteEpochChange : public RecoveryUnit::Change {
+    public:
+        explicit BumpWriteEpochChange( const boost::shared_ptr<AtomicUInt64>& epoch )
+            : _epoch( epoch ) {
+        }
+
+        virtual void commit() { _epoch->store( nextWriteEpoch() ); }
+        virtual void rollback() { _epoch->store( nextWriteEpoch() ); }
+
+    private:
+        const boost::shared_ptr<AtomicUInt64> _epoch;
+    };
+
+} // namespace
+
     std::string CompactOptions::toString() const {
         std::stringstream ss;
         ss << "paddingMode: ";
@@ -73,6 +98,7 @@ namespace mongo {
         }
 
         ss << " validateDocuments: " << validateDocuments;
+        ss << " maxExtentFill: " << maxExtentFill;
 
         return ss.str();
     }
@@ -90,7 +116,13 @@ namespace mongo {
           _database( database ),
           _infoCache( this ),
           _indexCatalog( this ),
-          _cursorManager( fullNS ) {
+          _cursorManager( fullNS ),
+          _workingSetEstimator( fullNS ),
+          _cappedNotifier( _recordStore->isCapped() ? new CappedInsertNotifier() : NULL ),
+          _writeEpoch( new AtomicUInt64( nextWriteEpoch() ) ),
+          _truncateEpoch( nextWriteEpoch() ),
+          _idBloomFilter( IdBloomFilter::enabled() && requiresIdIndex() ?
+                          new IdBloomFilter() : NULL ) {
         _magic = 1357924;
         _indexCatalog.init(txn);
         if ( isCapped() )
@@ -100,6 +132,10 @@ namespace mongo {
 
     Collection::~Collection() {
         verify( ok() );
+        if ( _cappedNotifier ) {
+            // Let waiters notice the collection is gone rather than sleep out their timeout.
+            _cappedNotifier->notifyAll();
+        }
         _magic = 0;
     }
 
@@ -160,13 +196,16 @@ namespace mongo {
     }
 
     BSONObj Collection::docFor(OperationContext* txn, const RecordId& loc) const {
-        return  _recordStore->dataFor( txn, loc ).releaseToBson();
+        RecordData rd = _recordStore->dataFor( txn, loc );
+        _workingSetEstimator.noteAccessed( loc, rd.size() );
+        return rd.releaseToBson();
     }
 
     bool Collection::findDoc(OperationContext* txn, const RecordId& loc, BSONObj* out) const {
         RecordData rd;
         if ( !_recordStore->findRecord( txn, loc, &rd ) )
             return false;
+        _workingSetEstimator.noteAccessed( loc, rd.size() );
         *out = rd.releaseToBson();
         return true;
     }
@@ -182,6 +221,7 @@ namespace mongo {
         if ( !loc.isOK() )
             return loc;
 
+        _notifyCappedWaitersOnCommit( txn );
         return StatusWith<RecordId>( loc );
     }
 
@@ -220,14 +260,76 @@ namespace mongo {
         if ( !status.isOK() )
             return StatusWith<RecordId>( status );
 
+        _notifyCappedWaitersOnCommit( txn );
         return loc;
     }
 
+    Status Collection::insertDocuments( OperationContext* txn,
+                                        const std::vector<BSONObj>& docs,
+                                        bool enforceQuota,
+                                        std::vector<RecordId>* locsOut ) {
+
+        uint64_t txnId = txn->recoveryUnit()->getMyTransactionCount();
+
+        std::vector<RecordData> records;
+        records.reserve( docs.size() );
+
+        const bool requireId = _indexCatalog.findIdIndex( txn );
+        for ( std::vector<BSONObj>::const_iterator it = docs.begin(); it != docs.end(); ++it ) {
+            if ( requireId && (*it)["_id"].eoo() ) {
+                return Status( ErrorCodes::InternalError,
+                               str::stream() << "Collection::insertDocuments got "
+                               "document without _id for ns:" << _ns.ns() );
+            }
+            records.push_back( RecordData( it->objdata(), it->objsize() ) );
+        }
+
+        locsOut->reserve( locsOut->size() + docs.size() );
+        Status status = _recordStore->insertRecords( txn,
+                                                     records,
+                                                     _enforceQuota( enforceQuota ),
+                                                     locsOut );
+        if ( !status.isOK() )
+            return status;
+
+        invariant( locsOut->size() == docs.size() );
+        for ( std::vector<RecordId>::const_iterator it = locsOut->begin();
+              it != locsOut->end();
+              ++it ) {
+            invariant( RecordId::min() < *it );
+            invariant( *it < RecordId::max() );
+        }
+
+        _infoCache.notifyOfWriteOp();
+        _bumpWriteEpoch( txn );
+
+        if ( _idBloomFilter ) {
+            for ( std::vector<BSONObj>::const_iterator it = docs.begin(); it != docs.end(); ++it ) {
+                _idBloomFilter->onInsert( txn, (*it)["_id"] );
+            }
+        }
+
+        status = _indexCatalog.indexRecords( txn, docs, *locsOut );
+        invariant( txnId == txn->recoveryUnit()->getMyTransactionCount() );
+        if ( status.isOK() )
+            _notifyCappedWaitersOnCommit( txn );
+        return status;
+    }
+
     RecordFetcher* Collection::documentNeedsFetch( OperationContext* txn,
                                                    const RecordId& loc ) const {
         return _recordStore->recordNeedsFetch( txn, loc );
     }
 
+    bool Collection::documentPrefetchSupported() const {
+        return _recordStore->prefetchSupported();
+    }
+
+    void Collection::prefetchDocuments( OperationContext* txn,
+                                        const std::vector<RecordId>& locs ) const {
+        _recordStore->prefetchRecords( txn, locs );
+    }
+
 
     StatusWith<RecordId> Collection::_insertDocument( OperationContext* txn,
                                                      const BSONObj& docToInsert,
@@ -248,15 +350,47 @@ namespace mongo {
         invariant( loc.getValue() < RecordId::max() );
 
         _infoCache.notifyOfWriteOp();
+        _bumpWriteEpoch( txn );
+
+        if ( _idBloomFilter )
+            _idBloomFilter->onInsert( txn, docToInsert["_id"] );
 
         Status s = _indexCatalog.indexRecord(txn, docToInsert, loc.getValue());
         if (!s.isOK())
             return StatusWith<RecordId>(s);
 
+        _notifyCappedWaitersOnCommit( txn );
         return loc;
     }
 
+    namespace {
+        class NotifyCappedWaitersChange : public RecoveryUnit::Change {
+        public:
+            explicit NotifyCappedWaitersChange( const boost::shared_ptr<CappedInsertNotifier>& n )
+                : _notifier( n ) {
+            }
+
+            virtual void commit() { _notifier->notifyAll(); }
+            virtual void rollback() { }
+
+        private:
+            const boost::shared_ptr<CappedInsertNotifier> _notifier;
+        };
+    }
+
+    void Collection::_notifyCappedWaitersOnCommit( OperationContext* txn ) {
+        if ( !_cappedNotifier )
+            return;
+        txn->recoveryUnit()->registerChange( new NotifyCappedWaitersChange( _cappedNotifier ) );
+    }
+
+    void Collection::_bumpWriteEpoch( OperationContext* txn ) {
+        _writeEpoch->store( nextWriteEpoch() );
+        txn->recoveryUnit()->registerChange( new BumpWriteEpochChange( _writeEpoch ) );
+    }
+
     Status Collection::aboutToDeleteCapped( OperationContext* txn, const RecordId& loc ) {
+        _bumpWriteEpoch( txn );
 
         BSONObj doc = docFor( txn, loc );
 
@@ -265,6 +399,9 @@ namespace mongo {
 
         _indexCatalog.unindexRecord(txn, doc, loc, false);
 
+        if ( _idBloomFilter )
+            _idBloomFilter->onDelete( txn, doc["_id"] );
+
         return Status::OK();
     }
 
@@ -293,9 +430,54 @@ namespace mongo {
 
         _indexCatalog.unindexRecord(txn, doc, loc, noWarn);
 
+        if ( _idBloomFilter )
+            _idBloomFilter->onDelete( txn, doc["_id"] );
+
         _recordStore->deleteRecord( txn, loc );
 
         _infoCache.notifyOfWriteOp();
+        _bumpWriteEpoch( txn );
+    }
+
+    void Collection::deleteDocuments( OperationContext* txn,
+                                      const std::vector<RecordId>& locs,
+                                      bool cappedOK,
+                                      bool noWarn,
+                                      std::vector<BSONObj>* deletedIds ) {
+        if ( isCapped() && !cappedOK ) {
+            log() << "failing remove on a capped ns " << _ns << endl;
+            uasserted( 10089,  "cannot remove from a capped collection" );
+            return;
+        }
+
+        std::vector<BSONObj> docs;
+        docs.reserve( locs.size() );
+        for ( std::vector<RecordId>::const_iterator it = locs.begin(); it != locs.end(); ++it ) {
+            docs.push_back( docFor( txn, *it ) );
+
+            if ( deletedIds ) {
+                BSONElement e = docs.back()["_id"];
+                deletedIds->push_back( e.type() ? e.wrap() : BSONObj() );
+            }
+
+            /* check if any cursors point to us.  if so, advance them. */
+            _cursorManager.invalidateDocument(txn, *it, INVALIDATION_DELETION);
+        }
+
+        _indexCatalog.unindexRecords(txn, docs, locs, noWarn);
+
+        if ( _idBloomFilter ) {
+            for ( std::vector<BSONObj>::const_iterator it = docs.begin(); it != docs.end(); ++it ) {
+                _idBloomFilter->onDelete( txn, (*it)["_id"] );
+            }
+        }
+
+        for ( std::vector<RecordId>::const_iterator it = locs.begin(); it != locs.end(); ++it ) {
+            _recordStore->deleteRecord( txn, *it );
+        }
+
+        _infoCache.notifyOfWriteOp();
+        _bumpWriteEpoch( txn );
     }
 
     Counter64 moveCounter;
@@ -322,6 +504,12 @@ namespace mongo {
         // objNew.
         OwnedPointerMap<IndexDescriptor*,UpdateTicket> updateTickets;
         if ( indexesAffected ) {
+            // Each index looks up its key fields in both documents.
+            BSONFieldIndex oldFields( objOld );
+            BSONFieldIndex newFields( objNew );
+            BSONFieldIndex::Scope oldFieldsScope( oldFields );
+            BSONFieldIndex::Scope newFieldsScope( newFields );
+
             IndexCatalog::IndexIterator ii = _indexCatalog.getIndexIterator( txn, true );
             while ( ii.more() ) {
                 IndexDescriptor* descriptor = ii.next();
@@ -359,6 +547,7 @@ namespace mongo {
         // moved.
 
         _infoCache.notifyOfWriteOp();
+        _bumpWriteEpoch( txn );
 
         // If the object did move, we need to add the new location to all indexes.
         if ( newLocation.getValue() != oldLocation ) {
@@ -404,6 +593,135 @@ namespace mongo {
         return newLocation;
     }
 
+    Status Collection::updateDocuments( OperationContext* txn,
+                                        const std::vector<RecordId>& oldLocations,
+                                        const std::vector<BSONObj>& oldDocs,
+                                        const std::vector<BSONObj>& newDocs,
+                                        bool enforceQuota,
+                                        OpDebug* debug,
+                                        std::vector<RecordId>* locsOut ) {
+        invariant( oldLocations.size() == oldDocs.size() );
+        invariant( newDocs.size() == oldDocs.size() );
+
+        uint64_t txnId = txn->recoveryUnit()->getMyTransactionCount();
+        const size_t numDocs = oldDocs.size();
+
+        for ( size_t i = 0; i < numDocs; i++ ) {
+            BSONElement oldId = oldDocs[i]["_id"];
+            if ( !oldId.eoo() && ( oldId != newDocs[i]["_id"] ) )
+                return Status( ErrorCodes::InternalError,
+                               "in Collection::updateDocuments _id mismatch",
+                               13596 );
+        }
+
+        std::vector<IndexDescriptor*> descriptors;
+        IndexCatalog::IndexIterator ii = _indexCatalog.getIndexIterator( txn, true );
+        while ( ii.more() ) {
+            descriptors.push_back( ii.next() );
+        }
+
+        // The ticket of document i for index j is at j * numDocs + i.
+        OwnedPointerVector<UpdateTicket> updateTickets;
+        updateTickets.mutableVector().reserve( descriptors.size() * numDocs );
+        for ( size_t j = 0; j < descriptors.size(); j++ ) {
+            for ( size_t i = 0; i < numDocs; i++ ) {
+                updateTickets.push_back( new UpdateTicket() );
+            }
+        }
+
+        for ( size_t i = 0; i < numDocs; i++ ) {
+            // Each index looks up its key fields in both documents.
+            BSONFieldIndex oldFields( oldDocs[i] );
+            BSONFieldIndex newFields( newDocs[i] );
+            BSONFieldIndex::Scope oldFieldsScope( oldFields );
+            BSONFieldIndex::Scope newFieldsScope( newFields );
+
+            for ( size_t j = 0; j < descriptors.size(); j++ ) {
+                IndexDescriptor* descriptor = descriptors[j];
+                IndexAccessMethod* iam = _indexCatalog.getIndex( descriptor );
+
+                InsertDeleteOptions options;
+                options.logIfError = false;
+                options.dupsAllowed =
+                    !(KeyPattern::isIdKeyPattern(descriptor->keyPattern()) || descriptor->unique())
+                    || repl::getGlobalReplicationCoordinator()->shouldIgnoreUniqueIndex(descriptor);
+                Status ret = iam->validateUpdate( txn, oldDocs[i], newDocs[i], oldLocations[i],
+                                                  options, updateTickets[j * numDocs + i] );
+                if ( !ret.isOK() ) {
+                    return ret;
+                }
+            }
+        }
+
+        // Moved documents are unindexed by recordStoreGoingToMove and indexed again in full
+        // right away; only the ones staying in place keep their tickets for the batch.
+        std::vector<bool> moved( numDocs, false );
+        locsOut->reserve( locsOut->size() + numDocs );
+        for ( size_t i = 0; i < numDocs; i++ ) {
+            StatusWith<RecordId> newLocation =
+                _recordStore->updateRecord( txn,
+                                            oldLocations[i],
+                                            newDocs[i].objdata(),
+                                            newDocs[i].objsize(),
+                                            _enforceQuota( enforceQuota ),
+                                            this );
+            if ( !newLocation.isOK() ) {
+                return newLocation.getStatus();
+            }
+            locsOut->push_back( newLocation.getValue() );
+
+            if ( newLocation.getValue() == oldLocations[i] ) {
+                continue;
+            }
+
+            moved[i] = true;
+            if ( debug ) {
+                if (debug->nmoved == -1) // default of -1 rather than 0
+                    debug->nmoved = 1;
+                else
+                    debug->nmoved += 1;
+            }
+
+            Status s = _indexCatalog.indexRecord( txn, newDocs[i], newLocation.getValue() );
+            if ( !s.isOK() )
+                return s;
+        }
+
+        _infoCache.notifyOfWriteOp();
+        _bumpWriteEpoch( txn );
+
+        if ( debug )
+            debug->keyUpdates = 0;
+
+        std::vector<const UpdateTicket*> indexTickets;
+        for ( size_t j = 0; j < descriptors.size(); j++ ) {
+            indexTickets.clear();
+            for ( size_t i = 0; i < numDocs; i++ ) {
+                if ( !moved[i] ) {
+                    indexTickets.push_back( updateTickets[j * numDocs + i] );
+                }
+            }
+
+            int64_t updatedKeys;
+            IndexAccessMethod* iam = _indexCatalog.getIndex( descriptors[j] );
+            Status ret = iam->updateMany( txn, indexTickets, &updatedKeys );
+            if ( !ret.isOK() )
+                return ret;
+            if ( debug )
+                debug->keyUpdates += updatedKeys;
+        }
+
+        // Broadcast the mutations so that query results stay correct.
+        for ( size_t i = 0; i < numDocs; i++ ) {
+            if ( !moved[i] ) {
+                _cursorManager.invalidateDocument( txn, oldLocations[i], INVALIDATION_MUTATION );
+            }
+        }
+
+        invariant( txnId == txn->recoveryUnit()->getMyTransactionCount() );
+        return Status::OK();
+    }
+
     Status Collection::recordStoreGoingToMove( OperationContext* txn,
                                                const RecordId& oldLocation,
                                                const char* oldBuffer,
@@ -423,6 +741,7 @@ namespace mongo {
 
         // Broadcast the mutation so that query results stay correct.
         _cursorManager.invalidateDocument(txn, loc, INVALIDATION_MUTATION);
+        _bumpWriteEpoch( txn );
 
         return _recordStore->updateWithDamages( txn, loc, oldRec, damageSource, damages );
     }
@@ -506,6 +825,8 @@ namespace mongo {
             return status;
         _cursorManager.invalidateAll( false );
         _infoCache.reset( txn );
+        _bumpWriteEpoch( txn );
+        _truncateEpoch.store( nextWriteEpoch() );
 
         // 3) truncate record store
         status = _recordStore->truncate(txn);
@@ -526,6 +847,8 @@ namespace mongo {
                                               RecordId end,
                                               bool inclusive) {
         invariant( isCapped() );
+        _bumpWriteEpoch( txn );
+        _truncateEpoch.store( nextWriteEpoch() );
         _recordStore->temp_cappedTruncateAfter( txn, end, inclusive );
     }
 
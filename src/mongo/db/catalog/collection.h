@@ -32,16 +32,22 @@
 
 #include <string>
 
+#include <boost/shared_ptr.hpp>
+
 #include "mongo/base/string_data.h"
 #include "mongo/bson/mutable/damage_vector.h"
+#include "mongo/db/catalog/capped_insert_notifier.h"
 #include "mongo/db/catalog/collection_info_cache.h"
 #include "mongo/db/catalog/cursor_manager.h"
+#include "mongo/db/catalog/id_bloom_filter.h"
 #include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/catalog/working_set_estimator.h"
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/record_id.h"
 #include "mongo/db/storage/capped_callback.h"
 #include "mongo/db/storage/record_store.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/cstdint.h"
 
 namespace mongo {
@@ -65,6 +71,7 @@ namespace mongo {
             validateDocuments = true;
             paddingFactor = 1;
             paddingBytes = 0;
+            maxExtentFill = 0.5;
         }
 
         // padding
@@ -84,15 +91,25 @@ namespace mongo {
         // other
         bool validateDocuments;
 
+        // incremental compaction only moves records out of extents with less than this fraction
+        // of their space in use
+        double maxExtentFill;
+
         std::string toString() const;
     };
 
     struct CompactStats {
         CompactStats() {
             corruptDocuments = 0;
+            recordsMoved = 0;
+            extentsFreed = 0;
         }
 
         long long corruptDocuments;
+
+        // only maintained by incremental compaction
+        long long recordsMoved;
+        long long extentsFreed;
     };
 
     /**
@@ -127,6 +144,28 @@ namespace mongo {
 
         CursorManager* getCursorManager() const { return &_cursorManager; }
 
+        /**
+         * Notified after every committed insert, for tailable awaitData cursors to wait on.
+         * NULL unless the collection is capped.
+         */
+        boost::shared_ptr<CappedInsertNotifier> getCappedInsertNotifier() const {
+            return _cappedNotifier;
+        }
+
+        /**
+         * Changes whenever a write to this collection begins, commits or rolls back, and never
+         * repeats a value used by another collection. Results computed while it held one value
+         * are current for as long as it still does.
+         */
+        unsigned long long getWriteEpoch() const { return _writeEpoch->load(); }
+
+        /**
+         * Like the write epoch, but only changes when documents are removed in bulk, by truncate()
+         * or temp_cappedTruncateAfter(). What follows a record stays the same in a capped
+         * collection for as long as this does.
+         */
+        unsigned long long getTruncateEpoch() const { return _truncateEpoch.load(); }
+
         bool requiresIdIndex() const;
 
         BSONObj docFor(OperationContext* txn, const RecordId& loc) const;
@@ -137,6 +176,21 @@ namespace mongo {
          */
         bool findDoc(OperationContext* txn, const RecordId& loc, BSONObj* out) const;
 
+        /**
+         * Counts a read of the record at 'loc' toward the working set estimate.  Only needed by
+         * callers that read records without going through docFor() or findDoc().
+         */
+        void noteAccessed(const RecordId& loc, int size) const {
+            _workingSetEstimator.noteAccessed(loc, size);
+        }
+
+        const WorkingSetEstimator& workingSetEstimator() const { return _workingSetEstimator; }
+
+        /**
+         * The filter of this collection's _id values, or NULL if _id filters are disabled.
+         */
+        IdBloomFilter* idBloomFilter() const { return _idBloomFilter.get(); }
+
         // ---- things that should move to a CollectionAccessMethod like thing
         /**
          * Default arguments will return all items in the collection.
@@ -166,6 +220,18 @@ namespace mongo {
                              bool noWarn = false,
                              BSONObj* deletedId = 0 );
 
+        /**
+         * Deletes a batch of distinct documents with the same semantics as deleteDocument(),
+         * removing the keys of the whole batch from each index at once, in key order.  If not
+         * NULL, 'deletedIds' gets the wrapped _id of each document in order, or an empty object
+         * for a document without one.
+         */
+        void deleteDocuments( OperationContext* txn,
+                              const std::vector<RecordId>& locs,
+                              bool cappedOK,
+                              bool noWarn,
+                              std::vector<BSONObj>* deletedIds );
+
         /**
          * this does NOT modify the doc before inserting
          * i.e. will not add an _id field for documents that are missing it
@@ -185,6 +251,19 @@ namespace mongo {
                                             MultiIndexBlock* indexBlock,
                                             bool enforceQuota );
 
+        /**
+         * Inserts a batch of documents with the same semantics as insertDocument(), sharing
+         * record store and index maintenance work across the batch.  On success, 'locsOut'
+         * holds the RecordId of each document in order.
+         *
+         * On error, some documents may have been written and the caller must roll back the
+         * enclosing WriteUnitOfWork.  The error does not identify the offending document.
+         */
+        Status insertDocuments( OperationContext* txn,
+                                const std::vector<BSONObj>& docs,
+                                bool enforceQuota,
+                                std::vector<RecordId>* locsOut );
+
         /**
          * If the document at 'loc' is unlikely to be in physical memory, the storage
          * engine gives us back a RecordFetcher functor which we can invoke in order
@@ -197,6 +276,17 @@ namespace mongo {
         RecordFetcher* documentNeedsFetch( OperationContext* txn,
                                            const RecordId& loc ) const;
 
+        /**
+         * Returns true if the storage engine can start reading in documents ahead of time.
+         */
+        bool documentPrefetchSupported() const;
+
+        /**
+         * Hints the storage engine that the documents at 'locs' are about to be read.
+         * See RecordStore::prefetchRecords().
+         */
+        void prefetchDocuments( OperationContext* txn, const std::vector<RecordId>& locs ) const;
+
         /**
          * updates the document @ oldLocation with newDoc
          * if the document fits in the old space, it is put there
@@ -211,6 +301,23 @@ namespace mongo {
                                              bool indexesAffected,
                                              OpDebug* debug );
 
+        /**
+         * Updates a batch of distinct documents with the same semantics as updateDocument()
+         * with 'indexesAffected' set, sharing index maintenance across the batch: each index
+         * gets the key changes of all the documents that stay in place at once, in key order.
+         * On success, 'locsOut' holds the post update location of each document in order.
+         *
+         * On error, some documents may have been written and the caller must roll back the
+         * enclosing WriteUnitOfWork.  The error does not identify the offending document.
+         */
+        Status updateDocuments( OperationContext* txn,
+                                const std::vector<RecordId>& oldLocations,
+                                const std::vector<BSONObj>& oldDocs,
+                                const std::vector<BSONObj>& newDocs,
+                                bool enforceQuota,
+                                OpDebug* debug,
+                                std::vector<RecordId>* locsOut );
+
         /**
          * right now not allowed to modify indexes
          */
@@ -224,6 +331,18 @@ namespace mongo {
 
         StatusWith<CompactStats> compact(OperationContext* txn, const CompactOptions* options);
 
+        /**
+         * Runs one batch of online compaction, moving at most 'maxRecords' records and updating
+         * the indexes as it goes.  The caller must hold the collection lock exclusively and should
+         * release it between batches so other operations can run.  Sets *done once nothing is
+         * left worth moving.
+         */
+        Status compactIncremental( OperationContext* txn,
+                                   const CompactOptions* options,
+                                   int maxRecords,
+                                   CompactStats* stats,
+                                   bool* done );
+
         /**
          * removes all documents as fast as possible
          * indexes before and after will be the same
@@ -303,6 +422,17 @@ namespace mongo {
 
         bool _enforceQuota( bool userEnforeQuota ) const;
 
+        /**
+         * Wakes the awaitData cursors waiting on a capped collection once 'txn' commits.
+         */
+        void _notifyCappedWaitersOnCommit( OperationContext* txn );
+
+        /**
+         * Moves the write epoch on now, and again once 'txn' commits or rolls back, so that
+         * nothing read while the write was pending is taken as current afterwards.
+         */
+        void _bumpWriteEpoch( OperationContext* txn );
+
         int _magic;
 
         NamespaceString _ns;
@@ -317,6 +447,20 @@ namespace mongo {
         // should be about the data.
         mutable CursorManager _cursorManager;
 
+        // Mutable for the same reason: reads through a const Collection feed it.
+        mutable WorkingSetEstimator _workingSetEstimator;
+
+        // Only set for capped collections.
+        const boost::shared_ptr<CappedInsertNotifier> _cappedNotifier;
+
+        // Shared with the changes registered by _bumpWriteEpoch, which may outlive us.
+        const boost::shared_ptr<AtomicUInt64> _writeEpoch;
+
+        AtomicUInt64 _truncateEpoch;
+
+        // Only set when _id filters are enabled and the collection has an _id index.
+        const boost::scoped_ptr<IdBloomFilter> _idBloomFilter;
+
         friend class Database;
         friend class IndexCatalog;
         friend class NamespaceDetails;
@@ -32,6 +32,7 @@
 
 #include "mongo/base/string_data.h"
 #include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/index/multikey_paths.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/record_id.h"
 
@@ -72,6 +73,25 @@ namespace mongo {
                                         const StringData& indexName,
                                         bool multikey = true) = 0;
 
+        /**
+         * Returns which fields of a multikey index are multikey, or an empty MultikeyPaths if
+         * that isn't recorded.
+         */
+        virtual MultikeyPaths getIndexMultikeyPaths(OperationContext* txn,
+                                                    const StringData& indexName) const {
+            return MultikeyPaths();
+        }
+
+        /**
+         * Records which fields of a multikey index are multikey. Returns true if that changed
+         * anything. Catalogs which don't record it ignore the call and return false.
+         */
+        virtual bool setIndexMultikeyPaths(OperationContext* txn,
+                                           const StringData& indexName,
+                                           const MultikeyPaths& multikeyPaths) {
+            return false;
+        }
+
         virtual RecordId getIndexHead( OperationContext* txn,
                                       const StringData& indexName ) const = 0;
 
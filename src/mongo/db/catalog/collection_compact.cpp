@@ -95,6 +95,34 @@ namespace mongo {
             MultiIndexBlock* _multiIndexBlock;
         };
 
+        /**
+         * Adds each moved record to the live indexes; the Collection, as the record store's
+         * UpdateMoveNotifier, has already removed the old location from them.
+         */
+        class IncrementalCompactAdaptor : public RecordStoreCompactAdaptor {
+        public:
+            IncrementalCompactAdaptor(OperationContext* txn, IndexCatalog* indexCatalog)
+                : _txn( txn ),
+                  _indexCatalog( indexCatalog ) {
+            }
+
+            virtual bool isDataValid( const RecordData& recData ) {
+                return recData.toBson().valid();
+            }
+
+            virtual size_t dataSize( const RecordData& recData ) {
+                return recData.toBson().objsize();
+            }
+
+            virtual void inserted( const RecordData& recData, const RecordId& newLocation ) {
+                uassertStatusOK( _indexCatalog->indexRecord( _txn, recData.toBson(), newLocation ) );
+            }
+
+        private:
+            OperationContext* const _txn;
+            IndexCatalog* const _indexCatalog;
+        };
+
     }
 
 
@@ -177,4 +205,29 @@ namespace mongo {
         return StatusWith<CompactStats>( stats );
     }
 
+    Status Collection::compactIncremental( OperationContext* txn,
+                                           const CompactOptions* compactOptions,
+                                           int maxRecords,
+                                           CompactStats* stats,
+                                           bool* done ) {
+        if ( !_recordStore->compactIncrementalSupported() )
+            return Status( ErrorCodes::BadValue,
+                           str::stream() <<
+                           "cannot compact incrementally collection with record store: " <<
+                           _recordStore->name() );
+
+        if ( _indexCatalog.numIndexesInProgress( txn ) )
+            return Status( ErrorCodes::BadValue,
+                           "cannot compact when indexes in progress" );
+
+        IncrementalCompactAdaptor adaptor( txn, &_indexCatalog );
+        return _recordStore->compactIncremental( txn,
+                                                 &adaptor,
+                                                 this,
+                                                 compactOptions,
+                                                 maxRecords,
+                                                 stats,
+                                                 done );
+    }
+
 }  // namespace mongo
@@ -39,6 +39,7 @@
 #include "mongo/db/fts/fts_spec.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/index_legacy.h"
+#include "mongo/db/matcher/expression.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/util/debug_util.h"
 #include "mongo/util/log.h"
@@ -46,15 +47,29 @@
 
 namespace mongo {
 
+    namespace {
+        void addFilterPaths( const MatchExpression* expr, UpdateIndexData* paths ) {
+            if ( !expr->path().empty() ) {
+                paths->addPath( expr->path() );
+            }
+            for ( size_t i = 0; i < expr->numChildren(); i++ ) {
+                addFilterPaths( expr->getChild( i ), paths );
+            }
+        }
+    }
+
     CollectionInfoCache::CollectionInfoCache( Collection* collection )
         : _collection( collection ),
           _keysComputed( false ),
           _planCache(new PlanCache(collection->ns().ns())),
-          _querySettings(new QuerySettings()) { }
+          _querySettings(new QuerySettings()),
+          _indexStatistics(new IndexStatistics()),
+          _queryShapeStats(new QueryShapeStats()) { }
 
     void CollectionInfoCache::reset( OperationContext* txn ) {
         LOG(1) << _collection->ns().ns() << ": clearing plan cache - collection info cache reset";
         clearQueryCache();
+        _indexStatistics->clear();
         _keysComputed = false;
         computeIndexKeys( txn );
         // query settings is not affected by info cache reset.
@@ -108,6 +123,13 @@ namespace mongo {
                     _indexedPaths.addPathComponent(ftsSpec.languageOverrideField());
                 }
             }
+
+            // Changing a field of a partial index's filter can move a document in or out of it.
+            const MatchExpression* filter =
+                _collection->getIndexCatalog()->getEntry(descriptor)->getFilterExpression();
+            if (filter) {
+                addFilterPaths(filter, &_indexedPaths);
+            }
         }
 
         _keysComputed = true;
@@ -118,6 +140,7 @@ namespace mongo {
         if (NULL != _planCache.get()) {
             _planCache->notifyOfWriteOp();
         }
+        _indexStatistics->notifyOfWriteOp();
     }
 
     void CollectionInfoCache::clearQueryCache() {
@@ -134,4 +157,12 @@ namespace mongo {
         return _querySettings.get();
     }
 
+    IndexStatistics* CollectionInfoCache::getIndexStatistics() const {
+        return _indexStatistics.get();
+    }
+
+    QueryShapeStats* CollectionInfoCache::getQueryShapeStats() const {
+        return _queryShapeStats.get();
+    }
+
 }
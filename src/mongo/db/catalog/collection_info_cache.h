@@ -32,8 +32,10 @@
 
 #include <boost/scoped_ptr.hpp>
 
+#include "mongo/db/query/index_histogram.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/query_settings.h"
+#include "mongo/db/query/query_shape_stats.h"
 #include "mongo/db/update_index_data.h"
 
 namespace mongo {
@@ -68,6 +70,16 @@ namespace mongo {
          */
         QuerySettings* getQuerySettings() const;
 
+        /**
+         * Get the histograms of the indexes of this collection.
+         */
+        IndexStatistics* getIndexStatistics() const;
+
+        /**
+         * Get the execution counters of the queries on this collection, by query shape.
+         */
+        QueryShapeStats* getQueryShapeStats() const;
+
         // -------------------
 
         /* get set of index keys for this namespace.  handy to quickly check if a given
@@ -102,6 +114,12 @@ namespace mongo {
         // Includes index filters.
         boost::scoped_ptr<QuerySettings> _querySettings;
 
+        // Index histograms, for pruning candidate plans.
+        boost::scoped_ptr<IndexStatistics> _indexStatistics;
+
+        // Query execution counters, by query shape.
+        boost::scoped_ptr<QueryShapeStats> _queryShapeStats;
+
         /**
          * Must be called under exclusive DB lock.
          */
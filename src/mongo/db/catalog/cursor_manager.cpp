@@ -314,9 +314,11 @@ namespace mongo {
 
     CursorManager::CursorManager( const StringData& ns )
         : _nss( ns ),
-          _mutex( "CursorManager" ) {
+          _executorsMutex( "CursorManager" ) {
         _collectionCacheRuntimeId = globalCursorIdCache->created( _nss.ns() );
-        _random.reset( new PseudoRandom( globalCursorIdCache->nextSeed() ) );
+        for ( int i = 0; i < kNumPartitions; i++ ) {
+            _partitions[i].random.reset( new PseudoRandom( globalCursorIdCache->nextSeed() ) );
+        }
     }
 
     CursorManager::~CursorManager() {
@@ -324,8 +326,12 @@ namespace mongo {
         globalCursorIdCache->destroyed( _collectionCacheRuntimeId, _nss.ns() );
     }
 
+    CursorManager::Partition::Partition() : mutex( "CursorManagerPartition" ) {}
+
+    CursorManager::Partition::~Partition() {}
+
     void CursorManager::invalidateAll( bool collectionGoingAway ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        SimpleMutex::scoped_lock lk( _executorsMutex );
 
         for ( ExecSet::iterator it = _nonCachedExecutors.begin();
               it != _nonCachedExecutors.end();
@@ -338,58 +344,71 @@ namespace mongo {
         }
         _nonCachedExecutors.clear();
 
-        if ( collectionGoingAway ) {
-            // we're going to wipe out the world
-            for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-                ClientCursor* cc = i->second;
+        for ( int p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock partitionLock( partition.mutex );
 
-                cc->kill();
-
-                invariant( cc->getExecutor() == NULL || cc->getExecutor()->collection() == NULL );
-
-                // If the CC is pinned, somebody is actively using it and we do not delete it.
-                // Instead we notify the holder that we killed it.  The holder will then delete the
-                // CC.
-                //
-                // If the CC is not pinned, there is nobody actively holding it.  We can safely
-                // delete it.
-                if (!cc->isPinned()) {
-                    delete cc;
-                }
-            }
-        }
-        else {
-            CursorMap newMap;
+            if ( collectionGoingAway ) {
+                // we're going to wipe out the world
+                for ( CursorMap::const_iterator i = partition.cursors.begin();
+                      i != partition.cursors.end(); ++i ) {
+                    ClientCursor* cc = i->second.cursor;
 
-            // collection will still be around, just all PlanExecutors are invalid
-            for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-                ClientCursor* cc = i->second;
+                    cc->kill();
 
-                // Note that a valid ClientCursor state is "no cursor no executor."  This is because
-                // the set of active cursor IDs in ClientCursor is used as representation of query
-                // state.  See sharding_block.h.  TODO(greg,hk): Move this out.
-                if (NULL == cc->getExecutor() ) {
-                    newMap.insert( *i );
-                    continue;
+                    invariant( cc->getExecutor() == NULL ||
+                               cc->getExecutor()->collection() == NULL );
+
+                    // If the CC is pinned, somebody is actively using it and we do not delete it.
+                    // Instead we notify the holder that we killed it.  The holder will then
+                    // delete the CC.
+                    //
+                    // If the CC is not pinned, there is nobody actively holding it.  We can
+                    // safely delete it.
+                    if (!cc->isPinned()) {
+                        delete cc;
+                    }
                 }
 
-                if (cc->isPinned() || cc->isAggCursor()) {
-                    // Pinned cursors need to stay alive, so we leave them around.  Aggregation
-                    // cursors also can stay alive (since they don't have their lifetime bound to
-                    // the underlying collection).  However, if they have an associated executor, we
-                    // need to kill it, because it's now invalid.
-                    if ( cc->getExecutor() )
-                        cc->getExecutor()->kill();
-                    newMap.insert( *i );
+                partition.cursors.clear();
+                if ( partition.timeouts ) {
+                    partition.timeouts->clear();
                 }
-                else {
-                    cc->kill();
-                    delete cc;
+            }
+            else {
+                // collection will still be around, just all PlanExecutors are invalid
+                for ( CursorMap::iterator i = partition.cursors.begin();
+                      i != partition.cursors.end(); ) {
+                    ClientCursor* cc = i->second.cursor;
+
+                    // Note that a valid ClientCursor state is "no cursor no executor."  This is
+                    // because the set of active cursor IDs in ClientCursor is used as
+                    // representation of query state.  See sharding_block.h.  TODO(greg,hk): Move
+                    // this out.
+                    if (NULL == cc->getExecutor() ) {
+                        ++i;
+                        continue;
+                    }
+
+                    if (cc->isPinned() || cc->isAggCursor()) {
+                        // Pinned cursors need to stay alive, so we leave them around.
+                        // Aggregation cursors also can stay alive (since they don't have their
+                        // lifetime bound to the underlying collection).  However, if they have an
+                        // associated executor, we need to kill it, because it's now invalid.
+                        if ( cc->getExecutor() )
+                            cc->getExecutor()->kill();
+                        ++i;
+                    }
+                    else {
+                        if ( i->second.hasTimeout ) {
+                            partition.timeouts->cancel( i->second.timeout );
+                        }
+                        partition.cursors.erase( i++ );
+                        cc->kill();
+                        delete cc;
+                    }
                 }
-
             }
-
-            _cursors = newMap;
         }
     }
 
@@ -402,64 +421,101 @@ namespace mongo {
             return;
         }
 
-        SimpleMutex::scoped_lock lk( _mutex );
+        {
+            SimpleMutex::scoped_lock lk( _executorsMutex );
 
-        for ( ExecSet::iterator it = _nonCachedExecutors.begin();
-              it != _nonCachedExecutors.end();
-              ++it ) {
+            for ( ExecSet::iterator it = _nonCachedExecutors.begin();
+                  it != _nonCachedExecutors.end();
+                  ++it ) {
 
-            PlanExecutor* exec = *it;
-            exec->invalidate(txn, dl, type);
+                PlanExecutor* exec = *it;
+                exec->invalidate(txn, dl, type);
+            }
         }
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            PlanExecutor* exec = i->second->getExecutor();
-            if ( exec ) {
-                exec->invalidate(txn, dl, type);
+        for ( int p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
+
+            for ( CursorMap::const_iterator i = partition.cursors.begin();
+                  i != partition.cursors.end(); ++i ) {
+                PlanExecutor* exec = i->second.cursor->getExecutor();
+                if ( exec ) {
+                    exec->invalidate(txn, dl, type);
+                }
             }
         }
     }
 
     std::size_t CursorManager::timeoutCursors( int millisSinceLastCall ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        const long long now = _clockMillis.addAndFetch( millisSinceLastCall );
 
+        std::size_t numTimedOut = 0;
+        vector<CursorId> due;
         vector<ClientCursor*> toDelete;
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            ClientCursor* cc = i->second;
-            if ( cc->shouldTimeout( millisSinceLastCall ) )
-                toDelete.push_back( cc );
-        }
+        for ( int p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
 
-        for ( vector<ClientCursor*>::const_iterator i = toDelete.begin();
-                i != toDelete.end(); ++i ) {
-            ClientCursor* cc = *i;
-            _deregisterCursor_inlock( cc );
-            cc->kill();
-            delete cc;
+            if ( !partition.timeouts ) {
+                continue;
+            }
+
+            due.clear();
+            partition.timeouts->advance( now, &due );
+
+            toDelete.clear();
+            for ( vector<CursorId>::const_iterator i = due.begin(); i != due.end(); ++i ) {
+                CursorMap::iterator it = partition.cursors.find( *i );
+                invariant( it != partition.cursors.end() );
+                it->second.hasTimeout = false;
+
+                // The cursor may have been used since it was put on the wheel, in which case it
+                // goes back on it for the rest of its idle time. Cursors in use when they come
+                // up are checked again a whole timeout later.
+                ClientCursor* cc = it->second.cursor;
+                if ( cc->shouldTimeout( 0 ) ) {
+                    toDelete.push_back( cc );
+                }
+                else {
+                    _scheduleTimeout_inlock( &partition, *i, &it->second, now );
+                }
+            }
+
+            for ( vector<ClientCursor*>::const_iterator i = toDelete.begin();
+                    i != toDelete.end(); ++i ) {
+                ClientCursor* cc = *i;
+                _deregisterCursor_inlock( &partition, cc );
+                cc->kill();
+                delete cc;
+            }
+
+            numTimedOut += toDelete.size();
         }
 
-        return toDelete.size();
+        return numTimedOut;
     }
 
     void CursorManager::registerExecutor( PlanExecutor* exec ) {
-        SimpleMutex::scoped_lock lk(_mutex);
+        SimpleMutex::scoped_lock lk(_executorsMutex);
         const std::pair<ExecSet::iterator, bool> result = _nonCachedExecutors.insert(exec);
         invariant(result.second); // make sure this was inserted
     }
 
     void CursorManager::deregisterExecutor( PlanExecutor* exec ) {
-        SimpleMutex::scoped_lock lk(_mutex);
+        SimpleMutex::scoped_lock lk(_executorsMutex);
         _nonCachedExecutors.erase(exec);
     }
 
     ClientCursor* CursorManager::find( CursorId id, bool pin ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        CursorMap::const_iterator it = _cursors.find( id );
-        if ( it == _cursors.end() )
+        Partition& partition = _partitionFor( id );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        CursorMap::const_iterator it = partition.cursors.find( id );
+        if ( it == partition.cursors.end() )
             return NULL;
 
-        ClientCursor* cursor = it->second;
+        ClientCursor* cursor = it->second.cursor;
         if ( pin ) {
             uassert( 12051,
                      "clientcursor already in use? driver problem?",
@@ -471,7 +527,8 @@ namespace mongo {
     }
 
     void CursorManager::unpin( ClientCursor* cursor ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        Partition& partition = _partitionFor( cursor->cursorid() );
+        SimpleMutex::scoped_lock lk( partition.mutex );
 
         invariant( cursor->isPinned() );
         cursor->unsetPinned();
@@ -482,47 +539,85 @@ namespace mongo {
     }
 
     void CursorManager::getCursorIds( std::set<CursorId>* openCursors ) const {
-        SimpleMutex::scoped_lock lk( _mutex );
+        for ( int p = 0; p < kNumPartitions; p++ ) {
+            const Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            ClientCursor* cc = i->second;
-            openCursors->insert( cc->cursorid() );
+            for ( CursorMap::const_iterator i = partition.cursors.begin();
+                  i != partition.cursors.end(); ++i ) {
+                openCursors->insert( i->first );
+            }
         }
     }
 
     size_t CursorManager::numCursors() const {
-        SimpleMutex::scoped_lock lk( _mutex );
-        return _cursors.size();
+        size_t num = 0;
+        for ( int p = 0; p < kNumPartitions; p++ ) {
+            const Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
+            num += partition.cursors.size();
+        }
+        return num;
     }
 
-    CursorId CursorManager::_allocateCursorId_inlock() {
+    CursorId CursorManager::_allocateCursorId_inlock( Partition* partition,
+                                                      unsigned partitionIndex ) {
         for ( int i = 0; i < 10000; i++ ) {
-            unsigned mypart = static_cast<unsigned>( _random->nextInt32() );
+            // The low bits pick the partition, the rest are random
+            unsigned mypart = static_cast<unsigned>( partition->random->nextInt32() );
+            mypart = ( mypart & ~static_cast<unsigned>( kNumPartitions - 1 ) ) | partitionIndex;
             CursorId id = cursorIdFromParts( _collectionCacheRuntimeId, mypart );
-            if ( _cursors.count( id ) == 0 )
+            if ( partition->cursors.count( id ) == 0 )
                 return id;
         }
         fassertFailed( 17360 );
     }
 
+    void CursorManager::_scheduleTimeout_inlock( Partition* partition,
+                                                 CursorId id,
+                                                 CursorEntry* entry,
+                                                 long long now ) {
+        invariant( !entry->hasTimeout );
+        if ( entry->cursor->isNoTimeout() ) {
+            return;
+        }
+
+        if ( !partition->timeouts ) {
+            // Ticks of one second are plenty for timeouts of minutes checked every few seconds
+            partition->timeouts.reset( new TimeoutWheel( 1000, now ) );
+        }
+
+        // Due just after the idle time runs out
+        const long long idle = entry->cursor->isPinned() ? 0 : entry->cursor->idleTime();
+        const long long remaining = std::max( ClientCursor::kIdleTimeoutMillis - idle, 0LL );
+        entry->timeout = partition->timeouts->schedule( now + remaining + 1, id );
+        entry->hasTimeout = true;
+    }
+
     CursorId CursorManager::registerCursor( ClientCursor* cc ) {
         invariant( cc );
-        SimpleMutex::scoped_lock lk( _mutex );
-        CursorId id = _allocateCursorId_inlock();
-        _cursors[id] = cc;
+        const unsigned partitionIndex = _nextPartition.fetchAndAdd( 1 ) % kNumPartitions;
+        Partition& partition = _partitions[partitionIndex];
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        CursorId id = _allocateCursorId_inlock( &partition, partitionIndex );
+        CursorEntry& entry = partition.cursors[id];
+        entry.cursor = cc;
+        _scheduleTimeout_inlock( &partition, id, &entry, clockMillis() );
         return id;
     }
 
     void CursorManager::deregisterCursor( ClientCursor* cc ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        _deregisterCursor_inlock( cc );
+        Partition& partition = _partitionFor( cc->cursorid() );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        _deregisterCursor_inlock( &partition, cc );
     }
 
     bool CursorManager::eraseCursor(OperationContext* txn, CursorId id, bool checkAuth) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        Partition& partition = _partitionFor( id );
+        SimpleMutex::scoped_lock lk( partition.mutex );
 
-        CursorMap::iterator it = _cursors.find( id );
-        if ( it == _cursors.end() ) {
+        CursorMap::iterator it = partition.cursors.find( id );
+        if ( it == partition.cursors.end() ) {
             if ( checkAuth )
                 audit::logKillCursorsAuthzCheck( txn->getClient(),
                                                  _nss,
@@ -531,7 +626,7 @@ namespace mongo {
             return false;
         }
 
-        ClientCursor* cursor = it->second;
+        ClientCursor* cursor = it->second.cursor;
 
         if ( checkAuth )
             audit::logKillCursorsAuthzCheck( txn->getClient(),
@@ -544,15 +639,21 @@ namespace mongo {
                  !cursor->isPinned() );
 
         cursor->kill();
-        _deregisterCursor_inlock( cursor );
+        _deregisterCursor_inlock( &partition, cursor );
         delete cursor;
         return true;
     }
 
-    void CursorManager::_deregisterCursor_inlock( ClientCursor* cc ) {
+    void CursorManager::_deregisterCursor_inlock( Partition* partition, ClientCursor* cc ) {
         invariant( cc );
-        CursorId id = cc->cursorid();
-        _cursors.erase( id );
+        CursorMap::iterator it = partition->cursors.find( cc->cursorid() );
+        if ( it == partition->cursors.end() ) {
+            return;
+        }
+        if ( it->second.hasTimeout ) {
+            partition->timeouts->cancel( it->second.timeout );
+        }
+        partition->cursors.erase( it );
     }
 
 }
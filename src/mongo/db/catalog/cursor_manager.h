@@ -36,8 +36,11 @@
 #include "mongo/db/invalidation_type.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/record_id.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/unordered_map.h"
 #include "mongo/platform/unordered_set.h"
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/timer_wheel.h"
 
 namespace mongo {
 
@@ -45,6 +48,14 @@ namespace mongo {
     class PseudoRandom;
     class PlanExecutor;
 
+    /**
+     * Keeps the cursors and yielding executors of a collection, or the global ones.
+     *
+     * The cursors are split into partitions by cursor id, each with its own lock, so registering,
+     * pinning and timing out cursors of one busy collection don't all contend on one mutex. Each
+     * partition also keeps a timer wheel of when its cursors would time out, so a timeout pass
+     * only looks at cursors that are due rather than at all of them.
+     */
     class CursorManager {
     public:
         CursorManager( const StringData& ns );
@@ -78,6 +89,11 @@ namespace mongo {
          */
         std::size_t timeoutCursors( int millisSinceLastCall );
 
+        /**
+         * The clock cursor idle times are measured on, moved forward by timeoutCursors().
+         */
+        long long clockMillis() const { return _clockMillis.load(); }
+
         // -----------------
 
         /**
@@ -136,20 +152,61 @@ namespace mongo {
         static std::size_t timeoutCursorsGlobal(OperationContext* txn, int millisSinceLastCall);
 
     private:
-        CursorId _allocateCursorId_inlock();
-        void _deregisterCursor_inlock( ClientCursor* cc );
+        typedef TimerWheel<CursorId> TimeoutWheel;
+
+        struct CursorEntry {
+            CursorEntry() : cursor( NULL ), hasTimeout( false ) {}
+
+            ClientCursor* cursor;
+
+            // Whether the cursor is on the timeout wheel of its partition, at 'timeout'
+            bool hasTimeout;
+            TimeoutWheel::Handle timeout;
+        };
+
+        typedef unordered_map<CursorId, CursorEntry> CursorMap;
+
+        struct Partition {
+            Partition();
+            ~Partition();
+
+            mutable SimpleMutex mutex;
+            CursorMap cursors;
+
+            // Created with the first cursor which can time out
+            boost::scoped_ptr<TimeoutWheel> timeouts;
+
+            // Picks the ids of the cursors registered in this partition
+            boost::scoped_ptr<PseudoRandom> random;
+        };
+
+        static const int kPartitionBits = 4;
+        static const int kNumPartitions = 1 << kPartitionBits;
+
+        Partition& _partitionFor( CursorId id ) {
+            return _partitions[ static_cast<unsigned>( id ) & ( kNumPartitions - 1 ) ];
+        }
+
+        CursorId _allocateCursorId_inlock( Partition* partition, unsigned partitionIndex );
+        void _scheduleTimeout_inlock( Partition* partition,
+                                      CursorId id,
+                                      CursorEntry* entry,
+                                      long long now );
+        void _deregisterCursor_inlock( Partition* partition, ClientCursor* cc );
 
         NamespaceString _nss;
         unsigned _collectionCacheRuntimeId;
-        boost::scoped_ptr<PseudoRandom> _random;
 
-        mutable SimpleMutex _mutex;
+        // Spreads the new cursors over the partitions
+        AtomicUInt32 _nextPartition;
+
+        AtomicInt64 _clockMillis;
 
+        mutable SimpleMutex _executorsMutex;
         typedef unordered_set<PlanExecutor*> ExecSet;
         ExecSet _nonCachedExecutors;
 
-        typedef std::map<CursorId,ClientCursor*> CursorMap;
-        CursorMap _cursors;
+        Partition _partitions[kNumPartitions];
     };
 
 }
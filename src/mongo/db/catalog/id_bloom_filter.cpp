@@ -0,0 +1,430 @@
+// id_bloom_filter.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/catalog/id_bloom_filter.h"
+
+#include <algorithm>
+#include <list>
+#include <set>
+#include <string>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/database_catalog_entry.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/hasher.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/query/internal_plans.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/recovery_unit.h"
+#include "mongo/util/background.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    // Gives every collection an in-memory filter of its _id values, which _id lookups check
+    // before the _id index.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(idBloomFilterEnabled, bool, false);
+
+    // How often the builder looks for _id filters to build or rebuild.
+    MONGO_EXPORT_SERVER_PARAMETER(idBloomFilterBuildIntervalSecs, int, 10);
+
+    namespace {
+
+        Counter64 idFilterNegatives;
+        ServerStatusMetricField<Counter64> idFilterNegativesDisplay("idBloomFilter.negatives",
+                                                                     &idFilterNegatives);
+        Counter64 idFilterBuilds;
+        ServerStatusMetricField<Counter64> idFilterBuildsDisplay("idBloomFilter.builds",
+                                                                  &idFilterBuilds);
+
+        // Filters are built for at least this many _ids, and for twice the collection's size.
+        const long long kMinCapacity = 1024;
+
+        const int kNumHashes = 4;
+
+        // How many hashes the build reads from the index before adding them under the mutex.
+        const size_t kBuildBatchSize = 1024;
+
+    }  // namespace
+
+    /**
+     * A counting Bloom filter of one byte counters, about eight per _id of capacity.
+     */
+    class IdBloomFilter::Counters {
+    public:
+        explicit Counters(long long capacity) : _capacity(capacity) {
+            // A power of two number of counters.
+            size_t numCounters = 64;
+            while (numCounters < static_cast<size_t>(capacity) * 8) {
+                numCounters *= 2;
+            }
+            _counts.assign(numCounters, 0);
+        }
+
+        void add(uint64_t hash) {
+            const uint64_t mask = _counts.size() - 1;
+            uint64_t h1 = hash;
+            const uint64_t h2 = (hash >> 32) | 1;
+            for (int i = 0; i < kNumHashes; ++i, h1 += h2) {
+                unsigned char& count = _counts[h1 & mask];
+                if (count != kSaturated) {
+                    ++count;
+                }
+            }
+        }
+
+        void remove(uint64_t hash) {
+            const uint64_t mask = _counts.size() - 1;
+            uint64_t h1 = hash;
+            const uint64_t h2 = (hash >> 32) | 1;
+            for (int i = 0; i < kNumHashes; ++i, h1 += h2) {
+                unsigned char& count = _counts[h1 & mask];
+                if (count != kSaturated && count != 0) {
+                    --count;
+                }
+            }
+        }
+
+        bool mayContain(uint64_t hash) const {
+            const uint64_t mask = _counts.size() - 1;
+            uint64_t h1 = hash;
+            const uint64_t h2 = (hash >> 32) | 1;
+            for (int i = 0; i < kNumHashes; ++i, h1 += h2) {
+                if (0 == _counts[h1 & mask]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        long long capacity() const { return _capacity; }
+
+    private:
+        static const unsigned char kSaturated = 255;
+
+        const long long _capacity;
+        std::vector<unsigned char> _counts;
+    };
+
+    /**
+     * Adds an inserted _id again when the insert commits, so that a filter which started being
+     * built or used after the insert began still has it.
+     */
+    class IdBloomFilter::CommitInsertChange : public RecoveryUnit::Change {
+    public:
+        CommitInsertChange(IdBloomFilter* filter, uint64_t hash)
+            : _filter(filter), _hash(hash) { }
+
+        virtual void commit() { _filter->_add(_hash); }
+        virtual void rollback() { }
+
+    private:
+        IdBloomFilter* const _filter;
+        const uint64_t _hash;
+    };
+
+    /**
+     * Takes a deleted _id out when the delete commits.
+     */
+    class IdBloomFilter::CommitDeleteChange : public RecoveryUnit::Change {
+    public:
+        CommitDeleteChange(IdBloomFilter* filter, uint64_t hash, unsigned long long generation)
+            : _filter(filter), _hash(hash), _generation(generation) { }
+
+        virtual void commit() { _filter->_removeIfGeneration(_hash, _generation); }
+        virtual void rollback() { }
+
+    private:
+        IdBloomFilter* const _filter;
+        const uint64_t _hash;
+        const unsigned long long _generation;
+    };
+
+    IdBloomFilter::IdBloomFilter() : _mutex("IdBloomFilter"), _generation(0) { }
+
+    IdBloomFilter::~IdBloomFilter() { }
+
+    // static
+    bool IdBloomFilter::enabled() {
+        return idBloomFilterEnabled;
+    }
+
+    // static
+    uint64_t IdBloomFilter::hashId(const BSONElement& id) {
+        // Hashed the way hashed indexes hash, so _ids which compare equal but are stored with
+        // different numeric types hash the same.
+        return static_cast<uint64_t>(
+            BSONElementHasher::hash64(id, BSONElementHasher::DEFAULT_HASH_SEED));
+    }
+
+    bool IdBloomFilter::mayContain(const BSONElement& id) const {
+        const uint64_t hash = hashId(id);
+        SimpleMutex::scoped_lock lk(_mutex);
+        if (!_active || _active->mayContain(hash)) {
+            return true;
+        }
+        idFilterNegatives.increment();
+        return false;
+    }
+
+    void IdBloomFilter::onInsert(OperationContext* txn, const BSONElement& id) {
+        if (id.eoo()) {
+            return;
+        }
+        const uint64_t hash = hashId(id);
+        _add(hash);
+        txn->recoveryUnit()->registerChange(new CommitInsertChange(this, hash));
+    }
+
+    void IdBloomFilter::onDelete(OperationContext* txn, const BSONElement& id) {
+        if (id.eoo()) {
+            return;
+        }
+        const uint64_t hash = hashId(id);
+        unsigned long long generation;
+        {
+            SimpleMutex::scoped_lock lk(_mutex);
+            if (!_active) {
+                return;
+            }
+            generation = _generation;
+        }
+        txn->recoveryUnit()->registerChange(new CommitDeleteChange(this, hash, generation));
+    }
+
+    void IdBloomFilter::_add(uint64_t hash) {
+        SimpleMutex::scoped_lock lk(_mutex);
+        if (_active) {
+            _active->add(hash);
+        }
+        if (_building) {
+            _building->add(hash);
+        }
+    }
+
+    void IdBloomFilter::_removeIfGeneration(uint64_t hash, unsigned long long generation) {
+        SimpleMutex::scoped_lock lk(_mutex);
+        // A filter built since the delete may never have had this _id, and taking it out would
+        // clear counters other _ids rely on.
+        if (_active && generation == _generation) {
+            _active->remove(hash);
+        }
+    }
+
+    bool IdBloomFilter::needsBuild(long long numRecords) const {
+        SimpleMutex::scoped_lock lk(_mutex);
+        if (_building) {
+            return false;
+        }
+        return !_active || numRecords > _active->capacity();
+    }
+
+    bool IdBloomFilter::startBuild(long long numRecords) {
+        SimpleMutex::scoped_lock lk(_mutex);
+        if (_building) {
+            return false;
+        }
+        _building.reset(new Counters(std::max(kMinCapacity, numRecords * 2)));
+        return true;
+    }
+
+    void IdBloomFilter::addBuilt(const std::vector<uint64_t>& hashes) {
+        SimpleMutex::scoped_lock lk(_mutex);
+        invariant(_building);
+        for (std::vector<uint64_t>::const_iterator it = hashes.begin(); it != hashes.end(); ++it) {
+            _building->add(*it);
+        }
+    }
+
+    void IdBloomFilter::finishBuild() {
+        SimpleMutex::scoped_lock lk(_mutex);
+        invariant(_building);
+        _active.swap(_building);
+        _building.reset();
+        ++_generation;
+        idFilterBuilds.increment();
+    }
+
+    void IdBloomFilter::abortBuild() {
+        SimpleMutex::scoped_lock lk(_mutex);
+        _building.reset();
+    }
+
+    namespace {
+
+        /**
+         * Stops the build of the _id filter of 'collection' after its scan was killed.  A yield
+         * may have let the collection be dropped, so this only touches the filter if 'ns' still
+         * names the same collection.
+         */
+        void abortBuildIfStillThere(OperationContext* txn,
+                                    const std::string& ns,
+                                    Collection* collection) {
+            Database* db = dbHolder().get(txn, ns);
+            if (db && db->getCollection(ns) == collection) {
+                collection->idBloomFilter()->abortBuild();
+            }
+        }
+
+        /**
+         * Builds the _id filter of the collection 'ns' if it needs it.  The scan of the _id
+         * index yields, so the collection may be dropped under it.
+         */
+        void buildIdFilter(OperationContext* txn, const std::string& ns) {
+            AutoGetCollectionForRead ctx(txn, ns);
+            Collection* collection = ctx.getCollection();
+            if (!collection || !collection->idBloomFilter()) {
+                return;
+            }
+
+            IdBloomFilter* filter = collection->idBloomFilter();
+            const IndexDescriptor* idDesc = collection->getIndexCatalog()->findIdIndex(txn);
+            if (!idDesc || !filter->needsBuild(collection->numRecords(txn))) {
+                return;
+            }
+
+            if (!filter->startBuild(collection->numRecords(txn))) {
+                return;
+            }
+
+            boost::scoped_ptr<PlanExecutor> exec(InternalPlanner::indexScan(txn,
+                                                                            collection,
+                                                                            idDesc,
+                                                                            BSONObj(),
+                                                                            BSONObj(),
+                                                                            false));
+            exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
+
+            PlanExecutor::ExecState state;
+            try {
+                std::vector<uint64_t> hashes;
+                hashes.reserve(kBuildBatchSize);
+                BSONObj key;
+                while (PlanExecutor::ADVANCED == (state = exec->getNext(&key, NULL))) {
+                    hashes.push_back(IdBloomFilter::hashId(key.firstElement()));
+                    if (hashes.size() == kBuildBatchSize) {
+                        filter->addBuilt(hashes);
+                        hashes.clear();
+                    }
+                }
+
+                if (PlanExecutor::IS_EOF == state) {
+                    filter->addBuilt(hashes);
+                    filter->finishBuild();
+                    LOG(1) << "built _id filter for " << ns;
+                    return;
+                }
+            }
+            catch (...) {
+                abortBuildIfStillThere(txn, ns, collection);
+                throw;
+            }
+
+            abortBuildIfStillThere(txn, ns, collection);
+        }
+
+        class IdBloomFilterBuilder : public BackgroundJob {
+        public:
+            IdBloomFilterBuilder() : BackgroundJob(true /* selfDelete */) { }
+
+            virtual std::string name() const { return "IdBloomFilterBuilder"; }
+
+            virtual void run() {
+                Client::initThread(name().c_str());
+                cc().getAuthorizationSession()->grantInternalAuthorization();
+
+                while (!inShutdown()) {
+                    buildAll();
+                    for (int i = 0;
+                         i < std::max(idBloomFilterBuildIntervalSecs, 1) && !inShutdown();
+                         i++) {
+                        sleepsecs(1);
+                    }
+                }
+            }
+
+        private:
+            void buildAll() {
+                OperationContextImpl txn;
+
+                std::set<std::string> dbs;
+                dbHolder().getAllShortNames(dbs);
+
+                for (std::set<std::string>::const_iterator i = dbs.begin();
+                     i != dbs.end() && !inShutdown();
+                     ++i) {
+                    std::list<std::string> namespaces;
+                    {
+                        ScopedTransaction transaction(&txn, MODE_IS);
+                        Lock::DBLock dbLock(txn.lockState(), *i, MODE_IS);
+                        Database* db = dbHolder().get(&txn, *i);
+                        if (!db) {
+                            continue;
+                        }
+                        db->getDatabaseCatalogEntry()->getCollectionNamespaces(&namespaces);
+                    }
+
+                    for (std::list<std::string>::const_iterator ns = namespaces.begin();
+                         ns != namespaces.end() && !inShutdown();
+                         ++ns) {
+                        try {
+                            buildIdFilter(&txn, *ns);
+                        }
+                        catch (const DBException& e) {
+                            warning() << "failed to build _id filter for " << *ns << ": "
+                                      << e.toString();
+                        }
+                    }
+                }
+            }
+        };
+
+    }  // namespace
+
+    void startIdBloomFilterBuilder() {
+        if (!idBloomFilterEnabled) {
+            return;
+        }
+        (new IdBloomFilterBuilder())->go();
+    }
+
+} // namespace mongo
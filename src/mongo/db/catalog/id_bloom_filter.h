@@ -0,0 +1,139 @@
+// id_bloom_filter.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/scoped_ptr.hpp>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonelement.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    class OperationContext;
+
+    /**
+     * An in-memory counting Bloom filter over the _id values of one collection, which lets an
+     * _id point lookup that misses skip the _id index.  It answers "maybe" or "definitely not".
+     *
+     * Inserts are added as they happen and again when they commit, so a document is in the
+     * filter from before it becomes visible.  Deletes are taken out when they commit, unless the
+     * filter was rebuilt in the meantime, in which case the stale entry is left as a false
+     * positive.  Counters saturate and are then never decremented.
+     *
+     * The filter starts out unbuilt, and lookups only consult it once the background builder
+     * (see startIdBloomFilterBuilder) has scanned the _id index into it.  Writes that happen
+     * during the scan go to the filter being built as well.  The builder rebuilds a filter that
+     * has grown past its capacity.
+     *
+     * Only collections of a mongod started with idBloomFilterEnabled have one.  Threadsafe.
+     */
+    class IdBloomFilter {
+        MONGO_DISALLOW_COPYING(IdBloomFilter);
+    public:
+        IdBloomFilter();
+        ~IdBloomFilter();
+
+        /**
+         * Returns false only if no document with _id 'id' exists.  Always true until the filter
+         * has been built.
+         */
+        bool mayContain(const BSONElement& id) const;
+
+        /**
+         * Called when a document with _id 'id' is inserted in 'txn'.
+         */
+        void onInsert(OperationContext* txn, const BSONElement& id);
+
+        /**
+         * Called when a document with _id 'id' is deleted in 'txn'.
+         */
+        void onDelete(OperationContext* txn, const BSONElement& id);
+
+        /**
+         * Whether the builder should (re)build this filter for a collection of 'numRecords'.
+         */
+        bool needsBuild(long long numRecords) const;
+
+        /**
+         * Starts building a fresh filter sized for 'numRecords'.  Returns false if a build is
+         * already running.  Until finishBuild() or abortBuild(), inserts go to both filters.
+         */
+        bool startBuild(long long numRecords);
+
+        /**
+         * Adds the _id hashes read from the index by the build.
+         */
+        void addBuilt(const std::vector<uint64_t>& hashes);
+
+        /**
+         * Starts using the filter just built for lookups.
+         */
+        void finishBuild();
+
+        void abortBuild();
+
+        static uint64_t hashId(const BSONElement& id);
+
+        /**
+         * Whether collections have an _id filter in this process.
+         */
+        static bool enabled();
+
+    private:
+        class Counters;
+        class CommitInsertChange;
+        class CommitDeleteChange;
+
+        void _add(uint64_t hash);
+        void _removeIfGeneration(uint64_t hash, unsigned long long generation);
+
+        // Guards everything below.
+        mutable SimpleMutex _mutex;
+
+        // The filter lookups consult, or NULL before the first build.
+        boost::scoped_ptr<Counters> _active;
+
+        // The filter being built, or NULL when no build is running.
+        boost::scoped_ptr<Counters> _building;
+
+        // Bumped each time a built filter replaces _active.
+        unsigned long long _generation;
+    };
+
+    /**
+     * Starts the thread which builds and rebuilds the _id filters of all collections, if
+     * idBloomFilterEnabled is set.
+     */
+    void startIdBloomFilterBuilder();
+
+} // namespace mongo
@@ -34,8 +34,10 @@
 
 #include "mongo/db/catalog/index_catalog.h"
 
+#include <boost/scoped_ptr.hpp>
 #include <vector>
 
+#include "mongo/bson/bson_field_index.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/background.h"
 #include "mongo/db/catalog/collection_catalog_entry.h"
@@ -48,12 +50,15 @@
 #include "mongo/db/curop.h"
 #include "mongo/db/field_ref.h"
 #include "mongo/db/global_environment_experiment.h"
+#include "mongo/db/hasher.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/index_legacy.h"
 #include "mongo/db/index_names.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/keypattern.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/ops/delete.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
@@ -503,6 +508,42 @@ namespace {
     }
 
 
+    namespace {
+        /**
+         * A partialFilterExpression may only use the expressions the query planner can tell a
+         * query implies: comparisons, {$exists: true} and $type, under a top-level $and.
+         */
+        Status checkPartialFilterExpression( const MatchExpression* expr, int level ) {
+            switch ( expr->matchType() ) {
+            case MatchExpression::AND:
+                if ( level > 0 ) {
+                    return Status( ErrorCodes::CannotCreateIndex,
+                                   "$and is only supported at the top level of a "
+                                   "partialFilterExpression" );
+                }
+                for ( size_t i = 0; i < expr->numChildren(); i++ ) {
+                    Status status = checkPartialFilterExpression( expr->getChild( i ),
+                                                                  level + 1 );
+                    if ( !status.isOK() )
+                        return status;
+                }
+                return Status::OK();
+            case MatchExpression::EQ:
+            case MatchExpression::LT:
+            case MatchExpression::LTE:
+            case MatchExpression::GT:
+            case MatchExpression::GTE:
+            case MatchExpression::EXISTS:
+            case MatchExpression::TYPE_OPERATOR:
+                return Status::OK();
+            default:
+                return Status( ErrorCodes::CannotCreateIndex,
+                               str::stream() << "unsupported expression in partialFilterExpression: "
+                                             << expr->toString() );
+            }
+        }
+    }
+
     Status IndexCatalog::_isSpecOk( const BSONObj& spec ) const {
 
         const NamespaceString& nss = _collection->ns();
@@ -564,6 +605,13 @@ namespace {
                                          << keyStatus.reason() );
         }
 
+        BSONElement hashVersionElt = spec["hashVersion"];
+        if ( !hashVersionElt.eoo() &&
+             ( !hashVersionElt.isNumber() || !isValidHashVersion( hashVersionElt.numberInt() ) ) ) {
+            return Status( ErrorCodes::CannotCreateIndex,
+                           str::stream() << "unsupported hash version " << hashVersionElt );
+        }
+
         if ( IndexDescriptor::isIdIndexPattern( key ) ) {
             BSONElement uniqueElt = spec["unique"];
             if ( !uniqueElt.eoo() && !uniqueElt.trueValue() ) {
@@ -579,6 +627,33 @@ namespace {
             }
         }
 
+        BSONElement filterElement = spec.getField("partialFilterExpression");
+        if ( !filterElement.eoo() ) {
+            if ( filterElement.type() != Object ) {
+                return Status( ErrorCodes::CannotCreateIndex,
+                               "'partialFilterExpression' for an index has to be a document" );
+            }
+            if ( IndexDescriptor::isIdIndexPattern( key ) ) {
+                return Status( ErrorCodes::CannotCreateIndex,
+                               "the _id index cannot be a partial index" );
+            }
+            if ( spec["sparse"].trueValue() ) {
+                return Status( ErrorCodes::CannotCreateIndex,
+                               "cannot mix \"partialFilterExpression\" and \"sparse\" options" );
+            }
+
+            StatusWithMatchExpression parsed = MatchExpressionParser::parse( filterElement.Obj() );
+            if ( !parsed.isOK() ) {
+                return Status( ErrorCodes::CannotCreateIndex,
+                               str::stream() << "bad partialFilterExpression: "
+                                             << parsed.getStatus().reason() );
+            }
+            boost::scoped_ptr<MatchExpression> filterExpr( parsed.getValue() );
+            Status filterStatus = checkPartialFilterExpression( filterExpr.get(), 0 );
+            if ( !filterStatus.isOK() )
+                return filterStatus;
+        }
+
         BSONElement storageEngineElement = spec.getField("storageEngine");
         if (storageEngineElement.eoo()) {
             return Status::OK();
@@ -997,6 +1072,10 @@ namespace {
             if ( !keyPattern.isPrefixOf( desc->keyPattern() ) )
                 continue;
 
+            // Callers scan ranges of the collection, which a partial index may not hold.
+            if ( desc->isPartial() )
+                continue;
+
             if( !desc->isMultikey( txn ) )
                 return desc;
 
@@ -1085,6 +1164,11 @@ namespace {
                                       IndexCatalogEntry* index,
                                       const BSONObj& obj,
                                       const RecordId &loc ) {
+        const MatchExpression* filter = index->getFilterExpression();
+        if ( filter && !filter->matchesBSON( obj ) ) {
+            return Status::OK();
+        }
+
         InsertDeleteOptions options;
         options.logIfError = false;
         options.dupsAllowed = isDupsAllowed( index->descriptor() );
@@ -1098,6 +1182,11 @@ namespace {
                                         const BSONObj& obj,
                                         const RecordId &loc,
                                         bool logIfError) {
+        const MatchExpression* filter = index->getFilterExpression();
+        if ( filter && !filter->matchesBSON( obj ) ) {
+            return Status::OK();
+        }
+
         InsertDeleteOptions options;
         options.logIfError = logIfError;
         options.dupsAllowed = isDupsAllowed( index->descriptor() );
@@ -1119,6 +1208,10 @@ namespace {
                                    const BSONObj& obj,
                                    const RecordId &loc ) {
 
+        // Each index looks up its key fields in the same document.
+        BSONFieldIndex fields(obj);
+        BSONFieldIndex::Scope fieldsScope(fields);
+
         for ( IndexCatalogEntryContainer::const_iterator i = _entries.begin();
               i != _entries.end();
               ++i ) {
@@ -1130,6 +1223,50 @@ namespace {
         return Status::OK();
     }
 
+    Status IndexCatalog::indexRecords(OperationContext* txn,
+                                      const std::vector<BSONObj>& docs,
+                                      const std::vector<RecordId>& locs) {
+        invariant(docs.size() == locs.size());
+
+        // Each index looks up its key fields in the same documents: keep their field tables
+        // across indexes.
+        std::vector<BSONFieldIndex> fields(docs.begin(), docs.end());
+
+        std::vector<const BSONFieldIndex*> indexDocs;
+        std::vector<RecordId> indexLocs;
+        for ( IndexCatalogEntryContainer::const_iterator i = _entries.begin();
+              i != _entries.end();
+              ++i ) {
+            IndexCatalogEntry* index = *i;
+            const MatchExpression* filter = index->getFilterExpression();
+
+            indexDocs.clear();
+            indexLocs.clear();
+            for (size_t j = 0; j < docs.size(); j++) {
+                if ( filter && !filter->matchesBSON( docs[j] ) ) {
+                    continue;
+                }
+                indexDocs.push_back(&fields[j]);
+                indexLocs.push_back(locs[j]);
+            }
+            if (indexDocs.empty()) {
+                continue;
+            }
+
+            InsertDeleteOptions options;
+            options.logIfError = false;
+            options.dupsAllowed = isDupsAllowed( index->descriptor() );
+
+            int64_t inserted;
+            Status s = index->accessMethod()->insertMany(txn, indexDocs, indexLocs, options,
+                                                         &inserted);
+            if (!s.isOK())
+                return s;
+        }
+
+        return Status::OK();
+    }
+
     void IndexCatalog::unindexRecord(OperationContext* txn,
                                      const BSONObj& obj,
                                      const RecordId& loc,
@@ -1147,6 +1284,51 @@ namespace {
         }
     }
 
+    void IndexCatalog::unindexRecords(OperationContext* txn,
+                                      const std::vector<BSONObj>& docs,
+                                      const std::vector<RecordId>& locs,
+                                      bool noWarn) {
+        invariant(docs.size() == locs.size());
+
+        std::vector<BSONFieldIndex> fields(docs.begin(), docs.end());
+
+        std::vector<const BSONFieldIndex*> indexDocs;
+        std::vector<RecordId> indexLocs;
+        for ( IndexCatalogEntryContainer::const_iterator i = _entries.begin();
+              i != _entries.end();
+              ++i ) {
+            IndexCatalogEntry* index = *i;
+            const MatchExpression* filter = index->getFilterExpression();
+
+            indexDocs.clear();
+            indexLocs.clear();
+            for (size_t j = 0; j < docs.size(); j++) {
+                if ( filter && !filter->matchesBSON( docs[j] ) ) {
+                    continue;
+                }
+                indexDocs.push_back(&fields[j]);
+                indexLocs.push_back(locs[j]);
+            }
+            if (indexDocs.empty()) {
+                continue;
+            }
+
+            // If it's a background index, we DO NOT want to log anything.
+            InsertDeleteOptions options;
+            options.logIfError = index->isReady(txn) ? !noWarn : false;
+            options.dupsAllowed = isDupsAllowed( index->descriptor() );
+
+            int64_t removed;
+            Status status = index->accessMethod()->removeMany(txn, indexDocs, indexLocs, options,
+                                                              &removed);
+            if ( !status.isOK() ) {
+                log() << "Couldn't unindex " << indexDocs.size() << " records"
+                      << " from collection " << _collection->ns()
+                      << ". Status: " << status.toString();
+            }
+        }
+    }
+
     BSONObj IndexCatalog::fixIndexKey( const BSONObj& key ) {
         if ( IndexDescriptor::isIdIndexPattern( key ) ) {
             return _idObj;
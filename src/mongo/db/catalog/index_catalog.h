@@ -99,7 +99,8 @@ namespace mongo {
 
         /* Returns the index entry for the first index whose prefix contains
          * 'keyPattern'. If 'requireSingleKey' is true, skip indices that contain
-         * array attributes. Otherwise, returns NULL.
+         * array attributes. Otherwise, returns NULL. Partial indexes are never returned, since
+         * they may not hold every document in a range of 'keyPattern'.
          */
         IndexDescriptor* findIndexByPrefix( OperationContext* txn,
                                             const BSONObj &keyPattern,
@@ -289,11 +290,28 @@ namespace mongo {
         // this throws for now
         Status indexRecord(OperationContext* txn, const BSONObj& obj, const RecordId &loc);
 
+        /**
+         * Indexes a batch of documents, where locs[i] is the RecordId of docs[i].  Each index
+         * is updated for the whole batch before moving on to the next one.
+         */
+        Status indexRecords(OperationContext* txn,
+                            const std::vector<BSONObj>& docs,
+                            const std::vector<RecordId>& locs);
+
         void unindexRecord(OperationContext* txn,
                            const BSONObj& obj,
                            const RecordId& loc,
                            bool noWarn);
 
+        /**
+         * Unindexes a batch of documents, where locs[i] is the RecordId of docs[i].  Each index
+         * is updated for the whole batch before moving on to the next one.
+         */
+        void unindexRecords(OperationContext* txn,
+                            const std::vector<BSONObj>& docs,
+                            const std::vector<RecordId>& locs,
+                            bool noWarn);
+
         // ------- temp internal -------
 
         std::string getAccessMethodName(OperationContext* txn, const BSONObj& keyPattern) {
@@ -40,6 +40,8 @@
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/global_environment_experiment.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/util/file_allocator.h"
 #include "mongo/util/log.h"
@@ -79,6 +81,14 @@ namespace mongo {
           _isReady( false ) {
 
         _descriptor->_cachedEntry = this;
+
+        if ( descriptor->isPartial() ) {
+            // The filter was validated when the index was created.
+            const BSONObj filter = descriptor->infoObj().getObjectField("partialFilterExpression");
+            StatusWithMatchExpression parsed = MatchExpressionParser::parse( filter );
+            invariant( parsed.isOK() );
+            _filterExpression.reset( parsed.getValue() );
+        }
     }
 
     IndexCatalogEntry::~IndexCatalogEntry() {
@@ -97,6 +107,12 @@ namespace mongo {
         _isReady = _catalogIsReady( txn );
         _head = _catalogHead( txn );
         _isMultikey = _catalogIsMultikey( txn );
+        if ( _isMultikey ) {
+            _multikeyPaths = _collection->getIndexMultikeyPaths( txn, _descriptor->indexName() );
+            if ( _multikeyPaths.size() != static_cast<size_t>(_descriptor->getNumFields()) ) {
+                _multikeyPaths.clear();
+            }
+        }
     }
 
     const RecordId& IndexCatalogEntry::head( OperationContext* txn ) const {
@@ -113,6 +129,11 @@ namespace mongo {
         return _isMultikey;
     }
 
+    MultikeyPaths IndexCatalogEntry::getMultikeyPaths() const {
+        boost::mutex::scoped_lock lk(_multikeyPathsMutex);
+        return _multikeyPaths;
+    }
+
     // ---
 
     void IndexCatalogEntry::setIsReady( bool newIsReady ) {
@@ -172,8 +193,9 @@ namespace mongo {
         const boost::scoped_ptr<RecoveryUnit> _newRecoveryUnit;
     };
 
-    void IndexCatalogEntry::setMultikey(OperationContext* txn) {
-        if (isMultikey()) {
+    void IndexCatalogEntry::setMultikey(OperationContext* txn,
+                                        const MultikeyPaths& multikeyPaths) {
+        if (isMultikey() && !multikeyPathsWouldChange(getMultikeyPaths(), multikeyPaths)) {
             return;
         }
 
@@ -185,8 +207,13 @@ namespace mongo {
 
         // Check again in case we blocked on the MD lock and another thread beat us to setting the
         // multiKey metadata for this index.
+        MultikeyPaths newPaths = multikeyPaths;
         if (isMultikey()) {
-            return;
+            MultikeyPaths oldPaths = getMultikeyPaths();
+            if (!multikeyPathsWouldChange(oldPaths, multikeyPaths)) {
+                return;
+            }
+            mergeMultikeyPaths(&newPaths, oldPaths);
         }
 
         // This effectively emulates a sub-transaction off the main transaction, which invoked
@@ -198,17 +225,24 @@ namespace mongo {
 
             WriteUnitOfWork wuow(txn);
 
-            if (_collection->setIndexIsMultikey(txn, _descriptor->indexName())) {
-                if (_infoCache) {
-                    LOG(1) << _ns << ": clearing plan cache - index "
-                           << _descriptor->keyPattern() << " set to multi key.";
-                    _infoCache->clearQueryCache();
-                }
+            _collection->setIndexIsMultikey(txn, _descriptor->indexName());
+            _collection->setIndexMultikeyPaths(txn, _descriptor->indexName(), newPaths);
+
+            // Either the index just became multikey or more of its fields did, which changes
+            // the bounds the planner may build over it.
+            if (_infoCache) {
+                LOG(1) << _ns << ": clearing plan cache - index "
+                       << _descriptor->keyPattern() << " set to multi key.";
+                _infoCache->clearQueryCache();
             }
 
             wuow.commit();
         }
 
+        {
+            boost::mutex::scoped_lock lk(_multikeyPathsMutex);
+            _multikeyPaths = newPaths;
+        }
         _isMultikey = true;
     }
 
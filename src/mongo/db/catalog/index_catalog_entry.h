@@ -30,10 +30,13 @@
 
 #pragma once
 
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include <string>
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/bson/ordering.h"
+#include "mongo/db/index/multikey_paths.h"
 #include "mongo/db/record_id.h"
 
 namespace mongo {
@@ -43,6 +46,7 @@ namespace mongo {
     class HeadManager;
     class IndexAccessMethod;
     class IndexDescriptor;
+    class MatchExpression;
     class OperationContext;
 
     class IndexCatalogEntry {
@@ -68,6 +72,12 @@ namespace mongo {
 
         const Ordering& ordering() const { return _ordering; }
 
+        /**
+         * The partialFilterExpression of a partial index, which only holds the documents this
+         * matches. NULL for other indexes.
+         */
+        const MatchExpression* getFilterExpression() const { return _filterExpression.get(); }
+
         /// ---------------------
 
         const RecordId& head( OperationContext* txn ) const;
@@ -82,7 +92,17 @@ namespace mongo {
 
         bool isMultikey() const;
 
-        void setMultikey( OperationContext* txn );
+        /**
+         * Which fields of a multikey index are multikey. Empty if not known, or if the index
+         * isn't multikey.
+         */
+        MultikeyPaths getMultikeyPaths() const;
+
+        /**
+         * Marks the index multikey, with the fields in 'multikeyPaths' multikey on top of any
+         * already recorded. An empty 'multikeyPaths' makes every field multikey.
+         */
+        void setMultikey( OperationContext* txn, const MultikeyPaths& multikeyPaths );
 
         // if this ready is ready for queries
         bool isReady( OperationContext* txn ) const;
@@ -111,12 +131,17 @@ namespace mongo {
         // Owned here.
         HeadManager* _headManager;
 
+        boost::scoped_ptr<MatchExpression> _filterExpression;
+
         // cached stuff
 
         Ordering _ordering; // TODO: this might be b-tree specific
         bool _isReady; // cache of NamespaceDetails info
         RecordId _head; // cache of IndexDetails
         bool _isMultikey; // cache of NamespaceDetails info
+
+        mutable boost::mutex _multikeyPathsMutex; // protects _multikeyPaths
+        MultikeyPaths _multikeyPaths; // cache of the catalog's info, only set if _isMultikey
     };
 
     class IndexCatalogEntryContainer {
@@ -34,20 +34,28 @@
 
 #include "mongo/db/catalog/index_create.h"
 
+#include <algorithm>
+#include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "mongo/base/error_codes.h"
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/background.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/curop.h"
+#include "mongo/db/index/btree_based_bulk_access_method.h"
+#include "mongo/db/matcher/expression.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/query_yield.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/log.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
@@ -56,6 +64,55 @@ namespace mongo {
 
     using boost::scoped_ptr;
 
+    // Number of threads reading the collection and generating keys for a foreground index build,
+    // each into its own sorter. 0 or 1 does it all on the thread building the indexes.
+    MONGO_EXPORT_SERVER_PARAMETER(indexBuildParallelThreads, int, 0);
+
+namespace {
+
+    /**
+     * Generates the keys of the records of some iterators into one of the sorters of each index.
+     */
+    struct ParallelKeyGenerator {
+        ParallelKeyGenerator() : sorterIndex(0), numRecords(0), errorCode(0) {}
+
+        void run() {
+            try {
+                for (size_t i = 0; i < iterators.size(); i++) {
+                    RecordIterator* iterator = iterators[i];
+                    while (!iterator->isEOF()) {
+                        const RecordId loc = iterator->getNext();
+                        const BSONObj obj = iterator->dataFor(loc).toBson();
+                        for (size_t j = 0; j < bulks.size(); j++) {
+                            if (filters[j] && !filters[j]->matchesBSON(obj))
+                                continue;
+                            bulks[j]->insertIntoSorter(sorterIndex, obj, loc);
+                        }
+                        numRecords++;
+                    }
+                }
+            }
+            catch (const DBException& e) {
+                errorCode = e.getCode();
+                errorMessage = e.what();
+            }
+            catch (const std::exception& e) {
+                errorCode = ErrorCodes::InternalError;
+                errorMessage = e.what();
+            }
+        }
+
+        size_t sorterIndex;
+        std::vector<RecordIterator*> iterators; // owned elsewhere
+        std::vector<BtreeBasedBulkAccessMethod*> bulks; // owned elsewhere
+        std::vector<const MatchExpression*> filters; // parallel to bulks, NULL if not partial
+        unsigned long long numRecords;
+        int errorCode; // 0 if run() succeeded
+        std::string errorMessage;
+    };
+
+} // namespace
+
     /**
      * On rollback sets MultiIndexBlock::_needToCleanup to true.
      */
@@ -75,6 +132,7 @@ namespace mongo {
           _txn(txn),
           _buildInBackground(false),
           _allowInterruption(false),
+          _yieldToLockWaiters(false),
           _ignoreUnique(false),
           _needToCleanup(true) {
     }
@@ -155,6 +213,7 @@ namespace mongo {
                 return status;
 
             index.real = index.block->getEntry()->accessMethod();
+            index.filterExpression = index.block->getEntry()->getFilterExpression();
             status = index.real->initializeAsEmpty(_txn);
             if ( !status.isOK() )
                 return status;
@@ -218,6 +277,94 @@ namespace mongo {
 
         unsigned long long n = 0;
 
+        if (_insertAllDocumentsInParallel(&n)) {
+            progress->hit(n);
+        }
+        else {
+            Status ret = _insertAllDocumentsSerially(progress, &n, dupsOut);
+            if (!ret.isOK())
+                return ret;
+        }
+
+        progress->finished();
+
+        Status ret = doneInserting(dupsOut);
+        if (!ret.isOK())
+            return ret;
+
+        log() << "build index done.  scanned " << n << " total records. "
+              << t.seconds() << " secs" << endl;
+
+        return Status::OK();
+    }
+
+    bool MultiIndexBlock::_insertAllDocumentsInParallel(unsigned long long* numRecords) {
+        // Everything runs to completion here, while the caller holds the collection lock, since
+        // the iterators can't be used after it is released.
+        const int maxThreads = indexBuildParallelThreads;
+        if (maxThreads <= 1 || _buildInBackground || _indexes.empty())
+            return false;
+
+        std::vector<BtreeBasedBulkAccessMethod*> bulks;
+        std::vector<const MatchExpression*> filters;
+        for (size_t i = 0; i < _indexes.size(); i++) {
+            BtreeBasedBulkAccessMethod* bulk =
+                dynamic_cast<BtreeBasedBulkAccessMethod*>(_indexes[i].bulk.get());
+            if (!bulk)
+                return false;
+            bulks.push_back(bulk);
+            filters.push_back(_indexes[i].filterExpression);
+        }
+
+        OwnedPointerVector<RecordIterator> iterators(_collection->getManyIterators(_txn));
+        if (iterators.size() <= 1)
+            return false;
+
+        const size_t numThreads = std::min(iterators.size(), size_t(maxThreads));
+        for (size_t i = 0; i < bulks.size(); i++) {
+            bulks[i]->setNumSorters(numThreads);
+        }
+
+        std::vector<ParallelKeyGenerator> generators(numThreads);
+        for (size_t i = 0; i < numThreads; i++) {
+            generators[i].sorterIndex = i;
+            generators[i].bulks = bulks;
+            generators[i].filters = filters;
+        }
+
+        // Hand the iterators out round-robin so each thread gets a similar share.
+        for (size_t i = 0; i < iterators.size(); i++) {
+            generators[i % numThreads].iterators.push_back(iterators[i]);
+        }
+
+        LOG(1) << "\t generating keys on " << numThreads << " threads";
+
+        {
+            boost::thread_group threads;
+            for (size_t i = 1; i < numThreads; i++) {
+                threads.create_thread(boost::bind(&ParallelKeyGenerator::run, &generators[i]));
+            }
+            generators[0].run();
+            threads.join_all();
+        }
+
+        for (size_t i = 0; i < numThreads; i++) {
+            if (generators[i].errorCode)
+                uasserted(generators[i].errorCode, generators[i].errorMessage);
+            *numRecords += generators[i].numRecords;
+        }
+
+        if (_allowInterruption)
+            _txn->checkForInterrupt();
+
+        return true;
+    }
+
+    Status MultiIndexBlock::_insertAllDocumentsSerially(ProgressMeterHolder& progress,
+                                                        unsigned long long* numRecords,
+                                                        std::set<RecordId>* dupsOut) {
+        unsigned long long& n = *numRecords;
+
         scoped_ptr<PlanExecutor> exec(InternalPlanner::collectionScan(_txn,
                                                                       _collection->ns().ns(),
                                                                       _collection));
@@ -226,6 +373,9 @@ namespace mongo {
             exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
         }
 
+        const bool yieldToLockWaiters = _buildInBackground && _yieldToLockWaiters;
+        unsigned long long waiterYields = 0;
+
         BSONObj objToIndex;
         RecordId loc;
         PlanExecutor::ExecState state;
@@ -257,6 +407,19 @@ namespace mongo {
             progress->hit();
 
             progress->setTotalWhileRunning( _collection->numRecords(_txn) );
+
+            if (yieldToLockWaiters && _txn->lockState()->hasLockWaiters()) {
+                // If the collection goes away meanwhile, the next getNext() returns DEAD.
+                exec->saveState();
+                QueryYield::yieldAllLocks(_txn, NULL);
+                exec->restoreState(_txn);
+                _txn->checkForInterrupt();
+                waiterYields++;
+            }
+        }
+
+        if (yieldToLockWaiters) {
+            LOG(1) << "\t index build yielded " << waiterYields << " times to waiting lockers";
         }
 
         if (state != PlanExecutor::IS_EOF) {
@@ -264,20 +427,16 @@ namespace mongo {
                       "Unable to complete index build as the collection is no longer readable");
         }
 
-        progress->finished();
-
-        Status ret = doneInserting(dupsOut);
-        if (!ret.isOK())
-            return ret;
-
-        log() << "build index done.  scanned " << n << " total records. "
-              << t.seconds() << " secs" << endl;
-
         return Status::OK();
     }
 
     Status MultiIndexBlock::insert(const BSONObj& doc, const RecordId& loc) {
         for ( size_t i = 0; i < _indexes.size(); i++ ) {
+            if ( _indexes[i].filterExpression &&
+                 !_indexes[i].filterExpression->matchesBSON( doc ) ) {
+                continue;
+            }
+
             int64_t unused;
             Status idxStatus = _indexes[i].forInsert()->insert( _txn,
                                                                doc,
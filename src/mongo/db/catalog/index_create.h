@@ -46,7 +46,9 @@ namespace mongo {
     class BackgroundOperation;
     class BSONObj;
     class Collection;
+    class MatchExpression;
     class OperationContext;
+    class ProgressMeterHolder;
 
     /**
      * Builds one or more indexes.
@@ -84,6 +86,13 @@ namespace mongo {
          */
         void allowInterruption() { _allowInterruption = true; }
 
+        /**
+         * Call this before insertAllDocumentsInCollection() to make a background build give up its
+         * locks as soon as another operation waits for one of them, rather than only every
+         * internalQueryExecYieldIterations documents or internalQueryExecYieldPeriodMS.
+         */
+        void yieldToLockWaiters() { _yieldToLockWaiters = true; }
+
         /**
          * By default we enforce the 'unique' flag in specs when building an index by failing.
          * If this is called before init(), we will ignore unique violations. This has no effect if
@@ -198,8 +207,19 @@ namespace mongo {
     private:
         class SetNeedToCleanupOnRollback;
 
+        /**
+         * Reads the collection and generates the keys on several threads, when the server is
+         * configured for it and all the indexes are built in bulk. Returns false, without
+         * inserting anything, if the build can't be done in parallel.
+         */
+        bool _insertAllDocumentsInParallel(unsigned long long* numRecords);
+
+        Status _insertAllDocumentsSerially(ProgressMeterHolder& progress,
+                                           unsigned long long* numRecords,
+                                           std::set<RecordId>* dupsOut);
+
         struct IndexToBuild {
-            IndexToBuild() : real(NULL) {}
+            IndexToBuild() : real(NULL), filterExpression(NULL) {}
 
             IndexAccessMethod* forInsert() { return bulk ? bulk.get() : real; }
 
@@ -208,6 +228,8 @@ namespace mongo {
             IndexAccessMethod* real; // owned elsewhere
             boost::shared_ptr<IndexAccessMethod> bulk;
 
+            const MatchExpression* filterExpression; // owned elsewhere, NULL if not partial
+
             InsertDeleteOptions options;
         };
 
@@ -222,6 +244,7 @@ namespace mongo {
 
         bool _buildInBackground;
         bool _allowInterruption;
+        bool _yieldToLockWaiters;
         bool _ignoreUnique;
 
         bool _needToCleanup;
@@ -0,0 +1,208 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/catalog/working_set_estimator.h"
+
+#include <map>
+#include <set>
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_SERVER_PARAMETER(workingSetEstimation, bool, true);
+    MONGO_EXPORT_SERVER_PARAMETER(workingSetWindowSecs, int, 60);
+
+    namespace {
+
+        const long long kPageSize = 4096;
+
+        SimpleMutex registryMutex("workingSetEstimators");
+        std::set<const WorkingSetEstimator*> registry;
+
+        long long windowMillis() {
+            return std::max(1, workingSetWindowSecs) * 1000LL;
+        }
+
+    } // namespace
+
+    WorkingSetEstimator::WorkingSetEstimator(const StringData& ns)
+        : _ns(ns.toString()),
+          _rotateMutex("WorkingSetEstimator"),
+          _current(0),
+          _currentStartMillis(curTimeMillis64()) {
+        SimpleMutex::scoped_lock lk(registryMutex);
+        registry.insert(this);
+    }
+
+    WorkingSetEstimator::~WorkingSetEstimator() {
+        SimpleMutex::scoped_lock lk(registryMutex);
+        registry.erase(this);
+    }
+
+    uint64_t WorkingSetEstimator::_hash(const RecordId& loc) {
+        // splitmix64 finalizer; RecordIds are often sequential so they need real mixing.
+        uint64_t x = static_cast<uint64_t>(loc.repr());
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    void WorkingSetEstimator::_noteSampled(uint64_t hash, int size) {
+        if (!workingSetEstimation) {
+            return;
+        }
+
+        const long long now = curTimeMillis64();
+        if (now - _currentStartMillis.loadRelaxed() >= windowMillis()) {
+            _rotateIfNeeded(now);
+        }
+
+        Window& window = _windows[_current.loadRelaxed()];
+        window.records.add(hash);
+        window.accesses.fetchAndAdd(1);
+        window.bytes.fetchAndAdd(size);
+    }
+
+    void WorkingSetEstimator::_rotateIfNeeded(long long now) {
+        SimpleMutex::scoped_lock lk(_rotateMutex);
+        if (now - _currentStartMillis.load() < windowMillis()) {
+            return; // someone else got here first
+        }
+
+        // The old previous window becomes the new current one.  Writers that loaded the old
+        // index just before the switch may land a few accesses in either window, which only
+        // blurs the boundary slightly.
+        const unsigned next = 1 - _current.load();
+        Window& window = _windows[next];
+        window.records.clear();
+        window.accesses.store(0);
+        window.bytes.store(0);
+
+        if (now - _currentStartMillis.load() >= 2 * windowMillis()) {
+            // Idle for longer than a window, so the outgoing window is stale as well.
+            Window& stale = _windows[1 - next];
+            stale.records.clear();
+            stale.accesses.store(0);
+            stale.bytes.store(0);
+        }
+
+        _currentStartMillis.store(now);
+        _current.store(next);
+    }
+
+    WorkingSetEstimator::Estimate WorkingSetEstimator::estimate() const {
+        SimpleMutex::scoped_lock lk(_rotateMutex);
+
+        const long long age = curTimeMillis64() - _currentStartMillis.load();
+        const Window& current = _windows[_current.load()];
+        const Window& previous = _windows[1 - _current.load()];
+
+        double sampledRecords;
+        unsigned long long accesses;
+        unsigned long long bytes;
+        if (age < windowMillis()) {
+            sampledRecords = current.records.estimateUnion(previous.records);
+            accesses = current.accesses.load() + previous.accesses.load();
+            bytes = current.bytes.load() + previous.bytes.load();
+        }
+        else if (age < 2 * windowMillis()) {
+            // Nothing has rotated the windows lately, so the previous one is too old.
+            sampledRecords = current.records.estimate();
+            accesses = current.accesses.load();
+            bytes = current.bytes.load();
+        }
+        else {
+            return Estimate();
+        }
+
+        Estimate result;
+        if (accesses == 0) {
+            return result;
+        }
+
+        result.records = static_cast<long long>(sampledRecords * (1 << SampleShift) + 0.5);
+        result.bytes = static_cast<long long>(result.records *
+                                              (static_cast<double>(bytes) / accesses));
+        result.pages = (result.bytes + kPageSize - 1) / kPageSize;
+        return result;
+    }
+
+    namespace {
+
+        class WorkingSetServerStatusSection : public ServerStatusSection {
+        public:
+            WorkingSetServerStatusSection() : ServerStatusSection("workingSet") { }
+
+            virtual bool includeByDefault() const { return false; }
+
+            BSONObj generateSection(OperationContext* txn,
+                                    const BSONElement& configElement) const {
+                // Several estimators can share a namespace while a collection is being
+                // replaced, so sum them.
+                std::map<std::string, WorkingSetEstimator::Estimate> byNs;
+                {
+                    SimpleMutex::scoped_lock lk(registryMutex);
+                    for (std::set<const WorkingSetEstimator*>::const_iterator it =
+                             registry.begin(); it != registry.end(); ++it) {
+                        const WorkingSetEstimator::Estimate e = (*it)->estimate();
+                        WorkingSetEstimator::Estimate& total = byNs[(*it)->ns()];
+                        total.records += e.records;
+                        total.bytes += e.bytes;
+                        total.pages += e.pages;
+                    }
+                }
+
+                BSONObjBuilder b;
+                b.append("windowSecs", workingSetWindowSecs);
+                BSONObjBuilder nsBuilder(b.subobjStart("namespaces"));
+                for (std::map<std::string, WorkingSetEstimator::Estimate>::const_iterator it =
+                         byNs.begin(); it != byNs.end(); ++it) {
+                    if (it->second.records == 0) {
+                        continue;
+                    }
+                    BSONObjBuilder nsStats(nsBuilder.subobjStart(it->first));
+                    nsStats.appendNumber("records", it->second.records);
+                    nsStats.appendNumber("bytes", it->second.bytes);
+                    nsStats.appendNumber("pages", it->second.pages);
+                    nsStats.doneFast();
+                }
+                nsBuilder.doneFast();
+                return b.obj();
+            }
+
+        } workingSetServerStatusSection;
+
+    } // namespace
+
+} // namespace mongo
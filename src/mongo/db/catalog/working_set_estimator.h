@@ -0,0 +1,111 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/record_id.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/hyperloglog.h"
+
+namespace mongo {
+
+    /**
+     * Estimates how many distinct records of one collection, and how many bytes of them, were
+     * read over the last workingSetWindowSecs seconds.  Each access is hashed and a fixed
+     * fraction of the hashes is fed to a HyperLogLog, so the cost on the read path is a hash, a
+     * compare and, for sampled accesses, a couple of relaxed atomic updates.
+     *
+     * Accesses are counted into the current of two windows; when it ages out it becomes the
+     * previous window and a fresh one starts.  The estimate is the union of both, so it always
+     * covers between one and two windows of history.
+     *
+     * All live estimators register themselves so the "workingSet" serverStatus section can
+     * report them.
+     */
+    class WorkingSetEstimator {
+        MONGO_DISALLOW_COPYING(WorkingSetEstimator);
+    public:
+        struct Estimate {
+            Estimate() : records(0), bytes(0), pages(0) { }
+
+            long long records;
+            long long bytes;
+            long long pages;
+        };
+
+        explicit WorkingSetEstimator(const StringData& ns);
+        ~WorkingSetEstimator();
+
+        /**
+         * Records a read of the 'size' byte record at 'loc'.  Threadsafe.
+         */
+        void noteAccessed(const RecordId& loc, int size) {
+            const uint64_t hash = _hash(loc);
+            if (hash >> (64 - SampleShift)) {
+                return;
+            }
+            _noteSampled(hash, size);
+        }
+
+        Estimate estimate() const;
+
+        const std::string& ns() const { return _ns; }
+
+    private:
+        // One in 2^SampleShift accesses, picked by hash so a record is always in or out.
+        enum { SampleShift = 3 };
+
+        struct Window {
+            HyperLogLog records;
+            AtomicUInt64 accesses;
+            AtomicUInt64 bytes;
+        };
+
+        static uint64_t _hash(const RecordId& loc);
+
+        void _noteSampled(uint64_t hash, int size);
+
+        /** Swaps the windows if the current one is over. */
+        void _rotateIfNeeded(long long now);
+
+        const std::string _ns;
+
+        // Guards rotation, not counting.
+        mutable SimpleMutex _rotateMutex;
+
+        Window _windows[2];
+        AtomicUInt32 _current;
+        AtomicInt64 _currentStartMillis;
+    };
+
+} // namespace mongo
@@ -132,6 +132,12 @@ namespace {
           _shutdown(false) {
 
         _curOp = new CurOp( this );
+
+        // Threads of the server itself, such as replication, go ahead of client operations
+        // under admission control.
+        if ( !isFromUserConnection() ) {
+            _locker->setAdmissionPriority( kAdmissionInternal );
+        }
     }
 
     Client::~Client() {
@@ -514,6 +520,8 @@ namespace {
         }
 
         s << " numYields:" << curop.numYields();
+        curop.reportTimeBreakdown(s);
+        curop.storageStats().report(s);
         
         OPDEBUG_TOSTRING_HELP( nreturned );
         if ( responseLength > 0 )
@@ -601,6 +609,14 @@ namespace {
         OPDEBUG_APPEND_NUMBER( writeConflicts );
 
         b.appendNumber("numYield", curop.numYields());
+        curop.appendTimeBreakdown("timeBreakdownMicros", &b);
+
+        const StorageStats storageStats = curop.storageStats();
+        if (!storageStats.isEmpty()) {
+            BSONObjBuilder storageStatsBuilder(b.subobjStart("storageStats"));
+            storageStats.append(&storageStatsBuilder);
+            storageStatsBuilder.doneFast();
+        }
 
         if ( ! exceptionInfo.empty() )
             exceptionInfo.append( b , "exception" , "exceptionCode" );
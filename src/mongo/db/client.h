@@ -208,6 +208,14 @@ namespace mongo {
         // Return a reference to the Locker for this client. Client retains ownership.
         Locker* getLocker() const { return _locker.get(); }
 
+        // Returns the recovery unit that the client's last OperationContext left for reuse, or
+        // NULL if there is none. Caller owns.
+        RecoveryUnit* releaseCachedRecoveryUnit() { return _cachedRecoveryUnit.release(); }
+
+        // Keeps 'unit', which resetForReuse() has returned to a fresh state, for the client's
+        // next OperationContext. Takes ownership.
+        void cacheRecoveryUnit(RecoveryUnit* unit) { _cachedRecoveryUnit.reset(unit); }
+
         /* report what the last operation was.  used by getlasterror */
         void appendLastOp( BSONObjBuilder& b ) const;
         void reportState(BSONObjBuilder& builder);
@@ -261,6 +269,10 @@ namespace mongo {
         // allocating OS resources can be amortized over multiple operations.
         boost::scoped_ptr<Locker> const _locker;
 
+        // Likewise, an OperationContext takes the recovery unit of the previous one on this
+        // client, when its storage engine can reuse it, rather than a new one.
+        std::auto_ptr<RecoveryUnit> _cachedRecoveryUnit;
+
         // Used by replication
         OpTime _lastOp;
         OID _remoteId; // Only used by master-slave
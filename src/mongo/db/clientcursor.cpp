@@ -107,7 +107,7 @@ namespace mongo {
         _isPinned = false;
         _isNoTimeout = false;
 
-        _idleAgeMillis = 0;
+        _lastUseMillis = _cursorManager->clockMillis();
         _leftoverMaxTimeMicros = 0;
         _pos = 0;
 
@@ -164,15 +164,25 @@ namespace mongo {
     //
 
     bool ClientCursor::shouldTimeout(int millis) {
-        _idleAgeMillis += millis;
+        _lastUseMillis -= millis;
         if (_isNoTimeout || _isPinned) {
             return false;
         }
-        return _idleAgeMillis > 600000;
+        return idleTime() > kIdleTimeoutMillis;
     }
 
     void ClientCursor::setIdleTime( int millis ) {
-        _idleAgeMillis = millis;
+        if ( _cursorManager ) {
+            _lastUseMillis = _cursorManager->clockMillis() - millis;
+        }
+    }
+
+    int ClientCursor::idleTime() const {
+        if ( !_cursorManager ) {
+            // Killed, so it no longer times out
+            return 0;
+        }
+        return static_cast<int>( _cursorManager->clockMillis() - _lastUseMillis );
     }
 
     void ClientCursor::updateSlaveLocation(OperationContext* txn, CurOp& curop) {
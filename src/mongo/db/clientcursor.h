@@ -118,13 +118,20 @@ namespace mongo {
         // Timing and timeouts
         //
 
+        // How long a cursor can stay idle before it is timed out
+        static const int kIdleTimeoutMillis = 600 * 1000;
+
         /**
-         * @param millis amount of idle passed time since last call
-         * note called outside of locks (other than ccmutex) so care must be exercised
+         * Adds 'millis' to the idle time and returns whether the cursor should now be timed out.
          */
         bool shouldTimeout( int millis );
+        bool isNoTimeout() const { return _isNoTimeout; }
+
+        /**
+         * Idle time, measured on the clock of the CursorManager the cursor is registered with.
+         */
         void setIdleTime( int millis );
-        int idleTime() const { return _idleAgeMillis; }
+        int idleTime() const;
 
         uint64_t getLeftoverMaxTimeMicros() const { return _leftoverMaxTimeMicros; }
         void setLeftoverMaxTimeMicros( uint64_t leftoverMaxTimeMicros ) {
@@ -259,8 +266,8 @@ namespace mongo {
         // TODO: document better.
         OpTime _slaveReadTill;
 
-        // How long has the cursor been idle?
-        int _idleAgeMillis;
+        // When was the cursor last used, on the clock of its CursorManager?
+        long long _lastUseMillis;
 
         // TODO: Document.
         uint64_t _leftoverMaxTimeMicros;
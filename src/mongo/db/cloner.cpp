@@ -34,7 +34,9 @@
 
 #include "mongo/db/cloner.h"
 
+#include <algorithm>
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "mongo/base/status.h"
 #include "mongo/bson/util/builder.h"
@@ -53,11 +55,14 @@
 #include "mongo/db/index_builder.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/operation_context_impl.h"
 #include "mongo/db/repl/isself.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
@@ -66,6 +71,10 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(skipCorruptDocumentsWhenCloning, bool, false);
 
+    // Most documents inserted by the cloner in one unit of work. The cloner also checks for
+    // interruption and yields between these groups.
+    const size_t kMaxDocsPerInsert = 128;
+
     BSONElement getErrField(const BSONObj& o);
 
     /* for index info object:
@@ -115,9 +124,10 @@ namespace mongo {
         void operator()( DBClientCursorBatchIterator &i ) {
             invariant(from_collection.coll() != "system.indexes");
 
-            // XXX: can probably take dblock instead
-            scoped_ptr<ScopedTransaction> scopedXact(new ScopedTransaction(txn, MODE_X));
-            scoped_ptr<Lock::GlobalWrite> globalWriteLock(new Lock::GlobalWrite(txn->lockState()));
+            // Only the target database is written, so other databases can be cloned meanwhile
+            scoped_ptr<ScopedTransaction> scopedXact(new ScopedTransaction(txn, MODE_IX));
+            scoped_ptr<Lock::DBLock> dbWriteLock(
+                new Lock::DBLock(txn->lockState(), _dbName, MODE_X));
 
             // Make sure database still exists after we resume from the temp release
             Database* db = dbHolder().openDb(txn, _dbName);
@@ -145,8 +155,10 @@ namespace mongo {
                 wunit.commit();
             }
 
+            bool firstGroup = true;
+            std::vector<BSONObj> docs;
             while( i.moreInCurrentBatch() ) {
-                if ( numSeen % 128 == 127 ) {
+                if ( !firstGroup ) {
                     time_t now = time(0);
                     if( now - lastLog >= 60 ) {
                         // report progress
@@ -160,13 +172,13 @@ namespace mongo {
                     }
 
                     if (_mayYield) {
+                        dbWriteLock.reset();
                         scopedXact.reset();
-                        globalWriteLock.reset();
 
                         txn->getCurOp()->yielded();
 
-                        scopedXact.reset(new ScopedTransaction(txn, MODE_X));
-                        globalWriteLock.reset(new Lock::GlobalWrite(txn->lockState()));
+                        scopedXact.reset(new ScopedTransaction(txn, MODE_IX));
+                        dbWriteLock.reset(new Lock::DBLock(txn->lockState(), _dbName, MODE_X));
 
                         // Check if everything is still all right.
                         if (logForRepl) {
@@ -191,35 +203,47 @@ namespace mongo {
                                 collection != NULL);
                     }
                 }
-
-                BSONObj tmp = i.nextSafe();
-
-                /* assure object is valid.  note this will slow us down a little. */
-                const Status status = validateBSON(tmp.objdata(), tmp.objsize());
-                if (!status.isOK()) {
-                    str::stream ss;
-                    ss << "Cloner: found corrupt document in " << from_collection.toString()
-                          << ": " << status.reason();
-                    if (skipCorruptDocumentsWhenCloning) {
-                        warning() << ss.ss.str() << "; skipping";
-                        continue;
+                firstGroup = false;
+
+                // Insert the documents in groups, each in one unit of work
+                docs.clear();
+                while ( i.moreInCurrentBatch() && docs.size() < kMaxDocsPerInsert ) {
+                    BSONObj tmp = i.nextSafe();
+
+                    /* assure object is valid.  note this will slow us down a little. */
+                    const Status status = validateBSON(tmp.objdata(), tmp.objsize());
+                    if (!status.isOK()) {
+                        str::stream ss;
+                        ss << "Cloner: found corrupt document in " << from_collection.toString()
+                              << ": " << status.reason();
+                        if (skipCorruptDocumentsWhenCloning) {
+                            warning() << ss.ss.str() << "; skipping";
+                            continue;
+                        }
+                        msgasserted(28531, ss);
                     }
-                    msgasserted(28531, ss);
+
+                    docs.push_back(tmp);
                 }
 
-                ++numSeen;
-                WriteUnitOfWork wunit(txn);
+                if ( docs.empty() )
+                    continue;
 
-                BSONObj js = tmp;
+                numSeen += docs.size();
+                WriteUnitOfWork wunit(txn);
 
-                StatusWith<RecordId> loc = collection->insertDocument( txn, js, true );
-                if ( !loc.isOK() ) {
-                    error() << "error: exception cloning object in " << from_collection
-                            << ' ' << loc.toString() << " obj:" << js;
+                std::vector<RecordId> locs;
+                Status status = collection->insertDocuments( txn, docs, true, &locs );
+                if ( !status.isOK() ) {
+                    error() << "error: exception cloning objects in " << from_collection
+                            << ' ' << status.toString();
+                }
+                uassertStatusOK( status );
+                if (logForRepl) {
+                    for ( size_t j = 0; j < docs.size(); j++ ) {
+                        repl::logOp(txn, "i", to_collection.ns().c_str(), docs[j]);
+                    }
                 }
-                uassertStatusOK( loc.getStatus() );
-                if (logForRepl)
-                    repl::logOp(txn, "i", to_collection.ns().c_str(), js);
 
                 wunit.commit();
 
@@ -347,6 +371,135 @@ namespace mongo {
         wunit.commit();
     }
 
+    void Cloner::_copyCollectionData(OperationContext* txn,
+                                     const string& toDBName,
+                                     const string& collectionName,
+                                     const CloneOptions& opts,
+                                     bool masterSameProcess) {
+        const NamespaceString from_name(opts.fromDB, collectionName);
+        const NamespaceString to_name(toDBName, collectionName);
+
+        LOG(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
+        Query q;
+        if( opts.snapshot )
+            q.snapshot();
+
+        copy(txn,
+             toDBName,
+             from_name,
+             to_name,
+             opts.logForRepl,
+             masterSameProcess,
+             opts.slaveOk,
+             opts.mayYield,
+             opts.mayBeInterrupted,
+             q);
+
+        // Copy releases the lock, so we need to re-load the database. This should
+        // probably throw if the database has changed in between, but for now preserve
+        // the existing behaviour.
+        Database* db = dbHolder().get(txn, toDBName);
+        uassert(18645,
+                str::stream() << "database " << toDBName << " dropped during clone",
+                db);
+
+        Collection* c = db->getCollection( to_name );
+        if ( c && !c->getIndexCatalog()->haveIdIndex( txn ) ) {
+            // We need to drop objects with duplicate _ids because we didn't do a true
+            // snapshot and this is before applying oplog operations that occur during the
+            // initial sync.
+            set<RecordId> dups;
+
+            MultiIndexBlock indexer(txn, c);
+            if (opts.mayBeInterrupted)
+                indexer.allowInterruption();
+
+            uassertStatusOK(indexer.init(c->getIndexCatalog()->getDefaultIdIndexSpec()));
+            uassertStatusOK(indexer.insertAllDocumentsInCollection(&dups));
+
+            for (set<RecordId>::const_iterator it = dups.begin(); it != dups.end(); ++it) {
+                WriteUnitOfWork wunit(txn);
+                BSONObj id;
+
+                c->deleteDocument(txn, *it, true, true, opts.logForRepl ? &id : NULL);
+                if (opts.logForRepl)
+                    repl::logOp(txn, "d", c->ns().ns().c_str(), id);
+                wunit.commit();
+            }
+
+            if (!dups.empty()) {
+                log() << "index build dropped: " << dups.size() << " dups";
+            }
+
+            WriteUnitOfWork wunit(txn);
+            indexer.commit();
+            if (opts.logForRepl) {
+                repl::logOp(txn,
+                            "i",
+                            c->ns().getSystemIndexesCollection().c_str(),
+                            c->getIndexCatalog()->getDefaultIdIndexSpec());
+            }
+            wunit.commit();
+        }
+    }
+
+    Cloner::ParallelCopy::ParallelCopy(const ConnectionString& cs,
+                                       const string& toDBName,
+                                       const CloneOptions& opts,
+                                       const list<BSONObj>& toClone)
+        : errCode(0),
+          _mutex("ParallelCopy"),
+          _cs(cs),
+          _toDBName(toDBName),
+          _opts(opts),
+          _toClone(toClone) {
+    }
+
+    bool Cloner::ParallelCopy::_next(string* collectionName) {
+        scoped_lock lk(_mutex);
+        if (errCode || _toClone.empty())
+            return false;
+
+        *collectionName = _toClone.front()["name"].String();
+        _toClone.pop_front();
+        return true;
+    }
+
+    void Cloner::ParallelCopy::run() {
+        Client::initThread("clonerWorker");
+        OperationContextImpl txn;
+
+        string collectionName;
+        try {
+            string err;
+            auto_ptr<DBClientBase> conn(_cs.connect(err));
+            uassert(ErrorCodes::HostUnreachable, err, conn.get());
+            uassert(ErrorCodes::AuthenticationFailed,
+                    str::stream() << "cloner could not authenticate to " << _cs.toString(),
+                    !getGlobalAuthorizationManager()->isAuthEnabled() ||
+                        authenticateInternalUser(conn.get()));
+
+            Cloner cloner;
+            cloner.setConnection(conn.release());
+
+            while (_next(&collectionName)) {
+                ScopedTransaction transaction(&txn, MODE_IX);
+                Lock::DBLock dbWrite(txn.lockState(), _toDBName, MODE_X);
+                cloner._copyCollectionData(&txn, _toDBName, collectionName, _opts, false);
+            }
+        }
+        catch (const DBException& e) {
+            scoped_lock lk(_mutex);
+            if (!errCode) {
+                errmsg = str::stream() << "error cloning " << _opts.fromDB << '.'
+                                       << collectionName << causedBy(e);
+                errCode = e.getCode();
+            }
+        }
+
+        txn.getClient()->shutdown();
+    }
+
     bool Cloner::copyCollection(OperationContext* txn,
                                 const string& ns,
                                 const BSONObj& query,
@@ -531,13 +684,16 @@ namespace mongo {
         }
 
         if ( opts.syncData ) {
+            const bool parallel = opts.numCollectionCloners > 1 &&
+                                  !masterSameProcess &&
+                                  toClone.size() > 1;
+
             for ( list<BSONObj>::iterator i=toClone.begin(); i != toClone.end(); i++ ) {
                 BSONObj collection = *i;
                 LOG(2) << "  really will clone: " << collection << endl;
                 const char* collectionName = collection["name"].valuestr();
                 BSONObj options = collection.getObjectField("options");
 
-                const NamespaceString from_name(opts.fromDB, collectionName);
                 const NamespaceString to_name(toDBName, collectionName);
 
                 Database* db = dbHolder().openDb(txn, toDBName);
@@ -563,67 +719,34 @@ namespace mongo {
                     wunit.commit();
                 }
 
-                LOG(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
-                Query q;
-                if( opts.snapshot )
-                    q.snapshot();
-
-                copy(txn,
-                     toDBName,
-                     from_name,
-                     to_name,
-                     opts.logForRepl,
-                     masterSameProcess,
-                     opts.slaveOk,
-                     opts.mayYield,
-                     opts.mayBeInterrupted,
-                     q);
-
-                // Copy releases the lock, so we need to re-load the database. This should
-                // probably throw if the database has changed in between, but for now preserve
-                // the existing behaviour.
-                db = dbHolder().get(txn, toDBName);
-                uassert(18645,
-                        str::stream() << "database " << toDBName << " dropped during clone",
-                        db);
-
-                Collection* c = db->getCollection( to_name );
-                if ( c && !c->getIndexCatalog()->haveIdIndex( txn ) ) {
-                    // We need to drop objects with duplicate _ids because we didn't do a true
-                    // snapshot and this is before applying oplog operations that occur during the
-                    // initial sync.
-                    set<RecordId> dups;
-
-                    MultiIndexBlock indexer(txn, c);
-                    if (opts.mayBeInterrupted)
-                        indexer.allowInterruption();
-
-                    uassertStatusOK(indexer.init(c->getIndexCatalog()->getDefaultIdIndexSpec()));
-                    uassertStatusOK(indexer.insertAllDocumentsInCollection(&dups));
-
-                    for (set<RecordId>::const_iterator it = dups.begin(); it != dups.end(); ++it) {
-                        WriteUnitOfWork wunit(txn);
-                        BSONObj id;
-
-                        c->deleteDocument(txn, *it, true, true, opts.logForRepl ? &id : NULL);
-                        if (opts.logForRepl)
-                            repl::logOp(txn, "d", c->ns().ns().c_str(), id);
-                        wunit.commit();
-                    }
+                if ( !parallel ) {
+                    _copyCollectionData(txn, toDBName, collectionName, opts, masterSameProcess);
+                }
+            }
 
-                    if (!dups.empty()) {
-                        log() << "index build dropped: " << dups.size() << " dups";
-                    }
+            if ( parallel ) {
+                ParallelCopy parallelCopy(cs, toDBName, opts, toClone);
 
-                    WriteUnitOfWork wunit(txn);
-                    indexer.commit();
-                    if (opts.logForRepl) {
-                        repl::logOp(txn,
-                                    "i",
-                                    c->ns().getSystemIndexesCollection().c_str(),
-                                    c->getIndexCatalog()->getDefaultIdIndexSpec());
+                const size_t numThreads =
+                    std::min(toClone.size(), size_t(opts.numCollectionCloners));
+                log() << "cloning " << toClone.size() << " collections of " << toDBName
+                      << " with " << numThreads << " threads";
+
+                {
+                    Lock::TempRelease tempRelease(txn->lockState());
+
+                    boost::thread_group threads;
+                    for ( size_t i = 0; i < numThreads; i++ ) {
+                        threads.create_thread(stdx::bind(&ParallelCopy::run, &parallelCopy));
                     }
-                    wunit.commit();
+                    threads.join_all();
+                }
+
+                if ( parallelCopy.errCode ) {
+                    errmsg = parallelCopy.errmsg;
+                    if ( errCode )
+                        *errCode = parallelCopy.errCode;
+                    return false;
                 }
             }
         }
@@ -30,8 +30,11 @@
 
 #pragma once
 
+#include <list>
+
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/base/disallow_copying.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
@@ -90,7 +93,49 @@ namespace mongo {
                          bool mayYield,
                          bool mayBeInterrupted);
 
+        /**
+         * Copies the documents of a collection and builds its _id index. Called with the
+         * database of 'toDBName' locked in MODE_X, which is released while documents are fetched.
+         */
+        void _copyCollectionData(OperationContext* txn,
+                                 const std::string& toDBName,
+                                 const std::string& collectionName,
+                                 const CloneOptions& opts,
+                                 bool masterSameProcess);
+
         struct Fun;
+
+        /**
+         * Collections of a database left to copy by the threads of go(). Each thread has its own
+         * connection and OperationContext, and takes the next collection when done with one.
+         */
+        class ParallelCopy {
+            MONGO_DISALLOW_COPYING(ParallelCopy);
+        public:
+            ParallelCopy(const ConnectionString& cs,
+                         const std::string& toDBName,
+                         const CloneOptions& opts,
+                         const std::list<BSONObj>& toClone);
+
+            /**
+             * Thread body. Copies collections until there are none left or any thread failed.
+             */
+            void run();
+
+            // Set by the first thread to fail, protected by _mutex until the threads are joined
+            std::string errmsg;
+            int errCode;
+
+        private:
+            bool _next(std::string* collectionName);
+
+            mongo::mutex _mutex;
+            const ConnectionString _cs;
+            const std::string _toDBName;
+            const CloneOptions& _opts;
+            std::list<BSONObj> _toClone;
+        };
+
         std::auto_ptr<DBClientBase> _conn;
     };
 
@@ -112,6 +157,8 @@ namespace mongo {
 
             syncData = true;
             syncIndexes = true;
+
+            numCollectionCloners = 1;
         }
 
         std::string fromDB;
@@ -126,6 +173,10 @@ namespace mongo {
 
         bool syncData;
         bool syncIndexes;
+
+        // Number of collections whose data is copied at the same time, each over its own
+        // connection. Ignored when cloning from the same process.
+        int numCollectionCloners;
     };
 
 } // namespace mongo
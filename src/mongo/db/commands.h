@@ -40,6 +40,7 @@
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/explain.h"
+#include "mongo/db/stats/latency_histogram.h"
 #include "mongo/util/string_map.h"
 
 namespace mongo {
@@ -241,7 +242,12 @@ namespace mutablebson {
         ServerStatusMetricField<Counter64> _commandsExecutedMetric;
         ServerStatusMetricField<Counter64> _commandsFailedMetric;
 
+        // How long the runs of this command took
+        LatencyHistogram _latency;
+
     public:
+        const LatencyHistogram& getLatencyHistogram() const { return _latency; }
+
         // Stops all index builds required to run this command and returns index builds killed.
         virtual std::vector<BSONObj> stopIndexBuilds(OperationContext* opCtx,
                                                      Database* db, 
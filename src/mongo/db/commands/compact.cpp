@@ -67,9 +67,13 @@ namespace mongo {
             help << "compact collection\n"
                 "warning: this operation locks the database and is slow. you can cancel with killOp()\n"
                 "{ compact : <collection_name>, [force:<bool>], [validate:<bool>],\n"
-                "  [paddingFactor:<num>], [paddingBytes:<num>] }\n"
+                "  [paddingFactor:<num>], [paddingBytes:<num>],\n"
+                "  [incremental:<bool>], [batchSize:<num>], [maxExtentFill:<num>] }\n"
                 "  force - allows to run on a replica set primary\n"
-                "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n";
+                "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n"
+                "  incremental - move records out of the emptiest extents a batch at a time, letting other operations run between batches. indexes are kept and updated as records move\n"
+                "  batchSize - records moved per batch in incremental mode (default 100)\n"
+                "  maxExtentFill - in incremental mode only empty extents with less than this fraction in use (default 0.5)\n";
         }
         CompactCmd() : Command("compact") { }
 
@@ -86,8 +90,11 @@ namespace mongo {
         virtual bool run(OperationContext* txn, const string& db, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
             const std::string nsToCompact = parseNsCollectionRequired(db, cmdObj);
 
+            const bool incremental = cmdObj["incremental"].trueValue();
+
             repl::ReplicationCoordinator* replCoord = repl::getGlobalReplicationCoordinator();
-            if (replCoord->getMemberState().primary() && !cmdObj["force"].trueValue()) {
+            if (replCoord->getMemberState().primary() && !cmdObj["force"].trueValue() &&
+                    !incremental) {
                 errmsg = "will not run compact on an active replica set primary as this is a slow blocking operation. use force:true to force";
                 return false;
             }
@@ -138,6 +145,25 @@ namespace mongo {
             if ( cmdObj.hasElement("validate") )
                 compactOptions.validateDocuments = cmdObj["validate"].trueValue();
 
+            if ( incremental ) {
+                int batchSize = 100;
+                if ( cmdObj.hasElement("batchSize") ) {
+                    batchSize = cmdObj["batchSize"].numberInt();
+                    if ( batchSize < 1 || batchSize > 10000 ) {
+                        errmsg = "invalid batch size";
+                        return false;
+                    }
+                }
+                if ( cmdObj.hasElement("maxExtentFill") ) {
+                    compactOptions.maxExtentFill = cmdObj["maxExtentFill"].Number();
+                    if ( compactOptions.maxExtentFill <= 0 || compactOptions.maxExtentFill > 1 ) {
+                        errmsg = "invalid max extent fill";
+                        return false;
+                    }
+                }
+                return _runIncremental( txn, db, ns, compactOptions, batchSize, errmsg, result );
+            }
+
 
             ScopedTransaction transaction(txn, MODE_IX);
             AutoGetDb autoDb(txn, db, MODE_X);
@@ -175,6 +201,64 @@ namespace mongo {
 
             return true;
         }
+
+    private:
+        /**
+         * Compacts in batches, taking the collection lock for each and releasing it in between
+         * so that reads and writes on the collection can proceed.
+         */
+        bool _runIncremental(OperationContext* txn,
+                             const string& db,
+                             const NamespaceString& ns,
+                             const CompactOptions& compactOptions,
+                             int batchSize,
+                             string& errmsg,
+                             BSONObjBuilder& result) {
+            log() << "compact " << ns << " incremental begin, batchSize: " << batchSize
+                  << " options: " << compactOptions.toString();
+
+            CompactStats stats;
+            long long batches = 0;
+            bool done = false;
+            while ( !done ) {
+                txn->checkForInterrupt();
+
+                ScopedTransaction transaction(txn, MODE_IX);
+                AutoGetDb autoDb(txn, db, MODE_IX);
+                Lock::CollectionLock collLock(txn->lockState(), ns.ns(), MODE_X);
+                Database* const collDB = autoDb.getDb();
+                Collection* collection = collDB ? collDB->getCollection(ns) : NULL;
+
+                if ( !collDB || !collection ) {
+                    errmsg = "namespace does not exist";
+                    return false;
+                }
+
+                if ( collection->isCapped() ) {
+                    errmsg = "cannot compact a capped collection";
+                    return false;
+                }
+
+                Status status = collection->compactIncremental( txn,
+                                                                &compactOptions,
+                                                                batchSize,
+                                                                &stats,
+                                                                &done );
+                if ( !status.isOK() )
+                    return appendCommandStatus( result, status );
+
+                batches++;
+            }
+
+            result.append("batches", batches);
+            result.append("recordsMoved", stats.recordsMoved);
+            result.append("extentsFreed", stats.extentsFreed);
+
+            log() << "compact " << ns << " incremental end, moved " << stats.recordsMoved
+                  << " records in " << batches << " batches, freed " << stats.extentsFreed
+                  << " extents";
+            return true;
+        }
     };
     static CompactCmd compactCmd;
 
@@ -206,6 +206,14 @@ namespace mongo {
                 hintObj = BSON("$hint" << hint);
             }
 
+            bool approximate = false;
+            if (Bool == cmdObj["approximate"].type()) {
+                approximate = cmdObj["approximate"].Bool();
+            }
+            else if (cmdObj["approximate"].ok()) {
+                return Status(ErrorCodes::BadValue, "approximate value is not a boolean");
+            }
+
             std::string ns = parseNs(dbname, cmdObj);
 
             if (!nsIsFull(ns)) {
@@ -218,6 +226,7 @@ namespace mongo {
             request->hint = hintObj;
             request->limit = limit;
             request->skip = skip;
+            request->approximate = approximate;
 
             // By default, count requests are regular count not explain of count.
             request->explain = false;
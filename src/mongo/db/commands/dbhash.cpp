@@ -32,13 +32,23 @@
 
 #include "mongo/db/commands/dbhash.h"
 
+#include <algorithm>
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <third_party/murmurhash3/MurmurHash3.h>
 
+#include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_catalog_entry.h"
+#include "mongo/db/operation_context_impl.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/util/hex.h"
 #include "mongo/util/log.h"
 #include "mongo/util/md5.hpp"
 #include "mongo/util/timer.h"
@@ -69,10 +79,79 @@ namespace mongo {
         out->push_back(Privilege(ResourcePattern::forDatabaseName(dbname), actions));
     }
 
-    string DBHashCmd::hashCollection( OperationContext* opCtx, Database* db, const string& fullCollectionName, bool* fromCache ) {
+    // Number of collections hashed at the same time by one dbHash command, each by its own thread
+    // holding a lock on just that collection.
+    MONGO_EXPORT_SERVER_PARAMETER(dbHashParallelCollections, int, 4);
+
+    /**
+     * The collections one dbHash command hashes, handed out to its threads one at a time. Each
+     * hash goes in the slot of its collection, so the results come out in name order however
+     * the threads finish.
+     */
+    struct DBHashCmd::HashJob {
+        HashJob() : fastHash(false), yield(false), next(0), status(Status::OK()) {}
+
+        bool fastHash;
+        bool yield;
+        vector<string> collections;
+        vector<string> hashes;
+        vector<char> fromCache;
+        AtomicUInt32 next;
+
+        boost::mutex statusMutex;
+        Status status;
+    };
+
+namespace {
+
+    /**
+     * Order dependent 128-bit MurmurHash3 over a sequence of documents, for callers that only
+     * compare hashes and would rather not pay for MD5.
+     */
+    class FastHasher {
+    public:
+        FastHasher() {
+            _state[0] = 0;
+            _state[1] = 0;
+        }
+
+        void append(const BSONObj& obj) {
+            uint64_t input[4];
+            input[0] = _state[0];
+            input[1] = _state[1];
+            MurmurHash3_x64_128(obj.objdata(), obj.objsize(), 0, &input[2]);
+            MurmurHash3_x64_128(input, sizeof(input), 0, _state);
+        }
+
+        string finish() const {
+            return toHexLower(_state, sizeof(_state));
+        }
+
+    private:
+        uint64_t _state[2];
+    };
+
+} // namespace
+
+    string DBHashCmd::hashCollection( OperationContext* opCtx,
+                                      const string& fullCollectionName,
+                                      bool fastHash,
+                                      bool yield,
+                                      bool* fromCache ) {
+        // Without yielding, the collection is locked in S-mode so that its contents will not
+        // change for the snapshot.
+        ScopedTransaction scopedXact(opCtx, MODE_IS);
+        AutoGetDb autoDb(opCtx, nsToDatabaseSubstring(fullCollectionName), MODE_IS);
+        Lock::CollectionLock collLock(opCtx->lockState(),
+                                      fullCollectionName,
+                                      yield ? MODE_IS : MODE_S);
+
+        // The cache lock is taken after the collection lock, as writers clear the cache with
+        // their collection lock held. For the same reason, cached collections don't yield.
         scoped_ptr<scoped_lock> cachedHashedLock;
 
-        if ( isCachable( fullCollectionName ) ) {
+        if ( !fastHash && isCachable( fullCollectionName ) ) {
+            yield = false;
             cachedHashedLock.reset( new scoped_lock( _cachedHashedMutex ) );
             string hash = _cachedHashed[fullCollectionName];
             if ( hash.size() > 0 ) {
@@ -82,7 +161,8 @@ namespace mongo {
         }
 
         *fromCache = false;
-        Collection* collection = db->getCollection( fullCollectionName );
+        Database* db = autoDb.getDb();
+        Collection* collection = db ? db->getCollection( fullCollectionName ) : NULL;
         if ( !collection )
             return "";
 
@@ -109,23 +189,40 @@ namespace mongo {
             return "no _id _index";
         }
 
+        verify(NULL != exec.get());
+        if ( yield ) {
+            exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
+        }
+
         md5_state_t st;
         md5_init(&st);
+        FastHasher fast;
 
         long long n = 0;
         PlanExecutor::ExecState state;
         BSONObj c;
-        verify(NULL != exec.get());
         while (PlanExecutor::ADVANCED == (state = exec->getNext(&c, NULL))) {
-            md5_append( &st , (const md5_byte_t*)c.objdata() , c.objsize() );
+            if ( fastHash ) {
+                fast.append( c );
+            }
+            else {
+                md5_append( &st , (const md5_byte_t*)c.objdata() , c.objsize() );
+            }
             n++;
         }
         if (PlanExecutor::IS_EOF != state) {
             warning() << "error while hashing, db dropped? ns=" << fullCollectionName << endl;
         }
-        md5digest d;
-        md5_finish(&st, d);
-        string hash = digestToString( d );
+
+        string hash;
+        if ( fastHash ) {
+            hash = fast.finish();
+        }
+        else {
+            md5digest d;
+            md5_finish(&st, d);
+            hash = digestToString( d );
+        }
 
         if ( cachedHashedLock.get() ) {
             _cachedHashed[fullCollectionName] = hash;
@@ -134,6 +231,42 @@ namespace mongo {
         return hash;
     }
 
+    void DBHashCmd::hashCollections( OperationContext* opCtx, HashJob* job ) {
+        try {
+            for ( unsigned i = job->next.fetchAndAdd( 1 );
+                  i < job->collections.size();
+                  i = job->next.fetchAndAdd( 1 ) ) {
+                bool fromCache = false;
+                job->hashes[i] = hashCollection( opCtx,
+                                                 job->collections[i],
+                                                 job->fastHash,
+                                                 job->yield,
+                                                 &fromCache );
+                job->fromCache[i] = fromCache;
+                LOG(1) << "dbHash of " << job->collections[i] << ": " << job->hashes[i];
+            }
+        }
+        catch ( const DBException& e ) {
+            boost::mutex::scoped_lock lk( job->statusMutex );
+            if ( job->status.isOK() ) {
+                job->status = e.toStatus();
+            }
+            // Stop the other threads from starting on further collections.
+            job->next.store( job->collections.size() );
+        }
+    }
+
+    void DBHashCmd::runHashThread( HashJob* job ) {
+        Client::initThread( "dbHash" );
+        Client& client = cc();
+        client.getAuthorizationSession()->grantInternalAuthorization();
+        {
+            OperationContextImpl txn;
+            hashCollections( &txn, job );
+        }
+        client.shutdown();
+    }
+
     bool DBHashCmd::run(OperationContext* txn, const string& dbname , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
         Timer timer;
 
@@ -150,28 +283,36 @@ namespace mongo {
             }
         }
 
+        HashJob job;
+        BSONElement algorithm = cmdObj["algorithm"];
+        if ( !algorithm.eoo() ) {
+            if ( algorithm.type() != String ||
+                 ( algorithm.String() != "md5" && algorithm.String() != "murmur3" ) ) {
+                errmsg = "algorithm has to be \"md5\" or \"murmur3\"";
+                return false;
+            }
+            job.fastHash = algorithm.String() == "murmur3";
+        }
+        job.yield = cmdObj["yield"].trueValue();
+
         list<string> colls;
         const string ns = parseNs(dbname, cmdObj);
 
-        // We lock the entire database in S-mode in order to ensure that the contents will not
-        // change for the snapshot.
-        ScopedTransaction scopedXact(txn, MODE_IS);
-        AutoGetDb autoDb(txn, ns, MODE_S);
-        Database* db = autoDb.getDb();
-        if (db) {
-            db->getDatabaseCatalogEntry()->getCollectionNamespaces(&colls);
-            colls.sort();
+        // The database is only locked while its collections are listed. Each collection is then
+        // locked on its own while it is hashed.
+        {
+            ScopedTransaction scopedXact(txn, MODE_IS);
+            AutoGetDb autoDb(txn, ns, MODE_S);
+            Database* db = autoDb.getDb();
+            if (db) {
+                db->getDatabaseCatalogEntry()->getCollectionNamespaces(&colls);
+                colls.sort();
+            }
         }
 
         result.appendNumber( "numCollections" , (long long)colls.size() );
         result.append( "host" , prettyHostName() );
 
-        md5_state_t globalState;
-        md5_init(&globalState);
-
-        vector<string> cached;
-
-        BSONObjBuilder bb( result.subobjStart( "collections" ) );
         for ( list<string>::iterator i=colls.begin(); i != colls.end(); i++ ) {
             string fullCollectionName = *i;
             if ( fullCollectionName.size() -1 <= dbname.size() ) {
@@ -187,14 +328,38 @@ namespace mongo {
                  desiredCollections.count( shortCollectionName ) == 0 )
                 continue;
 
-            bool fromCache = false;
-            string hash = hashCollection( txn, db, fullCollectionName, &fromCache );
+            job.collections.push_back( fullCollectionName );
+        }
+        job.hashes.resize( job.collections.size() );
+        job.fromCache.resize( job.collections.size() );
+
+        // This thread takes part in the hashing too.
+        const int numThreads = std::min( std::max( dbHashParallelCollections, 1 ),
+                                         static_cast<int>( job.collections.size() ) );
+        boost::thread_group threads;
+        for ( int i = 1; i < numThreads; i++ ) {
+            threads.create_thread( stdx::bind( &DBHashCmd::runHashThread, this, &job ) );
+        }
+        hashCollections( txn, &job );
+        threads.join_all();
+
+        if ( !job.status.isOK() ) {
+            return appendCommandStatus( result, job.status );
+        }
 
-            bb.append( shortCollectionName, hash );
+        md5_state_t globalState;
+        md5_init(&globalState);
+
+        vector<string> cached;
+
+        BSONObjBuilder bb( result.subobjStart( "collections" ) );
+        for ( size_t i = 0; i < job.collections.size(); i++ ) {
+            const string& hash = job.hashes[i];
+            bb.append( job.collections[i].substr( dbname.size() + 1 ), hash );
 
             md5_append( &globalState , (const md5_byte_t*)hash.c_str() , hash.size() );
-            if ( fromCache )
-                cached.push_back( fullCollectionName );
+            if ( job.fromCache[i] )
+                cached.push_back( job.collections[i] );
         }
         bb.done();
 
@@ -54,7 +54,21 @@ namespace mongo {
 
         bool isCachable( const StringData& ns ) const;
 
-        std::string hashCollection( OperationContext* opCtx, Database* db, const std::string& fullCollectionName, bool* fromCache );
+        struct HashJob;
+
+        /**
+         * Hashes one collection under its own lock. With 'yield', the scan gives up its locks
+         * periodically so writers can proceed, and the hash is not of a single snapshot.
+         */
+        std::string hashCollection( OperationContext* opCtx,
+                                    const std::string& fullCollectionName,
+                                    bool fastHash,
+                                    bool yield,
+                                    bool* fromCache );
+
+        void hashCollections( OperationContext* opCtx, HashJob* job );
+
+        void runHashThread( HashJob* job );
 
         std::map<std::string,std::string> _cachedHashed;
         mutex _cachedHashedMutex;
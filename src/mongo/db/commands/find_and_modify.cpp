@@ -36,12 +36,15 @@
 
 #include "mongo/db/commands.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
-#include "mongo/db/dbhelpers.h"
+#include "mongo/db/exec/delete.h"
+#include "mongo/db/exec/update.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/projection.h"
-#include "mongo/db/ops/delete.h"
-#include "mongo/db/ops/update.h"
+#include "mongo/db/ops/delete_request.h"
+#include "mongo/db/ops/parsed_delete.h"
+#include "mongo/db/ops/parsed_update.h"
 #include "mongo/db/ops/update_lifecycle_impl.h"
+#include "mongo/db/ops/update_request.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/util/log.h"
 
@@ -188,6 +191,35 @@ namespace mongo {
             result.append( "value" , p.transform( doc ) );
         }
 
+        /**
+         * Runs 'exec', a single update or delete which returns the document it changes, to the
+         * end. Returns whether there was a document, which is then in 'doc'.
+         */
+        static bool _runToCompletion(PlanExecutor* exec, BSONObj* doc) {
+            bool found = false;
+            BSONObj obj;
+            PlanExecutor::ExecState state;
+            while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, NULL))) {
+                *doc = obj.getOwned();
+                found = true;
+            }
+
+            if (PlanExecutor::FAILURE == state || PlanExecutor::DEAD == state) {
+                if (PlanExecutor::FAILURE == state &&
+                    WorkingSetCommon::isValidStatusMemberObject(obj)) {
+                    const Status errorStatus = WorkingSetCommon::getMemberObjectStatus(obj);
+                    invariant(!errorStatus.isOK());
+                    uasserted(errorStatus.code(), errorStatus.reason());
+                }
+                uasserted(ErrorCodes::OperationFailed,
+                          str::stream() << "executor returned " << PlanExecutor::statestr(state)
+                                        << " while modifying document");
+            }
+            invariant(PlanExecutor::IS_EOF == state);
+
+            return found;
+        }
+
         static bool runImpl(OperationContext* txn,
                             const string& ns,
                             const BSONObj& query,
@@ -218,183 +250,67 @@ namespace mongo {
                 return false;
             }
 
+            const NamespaceString requestNs(ns);
             BSONObj doc;
-            bool found = false;
-            {
-                CanonicalQuery* cq;
-                const BSONObj projection;
-                const long long skip = 0;
-                const long long limit = -1; // 1 document requested; negative indicates hard limit.
-                uassertStatusOK(CanonicalQuery::canonicalize(ns,
-                                                             query,
-                                                             sort,
-                                                             projection,
-                                                             skip,
-                                                             limit,
-                                                             &cq,
-                                                             whereCallback));
-
-                PlanExecutor* rawExec;
-                uassertStatusOK(getExecutor(txn,
-                                            collection,
-                                            cq,
-                                            PlanExecutor::YIELD_AUTO,
-                                            &rawExec,
-                                            QueryPlannerParams::DEFAULT));
-
-                scoped_ptr<PlanExecutor> exec(rawExec);
-
-                PlanExecutor::ExecState state = exec->getNext(&doc, NULL);
-                if (PlanExecutor::ADVANCED == state) {
-                    found = true;
-                }
-                else if (PlanExecutor::FAILURE == state || PlanExecutor::DEAD == state) {
-                    if (PlanExecutor::FAILURE == state &&
-                        WorkingSetCommon::isValidStatusMemberObject(doc)) {
-                        const Status errorStatus = WorkingSetCommon::getMemberObjectStatus(doc);
-                        invariant(!errorStatus.isOK());
-                        uasserted(errorStatus.code(), errorStatus.reason());
-                    }
-                    uasserted(ErrorCodes::OperationFailed,
-                              str::stream() << "executor returned " << PlanExecutor::statestr(state)
-                                            << " while finding document to update");
-                }
-                else {
-                    invariant(PlanExecutor::IS_EOF == state);
-                }
-            }
-
-            BSONObj queryModified = query;
-            if (found && !doc["_id"].eoo() && !CanonicalQuery::isSimpleIdQuery(query)) {
-                // we're going to re-write the query to be more efficient
-                // we have to be a little careful because of positional operators
-                // maybe we can pass this all through eventually, but right now isn't an easy way
-                
-                bool hasPositionalUpdate = false;
-                {
-                    // if the update has a positional piece ($)
-                    // then we need to pull all query parts in
-                    // so here we check for $
-                    // a little hacky
-                    BSONObjIterator i( update );
-                    while ( i.more() ) {
-                        const BSONElement& elem = i.next();
-                        
-                        if ( elem.fieldName()[0] != '$' || elem.type() != Object )
-                            continue;
-
-                        BSONObjIterator j( elem.Obj() );
-                        while ( j.more() ) {
-                            if ( str::contains( j.next().fieldName(), ".$" ) ) {
-                                hasPositionalUpdate = true;
-                                break;
-                            }
-                        }
-                    }
-                }
-
-                BSONObjBuilder b(query.objsize() + 10);
-                b.append( doc["_id"] );
-                
-                bool addedAtomic = false;
-
-                BSONObjIterator i(query);
-                while ( i.more() ) {
-                    const BSONElement& elem = i.next();
 
-                    if ( str::equals( "_id" , elem.fieldName() ) ) {
-                        // we already do _id
-                        continue;
-                    }
-                    
-                    if ( ! hasPositionalUpdate ) {
-                        // if there is a dotted field, accept we may need more query parts
-                        continue;
-                    }
-                    
-                    if ( ! addedAtomic ) {
-                        b.appendBool( "$atomic" , true );
-                        addedAtomic = true;
-                    }
+            if ( remove ) {
+                DeleteRequest request(requestNs);
+                request.setQuery(query);
+                request.setSort(sort);
+                request.setMulti(false);
+                request.setUpdateOpLog();
+                request.setReturnDeleted();
+                request.setYieldPolicy(PlanExecutor::YIELD_AUTO);
 
-                    b.append( elem );
-                }
+                ParsedDelete parsedDelete(txn, &request);
+                uassertStatusOK(parsedDelete.parseRequest());
 
-                queryModified = b.obj();
-            }
+                PlanExecutor* rawExec;
+                uassertStatusOK(getExecutorDelete(txn, collection, &parsedDelete, &rawExec));
+                scoped_ptr<PlanExecutor> exec(rawExec);
 
-            if ( remove ) {
+                const bool found = _runToCompletion(exec.get(), &doc);
                 _appendHelper(result, doc, found, fields, whereCallback);
                 if ( found ) {
-                    deleteObjects(txn, cx.db(), ns, queryModified, PlanExecutor::YIELD_AUTO,
-                                  true, true);
                     BSONObjBuilder le( result.subobjStart( "lastErrorObject" ) );
                     le.appendNumber( "n" , 1 );
                     le.done();
                 }
             }
             else {
-                // update
-                if ( ! found && ! upsert ) {
-                    // didn't have it, and am not upserting
-                    _appendHelper(result, doc, found, fields, whereCallback);
-                }
-                else {
-                    // we found it or we're updating
-                    
-                    if ( ! returnNew ) {
-                        _appendHelper(result, doc, found, fields, whereCallback);
-                    }
-                    
-                    const NamespaceString requestNs(ns);
-                    UpdateRequest request(requestNs);
-
-                    request.setQuery(queryModified);
-                    request.setUpdates(update);
-                    request.setUpsert(upsert);
-                    request.setUpdateOpLog();
-
-                    request.setYieldPolicy(PlanExecutor::YIELD_AUTO);
-
-                    // TODO(greg) We need to send if we are ignoring
-                    // the shard version below, but for now no
-                    UpdateLifecycleImpl updateLifecycle(false, requestNs);
-                    request.setLifecycle(&updateLifecycle);
-                    UpdateResult res = mongo::update(txn,
-                                                     cx.db(),
-                                                     request,
-                                                     &txn->getCurOp()->debug());
-
-                    if ( !collection ) {
-                        // collection created by an upsert
-                        collection = cx.getCollection();
-                    }
+                UpdateRequest request(requestNs);
+                request.setQuery(query);
+                request.setSort(sort);
+                request.setUpdates(update);
+                request.setUpsert(upsert);
+                request.setUpdateOpLog();
+                request.setReturnDocs(returnNew ? UpdateRequest::RETURN_NEW
+                                                : UpdateRequest::RETURN_OLD);
+                request.setYieldPolicy(PlanExecutor::YIELD_AUTO);
+
+                // TODO(greg) We need to send if we are ignoring
+                // the shard version below, but for now no
+                UpdateLifecycleImpl updateLifecycle(false, requestNs);
+                request.setLifecycle(&updateLifecycle);
+
+                ParsedUpdate parsedUpdate(txn, &request);
+                uassertStatusOK(parsedUpdate.parseRequest());
+
+                OpDebug* opDebug = &txn->getCurOp()->debug();
+                PlanExecutor* rawExec;
+                uassertStatusOK(getExecutorUpdate(txn, collection, &parsedUpdate, opDebug,
+                                                  &rawExec));
+                scoped_ptr<PlanExecutor> exec(rawExec);
 
-                    LOG(3) << "update result: "  << res ;
-                    if ( returnNew ) {
-                        if ( !res.upserted.isEmpty() ) {
-                            BSONElement upsertedElem = res.upserted[kUpsertedFieldName];
-                            LOG(3) << "using new _id to get new doc: "
-                                   << upsertedElem;
-                            queryModified = upsertedElem.wrap("_id");
-                        }
-                        else if ( queryModified["_id"].type() ) {
-                            // we do this so that if the update changes the fields, it still matches
-                            queryModified = queryModified["_id"].wrap();
-                        }
-
-                        LOG(3) << "using modified query to return the new doc: " << queryModified;
-                        if ( ! Helpers::findOne( txn, collection, queryModified, doc ) ) {
-                            errmsg = str::stream() << "can't find object after modification  " 
-                                                   << " ns: " << ns 
-                                                   << " queryModified: " << queryModified 
-                                                   << " queryOriginal: " << query;
-                            log() << errmsg << endl;
-                            return false;
-                        }
-                        _appendHelper(result, doc, true, fields, whereCallback);
-                    }
-                    
+                // The plan returns the document as it was before the update, or as it is after
+                // it, from the same pass that updates it.
+                const bool found = _runToCompletion(exec.get(), &doc);
+                UpdateResult res = UpdateStage::makeUpdateResult(exec.get(), opDebug);
+                LOG(3) << "update result: "  << res ;
+
+                _appendHelper(result, doc, found, fields, whereCallback);
+
+                if ( found || upsert ) {
                     BSONObjBuilder le( result.subobjStart( "lastErrorObject" ) );
                     le.appendBool( "updatedExisting" , res.existing );
                     le.appendNumber( "n" , res.numMatched );
@@ -402,7 +318,6 @@ namespace mongo {
                         le.append( res.upserted[kUpsertedFieldName] );
                     }
                     le.done();
-                    
                 }
             }
 
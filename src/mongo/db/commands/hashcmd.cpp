@@ -61,7 +61,7 @@ namespace mongo {
         }
 
         /* CmdObj has the form {"hash" : <thingToHash>}
-         * or {"hash" : <thingToHash>, "seed" : <number> }
+         * or {"hash" : <thingToHash>, "seed" : <number>, "hashVersion" : <number> }
          * Result has the form
          * {"key" : <thingTohash>, "seed" : <int>, "out": NumberLong(<hash>)}
          *
@@ -89,7 +89,17 @@ namespace mongo {
             }
             result.append( "seed" , seed );
 
-            result.append( "out" , BSONElementHasher::hash64( cmdObj.firstElement() , seed ) );
+            int hashVersion = MD5_HASH_VERSION;
+            if (cmdObj.hasField("hashVersion")) {
+                hashVersion = cmdObj["hashVersion"].numberInt();
+                if (!cmdObj["hashVersion"].isNumber() || !isValidHashVersion(hashVersion)) {
+                    errmsg += "unsupported hashVersion";
+                    return false;
+                }
+            }
+
+            result.append( "out" ,
+                           BSONElementHasher::hash64( cmdObj.firstElement() , seed , hashVersion ) );
             return true;
         }
     };
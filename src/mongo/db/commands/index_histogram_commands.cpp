@@ -0,0 +1,220 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
+#include "mongo/db/query/index_histogram.h"
+#include "mongo/db/query/internal_plans.h"
+#include "mongo/platform/random.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    using boost::shared_ptr;
+    using std::auto_ptr;
+    using std::string;
+    using std::stringstream;
+    using std::vector;
+
+    /**
+     * Builds histograms of the keys of the indexes of a collection, which the planner uses to
+     * prune candidate plans.
+     *
+     * Format:
+     * {
+     *   buildIndexHistograms: <collection name>,
+     *   index: <index name>,          // optional, defaults to every index that can have one
+     *   buckets: <number of buckets>, // optional, defaults to 100
+     *   sampleSize: <number of keys>  // optional, defaults to 10000
+     * }
+     *
+     * Return format:
+     * {
+     *   histograms: [ { name: <index name>, key: <key pattern>, numKeys: ..., buckets: [...] } ]
+     * }
+     */
+    class CmdBuildIndexHistograms : public Command {
+    public:
+        CmdBuildIndexHistograms() : Command("buildIndexHistograms") {}
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+
+        virtual void help(stringstream& help) const {
+            help << "build the key histograms of the indexes of a collection, for the planner";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::planCacheWrite);
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+
+        bool run(OperationContext* txn,
+                 const string& dbname,
+                 BSONObj& cmdObj,
+                 int,
+                 string& errmsg,
+                 BSONObjBuilder& result,
+                 bool /*fromRepl*/) {
+
+            const NamespaceString ns(parseNs(dbname, cmdObj));
+            if (!ns.isValid() || ns.coll().empty()) {
+                return appendCommandStatus(result, Status(ErrorCodes::InvalidNamespace,
+                                                          "invalid collection name"));
+            }
+
+            const string indexName = cmdObj["index"].str();
+
+            long long numBuckets = 100;
+            if (cmdObj.hasField("buckets")) {
+                if (!cmdObj["buckets"].isNumber() || cmdObj["buckets"].numberLong() < 1) {
+                    return appendCommandStatus(result, Status(ErrorCodes::BadValue,
+                                                              "buckets must be a positive number"));
+                }
+                numBuckets = cmdObj["buckets"].numberLong();
+            }
+
+            long long sampleSize = 10000;
+            if (cmdObj.hasField("sampleSize")) {
+                if (!cmdObj["sampleSize"].isNumber() || cmdObj["sampleSize"].numberLong() < 1) {
+                    return appendCommandStatus(
+                        result,
+                        Status(ErrorCodes::BadValue, "sampleSize must be a positive number"));
+                }
+                sampleSize = cmdObj["sampleSize"].numberLong();
+            }
+
+            AutoGetCollectionForRead ctx(txn, ns);
+            Collection* collection = ctx.getCollection();
+            if (!collection) {
+                return appendCommandStatus(result, Status(ErrorCodes::NamespaceNotFound,
+                                                          "collection not found"));
+            }
+
+            IndexStatistics* stats = collection->infoCache()->getIndexStatistics();
+
+            vector<IndexDescriptor*> indexes;
+            IndexCatalog::IndexIterator it =
+                collection->getIndexCatalog()->getIndexIterator(txn, false);
+            while (it.more()) {
+                IndexDescriptor* desc = it.next();
+                if (!indexName.empty() && desc->indexName() != indexName) {
+                    continue;
+                }
+
+                // Only indexes whose keys are the values of their fields have bounds we can
+                // estimate with.
+                const string& type = desc->getAccessMethodName();
+                if (type != IndexNames::BTREE && type != IndexNames::HASHED) {
+                    continue;
+                }
+                indexes.push_back(desc);
+            }
+
+            if (!indexName.empty() && indexes.empty()) {
+                return appendCommandStatus(result, Status(ErrorCodes::IndexNotFound,
+                                                          "no index with a histogram named "
+                                                          + indexName));
+            }
+
+            PseudoRandom random(static_cast<int64_t>(curTimeMicros64()));
+
+            BSONArrayBuilder histograms(result.subarrayStart("histograms"));
+            for (size_t i = 0; i < indexes.size(); ++i) {
+                const string name = indexes[i]->indexName();
+                const BSONObj keyPattern = indexes[i]->keyPattern().getOwned();
+                const long long writeOps = stats->writeOps();
+
+                auto_ptr<PlanExecutor> exec(
+                    InternalPlanner::indexScan(txn, collection, indexes[i],
+                                               BSONObj(), BSONObj(), false));
+                exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
+
+                // Take a uniform sample of the first fields of the keys.
+                vector<BSONObj> sample;
+                long long numKeys = 0;
+                BSONObj key;
+                PlanExecutor::ExecState state;
+                while (PlanExecutor::ADVANCED == (state = exec->getNext(&key, NULL))) {
+                    ++numKeys;
+                    if (static_cast<long long>(sample.size()) < sampleSize) {
+                        sample.push_back(key.firstElement().wrap(""));
+                    }
+                    else {
+                        long long slot = random.nextInt64(numKeys);
+                        if (slot < sampleSize) {
+                            sample[slot] = key.firstElement().wrap("");
+                        }
+                    }
+                }
+
+                if (PlanExecutor::IS_EOF != state) {
+                    histograms.doneFast();
+                    return appendCommandStatus(
+                        result,
+                        Status(ErrorCodes::OperationFailed,
+                               str::stream() << "scan of index " << name << " failed: "
+                                             << WorkingSetCommon::toStatusString(key)));
+                }
+
+                shared_ptr<const IndexHistogram> hist(
+                    new IndexHistogram(sample, numKeys, numBuckets, writeOps));
+                stats->set(keyPattern, hist);
+
+                BSONObjBuilder histBuilder(histograms.subobjStart());
+                histBuilder.append("name", name);
+                histBuilder.append("key", keyPattern);
+                hist->toBSON(&histBuilder);
+                histBuilder.doneFast();
+            }
+            histograms.doneFast();
+
+            return true;
+        }
+
+    } cmdBuildIndexHistograms;
+
+}  // namespace mongo
@@ -31,6 +31,8 @@
 #include "mongo/platform/basic.h"
 
 #include <boost/scoped_ptr.hpp>
+#include <set>
+#include <string>
 
 #include "mongo/db/catalog/collection_catalog_entry.h"
 #include "mongo/db/catalog/cursor_manager.h"
@@ -50,6 +52,66 @@ namespace mongo {
 
     using boost::scoped_ptr;
 
+namespace {
+
+    /**
+     * Whether 'filter' only looks at the collection name, so that it can be matched before the
+     * options are read from the catalog.
+     */
+    bool filterOnlyOnName(const BSONObj& filter) {
+        BSONObjIterator i(filter);
+        while (i.more()) {
+            BSONElement e = i.next();
+            StringData field = e.fieldNameStringData();
+            if (field == "$and" || field == "$or" || field == "$nor") {
+                if (e.type() != Array) {
+                    return false;
+                }
+                BSONObjIterator clauses(e.Obj());
+                while (clauses.more()) {
+                    BSONElement clause = clauses.next();
+                    if (clause.type() != Object || !filterOnlyOnName(clause.Obj())) {
+                        return false;
+                    }
+                }
+            }
+            else if (field != "name" && !field.startsWith("name.")) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * If 'filter' requires the name to be one of a set of strings, fills 'names' with them and
+     * returns true, so that only those collections need to be looked up.
+     */
+    bool getNamesFromFilter(const BSONObj& filter, std::set<std::string>* names) {
+        BSONElement name = filter["name"];
+        if (name.type() == String) {
+            names->insert(name.String());
+            return true;
+        }
+        if (name.type() != Object || name.Obj().nFields() != 1) {
+            return false;
+        }
+        BSONElement in = name.Obj()["$in"];
+        if (in.type() != Array) {
+            return false;
+        }
+        BSONObjIterator i(in.Obj());
+        while (i.more()) {
+            BSONElement e = i.next();
+            if (e.type() != String) {
+                return false;
+            }
+            names->insert(e.String());
+        }
+        return true;
+    }
+
+} // namespace
+
     class CmdListCollections : public Command {
     public:
         virtual bool slaveOk() const { return false; }
@@ -77,6 +139,9 @@ namespace mongo {
                  BSONObjBuilder& result,
                  bool /*fromRepl*/) {
             boost::scoped_ptr<MatchExpression> matcher;
+            bool matchOnNameOnly = false;
+            std::set<std::string> filterNames;
+            bool haveFilterNames = false;
             BSONElement filterElt = jsobj["filter"];
             if (!filterElt.eoo()) {
                 if (filterElt.type() != mongo::Object) {
@@ -89,6 +154,8 @@ namespace mongo {
                     return appendCommandStatus(result, statusWithMatcher.getStatus());
                 }
                 matcher.reset(statusWithMatcher.getValue());
+                matchOnNameOnly = filterOnlyOnName(filterElt.Obj());
+                haveFilterNames = getNamesFromFilter(filterElt.Obj(), &filterNames);
             }
 
             const long long defaultBatchSize = std::numeric_limits<long long>::max();
@@ -106,10 +173,24 @@ namespace mongo {
             const Database* d = autoDb.getDb();
             const DatabaseCatalogEntry* dbEntry = NULL;
 
+            // A filter on the name only needs the collections it names to be looked up, in
+            // the same order as the full listing.
             list<string> names;
             if ( d ) {
                 dbEntry = d->getDatabaseCatalogEntry();
-                dbEntry->getCollectionNamespaces( &names );
+                if ( haveFilterNames ) {
+                    for ( std::set<std::string>::const_iterator i = filterNames.begin();
+                          i != filterNames.end();
+                          ++i ) {
+                        const std::string ns = dbname + "." + *i;
+                        if ( dbEntry->getCollectionCatalogEntry( ns ) ) {
+                            names.push_back( ns );
+                        }
+                    }
+                }
+                else {
+                    dbEntry->getCollectionNamespaces( &names );
+                }
                 names.sort();
             }
 
@@ -126,6 +207,13 @@ namespace mongo {
                     continue;
                 }
 
+                // Reading the options is the expensive part, so skip it for collections a
+                // filter on the name alone rules out.
+                if ( matchOnNameOnly &&
+                     !matcher->matchesBSON( BSON( "name" << collection ) ) ) {
+                    continue;
+                }
+
                 BSONObjBuilder b;
                 b.append( "name", collection );
 
@@ -134,7 +222,7 @@ namespace mongo {
                 b.append( "options", options.toBSON() );
 
                 BSONObj maybe = b.obj();
-                if ( matcher && !matcher->matchesBSON( maybe ) ) {
+                if ( matcher && !matchOnNameOnly && !matcher->matchesBSON( maybe ) ) {
                     continue;
                 }
 
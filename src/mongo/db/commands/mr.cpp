@@ -35,6 +35,8 @@
 #include "mongo/db/commands/mr.h"
 
 #include <boost/scoped_ptr.hpp>
+#include <limits>
+#include <pcrecpp.h>
 
 #include "mongo/client/connpool.h"
 #include "mongo/client/parallel.h"
@@ -65,6 +67,7 @@
 #include "mongo/s/stale_exception.h"
 #include "mongo/util/log.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/stringutils.h"
 
 namespace mongo {
 
@@ -251,6 +254,258 @@ namespace mongo {
             _reduce( x , key , endSizeEstimate );
         }
 
+        namespace {
+
+            // A JavaScript identifier and a dotted path of them.
+            const std::string kIdent = "[A-Za-z_$][\\w$]*";
+            const std::string kPath = kIdent + "(?:\\." + kIdent + ")*";
+
+            // Reading these from a document that lacks them gives a function, not undefined.
+            const char* const kObjectPrototypeFields[] = {
+                "constructor", "hasOwnProperty", "isPrototypeOf", "propertyIsEnumerable",
+                "toLocaleString", "toString", "valueOf", "__proto__", "__defineGetter__",
+                "__defineSetter__", "__lookupGetter__", "__lookupSetter__",
+            };
+
+            bool isPlainPath( const std::string& path ) {
+                std::vector<std::string> parts;
+                splitStringDelim( path, &parts, '.' );
+                for ( size_t i = 0; i < parts.size(); i++ ) {
+                    for ( size_t j = 0; j < sizeof(kObjectPrototypeFields) / sizeof(char*); j++ ) {
+                        if ( parts[i] == kObjectPrototypeFields[j] )
+                            return false;
+                    }
+                }
+                return true;
+            }
+
+            /**
+             * Sets 'out' to what 'this.<path>' reads from 'obj' (EOO for undefined). Returns false
+             * if that depends on JavaScript semantics, i.e. an intermediate field isn't an object.
+             */
+            bool lookupPath( const BSONObj& obj , const std::string& path , BSONElement* out ) {
+                BSONObj cur = obj;
+                size_t start = 0;
+                while ( true ) {
+                    size_t dot = path.find( '.', start );
+                    BSONElement e = cur.getField( StringData( path ).substr( start, dot - start ) );
+                    if ( dot == std::string::npos ) {
+                        *out = e;
+                        return true;
+                    }
+                    if ( e.type() != Object )
+                        return false;
+                    cur = e.embeddedObject();
+                    start = dot + 1;
+                }
+            }
+
+            double jsMax( double a , double b ) {
+                if ( a != a || b != b )
+                    return std::numeric_limits<double>::quiet_NaN();
+                if ( a == 0 && b == 0 )
+                    return 1 / a > 0 ? a : b; // +0 > -0
+                return a > b ? a : b;
+            }
+
+            double jsMin( double a , double b ) {
+                if ( a != a || b != b )
+                    return std::numeric_limits<double>::quiet_NaN();
+                if ( a == 0 && b == 0 )
+                    return 1 / a < 0 ? a : b;
+                return a < b ? a : b;
+            }
+
+        } // namespace
+
+        NativeMapper* NativeMapper::parse( const BSONElement& code ) {
+            if ( code.type() != Code && code.type() != String )
+                return NULL;
+
+            static const pcrecpp::RE re(
+                "\\s*function\\s*(?:" + kIdent + ")?\\s*\\(\\s*\\)\\s*\\{\\s*"
+                "emit\\s*\\(\\s*this\\.(" + kPath + ")\\s*,\\s*"
+                "(?:this\\.(" + kPath + ")|(-?\\d+(?:\\.\\d+)?))\\s*\\)\\s*;?\\s*\\}\\s*" );
+
+            std::string keyPath;
+            std::string valuePath;
+            std::string valueConstant;
+            if ( !re.FullMatch( code._asCode(), &keyPath, &valuePath, &valueConstant ) )
+                return NULL;
+            if ( !isPlainPath( keyPath ) || !isPlainPath( valuePath ) )
+                return NULL;
+
+            NativeMapper* mapper = new NativeMapper( code );
+            mapper->_keyPath = keyPath;
+            mapper->_valuePath = valuePath;
+            mapper->_valueConstant = valuePath.empty() ? strtod( valueConstant.c_str(), NULL ) : 0;
+            return mapper;
+        }
+
+        void NativeMapper::init( State * state ) {
+            _js.init( state );
+            _state = state;
+        }
+
+        void NativeMapper::map( const BSONObj& o ) {
+            BSONElement key;
+            if ( !lookupPath( o, _keyPath, &key ) ) {
+                _js.map( o );
+                return;
+            }
+
+            double value = _valueConstant;
+            if ( !_valuePath.empty() ) {
+                BSONElement v;
+                if ( !lookupPath( o, _valuePath, &v ) ||
+                     ( v.type() != NumberDouble && v.type() != NumberInt ) ) {
+                    _js.map( o );
+                    return;
+                }
+                value = v.numberDouble();
+            }
+
+            BSONObjBuilder b;
+            switch ( key.type() ) {
+            case EOO:
+            case Undefined:
+            case jstNULL:
+                b.appendNull( "0" );
+                break;
+            case NumberInt:
+            case NumberDouble:
+                b.append( "0", key.numberDouble() );
+                break;
+            case String:
+            case jstOID:
+            case Bool:
+            case Date:
+                b.appendAs( key, "0" );
+                break;
+            default:
+                // Anything else may not come back from JavaScript the same.
+                _js.map( o );
+                return;
+            }
+            b.append( "1", value );
+
+            BSONObj tuple = b.obj();
+            uassert( 13069 , "an emit can't be more than half max bson size" , tuple.objsize() < ( BSONObjMaxUserSize / 2 ) );
+            _state->emit( tuple );
+        }
+
+        NativeReducer* NativeReducer::parse( const BSONElement& code ) {
+            if ( code.type() != Code && code.type() != String )
+                return NULL;
+
+            // Groups 1 and 2 are the key and values arguments.
+            const std::string head = "\\s*function\\s*(?:" + kIdent + ")?\\s*"
+                                     "\\(\\s*(" + kIdent + ")\\s*,\\s*(" + kIdent + ")\\s*\\)\\s*\\{\\s*";
+            const std::string tail = "\\s*;?\\s*\\}\\s*";
+
+            static const pcrecpp::RE arraySum(
+                head + "return\\s+Array\\.sum\\s*\\(\\s*\\2\\s*\\)" + tail );
+            static const pcrecpp::RE mathApply(
+                head + "return\\s+Math\\.(max|min)\\.apply\\s*\\(\\s*(?:Math|null|this)\\s*,"
+                "\\s*\\2\\s*\\)" + tail );
+            // var s = 0; for (var i = 0; i < values.length; i++) s += values[i]; return s;
+            static const pcrecpp::RE forLoop(
+                head + "var\\s+(" + kIdent + ")\\s*=\\s*0\\s*;\\s*"
+                "for\\s*\\(\\s*var\\s+(" + kIdent + ")\\s*=\\s*0\\s*;\\s*\\4\\s*<\\s*\\2\\.length\\s*;"
+                "\\s*(?:\\4\\s*\\+\\+|\\+\\+\\s*\\4|\\4\\s*\\+=\\s*1)\\s*\\)\\s*"
+                "(?:\\{\\s*\\3\\s*\\+=\\s*\\2\\s*\\[\\s*\\4\\s*\\]\\s*;?\\s*\\}|"
+                "\\3\\s*\\+=\\s*\\2\\s*\\[\\s*\\4\\s*\\]\\s*;)\\s*"
+                "return\\s+\\3" + tail );
+            // var s = 0; values.forEach(function(v) { s += v; }); return s;
+            static const pcrecpp::RE forEach(
+                head + "var\\s+(" + kIdent + ")\\s*=\\s*0\\s*;\\s*"
+                "\\2\\.forEach\\s*\\(\\s*function\\s*\\(\\s*(" + kIdent + ")\\s*\\)\\s*"
+                "\\{\\s*\\3\\s*\\+=\\s*\\4\\s*;?\\s*\\}\\s*\\)\\s*;?\\s*"
+                "return\\s+\\3" + tail );
+
+            const std::string js = code._asCode();
+            std::string key;
+            std::string values;
+            std::string a;
+            std::string b;
+            if ( arraySum.FullMatch( js, &key, &values ) )
+                return new NativeReducer( code, SUM );
+            if ( mathApply.FullMatch( js, &key, &values, &a ) )
+                return new NativeReducer( code, a == "max" ? MAX : MIN );
+            if ( ( forLoop.FullMatch( js, &key, &values, &a, &b ) ||
+                   forEach.FullMatch( js, &key, &values, &a, &b ) ) &&
+                 a != values && a != b && b != values ) {
+                return new NativeReducer( code, SUM_FROM_ZERO );
+            }
+            return NULL;
+        }
+
+        bool NativeReducer::reduceValues( const BSONList& tuples , double* result ) const {
+            double r = 0;
+            for ( size_t i = 0; i < tuples.size(); i++ ) {
+                BSONObjIterator it( tuples[i] );
+                it.next();
+                BSONElement e = it.next();
+                if ( e.type() != NumberDouble )
+                    return false;
+
+                double v = e.Double();
+                if ( i == 0 && _op != SUM_FROM_ZERO ) {
+                    r = v;
+                    continue;
+                }
+                switch ( _op ) {
+                case SUM:
+                case SUM_FROM_ZERO: r += v; break;
+                case MIN: r = jsMin( r, v ); break;
+                case MAX: r = jsMax( r, v ); break;
+                }
+            }
+            *result = r;
+            return true;
+        }
+
+        BSONObj NativeReducer::reduce( const BSONList& tuples ) {
+            if ( tuples.size() <= 1 )
+                return tuples[0];
+
+            double result;
+            if ( !reduceValues( tuples, &result ) ) {
+                long long before = _js.numReduces;
+                BSONObj res = _js.reduce( tuples );
+                numReduces += _js.numReduces - before;
+                return res;
+            }
+
+            ++numReduces;
+            BSONObjBuilder b;
+            b.appendAs( tuples[0].firstElement() , "0" );
+            b.append( "1", result );
+            return b.obj();
+        }
+
+        BSONObj NativeReducer::finalReduce( const BSONList& tuples , Finalizer * finalizer ) {
+            double result;
+            if ( tuples.size() == 1 || !reduceValues( tuples, &result ) ) {
+                long long before = _js.numReduces;
+                BSONObj res = _js.finalReduce( tuples, finalizer );
+                numReduces += _js.numReduces - before;
+                return res;
+            }
+
+            ++numReduces;
+            BSONObjBuilder b;
+            b.appendAs( tuples[0].firstElement() , "_id" );
+            b.append( "value", result );
+            BSONObj res = b.obj();
+
+            if ( finalizer ) {
+                res = finalizer->finalize( res );
+            }
+
+            return res;
+        }
+
         Config::Config( const string& _dbname , const BSONObj& cmdObj )
         {
             dbname = _dbname;
@@ -294,8 +549,16 @@ namespace mongo {
                 if ( cmdObj["scope"].type() == Object )
                     scopeSetup = cmdObj["scope"].embeddedObjectUserCheck();
 
-                mapper.reset( new JSMapper( cmdObj["map"] ) );
-                reducer.reset( new JSReducer( cmdObj["reduce"] ) );
+                // Common map and reduce functions run natively, unless they run in a single JS
+                // scope or may depend on what the user put in it.
+                if ( !jsMode && scopeSetup.isEmpty() && cmdObj["mapparams"].eoo() ) {
+                    mapper.reset( NativeMapper::parse( cmdObj["map"] ) );
+                    reducer.reset( NativeReducer::parse( cmdObj["reduce"] ) );
+                }
+                if ( !mapper )
+                    mapper.reset( new JSMapper( cmdObj["map"] ) );
+                if ( !reducer )
+                    reducer.reset( new JSReducer( cmdObj["reduce"] ) );
                 if ( cmdObj["finalize"].type() && cmdObj["finalize"].trueValue() )
                     finalizer.reset( new JSFinalizer( cmdObj["finalize"] ) );
 
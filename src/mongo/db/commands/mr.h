@@ -157,6 +157,65 @@ namespace mongo {
 
         };
 
+        // ------------  native implementations -----------
+
+        /**
+         * Runs map functions of the form
+         *     function() { emit(this.<path>, this.<path> or <number>); }
+         * without JavaScript, emitting what the function would: numbers as doubles, and a missing
+         * key as null. Documents whose key isn't a simple scalar, or whose value isn't a number,
+         * go through the JavaScript function instead.
+         */
+        class NativeMapper : public Mapper {
+        public:
+            /// Returns a mapper for 'code' if it has the form above, NULL otherwise.
+            static NativeMapper* parse( const BSONElement& code );
+
+            virtual void init( State * state );
+            virtual void map( const BSONObj& o );
+
+        private:
+            NativeMapper( const BSONElement& code ) : _js( code ), _state( NULL ) {}
+
+            JSMapper _js;
+            State * _state;
+            std::string _keyPath;
+            std::string _valuePath; // empty if the function emits _valueConstant
+            double _valueConstant;
+        };
+
+        /**
+         * Runs reduce functions that sum their values, with Array.sum() or a loop, or take their
+         * Math.min() or Math.max(), without JavaScript, with the same floating point results.
+         * Lists of values that aren't all doubles go through the JavaScript function instead.
+         */
+        class NativeReducer : public Reducer {
+        public:
+            /// Returns a reducer for 'code' if it has one of the forms above, NULL otherwise.
+            static NativeReducer* parse( const BSONElement& code );
+
+            virtual void init( State * state ) { _js.init( state ); }
+
+            virtual BSONObj reduce( const BSONList& tuples );
+            virtual BSONObj finalReduce( const BSONList& tuples , Finalizer * finalizer );
+
+        private:
+            enum Op {
+                SUM,            // Array.sum(values): values[0] + values[1] + ...
+                SUM_FROM_ZERO,  // a loop: 0 + values[0] + values[1] + ...
+                MIN,
+                MAX,
+            };
+
+            NativeReducer( const BSONElement& code , Op op ) : _js( code ), _op( op ) {}
+
+            /// Returns false if some value isn't a double.
+            bool reduceValues( const BSONList& tuples , double* result ) const;
+
+            JSReducer _js;
+            const Op _op;
+        };
+
         // -----------------
 
 
@@ -48,9 +48,12 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/pipeline_d.h"
 #include "mongo/db/pipeline/pipeline.h"
+#include "mongo/db/query/cursor_batch_budget.h"
 #include "mongo/db/query/find_constants.h"
 #include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/query_result_cache.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/s/d_state.h"
 
 namespace mongo {
 
@@ -78,7 +81,8 @@ namespace mongo {
 
         // can't use result BSONObjBuilder directly since it won't handle exceptions correctly.
         BSONArrayBuilder resultsArray;
-        const int byteLimit = MaxBytesToReturnToClientAtOnce;
+        // Without a pin there are no more batches, so this one can't be cut short.
+        const CursorBatchBudget budget(MaxBytesToReturnToClientAtOnce, pin != NULL);
         BSONObj next;
         for (int objCount = 0; objCount < batchSize; objCount++) {
             // The initial getNext() on a PipelineProxyStage may be very expensive so we don't
@@ -91,7 +95,7 @@ namespace mongo {
                 break;
             }
 
-            if (resultsArray.len() + next.objsize() > byteLimit) {
+            if (resultsArray.len() + next.objsize() > budget.maxBytes()) {
                 // Get the pipeline proxy stage wrapped by this PlanExecutor.
                 PipelineProxyStage* proxy = static_cast<PipelineProxyStage*>(exec->getRootStage());
                 // too big. next will be the first doc in the second batch
@@ -100,6 +104,10 @@ namespace mongo {
             }
 
             resultsArray.append(next);
+
+            if (budget.enough(objCount + 1, resultsArray.len())) {
+                break;
+            }
         }
 
         // NOTE: exec->isEOF() can have side effects such as writing by $out. However, it should
@@ -152,6 +160,7 @@ namespace mongo {
                  << ", explain: <bool>"
                  << ", allowDiskUse: <bool>"
                  << ", cursor: {batchSize: <number>}"
+                 << ", cacheResults: <bool>"
                  << " }"
                  << endl
                  << "See http://dochub.mongodb.org/core/aggregation for more details."
@@ -195,6 +204,15 @@ namespace mongo {
             }
 #endif
 
+            // Aggregations which asked for it are answered from the result cache as long as their
+            // collection has not been written since they last ran. Only pipelines reading nothing
+            // but an unsharded input collection qualify.
+            const bool canCacheResults = cmdObj["cacheResults"].trueValue()
+                && !pPipeline->isExplain()
+                && !pPipeline->touchesOtherCollections();
+            std::string resultCacheKey;
+            unsigned long long writeEpoch = 0;
+
             PlanExecutor* exec = NULL;
             scoped_ptr<ClientCursorPin> pin; // either this OR the execHolder will be non-null
             auto_ptr<PlanExecutor> execHolder;
@@ -209,6 +227,21 @@ namespace mongo {
 
                 Collection* collection = ctx.getCollection();
 
+                // The write epoch must be read before running the pipeline, so that a write
+                // committing meanwhile makes the results stale.
+                if (canCacheResults
+                    && collection
+                    && !shardingState.needCollectionMetadata(nss.ns())) {
+                    resultCacheKey = QueryResultCache::makeKey(nss.ns(), cmdObj);
+                    writeEpoch = collection->getWriteEpoch();
+
+                    QueryResultCache::Result cached;
+                    if (QueryResultCache::get()->lookup(resultCacheKey, writeEpoch, &cached)) {
+                        result.appendElements(BSONObj(cached.data.data()));
+                        return true;
+                    }
+                }
+
                 // This does mongod-specific stuff like creating the input PlanExecutor and adding
                 // it to the front of the pipeline if needed.
                 boost::shared_ptr<PlanExecutor> input = PipelineD::prepareCursorSource(txn,
@@ -292,6 +325,20 @@ namespace mongo {
             }
             // Any code that needs the cursor pinned must be inside the try block, above.
 
+            // Only results sent whole in this reply can be replayed from the cache.
+            if (!resultCacheKey.empty()) {
+                const BSONObj reply = result.asTempObj();
+                const BSONElement cursorId = reply.getObjectField("cursor")["id"];
+                if ((cursorId.eoo() || 0 == cursorId.numberLong())
+                    && static_cast<size_t>(reply.objsize())
+                        <= QueryResultCache::get()->maxResultBytes()) {
+                    QueryResultCache::Result toCache;
+                    toCache.data.assign(reply.objdata(), reply.objsize());
+                    toCache.numResults = 1;
+                    QueryResultCache::get()->insert(resultCacheKey, writeEpoch, toCache);
+                }
+            }
+
             return true;
         }
     } cmdPipeline;
@@ -0,0 +1,118 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/query/query_shape_stats.h"
+
+namespace mongo {
+
+    using std::string;
+    using std::stringstream;
+
+    /**
+     * Returns the execution counters of the queries on a collection, by query shape, costliest
+     * first, and optionally resets them.
+     *
+     * Format:
+     * {
+     *   queryShapeStats: <collection name>,
+     *   reset: <bool>  // optional, clears the counters after reading them
+     * }
+     *
+     * Return format:
+     * {
+     *   shapes: [ { query, sort, projection, count, totalMicros, maxMicros, keysExamined,
+     *               docsExamined, nReturned, planChanges, planSummary }, ... ],
+     *   dropped: <executions of shapes over internalQueryShapeStatsMaxShapes>
+     * }
+     */
+    class CmdQueryShapeStats : public Command {
+    public:
+        CmdQueryShapeStats() : Command("queryShapeStats") {}
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+
+        virtual void help(stringstream& help) const {
+            help << "execution counters of the queries on a collection, by query shape";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::planCacheRead);
+            if (cmdObj["reset"].trueValue()) {
+                actions.addAction(ActionType::planCacheWrite);
+            }
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+
+        bool run(OperationContext* txn,
+                 const string& dbname,
+                 BSONObj& cmdObj,
+                 int,
+                 string& errmsg,
+                 BSONObjBuilder& result,
+                 bool /*fromRepl*/) {
+
+            const NamespaceString ns(parseNs(dbname, cmdObj));
+            if (!ns.isValid() || ns.coll().empty()) {
+                return appendCommandStatus(result, Status(ErrorCodes::InvalidNamespace,
+                                                          "invalid collection name"));
+            }
+
+            AutoGetCollectionForRead ctx(txn, ns);
+            Collection* collection = ctx.getCollection();
+            if (!collection) {
+                return appendCommandStatus(result, Status(ErrorCodes::NamespaceNotFound,
+                                                          "collection not found"));
+            }
+
+            QueryShapeStats* stats = collection->infoCache()->getQueryShapeStats();
+            stats->toBSON(&result);
+            if (cmdObj["reset"].trueValue()) {
+                stats->clear();
+            }
+
+            return true;
+        }
+
+    } cmdQueryShapeStats;
+
+}  // namespace mongo
@@ -46,9 +46,12 @@
 #include "mongo/db/commands/server_status_internal.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/latency_histogram.h"
 #include "mongo/platform/process_id.h"
+#include "mongo/util/huge_pages.h"
 #include "mongo/util/log.h"
 #include "mongo/util/net/listen.h"
+#include "mongo/util/net/message_compressor.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
@@ -238,6 +241,45 @@ namespace mongo {
 
         } extraInfo;
 
+        /**
+         * Where this process' memory is, by NUMA node. Off by default, as it reads every mapping
+         * of the process.
+         */
+        class NumaInfo : public ServerStatusSection {
+        public:
+            NumaInfo() : ServerStatusSection( "numa" ){}
+            virtual bool includeByDefault() const { return false; }
+
+            BSONObj generateSection(OperationContext* txn,
+                                    const BSONElement& configElement) const {
+                ProcessInfo p;
+                const std::vector<std::vector<int> >& nodeCpus = p.getNumaNodeCpus();
+
+                BSONObjBuilder bb;
+                bb.append("numNodes", static_cast<int>(std::max<size_t>(nodeCpus.size(), 1)));
+                bb.append("interleaved", !nodeCpus.empty() && !p.hasNumaEnabled());
+                ProcessInfo::appendNumaStats(bb);
+                return bb.obj();
+            }
+
+        } numaInfo;
+
+        class HugePages : public ServerStatusSection {
+        public:
+            HugePages() : ServerStatusSection( "hugePages" ){}
+            virtual bool includeByDefault() const { return true; }
+
+            BSONObj generateSection(OperationContext* txn,
+                                    const BSONElement& configElement) const {
+                BSONObjBuilder bb;
+                bb.append("transparentBytes", hugePageStats.transparentBytes.load());
+                bb.append("explicitBytes", hugePageStats.explicitBytes.load());
+                bb.append("explicitFallbacks", hugePageStats.explicitFallbacks.load());
+                return bb.obj();
+            }
+
+        } hugePages;
+
 
         class Asserts : public ServerStatusSection {
         public:
@@ -269,11 +311,62 @@ namespace mongo {
 
                 BSONObjBuilder b;
                 networkCounter.append( b );
+                BSONObjBuilder compression( b.subobjStart( "compression" ) );
+                appendMessageCompressionStats( &compression );
+                compression.done();
                 return b.obj();
             }
                 
         } network;
 
+        /**
+         * Latency histograms by type of operation, see LatencyBuckets for the format.
+         */
+        class OpLatencies : public ServerStatusSection {
+        public:
+            OpLatencies() : ServerStatusSection( "opLatencies" ){}
+            virtual bool includeByDefault() const { return true; }
+
+            BSONObj generateSection(OperationContext* txn,
+                                    const BSONElement& configElement) const {
+
+                BSONObjBuilder b;
+                globalOpLatencyStats.append( &b );
+                return b.obj();
+            }
+
+        } opLatencies;
+
+        /**
+         * Latency histograms of each command that has run, by command name. Off by default since
+         * it is large; ask for it with { serverStatus: 1, commandLatencies: 1 }.
+         */
+        class CommandLatencies : public ServerStatusSection {
+        public:
+            CommandLatencies() : ServerStatusSection( "commandLatencies" ){}
+            virtual bool includeByDefault() const { return false; }
+
+            BSONObj generateSection(OperationContext* txn,
+                                    const BSONElement& configElement) const {
+
+                BSONObjBuilder b;
+                const Command::CommandMap* commands = Command::commandsByBestName();
+                for ( Command::CommandMap::const_iterator it = commands->begin();
+                      it != commands->end(); ++it ) {
+
+                    LatencyBuckets latency = it->second->getLatencyHistogram().snapshot();
+                    if ( latency.count == 0 )
+                        continue;
+
+                    BSONObjBuilder commandBuilder( b.subobjStart( it->first ) );
+                    latency.append( &commandBuilder );
+                    commandBuilder.done();
+                }
+                return b.obj();
+            }
+
+        } commandLatencies;
+
 #ifdef MONGO_SSL
         class Security : public ServerStatusSection {
         public:
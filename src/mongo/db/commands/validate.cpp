@@ -32,14 +32,287 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
+#include <boost/thread/thread.hpp>
+#include <string>
+#include <third_party/murmurhash3/MurmurHash3.h>
+#include <vector>
+
+#include "mongo/bson/bson_validate.h"
+#include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/hasher.h"
+#include "mongo/db/index/index_access_method.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/log.h"
+#include "mongo/util/progress_meter.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
+    // Number of indexes checked at the same time by a background validate, each by its own
+    // thread.
+    MONGO_EXPORT_SERVER_PARAMETER(backgroundValidateParallelIndexes, int, 4);
+
+namespace {
+
+    /**
+     * An order independent summary of a set of (key, RecordId) pairs. A consistent index gives
+     * the same sketch from a scan of the index as from generating its keys over a collection
+     * scan. Key values are hashed the way hashed indexes hash them, so keys which compare equal
+     * but are stored with different numeric types hash the same.
+     */
+    struct IndexSketch {
+        IndexSketch() : hash(0), count(0) {}
+
+        void add(const BSONObj& key, const RecordId& loc) {
+            uint64_t pair[2] = { 0, static_cast<uint64_t>(loc.repr()) };
+            BSONObjIterator i(key);
+            while (i.more()) {
+                pair[0] = pair[0] * 31 + static_cast<uint64_t>(BSONElementHasher::hash64(i.next(),
+                                                                                         0));
+            }
+            uint64_t out[2];
+            MurmurHash3_x64_128(pair, sizeof(pair), 0, out);
+            hash += out[0];
+            count++;
+        }
+
+        bool operator==(const IndexSketch& other) const {
+            return hash == other.hash && count == other.count;
+        }
+
+        uint64_t hash;
+        long long count;
+    };
+
+    struct IndexCheck {
+        explicit IndexCheck(const IndexDescriptor* descriptor)
+            : name(descriptor->indexName()),
+              indexNamespace(descriptor->indexNamespace()),
+              spec(descriptor->infoObj().getOwned()),
+              status(Status::OK()) {}
+
+        std::string name;
+        std::string indexNamespace;
+        BSONObj spec;
+
+        IndexSketch expected; // From the collection scan.
+        IndexSketch found; // From the index scan.
+        Status status;
+    };
+
+    /**
+     * The indexes one background validate checks, handed out to its threads one at a time.
+     */
+    struct BackgroundValidation {
+        explicit BackgroundValidation(const std::string& ns) : ns(ns) {}
+
+        const std::string ns;
+        std::vector<IndexCheck> indexes;
+
+        AtomicUInt32 next;
+        AtomicUInt32 threadsDone;
+        AtomicUInt64 keysChecked;
+        AtomicUInt32 stop;
+    };
+
+    /**
+     * Returns the index 'check' was made for, or NULL if it has been dropped or replaced.
+     */
+    const IndexDescriptor* findIndex(OperationContext* txn,
+                                     Collection* collection,
+                                     const IndexCheck& check) {
+        const IndexDescriptor* descriptor =
+            collection->getIndexCatalog()->findIndexByName(txn, check.name);
+        if (!descriptor || descriptor->infoObj() != check.spec) {
+            return NULL;
+        }
+        return descriptor;
+    }
+
+    Status indexChanged(const IndexCheck& check) {
+        return Status(ErrorCodes::OperationFailed,
+                      str::stream() << "index " << check.name
+                                    << " was dropped or changed during validation");
+    }
+
+    /**
+     * Scans the collection, validating each document's BSON and adding the keys each index
+     * should have for it to that index's expected sketch. With 'yield', the scan gives up its
+     * locks periodically.
+     */
+    Status sketchCollection(OperationContext* txn,
+                            Collection* collection,
+                            bool yield,
+                            BackgroundValidation* validation,
+                            long long* nrecords,
+                            ValidateResults* results) {
+        std::vector<IndexAccessMethod*> accessMethods(validation->indexes.size());
+        for (size_t i = 0; i < validation->indexes.size(); i++) {
+            const IndexDescriptor* descriptor =
+                findIndex(txn, collection, validation->indexes[i]);
+            if (!descriptor) {
+                return indexChanged(validation->indexes[i]);
+            }
+            accessMethods[i] = collection->getIndexCatalog()->getIndex(descriptor);
+        }
+
+        ProgressMeterHolder progress(*txn->setMessage("validate: scanning collection",
+                                                      "validate: scanning collection Progress",
+                                                      collection->numRecords(txn)));
+
+        boost::scoped_ptr<PlanExecutor> exec(InternalPlanner::collectionScan(txn,
+                                                                             validation->ns,
+                                                                             collection));
+        if (yield) {
+            exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
+        }
+
+        long long numYields = 0;
+        BSONObj obj;
+        RecordId loc;
+        PlanExecutor::ExecState state;
+        while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, &loc))) {
+            // Indexes may have been dropped while the locks were given up.
+            if (exec->getNumYields() != numYields) {
+                numYields = exec->getNumYields();
+                for (size_t i = 0; i < validation->indexes.size(); i++) {
+                    const IndexDescriptor* descriptor =
+                        findIndex(txn, collection, validation->indexes[i]);
+                    if (!descriptor) {
+                        return indexChanged(validation->indexes[i]);
+                    }
+                    accessMethods[i] = collection->getIndexCatalog()->getIndex(descriptor);
+                }
+            }
+
+            (*nrecords)++;
+            progress.hit();
+
+            Status status = validateBSON(obj.objdata(), obj.objsize());
+            if (!status.isOK()) {
+                results->errors.push_back(str::stream() << "invalid object at " << loc
+                                                        << ": " << status.reason());
+                results->valid = false;
+                continue;
+            }
+
+            for (size_t i = 0; i < validation->indexes.size(); i++) {
+                BSONObjSet keys;
+                accessMethods[i]->getKeys(obj, &keys);
+                for (BSONObjSet::const_iterator key = keys.begin(); key != keys.end(); ++key) {
+                    validation->indexes[i].expected.add(*key, loc);
+                }
+            }
+        }
+
+        if (PlanExecutor::IS_EOF != state) {
+            return Status(ErrorCodes::NamespaceNotFound,
+                          str::stream() << "collection " << validation->ns
+                                        << " was dropped during validation");
+        }
+        return Status::OK();
+    }
+
+    /**
+     * Scans the index of 'check' into its found sketch.
+     */
+    Status sketchIndex(OperationContext* txn,
+                       Collection* collection,
+                       bool yield,
+                       BackgroundValidation* validation,
+                       IndexCheck* check) {
+        const IndexDescriptor* descriptor = findIndex(txn, collection, *check);
+        if (!descriptor) {
+            return indexChanged(*check);
+        }
+
+        boost::scoped_ptr<PlanExecutor> exec(InternalPlanner::indexScan(txn,
+                                                                        collection,
+                                                                        descriptor,
+                                                                        BSONObj(),
+                                                                        BSONObj(),
+                                                                        false));
+        if (yield) {
+            exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
+        }
+
+        BSONObj key;
+        RecordId loc;
+        PlanExecutor::ExecState state;
+        while (PlanExecutor::ADVANCED == (state = exec->getNext(&key, &loc))) {
+            check->found.add(key, loc);
+            if (check->found.count % 128 == 0) {
+                validation->keysChecked.fetchAndAdd(128);
+                if (validation->stop.load()) {
+                    return Status(ErrorCodes::Interrupted, "validate interrupted");
+                }
+            }
+        }
+
+        if (PlanExecutor::IS_EOF != state) {
+            return indexChanged(*check);
+        }
+        return Status::OK();
+    }
+
+    void checkIndexes(OperationContext* txn, BackgroundValidation* validation) {
+        for (unsigned i = validation->next.fetchAndAdd(1);
+             i < validation->indexes.size();
+             i = validation->next.fetchAndAdd(1)) {
+            IndexCheck* check = &validation->indexes[i];
+            try {
+                AutoGetCollectionForRead ctx(txn, validation->ns);
+                Collection* collection = ctx.getCollection();
+                if (!collection) {
+                    check->status = Status(ErrorCodes::NamespaceNotFound,
+                                           str::stream() << "collection " << validation->ns
+                                                         << " was dropped during validation");
+                    continue;
+                }
+                check->status = sketchIndex(txn, collection, true, validation, check);
+            }
+            catch (const DBException& e) {
+                check->status = e.toStatus();
+            }
+        }
+    }
+
+    void runCheckIndexesThread(BackgroundValidation* validation) {
+        Client::initThread("validate");
+        Client& client = cc();
+        client.getAuthorizationSession()->grantInternalAuthorization();
+        {
+            OperationContextImpl txn;
+            checkIndexes(&txn, validation);
+        }
+        client.shutdown();
+        validation->threadsDone.fetchAndAdd(1);
+    }
+
+    void appendMismatch(const IndexCheck& check, ValidateResults* results) {
+        if (check.found.count != check.expected.count) {
+            results->errors.push_back(str::stream() << "index " << check.name << " has "
+                                                    << check.found.count << " keys but "
+                                                    << check.expected.count
+                                                    << " were expected from the collection");
+        }
+        else {
+            results->errors.push_back(str::stream() << "index " << check.name
+                                                    << " has keys which don't match the "
+                                                    << "collection's documents");
+        }
+        results->valid = false;
+    }
+
+} // namespace
+
     class ValidateCmd : public Command {
     public:
         ValidateCmd() : Command( "validate" ) {}
@@ -49,7 +322,8 @@ namespace mongo {
         }
 
         virtual void help(stringstream& h) const { h << "Validate contents of a namespace by scanning its data structures for correctness.  Slow.\n"
-                                                        "Add full:true option to do a more thorough check"; }
+                                                        "Add full:true option to do a more thorough check.\n"
+                                                        "Add background:true to yield while checking documents and indexes"; }
 
         virtual bool isWriteCommandForConfigServer() const { return false; }
         virtual void addRequiredPrivileges(const std::string& dbname,
@@ -59,7 +333,7 @@ namespace mongo {
             actions.addAction(ActionType::validate);
             out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
         }
-        //{ validate: "collectionnamewithoutthedbpart" [, scandata: <bool>] [, full: <bool> } */
+        //{ validate: "collectionnamewithoutthedbpart" [, scandata: <bool>] [, full: <bool>] [, background: <bool>] } */
 
         bool run(OperationContext* txn, const string& dbname , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
             string ns = dbname + "." + cmdObj.firstElement().valuestrsafe();
@@ -77,6 +351,14 @@ namespace mongo {
                 LOG(0) << "CMD: validate " << ns << endl;
             }
 
+            if ( cmdObj["background"].trueValue() ) {
+                if ( !ns_string.isNormal() ) {
+                    errmsg = "Can only run background validate on a regular collection";
+                    return false;
+                }
+                return runBackground( txn, ns_string, errmsg, result );
+            }
+
             AutoGetCollectionForRead ctx(txn, ns_string.ns());
 
             Collection* collection = ctx.getCollection();
@@ -106,6 +388,143 @@ namespace mongo {
             return true;
         }
 
+    private:
+        /**
+         * Validates documents and checks that the indexes match them, without holding the
+         * collection lock for long. The collection is scanned, yielding, into a sketch of the
+         * keys each index should have, then the indexes are scanned in parallel, also yielding,
+         * and compared to it. Writes during the scans can make the sketches differ, so indexes
+         * which don't match are checked again with writes to the collection blocked.
+         */
+        bool runBackground(OperationContext* txn,
+                           const NamespaceString& ns,
+                           string& errmsg,
+                           BSONObjBuilder& result) {
+            BackgroundValidation validation(ns.ns());
+            ValidateResults results;
+            long long nrecords = 0;
+
+            {
+                AutoGetCollectionForRead ctx(txn, ns.ns());
+                Collection* collection = ctx.getCollection();
+                if (!collection) {
+                    errmsg = "ns not found";
+                    return false;
+                }
+
+                IndexCatalog::IndexIterator i =
+                    collection->getIndexCatalog()->getIndexIterator(txn, false);
+                while (i.more()) {
+                    validation.indexes.push_back(IndexCheck(i.next()));
+                }
+
+                Status status = sketchCollection(txn, collection, true, &validation,
+                                                  &nrecords, &results);
+                if (!status.isOK()) {
+                    return appendCommandStatus(result, status);
+                }
+            }
+
+            long long expectedKeys = 0;
+            for (size_t i = 0; i < validation.indexes.size(); i++) {
+                expectedKeys += validation.indexes[i].expected.count;
+            }
+
+            const int numThreads = std::min(std::max(backgroundValidateParallelIndexes, 1),
+                                            static_cast<int>(validation.indexes.size()));
+            {
+                ProgressMeterHolder progress(*txn->setMessage("validate: checking indexes",
+                                                              "validate: checking indexes "
+                                                              "Progress",
+                                                              expectedKeys));
+                boost::thread_group threads;
+                for (int i = 0; i < numThreads; i++) {
+                    threads.create_thread(stdx::bind(runCheckIndexesThread, &validation));
+                }
+
+                // This thread reports progress and passes on interruptions.
+                unsigned long long reported = 0;
+                while (validation.threadsDone.load() < static_cast<unsigned>(numThreads)) {
+                    sleepmillis(100);
+                    if (!txn->checkForInterruptNoAssert().isOK()) {
+                        validation.stop.store(1);
+                    }
+                    const unsigned long long checked = validation.keysChecked.load();
+                    progress.hit(static_cast<int>(checked - reported));
+                    reported = checked;
+                }
+                threads.join_all();
+            }
+            txn->checkForInterrupt();
+
+            std::vector<IndexCheck> mismatched;
+            for (size_t i = 0; i < validation.indexes.size(); i++) {
+                const IndexCheck& check = validation.indexes[i];
+                if (!check.status.isOK()) {
+                    return appendCommandStatus(result, check.status);
+                }
+                if (!(check.found == check.expected)) {
+                    mismatched.push_back(IndexCheck(check));
+                    mismatched.back().expected = IndexSketch();
+                    mismatched.back().found = IndexSketch();
+                }
+            }
+
+            if (!mismatched.empty()) {
+                LOG(1) << "validate: rechecking " << mismatched.size() << " indexes of " << ns
+                       << " with writes blocked";
+
+                BackgroundValidation recheck(ns.ns());
+                recheck.indexes = mismatched;
+
+                ScopedTransaction scopedXact(txn, MODE_IS);
+                AutoGetDb autoDb(txn, ns.db(), MODE_IS);
+                Lock::CollectionLock collLock(txn->lockState(), ns.ns(), MODE_S);
+                Database* db = autoDb.getDb();
+                Collection* collection = db ? db->getCollection(ns.ns()) : NULL;
+                if (!collection) {
+                    errmsg = "ns not found";
+                    return false;
+                }
+
+                long long ignored = 0;
+                ValidateResults ignoredResults;
+                Status status = sketchCollection(txn, collection, false, &recheck,
+                                                 &ignored, &ignoredResults);
+                for (size_t i = 0; status.isOK() && i < recheck.indexes.size(); i++) {
+                    IndexCheck* check = &recheck.indexes[i];
+                    status = sketchIndex(txn, collection, false, &recheck, check);
+                    if (status.isOK() && !(check->found == check->expected)) {
+                        appendMismatch(*check, &results);
+                    }
+                }
+                if (!status.isOK()) {
+                    return appendCommandStatus(result, status);
+                }
+            }
+
+            result.append("ns", ns.ns());
+            result.appendBool("background", true);
+            result.appendNumber("nrecords", nrecords);
+            result.append("nIndexes", static_cast<int>(validation.indexes.size()));
+            BSONObjBuilder keysPerIndex(result.subobjStart("keysPerIndex"));
+            for (size_t i = 0; i < validation.indexes.size(); i++) {
+                keysPerIndex.appendNumber(validation.indexes[i].indexNamespace,
+                                          validation.indexes[i].found.count);
+            }
+            keysPerIndex.done();
+
+            result.appendBool("valid", results.valid);
+            result.append("errors", results.errors);
+            result.append("warning", "Storage structures were not checked in background mode. "
+                                     "Document counts may include concurrent writes.");
+            if (!results.valid) {
+                result.append("advice",
+                              "ns corrupt. See http://dochub.mongodb.org/core/data-recovery");
+            }
+            return true;
+        }
+
     } validateCmd;
 
 }
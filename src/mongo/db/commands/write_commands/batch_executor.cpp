@@ -33,9 +33,12 @@
 #include "mongo/db/commands/write_commands/batch_executor.h"
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
 #include <memory>
 
 #include "mongo/base/error_codes.h"
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
@@ -48,6 +51,7 @@
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/exec/delete.h"
 #include "mongo/db/exec/update.h"
+#include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/ops/delete_request.h"
 #include "mongo/db/ops/parsed_delete.h"
 #include "mongo/db/ops/parsed_update.h"
@@ -62,12 +66,14 @@
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/s/collection_metadata.h"
 #include "mongo/s/d_state.h"
 #include "mongo/s/shard_key_pattern.h"
 #include "mongo/s/write_ops/batched_upsert_detail.h"
 #include "mongo/s/write_ops/write_error_detail.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/elapsed_tracker.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
@@ -102,6 +108,13 @@ namespace mongo {
     // TODO: Determine queueing behavior we want here
     MONGO_EXPORT_SERVER_PARAMETER( queueForMigrationCommit, bool, true );
 
+    // Most threads an unordered update or delete batch is executed on, when the storage engine
+    // supports document-level locking. One executes every batch on the calling thread.
+    MONGO_EXPORT_SERVER_PARAMETER( writeBatchConcurrency, int, 1 );
+
+    // Fewest items worth giving a thread of its own.
+    static const size_t kMinItemsPerSubBatch = 16;
+
     using mongoutils::str::stream;
 
     WriteBatchExecutor::WriteBatchExecutor( OperationContext* txn,
@@ -147,6 +160,31 @@ namespace mongo {
         dassert( response->isValid(NULL) );
     }
 
+    // How many sub-batches to split a batch into for concurrent execution. Returns 1 if the batch
+    // must run serially.
+    static size_t getNumSubBatches( OperationContext* txn, const BatchedCommandRequest& request ) {
+        if ( request.getOrdered()
+             || request.getBatchType() == BatchedCommandRequest::BatchType_Insert
+             || writeBatchConcurrency <= 1 ) {
+            return 1;
+        }
+
+        // Sub-batches would wait on each other's locks unless the engine locks documents.
+        if ( !getGlobalEnvironment()->getGlobalStorageEngine()->supportsDocLocking() ) {
+            return 1;
+        }
+
+        // Batches issued by an operation which already holds locks, for instance through
+        // DBDirectClient, must stay on its thread.
+        if ( txn->lockState()->isLocked() ) {
+            return 1;
+        }
+
+        return std::max<size_t>( 1, std::min<size_t>( writeBatchConcurrency,
+                                                      request.sizeWriteOps()
+                                                          / kMinItemsPerSubBatch ) );
+    }
+
     static void noteInCriticalSection( WriteErrorDetail* staleError ) {
         BSONObjBuilder builder;
         if ( staleError->isErrInfoSet() )
@@ -759,8 +797,39 @@ namespace mongo {
         if ( request.getBatchType() == BatchedCommandRequest::BatchType_Insert ) {
             execInserts( request, errors );
         }
-        else if ( request.getBatchType() == BatchedCommandRequest::BatchType_Update ) {
-            for ( size_t i = 0; i < request.sizeWriteOps(); i++ ) {
+        else {
+            const size_t numSubBatches = getNumSubBatches( _txn, request );
+            if ( numSubBatches > 1 ) {
+                execConcurrently( request, numSubBatches, upsertedIds, errors );
+            }
+            else {
+                execItems( request, 0, request.sizeWriteOps(), upsertedIds, errors );
+            }
+        }
+
+        // Fill in stale version errors for unordered batches (update/delete can't do this on own)
+        if ( !errors->empty() && !request.getOrdered() ) {
+
+            const WriteErrorDetail* finalError = errors->back();
+
+            if ( finalError->getErrCode() == ErrorCodes::StaleShardVersion ) {
+                for ( size_t i = finalError->getIndex() + 1; i < request.sizeWriteOps(); i++ ) {
+                    WriteErrorDetail* dupStaleError = new WriteErrorDetail;
+                    finalError->cloneTo( dupStaleError );
+                    errors->push_back( dupStaleError );
+                }
+            }
+        }
+    }
+
+    void WriteBatchExecutor::execItems( const BatchedCommandRequest& request,
+                                        size_t begin,
+                                        size_t end,
+                                        std::vector<BatchedUpsertDetail*>* upsertedIds,
+                                        std::vector<WriteErrorDetail*>* errors ) {
+
+        if ( request.getBatchType() == BatchedCommandRequest::BatchType_Update ) {
+            for ( size_t i = begin; i < end; i++ ) {
 
                 WriteErrorDetail* error = NULL;
                 BSONObj upsertedId;
@@ -782,7 +851,7 @@ namespace mongo {
         }
         else {
             dassert( request.getBatchType() == BatchedCommandRequest::BatchType_Delete );
-            for ( size_t i = 0; i < request.sizeWriteOps(); i++ ) {
+            for ( size_t i = begin; i < end; i++ ) {
 
                 WriteErrorDetail* error = NULL;
                 execRemove( BatchItemRef( &request, i ), &error );
@@ -794,19 +863,130 @@ namespace mongo {
                 }
             }
         }
+    }
 
-        // Fill in stale version errors for unordered batches (update/delete can't do this on own)
-        if ( !errors->empty() && !request.getOrdered() ) {
+    /**
+     * One contiguous range of the items of an unordered batch, executed on its own thread by
+     * WriteBatchExecutor::execConcurrently(), and what executing it produced.
+     */
+    struct WriteBatchExecutor::SubBatch {
+        SubBatch( const BatchedCommandRequest* aRequest,
+                  size_t aBegin,
+                  size_t aEnd,
+                  OperationContext* aParentTxn,
+                  OpCounters* anOpCounters,
+                  const LastError& aLastError ) :
+            request( aRequest ),
+            begin( aBegin ),
+            end( aEnd ),
+            parentTxn( aParentTxn ),
+            opCounters( anOpCounters ),
+            lastError( aLastError ),
+            status( Status::OK() ) {
+        }
 
-            const WriteErrorDetail* finalError = errors->back();
+        /**
+         * Thread body. Executes the items with a new client and OperationContext, checking the
+         * parent operation for interruption before each of them.
+         */
+        void run() {
+            Client::initThread( "writeBatchWorker" );
+            // The parent operation was authorized for the whole batch.
+            cc().getAuthorizationSession()->grantInternalAuthorization();
 
-            if ( finalError->getErrCode() == ErrorCodes::StaleShardVersion ) {
-                for ( size_t i = finalError->getIndex() + 1; i < request.sizeWriteOps(); i++ ) {
-                    WriteErrorDetail* dupStaleError = new WriteErrorDetail;
-                    finalError->cloneTo( dupStaleError );
-                    errors->push_back( dupStaleError );
+            try {
+                OperationContextImpl txn;
+                WriteBatchExecutor executor( &txn, WriteConcernOptions(), opCounters, &lastError );
+                for ( size_t i = begin; i < end; i++ ) {
+                    parentTxn->checkForInterrupt();
+                    executor.execItems( *request,
+                                        i,
+                                        i + 1,
+                                        &upsertedIds.mutableVector(),
+                                        &errors.mutableVector() );
                 }
+                stats = executor.getStats();
+            }
+            catch ( const DBException& ex ) {
+                status = ex.toStatus();
             }
+
+            lastOp = cc().getLastOp();
+            cc().shutdown();
+        }
+
+        const BatchedCommandRequest* const request;
+        const size_t begin;
+        const size_t end;
+        OperationContext* const parentTxn;
+        OpCounters* const opCounters;
+
+        // Results, valid once the thread running run() has been joined.
+        LastError lastError;
+        Status status;
+        WriteBatchStats stats;
+        OpTime lastOp;
+        OwnedPointerVector<BatchedUpsertDetail> upsertedIds;
+        OwnedPointerVector<WriteErrorDetail> errors;
+    };
+
+    void WriteBatchExecutor::execConcurrently( const BatchedCommandRequest& request,
+                                               size_t numSubBatches,
+                                               std::vector<BatchedUpsertDetail*>* upsertedIds,
+                                               std::vector<WriteErrorDetail*>* errors ) {
+
+        dassert( !request.getOrdered() );
+
+        OwnedPointerVector<SubBatch> subBatchesOwned;
+        std::vector<SubBatch*>& subBatches = subBatchesOwned.mutableVector();
+
+        const size_t numItems = request.sizeWriteOps();
+        for ( size_t i = 0; i < numSubBatches; i++ ) {
+            subBatches.push_back( new SubBatch( &request,
+                                                numItems * i / numSubBatches,
+                                                numItems * ( i + 1 ) / numSubBatches,
+                                                _txn,
+                                                _opCounters,
+                                                *_le ) );
+        }
+
+        boost::thread_group workers;
+        for ( size_t i = 0; i < subBatches.size(); i++ ) {
+            workers.create_thread( stdx::bind( &SubBatch::run, subBatches[i] ) );
+        }
+        workers.join_all();
+
+        // The sub-batches cover contiguous, increasing ranges of items, so appending their results
+        // in order keeps upserted _ids and errors sorted by item index.
+        OpTime lastOp = _txn->getClient()->getLastOp();
+        for ( size_t i = 0; i < subBatches.size(); i++ ) {
+            SubBatch* subBatch = subBatches[i];
+
+            std::vector<BatchedUpsertDetail*> subUpserted = subBatch->upsertedIds.release();
+            upsertedIds->insert( upsertedIds->end(), subUpserted.begin(), subUpserted.end() );
+
+            std::vector<WriteErrorDetail*> subErrors = subBatch->errors.release();
+            errors->insert( errors->end(), subErrors.begin(), subErrors.end() );
+
+            _stats->numInserted += subBatch->stats.numInserted;
+            _stats->numUpserted += subBatch->stats.numUpserted;
+            _stats->numMatched += subBatch->stats.numMatched;
+            _stats->numModified += subBatch->stats.numModified;
+            _stats->numDeleted += subBatch->stats.numDeleted;
+
+            if ( lastOp < subBatch->lastOp ) {
+                lastOp = subBatch->lastOp;
+            }
+        }
+
+        // Write concern waits for the latest op any sub-batch wrote, and getLastError reports on
+        // the last item, as if the batch had run serially.
+        _txn->getClient()->setLastOp( lastOp );
+        *_le = subBatches.back()->lastError;
+
+        // Interruptions and other exceptions escape, like they do from serial execution.
+        for ( size_t i = 0; i < subBatches.size(); i++ ) {
+            uassertStatusOK( subBatches[i]->status );
         }
     }
 
@@ -874,6 +1054,12 @@ namespace mongo {
                 elapsedTracker.resetLastTime();
             }
 
+            const size_t nInserted = execInsertBatch(&state);
+            if (nInserted) {
+                state.currIndex += nInserted - 1;
+                continue;
+            }
+
             WriteErrorDetail* error = NULL;
             execOneInsert(&state, &error);
             if (error) {
@@ -1097,6 +1283,83 @@ namespace mongo {
         }
     }
 
+    // Upper bound on the number of documents written by one execInsertBatch() call.
+    static const size_t kMaxInsertBatchSize = 64;
+
+    size_t WriteBatchExecutor::execInsertBatch(ExecInsertsState* state) {
+        if (state->request->isInsertIndexRequest())
+            return 0;
+
+        const size_t begin = state->currIndex;
+        size_t end = begin;
+        while (end < state->normalizedInserts.size()
+               && end - begin < kMaxInsertBatchSize
+               && state->normalizedInserts[end].isOK()) {
+            ++end;
+        }
+
+        if (end - begin < 2)
+            return 0;
+
+        CurOp currentOp( _txn->getClient(), _txn->getClient()->curop() );
+        beginCurrentOp( &currentOp, _txn->getClient(), BatchItemRef(state->request, begin) );
+
+        try {
+            WriteOpResult lockResult;
+            if (!state->lockAndCheck(&lockResult)) {
+                // The single insert path reports the error.
+                return 0;
+            }
+
+            Collection* collection = state->getCollection();
+            if (collection->isCapped()) {
+                // Capped inserts may delete documents as they go; keep them one at a time.
+                return 0;
+            }
+
+            std::vector<BSONObj> docs;
+            docs.reserve(end - begin);
+            for (size_t i = begin; i < end; i++) {
+                const BSONObj& normalized = state->normalizedInserts[i].getValue();
+                docs.push_back(normalized.isEmpty() ?
+                               state->request->getInsertRequest()->getDocumentsAt(i) :
+                               normalized);
+            }
+
+            const string& insertNS = collection->ns().ns();
+            invariant(_txn->lockState()->isCollectionLockedForMode(insertNS, MODE_IX));
+
+            WriteUnitOfWork wunit(_txn);
+            std::vector<RecordId> locs;
+            if (!collection->insertDocuments(_txn, docs, true, &locs).isOK()) {
+                return 0;
+            }
+
+            // Only log once all documents are in, so that nothing observes a partial batch.
+            for (std::vector<BSONObj>::const_iterator it = docs.begin(); it != docs.end(); ++it) {
+                repl::logOp(_txn, "i", insertNS.c_str(), *it);
+            }
+            wunit.commit();
+        }
+        catch (const DBException& ex) {
+            if (ErrorCodes::isInterruption(ex.toStatus().code()))
+                throw;
+            return 0;
+        }
+
+        for (size_t i = begin; i < end; i++) {
+            BatchItemRef currInsertItem(state->request, i);
+            incOpStats(currInsertItem);
+
+            WriteOpStats stats;
+            stats.n = 1;
+            incWriteStats(currInsertItem, stats, NULL, &currentOp);
+        }
+        finishCurrentOp(_txn, &currentOp, NULL);
+
+        return end - begin;
+    }
+
     /**
      * Perform a single insert into a collection.  Requires the insert be preprocessed and the
      * collection already has been created.
@@ -60,6 +60,7 @@ namespace mongo {
 
         // State object used by private execInserts.  TODO: Do not expose this type.
         class ExecInsertsState;
+        struct SubBatch;
 
         WriteBatchExecutor( OperationContext* txn,
                             const WriteConcernOptions& defaultWriteConcern,
@@ -89,6 +90,26 @@ namespace mongo {
                           std::vector<BatchedUpsertDetail*>* upsertedIds,
                           std::vector<WriteErrorDetail*>* errors );
 
+        /**
+         * Executes the update or delete items with indexes in [begin, end) and returns upserted
+         * _ids and write errors. Stops on error if the batch is ordered.
+         */
+        void execItems( const BatchedCommandRequest& request,
+                        size_t begin,
+                        size_t end,
+                        std::vector<BatchedUpsertDetail*>* upsertedIds,
+                        std::vector<WriteErrorDetail*>* errors );
+
+        /**
+         * Executes the items of an unordered update or delete batch as 'numSubBatches'
+         * contiguous sub-batches, each on its own thread with its own client and
+         * OperationContext, and merges their upserted _ids, write errors and stats in item order.
+         */
+        void execConcurrently( const BatchedCommandRequest& request,
+                               size_t numSubBatches,
+                               std::vector<BatchedUpsertDetail*>* upsertedIds,
+                               std::vector<WriteErrorDetail*>* errors );
+
         /**
          * Executes the inserts of an insert batch and returns the write errors.
          *
@@ -104,6 +125,14 @@ namespace mongo {
          */
         void execOneInsert( ExecInsertsState* state, WriteErrorDetail** error );
 
+        /**
+         * Inserts the run of valid documents starting at the current insert of "state" in a
+         * single unit of work.  Returns the number of documents inserted, or 0 if none were
+         * written, in which case the caller inserts them one at a time so that errors are
+         * reported against the right document.
+         */
+        size_t execInsertBatch( ExecInsertsState* state );
+
         /**
          * Executes an update item (which may update many documents or upsert), and returns the
          * upserted _id on upsert or error on failure.
@@ -0,0 +1,231 @@
+// admission_control.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/concurrency/admission_control.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    // How many operations may hold intent locks on the global resource at the same time. 0 turns
+    // admission control off.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(admissionControlTickets, int, 0);
+
+    // How many of the tickets only internal operations, such as replication, can take.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(admissionControlReservedTickets, int, 4);
+
+    // Relative shares of the unreserved tickets interactive and batch waiters get under load.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(admissionControlInteractiveWeight, int, 4);
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(admissionControlBatchWeight, int, 1);
+
+namespace {
+
+    const unsigned long long kStrideBase = 1 << 20;
+
+    int bucketFor(uint64_t micros) {
+        int bucket = 0;
+        while (micros > 1 && bucket < AdmissionTickets::kNumBuckets - 1) {
+            micros >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+} // namespace
+
+    const char* admissionPriorityName(AdmissionPriority priority) {
+        switch (priority) {
+        case kAdmissionInteractive: return "interactive";
+        case kAdmissionBatch: return "batch";
+        case kAdmissionInternal: return "internal";
+        default: invariant(false);
+        }
+    }
+
+    bool parseAdmissionPriority(const StringData& name, AdmissionPriority* priority) {
+        if (name == "interactive") {
+            *priority = kAdmissionInteractive;
+            return true;
+        }
+        if (name == "batch") {
+            *priority = kAdmissionBatch;
+            return true;
+        }
+        return false;
+    }
+
+    AdmissionTickets::QueueStats::QueueStats() : acquisitions(0), waits(0), waitMicros(0) {
+        memset(buckets, 0, sizeof(buckets));
+    }
+
+    AdmissionTickets::AdmissionTickets(int numTickets,
+                                       int reserved,
+                                       int interactiveWeight,
+                                       int batchWeight)
+        : _outof(std::max(numTickets, 1)),
+          _reserved(std::min(std::max(reserved, 0), _outof - 1)),
+          _available(_outof),
+          _lastPass(0) {
+        _strides[kAdmissionInteractive] = kStrideBase / std::max(interactiveWeight, 1);
+        _strides[kAdmissionBatch] = kStrideBase / std::max(batchWeight, 1);
+        _strides[kAdmissionInternal] = 0;
+        memset(_passes, 0, sizeof(_passes));
+    }
+
+    bool AdmissionTickets::_canTake_inlock(AdmissionPriority priority) const {
+        return priority == kAdmissionInternal ? _available > 0 : _available > _reserved;
+    }
+
+    void AdmissionTickets::waitForTicket(AdmissionPriority priority) {
+        boost::mutex::scoped_lock lk(_mutex);
+        QueueStats& stats = _stats[priority];
+        stats.acquisitions++;
+
+        // Free tickets only remain while nobody who could take them is waiting, so taking one
+        // here doesn't overtake anyone.
+        if (_canTake_inlock(priority)) {
+            _available--;
+            stats.buckets[0]++;
+            return;
+        }
+
+        std::deque<Waiter*>& queue = _queues[priority];
+        if (queue.empty()) {
+            _passes[priority] = std::max(_passes[priority], _lastPass);
+        }
+
+        Waiter waiter;
+        queue.push_back(&waiter);
+
+        Timer timer;
+        while (!waiter.granted) {
+            waiter.condition.wait(lk);
+        }
+
+        const uint64_t waitMicros = timer.micros();
+        stats.waits++;
+        stats.waitMicros += waitMicros;
+        stats.buckets[bucketFor(waitMicros)]++;
+    }
+
+    void AdmissionTickets::release() {
+        boost::mutex::scoped_lock lk(_mutex);
+        _available++;
+        invariant(_available <= _outof);
+        _grant_inlock();
+    }
+
+    int AdmissionTickets::numQueued() const {
+        boost::mutex::scoped_lock lk(_mutex);
+        size_t queued = 0;
+        for (int priority = 0; priority < kAdmissionPrioritiesCount; priority++) {
+            queued += _queues[priority].size();
+        }
+        return static_cast<int>(queued);
+    }
+
+    void AdmissionTickets::_grant_inlock() {
+        while (_available > 0) {
+            int priority = -1;
+            if (!_queues[kAdmissionInternal].empty()) {
+                priority = kAdmissionInternal;
+            }
+            else if (_available > _reserved) {
+                const bool interactiveWaiting = !_queues[kAdmissionInteractive].empty();
+                const bool batchWaiting = !_queues[kAdmissionBatch].empty();
+                if (interactiveWaiting && (!batchWaiting ||
+                                           _passes[kAdmissionInteractive] <=
+                                               _passes[kAdmissionBatch])) {
+                    priority = kAdmissionInteractive;
+                }
+                else if (batchWaiting) {
+                    priority = kAdmissionBatch;
+                }
+            }
+
+            if (priority < 0) {
+                return;
+            }
+
+            Waiter* waiter = _queues[priority].front();
+            _queues[priority].pop_front();
+            _available--;
+            _lastPass = std::max(_lastPass, _passes[priority]);
+            _passes[priority] += _strides[priority];
+
+            waiter->granted = true;
+            waiter->condition.notify_one();
+        }
+    }
+
+    void AdmissionTickets::report(BSONObjBuilder* builder) const {
+        boost::mutex::scoped_lock lk(_mutex);
+        builder->append("out", _outof - _available);
+        builder->append("available", _available);
+        builder->append("reserved", _reserved);
+
+        for (int priority = 0; priority < kAdmissionPrioritiesCount; priority++) {
+            const QueueStats& stats = _stats[priority];
+            BSONObjBuilder queueBuilder(builder->subobjStart(
+                admissionPriorityName(static_cast<AdmissionPriority>(priority))));
+            queueBuilder.appendNumber("acquisitions", stats.acquisitions);
+            queueBuilder.appendNumber("waits", stats.waits);
+            queueBuilder.appendNumber("waitMicros", stats.waitMicros);
+            queueBuilder.append("queued", static_cast<int>(_queues[priority].size()));
+
+            BSONArrayBuilder bucketsBuilder(queueBuilder.subarrayStart("buckets"));
+            for (int i = 0; i < kNumBuckets; i++) {
+                bucketsBuilder.append(stats.buckets[i]);
+            }
+            bucketsBuilder.done();
+            queueBuilder.done();
+        }
+    }
+
+    AdmissionTickets* getGlobalAdmissionTickets() {
+        // Startup parameters are all set before the first lock is taken.
+        static AdmissionTickets* const tickets =
+            admissionControlTickets > 0 ? new AdmissionTickets(admissionControlTickets,
+                                                               admissionControlReservedTickets,
+                                                               admissionControlInteractiveWeight,
+                                                               admissionControlBatchWeight)
+                                        : NULL;
+        return tickets;
+    }
+
+} // namespace mongo
@@ -0,0 +1,152 @@
+// admission_control.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <deque>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * The queue an operation waits in for an admission ticket.
+     */
+    enum AdmissionPriority {
+        // Regular operations from clients.
+        kAdmissionInteractive = 0,
+
+        // Operations which asked to yield to interactive ones, such as analytics.
+        kAdmissionBatch,
+
+        // Replication and other work of the server itself.
+        kAdmissionInternal,
+
+        kAdmissionPrioritiesCount
+    };
+
+    const char* admissionPriorityName(AdmissionPriority priority);
+
+    /**
+     * Parses "interactive" or "batch", the priorities operations can pick for themselves.
+     */
+    bool parseAdmissionPriority(const StringData& name, AdmissionPriority* priority);
+
+    /**
+     * A counting semaphore, like TicketHolder, whose waiters are queued by priority rather than
+     * first come first served.
+     *
+     * Internal waiters go first, and 'reserved' of the tickets are kept for them only, so that
+     * replication makes progress however many client operations are queued. Interactive and
+     * batch waiters share the remaining tickets in proportion to their weights, by stride
+     * scheduling, so batch work slows down rather than stops under load.
+     *
+     * Thread safe.
+     */
+    class AdmissionTickets {
+        MONGO_DISALLOW_COPYING(AdmissionTickets);
+    public:
+        static const int kNumBuckets = 24;
+
+        AdmissionTickets(int numTickets, int reserved, int interactiveWeight, int batchWeight);
+
+        /**
+         * Blocks until a ticket is handed to this thread. Not interruptible.
+         */
+        void waitForTicket(AdmissionPriority priority);
+
+        void release();
+
+        /**
+         * Number of operations waiting for a ticket, of any priority.
+         */
+        int numQueued() const;
+
+        /**
+         * Appends { out, available, reserved, <priority>: { acquisitions, waits, waitMicros,
+         * queued, buckets: [ ... ] } }. Bucket 0 counts waits under 2 microseconds, bucket i > 0
+         * waits of [2^i, 2^(i+1)) microseconds, and the last bucket everything above.
+         */
+        void report(BSONObjBuilder* builder) const;
+
+    private:
+        struct Waiter {
+            Waiter() : granted(false) {}
+
+            bool granted;
+            boost::condition_variable condition;
+        };
+
+        struct QueueStats {
+            QueueStats();
+
+            long long acquisitions;
+            long long waits;
+            long long waitMicros;
+            long long buckets[kNumBuckets];
+        };
+
+        bool _canTake_inlock(AdmissionPriority priority) const;
+
+        /**
+         * Hands free tickets to waiters until either runs out.
+         */
+        void _grant_inlock();
+
+        const int _outof;
+        const int _reserved;
+        unsigned long long _strides[kAdmissionPrioritiesCount];
+
+        mutable boost::mutex _mutex;
+        int _available;
+        std::deque<Waiter*> _queues[kAdmissionPrioritiesCount];
+
+        // Stride scheduling state of the interactive and batch queues: the next queue served is
+        // the waiting one with the lowest pass, and a queue which starts waiting again starts
+        // from the pass last served, so that it can't catch up on time it didn't wait.
+        unsigned long long _passes[kAdmissionPrioritiesCount];
+        unsigned long long _lastPass;
+
+        QueueStats _stats[kAdmissionPrioritiesCount];
+    };
+
+    /**
+     * Returns the tickets operations take before their outermost intent lock on the global
+     * resource, or NULL if admission control is off, which is when the admissionControlTickets
+     * startup parameter is 0.
+     */
+    AdmissionTickets* getGlobalAdmissionTickets();
+
+} // namespace mongo
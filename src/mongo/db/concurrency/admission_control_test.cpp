@@ -0,0 +1,160 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/platform/basic.h"
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <vector>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/concurrency/admission_control.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace {
+
+    BSONObj report(const AdmissionTickets& tickets) {
+        BSONObjBuilder builder;
+        tickets.report(&builder);
+        return builder.obj();
+    }
+
+    void waitUntilQueued(const AdmissionTickets& tickets,
+                         AdmissionPriority priority,
+                         int queued) {
+        while (report(tickets)[admissionPriorityName(priority)]["queued"].numberInt() != queued) {
+            sleepmillis(1);
+        }
+    }
+
+    /**
+     * Takes a ticket and records in which order the waiters got theirs.
+     */
+    class Waiter {
+    public:
+        Waiter(AdmissionTickets* tickets,
+               boost::mutex* mutex,
+               std::vector<AdmissionPriority>* order)
+            : _tickets(tickets), _mutex(mutex), _order(order) {}
+
+        void operator()(AdmissionPriority priority) {
+            _tickets->waitForTicket(priority);
+            boost::mutex::scoped_lock lk(*_mutex);
+            _order->push_back(priority);
+        }
+
+    private:
+        AdmissionTickets* _tickets;
+        boost::mutex* _mutex;
+        std::vector<AdmissionPriority>* _order;
+    };
+
+    TEST(AdmissionTickets, ReservedTicketsAreOnlyForInternal) {
+        AdmissionTickets tickets(2, 1, 4, 1);
+        tickets.waitForTicket(kAdmissionInteractive);
+
+        // The last ticket is reserved, so an internal operation gets it without waiting while
+        // an interactive one queues.
+        boost::mutex mutex;
+        std::vector<AdmissionPriority> order;
+        boost::thread interactive(stdx::bind<void>(Waiter(&tickets, &mutex, &order),
+                                                   kAdmissionInteractive));
+        waitUntilQueued(tickets, kAdmissionInteractive, 1);
+        ASSERT_EQUALS(1, tickets.numQueued());
+
+        tickets.waitForTicket(kAdmissionInternal);
+        BSONObj stats = report(tickets);
+        ASSERT_EQUALS(0, stats["available"].numberInt());
+        ASSERT_EQUALS(0, stats["internal"]["waits"].numberLong());
+
+        tickets.release();
+        tickets.release();
+        interactive.join();
+        ASSERT_EQUALS(1U, order.size());
+
+        stats = report(tickets);
+        ASSERT_EQUALS(2, stats["interactive"]["acquisitions"].numberLong());
+        ASSERT_EQUALS(1, stats["interactive"]["waits"].numberLong());
+        tickets.release();
+        ASSERT_EQUALS(2, report(tickets)["available"].numberInt());
+    }
+
+    TEST(AdmissionTickets, InternalThenWeightedByPriority) {
+        AdmissionTickets tickets(1, 0, 2, 1);
+        tickets.waitForTicket(kAdmissionInteractive);
+
+        boost::mutex mutex;
+        std::vector<AdmissionPriority> order;
+        boost::thread_group threads;
+        for (int i = 0; i < 3; i++) {
+            threads.create_thread(stdx::bind<void>(Waiter(&tickets, &mutex, &order),
+                                                   kAdmissionBatch));
+        }
+        waitUntilQueued(tickets, kAdmissionBatch, 3);
+        for (int i = 0; i < 4; i++) {
+            threads.create_thread(stdx::bind<void>(Waiter(&tickets, &mutex, &order),
+                                                   kAdmissionInteractive));
+        }
+        waitUntilQueued(tickets, kAdmissionInteractive, 4);
+        threads.create_thread(stdx::bind<void>(Waiter(&tickets, &mutex, &order),
+                                               kAdmissionInternal));
+        waitUntilQueued(tickets, kAdmissionInternal, 1);
+
+        // Hand the single ticket on one waiter at a time.
+        for (size_t granted = 1; granted <= 8; granted++) {
+            tickets.release();
+            while (true) {
+                boost::mutex::scoped_lock lk(mutex);
+                if (order.size() == granted) {
+                    break;
+                }
+                lk.unlock();
+                sleepmillis(1);
+            }
+        }
+        threads.join_all();
+
+        // Internal first, then two interactive waiters for every batch one.
+        ASSERT_EQUALS(kAdmissionInternal, order[0]);
+        ASSERT_EQUALS(kAdmissionInteractive, order[1]);
+        ASSERT_EQUALS(kAdmissionBatch, order[2]);
+        ASSERT_EQUALS(kAdmissionInteractive, order[3]);
+        ASSERT_EQUALS(kAdmissionInteractive, order[4]);
+        ASSERT_EQUALS(kAdmissionBatch, order[5]);
+        ASSERT_EQUALS(kAdmissionInteractive, order[6]);
+        ASSERT_EQUALS(kAdmissionBatch, order[7]);
+        tickets.release();
+    }
+
+} // namespace
+} // namespace mongo
@@ -32,6 +32,7 @@
 
 #include <string>
 
+#include "mongo/db/concurrency/lock_contention.h"
 #include "mongo/db/concurrency/locker.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/namespace_string.h"
@@ -142,6 +143,7 @@ namespace mongo {
           _mode(mode) {
 
         massert(28539, "need a valid database name", !db.empty() && nsIsDbOnly(db));
+        globalContendedResources.noteName(_id, db);
 
         const bool isRead = (_mode == MODE_S || _mode == MODE_IS);
 
@@ -189,6 +191,7 @@ namespace mongo {
           _lockState(lockState) {
         const bool isRead = (mode == MODE_S || mode == MODE_IS);
         massert(28538, "need a non-empty collection name", nsIsFull(ns));
+        globalContendedResources.noteName(_id, ns);
         dassert(_lockState->isDbLockedForMode(nsToDatabaseSubstring(ns),
                                               isRead ? MODE_IS : MODE_IX));
         if (supportsDocLocking()) {
@@ -0,0 +1,237 @@
+// lock_contention.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/concurrency/lock_contention.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+
+    // Record one in this many lock waits in globalContendedResources.
+    MONGO_EXPORT_SERVER_PARAMETER(lockContentionSampleRate, int, 1);
+
+    ContendedResources globalContendedResources;
+
+namespace {
+
+    int bucketFor(uint64_t micros) {
+        int bucket = 0;
+        while (micros > 1 && bucket < ContendedResources::kNumBuckets - 1) {
+            micros >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    /**
+     * Names of the resources which are not locked by name.
+     */
+    std::string wellKnownName(ResourceId resId) {
+        if (resId == resourceIdOplog) {
+            return "local.oplog.rs";
+        }
+        if (resId == resourceIdLocalDB) {
+            return "local";
+        }
+
+        switch (resId.getType()) {
+        case RESOURCE_DATABASE:
+        case RESOURCE_COLLECTION:
+            return "";
+        default:
+            return resourceTypeName(resId.getType());
+        }
+    }
+
+    bool moreWaitMicros(const BSONObj& lhs, const BSONObj& rhs) {
+        return lhs["waitMicros"].numberLong() > rhs["waitMicros"].numberLong();
+    }
+
+} // namespace
+
+    ContendedResources::Resource::Resource()
+        : waits(0),
+          waitMicros(0),
+          maxWaitMicros(0),
+          overcountMicros(0) {
+        memset(waitsByMode, 0, sizeof(waitsByMode));
+        memset(buckets, 0, sizeof(buckets));
+    }
+
+    ContendedResources::ContendedResources() {
+        _resources.reserve(kMaxResources);
+    }
+
+    void ContendedResources::recordWait(ResourceId resId, LockMode mode, uint64_t waitMicros) {
+        const int sampleRate = lockContentionSampleRate;
+        if (sampleRate > 1 && _sampleCounter.fetchAndAdd(1) % sampleRate != 0) {
+            return;
+        }
+
+        boost::mutex::scoped_lock lk(_mutex);
+
+        Resource* resource = NULL;
+        const int index = _find_inlock(resId);
+        if (index >= 0) {
+            resource = &_resources[index];
+        }
+        else {
+            long long overcount = 0;
+            if (_resources.size() < kMaxResources) {
+                _resources.push_back(Resource());
+                resource = &_resources.back();
+            }
+            else {
+                // Replace the resource with the least wait time.
+                resource = &_resources[0];
+                for (size_t i = 1; i < _resources.size(); i++) {
+                    if (_resources[i].waitMicros < resource->waitMicros) {
+                        resource = &_resources[i];
+                    }
+                }
+
+                if (resource->name.empty()) {
+                    _numUnnamed.subtractAndFetch(1);
+                }
+                overcount = resource->waitMicros;
+                *resource = Resource();
+            }
+
+            resource->resId = resId;
+            resource->name = wellKnownName(resId);
+            resource->waitMicros = overcount;
+            resource->overcountMicros = overcount;
+            if (resource->name.empty()) {
+                _numUnnamed.addAndFetch(1);
+            }
+        }
+
+        resource->waits++;
+        resource->waitMicros += waitMicros;
+        resource->maxWaitMicros = std::max(resource->maxWaitMicros,
+                                           static_cast<long long>(waitMicros));
+        resource->waitsByMode[mode]++;
+        resource->buckets[bucketFor(waitMicros)]++;
+    }
+
+    void ContendedResources::_noteName(ResourceId resId, const StringData& name) {
+        boost::mutex::scoped_lock lk(_mutex);
+
+        const int index = _find_inlock(resId);
+        if (index >= 0 && _resources[index].name.empty()) {
+            _resources[index].name = name.toString();
+            _numUnnamed.subtractAndFetch(1);
+        }
+    }
+
+    std::string ContendedResources::getName(ResourceId resId) const {
+        const std::string known = wellKnownName(resId);
+        if (!known.empty()) {
+            return known;
+        }
+
+        {
+            boost::mutex::scoped_lock lk(_mutex);
+            const int index = _find_inlock(resId);
+            if (index >= 0 && !_resources[index].name.empty()) {
+                return _resources[index].name;
+            }
+        }
+
+        return resId.toString();
+    }
+
+    void ContendedResources::report(BSONObjBuilder* builder) const {
+        std::vector<BSONObj> resources;
+        {
+            boost::mutex::scoped_lock lk(_mutex);
+            for (size_t i = 0; i < _resources.size(); i++) {
+                const Resource& resource = _resources[i];
+
+                BSONObjBuilder resourceBuilder;
+                resourceBuilder.append("resource", resource.name.empty() ?
+                                                       resource.resId.toString() : resource.name);
+                resourceBuilder.append("type", resourceTypeName(resource.resId.getType()));
+                resourceBuilder.appendNumber("waits", resource.waits);
+                resourceBuilder.appendNumber("waitMicros", resource.waitMicros);
+                resourceBuilder.appendNumber("maxWaitMicros", resource.maxWaitMicros);
+                resourceBuilder.appendNumber("overcountMicros", resource.overcountMicros);
+
+                BSONObjBuilder modesBuilder(resourceBuilder.subobjStart("modes"));
+                for (int mode = 1; mode < LockModesCount; mode++) {
+                    if (resource.waitsByMode[mode]) {
+                        modesBuilder.appendNumber(legacyModeName(static_cast<LockMode>(mode)),
+                                                  resource.waitsByMode[mode]);
+                    }
+                }
+                modesBuilder.done();
+
+                int numBuckets = kNumBuckets;
+                while (numBuckets > 0 && resource.buckets[numBuckets - 1] == 0) {
+                    numBuckets--;
+                }
+                BSONArrayBuilder bucketsBuilder(resourceBuilder.subarrayStart("buckets"));
+                for (int bucket = 0; bucket < numBuckets; bucket++) {
+                    bucketsBuilder.append(resource.buckets[bucket]);
+                }
+                bucketsBuilder.done();
+
+                resources.push_back(resourceBuilder.obj());
+            }
+        }
+
+        std::sort(resources.begin(), resources.end(), moreWaitMicros);
+
+        builder->append("sampleRate", std::max(static_cast<int>(lockContentionSampleRate), 1));
+        builder->append("resources", resources);
+    }
+
+    void ContendedResources::reset() {
+        boost::mutex::scoped_lock lk(_mutex);
+        _resources.clear();
+        _numUnnamed.store(0);
+    }
+
+    int ContendedResources::_find_inlock(ResourceId resId) const {
+        for (size_t i = 0; i < _resources.size(); i++) {
+            if (_resources[i].resId == resId) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+} // namespace mongo
@@ -0,0 +1,135 @@
+// lock_contention.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/mutex.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/concurrency/lock_manager_defs.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * The lock resources waited on the longest, each with a histogram of its wait times, so that
+     * the collection or database whose lock is contended can be told apart from the others of
+     * its type, which LockStats can't do.
+     *
+     * Keeps at most kMaxResources resources, using the Space-Saving algorithm: a new resource
+     * replaces the one with the least wait time, and starts from that wait time, which is kept
+     * as the possible overcount. Any resource waited on for longer than that overcount is
+     * guaranteed to be tracked.
+     *
+     * ResourceIds are hashes, so names are only known for resources locked through the
+     * Lock::DBLock and Lock::CollectionLock helpers, which report them with noteName().
+     *
+     * Thread safe.
+     */
+    class ContendedResources {
+        MONGO_DISALLOW_COPYING(ContendedResources);
+    public:
+        static const size_t kMaxResources = 32;
+        static const int kNumBuckets = 24;
+
+        ContendedResources();
+
+        /**
+         * Records that a request for 'resId' in 'mode' waited 'waitMicros' before being granted
+         * or giving up. Only one in lockContentionSampleRate waits are recorded.
+         */
+        void recordWait(ResourceId resId, LockMode mode, uint64_t waitMicros);
+
+        /**
+         * Tells the name of 'resId', if it is tracked and does not have one yet. Only takes the
+         * mutex while some tracked resource has no name.
+         */
+        void noteName(ResourceId resId, const StringData& name) {
+            if (_numUnnamed.load() == 0) {
+                return;
+            }
+            _noteName(resId, name);
+        }
+
+        /**
+         * Returns the name of 'resId' if it is known, or else its ResourceId::toString().
+         */
+        std::string getName(ResourceId resId) const;
+
+        /**
+         * Appends { sampleRate, resources: [ { resource, type, waits, waitMicros, maxWaitMicros,
+         * overcountMicros, modes: { <mode>: waits }, buckets: [ ... ] } ] }, the resources by
+         * decreasing waitMicros. Bucket 0 counts waits under 2 microseconds, bucket i > 0 waits
+         * of [2^i, 2^(i+1)) microseconds, and the last bucket everything above.
+         */
+        void report(BSONObjBuilder* builder) const;
+
+        void reset();
+
+    private:
+        struct Resource {
+            Resource();
+
+            ResourceId resId;
+            std::string name;
+
+            long long waits;
+            long long waitMicros;
+            long long maxWaitMicros;
+            long long overcountMicros; // inherited from the resource this one replaced
+            long long waitsByMode[LockModesCount];
+            long long buckets[kNumBuckets];
+        };
+
+        void _noteName(ResourceId resId, const StringData& name);
+
+        /**
+         * Returns the index of 'resId' in _resources, or -1 if it isn't tracked.
+         */
+        int _find_inlock(ResourceId resId) const;
+
+        // Protects _resources.
+        mutable boost::mutex _mutex;
+        std::vector<Resource> _resources;
+
+        // How many of _resources have no name yet.
+        AtomicUInt32 _numUnnamed;
+
+        AtomicUInt32 _sampleCounter;
+    };
+
+    extern ContendedResources globalContendedResources;
+
+} // namespace mongo
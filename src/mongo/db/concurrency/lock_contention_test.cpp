@@ -0,0 +1,108 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/concurrency/lock_contention.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+
+    TEST(ContendedResources, AddsUpWaitsPerResource) {
+        const ResourceId first(RESOURCE_COLLECTION, std::string("ContendedResources.first"));
+        const ResourceId second(RESOURCE_COLLECTION, std::string("ContendedResources.second"));
+
+        ContendedResources contended;
+        contended.recordWait(first, MODE_X, 100);
+        contended.recordWait(first, MODE_IS, 1000);
+        contended.recordWait(second, MODE_X, 10);
+
+        BSONObjBuilder builder;
+        contended.report(&builder);
+        std::vector<BSONElement> resources = builder.obj()["resources"].Array();
+        ASSERT_EQUALS(2U, resources.size());
+
+        // Longest waits first
+        const BSONObj resource = resources[0].Obj();
+        ASSERT_EQUALS(first.toString(), resource["resource"].String());
+        ASSERT_EQUALS(2, resource["waits"].numberLong());
+        ASSERT_EQUALS(1100, resource["waitMicros"].numberLong());
+        ASSERT_EQUALS(1000, resource["maxWaitMicros"].numberLong());
+        ASSERT_EQUALS(1, resource["modes"]["W"].numberLong());
+        ASSERT_EQUALS(1, resource["modes"]["r"].numberLong());
+
+        // 100 micros go in bucket 6, [64, 128), and 1000 in bucket 9, [512, 1024)
+        std::vector<BSONElement> buckets = resource["buckets"].Array();
+        ASSERT_EQUALS(10U, buckets.size());
+        ASSERT_EQUALS(1, buckets[6].numberLong());
+        ASSERT_EQUALS(1, buckets[9].numberLong());
+    }
+
+    TEST(ContendedResources, NamesResources) {
+        const ResourceId resId(RESOURCE_DATABASE, std::string("ContendedResources"));
+
+        ContendedResources contended;
+        contended.noteName(resId, "ContendedResources");
+        ASSERT_EQUALS(resId.toString(), contended.getName(resId));
+
+        contended.recordWait(resId, MODE_X, 10);
+        contended.noteName(resId, "ContendedResources");
+        ASSERT_EQUALS("ContendedResources", contended.getName(resId));
+
+        ASSERT_EQUALS("local.oplog.rs", contended.getName(resourceIdOplog));
+    }
+
+    TEST(ContendedResources, ReplacesTheLeastWaitedOn) {
+        ContendedResources contended;
+        for (size_t i = 0; i < ContendedResources::kMaxResources; i++) {
+            const ResourceId resId(RESOURCE_COLLECTION, static_cast<uint64_t>(i));
+            contended.recordWait(resId, MODE_X, 100 + i);
+        }
+
+        const ResourceId newResId(RESOURCE_COLLECTION, static_cast<uint64_t>(1000));
+        contended.recordWait(newResId, MODE_X, 10);
+
+        BSONObjBuilder builder;
+        contended.report(&builder);
+        std::vector<BSONElement> resources = builder.obj()["resources"].Array();
+        ASSERT_EQUALS(ContendedResources::kMaxResources, resources.size());
+
+        // The new resource took the place of the first, and starts from its wait time.
+        for (size_t i = 0; i < resources.size(); i++) {
+            const BSONObj resource = resources[i].Obj();
+            ASSERT_NOT_EQUALS(ResourceId(RESOURCE_COLLECTION, static_cast<uint64_t>(0)).toString(),
+                              resource["resource"].String());
+            if (resource["resource"].String() == newResId.toString()) {
+                ASSERT_EQUALS(110, resource["waitMicros"].numberLong());
+                ASSERT_EQUALS(100, resource["overcountMicros"].numberLong());
+            }
+        }
+    }
+
+} // namespace mongo
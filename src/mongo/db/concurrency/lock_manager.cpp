@@ -146,6 +146,7 @@ namespace {
 
             conversionsCount = 0;
             compatibleFirstCount = 0;
+            fastIntentCount = 0;
         }
 
         /**
@@ -248,6 +249,20 @@ namespace {
             }
         }
 
+        // Accounts for 'count' requests in 'mode', which were granted by a FastIntentLock and
+        // are not on the granted queue
+        void addFastIntentGrants(LockMode mode, uint32_t count) {
+            if (count == 0) {
+                return;
+            }
+
+            if (grantedCounts[mode] == 0) {
+                grantedModes |= modeMask(mode);
+            }
+            grantedCounts[mode] += count;
+            fastIntentCount += count;
+        }
+
         // Methods to maintain the conflict queue
         void incConflictModeCount(LockMode mode) {
             invariant(conflictCounts[mode] >= 0);
@@ -324,6 +339,15 @@ namespace {
         // be switched to compatible-first. As long as this value is > 0, the policy will stay
         // compatible-first.
         uint32_t compatibleFirstCount;
+
+        //
+        // Fast intent locks
+        //
+
+        // Counts the requests granted by this resource's FastIntentLock before it was closed,
+        // which are still held. These are included in grantedCounts, but are not on the granted
+        // queue.
+        uint32_t fastIntentCount;
     };
 
     /**
@@ -371,6 +395,125 @@ namespace {
         LockRequestList grantedList;
     };
 
+    /**
+     * The FastIntentLock allows granting requests with the intent modes MODE_IS and MODE_IX on
+     * the global and database resources without taking any mutex. These are acquired by nearly
+     * every operation and are compatible with each other, so even the partition lock is a
+     * hotspot for them on machines with many cores.
+     *
+     * While it is open, a FastIntentLock grants intent mode requests by atomically incrementing
+     * the count for their mode, and they are released by decrementing it. Such requests are on no
+     * list. A request in a conflicting mode must close the FastIntentLock under the bucket mutex,
+     * which hands the counts of its granted requests over to the resource's LockHead. From then
+     * on, those requests are released through the LockHead. The first intent mode request made
+     * after they are all gone and while the LockHead holds no conflicting modes reopens it.
+     *
+     * Since requests it grants are on no list, the deadlock detector does not see them. They are
+     * moved to the LockHead's granted queue before being converted, so that upgrades still show up
+     * in the wait-for graph.
+     */
+    struct FastIntentLock {
+        FastIntentLock() : type(RESOURCE_INVALID) { }
+
+        // The low 'countBits' bits of 'state' count the granted MODE_IS requests and the next
+        // 'countBits' bits count the granted MODE_IX requests. The top bit is set while closed.
+        static const uint64_t countBits = 31;
+        static const uint64_t countMask = (1ULL << countBits) - 1;
+        static const uint64_t closedBit = 1ULL << 63;
+
+        static uint64_t unit(LockMode mode) {
+            return (mode == MODE_IS) ? 1ULL : (1ULL << countBits);
+        }
+
+        static uint32_t count(uint64_t state, LockMode mode) {
+            return (mode == MODE_IS) ? (state & countMask) : ((state >> countBits) & countMask);
+        }
+
+        ResourceId getResourceId() const {
+            // The constructor drops the type bits from the full hash.
+            return ResourceId(type, resourceId.load());
+        }
+
+        /**
+         * Grants a request in the specified intent mode, unless closed.
+         */
+        bool tryLock(LockMode mode) {
+            uint64_t current = state.load();
+            while (!(current & closedBit)) {
+                const uint64_t old = state.compareAndSwap(current, current + unit(mode));
+                if (old == current) {
+                    return true;
+                }
+                current = old;
+            }
+            return false;
+        }
+
+        /**
+         * Converts a request, which it granted, to another intent mode, unless closed.
+         */
+        bool tryConvert(LockMode mode, LockMode newMode) {
+            uint64_t current = state.load();
+            while (!(current & closedBit)) {
+                const uint64_t old = state.compareAndSwap(current,
+                                                          current - unit(mode) + unit(newMode));
+                if (old == current) {
+                    return true;
+                }
+                current = old;
+            }
+            return false;
+        }
+
+        /**
+         * Releases a request, which it granted. Returns false if closed, in which case the
+         * request is accounted for by the LockHead and has to be released there as well.
+         */
+        bool unlock(LockMode mode) {
+            return !(state.fetchAndSubtract(unit(mode)) & closedBit);
+        }
+
+        /**
+         * Closes it, unless already closed, and hands the requests it granted over to 'lock'.
+         * MUST be called under the lock bucket's mutex.
+         */
+        void close(LockHead* lock) {
+            uint64_t current = state.load();
+            while (!(current & closedBit)) {
+                const uint64_t old = state.compareAndSwap(current, current | closedBit);
+                if (old == current) {
+                    lock->addFastIntentGrants(MODE_IS, count(current, MODE_IS));
+                    lock->addFastIntentGrants(MODE_IX, count(current, MODE_IX));
+                    return;
+                }
+                current = old;
+            }
+        }
+
+        /**
+         * Reopens it and grants a request in the specified intent mode. Only succeeds if all the
+         * requests it granted before it was closed have been released. MUST be called under the
+         * lock bucket's mutex.
+         */
+        bool tryReopen(LockMode mode) {
+            // When closed, only releasing requests can change the state, so this can only fail
+            // if some are still held.
+            return state.compareAndSwap(closedBit, unit(mode)) == closedBit;
+        }
+
+        // The resource which this lock is for, or zero if not claimed yet. Never changes once
+        // claimed.
+        AtomicUInt64 resourceId;
+
+        AtomicUInt64 state;
+
+        // Type of the resources, which this lock is for
+        ResourceType type;
+
+        // Keep each of these on its own cache line, since they are all written very frequently
+        char padding[64 - sizeof(ResourceType) - 2 * sizeof(AtomicUInt64)];
+    };
+
     void LockHead::migratePartitionedLockHeads() {
         invariant(partitioned());
         // There can't be non-intent modes or conflicts when the lock is partitioned
@@ -379,7 +522,7 @@ namespace {
         // Migration time: lock each partition in turn and transfer its requests, if any
         while(partitioned()) {
             LockManager::Partition* partition = partitions.back();
-            SimpleMutex::scoped_lock scopedLock(partition->mutex);
+            AdaptiveMutex::scoped_lock scopedLock(partition->mutex);
 
             LockManager::Partition::Map::iterator it = partition->data.find(resourceId);
             if (it != partition->data.end()) {
@@ -406,6 +549,8 @@ namespace {
     // LockManager
     //
 
+    AdaptiveMutex::Stats lockManagerMutexStats;
+
     // Have more buckets than CPUs to reduce contention on lock and caches
     const unsigned LockManager::_numLockBuckets(128);
 
@@ -413,9 +558,19 @@ namespace {
     // The exact value doesn't appear very important, but should be power of two
     const unsigned LockManager::_numPartitions = 32;
 
+    // One for the global resource and the rest shared by all databases. A database which maps to
+    // a FastIntentLock already claimed by another database uses the regular LockHead only.
+    const unsigned LockManager::_numFastIntentLocks = 128;
+
     LockManager::LockManager() {
         _lockBuckets = new LockBucket[_numLockBuckets];
         _partitions = new Partition[_numPartitions];
+
+        _fastIntentLocks = new FastIntentLock[_numFastIntentLocks];
+        _fastIntentLocks[0].type = RESOURCE_GLOBAL;
+        for (unsigned i = 1; i < _numFastIntentLocks; i++) {
+            _fastIntentLocks[i].type = RESOURCE_DATABASE;
+        }
     }
 
     LockManager::~LockManager() {
@@ -428,18 +583,32 @@ namespace {
 
         delete[] _lockBuckets;
         delete[] _partitions;
+        delete[] _fastIntentLocks;
     }
 
     LockResult LockManager::lock(ResourceId resId, LockRequest* request, LockMode mode) {
         // Sanity check that requests are not being reused without proper cleanup
         invariant(request->status == LockRequest::STATUS_NEW);
 
-        request->partitioned = (mode == MODE_IX || mode == MODE_IS);
+        const bool isIntentMode = (mode == MODE_IX || mode == MODE_IS);
+        FastIntentLock* const fastIntentLock = _getFastIntentLock(resId);
+
+        // Requests which change the policy of the lock must be on its granted queue
+        const bool useFastIntentLock = fastIntentLock && isIntentMode && !request->compatibleFirst;
+
+        // Fastest path for intent locks on resources which have a FastIntentLock
+        if (useFastIntentLock && fastIntentLock->tryLock(mode)) {
+            _grantByFastIntentLock(fastIntentLock, request, mode);
+            return LOCK_OK;
+        }
+
+        // Resources which have a FastIntentLock are never partitioned
+        request->partitioned = isIntentMode && !fastIntentLock;
 
         // For intent modes, try the PartitionedLockHead
         if (request->partitioned) {
             Partition* partition = _getPartition(request);
-            SimpleMutex::scoped_lock scopedLock(partition->mutex);
+            AdaptiveMutex::scoped_lock scopedLock(partition->mutex);
 
             // Fast path for intent locks
             PartitionedLockHead* partitionedLock = partition->find(resId);
@@ -455,15 +624,31 @@ namespace {
 
         // Use regular LockHead, maybe start partitioning
         LockBucket* bucket = _getBucket(resId);
-        SimpleMutex::scoped_lock scopedLock(bucket->mutex);
+        AdaptiveMutex::scoped_lock scopedLock(bucket->mutex);
 
         LockHead* lock = bucket->findOrInsert(resId);
 
+        if (fastIntentLock) {
+            // Try again or reopen the FastIntentLock, if there is nothing to conflict with. This
+            // does not race with closing it, since that is done under the bucket mutex as well.
+            if (useFastIntentLock && !(lock->grantedModes & (~intentModes))
+                && !lock->conflictModes
+                && (fastIntentLock->tryLock(mode) || fastIntentLock->tryReopen(mode))) {
+                _grantByFastIntentLock(fastIntentLock, request, mode);
+                return LOCK_OK;
+            }
+
+            // Conflicting modes need to see the requests granted by the FastIntentLock
+            if (!isIntentMode) {
+                fastIntentLock->close(lock);
+            }
+        }
+
         // Start a partitioned lock if possible
         if (request->partitioned && !(lock->grantedModes & (~intentModes))
             && !lock->conflictModes) {
             Partition* partition = _getPartition(request);
-            SimpleMutex::scoped_lock scopedLock(partition->mutex);
+            AdaptiveMutex::scoped_lock scopedLock(partition->mutex);
             PartitionedLockHead* partitionedLock = partition->findOrInsert(resId);
             invariant(partitionedLock);
             lock->partitions.push_back(partition);
@@ -503,13 +688,28 @@ namespace {
         invariant((LockConflictsTable[request->mode] | LockConflictsTable[newMode]) ==
                                                         LockConflictsTable[newMode]);
 
+        // Fast path for converting between intent modes, while the FastIntentLock is open
+        if (request->fastIntentLock && newMode == MODE_IX
+            && request->fastIntentLock->tryConvert(request->mode, newMode)) {
+            request->mode = newMode;
+            return LOCK_OK;
+        }
+
         LockBucket* bucket = _getBucket(resId);
-        SimpleMutex::scoped_lock scopedLock(bucket->mutex);
+        AdaptiveMutex::scoped_lock scopedLock(bucket->mutex);
 
-        LockBucket::Map::iterator it = bucket->data.find(resId);
-        invariant(it != bucket->data.end());
+        LockHead* lock;
+        if (request->fastIntentLock) {
+            // There may not be a LockHead yet if all requests used the FastIntentLock
+            lock = bucket->findOrInsert(resId);
+            _adoptFastIntentRequest(lock, request);
+        }
+        else {
+            LockBucket::Map::iterator it = bucket->data.find(resId);
+            invariant(it != bucket->data.end());
 
-        LockHead* const lock = it->second;
+            lock = it->second;
+        }
 
         if (lock->partitioned()) {
             lock->migratePartitionedLockHeads();
@@ -568,6 +768,34 @@ namespace {
             return false;
         }
 
+        if (request->fastIntentLock) {
+            invariant(request->status == LockRequest::STATUS_GRANTED);
+
+            // Fast path: the FastIntentLock is still open
+            FastIntentLock* const fastIntentLock = request->fastIntentLock;
+            if (fastIntentLock->unlock(request->mode)) {
+                return true;
+            }
+
+            // The FastIntentLock was closed, so the LockHead accounts for this request. It must
+            // still exist, since its granted counts include this request.
+            const ResourceId resId = fastIntentLock->getResourceId();
+            LockBucket* bucket = _getBucket(resId);
+            AdaptiveMutex::scoped_lock scopedLock(bucket->mutex);
+
+            LockBucket::Map::iterator it = bucket->data.find(resId);
+            invariant(it != bucket->data.end());
+
+            LockHead* lock = it->second;
+            invariant(lock->fastIntentCount > 0);
+
+            lock->fastIntentCount--;
+            lock->decGrantedModeCount(request->mode);
+
+            _onLockModeChanged(lock, lock->grantedCounts[request->mode] == 0);
+            return true;
+        }
+
         if (request->partitioned) {
             // Unlocking a lock that was acquired as partitioned. The lock request may since have
             // moved to the lock head, but there is no safe way to find out without synchronizing
@@ -575,7 +803,7 @@ namespace {
             invariant(request->status == LockRequest::STATUS_GRANTED
                       || request->status == LockRequest::STATUS_CONVERTING);
             Partition* partition = _getPartition(request);
-            SimpleMutex::scoped_lock scopedLock(partition->mutex);
+            AdaptiveMutex::scoped_lock scopedLock(partition->mutex);
             //  Fast path: still partitioned.
             if (request->partitionedLock) {
                 request->partitionedLock->grantedList.remove(request);
@@ -588,7 +816,7 @@ namespace {
 
         LockHead* lock = request->lock;
         LockBucket* bucket = _getBucket(lock->resourceId);
-        SimpleMutex::scoped_lock scopedLock(bucket->mutex);
+        AdaptiveMutex::scoped_lock scopedLock(bucket->mutex);
 
         if (request->status == LockRequest::STATUS_GRANTED) {
             // This releases a currently held lock and is the most common path, so it should be
@@ -648,7 +876,7 @@ namespace {
         LockHead* lock = request->lock;
 
         LockBucket* bucket = _getBucket(lock->resourceId);
-        SimpleMutex::scoped_lock scopedLock(bucket->mutex);
+        AdaptiveMutex::scoped_lock scopedLock(bucket->mutex);
 
         lock->incGrantedModeCount(newMode);
         lock->decGrantedModeCount(request->mode);
@@ -657,10 +885,23 @@ namespace {
         _onLockModeChanged(lock, true);
     }
 
+    bool LockManager::hasWaitingRequests(ResourceId resId) const {
+        LockBucket* bucket = _getBucket(resId);
+        AdaptiveMutex::scoped_lock scopedLock(bucket->mutex);
+
+        LockBucket::Map::const_iterator it = bucket->data.find(resId);
+        if (it == bucket->data.end()) {
+            return false;
+        }
+
+        const LockHead* lock = it->second;
+        return lock->conflictModes != 0 || lock->conversionsCount > 0;
+    }
+
     void LockManager::cleanupUnusedLocks() {
         for (unsigned i = 0; i < _numLockBuckets; i++) {
             LockBucket* bucket = &_lockBuckets[i];
-            SimpleMutex::scoped_lock scopedLock(bucket->mutex);
+            AdaptiveMutex::scoped_lock scopedLock(bucket->mutex);
 
             LockBucket::Map::iterator it = bucket->data.begin();
             while (it != bucket->data.end()) {
@@ -670,6 +911,7 @@ namespace {
                 }
                 if (lock->grantedModes == 0) {
                     invariant(lock->grantedModes == 0);
+                    invariant(lock->fastIntentCount == 0);
                     invariant(lock->grantedList._front == NULL);
                     invariant(lock->grantedList._back == NULL);
                     invariant(lock->conflictModes == 0);
@@ -782,7 +1024,8 @@ namespace {
 
         // This is a convenient place to check that the state of the two request queues is in sync
         // with the bitmask on the modes.
-        invariant((lock->grantedModes == 0) ^ (lock->grantedList._front != NULL));
+        invariant((lock->grantedModes == 0) ^
+                  ((lock->grantedList._front != NULL) || (lock->fastIntentCount > 0)));
         invariant((lock->conflictModes == 0) ^ (lock->conflictList._front != NULL));
     }
 
@@ -794,12 +1037,69 @@ namespace {
         return &_partitions[request->locker->getId() % _numPartitions];
     }
 
+    FastIntentLock* LockManager::_getFastIntentLock(ResourceId resId) const {
+        FastIntentLock* fastIntentLock;
+        switch (resId.getType()) {
+        case RESOURCE_GLOBAL:
+            fastIntentLock = &_fastIntentLocks[0];
+            break;
+        case RESOURCE_DATABASE:
+            fastIntentLock = &_fastIntentLocks[1 + resId.getHashId() % (_numFastIntentLocks - 1)];
+            break;
+        default:
+            return NULL;
+        }
+
+        // The resource id is never zero, because the type bits are set
+        const uint64_t claimedBy = fastIntentLock->resourceId.load();
+        if (claimedBy == resId) {
+            return fastIntentLock;
+        }
+
+        if (claimedBy == 0) {
+            const uint64_t old = fastIntentLock->resourceId.compareAndSwap(0, resId);
+            if (old == 0 || old == resId) {
+                return fastIntentLock;
+            }
+        }
+
+        return NULL;
+    }
+
+    void LockManager::_grantByFastIntentLock(FastIntentLock* fastIntentLock,
+                                             LockRequest* request,
+                                             LockMode mode) {
+        request->mode = mode;
+        request->lock = NULL;
+        request->partitionedLock = NULL;
+        request->fastIntentLock = fastIntentLock;
+        request->recursiveCount = 1;
+        request->status = LockRequest::STATUS_GRANTED;
+        request->partitioned = false;
+    }
+
+    void LockManager::_adoptFastIntentRequest(LockHead* lock, LockRequest* request) {
+        FastIntentLock* const fastIntentLock = request->fastIntentLock;
+        fastIntentLock->close(lock);
+
+        // The LockHead's granted counts already include this request, so only move it onto the
+        // granted queue.
+        const bool wasOpen = fastIntentLock->unlock(request->mode);
+        invariant(!wasOpen);
+        invariant(lock->fastIntentCount > 0);
+        lock->fastIntentCount--;
+
+        request->fastIntentLock = NULL;
+        request->lock = lock;
+        lock->grantedList.push_back(request);
+    }
+
     void LockManager::dump() const {
         log() << "Dumping LockManager @ " << static_cast<const void*>(this) << '\n';
 
         for (unsigned i = 0; i < _numLockBuckets; i++) {
             LockBucket* bucket = &_lockBuckets[i];
-            SimpleMutex::scoped_lock scopedLock(bucket->mutex);
+            AdaptiveMutex::scoped_lock scopedLock(bucket->mutex);
 
             if (!bucket->data.empty()) {
                 _dumpBucket(bucket);
@@ -814,7 +1114,7 @@ namespace {
 
             const LockHead* lock = it->second;
 
-            if (lock->grantedList.empty()) {
+            if (lock->grantedList.empty() && (lock->fastIntentCount == 0)) {
                 // If there are no granted requests, this lock is empty, so no need to print it
                 continue;
             }
@@ -822,6 +1122,8 @@ namespace {
             StringBuilder sb;
             sb << "Lock @ " << lock << ": " << lock->resourceId.toString() << '\n';
 
+            sb << "GRANTED BY FAST INTENT LOCK: " << lock->fastIntentCount << '\n';
+
             sb << "GRANTED:\n";
             for (const LockRequest* iter = lock->grantedList._front;
                  iter != NULL;
@@ -949,7 +1251,7 @@ namespace {
     void DeadlockDetector::_processNextNode(const UnprocessedNode& node) {
         // Locate the request
         LockManager::LockBucket* bucket = _lockMgr._getBucket(node.resId);
-        SimpleMutex::scoped_lock scopedLock(bucket->mutex);
+        AdaptiveMutex::scoped_lock scopedLock(bucket->mutex);
 
         LockManager::LockBucket::Map::const_iterator iter = bucket->data.find(node.resId);
         if (iter == bucket->data.end()) {
@@ -1099,6 +1401,7 @@ namespace {
         recursiveCount = 0;
 
         lock = NULL;
+        fastIntentLock = NULL;
         prev = NULL;
         next = NULL;
         status = STATUS_NEW;
@@ -39,10 +39,17 @@
 #include "mongo/platform/compiler.h"
 #include "mongo/platform/cstdint.h"
 #include "mongo/platform/unordered_map.h"
+#include "mongo/util/concurrency/adaptive_mutex.h"
 #include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
+    /**
+     * Contention on the mutexes of the lock manager's buckets and partitions, summed over all of
+     * them. Reported in serverStatus under lockContention.lockManagerMutexes.
+     */
+    extern AdaptiveMutex::Stats lockManagerMutexStats;
+
     /**
      * Entry point for the lock manager scheduling functionality. Don't use it directly, but
      * instead go through the Locker interface.
@@ -108,6 +115,12 @@ namespace mongo {
          */
         void downgrade(LockRequest* request, LockMode newMode);
 
+        /**
+         * Returns whether any request is waiting for the resource, either to get it or to convert
+         * the mode in which it already holds it. Never blocks.
+         */
+        bool hasWaitingRequests(ResourceId resId) const;
+
         /**
          * Iterates through all buckets and deletes all locks, which have no requests on them. This
          * call is kind of expensive and should only be used for reducing the memory footprint of
@@ -130,8 +143,8 @@ namespace mongo {
         // These types describe the locks hash table
 
         struct LockBucket {
-            LockBucket() : mutex("LockManager") { }
-            SimpleMutex mutex;
+            LockBucket() : mutex(&lockManagerMutexStats) { }
+            AdaptiveMutex mutex;
             typedef unordered_map<ResourceId, LockHead*> Map;
             Map data;
             LockHead* findOrInsert(ResourceId resId);
@@ -141,11 +154,11 @@ namespace mongo {
         // modes and potentially other modes that don't conflict with themselves. This avoids
         // contention on the regular LockHead in the lock manager.
         struct Partition {
-            Partition() : mutex("LockManager") { }
+            Partition() : mutex(&lockManagerMutexStats) { }
             PartitionedLockHead* find(ResourceId resId);
             PartitionedLockHead* findOrInsert(ResourceId resId);
             typedef unordered_map<ResourceId, PartitionedLockHead*> Map;
-            SimpleMutex mutex;
+            AdaptiveMutex mutex;
             Map data;
         };
 
@@ -161,6 +174,28 @@ namespace mongo {
          */
         Partition* _getPartition(LockRequest* request) const;
 
+        /**
+         * Retrieves the FastIntentLock which grants intent mode requests on the specified
+         * resource, or NULL if that resource doesn't have one. The result for a given resource
+         * never changes. There is no need to hold a lock when calling this function.
+         */
+        FastIntentLock* _getFastIntentLock(ResourceId resId) const;
+
+        /**
+         * Fills in a request, which has been granted by 'fastIntentLock' in the specified mode.
+         */
+        void _grantByFastIntentLock(FastIntentLock* fastIntentLock,
+                                    LockRequest* request,
+                                    LockMode mode);
+
+        /**
+         * Moves a request granted by its FastIntentLock to the granted queue of 'lock', so it can
+         * be converted. Closes the FastIntentLock if it is still open.
+         *
+         * MUST be called under the lock bucket's mutex.
+         */
+        void _adoptFastIntentRequest(LockHead* lock, LockRequest* request);
+
         /**
          * Prints the contents of a bucket to the log.
          */
@@ -184,6 +219,12 @@ namespace mongo {
 
         static const unsigned _numPartitions;
         Partition* _partitions;
+
+        // Intent mode requests on the global and database resources don't conflict with each
+        // other and are by far the most common, so they are granted by one of these without
+        // taking any mutex, until a request in a conflicting mode comes along.
+        static const unsigned _numFastIntentLocks;
+        FastIntentLock* _fastIntentLocks;
     };
 
 
@@ -0,0 +1,109 @@
+// lock_manager_bench.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/concurrency/lock_manager.h"
+#include "mongo/db/concurrency/lock_state.h"
+#include "mongo/unittest/benchmark.h"
+
+namespace mongo {
+namespace {
+
+    using unittest::doNotOptimizeAway;
+
+    class NoopLockGrantNotification : public LockGrantNotification {
+    public:
+        virtual void notify(ResourceId resId, LockResult result) {}
+    };
+
+    BENCHMARK(LockManager, LockUnlockUncontended) {
+        LockManager lockMgr;
+        const ResourceId resId(RESOURCE_COLLECTION, std::string("TestDB.collection"));
+
+        DefaultLockerImpl locker;
+        NoopLockGrantNotification notify;
+        LockRequest request;
+        request.initNew(&locker, &notify);
+
+        while (state.keepRunning()) {
+            doNotOptimizeAway(lockMgr.lock(resId, &request, MODE_IX));
+            lockMgr.unlock(&request);
+        }
+    }
+
+    BENCHMARK(LockManager, LockUnlockShared) {
+        LockManager lockMgr;
+        const ResourceId resId(RESOURCE_COLLECTION, std::string("TestDB.collection"));
+
+        // Another holder of the resource takes it off the uncontended fast path.
+        DefaultLockerImpl otherLocker;
+        NoopLockGrantNotification otherNotify;
+        LockRequest otherRequest;
+        otherRequest.initNew(&otherLocker, &otherNotify);
+        lockMgr.lock(resId, &otherRequest, MODE_S);
+
+        DefaultLockerImpl locker;
+        NoopLockGrantNotification notify;
+        LockRequest request;
+        request.initNew(&locker, &notify);
+
+        while (state.keepRunning()) {
+            doNotOptimizeAway(lockMgr.lock(resId, &request, MODE_S));
+            lockMgr.unlock(&request);
+        }
+
+        lockMgr.unlock(&otherRequest);
+    }
+
+    BENCHMARK(Locker, GlobalAndCollectionIX) {
+        const ResourceId resId(RESOURCE_COLLECTION, std::string("TestDB.collection"));
+        DefaultLockerImpl locker;
+
+        while (state.keepRunning()) {
+            locker.lockGlobal(MODE_IX);
+            locker.lock(resId, MODE_IX);
+            locker.unlockAll();
+        }
+    }
+
+    BENCHMARK(Locker, MMAPV1GlobalAndCollectionX) {
+        const ResourceId resId(RESOURCE_COLLECTION, std::string("TestDB.collection"));
+        MMAPV1LockerImpl locker;
+
+        while (state.keepRunning()) {
+            locker.lockGlobal(MODE_IX);
+            locker.lock(resId, MODE_X);
+            locker.unlockAll();
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
@@ -40,6 +40,7 @@ namespace mongo {
 
     class Locker;
 
+    struct FastIntentLock;
     struct LockHead;
     struct PartitionedLockHead;
 
@@ -328,6 +329,12 @@ namespace mongo {
         // only transition from 'partitionedLock' to 'lock', never the other way around.
         PartitionedLockHead* partitionedLock;
 
+        // Pointer to the fast intent lock which granted this request, or null if it was not
+        // granted that way. Such requests are only counted, so they are on no list and both
+        // 'lock' and 'partitionedLock' are NULL. A request can only transition from
+        // 'fastIntentLock' to 'lock', never the other way around.
+        FastIntentLock* fastIntentLock;
+
         // The reason intrusive linked list is used instead of the std::list class is to allow
         // for entries to be removed from the middle of the list in O(1) time, if they are known
         // instead of having to search for them and we cannot persist iterators, because the list
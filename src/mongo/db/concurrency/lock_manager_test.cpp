@@ -819,4 +819,75 @@ namespace mongo {
         ASSERT(lockMgr.unlock(&requestX));
     }
 
+    TEST(LockManager, FastIntentLockConflict) {
+        LockManager lockMgr;
+        const ResourceId resId(RESOURCE_DATABASE, std::string("TestDB"));
+
+        MMAPV1LockerImpl lockerIS;
+        LockRequestCombo requestIS(&lockerIS);
+        ASSERT(LOCK_OK == lockMgr.lock(resId, &requestIS, MODE_IS));
+
+        MMAPV1LockerImpl lockerIX;
+        LockRequestCombo requestIX(&lockerIX);
+        ASSERT(LOCK_OK == lockMgr.lock(resId, &requestIX, MODE_IX));
+
+        // The X request must wait for the intent locks, even though they are on no queue
+        MMAPV1LockerImpl lockerX;
+        LockRequestCombo requestX(&lockerX);
+        ASSERT(LOCK_WAITING == lockMgr.lock(resId, &requestX, MODE_X));
+
+        ASSERT(lockMgr.unlock(&requestIS));
+        ASSERT(requestX.numNotifies == 0);
+
+        ASSERT(lockMgr.unlock(&requestIX));
+        ASSERT(requestX.numNotifies == 1);
+        ASSERT(requestX.lastResult == LOCK_OK);
+
+        // New intent requests must wait while X is held
+        MMAPV1LockerImpl lockerPending;
+        LockRequestCombo requestPending(&lockerPending);
+        ASSERT(LOCK_WAITING == lockMgr.lock(resId, &requestPending, MODE_IX));
+
+        ASSERT(lockMgr.unlock(&requestX));
+        ASSERT(requestPending.numNotifies == 1);
+        ASSERT(requestPending.lastResult == LOCK_OK);
+
+        ASSERT(lockMgr.unlock(&requestPending));
+
+        // Once everything has drained, intent requests are granted immediately again
+        MMAPV1LockerImpl lockerAfter;
+        LockRequestCombo requestAfter(&lockerAfter);
+        ASSERT(LOCK_OK == lockMgr.lock(resId, &requestAfter, MODE_IS));
+        ASSERT(lockMgr.unlock(&requestAfter));
+    }
+
+    TEST(LockManager, FastIntentLockConvertUpgrade) {
+        LockManager lockMgr;
+        const ResourceId resId(RESOURCE_GLOBAL, 1);
+
+        MMAPV1LockerImpl locker1;
+        LockRequestCombo request1(&locker1);
+        ASSERT(LOCK_OK == lockMgr.lock(resId, &request1, MODE_IS));
+
+        MMAPV1LockerImpl locker2;
+        LockRequestCombo request2(&locker2);
+        ASSERT(LOCK_OK == lockMgr.lock(resId, &request2, MODE_IX));
+
+        // Converting between intent modes does not conflict
+        ASSERT(LOCK_OK == lockMgr.convert(resId, &request1, MODE_IX));
+        ASSERT(request1.mode == MODE_IX);
+
+        // Upgrade to X must wait for the other intent lock
+        ASSERT(LOCK_WAITING == lockMgr.convert(resId, &request1, MODE_X));
+
+        ASSERT(lockMgr.unlock(&request2));
+        ASSERT(request1.numNotifies == 1);
+        ASSERT(request1.lastResult == LOCK_OK);
+        ASSERT(request1.mode == MODE_X);
+
+        ASSERT(!lockMgr.unlock(&request1));
+        ASSERT(!lockMgr.unlock(&request1));
+        ASSERT(lockMgr.unlock(&request1));
+    }
+
 } // namespace mongo
@@ -32,6 +32,9 @@
 
 #include "mongo/db/concurrency/lock_state.h"
 
+#include <vector>
+
+#include "mongo/db/concurrency/lock_contention.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/platform/compiler.h"
@@ -279,7 +282,9 @@ namespace {
           _requestStartTime(0),
           _wuowNestingLevel(0),
           _batchWriter(false),
-          _lockPendingParallelWriter(false) {
+          _lockPendingParallelWriter(false),
+          _admissionPriority(kAdmissionInteractive),
+          _holdsAdmissionTicket(false) {
 
     }
 
@@ -307,6 +312,17 @@ namespace {
 
     template<bool IsForMMAPV1>
     LockResult LockerImpl<IsForMMAPV1>::lockGlobalBegin(LockMode mode) {
+        // Admission is only waited for while no locks are held, so that waiting for a ticket
+        // can't hold up whoever has one. Global S and X requests queue on the lock itself.
+        AdmissionTickets* tickets = getGlobalAdmissionTickets();
+        if (tickets &&
+            !_holdsAdmissionTicket &&
+            (mode == MODE_IS || mode == MODE_IX) &&
+            _requests.find(resourceIdGlobal).finished()) {
+            tickets->waitForTicket(_admissionPriority);
+            _holdsAdmissionTicket = true;
+        }
+
         const LockResult result = lockBegin(resourceIdGlobal, mode);
         if (result == LOCK_OK) return LOCK_OK;
 
@@ -505,6 +521,32 @@ namespace {
         return ResourceId();
     }
 
+    template<bool IsForMMAPV1>
+    bool LockerImpl<IsForMMAPV1>::hasLockWaiters() const {
+        // Don't hold the spinlock while going to the lock manager
+        std::vector<ResourceId> granted;
+        {
+            scoped_spinlock scopedLock(_lock);
+
+            LockRequestsMap::ConstIterator it = _requests.begin();
+            while (!it.finished()) {
+                if (it->status == LockRequest::STATUS_GRANTED) {
+                    granted.push_back(it.key());
+                }
+
+                it.next();
+            }
+        }
+
+        for (size_t i = 0; i < granted.size(); i++) {
+            if (globalLockManager.hasWaitingRequests(granted[i])) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     template<bool IsForMMAPV1>
     void LockerImpl<IsForMMAPV1>::getLockerInfo(LockerInfo* lockerInfo) const {
         invariant(lockerInfo);
@@ -716,12 +758,22 @@ namespace {
             }
         }
 
+        const uint64_t totalWaitMicros = curTimeMicros64() - _requestStartTime;
+        globalContendedResources.recordWait(resId, mode, totalWaitMicros);
+        _totalWaitMicros.fetchAndAdd(totalWaitMicros);
+
         // Cleanup the state, since this is an unused lock now
         if (result != LOCK_OK) {
             LockRequestsMap::Iterator it = _requests.find(resId);
             if (globalLockManager.unlock(it.objAddr())) {
-                scoped_spinlock scopedLock(_lock);
-                it.remove();
+                {
+                    scoped_spinlock scopedLock(_lock);
+                    it.remove();
+                }
+
+                if (resId == resourceIdGlobal) {
+                    _releaseAdmissionTicket();
+                }
             }
         }
 
@@ -742,8 +794,15 @@ namespace {
         }
 
         if (globalLockManager.unlock(it.objAddr())) {
-            scoped_spinlock scopedLock(_lock);
-            it.remove();
+            const bool isGlobal = it.key() == resourceIdGlobal;
+            {
+                scoped_spinlock scopedLock(_lock);
+                it.remove();
+            }
+
+            if (isGlobal) {
+                _releaseAdmissionTicket();
+            }
 
             return true;
         }
@@ -751,6 +810,14 @@ namespace {
         return false;
     }
 
+    template<bool IsForMMAPV1>
+    void LockerImpl<IsForMMAPV1>::_releaseAdmissionTicket() {
+        if (_holdsAdmissionTicket) {
+            getGlobalAdmissionTickets()->release();
+            _holdsAdmissionTicket = false;
+        }
+    }
+
     template<bool IsForMMAPV1>
     LockMode LockerImpl<IsForMMAPV1>::_getModeForMMAPV1FlushLock() const {
         invariant(IsForMMAPV1);
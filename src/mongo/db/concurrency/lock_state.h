@@ -126,6 +126,10 @@ namespace mongo {
 
         virtual void getLockerInfo(LockerInfo* lockerInfo) const;
 
+        virtual unsigned long long getTotalWaitMicros() const {
+            return _totalWaitMicros.loadRelaxed();
+        }
+
         virtual bool saveLockStateAndUnlock(LockSnapshot* stateOut);
 
         virtual void restoreLockState(const LockSnapshot& stateToRestore);
@@ -211,6 +215,10 @@ namespace mongo {
         // db.currentOp. Complementary to the per-instance locking statistics.
         LockStats _stats;
 
+        // Time spent waiting for all lock requests so far, which CurOp charges to the operations
+        // that did the waiting. Read by other threads through getTotalWaitMicros.
+        AtomicUInt64 _totalWaitMicros;
+
         // Delays release of exclusive/intent-exclusive locked resources until the write unit of
         // work completes. Value of 0 means we are not inside a write unit of work.
         int _wuowNestingLevel;
@@ -238,6 +246,13 @@ namespace mongo {
 
         virtual bool hasLockPending() const { return getWaitingResource().isValid() || _lockPendingParallelWriter; }
 
+        virtual bool hasLockWaiters() const;
+
+        virtual void setAdmissionPriority(AdmissionPriority priority) {
+            _admissionPriority = priority;
+        }
+        virtual AdmissionPriority getAdmissionPriority() const { return _admissionPriority; }
+
         virtual void setIsBatchWriter(bool newValue) { _batchWriter = newValue; }
         virtual bool isBatchWriter() const { return _batchWriter; }
         virtual void setLockPendingParallelWriter(bool newValue) { 
@@ -248,6 +263,13 @@ namespace mongo {
 
         bool _batchWriter;
         bool _lockPendingParallelWriter;
+
+        AdmissionPriority _admissionPriority;
+
+        // Whether an admission ticket was taken for the global lock currently held.
+        bool _holdsAdmissionTicket;
+
+        void _releaseAdmissionTicket();
     };
 
     typedef LockerImpl<false> DefaultLockerImpl;
@@ -117,6 +117,30 @@ namespace {
         locker2.unlockAll();
     }
 
+    TEST(LockerImpl, HasLockWaiters) {
+        const ResourceId resId(RESOURCE_COLLECTION, std::string("TestDB.collection"));
+
+        DefaultLockerImpl locker1;
+        ASSERT(LOCK_OK == locker1.lockGlobal(MODE_IX));
+        ASSERT(LOCK_OK == locker1.lock(resId, MODE_X));
+        ASSERT(!locker1.hasLockWaiters());
+
+        DefaultLockerImpl locker2;
+        ASSERT(LOCK_OK == locker2.lockGlobal(MODE_IX));
+        ASSERT(!locker1.hasLockWaiters());
+
+        // Only locker1 holds a lock someone waits for
+        ASSERT(LOCK_WAITING == locker2.lockBegin(resId, MODE_S));
+        ASSERT(locker1.hasLockWaiters());
+        ASSERT(!locker2.hasLockWaiters());
+
+        ASSERT(locker2.unlock(resId));
+        ASSERT(!locker1.hasLockWaiters());
+
+        ASSERT(locker1.unlockAll());
+        ASSERT(locker2.unlockAll());
+    }
+
     TEST(LockerImpl, ReadTransaction) {
         DefaultLockerImpl locker;
 
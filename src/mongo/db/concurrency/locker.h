@@ -32,6 +32,7 @@
 #include <vector>
 
 #include "mongo/base/disallow_copying.h"
+#include "mongo/db/concurrency/admission_control.h"
 #include "mongo/db/concurrency/lock_manager.h"
 #include "mongo/db/concurrency/lock_stats.h"
 
@@ -213,6 +214,12 @@ namespace mongo {
 
         virtual void getLockerInfo(LockerInfo* lockerInfo) const = 0;
 
+        /**
+         * Returns the total number of microseconds this locker has spent waiting for locks to be
+         * granted. Safe to call from threads other than the one which owns the locker.
+         */
+        virtual unsigned long long getTotalWaitMicros() const = 0;
+
         /**
          * LockSnapshot captures the state of all resources that are locked, what modes they're
          * locked in, and how many times they've been locked in that mode.
@@ -273,6 +280,21 @@ namespace mongo {
          */
         virtual bool hasLockPending() const = 0;
 
+        /**
+         * Returns whether another locker is waiting for any of the resources granted to this one.
+         * Long running operations can use this to give up their locks as soon as they block
+         * someone, instead of on a timer.
+         */
+        virtual bool hasLockWaiters() const = 0;
+
+        /**
+         * The queue this locker waits in for an admission ticket, when admission control is on.
+         * A ticket is taken before the outermost intent lock on the global resource and given
+         * back when the global lock is released, including when yielding.
+         */
+        virtual void setAdmissionPriority(AdmissionPriority priority) = 0;
+        virtual AdmissionPriority getAdmissionPriority() const = 0;
+
         // Used for the replication parallel log op application threads
         virtual void setIsBatchWriter(bool newValue) = 0;
         virtual bool isBatchWriter() const = 0;
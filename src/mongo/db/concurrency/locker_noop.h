@@ -118,6 +118,10 @@ namespace mongo {
             invariant(false);
         }
 
+        virtual unsigned long long getTotalWaitMicros() const {
+            return 0;
+        }
+
         virtual bool saveLockStateAndUnlock(LockSnapshot* stateOut) {
             invariant(false);
         }
@@ -158,6 +162,18 @@ namespace mongo {
             invariant(false);
         }
 
+        virtual bool hasLockWaiters() const {
+            invariant(false);
+        }
+
+        virtual void setAdmissionPriority(AdmissionPriority priority) {
+            invariant(false);
+        }
+
+        virtual AdmissionPriority getAdmissionPriority() const {
+            invariant(false);
+        }
+
         virtual void setIsBatchWriter(bool newValue) {
             invariant(false);
         }
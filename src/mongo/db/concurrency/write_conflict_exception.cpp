@@ -31,12 +31,66 @@
 #define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kWrite
 
 #include "mongo/db/concurrency/write_conflict_exception.h"
+
+#include <algorithm>
+
 #include "mongo/db/server_parameters.h"
+#include "mongo/platform/random.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/log.h"
 #include "mongo/util/stacktrace.h"
+#include "mongo/util/string_map.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
+    // A namespace is hot once it sees this many write conflicts within a second.
+    MONGO_EXPORT_SERVER_PARAMETER(writeConflictHotNamespaceRate, int, 100);
+
+namespace {
+
+    // Backoff sleeps start around this long, and double with every retry up to the maximum.
+    const long long kMinBackoffMicros = 100;
+    const long long kMaxBackoffMicros = 10 * 1000;
+
+    // Free retries before the first sleep while the namespace is not hot.
+    const int kColdFreeRetries = 3;
+
+    struct NamespaceState {
+        NamespaceState() : windowStartMillis(0), windowConflicts(0) { }
+
+        WriteConflictException::NamespaceStats stats;
+
+        // Conflicts since windowStartMillis, which is reset every second.
+        long long windowStartMillis;
+        long long windowConflicts;
+    };
+
+    // Conflicts are the slow path already, so one mutex for all namespaces is cheap enough.
+    SimpleMutex namespaceStatesMutex("writeConflictNamespaces");
+    StringMap<NamespaceState> namespaceStates;
+    PseudoRandom backoffRandom(static_cast<int64_t>(curTimeMicros64()));
+
+    /**
+     * How long to sleep before the given retry, given how many conflicts the namespace had in
+     * the last second. Sleeps fall at random in the upper half of an exponentially growing
+     * range, so writers which conflicted with each other do not retry in lockstep.
+     */
+    long long backoffMicros(int attempt, long long recentConflicts) {
+        const int freeRetries =
+            recentConflicts < writeConflictHotNamespaceRate ? kColdFreeRetries : 0;
+        if (attempt <= freeRetries) {
+            return 0;
+        }
+
+        const int doublings = std::min(attempt - freeRetries - 1, 7);
+        const long long range = std::min(kMaxBackoffMicros, kMinBackoffMicros << doublings);
+        const uint32_t jitter = static_cast<uint32_t>(backoffRandom.nextInt32());
+        return range / 2 + static_cast<long long>(jitter % (range / 2 + 1));
+    }
+
+} // namespace
+
     bool WriteConflictException::trace = false;
 
     WriteConflictException::WriteConflictException()
@@ -52,24 +106,51 @@ namespace mongo {
                                                const StringData& operation,
                                                const StringData& ns) {
 
+        long long recentConflicts;
+        long long sleepMicros;
+        {
+            SimpleMutex::scoped_lock lk(namespaceStatesMutex);
+            NamespaceState& state = namespaceStates[ns];
+
+            const long long now = curTimeMillis64();
+            if (now - state.windowStartMillis >= 1000) {
+                state.windowStartMillis = now;
+                state.windowConflicts = 0;
+            }
+            recentConflicts = ++state.windowConflicts;
+
+            sleepMicros = backoffMicros(attempt, recentConflicts);
+            state.stats.conflicts++;
+            state.stats.backoffMicros += sleepMicros;
+        }
+
         LOG(1) << "Caught WriteConflictException doing " << operation
                << " on " << ns
-               << ", attempt: " << attempt << " retrying";
+               << ", attempt: " << attempt
+               << ", conflicts on ns in the last second: " << recentConflicts
+               << ", retrying in " << sleepMicros << " micros";
 
-        // All numbers below chosen by guess and check against a few random benchmarks.
-        if (attempt < 4) {
-            // no-op
-        }
-        else if (attempt < 10) {
-            sleepmillis(1);
-        }
-        else if (attempt < 100) {
-            sleepmillis(5);
+        if (sleepMicros > 0) {
+            sleepmicros(sleepMicros);
         }
-        else {
-            sleepmillis(10);
+    }
+
+    // static
+    WriteConflictException::NamespaceStatsMap WriteConflictException::getNamespaceStats() {
+        NamespaceStatsMap out;
+        SimpleMutex::scoped_lock lk(namespaceStatesMutex);
+        for (StringMap<NamespaceState>::const_iterator it = namespaceStates.begin();
+             it != namespaceStates.end();
+             ++it) {
+            out[it->first] = it->second.stats;
         }
+        return out;
+    }
 
+    // static
+    void WriteConflictException::namespaceDropped(const StringData& ns) {
+        SimpleMutex::scoped_lock lk(namespaceStatesMutex);
+        namespaceStates.erase(ns);
     }
 
     namespace {
@@ -31,6 +31,8 @@
 #pragma once
 
 #include <exception>
+#include <map>
+#include <string>
 
 #include "mongo/util/assert_util.h"
 
@@ -46,8 +48,9 @@ namespace mongo {
         WriteConflictException();
 
         /**
-         * Will log a message if sensible and will do an exponential backoff to make sure
-         * we don't hammer the same doc over and over.
+         * Will log a message if sensible and will do a jittered exponential backoff to make sure
+         * we don't hammer the same doc over and over. Retries start without sleeping while
+         * conflicts on 'ns' are rare, and sleep from the first retry on while 'ns' is hot.
          * @param attempt - what attempt is this, 1 based
          * @param operation - e.g. "update"
          */
@@ -55,6 +58,28 @@ namespace mongo {
                                   const StringData& operation,
                                   const StringData& ns);
 
+        /**
+         * Conflicts retried through logAndBackoff() on one namespace, and the time spent
+         * sleeping before those retries.
+         */
+        struct NamespaceStats {
+            NamespaceStats() : conflicts(0), backoffMicros(0) { }
+            long long conflicts;
+            long long backoffMicros;
+        };
+
+        typedef std::map<std::string, NamespaceStats> NamespaceStatsMap;
+
+        /**
+         * Returns the stats of every namespace which had a conflict retried.
+         */
+        static NamespaceStatsMap getNamespaceStats();
+
+        /**
+         * Forgets the stats of a dropped namespace.
+         */
+        static void namespaceDropped(const StringData& ns);
+
         /**
          * If true, will call printStackTrace on every WriteConflictException created.
          * Can be set via setParameter named traceWriteConflictExceptions.
@@ -37,6 +37,9 @@ namespace mongo {
 
     int ConnPoolOptions::maxConnsPerHost(200);
     int ConnPoolOptions::maxShardedConnsPerHost(200);
+    int ConnPoolOptions::minConnsPerHost(0);
+    int ConnPoolOptions::idleTimeoutSecs(600);
+    int ConnPoolOptions::healthCheckSecs(60);
 
     namespace {
 
@@ -54,6 +57,27 @@ namespace mongo {
                                         true,
                                         false /* can't change at runtime */);
 
+        ExportedServerParameter<int> //
+        minConnsPerHostParameter(ServerParameterSet::getGlobal(),
+                                 "connPoolMinConnsPerHost",
+                                 &ConnPoolOptions::minConnsPerHost,
+                                 true,
+                                 false /* can't change at runtime */);
+
+        ExportedServerParameter<int> //
+        idleTimeoutSecsParameter(ServerParameterSet::getGlobal(),
+                                 "connPoolIdleTimeoutSecs",
+                                 &ConnPoolOptions::idleTimeoutSecs,
+                                 true,
+                                 false /* can't change at runtime */);
+
+        ExportedServerParameter<int> //
+        healthCheckSecsParameter(ServerParameterSet::getGlobal(),
+                                 "connPoolHealthCheckSecs",
+                                 &ConnPoolOptions::healthCheckSecs,
+                                 true,
+                                 false /* can't change at runtime */);
+
         MONGO_INITIALIZER(InitializeConnectionPools)(InitializerContext* context) {
 
             // Initialize the sharded and unsharded outgoing connection pools
@@ -64,9 +88,15 @@ namespace mongo {
 
             pool.setName("connection pool");
             pool.setMaxPoolSize(ConnPoolOptions::maxConnsPerHost);
+            pool.setMinPoolSize(ConnPoolOptions::minConnsPerHost);
+            pool.setIdleTimeout(ConnPoolOptions::idleTimeoutSecs);
+            pool.setHealthCheckInterval(ConnPoolOptions::healthCheckSecs);
 
             shardConnectionPool.setName("sharded connection pool");
             shardConnectionPool.setMaxPoolSize(ConnPoolOptions::maxShardedConnsPerHost);
+            shardConnectionPool.setMinPoolSize(ConnPoolOptions::minConnsPerHost);
+            shardConnectionPool.setIdleTimeout(ConnPoolOptions::idleTimeoutSecs);
+            shardConnectionPool.setHealthCheckInterval(ConnPoolOptions::healthCheckSecs);
 
             return Status::OK();
         }
@@ -49,6 +49,22 @@ namespace mongo {
          * Maximum connections per host the sharded conn pool should use
          */
         static int maxShardedConnsPerHost;
+
+        /**
+         * Idle connections per host which both pools keep past the idle timeout
+         */
+        static int minConnsPerHost;
+
+        /**
+         * Seconds a pooled connection may sit unused before it is closed, or -1 for never
+         */
+        static int idleTimeoutSecs;
+
+        /**
+         * Seconds since a pooled connection was last used or checked in the background before
+         * handing it out checks it is still connected
+         */
+        static int healthCheckSecs;
     };
 
 }
@@ -32,12 +32,17 @@
 
 #include "mongo/db/curop.h"
 
+#include <boost/static_assert.hpp>
+
 #include "mongo/base/counter.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/catalog/database.h"
+#include "mongo/db/concurrency/locker.h"
 #include "mongo/db/global_environment_experiment.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/top.h"
+#include "mongo/db/storage/storage_engine.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
 
@@ -56,6 +61,21 @@ namespace mongo {
     // This fail point cannot be used with the maxTimeAlwaysTimeOut fail point.
     MONGO_FP_DECLARE(maxTimeNeverTimeOut);
 
+    // At profiling level 2, profile only one in this many of the ops that are not slow.
+    MONGO_EXPORT_SERVER_PARAMETER(profileSampleRate, int, 1);
+
+    // Whether operations ask the storage engine what it did for them, see CurOp::storageStats.
+    MONGO_EXPORT_SERVER_PARAMETER(operationStorageStats, bool, true);
+
+    namespace {
+        AtomicUInt32 profileSampleCounter;
+
+        // Indexed by CurOp::TimeCategory.
+        const char* const timeCategoryNames[] = { "lockWait", "storage", "yield", "writeConcern" };
+        BOOST_STATIC_ASSERT(sizeof(timeCategoryNames) / sizeof(timeCategoryNames[0]) ==
+                            CurOp::kNumTimeCategories);
+    } // namespace
+
     // todo : move more here
 
     CurOp::CurOp( Client * client , CurOp * wrapped ) :
@@ -82,6 +102,12 @@ namespace mongo {
         _progressMeter.finished();
         _killPending.store(0);
         _numYields = 0;
+        for (int i = 0; i < kNumTimeCategories; i++) {
+            _timeMicros[i] = 0;
+        }
+        _lockWaitStartMicros = -1;
+        _storageStats = StorageStats();
+        _storageStatsRunning = false;
         _expectedLatencyMs = 0;
     }
 
@@ -136,9 +162,25 @@ namespace mongo {
         _ns = ns;
     }
 
+    bool CurOp::shouldDBProfile( int ms ) const {
+        if ( _dbprofile <= 0 )
+            return false;
+
+        if ( ms >= serverGlobalParams.slowMS )
+            return true;
+
+        if ( _dbprofile < 2 )
+            return false;
+
+        const int sampleRate = profileSampleRate;
+        return sampleRate <= 1 || profileSampleCounter.fetchAndAdd(1) % sampleRate == 0;
+    }
+
     void CurOp::ensureStarted() {
         if ( _start == 0 ) {
             _start = curTimeMicros64();
+            _startLockWaitClock();
+            _startStorageStatsClock();
 
             // If ensureStarted() is invoked after setMaxTimeMicros(), then time limit tracking will
             // start here.  This is because time limit tracking can only commence after the
@@ -149,6 +191,75 @@ namespace mongo {
         }
     }
 
+    void CurOp::_startLockWaitClock() {
+        _lockWaitStartMicros = _client->getLocker()->getTotalWaitMicros();
+    }
+
+    void CurOp::_stopLockWaitClock() {
+        if (_lockWaitStartMicros < 0) {
+            return;
+        }
+        _timeMicros[kLockWaitTime] = timeMicros(kLockWaitTime);
+        _lockWaitStartMicros = -1;
+    }
+
+    void CurOp::_startStorageStatsClock() {
+        if (!operationStorageStats) {
+            return;
+        }
+        StorageEngine* engine = getGlobalEnvironment()->getGlobalStorageEngine();
+        if (!engine) {
+            return;
+        }
+        _storageStatsAtStart = engine->getThreadStorageStats();
+        _storageStatsRunning = true;
+    }
+
+    void CurOp::_stopStorageStatsClock() {
+        if (!_storageStatsRunning) {
+            return;
+        }
+        _storageStats = storageStats();
+        _storageStatsRunning = false;
+    }
+
+    StorageStats CurOp::storageStats() const {
+        if (_storageStatsRunning) {
+            return getGlobalEnvironment()->getGlobalStorageEngine()->getThreadStorageStats()
+                .since(_storageStatsAtStart);
+        }
+        return _storageStats;
+    }
+
+    long long CurOp::timeMicros(TimeCategory category) const {
+        if (category == kLockWaitTime && _lockWaitStartMicros >= 0) {
+            return _client->getLocker()->getTotalWaitMicros() - _lockWaitStartMicros;
+        }
+        return _timeMicros[category];
+    }
+
+    void CurOp::appendTimeBreakdown(const StringData& name, BSONObjBuilder* builder) const {
+        BSONObjBuilder breakdown;
+        for (int i = 0; i < kNumTimeCategories; i++) {
+            const long long micros = timeMicros(static_cast<TimeCategory>(i));
+            if (micros > 0) {
+                breakdown.appendNumber(timeCategoryNames[i], micros);
+            }
+        }
+        if (!breakdown.asTempObj().isEmpty()) {
+            builder->append(name, breakdown.obj());
+        }
+    }
+
+    void CurOp::reportTimeBreakdown(StringBuilder& s) const {
+        for (int i = 0; i < kNumTimeCategories; i++) {
+            const long long micros = timeMicros(static_cast<TimeCategory>(i));
+            if (micros > 0) {
+                s << " " << timeCategoryNames[i] << "Micros:" << micros;
+            }
+        }
+    }
+
     void CurOp::enter(const char* ns, int dbProfileLevel) {
         ensureStarted();
         _ns = ns;
@@ -210,6 +321,7 @@ namespace mongo {
             builder->append("killPending", true);
 
         builder->append( "numYields" , _numYields );
+        appendTimeBreakdown("timeBreakdownMicros", builder);
     }
 
     BSONObj CurOp::description() {
@@ -35,6 +35,7 @@
 
 #include "mongo/db/client.h"
 #include "mongo/db/server_options.h"
+#include "mongo/db/storage/storage_stats.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/spin_lock.h"
 #include "mongo/util/net/hostandport.h"
@@ -203,12 +204,11 @@ namespace mongo {
         OpDebug& debug()           { return _debug; }
         string getNS() const { return _ns.toString(); }
 
-        bool shouldDBProfile( int ms ) const {
-            if ( _dbprofile <= 0 )
-                return false;
-
-            return _dbprofile >= 2 || ms >= serverGlobalParams.slowMS;
-        }
+        /**
+         * Whether to profile this op, which took 'ms'. Slow ops always are if profiling is on;
+         * at level 2 the others are too, one in every profileSampleRate of them.
+         */
+        bool shouldDBProfile( int ms ) const;
 
         unsigned int opNum() const { return _opNum; }
 
@@ -258,6 +258,8 @@ namespace mongo {
         void done() {
             _active = false;
             _end = curTimeMicros64();
+            _stopLockWaitClock();
+            _stopStorageStatsClock();
         }
 
         long long totalTimeMicros() {
@@ -302,6 +304,64 @@ namespace mongo {
         bool killPending() const { return _killPending.loadRelaxed(); }
         void yielded() { _numYields++; }
         int numYields() const { return _numYields; }
+
+        /**
+         * Places other than its own code where an operation can spend its time. How long it
+         * spends in each is accumulated as it runs and reported with the operation.
+         */
+        enum TimeCategory {
+            kLockWaitTime = 0,  // waiting for the lock manager to grant locks
+            kStorageTime,       // committing write units of work to the storage engine
+            kYieldTime,         // yielded with locks released, e.g. paging in a record
+            kWriteConcernTime,  // waiting for the journal or for replication
+            kNumTimeCategories
+        };
+
+        /**
+         * Charges 'micros' to 'category'. Lock waits are taken from the client's Locker instead.
+         */
+        void addTime(TimeCategory category, long long micros) {
+            dassert(category != kLockWaitTime);
+            _timeMicros[category] += micros;
+        }
+
+        /**
+         * Charges the time from its construction until it goes out of scope to 'category'.
+         */
+        class TimeScope {
+            MONGO_DISALLOW_COPYING(TimeScope);
+        public:
+            TimeScope(CurOp* curOp, TimeCategory category)
+                : _curOp(curOp), _category(category), _start(curTimeMicros64()) { }
+
+            ~TimeScope() {
+                _curOp->addTime(_category, curTimeMicros64() - _start);
+            }
+
+        private:
+            CurOp* const _curOp;
+            const TimeCategory _category;
+            const unsigned long long _start;
+        };
+
+        /** Microseconds of this operation so far spent in 'category'. */
+        long long timeMicros(TimeCategory category) const;
+
+        /**
+         * Appends the categories this operation spent any time in as
+         * "name: {lockWait: <micros>, storage: <micros>, ...}". Appends nothing if there are none.
+         */
+        void appendTimeBreakdown(const StringData& name, BSONObjBuilder* builder) const;
+
+        /** Same as appendTimeBreakdown, for the slow operation log line. */
+        void reportTimeBreakdown(StringBuilder& s) const;
+
+        /**
+         * What the storage engine did for this operation, see
+         * StorageEngine::getThreadStorageStats. The engine counts per thread, so until the
+         * operation is done this must only be called from the operation's own thread.
+         */
+        StorageStats storageStats() const;
         
         long long getExpectedLatencyMs() const { return _expectedLatencyMs; }
         void setExpectedLatencyMs( long long latency ) { _expectedLatencyMs = latency; }
@@ -318,6 +378,10 @@ namespace mongo {
     private:
         friend class Client;
         void _reset();
+        void _startLockWaitClock();
+        void _stopLockWaitClock();
+        void _startStorageStatsClock();
+        void _stopStorageStatsClock();
 
         static AtomicUInt32 _nextOpNum;
         Client * _client;
@@ -338,6 +402,17 @@ namespace mongo {
         ProgressMeter _progressMeter;
         AtomicInt32 _killPending;
         int _numYields;
+
+        // Microseconds spent in each TimeCategory. While the operation runs, its lock wait time
+        // is instead the growth of the Locker's total wait time since _lockWaitStartMicros.
+        long long _timeMicros[kNumTimeCategories];
+        long long _lockWaitStartMicros; // -1 when the operation isn't running
+
+        // Like the lock wait time: while the operation runs, its storage stats are the growth of
+        // the engine's counters for the thread since _storageStatsAtStart.
+        StorageStats _storageStats;
+        StorageStats _storageStatsAtStart;
+        bool _storageStatsRunning;
         
         // this is how much "extra" time a query might take
         // a writebacklisten for example will block for 30s 
@@ -39,6 +39,7 @@
 #include "mongo/db/client.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/commands/fsync.h"
+#include "mongo/db/concurrency/lock_contention.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/matcher/matcher.h"
@@ -168,6 +169,10 @@ namespace mongo {
 
         // "waitingForLock" section
         infoBuilder.append("waitingForLock", lockerInfo.waitingResource.isValid());
+        if (lockerInfo.waitingResource.isValid()) {
+            infoBuilder.append("waitingForLockOn",
+                               globalContendedResources.getName(lockerInfo.waitingResource));
+        }
 
         // "lockStats" section
         {
@@ -50,6 +50,7 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_catalog_entry.h"
+#include "mongo/db/catalog/id_bloom_filter.h"
 #include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/catalog/index_key_validate.h"
 #include "mongo/db/client.h"
@@ -84,8 +85,10 @@
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/startup_warnings_mongod.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/cpu_sampler.h"
 #include "mongo/db/stats/snapshots.h"
 #include "mongo/db/storage/mmap_v1/mmap_v1_options.h"
+#include "mongo/db/storage/page_cache_warmer.h"
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/ttl.h"
@@ -231,6 +234,39 @@ namespace mongo {
             if( c ) c->shutdown();
         }
 
+        virtual ConnectionThreadState* makeConnectionThreadState( AbstractMessagingPort* p ) {
+            return new ClientThreadState();
+        }
+
+        virtual bool supportsConnectionThreadHandoff() const { return true; }
+
+    private:
+        /**
+         * Moves the connection's Client between worker threads.
+         */
+        class ClientThreadState : public ConnectionThreadState {
+        public:
+            ClientThreadState() : _client(NULL) {}
+
+            virtual ~ClientThreadState() {
+                delete _client;
+            }
+
+            virtual void attach() {
+                invariant(!currentClient.get());
+                currentClient.reset(_client);
+                _client = NULL;
+            }
+
+            virtual void detach() {
+                invariant(!_client);
+                _client = currentClient.release();
+            }
+
+        private:
+            // Owned while detached.
+            Client* _client;
+        };
     };
 
     static void logStartup() {
@@ -608,6 +644,10 @@ namespace mongo {
         }
 
         startClientCursorMonitor();
+        startProfileBufferFlusher();
+        startCpuSampler();
+        startPageCacheWarmer();
+        startIdBloomFilterBuilder();
 
         PeriodicTask::startRunningPeriodicTasks();
 
@@ -73,6 +73,7 @@
 #include "mongo/db/repl/repl_settings.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/repl/oplog.h"
+#include "mongo/db/stats/profile_buffer.h"
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
 #include "mongo/db/write_concern.h"
@@ -84,6 +85,7 @@
 #include "mongo/util/log.h"
 #include "mongo/util/md5.hpp"
 #include "mongo/util/print.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -377,6 +379,65 @@ namespace mongo {
         }
     } cmdProfile;
 
+    /**
+     * Reads this database's entries of the in-memory profile buffer, see ProfileBuffer.
+     */
+    class CmdProfileBuffer : public Command {
+    public:
+        CmdProfileBuffer() : Command("profileBuffer") { }
+
+        virtual bool slaveOk() const {
+            return true;
+        }
+
+        virtual void help( stringstream& help ) const {
+            help << "returns the profile documents of this database held in memory, oldest first\n";
+            help << "{ profileBuffer : 1, after : <seq> }\n";
+            help << "pass the returned 'seq' as 'after' to read on from there";
+        }
+
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            // Same as reading system.profile.
+            ActionSet actions;
+            actions.addAction(ActionType::find);
+            out->push_back(Privilege(
+                    ResourcePattern::forExactNamespace(NamespaceString(dbname, "system.profile")),
+                    actions));
+        }
+
+        bool run(OperationContext* txn, const string& dbname, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
+            ProfileBuffer* buffer = getGlobalProfileBuffer();
+            if ( !buffer ) {
+                errmsg = "the profile buffer is off, see the profileBufferSize parameter";
+                return false;
+            }
+
+            long long after = 0;
+            BSONElement afterElt = cmdObj["after"];
+            if ( afterElt.isNumber() ) {
+                after = std::max( afterElt.numberLong(), 0LL );
+            }
+
+            // Leave room in the reply for everything besides the documents.
+            vector<ProfileBuffer::Entry> entries;
+            const unsigned long long seq =
+                buffer->read( dbname, after, BSONObjMaxUserSize - 16 * 1024, &entries );
+
+            BSONArrayBuilder docs( result.subarrayStart( "entries" ) );
+            for ( size_t i = 0; i < entries.size(); i++ ) {
+                docs.append( entries[i].doc );
+            }
+            docs.done();
+
+            result.append( "seq", static_cast<long long>( seq ) );
+            return true;
+        }
+    } cmdProfileBuffer;
+
     class CmdDiagLogging : public Command {
     public:
         virtual bool slaveOk() const {
@@ -1450,6 +1511,23 @@ namespace mongo {
 
         txn->getCurOp()->setMaxTimeMicros(static_cast<unsigned long long>(maxTimeMS.getValue())
                                           * 1000);
+
+        // Handle command option admissionPriority, which only applies to this command.
+        const AdmissionPriority previousPriority = txn->lockState()->getAdmissionPriority();
+        BSONElement priorityElt = cmdObj["admissionPriority"];
+        if (!priorityElt.eoo()) {
+            AdmissionPriority priority;
+            if (priorityElt.type() != String ||
+                !parseAdmissionPriority(priorityElt.valueStringData(), &priority)) {
+                appendCommandStatus(result,
+                                    Status(ErrorCodes::BadValue,
+                                           "admissionPriority must be \"interactive\" or "
+                                           "\"batch\""));
+                return;
+            }
+            txn->lockState()->setAdmissionPriority(priority);
+        }
+        ON_BLOCK_EXIT_OBJ(*txn->lockState(), &Locker::setAdmissionPriority, previousPriority);
         try {
             txn->checkForInterrupt(); // May trigger maxTimeAlwaysTimeOut fail point.
         }
@@ -1465,7 +1543,9 @@ namespace mongo {
 
         c->_commandsExecuted.increment();
 
+        Timer runTimer;
         retval = _execCommand(txn, c, dbname, cmdObj, queryOptions, errmsg, result, fromRepl);
+        c->_latency.record(runTimer.micros());
 
         if ( !retval ){
             c->_commandsFailed.increment();
@@ -1519,7 +1599,8 @@ namespace mongo {
                                                     "commands; use maxTimeMS command option "
                                                     "instead");
                     BSONObj x = anObjBuilder.done();
-                    b.appendBuf(x.objdata(), x.objsize());
+                    if (&anObjBuilder.bb() != &b)
+                        b.appendBuf(x.objdata(), x.objsize());
                     return true;
                 }
             }
@@ -1556,7 +1637,9 @@ namespace mongo {
         }
 
         BSONObj x = anObjBuilder.done();
-        b.appendBuf(x.objdata(), x.objsize());
+        // Nothing to copy if the caller built the result in 'b' already.
+        if (&anObjBuilder.bb() != &b)
+            b.appendBuf(x.objdata(), x.objsize());
 
         return true;
     }
@@ -34,6 +34,7 @@
 
 #include "mongo/db/dbhelpers.h"
 
+#include <algorithm>
 #include <boost/filesystem/convenience.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <fstream>
@@ -330,7 +331,8 @@ namespace mongo {
                                     const WriteConcernOptions& writeConcern,
                                     RemoveSaver* callback,
                                     bool fromMigrate,
-                                    bool onlyRemoveOrphanedDocs )
+                                    bool onlyRemoveOrphanedDocs,
+                                    RemoveRangeThrottle* throttle )
     {
         Timer rangeRemoveTimer;
         const string& ns = range.ns;
@@ -369,7 +371,12 @@ namespace mongo {
         
         long long millisWaitingForReplication = 0;
 
-        while ( 1 ) {
+        bool done = false;
+        while ( !done ) {
+            const long long batchSize = throttle ? std::max(throttle->getBatchSize(), 1LL) : 1;
+            long long batchDocs = 0;
+            long long batchBytes = 0;
+
             // Scoping for write lock.
             {
                 Client::WriteContext ctx(txn, ns);
@@ -377,92 +384,103 @@ namespace mongo {
                 if ( !collection )
                     break;
 
-                IndexDescriptor* desc =
-                    collection->getIndexCatalog()->findIndexByKeyPattern( txn,
-                                                                          indexKeyPattern.toBSON() );
-
-                auto_ptr<PlanExecutor> exec(InternalPlanner::indexScan(txn, collection, desc,
-                                                                       min, max,
-                                                                       maxInclusive,
-                                                                       InternalPlanner::FORWARD,
-                                                                       InternalPlanner::IXSCAN_FETCH));
-                exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
-
-                RecordId rloc;
-                BSONObj obj;
-                PlanExecutor::ExecState state;
-                // This may yield so we cannot touch nsd after this.
-                state = exec->getNext(&obj, &rloc);
-                exec.reset();
-                if (PlanExecutor::IS_EOF == state) { break; }
-
-                if (PlanExecutor::DEAD == state) {
-                    warning(LogComponent::kSharding) << "cursor died: aborting deletion for "
-                              << min << " to " << max << " in " << ns
-                              << endl;
-                    break;
-                }
-
-                if (PlanExecutor::FAILURE == state) {
-                    warning(LogComponent::kSharding) << "cursor error while trying to delete "
-                              << min << " to " << max
-                              << " in " << ns << ": "
-                              << WorkingSetCommon::toStatusString(obj) << endl;
-                    break;
-                }
-
-                verify(PlanExecutor::ADVANCED == state);
-
-                WriteUnitOfWork wuow(txn);
-
-                if ( onlyRemoveOrphanedDocs ) {
-                    // Do a final check in the write lock to make absolutely sure that our
-                    // collection hasn't been modified in a way that invalidates our migration
-                    // cleanup.
-
-                    // We should never be able to turn off the sharding state once enabled, but
-                    // in the future we might want to.
-                    verify(shardingState.enabled());
-
-                    // In write lock, so will be the most up-to-date version
-                    CollectionMetadataPtr metadataNow = shardingState.getCollectionMetadata( ns );
+                for ( ; batchDocs < batchSize; batchDocs++ ) {
+                    IndexDescriptor* desc =
+                        collection->getIndexCatalog()->findIndexByKeyPattern( txn,
+                                                                              indexKeyPattern.toBSON() );
+
+                    auto_ptr<PlanExecutor> exec(InternalPlanner::indexScan(txn, collection, desc,
+                                                                           min, max,
+                                                                           maxInclusive,
+                                                                           InternalPlanner::FORWARD,
+                                                                           InternalPlanner::IXSCAN_FETCH));
+                    exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
+
+                    RecordId rloc;
+                    BSONObj obj;
+                    PlanExecutor::ExecState state;
+                    // This may yield so we cannot touch nsd after this.
+                    state = exec->getNext(&obj, &rloc);
+                    exec.reset();
+                    if (PlanExecutor::IS_EOF == state) { done = true; break; }
+
+                    if (PlanExecutor::DEAD == state) {
+                        warning(LogComponent::kSharding) << "cursor died: aborting deletion for "
+                                  << min << " to " << max << " in " << ns
+                                  << endl;
+                        done = true;
+                        break;
+                    }
 
-                    bool docIsOrphan;
-                    if ( metadataNow ) {
-                        ShardKeyPattern kp( metadataNow->getKeyPattern() );
-                        BSONObj key = kp.extractShardKeyFromDoc(obj);
-                        docIsOrphan = !metadataNow->keyBelongsToMe( key )
-                            && !metadataNow->keyIsPending( key );
+                    if (PlanExecutor::FAILURE == state) {
+                        warning(LogComponent::kSharding) << "cursor error while trying to delete "
+                                  << min << " to " << max
+                                  << " in " << ns << ": "
+                                  << WorkingSetCommon::toStatusString(obj) << endl;
+                        done = true;
+                        break;
                     }
-                    else {
-                        docIsOrphan = false;
+
+                    verify(PlanExecutor::ADVANCED == state);
+
+                    WriteUnitOfWork wuow(txn);
+
+                    if ( onlyRemoveOrphanedDocs ) {
+                        // Do a final check in the write lock to make absolutely sure that our
+                        // collection hasn't been modified in a way that invalidates our migration
+                        // cleanup.
+
+                        // We should never be able to turn off the sharding state once enabled, but
+                        // in the future we might want to.
+                        verify(shardingState.enabled());
+
+                        // In write lock, so will be the most up-to-date version
+                        CollectionMetadataPtr metadataNow = shardingState.getCollectionMetadata( ns );
+
+                        bool docIsOrphan;
+                        if ( metadataNow ) {
+                            ShardKeyPattern kp( metadataNow->getKeyPattern() );
+                            BSONObj key = kp.extractShardKeyFromDoc(obj);
+                            docIsOrphan = !metadataNow->keyBelongsToMe( key )
+                                && !metadataNow->keyIsPending( key );
+                        }
+                        else {
+                            docIsOrphan = false;
+                        }
+
+                        if ( !docIsOrphan ) {
+                            warning(LogComponent::kSharding)
+                                      << "aborting migration cleanup for chunk " << min << " to " << max
+                                      << ( metadataNow ? (string) " at document " + obj.toString() : "" )
+                                      << ", collection " << ns << " has changed " << endl;
+                            done = true;
+                            break;
+                        }
                     }
 
-                    if ( !docIsOrphan ) {
-                        warning(LogComponent::kSharding)
-                                  << "aborting migration cleanup for chunk " << min << " to " << max
-                                  << ( metadataNow ? (string) " at document " + obj.toString() : "" )
-                                  << ", collection " << ns << " has changed " << endl;
-                        break;
+                    if (!repl::getGlobalReplicationCoordinator()->canAcceptWritesForDatabase(ns)) {
+                        warning() << "stepped down from primary while deleting chunk; "
+                                  << "orphaning data in " << ns
+                                  << " in range [" << min << ", " << max << ")";
+                        return numDeleted;
                     }
-                }
 
-                if (!repl::getGlobalReplicationCoordinator()->canAcceptWritesForDatabase(ns)) {
-                    warning() << "stepped down from primary while deleting chunk; "
-                              << "orphaning data in " << ns
-                              << " in range [" << min << ", " << max << ")";
-                    return numDeleted;
-                }
+                    if ( callback )
+                        callback->goingToDelete( obj );
+
+                    batchBytes += obj.objsize();
 
-                if ( callback )
-                    callback->goingToDelete( obj );
+                    BSONObj deletedId;
+                    collection->deleteDocument( txn, rloc, false, false, &deletedId );
+                    // The above throws on failure, and so is not logged
+                    repl::logOp(txn, "d", ns.c_str(), deletedId, 0, 0, fromMigrate);
+                    wuow.commit();
+                    numDeleted++;
+                }
+            }
 
-                BSONObj deletedId;
-                collection->deleteDocument( txn, rloc, false, false, &deletedId );
-                // The above throws on failure, and so is not logged
-                repl::logOp(txn, "d", ns.c_str(), deletedId, 0, 0, fromMigrate);
-                wuow.commit();
-                numDeleted++;
+            if ( throttle && batchDocs > 0 ) {
+                throttle->batchDone( txn, batchDocs, batchBytes );
             }
 
             // TODO remove once the yielding below that references this timer has been removed
@@ -54,6 +54,7 @@ namespace mongo {
     struct Helpers {
 
         class RemoveSaver;
+        class RemoveRangeThrottle;
 
         /* ensure the specified index exists.
 
@@ -160,6 +161,10 @@ namespace mongo {
          * Returns -1 when no usable index exists
          *
          * Does oplog the individual document deletions.
+         *
+         * If a throttle is given, up to throttle->getBatchSize() documents are deleted under each
+         * acquisition of the write lock and throttle->batchDone() is called after every batch,
+         * with the lock released. Otherwise the documents are deleted one per lock acquisition.
          * // TODO: Refactor this mechanism, it is growing too large
          */
         static long long removeRange( OperationContext* txn,
@@ -168,7 +173,8 @@ namespace mongo {
                                       const WriteConcernOptions& secondaryThrottle,
                                       RemoveSaver* callback = NULL,
                                       bool fromMigrate = false,
-                                      bool onlyRemoveOrphanedDocs = false );
+                                      bool onlyRemoveOrphanedDocs = false,
+                                      RemoveRangeThrottle* throttle = NULL );
 
 
         // TODO: This will supersede Chunk::MaxObjectsPerChunk
@@ -220,6 +226,25 @@ namespace mongo {
             std::ofstream* _out;
         };
 
+        /**
+         * Controls the pace of removeRange.
+         */
+        class RemoveRangeThrottle {
+        public:
+            virtual ~RemoveRangeThrottle() {}
+
+            /**
+             * Returns the most documents to delete under one acquisition of the write lock.
+             */
+            virtual long long getBatchSize() = 0;
+
+            /**
+             * Called without any lock held after each batch of deletes, with the number and total
+             * size of the documents deleted. Can sleep to slow down the deletes.
+             */
+            virtual void batchDone(OperationContext* txn, long long docs, long long bytes) = 0;
+        };
+
     };
 
 } // namespace mongo
@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/and_hash.h"
 
+#include <algorithm>
+
 #include "mongo/db/exec/and_common-inl.h"
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/scoped_timer.h"
@@ -47,6 +49,69 @@ namespace mongo {
 
     using std::auto_ptr;
 
+    //
+    // RecordIdBloomFilter
+    //
+
+    // With a byte per RecordId, this many hashes lets about 2% of absent RecordIds through.
+    const int RecordIdBloomFilter::kNumHashes = 4;
+
+    namespace {
+
+        // A 64 bit mix (splitmix64's finalizer), since RecordIds are often sequential.
+        uint64_t mixRecordId(const RecordId& loc) {
+            uint64_t x = static_cast<uint64_t>(loc.repr());
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+            return x ^ (x >> 31);
+        }
+
+    }  // namespace
+
+    void RecordIdBloomFilter::reset(size_t numRecordIds) {
+        // A power of two number of 64 bit words, with at least 8 bits per RecordId.
+        size_t numWords = 1;
+        while (numWords * 8 < numRecordIds) {
+            numWords *= 2;
+        }
+        _bits.assign(numWords, 0);
+    }
+
+    void RecordIdBloomFilter::add(const RecordId& loc) {
+        if (_bits.empty()) {
+            return;
+        }
+        const uint64_t hash = mixRecordId(loc);
+        const uint64_t mask = _bits.size() * 64 - 1;
+        uint64_t h1 = hash;
+        const uint64_t h2 = (hash >> 32) | 1;
+        for (int i = 0; i < kNumHashes; ++i, h1 += h2) {
+            const uint64_t bit = h1 & mask;
+            _bits[bit >> 6] |= 1ULL << (bit & 63);
+        }
+    }
+
+    bool RecordIdBloomFilter::mayContain(const RecordId& loc) const {
+        if (_bits.empty()) {
+            return true;
+        }
+        const uint64_t hash = mixRecordId(loc);
+        const uint64_t mask = _bits.size() * 64 - 1;
+        uint64_t h1 = hash;
+        const uint64_t h2 = (hash >> 32) | 1;
+        for (int i = 0; i < kNumHashes; ++i, h1 += h2) {
+            const uint64_t bit = h1 & mask;
+            if (!(_bits[bit >> 6] & (1ULL << (bit & 63)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //
+    // AndHashStage
+    //
+
     const size_t AndHashStage::kLookAheadWorks = 10;
 
     // static
@@ -59,6 +124,10 @@ namespace mongo {
           _ws(ws),
           _filter(filter),
           _hashingChildren(true),
+          _onlyRecordIdsNeeded(false),
+          _compacted(false),
+          _numSortedCompactLocs(0),
+          _numCompactGone(0),
           _currentChild(0),
           _commonStats(kStageType),
           _memUsage(0),
@@ -72,6 +141,10 @@ namespace mongo {
           _ws(ws),
           _filter(filter),
           _hashingChildren(true),
+          _onlyRecordIdsNeeded(false),
+          _compacted(false),
+          _numSortedCompactLocs(0),
+          _numCompactGone(0),
           _currentChild(0),
           _commonStats(kStageType),
           _memUsage(0),
@@ -83,6 +156,11 @@ namespace mongo {
 
     void AndHashStage::addChild(PlanStage* child) { _children.push_back(child); }
 
+    void AndHashStage::setOnlyRecordIdsNeeded() {
+        // A filter could look at the keys of any child.
+        _onlyRecordIdsNeeded = (NULL == _filter);
+    }
+
     size_t AndHashStage::getMemUsage() const {
         return _memUsage;
     }
@@ -97,7 +175,7 @@ namespace mongo {
         // Or we're streaming in results from the last child.
 
         // If there's nothing to probe against, we're EOF.
-        if (_dataMap.empty()) { return true; }
+        if (0 == numBuffered()) { return true; }
 
         // Otherwise, we're done when the last child is done.
         invariant(_children.size() >= 2);
@@ -108,8 +186,8 @@ namespace mongo {
     PlanStage::StageState AndHashStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -178,7 +256,13 @@ namespace mongo {
 
         // We read the first child into our hash table.
         if (_hashingChildren) {
-            // Check memory usage of previously hashed results.
+            // Check memory usage of previously hashed results.  If nobody needs more than the
+            // RecordIds of the first child, we can drop the rest.
+            if (_memUsage > _maxMemUsage
+                && 0 == _currentChild && _onlyRecordIdsNeeded && !_compacted) {
+                compactDataMap();
+            }
+
             if (_memUsage > _maxMemUsage) {
                 mongoutils::str::stream ss;
                 ss << "hashed AND stage buffered data usage of " << _memUsage
@@ -206,7 +290,7 @@ namespace mongo {
         // hash map.
 
         // We should be EOF if we're not hashing results and the dataMap is empty.
-        verify(!_dataMap.empty());
+        verify(0 != numBuffered());
 
         // We probe _dataMap with the last child.
         verify(_currentChild == _children.size() - 1);
@@ -227,6 +311,30 @@ namespace mongo {
             return PlanStage::NEED_TIME;
         }
 
+        if (!_bloomFilter.mayContain(member->loc)) {
+            // Child's output certainly wasn't in every previous child.
+            ++_specificStats.bloomFilterRejects;
+            _ws->free(*out);
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
+        if (_compacted) {
+            size_t pos;
+            if (!findCompactLoc(member->loc, &pos)) {
+                _ws->free(*out);
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+
+            // We only have the RecordIds of the previous children, so the last child's output
+            // is all we return. There's no filter to apply.
+            _compactGone[pos] = true;
+            ++_numCompactGone;
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
         DataMap::iterator it = _dataMap.find(member->loc);
         if (_dataMap.end() == it) {
             // Child's output wasn't in every previous child.  Throw it out.
@@ -287,6 +395,15 @@ namespace mongo {
             }
 
             verify(member->hasLoc());
+
+            if (_compacted) {
+                _compactLocs.push_back(member->loc);
+                _ws->free(id);
+                _memUsage += sizeof(RecordId);
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+
             verify(_dataMap.end() == _dataMap.find(member->loc));
 
             _dataMap[member->loc] = id;
@@ -301,14 +418,36 @@ namespace mongo {
             // Done reading child 0.
             _currentChild = 1;
 
+            if (_compacted) {
+                sortCompactLocs();
+
+                // Drop what was invalidated, and start tracking which RecordIds are gone in
+                // _compactGone.
+                vector<RecordId> kept;
+                kept.reserve(_compactLocs.size() - _compactInvalidated.size());
+                for (size_t i = 0; i < _compactLocs.size(); ++i) {
+                    if (_compactInvalidated.end() == _compactInvalidated.find(_compactLocs[i])) {
+                        kept.push_back(_compactLocs[i]);
+                    }
+                }
+                _compactLocs.swap(kept);
+                _numSortedCompactLocs = _compactLocs.size();
+                _compactInvalidated.clear();
+                _compactSeen.assign(_compactLocs.size(), false);
+                _compactGone.assign(_compactLocs.size(), false);
+                _memUsage = _compactLocs.size() * sizeof(RecordId);
+            }
+
             // If our first child was empty, don't scan any others, no possible results.
-            if (_dataMap.empty()) {
+            if (0 == numBuffered()) {
                 _hashingChildren = false;
                 return PlanStage::IS_EOF;
             }
 
+            buildBloomFilter();
+
             ++_commonStats.needTime;
-            _specificStats.mapAfterChild.push_back(_dataMap.size());
+            _specificStats.mapAfterChild.push_back(numBuffered());
 
             return PlanStage::NEED_TIME;
         }
@@ -355,7 +494,17 @@ namespace mongo {
             }
 
             verify(member->hasLoc());
-            if (_dataMap.end() == _dataMap.find(member->loc)) {
+            if (!_bloomFilter.mayContain(member->loc)) {
+                // Ignore.  It's certainly not in every previous child.
+                ++_specificStats.bloomFilterRejects;
+            }
+            else if (_compacted) {
+                size_t pos;
+                if (findCompactLoc(member->loc, &pos)) {
+                    _compactSeen[pos] = true;
+                }
+            }
+            else if (_dataMap.end() == _dataMap.find(member->loc)) {
                 // Ignore.  It's not in any previous child.
             }
             else {
@@ -377,6 +526,10 @@ namespace mongo {
             // Finished with a child.
             ++_currentChild;
 
+            if (_compacted) {
+                keepSeenCompactLocs();
+            }
+
             // Keep elements of _dataMap that are in _seenMap.
             DataMap::iterator it = _dataMap.begin();
             while (it != _dataMap.end()) {
@@ -394,18 +547,21 @@ namespace mongo {
                 else { ++it; }
             }
 
-            _specificStats.mapAfterChild.push_back(_dataMap.size());
+            _specificStats.mapAfterChild.push_back(numBuffered());
 
             _seenMap.clear();
 
             // _dataMap is now the intersection of the first _currentChild nodes.
 
             // If we have nothing to AND with after finishing any child, stop.
-            if (_dataMap.empty()) {
+            if (0 == numBuffered()) {
                 _hashingChildren = false;
                 return PlanStage::IS_EOF;
             }
 
+            // The intersection shrank, so a new filter rules out more.
+            buildBloomFilter();
+
             // We've finished scanning all children.  Return results with the next call to work().
             if (_currentChild == _children.size()) {
                 _hashingChildren = false;
@@ -479,6 +635,38 @@ namespace mongo {
             }
         }
 
+        if (_compacted) {
+            // We don't have a member for the RecordId, only the document to flag.
+            sortCompactLocs();
+            size_t pos;
+            if (!findCompactLoc(dl, &pos)) {
+                return;
+            }
+
+            if (_hashingChildren) {
+                ++_specificStats.flaggedInProgress;
+            }
+            else {
+                ++_specificStats.flaggedButPassed;
+            }
+
+            if (0 == _currentChild) {
+                _compactInvalidated.insert(dl);
+            }
+            else {
+                _compactGone[pos] = true;
+                ++_numCompactGone;
+            }
+
+            WorkingSetID id = _ws->allocate();
+            WorkingSetMember* member = _ws->get(id);
+            member->loc = dl;
+            member->state = WorkingSetMember::LOC_AND_IDX;
+            WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+            _ws->flagForReview(id);
+            return;
+        }
+
         // If it's a deletion, we have to forget about the RecordId, and since the AND-ing is by
         // RecordId we can't continue processing it even with the object.
         //
@@ -512,6 +700,94 @@ namespace mongo {
         }
     }
 
+    void AndHashStage::compactDataMap() {
+        invariant(!_compacted);
+        invariant(0 == _currentChild);
+
+        _compactLocs.reserve(_dataMap.size());
+        for (DataMap::const_iterator it = _dataMap.begin(); it != _dataMap.end(); ++it) {
+            _compactLocs.push_back(it->first);
+            _ws->free(it->second);
+        }
+        _dataMap.clear();
+
+        _numSortedCompactLocs = 0;
+        _memUsage = _compactLocs.size() * sizeof(RecordId);
+        _compacted = true;
+    }
+
+    void AndHashStage::sortCompactLocs() {
+        if (_numSortedCompactLocs == _compactLocs.size()) {
+            return;
+        }
+
+        // Only RecordIds added since we last sorted are out of place.
+        const vector<RecordId>::iterator middle = _compactLocs.begin() + _numSortedCompactLocs;
+        std::sort(middle, _compactLocs.end());
+        std::inplace_merge(_compactLocs.begin(), middle, _compactLocs.end());
+        _compactLocs.erase(std::unique(_compactLocs.begin(), _compactLocs.end()),
+                           _compactLocs.end());
+        _numSortedCompactLocs = _compactLocs.size();
+    }
+
+    bool AndHashStage::findCompactLoc(const RecordId& loc, size_t* posOut) const {
+        dassert(_numSortedCompactLocs == _compactLocs.size());
+
+        const vector<RecordId>::const_iterator it =
+            std::lower_bound(_compactLocs.begin(), _compactLocs.end(), loc);
+        if (_compactLocs.end() == it || *it != loc) {
+            return false;
+        }
+
+        const size_t pos = it - _compactLocs.begin();
+        if (0 == _currentChild) {
+            if (_compactInvalidated.end() != _compactInvalidated.find(loc)) {
+                return false;
+            }
+        }
+        else if (_compactGone[pos]) {
+            return false;
+        }
+        *posOut = pos;
+        return true;
+    }
+
+    void AndHashStage::keepSeenCompactLocs() {
+        size_t numKept = 0;
+        for (size_t i = 0; i < _compactLocs.size(); ++i) {
+            if (_compactSeen[i] && !_compactGone[i]) {
+                _compactLocs[numKept++] = _compactLocs[i];
+            }
+        }
+        _compactLocs.resize(numKept);
+        _numSortedCompactLocs = numKept;
+        _compactSeen.assign(numKept, false);
+        _compactGone.assign(numKept, false);
+        _numCompactGone = 0;
+        _memUsage = numKept * sizeof(RecordId);
+    }
+
+    void AndHashStage::buildBloomFilter() {
+        _bloomFilter.reset(numBuffered());
+        if (_compacted) {
+            for (size_t i = 0; i < _compactLocs.size(); ++i) {
+                _bloomFilter.add(_compactLocs[i]);
+            }
+        }
+        else {
+            for (DataMap::const_iterator it = _dataMap.begin(); it != _dataMap.end(); ++it) {
+                _bloomFilter.add(it->first);
+            }
+        }
+    }
+
+    size_t AndHashStage::numBuffered() const {
+        if (_compacted) {
+            return _compactLocs.size() - _numCompactGone;
+        }
+        return _dataMap.size();
+    }
+
     vector<PlanStage*> AndHashStage::getChildren() const {
         return _children;
     }
@@ -521,6 +797,7 @@ namespace mongo {
 
         _specificStats.memLimit = _maxMemUsage;
         _specificStats.memUsage = _memUsage;
+        _specificStats.compacted = _compacted;
 
         // Add a BSON representation of the filter to the stats tree, if there is one.
         if (NULL != _filter) {
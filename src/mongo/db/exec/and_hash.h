@@ -39,6 +39,35 @@
 
 namespace mongo {
 
+    /**
+     * A Bloom filter over RecordIds, which answers "maybe" or "definitely not" for whether a
+     * RecordId was added, in about a byte per RecordId.
+     */
+    class RecordIdBloomFilter {
+    public:
+        RecordIdBloomFilter() { }
+
+        /**
+         * Forgets everything added, and sizes the filter for 'numRecordIds'.
+         */
+        void reset(size_t numRecordIds);
+
+        void add(const RecordId& loc);
+
+        /**
+         * Returns false only if 'loc' was never added. Always true if the filter is empty, i.e.
+         * before reset() is first called.
+         */
+        bool mayContain(const RecordId& loc) const;
+
+        size_t getMemUsage() const { return _bits.size() * sizeof(uint64_t); }
+
+    private:
+        static const int kNumHashes;
+
+        std::vector<uint64_t> _bits;
+    };
+
     /**
      * Reads from N children, each of which must have a valid RecordId.  Uses a hash table to
      * intersect the outputs of the N children, and outputs the intersection.
@@ -49,6 +78,10 @@ namespace mongo {
      * is fetched and added to the WorkingSet as "flagged for further review."  Because this stage
      * operates with RecordIds, we are unable to evaluate the AND for the invalidated RecordId, and it
      * must be fully matched later.
+     *
+     * If nothing above this stage looks at the index keys of the results of any child but the
+     * last, see setOnlyRecordIdsNeeded(), this stage keeps going when it buffers too much by
+     * discarding what it buffered but the RecordIds, which it keeps in a sorted array.
      */
     class AndHashStage : public PlanStage {
     public:
@@ -68,6 +101,13 @@ namespace mongo {
 
         void addChild(PlanStage* child);
 
+        /**
+         * Tells us that only the RecordIds of our results matter to the stages above us, e.g. a
+         * fetch, as long as we have no filter. Results are then returned with the data of the
+         * last child only, and buffering too much makes us compact rather than fail.
+         */
+        void setOnlyRecordIdsNeeded();
+
         /**
          * Returns memory usage.
          * For testing only.
@@ -100,6 +140,39 @@ namespace mongo {
         StageState hashOtherChildren(WorkingSetID* out);
         StageState workChild(size_t childNo, WorkingSetID* out);
 
+        /**
+         * Replaces _dataMap with _compactLocs, freeing the buffered members.
+         */
+        void compactDataMap();
+
+        /**
+         * Makes all of _compactLocs sorted and unique.
+         */
+        void sortCompactLocs();
+
+        /**
+         * Returns true and puts the position of 'loc' in _compactLocs in 'posOut' if it's there
+         * and not gone.
+         * _compactLocs must be sorted. Once we're done with the first child, the RecordIds which
+         * are gone are marked in _compactGone, before that they're in _compactInvalidated.
+         */
+        bool findCompactLoc(const RecordId& loc, size_t* posOut) const;
+
+        /**
+         * Keeps just the RecordIds of _compactLocs which are marked seen and not gone.
+         */
+        void keepSeenCompactLocs();
+
+        /**
+         * Adds what's in _dataMap or _compactLocs to _bloomFilter.
+         */
+        void buildBloomFilter();
+
+        /**
+         * How many RecordIds we're holding in _dataMap or _compactLocs.
+         */
+        size_t numBuffered() const;
+
         // Not owned by us.
         const Collection* _collection;
 
@@ -130,6 +203,33 @@ namespace mongo {
         // True if we're still intersecting _children[0..._children.size()-1].
         bool _hashingChildren;
 
+        // See setOnlyRecordIdsNeeded().
+        bool _onlyRecordIdsNeeded;
+
+        // Once true, _compactLocs holds what _dataMap would, without any data but the RecordIds,
+        // and _dataMap is empty.
+        bool _compacted;
+
+        // The RecordIds we're intersecting if _compacted. Only the first _numSortedCompactLocs
+        // are sorted while we're reading the first child. The others get sorted when we're done,
+        // or when we need to look one up.
+        std::vector<RecordId> _compactLocs;
+        size_t _numSortedCompactLocs;
+
+        // Which of _compactLocs the current child produced, and which we're done with because
+        // they were returned or invalidated.
+        std::vector<bool> _compactSeen;
+        std::vector<bool> _compactGone;
+        size_t _numCompactGone;
+
+        // The RecordIds invalidated while we're reading the first child, if _compacted. They're
+        // dropped from _compactLocs when we're done with it.
+        SeenMap _compactInvalidated;
+
+        // Built from what the first child produced, so the other children can skip looking up
+        // most of the RecordIds which aren't in the intersection.
+        RecordIdBloomFilter _bloomFilter;
+
         // Which child are we currently working on?
         size_t _currentChild;
 
@@ -138,7 +238,7 @@ namespace mongo {
         AndHashStats _specificStats;
 
         // The usage in bytes of all buffered data that we're holding.
-        // Memory usage is calculated from keys held in _dataMap only.
+        // Memory usage is calculated from keys held in _dataMap or _compactLocs only.
         // For simplicity, results in _lookAheadResults do not count towards the limit.
         size_t _memUsage;
 
@@ -62,8 +62,8 @@ namespace mongo {
     PlanStage::StageState AndSortedStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -26,9 +26,23 @@
  *    it in the license file.
  */
 
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
 #include "mongo/db/exec/cached_plan.h"
+
+#include <algorithm>
+
+#include "mongo/base/counter.h"
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/exec/multi_plan.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/explain.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/query/query_planner.h"
+#include "mongo/db/query/stage_builder.h"
+#include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 
 // for updateCache
@@ -41,17 +55,30 @@
 
 namespace mongo {
 
+    // How many cached plans did so badly in their trial that we replanned?
+    static Counter64 replannedCounter;
+    static ServerStatusMetricField<Counter64> displayReplanned("queryExecutor.replanned",
+                                                               &replannedCounter);
+
     // static
     const char* CachedPlanStage::kStageType = "CACHED_PLAN";
 
-    CachedPlanStage::CachedPlanStage(const Collection* collection,
+    CachedPlanStage::CachedPlanStage(OperationContext* txn,
+                                     const Collection* collection,
+                                     WorkingSet* ws,
                                      CanonicalQuery* cq,
+                                     const QueryPlannerParams& params,
+                                     size_t decisionWorks,
                                      PlanStage* mainChild,
                                      QuerySolution* mainQs,
                                      PlanStage* backupChild,
                                      QuerySolution* backupQs)
-        : _collection(collection),
+        : _txn(txn),
+          _collection(collection),
+          _ws(ws),
           _canonicalQuery(cq),
+          _plannerParams(params),
+          _decisionWorks(decisionWorks),
           _mainQs(mainQs),
           _backupQs(backupQs),
           _mainChildPlan(mainChild),
@@ -69,16 +96,178 @@ namespace mongo {
         }
     }
 
-    bool CachedPlanStage::isEOF() { return getActiveChild()->isEOF(); }
+    Status CachedPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
+        // Adds the amount of time taken by pickBestPlan() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
+
+        if (0 == _decisionWorks || internalQueryCacheEvictionRatio <= 0) {
+            return Status::OK();
+        }
+
+        // Stop once we have as many results as plan ranking would have gathered.
+        size_t numResults = (size_t)internalQueryPlanEvaluationMaxResults;
+        size_t numToReturn = _canonicalQuery->getParsed().getNumToReturn();
+        if (numToReturn > 0) {
+            numResults = std::min(numToReturn, numResults);
+        }
+
+        const size_t maxWorks = static_cast<size_t>(internalQueryCacheEvictionRatio *
+                                                    _decisionWorks);
+
+        for (size_t works = 0; works < maxWorks; ++works) {
+            Status yieldStatus = tryYield(yieldPolicy);
+            if (!yieldStatus.isOK()) {
+                return yieldStatus;
+            }
+
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            StageState state = getActiveChild()->work(&id);
+
+            if (PlanStage::ADVANCED == state) {
+                _alreadyProduced = true;
+                _results.push_back(id);
+                if (_results.size() >= numResults) {
+                    return Status::OK();
+                }
+            }
+            else if (PlanStage::IS_EOF == state) {
+                return Status::OK();
+            }
+            else if (PlanStage::NEED_FETCH == state) {
+                // Transfer ownership of the fetcher and yield on the next pass.
+                WorkingSetMember* member = _ws->get(id);
+                invariant(member->hasFetcher());
+                _fetcher.reset(member->releaseFetcher());
+            }
+            else if (PlanStage::FAILURE == state
+                     && !_alreadyProduced
+                     && !_usingBackupChild
+                     && NULL != _backupChildPlan.get()) {
+                // Give the backup plan the rest of the trial, as work() would.
+                _usingBackupChild = true;
+            }
+            else if (PlanStage::FAILURE == state) {
+                // Nothing has been returned yet, so we can still try the other plans.
+                LOG(1) << "Cached plan failed, replanning: " << _canonicalQuery->toStringShort();
+                return replan(yieldPolicy);
+            }
+            else if (PlanStage::DEAD == state) {
+                return Status(ErrorCodes::OperationFailed,
+                              "PlanExecutor killed during cached plan trial");
+            }
+        }
+
+        LOG(1) << "Evicting cached plan and replanning, for it took over "
+               << internalQueryCacheEvictionRatio << " times the " << _decisionWorks
+               << " works it took when it was picked: " << _canonicalQuery->toStringShort()
+               << ", planSummary: " << Explain::getPlanSummary(getActiveChild());
+
+        return replan(yieldPolicy);
+    }
+
+    Status CachedPlanStage::tryYield(PlanYieldPolicy* yieldPolicy) {
+        // Yield if the yield policy's timer elapsed, or if the plan requested a fetch.
+        if (NULL != yieldPolicy && (yieldPolicy->shouldYield() || NULL != _fetcher.get())) {
+            if (!yieldPolicy->yield(_fetcher.get())) {
+                return Status(ErrorCodes::OperationFailed,
+                              "PlanExecutor killed during cached plan trial");
+            }
+        }
+
+        // We don't want to use the same RecordFetcher twice.
+        _fetcher.reset();
+
+        return Status::OK();
+    }
+
+    Status CachedPlanStage::replan(PlanYieldPolicy* yieldPolicy) {
+        replannedCounter.increment();
+        _specificStats.replanned = true;
+
+        // The entry is gone, so there's nothing to give feedback on.
+        _updatedCache = true;
+        _collection->infoCache()->getPlanCache()->remove(*_canonicalQuery);
+
+        // Throw away the cached plans and what they produced. We start with a fresh working set.
+        _results.clear();
+        _fetcher.reset();
+        _mainChildPlan.reset();
+        _backupChildPlan.reset();
+        _mainQs.reset();
+        _backupQs.reset();
+        _usingBackupChild = false;
+        _alreadyProduced = false;
+        _ws->clear();
+
+        vector<QuerySolution*> rawSolutions;
+        Status status = QueryPlanner::planWithCandidateCache(
+            *_canonicalQuery, _plannerParams, _collection->infoCache()->getPlanCache(),
+            &rawSolutions);
+        if (!status.isOK()) {
+            return Status(ErrorCodes::BadValue,
+                          "error processing query: " + _canonicalQuery->toString() +
+                          " planner returned error: " + status.reason());
+        }
+
+        OwnedPointerVector<QuerySolution> solutions(rawSolutions);
+
+        if (0 == solutions.size()) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream()
+                          << "error processing query: "
+                          << _canonicalQuery->toString()
+                          << " No query solutions");
+        }
+
+        if (1 == solutions.size()) {
+            // Only one possible plan. Run it.
+            PlanStage* root;
+            verify(StageBuilder::build(_txn, _collection, *solutions[0], _ws, &root));
+            _replannedQs.reset(solutions.popAndReleaseBack());
+            _replannedPlan.reset(root);
+            return Status::OK();
+        }
+
+        // Many solutions. Have a MultiPlanStage pick the best and put it in the cache. The
+        // working set is shared by all candidate plans.
+        MultiPlanStage* multiPlanStage = new MultiPlanStage(_txn, _collection, _canonicalQuery);
+        _replannedPlan.reset(multiPlanStage);
+
+        for (size_t ix = 0; ix < solutions.size(); ++ix) {
+            if (solutions[ix]->cacheData.get()) {
+                solutions[ix]->cacheData->indexFilterApplied = _plannerParams.indexFiltersApplied;
+            }
+
+            PlanStage* nextPlanRoot;
+            verify(StageBuilder::build(_txn, _collection, *solutions[ix], _ws, &nextPlanRoot));
+
+            // Takes ownership of 'solutions[ix]' and 'nextPlanRoot'.
+            multiPlanStage->addPlan(solutions.releaseAt(ix), nextPlanRoot, _ws);
+        }
+
+        return multiPlanStage->pickBestPlan(yieldPolicy);
+    }
+
+    bool CachedPlanStage::isEOF() {
+        return _results.empty() && getActiveChild()->isEOF();
+    }
 
     PlanStage::StageState CachedPlanStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
+        // Return the results of the trial first.
+        if (!_results.empty()) {
+            *out = _results.front();
+            _results.pop_front();
+            _commonStats.advanced++;
+            return PlanStage::ADVANCED;
+        }
+
         StageState childStatus = getActiveChild()->work(out);
 
         if (PlanStage::ADVANCED == childStatus) {
@@ -110,19 +299,34 @@ namespace mongo {
     }
 
     void CachedPlanStage::saveState() {
-        _mainChildPlan->saveState();
+        _txn = NULL;
+
+        if (NULL != _replannedPlan.get()) {
+            _replannedPlan->saveState();
+        }
+        else {
+            _mainChildPlan->saveState();
 
-        if (NULL != _backupChildPlan.get()) {
-            _backupChildPlan->saveState();
+            if (NULL != _backupChildPlan.get()) {
+                _backupChildPlan->saveState();
+            }
         }
         ++_commonStats.yields;
     }
 
     void CachedPlanStage::restoreState(OperationContext* opCtx) {
-        _mainChildPlan->restoreState(opCtx);
+        invariant(_txn == NULL);
+        _txn = opCtx;
+
+        if (NULL != _replannedPlan.get()) {
+            _replannedPlan->restoreState(opCtx);
+        }
+        else {
+            _mainChildPlan->restoreState(opCtx);
 
-        if (NULL != _backupChildPlan.get()) {
-            _backupChildPlan->restoreState(opCtx);
+            if (NULL != _backupChildPlan.get()) {
+                _backupChildPlan->restoreState(opCtx);
+            }
         }
         ++_commonStats.unyields;
     }
@@ -130,23 +334,32 @@ namespace mongo {
     void CachedPlanStage::invalidate(OperationContext* txn,
                                      const RecordId& dl,
                                      InvalidationType type) {
-        if (! _usingBackupChild) {
-            _mainChildPlan->invalidate(txn, dl, type);
+        if (NULL != _replannedPlan.get()) {
+            _replannedPlan->invalidate(txn, dl, type);
+        }
+        else {
+            if (! _usingBackupChild) {
+                _mainChildPlan->invalidate(txn, dl, type);
+            }
+            if (NULL != _backupChildPlan.get()) {
+                _backupChildPlan->invalidate(txn, dl, type);
+            }
         }
-        if (NULL != _backupChildPlan.get()) {
-            _backupChildPlan->invalidate(txn, dl, type);
+
+        // The results of the trial are no longer protected by the plan that produced them.
+        for (std::list<WorkingSetID>::iterator it = _results.begin(); it != _results.end();
+             ++it) {
+            WorkingSetMember* member = _ws->get(*it);
+            if (member->hasLoc() && member->loc == dl) {
+                WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+            }
         }
         ++_commonStats.invalidates;
     }
 
     vector<PlanStage*> CachedPlanStage::getChildren() const {
         vector<PlanStage*> children;
-        if (_usingBackupChild) {
-            children.push_back(_backupChildPlan.get());
-        }
-        else {
-            children.push_back(_mainChildPlan.get());
-        }
+        children.push_back(getActiveChild());
         return children;
     }
 
@@ -156,12 +369,7 @@ namespace mongo {
         auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_CACHED_PLAN));
         ret->specific.reset(new CachedPlanStats(_specificStats));
 
-        if (_usingBackupChild) {
-            ret->children.push_back(_backupChildPlan->getStats());
-        }
-        else {
-            ret->children.push_back(_mainChildPlan->getStats());
-        }
+        ret->children.push_back(getActiveChild()->getStats());
 
         return ret.release();
     }
@@ -195,6 +403,9 @@ namespace mongo {
     }
 
     PlanStage* CachedPlanStage::getActiveChild() const {
+        if (NULL != _replannedPlan.get()) {
+            return _replannedPlan.get();
+        }
         return _usingBackupChild ? _backupChildPlan.get() : _mainChildPlan.get();
     }
 
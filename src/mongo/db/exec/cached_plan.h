@@ -28,12 +28,18 @@
 
 #pragma once
 
+#include <boost/scoped_ptr.hpp>
+#include <list>
+
 #include "mongo/db/jsobj.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_planner_params.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/storage/record_fetcher.h"
 
 namespace mongo {
 
@@ -41,6 +47,10 @@ namespace mongo {
      * This stage outputs its mainChild, and possibly its backup child
      * and also updates the cache.
      *
+     * Before returning anything, pickBestPlan() gives the cached plan a trial. If the plan takes
+     * many more works than it did when it was picked for the cache, the cache entry is evicted and
+     * the query is planned again from scratch.
+     *
      * Preconditions: Valid RecordId.
      *
      */
@@ -48,9 +58,17 @@ namespace mongo {
     public:
         /**
          * Takes ownership of 'mainChild', 'mainQs', 'backupChild', and 'backupQs'.
+         *
+         * 'decisionWorks' is how many works the cached plan took when it was picked, or zero if
+         * that isn't known, in which case the plan gets no trial. 'ws' and 'params' are used to
+         * replan.
          */
-        CachedPlanStage(const Collection* collection,
+        CachedPlanStage(OperationContext* txn,
+                        const Collection* collection,
+                        WorkingSet* ws,
                         CanonicalQuery* cq,
+                        const QueryPlannerParams& params,
+                        size_t decisionWorks,
                         PlanStage* mainChild,
                         QuerySolution* mainQs,
                         PlanStage* backupChild = NULL,
@@ -76,18 +94,53 @@ namespace mongo {
 
         virtual const SpecificStats* getSpecificStats();
 
+        /**
+         * Works the cached plan until it has produced as many results as plan ranking would
+         * have, or hit EOF. If it takes over 'internalQueryCacheEvictionRatio' times the works
+         * it took when it was picked, evicts it from the plan cache and replans.
+         *
+         * The results of the trial are buffered and returned by work(). If 'yieldPolicy' is
+         * non-NULL, locks may be yielded during the trial and during replanning.
+         *
+         * Returns a non-OK status if the plan was killed during a yield or replanning failed.
+         */
+        Status pickBestPlan(PlanYieldPolicy* yieldPolicy);
+
         static const char* kStageType;
 
     private:
         PlanStage* getActiveChild() const;
         void updateCache();
 
+        /**
+         * Yields if 'yieldPolicy' says so or a fetch was requested. Returns a non-OK status if
+         * the plan was killed while yielding.
+         */
+        Status tryYield(PlanYieldPolicy* yieldPolicy);
+
+        /**
+         * Evicts the cached plan, plans the query from scratch and switches to the new plan.
+         */
+        Status replan(PlanYieldPolicy* yieldPolicy);
+
+        // Not owned. NULL while the stage is saved.
+        OperationContext* _txn;
+
         // not owned
         const Collection* _collection;
 
+        // not owned
+        WorkingSet* _ws;
+
         // not owned
         CanonicalQuery* _canonicalQuery;
 
+        // Used to replan.
+        QueryPlannerParams _plannerParams;
+
+        // Works the cached plan took when it was picked.
+        size_t _decisionWorks;
+
         // Owned by us. Must be deleted after the corresponding PlanStage trees, as
         // those trees point into the query solutions.
         boost::scoped_ptr<QuerySolution> _mainQs;
@@ -98,6 +151,19 @@ namespace mongo {
         boost::scoped_ptr<PlanStage> _mainChildPlan;
         boost::scoped_ptr<PlanStage> _backupChildPlan;
 
+        // The plan picked by replanning, and its solution if there was only one candidate.
+        // Takes over from the children above, which are deleted. A MultiPlanStage owns its own
+        // solutions.
+        boost::scoped_ptr<QuerySolution> _replannedQs;
+        boost::scoped_ptr<PlanStage> _replannedPlan;
+
+        // Results of the trial run by pickBestPlan(), to be returned before working the active
+        // child again.
+        std::list<WorkingSetID> _results;
+
+        // A fetch requested by the active child during the trial, for tryYield().
+        boost::scoped_ptr<RecordFetcher> _fetcher;
+
         // True if the main plan errors before producing results
         // and if a backup plan is available (can happen with blocking sorts)
         bool _usingBackupChild;
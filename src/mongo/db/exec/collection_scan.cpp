@@ -36,6 +36,7 @@
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
@@ -61,6 +62,10 @@ namespace mongo {
         // Explain reports the direction of the collection scan.
         _specificStats.direction = params.direction;
 
+        if (NULL != _filter && internalQueryExecCompileFilters) {
+            _compiledFilter.reset(new CompiledMatchExpression(_filter));
+        }
+
         // We pre-allocate a WSM and use it to pass up fetch requests. This should never be used
         // for anything other than passing up NEED_FETCH. We use the loc and owned obj state, but
         // the loc isn't really pointing at any obj. The obj field of the WSM should never be used.
@@ -69,10 +74,23 @@ namespace mongo {
     }
 
     PlanStage::StageState CollectionScan::work(WorkingSetID* out) {
-        ++_commonStats.works;
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
+
+        return doWork(out);
+    }
+
+    PlanStage::StageState CollectionScan::workBatch(size_t maxWorks,
+                                        std::vector<WorkingSetID>* out,
+                                        WorkingSetID* id) {
+        // Time the batch as a whole rather than each unit of work in it.
+        ScopedTimer timer(&_commonStats);
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        return workBatchOf(this, &CollectionScan::doWork, maxWorks, out, id);
+    }
+
+    PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
+        ++_commonStats.works;
 
         if (_isDead) { return PlanStage::DEAD; }
 
@@ -143,7 +161,9 @@ namespace mongo {
         WorkingSetID id = _workingSet->allocate();
         WorkingSetMember* member = _workingSet->get(id);
         member->loc = curr;
-        member->obj = _iter->dataFor(member->loc).releaseToBson();
+        RecordData rd = _iter->dataFor(member->loc);
+        _params.collection->noteAccessed(member->loc, rd.size());
+        member->obj = rd.releaseToBson();
         member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
 
         // Advance the iterator.
@@ -157,7 +177,7 @@ namespace mongo {
                                                           WorkingSetID* out) {
         ++_specificStats.docsTested;
 
-        if (Filter::passes(member, _filter)) {
+        if (Filter::passes(member, _filter, _compiledFilter.get())) {
             *out = memberID;
             ++_commonStats.advanced;
             return PlanStage::ADVANCED;
@@ -204,6 +224,15 @@ namespace mongo {
         }
     }
 
+    void CollectionScan::resumeAfter(const RecordId& loc) {
+        invariant(_params.tailable);
+        invariant(!loc.isNull());
+
+        // Reopened at 'loc' on the next call to work(), as after EOF.
+        _iter.reset();
+        _lastSeenLoc = loc;
+    }
+
     void CollectionScan::saveState() {
         _txn = NULL;
         ++_commonStats.yields;
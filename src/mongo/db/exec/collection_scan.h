@@ -33,6 +33,7 @@
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_compiled.h"
 #include "mongo/db/record_id.h"
 
 namespace mongo {
@@ -55,6 +56,9 @@ namespace mongo {
                        const MatchExpression* filter);
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* out,
+                                     WorkingSetID* id);
         virtual bool isEOF();
 
         virtual void invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type);
@@ -65,6 +69,20 @@ namespace mongo {
 
         virtual StageType stageType() const { return STAGE_COLLSCAN; }
 
+        const MatchExpression* getFilter() const { return _filter; }
+
+        /**
+         * The last record looked at, which a tailable scan continues after once it runs dry.
+         */
+        const RecordId& getLastSeenLoc() const { return _lastSeenLoc; }
+
+        /**
+         * Makes a tailable scan continue after 'loc', a later record than the last one it looked
+         * at, as though it had looked at every record up to it. For readers that got the results
+         * for those records some other way.
+         */
+        void resumeAfter(const RecordId& loc);
+
         virtual PlanStageStats* getStats();
 
         virtual const CommonStats* getCommonStats();
@@ -74,6 +92,11 @@ namespace mongo {
         static const char* kStageType;
 
     private:
+        /**
+         * Does one unit of work, without timing it. Shared by work() and workBatch().
+         */
+        StageState doWork(WorkingSetID* out);
+
         /**
          * If the member (with id memberID) passes our filter, set *out to memberID and return that
          * ADVANCED.  Otherwise, free memberID and return NEED_TIME.
@@ -91,6 +114,9 @@ namespace mongo {
         // The filter is not owned by us.
         const MatchExpression* _filter;
 
+        // The compiled form of '_filter', if there is one and compiling filters is enabled.
+        boost::scoped_ptr<CompiledMatchExpression> _compiledFilter;
+
         boost::scoped_ptr<RecordIterator> _iter;
 
         CollectionScanParams _params;
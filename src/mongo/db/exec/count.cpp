@@ -31,6 +31,7 @@
 #include "mongo/db/exec/count.h"
 
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/exec/count_scan.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 
@@ -55,7 +56,7 @@ namespace mongo {
     CountStage::~CountStage() { }
 
     bool CountStage::isEOF() {
-        if (_specificStats.trivialCount) {
+        if (_specificStats.trivialCount || _specificStats.estimated) {
             return true;
         }
 
@@ -68,8 +69,27 @@ namespace mongo {
 
     void CountStage::trivialCount() {
         invariant(_collection);
-        long long nCounted = _collection->numRecords(_txn);
+        setCountWithSkipLimit(_collection->numRecords(_txn));
+        _specificStats.trivialCount = true;
+    }
+
+    bool CountStage::estimatedCount() {
+        if (!_request.approximate || NULL == _child.get()
+            || STAGE_COUNT_SCAN != _child->stageType()) {
+            return false;
+        }
 
+        long long estimate;
+        if (!static_cast<CountScan*>(_child.get())->estimateCount(&estimate)) {
+            return false;
+        }
+
+        setCountWithSkipLimit(estimate);
+        _specificStats.estimated = true;
+        return true;
+    }
+
+    void CountStage::setCountWithSkipLimit(long long nCounted) {
         if (0 != _request.skip) {
             nCounted -= _request.skip;
             if (nCounted < 0) {
@@ -88,14 +108,13 @@ namespace mongo {
 
         _specificStats.nCounted = nCounted;
         _specificStats.nSkipped = _request.skip;
-        _specificStats.trivialCount = true;
     }
 
     PlanStage::StageState CountStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         // This stage never returns a working set member.
         *out = WorkingSet::INVALID_ID;
@@ -107,6 +126,13 @@ namespace mongo {
             return PlanStage::IS_EOF;
         }
 
+        // On the first call, see whether an approximate count can be answered by the storage
+        // engine without scanning the index range.
+        if (1 == _commonStats.works && estimatedCount()) {
+            _commonStats.isEOF = true;
+            return PlanStage::IS_EOF;
+        }
+
         if (isEOF()) {
             _commonStats.isEOF = true;
             return PlanStage::IS_EOF;
@@ -62,6 +62,9 @@ namespace mongo {
 
         // Whether this is an explain of a count.
         bool explain;
+
+        // Whether an estimate from the storage engine is acceptable in place of an exact count.
+        bool approximate;
     };
 
     /**
@@ -111,6 +114,18 @@ namespace mongo {
          */
         void trivialCount();
 
+        /**
+         * If the child is a single index range scan whose size the storage engine can estimate,
+         * stores the estimate (with skip and limit applied) in '_specificStats' and returns true.
+         */
+        bool estimatedCount();
+
+        /**
+         * Applies the skip and limit of the request to 'nCounted' and stores the result in
+         * '_specificStats'.
+         */
+        void setCountWithSkipLimit(long long nCounted);
+
         // Transactional context for read locks. Not owned by us.
         OperationContext* _txn;
 
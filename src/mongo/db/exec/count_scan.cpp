@@ -105,8 +105,8 @@ namespace mongo {
     PlanStage::StageState CountScan::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         if (NULL == _btreeCursor.get()) {
             // First call to work().  Perform cursor init.
@@ -139,6 +139,19 @@ namespace mongo {
         return PlanStage::ADVANCED;
     }
 
+    bool CountScan::estimateCount(long long* estimateOut) const {
+        if (_shouldDedup) {
+            return false;
+        }
+
+        return _iam->estimateRangeCount(_txn,
+                                        _params.startKey,
+                                        _params.startKeyInclusive,
+                                        _params.endKey,
+                                        _params.endKeyInclusive,
+                                        estimateOut);
+    }
+
     bool CountScan::isEOF() {
         if (NULL == _btreeCursor.get()) {
             // Have to call work() at least once.
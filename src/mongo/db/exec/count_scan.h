@@ -87,6 +87,13 @@ namespace mongo {
 
         virtual const SpecificStats* getSpecificStats();
 
+        /**
+         * Asks the index for an estimate of how many entries lie between the start and end keys,
+         * without scanning them. Returns false if the index can't estimate, or if it is multikey
+         * and so an entry count would overstate the number of documents.
+         */
+        bool estimateCount(long long* estimateOut) const;
+
         static const char* kStageType;
 
     private:
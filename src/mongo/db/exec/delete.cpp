@@ -32,15 +32,22 @@
 
 #include "mongo/db/exec/delete.h"
 
+#include <algorithm>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
 
+    // Largest number of documents a multi delete removes together, so that each index gets the
+    // keys of all of them removed at once and in key order. 1 turns this off.
+    MONGO_EXPORT_SERVER_PARAMETER(deleteBatchSize, int, 64);
+
     // static
     const char* DeleteStage::kStageType = "DELETE";
 
@@ -54,7 +61,13 @@ namespace mongo {
           _ws(ws),
           _collection(collection),
           _child(child),
-          _commonStats(kStageType) { }
+          _commonStats(kStageType),
+          _deleteBatchSize(1) {
+        if (params.isMulti && !params.isExplain && !params.returnDeleted &&
+            deleteBatchSize > 1) {
+            _deleteBatchSize = deleteBatchSize;
+        }
+    }
 
     DeleteStage::~DeleteStage() {}
 
@@ -65,89 +78,162 @@ namespace mongo {
         if (!_params.isMulti && _specificStats.docsDeleted > 0) {
             return true;
         }
+        if (_params.limit > 0 &&
+            static_cast<long long>(_specificStats.docsDeleted) >= _params.limit) {
+            return true;
+        }
         return _child->isEOF();
     }
 
-    PlanStage::StageState DeleteStage::work(WorkingSetID* out) {
-        ++_commonStats.works;
+    PlanStage::StageState DeleteStage::bufferMember(WorkingSetID id, WorkingSetID* out) {
+        WorkingSetMember* member = _ws->get(id);
+        if (!member->hasLoc()) {
+            _ws->free(id);
+            const std::string errmsg = "delete stage failed to read member w/ loc from child";
+            *out = WorkingSetCommon::allocateStatusMember(_ws, Status(ErrorCodes::InternalError,
+                                                                      errmsg));
+            return PlanStage::FAILURE;
+        }
+        RecordId rloc = member->loc;
+
+        // If the working set member is in the owned obj with loc state, then the document may
+        // have already been deleted after-being force-fetched.
+        BSONObj deletedDoc;
+        if (WorkingSetMember::LOC_AND_OWNED_OBJ == member->state) {
+            if (!_collection->findDoc(_txn, rloc, &deletedDoc)) {
+                // Doc is already deleted. Nothing more to do.
+                return PlanStage::NEED_TIME;
+            }
+        }
+        else if (member->hasObj()) {
+            deletedDoc = member->obj;
+        }
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        if (_params.returnDeleted) {
+            if (deletedDoc.isEmpty()) {
+                deletedDoc = _collection->docFor(_txn, rloc);
+            }
+            _deletedDoc = deletedDoc.getOwned();
+        }
 
-        if (isEOF()) { return PlanStage::IS_EOF; }
-        invariant(_collection); // If isEOF() returns false, we must have a collection.
+        _ws->free(id);
 
-        WorkingSetID id = WorkingSet::INVALID_ID;
-        StageState status = _child->work(&id);
+        if (std::find(_pendingDeletes.begin(), _pendingDeletes.end(), rloc) ==
+            _pendingDeletes.end()) {
+            _pendingDeletes.push_back(rloc);
+        }
+        return PlanStage::NEED_TIME;
+    }
 
-        if (PlanStage::ADVANCED == status) {
-            WorkingSetMember* member = _ws->get(id);
-            if (!member->hasLoc()) {
-                _ws->free(id);
-                const std::string errmsg = "delete stage failed to read member w/ loc from child";
-                *out = WorkingSetCommon::allocateStatusMember(_ws, Status(ErrorCodes::InternalError,
-                                                                          errmsg));
-                return PlanStage::FAILURE;
-            }
-            RecordId rloc = member->loc;
-
-            // If the working set member is in the owned obj with loc state, then the document may
-            // have already been deleted after-being force-fetched.
-            if (WorkingSetMember::LOC_AND_OWNED_OBJ == member->state) {
-                BSONObj deletedDoc;
-                if (!_collection->findDoc(_txn, rloc, &deletedDoc)) {
-                    // Doc is already deleted. Nothing more to do.
-                    ++_commonStats.needTime;
-                    return PlanStage::NEED_TIME;
+    void DeleteStage::flushPendingDeletes() {
+        if (_pendingDeletes.empty()) {
+            return;
+        }
+
+        _child->saveState();
+
+        {
+            WriteUnitOfWork wunit(_txn);
+
+            const bool deleteCappedOK = false;
+            const bool deleteNoWarn = false;
+
+            // Do the write, unless this is an explain.
+            if (!_params.isExplain) {
+                std::vector<BSONObj> deletedIds;
+                _collection->deleteDocuments(_txn, _pendingDeletes, deleteCappedOK, deleteNoWarn,
+                                             _params.shouldCallLogOp ? &deletedIds : NULL);
+
+                if (_params.shouldCallLogOp) {
+                    for (std::vector<BSONObj>::const_iterator it = deletedIds.begin();
+                         it != deletedIds.end(); ++it) {
+                        if (it->isEmpty()) {
+                            log() << "Deleted object without id in collection "
+                                  << _collection->ns() << ", not logging.";
+                            continue;
+                        }
+                        bool replJustOne = true;
+                        repl::logOp(_txn, "d", _collection->ns().ns().c_str(), *it, 0,
+                                    &replJustOne, _params.fromMigrate);
+                    }
                 }
             }
 
-            _ws->free(id);
+            wunit.commit();
+        }
+
+        //  As restoreState may restore (recreate) cursors, cursors are tied to the
+        //  transaction in which they are created, and a WriteUnitOfWork is a
+        //  transaction, make sure to restore the state outside of the WritUnitOfWork.
+        _child->restoreState(_txn);
 
-            BSONObj deletedDoc;
+        _specificStats.docsDeleted += _pendingDeletes.size();
+        _pendingDeletes.clear();
+    }
 
-            // TODO: Do we want to buffer docs and delete them in a group rather than
-            // saving/restoring state repeatedly?
-            _child->saveState();
+    PlanStage::StageState DeleteStage::returnDeletedDoc(WorkingSetID* out) {
+        WorkingSetID id = _ws->allocate();
+        WorkingSetMember* member = _ws->get(id);
+        member->obj = _deletedDoc;
+        member->state = WorkingSetMember::OWNED_OBJ;
+        _deletedDoc = BSONObj();
 
-            {
-                WriteUnitOfWork wunit(_txn);
+        *out = id;
+        ++_commonStats.advanced;
+        return PlanStage::ADVANCED;
+    }
 
-                const bool deleteCappedOK = false;
-                const bool deleteNoWarn = false;
+    PlanStage::StageState DeleteStage::work(WorkingSetID* out) {
+        ++_commonStats.works;
 
-                // Do the write, unless this is an explain.
-                if (!_params.isExplain) {
-                    _collection->deleteDocument(_txn, rloc, deleteCappedOK, deleteNoWarn,
-                                                _params.shouldCallLogOp ? &deletedDoc : NULL);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
-                    if (_params.shouldCallLogOp) {
-                        if (deletedDoc.isEmpty()) {
-                            log() << "Deleted object without id in collection " << _collection->ns()
-                            << ", not logging.";
-                        }
-                        else {
-                            bool replJustOne = true;
-                            repl::logOp(_txn, "d", _collection->ns().ns().c_str(), deletedDoc, 0,
-                                        &replJustOne, _params.fromMigrate);
-                        }
-                    }
+        if (isEOF()) { return PlanStage::IS_EOF; }
+        invariant(_collection); // If isEOF() returns false, we must have a collection.
+
+        // Most documents to buffer: the batch size, within the limit of a limited delete.
+        size_t maxPending = _deleteBatchSize;
+        if (_params.limit > 0) {
+            const long long remaining =
+                _params.limit - static_cast<long long>(_specificStats.docsDeleted);
+            maxPending = std::min(maxPending, static_cast<size_t>(remaining));
+        }
+
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState status = _child->work(&id);
+
+        // A yield may happen between calls to work(), so buffered deletes never outlive one:
+        // keep taking documents from the child until the batch is full or the child returns
+        // something else.
+        for (size_t childWorks = 1; ; ++childWorks) {
+            if (PlanStage::ADVANCED == status) {
+                if (PlanStage::FAILURE == bufferMember(id, out)) {
+                    flushPendingDeletes();
+                    return PlanStage::FAILURE;
                 }
+                status = PlanStage::NEED_TIME;
+            }
+            else if (PlanStage::NEED_TIME != status) {
+                break;
+            }
 
-                wunit.commit();
+            if (_pendingDeletes.size() >= maxPending || childWorks >= 4 * _deleteBatchSize) {
+                break;
             }
 
-            //  As restoreState may restore (recreate) cursors, cursors are tied to the
-            //  transaction in which they are created, and a WriteUnitOfWork is a
-            //  transaction, make sure to restore the state outside of the WritUnitOfWork.
-            _child->restoreState(_txn);
+            id = WorkingSet::INVALID_ID;
+            status = _child->work(&id);
+        }
 
-            ++_specificStats.docsDeleted;
+        flushPendingDeletes();
 
-            ++_commonStats.needTime;
-            return PlanStage::NEED_TIME;
+        if (_params.returnDeleted && !_deletedDoc.isEmpty()) {
+            // Only a single delete returns documents, so this is the one just deleted.
+            return returnDeletedDoc(out);
         }
-        else if (PlanStage::FAILURE == status) {
+
+        if (PlanStage::FAILURE == status) {
             *out = id;
             // If a stage fails, it may create a status WSM to indicate why it failed, in which case
             // 'id' is valid.  If ID is invalid, we create our own error message.
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <vector>
 
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
@@ -43,7 +44,9 @@ namespace mongo {
             isMulti(false),
             shouldCallLogOp(false),
             fromMigrate(false),
-            isExplain(false) { }
+            isExplain(false),
+            returnDeleted(false),
+            limit(0) { }
 
         // Should we delete all documents returned from the child (a "multi delete"), or at most one
         // (a "single delete")?
@@ -58,11 +61,18 @@ namespace mongo {
 
         // Are we explaining a delete command rather than actually executing it?
         bool isExplain;
+
+        // Should we return each document we delete, as ADVANCED results?
+        bool returnDeleted;
+
+        // Most documents a multi delete removes before it is EOF, or zero for no limit.
+        long long limit;
     };
 
     /**
      * This stage delete documents by RecordId that are returned from its child.  NEED_TIME
-     * is returned after deleting a document.
+     * is returned after deleting a document, or ADVANCED with the deleted document if
+     * 'returnDeleted' is set.
      *
      * Callers of work() must be holding a write lock (and, for shouldCallLogOp=true deletes,
      * callers must have had the replication coordinator approve the write).
@@ -104,6 +114,22 @@ namespace mongo {
         static long long getNumDeleted(PlanExecutor* exec);
 
     private:
+        /**
+         * Adds the document the child returned as 'id' to '_pendingDeletes'. Returns FAILURE,
+         * with the error in 'out', if the member is unusable, NEED_TIME otherwise.
+         */
+        StageState bufferMember(WorkingSetID id, WorkingSetID* out);
+
+        /**
+         * Deletes the documents of '_pendingDeletes' in one WriteUnitOfWork.
+         */
+        void flushPendingDeletes();
+
+        /**
+         * Returns '_deletedDoc' as an owned object in a new member 'out', as ADVANCED.
+         */
+        StageState returnDeletedDoc(WorkingSetID* out);
+
         // Transactional context.  Not owned by us.
         OperationContext* _txn;
 
@@ -122,6 +148,14 @@ namespace mongo {
         // Stats
         CommonStats _commonStats;
         DeleteStats _specificStats;
+
+        // Multi deletes take up to this many documents from the child, within a single call to
+        // work(), and delete them together. 1 means one document at a time.
+        size_t _deleteBatchSize;
+        std::vector<RecordId> _pendingDeletes;
+
+        // With 'returnDeleted', the owned document of the single pending delete.
+        BSONObj _deletedDoc;
     };
 
 }  // namespace mongo
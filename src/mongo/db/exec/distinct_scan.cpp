@@ -108,8 +108,8 @@ namespace mongo {
     PlanStage::StageState DistinctScan::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         if (INITIALIZING == _scanState) {
             invariant(NULL == _btreeCursor.get());
@@ -32,6 +32,8 @@
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/global_environment_experiment.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/mongoutils/str.h"
@@ -52,7 +54,20 @@ namespace mongo {
           _child(child),
           _filter(filter),
           _idBeingPagedIn(WorkingSet::INVALID_ID),
-          _commonStats(kStageType) { }
+          _childBatchPos(0),
+          _childBatchState(PlanStage::NEED_TIME),
+          _childBatchId(WorkingSet::INVALID_ID),
+          _lookahead(0),
+          _commonStats(kStageType) {
+
+        if (internalQueryExecFetchLookahead > 0 && _collection->documentPrefetchSupported()) {
+            _lookahead = internalQueryExecFetchLookahead;
+        }
+
+        if (NULL != _filter && internalQueryExecCompileFilters) {
+            _compiledFilter.reset(new CompiledMatchExpression(_filter));
+        }
+    }
 
     FetchStage::~FetchStage() { }
 
@@ -63,14 +78,24 @@ namespace mongo {
             return false;
         }
 
+        if (_childBatchPos < _childBatch.size()) {
+            // We still have results of the child's last batch to fetch.
+            return false;
+        }
+
+        if (PlanStage::NEED_TIME != _childBatchState && PlanStage::IS_EOF != _childBatchState) {
+            // The child's last batch ended in a state we haven't passed up yet.
+            return false;
+        }
+
         return _child->isEOF();
     }
 
     PlanStage::StageState FetchStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -86,46 +111,37 @@ namespace mongo {
         }
 
         // If we're here, we're not waiting for a RecordId to be fetched.  Get another to-be-fetched
-        // result from our child.
-        WorkingSetID id = WorkingSet::INVALID_ID;
-        StageState status = _child->work(&id);
-
-        if (PlanStage::ADVANCED == status) {
-            WorkingSetMember* member = _ws->get(id);
-
-            // If there's an obj there, there is no fetching to perform.
-            if (member->hasObj()) {
-                ++_specificStats.alreadyHasObj;
-            }
-            else {
-                // We need a valid loc to fetch from and this is the only state that has one.
-                verify(WorkingSetMember::LOC_AND_IDX == member->state);
-                verify(member->hasLoc());
-
-                // We might need to retrieve 'nextLoc' from secondary storage, in which case we send
-                // a NEED_FETCH request up to the PlanExecutor.
-                if (!member->loc.isNull()) {
-                    std::auto_ptr<RecordFetcher> fetcher(
-                        _collection->documentNeedsFetch(_txn, member->loc));
-                    if (NULL != fetcher.get()) {
-                        // There's something to fetch. Hand the fetcher off to the WSM, and pass up
-                        // a fetch request.
-                        _idBeingPagedIn = id;
-                        member->setFetcher(fetcher.release());
-                        *out = id;
-                        _commonStats.needFetch++;
-                        return NEED_FETCH;
-                    }
-                }
+        // result, either from what's left of the child's last batch or from the child itself.
+        if (_lookahead > 0 && _childBatch.empty() && PlanStage::NEED_TIME == _childBatchState) {
+            readAhead();
+        }
 
-                // The doc is already in memory, so go ahead and grab it. Now we have a RecordId
-                // as well as an unowned object
-                member->obj = _collection->docFor(_txn, member->loc);
-                member->keyData.clear();
-                member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState status;
+        if (_childBatchPos < _childBatch.size()) {
+            id = _childBatch[_childBatchPos++];
+            status = PlanStage::ADVANCED;
+            if (_childBatchPos == _childBatch.size()) {
+                _childBatch.clear();
+                _childBatchPos = 0;
             }
+        }
+        else if (PlanStage::NEED_TIME != _childBatchState) {
+            id = _childBatchId;
+            status = _childBatchState;
+            _childBatchId = WorkingSet::INVALID_ID;
+            _childBatchState = PlanStage::NEED_TIME;
+        }
+        else if (_lookahead > 0) {
+            // The child needed time without producing anything to read ahead.
+            status = PlanStage::NEED_TIME;
+        }
+        else {
+            status = _child->work(&id);
+        }
 
-            return returnIfMatches(member, id, out);
+        if (PlanStage::ADVANCED == status) {
+            return fetchChildResult(id, out);
         }
         else if (PlanStage::FAILURE == status) {
             *out = id;
@@ -151,7 +167,184 @@ namespace mongo {
         return status;
     }
 
+    PlanStage::StageState FetchStage::fetchChildResult(WorkingSetID id, WorkingSetID* out) {
+        WorkingSetMember* member = _ws->get(id);
+
+        // If there's an obj there, there is no fetching to perform.
+        if (member->hasObj()) {
+            ++_specificStats.alreadyHasObj;
+        }
+        else {
+            // We need a valid loc to fetch from and this is the only state that has one.
+            verify(WorkingSetMember::LOC_AND_IDX == member->state);
+            verify(member->hasLoc());
+
+            // We might need to retrieve 'nextLoc' from secondary storage, in which case we send
+            // a NEED_FETCH request up to the PlanExecutor.
+            if (!member->loc.isNull()) {
+                std::auto_ptr<RecordFetcher> fetcher(
+                    _collection->documentNeedsFetch(_txn, member->loc));
+                if (NULL != fetcher.get()) {
+                    // There's something to fetch. Hand the fetcher off to the WSM, and pass up
+                    // a fetch request.
+                    _idBeingPagedIn = id;
+                    member->setFetcher(fetcher.release());
+                    *out = id;
+                    _commonStats.needFetch++;
+                    return NEED_FETCH;
+                }
+            }
+
+            // The doc is already in memory, so go ahead and grab it. Now we have a RecordId
+            // as well as an unowned object
+            member->obj = _collection->docFor(_txn, member->loc);
+            member->keyData.clear();
+            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+        }
+
+        return returnIfMatches(member, id, out);
+    }
+
+    void FetchStage::readAhead() {
+        invariant(_childBatch.empty());
+        WorkingSetID childId = WorkingSet::INVALID_ID;
+        StageState status = _child->workBatch(_lookahead, &_childBatch, &childId);
+        if (PlanStage::ADVANCED != status && PlanStage::NEED_TIME != status) {
+            _childBatchState = status;
+            _childBatchId = childId;
+        }
+        prefetchChildBatch();
+    }
+
+    void FetchStage::prefetchChildBatch() {
+        std::vector<RecordId> locs;
+        for (size_t i = _childBatchPos + 1; i < _childBatch.size(); ++i) {
+            const WorkingSetMember* member = _ws->get(_childBatch[i]);
+            if (WorkingSetMember::LOC_AND_IDX == member->state && !member->loc.isNull()) {
+                locs.push_back(member->loc);
+            }
+        }
+
+        if (!locs.empty()) {
+            _collection->prefetchDocuments(_txn, locs);
+            _specificStats.docsPrefetched += locs.size();
+        }
+    }
+
+    void FetchStage::fetchChildBatchForYield() {
+        size_t numKept = _childBatchPos;
+        for (size_t i = _childBatchPos; i < _childBatch.size(); ++i) {
+            const WorkingSetID id = _childBatch[i];
+            WorkingSetMember* member = _ws->get(id);
+            if (WorkingSetMember::LOC_AND_IDX == member->state && !member->loc.isNull()) {
+                BSONObj doc;
+                if (!_collection->findDoc(_txn, member->loc, &doc)) {
+                    _ws->free(id);
+                    continue;
+                }
+                member->obj = doc.getOwned();
+                member->keyData.clear();
+                member->state = WorkingSetMember::LOC_AND_OWNED_OBJ;
+            }
+            _childBatch[numKept++] = id;
+        }
+
+        _childBatch.resize(numKept);
+        if (_childBatchPos == _childBatch.size()) {
+            _childBatch.clear();
+            _childBatchPos = 0;
+        }
+    }
+
+    PlanStage::StageState FetchStage::workBatch(size_t maxWorks,
+                                                std::vector<WorkingSetID>* out,
+                                                WorkingSetID* id) {
+        if (WorkingSet::INVALID_ID != _idBeingPagedIn
+            || !_childBatch.empty()
+            || PlanStage::NEED_TIME != _childBatchState) {
+            // Finish what an earlier batch left over one result at a time.
+            return PlanStage::workBatch(maxWorks, out, id);
+        }
+
+        // Adds the amount of time taken by workBatch() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
+
+        if (isEOF()) {
+            ++_commonStats.works;
+            return PlanStage::IS_EOF;
+        }
+
+        const size_t oldSize = out->size();
+        const size_t oldChildWorks = _child->getCommonStats()->works;
+        WorkingSetID childId = WorkingSet::INVALID_ID;
+        StageState status = _child->workBatch(maxWorks, &_childBatch, &childId);
+        const size_t childWorks = _child->getCommonStats()->works - oldChildWorks;
+        const bool childStopped = PlanStage::ADVANCED != status && PlanStage::NEED_TIME != status;
+
+        // Each unit of work of the child which produced neither a result nor the state the batch
+        // stopped in was a NEED_TIME for us too.
+        const size_t childNeedTimes = childWorks - _childBatch.size() - (childStopped ? 1 : 0);
+        _commonStats.works += childNeedTimes;
+        _commonStats.needTime += childNeedTimes;
+
+        if (_lookahead > 0) {
+            prefetchChildBatch();
+        }
+
+        while (_childBatchPos < _childBatch.size()) {
+            ++_commonStats.works;
+            WorkingSetID resultId = WorkingSet::INVALID_ID;
+            StageState fetchStatus = fetchChildResult(_childBatch[_childBatchPos++], &resultId);
+            if (PlanStage::ADVANCED == fetchStatus) {
+                out->push_back(resultId);
+            }
+            else if (PlanStage::NEED_FETCH == fetchStatus) {
+                // Hold on to the rest of the batch, and the state it ended in, until work() is
+                // called after the fetch.
+                if (_childBatchPos == _childBatch.size()) {
+                    _childBatch.clear();
+                    _childBatchPos = 0;
+                }
+                if (childStopped) {
+                    _childBatchState = status;
+                    _childBatchId = childId;
+                }
+                *id = resultId;
+                return PlanStage::NEED_FETCH;
+            }
+        }
+        _childBatch.clear();
+        _childBatchPos = 0;
+
+        if (!childStopped) {
+            return out->size() > oldSize ? PlanStage::ADVANCED : PlanStage::NEED_TIME;
+        }
+
+        ++_commonStats.works;
+        *id = childId;
+        if (PlanStage::FAILURE == status) {
+            // If a stage fails, it may create a status WSM to indicate why it
+            // failed, in which case 'id' is valid.  If ID is invalid, we
+            // create our own error message.
+            if (WorkingSet::INVALID_ID == childId) {
+                mongoutils::str::stream ss;
+                ss << "fetch stage failed to read in results from child";
+                Status status(ErrorCodes::InternalError, ss);
+                *id = WorkingSetCommon::allocateStatusMember( _ws, status);
+            }
+        }
+        else if (PlanStage::NEED_FETCH == status) {
+            ++_commonStats.needFetch;
+        }
+
+        return status;
+    }
+
     void FetchStage::saveState() {
+        if (_childBatchPos < _childBatch.size() && supportsDocLocking()) {
+            fetchChildBatchForYield();
+        }
+
         _txn = NULL;
         ++_commonStats.yields;
         _child->saveState();
@@ -178,6 +371,14 @@ namespace mongo {
                 WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
             }
         }
+
+        // The same goes for the results of the child's last batch we haven't fetched yet.
+        for (size_t i = _childBatchPos; i < _childBatch.size(); ++i) {
+            WorkingSetMember* member = _ws->get(_childBatch[i]);
+            if (member->hasLoc() && (member->loc == dl)) {
+                WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+            }
+        }
     }
 
     PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
@@ -185,7 +386,7 @@ namespace mongo {
                                                       WorkingSetID* out) {
         ++_specificStats.docsExamined;
 
-        if (Filter::passes(member, _filter)) {
+        if (Filter::passes(member, _filter, _compiledFilter.get())) {
             if (NULL != _filter) {
                 ++_specificStats.matchTested;
             }
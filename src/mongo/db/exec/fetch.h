@@ -33,6 +33,7 @@
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_compiled.h"
 #include "mongo/db/record_id.h"
 
 namespace mongo {
@@ -57,6 +58,9 @@ namespace mongo {
 
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* out,
+                                     WorkingSetID* id);
 
         virtual void saveState();
         virtual void restoreState(OperationContext* opCtx);
@@ -76,6 +80,12 @@ namespace mongo {
 
     private:
 
+        /**
+         * Fetches the document of 'id', a result of our child, and passes it on through
+         * returnIfMatches(). Returns NEED_FETCH instead if the document has to be paged in first.
+         */
+        StageState fetchChildResult(WorkingSetID id, WorkingSetID* out);
+
         /**
          * If the member (with id memberID) passes our filter, set *out to memberID and return that
          * ADVANCED.  Otherwise, free memberID and return NEED_TIME.
@@ -83,6 +93,25 @@ namespace mongo {
         StageState returnIfMatches(WorkingSetMember* member, WorkingSetID memberID,
                                    WorkingSetID* out);
 
+        /**
+         * Reads up to '_lookahead' results of the child into '_childBatch' and prefetches them.
+         * If the child stops, the state it stopped in is kept in '_childBatchState'.
+         */
+        void readAhead();
+
+        /**
+         * Hints the storage engine to start reading in the documents of the results of the
+         * child's batch we haven't fetched yet, except the next one, which we read right away.
+         */
+        void prefetchChildBatch();
+
+        /**
+         * Reads in the documents of the results of the child's batch we haven't fetched yet,
+         * dropping the results whose documents are gone. Used before yielding on storage engines
+         * with document-level locking, which don't invalidate the records they delete.
+         */
+        void fetchChildBatchForYield();
+
         OperationContext* _txn;
 
         // Collection which is used by this stage. Used to resolve record ids retrieved by child
@@ -96,6 +125,9 @@ namespace mongo {
         // The filter is not owned by us.
         const MatchExpression* _filter;
 
+        // The compiled form of '_filter', if there is one and compiling filters is enabled.
+        boost::scoped_ptr<CompiledMatchExpression> _compiledFilter;
+
         // If we want to return a RecordId and it points to something that's not in memory,
         // we return a "please page this in" result. We add a RecordFetcher given back to us by the
         // storage engine to the WSM. The RecordFetcher is used by the PlanExecutor when it handles
@@ -110,6 +142,20 @@ namespace mongo {
         // CollectionScan for when '_idBeingPagedIn' is invalidated before it can be returned.
         WorkingSetID _idBeingPagedIn;
 
+        // A NEED_FETCH can interrupt workBatch() halfway through the batch it got from the child.
+        // The results from '_childBatchPos' on are left to fetch, and '_childBatchState' is the
+        // state the child's batch ended in (NEED_TIME if there is none to pass up), with its id in
+        // '_childBatchId'. work() returns them before working the child again.
+        std::vector<WorkingSetID> _childBatch;
+        size_t _childBatchPos;
+        StageState _childBatchState;
+        WorkingSetID _childBatchId;
+
+        // How many results of the child to read ahead of the one being fetched, so that the
+        // storage engine can read in their documents in the meantime. Zero if the storage engine
+        // can't prefetch or readahead is disabled.
+        size_t _lookahead;
+
         // Stats
         CommonStats _commonStats;
         FetchStats _specificStats;
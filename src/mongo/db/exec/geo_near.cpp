@@ -238,6 +238,58 @@ namespace mongo {
                          min(maxDistance, kMaxEarthDistanceInMeters));
     }
 
+    // Results an annulus is sized to buffer when no limit is known, or the limit is large.
+    static const double kTargetResultsPerInterval = 450;
+    // Fewest results an annulus is sized to buffer, so a small limit can't cause many tiny scans.
+    static const double kMinTargetResultsPerInterval = 20;
+    // Most the annulus width may grow or shrink by from one interval to the next.
+    static const double kMaxBoundsIncrementGrowth = 4;
+
+    /**
+     * Picks the width of the next annulus from the density of results buffered in the last one,
+     * 'lastBounds', aiming for about as many results as are still wanted. An annulus that turned
+     * up nothing grows the width as fast as allowed, so sparse regions are crossed quickly.
+     */
+    static double nextBoundsIncrement(const NearStats& stats,
+                                      const R2Annulus& lastBounds,
+                                      double lastIncrement,
+                                      size_t numWanted) {
+
+        const IntervalStats& lastIntervalStats = stats.intervalStats.back();
+        if (lastIntervalStats.numResultsBuffered == 0) {
+            return lastIncrement * kMaxBoundsIncrementGrowth;
+        }
+
+        // Every result buffered so far has been returned before we're asked for a new interval.
+        // If more than numWanted have been, the caller is reading past a batch size, not a limit.
+        double targetResults = kTargetResultsPerInterval;
+        if (numWanted > 0) {
+            size_t numReturned = 0;
+            for (vector<IntervalStats>::const_iterator it = stats.intervalStats.begin();
+                 it != stats.intervalStats.end(); ++it) {
+                numReturned += it->numResultsBuffered;
+            }
+            if (numReturned < numWanted) {
+                targetResults = max(kMinTargetResultsPerInterval,
+                                    min(targetResults, double(numWanted - numReturned)));
+            }
+        }
+
+        // Treat the annulus as flat - the constant factor of its area cancels out below.
+        const double inner = lastBounds.getInner();
+        const double outer = lastBounds.getOuter();
+        const double lastArea = outer * outer - inner * inner;
+        if (lastArea <= 0) {
+            return lastIncrement;
+        }
+
+        const double density = lastIntervalStats.numResultsBuffered / lastArea;
+        const double nextOuter = sqrt(outer * outer + targetResults / density);
+
+        return min(max(nextOuter - outer, lastIncrement / kMaxBoundsIncrementGrowth),
+                   lastIncrement * kMaxBoundsIncrementGrowth);
+    }
+
     //
     // GeoNear2DStage
     //
@@ -652,14 +704,10 @@ namespace mongo {
         const NearStats* stats = getNearStats();
 
         if (!stats->intervalStats.empty()) {
-
-            const IntervalStats& lastIntervalStats = stats->intervalStats.back();
-
-            // TODO: Generally we want small numbers of results fast, then larger numbers later
-            if (lastIntervalStats.numResultsBuffered < 300)
-                _boundsIncrement *= 2;
-            else if (lastIntervalStats.numResultsBuffered > 600)
-                _boundsIncrement /= 2;
+            _boundsIncrement = nextBoundsIncrement(*stats,
+                                                   _currBounds,
+                                                   _boundsIncrement,
+                                                   _nearParams.numWanted);
         }
 
         _boundsIncrement = max(_boundsIncrement,
@@ -1113,14 +1161,10 @@ namespace mongo {
         const NearStats* stats = getNearStats();
 
         if (!stats->intervalStats.empty()) {
-
-            const IntervalStats& lastIntervalStats = stats->intervalStats.back();
-
-            // TODO: Generally we want small numbers of results fast, then larger numbers later
-            if (lastIntervalStats.numResultsBuffered < 300)
-                _boundsIncrement *= 2;
-            else if (lastIntervalStats.numResultsBuffered > 600)
-                _boundsIncrement /= 2;
+            _boundsIncrement = nextBoundsIncrement(*stats,
+                                                   _currBounds,
+                                                   _boundsIncrement,
+                                                   _nearParams.numWanted);
         }
 
         invariant(_boundsIncrement > 0.0);
@@ -47,7 +47,7 @@ namespace mongo {
     struct GeoNearParams {
 
         GeoNearParams() :
-            filter(NULL), nearQuery(NULL), addPointMeta(false), addDistMeta(false) {
+            filter(NULL), nearQuery(NULL), addPointMeta(false), addDistMeta(false), numWanted(0) {
         }
 
         // MatchExpression to apply to the index keys and fetched documents
@@ -60,6 +60,10 @@ namespace mongo {
         const GeoNearExpression* nearQuery;
         bool addPointMeta;
         bool addDistMeta;
+
+        // Skip plus limit (or batch size) of the query, used to size the search annuli. Zero if
+        // unknown.
+        size_t numWanted;
     };
 
     /**
@@ -87,8 +87,8 @@ namespace mongo {
     PlanStage::StageState IDHackStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         if (_done) { return PlanStage::IS_EOF; }
 
@@ -112,6 +112,14 @@ namespace mongo {
             return PlanStage::IS_EOF;
         }
 
+        // The collection's _id filter can tell us the lookup would miss without our touching
+        // the index.
+        const IdBloomFilter* idFilter = _collection->idBloomFilter();
+        if (NULL != idFilter && !idFilter->mayContain(_key.firstElement())) {
+            _done = true;
+            return PlanStage::IS_EOF;
+        }
+
         // This may not be valid always.  See SERVER-12397.
         const BtreeBasedAccessMethod* accessMethod =
             static_cast<const BtreeBasedAccessMethod*>(catalog->getIndex(idDesc));
@@ -147,10 +147,23 @@ namespace mongo {
     }
 
     PlanStage::StageState IndexScan::work(WorkingSetID* out) {
-        ++_commonStats.works;
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
+
+        return doWork(out);
+    }
+
+    PlanStage::StageState IndexScan::workBatch(size_t maxWorks,
+                                        std::vector<WorkingSetID>* out,
+                                        WorkingSetID* id) {
+        // Time the batch as a whole rather than each unit of work in it.
+        ScopedTimer timer(&_commonStats);
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        return workBatchOf(this, &IndexScan::doWork, maxWorks, out, id);
+    }
+
+    PlanStage::StageState IndexScan::doWork(WorkingSetID* out) {
+        ++_commonStats.works;
 
         if (INITIALIZING == _scanState) {
             invariant(NULL == _indexCursor.get());
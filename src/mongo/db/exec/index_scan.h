@@ -109,6 +109,9 @@ namespace mongo {
         virtual ~IndexScan() { }
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* out,
+                                     WorkingSetID* id);
         virtual bool isEOF();
         virtual void saveState();
         virtual void restoreState(OperationContext* opCtx);
@@ -127,6 +130,11 @@ namespace mongo {
         static const char* kStageType;
 
     private:
+        /**
+         * Does one unit of work, without timing it. Shared by work() and workBatch().
+         */
+        StageState doWork(WorkingSetID* out);
+
         /**
          * Initialize the underlying IndexCursor, grab information from the catalog for stats.
          */
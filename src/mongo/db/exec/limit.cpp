@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/limit.h"
 
+#include <algorithm>
+
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/util/mongoutils/str.h"
@@ -47,8 +49,8 @@ namespace mongo {
     PlanStage::StageState LimitStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         if (0 == _numToReturn) {
             // We've returned as many results as we're limited to.
@@ -88,6 +90,40 @@ namespace mongo {
         return status;
     }
 
+    PlanStage::StageState LimitStage::workBatch(size_t maxWorks,
+                                                std::vector<WorkingSetID>* out,
+                                                WorkingSetID* id) {
+        // Adds the amount of time taken by workBatch() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
+
+        if (0 == _numToReturn) {
+            // We've returned as many results as we're limited to.
+            ++_commonStats.works;
+            return PlanStage::IS_EOF;
+        }
+
+        // Every result takes at least one unit of work, so the child can't overshoot the limit.
+        const size_t oldSize = out->size();
+        const size_t oldChildWorks = _child->getCommonStats()->works;
+        StageState status = _child->workBatch(std::min(maxWorks,
+                                                       static_cast<size_t>(_numToReturn)),
+                                              out,
+                                              id);
+        const size_t childWorks = _child->getCommonStats()->works - oldChildWorks;
+
+        _numToReturn -= out->size() - oldSize;
+        countBatchOfChildWorks(&_commonStats, childWorks, out->size() - oldSize, status);
+
+        if (PlanStage::FAILURE == status && WorkingSet::INVALID_ID == *id) {
+            mongoutils::str::stream ss;
+            ss << "limit stage failed to read in results from child";
+            Status status(ErrorCodes::InternalError, ss);
+            *id = WorkingSetCommon::allocateStatusMember( _ws, status);
+        }
+
+        return status;
+    }
+
     void LimitStage::saveState() {
         ++_commonStats.yields;
         _child->saveState();
@@ -68,8 +68,8 @@ namespace mongo {
     PlanStage::StageState MergeSortStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -93,7 +93,7 @@ namespace mongo {
                     else {
                         ++_specificStats.dupsTested;
                         // ...and there's a diskloc and and we've seen the RecordId before
-                        if (_seen.end() != _seen.find(member->loc)) {
+                        if (!_seen.insert(member->loc)) {
                             // ...drop it.
                             _ws->free(id);
                             ++_commonStats.needTime;
@@ -101,10 +101,9 @@ namespace mongo {
                             return PlanStage::NEED_TIME;
                         }
                         else {
-                            // Otherwise, note that we've seen it.
-                            _seen.insert(member->loc);
-                            // We're going to use the result from the child, so we remove it from
-                            // the queue of children without a result.
+                            // Otherwise, we've now noted that we've seen it.  We're going to use
+                            // the result from the child, so we remove it from the queue of
+                            // children without a result.
                             _noResultToMerge.pop();
                         }
                     }
@@ -264,6 +263,7 @@ namespace mongo {
         _commonStats.isEOF = isEOF();
 
         _specificStats.sortPattern = _pattern;
+        _specificStats.dedupMemUsage = _seen.getMemUsage();
 
         auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_SORT_MERGE));
         ret->specific.reset(new MergeSortStats(_specificStats));
@@ -33,6 +33,7 @@
 #include <vector>
 
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/record_id_set.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/record_id.h"
@@ -95,7 +96,7 @@ namespace mongo {
         bool _dedup;
 
         // Which RecordIds have we seen?
-        unordered_set<RecordId, RecordId::Hasher> _seen;
+        RecordIdSet _seen;
 
         // Owned by us.  All the children we're reading from.
         std::vector<PlanStage*> _children;
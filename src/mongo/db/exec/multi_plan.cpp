@@ -92,8 +92,8 @@ namespace mongo {
     }
 
     PlanStage::StageState MultiPlanStage::work(WorkingSetID* out) {
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         if (_failure) {
             *out = _statusMemberId;
@@ -179,10 +179,10 @@ namespace mongo {
     }
 
     Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
-        // Adds the amount of time taken by pickBestPlan() to executionTimeMillis. There's lots of
+        // Adds the amount of time taken by pickBestPlan() to executionTimeNanos. There's lots of
         // execution work that happens here, so this is needed for the time accounting to
         // make sense.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         // Run each plan some number of times. This number is at least as great as
         // 'internalQueryPlanEvaluationWorks', but may be larger for big collections.
@@ -54,8 +54,8 @@ namespace mongo {
     PlanStage::StageState OrStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -74,17 +74,13 @@ namespace mongo {
                 ++_specificStats.dupsTested;
 
                 // ...and we've seen the RecordId before
-                if (_seen.end() != _seen.find(member->loc)) {
+                if (!_seen.insert(member->loc)) {
                     // ...drop it.
                     ++_specificStats.dupsDropped;
                     _ws->free(id);
                     ++_commonStats.needTime;
                     return PlanStage::NEED_TIME;
                 }
-                else {
-                    // Otherwise, note that we've seen it.
-                    _seen.insert(member->loc);
-                }
             }
 
             if (Filter::passes(member, _filter)) {
@@ -167,10 +163,8 @@ namespace mongo {
         // If we see DL again it is not the same record as it once was so we still want to
         // return it.
         if (_dedup && INVALIDATION_DELETION == type) {
-            unordered_set<RecordId, RecordId::Hasher>::iterator it = _seen.find(dl);
-            if (_seen.end() != it) {
+            if (_seen.erase(dl)) {
                 ++_specificStats.locsForgotten;
-                _seen.erase(dl);
             }
         }
     }
@@ -189,6 +183,8 @@ namespace mongo {
             _commonStats.filter = bob.obj();
         }
 
+        _specificStats.dedupMemUsage = _seen.getMemUsage();
+
         auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_OR));
         ret->specific.reset(new OrStats(_specificStats));
         for (size_t i = 0; i < _children.size(); ++i) {
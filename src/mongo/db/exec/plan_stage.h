@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/invalidation_type.h"
@@ -171,6 +173,24 @@ namespace mongo {
          */
         virtual StageState work(WorkingSetID* out) = 0;
 
+        /**
+         * Performs up to 'maxWorks' units of work, appending the results to 'out', which the
+         * caller must free as if work() had returned them one at a time.
+         *
+         * Stops early at the first state other than ADVANCED and NEED_TIME, and returns it with
+         * '*id' set the way work() sets its out parameter for that state.  Otherwise returns
+         * ADVANCED if the call appended any results and NEED_TIME if it didn't.  Whatever the
+         * state returned, the results appended to 'out' come before it.
+         *
+         * The default implementation calls work() repeatedly. Stages override it when they can
+         * produce a batch more cheaply, e.g. by asking their child for a batch in turn.
+         */
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* out,
+                                     WorkingSetID* id) {
+            return workBatchOf(this, &PlanStage::work, maxWorks, out, id);
+        }
+
         /**
          * Returns true if no more work can be done on the query / out of results.
          */
@@ -267,6 +287,50 @@ namespace mongo {
          */
         virtual const SpecificStats* getSpecificStats() = 0;
 
+    protected:
+        /**
+         * Implements workBatch() on top of 'doWork', which must behave like work() for 'stage'.
+         */
+        template <typename Stage>
+        static StageState workBatchOf(Stage* stage,
+                                      StageState (Stage::*doWork)(WorkingSetID*),
+                                      size_t maxWorks,
+                                      std::vector<WorkingSetID>* out,
+                                      WorkingSetID* id) {
+            const size_t oldSize = out->size();
+            for (size_t i = 0; i < maxWorks; ++i) {
+                WorkingSetID resultId = WorkingSet::INVALID_ID;
+                const StageState state = (stage->*doWork)(&resultId);
+                if (ADVANCED == state) {
+                    out->push_back(resultId);
+                }
+                else if (NEED_TIME != state) {
+                    *id = resultId;
+                    return state;
+                }
+            }
+            return out->size() > oldSize ? ADVANCED : NEED_TIME;
+        }
+
+        /**
+         * Updates 'stats' for a batch of a stage which does one unit of work for each unit of
+         * work of its child. The child did 'childWorks' units ending in 'state', and the stage
+         * returned 'advanced' results out of them. Dropped results count as NEED_TIME.
+         */
+        static void countBatchOfChildWorks(CommonStats* stats,
+                                           size_t childWorks,
+                                           size_t advanced,
+                                           StageState state) {
+            const size_t notNeedTime = advanced + (ADVANCED != state && NEED_TIME != state);
+            stats->works += childWorks;
+            stats->advanced += advanced;
+            if (childWorks > notNeedTime) {
+                stats->needTime += childWorks - notNeedTime;
+            }
+            if (NEED_FETCH == state) {
+                ++stats->needFetch;
+            }
+        }
     };
 
 }  // namespace mongo
@@ -65,7 +65,8 @@ namespace mongo {
                         advanced(0),
                         needTime(0),
                         needFetch(0),
-                        executionTimeMillis(0),
+                        executionTimeNanos(0),
+                        timerCalls(0),
                         isEOF(false) { }
         // String giving the type of the stage. Not owned.
         const char* stageTypeStr;
@@ -85,8 +86,12 @@ namespace mongo {
         // is no filter affixed, then 'filter' should be an empty BSONObj.
         BSONObj filter;
 
-        // Time elapsed while working inside this stage.
-        long long executionTimeMillis;
+        // Time elapsed while working inside this stage, possibly extrapolated from a sample of
+        // calls. See ScopedTimer.
+        long long executionTimeNanos;
+
+        // How many ScopedTimers this stage started, for picking which of them are sampled.
+        size_t timerCalls;
 
         // TODO: have some way of tracking WSM sizes (or really any series of #s).  We can measure
         // the size of our inputs and the size of our outputs.  We can do a lot with the WS here.
@@ -147,7 +152,9 @@ namespace mongo {
         AndHashStats() : flaggedButPassed(0),
                          flaggedInProgress(0),
                          memUsage(0),
-                         memLimit(0) { }
+                         memLimit(0),
+                         compacted(false),
+                         bloomFilterRejects(0) { }
 
         virtual ~AndHashStats() { }
 
@@ -176,6 +183,12 @@ namespace mongo {
 
         // What's our memory limit?
         size_t memLimit;
+
+        // Did we go over the memory limit and keep just RecordIds?
+        bool compacted;
+
+        // How many results of children after the first did the Bloom filter rule out?
+        size_t bloomFilterRejects;
     };
 
     struct AndSortedStats : public SpecificStats {
@@ -200,11 +213,14 @@ namespace mongo {
     };
 
     struct CachedPlanStats : public SpecificStats {
-        CachedPlanStats() { }
+        CachedPlanStats() : replanned(false) { }
 
         virtual SpecificStats* clone() const {
             return new CachedPlanStats(*this);
         }
+
+        // Did the cached plan do badly enough in its trial that we evicted it and replanned?
+        bool replanned;
     };
 
     struct CollectionScanStats : public SpecificStats {
@@ -224,7 +240,7 @@ namespace mongo {
     };
 
     struct CountStats : public SpecificStats {
-        CountStats() : nCounted(0), nSkipped(0), trivialCount(false) { }
+        CountStats() : nCounted(0), nSkipped(0), trivialCount(false), estimated(false) { }
 
         virtual SpecificStats* clone() const {
             CountStats* specific = new CountStats(*this);
@@ -240,6 +256,10 @@ namespace mongo {
         // A "trivial count" is one that we can answer by calling numRecords() on the
         // collection, without actually going through any query logic.
         bool trivialCount;
+
+        // Whether the count is an estimate of the size of an index range, obtained from the
+        // storage engine rather than by scanning. Only possible for approximate count requests.
+        bool estimated;
     };
 
     struct CountScanStats : public SpecificStats {
@@ -296,7 +316,8 @@ namespace mongo {
         FetchStats() : alreadyHasObj(0),
                        forcedFetches(0),
                        matchTested(0),
-                       docsExamined(0) { }
+                       docsExamined(0),
+                       docsPrefetched(0) { }
 
         virtual ~FetchStats() { }
 
@@ -320,6 +341,9 @@ namespace mongo {
 
         // The total number of full documents touched by the fetch stage.
         size_t docsExamined;
+
+        // How many documents the storage engine was asked to read in ahead of their fetch.
+        size_t docsPrefetched;
     };
 
     struct GroupStats : public SpecificStats {
@@ -438,7 +462,8 @@ namespace mongo {
     struct OrStats : public SpecificStats {
         OrStats() : dupsTested(0),
                     dupsDropped(0),
-                    locsForgotten(0) { }
+                    locsForgotten(0),
+                    dedupMemUsage(0) { }
 
         virtual ~OrStats() { }
 
@@ -453,6 +478,9 @@ namespace mongo {
         // How many calls to invalidate(...) actually removed a RecordId from our deduping map?
         size_t locsForgotten;
 
+        // Bytes used by the set of RecordIds we dedup against.
+        size_t dedupMemUsage;
+
         // We know how many passed (it's the # of advanced) and therefore how many failed.
         std::vector<size_t> matchTested;
     };
@@ -470,7 +498,7 @@ namespace mongo {
     };
 
     struct SortStats : public SpecificStats {
-        SortStats() : forcedFetches(0), memUsage(0), memLimit(0) { }
+        SortStats() : forcedFetches(0), memUsage(0), memLimit(0), usedDisk(false) { }
 
         virtual ~SortStats() { }
 
@@ -488,6 +516,9 @@ namespace mongo {
         // What's our memory limit?
         size_t memLimit;
 
+        // Did we go over the memory limit and spill to disk?
+        bool usedDisk;
+
         // The number of results to return from the sort.
         size_t limit;
 
@@ -498,7 +529,8 @@ namespace mongo {
     struct MergeSortStats : public SpecificStats {
         MergeSortStats() : dupsTested(0),
                            dupsDropped(0),
-                           forcedFetches(0) { }
+                           forcedFetches(0),
+                           dedupMemUsage(0) { }
 
         virtual ~MergeSortStats() { }
 
@@ -513,6 +545,9 @@ namespace mongo {
         // How many records were we forced to fetch as the result of an invalidation?
         size_t forcedFetches;
 
+        // Bytes used by the set of RecordIds we dedup against.
+        size_t dedupMemUsage;
+
         // The pattern according to which we are sorting.
         BSONObj sortPattern;
     };
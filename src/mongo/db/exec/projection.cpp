@@ -201,8 +201,8 @@ namespace mongo {
     PlanStage::StageState ProjectionStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         WorkingSetID id = WorkingSet::INVALID_ID;
         StageState status = _child->work(&id);
@@ -246,6 +246,47 @@ namespace mongo {
         return status;
     }
 
+    PlanStage::StageState ProjectionStage::workBatch(size_t maxWorks,
+                                                     std::vector<WorkingSetID>* out,
+                                                     WorkingSetID* id) {
+        // Adds the amount of time taken by workBatch() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
+
+        const size_t oldSize = out->size();
+        const size_t oldChildWorks = _child->getCommonStats()->works;
+        StageState status = _child->workBatch(maxWorks, out, id);
+        const size_t childWorks = _child->getCommonStats()->works - oldChildWorks;
+
+        for (size_t i = oldSize; i < out->size(); ++i) {
+            Status projStatus = transform(_ws->get((*out)[i]));
+            if (!projStatus.isOK()) {
+                warning() << "Couldn't execute projection, status = "
+                          << projStatus.toString() << endl;
+
+                // The results before the one we couldn't project are still good.
+                for (size_t j = i; j < out->size(); ++j) {
+                    _ws->free((*out)[j]);
+                }
+                out->resize(i);
+
+                countBatchOfChildWorks(&_commonStats, childWorks, i - oldSize, FAILURE);
+                *id = WorkingSetCommon::allocateStatusMember(_ws, projStatus);
+                return PlanStage::FAILURE;
+            }
+        }
+
+        countBatchOfChildWorks(&_commonStats, childWorks, out->size() - oldSize, status);
+
+        if (PlanStage::FAILURE == status && WorkingSet::INVALID_ID == *id) {
+            mongoutils::str::stream ss;
+            ss << "projection stage failed to read in results from child";
+            Status status(ErrorCodes::InternalError, ss);
+            *id = WorkingSetCommon::allocateStatusMember( _ws, status);
+        }
+
+        return status;
+    }
+
     void ProjectionStage::saveState() {
         ++_commonStats.yields;
         _child->saveState();
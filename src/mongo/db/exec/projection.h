@@ -84,6 +84,9 @@ namespace mongo {
 
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* out,
+                                     WorkingSetID* id);
 
         virtual void saveState();
         virtual void restoreState(OperationContext* opCtx);
@@ -0,0 +1,182 @@
+// record_id_set.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/record_id_set.h"
+
+#include <climits>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    const int64_t RecordIdSet::kEmpty = LLONG_MIN;
+    const int64_t RecordIdSet::kErased = LLONG_MIN + 1;
+
+    namespace {
+
+        const size_t kMinSlots = 16;
+
+        // A 64 bit mix (splitmix64's finalizer), since RecordIds are often sequential.
+        uint64_t mixRepr(int64_t repr) {
+            uint64_t x = static_cast<uint64_t>(repr);
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+            return x ^ (x >> 31);
+        }
+
+    }  // namespace
+
+    RecordIdSet::RecordIdSet()
+        : _size(0),
+          _numErased(0),
+          _hasEmptyRepr(false),
+          _hasErasedRepr(false) { }
+
+    bool RecordIdSet::insert(const RecordId& loc) {
+        const int64_t repr = loc.repr();
+        if (kEmpty == repr || kErased == repr) {
+            bool& has = (kEmpty == repr) ? _hasEmptyRepr : _hasErasedRepr;
+            if (has) {
+                return false;
+            }
+            has = true;
+            ++_size;
+            return true;
+        }
+
+        if (_slots.empty()) {
+            _rehash(kMinSlots);
+        }
+        else if ((_size + _numErased + 1) * 4 > _slots.size() * 3) {
+            // Grow, unless erased slots are most of what fills the table.
+            _rehash(_numErased < _size ? _slots.size() * 2 : _slots.size());
+        }
+
+        bool found;
+        const size_t i = _find(repr, &found);
+        if (found) {
+            return false;
+        }
+
+        if (kErased == _slots[i]) {
+            --_numErased;
+        }
+        _slots[i] = repr;
+        ++_size;
+        return true;
+    }
+
+    bool RecordIdSet::contains(const RecordId& loc) const {
+        const int64_t repr = loc.repr();
+        if (kEmpty == repr) {
+            return _hasEmptyRepr;
+        }
+        if (kErased == repr) {
+            return _hasErasedRepr;
+        }
+        if (_slots.empty()) {
+            return false;
+        }
+
+        bool found;
+        _find(repr, &found);
+        return found;
+    }
+
+    bool RecordIdSet::erase(const RecordId& loc) {
+        const int64_t repr = loc.repr();
+        if (kEmpty == repr || kErased == repr) {
+            bool& has = (kEmpty == repr) ? _hasEmptyRepr : _hasErasedRepr;
+            if (!has) {
+                return false;
+            }
+            has = false;
+            --_size;
+            return true;
+        }
+        if (_slots.empty()) {
+            return false;
+        }
+
+        bool found;
+        const size_t i = _find(repr, &found);
+        if (!found) {
+            return false;
+        }
+
+        _slots[i] = kErased;
+        ++_numErased;
+        --_size;
+        return true;
+    }
+
+    size_t RecordIdSet::_find(int64_t repr, bool* found) const {
+        dassert(!_slots.empty());
+        const size_t mask = _slots.size() - 1;
+
+        // Linear probing.  The table is never full, so we reach an empty slot.
+        size_t firstErased = _slots.size();
+        for (size_t i = mixRepr(repr) & mask; ; i = (i + 1) & mask) {
+            const int64_t slot = _slots[i];
+            if (repr == slot) {
+                *found = true;
+                return i;
+            }
+            if (kEmpty == slot) {
+                *found = false;
+                return firstErased < _slots.size() ? firstErased : i;
+            }
+            if (kErased == slot && firstErased == _slots.size()) {
+                firstErased = i;
+            }
+        }
+    }
+
+    void RecordIdSet::_rehash(size_t numSlots) {
+        std::vector<int64_t> old(numSlots, kEmpty);
+        _slots.swap(old);
+        _numErased = 0;
+
+        const size_t mask = _slots.size() - 1;
+        for (std::vector<int64_t>::const_iterator it = old.begin(); it != old.end(); ++it) {
+            if (kEmpty == *it || kErased == *it) {
+                continue;
+            }
+            size_t i = mixRepr(*it) & mask;
+            while (kEmpty != _slots[i]) {
+                i = (i + 1) & mask;
+            }
+            _slots[i] = *it;
+        }
+    }
+
+} // namespace mongo
@@ -0,0 +1,97 @@
+// record_id_set.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/record_id.h"
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+
+    /**
+     * A set of RecordIds for deduplicating query results, kept as an open addressing hash table
+     * of their 64 bit representations.  At most 3/4 full, it costs between about 11 and 21
+     * bytes per RecordId, rather than the 40 or more of an unordered_set node.
+     */
+    class RecordIdSet {
+    public:
+        RecordIdSet();
+
+        /**
+         * Returns true if 'loc' was added, false if it was already in the set.
+         */
+        bool insert(const RecordId& loc);
+
+        bool contains(const RecordId& loc) const;
+
+        /**
+         * Returns true if 'loc' was in the set.
+         */
+        bool erase(const RecordId& loc);
+
+        size_t size() const { return _size; }
+
+        /**
+         * Bytes used by the table.
+         */
+        size_t getMemUsage() const { return _slots.capacity() * sizeof(int64_t); }
+
+    private:
+        // Marks for unused and erased slots.  RecordIds with these representations are
+        // remembered by the flags below instead.
+        static const int64_t kEmpty;
+        static const int64_t kErased;
+
+        /**
+         * Returns the slot holding 'repr', or the first free slot on its probe sequence if it
+         * isn't in the table.  Requires a non-empty table.
+         */
+        size_t _find(int64_t repr, bool* found) const;
+
+        /**
+         * Rehashes into a table of 'numSlots', a power of two, dropping erased slots.
+         */
+        void _rehash(size_t numSlots);
+
+        std::vector<int64_t> _slots;
+
+        // Number of RecordIds in the set, including those tracked by the flags.
+        size_t _size;
+
+        // Slots in _slots holding kErased.
+        size_t _numErased;
+
+        bool _hasEmptyRepr;
+        bool _hasErasedRepr;
+    };
+
+} // namespace mongo
@@ -0,0 +1,100 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/exec/record_id_set.cpp
+ */
+
+#include <set>
+
+#include "mongo/db/exec/record_id_set.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    TEST(RecordIdSetTest, InsertContainsErase) {
+        RecordIdSet set;
+        ASSERT_FALSE(set.contains(RecordId(1)));
+        ASSERT_FALSE(set.erase(RecordId(1)));
+
+        ASSERT_TRUE(set.insert(RecordId(1)));
+        ASSERT_FALSE(set.insert(RecordId(1)));
+        ASSERT_TRUE(set.contains(RecordId(1)));
+        ASSERT_EQUALS(1U, set.size());
+
+        ASSERT_TRUE(set.erase(RecordId(1)));
+        ASSERT_FALSE(set.contains(RecordId(1)));
+        ASSERT_FALSE(set.erase(RecordId(1)));
+        ASSERT_EQUALS(0U, set.size());
+
+        // An erased RecordId can come back.
+        ASSERT_TRUE(set.insert(RecordId(1)));
+        ASSERT_TRUE(set.contains(RecordId(1)));
+    }
+
+    TEST(RecordIdSetTest, SentinelRecordIds) {
+        RecordIdSet set;
+        ASSERT_TRUE(set.insert(RecordId::min()));
+        ASSERT_TRUE(set.insert(RecordId(RecordId::min().repr() + 1)));
+        ASSERT_TRUE(set.insert(RecordId::max()));
+        ASSERT_FALSE(set.insert(RecordId::min()));
+        ASSERT_EQUALS(3U, set.size());
+
+        ASSERT_TRUE(set.erase(RecordId::min()));
+        ASSERT_FALSE(set.contains(RecordId::min()));
+        ASSERT_TRUE(set.contains(RecordId(RecordId::min().repr() + 1)));
+        ASSERT_TRUE(set.contains(RecordId::max()));
+        ASSERT_EQUALS(2U, set.size());
+    }
+
+    TEST(RecordIdSetTest, MatchesStdSetThroughGrowthAndErasure) {
+        RecordIdSet set;
+        std::set<RecordId> expected;
+        for (int i = 0; i < 20000; i++) {
+            // Mostly sequential, with repeats, like RecordIds from overlapping index scans.
+            const RecordId loc(static_cast<int64_t>((i * 7) % 9001));
+            ASSERT_EQUALS(expected.insert(loc).second, set.insert(loc));
+            if (i % 3 == 0) {
+                const RecordId victim(static_cast<int64_t>((i * 13) % 9001));
+                ASSERT_EQUALS(expected.erase(victim) > 0, set.erase(victim));
+            }
+        }
+
+        ASSERT_EQUALS(expected.size(), set.size());
+        for (int i = 0; i < 9001; i++) {
+            const RecordId loc(static_cast<int64_t>(i));
+            ASSERT_EQUALS(expected.count(loc) > 0, set.contains(loc));
+        }
+
+        // Far smaller than an unordered_set node per RecordId.
+        ASSERT_LESS_THAN_OR_EQUALS(set.getMemUsage(), 9001U * 24);
+    }
+
+}  // namespace
@@ -30,18 +30,30 @@
 
 #include "mongo/db/exec/scoped_timer.h"
 
-#include "mongo/util/net/listen.h"
+#include "mongo/db/exec/plan_stats.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
 
-    ScopedTimer::ScopedTimer(long long* counter) :
-        _counter(counter),
-        _start(Listener::getElapsedTimeMillis()) {
+    // Time one in this many calls into each stage. One times every call.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecTimingSampleRate, int, 1);
+
+    ScopedTimer::ScopedTimer(CommonStats* stats) : _stats(NULL), _scale(1) {
+        const int sampleRate = internalQueryExecTimingSampleRate;
+        if (sampleRate > 1) {
+            if (stats->timerCalls++ % sampleRate != 0) {
+                return;
+            }
+            _scale = sampleRate;
+        }
+        _stats = stats;
+        _timer.reset();
     }
 
     ScopedTimer::~ScopedTimer() {
-        long long elapsed = Listener::getElapsedTimeMillis() - _start;
-        *_counter += elapsed;
+        if (NULL != _stats) {
+            _stats->executionTimeNanos += _timer.nanos() * _scale;
+        }
     }
 
 }  // namespace mongo
@@ -29,17 +29,25 @@
 #pragma once
 
 #include "mongo/base/disallow_copying.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
+    struct CommonStats;
+
     /**
-     * This class increments a counter by a rough estimate of the time elapsed since its
-     * construction when it goes out of scope.
+     * This class adds the time elapsed since its construction to a stage's
+     * CommonStats::executionTimeNanos when it goes out of scope.
+     *
+     * Timing uses the monotonic high resolution clock. When the
+     * internalQueryExecTimingSampleRate server parameter is N > 1, only one in N timers of a
+     * stage actually reads the clock, and its elapsed time is scaled by N, so stages whose
+     * work() is very cheap do not pay for a clock read per call.
      */
     class ScopedTimer {
         MONGO_DISALLOW_COPYING(ScopedTimer);
     public:
-        ScopedTimer(long long* counter);
+        ScopedTimer(CommonStats* stats);
 
         ~ScopedTimer();
 
@@ -47,11 +55,14 @@ namespace mongo {
         // Default constructor disallowed.
         ScopedTimer();
 
-        // Reference to the counter that we are incrementing with the elapsed time.
-        long long* _counter;
+        // The stats we add the elapsed time to, or NULL if this timer is not sampled.
+        CommonStats* _stats;
+
+        // How much the elapsed time is scaled by to account for unsampled timers.
+        long long _scale;
 
-        // Time at which the timer was constructed.
-        long long _start;
+        // Started at construction if this timer is sampled.
+        Timer _timer;
     };
 
 }  // namespace mongo
@@ -44,7 +44,11 @@ namespace mongo {
     ShardFilterStage::ShardFilterStage(const CollectionMetadataPtr& metadata,
                                        WorkingSet* ws,
                                        PlanStage* child)
-        : _ws(ws), _child(child), _commonStats(kStageType), _metadata(metadata) { }
+        : _ws(ws), _child(child), _commonStats(kStageType), _metadata(metadata) {
+        if (_metadata) {
+            _shardKeyPattern.reset(new ShardKeyPattern(_metadata->getKeyPattern()));
+        }
+    }
 
     ShardFilterStage::~ShardFilterStage() { }
 
@@ -53,8 +57,8 @@ namespace mongo {
     PlanStage::StageState ShardFilterStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         // If we've returned as many results as we're limited to, isEOF will be true.
         if (isEOF()) { return PlanStage::IS_EOF; }
@@ -68,10 +72,9 @@ namespace mongo {
             // aborted migrations
             if (_metadata) {
 
-                ShardKeyPattern shardKeyPattern(_metadata->getKeyPattern());
                 WorkingSetMember* member = _ws->get(*out);
                 WorkingSetMatchableDocument matchable(member);
-                BSONObj shardKey = shardKeyPattern.extractShardKeyFromMatchable(matchable);
+                BSONObj shardKey = _shardKeyPattern->extractShardKeyFromMatchable(matchable);
 
                 if (shardKey.isEmpty()) {
 
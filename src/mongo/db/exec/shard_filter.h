@@ -38,6 +38,8 @@
 
 namespace mongo {
 
+    class ShardKeyPattern;
+
     /**
      * This stage drops documents that didn't belong to the shard we're executing on at the time of
      * construction. This matches the contract for sharded cursorids which guarantees that a
@@ -108,6 +110,9 @@ namespace mongo {
         // Note: it is important that this is the metadata from the time this stage is constructed.
         // See class comment for details.
         const CollectionMetadataPtr _metadata;
+
+        // Parsed once from the metadata's key pattern, rather than for every document
+        boost::scoped_ptr<ShardKeyPattern> _shardKeyPattern;
     };
 
 }  // namespace mongo
@@ -27,6 +27,9 @@
 */
 
 #include "mongo/db/exec/skip.h"
+
+#include <algorithm>
+
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/util/mongoutils/str.h"
@@ -46,8 +49,8 @@ namespace mongo {
     PlanStage::StageState SkipStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         WorkingSetID id = WorkingSet::INVALID_ID;
         StageState status = _child->work(&id);
@@ -91,6 +94,40 @@ namespace mongo {
         return status;
     }
 
+    PlanStage::StageState SkipStage::workBatch(size_t maxWorks,
+                                               std::vector<WorkingSetID>* out,
+                                               WorkingSetID* id) {
+        // Adds the amount of time taken by workBatch() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
+
+        const size_t oldSize = out->size();
+        const size_t oldChildWorks = _child->getCommonStats()->works;
+        StageState status = _child->workBatch(maxWorks, out, id);
+        const size_t childWorks = _child->getCommonStats()->works - oldChildWorks;
+
+        // Drop the results we're still skipping from the front of the batch.
+        const size_t toDrop = std::min(static_cast<size_t>(_toSkip), out->size() - oldSize);
+        for (size_t i = oldSize; i < oldSize + toDrop; ++i) {
+            _ws->free((*out)[i]);
+        }
+        out->erase(out->begin() + oldSize, out->begin() + oldSize + toDrop);
+        _toSkip -= toDrop;
+
+        countBatchOfChildWorks(&_commonStats, childWorks, out->size() - oldSize, status);
+
+        if (PlanStage::FAILURE == status && WorkingSet::INVALID_ID == *id) {
+            mongoutils::str::stream ss;
+            ss << "skip stage failed to read in results from child";
+            Status status(ErrorCodes::InternalError, ss);
+            *id = WorkingSetCommon::allocateStatusMember( _ws, status);
+        }
+        else if (PlanStage::ADVANCED == status && out->size() == oldSize) {
+            return PlanStage::NEED_TIME;
+        }
+
+        return status;
+    }
+
     void SkipStage::saveState() {
         ++_commonStats.yields;
         _child->saveState();
@@ -40,14 +40,218 @@
 #include "mongo/db/query/qlog.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/platform/unordered_set.h"
+#include "mongo/db/sorter/sorter.h"
+#include "mongo/db/storage/key_string.h"
+#include "mongo/db/storage_options.h"
 
 namespace mongo {
 
+    using std::pair;
     using std::vector;
 
     // static
     const char* SortStage::kStageType = "SORT";
 
+    namespace {
+
+        bool hasComputedData(const WorkingSetMember& member) {
+            for (int i = 0; i < WSM_COMPUTED_NUM_TYPES; ++i) {
+                if (member.hasComputed(static_cast<WorkingSetComputedDataType>(i))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * The sort key of a result spilled by a SortStage, with the RecordId which breaks ties.
+         * The key is kept as a KeyString, so that keys compare with a memcmp, unless it is too
+         * big for one, in which case it is kept as BSON.
+         */
+        class SpilledSortKey {
+        public:
+            struct SorterDeserializeSettings {};
+
+            SpilledSortKey() : _isKeyString(false) { }
+
+            SpilledSortKey(const BSONObj& sortKey, Ordering ord, const RecordId& loc)
+                : _isKeyString(false),
+                  _loc(loc) {
+                // Escaping can make a KeyString up to about twice the size of the BSON.
+                if (2 * sortKey.objsize() + 16 < static_cast<int>(KeyString::kMaxBufferSize)) {
+                    // KeyString uses field names to mark bounds, which sort keys aren't.
+                    BSONObjBuilder bob;
+                    BSONForEach(elt, sortKey) {
+                        bob.appendAs(elt, "");
+                    }
+                    KeyString ks = KeyString::make(bob.obj(), ord);
+                    _keyString.assign(ks.getBuffer(), ks.getSize());
+                    _isKeyString = true;
+                }
+                else {
+                    _bson = sortKey.getOwned();
+                }
+            }
+
+            const RecordId& loc() const { return _loc; }
+
+            int compare(const SpilledSortKey& other, Ordering ord) const {
+                int result;
+                if (_isKeyString && other._isKeyString) {
+                    const size_t len = std::min(_keyString.size(), other._keyString.size());
+                    result = memcmp(_keyString.data(), other._keyString.data(), len);
+                    if (0 == result && _keyString.size() != other._keyString.size()) {
+                        result = _keyString.size() < other._keyString.size() ? -1 : 1;
+                    }
+                }
+                else {
+                    // Rare enough that we don't mind decoding.
+                    result = toBSON(ord).woCompare(other.toBSON(ord), ord, false);
+                }
+
+                if (0 != result) {
+                    return result;
+                }
+                return _loc.compare(other._loc);
+            }
+
+            void serializeForSorter(BufBuilder& buf) const {
+                buf.appendChar(_isKeyString);
+                if (_isKeyString) {
+                    buf.appendNum(static_cast<int>(_keyString.size()));
+                    buf.appendBuf(_keyString.data(), _keyString.size());
+                }
+                else {
+                    _bson.serializeForSorter(buf);
+                }
+                _loc.serializeForSorter(buf);
+            }
+
+            static SpilledSortKey deserializeForSorter(BufReader& buf,
+                                                       const SorterDeserializeSettings&) {
+                SpilledSortKey key;
+                key._isKeyString = buf.read<char>();
+                if (key._isKeyString) {
+                    const int size = buf.read<int>();
+                    key._keyString.assign(static_cast<const char*>(buf.skip(size)), size);
+                }
+                else {
+                    key._bson = BSONObj::deserializeForSorter(
+                        buf, BSONObj::SorterDeserializeSettings()).getOwned();
+                }
+                key._loc = RecordId::deserializeForSorter(buf,
+                                                          RecordId::SorterDeserializeSettings());
+                return key;
+            }
+
+            int memUsageForSorter() const {
+                return sizeof(SpilledSortKey) + _keyString.size()
+                    + (_isKeyString ? 0 : _bson.objsize());
+            }
+
+            SpilledSortKey getOwned() const { return *this; }
+
+        private:
+            BSONObj toBSON(Ordering ord) const {
+                if (!_isKeyString) {
+                    return _bson;
+                }
+                return KeyString::toBson(_keyString.data(), _keyString.size(), ord,
+                                         KeyString::TypeBits());
+            }
+
+            bool _isKeyString;
+            std::string _keyString;
+            BSONObj _bson;
+            RecordId _loc;
+        };
+
+        class SpilledSortKeyComparator {
+        public:
+            explicit SpilledSortKeyComparator(Ordering ord) : _ord(ord) { }
+
+            int operator()(const pair<SpilledSortKey, BSONObj>& lhs,
+                           const pair<SpilledSortKey, BSONObj>& rhs) const {
+                return lhs.first.compare(rhs.first, _ord);
+            }
+
+        private:
+            Ordering _ord;
+        };
+
+        typedef Sorter<SpilledSortKey, BSONObj> SpillSorter;
+
+    }  // namespace
+
+    /**
+     * Sorts the results of a SortStage that buffered more than it may keep in memory, writing
+     * sorted runs to disk as needed. Results are kept as owned BSON, with the RecordIds they
+     * had, so we remember which RecordIds are invalidated while they're spilled.
+     */
+    class SortStageSpiller {
+    public:
+        SortStageSpiller(const BSONObj& comparator, size_t maxMemoryUsageBytes)
+            : _ord(Ordering::make(comparator)),
+              _sorter(SpillSorter::make(SortOptions()
+                                            .MaxMemoryUsageBytes(maxMemoryUsageBytes)
+                                            .ExtSortAllowed()
+                                            .TempDir(storageGlobalParams.dbpath + "/_tmp"),
+                                        SpilledSortKeyComparator(_ord))) {
+        }
+
+        void add(const BSONObj& sortKey, const RecordId& loc, const BSONObj& obj) {
+            _sorter->add(SpilledSortKey(sortKey, _ord, loc), obj);
+            if (!loc.isNull()) {
+                _spilledLocs.insert(loc);
+            }
+        }
+
+        void done() {
+            _iterator.reset(_sorter->done());
+            _sorter.reset();
+        }
+
+        bool isEOF() {
+            return NULL == _iterator.get() || !_iterator->more();
+        }
+
+        /**
+         * Puts the next result in 'member'. Results whose RecordId was invalidated come back
+         * without it, as if they'd been fetched when it was.
+         */
+        void next(WorkingSetMember* member) {
+            SpillSorter::Data data = _iterator->next();
+            member->obj = data.second.getOwned();
+            member->loc = data.first.loc();
+            if (!member->loc.isNull() && _spilledLocs.erase(member->loc)) {
+                member->state = WorkingSetMember::LOC_AND_OWNED_OBJ;
+            }
+            else {
+                member->loc = RecordId();
+                member->state = WorkingSetMember::OWNED_OBJ;
+            }
+        }
+
+        void invalidate(const RecordId& dl) {
+            _spilledLocs.erase(dl);
+        }
+
+        size_t memUsed() const {
+            return _sorter ? _sorter->memUsed() : 0;
+        }
+
+    private:
+        Ordering _ord;
+
+        boost::scoped_ptr<SpillSorter> _sorter;
+
+        boost::scoped_ptr<SpillSorter::Iterator> _iterator;
+
+        // The RecordIds of the spilled results which haven't been invalidated.
+        unordered_set<RecordId, RecordId::Hasher> _spilledLocs;
+    };
+
     SortStageKeyGenerator::SortStageKeyGenerator(const Collection* collection,
                                                  const BSONObj& sortSpec,
                                                  const BSONObj& queryObj) {
@@ -289,6 +493,7 @@ namespace mongo {
           _pattern(params.pattern),
           _query(params.query),
           _limit(params.limit),
+          _allowDiskUse(params.allowDiskUse),
           _sorted(false),
           _resultIterator(_data.end()),
           _commonStats(kStageType),
@@ -300,14 +505,17 @@ namespace mongo {
     bool SortStage::isEOF() {
         // We're done when our child has no more results, we've sorted the child's results, and
         // we've returned all sorted results.
+        if (_spiller) {
+            return _child->isEOF() && _sorted && _spiller->isEOF();
+        }
         return _child->isEOF() && _sorted && (_data.end() == _resultIterator);
     }
 
     PlanStage::StageState SortStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         if (NULL == _sortKeyGen) {
             // This is heavy and should be done as part of work().
@@ -323,7 +531,7 @@ namespace mongo {
         }
 
         const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes);
-        if (_memUsage > maxBytes) {
+        if (_memUsage > maxBytes && !(0 == _limit && _allowDiskUse && spillBuffer())) {
             mongoutils::str::stream ss;
             ss << "sort stage buffered data usage of " << _memUsage
                << " bytes exceeds internal limit of " << maxBytes << " bytes";
@@ -366,7 +574,17 @@ namespace mongo {
                     item.loc = member->loc;
                 }
 
-                addToBuffer(item);
+                if (!_spiller) {
+                    addToBuffer(item);
+                }
+                else if (!addToSpiller(item)) {
+                    mongoutils::str::stream ss;
+                    ss << "sort stage can't spill results with computed data to disk, and "
+                       << "buffered more than the internal limit of " << maxBytes << " bytes";
+                    Status status(ErrorCodes::Overflow, ss);
+                    *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+                    return PlanStage::FAILURE;
+                }
 
                 ++_commonStats.needTime;
                 return PlanStage::NEED_TIME;
@@ -374,8 +592,13 @@ namespace mongo {
             else if (PlanStage::IS_EOF == code) {
                 // TODO: We don't need the lock for this.  We could ask for a yield and do this work
                 // unlocked.  Also, this is performing a lot of work for one call to work(...)
-                sortBuffer();
-                _resultIterator = _data.begin();
+                if (_spiller) {
+                    _spiller->done();
+                }
+                else {
+                    sortBuffer();
+                    _resultIterator = _data.begin();
+                }
                 _sorted = true;
                 ++_commonStats.needTime;
                 return PlanStage::NEED_TIME;
@@ -405,6 +628,14 @@ namespace mongo {
         }
 
         // Returning results.
+        if (_spiller) {
+            // Spilled results come back as new, owned, members.
+            *out = _ws->allocate();
+            _spiller->next(_ws->get(*out));
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
         verify(_resultIterator != _data.end());
         verify(_sorted);
         *out = _resultIterator->wsid;
@@ -456,6 +687,12 @@ namespace mongo {
             _wsidByDiskLoc.erase(it);
             ++_specificStats.forcedFetches;
         }
+
+        // Spilled results are copies already, but the RecordId they're returned with must not
+        // be one that was invalidated.
+        if (_spiller) {
+            _spiller->invalidate(dl);
+        }
     }
 
     vector<PlanStage*> SortStage::getChildren() const {
@@ -468,7 +705,8 @@ namespace mongo {
         _commonStats.isEOF = isEOF();
         const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes);
         _specificStats.memLimit = maxBytes;
-        _specificStats.memUsage = _memUsage;
+        _specificStats.memUsage = _spiller ? _spiller->memUsed() : _memUsage;
+        _specificStats.usedDisk = NULL != _spiller.get();
         _specificStats.limit = _limit;
         _specificStats.sortPattern = _pattern.getOwned();
 
@@ -569,6 +807,47 @@ namespace mongo {
         }
     }
 
+    bool SortStage::spillBuffer() {
+        invariant(0 == _limit);
+        invariant(!_spiller);
+
+        // Computed data, such as text scores, isn't spilled with the documents.
+        for (size_t i = 0; i < _data.size(); ++i) {
+            if (hasComputedData(*_ws->get(_data[i].wsid))) {
+                return false;
+            }
+        }
+
+        const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes);
+        _spiller.reset(new SortStageSpiller(_sortKeyGen->getSortComparator(), maxBytes));
+        for (size_t i = 0; i < _data.size(); ++i) {
+            const bool spilled = addToSpiller(_data[i]);
+            invariant(spilled);
+        }
+
+        vector<SortableDataItem> empty;
+        _data.swap(empty);
+        _resultIterator = _data.end();
+        _memUsage = 0;
+        return true;
+    }
+
+    bool SortStage::addToSpiller(const SortableDataItem& item) {
+        WorkingSetMember* member = _ws->get(item.wsid);
+        if (member->hasLoc()) {
+            _wsidByDiskLoc.erase(member->loc);
+        }
+
+        if (hasComputedData(*member)) {
+            _ws->free(item.wsid);
+            return false;
+        }
+
+        _spiller->add(item.sortKey, item.loc, member->obj);
+        _ws->free(item.wsid);
+        return true;
+    }
+
     void SortStage::sortBuffer() {
         if (_limit == 0) {
             const WorkingSetComparator& cmp = *_sortKeyComparator;
@@ -589,3 +868,6 @@ namespace mongo {
     }
 
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
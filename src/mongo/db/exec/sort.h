@@ -43,11 +43,12 @@
 namespace mongo {
 
     class BtreeKeyGenerator;
+    class SortStageSpiller;
 
     // Parameters that must be provided to a SortStage
     class SortStageParams {
     public:
-        SortStageParams() : collection(NULL), limit(0) { }
+        SortStageParams() : collection(NULL), limit(0), allowDiskUse(false) { }
 
         // Used for resolving RecordIds to BSON
         const Collection* collection;
@@ -60,6 +61,10 @@ namespace mongo {
 
         // Equal to 0 for no limit.
         size_t limit;
+
+        // If true, a sort with no limit which buffers more than
+        // internalQueryExecMaxBlockingSortBytes spills to disk rather than failing.
+        bool allowDiskUse;
     };
 
     /**
@@ -191,6 +196,9 @@ namespace mongo {
         // Equal to 0 for no limit.
         size_t _limit;
 
+        // May we spill to disk once we buffer too much?
+        bool _allowDiskUse;
+
         //
         // Sort key generation
         //
@@ -232,6 +240,19 @@ namespace mongo {
          */
         void addToBuffer(const SortableDataItem& item);
 
+        /**
+         * Moves everything buffered so far to '_spiller', creating it, so that the rest of the
+         * results we read from the child are sorted externally. Returns false, leaving the
+         * buffer as it is, if some buffered result can't be spilled.
+         */
+        bool spillBuffer();
+
+        /**
+         * Adds 'item' to '_spiller' and frees its working set member. Returns false, holding on
+         * to nothing, if the member can't be spilled.
+         */
+        bool addToSpiller(const SortableDataItem& item);
+
         /**
          * Sorts data buffer.
          * Assumes no more items will be added to buffer.
@@ -258,6 +279,10 @@ namespace mongo {
         // Iterates through _data post-sort returning it.
         std::vector<SortableDataItem>::iterator _resultIterator;
 
+        // Once we've buffered too much, results go here instead of _data and we return them
+        // from here once sorted. Only used if _allowDiskUse.
+        boost::scoped_ptr<SortStageSpiller> _spiller;
+
         // We buffer a lot of data and we want to look it up by RecordId quickly upon invalidation.
         typedef unordered_map<RecordId, WorkingSetID, RecordId::Hasher> DataMap;
         DataMap _wsidByDiskLoc;
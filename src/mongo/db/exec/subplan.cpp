@@ -100,9 +100,9 @@ namespace mongo {
     }
 
     Status SubplanStage::planSubqueries() {
-        // Adds the amount of time taken by planSubqueries() to executionTimeMillis. There's lots of
+        // Adds the amount of time taken by planSubqueries() to executionTimeNanos. There's lots of
         // work that happens here, so this is needed for the time accounting to make sense.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         MatchExpression* orExpr = _query->root();
 
@@ -156,9 +156,11 @@ namespace mongo {
 
                 // We don't set NO_TABLE_SCAN because peeking at the cache data will keep us from
                 // considering any plan that's a collscan.
-                Status status = QueryPlanner::plan(*branchResult->canonicalQuery.get(),
-                                                   _plannerParams,
-                                                   &branchResult->solutions.mutableVector());
+                Status status = QueryPlanner::planWithCandidateCache(
+                    *branchResult->canonicalQuery.get(),
+                    _plannerParams,
+                    _collection->infoCache()->getPlanCache(),
+                    &branchResult->solutions.mutableVector());
 
                 if (!status.isOK()) {
                     mongoutils::str::stream ss;
@@ -376,7 +378,8 @@ namespace mongo {
 
         // Use the query planning module to plan the whole query.
         vector<QuerySolution*> rawSolutions;
-        Status status = QueryPlanner::plan(*_query, _plannerParams, &rawSolutions);
+        Status status = QueryPlanner::planWithCandidateCache(
+            *_query, _plannerParams, _collection->infoCache()->getPlanCache(), &rawSolutions);
         if (!status.isOK()) {
             return Status(ErrorCodes::BadValue,
                           "error processing query: " + _query->toString() +
@@ -438,9 +441,9 @@ namespace mongo {
     }
 
     Status SubplanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
-        // Adds the amount of time taken by pickBestPlan() to executionTimeMillis. There's lots of
+        // Adds the amount of time taken by pickBestPlan() to executionTimeNanos. There's lots of
         // work that happens here, so this is needed for the time accounting to make sense.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         // Plan each branch of the $or.
         Status subplanningStatus = planSubqueries();
@@ -467,8 +470,8 @@ namespace mongo {
     PlanStage::StageState SubplanStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -28,6 +28,9 @@
 
 #include "mongo/db/exec/text.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/scoped_timer.h"
@@ -42,6 +45,11 @@ namespace mongo {
     // static
     const char* TextStage::kStageType = "TEXT";
 
+    // When reading for a limit, the fewest keys we read between checks for whether we can stop.
+    // Checks take time linear in the number of documents buffered, so we wait at least that many
+    // keys between them too.
+    static const size_t kMinKeysBetweenPruneChecks = 128;
+
     TextStage::TextStage(OperationContext* txn,
                          const TextStageParams& params,
                          WorkingSet* ws,
@@ -53,7 +61,11 @@ namespace mongo {
           _filter(filter),
           _commonStats(kStageType),
           _internalState(INIT_SCANS),
-          _currentIndexScanner(0) {
+          _currentIndexScanner(0),
+          _readForLimit(false),
+          _openScanners(0),
+          _keysSincePruneCheck(0),
+          _usePositions(params.spec.termPositions() && !params.query.getPhr().empty()) {
         _scoreIterator = _scores.end();
         _specificStats.indexPrefix = _params.indexPrefix;
         _specificStats.indexName = _params.index->indexName();
@@ -68,8 +80,8 @@ namespace mongo {
     PlanStage::StageState TextStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
         invariant(_internalState != DONE);
@@ -206,6 +218,18 @@ namespace mongo {
             return PlanStage::IS_EOF;
         }
 
+        // Each scan returns its term's keys from the highest score down, so the last score it
+        // returned bounds the scores still to come, and reading them all in turn lets us stop
+        // once nothing left unread could make it into the best 'limit' results.
+        _readForLimit = _params.limit > 0
+                        && _scanners.size() <= 64
+                        && !_params.query.hasNonTermPieces();
+        if (_readForLimit) {
+            _scannerBounds.assign(_scanners.size(), MAX_WEIGHT);
+            _openScanners = (64 == _scanners.size()) ? ~uint64_t(0)
+                                                     : (uint64_t(1) << _scanners.size()) - 1;
+        }
+
         // Transition to the next state.
         _internalState = READING_TERMS;
         return PlanStage::NEED_TIME;
@@ -225,24 +249,31 @@ namespace mongo {
             invariant(wsm->hasLoc());
             IndexKeyDatum& keyDatum = wsm->keyData.back();
             addTerm(keyDatum.keyData, id);
-            return PlanStage::NEED_TIME;
+
+            if (!_readForLimit) {
+                return PlanStage::NEED_TIME;
+            }
+
+            ++_keysSincePruneCheck;
+            if (_keysSincePruneCheck < std::max(kMinKeysBetweenPruneChecks, _scores.size())
+                || !pruneToLimit()) {
+                advanceSubScanner();
+                return PlanStage::NEED_TIME;
+            }
+
+            // The best 'limit' results are all buffered, so we can stop reading.
         }
         else if (PlanStage::IS_EOF == childState) {
             // Done with this scan.
-            ++_currentIndexScanner;
+            if (_readForLimit) {
+                _scannerBounds[_currentIndexScanner] = 0;
+                _openScanners &= ~(uint64_t(1) << _currentIndexScanner);
+            }
 
-            if (_currentIndexScanner < _scanners.size()) {
+            if (advanceSubScanner()) {
                 // We have another scan to read from.
                 return PlanStage::NEED_TIME;
             }
-
-            // If we're here we are done reading results.  Move to the next state.
-            _scoreIterator = _scores.begin();
-            _internalState = RETURNING_RESULTS;
-
-            // Don't need to keep these around.
-            _scanners.clear();
-            return PlanStage::NEED_TIME;
         }
         else {
             if (PlanStage::FAILURE == childState) {
@@ -260,6 +291,111 @@ namespace mongo {
             }
             return childState;
         }
+
+        // If we're here we are done reading results.  Move to the next state.
+        _scoreIterator = _scores.begin();
+        _internalState = RETURNING_RESULTS;
+
+        // Don't need to keep these around.
+        _scanners.clear();
+        return PlanStage::NEED_TIME;
+    }
+
+    bool TextStage::advanceSubScanner() {
+        if (!_readForLimit) {
+            ++_currentIndexScanner;
+            return _currentIndexScanner < _scanners.size();
+        }
+
+        if (0 == _openScanners) {
+            return false;
+        }
+
+        do {
+            _currentIndexScanner = (_currentIndexScanner + 1) % _scanners.size();
+        } while (!(_openScanners & (uint64_t(1) << _currentIndexScanner)));
+
+        return true;
+    }
+
+    bool TextStage::pruneToLimit() {
+        invariant(_readForLimit);
+        _keysSincePruneCheck = 0;
+
+        // The highest score a document not yet read by any scan could have.
+        double unreadBound = 0;
+        for (size_t i = 0; i < _scannerBounds.size(); ++i) {
+            unreadBound += _scannerBounds[i];
+        }
+
+        // Scores buffered so far only grow as more keys are read, so the 'limit'-th best of them
+        // is a lower bound on the 'limit'-th best final score.
+        std::vector<double> scores;
+        scores.reserve(_scores.size());
+        for (ScoreMap::const_iterator it = _scores.begin(); it != _scores.end(); ++it) {
+            if (it->second.score >= 0) {
+                scores.push_back(it->second.score);
+            }
+        }
+
+        if (scores.size() < _params.limit) {
+            return false;
+        }
+
+        std::nth_element(scores.begin(),
+                         scores.begin() + (_params.limit - 1),
+                         scores.end(),
+                         std::greater<double>());
+        const double limitScore = scores[_params.limit - 1];
+
+        if (unreadBound > limitScore) {
+            return false;
+        }
+
+        // No unread document can beat limitScore, so the results are among the buffered ones.
+        // Drop those which can't beat it either, even with the best scores still unread for the
+        // terms we haven't seen them under.
+        for (ScoreMap::iterator it = _scores.begin(); it != _scores.end();) {
+            const TextRecordData& textRecordData = it->second;
+
+            double bound = textRecordData.score;
+            const uint64_t unseen = _openScanners & ~textRecordData.scannersSeen;
+            for (size_t i = 0; i < _scannerBounds.size(); ++i) {
+                if (unseen & (uint64_t(1) << i)) {
+                    bound += _scannerBounds[i];
+                }
+            }
+
+            if (textRecordData.score >= limitScore || bound > limitScore) {
+                ++it;
+                continue;
+            }
+
+            if (textRecordData.score >= 0 && !_filter) {
+                // Counted as a fetch when first seen, but we won't fetch it now.
+                --_specificStats.fetches;
+            }
+            _ws->free(textRecordData.wsid);
+            _scores.erase(it++);
+        }
+
+        return true;
+    }
+
+    double TextStage::scoreDocument(const BSONObj& doc) const {
+        fts::TermFrequencyMap termFreqs;
+        _params.spec.scoreDocument(doc, &termFreqs);
+
+        // Sum over the query's terms the same way as the scans do, once per scan.
+        double score = 0;
+        const vector<string>& terms = _params.query.getTerms();
+        for (size_t i = 0; i < terms.size(); ++i) {
+            fts::TermFrequencyMap::const_iterator it = termFreqs.find(terms[i]);
+            if (it != termFreqs.end()) {
+                score += it->second;
+            }
+        }
+        return score;
     }
 
     PlanStage::StageState TextStage::returnResults(WorkingSetID* out) {
@@ -279,6 +415,16 @@ namespace mongo {
             return PlanStage::NEED_TIME;
         }
 
+        // The term positions in the index can rule out a phrase without fetching the document.
+        if (_usePositions && !_ftsMatcher.phrasesMayMatch(textRecordData.termPositions)) {
+            if (!_filter) {
+                // Counted as a fetch when first seen, but we won't fetch it now.
+                --_specificStats.fetches;
+            }
+            _ws->free(textRecordData.wsid);
+            return PlanStage::NEED_TIME;
+        }
+
         // Retrieve the document. We may already have the document due to force-fetching before
         // a yield. If not, then we fetch the document here.
         BSONObj doc;
@@ -292,6 +438,12 @@ namespace mongo {
             wsm->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
         }
 
+        // We stopped reading keys before every scan got to this document, so the score buffered
+        // for it may be missing some of its terms.
+        if (_openScanners & ~textRecordData.scannersSeen) {
+            textRecordData.score = scoreDocument(doc);
+        }
+
         // Filter for phrases and negated terms
         if (_params.query.hasNonTermPieces()) {
             if (!_ftsMatcher.matchesNonTerm(doc)) {
@@ -396,12 +548,23 @@ namespace mongo {
         BSONElement scoreElement = keyIt.next();
         double documentTermScore = scoreElement.number();
 
+        if (_readForLimit) {
+            _scannerBounds[_currentIndexScanner] = documentTermScore;
+            textRecordData->scannersSeen |= uint64_t(1) << _currentIndexScanner;
+        }
+
         // Handle filtering.
         if (*documentAggregateScore < 0) {
             // We have already rejected this document.
             return;
         }
 
+        if (_usePositions) {
+            // Index keys are {prefix,term,score,positions,suffix} with term positions.
+            textRecordData->termPositions.resize(_scanners.size());
+            textRecordData->termPositions[_currentIndexScanner] = keyIt.next().wrap();
+        }
+
         if (*documentAggregateScore == 0) {
             if (_filter) {
                 // We have not seen this document before and need to apply a filter.
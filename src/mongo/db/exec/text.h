@@ -55,7 +55,7 @@ namespace mongo {
     class OperationContext;
 
     struct TextStageParams {
-        TextStageParams(const FTSSpec& s) : spec(s) {}
+        TextStageParams(const FTSSpec& s) : spec(s), limit(0) {}
 
         // Text index descriptor.  IndexCatalog owns this.
         IndexDescriptor* index;
@@ -68,6 +68,10 @@ namespace mongo {
 
         // The text query.
         FTSQuery query;
+
+        // If non-zero, only the 'limit' best scoring documents are wanted, and the stage may
+        // return any superset of them rather than every match.
+        size_t limit;
     };
 
     /**
@@ -143,6 +147,26 @@ namespace mongo {
          */
         void addTerm(const BSONObj key, WorkingSetID wsid);
 
+        /**
+         * Moves on to the next sub-scanner to read from: the next one still open when reading
+         * round-robin for a limit, or simply the next one otherwise.  Returns false once every
+         * sub-scanner has been read to the end.
+         */
+        bool advanceSubScanner();
+
+        /**
+         * When reading for a limit, checks whether any document not yet buffered, or not fully
+         * scored, could still score above the 'limit'-th best score buffered so far.  If not,
+         * drops the buffered documents which can't make it into the results and returns true.
+         */
+        bool pruneToLimit();
+
+        /**
+         * Computes the text score of a fetched document from its contents, for documents that
+         * we stopped reading index keys for before all of their terms were scanned.
+         */
+        double scoreDocument(const BSONObj& doc) const;
+
         /**
          * Possibly return a result.  FYI, this may perform a fetch directly if it is needed to
          * evaluate all filters.
@@ -178,11 +202,36 @@ namespace mongo {
         // Which _scanners are we currently reading from?
         size_t _currentIndexScanner;
 
+        // Whether we read the _scanners round-robin and stop as soon as the best 'limit' results
+        // are known.  Requires a limit, at most 64 terms, and no phrases or negated terms, as a
+        // document rejected by those after it is fetched could leave us short of results.
+        bool _readForLimit;
+
+        // Used when _readForLimit.  The score of the last key read by each of the _scanners,
+        // which is at least the score of any key it has yet to read, or 0 once it is EOF.
+        std::vector<double> _scannerBounds;
+
+        // Used when _readForLimit.  Bit i is set for each of the _scanners which is not yet EOF.
+        uint64_t _openScanners;
+
+        // Used when _readForLimit.  Keys read since we last tried pruneToLimit().
+        size_t _keysSincePruneCheck;
+
+        // Whether we collect the term positions from the index keys of each document, to check
+        // phrases before fetching it.  Requires an index with term positions and a phrase.
+        bool _usePositions;
+
         // Map each buffered record id to this data.
         struct TextRecordData {
-            TextRecordData() : wsid(WorkingSet::INVALID_ID), score(0.0) { }
+            TextRecordData() : wsid(WorkingSet::INVALID_ID), score(0.0), scannersSeen(0) { }
             WorkingSetID wsid;
             double score;
+            // Bit i is set if _scanners[i] returned a key for the document.  Used when
+            // _readForLimit.
+            uint64_t scannersSeen;
+            // Element i is the wrapped term positions from the key _scanners[i] returned for the
+            // document, if any.  Used when _usePositions.
+            std::vector<BSONObj> termPositions;
         };
 
         // Temporary score data filled out by sub-scans.  Used in READING_TERMS and
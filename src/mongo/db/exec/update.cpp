@@ -30,6 +30,10 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 #include "mongo/db/exec/update.h"
 
 #include "mongo/bson/mutable/algorithm.h"
@@ -40,12 +44,17 @@
 #include "mongo/db/query/explain.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/repl/oplog.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
 
     namespace mb = mutablebson;
 
+    // Largest number of documents a multi-update changing indexed fields writes together, so
+    // that each index gets their key changes at once and in key order. 1 turns this off.
+    MONGO_EXPORT_SERVER_PARAMETER(updateIndexBatchSize, int, 64);
+
     namespace {
 
         const char idFieldName[] = "_id";
@@ -420,6 +429,64 @@ namespace mongo {
             return Status::OK();
 
         }
+        /**
+         * Returns the element at 'path' in 'obj', descending through embedded documents only, or
+         * EOO if there is none.
+         */
+        BSONElement getFieldThroughObjects(const BSONObj& obj, const FieldRef& path) {
+            BSONElement elem = obj.getField(path.getPart(0));
+            for (size_t i = 1; i < path.numParts(); ++i) {
+                if (elem.type() != Object) {
+                    return BSONElement();
+                }
+                elem = elem.embeddedObject().getField(path.getPart(i));
+            }
+            return elem;
+        }
+
+        /**
+         * Appends 'current' + 'inc' to 'bob' as 'fieldName' if the sum has the type of
+         * 'current', which is when $inc would leave its width unchanged. Returns false, appending
+         * nothing, if the sum would need a wider type or overflows.
+         */
+        bool appendSameTypeSum(const BSONElement& current,
+                               const BSONElement& inc,
+                               const StringData& fieldName,
+                               BSONObjBuilder* bob) {
+            switch (current.type()) {
+            case NumberInt: {
+                if (inc.type() != NumberInt) {
+                    return false;
+                }
+                const long long sum =
+                    static_cast<long long>(current._numberInt()) + inc._numberInt();
+                if (sum > std::numeric_limits<int>::max() ||
+                    sum < std::numeric_limits<int>::min()) {
+                    return false;
+                }
+                bob->append(fieldName, static_cast<int>(sum));
+                return true;
+            }
+            case NumberLong: {
+                if (inc.type() != NumberInt && inc.type() != NumberLong) {
+                    return false;
+                }
+                const long long lhs = current._numberLong();
+                const long long rhs = inc.numberLong();
+                if ((rhs > 0 && lhs > std::numeric_limits<long long>::max() - rhs) ||
+                    (rhs < 0 && lhs < std::numeric_limits<long long>::min() - rhs)) {
+                    return false;
+                }
+                bob->append(fieldName, lhs + rhs);
+                return true;
+            }
+            case NumberDouble:
+                bob->append(fieldName, current._numberDouble() + inc.numberDouble());
+                return true;
+            default:
+                return false;
+            }
+        }
     } // namespace
 
     // static
@@ -437,7 +504,13 @@ namespace mongo {
           _child(child),
           _commonStats(kStageType),
           _updatedLocs(params.request->isMulti() ? new DiskLocSet() : NULL),
-          _doc(params.driver->getDocument()) {
+          _doc(params.driver->getDocument()),
+          _indexUpdateBatchSize(1) {
+        if (params.request->isMulti() && !params.request->isExplain() &&
+            !params.request->shouldReturnAnyDocs() && updateIndexBatchSize > 1) {
+            _indexUpdateBatchSize = updateIndexBatchSize;
+        }
+
         // We are an update until we fall into the insert case.
         params.driver->setContext(ModifierInterface::ExecInfo::UPDATE_CONTEXT);
 
@@ -446,12 +519,120 @@ namespace mongo {
         _specificStats.isDocReplacement = params.driver->isDocReplacement();
     }
 
-    void UpdateStage::transformAndUpdate(BSONObj& oldObj, RecordId& loc) {
+    bool UpdateStage::applyFixedWidthMod(const BSONObj& oldObj, const RecordId& loc) {
+        const UpdateRequest* request = _params.request;
+        UpdateDriver* driver = _params.driver;
+
+        const UpdateDriver::FixedWidthMod* mod = driver->getFixedWidthMod();
+        if (!mod || request->isExplain() || request->shouldReturnNewDocs()) {
+            return false;
+        }
+
+        // Leave anything touching an immutable field, such as the shard key, to the checks on
+        // the general path.
+        if (!(request->isFromReplication() || request->isFromMigration())) {
+            UpdateLifecycle* lifecycle = request->getLifecycle();
+            const std::vector<FieldRef*>* immutableFields =
+                lifecycle ? lifecycle->getImmutableFields() : NULL;
+            if (immutableFields) {
+                for (std::vector<FieldRef*>::const_iterator it = immutableFields->begin();
+                     it != immutableFields->end(); ++it) {
+                    const size_t common = (*it)->commonPrefixSize(mod->path);
+                    if (common == std::min((*it)->numParts(), mod->path.numParts())) {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        const BSONElement current = getFieldThroughObjects(oldObj, mod->path);
+        if (current.eoo()) {
+            return false;
+        }
+
+        // { <path>: <new value> }, which is also what gets logged as a $set.
+        BSONObj newValueObj;
+        if (mod->isInc) {
+            BSONObjBuilder bob;
+            if (!appendSameTypeSum(current, mod->value, mod->path.dottedField(), &bob)) {
+                return false;
+            }
+            newValueObj = bob.obj();
+        }
+        else {
+            newValueObj = mod->holder;
+        }
+
+        const BSONElement newValue = newValueObj.firstElement();
+        if (current.woCompare(newValue, false) == 0) {
+            // A no-op, such as an $inc by 0, as the modifiers would also find it.
+            return true;
+        }
+        if (current.type() != newValue.type()) {
+            return false;
+        }
+
+        WriteUnitOfWork wunit(_txn);
+
+        if (_collection->getRecordStore()->updateWithDamagesSupported()) {
+            mutablebson::DamageEvent damage;
+            damage.sourceOffset = 0;
+            damage.targetOffset = current.value() - oldObj.objdata();
+            damage.size = current.valuesize();
+            _damages.clear();
+            _damages.push_back(damage);
+
+            const RecordData oldRec(oldObj.objdata(), oldObj.objsize());
+            _collection->updateDocumentWithDamages(_txn, loc, oldRec, newValue.value(), _damages);
+        }
+        else {
+            // Patch a copy of the document. Its size and layout don't change, so neither does
+            // any index key.
+            BufBuilder buf(oldObj.objsize());
+            buf.appendBuf(oldObj.objdata(), oldObj.objsize());
+            std::memcpy(buf.buf() + (current.value() - oldObj.objdata()),
+                        newValue.value(),
+                        current.valuesize());
+            const BSONObj newObj(buf.buf());
+
+            StatusWith<RecordId> res = _collection->updateDocument(_txn,
+                                                                   loc, oldObj, newObj,
+                                                                   true, false,
+                                                                   _params.opDebug);
+            uassertStatusOK(res.getStatus());
+            if (_updatedLocs && res.getValue() != loc) {
+                _updatedLocs->insert(res.getValue());
+            }
+        }
+
+        if (request->shouldCallLogOp() && driver->logOp()) {
+            BSONObj idQuery = driver->makeOplogEntryQuery(oldObj, request->isMulti());
+            repl::logOp(_txn,
+                        "u",
+                        request->getNamespaceString().ns().c_str(),
+                        BSON("$set" << newValueObj),
+                        &idQuery,
+                        NULL,
+                        request->isFromMigration());
+        }
+
+        wunit.commit();
+
+        _specificStats.fastmod = true;
+        _specificStats.nModified++;
+        return true;
+    }
+
+    BSONObj UpdateStage::transformAndUpdate(BSONObj& oldObj, RecordId& loc) {
         const UpdateRequest* request = _params.request;
         UpdateDriver* driver = _params.driver;
         CanonicalQuery* cq = _params.canonicalQuery;
         UpdateLifecycle* lifecycle = request->getLifecycle();
 
+        if (applyFixedWidthMod(oldObj, loc)) {
+            return BSONObj();
+        }
+
         // Ask the driver to apply the mods. It may be that the driver can apply those "in
         // place", that is, some values of the old document just get adjusted without any
         // change to the binary layout on the bson layer. It may be that a whole new document
@@ -515,6 +696,7 @@ namespace mongo {
             docWasModified = false;
         }
 
+        BSONObj newObj;
         if (docWasModified) {
 
             // Verify that no immutable fields were changed and data is valid for storage.
@@ -532,8 +714,26 @@ namespace mongo {
             }
 
 
+            if (!inPlace && _indexUpdateBatchSize > 1 && driver->modsAffectIndices()) {
+                // Leave the write to flushPendingUpdates(), along with the other documents of
+                // the batch.
+                PendingUpdate pending;
+                pending.loc = loc;
+                pending.oldObj = oldObj.getOwned();
+                pending.newObj = _doc.getObject();
+                pending.logObj = logObj.getOwned();
+                uassert(17419,
+                        str::stream() << "Resulting document after update is larger than "
+                        << BSONObjMaxUserSize,
+                        pending.newObj.objsize() <= BSONObjMaxUserSize);
+                _pendingUpdates.push_back(pending);
+
+                // Don't take the document again from the child before the batch is written.
+                _updatedLocs->insert(loc);
+                return BSONObj();
+            }
+
             // Prepare to write back the modified document
-            BSONObj newObj;
             WriteUnitOfWork wunit(_txn);
 
             if (inPlace) {
@@ -545,7 +745,8 @@ namespace mongo {
                     _collection->updateDocumentWithDamages(_txn, loc, oldRec, source, _damages);
                 }
 
-                newObj = oldObj;
+                // The damages were computed against 'oldObj', which may be the record itself.
+                newObj = request->shouldReturnNewDocs() ? _doc.getObject() : oldObj;
                 _specificStats.fastmod = true;
 
             }
@@ -601,6 +802,11 @@ namespace mongo {
         if (docWasModified || request->isExplain()) {
             _specificStats.nModified++;
         }
+
+        if (!request->shouldReturnNewDocs()) {
+            return BSONObj();
+        }
+        return docWasModified ? newObj.getOwned() : oldObj.getOwned();
     }
 
     void UpdateStage::doInsert() {
@@ -720,157 +926,319 @@ namespace mongo {
         return doneUpdating() && !needInsert();
     }
 
-    PlanStage::StageState UpdateStage::work(WorkingSetID* out) {
-        ++_commonStats.works;
+    PlanStage::StageState UpdateStage::updateMember(WorkingSetID id, WorkingSetID* out) {
+        // Need to get these things from the result returned by the child.
+        RecordId loc;
+        BSONObj oldObj;
 
-        // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        WorkingSetMember* member = _ws->get(id);
 
-        if (isEOF()) { return PlanStage::IS_EOF; }
+        if (!member->hasLoc()) {
+            _ws->free(id);
+            const std::string errmsg = "update stage failed to read member w/ loc from child";
+            *out = WorkingSetCommon::allocateStatusMember(_ws, Status(ErrorCodes::InternalError,
+                                                                      errmsg));
+            return PlanStage::FAILURE;
+        }
+        loc = member->loc;
+
+        // Updates can't have projections. This means that covering analysis will always add
+        // a fetch. We should always get fetched data, and never just key data.
+        invariant(member->hasObj());
+        oldObj = member->obj;
+
+        // If the working set member is in the owned obj with loc state, then 'oldObj' may not
+        // be the latest version in the database. In this case, we must refetch the doc from the
+        // collection. We also must be tolerant of the possibility that the doc at the wsm's
+        // RecordId was deleted or updated after being force-fetched.
+        if (WorkingSetMember::LOC_AND_OWNED_OBJ == member->state) {
+            if (!_collection->findDoc(_txn, loc, &oldObj)) {
+                // The doc was deleted after the force-fetch, so we just move on.
+                return PlanStage::NEED_TIME;
+            }
 
-        if (doneUpdating()) {
-            // Even if we're done updating, we may have some inserting left to do.
-            if (needInsert()) {
-                doInsert();
+            // We need to make sure that the doc still matches the predicate, as it may have
+            // been updated since being force-fetched.
+            //
+            // 'cq' may be NULL in the case of idhack updates. In this case, doc-level locking
+            // storage engines will look up the key in the _id index and fetch the keyed
+            // document in a single work() cyle. Since yielding cannot happen between these
+            // two events, the OperationContext protects from the doc changing under our feet.
+            CanonicalQuery* cq = _params.canonicalQuery;
+            if (cq && !cq->root()->matchesBSON(oldObj, NULL)) {
+                return PlanStage::NEED_TIME;
             }
+        }
 
-            // At this point either we're done updating and there was no insert to do,
-            // or we're done updating and we're done inserting. Either way, we're EOF.
-            invariant(isEOF());
-            return PlanStage::IS_EOF;
+        // If we're here, then we have retrieved both a RecordId and the corresponding
+        // object from the child stage. Since we have the object and the diskloc,
+        // we can free the WSM.
+        _ws->free(id);
+
+        // We fill this with the new locs of moved doc so we don't double-update.
+        if (_updatedLocs && _updatedLocs->count(loc) > 0) {
+            // Found a loc that we already updated.
+            return PlanStage::NEED_TIME;
         }
 
-        // If we're here, then we still have to ask for results from the child and apply
-        // updates to them. We should only get here if the collection exists.
-        invariant(_collection);
+        ++_specificStats.nMatched;
 
-        WorkingSetID id = WorkingSet::INVALID_ID;
-        StageState status = _child->work(&id);
+        // The update may change the record 'oldObj' points to.
+        BSONObj oldObjOwned;
+        if (_params.request->shouldReturnOldDocs()) {
+            oldObjOwned = oldObj.getOwned();
+        }
 
-        if (PlanStage::ADVANCED == status) {
-            // Need to get these things from the result returned by the child.
-            RecordId loc;
-            BSONObj oldObj;
+        // Save state before making changes
+        _child->saveState();
 
-            WorkingSetMember* member = _ws->get(id);
+        // Do the update.
+        BSONObj newObj;
+        const bool updated = updateWithRetries(oldObj, loc, &newObj);
 
-            if (!member->hasLoc()) {
-                _ws->free(id);
-                const std::string errmsg = "update stage failed to read member w/ loc from child";
-                *out = WorkingSetCommon::allocateStatusMember(_ws, Status(ErrorCodes::InternalError,
-                                                                          errmsg));
-                return PlanStage::FAILURE;
+        // Restore state after modification
+
+        // As restoreState may restore (recreate) cursors, make sure to restore the
+        // state outside of the WritUnitOfWork.
+
+        _child->restoreState(_txn);
+
+        if (updated && _params.request->shouldReturnAnyDocs()) {
+            return returnDoc(_params.request->shouldReturnOldDocs() ? oldObjOwned : newObj, out);
+        }
+
+        return PlanStage::NEED_TIME;
+    }
+
+    PlanStage::StageState UpdateStage::returnDoc(const BSONObj& doc, WorkingSetID* out) {
+        WorkingSetID id = _ws->allocate();
+        WorkingSetMember* member = _ws->get(id);
+        member->obj = doc;
+        member->state = WorkingSetMember::OWNED_OBJ;
+
+        *out = id;
+        return PlanStage::ADVANCED;
+    }
+
+    bool UpdateStage::updateWithRetries(BSONObj oldObj, RecordId loc, BSONObj* newObjOut) {
+        BSONObj reFetched;
+        uint64_t attempt = 1;
+
+        while ( attempt++ ) {
+            try {
+                *newObjOut = transformAndUpdate(reFetched.isEmpty() ? oldObj : reFetched , loc);
+                return true;
             }
-            loc = member->loc;
-
-            // Updates can't have projections. This means that covering analysis will always add
-            // a fetch. We should always get fetched data, and never just key data.
-            invariant(member->hasObj());
-            oldObj = member->obj;
-
-            // If the working set member is in the owned obj with loc state, then 'oldObj' may not
-            // be the latest version in the database. In this case, we must refetch the doc from the
-            // collection. We also must be tolerant of the possibility that the doc at the wsm's
-            // RecordId was deleted or updated after being force-fetched.
-            if (WorkingSetMember::LOC_AND_OWNED_OBJ == member->state) {
-                if (!_collection->findDoc(_txn, loc, &oldObj)) {
-                    // The doc was deleted after the force-fetch, so we just move on.
-                    ++_commonStats.needTime;
-                    return PlanStage::NEED_TIME;
+            catch ( const WriteConflictException& de ) {
+                if ( !_params.request->isMulti() ) {
+                    // We don't handle this here as we handle at the top level.
+                    throw;
                 }
 
-                // We need to make sure that the doc still matches the predicate, as it may have
-                // been updated since being force-fetched.
-                //
-                // 'cq' may be NULL in the case of idhack updates. In this case, doc-level locking
-                // storage engines will look up the key in the _id index and fetch the keyed
-                // document in a single work() cyle. Since yielding cannot happen between these
-                // two events, the OperationContext protects from the doc changing under our feet.
-                CanonicalQuery* cq = _params.canonicalQuery;
-                if (cq && !cq->root()->matchesBSON(oldObj, NULL)) {
-                    ++_commonStats.needTime;
-                    return PlanStage::NEED_TIME;
+                _params.opDebug->writeConflicts++;
+
+                _txn->recoveryUnit()->commitAndRestart();
+
+                _txn->checkForInterrupt();
+
+                WriteConflictException::logAndBackoff( attempt,
+                                                       "multi-update",
+                                                       _collection->ns().ns() );
+
+                if ( attempt > 2 ) {
+                    // This means someone else is in this same loop trying to update
+                    // the same doc.  Lets make sure we give them a chance to finish.
+#if !defined(_WIN32)
+                    sched_yield();
+#else
+                    SwitchToThread();
+#endif
+                }
+
+                if ( !_collection->findDoc( _txn, loc, &reFetched ) ) {
+                    // document was deleted, we're done here
+                    break;
+                }
+                // we have to re-match the doc as it might not match anymore
+                if ( _params.canonicalQuery &&
+                     _params.canonicalQuery->root() &&
+                     !_params.canonicalQuery->root()->matchesBSON( reFetched, NULL ) ) {
+                    // doesn't match!
+                    break;
                 }
+                // now we try again!
             }
+        }
+        return false;
+    }
 
-            // If we're here, then we have retrieved both a RecordId and the corresponding
-            // object from the child stage. Since we have the object and the diskloc,
-            // we can free the WSM.
-            _ws->free(id);
+    void UpdateStage::flushPendingUpdates() {
+        if (_pendingUpdates.empty()) {
+            return;
+        }
 
-            // We fill this with the new locs of moved doc so we don't double-update.
-            if (_updatedLocs && _updatedLocs->count(loc) > 0) {
-                // Found a loc that we already updated.
-                ++_commonStats.needTime;
-                return PlanStage::NEED_TIME;
+        // As restoreState may restore (recreate) cursors, write outside of the child's state.
+        _child->saveState();
+
+        bool written = false;
+        try {
+            writePendingUpdates();
+            written = true;
+        }
+        catch (const WriteConflictException&) {
+            _params.opDebug->writeConflicts++;
+            _txn->recoveryUnit()->commitAndRestart();
+            _txn->checkForInterrupt();
+        }
+        catch (const DBException& ex) {
+            LOG(1) << "batched multi-update of " << _pendingUpdates.size() << " documents in "
+                   << _collection->ns().ns() << " failed, redoing it one document at a time: "
+                   << ex.toString();
+        }
+
+        if (!written) {
+            // The batch was rolled back. Redo it as if it had never been buffered, to retry
+            // write conflicts per document and fail at the document which fails.
+            std::vector<PendingUpdate> pending;
+            pending.swap(_pendingUpdates);
+
+            const size_t batchSize = _indexUpdateBatchSize;
+            _indexUpdateBatchSize = 1;
+            for (std::vector<PendingUpdate>::const_iterator it = pending.begin();
+                 it != pending.end(); ++it) {
+                BSONObj current;
+                if (!_collection->findDoc(_txn, it->loc, &current)) {
+                    continue;
+                }
+                if (_params.canonicalQuery &&
+                    _params.canonicalQuery->root() &&
+                    !_params.canonicalQuery->root()->matchesBSON(current, NULL)) {
+                    continue;
+                }
+                BSONObj newObj;
+                updateWithRetries(current, it->loc, &newObj);
             }
+            _indexUpdateBatchSize = batchSize;
+        }
 
-            ++_specificStats.nMatched;
+        _child->restoreState(_txn);
+    }
+
+    void UpdateStage::writePendingUpdates() {
+        const UpdateRequest* request = _params.request;
+        UpdateDriver* driver = _params.driver;
 
-            // Save state before making changes
-            _child->saveState();
+        std::vector<RecordId> locs;
+        std::vector<BSONObj> oldDocs;
+        std::vector<BSONObj> newDocs;
+        locs.reserve(_pendingUpdates.size());
+        oldDocs.reserve(_pendingUpdates.size());
+        newDocs.reserve(_pendingUpdates.size());
+        for (std::vector<PendingUpdate>::const_iterator it = _pendingUpdates.begin();
+             it != _pendingUpdates.end(); ++it) {
+            locs.push_back(it->loc);
+            oldDocs.push_back(it->oldObj);
+            newDocs.push_back(it->newObj);
+        }
 
-            // Do the update and return.
-            BSONObj reFetched;
-            uint64_t attempt = 1;
+        WriteUnitOfWork wunit(_txn);
 
-            while ( attempt++ ) {
-                try {
-                    transformAndUpdate(reFetched.isEmpty() ? oldObj : reFetched , loc);
-                    break;
-                }
-                catch ( const WriteConflictException& de ) {
-                    if ( !_params.request->isMulti() ) {
-                        // We don't handle this here as we handle at the top level.
-                        throw;
-                    }
+        std::vector<RecordId> newLocs;
+        uassertStatusOK(_collection->updateDocuments(_txn, locs, oldDocs, newDocs,
+                                                     true, _params.opDebug, &newLocs));
 
-                    _params.opDebug->writeConflicts++;
+        for (size_t i = 0; i < _pendingUpdates.size(); ++i) {
+            const PendingUpdate& pending = _pendingUpdates[i];
 
-                    _txn->recoveryUnit()->commitAndRestart();
+            // As for any update changing indexed values, we might see the document again.
+            _updatedLocs->insert(newLocs[i]);
 
-                    _txn->checkForInterrupt();
+            if (request->shouldCallLogOp() && !pending.logObj.isEmpty()) {
+                BSONObj idQuery = driver->makeOplogEntryQuery(pending.newObj,
+                                                              request->isMulti());
+                repl::logOp(_txn,
+                            "u",
+                            request->getNamespaceString().ns().c_str(),
+                            pending.logObj,
+                            &idQuery,
+                            NULL,
+                            request->isFromMigration());
+            }
+        }
 
-                    WriteConflictException::logAndBackoff( attempt,
-                                                           "multi-update",
-                                                           _collection->ns().ns() );
+        wunit.commit();
 
-                    if ( attempt > 2 ) {
-                        // This means someone else is in this same loop trying to update
-                        // the same doc.  Lets make sure we give them a chance to finish.
-#if !defined(_WIN32)
-                        sched_yield();
-#else
-                        SwitchToThread();
-#endif
-                    }
+        _specificStats.nModified += _pendingUpdates.size();
+        _pendingUpdates.clear();
+    }
 
-                    if ( !_collection->findDoc( _txn, loc, &reFetched ) ) {
-                        // document was deleted, we're done here
-                        break;
-                    }
-                    // we have to re-match the doc as it might not match anymore
-                    if ( _params.canonicalQuery &&
-                         _params.canonicalQuery->root() &&
-                         !_params.canonicalQuery->root()->matchesBSON( reFetched, NULL ) ) {
-                        // doesn't match!
-                        break;
-                    }
-                    // now we try again!
+    PlanStage::StageState UpdateStage::work(WorkingSetID* out) {
+        ++_commonStats.works;
+
+        // Adds the amount of time taken by work() to executionTimeNanos.
+        ScopedTimer timer(&_commonStats);
+
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        if (doneUpdating()) {
+            // Even if we're done updating, we may have some inserting left to do.
+            if (needInsert()) {
+                doInsert();
+
+                if (_params.request->shouldReturnNewDocs()) {
+                    ++_commonStats.advanced;
+                    return returnDoc(_specificStats.objInserted.getOwned(), out);
                 }
             }
 
-            // Restore state after modification
+            // At this point either we're done updating and there was no insert to do,
+            // or we're done updating and we're done inserting. Either way, we're EOF.
+            invariant(isEOF());
+            return PlanStage::IS_EOF;
+        }
+
+        // If we're here, then we still have to ask for results from the child and apply
+        // updates to them. We should only get here if the collection exists.
+        invariant(_collection);
+
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState status = _child->work(&id);
 
-            // As restoreState may restore (recreate) cursors, make sure to restore the
-            // state outside of the WritUnitOfWork.
+        // A yield may happen between calls to work(), so buffered updates never outlive one:
+        // keep taking documents from the child until the batch is full or the child returns
+        // something else.
+        for (size_t childWorks = 1; ; ++childWorks) {
+            if (PlanStage::ADVANCED == status) {
+                const StageState memberStatus = updateMember(id, out);
+                if (PlanStage::ADVANCED == memberStatus) {
+                    // Returning documents is only for single updates, which never buffer.
+                    invariant(_pendingUpdates.empty());
+                    ++_commonStats.advanced;
+                    return PlanStage::ADVANCED;
+                }
+                if (PlanStage::FAILURE == memberStatus) {
+                    flushPendingUpdates();
+                    return PlanStage::FAILURE;
+                }
+                status = PlanStage::NEED_TIME;
+            }
+            else if (PlanStage::NEED_TIME != status) {
+                break;
+            }
 
-            _child->restoreState(_txn);
+            if (_pendingUpdates.empty() ||
+                _pendingUpdates.size() >= _indexUpdateBatchSize ||
+                childWorks >= 4 * _indexUpdateBatchSize) {
+                break;
+            }
 
-            ++_commonStats.needTime;
-            return PlanStage::NEED_TIME;
+            id = WorkingSet::INVALID_ID;
+            status = _child->work(&id);
         }
-        else if (PlanStage::IS_EOF == status) {
+
+        flushPendingUpdates();
+
+        if (PlanStage::IS_EOF == status) {
             // The child is out of results, but we might not be done yet because we still might
             // have to do an insert.
             ++_commonStats.needTime;
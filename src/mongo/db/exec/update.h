@@ -72,7 +72,8 @@ namespace mongo {
 
     /**
      * Execution stage responsible for updates to documents and upserts. NEED_TIME is returned
-     * after performing an update or an insert.
+     * after performing an update or an insert, or ADVANCED with the old or new document if
+     * the request asks for them.
      *
      * Callers of work() must be holding a write lock.
      */
@@ -116,11 +117,51 @@ namespace mongo {
         static UpdateResult makeUpdateResult(PlanExecutor* exec, OpDebug* opDebug);
 
     private:
+        /**
+         * Applies the driver's FixedWidthMod, if it has one, to the document 'oldObj' at RecordId
+         * 'loc' by overwriting the bytes of the old value, skipping the mutable document and the
+         * modifiers. Returns false, having done nothing, if the update doesn't fit in place or
+         * needs the checks of the general path.
+         */
+        bool applyFixedWidthMod(const BSONObj& oldObj, const RecordId& loc);
+
         /**
          * Computes the result of applying mods to the document 'oldObj' at RecordId 'loc' in
-         * memory, then commits these changes to the database.
+         * memory, then commits these changes to the database. When the changes affect indexes
+         * and batching is on, they are added to '_pendingUpdates' instead.
+         *
+         * Returns the owned document after the update if the request returns new documents, an
+         * empty object otherwise.
+         */
+        BSONObj transformAndUpdate(BSONObj& oldObj, RecordId& loc);
+
+        /**
+         * Updates the document the child returned as 'id'. Returns FAILURE, with the error in
+         * 'out', if the member is unusable, ADVANCED with the document in 'out' if the request
+         * returns documents, NEED_TIME otherwise.
+         */
+        StageState updateMember(WorkingSetID id, WorkingSetID* out);
+
+        /**
+         * Calls transformAndUpdate(), fetching the document again and retrying on write
+         * conflicts for as long as it still matches. Returns whether the document was updated,
+         * with transformAndUpdate()'s result in 'newObjOut'.
          */
-        void transformAndUpdate(BSONObj& oldObj, RecordId& loc);
+        bool updateWithRetries(BSONObj oldObj, RecordId loc, BSONObj* newObjOut);
+
+        /**
+         * Puts the owned 'doc' in a new working set member 'out' and returns ADVANCED.
+         */
+        StageState returnDoc(const BSONObj& doc, WorkingSetID* out);
+
+        /**
+         * Writes '_pendingUpdates' in one WriteUnitOfWork through Collection::updateDocuments().
+         * If that fails, redoes them one document at a time.
+         */
+        void flushPendingUpdates();
+
+        /** Writes '_pendingUpdates' in one WriteUnitOfWork, throwing on errors. */
+        void writePendingUpdates();
 
         /**
          * Computes the document to insert and inserts it into the collection. Used if the
@@ -181,6 +222,19 @@ namespace mongo {
         // These get reused for each update.
         mutablebson::Document& _doc;
         mutablebson::DamageVector _damages;
+
+        // A computed update waiting for its write, along with others, by flushPendingUpdates().
+        struct PendingUpdate {
+            RecordId loc;
+            BSONObj oldObj;
+            BSONObj newObj;
+            BSONObj logObj;
+        };
+
+        // Multi-updates which change indexed fields buffer up to this many documents, within a
+        // single call to work(), and write them together. 1 means no buffering.
+        size_t _indexUpdateBatchSize;
+        std::vector<PendingUpdate> _pendingUpdates;
     };
 
 }  // namespace mongo
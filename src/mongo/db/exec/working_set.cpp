@@ -28,31 +28,100 @@
 
 #include "mongo/db/exec/working_set.h"
 
+#include <boost/thread/tss.hpp>
+
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/storage/record_fetcher.h"
 
 namespace mongo {
 
+    namespace {
+
+        // How many WorkingSets each thread keeps for reuse, and how many members one can have
+        // room for and still be kept. Most queries get by with a handful of members. Those that
+        // buffer many results, like blocking sorts, are rare enough not to be worth the memory.
+        const size_t kMaxPooledWorkingSets = 2;
+        const size_t kMaxPooledMembers = 128;
+
+        /**
+         * The WorkingSets kept by a thread, deleted with it.
+         */
+        class WorkingSetPool {
+        public:
+            ~WorkingSetPool() {
+                for (size_t i = 0; i < _free.size(); ++i) {
+                    delete _free[i];
+                }
+            }
+
+            std::vector<WorkingSet*> _free;
+        };
+
+        boost::thread_specific_ptr<WorkingSetPool> workingSetPool;
+
+    }  // namespace
+
     WorkingSet::MemberHolder::MemberHolder() : member(NULL) { }
     WorkingSet::MemberHolder::~MemberHolder() {}
 
     WorkingSet::WorkingSet() : _freeList(INVALID_ID) { }
 
     WorkingSet::~WorkingSet() {
-        for (size_t i = 0; i < _data.size(); i++) {
-            delete _data[i].member;
+        for (size_t i = 0; i < _blocks.size(); i++) {
+            delete[] _blocks[i];
+        }
+    }
+
+    // static
+    WorkingSet* WorkingSet::acquire() {
+        WorkingSetPool* pool = workingSetPool.get();
+        if (NULL == pool || pool->_free.empty()) {
+            return new WorkingSet();
+        }
+
+        WorkingSet* ws = pool->_free.back();
+        pool->_free.pop_back();
+        return ws;
+    }
+
+    // static
+    void WorkingSet::release(WorkingSet* ws) {
+        if (NULL == ws) {
+            return;
+        }
+
+        if (ws->_blocks.size() * kMembersPerBlock > kMaxPooledMembers) {
+            delete ws;
+            return;
+        }
+
+        WorkingSetPool* pool = workingSetPool.get();
+        if (NULL == pool) {
+            pool = new WorkingSetPool();
+            workingSetPool.reset(pool);
+        }
+
+        if (pool->_free.size() >= kMaxPooledWorkingSets) {
+            delete ws;
+            return;
         }
+
+        ws->clear();
+        pool->_free.push_back(ws);
     }
 
     WorkingSetID WorkingSet::allocate() {
         if (_freeList == INVALID_ID) {
-            // The free list is empty so we need to make a single new WSM to return. This relies on
+            // The free list is empty so we need to hand out a new WSM. This relies on
             // vector::resize being amortized O(1) for efficient allocation. Note that the free list
             // remains empty until something is returned by a call to free().
             WorkingSetID id = _data.size();
+            if (id / kMembersPerBlock == _blocks.size()) {
+                _blocks.push_back(new WorkingSetMember[kMembersPerBlock]);
+            }
             _data.resize(_data.size() + 1);
             _data.back().nextFreeOrSelf = id;
-            _data.back().member = new WorkingSetMember();
+            _data.back().member = &_blocks[id / kMembersPerBlock][id % kMembersPerBlock];
             return id;
         }
 
@@ -90,8 +159,11 @@ namespace mongo {
     }
 
     void WorkingSet::clear() {
+        // Members on the free list were cleared when they were freed.
         for (size_t i = 0; i < _data.size(); i++) {
-            delete _data[i].member;
+            if (_data[i].nextFreeOrSelf == i) {
+                _data[i].member->clear();
+            }
         }
         _data.clear();
 
@@ -182,6 +254,7 @@ namespace mongo {
 
         keyData.clear();
         obj = BSONObj();
+        _fetcher.reset();
         state = WorkingSetMember::INVALID;
     }
 
@@ -62,6 +62,19 @@ namespace mongo {
         WorkingSet();
         ~WorkingSet();
 
+        /**
+         * Returns an empty WorkingSet owned by the caller. Reuses one given to release() on this
+         * thread if there is one, so that its members don't have to be allocated again.
+         */
+        static WorkingSet* acquire();
+
+        /**
+         * Takes ownership of 'ws', which can have been created any way. Clears it and keeps it
+         * for acquire() on this thread, unless this thread keeps enough WorkingSets already or
+         * 'ws' has grown too large to be worth keeping, in which case it is deleted.
+         */
+        static void release(WorkingSet* ws);
+
         /**
          * Allocate a new query result and return the ID used to get and free it.
          */
@@ -104,7 +117,7 @@ namespace mongo {
         const unordered_set<WorkingSetID>& getFlagged() const;
 
         /**
-         * Removes and deallocates all members of this working set.
+         * Removes all members of this working set. Their memory is kept for reuse by allocate().
          */
         void clear();
 
@@ -174,6 +187,12 @@ namespace mongo {
 
         // All WorkingSetIDs are indexes into this, except for INVALID_ID.
         // Elements are added to _freeList rather than removed when freed.
+        // Members come out of blocks of kMembersPerBlock, so allocating a new one is usually not
+        // a trip to the allocator. The member with id 'i' is always element 'i % kMembersPerBlock'
+        // of block 'i / kMembersPerBlock', and blocks live as long as the WorkingSet does.
+        static const size_t kMembersPerBlock = 16;
+        std::vector<WorkingSetMember*> _blocks;
+
         std::vector<MemberHolder> _data;
 
         // Index into _data, forming a linked-list using MemberHolder::nextFreeOrSelf as the next
@@ -243,4 +243,71 @@ namespace {
         ASSERT_EQ(counter, 1);
     }
 
+    //
+    // Member recycling tests
+    //
+
+    TEST(WorkingSetRecyclingTest, ClearKeepsMembers) {
+        WorkingSet ws;
+
+        // Enough members to take more than one block.
+        std::vector<WorkingSetMember*> members;
+        for (int i = 0; i < 40; ++i) {
+            WorkingSetID id = ws.allocate();
+            ASSERT_EQUALS(static_cast<WorkingSetID>(i), id);
+            WorkingSetMember* member = ws.get(id);
+            member->state = WorkingSetMember::OWNED_OBJ;
+            member->obj = BSON("a" << i);
+            member->keyData.push_back(IndexKeyDatum(BSON("a" << 1), BSON("" << i)));
+            members.push_back(member);
+        }
+        ws.free(7);
+
+        ws.clear();
+        ASSERT(ws.begin() == ws.end());
+
+        // The same members come back, cleared.
+        for (int i = 0; i < 40; ++i) {
+            WorkingSetID id = ws.allocate();
+            ASSERT_EQUALS(static_cast<WorkingSetID>(i), id);
+            WorkingSetMember* member = ws.get(id);
+            ASSERT_EQUALS(members[i], member);
+            ASSERT_EQUALS(WorkingSetMember::INVALID, member->state);
+            ASSERT(member->obj.isEmpty());
+            ASSERT(member->keyData.empty());
+            ASSERT_FALSE(member->hasFetcher());
+        }
+    }
+
+    TEST(WorkingSetRecyclingTest, ReleasedWorkingSetIsReused) {
+        WorkingSet* ws = WorkingSet::acquire();
+        WorkingSetID id = ws->allocate();
+        ws->get(id)->state = WorkingSetMember::OWNED_OBJ;
+        ws->get(id)->obj = BSON("a" << 1);
+        WorkingSet::release(ws);
+
+        WorkingSet* reused = WorkingSet::acquire();
+        ASSERT_EQUALS(ws, reused);
+        ASSERT(reused->begin() == reused->end());
+        WorkingSetID reusedId = reused->allocate();
+        ASSERT_EQUALS(WorkingSetMember::INVALID, reused->get(reusedId)->state);
+        WorkingSet::release(reused);
+    }
+
+    TEST(WorkingSetRecyclingTest, LargeWorkingSetIsNotReused) {
+        WorkingSet* small = WorkingSet::acquire();
+        WorkingSet* large = WorkingSet::acquire();
+        small->allocate();
+        for (int i = 0; i < 1000; ++i) {
+            large->allocate();
+        }
+        WorkingSet::release(small);
+        WorkingSet::release(large);
+
+        // Had 'large' been kept, it would be handed out first.
+        WorkingSet* reused = WorkingSet::acquire();
+        ASSERT_EQUALS(small, reused);
+        WorkingSet::release(reused);
+    }
+
 }  // namespace
@@ -0,0 +1,116 @@
+// fts_bench.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <string>
+
+#include "mongo/db/fts/fts_spec.h"
+#include "mongo/db/fts/stemmer.h"
+#include "mongo/db/fts/tokenizer.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/benchmark.h"
+
+namespace mongo {
+namespace fts {
+namespace {
+
+    using unittest::doNotOptimizeAway;
+
+    const char* const kWords[] = {
+        "the", "running", "of", "indexes", "and", "a", "document", "searching", "to", "text",
+        "in", "queries", "stemmed", "is", "collections", "that", "for", "language", "words",
+        "on", "building", "with", "terms", "scoring", "as", "phrases", "by", "weights",
+    };
+    const size_t kNumWords = sizeof(kWords) / sizeof(kWords[0]);
+
+    /**
+     * Text with roughly Zipfian word frequencies: the i-th word appears about 1/i as often as
+     * the first.
+     */
+    std::string makeText(size_t numWords) {
+        std::string text;
+        unsigned seed = 1;
+        for (size_t i = 0; i < numWords; i++) {
+            seed = seed * 1103515245 + 12345;
+            size_t rank = (seed >> 16) % kNumWords + 1;
+            text += kWords[((seed >> 8) & 0xff) % rank];
+            text += (i % 12 == 11) ? ". " : " ";
+        }
+        return text;
+    }
+
+    BENCHMARK(FTS, Tokenize) {
+        const std::string text = makeText(1000);
+        while (state.keepRunning()) {
+            Tokenizer tokenizer(languageEnglishV2, text);
+            unsigned numTokens = 0;
+            while (tokenizer.more()) {
+                numTokens += tokenizer.next().type == Token::TEXT;
+            }
+            doNotOptimizeAway(numTokens);
+        }
+    }
+
+    BENCHMARK(FTS, StemRepeatedWords) {
+        Stemmer stemmer(languageEnglishV2);
+        size_t i = 0;
+        while (state.keepRunning()) {
+            doNotOptimizeAway(stemmer.stem(kWords[i++ % kNumWords]));
+        }
+    }
+
+    BENCHMARK(FTS, StemDistinctWords) {
+        Stemmer stemmer(languageEnglishV2);
+        std::string word = "running";
+        unsigned i = 0;
+        while (state.keepRunning()) {
+            word.resize(7);
+            word += static_cast<char>('a' + i % 26);
+            word += static_cast<char>('a' + (i / 26) % 26);
+            word += static_cast<char>('a' + (i / 676) % 26);
+            i++;
+            doNotOptimizeAway(stemmer.stem(word));
+        }
+    }
+
+    BENCHMARK(FTS, ScoreDocument) {
+        const FTSSpec spec(FTSSpec::fixSpec(BSON("key" << BSON("text" << "text"))));
+        const BSONObj doc = BSON("text" << makeText(200));
+        while (state.keepRunning()) {
+            TermFrequencyMap scores;
+            spec.scoreDocument(doc, &scores);
+            doNotOptimizeAway(scores.size());
+        }
+    }
+
+}  // namespace
+}  // namespace fts
+}  // namespace mongo
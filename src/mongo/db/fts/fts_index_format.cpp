@@ -60,6 +60,14 @@ namespace mongo {
             const size_t termKeySuffixLength = 32U;
             const size_t termKeyLength = termKeyPrefixLength + termKeySuffixLength;
 
+            // For indexes with term positions, the most positions kept in the key of a term.
+            // The key of a term appearing more often holds an empty array instead, and phrases
+            // with it are checked against the document.
+            const size_t maxIndexedTermPositions = 16U;
+            // Upper bound on the size of the positions array: its element, then per position an
+            // int element named by up to two digits.
+            const int maxTermPositionsSize = 7 + 8 * maxIndexedTermPositions;
+
             /**
              * Returns size of buffer required to store term in index key.
              * In version 1, terms are stored verbatim in key.
@@ -118,6 +126,11 @@ namespace mongo {
             TermFrequencyMap term_freqs;
             spec.scoreDocument( obj, &term_freqs );
 
+            TermPositionsMap termPositions;
+            if ( spec.termPositions() ) {
+                spec.getTermPositions( obj, &termPositions );
+            }
+
             // create index keys from raw scores
             // only 1 per string
 
@@ -141,6 +154,7 @@ namespace mongo {
                     8 /* term overhead */ +
                     /* term size (could be truncated/hashed) */
                     guessTermSize( term, spec.getTextIndexVersion() ) +
+                    ( spec.termPositions() ? maxTermPositionsSize : 0 ) +
                     extraSize;
 
                 BSONObjBuilder b(guess); // builds a BSON object with guess length.
@@ -148,6 +162,9 @@ namespace mongo {
                     b.appendAs( extrasBefore[k], "" );
                 }
                 _appendIndexKey( b, weight, term, spec.getTextIndexVersion() );
+                if ( spec.termPositions() ) {
+                    _appendTermPositions( b, termPositions[term] );
+                }
                 for ( unsigned k = 0; k < extrasAfter.size(); k++ ) {
                     b.appendAs( extrasAfter[k], "" );
                 }
@@ -182,6 +199,17 @@ namespace mongo {
             return b.obj();
         }
 
+        void FTSIndexFormat::_appendTermPositions( BSONObjBuilder& b,
+                                                   const std::vector<unsigned>& positions ) {
+            BSONArrayBuilder arr( b.subarrayStart( "" ) );
+            if ( positions.size() <= maxIndexedTermPositions ) {
+                for ( size_t i = 0; i < positions.size(); i++ ) {
+                    arr.append( static_cast<int>( positions[i] ) );
+                }
+            }
+            arr.done();
+        }
+
         void FTSIndexFormat::_appendIndexKey( BSONObjBuilder& b, double weight, const string& term,
                                               TextIndexVersion textIndexVersion ) {
             verify( weight >= 0 && weight <= MAX_WEIGHT ); // FTSmaxweight =  defined in fts_header
@@ -65,6 +65,15 @@ namespace mongo {
              */
             static void _appendIndexKey( BSONObjBuilder& b, double weight, const std::string& term,
                                          TextIndexVersion textIndexVersion );
+
+            /*
+             * Helper method to append the positions of a term to an index entry, for indexes
+             * with term positions.  Too many positions are replaced by an empty array.
+             * @param b, reference to the BSONOBjBuilder
+             * @param positions, the ascending positions of the term in the document
+             */
+            static void _appendTermPositions( BSONObjBuilder& b,
+                                              const std::vector<unsigned>& positions );
         };
 
     }
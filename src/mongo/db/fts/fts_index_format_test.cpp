@@ -76,6 +76,50 @@ namespace mongo {
             ASSERT_EQUALS( 5, i.next().numberInt() );
         }
 
+        TEST( FTSIndexFormat, TermPositions1 ) {
+            FTSSpec spec( FTSSpec::fixSpec( BSON( "key" << BSON( "data" << "text" <<
+                                                                 "x" << 1 ) <<
+                                                  "termPositions" << true ) ) );
+            BSONObjSet keys;
+            FTSIndexFormat::getKeys( spec, BSON( "data" << "cat sat cat" << "x" << 5 ), &keys );
+
+            ASSERT_EQUALS( 2U, keys.size() );
+            for ( BSONObjSet::const_iterator it = keys.begin(); it != keys.end(); ++it ) {
+                BSONObjIterator i( *it );
+                string term = i.next().str();
+                ASSERT( i.next().numberDouble() > 0 );
+                BSONElement positions = i.next();
+                ASSERT_EQUALS( Array, positions.type() );
+                if ( term == "cat" ) {
+                    ASSERT_EQUALS( BSON_ARRAY( 0 << 2 ), positions.Obj() );
+                }
+                else {
+                    ASSERT_EQUALS( "sat", term );
+                    ASSERT_EQUALS( BSON_ARRAY( 1 ), positions.Obj() );
+                }
+                ASSERT_EQUALS( 5, i.next().numberInt() );
+            }
+        }
+
+        TEST( FTSIndexFormat, TermPositionsTooMany ) {
+            FTSSpec spec( FTSSpec::fixSpec( BSON( "key" << BSON( "data" << "text" ) <<
+                                                  "termPositions" << true ) ) );
+            string text;
+            for ( int i = 0; i < 100; i++ ) {
+                text += "cat ";
+            }
+            BSONObjSet keys;
+            FTSIndexFormat::getKeys( spec, BSON( "data" << text ), &keys );
+
+            ASSERT_EQUALS( 1U, keys.size() );
+            BSONObjIterator i( *keys.begin() );
+            i.next();
+            i.next();
+            BSONElement positions = i.next();
+            ASSERT_EQUALS( Array, positions.type() );
+            ASSERT( positions.Obj().isEmpty() );
+        }
+
         /*
         TEST( FTSIndexFormat, ExtraBackArray1 ) {
             FTSSpec spec( FTSSpec::fixSpec( BSON( "key" << BSON( "data" << "text" <<
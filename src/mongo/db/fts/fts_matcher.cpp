@@ -41,9 +41,65 @@ namespace mongo {
 
     namespace fts {
 
+        namespace {
+            /**
+             * Returns true if the ascending array of positions 'positions' holds 'position'.
+             */
+            bool hasPosition( const BSONObj& positions, long long position ) {
+                BSONObjIterator it( positions );
+                while ( it.more() ) {
+                    long long next = it.next().numberLong();
+                    if ( next >= position ) {
+                        return next == position;
+                    }
+                }
+                return false;
+            }
+        }
+
         FTSMatcher::FTSMatcher( const FTSQuery& query, const FTSSpec& spec )
             : _query( query ),
               _spec( spec ) {
+
+            if ( !_spec.termPositions() ) {
+                return;
+            }
+
+            // Split the phrases into words the way the query's terms were.
+            const FTSLanguage& language = _query.getLanguage();
+            const StopWords* stopWords = StopWords::getStopWords( language );
+            Stemmer stemmer( language );
+            const vector<string>& terms = _query.getTerms();
+
+            _phraseWords.resize( _query.getPhr().size() );
+            for ( size_t i = 0; i < _query.getPhr().size(); i++ ) {
+                vector<PhraseWord>& words = _phraseWords[i];
+
+                unsigned offset = 0;
+                Tokenizer tokenizer( language, _query.getPhr()[i] );
+                while ( tokenizer.more() ) {
+                    Token t = tokenizer.next();
+                    if ( t.type != Token::TEXT )
+                        continue;
+
+                    string word = tolowerString( t.data );
+                    if ( !stopWords->isStopWord( word ) ) {
+                        vector<string>::const_iterator term =
+                            std::find( terms.begin(), terms.end(), stemmer.stem( word ) );
+                        if ( term == terms.end() ) {
+                            words.clear();
+                            break;
+                        }
+                        words.push_back( PhraseWord( term - terms.begin(), offset ) );
+                    }
+                    offset++;
+                }
+
+                // Longer phrases could seem to run from one string into the next.
+                if ( offset > TERM_POSITIONS_GAP ) {
+                    words.clear();
+                }
+            }
         }
 
         /*
@@ -107,6 +163,51 @@ namespace mongo {
             return true;
         }
 
+        bool FTSMatcher::phrasesMayMatch( const vector<BSONObj>& positions ) const {
+            for ( size_t i = 0; i < _phraseWords.size(); i++ ) {
+                if ( !_phraseMayMatchPositions( i, positions ) ) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool FTSMatcher::_phraseMayMatchPositions( size_t phrase,
+                                                   const vector<BSONObj>& positions ) const {
+            if ( phrase >= _phraseWords.size() || _phraseWords[phrase].empty() ) {
+                return true;
+            }
+            const vector<PhraseWord>& words = _phraseWords[phrase];
+
+            // Every word must be in the document, with its positions known.
+            vector<BSONObj> wordPositions;
+            for ( size_t i = 0; i < words.size(); i++ ) {
+                if ( words[i].first >= positions.size() || positions[words[i].first].isEmpty() ) {
+                    return false;
+                }
+                BSONObj termPositions = positions[words[i].first].firstElement().Obj();
+                if ( termPositions.isEmpty() ) {
+                    return true;
+                }
+                wordPositions.push_back( termPositions );
+            }
+
+            // Try each place the first word appears as the start of the phrase.
+            BSONObjIterator it( wordPositions[0] );
+            while ( it.more() ) {
+                long long start = it.next().numberLong() - words[0].second;
+                bool matched = true;
+                for ( size_t i = 1; i < words.size() && matched; i++ ) {
+                    matched = hasPosition( wordPositions[i], start + words[i].second );
+                }
+                if ( matched ) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
         /**
          * Checks if phrase is exactly matched in obj, returns true if so, false otherwise
          * @param phrase, the string to be matched
@@ -58,7 +58,28 @@ namespace mongo {
                 return !hasNegativeTerm( obj ) && phrasesMatch( obj );
             }
 
+            /**
+             * For indexes with term positions.  'positions' holds, for each of the query's
+             * terms, the positions element from a document's index key for the term wrapped in
+             * an object, or an empty object if the document has no key for the term.
+             *
+             * A phrase can only be in the document if its words, stop words aside, appear in
+             * that order in one of the document's strings.  Phrases too common or too long to
+             * tell from the positions are let through.  A true result still needs checking with
+             * matchesNonTerm() once the document is fetched.
+             *
+             * @return false if the positions show that a phrase is missing from the document,
+             *         without needing the document
+             */
+            bool phrasesMayMatch( const std::vector<BSONObj>& positions ) const;
+
         private:
+            /**
+             * Checks the phrase _query.getPhr()[phrase] against term positions.
+             */
+            bool _phraseMayMatchPositions( size_t phrase,
+                                           const std::vector<BSONObj>& positions ) const;
+
             /**
              * @return true if raw has a negated term
              */
@@ -71,6 +92,14 @@ namespace mongo {
 
             FTSQuery _query;
             FTSSpec  _spec;
+
+            // A word of a phrase, as its index in the query's terms and its offset from the
+            // start of the phrase.
+            typedef std::pair<size_t, unsigned> PhraseWord;
+
+            // For indexes with term positions, the words to look for in term positions for each
+            // phrase, or none if the phrase can only be checked against the document.
+            std::vector<std::vector<PhraseWord> > _phraseWords;
         };
 
     }
@@ -85,6 +85,81 @@ namespace mongo {
                                    BSON( "x" << BSON_ARRAY( "table top" ) ) ) );
         }
 
+        namespace {
+            /**
+             * The positions the text stage would collect from the index keys of 'doc' for the
+             * terms of 'q'.
+             */
+            std::vector<BSONObj> termPositions( const FTSSpec& spec,
+                                                const FTSQuery& q,
+                                                const BSONObj& doc ) {
+                TermPositionsMap m;
+                spec.getTermPositions( doc, &m );
+
+                std::vector<BSONObj> positions( q.getTerms().size() );
+                for ( size_t i = 0; i < q.getTerms().size(); i++ ) {
+                    TermPositionsMap::const_iterator it = m.find( q.getTerms()[i] );
+                    if ( it == m.end() ) {
+                        continue;
+                    }
+                    BSONArrayBuilder arr;
+                    if ( it->second.size() <= 16 ) {
+                        for ( size_t j = 0; j < it->second.size(); j++ ) {
+                            arr.append( static_cast<int>( it->second[j] ) );
+                        }
+                    }
+                    positions[i] = BSON( "" << arr.arr() );
+                }
+                return positions;
+            }
+        }
+
+        TEST( FTSMatcher, PhrasePositions1 ) {
+            FTSQuery q;
+            ASSERT_OK( q.parse( "foo \"the table top\"", "english", TEXT_INDEX_VERSION_2 ) );
+            FTSSpec spec( FTSSpec::fixSpec( BSON( "key" << BSON( "x" << "text" ) <<
+                                                  "termPositions" << true ) ) );
+            FTSMatcher m( q, spec );
+
+            BSONObj matches = BSON( "x" << "foo on the table top" );
+            ASSERT( m.phrasesMayMatch( termPositions( spec, q, matches ) ) );
+            ASSERT( m.matchesNonTerm( matches ) );
+
+            BSONObj apart = BSON( "x" << "foo on the table and top" );
+            ASSERT( !m.phrasesMayMatch( termPositions( spec, q, apart ) ) );
+
+            BSONObj reversed = BSON( "x" << "foo on the top table" );
+            ASSERT( !m.phrasesMayMatch( termPositions( spec, q, reversed ) ) );
+
+            BSONObj missing = BSON( "x" << "foo table" );
+            ASSERT( !m.phrasesMayMatch( termPositions( spec, q, missing ) ) );
+
+            // A phrase can't run from one string into the next.
+            BSONObj split = BSON( "x" << BSON_ARRAY( "foo table" << "top" ) );
+            ASSERT( !m.phrasesMayMatch( termPositions( spec, q, split ) ) );
+        }
+
+        TEST( FTSMatcher, PhrasePositionsUnknown ) {
+            FTSQuery q;
+            ASSERT_OK( q.parse( "\"table top\"", "english", TEXT_INDEX_VERSION_2 ) );
+            FTSSpec spec( FTSSpec::fixSpec( BSON( "key" << BSON( "x" << "text" ) <<
+                                                  "termPositions" << true ) ) );
+            FTSMatcher m( q, spec );
+
+            // Too many positions to keep for "table", so the document decides.
+            string text;
+            for ( int i = 0; i < 20; i++ ) {
+                text += "table ";
+            }
+            BSONObj withPhrase = BSON( "x" << text + "top" );
+            ASSERT( m.phrasesMayMatch( termPositions( spec, q, withPhrase ) ) );
+            ASSERT( m.matchesNonTerm( withPhrase ) );
+
+            BSONObj withoutPhrase = BSON( "x" << text + "and top" );
+            ASSERT( m.phrasesMayMatch( termPositions( spec, q, withoutPhrase ) ) );
+            ASSERT( !m.matchesNonTerm( withoutPhrase ) );
+        }
+
         // Test that the matcher parses the document with the document language, not the search
         // language.
         TEST( FTSMatcher, ParsesUsingDocLanguage ) {
@@ -49,6 +49,7 @@ namespace mongo {
         const double DEFAULT_WEIGHT = 1;
         const double MAX_WEIGHT = 1000000000;
         const double MAX_WORD_WEIGHT = MAX_WEIGHT / 10000;
+        const unsigned TERM_POSITIONS_GAP = 1024;
 
         namespace {
             // Default language.  Used for new indexes.
@@ -99,6 +100,8 @@ namespace mongo {
 
             _wildcard = false;
 
+            _termPositions = indexInfo["termPositions"].trueValue();
+
             // in this block we fill in the _weights map
             {
                 BSONObjIterator i( indexInfo["weights"].Obj() );
@@ -129,7 +132,8 @@ namespace mongo {
                 while ( i.more() ) {
                     BSONElement e = i.next();
                     if ( str::equals( e.fieldName(), "_fts" ) ||
-                         str::equals( e.fieldName(), "_ftsx" ) ) {
+                         str::equals( e.fieldName(), "_ftsx" ) ||
+                         str::equals( e.fieldName(), "_ftsp" ) ) {
                         passedFTS = true;
                         continue;
                     }
@@ -174,6 +178,36 @@ namespace mongo {
             }
         }
 
+        void FTSSpec::getTermPositions( const BSONObj& obj, TermPositionsMap* positions ) const {
+            invariant( _textIndexVersion == TEXT_INDEX_VERSION_2 );
+
+            FTSElementIterator it( *this, obj );
+
+            unsigned start = 0;
+            while ( it.more() ) {
+                FTSIteratorValue val = it.next();
+                Stemmer stemmer( *val._language );
+                const StopWords* stopwords = StopWords::getStopWords( *val._language );
+
+                unsigned position = start;
+                Tokenizer i( *val._language, val._text );
+                while ( i.more() ) {
+                    Token t = i.next();
+                    if ( t.type != Token::TEXT )
+                        continue;
+
+                    string term = t.data.toString();
+                    makeLower( &term );
+                    if ( !stopwords->isStopWord( term ) ) {
+                        (*positions)[stemmer.stem( term )].push_back( position );
+                    }
+                    position++;
+                }
+
+                start = position + TERM_POSITIONS_GAP;
+            }
+        }
+
         void FTSSpec::_scoreStringV2( const Tools& tools,
                                       const StringData& raw,
                                       TermFrequencyMap* docScores,
@@ -261,20 +295,32 @@ namespace mongo {
         }
 
         namespace {
-            void _addFTSStuff( BSONObjBuilder* b ) {
+            void _addFTSStuff( BSONObjBuilder* b, bool termPositions ) {
                 b->append( "_fts", INDEX_NAME );
                 b->append( "_ftsx", 1 );
+                if ( termPositions ) {
+                    b->append( "_ftsp", 1 );
+                }
             }
 
             void verifyFieldNameNotReserved( StringData s ) {
                 uassert( 17289,
-                         "text index with reserved fields _fts/_ftsx not allowed",
-                         s != "_fts" && s != "_ftsx" );
+                         "text index with reserved fields _fts/_ftsx/_ftsp not allowed",
+                         s != "_fts" && s != "_ftsx" && s != "_ftsp" );
             }
         }
 
         BSONObj FTSSpec::fixSpec( const BSONObj& spec ) {
+            BSONElement termPositionsElt = spec["termPositions"];
+            uassert( 28624,
+                     "text index option 'termPositions' must be a boolean",
+                     termPositionsElt.eoo() || termPositionsElt.type() == Bool );
+            const bool termPositions = termPositionsElt.trueValue();
+
             if ( spec["textIndexVersion"].numberInt() == TEXT_INDEX_VERSION_1 ) {
+                uassert( 28625,
+                         "text index option 'termPositions' requires textIndexVersion 2",
+                         !termPositions );
                 return _fixSpecV1( spec );
             }
 
@@ -301,10 +347,14 @@ namespace mongo {
                             uassert( 17272, "expecting _ftsx:1", e.numberInt() == 1 );
                             b.append( e );
                         }
+                        else if ( str::equals( e.fieldName(), "_ftsp" ) ) {
+                            uassert( 28626, "expecting _ftsp:1", e.numberInt() == 1 );
+                            b.append( e );
+                        }
                         else if ( e.type() == String && INDEX_NAME == e.valuestr() ) {
 
                             if ( !addedFtsStuff ) {
-                                _addFTSStuff( &b );
+                                _addFTSStuff( &b, termPositions );
                                 addedFtsStuff = true;
                             }
 
@@ -344,6 +394,14 @@ namespace mongo {
                                  "expected _ftsx after _fts",
                                  str::equals( e.fieldName(), "_ftsx" ) );
                         e = i.next();
+
+                        const bool hasPositionsField = str::equals( e.fieldName(), "_ftsp" );
+                        uassert( 28627,
+                                 "expected _ftsp after _ftsx exactly when termPositions is set",
+                                 hasPositionsField == termPositions );
+                        if ( hasPositionsField ) {
+                            e = i.next();
+                        }
                     }
                     else {
                         do {
@@ -49,8 +49,13 @@ namespace mongo {
         extern const double MAX_WORD_WEIGHT;
         extern const double DEFAULT_WEIGHT;
 
+        // Added to the term positions of each string in a document after the first, so that no
+        // phrase of up to this many words can seem to run from one string into the next.
+        extern const unsigned TERM_POSITIONS_GAP;
+
         typedef std::map<std::string,double> Weights; // TODO cool map
         typedef unordered_map<std::string,double> TermFrequencyMap;
+        typedef unordered_map<std::string,std::vector<unsigned> > TermPositionsMap;
 
         struct ScoreHelperStruct {
             ScoreHelperStruct()
@@ -90,6 +95,12 @@ namespace mongo {
             size_t numExtraAfter() const { return _extraAfter.size(); }
             const std::string& extraAfter( unsigned i ) const { return _extraAfter[i]; }
 
+            /**
+             * True if the index was built with { termPositions: true }, so that its keys also hold
+             * where in the document each term appears.
+             */
+            bool termPositions() const { return _termPositions; }
+
             /**
              * Calculates term/score pairs for a BSONObj as applied to this spec.
              * @arg obj  document to traverse; can be a subdocument or array
@@ -97,6 +108,16 @@ namespace mongo {
              */
             void scoreDocument( const BSONObj& obj, TermFrequencyMap* term_freqs ) const;
 
+            /**
+             * Calculates the positions of each term in a BSONObj as applied to this spec: the
+             * number of words, stop words included, before each occurrence of the term, counting
+             * through the document's strings in the order they are scored.  Only for
+             * TEXT_INDEX_VERSION_2 specs.
+             * @arg obj  document to traverse; can be a subdocument or array
+             * @arg positions  output parameter to store (term,ascending positions) results
+             */
+            void getTermPositions( const BSONObj& obj, TermPositionsMap* positions ) const;
+
             /**
              * given a query, pulls out the pieces (in order) that go in the index first
              */
@@ -163,6 +184,7 @@ namespace mongo {
             const FTSLanguage* _defaultLanguage;
             std::string _languageOverrideField;
             bool _wildcard;
+            bool _termPositions;
 
             // mapping : fieldname -> weight
             Weights _weights;
@@ -181,6 +181,50 @@ namespace mongo {
             assertFixFailure("{key: {a: 'text'}, textIndexVersion: {}}");
         }
 
+        TEST( FTSSpec, FixTermPositions1 ) {
+            assertFixSuccess("{key: {a: 'text'}, termPositions: true}");
+            assertFixSuccess("{key: {a: 'text'}, termPositions: false}");
+            assertFixSuccess("{key: {a: 1, b: 'text', c: 1}, termPositions: true}");
+            assertFixSuccess("{key: {a: 'text'}, termPositions: true, textIndexVersion: 2}");
+
+            assertFixFailure("{key: {a: 'text'}, termPositions: 1}");
+            assertFixFailure("{key: {a: 'text'}, termPositions: true, textIndexVersion: 1}");
+            assertFixFailure("{key: {a: 'text', _ftsp: 1}}");
+            assertFixFailure("{key: {_fts: 'text', _ftsx: 1, _ftsp: 1}}");
+            assertFixFailure("{key: {_fts: 'text', _ftsx: 1}, termPositions: true}");
+
+            BSONObj fixed = FTSSpec::fixSpec( fromjson( "{key: {a: 1, b: 'text', c: 1}, "
+                                                        "termPositions: true}" ) );
+            ASSERT_EQUALS( fromjson( "{a: 1, _fts: 'text', _ftsx: 1, _ftsp: 1, c: 1}" ),
+                           fixed["key"].Obj() );
+            FTSSpec spec( fixed );
+            ASSERT( spec.termPositions() );
+            ASSERT_EQUALS( 1U, spec.numExtraBefore() );
+            ASSERT_EQUALS( 1U, spec.numExtraAfter() );
+
+            // Fixing is idempotent.
+            ASSERT_EQUALS( fixed, FTSSpec::fixSpec( fixed ) );
+        }
+
+        TEST( FTSSpec, TermPositions1 ) {
+            FTSSpec spec( FTSSpec::fixSpec( fromjson( "{key: {a: 'text', b: 'text'}, "
+                                                      "termPositions: true}" ) ) );
+
+            TermPositionsMap m;
+            spec.getTermPositions( fromjson( "{a: 'the cat sat on the cat', b: 'cat'}" ), &m );
+            ASSERT_EQUALS( 2U, m.size() );
+
+            // Stop words take up positions but aren't indexed.
+            ASSERT_EQUALS( 1U, m["sat"].size() );
+            ASSERT_EQUALS( 2U, m["sat"][0] );
+
+            // The second string's positions start past the gap after the first's.
+            ASSERT_EQUALS( 3U, m["cat"].size() );
+            ASSERT_EQUALS( 1U, m["cat"][0] );
+            ASSERT_EQUALS( 5U, m["cat"][1] );
+            ASSERT_EQUALS( 6U + TERM_POSITIONS_GAP, m["cat"][2] );
+        }
+
         TEST( FTSSpec, ScoreSingleField1 ) {
             BSONObj user = BSON( "key" << BSON( "title" << "text" <<
                                                 "text" << "text" ) <<
@@ -28,43 +28,135 @@
 *    it in the license file.
 */
 
+#include <boost/thread/tss.hpp>
 #include <cstdlib>
+#include <list>
+#include <map>
 #include <string>
 
 #include "mongo/db/fts/stemmer.h"
+#include "mongo/platform/unordered_map.h"
 #include "mongo/util/mongoutils/str.h"
+#include "third_party/libstemmer_c/include/libstemmer.h"
 
 namespace mongo {
 
     namespace fts {
 
-        Stemmer::Stemmer( const FTSLanguage& language ) {
-            _stemmer = NULL;
-            if ( language.str() != "none" )
-                _stemmer = sb_stemmer_new(language.str().c_str(), "UTF_8");
+        namespace {
+            // Most words stemmed per language per thread that are remembered.  Word frequencies
+            // are very skewed, so a few thousand cover most of the words in typical text.
+            const size_t kMaxCachedStems = 4096;
+
+            // Longer words are rare enough not to be worth caching.
+            const size_t kMaxCachedWordSize = 32;
         }
 
-        Stemmer::~Stemmer() {
-            if ( _stemmer ) {
-                sb_stemmer_delete(_stemmer);
-                _stemmer = NULL;
+        /**
+         * A libstemmer stemmer for one language, with the stems of the words it most recently
+         * stemmed.  Not thread safe; one per language per thread.
+         */
+        class StemCache {
+        public:
+            explicit StemCache( const FTSLanguage& language )
+                : _stemmer( sb_stemmer_new( language.str().c_str(), "UTF_8" ) ) {
             }
-        }
 
-        string Stemmer::stem( const StringData& word ) const {
-            if ( !_stemmer )
-                return word.toString();
+            ~StemCache() {
+                if ( _stemmer ) {
+                    sb_stemmer_delete( _stemmer );
+                }
+            }
+
+            std::string stem( const StringData& word ) {
+                if ( !_stemmer )
+                    return word.toString();
+
+                if ( word.size() > kMaxCachedWordSize ) {
+                    return _stem( word );
+                }
+
+                std::string key = word.toString();
+                Index::iterator it = _index.find( key );
+                if ( it != _index.end() ) {
+                    // Move to the front, as the most recently used.
+                    _lru.splice( _lru.begin(), _lru, it->second );
+                    return it->second->second;
+                }
+
+                if ( _index.size() >= kMaxCachedStems ) {
+                    _index.erase( _lru.back().first );
+                    _lru.pop_back();
+                }
+                _lru.push_front( Entry( key, _stem( word ) ) );
+                _index[key] = _lru.begin();
+                return _lru.front().second;
+            }
+
+        private:
+            typedef std::pair<std::string, std::string> Entry; // word, stem
+            typedef std::list<Entry> LRUList;
+            typedef unordered_map<std::string, LRUList::iterator> Index;
+
+            std::string _stem( const StringData& word ) {
+                const sb_symbol* sb_sym = sb_stemmer_stem( _stemmer,
+                                                           (const sb_symbol*)word.rawData(),
+                                                           word.size() );
+
+                if ( sb_sym == NULL ) {
+                    // out of memory
+                    abort();
+                }
 
-            const sb_symbol* sb_sym = sb_stemmer_stem( _stemmer,
-                                                       (const sb_symbol*)word.rawData(),
-                                                       word.size() );
+                return std::string( (const char*)(sb_sym), sb_stemmer_length( _stemmer ) );
+            }
+
+            struct sb_stemmer* const _stemmer;
+            LRUList _lru; // most recently used first
+            Index _index;
+        };
+
+        namespace {
+            typedef std::map<const FTSLanguage*, StemCache*> StemCacheMap;
+
+            struct ThreadStemCaches {
+                ~ThreadStemCaches() {
+                    for ( StemCacheMap::iterator it = caches.begin(); it != caches.end(); ++it ) {
+                        delete it->second;
+                    }
+                }
 
-            if ( sb_sym == NULL ) {
-                // out of memory
-                abort();
+                StemCacheMap caches;
+            };
+
+            boost::thread_specific_ptr<ThreadStemCaches> threadStemCaches;
+
+            StemCache* getStemCache( const FTSLanguage& language ) {
+                ThreadStemCaches* threadCaches = threadStemCaches.get();
+                if ( !threadCaches ) {
+                    threadCaches = new ThreadStemCaches();
+                    threadStemCaches.reset( threadCaches );
+                }
+
+                StemCache*& cache = threadCaches->caches[&language];
+                if ( !cache ) {
+                    cache = new StemCache( language );
+                }
+                return cache;
             }
+        }
+
+        Stemmer::Stemmer( const FTSLanguage& language ) {
+            _cache = NULL;
+            if ( language.str() != "none" )
+                _cache = getStemCache( language );
+        }
+
+        string Stemmer::stem( const StringData& word ) const {
+            if ( !_cache )
+                return word.toString();
 
-            return string( (const char*)(sb_sym), sb_stemmer_length( _stemmer ) );
+            return _cache->stem( word );
         }
 
     }
@@ -35,25 +35,29 @@
 
 #include "mongo/base/string_data.h"
 #include "mongo/db/fts/fts_language.h"
-#include "third_party/libstemmer_c/include/libstemmer.h"
 
 namespace mongo {
 
     namespace fts {
 
+        class StemCache;
+
         /**
          * maintains case
          * but works
          * running/Running -> run/Run
+         *
+         * The libstemmer stemmer for each language, and the most recently stemmed words, are
+         * kept per thread and shared by the Stemmers made on it, so a Stemmer must only be used
+         * on the thread that constructed it.
          */
         class Stemmer {
         public:
             Stemmer( const FTSLanguage& language );
-            ~Stemmer();
 
             std::string stem( const StringData& word ) const;
         private:
-            struct sb_stemmer* _stemmer;
+            StemCache* _cache; // NULL for the "none" language
         };
     }
 }
@@ -49,5 +49,21 @@ namespace mongo {
             ASSERT_EQUALS( "Unite", s.stem( "United" ) );
         }
 
+        TEST( English, StemCache ) {
+            Stemmer english( languageEnglishV2 );
+            Stemmer porter( languagePorterV1 );
+
+            // Stem words again after enough others to push them out of the cache.
+            for ( int round = 0; round < 3; round++ ) {
+                ASSERT_EQUALS( "run", english.stem( "running" ) );
+                ASSERT_EQUALS( "Run", english.stem( "Running" ) );
+                ASSERT_EQUALS( "Unite", porter.stem( "United" ) );
+                for ( int i = 0; i < 10000; i++ ) {
+                    string number = BSONObjBuilder::numStr( i );
+                    ASSERT_EQUALS( number, english.stem( number ) );
+                }
+            }
+        }
+
     }
 }
@@ -38,9 +38,90 @@ namespace mongo {
 
     namespace fts {
 
+        namespace {
+            Token::Type charType( char c, bool english ) {
+                switch ( c ) {
+                case ' ':
+                case '\f':
+                case '\v':
+                case '\t':
+                case '\r':
+                case '\n':
+                    return Token::WHITESPACE;
+                case '\'':
+                    if ( english )
+                        return Token::TEXT;
+                    else
+                        return Token::WHITESPACE;
+
+                case '~':
+                case '`':
+
+                case '!':
+                case '@':
+                case '#':
+                case '$':
+                case '%':
+                case '^':
+                case '&':
+                case '*':
+                case '(':
+                case ')':
+
+                case '-':
+
+                case '=':
+                case '+':
+
+                case '[':
+                case ']':
+                case '{':
+                case '}':
+                case '|':
+                case '\\':
+
+                case ';':
+                case ':':
+
+                case '"':
+
+                case '<':
+                case '>':
+
+                case ',':
+                case '.':
+
+                case '/':
+                case '?':
+
+                    return Token::DELIMITER;
+                default:
+                    return Token::TEXT;
+                }
+            }
+
+            /**
+             * The token type of every byte, looked up once per byte of text rather than going
+             * through the switch above.  Bytes of multi-byte UTF-8 characters are all TEXT.
+             */
+            struct CharTypeTable {
+                explicit CharTypeTable( bool english ) {
+                    for ( int c = 0; c < 256; c++ ) {
+                        types[c] = charType( static_cast<char>( c ), english );
+                    }
+                }
+
+                Token::Type types[256];
+            };
+
+            const CharTypeTable englishCharTypes( true );
+            const CharTypeTable otherCharTypes( false );
+        }
+
         Tokenizer::Tokenizer( const FTSLanguage& language, const StringData& str )
             : _pos(0), _raw( str ) {
-            _english = ( language.str() == "english" );
+            _charTypes = ( language.str() == "english" ) ? englishCharTypes.types
+                                                         : otherCharTypes.types;
             _skipWhitespace();
             _previousWhiteSpace = true;
         }
@@ -75,68 +156,6 @@ namespace mongo {
             return _pos > start;
         }
 
-
-        Token::Type Tokenizer::_type( char c ) const {
-            switch ( c ) {
-            case ' ':
-            case '\f':
-            case '\v':
-            case '\t':
-            case '\r':
-            case '\n':
-                return Token::WHITESPACE;
-            case '\'':
-                if ( _english )
-                    return Token::TEXT;
-                else
-                    return Token::WHITESPACE;
-
-            case '~':
-            case '`':
-
-            case '!':
-            case '@':
-            case '#':
-            case '$':
-            case '%':
-            case '^':
-            case '&':
-            case '*':
-            case '(':
-            case ')':
-
-            case '-':
-
-            case '=':
-            case '+':
-
-            case '[':
-            case ']':
-            case '{':
-            case '}':
-            case '|':
-            case '\\':
-
-            case ';':
-            case ':':
-
-            case '"':
-
-            case '<':
-            case '>':
-
-            case ',':
-            case '.':
-
-            case '/':
-            case '?':
-
-                return Token::DELIMITER;
-            default:
-                return Token::TEXT;
-            }
-        }
-
     }
 
 }
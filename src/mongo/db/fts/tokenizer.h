@@ -67,13 +67,17 @@ namespace mongo {
             Token next();
 
         private:
-            Token::Type _type( char c ) const;
+            Token::Type _type( char c ) const {
+                return _charTypes[static_cast<unsigned char>( c )];
+            }
+
             bool _skipWhitespace();
 
             unsigned _pos;
             bool _previousWhiteSpace;
             const StringData _raw;
-            bool _english;
+            const Token::Type* _charTypes; // the type of each byte, for the language
+
         };
 
     }
@@ -31,6 +31,7 @@
 #include "mongo/db/geo/geoconstants.h"
 #include "mongo/db/geo/geoparser.h"
 #include "mongo/util/mongoutils/str.h"
+#include "third_party/s2/s2regioncoverer.h"
 
 namespace mongo {
 
@@ -375,7 +376,31 @@ namespace mongo {
         return poly.MayIntersect(otherCell);
     }
 
+    const S2CellUnion& GeometryContainer::getInteriorCovering() const {
+        // A few cells no finer than about 10m on a side already take in most of a region's
+        // area, while costing little to find.
+        static const int kInteriorCoveringMaxCells = 32;
+        static const int kInteriorCoveringMaxLevel = 20;
+
+        if (NULL == _interiorCovering) {
+            _interiorCovering.reset(new S2CellUnion());
+            if (NULL != _s2Region) {
+                S2RegionCoverer coverer;
+                coverer.set_max_cells(kInteriorCoveringMaxCells);
+                coverer.set_max_level(kInteriorCoveringMaxLevel);
+                coverer.GetInteriorCellUnion(*_s2Region, _interiorCovering.get());
+            }
+        }
+        return *_interiorCovering;
+    }
+
     bool GeometryContainer::contains(const S2Cell& otherCell, const S2Point& otherPoint) const {
+        // The exact tests below have to look at the edges of the region, while a point whose
+        // cell lies within one of the region's interior cells is contained regardless.
+        if (getInteriorCovering().Contains(otherCell.id())) {
+            return true;
+        }
+
         if (NULL != _polygon && (NULL != _polygon->s2Polygon)) {
             return containsPoint(*_polygon->s2Polygon, otherCell, otherPoint);
         }
@@ -33,6 +33,7 @@
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/db/geo/shapes.h"
+#include "third_party/s2/s2cellunion.h"
 #include "third_party/s2/s2regionunion.h"
 
 namespace mongo {
@@ -140,6 +141,10 @@ namespace mongo {
         bool contains(const S2Polyline& otherLine) const;
         bool contains(const S2Polygon& otherPolygon) const;
 
+        // Cells entirely inside _s2Region, so that points in them need no exact containment
+        // test. Computed the first time a point is tested.
+        const S2CellUnion& getInteriorCovering() const;
+
         // Only one of these shared_ptrs should be non-NULL.  S2Region is a
         // superclass but it only supports testing against S2Cells.  We need
         // the most specific class we can get.
@@ -157,6 +162,8 @@ namespace mongo {
         // TODO: _s2Region is currently generated immediately - don't necessarily need to do this
         boost::scoped_ptr<S2RegionUnion> _s2Region;
         boost::scoped_ptr<R2Region> _r2Region;
+
+        mutable boost::scoped_ptr<S2CellUnion> _interiorCovering;
     };
 
 } // namespace mongo
@@ -37,30 +37,58 @@
 #include <boost/scoped_ptr.hpp>
 
 #include "mongo/db/jsobj.h"
+#include "mongo/util/mongoutils/str.h"
 #include "mongo/util/startup_test.h"
+#include "third_party/murmurhash3/MurmurHash3.h"
 
 namespace mongo {
 
     using boost::scoped_ptr;
 
-    Hasher::Hasher( HashSeed seed ) : _seed( seed ) {
+    MD5Hasher::MD5Hasher( HashSeed seed ) : _seed( seed ) {
         md5_init( &_md5State );
         md5_append( &_md5State , reinterpret_cast< const md5_byte_t * >( & _seed ) , sizeof( _seed ) );
     }
 
-    void Hasher::addData( const void * keyData , size_t numBytes ) {
+    void MD5Hasher::addData( const void * keyData , size_t numBytes ) {
         md5_append( &_md5State , static_cast< const md5_byte_t * >( keyData ), numBytes );
     }
 
-    void Hasher::finish( HashDigest out ) {
+    void MD5Hasher::finish( HashDigest out ) {
         md5_finish( &_md5State , out );
     }
 
-    long long int BSONElementHasher::hash64( const BSONElement& e , HashSeed seed ){
-        scoped_ptr<Hasher> h( HasherFactory::createHasher( seed ) );
-        recursiveHash( h.get() , e , false );
+    void Murmur3Hasher::addData( const void * keyData , size_t numBytes ) {
+        _data.appendBuf( keyData , numBytes );
+    }
+
+    void Murmur3Hasher::finish( HashDigest out ) {
+        MurmurHash3_x64_128( _data.buf() , _data.len() , _seed , out );
+    }
+
+    Hasher* HasherFactory::createHasher( HashSeed seed , int hashVersion ) {
+        massert( 16767 , str::stream() << "unknown hashVersion " << hashVersion ,
+                 isValidHashVersion( hashVersion ) );
+        if ( hashVersion == MURMUR3_HASH_VERSION )
+            return new Murmur3Hasher( seed );
+        return new MD5Hasher( seed );
+    }
+
+    long long int BSONElementHasher::hash64( const BSONElement& e ,
+                                             HashSeed seed ,
+                                             int hashVersion ) {
         HashDigest d;
-        h->finish(d);
+        if ( hashVersion == MD5_HASH_VERSION ) {
+            // the common case, without a heap allocated hasher
+            MD5Hasher h( seed );
+            recursiveHash( &h , e , false );
+            h.finish(d);
+        }
+        else {
+            scoped_ptr<Hasher> h( HasherFactory::createHasher( seed , hashVersion ) );
+            recursiveHash( h.get() , e , false );
+            h->finish(d);
+        }
         //HashDigest is actually 16 bytes, but we just get 8 via truncation
         // NOTE: assumes little-endian
         return *reinterpret_cast< long long int * >( d );
@@ -42,6 +42,7 @@
 #include <boost/noncopyable.hpp>
 
 #include "mongo/bson/bsonelement.h"
+#include "mongo/bson/util/builder.h"
 #include "mongo/util/md5.hpp"
 
 namespace mongo {
@@ -49,32 +50,58 @@ namespace mongo {
     typedef int HashSeed;
     typedef unsigned char HashDigest[16];
 
+    /* The hash functions of hashed indexes, recorded as "hashVersion" in the index spec.
+     * Hashed shard keys always use MD5_HASH_VERSION.
+     */
+    enum HashVersion {
+        MD5_HASH_VERSION = 0,
+        MURMUR3_HASH_VERSION = 1,   // MurmurHash3_x64_128, several times faster than MD5
+    };
+
+    inline bool isValidHashVersion( int v ) {
+        return v == MD5_HASH_VERSION || v == MURMUR3_HASH_VERSION;
+    }
+
     class Hasher : private boost::noncopyable {
     public:
-
-        explicit Hasher( HashSeed seed );
-        ~Hasher() { };
+        virtual ~Hasher() { };
 
         //pointer to next part of input key, length in bytes to read
-        void addData( const void * keyData , size_t numBytes );
+        virtual void addData( const void * keyData , size_t numBytes ) = 0;
 
         //finish computing the hash, put the result in the digest
         //only call this once per Hasher
-        void finish( HashDigest out );
+        virtual void finish( HashDigest out ) = 0;
+    };
+
+    class MD5Hasher : public Hasher {
+    public:
+        explicit MD5Hasher( HashSeed seed );
+
+        virtual void addData( const void * keyData , size_t numBytes );
+        virtual void finish( HashDigest out );
 
     private:
         md5_state_t _md5State;
         HashSeed _seed;
     };
 
+    /* MurmurHash3 isn't incremental, so this buffers the data and hashes it in finish(). */
+    class Murmur3Hasher : public Hasher {
+    public:
+        explicit Murmur3Hasher( HashSeed seed ) : _seed( seed ) {}
+
+        virtual void addData( const void * keyData , size_t numBytes );
+        virtual void finish( HashDigest out );
+
+    private:
+        StackBufBuilder _data;
+        HashSeed _seed;
+    };
+
     class HasherFactory : private boost::noncopyable  {
     public:
-        /* Eventually this may be a more sophisticated factory
-         * for creating other hashers, but for now use MD5.
-         */
-        static Hasher* createHasher( HashSeed seed ) {
-            return new Hasher( seed );
-        }
+        static Hasher* createHasher( HashSeed seed , int hashVersion = MD5_HASH_VERSION );
 
     private:
         HasherFactory();
@@ -99,12 +126,16 @@ namespace mongo {
          * ints via truncation, so floating point values round towards 0 to the
          * nearest int representable as a 64-bit long.
          *
+         * "hashVersion" picks the hash function, see HashVersion.
+         *
          * This function is used in the computation of hashed indexes
          * and hashed shard keys, and thus should not be changed unless
          * the associated "getKeys" and "makeSingleKey" method in the
          * hashindex type is changed accordingly.
          */
-        static long long int hash64( const BSONElement& e , HashSeed seed );
+        static long long int hash64( const BSONElement& e ,
+                                     HashSeed seed ,
+                                     int hashVersion = MD5_HASH_VERSION );
 
         /* This incrementally computes the hash of BSONElement "e"
          * using hash function "h".  If "includeFieldName" is true,
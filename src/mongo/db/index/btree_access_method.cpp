@@ -67,4 +67,8 @@ namespace mongo {
         _keyGenerator->getKeys(obj, keys);
     }
 
+    void BtreeAccessMethod::getMultikeyPaths(const BSONObj& obj, MultikeyPaths* multikeyPaths) {
+        _keyGenerator->getMultikeyPaths(obj, multikeyPaths);
+    }
+
 }  // namespace mongo
@@ -58,6 +58,8 @@ namespace mongo {
     private:
         virtual void getKeys(const BSONObj& obj, BSONObjSet* keys);
 
+        virtual void getMultikeyPaths(const BSONObj& obj, MultikeyPaths* multikeyPaths);
+
         // Our keys differ for V0 and V1.
         boost::scoped_ptr<BtreeKeyGenerator> _keyGenerator;
     };
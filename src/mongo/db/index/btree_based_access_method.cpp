@@ -30,18 +30,22 @@
 
 #include "mongo/db/index/btree_access_method.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "mongo/base/error_codes.h"
+#include "mongo/bson/bson_field_index.h"
 #include "mongo/base/status.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/index/btree_based_bulk_access_method.h"
 #include "mongo/db/index/btree_index_cursor.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/keypattern.h"
+#include "mongo/db/matcher/expression.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
 #include "mongo/util/progress_meter.h"
 
 
@@ -84,21 +88,10 @@ namespace mongo {
                 continue;
             }
 
-            // Error cases.
-
-            if (status.code() == ErrorCodes::KeyTooLong && ignoreKeyTooLong(txn)) {
+            if (!isFatalInsertError(txn, status, *i)) {
                 continue;
             }
 
-            if (status.code() == ErrorCodes::DuplicateKeyValue) {
-                // A document might be indexed multiple times during a background index build
-                // if it moves ahead of the collection scan cursor (e.g. via an update).
-                if (!_btreeState->isReady(txn)) {
-                    LOG(3) << "key " << *i << " already in index during background indexing (ok)";
-                    continue;
-                }
-            }
-
             // Clean up after ourselves.
             for (BSONObjSet::const_iterator j = keys.begin(); j != i; ++j) {
                 removeOneKey(txn, *j, loc, options.dupsAllowed);
@@ -109,12 +102,154 @@ namespace mongo {
         }
 
         if (*numInserted > 1) {
-            _btreeState->setMultikey( txn );
+            MultikeyPaths multikeyPaths;
+            getMultikeyPaths(obj, &multikeyPaths);
+            _btreeState->setMultikey(txn, multikeyPaths);
         }
 
         return ret;
     }
 
+    bool BtreeBasedAccessMethod::isFatalInsertError(OperationContext* txn,
+                                                    const Status& status,
+                                                    const BSONObj& key) {
+        if (status.code() == ErrorCodes::KeyTooLong && ignoreKeyTooLong(txn)) {
+            return false;
+        }
+
+        if (status.code() == ErrorCodes::DuplicateKeyValue) {
+            // A document might be indexed multiple times during a background index build
+            // if it moves ahead of the collection scan cursor (e.g. via an update).
+            if (!_btreeState->isReady(txn)) {
+                LOG(3) << "key " << key << " already in index during background indexing (ok)";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    namespace {
+
+        struct BatchKey {
+            BatchKey(const BSONObj& key, size_t doc) : key(key), doc(doc) {}
+
+            BSONObj key;
+            size_t doc; // index of the document in the batch
+        };
+
+        class BatchKeyLess {
+        public:
+            explicit BatchKeyLess(const BSONObj& keyPattern) : _keyPattern(keyPattern) {}
+
+            bool operator()(const BatchKey& lhs, const BatchKey& rhs) const {
+                const int cmp = lhs.key.woCompare(rhs.key, _keyPattern, false);
+                return cmp < 0 || (cmp == 0 && lhs.doc < rhs.doc);
+            }
+
+        private:
+            const BSONObj _keyPattern;
+        };
+
+    } // namespace
+
+    Status BtreeBasedAccessMethod::insertMany(OperationContext* txn,
+                                              const std::vector<const BSONFieldIndex*>& docs,
+                                              const std::vector<RecordId>& locs,
+                                              const InsertDeleteOptions& options,
+                                              int64_t* numInserted) {
+        invariant(docs.size() == locs.size());
+        if (numInserted) {
+            *numInserted = 0;
+        }
+
+        std::vector<BatchKey> keys;
+        keys.reserve(docs.size());
+        {
+            BSONObjSet docKeys;
+            for (size_t i = 0; i < docs.size(); ++i) {
+                BSONFieldIndex::Scope fieldsScope(*docs[i]);
+                docKeys.clear();
+                getKeys(docs[i]->obj(), &docKeys);
+                for (BSONObjSet::const_iterator it = docKeys.begin(); it != docKeys.end(); ++it) {
+                    keys.push_back(BatchKey(*it, i));
+                }
+            }
+        }
+
+        std::sort(keys.begin(), keys.end(), BatchKeyLess(_descriptor->keyPattern()));
+
+        // Two documents of the batch with the same key would only collide once the first has
+        // been inserted; catch them before inserting anything.
+        if (!options.dupsAllowed) {
+            for (size_t i = 1; i < keys.size(); ++i) {
+                if (keys[i].doc != keys[i - 1].doc &&
+                    keys[i].key.woCompare(keys[i - 1].key, BSONObj(), false) == 0) {
+                    return Status(ErrorCodes::DuplicateKey,
+                                  str::stream() << "E11000 duplicate key error index: "
+                                                << _descriptor->indexNamespace()
+                                                << " dup key: " << keys[i].key);
+                }
+            }
+        }
+
+        std::vector<int> docNumInserted(docs.size(), 0);
+        std::vector<bool> inserted(keys.size(), false);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const BatchKey& key = keys[i];
+            Status status = _newInterface->insert(txn, key.key, locs[key.doc],
+                                                  options.dupsAllowed);
+            if (status.isOK()) {
+                ++docNumInserted[key.doc];
+                inserted[i] = true;
+                continue;
+            }
+
+            if (!isFatalInsertError(txn, status, key.key)) {
+                continue;
+            }
+
+            // Clean up after ourselves.  Skipped keys were either not inserted or already in
+            // the index before this batch, so only remove the ones that went in.
+            for (size_t j = 0; j < i; ++j) {
+                if (inserted[j]) {
+                    removeOneKey(txn, keys[j].key, locs[keys[j].doc], options.dupsAllowed);
+                }
+            }
+            if (numInserted) {
+                *numInserted = 0;
+            }
+
+            return status;
+        }
+
+        MultikeyPaths multikeyPaths;
+        bool anyMultikey = false;
+        for (size_t i = 0; i < docs.size(); ++i) {
+            if (numInserted) {
+                *numInserted += docNumInserted[i];
+            }
+            if (docNumInserted[i] <= 1) {
+                continue;
+            }
+
+            MultikeyPaths docPaths;
+            getMultikeyPaths(docs[i]->obj(), &docPaths);
+            if (anyMultikey) {
+                mergeMultikeyPaths(&multikeyPaths, docPaths);
+            }
+            else {
+                multikeyPaths = docPaths;
+                anyMultikey = true;
+            }
+        }
+        if (anyMultikey) {
+            _btreeState->setMultikey(txn, multikeyPaths);
+        }
+
+        return Status::OK();
+    }
+
     void BtreeBasedAccessMethod::removeOneKey(OperationContext* txn,
                                               const BSONObj& key,
                                               const RecordId& loc,
@@ -155,6 +290,40 @@ namespace mongo {
         return Status::OK();
     }
 
+    Status BtreeBasedAccessMethod::removeMany(OperationContext* txn,
+                                              const std::vector<const BSONFieldIndex*>& docs,
+                                              const std::vector<RecordId>& locs,
+                                              const InsertDeleteOptions& options,
+                                              int64_t* numDeleted) {
+        invariant(docs.size() == locs.size());
+
+        std::vector<BatchKey> keys;
+        keys.reserve(docs.size());
+        {
+            BSONObjSet docKeys;
+            for (size_t i = 0; i < docs.size(); ++i) {
+                BSONFieldIndex::Scope fieldsScope(*docs[i]);
+                docKeys.clear();
+                getKeys(docs[i]->obj(), &docKeys);
+                for (BSONObjSet::const_iterator it = docKeys.begin(); it != docKeys.end(); ++it) {
+                    keys.push_back(BatchKey(*it, i));
+                }
+            }
+        }
+
+        std::sort(keys.begin(), keys.end(), BatchKeyLess(_descriptor->keyPattern()));
+
+        for (size_t i = 0; i < keys.size(); ++i) {
+            removeOneKey(txn, keys[i].key, locs[keys[i].doc], options.dupsAllowed);
+        }
+
+        if (numDeleted) {
+            *numDeleted = keys.size();
+        }
+
+        return Status::OK();
+    }
+
     // Return keys in l that are not in r.
     // Lifted basically verbatim from elsewhere.
     static void setDifference(const BSONObjSet &l, const BSONObjSet &r, vector<BSONObj*> *diff) {
@@ -234,6 +403,20 @@ namespace mongo {
         return _newInterface->getSpaceUsedBytes( txn );
     }
 
+    bool BtreeBasedAccessMethod::estimateRangeCount(OperationContext* txn,
+                                                    const BSONObj& startKey,
+                                                    bool startKeyInclusive,
+                                                    const BSONObj& endKey,
+                                                    bool endKeyInclusive,
+                                                    long long* estimateOut) const {
+        return _newInterface->estimateRangeCount(txn,
+                                                 startKey,
+                                                 startKeyInclusive,
+                                                 endKey,
+                                                 endKeyInclusive,
+                                                 estimateOut);
+    }
+
     Status BtreeBasedAccessMethod::validateUpdate(OperationContext* txn,
                                                   const BSONObj &from,
                                                   const BSONObj &to,
@@ -244,10 +427,19 @@ namespace mongo {
         BtreeBasedPrivateUpdateData *data = new BtreeBasedPrivateUpdateData();
         status->_indexSpecificUpdateData.reset(data);
 
-        getKeys(from, &data->oldKeys);
-        getKeys(to, &data->newKeys);
+        // A partial index only has keys for the versions of the document matching its filter.
+        const MatchExpression* filter = _btreeState->getFilterExpression();
+        if (!filter || filter->matchesBSON(from)) {
+            getKeys(from, &data->oldKeys);
+        }
+        if (!filter || filter->matchesBSON(to)) {
+            getKeys(to, &data->newKeys);
+        }
         data->loc = record;
         data->dupsAllowed = options.dupsAllowed;
+        if (data->newKeys.size() > 1) {
+            getMultikeyPaths(to, &data->multikeyPaths);
+        }
 
         setDifference(data->oldKeys, data->newKeys, &data->removed);
         setDifference(data->newKeys, data->oldKeys, &data->added);
@@ -268,7 +460,7 @@ namespace mongo {
             static_cast<BtreeBasedPrivateUpdateData*>(ticket._indexSpecificUpdateData.get());
 
         if (data->oldKeys.size() + data->added.size() - data->removed.size() > 1) {
-            _btreeState->setMultikey( txn );
+            _btreeState->setMultikey(txn, data->multikeyPaths);
         }
 
         for (size_t i = 0; i < data->removed.size(); ++i) {
@@ -293,6 +485,93 @@ namespace mongo {
         return Status::OK();
     }
 
+    Status BtreeBasedAccessMethod::updateMany(OperationContext* txn,
+                                              const std::vector<const UpdateTicket*>& tickets,
+                                              int64_t* numUpdated) {
+        if (numUpdated) {
+            *numUpdated = 0;
+        }
+        if (tickets.empty()) {
+            return Status::OK();
+        }
+
+        std::vector<const BtreeBasedPrivateUpdateData*> datas;
+        datas.reserve(tickets.size());
+        for (size_t i = 0; i < tickets.size(); ++i) {
+            if (!tickets[i]->_isValid) {
+                return Status(ErrorCodes::InternalError, "Invalid UpdateTicket in updateMany");
+            }
+            datas.push_back(static_cast<const BtreeBasedPrivateUpdateData*>(
+                tickets[i]->_indexSpecificUpdateData.get()));
+        }
+
+        if (!datas[0]->dupsAllowed) {
+            for (size_t i = 0; i < tickets.size(); ++i) {
+                int64_t ticketUpdated;
+                Status status = update(txn, *tickets[i], &ticketUpdated);
+                if (!status.isOK()) {
+                    return status;
+                }
+                if (numUpdated) {
+                    *numUpdated += ticketUpdated;
+                }
+            }
+            return Status::OK();
+        }
+
+        std::vector<BatchKey> removed;
+        std::vector<BatchKey> added;
+        MultikeyPaths multikeyPaths;
+        bool anyMultikey = false;
+        for (size_t i = 0; i < datas.size(); ++i) {
+            const BtreeBasedPrivateUpdateData* data = datas[i];
+            for (size_t j = 0; j < data->removed.size(); ++j) {
+                removed.push_back(BatchKey(*data->removed[j], i));
+            }
+            for (size_t j = 0; j < data->added.size(); ++j) {
+                added.push_back(BatchKey(*data->added[j], i));
+            }
+
+            if (data->oldKeys.size() + data->added.size() - data->removed.size() <= 1) {
+                continue;
+            }
+            if (anyMultikey) {
+                mergeMultikeyPaths(&multikeyPaths, data->multikeyPaths);
+            }
+            else {
+                multikeyPaths = data->multikeyPaths;
+                anyMultikey = true;
+            }
+        }
+        if (anyMultikey) {
+            _btreeState->setMultikey(txn, multikeyPaths);
+        }
+
+        const BatchKeyLess less(_descriptor->keyPattern());
+        std::sort(removed.begin(), removed.end(), less);
+        std::sort(added.begin(), added.end(), less);
+
+        for (size_t i = 0; i < removed.size(); ++i) {
+            _newInterface->unindex(txn, removed[i].key, datas[removed[i].doc]->loc, true);
+        }
+
+        for (size_t i = 0; i < added.size(); ++i) {
+            Status status = _newInterface->insert(txn,
+                                                  added[i].key,
+                                                  datas[added[i].doc]->loc,
+                                                  true);
+            if (!status.isOK()) {
+                return status;
+            }
+        }
+
+        if (numUpdated) {
+            *numUpdated = added.size();
+        }
+
+        return Status::OK();
+    }
+
     IndexAccessMethod* BtreeBasedAccessMethod::initiateBulk(OperationContext* txn) {
         // If there's already data in the index, don't do anything.
         if (!_newInterface->isEmpty(txn)) {
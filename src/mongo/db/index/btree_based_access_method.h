@@ -35,6 +35,7 @@
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index/multikey_paths.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/record_id.h"
 #include "mongo/db/storage/sorted_data_interface.h"
@@ -68,12 +69,32 @@ namespace mongo {
                               const InsertDeleteOptions& options,
                               int64_t* numInserted);
 
+        /**
+         * Sorts the keys of the whole batch and inserts them in key order, so that consecutive
+         * inserts go to neighbouring parts of the index.  For a unique index, keys repeated
+         * within the batch are found in the sorted keys before inserting any.
+         */
+        virtual Status insertMany(OperationContext* txn,
+                                  const std::vector<const BSONFieldIndex*>& docs,
+                                  const std::vector<RecordId>& locs,
+                                  const InsertDeleteOptions& options,
+                                  int64_t* numInserted);
+
         virtual Status remove(OperationContext* txn,
                               const BSONObj& obj,
                               const RecordId& loc,
                               const InsertDeleteOptions& options,
                               int64_t* numDeleted);
 
+        /**
+         * Sorts the keys of the whole batch and removes them in key order.
+         */
+        virtual Status removeMany(OperationContext* txn,
+                                  const std::vector<const BSONFieldIndex*>& docs,
+                                  const std::vector<RecordId>& locs,
+                                  const InsertDeleteOptions& options,
+                                  int64_t* numDeleted);
+
         virtual Status validateUpdate(OperationContext* txn,
                                       const BSONObj& from,
                                       const BSONObj& to,
@@ -85,6 +106,15 @@ namespace mongo {
                               const UpdateTicket& ticket,
                               int64_t* numUpdated);
 
+        /**
+         * Removes the old keys of the whole batch and then inserts the new ones, each in key
+         * order.  An index without duplicates applies the tickets one at a time instead, so that
+         * a key freed by a later document isn't taken by an earlier one.
+         */
+        virtual Status updateMany(OperationContext* txn,
+                                  const std::vector<const UpdateTicket*>& tickets,
+                                  int64_t* numUpdated);
+
         virtual Status newCursor(OperationContext* txn,
                                  const CursorOptions& opts,
                                  IndexCursor** out) const;
@@ -109,21 +139,38 @@ namespace mongo {
             const;
         virtual long long getSpaceUsedBytes( OperationContext* txn ) const;
 
+        virtual bool estimateRangeCount(OperationContext* txn,
+                                        const BSONObj& startKey,
+                                        bool startKeyInclusive,
+                                        const BSONObj& endKey,
+                                        bool endKeyInclusive,
+                                        long long* estimateOut) const;
+
         // XXX: consider migrating callers to use IndexCursor instead
         virtual RecordId findSingle( OperationContext* txn, const BSONObj& key ) const;
 
     protected:
-        // Friends who need getKeys.
+        // Friends who need the members below.
         friend class BtreeBasedBulkAccessMethod;
 
         // See below for body.
         class BtreeBasedPrivateUpdateData;
 
-        virtual void getKeys(const BSONObj &obj, BSONObjSet *keys) = 0;
+        /**
+         * Fills out which indexed fields of 'obj', a document with more than one key, are
+         * multikey. Access methods which can't tell leave 'multikeyPaths' empty.
+         */
+        virtual void getMultikeyPaths(const BSONObj& obj, MultikeyPaths* multikeyPaths) { }
 
         // Determines whether it's OK to ignore ErrorCodes::KeyTooLong for this OperationContext
         bool ignoreKeyTooLong(OperationContext* txn);
 
+        /**
+         * Returns true if 'status', the failure to insert 'key', should fail the insert rather
+         * than just skip the key.
+         */
+        bool isFatalInsertError(OperationContext* txn, const Status& status, const BSONObj& key);
+
         IndexCatalogEntry* _btreeState; // owned by IndexCatalogEntry
         const IndexDescriptor* _descriptor;
 
@@ -151,6 +198,9 @@ namespace mongo {
 
         RecordId loc;
         bool dupsAllowed;
+
+        // Only filled out if the new version of the document has more than one key.
+        MultikeyPaths multikeyPaths;
     };
 
 }  // namespace mongo
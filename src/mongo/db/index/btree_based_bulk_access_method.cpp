@@ -34,8 +34,10 @@
 
 #include <boost/scoped_ptr.hpp>
 
+#include "mongo/bson/bson_field_index.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/util/log.h"
 #include "mongo/util/progress_meter.h"
@@ -44,6 +46,9 @@ namespace mongo {
 
     using boost::scoped_ptr;
 
+    // Number of background threads each index build uses to sort and write its spilled runs.
+    MONGO_EXPORT_SERVER_PARAMETER(indexBuildSortSpillThreads, int, 0);
+
     //
     // Comparison for external sorter interface
     //
@@ -81,53 +86,142 @@ namespace mongo {
         _real = real;
         _interface = interface;
         _txn = txn;
+        _descriptor = descriptor;
 
-        _docsInserted = 0;
-        _keysInserted = 0;
-        _isMultiKey = false;
+        setNumSorters(1);
+    }
 
-        _sorter.reset(BSONObjExternalSorter::make(
-                    SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
-                                 .ExtSortAllowed()
-                                 .MaxMemoryUsageBytes(100*1024*1024),
-                    BtreeExternalSortComparison(descriptor->keyPattern(), descriptor->version())));
+    SortOptions BtreeBasedBulkAccessMethod::_makeSortOptions(size_t numSorters) const {
+        return SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
+                            .ExtSortAllowed()
+                            .MaxMemoryUsageBytes(100*1024*1024 / numSorters)
+                            .SpillThreads(indexBuildSortSpillThreads);
     }
 
-    Status BtreeBasedBulkAccessMethod::insert(OperationContext* txn,
-                                              const BSONObj& obj,
-                                              const RecordId& loc,
-                                              const InsertDeleteOptions& options,
-                                              int64_t* numInserted) {
+    void BtreeBasedBulkAccessMethod::setNumSorters(size_t numSorters) {
+        invariant(numSorters > 0);
+
+        const SortOptions opts = _makeSortOptions(numSorters);
+
+        _sorters.clear();
+        for (size_t i = 0; i < numSorters; i++) {
+            boost::shared_ptr<SorterState> state(new SorterState());
+            state->sorter.reset(BSONObjExternalSorter::make(
+                    opts,
+                    BtreeExternalSortComparison(_descriptor->keyPattern(),
+                                                _descriptor->version())));
+            _sorters.push_back(state);
+        }
+    }
+
+    size_t BtreeBasedBulkAccessMethod::_insert(SorterState* state,
+                                               const BSONObj& obj,
+                                               const RecordId& loc) {
         BSONObjSet keys;
         _real->getKeys(obj, &keys);
 
-        _isMultiKey = _isMultiKey || (keys.size() > 1);
+        if (keys.size() > 1) {
+            MultikeyPaths multikeyPaths;
+            _real->getMultikeyPaths(obj, &multikeyPaths);
+            if (state->isMultiKey) {
+                mergeMultikeyPaths(&state->multikeyPaths, multikeyPaths);
+            }
+            else {
+                state->isMultiKey = true;
+                state->multikeyPaths = multikeyPaths;
+            }
+        }
 
         for (BSONObjSet::iterator it = keys.begin(); it != keys.end(); ++it) {
             // False is for mayInterrupt.
-            _sorter->add(*it, loc);
-            _keysInserted++;
+            state->sorter->add(*it, loc);
+            state->keysInserted++;
         }
 
-        _docsInserted++;
+        state->docsInserted++;
+
+        return keys.size();
+    }
+
+    Status BtreeBasedBulkAccessMethod::insert(OperationContext* txn,
+                                              const BSONObj& obj,
+                                              const RecordId& loc,
+                                              const InsertDeleteOptions& options,
+                                              int64_t* numInserted) {
+        const size_t numKeys = _insert(_sorters[0].get(), obj, loc);
 
         if (NULL != numInserted) {
-            *numInserted += keys.size();
+            *numInserted += numKeys;
         }
 
         return Status::OK();
     }
 
+    Status BtreeBasedBulkAccessMethod::insertMany(OperationContext* txn,
+                                                  const std::vector<const BSONFieldIndex*>& docs,
+                                                  const std::vector<RecordId>& locs,
+                                                  const InsertDeleteOptions& options,
+                                                  int64_t* numInserted) {
+        invariant(docs.size() == locs.size());
+        for (size_t i = 0; i < docs.size(); i++) {
+            Status status = insert(txn, docs[i]->obj(), locs[i], options, numInserted);
+            if (!status.isOK()) {
+                return status;
+            }
+        }
+        return Status::OK();
+    }
+
+    void BtreeBasedBulkAccessMethod::insertIntoSorter(size_t sorterIndex,
+                                                      const BSONObj& obj,
+                                                      const RecordId& loc) {
+        invariant(sorterIndex < _sorters.size());
+        _insert(_sorters[sorterIndex].get(), obj, loc);
+    }
+
     Status BtreeBasedBulkAccessMethod::commit(set<RecordId>* dupsToDrop,
                                               bool mayInterrupt,
                                               bool dupsAllowed) {
         Timer timer;
 
-        scoped_ptr<BSONObjExternalSorter::Iterator> i(_sorter->done());
+        unsigned long long keysInserted = 0;
+        bool isMultiKey = false;
+        MultikeyPaths multikeyPaths;
+        for (size_t j = 0; j < _sorters.size(); j++) {
+            keysInserted += _sorters[j]->keysInserted;
+            if (!_sorters[j]->isMultiKey) {
+                continue;
+            }
+            if (isMultiKey) {
+                mergeMultikeyPaths(&multikeyPaths, _sorters[j]->multikeyPaths);
+            }
+            else {
+                isMultiKey = true;
+                multikeyPaths = _sorters[j]->multikeyPaths;
+            }
+        }
+
+        scoped_ptr<BSONObjExternalSorter::Iterator> i;
+        if (_sorters.size() == 1) {
+            i.reset(_sorters[0]->sorter->done());
+        }
+        else {
+            std::vector<boost::shared_ptr<BSONObjExternalSorter::Iterator> > iters;
+            for (size_t j = 0; j < _sorters.size(); j++) {
+                iters.push_back(
+                    boost::shared_ptr<BSONObjExternalSorter::Iterator>(
+                        _sorters[j]->sorter->done()));
+            }
+            i.reset(BSONObjExternalSorter::Iterator::merge(
+                        iters,
+                        _makeSortOptions(_sorters.size()),
+                        BtreeExternalSortComparison(_descriptor->keyPattern(),
+                                                    _descriptor->version())));
+        }
 
         ProgressMeterHolder pm(*_txn->setMessage("Index Bulk Build: (2/3) btree bottom up",
                                                  "Index: (2/3) BTree Bottom Up Progress",
-                                                 _keysInserted,
+                                                 keysInserted,
                                                  10));
 
         scoped_ptr<SortedDataBuilderInterface> builder;
@@ -135,8 +229,8 @@ namespace mongo {
         {
             WriteUnitOfWork wunit(_txn);
 
-            if (_isMultiKey) {
-                _real->_btreeState->setMultikey( _txn );
+            if (isMultiKey) {
+                _real->_btreeState->setMultikey(_txn, multikeyPaths);
             }
 
             builder.reset(_interface->getBulkBuilder(_txn, dupsAllowed));
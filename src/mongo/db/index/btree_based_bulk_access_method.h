@@ -27,6 +27,7 @@
 */
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <set>
 #include <vector>
 
@@ -60,8 +61,31 @@ namespace mongo {
                               const InsertDeleteOptions& options,
                               int64_t* numInserted);
 
+        virtual Status insertMany(OperationContext* txn,
+                                  const std::vector<const BSONFieldIndex*>& docs,
+                                  const std::vector<RecordId>& locs,
+                                  const InsertDeleteOptions& options,
+                                  int64_t* numInserted);
+
         Status commit(std::set<RecordId>* dupsToDrop, bool mayInterrupt, bool dupsAllowed);
 
+        /**
+         * Splits the build between 'numSorters' sorters, which share its memory limit. Keys can
+         * then be added to different sorters by different threads at the same time with
+         * insertIntoSorter(), and commit() merges the sorters into one ordered stream.
+         *
+         * Must be called before any key is added.
+         */
+        void setNumSorters(size_t numSorters);
+
+        size_t getNumSorters() const { return _sorters.size(); }
+
+        /**
+         * Generates the keys of 'obj' and adds them to sorter 'sorterIndex'. Must not be called
+         * concurrently for the same sorter.
+         */
+        void insertIntoSorter(size_t sorterIndex, const BSONObj& obj, const RecordId& loc);
+
         // Exposed for testing.
         static ExternalSortComparison* getComparison(int version, const BSONObj& keyPattern);
 
@@ -89,6 +113,10 @@ namespace mongo {
             return _notAllowed();
         }
 
+        virtual void getKeys(const BSONObj& obj, BSONObjSet* keys) {
+            _real->getKeys(obj, keys);
+        }
+
         virtual bool appendCustomStats(OperationContext* txn, BSONObjBuilder* output, double scale)
             const {
             return false;
@@ -102,6 +130,14 @@ namespace mongo {
             return _notAllowed();
         }
 
+        virtual Status removeMany(OperationContext* txn,
+                                  const std::vector<const BSONFieldIndex*>& docs,
+                                  const std::vector<RecordId>& locs,
+                                  const InsertDeleteOptions& options,
+                                  int64_t* numDeleted) {
+            return _notAllowed();
+        }
+
         virtual Status validateUpdate(OperationContext* txn,
                                       const BSONObj& from,
                                       const BSONObj& to,
@@ -115,12 +151,27 @@ namespace mongo {
             return -1;
         }
 
+        virtual bool estimateRangeCount(OperationContext* txn,
+                                        const BSONObj& startKey,
+                                        bool startKeyInclusive,
+                                        const BSONObj& endKey,
+                                        bool endKeyInclusive,
+                                        long long* estimateOut) const {
+            return false;
+        }
+
         virtual Status update(OperationContext* txn,
                               const UpdateTicket& ticket,
                               int64_t* numUpdated) {
             return _notAllowed();
         }
 
+        virtual Status updateMany(OperationContext* txn,
+                                  const std::vector<const UpdateTicket*>& tickets,
+                                  int64_t* numUpdated) {
+            return _notAllowed();
+        }
+
         virtual Status newCursor(OperationContext*txn,
                                  const CursorOptions& opts,
                                  IndexCursor** out) const {
@@ -140,27 +191,46 @@ namespace mongo {
     private:
         typedef Sorter<BSONObj, RecordId> BSONObjExternalSorter;
 
+        /**
+         * The keys generated by one thread.
+         */
+        struct SorterState {
+            SorterState() : docsInserted(0), keysInserted(0), isMultiKey(false) {}
+
+            boost::scoped_ptr<BSONObjExternalSorter> sorter;
+
+            // How many docs are we indexing?
+            unsigned long long docsInserted;
+
+            // And how many keys?
+            unsigned long long keysInserted;
+
+            // Does any document have >1 key?
+            bool isMultiKey;
+
+            // The multikey fields of those documents, if isMultiKey.
+            MultikeyPaths multikeyPaths;
+        };
+
         Status _notAllowed() const {
             return Status(ErrorCodes::InternalError, "cannot use bulk for this yet");
         }
 
+        SortOptions _makeSortOptions(size_t numSorters) const;
+
+        size_t _insert(SorterState* state, const BSONObj& obj, const RecordId& loc);
+
         // Not owned here.
         BtreeBasedAccessMethod* _real;
 
         // Not owned here.
         SortedDataInterface* _interface;
 
-        // The external sorter.
-        boost::scoped_ptr<BSONObjExternalSorter> _sorter;
-
-        // How many docs are we indexing?
-        unsigned long long _docsInserted;
-
-        // And how many keys?
-        unsigned long long _keysInserted;
+        // Not owned here.
+        const IndexDescriptor* _descriptor;
 
-        // Does any document have >1 key?
-        bool _isMultiKey;
+        // The external sorters, one per thread generating keys.
+        std::vector<boost::shared_ptr<SorterState> > _sorters;
 
         OperationContext* _txn;
     };
@@ -79,6 +79,48 @@ namespace mongo {
         }
     }
 
+    void BtreeKeyGenerator::addKey(const vector<BSONElement>& elements, BSONObjSet* keys) {
+        StackBufBuilder buf;
+        buf.skip(sizeof(int));
+        for (vector<BSONElement>::const_iterator i = elements.begin(); i != elements.end(); ++i) {
+            verify(!i->eoo());
+            buf.appendNum(static_cast<char>(i->type()));
+            buf.appendChar('\0'); // the empty field name
+            buf.appendBuf(i->value(), i->valuesize());
+        }
+        buf.appendNum(static_cast<char>(EOO));
+        DataView(buf.buf()).writeLE(buf.len());
+
+        const BSONObj key(buf.buf());
+        if (keys->find(key) == keys->end()) {
+            keys->insert(key.getOwned());
+        }
+    }
+
+    namespace {
+
+        bool pathHasArray(const BSONObj& obj, const StringData& path) {
+            const size_t dot = path.find('.');
+            BSONElement e = obj.getField(path.substr(0, dot));
+            if (Array == e.type()) {
+                return true;
+            }
+            if (std::string::npos == dot || Object != e.type()) {
+                return false;
+            }
+            return pathHasArray(e.embeddedObject(), path.substr(dot + 1));
+        }
+
+    } // namespace
+
+    void BtreeKeyGenerator::getMultikeyPaths(const BSONObj& obj,
+                                             MultikeyPaths* multikeyPaths) const {
+        multikeyPaths->resize(_fieldNames.size());
+        for (size_t i = 0; i < _fieldNames.size(); ++i) {
+            (*multikeyPaths)[i] = pathHasArray(obj, _fieldNames[i]);
+        }
+    }
+
     static void assertParallelArrays( const char *first, const char *second ) {
         stringstream ss;
         ss << "cannot index parallel arrays [" << first << "] [" << second << "]";
@@ -145,10 +187,7 @@ namespace mongo {
         if ( allFound ) {
             if ( arrElt.eoo() ) {
                 // no terminal array element to expand
-                BSONObjBuilder b(_sizeTracker);
-                for( vector< BSONElement >::iterator i = fixed.begin(); i != fixed.end(); ++i )
-                    b.appendAs( *i, "" );
-                keys->insert( b.obj() );
+                addKey( fixed, keys );
             }
             else {
                 // terminal array element to expand, so generate all keys
@@ -219,7 +258,8 @@ namespace mongo {
     BSONElement BtreeKeyGeneratorV1::extractNextElement(const BSONObj &obj, const BSONObj &arr,
                                                         const char *&field,
                                                         bool &arrayNestedArray) const {
-        string firstField = mongoutils::str::before( field, '.' );
+        const StringData fieldData( field );
+        const StringData firstField = fieldData.substr( 0, fieldData.find( '.' ) );
         bool haveObjField = !obj.getField( firstField ).eoo();
         BSONElement arrField = arr.getField( firstField );
         bool haveArrField = !arrField.eoo();
@@ -246,22 +286,28 @@ namespace mongo {
         return BSONElement();
     }
 
-    void BtreeKeyGeneratorV1::_getKeysArrEltFixed(vector<const char*> &fieldNames,
-                                                  vector<BSONElement> &fixed,
+    void BtreeKeyGeneratorV1::_getKeysArrEltFixed(const vector<const char*> &fieldNames,
+                                                  const vector<BSONElement> &fixed,
                                                   const BSONElement &arrEntry, BSONObjSet *keys,
                                                   unsigned numNotFound,
                                                   const BSONElement &arrObjElt,
                                                   const set<unsigned> &arrIdxs,
-                                                  bool mayExpandArrayUnembedded) const {
+                                                  bool mayExpandArrayUnembedded,
+                                                  vector<const char*>* childFieldNames,
+                                                  vector<BSONElement>* childFixed) const {
+        // Assigning over the copies made for the previous entry reuses their storage.
+        *childFieldNames = fieldNames;
+        *childFixed = fixed;
+
         // set up any terminal array values
         for( set<unsigned>::const_iterator j = arrIdxs.begin(); j != arrIdxs.end(); ++j ) {
             if ( *fieldNames[ *j ] == '\0' ) {
-                fixed[ *j ] = mayExpandArrayUnembedded ? arrEntry : arrObjElt;
+                (*childFixed)[ *j ] = mayExpandArrayUnembedded ? arrEntry : arrObjElt;
             }
         }
         // recurse
-        getKeysImplWithArray(fieldNames,
-                             fixed,
+        getKeysImplWithArray(childFieldNames,
+                             childFixed,
                              arrEntry.type() == Object ? arrEntry.embeddedObject() : BSONObj(),
                              keys,
                              numNotFound,
@@ -270,30 +316,30 @@ namespace mongo {
 
     void BtreeKeyGeneratorV1::getKeysImpl(vector<const char*> fieldNames, vector<BSONElement> fixed,
                                           const BSONObj &obj, BSONObjSet *keys) const {
-        getKeysImplWithArray(fieldNames, fixed, obj, keys, 0, BSONObj());
+        getKeysImplWithArray(&fieldNames, &fixed, obj, keys, 0, BSONObj());
     }
 
-    void BtreeKeyGeneratorV1::getKeysImplWithArray(vector<const char*> fieldNames,
-                                                   vector<BSONElement> fixed, const BSONObj &obj,
+    void BtreeKeyGeneratorV1::getKeysImplWithArray(vector<const char*>* fieldNames,
+                                                   vector<BSONElement>* fixed, const BSONObj &obj,
                                                    BSONObjSet *keys, unsigned numNotFound,
                                                    const BSONObj &array) const {
         BSONElement arrElt;
         set<unsigned> arrIdxs;
         bool mayExpandArrayUnembedded = true;
-        for( unsigned i = 0; i < fieldNames.size(); ++i ) {
-            if ( *fieldNames[ i ] == '\0' ) {
+        for( unsigned i = 0; i < fieldNames->size(); ++i ) {
+            if ( *(*fieldNames)[ i ] == '\0' ) {
                 continue;
             }
 
             bool arrayNestedArray;
             // Extract element matching fieldName[ i ] from object xor array.
-            BSONElement e = extractNextElement( obj, array, fieldNames[ i ], arrayNestedArray );
+            BSONElement e = extractNextElement( obj, array, (*fieldNames)[ i ], arrayNestedArray );
 
             if ( e.eoo() ) {
                 // if field not present, set to null
-                fixed[ i ] = _nullElt;
+                (*fixed)[ i ] = _nullElt;
                 // done expanding this field name
-                fieldNames[ i ] = "";
+                (*fieldNames)[ i ] = "";
                 numNotFound++;
             }
             else if ( e.type() == Array ) {
@@ -312,33 +358,34 @@ namespace mongo {
             }
             else {
                 // not an array - no need for further expansion
-                fixed[ i ] = e;
+                (*fixed)[ i ] = e;
             }
         }
 
         if ( arrElt.eoo() ) {
             // No array, so generate a single key.
-            if ( _isSparse && numNotFound == fieldNames.size()) {
+            if ( _isSparse && numNotFound == fieldNames->size()) {
                 return;
             }            
-            BSONObjBuilder b(_sizeTracker);
-            for( vector< BSONElement >::iterator i = fixed.begin(); i != fixed.end(); ++i ) {
-                b.appendAs( *i, "" );
-            }
-            keys->insert( b.obj() );
+            addKey( *fixed, keys );
+            return;
         }
-        else if ( arrElt.embeddedObject().firstElement().eoo() ) {
+
+        vector<const char*> childFieldNames;
+        vector<BSONElement> childFixed;
+        if ( arrElt.embeddedObject().firstElement().eoo() ) {
             // Empty array, so set matching fields to undefined.
-            _getKeysArrEltFixed(fieldNames, fixed, _undefinedElt, keys, numNotFound, arrElt,
-                                arrIdxs, true );
+            _getKeysArrEltFixed(*fieldNames, *fixed, _undefinedElt, keys, numNotFound, arrElt,
+                                arrIdxs, true, &childFieldNames, &childFixed );
         }
         else {
             // Non empty array that can be expanded, so generate a key for each member.
             BSONObj arrObj = arrElt.embeddedObject();
             BSONObjIterator i( arrObj );
             while( i.more() ) {
-                _getKeysArrEltFixed(fieldNames, fixed, i.next(), keys, numNotFound, arrElt, arrIdxs,
-                        mayExpandArrayUnembedded );
+                _getKeysArrEltFixed(*fieldNames, *fixed, i.next(), keys, numNotFound, arrElt,
+                                    arrIdxs, mayExpandArrayUnembedded, &childFieldNames,
+                                    &childFixed );
             }
         }
     }
@@ -30,6 +30,7 @@
 
 #include <vector>
 #include <set>
+#include "mongo/db/index/multikey_paths.h"
 #include "mongo/db/jsobj.h"
 
 namespace mongo {
@@ -45,9 +46,22 @@ namespace mongo {
 
         void getKeys(const BSONObj &obj, BSONObjSet *keys) const;
 
+        /**
+         * Fills out 'multikeyPaths' with, for each indexed field, whether its path in 'obj' runs
+         * through an array. Meant for documents that generated more than one key.
+         */
+        void getMultikeyPaths(const BSONObj& obj, MultikeyPaths* multikeyPaths) const;
+
         static const int ParallelArraysCode;
 
     protected:
+        /**
+         * Adds the key made of 'elements', renamed to "", to 'keys' unless it is there already.
+         * The key is put together on the stack, so a duplicate costs no allocation and a new key
+         * a single one of its exact size.
+         */
+        static void addKey(const std::vector<BSONElement>& elements, BSONObjSet* keys);
+
         // These are used by the getKeysImpl(s) below.
         std::vector<const char*> _fieldNames;
         bool _isIdIndex;
@@ -93,8 +107,9 @@ namespace mongo {
         virtual void getKeysImpl(vector<const char*> fieldNames, vector<BSONElement> fixed,
                                  const BSONObj &obj, BSONObjSet *keys) const;
 
-        // These guys are called by getKeysImpl.
-        void getKeysImplWithArray(vector<const char*> fieldNames, vector<BSONElement> fixed,
+        // These guys are called by getKeysImpl.  getKeysImplWithArray() consumes '*fieldNames'
+        // and fills in '*fixed' as it goes.
+        void getKeysImplWithArray(vector<const char*>* fieldNames, vector<BSONElement>* fixed,
                                   const BSONObj &obj, BSONObjSet *keys, unsigned numNotFound,
                                   const BSONObj &array) const;
         /**
@@ -103,10 +118,18 @@ namespace mongo {
          */
         BSONElement extractNextElement(const BSONObj &obj, const BSONObj &arr, const char *&field,
                                        bool &arrayNestedArray ) const;
-        void _getKeysArrEltFixed(vector<const char*> &fieldNames, vector<BSONElement> &fixed,
+        /**
+         * Recurses into 'arrEntry' with copies of 'fieldNames' and 'fixed' made in
+         * '*childFieldNames' and '*childFixed', which the caller reuses for all the entries of
+         * the array so they are only allocated once per array.
+         */
+        void _getKeysArrEltFixed(const vector<const char*> &fieldNames,
+                                 const vector<BSONElement> &fixed,
                                  const BSONElement &arrEntry, BSONObjSet *keys,
                                  unsigned numNotFound, const BSONElement &arrObjElt,
-                                 const set<unsigned> &arrIdxs, bool mayExpandArrayUnembedded) const;
+                                 const set<unsigned> &arrIdxs, bool mayExpandArrayUnembedded,
+                                 vector<const char*>* childFieldNames,
+                                 vector<BSONElement>* childFixed) const;
 
         BSONObj _undefinedObj;
         BSONElement _undefinedElt;
@@ -105,6 +105,23 @@ namespace {
         return match;
     }
 
+    MultikeyPaths getMultikeyPaths(const BSONObj& kp, const BSONObj& obj) {
+        vector<const char*> fieldNames;
+        vector<BSONElement> fixed;
+
+        BSONObjIterator it(kp);
+        while (it.more()) {
+            BSONElement elt = it.next();
+            fieldNames.push_back(elt.fieldName());
+            fixed.push_back(BSONElement());
+        }
+
+        BtreeKeyGeneratorV1 keyGen(fieldNames, fixed, false);
+        MultikeyPaths multikeyPaths;
+        keyGen.getMultikeyPaths(obj, &multikeyPaths);
+        return multikeyPaths;
+    }
+
     //
     // Unit tests
     //
@@ -590,4 +607,72 @@ namespace {
         ASSERT(testKeygen(keyPattern, genKeysFrom, expectedKeys));
     }
 
+    TEST(BtreeKeyGeneratorTest, GetKeysFromArrayWithDuplicates) {
+        BSONObj keyPattern = fromjson("{a: 1, b: 1}");
+        BSONObj genKeysFrom = fromjson("{a: [1, 2, 1, 'x', 2, 'x', 1], b: {c: 3}}");
+        BSONObjSet expectedKeys;
+        expectedKeys.insert(fromjson("{'': 1, '': {c: 3}}"));
+        expectedKeys.insert(fromjson("{'': 2, '': {c: 3}}"));
+        expectedKeys.insert(fromjson("{'': 'x', '': {c: 3}}"));
+        ASSERT(testKeygen(keyPattern, genKeysFrom, expectedKeys));
+    }
+
+    // Fields found in one element of an array must not carry over to the next.
+    TEST(BtreeKeyGeneratorTest, GetKeysFromArraySubobjectsWithDifferentFields) {
+        BSONObj keyPattern = fromjson("{'a.b': 1, 'a.c': 1}");
+        BSONObj genKeysFrom = fromjson("{a: [{b: 1, c: [1, 2]}, {b: 2}, {c: 3}, {b: 1, c: 2}]}");
+        BSONObjSet expectedKeys;
+        expectedKeys.insert(fromjson("{'': 1, '': 1}"));
+        expectedKeys.insert(fromjson("{'': 1, '': 2}"));
+        expectedKeys.insert(fromjson("{'': 2, '': null}"));
+        expectedKeys.insert(fromjson("{'': null, '': 3}"));
+        ASSERT(testKeygen(keyPattern, genKeysFrom, expectedKeys));
+    }
+
+    //
+    // Multikey paths
+    //
+
+    TEST(BtreeKeyGeneratorTest, MultikeyPathsOnlyArrayField) {
+        MultikeyPaths paths = getMultikeyPaths(fromjson("{a: 1, b: 1}"),
+                                               fromjson("{a: 1, b: [1, 2]}"));
+        ASSERT_EQUALS(2U, paths.size());
+        ASSERT_FALSE(paths[0]);
+        ASSERT_TRUE(paths[1]);
+    }
+
+    TEST(BtreeKeyGeneratorTest, MultikeyPathsArrayAlongDottedPath) {
+        MultikeyPaths paths = getMultikeyPaths(fromjson("{'a.b': 1, 'a.c': 1, 'd.e': 1}"),
+                                               fromjson("{a: [{b: 1, c: 2}, {b: 3}], d: {e: 4}}"));
+        ASSERT_EQUALS(3U, paths.size());
+        ASSERT_TRUE(paths[0]);
+        ASSERT_TRUE(paths[1]);
+        ASSERT_FALSE(paths[2]);
+    }
+
+    TEST(BtreeKeyGeneratorTest, MultikeyPathsMissingFieldIsNotMultikey) {
+        MultikeyPaths paths = getMultikeyPaths(fromjson("{a: 1, 'b.c': 1}"),
+                                               fromjson("{a: [1, 2], b: 3}"));
+        ASSERT_EQUALS(2U, paths.size());
+        ASSERT_TRUE(paths[0]);
+        ASSERT_FALSE(paths[1]);
+    }
+
+    TEST(BtreeKeyGeneratorTest, MergeMultikeyPaths) {
+        MultikeyPaths paths(2, false);
+        paths[0] = true;
+        MultikeyPaths other(2, false);
+        other[1] = true;
+        ASSERT_TRUE(multikeyPathsWouldChange(paths, other));
+        mergeMultikeyPaths(&paths, other);
+        ASSERT_TRUE(paths[0]);
+        ASSERT_TRUE(paths[1]);
+        ASSERT_FALSE(multikeyPathsWouldChange(paths, other));
+
+        // Unknown paths stay unknown, and make known ones unknown.
+        mergeMultikeyPaths(&paths, MultikeyPaths());
+        ASSERT_TRUE(paths.empty());
+        ASSERT_FALSE(multikeyPathsWouldChange(paths, other));
+    }
+
 } // namespace
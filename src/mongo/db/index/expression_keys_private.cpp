@@ -30,6 +30,7 @@
 
 #include "mongo/db/index/expression_keys_private.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "mongo/db/fts/fts_index_format.h"
@@ -85,16 +86,18 @@ namespace {
     }
 
 
+    /**
+     * Appends the cells covering the geometry in 'element' to 'out', using 'coverer', which has
+     * been configured with 'params'.
+     */
     Status S2GetKeysForElement(const BSONElement& element,
                             const S2IndexingParams& params,
+                            S2RegionCoverer* coverer,
                             vector<string>* out) {
         GeometryContainer geoContainer;
         Status status = geoContainer.parseFromStorage(element);
         if (!status.isOK()) return status;
 
-        S2RegionCoverer coverer;
-        params.configureCoverer(&coverer);
-
         // Don't index big polygon
         if (geoContainer.getNativeCRS() == STRICT_SPHERE) {
             return Status(ErrorCodes::BadValue, "can't index geometry with strict winding order");
@@ -118,7 +121,7 @@ namespace {
 
         invariant(geoContainer.hasS2Region());
 
-        S2KeysFromRegion(&coverer, geoContainer.getS2Region(), out);
+        S2KeysFromRegion(coverer, geoContainer.getS2Region(), out);
         return Status::OK();
     }
 
@@ -130,21 +133,31 @@ namespace {
     void getS2GeoKeys(const BSONObj& document, const BSONElementSet& elements,
                                     const S2IndexingParams& params,
                                     BSONObjSet* out) {
+        // The cells of every geometry in the document are gathered first, so that one coverer
+        // serves them all and the cells they share only become one key.
+        S2RegionCoverer coverer;
+        params.configureCoverer(&coverer);
+
+        vector<string> cells;
         for (BSONElementSet::iterator i = elements.begin(); i != elements.end(); ++i) {
-            vector<string> cells;
-            Status status = S2GetKeysForElement(*i, params, &cells);
+            const size_t numCellsBefore = cells.size();
+            Status status = S2GetKeysForElement(*i, params, &coverer, &cells);
             uassert(16755, str::stream() << "Can't extract geo keys: " << document << "  "
                     << status.reason(), status.isOK());
 
             uassert(16756, "Unable to generate keys for (likely malformed) geometry: "
                     + document.toString(),
-                    cells.size() > 0);
+                    cells.size() > numCellsBefore);
+        }
 
-            for (vector<string>::const_iterator it = cells.begin(); it != cells.end(); ++it) {
-                BSONObjBuilder b;
-                b.append("", *it);
-                out->insert(b.obj());
-            }
+        // Keys compare like their cell strings, so sorted cells can be appended to 'out' in
+        // order rather than each searched for.
+        std::sort(cells.begin(), cells.end());
+        cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+        for (vector<string>::const_iterator it = cells.begin(); it != cells.end(); ++it) {
+            BSONObjBuilder b;
+            b.append("", *it);
+            out->insert(out->end(), b.obj());
         }
 
         if (0 == out->size()) {
@@ -348,8 +361,7 @@ namespace mongo {
     long long int ExpressionKeysPrivate::makeSingleHashKey(const BSONElement& e,
                                                            HashSeed seed,
                                                            int v) {
-        massert(16767, "Only HashVersion 0 has been defined" , v == 0 );
-        return BSONElementHasher::hash64(e, seed);
+        return BSONElementHasher::hash64(e, seed, v);
     }
 
     // static
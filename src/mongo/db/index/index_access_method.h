@@ -29,6 +29,7 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <vector>
 
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
@@ -38,6 +39,7 @@
 
 namespace mongo {
 
+    class BSONFieldIndex;
     class BSONObjBuilder;
     class UpdateTicket;
     struct InsertDeleteOptions;
@@ -74,6 +76,19 @@ namespace mongo {
                               const InsertDeleteOptions& options,
                               int64_t* numInserted) = 0;
 
+        /**
+         * Inserts the keys of a batch of documents, as insert() would for each in turn: the
+         * document docs[i]->obj() is at location locs[i], and docs[i] is the table of its fields
+         * to generate its keys with.  If not NULL, 'numInserted' will be set to the number of
+         * keys added for the whole batch.  If any key can't be inserted, none of the batch's
+         * keys will be.
+         */
+        virtual Status insertMany(OperationContext* txn,
+                                  const std::vector<const BSONFieldIndex*>& docs,
+                                  const std::vector<RecordId>& locs,
+                                  const InsertDeleteOptions& options,
+                                  int64_t* numInserted) = 0;
+
         /**
          * Analogous to above, but remove the records instead of inserting them.  If not NULL,
          * numDeleted will be set to the number of keys removed from the index for the document.
@@ -84,6 +99,17 @@ namespace mongo {
                               const InsertDeleteOptions& options,
                               int64_t* numDeleted) = 0;
 
+        /**
+         * Removes the keys of a batch of documents, as remove() would for each in turn, with
+         * docs and locs as for insertMany().  If not NULL, 'numDeleted' will be set to the
+         * number of keys removed for the whole batch.
+         */
+        virtual Status removeMany(OperationContext* txn,
+                                  const std::vector<const BSONFieldIndex*>& docs,
+                                  const std::vector<RecordId>& locs,
+                                  const InsertDeleteOptions& options,
+                                  int64_t* numDeleted) = 0;
+
         /**
          * Checks whether the index entries for the document 'from', which is placed at location
          * 'loc' on disk, can be changed to the index entries for the doc 'to'. Provides a ticket
@@ -113,6 +139,16 @@ namespace mongo {
                               const UpdateTicket& ticket,
                               int64_t* numUpdated) = 0;
 
+        /**
+         * Performs the validated updates of a batch of distinct documents, with the same result
+         * as update() on each ticket in turn.  If not NULL, 'numUpdated' will be set to the
+         * number of keys added for the whole batch.  On failure, some keys of the batch may have
+         * been changed and the caller must roll back the enclosing WriteUnitOfWork.
+         */
+        virtual Status updateMany(OperationContext* txn,
+                                  const std::vector<const UpdateTicket*>& tickets,
+                                  int64_t* numUpdated) = 0;
+
         /**
          * Fills in '*out' with an IndexCursor.  Return a status indicating success or reason of
          * failure. If the latter, '*out' contains NULL.  See index_cursor.h for IndexCursor usage.
@@ -157,6 +193,11 @@ namespace mongo {
         virtual Status validate(OperationContext* txn, bool full, int64_t* numKeys,
                                 BSONObjBuilder* output) = 0;
 
+        /**
+         * Fills 'keys' with the keys this index has for 'obj', as they would be inserted.
+         */
+        virtual void getKeys(const BSONObj& obj, BSONObjSet* keys) = 0;
+
         /**
          * Add custom statistics about this index to BSON object builder, for display.
          *
@@ -173,6 +214,19 @@ namespace mongo {
          */
         virtual long long getSpaceUsedBytes( OperationContext* txn ) const = 0;
 
+        /**
+         * Estimates the number of keys between 'startKey' and 'endKey' without walking them.
+         * See SortedDataInterface::estimateRangeCount.
+         *
+         * Returns false if the underlying storage cannot estimate ranges.
+         */
+        virtual bool estimateRangeCount(OperationContext* txn,
+                                        const BSONObj& startKey,
+                                        bool startKeyInclusive,
+                                        const BSONObj& endKey,
+                                        bool endKeyInclusive,
+                                        long long* estimateOut) const = 0;
+
         //
         // Bulk operations support
         //
@@ -67,6 +67,7 @@ namespace mongo {
               _parentNS(infoObj.getStringField("ns")),
               _isIdIndex(isIdIndexPattern( _keyPattern )),
               _sparse(infoObj["sparse"].trueValue()),
+              _partial(infoObj.hasField("partialFilterExpression")),
               _unique( _isIdIndex || infoObj["unique"].trueValue() ),
               _cachedEntry( NULL )
         {
@@ -126,6 +127,9 @@ namespace mongo {
         // Is this index sparse?
         bool isSparse() const { return _sparse; }
 
+        // Does this index only hold the documents matching its partialFilterExpression?
+        bool isPartial() const { return _partial; }
+
         // Is this index multikey?
         bool isMultikey( OperationContext* txn ) const {
             _checkOk();
@@ -199,6 +203,7 @@ namespace mongo {
         std::string _indexNamespace;
         bool _isIdIndex;
         bool _sparse;
+        bool _partial;
         bool _unique;
         int _version;
 
@@ -0,0 +1,84 @@
+// multikey_paths.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace mongo {
+
+    /**
+     * Which fields of a multikey index's key pattern are themselves multikey: entry i is true if
+     * some document generated more than one key with an array along the path of the i-th field.
+     * Bounds on the other fields can still be intersected and compounded as for a non-multikey
+     * index, since every key of a document holds the same value for them.
+     *
+     * An empty MultikeyPaths means the fields are not known, so all of them must be assumed
+     * multikey. That is the case for index types other than btree, and for catalogs which don't
+     * record the per-field information.
+     */
+    typedef std::vector<bool> MultikeyPaths;
+
+    /**
+     * Adds the fields made multikey by 'other' to '*paths'. If either side is unknown, so is
+     * the result.
+     */
+    inline void mergeMultikeyPaths(MultikeyPaths* paths, const MultikeyPaths& other) {
+        if (paths->size() != other.size()) {
+            paths->clear();
+            return;
+        }
+        for (size_t i = 0; i < other.size(); ++i) {
+            if (other[i]) {
+                (*paths)[i] = true;
+            }
+        }
+    }
+
+    /**
+     * Returns true if merging 'other' into 'paths' would change 'paths'.
+     */
+    inline bool multikeyPathsWouldChange(const MultikeyPaths& paths, const MultikeyPaths& other) {
+        if (paths.empty()) {
+            return false;
+        }
+        if (paths.size() != other.size()) {
+            return true;
+        }
+        for (size_t i = 0; i < other.size(); ++i) {
+            if (other[i] && !paths[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+}  // namespace mongo
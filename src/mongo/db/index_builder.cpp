@@ -135,8 +135,11 @@ namespace {
         MultiIndexBlock indexer(txn, c);
         indexer.allowInterruption();
 
-        if (allowBackgroundBuilding)
+        if (allowBackgroundBuilding) {
             indexer.allowBackgroundBuilding();
+            // Don't hold up the application of later oplog entries to the same database
+            indexer.yieldToLockWaiters();
+        }
 
         Status status = Status::OK();
         IndexDescriptor* descriptor(NULL);
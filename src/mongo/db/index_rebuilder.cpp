@@ -32,7 +32,11 @@
 
 #include "mongo/db/index_rebuilder.h"
 
+#include <algorithm>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include <list>
+#include <map>
 #include <string>
 
 #include "mongo/db/auth/authorization_session.h"
@@ -45,12 +49,18 @@
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/storage_engine.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/log.h"
 #include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
+    // Number of databases whose interrupted index builds are restarted at the same time during
+    // startup. Each database is handled by one thread, which takes an exclusive lock on it.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(indexRebuildParallelDatabases, int, 4);
+
 namespace {
     void checkNS(OperationContext* txn, const std::list<std::string>& nsToCheck) {
         bool firstTime = true;
@@ -141,6 +151,56 @@ namespace {
             }
         }
     }
+
+    /**
+     * Hands out the collections of one database at a time to the threads rebuilding indexes.
+     */
+    class DatabaseQueue {
+    public:
+        typedef std::map<std::string, std::list<std::string> > CollectionsByDb;
+
+        explicit DatabaseQueue(const CollectionsByDb& collections)
+            : _collections(collections), _next(_collections.begin()) {}
+
+        bool next(std::list<std::string>* collections) {
+            boost::mutex::scoped_lock lk(_mutex);
+            if (_next == _collections.end()) {
+                return false;
+            }
+            *collections = _next->second;
+            ++_next;
+            return true;
+        }
+
+    private:
+        boost::mutex _mutex;
+        const CollectionsByDb _collections;
+        CollectionsByDb::const_iterator _next;
+    };
+
+    void checkDatabases(OperationContext* txn, DatabaseQueue* queue) {
+        try {
+            std::list<std::string> collNames;
+            while (queue->next(&collNames)) {
+                checkNS(txn, collNames);
+            }
+        }
+        catch (const DBException& e) {
+            error() << "Index verification did not complete: " << e.toString();
+            fassertFailedNoTrace(18643);
+        }
+    }
+
+    void runCheckDatabasesThread(DatabaseQueue* queue) {
+        Client::initThread("IndexRebuilder");
+        Client& client = cc();
+        client.getAuthorizationSession()->grantInternalAuthorization();
+        {
+            OperationContextImpl txn;
+            checkDatabases(&txn, queue);
+        }
+        client.shutdown();
+    }
 } // namespace
 
     void restartInProgressIndexesFromLastShutdown(OperationContext* txn) {
@@ -151,8 +211,8 @@ namespace {
         StorageEngine* storageEngine = getGlobalEnvironment()->getGlobalStorageEngine();
         storageEngine->listDatabases( &dbNames );
 
+        DatabaseQueue::CollectionsByDb collections;
         try {
-            std::list<std::string> collNames;
             for (std::vector<std::string>::const_iterator dbName = dbNames.begin();
                  dbName < dbNames.end();
                  ++dbName) {
@@ -161,14 +221,26 @@ namespace {
                 AutoGetDb autoDb(txn, *dbName, MODE_S);
 
                 Database* db = autoDb.getDb();
-                db->getDatabaseCatalogEntry()->getCollectionNamespaces(&collNames);
+                db->getDatabaseCatalogEntry()->getCollectionNamespaces(&collections[*dbName]);
             }
-            checkNS(txn, collNames);
         }
         catch (const DBException& e) {
             error() << "Index verification did not complete: " << e.toString();
             fassertFailedNoTrace(18643);
         }
+
+        // Databases are locked exclusively while their indexes are rebuilt, so they are the unit
+        // of parallelism. This thread takes part too.
+        DatabaseQueue queue(collections);
+        const int numThreads = std::min(std::max(indexRebuildParallelDatabases, 1),
+                                        static_cast<int>(collections.size()));
+        boost::thread_group threads;
+        for (int i = 1; i < numThreads; i++) {
+            threads.create_thread(stdx::bind(runCheckDatabasesThread, &queue));
+        }
+        checkDatabases(txn, &queue);
+        threads.join_all();
+
         LOG(1) << "checking complete" << endl;
     }
 }
@@ -52,8 +52,11 @@
 #include "mongo/db/auth/authorization_manager_global.h"
 #include "mongo/db/auth/internal_user_auth.h"
 #include "mongo/db/auth/security_key.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/server_options.h"
 #include "mongo/logger/logger.h"
+#include "mongo/logger/async_file_appender.h"
+#include "mongo/logger/async_log_writer.h"
 #include "mongo/logger/console_appender.h"
 #include "mongo/logger/message_event.h"
 #include "mongo/logger/message_event_utf8_encoder.h"
@@ -196,11 +199,18 @@ namespace mongo {
             quickExit(EXIT_FAILURE);
     }
 
+namespace {
+    Counter64 droppedLogLines;
+    ServerStatusMetricField<Counter64> displayDroppedLogLines("log.droppedLines",
+                                                              &droppedLogLines);
+}  // namespace
+
     MONGO_INITIALIZER_GENERAL(ServerLogRedirection,
                               ("GlobalLogManager", "EndStartupOptionHandling", "ForkServer"),
                               ("default"))(
             InitializerContext*) {
 
+        using logger::AsyncFileAppender;
         using logger::LogManager;
         using logger::MessageEventEphemeral;
         using logger::MessageEventDetailsEncoder;
@@ -281,14 +291,34 @@ namespace mongo {
 
             LogManager* manager = logger::globalLogManager();
             manager->getGlobalDomain()->clearAppenders();
-            manager->getGlobalDomain()->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
-                            new RotatableFileAppender<MessageEventEphemeral>(
-                                    new MessageEventDetailsEncoder, writer.getValue())));
-            manager->getNamedDomain("javascriptOutput")->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
-                            new RotatableFileAppender<MessageEventEphemeral>(
-                                    new MessageEventDetailsEncoder, writer.getValue())));
+            if (serverGlobalParams.logAsyncQueueSize > 0) {
+                // Never deleted; threads may log right up until the process exits.
+                logger::AsyncLogWriter* asyncLogWriter = new logger::AsyncLogWriter(
+                        writer.getValue(),
+                        serverGlobalParams.logAsyncQueueSize,
+                        serverGlobalParams.logAsyncBlockOnOverflow ?
+                                logger::AsyncLogWriter::kBlockOnOverflow :
+                                logger::AsyncLogWriter::kDropOnOverflow,
+                        &droppedLogLines);
+                manager->getGlobalDomain()->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new AsyncFileAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, asyncLogWriter)));
+                manager->getNamedDomain("javascriptOutput")->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new AsyncFileAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, asyncLogWriter)));
+            }
+            else {
+                manager->getGlobalDomain()->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new RotatableFileAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, writer.getValue())));
+                manager->getNamedDomain("javascriptOutput")->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new RotatableFileAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, writer.getValue())));
+            }
 
             if (serverGlobalParams.logAppend && exists) {
                 log() << "***** SERVER RESTARTED *****" << endl;
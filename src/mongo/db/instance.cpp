@@ -42,6 +42,8 @@
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/background.h"
+#include "mongo/db/catalog/capped_insert_notifier.h"
+#include "mongo/db/catalog/collection.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/commands/fsync.h"
@@ -79,7 +81,10 @@
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/cpu_sampler.h"
+#include "mongo/db/stats/latency_histogram.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/logger/async_log_writer.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/s/d_state.h"
@@ -306,6 +311,15 @@ namespace mongo {
             invariant(!txn->lockState()->isLocked());
         }
 
+        // Oplog reads by other members are replication, so are admitted ahead of client
+        // operations. Commands may pick their own priority.
+        if (!fromDBDirectClient && c.isFromUserConnection()) {
+            const bool isOplogRead = (op == dbQuery || op == dbGetMore) &&
+                                     NamespaceString::oplog(dbmsg.getns());
+            txn->lockState()->setAdmissionPriority(isOplogRead ? kAdmissionInternal
+                                                               : kAdmissionInteractive);
+        }
+
         if ( op == dbQuery ) {
             const char *ns = dbmsg.getns();
 
@@ -377,6 +391,9 @@ namespace mongo {
         OpDebug& debug = currentOp.debug();
         debug.op = op;
 
+        CpuSamplerTag samplerTag(isCommand ? "command" : opToString(op),
+                                 dbmsg.messageShouldHaveNs() ? dbmsg.getns() : "");
+
         long long logThreshold = serverGlobalParams.slowMS;
         LogComponent responseComponent(LogComponent::kQuery);
         if (op == dbInsert ||
@@ -481,6 +498,7 @@ namespace mongo {
         currentOp.ensureStarted();
         currentOp.done();
         debug.executionTime = currentOp.totalTimeMillis();
+        globalOpLatencyStats.record(op, isCommand, currentOp.totalTimeMicros());
 
         logThreshold += currentOp.getExpectedLatencyMs();
 
@@ -739,9 +757,13 @@ namespace mongo {
 
         scoped_ptr<AssertionException> ex;
         scoped_ptr<Timer> timer;
+        Date_t awaitDeadline;
+        boost::shared_ptr<CappedInsertNotifier> notifier;
+        uint64_t notifierVersion = 0;
         int pass = 0;
         bool exhaust = false;
         QueryResult::View msgdata = 0;
+        auto_ptr<Message> resp(new Message());
         OpTime last;
         while( 1 ) {
             bool isCursorAuthorized = false;
@@ -767,6 +789,20 @@ namespace mongo {
                     }
                 }
 
+                if (pass == 1) {
+                    // The cursor is awaiting data: find what to wait on between attempts.
+                    AutoGetCollectionForRead ctx(txn, nsString);
+                    if (ctx.getCollection()) {
+                        notifier = ctx.getCollection()->getCappedInsertNotifier();
+                    }
+                }
+
+                // Taken before looking, so an insert landing after this getMore saw nothing
+                // still ends the wait below.
+                if (notifier) {
+                    notifierVersion = notifier->getVersion();
+                }
+
                 msgdata = getMore(txn,
                                   ns,
                                   ntoreturn,
@@ -775,7 +811,8 @@ namespace mongo {
                                   pass,
                                   exhaust,
                                   &isCursorAuthorized,
-                                  fromDBDirectClient);
+                                  fromDBDirectClient,
+                                  resp.get());
             }
             catch ( AssertionException& e ) {
                 if ( isCursorAuthorized ) {
@@ -797,6 +834,7 @@ namespace mongo {
                 massert(13073, "shutting down", !inShutdown() );
                 if ( ! timer ) {
                     timer.reset( new Timer() );
+                    awaitDeadline = Date_t( curTimeMillis64() + 4000 );
                 }
                 else {
                     if ( timer->seconds() >= 4 ) {
@@ -806,7 +844,14 @@ namespace mongo {
                     }
                 }
                 pass++;
-                if (debug)
+                if ( pass == 1 ) {
+                    // Retry straight away; the next attempt picks up the capped insert
+                    // notifier so later ones can sleep until something is inserted.
+                }
+                else if ( notifier ) {
+                    notifier->waitUntil( notifierVersion, awaitDeadline );
+                }
+                else if (debug)
                     sleepmillis(20);
                 else
                     sleepmillis(2);
@@ -833,12 +878,10 @@ namespace mongo {
             return ok;
         }
 
-        Message *resp = new Message();
-        resp->setData(msgdata.view2ptr(), true);
         curop.debug().responseLength = resp->header().dataLen();
         curop.debug().nreturned = msgdata.getNReturned();
 
-        dbresponse.response = resp;
+        dbresponse.response = resp.release();
         dbresponse.responseTo = m.header().getId();
 
         if( exhaust ) {
@@ -1157,6 +1200,7 @@ namespace mongo {
         }
 #endif
 
+        logger::flushAsyncLogWriters();
         quickExit(rc);
     }
 
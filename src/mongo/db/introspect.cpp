@@ -45,14 +45,23 @@
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/introspect.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/profile_buffer.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/util/background.h"
+#include "mongo/util/exit.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
 
     using boost::scoped_ptr;
 
+    // Whether a background thread copies the profile buffer into each database's
+    // system.profile. Only used with profileBufferSize.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(profileBufferFlushToCollection, bool, false);
+
 namespace {
     void _appendUserInfo(const CurOp& c,
                          BSONObjBuilder& builder,
@@ -81,8 +90,94 @@ namespace {
         builder.append("user", bestUser.getUser().empty() ? "" : bestUser.getFullName());
 
     }
+
+    void _appendProfileInfo(const Client& c, CurOp& currentOp, BSONObjBuilder& b) {
+        currentOp.debug().append(currentOp, b);
+
+        b.appendDate("ts", jsTime());
+        b.append("client", c.clientAddress());
+
+        AuthorizationSession * authSession = c.getAuthorizationSession();
+        _appendUserInfo(currentOp, b, authSession);
+    }
+
+    /**
+     * Inserts 'docs' into the system.profile collection of 'dbname', creating it if need be.
+     */
+    void _flushProfileDocs(OperationContext* txn,
+                           const std::string& dbname,
+                           const std::vector<BSONObj>& docs) {
+        for (int attempt = 0; attempt < 2; attempt++) {
+            // Like profile(), only take the database exclusively to create system.profile.
+            ScopedTransaction transaction(txn, MODE_IX);
+            Lock::DBLock lk(txn->lockState(), dbname, attempt == 0 ? MODE_IX : MODE_X);
+            Database* db = dbHolder().get(txn, dbname);
+            if (db == NULL) {
+                return;
+            }
+
+            Lock::CollectionLock clk(txn->lockState(), db->getProfilingNS(), MODE_X);
+            WriteUnitOfWork wunit(txn);
+            Collection* profileCollection = getOrCreateProfileCollection(txn, db);
+            if (!profileCollection) {
+                continue;
+            }
+            for (size_t i = 0; i < docs.size(); i++) {
+                profileCollection->insertDocument(txn, docs[i], false);
+            }
+            wunit.commit();
+            return;
+        }
+    }
+
+    class ProfileBufferFlusher : public BackgroundJob {
+    public:
+        virtual std::string name() const { return "ProfileBufferFlusher"; }
+
+        virtual void run() {
+            Client::initThread(name().c_str());
+            cc().getAuthorizationSession()->grantInternalAuthorization();
+
+            ProfileBuffer* buffer = getGlobalProfileBuffer();
+            unsigned long long flushedSeq = 0;
+            while (!inShutdown()) {
+                sleepsecs(1);
+
+                std::vector<ProfileBuffer::Entry> entries;
+                flushedSeq = buffer->read("", flushedSeq, BSONObjMaxUserSize, &entries);
+
+                OperationContextImpl txn;
+                size_t i = 0;
+                while (i < entries.size()) {
+                    // Flush each run of entries of the same database together.
+                    const std::string& dbname = entries[i].db;
+                    std::vector<BSONObj> docs;
+                    for (; i < entries.size() && entries[i].db == dbname; i++) {
+                        docs.push_back(entries[i].doc);
+                    }
+
+                    try {
+                        _flushProfileDocs(&txn, dbname, docs);
+                    }
+                    catch (const DBException& e) {
+                        warning() << "Caught exception while flushing the profile buffer into "
+                                  << dbname << ": " << e.toString();
+                    }
+                }
+            }
+        }
+    };
 } // namespace
 
+    void startProfileBufferFlusher() {
+        if (!getGlobalProfileBuffer() || !profileBufferFlushToCollection) {
+            return;
+        }
+
+        ProfileBufferFlusher* flusher = new ProfileBufferFlusher();
+        flusher->go();
+    }
+
     /**
      * @return if collection existed or was created
      */
@@ -95,15 +190,7 @@ namespace {
 
         // build object
         BSONObjBuilder b(profileBufBuilder);
-
-        currentOp.debug().append(currentOp, b);
-
-        b.appendDate("ts", jsTime());
-        b.append("client", c.clientAddress());
-
-        AuthorizationSession * authSession = c.getAuthorizationSession();
-        _appendUserInfo(currentOp, b, authSession);
-
+        _appendProfileInfo(c, currentOp, b);
         BSONObj p = b.done();
 
         WriteUnitOfWork wunit(txn);
@@ -120,6 +207,14 @@ namespace {
     }
 
     void profile(OperationContext* txn, const Client& c, int op, CurOp& currentOp) {
+        if (ProfileBuffer* buffer = getGlobalProfileBuffer()) {
+            // No locks and no write, the flusher (if any) gets it into system.profile later.
+            BSONObjBuilder b;
+            _appendProfileInfo(c, currentOp, b);
+            buffer->push(nsToDatabaseSubstring(currentOp.getNS()), b.obj());
+            return;
+        }
+
         bool tryAgain = false;
         while ( 1 ) {
             try {
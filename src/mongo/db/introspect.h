@@ -48,6 +48,12 @@ namespace mongo {
 
     void profile(OperationContext* txn, const Client& c, int op, CurOp& currentOp);
 
+    /**
+     * Starts the thread copying the profile buffer into system.profile, when there is a profile
+     * buffer and the profileBufferFlushToCollection server parameter is set.
+     */
+    void startProfileBufferFlusher();
+
     /**
      * Get (or create) the profile collection
      *
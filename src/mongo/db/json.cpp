@@ -33,6 +33,7 @@
 
 #include "mongo/base/parse_number.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/json_fast_path.h"
 #include "mongo/platform/cstdint.h"
 #include "mongo/platform/strtoll.h"
 #include "mongo/util/base64.h"
@@ -1261,7 +1262,12 @@ namespace mongo {
             if (len) *len = 0;
             return BSONObj();
         }
-        JParse jparse(jsonString);
+        const StringData json(jsonString);
+        BSONObj fast;
+        if (fromjsonFastPath(json, &fast, len)) {
+            return fast;
+        }
+        JParse jparse(json);
         BSONObjBuilder builder;
         Status ret = Status::OK();
         try {
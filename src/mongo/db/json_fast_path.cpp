@@ -0,0 +1,461 @@
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/json_fast_path.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MONGO_JSON_FAST_PATH_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "mongo/base/data_view.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/platform/bits.h"
+#include "mongo/platform/strtoll.h"
+
+namespace mongo {
+
+namespace {
+
+    // Objects nested deeper than this are left to JParse.
+    const int kMaxDepth = 100;
+
+    // First field names that JParse::object turns into a value of another type.
+    const char* const kReservedFieldNames[] = {
+        "$oid", "$binary", "$date", "$timestamp", "$regex",
+        "$ref", "$undefined", "$numberLong", "$minKey", "$maxKey",
+    };
+
+    inline bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    inline bool isStringSpecial(char c) {
+        return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+    }
+
+    /**
+     * @return the first quote, backslash or control character in [p, end), or end
+     */
+    inline const char* findStringSpecial(const char* p, const char* end) {
+#ifdef MONGO_JSON_FAST_PATH_SSE2
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i lastControl = _mm_set1_epi8(0x1F);
+        for (; end - p >= 16; p += 16) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            // bytes <= 0x1F as unsigned: max(bytes, 0x1F) is then 0x1F.
+            const __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(bytes, lastControl),
+                                                   lastControl);
+            const __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, quote),
+                                                              _mm_cmpeq_epi8(bytes, backslash)),
+                                                 control);
+            const unsigned mask = _mm_movemask_epi8(special);
+            if (mask) {
+                return p + countTrailingZeros64(mask);
+            }
+        }
+#endif
+        while (p < end && !isStringSpecial(*p)) {
+            ++p;
+        }
+        return p;
+    }
+
+    /**
+     * A single pass recursive descent parser for strict JSON that appends BSON elements to a
+     * BufBuilder.  Every method returns false as soon as the input leaves the supported subset.
+     */
+    class StrictJsonParser {
+    public:
+        StrictJsonParser(const StringData& json, BufBuilder& bb)
+            : _begin(json.rawData()),
+              _p(_begin),
+              _end(_begin + json.size()),
+              _bb(bb) {
+        }
+
+        /**
+         * Appends the elements of the top level object or array, as JParse::parse does.
+         */
+        bool parse() {
+            skipWhitespace();
+            if (_p == _end) {
+                return false;
+            }
+            const char c = *_p++;
+            if (c == '{') {
+                return objectBody(0);
+            }
+            if (c == '[') {
+                return arrayBody(0);
+            }
+            return false;
+        }
+
+        int offset() const {
+            return _p - _begin;
+        }
+
+    private:
+        void skipWhitespace() {
+            while (_p < _end && (*_p == ' ' || *_p == '\n' || *_p == '\r' || *_p == '\t')) {
+                ++_p;
+            }
+        }
+
+        bool consume(char c) {
+            skipWhitespace();
+            if (_p < _end && *_p == c) {
+                ++_p;
+                return true;
+            }
+            return false;
+        }
+
+        bool isReservedFieldName(int offset) const {
+            const char* name = _bb.buf() + offset;
+            if (*name != '$') {
+                return false;
+            }
+            for (size_t i = 0;
+                 i < sizeof(kReservedFieldNames) / sizeof(kReservedFieldNames[0]);
+                 ++i) {
+                if (strcmp(name, kReservedFieldNames[i]) == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Called after '{'; consumes up to and including the matching '}'.
+         */
+        bool objectBody(int depth) {
+            if (consume('}')) {
+                return true;
+            }
+            bool first = true;
+            do {
+                if (!consume('"')) {
+                    return false;
+                }
+                // The type byte is only known once the value has been seen.
+                const int typeOffset = _bb.len();
+                _bb.skip(1);
+                const int nameOffset = _bb.len();
+                if (!stringBody()) {
+                    return false;
+                }
+                _bb.appendChar('\0');
+                if (first && isReservedFieldName(nameOffset)) {
+                    return false;
+                }
+                first = false;
+                if (!consume(':')) {
+                    return false;
+                }
+                if (!value(typeOffset, depth)) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume('}');
+        }
+
+        /**
+         * Called after '['; consumes up to and including the matching ']'.
+         */
+        bool arrayBody(int depth) {
+            if (consume(']')) {
+                return true;
+            }
+            unsigned index = 0;
+            do {
+                const int typeOffset = _bb.len();
+                _bb.skip(1);
+                appendIndexFieldName(index++);
+                if (!value(typeOffset, depth)) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(']');
+        }
+
+        void appendIndexFieldName(unsigned index) {
+            char digits[16];
+            char* start = digits + sizeof(digits);
+            *--start = '\0';
+            do {
+                *--start = static_cast<char>('0' + index % 10);
+                index /= 10;
+            } while (index);
+            _bb.appendBuf(start, digits + sizeof(digits) - start);
+        }
+
+        bool value(int typeOffset, int depth) {
+            skipWhitespace();
+            if (_p == _end) {
+                return false;
+            }
+            switch (*_p) {
+            case '"': {
+                ++_p;
+                _bb.buf()[typeOffset] = String;
+                const int sizeOffset = _bb.len();
+                _bb.skip(4);
+                if (!stringBody()) {
+                    return false;
+                }
+                _bb.appendChar('\0');
+                DataView(_bb.buf() + sizeOffset).writeLE<int>(_bb.len() - sizeOffset - 4);
+                return true;
+            }
+            case '{':
+            case '[': {
+                const bool isObject = *_p++ == '{';
+                if (depth >= kMaxDepth) {
+                    return false;
+                }
+                _bb.buf()[typeOffset] = isObject ? Object : Array;
+                const int sizeOffset = _bb.len();
+                _bb.skip(4);
+                if (!(isObject ? objectBody(depth + 1) : arrayBody(depth + 1))) {
+                    return false;
+                }
+                _bb.appendChar(EOO);
+                DataView(_bb.buf() + sizeOffset).writeLE<int>(_bb.len() - sizeOffset);
+                return true;
+            }
+            case 't':
+                if (!literal("true")) {
+                    return false;
+                }
+                _bb.buf()[typeOffset] = Bool;
+                _bb.appendChar(1);
+                return true;
+            case 'f':
+                if (!literal("false")) {
+                    return false;
+                }
+                _bb.buf()[typeOffset] = Bool;
+                _bb.appendChar(0);
+                return true;
+            case 'n':
+                if (!literal("null")) {
+                    return false;
+                }
+                _bb.buf()[typeOffset] = jstNULL;
+                return true;
+            default:
+                return number(typeOffset);
+            }
+        }
+
+        bool literal(const char* word) {
+            const size_t size = strlen(word);
+            if (static_cast<size_t>(_end - _p) < size || memcmp(_p, word, size) != 0) {
+                return false;
+            }
+            _p += size;
+            return true;
+        }
+
+        /**
+         * Called after the opening quote; appends the unescaped bytes, without a terminating
+         * NUL, and consumes the closing quote.
+         */
+        bool stringBody() {
+            while (true) {
+                const char* special = findStringSpecial(_p, _end);
+                _bb.appendBuf(_p, special - _p);
+                _p = special;
+                if (_p == _end) {
+                    return false;
+                }
+                const char c = *_p++;
+                if (c == '"') {
+                    return true;
+                }
+                if (c != '\\' || _p == _end) {
+                    // Control characters are an error, which JParse reports.
+                    return false;
+                }
+                switch (*_p++) {
+                case '"':  _bb.appendChar('"');  break;
+                case '\\': _bb.appendChar('\\'); break;
+                case '/':  _bb.appendChar('/');  break;
+                case 'b':  _bb.appendChar('\b'); break;
+                case 'f':  _bb.appendChar('\f'); break;
+                case 'n':  _bb.appendChar('\n'); break;
+                case 'r':  _bb.appendChar('\r'); break;
+                case 't':  _bb.appendChar('\t'); break;
+                default:   return false;
+                }
+            }
+        }
+
+        /**
+         * Accepts the JSON number grammar and picks the type the way JParse::number does: a
+         * fraction or exponent, or an integer outside 64 bits, is a double; otherwise the
+         * smallest of int and long long that holds the value.
+         */
+        bool number(int typeOffset) {
+            const char* start = _p;
+            if (*_p == '-') {
+                ++_p;
+            }
+            if (_p == _end || !isDigit(*_p)) {
+                return false;
+            }
+            if (*_p == '0') {
+                ++_p;
+                if (_p < _end && isDigit(*_p)) {
+                    return false;
+                }
+            }
+            else {
+                while (_p < _end && isDigit(*_p)) {
+                    ++_p;
+                }
+            }
+            bool isInteger = true;
+            if (_p < _end && *_p == '.') {
+                isInteger = false;
+                if (!digits()) {
+                    return false;
+                }
+            }
+            if (_p < _end && (*_p == 'e' || *_p == 'E')) {
+                isInteger = false;
+                if (_p + 1 < _end && (_p[1] == '+' || _p[1] == '-')) {
+                    ++_p;
+                }
+                if (!digits()) {
+                    return false;
+                }
+            }
+
+            if (isInteger) {
+                long long value;
+                // Up to 18 digits always fit in a long long.
+                if (_p - start <= 18) {
+                    const bool negative = *start == '-';
+                    value = 0;
+                    for (const char* d = start + negative; d < _p; ++d) {
+                        value = value * 10 + (*d - '0');
+                    }
+                    if (negative) {
+                        value = -value;
+                    }
+                }
+                else {
+                    errno = 0;
+                    char* endptr;
+                    value = strtoll(start, &endptr, 10);
+                    if (errno == ERANGE) {
+                        return appendDouble(typeOffset, start);
+                    }
+                    if (endptr != _p) {
+                        return false;
+                    }
+                }
+                if (value == static_cast<int>(value)) {
+                    _bb.buf()[typeOffset] = NumberInt;
+                    _bb.appendNum(static_cast<int>(value));
+                }
+                else {
+                    _bb.buf()[typeOffset] = NumberLong;
+                    _bb.appendNum(value);
+                }
+                return true;
+            }
+            return appendDouble(typeOffset, start);
+        }
+
+        /**
+         * Consumes the character at _p followed by one or more digits.
+         */
+        bool digits() {
+            ++_p;
+            if (_p == _end || !isDigit(*_p)) {
+                return false;
+            }
+            while (_p < _end && isDigit(*_p)) {
+                ++_p;
+            }
+            return true;
+        }
+
+        bool appendDouble(int typeOffset, const char* start) {
+            errno = 0;
+            char* endptr;
+            const double value = strtod(start, &endptr);
+            if (endptr != _p || errno == ERANGE) {
+                return false;
+            }
+            _bb.buf()[typeOffset] = NumberDouble;
+            _bb.appendNum(value);
+            return true;
+        }
+
+        const char* const _begin;
+        const char* _p;
+        const char* const _end;
+        BufBuilder& _bb;
+    };
+
+} // namespace
+
+    bool fromjsonFastPath(const StringData& json, BSONObj* result, int* len) {
+        // BSON is rarely much larger than the JSON it came from.
+        BSONObjBuilder builder(static_cast<int>(
+            std::min(json.size(), static_cast<size_t>(BSONObjMaxUserSize))) + 64);
+        StrictJsonParser parser(json, builder.bb());
+        try {
+            if (!parser.parse()) {
+                return false;
+            }
+            *result = builder.obj();
+        }
+        catch (const std::exception&) {
+            // Let the full parser report a document that grows too large.
+            return false;
+        }
+        if (len) *len = parser.offset();
+        return true;
+    }
+
+} // namespace mongo
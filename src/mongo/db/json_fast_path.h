@@ -0,0 +1,55 @@
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/string_data.h"
+
+namespace mongo {
+
+    class BSONObj;
+
+    /**
+     * Parses 'json' if it is strict JSON: an object or array built from double quoted keys and
+     * strings with only the simple backslash escapes, JSON numbers, true, false and null.
+     *
+     * Returns false, leaving 'result' and 'len' untouched, for anything else -- extended JSON
+     * ({$oid: ...}, ObjectId(...), /regex/, ...), the lenient syntax JParse accepts (unquoted or
+     * single quoted keys, NaN, leading zeros, ...), \u escapes, and malformed input.  The caller
+     * then parses the input with the full parser, which either handles it or reports the error.
+     * When it returns true, 'result' and 'len' are exactly what the full parser would produce.
+     *
+     * String bodies are scanned 16 bytes at a time with SSE2 where the compiler targets it, and
+     * elements are written straight into a BSON buffer sized from the input.
+     *
+     * 'json' must be followed by a NUL byte, as a C string is.
+     */
+    bool fromjsonFastPath(const StringData& json, BSONObj* result, int* len);
+
+} // namespace mongo
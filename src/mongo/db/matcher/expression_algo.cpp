@@ -0,0 +1,214 @@
+// expression_algo.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/expression_algo.h"
+
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_leaf.h"
+
+namespace mongo {
+namespace expression {
+
+    namespace {
+
+        bool isComparison(const MatchExpression* expr) {
+            switch (expr->matchType()) {
+            case MatchExpression::EQ:
+            case MatchExpression::LT:
+            case MatchExpression::LTE:
+            case MatchExpression::GT:
+            case MatchExpression::GTE:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        /**
+         * Whether a comparison against 'value' can only match fields that are present, and
+         * compares by value rather than by the rules for arrays, nulls and the type bounds.
+         */
+        bool isPlainValue(const BSONElement& value) {
+            switch (value.type()) {
+            case Array:
+            case jstNULL:
+            case Undefined:
+            case MinKey:
+            case MaxKey:
+                return false;
+            default:
+                return true;
+            }
+        }
+
+        /**
+         * Both arguments are comparisons on the same path. Comparisons only ever match values of
+         * the same canonical type, which lets the bounds be compared directly.
+         */
+        bool comparisonIsSubsetOf(const ComparisonMatchExpression* lhs,
+                                  const ComparisonMatchExpression* rhs) {
+            const BSONElement& lhsData = lhs->getData();
+            const BSONElement& rhsData = rhs->getData();
+
+            if (lhs->matchType() == MatchExpression::EQ &&
+                rhs->matchType() == MatchExpression::EQ) {
+                return lhsData.woCompare(rhsData, false) == 0;
+            }
+
+            if (!isPlainValue(lhsData) || !isPlainValue(rhsData) ||
+                lhsData.canonicalType() != rhsData.canonicalType()) {
+                return false;
+            }
+
+            const int cmp = lhsData.woCompare(rhsData, false);
+            switch (rhs->matchType()) {
+            case MatchExpression::LT:
+                return (lhs->matchType() == MatchExpression::LT && cmp <= 0) ||
+                       ((lhs->matchType() == MatchExpression::EQ ||
+                         lhs->matchType() == MatchExpression::LTE) && cmp < 0);
+            case MatchExpression::LTE:
+                return (lhs->matchType() == MatchExpression::EQ ||
+                        lhs->matchType() == MatchExpression::LT ||
+                        lhs->matchType() == MatchExpression::LTE) && cmp <= 0;
+            case MatchExpression::GT:
+                return (lhs->matchType() == MatchExpression::GT && cmp >= 0) ||
+                       ((lhs->matchType() == MatchExpression::EQ ||
+                         lhs->matchType() == MatchExpression::GTE) && cmp > 0);
+            case MatchExpression::GTE:
+                return (lhs->matchType() == MatchExpression::EQ ||
+                        lhs->matchType() == MatchExpression::GT ||
+                        lhs->matchType() == MatchExpression::GTE) && cmp >= 0;
+            default:
+                return false;
+            }
+        }
+
+        /**
+         * Whether 'lhs' can only match documents in which its path is present.
+         */
+        bool impliesExists(const MatchExpression* lhs) {
+            if (isComparison(lhs)) {
+                return isPlainValue(static_cast<const ComparisonMatchExpression*>(lhs)->getData());
+            }
+
+            switch (lhs->matchType()) {
+            case MatchExpression::EXISTS:
+            case MatchExpression::TYPE_OPERATOR:
+                return true;
+            case MatchExpression::MATCH_IN: {
+                const ArrayFilterEntries& entries =
+                    static_cast<const InMatchExpression*>(lhs)->getData();
+                return !entries.hasNull() && entries.size() > 0;
+            }
+            default:
+                return false;
+            }
+        }
+
+        /**
+         * Both arguments are path expressions on the same path.
+         */
+        bool leafIsSubsetOf(const MatchExpression* lhs, const MatchExpression* rhs) {
+            if (isComparison(lhs) && isComparison(rhs)) {
+                return comparisonIsSubsetOf(static_cast<const ComparisonMatchExpression*>(lhs),
+                                            static_cast<const ComparisonMatchExpression*>(rhs));
+            }
+
+            switch (rhs->matchType()) {
+            case MatchExpression::EXISTS:
+                return impliesExists(lhs);
+            case MatchExpression::TYPE_OPERATOR: {
+                const int type = static_cast<const TypeMatchExpression*>(rhs)->getData();
+                if (lhs->matchType() == MatchExpression::TYPE_OPERATOR) {
+                    return static_cast<const TypeMatchExpression*>(lhs)->getData() == type;
+                }
+                if (lhs->matchType() == MatchExpression::EQ) {
+                    const BSONElement& data =
+                        static_cast<const ComparisonMatchExpression*>(lhs)->getData();
+                    return data.type() == type && data.type() != Array;
+                }
+                return false;
+            }
+            default:
+                return lhs->equivalent(rhs);
+            }
+        }
+
+        bool isPathLeaf(const MatchExpression* expr) {
+            return isComparison(expr) ||
+                   expr->matchType() == MatchExpression::EXISTS ||
+                   expr->matchType() == MatchExpression::TYPE_OPERATOR ||
+                   expr->matchType() == MatchExpression::MATCH_IN;
+        }
+
+    }  // namespace
+
+    bool isSubsetOf(const MatchExpression* lhs, const MatchExpression* rhs) {
+        if (rhs->matchType() == MatchExpression::AND) {
+            for (size_t i = 0; i < rhs->numChildren(); i++) {
+                if (!isSubsetOf(lhs, rhs->getChild(i))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        if (lhs->matchType() == MatchExpression::AND) {
+            for (size_t i = 0; i < lhs->numChildren(); i++) {
+                if (isSubsetOf(lhs->getChild(i), rhs)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        if (lhs->matchType() == MatchExpression::OR) {
+            if (lhs->numChildren() == 0) {
+                return false;
+            }
+            for (size_t i = 0; i < lhs->numChildren(); i++) {
+                if (!isSubsetOf(lhs->getChild(i), rhs)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        if (isPathLeaf(lhs) && isPathLeaf(rhs)) {
+            return lhs->path() == rhs->path() && leafIsSubsetOf(lhs, rhs);
+        }
+
+        return false;
+    }
+
+}  // namespace expression
+}  // namespace mongo
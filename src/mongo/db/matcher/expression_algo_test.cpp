@@ -0,0 +1,132 @@
+// expression_algo_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/** Unit tests for expression::isSubsetOf, in expression_algo.{h,cpp}. */
+
+#include "mongo/unittest/unittest.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_algo.h"
+#include "mongo/db/matcher/expression_parser.h"
+
+namespace mongo {
+
+    using boost::scoped_ptr;
+
+    namespace {
+
+        MatchExpression* parse(const char* query) {
+            StatusWithMatchExpression result = MatchExpressionParser::parse(fromjson(query));
+            ASSERT_OK(result.getStatus());
+            return result.getValue();
+        }
+
+        bool isSubsetOf(const char* lhs, const char* rhs) {
+            scoped_ptr<MatchExpression> lhsExpr(parse(lhs));
+            scoped_ptr<MatchExpression> rhsExpr(parse(rhs));
+            return expression::isSubsetOf(lhsExpr.get(), rhsExpr.get());
+        }
+
+    }  // namespace
+
+    TEST(ExpressionAlgoIsSubsetOf, Equality) {
+        ASSERT(isSubsetOf("{a: 5}", "{a: 5}"));
+        ASSERT(isSubsetOf("{a: 'active'}", "{a: 'active'}"));
+        ASSERT(isSubsetOf("{a: null}", "{a: null}"));
+        ASSERT(!isSubsetOf("{a: 5}", "{a: 6}"));
+        ASSERT(!isSubsetOf("{a: 5}", "{b: 5}"));
+        ASSERT(!isSubsetOf("{a: {$gt: 4}}", "{a: 5}"));
+    }
+
+    TEST(ExpressionAlgoIsSubsetOf, Ranges) {
+        ASSERT(isSubsetOf("{a: 5}", "{a: {$gt: 4}}"));
+        ASSERT(isSubsetOf("{a: 5}", "{a: {$gte: 5}}"));
+        ASSERT(!isSubsetOf("{a: 5}", "{a: {$gt: 5}}"));
+        ASSERT(isSubsetOf("{a: {$gt: 10}}", "{a: {$gt: 5}}"));
+        ASSERT(isSubsetOf("{a: {$gt: 5}}", "{a: {$gte: 5}}"));
+        ASSERT(!isSubsetOf("{a: {$gte: 5}}", "{a: {$gt: 5}}"));
+        ASSERT(isSubsetOf("{a: {$lt: 3}}", "{a: {$lte: 3}}"));
+        ASSERT(isSubsetOf("{a: {$lte: 2}}", "{a: {$lt: 3}}"));
+        ASSERT(!isSubsetOf("{a: {$lt: 3}}", "{a: {$gt: 1}}"));
+        ASSERT(!isSubsetOf("{a: {$gt: 5}}", "{a: {$lt: 10}}"));
+    }
+
+    TEST(ExpressionAlgoIsSubsetOf, RangesNeedTheSameType) {
+        ASSERT(isSubsetOf("{a: 5.5}", "{a: {$gt: 5}}"));
+        ASSERT(!isSubsetOf("{a: 'x'}", "{a: {$gt: 5}}"));
+        ASSERT(!isSubsetOf("{a: {$lt: 'x'}}", "{a: {$lt: 5}}"));
+        ASSERT(!isSubsetOf("{a: null}", "{a: {$gte: null}}"));
+        ASSERT(!isSubsetOf("{a: [1, 2]}", "{a: {$gt: 0}}"));
+    }
+
+    TEST(ExpressionAlgoIsSubsetOf, Exists) {
+        ASSERT(isSubsetOf("{a: 5}", "{a: {$exists: true}}"));
+        ASSERT(isSubsetOf("{a: {$lt: 5}}", "{a: {$exists: true}}"));
+        ASSERT(isSubsetOf("{a: {$type: 2}}", "{a: {$exists: true}}"));
+        ASSERT(isSubsetOf("{a: {$in: [1, 2]}}", "{a: {$exists: true}}"));
+        ASSERT(isSubsetOf("{a: {$exists: true}}", "{a: {$exists: true}}"));
+        ASSERT(!isSubsetOf("{a: null}", "{a: {$exists: true}}"));
+        ASSERT(!isSubsetOf("{a: {$in: [1, null]}}", "{a: {$exists: true}}"));
+        ASSERT(!isSubsetOf("{b: 5}", "{a: {$exists: true}}"));
+    }
+
+    TEST(ExpressionAlgoIsSubsetOf, Type) {
+        ASSERT(isSubsetOf("{a: {$type: 2}}", "{a: {$type: 2}}"));
+        ASSERT(isSubsetOf("{a: 'x'}", "{a: {$type: 2}}"));
+        ASSERT(!isSubsetOf("{a: 5}", "{a: {$type: 2}}"));
+        ASSERT(!isSubsetOf("{a: {$type: 1}}", "{a: {$type: 2}}"));
+    }
+
+    TEST(ExpressionAlgoIsSubsetOf, And) {
+        ASSERT(isSubsetOf("{a: 5, b: 1}", "{a: {$gt: 3}}"));
+        ASSERT(isSubsetOf("{a: 5, b: 1}", "{a: 5, b: {$exists: true}}"));
+        ASSERT(!isSubsetOf("{a: 5}", "{a: 5, b: 1}"));
+        ASSERT(isSubsetOf("{$and: [{a: 5}, {b: 1}]}", "{b: 1}"));
+        ASSERT(isSubsetOf("{a: {$gt: 5, $lt: 10}}", "{a: {$lt: 20}}"));
+    }
+
+    TEST(ExpressionAlgoIsSubsetOf, Or) {
+        ASSERT(isSubsetOf("{$or: [{a: 5}, {a: 6}]}", "{a: {$gt: 4}}"));
+        ASSERT(!isSubsetOf("{$or: [{a: 5}, {a: 3}]}", "{a: {$gt: 4}}"));
+        ASSERT(isSubsetOf("{$or: [{a: 5, b: 1}, {a: 6}]}", "{a: {$gt: 4}}"));
+        ASSERT(!isSubsetOf("{a: 5}", "{$or: [{a: 5}, {a: 6}]}"));
+    }
+
+    TEST(ExpressionAlgoIsSubsetOf, OtherExpressionsAreNotSubsets) {
+        ASSERT(!isSubsetOf("{a: {$not: {$lt: 5}}}", "{a: {$exists: true}}"));
+        ASSERT(!isSubsetOf("{a: {$elemMatch: {$gt: 5}}}", "{a: {$gt: 5}}"));
+        ASSERT(!isSubsetOf("{a: /x/}", "{a: {$exists: true}}"));
+        ASSERT(!isSubsetOf("{}", "{a: {$exists: true}}"));
+    }
+
+}  // namespace mongo
@@ -0,0 +1,312 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/expression_compiled.h"
+
+#include "mongo/db/field_ref.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/matcher/matchable.h"
+#include "mongo/platform/float_utils.h"
+
+namespace mongo {
+
+    using std::vector;
+
+    namespace {
+
+        /**
+         * Whether 'expr' is a leaf which matches the single element along its path, when there is
+         * no array on the way, with matchesSingleElement().
+         */
+        bool isCompilableLeaf(const MatchExpression* expr) {
+            switch (expr->matchType()) {
+            case MatchExpression::EQ:
+            case MatchExpression::LT:
+            case MatchExpression::LTE:
+            case MatchExpression::GT:
+            case MatchExpression::GTE:
+            case MatchExpression::REGEX:
+            case MatchExpression::MOD:
+            case MatchExpression::EXISTS:
+            case MatchExpression::MATCH_IN:
+                return !static_cast<const LeafMatchExpression*>(expr)->path().empty();
+            default:
+                return false;
+            }
+        }
+
+        template <typename T>
+        int compareValues(T lhs, T rhs) {
+            if (lhs < rhs)
+                return -1;
+            return lhs == rhs ? 0 : 1;
+        }
+
+    }  // namespace
+
+    CompiledMatchExpression::Leaf::Leaf(const LeafMatchExpression* expr)
+        : expr(expr),
+          matchType(expr->matchType()),
+          kind(GENERIC),
+          integralValue(0),
+          doubleValue(0) {
+
+        switch (matchType) {
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+            break;
+        default:
+            return;
+        }
+
+        const BSONElement& rhs = static_cast<const ComparisonMatchExpression*>(expr)->getRHS();
+        switch (rhs.type()) {
+        case NumberInt:
+        case NumberLong:
+            kind = INTEGRAL;
+            integralValue = rhs.numberLong();
+            break;
+        case NumberDouble:
+            if (!isNaN(rhs.numberDouble())) {
+                kind = DOUBLE;
+                doubleValue = rhs.numberDouble();
+            }
+            break;
+        case String:
+            kind = STRING;
+            stringValue = StringData(rhs.valuestr(), rhs.valuestrsize() - 1);
+            break;
+        default:
+            break;
+        }
+    }
+
+    bool CompiledMatchExpression::Leaf::matchesSingleElement(const BSONElement& e) const {
+        int cmp;
+        switch (kind) {
+        case INTEGRAL:
+            if (e.type() != NumberInt && e.type() != NumberLong)
+                return expr->matchesSingleElement(e);
+            cmp = compareValues(e.numberLong(), integralValue);
+            break;
+        case DOUBLE:
+            if (e.type() != NumberDouble || isNaN(e._numberDouble()))
+                return expr->matchesSingleElement(e);
+            cmp = compareValues(e._numberDouble(), doubleValue);
+            break;
+        case STRING:
+            if (e.type() != String)
+                return expr->matchesSingleElement(e);
+            cmp = StringData(e.valuestr(), e.valuestrsize() - 1).compare(stringValue);
+            break;
+        default:
+            return expr->matchesSingleElement(e);
+        }
+
+        switch (matchType) {
+        case MatchExpression::LT:
+            return cmp < 0;
+        case MatchExpression::LTE:
+            return cmp <= 0;
+        case MatchExpression::EQ:
+            return cmp == 0;
+        case MatchExpression::GT:
+            return cmp > 0;
+        case MatchExpression::GTE:
+            return cmp >= 0;
+        default:
+            invariant(false);
+            return false;
+        }
+    }
+
+    CompiledMatchExpression::CompiledMatchExpression(const MatchExpression* expr)
+        : _expr(expr),
+          _nodes(1) {
+
+        if (!_expr)
+            return;
+
+        if (_expr->matchType() != MatchExpression::AND) {
+            if (isCompilableLeaf(_expr)) {
+                addLeaf(static_cast<const LeafMatchExpression*>(_expr));
+            }
+            else {
+                _others.push_back(_expr);
+            }
+        }
+        else {
+            for (size_t i = 0; i < _expr->numChildren(); ++i) {
+                const MatchExpression* child = _expr->getChild(i);
+                if (!isCompilableLeaf(child) ||
+                    !addLeaf(static_cast<const LeafMatchExpression*>(child))) {
+                    _others.push_back(child);
+                }
+            }
+        }
+
+        collectLeaves(0);
+    }
+
+    bool CompiledMatchExpression::addLeaf(const LeafMatchExpression* expr) {
+        FieldRef path;
+        path.parse(expr->path());
+
+        // Find the nodes we need to add first, so nothing is added if one would have too many
+        // children.
+        size_t nodeIndex = 0;
+        size_t part = 0;
+        for (; part < path.numParts(); ++part) {
+            const PathNode& node = _nodes[nodeIndex];
+            size_t child = 0;
+            while (child < node.children.size() &&
+                   _nodes[node.children[child]].fieldName != path.getPart(part)) {
+                ++child;
+            }
+            if (child == node.children.size()) {
+                if (node.children.size() >= kMaxChildrenPerNode)
+                    return false;
+                break;
+            }
+            nodeIndex = node.children[child];
+        }
+
+        for (; part < path.numParts(); ++part) {
+            _nodes.push_back(PathNode());
+            _nodes.back().fieldName = path.getPart(part).toString();
+            _nodes[nodeIndex].children.push_back(_nodes.size() - 1);
+            nodeIndex = _nodes.size() - 1;
+        }
+
+        _nodes[nodeIndex].leaves.push_back(_leaves.size());
+        _leaves.push_back(Leaf(expr));
+        return true;
+    }
+
+    void CompiledMatchExpression::collectLeaves(size_t nodeIndex) {
+        vector<size_t> allLeaves(_nodes[nodeIndex].leaves);
+        for (size_t i = 0; i < _nodes[nodeIndex].children.size(); ++i) {
+            size_t child = _nodes[nodeIndex].children[i];
+            collectLeaves(child);
+            allLeaves.insert(allLeaves.end(),
+                             _nodes[child].allLeaves.begin(),
+                             _nodes[child].allLeaves.end());
+        }
+        _nodes[nodeIndex].allLeaves.swap(allLeaves);
+    }
+
+    bool CompiledMatchExpression::matchesBSON(const BSONObj& doc, MatchDetails* details) const {
+        if (!_expr)
+            return true;
+
+        // Recording where in an array a leaf matched needs the usual iteration over the path.
+        if (_leaves.empty() || (details && details->needRecord()))
+            return _expr->matchesBSON(doc, details);
+
+        BSONMatchableDocument matchable(doc);
+        bool matched = matchesChildren(_nodes[0], doc, &matchable, details);
+        for (size_t i = 0; matched && i < _others.size(); ++i) {
+            matched = _others[i]->matches(&matchable, details);
+        }
+
+        if (!matched && details && _expr->matchType() == MatchExpression::AND)
+            details->resetOutput();
+        return matched;
+    }
+
+    bool CompiledMatchExpression::matchesChildren(const PathNode& node,
+                                                  const BSONObj& obj,
+                                                  const MatchableDocument* doc,
+                                                  MatchDetails* details) const {
+        const size_t numChildren = node.children.size();
+        if (numChildren == 0)
+            return true;
+
+        // Like getField(), each child gets the first field with its name.
+        unsigned long long found = 0;
+        size_t numFound = 0;
+        BSONObjIterator it(obj);
+        while (numFound < numChildren && it.more()) {
+            BSONElement e = it.next();
+            for (size_t i = 0; i < numChildren; ++i) {
+                const unsigned long long bit = 1ULL << i;
+                if ((found & bit) || _nodes[node.children[i]].fieldName != e.fieldNameStringData())
+                    continue;
+                found |= bit;
+                ++numFound;
+                if (!matchesNode(_nodes[node.children[i]], e, doc, details))
+                    return false;
+                break;
+            }
+        }
+
+        for (size_t i = 0; numFound < numChildren && i < numChildren; ++i) {
+            if (found & (1ULL << i))
+                continue;
+            if (!matchesNode(_nodes[node.children[i]], BSONElement(), doc, details))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool CompiledMatchExpression::matchesNode(const PathNode& node,
+                                              const BSONElement& e,
+                                              const MatchableDocument* doc,
+                                              MatchDetails* details) const {
+        if (e.type() == Array) {
+            // The leaves at or below the array may match any of several elements.
+            for (size_t i = 0; i < node.allLeaves.size(); ++i) {
+                if (!_leaves[node.allLeaves[i]].expr->matches(doc, details))
+                    return false;
+            }
+            return true;
+        }
+
+        for (size_t i = 0; i < node.leaves.size(); ++i) {
+            if (!_leaves[node.leaves[i]].matchesSingleElement(e))
+                return false;
+        }
+
+        if (e.type() == Object)
+            return matchesChildren(node, e.embeddedObject(), doc, details);
+
+        // A path which goes on below a missing field or a scalar finds nothing.
+        for (size_t i = 0; i < node.children.size(); ++i) {
+            if (!matchesNode(_nodes[node.children[i]], BSONElement(), doc, details))
+                return false;
+        }
+        return true;
+    }
+
+}  // namespace mongo
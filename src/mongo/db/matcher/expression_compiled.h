@@ -0,0 +1,158 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+    class LeafMatchExpression;
+    class MatchableDocument;
+
+    /**
+     * A MatchExpression compiled for matching BSON documents with fewer passes over them than
+     * MatchExpression::matchesBSON() takes.
+     *
+     * The leaves of the expression's top level $and (or the expression itself, if it is a leaf)
+     * are arranged in a tree by path. Matching walks each document and subdocument on the way
+     * only once, to find the fields of all the leaves below it, where each leaf normally walks the
+     * document to its own field. Comparisons with numbers and strings have fast paths for values
+     * of the same kind.
+     *
+     * Arrays along a path make a leaf match any of several elements, so a leaf which finds one is
+     * matched the usual way instead. So are the children of the $and which aren't leaves.
+     *
+     * The expression must outlive the compiled form and must not be changed after compilation.
+     */
+    class CompiledMatchExpression {
+        MONGO_DISALLOW_COPYING(CompiledMatchExpression);
+    public:
+        explicit CompiledMatchExpression(const MatchExpression* expr);
+
+        /**
+         * Returns what 'expr->matchesBSON(doc, details)' would.
+         */
+        bool matchesBSON(const BSONObj& doc, MatchDetails* details = NULL) const;
+
+        /**
+         * Returns how many leaves were compiled. The other children are matched as usual.
+         */
+        size_t numCompiledLeaves() const { return _leaves.size(); }
+
+    private:
+        /**
+         * A leaf of the expression with what we need to compare values with it quickly.
+         */
+        struct Leaf {
+            enum Kind {
+                GENERIC,    // anything without a fast path, matched with matchesSingleElement()
+                INTEGRAL,   // comparison with a NumberInt or NumberLong
+                DOUBLE,     // comparison with a NumberDouble which isn't NaN
+                STRING      // comparison with a String
+            };
+
+            explicit Leaf(const LeafMatchExpression* expr);
+
+            /**
+             * Whether the leaf matches 'e', which is not an array, as the only element along its
+             * path.
+             */
+            bool matchesSingleElement(const BSONElement& e) const;
+
+            const LeafMatchExpression* expr;
+            MatchExpression::MatchType matchType;
+            Kind kind;
+            long long integralValue;
+            double doubleValue;
+            StringData stringValue;
+        };
+
+        /**
+         * A field along the paths of the leaves, with the leaves whose paths end at the field,
+         * and the nodes of the fields their paths go on to below it.
+         */
+        struct PathNode {
+            std::string fieldName;
+            std::vector<size_t> leaves;
+            std::vector<size_t> children;
+
+            // The leaves at or below this node.
+            std::vector<size_t> allLeaves;
+        };
+
+        // A node has at most this many children, so matchesChildren() can keep track of the
+        // ones it found in a bit mask.
+        static const size_t kMaxChildrenPerNode = 64;
+
+        /**
+         * Adds 'expr' to the tree, unless that would give a node too many children. Returns
+         * whether it did.
+         */
+        bool addLeaf(const LeafMatchExpression* expr);
+
+        /**
+         * Fills in the 'allLeaves' of node 'nodeIndex' and of the nodes below it.
+         */
+        void collectLeaves(size_t nodeIndex);
+
+        /**
+         * Matches the leaves below 'node' against 'obj', the value of 'node' in 'doc'.
+         */
+        bool matchesChildren(const PathNode& node,
+                             const BSONObj& obj,
+                             const MatchableDocument* doc,
+                             MatchDetails* details) const;
+
+        /**
+         * Matches the leaves at or below 'node', given that its value is 'e'.
+         */
+        bool matchesNode(const PathNode& node,
+                         const BSONElement& e,
+                         const MatchableDocument* doc,
+                         MatchDetails* details) const;
+
+        const MatchExpression* _expr;
+
+        std::vector<Leaf> _leaves;
+
+        // The tree of the paths of '_leaves'. The first node is the root, which stands for the
+        // document itself.
+        std::vector<PathNode> _nodes;
+
+        // The children of the top level $and which aren't compiled.
+        std::vector<const MatchExpression*> _others;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,231 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/** Unit tests for CompiledMatchExpression, in expression_compiled.{h,cpp}. */
+
+#include "mongo/unittest/unittest.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <limits>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_compiled.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/matcher/match_details.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    using boost::scoped_ptr;
+
+    namespace {
+
+        MatchExpression* parse(const BSONObj& query) {
+            StatusWithMatchExpression result = MatchExpressionParser::parse(query);
+            ASSERT_OK(result.getStatus());
+            return result.getValue();
+        }
+
+        /**
+         * Asserts that the compiled form of 'query' matches 'doc' if and only if the expression
+         * does.
+         */
+        void assertSameMatch(const BSONObj& query, const BSONObj& doc) {
+            scoped_ptr<MatchExpression> expr(parse(query));
+            CompiledMatchExpression compiled(expr.get());
+            bool expected = expr->matchesBSON(doc);
+            if (compiled.matchesBSON(doc) != expected) {
+                FAIL(str::stream() << "query " << query << (expected ? " matches " : " misses ")
+                                   << doc << " but its compiled form does not");
+            }
+        }
+
+        void assertSameMatches(const BSONObj& query, const BSONArray& docs) {
+            BSONObjIterator it(docs);
+            while (it.more()) {
+                assertSameMatch(query, it.next().Obj());
+            }
+        }
+
+    }  // namespace
+
+    TEST(CompiledMatchExpression, EmptyQueryMatchesEverything) {
+        CompiledMatchExpression compiled(NULL);
+        ASSERT(compiled.matchesBSON(BSON("a" << 1)));
+        ASSERT(compiled.matchesBSON(BSONObj()));
+    }
+
+    TEST(CompiledMatchExpression, CompilesLeavesOfTopLevelAnd) {
+        BSONObj query = fromjson("{a: 1, 'b.c': {$gt: 2}, d: {$exists: true},"
+                                 " $or: [{e: 1}, {f: 1}]}");
+        scoped_ptr<MatchExpression> expr(parse(query));
+        CompiledMatchExpression compiled(expr.get());
+        ASSERT_EQUALS(3U, compiled.numCompiledLeaves());
+    }
+
+    TEST(CompiledMatchExpression, CompilesSingleLeaf) {
+        BSONObj query = BSON("a.b" << 1);
+        scoped_ptr<MatchExpression> expr(parse(query));
+        CompiledMatchExpression compiled(expr.get());
+        ASSERT_EQUALS(1U, compiled.numCompiledLeaves());
+        ASSERT(compiled.matchesBSON(BSON("a" << BSON("b" << 1))));
+        ASSERT(!compiled.matchesBSON(BSON("a" << BSON("b" << 2))));
+    }
+
+    TEST(CompiledMatchExpression, Comparisons) {
+        BSONArray docs = BSON_ARRAY(BSONObj()
+                                    << BSON("a" << 1)
+                                    << BSON("a" << 5)
+                                    << BSON("a" << 5LL)
+                                    << BSON("a" << 5.0)
+                                    << BSON("a" << 5.5)
+                                    << BSON("a" << 9)
+                                    << BSON("a" << std::numeric_limits<double>::quiet_NaN())
+                                    << BSON("a" << std::numeric_limits<long long>::max())
+                                    << BSON("a" << "5")
+                                    << BSON("a" << "abc")
+                                    << BSON("a" << "ab")
+                                    << BSON("a" << "abd")
+                                    << BSON("a" << BSONNULL)
+                                    << BSON("a" << true)
+                                    << BSON("a" << BSON("b" << 5)));
+
+        const char* ops[] = {"$lt", "$lte", "$gt", "$gte"};
+        for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); ++i) {
+            assertSameMatches(BSON("a" << BSON(ops[i] << 5)), docs);
+            assertSameMatches(BSON("a" << BSON(ops[i] << 5LL)), docs);
+            assertSameMatches(BSON("a" << BSON(ops[i] << 5.0)), docs);
+            assertSameMatches(BSON("a" << BSON(ops[i] << 5.25)), docs);
+            assertSameMatches(BSON("a" << BSON(ops[i] << "abc")), docs);
+            assertSameMatches(BSON("a" << BSON(ops[i] << BSONNULL)), docs);
+            assertSameMatches(BSON("a" << BSON(ops[i] <<
+                                               std::numeric_limits<double>::quiet_NaN())), docs);
+        }
+        assertSameMatches(BSON("a" << 5), docs);
+        assertSameMatches(BSON("a" << 5.0), docs);
+        assertSameMatches(BSON("a" << "abc"), docs);
+        assertSameMatches(BSON("a" << BSONNULL), docs);
+        assertSameMatches(BSON("a" << std::numeric_limits<long long>::max()), docs);
+    }
+
+    TEST(CompiledMatchExpression, DottedPaths) {
+        BSONArray docs = BSON_ARRAY(BSONObj()
+                                    << BSON("a" << 1)
+                                    << BSON("a" << BSONObj())
+                                    << BSON("a" << BSON("b" << 1))
+                                    << BSON("a" << BSON("b" << 1 << "c" << 2))
+                                    << BSON("a" << BSON("b" << BSON("c" << 1)))
+                                    << BSON("a" << BSON("c" << 2) << "d" << 3)
+                                    << BSON("a" << BSON("b" << 1) << "a" << BSON("b" << 2))
+                                    << BSON("d" << 3 << "a" << BSON("c" << 2 << "b" << 1)));
+
+        assertSameMatches(fromjson("{'a.b': 1}"), docs);
+        assertSameMatches(fromjson("{'a.b': 1, 'a.c': 2}"), docs);
+        assertSameMatches(fromjson("{'a.b': 1, 'a.c': 2, d: 3}"), docs);
+        assertSameMatches(fromjson("{a: {$exists: true}, 'a.b': {$exists: false}}"), docs);
+        assertSameMatches(fromjson("{'a.b': null}"), docs);
+        assertSameMatches(fromjson("{'a.b.c': null, 'a.b': {$exists: true}}"), docs);
+        assertSameMatches(fromjson("{'a.b': {$ne: 1}}"), docs);
+        assertSameMatches(fromjson("{'a.b': {$in: [1, 2]}, 'a.c': {$nin: [3]}}"), docs);
+    }
+
+    TEST(CompiledMatchExpression, Arrays) {
+        BSONArray docs = BSON_ARRAY(fromjson("{a: []}")
+                                    << fromjson("{a: [1, 2]}")
+                                    << fromjson("{a: [[1], 2]}")
+                                    << fromjson("{a: [{b: 1}, {b: 2}]}")
+                                    << fromjson("{a: [{b: 1}, {c: 2}]}")
+                                    << fromjson("{a: {b: [1, 2]}}")
+                                    << fromjson("{a: {b: [{c: 1}]}, d: 3}")
+                                    << fromjson("{a: {'0': {b: 1}}}")
+                                    << fromjson("{a: [{'0': 1}]}"));
+
+        assertSameMatches(fromjson("{a: 1}"), docs);
+        assertSameMatches(fromjson("{a: [1, 2]}"), docs);
+        assertSameMatches(fromjson("{a: {$size: 2}}"), docs);
+        assertSameMatches(fromjson("{'a.b': 1}"), docs);
+        assertSameMatches(fromjson("{'a.b': 1, 'a.c': 2}"), docs);
+        assertSameMatches(fromjson("{'a.b': {$gt: 1}, d: 3}"), docs);
+        assertSameMatches(fromjson("{'a.b.c': 1}"), docs);
+        assertSameMatches(fromjson("{'a.0': 1}"), docs);
+        assertSameMatches(fromjson("{'a.0.b': 1}"), docs);
+        assertSameMatches(fromjson("{'a.b': {$exists: false}}"), docs);
+        assertSameMatches(fromjson("{a: {$elemMatch: {b: 1}}}"), docs);
+    }
+
+    TEST(CompiledMatchExpression, OtherLeaves) {
+        BSONArray docs = BSON_ARRAY(BSONObj()
+                                    << BSON("a" << "abc")
+                                    << BSON("a" << "xyz")
+                                    << BSON("a" << 10)
+                                    << BSON("a" << 11)
+                                    << BSON("a" << BSON("b" << "abc")));
+
+        assertSameMatches(fromjson("{a: /^a/}"), docs);
+        assertSameMatches(fromjson("{a: {$mod: [5, 0]}}"), docs);
+        assertSameMatches(fromjson("{a: {$type: 2}}"), docs);
+        assertSameMatches(fromjson("{'a.b': /^a/, a: {$exists: true}}"), docs);
+        assertSameMatches(fromjson("{a: {$not: {$gt: 10}}}"), docs);
+        assertSameMatches(fromjson("{$or: [{a: 10}, {'a.b': 'abc'}]}"), docs);
+        assertSameMatches(fromjson("{$nor: [{a: 10}, {a: 11}], a: {$exists: true}}"), docs);
+    }
+
+    TEST(CompiledMatchExpression, ManyFieldsAtOneLevel) {
+        BSONObjBuilder query;
+        BSONObjBuilder doc;
+        for (int i = 0; i < 100; ++i) {
+            std::string field = str::stream() << "f" << i;
+            query.append(field, i);
+            doc.append(field, i);
+        }
+        BSONObj queryObj = query.obj();
+        scoped_ptr<MatchExpression> expr(parse(queryObj));
+        CompiledMatchExpression compiled(expr.get());
+        ASSERT_EQUALS(64U, compiled.numCompiledLeaves());
+
+        BSONObj docObj = doc.obj();
+        ASSERT(compiled.matchesBSON(docObj));
+        assertSameMatch(queryObj, docObj);
+        assertSameMatch(queryObj, BSON("f1" << 1));
+        assertSameMatch(queryObj, docObj.removeField("f99"));
+    }
+
+    TEST(CompiledMatchExpression, RecordsElemMatchKey) {
+        BSONObj query = fromjson("{'a.b': 2, c: 1}");
+        scoped_ptr<MatchExpression> expr(parse(query));
+        CompiledMatchExpression compiled(expr.get());
+
+        MatchDetails details;
+        details.requestElemMatchKey();
+        ASSERT(compiled.matchesBSON(fromjson("{a: [{b: 1}, {b: 2}], c: 1}"), &details));
+        ASSERT(details.hasElemMatchKey());
+        ASSERT_EQUALS("1", details.elemMatchKey());
+    }
+
+}  // namespace mongo
@@ -439,7 +439,8 @@ namespace mongo {
 
     // --------
 
-    ArrayFilterEntries::ArrayFilterEntries(){
+    ArrayFilterEntries::ArrayFilterEntries()
+        : _equalities(new BSONElementSet()) {
         _hasNull = false;
         _hasEmptyArray = false;
     }
@@ -466,7 +467,10 @@ namespace mongo {
         if ( e.type() == Array && e.Obj().isEmpty() )
             _hasEmptyArray = true;
 
-        _equalities.insert( e );
+        if ( !_equalities.unique() )
+            _equalities.reset( new BSONElementSet( *_equalities ) );
+
+        _equalities->insert( e );
         return Status::OK();
     }
 
@@ -485,7 +489,10 @@ namespace mongo {
             if ( !_regexes[i]->equivalent( other._regexes[i] ) )
                 return false;
 
-        return _equalities == other._equalities;
+        if ( _equalities == other._equalities )
+            return true;
+
+        return *_equalities == *other._equalities;
     }
 
     void ArrayFilterEntries::copyTo( ArrayFilterEntries& toFillIn ) const {
@@ -498,8 +505,8 @@ namespace mongo {
 
     void ArrayFilterEntries::debugString( StringBuilder& debug ) const {
         debug << "[ ";
-        for (BSONElementSet::const_iterator it = _equalities.begin();
-                it != _equalities.end(); ++it) {
+        for (BSONElementSet::const_iterator it = _equalities->begin();
+                it != _equalities->end(); ++it) {
             debug << it->toString( false ) << " ";
         }
         for (size_t i = 0; i < _regexes.size(); ++i) {
@@ -510,8 +517,8 @@ namespace mongo {
     }
 
     void ArrayFilterEntries::toBSON(BSONArrayBuilder* out) const {
-        for (BSONElementSet::const_iterator it = _equalities.begin();
-                it != _equalities.end(); ++it) {
+        for (BSONElementSet::const_iterator it = _equalities->begin();
+                it != _equalities->end(); ++it) {
             out->append(*it);
         }
         for (size_t i = 0; i < _regexes.size(); ++i) {
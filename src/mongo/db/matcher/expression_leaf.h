@@ -31,6 +31,7 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonmisc.h"
@@ -294,8 +295,8 @@ namespace mongo {
         Status addEquality( const BSONElement& e );
         Status addRegex( RegexMatchExpression* expr );
 
-        const BSONElementSet& equalities() const { return _equalities; }
-        bool contains( const BSONElement& elem ) const { return _equalities.count(elem) > 0; }
+        const BSONElementSet& equalities() const { return *_equalities; }
+        bool contains( const BSONElement& elem ) const { return _equalities->count(elem) > 0; }
 
         size_t numRegexes() const { return _regexes.size(); }
         RegexMatchExpression* regex( int idx ) const { return _regexes[idx]; }
@@ -303,7 +304,7 @@ namespace mongo {
         bool hasNull() const { return _hasNull; }
         bool singleNull() const { return size() == 1 && _hasNull; }
         bool hasEmptyArray() const { return _hasEmptyArray; }
-        int size() const { return _equalities.size() + _regexes.size(); }
+        int size() const { return _equalities->size() + _regexes.size(); }
 
         bool equivalent( const ArrayFilterEntries& other ) const;
 
@@ -316,7 +317,9 @@ namespace mongo {
     private:
         bool _hasNull; // if _equalities has a jstNULL element in it
         bool _hasEmptyArray;
-        BSONElementSet _equalities;
+        // Shared between copies made by copyTo() so that cloning a large $in is cheap; the set
+        // is copied before it is modified if another ArrayFilterEntries still refers to it.
+        boost::shared_ptr<BSONElementSet> _equalities;
         std::vector<RegexMatchExpression*> _regexes;
     };
 
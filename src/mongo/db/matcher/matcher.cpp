@@ -54,13 +54,14 @@ namespace mongo {
                  result.isOK() );
 
         _expression.reset( result.getValue() );
+        _compiled.reset( new CompiledMatchExpression( _expression.get() ) );
     }
 
     bool Matcher::matches(const BSONObj& doc, MatchDetails* details ) const {
         if ( !_expression )
             return true;
 
-        return _expression->matchesBSON( doc, details );
+        return _compiled->matchesBSON( doc, details );
     }
 
 }  // namespace mongo
@@ -36,6 +36,7 @@
 #include "mongo/base/status.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_compiled.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/matcher/match_details.h"
 
@@ -63,6 +64,9 @@ namespace mongo {
         BSONObj _pattern;
 
         boost::scoped_ptr<MatchExpression> _expression;
+
+        // The compiled form of '_expression', which does the matching.
+        boost::scoped_ptr<CompiledMatchExpression> _compiled;
     };
 
 }  // namespace mongo
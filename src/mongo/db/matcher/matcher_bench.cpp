@@ -0,0 +1,90 @@
+// matcher_bench.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/matcher.h"
+#include "mongo/unittest/benchmark.h"
+
+namespace mongo {
+namespace {
+
+    using unittest::doNotOptimizeAway;
+
+    const char* kDocument =
+        "{_id: 1, name: 'widget', price: 25.5, qty: 100, tags: ['a', 'b', 'c'],"
+        " dims: {h: 10, w: 20, d: 5}, status: 'active'}";
+
+    const char* kConjunction = "{price: {$gt: 10, $lt: 50}, status: 'active', 'dims.h': 10}";
+
+    BENCHMARK(Matcher, ParseConjunction) {
+        const BSONObj query = fromjson(kConjunction);
+        while (state.keepRunning()) {
+            Matcher matcher(query);
+            doNotOptimizeAway(matcher.getQuery());
+        }
+    }
+
+    BENCHMARK(Matcher, MatchEquality) {
+        const BSONObj doc = fromjson(kDocument);
+        const Matcher matcher(fromjson("{name: 'widget'}"));
+        while (state.keepRunning()) {
+            doNotOptimizeAway(matcher.matches(doc));
+        }
+    }
+
+    BENCHMARK(Matcher, MatchConjunction) {
+        const BSONObj doc = fromjson(kDocument);
+        const Matcher matcher(fromjson(kConjunction));
+        while (state.keepRunning()) {
+            doNotOptimizeAway(matcher.matches(doc));
+        }
+    }
+
+    BENCHMARK(Matcher, MatchArrayIn) {
+        const BSONObj doc = fromjson(kDocument);
+        const Matcher matcher(fromjson("{tags: {$in: ['x', 'y', 'c']}}"));
+        while (state.keepRunning()) {
+            doNotOptimizeAway(matcher.matches(doc));
+        }
+    }
+
+    BENCHMARK(Matcher, MatchRegex) {
+        const BSONObj doc = fromjson(kDocument);
+        const Matcher matcher(fromjson("{name: /^wid/}"));
+        while (state.keepRunning()) {
+            doNotOptimizeAway(matcher.matches(doc));
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
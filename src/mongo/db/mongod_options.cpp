@@ -51,6 +51,7 @@
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/net/ssl_options.h"
 #include "mongo/util/options_parser/startup_options.h"
+#include "mongo/util/stringutils.h"
 #include "mongo/util/version.h"
 #include "mongo/util/version_reporting.h"
 
@@ -296,6 +297,10 @@ namespace mongo {
                 "journalCommitInterval", moe::Unsigned, "how often to group/batch commit (ms)",
                 "storage.journal.commitIntervalMs");
 
+        storage_options.addOptionChaining("storage.mmapv1.journal.stripeDirs",
+                "journalStripeDirs", moe::String,
+                "comma separated list of additional directories to stripe the journal across");
+
         // Deprecated option that we don't want people to use for performance reasons
         storage_options.addOptionChaining("nopreallocj", "nopreallocj", moe::Switch,
                 "don't preallocate journal files")
@@ -985,6 +990,22 @@ namespace mongo {
             mmapv1GlobalOptions.journalOptions =
                 params["storage.mmapv1.journal.debugFlags"].as<int>();
         }
+        if (params.count("storage.mmapv1.journal.stripeDirs")) {
+            std::vector<std::string> dirs;
+            splitStringDelim(params["storage.mmapv1.journal.stripeDirs"].as<std::string>(),
+                             &dirs, ',');
+            for (size_t i = 0; i < dirs.size(); i++) {
+                if (dirs[i].empty()) {
+                    return Status(ErrorCodes::BadValue,
+                                  "--journalStripeDirs must not contain an empty directory");
+                }
+            }
+            if (dirs.size() > 15) {
+                return Status(ErrorCodes::BadValue,
+                              "--journalStripeDirs allows at most 15 additional directories");
+            }
+            mmapv1GlobalOptions.journalStripeDirs = dirs;
+        }
         if (params.count("nopreallocj")) {
             mmapv1GlobalOptions.preallocj = !params["nopreallocj"].as<bool>();
         }
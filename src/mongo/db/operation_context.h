@@ -34,6 +34,7 @@
 #include "mongo/db/storage/recovery_unit.h"
 #include "mongo/db/concurrency/locker.h"
 #include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -125,6 +126,12 @@ namespace mongo {
          */
         virtual CurOp* getCurOp() const = 0;
 
+        /**
+         * Charges 'micros' spent committing writes to the storage engine to this operation's
+         * CurOp, if it has one.
+         */
+        virtual void recordStorageTime(long long micros) {}
+
         /**
          * Returns the operation ID associated with this operation.
          * WARNING: Due to SERVER-14995, this OpID is not guaranteed to stay the same for the
@@ -163,7 +170,9 @@ namespace mongo {
         void commit() {
             invariant(!_ended);
 
+            const unsigned long long start = curTimeMicros64();
             _txn->recoveryUnit()->commitUnitOfWork();
+            _txn->recordStorageTime(curTimeMicros64() - start);
             _txn->lockState()->endWriteUnitOfWork();
 
             _ended = true;
@@ -49,15 +49,21 @@ namespace mongo {
         : _client(currentClient.get()),
           _locker(_client->getLocker()) {
         invariant(_locker);
-        StorageEngine* storageEngine = getGlobalEnvironment()->getGlobalStorageEngine();
-        invariant(storageEngine);
-        _recovery.reset(storageEngine->newRecoveryUnit());
+        _recovery.reset(_client->releaseCachedRecoveryUnit());
+        if (!_recovery.get()) {
+            StorageEngine* storageEngine = getGlobalEnvironment()->getGlobalStorageEngine();
+            invariant(storageEngine);
+            _recovery.reset(storageEngine->newRecoveryUnit());
+        }
         _client->setOperationContext(this);
     }
 
     OperationContextImpl::~OperationContextImpl() {
         _locker->assertEmpty();
         _client->resetOperationContext();
+        if (_recovery.get() && _recovery->resetForReuse()) {
+            _client->cacheRecoveryUnit(_recovery.release());
+        }
     }
 
     RecoveryUnit* OperationContextImpl::recoveryUnit() const {
@@ -103,6 +109,10 @@ namespace mongo {
         return getClient()->curop();
     }
 
+    void OperationContextImpl::recordStorageTime(long long micros) {
+        getCurOp()->addTime(CurOp::kStorageTime, micros);
+    }
+
     unsigned int OperationContextImpl::getOpID() const {
         return getCurOp()->opNum();
     }
@@ -62,6 +62,8 @@ namespace mongo {
 
         virtual CurOp* getCurOp() const;
 
+        virtual void recordStorageTime(long long micros);
+
         virtual unsigned int getOpID() const;
 
         virtual void checkForInterrupt() const;
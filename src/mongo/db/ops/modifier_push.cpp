@@ -675,49 +675,52 @@ namespace mongo {
 
     Status ModifierPush::log(LogBuilder* logBuilder) const {
 
-        // The start position to use for positional (ordinal) updates to the array
-        // (We will increment as we append elements to the oplog entry so can't be const)
-        size_t position = _preparedState->arrayPreModSize;
-
         // NOTE: Idempotence Requirement
         // In the case that the document does't have an array or it is empty we need to make sure
         // that the first time the field gets filled with items that it is a full set of the array.
+        // Otherwise we log positional $sets of just the elements from the first one that the
+        // $push changed to the end of the array, which a replay leaves as they are. That only
+        // works if the array did not shrink, and it is no smaller than a full copy when the
+        // changed elements are most of the array.
+
+        const size_t preModSize = _preparedState->arrayPreModSize;
+        const size_t postModSize = countChildren(_preparedState->elemFound);
+
+        // Index of the first element that may differ from the array before the $push.
+        size_t firstChanged = std::min(_startPosition, preModSize);
+        if (_slicePresent && _slice > 0) {
+            firstChanged = std::min(firstChanged, static_cast<size_t>(_slice));
+        }
 
-        // If we sorted, sliced, or added the first items to the array, make a full array copy.
-        const bool doFullCopy = _slicePresent || _sortPresent
-                       || (position == 0) // first element in new/empty array
-                       || (_startPosition < _preparedState->arrayPreModSize); // add in middle
+        const bool doFullCopy = _sortPresent
+                       || (_slicePresent && _slice <= 0) // may remove from the front
+                       || (preModSize == 0) // first element in new/empty array
+                       || (postModSize < preModSize) // sliced off existing elements
+                       || (firstChanged >= postModSize) // nothing to set positionally
+                       || (firstChanged < preModSize && // add in middle, shifting most elements
+                           (postModSize - firstChanged) * 2 > postModSize);
 
         if (doFullCopy) {
             return logBuilder->addToSetsWithNewFieldName(_fieldRef.dottedField(),
                                                          _preparedState->elemFound);
         }
-        else {
-            // Set only the positional elements appended
-            if (_eachMode || _pushMode == PUSH_ALL) {
-                // For each input element log it as a posisional $set
-                BSONObjIterator itEach(_eachElem.embeddedObject());
-                while (itEach.more()) {
-                    BSONElement eachItem = itEach.next();
-                    // value for the logElement ("field.path.name.N": <value>)
-                    const std::string positionalName =
-                        mongoutils::str::stream() << _fieldRef.dottedField() << "." << position++;
-
-                    Status s = logBuilder->addToSetsWithNewFieldName(positionalName, eachItem);
-                    if (!s.isOK())
-                        return s;
-                }
 
-                return Status::OK();
-            }
-            else {
-               // single value for the logElement ("field.path.name.N": <value>)
-               const std::string positionalName =
-                   mongoutils::str::stream() << _fieldRef.dottedField() << "." << position++;
+        // Set only the positional elements from the first changed one on
+        // ("field.path.name.N": <value>)
+        size_t position = firstChanged;
+        mutablebson::Element curr = _preparedState->elemFound.findNthChild(firstChanged);
+        while (curr.ok()) {
+            const std::string positionalName =
+                mongoutils::str::stream() << _fieldRef.dottedField() << "." << position++;
 
-               return logBuilder->addToSetsWithNewFieldName(positionalName, _val);
-            }
+            Status s = logBuilder->addToSetsWithNewFieldName(positionalName, curr);
+            if (!s.isOK())
+                return s;
+
+            curr = curr.rightSibling();
         }
+
+        return Status::OK();
     }
 
 } // namespace mongo
@@ -94,9 +94,9 @@ namespace mongo {
         virtual Status apply() const;
 
         /**
-         * $push currently logs the entire resulting array as a $set.
-         *
-         * TODO Log a positional $set in the array, whenever possible.
+         * $push logs positional $sets of the array elements from the first one it changed, or
+         * the entire resulting array as a $set when it sorted, removed from or started the array,
+         * or changed most of it.
          */
         virtual Status log(LogBuilder* logBuilder) const;
 
@@ -902,6 +902,27 @@ namespace {
         ASSERT_EQUALS(fromjson("{$set: {a: [3]}}"), logDoc);
     }
 
+    TEST(SlicePushEach, TopGrowing) {
+        Document doc(fromjson("{a: [3]}"));
+        Mod pushMod(fromjson("{$push: {a: {$each: [2, -1], $slice:2}}}"));
+
+        ModifierInterface::ExecInfo execInfo;
+        ASSERT_OK(pushMod.prepare(doc.root(), "", &execInfo));
+
+        ASSERT_EQUALS(execInfo.fieldRef[0]->dottedField(), "a");
+        ASSERT_FALSE(execInfo.noOp);
+
+        ASSERT_OK(pushMod.apply());
+        ASSERT_FALSE(doc.isInPlaceModeEnabled());
+        ASSERT_EQUALS(fromjson("{a: [3, 2]}"), doc);
+
+        Document logDoc;
+        LogBuilder logBuilder(logDoc.root());
+        ASSERT_OK(pushMod.log(&logBuilder));
+        ASSERT_EQUALS(countChildren(logDoc.root()), 1u);
+        ASSERT_EQUALS(fromjson("{$set: {'a.1': 2}}"), logDoc);
+    }
+
     /**
      * Sort for scalar (whole) array elements
      */
@@ -1452,4 +1473,25 @@ namespace {
         ASSERT_EQUALS(fromjson("{$set: {'a.1':1}}"), logDoc);
     }
 
+    TEST(ToPosition, NearBack) {
+        Document doc(fromjson("{a: [0, 1, 2, 3, 4, 5]}"));
+        Mod pushMod(fromjson("{$push: {a: { $each: [9], $position:5}}}"));
+
+        ModifierInterface::ExecInfo execInfo;
+        ASSERT_OK(pushMod.prepare(doc.root(), "", &execInfo));
+
+        ASSERT_EQUALS(execInfo.fieldRef[0]->dottedField(), "a");
+        ASSERT_FALSE(execInfo.noOp);
+
+        ASSERT_OK(pushMod.apply());
+        ASSERT_FALSE(doc.isInPlaceModeEnabled());
+        ASSERT_EQUALS(fromjson("{a: [0, 1, 2, 3, 4, 9, 5]}"), doc);
+
+        Document logDoc;
+        LogBuilder logBuilder(logDoc.root());
+        ASSERT_OK(pushMod.log(&logBuilder));
+        ASSERT_EQUALS(countChildren(logDoc.root()), 1u);
+        ASSERT_EQUALS(fromjson("{$set: {'a.5': 9, 'a.6': 5}}"), logDoc);
+    }
+
 } // unnamed namespace
@@ -73,8 +73,21 @@ namespace mongo {
         CanonicalQuery* cqRaw;
         const WhereCallbackReal whereCallback(_txn, _request->getNamespaceString().db());
 
+        // A single write with a sort only wants the first document in that order, which a
+        // top-k sort finds without sorting all the matches.
+        const long long limit =
+            (!_request->isMulti() && !_request->getSort().isEmpty()) ? -1 : 0;
+
         Status status = CanonicalQuery::canonicalize(_request->getNamespaceString().ns(),
                                                      _request->getQuery(),
+                                                     _request->getSort(),
+                                                     BSONObj(), // projection
+                                                     0, // skip
+                                                     limit,
+                                                     BSONObj(), // hint
+                                                     BSONObj(), // min
+                                                     BSONObj(), // max
+                                                     false, // snapshot
                                                      _request->isExplain(),
                                                      &cqRaw,
                                                      whereCallback);
@@ -138,9 +138,72 @@ namespace mongo {
         // replacement.
         _replacementMode = false;
 
+        parseFixedWidthMod(updateExpr);
+
         return Status::OK();
     }
 
+    void UpdateDriver::parseFixedWidthMod(const BSONObj& updateExpr) {
+        if (updateExpr.nFields() != 1) {
+            return;
+        }
+
+        const BSONElement modElem = updateExpr.firstElement();
+        const modifiertable::ModifierType modType = modifiertable::getType(modElem.fieldName());
+        if (modType != modifiertable::MOD_INC && modType != modifiertable::MOD_SET) {
+            return;
+        }
+
+        const BSONObj mods = modElem.embeddedObject();
+        if (mods.nFields() != 1) {
+            return;
+        }
+
+        const BSONElement value = mods.firstElement();
+        switch (value.type()) {
+        case NumberInt:
+        case NumberLong:
+        case NumberDouble:
+            break;
+        case Bool:
+        case Date:
+            if (modType == modifiertable::MOD_SET) {
+                break;
+            }
+            return;
+        default:
+            return;
+        }
+
+        // No positional operator, and not _id, which can't change.
+        const StringData path = value.fieldNameStringData();
+        if (path.find('$') != string::npos) {
+            return;
+        }
+
+        scoped_ptr<FixedWidthMod> mod(new FixedWidthMod());
+        mod->isInc = modType == modifiertable::MOD_INC;
+        mod->holder = mods.getOwned();
+        mod->value = mod->holder.firstElement();
+        mod->path.parse(mod->value.fieldNameStringData());
+        if (mod->path.getPart(0) == "_id") {
+            return;
+        }
+
+        _fixedWidthMod.swap(mod);
+    }
+
+    const UpdateDriver::FixedWidthMod* UpdateDriver::getFixedWidthMod() const {
+        if (!_fixedWidthMod || _context != ModifierInterface::ExecInfo::UPDATE_CONTEXT) {
+            return NULL;
+        }
+        if (_indexedFields &&
+            _indexedFields->mightBeIndexed(_fixedWidthMod->path.dottedField())) {
+            return NULL;
+        }
+        return _fixedWidthMod.get();
+    }
+
     inline Status UpdateDriver::addAndParse(const modifiertable::ModifierType type,
                                             const BSONElement& elem) {
         if (elem.eoo()) {
@@ -390,6 +453,7 @@ namespace mongo {
         _indexedFields = NULL;
         _replacementMode = false;
         _positional = false;
+        _fixedWidthMod.reset();
     }
 
 } // namespace mongo
@@ -28,12 +28,14 @@
 
 #pragma once
 
+#include <boost/scoped_ptr.hpp>
 #include <string>
 #include <vector>
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/base/status.h"
 #include "mongo/bson/mutable/document.h"
+#include "mongo/db/field_ref.h"
 #include "mongo/db/field_ref_set.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/ops/modifier_interface.h"
@@ -133,11 +135,35 @@ namespace mongo {
             return _positional;
         }
 
+        /**
+         * An update made of a single $inc of a number, or $set of a number, boolean or date, at
+         * a path through embedded documents. Where the field already holds a value of the same
+         * type, applying it only overwrites the value's bytes, which can be done without
+         * building a mutablebson::Document.
+         */
+        struct FixedWidthMod {
+            bool isInc;
+            FieldRef path;
+
+            // { <path>: <value> }, owned.
+            BSONObj holder;
+            BSONElement value;
+        };
+
+        /**
+         * Returns the update as a FixedWidthMod, or NULL if it isn't one, if its path may be
+         * indexed, or outside of the update context.
+         */
+        const FixedWidthMod* getFixedWidthMod() const;
+
     private:
 
         /** Resets the state of the class associated with mods (not the error state) */
         void clear();
 
+        /** Fills in '_fixedWidthMod' if 'updateExpr', already parsed, qualifies. */
+        void parseFixedWidthMod(const BSONObj& updateExpr);
+
         /** Create the modifier and add it to the back of the modifiers vector */
         inline Status addAndParse(const modifiertable::ModifierType type,
                                   const BSONElement& elem);
@@ -175,6 +201,9 @@ namespace mongo {
         // Do any of the mods require positional match details when calling 'prepare'?
         bool _positional;
 
+        // Set when the update is a FixedWidthMod.
+        boost::scoped_ptr<FixedWidthMod> _fixedWidthMod;
+
         // Is this update going to be an upsert?
         ModifierInterface::ExecInfo::UpdateContext _context;
 
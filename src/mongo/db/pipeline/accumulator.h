@@ -191,4 +191,85 @@ namespace mongo {
         double _total;
         long long _count;
     };
+
+
+    /**
+     * $approxCountDistinct estimates how many distinct values it sees with a HyperLogLog sketch of
+     * 2^kPrecision one byte registers, for a standard error of about 1.6%. Small sets are kept as
+     * a sorted list of register updates until that gets as big as the registers themselves.
+     */
+    class AccumulatorApproxCountDistinct : public Accumulator {
+    public:
+        virtual void processInternal(const Value& input, bool merging);
+        virtual Value getValue(bool toBeMerged) const;
+        virtual const char* getOpName() const;
+        virtual void reset();
+
+        static boost::intrusive_ptr<Accumulator> create();
+
+        static const int kPrecision = 12;
+        static const size_t kNumRegisters = 1 << kPrecision;
+
+    private:
+        AccumulatorApproxCountDistinct();
+
+        /// Raises register 'index' to 'rank' if it is lower.
+        void update(unsigned index, unsigned char rank);
+
+        /// Moves from the sparse list to the registers.
+        void densify();
+
+        void updateMemUsage();
+
+        // Sparse: (index << 8 | rank) for each register that isn't zero, sorted by index.
+        std::vector<unsigned> _sparse;
+        // Dense: every register. Empty while sparse.
+        std::vector<unsigned char> _registers;
+    };
+
+
+    /**
+     * $approxPercentile: {input: <expression>, p: <number between 0 and 1>} estimates the p-th
+     * quantile of the numeric inputs with a merging t-digest: values are buffered, then sorted and
+     * folded into a number of centroids proportional to kCompression, small near both tails and
+     * large in the middle. The first input's p is used. Non-numeric inputs are ignored, as by $avg.
+     */
+    class AccumulatorApproxPercentile : public Accumulator {
+    public:
+        virtual void processInternal(const Value& input, bool merging);
+        virtual Value getValue(bool toBeMerged) const;
+        virtual const char* getOpName() const;
+        virtual void reset();
+
+        static boost::intrusive_ptr<Accumulator> create();
+
+        static const int kCompression = 100;
+
+    private:
+        AccumulatorApproxPercentile();
+
+        struct Centroid {
+            Centroid(double mean, double weight) : mean(mean), weight(weight) {}
+            bool operator<(const Centroid& other) const { return mean < other.mean; }
+
+            double mean;
+            double weight;
+        };
+
+        void add(double mean, double weight);
+
+        /// Folds the buffer into the centroids. Const since it doesn't change the estimate.
+        void compress() const;
+
+        double quantile(double p) const;
+
+        void updateMemUsage();
+
+        double _p; // negative until the first input names it
+        double _min;
+        double _max;
+        mutable std::vector<Centroid> _centroids;
+        mutable std::vector<Centroid> _buffer;
+        mutable double _totalWeight; // of _centroids and _buffer
+    };
 }
@@ -41,11 +41,9 @@ namespace mongo {
 
     void AccumulatorAddToSet::processInternal(const Value& input, bool merging) {
         if (!merging) {
-            if (!input.missing()) {
-                bool inserted = set.insert(input).second;
-                if (inserted) {
-                    _memUsageBytes += input.getApproximateSize();
-                }
+            if (!input.missing() && set.find(input) == set.end()) {
+                set.insert(input.getOwned());
+                _memUsageBytes += input.getApproximateSize();
             }
         }
         else {
@@ -0,0 +1,213 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_PCH_WHITELISTED
+#include "mongo/platform/basic.h"
+#include "mongo/pch.h"
+#undef MONGO_PCH_WHITELISTED
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/value.h"
+
+namespace mongo {
+
+    using boost::intrusive_ptr;
+
+namespace {
+    /**
+     * Hashes values so that those comparing equal, such as 1 and 1.0, hash alike. Value's hash
+     * leaves small numbers nearly as they are, so it is put through MurmurHash3's finalizer to
+     * spread it over all 64 bits.
+     */
+    unsigned long long hashValue(const Value& value) {
+        size_t seed = 0;
+        value.hash_combine(seed);
+
+        unsigned long long h = seed;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    unsigned encodeSparse(unsigned index, unsigned char rank) {
+        return index << 8 | rank;
+    }
+
+    bool lessIndex(unsigned entry, unsigned index) {
+        return (entry >> 8) < index;
+    }
+}
+
+    void AccumulatorApproxCountDistinct::processInternal(const Value& input, bool merging) {
+        if (!merging) {
+            if (input.missing())
+                return;
+
+            // The first kPrecision bits pick a register, which keeps the longest run of leading
+            // zeros, plus one, seen in the rest.
+            const unsigned long long hash = hashValue(input);
+            const unsigned index = hash >> (64 - kPrecision);
+            unsigned long long rest = hash << kPrecision;
+            unsigned char rank = 1;
+            while (rank <= 64 - kPrecision && !(rest & (1ULL << 63))) {
+                rest <<= 1;
+                rank++;
+            }
+
+            update(index, rank);
+        }
+        else if (input.getType() == BinData) {
+            // Registers, from getValue(true) on a dense accumulator.
+            const BSONBinData binData = input.getBinData();
+            verify(binData.length == int(kNumRegisters));
+            const unsigned char* registers = static_cast<const unsigned char*>(binData.data);
+
+            densify();
+            for (size_t i = 0; i < kNumRegisters; i++) {
+                _registers[i] = std::max(_registers[i], registers[i]);
+            }
+        }
+        else {
+            // Register updates, from getValue(true) on a sparse accumulator.
+            verify(input.getType() == Array);
+
+            const vector<Value>& entries = input.getArray();
+            for (size_t i = 0; i < entries.size(); i++) {
+                const unsigned entry = entries[i].getInt();
+                update(entry >> 8, entry & 0xff);
+            }
+        }
+
+        updateMemUsage();
+    }
+
+    void AccumulatorApproxCountDistinct::update(unsigned index, unsigned char rank) {
+        if (!_registers.empty()) {
+            _registers[index] = std::max(_registers[index], rank);
+            return;
+        }
+
+        vector<unsigned>::iterator it =
+            std::lower_bound(_sparse.begin(), _sparse.end(), index, lessIndex);
+        if (it != _sparse.end() && (*it >> 8) == index) {
+            if ((*it & 0xff) < rank)
+                *it = encodeSparse(index, rank);
+            return;
+        }
+
+        _sparse.insert(it, encodeSparse(index, rank));
+
+        // The list is no smaller than the registers anymore.
+        if (_sparse.size() * sizeof(unsigned) >= kNumRegisters)
+            densify();
+    }
+
+    void AccumulatorApproxCountDistinct::densify() {
+        if (!_registers.empty())
+            return;
+
+        _registers.resize(kNumRegisters, 0);
+        for (size_t i = 0; i < _sparse.size(); i++) {
+            _registers[_sparse[i] >> 8] = _sparse[i] & 0xff;
+        }
+        vector<unsigned>().swap(_sparse);
+    }
+
+    void AccumulatorApproxCountDistinct::updateMemUsage() {
+        _memUsageBytes = sizeof(*this)
+                       + _sparse.capacity() * sizeof(unsigned)
+                       + _registers.capacity();
+    }
+
+    Value AccumulatorApproxCountDistinct::getValue(bool toBeMerged) const {
+        if (toBeMerged) {
+            if (!_registers.empty()) {
+                return Value(BSONBinData(&_registers[0], _registers.size(), BinDataGeneral));
+            }
+
+            vector<Value> entries;
+            entries.reserve(_sparse.size());
+            for (size_t i = 0; i < _sparse.size(); i++) {
+                entries.push_back(Value(static_cast<int>(_sparse[i])));
+            }
+            return Value::consume(entries);
+        }
+
+        // Registers missing from the sparse list are zero.
+        const double m = kNumRegisters;
+        double sum = 0;
+        size_t zeros = 0;
+        if (!_registers.empty()) {
+            for (size_t i = 0; i < kNumRegisters; i++) {
+                sum += std::ldexp(1.0, -_registers[i]);
+                if (_registers[i] == 0)
+                    zeros++;
+            }
+        }
+        else {
+            for (size_t i = 0; i < _sparse.size(); i++) {
+                sum += std::ldexp(1.0, -static_cast<int>(_sparse[i] & 0xff));
+            }
+            zeros = kNumRegisters - _sparse.size();
+            sum += zeros;
+        }
+
+        const double alpha = 0.7213 / (1 + 1.079 / m);
+        double estimate = alpha * m * m / sum;
+
+        // Linear counting is more accurate while many registers are still empty.
+        if (estimate <= 2.5 * m && zeros > 0)
+            estimate = m * std::log(m / zeros);
+
+        return Value(static_cast<long long>(estimate + 0.5));
+    }
+
+    AccumulatorApproxCountDistinct::AccumulatorApproxCountDistinct() {
+        updateMemUsage();
+    }
+
+    void AccumulatorApproxCountDistinct::reset() {
+        vector<unsigned>().swap(_sparse);
+        vector<unsigned char>().swap(_registers);
+        updateMemUsage();
+    }
+
+    intrusive_ptr<Accumulator> AccumulatorApproxCountDistinct::create() {
+        return new AccumulatorApproxCountDistinct();
+    }
+
+    const char *AccumulatorApproxCountDistinct::getOpName() const {
+        return "$approxCountDistinct";
+    }
+}
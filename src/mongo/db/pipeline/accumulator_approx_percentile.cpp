@@ -0,0 +1,231 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_PCH_WHITELISTED
+#include "mongo/platform/basic.h"
+#include "mongo/pch.h"
+#undef MONGO_PCH_WHITELISTED
+
+#include <algorithm>
+#include <limits>
+
+#include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    using boost::intrusive_ptr;
+
+namespace {
+    const char inputName[] = "input";
+    const char pName[] = "p";
+    const char minName[] = "min";
+    const char maxName[] = "max";
+    const char meansName[] = "means";
+    const char weightsName[] = "weights";
+
+    // Inputs are buffered until there are this many, then compressed.
+    const size_t kBufferSize = 5 * AccumulatorApproxPercentile::kCompression;
+}
+
+    void AccumulatorApproxPercentile::processInternal(const Value& input, bool merging) {
+        if (!merging) {
+            uassert(28613, str::stream() << "$approxPercentile takes an object with '"
+                                         << inputName << "' and '" << pName << "' fields, not "
+                                         << typeName(input.getType()),
+                    input.getType() == Object);
+
+            const Value p = input[pName];
+            uassert(28614, str::stream() << "$approxPercentile's '" << pName
+                                         << "' must be a number between 0 and 1, not "
+                                         << p.toString(),
+                    p.numeric() && p.getDouble() >= 0 && p.getDouble() <= 1);
+            if (_p < 0)
+                _p = p.getDouble();
+
+            // non numeric types are ignored, as by $avg
+            const Value value = input[inputName];
+            if (!value.numeric())
+                return;
+
+            const double x = value.getDouble();
+            _min = std::min(_min, x);
+            _max = std::max(_max, x);
+            add(x, 1);
+        }
+        else {
+            // We expect what getValue(true) produced below.
+            verify(input.getType() == Object);
+
+            if (_p < 0)
+                _p = input[pName].getDouble();
+
+            const vector<Value>& means = input[meansName].getArray();
+            const vector<Value>& weights = input[weightsName].getArray();
+            verify(means.size() == weights.size());
+            if (means.empty())
+                return;
+
+            _min = std::min(_min, input[minName].getDouble());
+            _max = std::max(_max, input[maxName].getDouble());
+            for (size_t i = 0; i < means.size(); i++) {
+                add(means[i].getDouble(), weights[i].getDouble());
+            }
+        }
+
+        updateMemUsage();
+    }
+
+    void AccumulatorApproxPercentile::add(double mean, double weight) {
+        _buffer.push_back(Centroid(mean, weight));
+        _totalWeight += weight;
+
+        if (_buffer.size() >= kBufferSize)
+            compress();
+    }
+
+    void AccumulatorApproxPercentile::compress() const {
+        if (_buffer.empty())
+            return;
+
+        vector<Centroid> all;
+        all.reserve(_centroids.size() + _buffer.size());
+        all.insert(all.end(), _centroids.begin(), _centroids.end());
+        all.insert(all.end(), _buffer.begin(), _buffer.end());
+        std::sort(all.begin(), all.end());
+
+        // Neighbours merge while the result stays under 4 * n * q * (1 - q) / kCompression, q
+        // being the fraction of the weight below its middle. That keeps single values at the
+        // extremes, where quantiles need them, and bounds the number of centroids.
+        vector<Centroid> merged;
+        double weightSoFar = 0;
+        Centroid current = all[0];
+        for (size_t i = 1; i < all.size(); i++) {
+            const double proposed = current.weight + all[i].weight;
+            const double q = (weightSoFar + proposed / 2) / _totalWeight;
+            const double limit = 4 * _totalWeight * q * (1 - q) / kCompression;
+
+            if (proposed <= limit) {
+                current.mean += (all[i].mean - current.mean) * all[i].weight / proposed;
+                current.weight = proposed;
+            }
+            else {
+                merged.push_back(current);
+                weightSoFar += current.weight;
+                current = all[i];
+            }
+        }
+        merged.push_back(current);
+
+        _centroids.swap(merged);
+        _buffer.clear();
+    }
+
+    double AccumulatorApproxPercentile::quantile(double p) const {
+        compress();
+        verify(!_centroids.empty());
+
+        // Each centroid stands for the middle of its weight. Below the first and above the last,
+        // interpolate towards the smallest and largest values seen.
+        const double target = p * _totalWeight;
+        double previousMean = _min;
+        double previousRank = 0;
+        double weightSoFar = 0;
+        for (size_t i = 0; i < _centroids.size(); i++) {
+            const double rank = weightSoFar + _centroids[i].weight / 2;
+            if (target < rank) {
+                const double fraction = (target - previousRank) / (rank - previousRank);
+                return previousMean + fraction * (_centroids[i].mean - previousMean);
+            }
+
+            previousMean = _centroids[i].mean;
+            previousRank = rank;
+            weightSoFar += _centroids[i].weight;
+        }
+
+        if (_totalWeight <= previousRank)
+            return _max;
+
+        const double fraction = (target - previousRank) / (_totalWeight - previousRank);
+        return previousMean + fraction * (_max - previousMean);
+    }
+
+    void AccumulatorApproxPercentile::updateMemUsage() {
+        _memUsageBytes = sizeof(*this)
+                       + (_centroids.capacity() + _buffer.capacity()) * sizeof(Centroid);
+    }
+
+    Value AccumulatorApproxPercentile::getValue(bool toBeMerged) const {
+        if (!toBeMerged) {
+            if (_totalWeight == 0)
+                return Value(BSONNULL);
+
+            return Value(quantile(_p));
+        }
+
+        compress();
+        vector<Value> means;
+        vector<Value> weights;
+        means.reserve(_centroids.size());
+        weights.reserve(_centroids.size());
+        for (size_t i = 0; i < _centroids.size(); i++) {
+            means.push_back(Value(_centroids[i].mean));
+            weights.push_back(Value(_centroids[i].weight));
+        }
+
+        return Value(DOC(pName << _p
+                      << minName << _min
+                      << maxName << _max
+                      << meansName << Value::consume(means)
+                      << weightsName << Value::consume(weights)));
+    }
+
+    AccumulatorApproxPercentile::AccumulatorApproxPercentile() {
+        reset();
+    }
+
+    void AccumulatorApproxPercentile::reset() {
+        _p = -1;
+        _min = std::numeric_limits<double>::infinity();
+        _max = -std::numeric_limits<double>::infinity();
+        vector<Centroid>().swap(_centroids);
+        vector<Centroid>().swap(_buffer);
+        _totalWeight = 0;
+        updateMemUsage();
+    }
+
+    intrusive_ptr<Accumulator> AccumulatorApproxPercentile::create() {
+        return new AccumulatorApproxPercentile();
+    }
+
+    const char *AccumulatorApproxPercentile::getOpName() const {
+        return "$approxPercentile";
+    }
+}
@@ -43,7 +43,7 @@ namespace mongo {
         if (!_haveFirst) {
             // can't use pValue.missing() since we want the first value even if missing
             _haveFirst = true;
-            _first = input;
+            _first = input.getOwned();
             _memUsageBytes = sizeof(*this) + input.getApproximateSize() - sizeof(Value);
         }
     }
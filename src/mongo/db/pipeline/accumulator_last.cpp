@@ -40,7 +40,7 @@ namespace mongo {
 
     void AccumulatorLast::processInternal(const Value& input, bool merging) {
         /* always remember the last value seen */
-        _last = input;
+        _last = input.getOwned();
         _memUsageBytes = sizeof(*this) + _last.getApproximateSize() - sizeof(Value);
     }
 
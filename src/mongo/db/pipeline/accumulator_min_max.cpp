@@ -44,7 +44,7 @@ namespace mongo {
             /* compare with the current value; swap if appropriate */
             int cmp = Value::compare(_val, input) * _sense;
             if (cmp > 0 || _val.missing()) { // missing is lower than all other values
-                _val = input;
+                _val = input.getOwned();
                 _memUsageBytes = sizeof(*this) + input.getApproximateSize() - sizeof(Value);
             }
         }
@@ -42,7 +42,7 @@ namespace mongo {
     void AccumulatorPush::processInternal(const Value& input, bool merging) {
         if (!merging) {
             if (!input.missing()) {
-                vpValue.push_back(input);
+                vpValue.push_back(input.getOwned());
                 _memUsageBytes += input.getApproximateSize();
             }
         }
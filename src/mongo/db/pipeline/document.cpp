@@ -34,11 +34,12 @@
 #include "mongo/db/pipeline/document.h"
 
 #include <boost/functional/hash.hpp>
-#include <boost/scoped_array.hpp>
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/field_path.h"
+#include "mongo/util/bump_arena.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
     using namespace mongoutils;
@@ -147,13 +148,14 @@ namespace mongo {
         uassert(16490, "Tried to make oversized document",
                 capacity <= size_t(BufferMaxSize));
 
-        boost::scoped_array<char> oldBuf(_buffer);
-        _buffer = new char[capacity];
+        char* const oldBuf = _buffer;
+        ON_BLOCK_EXIT(BumpArena::free, oldBuf);
+        _buffer = static_cast<char*>(BumpArena::allocate(capacity));
         _bufferEnd = _buffer + capacity - hashTabBytes();
 
         if (!firstAlloc) {
             // This just copies the elements
-            memcpy(_buffer, oldBuf.get(), _usedBytes);
+            memcpy(_buffer, oldBuf, _usedBytes);
 
             if (_numFields >= HASH_TAB_MIN) {
                 // if we were hashing, deal with the hash table
@@ -162,7 +164,7 @@ namespace mongo {
                 }
                 else {
                     // no rehash needed so just slide table down to new position
-                    memcpy(_hashTab, oldBuf.get() + oldCapacity, hashTabBytes());
+                    memcpy(_hashTab, oldBuf + oldCapacity, hashTabBytes());
                 }
             }
         }
@@ -182,7 +184,7 @@ namespace mongo {
         uassert(16491, "Tried to make oversized document",
                 newSize <= size_t(BufferMaxSize));
 
-        _buffer = new char[newSize + hashTabBytes()];
+        _buffer = static_cast<char*>(BumpArena::allocate(newSize + hashTabBytes()));
         _bufferEnd = _buffer + newSize;
     }
 
@@ -192,7 +194,7 @@ namespace mongo {
         // Make a copy of the buffer.
         // It is very important that the positions of each field are the same after cloning.
         const size_t bufferBytes = (_bufferEnd + hashTabBytes()) - _buffer;
-        out->_buffer = new char[bufferBytes];
+        out->_buffer = static_cast<char*>(BumpArena::allocate(bufferBytes));
         out->_bufferEnd = out->_buffer + (_bufferEnd - _buffer);
         memcpy(out->_buffer, _buffer, bufferBytes);
 
@@ -212,7 +214,7 @@ namespace mongo {
     }
 
     DocumentStorage::~DocumentStorage() {
-        boost::scoped_array<char> deleteBufferAtScopeEnd (_buffer);
+        ON_BLOCK_EXIT(BumpArena::free, _buffer);
 
         for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
             it->val.~Value(); // explicit destructor call
@@ -439,6 +441,33 @@ namespace mongo {
         }
     }
 
+    bool Document::isInArena() const {
+        if (!_storage)
+            return false;
+
+        if (storage().isInArena())
+            return true;
+
+        for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
+            if (it->val.isInArena())
+                return true;
+        }
+        return false;
+    }
+
+    Document Document::getOwned() const {
+        if (!isInArena())
+            return *this;
+
+        BumpArena::Scope heapScope(NULL);
+        MutableDocument out(size());
+        for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
+            out.addField(it->nameSD(), it->val.getOwned());
+        }
+        out.copyMetaDataFrom(*this);
+        return out.freeze();
+    }
+
     Document Document::deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&) {
         const int numElems = buf.read<int>();
         MutableDocument doc(numElems);
@@ -185,7 +185,15 @@ namespace mongo {
         void serializeForSorter(BufBuilder& buf) const;
         static Document deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&);
         int memUsageForSorter() const { return getApproximateSize(); }
-        Document getOwned() const { return *this; }
+
+        /**
+         * Returns a Document that doesn't live in any BumpArena, deep-copying this one if it or
+         * any of its values does. Use it before keeping a document past the current batch.
+         */
+        Document getOwned() const;
+
+        /// True if this document or any value in it lives in a BumpArena.
+        bool isInArena() const;
 
         /// only for testing
         const void* getPtr() const { return _storage.get(); }
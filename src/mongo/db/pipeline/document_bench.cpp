@@ -0,0 +1,121 @@
+// document_bench.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/field_path.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/unittest/benchmark.h"
+
+namespace mongo {
+namespace {
+
+    using unittest::doNotOptimizeAway;
+
+    BSONObj makeBson() {
+        return fromjson("{_id: 1, name: 'widget', price: 25.5, qty: 100,"
+                        " tags: ['a', 'b', 'c'], dims: {h: 10, w: 20, d: 5}, status: 'active'}");
+    }
+
+    BENCHMARK(Document, FromBson) {
+        const BSONObj bson = makeBson();
+        while (state.keepRunning()) {
+            doNotOptimizeAway(Document(bson));
+        }
+    }
+
+    BENCHMARK(Document, ToBson) {
+        const Document doc(makeBson());
+        while (state.keepRunning()) {
+            doNotOptimizeAway(doc.toBson());
+        }
+    }
+
+    BENCHMARK(Document, GetField) {
+        const Document doc(makeBson());
+        while (state.keepRunning()) {
+            doNotOptimizeAway(doc["status"]);
+        }
+    }
+
+    BENCHMARK(Document, GetNestedField) {
+        const Document doc(makeBson());
+        const FieldPath path("dims.w");
+        while (state.keepRunning()) {
+            doNotOptimizeAway(doc.getNestedField(path));
+        }
+    }
+
+    BENCHMARK(Document, BuildTenFields) {
+        while (state.keepRunning()) {
+            MutableDocument md;
+            md.addField("a", Value(1));
+            md.addField("b", Value(2));
+            md.addField("c", Value(3));
+            md.addField("d", Value(4));
+            md.addField("e", Value(5));
+            md.addField("f", Value(6));
+            md.addField("g", Value(7));
+            md.addField("h", Value(8));
+            md.addField("i", Value(9));
+            md.addField("j", Value(10));
+            doNotOptimizeAway(md.freeze());
+        }
+    }
+
+    BENCHMARK(Document, Compare) {
+        const Document lhs(makeBson());
+        const Document rhs(makeBson());
+        while (state.keepRunning()) {
+            doNotOptimizeAway(Document::compare(lhs, rhs));
+        }
+    }
+
+    BENCHMARK(Value, CompareNumbers) {
+        const Value lhs(25);
+        const Value rhs(25.5);
+        while (state.keepRunning()) {
+            doNotOptimizeAway(Value::compare(lhs, rhs));
+        }
+    }
+
+    BENCHMARK(Value, CompareStrings) {
+        const Value lhs(std::string("some string value a"));
+        const Value rhs(std::string("some string value b"));
+        while (state.keepRunning()) {
+            doNotOptimizeAway(Value::compare(lhs, rhs));
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
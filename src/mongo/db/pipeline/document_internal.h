@@ -33,6 +33,7 @@
 #include <boost/intrusive_ptr.hpp>
 #include <boost/noncopyable.hpp>
 
+#include "mongo/util/bump_arena.h"
 #include "mongo/util/intrusive_counter.h"
 #include "mongo/db/pipeline/value.h"
 
@@ -174,6 +175,10 @@ namespace mongo {
         {}
         ~DocumentStorage();
 
+        // DocumentStorage and its buffer come from the current BumpArena, if any.
+        static void* operator new(size_t bytes) { return BumpArena::allocate(bytes); }
+        static void operator delete(void* ptr) { BumpArena::free(ptr); }
+
         static const DocumentStorage& emptyDoc() {
             static const char emptyBytes[sizeof(DocumentStorage)] = {0};
             return *reinterpret_cast<const DocumentStorage*>(emptyBytes);
@@ -238,6 +243,13 @@ namespace mongo {
         /// Shallow copy of this. Caller owns memory.
         boost::intrusive_ptr<DocumentStorage> clone() const;
 
+        /// True if this or its buffer lives in a BumpArena. emptyDoc() never does.
+        bool isInArena() const {
+            if (this == &emptyDoc())
+                return false;
+            return BumpArena::isInArena(this) || (_buffer && BumpArena::isInArena(_buffer));
+        }
+
         size_t allocatedBytes() const {
             return !_buffer ? 0 : (_bufferEnd - _buffer + hashTabBytes());
         }
@@ -39,6 +39,7 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/unordered_map.hpp>
 #include <deque>
+#include <list>
 
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/jsobj.h"
@@ -161,6 +162,13 @@ namespace mongo {
         /// Returns true if doesn't require an input source (most DocumentSources do).
         virtual bool isValidInitialSource() const { return false; }
 
+        /**
+         * Returns the sort pattern, like {a: 1, b: -1}, that the output of this source is known to
+         * follow, or an empty object if there is none. Stages that neither reorder documents nor
+         * change their fields pass on the order of their own source.
+         */
+        virtual BSONObj getOutputSort() const { return BSONObj(); }
+
     protected:
         /**
            Base constructor.
@@ -357,6 +365,7 @@ namespace mongo {
         virtual bool coalesce(const boost::intrusive_ptr<DocumentSource>& nextSource);
         virtual bool isValidInitialSource() const { return true; }
         virtual void dispose();
+        virtual BSONObj getOutputSort() const { return _sort; }
 
         /**
          * Create a document source based on a passed-in PlanExecutor.
@@ -415,8 +424,27 @@ namespace mongo {
 
         void loadBatch();
 
+        /**
+         * Accounts for a batch of 'bytes' read in 'millis', and sizes the next one from it.
+         * 'yields' is how many times the executor gave up the lock on its own meanwhile.
+         */
+        void recordBatch(int bytes, long long millis, long long yields);
+
         std::deque<Document> _currentBatch;
 
+        // How many bytes of documents the next batch may read. It doubles after batches read
+        // quicker than internalDocumentSourceCursorBatchTargetMS and halves after slower ones, or
+        // ones during which the executor had to yield, between kMinBatchBytes and
+        // internalDocumentSourceCursorBatchSizeBytes.
+        int _batchBudgetBytes;
+        static const int kMinBatchBytes = 64 * 1024;
+
+        // Batching stats, for explain.
+        long long _numBatches;
+        long long _numBatchedBytes;
+        long long _numSlowBatches; // batches that took longer than the target
+        long long _numExecutorYields;
+
         // BSONObj members must outlive _projection and cursor.
         BSONObj _query;
         BSONObj _sort;
@@ -469,6 +497,13 @@ namespace mongo {
         /// Tell this source if it is doing a merge from shards. Defaults to false.
         void setDoingMerge(bool doingMerge) { _doingMerge = doingMerge; }
 
+        /**
+         * Returns {f1: 1, f2: 1, ...} for the input fields _id is made of, or an empty object if
+         * _id isn't made of field paths only. Input sorted on the first of these fields, in any
+         * order and direction, is grouped as it streams rather than all at once.
+         */
+        BSONObj getKeyPattern() const;
+
         /**
           Create a grouping DocumentSource from BSON.
 
@@ -508,6 +543,24 @@ namespace mongo {
         void populate();
         bool populated;
 
+        /**
+         * Adds the root document of _variables to the group for 'id' in groups, spilling groups to
+         * disk first if they use too much memory.
+         */
+        void addToGroups(const Value& id);
+
+        /// Sets up the output of groups, or of the spilled files, once all input is consumed.
+        void prepareToOutput();
+
+        /// True if the input is sorted such that the documents of each group come together.
+        bool inputIsGroupedByKey() const;
+
+        /**
+         * Returns the next group when streaming, as soon as the input moves on to the next one, or
+         * boost::none at EOF. Groups the input order can't be relied on for go to groups instead.
+         */
+        boost::optional<Document> getNextStreaming();
+
         /**
          * Parses the raw id expression into _idExpressions and possibly _idFieldNames.
          */
@@ -559,11 +612,22 @@ namespace mongo {
         // only used when !_spilled
         GroupsMap::iterator groupsIterator;
 
+        // used until populated
+        int _memoryUsageBytes; // of groups, reset on spill()
+        std::vector<boost::shared_ptr<Sorter<Value, Value>::Iterator> > _sortedFiles;
+
+        // set on the first call to getNext(), once the source knows its output order
+        bool _initialized;
+        bool _streaming;
+
         // only used when _spilled
         boost::scoped_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
         std::pair<Value, Value> _firstPartOfNextGroup;
+
+        // used when _spilled, or by the group in progress when _streaming
         Value _currentId;
         Accumulators _currentAccumulators;
+        bool _haveStreamingGroup;
     };
 
 
@@ -575,6 +639,9 @@ namespace mongo {
         virtual bool coalesce(const boost::intrusive_ptr<DocumentSource>& nextSource);
         virtual Value serialize(bool explain = false) const;
         virtual void setSource(DocumentSource* Source);
+        virtual BSONObj getOutputSort() const {
+            return pSource ? pSource->getOutputSort() : BSONObj();
+        }
 
         /**
           Create a filter.
@@ -719,12 +786,95 @@ namespace mongo {
 
         void spill(DBClientBase* conn, const std::vector<BSONObj>& toInsert);
 
+        // Builds _indexSpecs on _tempNs, once all the data is in.
+        void buildIndexes(DBClientBase* conn);
+
         bool _done;
 
+        // The indexes of _outputNs, for _tempNs. Inserts don't maintain them, they are built in
+        // bulk at the end instead.
+        std::vector<BSONObj> _indexSpecs;
+
         NamespaceString _tempNs; // output goes here as it is being processed.
         const NamespaceString _outputNs; // output will go here after all data is processed.
     };
 
+
+    /**
+     * Joins each input document to the documents of another collection in the same database
+     * whose 'foreignField' equals its 'localField', adding them as an array in its 'as' field.
+     *
+     * {$lookup: {from: <collection>, localField: <path>, foreignField: <path>, as: <path>}}
+     *
+     * The keys of a batch of input documents are looked up together with a single $in query, and
+     * the matches of recently seen keys are cached across batches.
+     */
+    class DocumentSourceLookUp : public DocumentSource
+                               , public SplittableDocumentSource
+                               , public DocumentSourceNeedsMongod {
+    public:
+        // virtuals from DocumentSource
+        virtual boost::optional<Document> getNext();
+        virtual const char *getSourceName() const;
+        virtual Value serialize(bool explain = false) const;
+        virtual GetDepsReturn getDependencies(DepsTracker* deps) const;
+        virtual void dispose();
+
+        // Virtuals for SplittableDocumentSource
+        // The foreign collection is only complete on the primary shard, so this runs in the merger.
+        virtual boost::intrusive_ptr<DocumentSource> getShardSource() { return NULL; }
+        virtual boost::intrusive_ptr<DocumentSource> getMergeSource() { return this; }
+
+        const NamespaceString& getFromNs() const { return _fromNs; }
+
+        static boost::intrusive_ptr<DocumentSource> createFromBson(
+            BSONElement elem,
+            const boost::intrusive_ptr<ExpressionContext> &pExpCtx);
+
+        static const char lookupName[];
+
+        // Input documents whose keys are looked up together.
+        static const size_t kBatchSize = 100;
+
+        // Keys whose matches are kept across batches.
+        static const size_t kMaxCachedKeys = 1000;
+
+    private:
+        DocumentSourceLookUp(const NamespaceString& fromNs,
+                             const std::string& as,
+                             const std::string& localField,
+                             const std::string& foreignField,
+                             const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
+
+        typedef std::vector<Value> Matches;
+
+        /**
+         * Reads the next batch of input into _buffered and makes sure _cache has the matches of
+         * all their keys.
+         */
+        void loadBatch();
+
+        /// Returns the key of 'input', the value of its localField with missing treated as null.
+        Value getKey(const Document& input) const;
+
+        /// Caches 'matches' for 'key', evicting the least recently used keys if needed.
+        void cacheMatches(const Value& key, const Matches& matches);
+
+        const NamespaceString _fromNs;
+        const FieldPath _as;
+        const FieldPath _localField;
+        const std::string _foreignField;
+
+        std::deque<Document> _buffered;
+
+        // Recently used keys, most recent first, and their matches.
+        typedef std::list<Value> LruList;
+        typedef boost::unordered_map<Value, std::pair<Matches, LruList::iterator>, Value::Hash>
+            Cache;
+        LruList _lru;
+        Cache _cache;
+    };
+
     
     class DocumentSourceProject : public DocumentSource {
     public:
@@ -802,6 +952,7 @@ namespace mongo {
         virtual void serializeToArray(std::vector<Value>& array, bool explain = false) const;
         virtual bool coalesce(const boost::intrusive_ptr<DocumentSource> &pNextSource);
         virtual void dispose();
+        virtual BSONObj getOutputSort() const;
 
         virtual GetDepsReturn getDependencies(DepsTracker* deps) const;
 
@@ -921,6 +1072,10 @@ namespace mongo {
             return SEE_NEXT; // This doesn't affect needed fields
         }
 
+        virtual BSONObj getOutputSort() const {
+            return pSource ? pSource->getOutputSort() : BSONObj();
+        }
+
         /**
           Create a new limiting DocumentSource.
 
@@ -977,6 +1132,10 @@ namespace mongo {
             return SEE_NEXT; // This doesn't affect needed fields
         }
 
+        virtual BSONObj getOutputSort() const {
+            return pSource ? pSource->getOutputSort() : BSONObj();
+        }
+
         /**
           Create a new skipping DocumentSource.
 
@@ -1051,6 +1210,9 @@ namespace mongo {
         /** Specify the field to unwind. */
         void unwindPath(const FieldPath &fieldPath);
 
+        /** Next document from _unwinder, allocated in the expression context's arena. */
+        boost::optional<Document> unwindNext();
+
         // Configuration state.
         boost::scoped_ptr<FieldPath> _unwindPath;
 
@@ -37,9 +37,10 @@
 #include "mongo/db/instance.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/query/explain.h"
-#include "mongo/db/query/find_constants.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/s/d_state.h"
+#include "mongo/util/timer.h"
 
 
 namespace mongo {
@@ -90,6 +91,14 @@ namespace mongo {
 
         _exec->restoreState(pExpCtx->opCtx);
 
+        // The budget may have been left above a maximum lowered since.
+        _batchBudgetBytes = std::min(_batchBudgetBytes,
+                                     std::max(int(kMinBatchBytes),
+                                              internalDocumentSourceCursorBatchSizeBytes));
+        const int targetMillis = internalDocumentSourceCursorBatchTargetMS;
+        const long long yieldsBefore = _exec->getNumYields();
+        Timer timer;
+
         int memUsageBytes = 0;
         BSONObj obj;
         PlanExecutor::ExecState state;
@@ -110,13 +119,16 @@ namespace mongo {
 
             memUsageBytes += _currentBatch.back().getApproximateSize();
 
-            if (memUsageBytes > MaxBytesToReturnToClientAtOnce) {
+            if (memUsageBytes > _batchBudgetBytes || timer.millis() >= targetMillis) {
                 // End this batch and prepare PlanExecutor for yielding.
+                recordBatch(memUsageBytes, timer.millis(), _exec->getNumYields() - yieldsBefore);
                 _exec->saveState();
                 return;
             }
         }
 
+        recordBatch(memUsageBytes, timer.millis(), _exec->getNumYields() - yieldsBefore);
+
         // If we got here, there won't be any more documents, so destroy the executor. Can't use
         // dispose since we want to keep the _currentBatch.
         _exec.reset();
@@ -131,6 +143,27 @@ namespace mongo {
                 state == PlanExecutor::IS_EOF || state == PlanExecutor::ADVANCED);
     }
 
+    void DocumentSourceCursor::recordBatch(int bytes, long long millis, long long yields) {
+        const bool slow = millis >= internalDocumentSourceCursorBatchTargetMS;
+
+        _numBatches++;
+        _numBatchedBytes += bytes;
+        _numExecutorYields += yields;
+        if (slow)
+            _numSlowBatches++;
+
+        if (slow || yields > 0) {
+            // The lock was held long enough, or the executor had to give it up: read less.
+            _batchBudgetBytes = std::max(_batchBudgetBytes / 2, int(kMinBatchBytes));
+        }
+        else if (bytes > _batchBudgetBytes) {
+            // The budget filled up well within the target: read more.
+            const int maxBytes = std::max(int(kMinBatchBytes),
+                                          internalDocumentSourceCursorBatchSizeBytes);
+            _batchBudgetBytes = std::min(_batchBudgetBytes, maxBytes / 2) * 2;
+        }
+    }
+
     void DocumentSourceCursor::setSource(DocumentSource *pSource) {
         /* this doesn't take a source */
         verify(false);
@@ -186,6 +219,12 @@ namespace mongo {
         if (!_projection.isEmpty())
             out["fields"] = Value(_projection);
 
+        out["batching"] = Value(DOC("batches" << _numBatches
+                                 << "bytes" << _numBatchedBytes
+                                 << "slowBatches" << _numSlowBatches
+                                 << "executorYields" << _numExecutorYields
+                                 << "nextBatchBytes" << _batchBudgetBytes));
+
         // Add explain results from the query system into the agg explain output.
         BSONObj explainObj = explainBuilder.obj();
         invariant(explainObj.hasField("queryPlanner"));
@@ -198,6 +237,11 @@ namespace mongo {
                                                const boost::shared_ptr<PlanExecutor>& exec,
                                                const intrusive_ptr<ExpressionContext> &pCtx)
         : DocumentSource(pCtx)
+        , _batchBudgetBytes(4 * kMinBatchBytes)
+        , _numBatches(0)
+        , _numBatchedBytes(0)
+        , _numSlowBatches(0)
+        , _numExecutorYields(0)
         , _docsAddedToBatches(0)
         , _ns(ns)
         , _exec(exec)
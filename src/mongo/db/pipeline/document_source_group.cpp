@@ -54,6 +54,19 @@ namespace mongo {
     boost::optional<Document> DocumentSourceGroup::getNext() {
         pExpCtx->checkForInterrupt();
 
+        if (!_initialized) {
+            _streaming = inputIsGroupedByKey();
+            _initialized = true;
+        }
+
+        if (_streaming && !populated) {
+            if (boost::optional<Document> out = getNextStreaming())
+                return out;
+
+            // The input is exhausted. Only the groups held back in groups, if any, are left.
+            prepareToOutput();
+        }
+
         if (!populated)
             populate();
 
@@ -206,6 +219,10 @@ namespace mongo {
         , _spilled(false)
         , _extSortAllowed(pExpCtx->extSortAllowed && !pExpCtx->inRouter)
         , _maxMemoryUsageBytes(100*1024*1024)
+        , _memoryUsageBytes(0)
+        , _initialized(false)
+        , _streaming(false)
+        , _haveStreamingGroup(false)
     {}
 
     void DocumentSourceGroup::addAccumulator(
@@ -234,6 +251,8 @@ namespace mongo {
     */
     static const GroupOpDesc GroupOpTable[] = {
         {"$addToSet", AccumulatorAddToSet::create},
+        {"$approxCountDistinct", AccumulatorApproxCountDistinct::create},
+        {"$approxPercentile", AccumulatorApproxPercentile::create},
         {"$avg", AccumulatorAvg::create},
         {"$first", AccumulatorFirst::create},
         {"$last", AccumulatorLast::create},
@@ -355,23 +374,8 @@ namespace mongo {
     }
 
     void DocumentSourceGroup::populate() {
-        const size_t numAccumulators = vpAccumulatorFactory.size();
-        dassert(numAccumulators == vpExpression.size());
-
-        // pushed to on spill()
-        vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
-        int memoryUsageBytes = 0;
-
         // This loop consumes all input from pSource and buckets it based on pIdExpression.
         while (boost::optional<Document> input = pSource->getNext()) {
-            if (memoryUsageBytes > _maxMemoryUsageBytes) {
-                uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort."
-                               " Pass allowDiskUse:true to opt in.",
-                        _extSortAllowed);
-                sortedFiles.push_back(spill());
-                memoryUsageBytes = 0;
-            }
-
             _variables->setRoot(*input);
 
             /* get the _id value */
@@ -381,56 +385,81 @@ namespace mongo {
             if (id.missing())
                 id = Value(BSONNULL);
 
-            /*
-              Look for the _id value in the map; if it's not there, add a
-              new entry with a blank accumulator.
-            */
-            const size_t oldSize = groups.size();
-            vector<intrusive_ptr<Accumulator> >& group = groups[id];
-            const bool inserted = groups.size() != oldSize;
+            addToGroups(id);
 
-            if (inserted) {
-                memoryUsageBytes += id.getApproximateSize();
+            // We are done with the ROOT document so release it.
+            _variables->clearRoot();
+        }
 
-                // Add the accumulators
-                group.reserve(numAccumulators);
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    group.push_back(vpAccumulatorFactory[i]());
-                }
-            } else {
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    // subtract old mem usage. New usage added back after processing.
-                    memoryUsageBytes -= group[i]->memUsageForSorter();
-                }
-            }
+        prepareToOutput();
+    }
+
+    void DocumentSourceGroup::addToGroups(const Value& id) {
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+        dassert(numAccumulators == vpExpression.size());
 
-            /* tickle all the accumulators for the group we found */
-            dassert(numAccumulators == group.size());
+        if (_memoryUsageBytes > _maxMemoryUsageBytes) {
+            uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort."
+                           " Pass allowDiskUse:true to opt in.",
+                    _extSortAllowed);
+            _sortedFiles.push_back(spill());
+            _memoryUsageBytes = 0;
+        }
+
+        /*
+          Look for the _id value in the map; if it's not there, add a
+          new entry with a blank accumulator.
+        */
+        GroupsMap::iterator groupIt = groups.find(id);
+        const bool inserted = groupIt == groups.end();
+        if (inserted) {
+            // The key outlives this input document, so it must not point into its arena.
+            groupIt = groups.insert(make_pair(id.getOwned(), Accumulators())).first;
+        }
+        vector<intrusive_ptr<Accumulator> >& group = groupIt->second;
+
+        if (inserted) {
+            _memoryUsageBytes += id.getApproximateSize();
+
+            // Add the accumulators
+            group.reserve(numAccumulators);
             for (size_t i = 0; i < numAccumulators; i++) {
-                group[i]->process(vpExpression[i]->evaluate(_variables.get()), _doingMerge);
-                memoryUsageBytes += group[i]->memUsageForSorter();
+                group.push_back(vpAccumulatorFactory[i]());
             }
+        } else {
+            for (size_t i = 0; i < numAccumulators; i++) {
+                // subtract old mem usage. New usage added back after processing.
+                _memoryUsageBytes -= group[i]->memUsageForSorter();
+            }
+        }
 
-            // We are done with the ROOT document so release it.
-            _variables->clearRoot();
+        /* tickle all the accumulators for the group we found */
+        dassert(numAccumulators == group.size());
+        for (size_t i = 0; i < numAccumulators; i++) {
+            group[i]->process(vpExpression[i]->evaluate(_variables.get()), _doingMerge);
+            _memoryUsageBytes += group[i]->memUsageForSorter();
+        }
 
-            DEV {
-                // In debug mode, spill every time we have a duplicate id to stress merge logic.
-                if (!inserted // is a dup
-                        && !pExpCtx->inRouter // can't spill to disk in router
-                        && !_extSortAllowed // don't change behavior when testing external sort
-                        && sortedFiles.size() < 20 // don't open too many FDs
-                        ) {
-                    sortedFiles.push_back(spill());
-                }
+        DEV {
+            // In debug mode, spill every time we have a duplicate id to stress merge logic.
+            if (!inserted // is a dup
+                    && !pExpCtx->inRouter // can't spill to disk in router
+                    && !_extSortAllowed // don't change behavior when testing external sort
+                    && _sortedFiles.size() < 20 // don't open too many FDs
+                    ) {
+                _sortedFiles.push_back(spill());
             }
         }
+    }
+
+    void DocumentSourceGroup::prepareToOutput() {
+        const size_t numAccumulators = vpAccumulatorFactory.size();
 
         // These blocks do any final steps necessary to prepare to output results.
-        if (!sortedFiles.empty()) {
+        if (!_sortedFiles.empty()) {
             _spilled = true;
             if (!groups.empty()) {
-                sortedFiles.push_back(spill());
+                _sortedFiles.push_back(spill());
             }
 
             // We won't be using groups again so free its memory.
@@ -438,9 +467,11 @@ namespace mongo {
 
             _sorterIterator.reset(
                     Sorter<Value,Value>::Iterator::merge(
-                        sortedFiles, SortOptions(), SorterComparator()));
+                        _sortedFiles, SortOptions(), SorterComparator()));
+            _sortedFiles.clear();
 
             // prepare current to accumulate data
+            _currentAccumulators.clear();
             _currentAccumulators.reserve(numAccumulators);
             for (size_t i = 0; i < numAccumulators; i++) {
                 _currentAccumulators.push_back(vpAccumulatorFactory[i]());
@@ -456,6 +487,134 @@ namespace mongo {
         populated = true;
     }
 
+    namespace {
+        /**
+         * Returns false for the group keys that sort orders may not keep together. The query
+         * system sorts missing fields with nulls and arrays by one of their elements, while $group
+         * tells missing apart from null below the top level and compares arrays as a whole.
+         */
+        bool sortsLikeItGroups(const Value& value) {
+            switch (value.getType()) {
+            case EOO:
+            case jstNULL:
+            case Undefined:
+            case Array:
+                return false;
+            default:
+                return true;
+            }
+        }
+    }
+
+    BSONObj DocumentSourceGroup::getKeyPattern() const {
+        BSONObjBuilder pattern;
+        for (size_t i = 0; i < _idExpressions.size(); i++) {
+            const ExpressionFieldPath* fieldPath =
+                dynamic_cast<const ExpressionFieldPath*>(_idExpressions[i].get());
+            if (!fieldPath)
+                return BSONObj();
+
+            // "$a" is stored as CURRENT.a, which is the input document here just like ROOT.a.
+            const FieldPath& withVariable = fieldPath->getFieldPath();
+            if (withVariable.getPathLength() < 2
+                    || (withVariable.getFieldName(0) != "CURRENT"
+                        && withVariable.getFieldName(0) != "ROOT"))
+                return BSONObj();
+
+            pattern.append(withVariable.tail().getPath(false), 1);
+        }
+        return pattern.obj();
+    }
+
+    bool DocumentSourceGroup::inputIsGroupedByKey() const {
+        const BSONObj keyPattern = getKeyPattern();
+        if (keyPattern.isEmpty())
+            return false;
+
+        set<string> keyFields;
+        BSONForEach(field, keyPattern) {
+            keyFields.insert(field.fieldName());
+        }
+
+        // Documents with the same key are together if the first fields of the sort are the key's.
+        const BSONObj sort = pSource->getOutputSort();
+        BSONObjIterator sortIt(sort);
+        for (int i = 0; i < keyPattern.nFields(); i++) {
+            if (!sortIt.more() || !keyFields.count(sortIt.next().fieldName()))
+                return false;
+        }
+        return true;
+    }
+
+    boost::optional<Document> DocumentSourceGroup::getNextStreaming() {
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+
+        while (boost::optional<Document> input = pSource->getNext()) {
+            _variables->setRoot(*input);
+
+            Value id = computeId(_variables.get());
+            if (id.missing())
+                id = Value(BSONNULL);
+
+            bool streamable = true;
+            if (_idExpressions.size() == 1) {
+                streamable = sortsLikeItGroups(id);
+            }
+            else {
+                const vector<Value>& parts = id.getArray();
+                for (size_t i = 0; i < parts.size() && streamable; i++) {
+                    streamable = sortsLikeItGroups(parts[i]);
+                }
+            }
+
+            if (!streamable) {
+                // Output once the input is exhausted, like when not streaming.
+                addToGroups(id);
+                _variables->clearRoot();
+                continue;
+            }
+
+            boost::optional<Document> out;
+            if (_haveStreamingGroup && Value::compare(id, _currentId) != 0) {
+                // The input moved on to the next group, so the current one is complete.
+                out = makeDocument(_currentId, _currentAccumulators, pExpCtx->inShard);
+                _haveStreamingGroup = false;
+            }
+
+            if (!_haveStreamingGroup) {
+                if (_currentAccumulators.empty()) {
+                    _currentAccumulators.reserve(numAccumulators);
+                    for (size_t i = 0; i < numAccumulators; i++) {
+                        _currentAccumulators.push_back(vpAccumulatorFactory[i]());
+                    }
+                }
+                else {
+                    for (size_t i = 0; i < numAccumulators; i++) {
+                        _currentAccumulators[i]->reset();
+                    }
+                }
+                _currentId = id.getOwned();
+                _haveStreamingGroup = true;
+            }
+
+            for (size_t i = 0; i < numAccumulators; i++) {
+                _currentAccumulators[i]->process(vpExpression[i]->evaluate(_variables.get()),
+                                                 _doingMerge);
+            }
+
+            _variables->clearRoot();
+
+            if (out)
+                return out;
+        }
+
+        if (_haveStreamingGroup) {
+            _haveStreamingGroup = false;
+            return makeDocument(_currentId, _currentAccumulators, pExpCtx->inShard);
+        }
+        return boost::none;
+    }
+
     class DocumentSourceGroup::SpillSTLComparator {
     public:
         bool operator() (const GroupsMap::value_type* lhs, const GroupsMap::value_type* rhs) const {
@@ -0,0 +1,258 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source.h"
+
+#include "mongo/client/dbclientcursor.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    using boost::intrusive_ptr;
+    using std::auto_ptr;
+    using std::string;
+    using std::vector;
+
+    const char DocumentSourceLookUp::lookupName[] = "$lookup";
+
+    DocumentSourceLookUp::DocumentSourceLookUp(const NamespaceString& fromNs,
+                                               const string& as,
+                                               const string& localField,
+                                               const string& foreignField,
+                                               const intrusive_ptr<ExpressionContext>& pExpCtx)
+        : DocumentSource(pExpCtx)
+        , _fromNs(fromNs)
+        , _as(as)
+        , _localField(localField)
+        , _foreignField(foreignField)
+    {}
+
+    const char* DocumentSourceLookUp::getSourceName() const {
+        return lookupName;
+    }
+
+    boost::optional<Document> DocumentSourceLookUp::getNext() {
+        pExpCtx->checkForInterrupt();
+
+        if (_buffered.empty()) {
+            loadBatch();
+            if (_buffered.empty())
+                return boost::none;
+        }
+
+        MutableDocument out(_buffered.front());
+        _buffered.pop_front();
+
+        Cache::iterator cached = _cache.find(getKey(out.peek()));
+        verify(cached != _cache.end()); // loadBatch() looked up the keys of all it buffered
+
+        out.setNestedField(_as, Value(cached->second.first));
+        return out.freeze();
+    }
+
+    Value DocumentSourceLookUp::getKey(const Document& input) const {
+        Value key = input.getNestedField(_localField);
+        if (key.missing())
+            return Value(BSONNULL); // like a query for null, this matches missing fields too
+        return key;
+    }
+
+    void DocumentSourceLookUp::loadBatch() {
+        typedef boost::unordered_map<Value, Matches, Value::Hash> KeyMatches;
+        KeyMatches toFind;
+
+        while (_buffered.size() < kBatchSize) {
+            boost::optional<Document> input = pSource->getNext();
+            if (!input)
+                break;
+
+            // Buffered documents outlive their batch, so copy them out of any arena.
+            _buffered.push_back(input->getOwned());
+
+            const Value key = getKey(*input);
+            Cache::iterator cached = _cache.find(key);
+            if (cached != _cache.end()) {
+                // Keeps the keys of this batch at the front, safe from eviction until it's done.
+                _lru.splice(_lru.begin(), _lru, cached->second.second);
+            }
+            else if (!toFind.count(key)) {
+                toFind[key.getOwned()];
+            }
+        }
+
+        if (toFind.empty())
+            return;
+
+        verify(_mongod);
+        uassert(28604, str::stream() << "namespace '" << _fromNs.ns()
+                                     << "' is sharded so it can't be used for $lookup",
+                !_mongod->isSharded(_fromNs));
+
+        DBClientBase* conn = _mongod->directClient();
+
+        // Most keys are looked up together with $in. $in would match arrays by their elements and
+        // regular expressions as patterns though, and a document can match null without having
+        // a null value to find it by, so those keys are looked up on their own.
+        BSONArrayBuilder inKeys;
+        for (KeyMatches::iterator it = toFind.begin(); it != toFind.end(); ++it) {
+            const Value& key = it->first;
+            switch (key.getType()) {
+            case Undefined:
+                break; // can't be queried for, so nothing matches
+
+            case Array:
+            case RegEx:
+            case jstNULL: {
+                BSONObjBuilder eq;
+                eq << "$eq" << key;
+                auto_ptr<DBClientCursor> cursor =
+                    conn->query(_fromNs.ns(), BSON(_foreignField << eq.obj()));
+                uassert(28605, "$lookup failed to query " + _fromNs.ns(), cursor.get());
+                while (cursor->more()) {
+                    it->second.push_back(Value(cursor->nextSafe()));
+                }
+                break;
+            }
+
+            default:
+                inKeys << key;
+                break;
+            }
+        }
+
+        if (inKeys.arrSize()) {
+            auto_ptr<DBClientCursor> cursor =
+                conn->query(_fromNs.ns(), BSON(_foreignField << BSON("$in" << inKeys.arr())));
+            uassert(28606, "$lookup failed to query " + _fromNs.ns(), cursor.get());
+            while (cursor->more()) {
+                const BSONObj obj = cursor->nextSafe();
+                const Value match(obj);
+
+                // Hand the document to each key it matched. The set holds equal values once.
+                BSONElementSet values;
+                obj.getFieldsDotted(_foreignField, values);
+                for (BSONElementSet::const_iterator value = values.begin();
+                        value != values.end(); ++value) {
+                    KeyMatches::iterator found = toFind.find(Value(*value));
+                    if (found == toFind.end())
+                        continue;
+
+                    const BSONType keyType = found->first.getType();
+                    if (keyType == Array || keyType == RegEx || keyType == jstNULL)
+                        continue; // looked up on their own
+
+                    found->second.push_back(match);
+                }
+            }
+        }
+
+        for (KeyMatches::const_iterator it = toFind.begin(); it != toFind.end(); ++it) {
+            cacheMatches(it->first, it->second);
+        }
+    }
+
+    void DocumentSourceLookUp::cacheMatches(const Value& key, const Matches& matches) {
+        // The keys of the batch being loaded are the most recent ones and there are at most
+        // kBatchSize of them, so making room for that many more than kMaxCachedKeys never evicts
+        // a key the batch still needs.
+        while (_lru.size() >= kMaxCachedKeys + kBatchSize) {
+            _cache.erase(_lru.back());
+            _lru.pop_back();
+        }
+
+        _lru.push_front(key);
+        _cache[key] = std::make_pair(matches, _lru.begin());
+    }
+
+    void DocumentSourceLookUp::dispose() {
+        _buffered.clear();
+        _cache.clear();
+        _lru.clear();
+        pSource->dispose();
+    }
+
+    intrusive_ptr<DocumentSource> DocumentSourceLookUp::createFromBson(
+            BSONElement elem,
+            const intrusive_ptr<ExpressionContext>& pExpCtx) {
+        uassert(28607, "the $lookup specification must be an Object", elem.type() == Object);
+
+        string from;
+        string as;
+        string localField;
+        string foreignField;
+        BSONForEach(argument, elem.Obj()) {
+            const StringData argName = argument.fieldNameStringData();
+            uassert(28608, str::stream() << "$lookup argument '" << argName
+                                         << "' must be a string, is type "
+                                         << typeName(argument.type()),
+                    argument.type() == String);
+
+            if (argName == "from") {
+                from = argument.String();
+            }
+            else if (argName == "as") {
+                as = argument.String();
+            }
+            else if (argName == "localField") {
+                localField = argument.String();
+            }
+            else if (argName == "foreignField") {
+                foreignField = argument.String();
+            }
+            else {
+                uasserted(28609, str::stream() << "unknown argument to $lookup: " << argName);
+            }
+        }
+
+        uassert(28610, "$lookup requires 'from', 'as', 'localField' and 'foreignField'",
+                !from.empty() && !as.empty() && !localField.empty() && !foreignField.empty());
+
+        const NamespaceString fromNs(pExpCtx->ns.db(), from);
+        uassert(28611, "invalid $lookup namespace: " + fromNs.ns(), fromNs.isValid());
+
+        return new DocumentSourceLookUp(fromNs, as, localField, foreignField, pExpCtx);
+    }
+
+    Value DocumentSourceLookUp::serialize(bool explain) const {
+        return Value(DOC(getSourceName() << DOC("from" << _fromNs.coll()
+                                                << "as" << _as.getPath(false)
+                                                << "localField" << _localField.getPath(false)
+                                                << "foreignField" << _foreignField)));
+    }
+
+    DocumentSource::GetDepsReturn DocumentSourceLookUp::getDependencies(
+            DepsTracker* deps) const {
+        deps->fields.insert(_localField.getPath(false));
+        return SEE_NEXT;
+    }
+}
@@ -85,23 +85,35 @@ namespace mongo {
                     ok);
         }
 
-        // copy indexes on _outputNs to _tempNs
+        // Remember the indexes on _outputNs, to build them on _tempNs once it is filled. The _id
+        // index came with the collection.
         const std::list<BSONObj> indexes = conn->getIndexSpecs(_outputNs);
         for (std::list<BSONObj>::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
+            if (str::equals((*it)["name"].valuestrsafe(), "_id_"))
+                continue;
+
             MutableDocument index((Document(*it)));
             index.remove("_id"); // indexes shouldn't have _ids but some existing ones do
             index["ns"] = Value(_tempNs.ns());
-
-            BSONObj indexBson = index.freeze().toBson();
-            conn->insert(_tempNs.getSystemIndexesCollection(), indexBson);
-            BSONObj err = conn->getLastErrorDetailed();
-            uassert(16995, str::stream() << "copying index for $out failed."
-                                         << " index: " << indexBson
-                                         << " error: " <<  err,
-                    DBClientWithCommands::getLastErrorString(err).empty());
+            _indexSpecs.push_back(index.freeze().toBson());
         }
     }
 
+    void DocumentSourceOut::buildIndexes(DBClientBase* conn) {
+        if (_indexSpecs.empty())
+            return;
+
+        // A single createIndexes builds all of them in one pass over the collection, with sorted
+        // bulk loads rather than an index insert per document.
+        BSONObj info;
+        bool ok = conn->runCommand(_outputNs.db().toString(),
+                                   BSON("createIndexes" << _tempNs.coll()
+                                     << "indexes" << _indexSpecs),
+                                   info);
+        uassert(16995, str::stream() << "copying indexes for $out failed: " << info,
+                ok);
+    }
+
     void DocumentSourceOut::spill(DBClientBase* conn, const vector<BSONObj>& toInsert) {
         conn->insert(_tempNs.ns(), toInsert);
         BSONObj err = conn->getLastErrorDetailed();
@@ -139,6 +151,8 @@ namespace mongo {
         if (!bufferedObjects.empty())
             spill(conn, bufferedObjects);
 
+        buildIndexes(conn);
+
         // Checking again to make sure we didn't become sharded while running.
         uassert(17018, str::stream() << "namespace '" << _outputNs.ns()
                                      << "' became sharded so it can't be used for $out'",
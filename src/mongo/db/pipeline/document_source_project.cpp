@@ -62,6 +62,9 @@ namespace mongo {
         if (!input)
             return boost::none;
 
+        // The input stays on the heap, only what we build here goes to the arena.
+        BumpArena::Scope arenaScope(&pExpCtx->arena);
+
         /* create the result document */
         const size_t sizeHint = pEO->getSizeHint();
         MutableDocument out (sizeHint);
@@ -116,6 +116,19 @@ namespace mongo {
         vAscending.push_back(ascending);
     }
 
+    BSONObj DocumentSourceSort::getOutputSort() const {
+        // Only the leading field path keys can be described as a sort pattern.
+        BSONObjBuilder pattern;
+        for (size_t i = 0; i < vSortKey.size(); i++) {
+            ExpressionFieldPath* efp = dynamic_cast<ExpressionFieldPath*>(vSortKey[i].get());
+            if (!efp)
+                break;
+
+            pattern.append(efp->getFieldPath().tail().getPath(false), vAscending[i] ? 1 : -1);
+        }
+        return pattern.obj();
+    }
+
     Document DocumentSourceSort::serializeSortKey(bool explain) const {
         MutableDocument keyObj;
         // add the key fields
@@ -241,7 +254,8 @@ namespace mongo {
         } else {
             scoped_ptr<MySorter> sorter (MySorter::make(makeSortOptions(), Comparator(*this)));
             while (boost::optional<Document> next = pSource->getNext()) {
-                sorter->add(extractKey(*next), *next);
+                // Buffered documents outlive their batch, so copy them out of any arena.
+                sorter->add(extractKey(*next).getOwned(), next->getOwned());
             }
             _output.reset(sorter->done());
         }
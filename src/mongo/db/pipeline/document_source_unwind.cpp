@@ -127,7 +127,7 @@ namespace mongo {
     boost::optional<Document> DocumentSourceUnwind::getNext() {
         pExpCtx->checkForInterrupt();
 
-        boost::optional<Document> out = _unwinder->getNext();
+        boost::optional<Document> out = unwindNext();
         while (!out) {
             // No more elements in array currently being unwound. This will loop if the input
             // document is missing the unwind field or has an empty array.
@@ -137,12 +137,18 @@ namespace mongo {
 
             // Try to extract an output document from the new input document.
             _unwinder->resetDocument(*input);
-            out = _unwinder->getNext();
+            out = unwindNext();
         }
 
         return out;
     }
 
+    boost::optional<Document> DocumentSourceUnwind::unwindNext() {
+        // Only the documents we build go to the arena, not those of the stage feeding us.
+        BumpArena::Scope arenaScope(&pExpCtx->arena);
+        return _unwinder->getNext();
+    }
+
     Value DocumentSourceUnwind::serialize(bool explain) const {
         verify(_unwindPath);
         return Value(DOC(getSourceName() << _unwindPath->getPath(true)));
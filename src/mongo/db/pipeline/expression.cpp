@@ -688,6 +688,274 @@ namespace {
         return cmpLookup[cmpOp].name;
     }
 
+    /* ------------------- ExpressionCompiledArithmetic ----------------------- */
+
+    ExpressionCompiledArithmetic::ExpressionCompiledArithmetic(
+            const intrusive_ptr<Expression>& tree)
+        : _tree(tree) {
+    }
+
+    bool ExpressionCompiledArithmetic::isArithmetic(const Expression* expression) {
+        return dynamic_cast<const ExpressionAdd*>(expression)
+            || dynamic_cast<const ExpressionSubtract*>(expression)
+            || dynamic_cast<const ExpressionMultiply*>(expression)
+            || dynamic_cast<const ExpressionDivide*>(expression)
+            || dynamic_cast<const ExpressionMod*>(expression);
+    }
+
+    intrusive_ptr<Expression> ExpressionCompiledArithmetic::compile(
+            const intrusive_ptr<Expression>& tree) {
+        intrusive_ptr<ExpressionCompiledArithmetic> compiled(
+            new ExpressionCompiledArithmetic(tree));
+        if (!compiled->compileNode(tree, 0))
+            return tree;
+
+        return compiled;
+    }
+
+    intrusive_ptr<Expression> ExpressionCompiledArithmetic::decompile(
+            const intrusive_ptr<Expression>& expression) {
+        if (ExpressionCompiledArithmetic* compiled =
+                dynamic_cast<ExpressionCompiledArithmetic*>(expression.get())) {
+            return compiled->_tree;
+        }
+
+        return expression;
+    }
+
+    bool ExpressionCompiledArithmetic::compileNode(const intrusive_ptr<Expression>& expression,
+                                                   size_t dest) {
+        if (dest >= kMaxRegisters)
+            return false;
+
+        Instruction instruction;
+        instruction.dest = dest;
+        instruction.operand = 0;
+        instruction.count = 0;
+
+        const ExpressionNary* nary = dynamic_cast<const ExpressionNary*>(expression.get());
+        if (!nary || !isArithmetic(nary)) {
+            if (const ExpressionConstant* constant =
+                    dynamic_cast<const ExpressionConstant*>(expression.get())) {
+                // A constant that isn't a number would make every run give up.
+                Number number;
+                if (!Number::unbox(constant->getValue(), &number))
+                    return false;
+
+                instruction.op = CONSTANT;
+                instruction.operand = _constants.size();
+                _constants.push_back(number);
+            }
+            else {
+                instruction.op = LOAD;
+                instruction.operand = _leaves.size();
+                _leaves.push_back(expression);
+            }
+
+            _program.push_back(instruction);
+            return true;
+        }
+
+        // Operands go in consecutive registers, the first one being 'dest' itself.
+        const ExpressionVector& operands = nary->vpOperand;
+        if (dest + operands.size() > kMaxRegisters)
+            return false;
+        if (!nary->isAssociativeAndCommutative() && operands.size() != 2)
+            return false; // $subtract, $divide and $mod take exactly two
+
+        for (size_t i = 0; i < operands.size(); ++i) {
+            if (!compileNode(operands[i], dest + i))
+                return false;
+        }
+
+        if (dynamic_cast<const ExpressionAdd*>(nary))
+            instruction.op = ADD;
+        else if (dynamic_cast<const ExpressionSubtract*>(nary))
+            instruction.op = SUBTRACT;
+        else if (dynamic_cast<const ExpressionMultiply*>(nary))
+            instruction.op = MULTIPLY;
+        else if (dynamic_cast<const ExpressionDivide*>(nary))
+            instruction.op = DIVIDE;
+        else
+            instruction.op = MOD;
+
+        instruction.operand = dest;
+        instruction.count = operands.size();
+        _program.push_back(instruction);
+        return true;
+    }
+
+    bool ExpressionCompiledArithmetic::Number::unbox(const Value& value, Number* out) {
+        switch (value.getType()) {
+        case NumberInt:
+            out->type = NumberInt;
+            out->longValue = value.getInt();
+            return true;
+
+        case NumberLong:
+            out->type = NumberLong;
+            out->longValue = value.getLong();
+            return true;
+
+        case NumberDouble:
+            out->type = NumberDouble;
+            out->doubleValue = value.getDouble();
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    Value ExpressionCompiledArithmetic::Number::box() const {
+        switch (type) {
+        case NumberInt: return Value(static_cast<int>(longValue));
+        case NumberLong: return Value(longValue);
+        default: return Value(doubleValue);
+        }
+    }
+
+    int ExpressionCompiledArithmetic::Number::coerceToInt() const {
+        return type == NumberDouble ? static_cast<int>(doubleValue)
+                                    : static_cast<int>(longValue);
+    }
+
+    long long ExpressionCompiledArithmetic::Number::coerceToLong() const {
+        return type == NumberDouble ? static_cast<long long>(doubleValue) : longValue;
+    }
+
+    double ExpressionCompiledArithmetic::Number::coerceToDouble() const {
+        return type == NumberDouble ? doubleValue : static_cast<double>(longValue);
+    }
+
+    void ExpressionCompiledArithmetic::Number::setLong(long long value) {
+        type = NumberLong;
+        longValue = value;
+    }
+
+    void ExpressionCompiledArithmetic::Number::setDouble(double value) {
+        type = NumberDouble;
+        doubleValue = value;
+    }
+
+    void ExpressionCompiledArithmetic::Number::setIntOrLong(long long value) {
+        type = static_cast<int>(value) == value ? NumberInt : NumberLong;
+        longValue = value;
+    }
+
+    bool ExpressionCompiledArithmetic::run(Variables* vars, Number* result) const {
+        Number registers[kMaxRegisters];
+
+        for (size_t pc = 0; pc < _program.size(); ++pc) {
+            const Instruction& instruction = _program[pc];
+            Number* const out = &registers[instruction.dest];
+            const Number* const in = &registers[instruction.operand];
+            const size_t n = instruction.count;
+
+            switch (instruction.op) {
+            case LOAD:
+                if (!Number::unbox(_leaves[instruction.operand]->evaluateInternal(vars), out))
+                    return false;
+                break;
+
+            case CONSTANT:
+                *out = _constants[instruction.operand];
+                break;
+
+            case ADD:
+            case MULTIPLY: {
+                // As ExpressionAdd and ExpressionMultiply, which track the integral and double
+                // results in parallel.
+                const bool add = instruction.op == ADD;
+                double doubleTotal = add ? 0 : 1;
+                long long longTotal = add ? 0 : 1;
+                BSONType totalType = NumberInt;
+                for (size_t i = 0; i < n; ++i) {
+                    totalType = Value::getWidestNumeric(totalType, in[i].type);
+                    if (add) {
+                        doubleTotal += in[i].coerceToDouble();
+                        longTotal += in[i].coerceToLong();
+                    }
+                    else {
+                        doubleTotal *= in[i].coerceToDouble();
+                        longTotal *= in[i].coerceToLong();
+                    }
+                }
+
+                if (totalType == NumberDouble)
+                    out->setDouble(doubleTotal);
+                else if (totalType == NumberLong)
+                    out->setLong(longTotal);
+                else
+                    out->setIntOrLong(longTotal);
+                break;
+            }
+
+            case SUBTRACT: {
+                const BSONType diffType = Value::getWidestNumeric(in[1].type, in[0].type);
+                if (diffType == NumberDouble)
+                    out->setDouble(in[0].coerceToDouble() - in[1].coerceToDouble());
+                else if (diffType == NumberLong)
+                    out->setLong(in[0].coerceToLong() - in[1].coerceToLong());
+                else
+                    out->setIntOrLong(in[0].coerceToLong() - in[1].coerceToLong());
+                break;
+            }
+
+            case DIVIDE: {
+                const double denom = in[1].coerceToDouble();
+                uassert(16608, "can't $divide by zero",
+                        denom != 0);
+                out->setDouble(in[0].coerceToDouble() / denom);
+                break;
+            }
+
+            case MOD: {
+                // As ExpressionMod.
+                const Number lhs = in[0];
+                const Number rhs = in[1];
+                const double right = rhs.coerceToDouble();
+                uassert(16610, "can't $mod by 0",
+                        right != 0);
+
+                if (lhs.type == NumberDouble
+                    || (rhs.type == NumberDouble && rhs.coerceToInt() != right)) {
+                    out->setDouble(fmod(lhs.coerceToDouble(), right));
+                }
+                else if (lhs.type == NumberLong || rhs.type == NumberLong) {
+                    out->setLong(lhs.coerceToLong() % rhs.coerceToLong());
+                }
+                else {
+                    out->type = NumberInt;
+                    out->longValue = lhs.coerceToInt() % rhs.coerceToInt();
+                }
+                break;
+            }
+            }
+        }
+
+        *result = registers[0];
+        return true;
+    }
+
+    Value ExpressionCompiledArithmetic::evaluateInternal(Variables* vars) const {
+        Number result;
+        if (run(vars, &result))
+            return result.box();
+
+        // Some operand wasn't a number: let the tree sort out nulls, dates and errors.
+        return _tree->evaluateInternal(vars);
+    }
+
+    void ExpressionCompiledArithmetic::addDependencies(DepsTracker* deps,
+                                                       vector<string>* path) const {
+        _tree->addDependencies(deps, path);
+    }
+
+    Value ExpressionCompiledArithmetic::serialize(bool explain) const {
+        return _tree->serialize(explain);
+    }
+
     /* ------------------------- ExpressionConcat ----------------------------- */
 
     Value ExpressionConcat::evaluateInternal(Variables* vars) const {
@@ -1893,10 +2161,16 @@ namespace {
     intrusive_ptr<Expression> ExpressionNary::optimize() {
         const size_t n = vpOperand.size();
 
+        // Arithmetic is compiled from the root of the tree down, so operands compiled on their
+        // own are taken apart again; see ExpressionCompiledArithmetic.
+        const bool arithmetic = ExpressionCompiledArithmetic::isArithmetic(this);
+
         // optimize sub-expressions and count constants
         unsigned constCount = 0;
         for(size_t i = 0; i < n; ++i) {
             intrusive_ptr<Expression> optimized = vpOperand[i]->optimize();
+            if (arithmetic)
+                optimized = ExpressionCompiledArithmetic::decompile(optimized);
 
             // substitute the optimized expression
             vpOperand[i] = optimized;
@@ -1919,7 +2193,7 @@ namespace {
 
         // Remaining optimizations are only for associative and commutative expressions.
         if (!isAssociativeAndCommutative())
-            return this;
+            return arithmetic ? ExpressionCompiledArithmetic::compile(this) : this;
 
         // Process vpOperand to split it into constant and nonconstant vectors.
         // This can leave vpOperand in an invalid state that is cleaned up after the loop.
@@ -1963,7 +2237,7 @@ namespace {
             vpOperand.push_back(ExpressionConstant::create(constValue));
         }
 
-        return this;
+        return arithmetic ? ExpressionCompiledArithmetic::compile(this) : this;
     }
 
     void ExpressionNary::addDependencies(DepsTracker* deps, vector<string>* path) const {
@@ -330,6 +330,9 @@ namespace mongo {
         ExpressionNary() {}
 
         ExpressionVector vpOperand;
+
+    private:
+        friend class ExpressionCompiledArithmetic;
     };
 
     /// Inherit from ExpressionVariadic or ExpressionFixedArity instead of directly from this class.
@@ -451,6 +454,98 @@ namespace mongo {
     };
 
 
+    /**
+     * A tree of $add, $subtract, $multiply, $divide and $mod lowered to a register program that
+     * computes on unboxed numbers, rather than boxing every intermediate result in a Value.
+     *
+     * Operands that aren't arithmetic, such as field paths or other operators, are evaluated as
+     * usual and unboxed as they are loaded. As soon as one isn't a number, the program gives up
+     * and the original tree is evaluated instead, so dates, nulls and type errors behave as
+     * they always have. ExpressionNary::optimize() compiles arithmetic trees; the tree is kept
+     * for serialization and dependency tracking.
+     */
+    class ExpressionCompiledArithmetic : public Expression {
+    public:
+        // virtuals from Expression
+        virtual boost::intrusive_ptr<Expression> optimize() { return this; }
+        virtual void addDependencies(DepsTracker* deps, std::vector<std::string>* path=NULL) const;
+        virtual Value evaluateInternal(Variables* vars) const;
+        virtual Value serialize(bool explain) const;
+
+        /// Returns true if 'expression' is one of the operators that can be compiled.
+        static bool isArithmetic(const Expression* expression);
+
+        /**
+         * Compiles the arithmetic tree rooted at 'tree'. Returns 'tree' itself if there is
+         * nothing to gain, such as when a constant operand isn't a number.
+         */
+        static boost::intrusive_ptr<Expression> compile(
+            const boost::intrusive_ptr<Expression>& tree);
+
+        /// Returns the tree 'expression' was compiled from, or 'expression' if it wasn't.
+        static boost::intrusive_ptr<Expression> decompile(
+            const boost::intrusive_ptr<Expression>& expression);
+
+    private:
+        enum OpCode {
+            LOAD,       // registers[dest] = unboxed leaves[operand]
+            CONSTANT,   // registers[dest] = constants[operand]
+            ADD,        // registers[dest] = $add of registers[operand, operand + count)
+            SUBTRACT,   // and so on, with the semantics of the Expression of the same name
+            MULTIPLY,
+            DIVIDE,
+            MOD,
+        };
+
+        struct Instruction {
+            OpCode op;
+            unsigned short dest;
+            unsigned short operand;
+            unsigned short count;
+        };
+
+        /**
+         * An unboxed NumberInt, NumberLong or NumberDouble. Ints are kept in longValue, and the
+         * coerceTo*() functions convert exactly as Value's do.
+         */
+        struct Number {
+            BSONType type;
+            long long longValue;
+            double doubleValue;
+
+            static bool unbox(const Value& value, Number* out);
+            Value box() const;
+
+            void setLong(long long value);
+            void setDouble(double value);
+            /// Narrows to NumberInt if 'value' fits, as Value::createIntOrLong().
+            void setIntOrLong(long long value);
+
+            int coerceToInt() const;
+            long long coerceToLong() const;
+            double coerceToDouble() const;
+        };
+
+        static const size_t kMaxRegisters = 64;
+
+        explicit ExpressionCompiledArithmetic(const boost::intrusive_ptr<Expression>& tree);
+
+        /**
+         * Emits the code leaving the value of 'expression' in register 'dest', using higher
+         * numbered registers for its operands. Returns false if the program can't be built.
+         */
+        bool compileNode(const boost::intrusive_ptr<Expression>& expression, size_t dest);
+
+        /// Runs the program. Returns false if an operand wasn't a number.
+        bool run(Variables* vars, Number* result) const;
+
+        boost::intrusive_ptr<Expression> _tree;
+        std::vector<Instruction> _program;
+        ExpressionVector _leaves;
+        std::vector<Number> _constants;
+    };
+
+
     class ExpressionConcat : public ExpressionVariadic<ExpressionConcat> {
     public:
         // virtuals from ExpressionNary
@@ -32,6 +32,7 @@
 
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/util/bump_arena.h"
 #include "mongo/util/intrusive_counter.h"
 
 namespace mongo {
@@ -65,6 +66,11 @@ namespace mongo {
         std::string tempDir; // Defaults to empty to prevent external sorting in mongos.
 
         OperationContext* opCtx;
+
+        // Stages building a new document per input, like $project and $unwind, allocate it here.
+        // Stages keeping documents across calls to getNext() must copy them out with getOwned().
+        BumpArena arena;
+
         static const int interruptCheckPeriod = 128;
         int interruptCounter; // when 0, check interruptStatus
     };
@@ -78,6 +78,8 @@ namespace mongo {
          DocumentSourceGroup::createFromBson},
         {DocumentSourceLimit::limitName,
          DocumentSourceLimit::createFromBson},
+        {DocumentSourceLookUp::lookupName,
+         DocumentSourceLookUp::createFromBson},
         {DocumentSourceMatch::matchName,
          DocumentSourceMatch::createFromBson},
         {DocumentSourceMergeCursors::name,
@@ -129,6 +131,15 @@ namespace mongo {
                 continue;
             }
 
+            // the result cache is also handled externally.
+            if (str::equals(pFieldName, "cacheResults")) {
+                uassert(28639,
+                        str::stream() << "cacheResults must be a bool, not a "
+                                      << typeName(cmdElement.type()),
+                        cmdElement.type() == Bool);
+                continue;
+            }
+
             /* look for the aggregation command */
             if (!strcmp(pFieldName, commandName)) {
                 continue;
@@ -350,6 +361,16 @@ namespace mongo {
                 actions.addAction(ActionType::insert);
                 out->push_back(Privilege(ResourcePattern::forExactNamespace(outputNs), actions));
             }
+            else if (str::equals(stage.firstElementFieldName(), "$lookup")) {
+                BSONObj spec = stage.firstElement().embeddedObjectUserCheck();
+                NamespaceString fromNs(db, spec["from"].str());
+                uassert(28612,
+                        mongoutils::str::stream() << "Invalid $lookup namespace, " << fromNs.ns(),
+                        fromNs.isValid());
+
+                out->push_back(Privilege(ResourcePattern::forExactNamespace(fromNs),
+                                         ActionType::find));
+            }
         }
     }
 
@@ -538,12 +559,28 @@ namespace mongo {
         if (explain)
             return false;
 
-        if (!sources.empty() && dynamic_cast<DocumentSourceNeedsMongod*>(sources.back().get()))
-            return false;
+        for (size_t i = 0; i < sources.size(); i++) {
+            if (dynamic_cast<DocumentSourceNeedsMongod*>(sources[i].get()))
+                return false;
+        }
 
         return true;
     }
 
+    bool Pipeline::needsPrimaryShardMerger() const {
+        // $out writes and $lookup reads an unsharded collection, which lives on the primary.
+        return touchesOtherCollections();
+    }
+
+    bool Pipeline::touchesOtherCollections() const {
+        for (size_t i = 0; i < sources.size(); i++) {
+            if (dynamic_cast<DocumentSourceNeedsMongod*>(sources[i].get()))
+                return true;
+        }
+
+        return false;
+    }
+
     DepsTracker Pipeline::getDependencies(const BSONObj& initialQuery) const {
         DepsTracker deps;
         bool knowAllFields = false;
@@ -123,6 +123,19 @@ namespace mongo {
         /// Returns true if this pipeline only uses features that work in mongos.
         bool canRunInMongos() const;
 
+        /**
+         * Returns true if this pipeline, as the merging half of a split pipeline, has to run on the
+         * database's primary shard because it reads or writes unsharded collections. Otherwise
+         * any shard can merge.
+         */
+        bool needsPrimaryShardMerger() const;
+
+        /**
+         * Returns true if this pipeline reads or writes collections other than its input, as
+         * $lookup and $out do.
+         */
+        bool touchesOtherCollections() const;
+
         /**
          * Write the pipeline's operators to a std::vector<Value>, with the
          * explain flag true (for DocumentSource::serializeToArray()).
@@ -30,9 +30,12 @@
 
 #include "mongo/db/pipeline/pipeline_d.h"
 
+#include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
@@ -41,6 +44,7 @@
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/d_state.h"
 
 namespace mongo {
@@ -48,6 +52,10 @@ namespace mongo {
     using boost::intrusive_ptr;
     using boost::shared_ptr;
 
+    // Number of threads used to compute partial results for a $group at the start of a pipeline
+    // over a whole collection. 0 disables parallel partial aggregation.
+    MONGO_EXPORT_SERVER_PARAMETER(aggregationParallelGroupThreads, int, 0);
+
 namespace {
     class MongodImplementation : public DocumentSourceNeedsMongod::MongodInterface {
     public:
@@ -78,6 +86,151 @@ namespace {
         intrusive_ptr<ExpressionContext> _ctx;
         DBDirectClient _client;
     };
+
+    /**
+     * Returns every document from a set of RecordIterators, one iterator after another.
+     */
+    class RecordIteratorSource : public DocumentSource {
+    public:
+        RecordIteratorSource(const intrusive_ptr<ExpressionContext>& ctx,
+                             const boost::optional<ParsedDeps>& dependencies)
+            : DocumentSource(ctx)
+            , _dependencies(dependencies)
+            , _current(0)
+        {}
+
+        void addIterator(RecordIterator* iterator) {
+            _iterators.mutableVector().push_back(iterator);
+        }
+
+        virtual boost::optional<Document> getNext() {
+            for ( ; _current < _iterators.size(); _current++) {
+                RecordIterator* iterator = _iterators[_current];
+                if (iterator->isEOF())
+                    continue;
+
+                const BSONObj obj = iterator->dataFor(iterator->getNext()).releaseToBson();
+                if (_dependencies)
+                    return _dependencies->extractFields(obj);
+                return Document(obj);
+            }
+            return boost::none;
+        }
+
+        virtual void dispose() {
+            _iterators.clear();
+            _current = 0;
+        }
+
+        virtual Value serialize(bool explain = false) const { return Value(); }
+        virtual bool isValidInitialSource() const { return true; }
+
+    private:
+        const boost::optional<ParsedDeps> _dependencies;
+        OwnedPointerVector<RecordIterator> _iterators;
+        size_t _current;
+    };
+
+    /**
+     * A $group computing partial results over its own share of a collection on its own thread.
+     * Each one has its own ExpressionContext and parsed expressions since their reference counts
+     * are not thread safe.
+     */
+    struct PartialGroup {
+        PartialGroup() : errorCode(0) {}
+
+        void run() {
+            try {
+                // The group consumes all of its input before returning anything.
+                first = group->getNext();
+            }
+            catch (const DBException& e) {
+                errorCode = e.getCode();
+                errorMessage = e.what();
+            }
+            catch (const std::exception& e) {
+                errorCode = ErrorCodes::InternalError;
+                errorMessage = e.what();
+            }
+        }
+
+        intrusive_ptr<RecordIteratorSource> input;
+        intrusive_ptr<DocumentSourceGroup> group;
+        boost::optional<Document> first; // first output of group, if any
+        int errorCode; // 0 if run() succeeded
+        std::string errorMessage;
+    };
+
+    /**
+     * Returns the output of each PartialGroup in turn, for use as input to a merging $group.
+     */
+    class PartialGroupResults : public DocumentSource {
+    public:
+        PartialGroupResults(const intrusive_ptr<ExpressionContext>& ctx,
+                            const std::vector<shared_ptr<PartialGroup> >& partials)
+            : DocumentSource(ctx)
+            , _partials(partials)
+            , _current(0)
+        {}
+
+        virtual boost::optional<Document> getNext() {
+            pExpCtx->checkForInterrupt();
+
+            for ( ; _current < _partials.size(); _current++) {
+                PartialGroup& partial = *_partials[_current];
+                if (partial.first) {
+                    boost::optional<Document> out = partial.first;
+                    partial.first = boost::none;
+                    return out;
+                }
+
+                if (boost::optional<Document> out = partial.group->getNext())
+                    return out;
+            }
+            return boost::none;
+        }
+
+        virtual void dispose() {
+            for (size_t i = 0; i < _partials.size(); i++) {
+                _partials[i]->group->dispose();
+            }
+            _partials.clear();
+        }
+
+        virtual Value serialize(bool explain = false) const { return Value(); }
+        virtual bool isValidInitialSource() const { return true; }
+
+    private:
+        std::vector<shared_ptr<PartialGroup> > _partials;
+        size_t _current;
+    };
+
+    /**
+     * Tries to create a PlanExecutor for the given query, sort and projection, returning the
+     * reason it can't rather than throwing so that the caller can fall back to a simpler one.
+     */
+    Status attemptToGetExecutor(OperationContext* txn,
+                                Collection* collection,
+                                const intrusive_ptr<ExpressionContext>& pExpCtx,
+                                const BSONObj& queryObj,
+                                const BSONObj& projectionObj,
+                                const BSONObj& sortObj,
+                                size_t plannerOpts,
+                                PlanExecutor** execOut) {
+        const WhereCallbackReal whereCallback(pExpCtx->opCtx, pExpCtx->ns.db());
+
+        CanonicalQuery* cq;
+        Status status = CanonicalQuery::canonicalize(pExpCtx->ns,
+                                                     queryObj,
+                                                     sortObj,
+                                                     projectionObj,
+                                                     &cq,
+                                                     whereCallback);
+        if (!status.isOK())
+            return status;
+
+        return getExecutor(txn, collection, cq, PlanExecutor::YIELD_AUTO, execOut, plannerOpts);
+    }
 }
 
     shared_ptr<PlanExecutor> PipelineD::prepareCursorSource(
@@ -112,6 +265,9 @@ namespace {
             return boost::shared_ptr<PlanExecutor>(); // don't need a cursor
         }
 
+        if (prepareParallelGroup(txn, collection, pPipeline, pExpCtx)) {
+            return boost::shared_ptr<PlanExecutor>(); // the partial groups already did the scan
+        }
 
         // Look for an initial match. This works whether we got an initial query or not.
         // If not, it results in a "{}" query, which will be what we want in that case.
@@ -126,10 +282,18 @@ namespace {
         const DepsTracker deps = pPipeline->getDependencies(queryObj);
 
         // Passing query an empty projection since it is faster to use ParsedDeps::extractFields().
-        // This will need to change to support covering indexes (SERVER-12015). There is an
-        // exception for textScore since that can only be retrieved by a query projection.
+        // There is an exception for textScore since that can only be retrieved by a query
+        // projection.
         const BSONObj projectionForQuery = deps.needTextScore ? deps.toProjection() : BSONObj();
 
+        // The other exception is a projection which an index covers, since then the documents
+        // don't have to be fetched at all. We only pass the projection along if the query system
+        // finds a covered plan for it, and fall back to projectionForQuery otherwise.
+        const bool tryCoveredProjection = !deps.needWholeDocument
+                                       && !deps.needTextScore
+                                       && !deps.fields.empty();
+        const BSONObj coveredProjection = tryCoveredProjection ? deps.toProjection() : BSONObj();
+
         /*
           Look for an initial sort; we'll try to add this to the
           Cursor we create.  If we're successful in doing that (further down),
@@ -154,7 +318,8 @@ namespace {
         // we don't get a PlanExecutor back.
         //
         // So we try to use both first.  If that fails, try again, without the
-        // sort.
+        // sort.  Each of these is first tried with coveredProjection, if we have
+        // one, then with projectionForQuery.
         //
         // If we don't have a sort, jump straight to just creating a PlanExecutor.
         // without the sort.
@@ -169,28 +334,29 @@ namespace {
                                    | QueryPlannerParams::INCLUDE_SHARD_FILTER
                                    | QueryPlannerParams::NO_BLOCKING_SORT
                                    ;
+        const size_t coveredRunnerOptions = runnerOptions
+                                          | QueryPlannerParams::NO_UNCOVERED_PROJECTIONS;
         boost::shared_ptr<PlanExecutor> exec;
         bool sortInRunner = false;
 
-        const WhereCallbackReal whereCallback(pExpCtx->opCtx, pExpCtx->ns.db());
-
         if (sortStage) {
-            CanonicalQuery* cq;
-            Status status =
-                CanonicalQuery::canonicalize(pExpCtx->ns,
-                                             queryObj,
-                                             sortObj,
-                                             projectionForQuery,
-                                             &cq,
-                                             whereCallback);
-
             PlanExecutor* rawExec;
-            if (status.isOK() && getExecutor(txn,
-                                             collection,
-                                             cq,
-                                             PlanExecutor::YIELD_AUTO,
-                                             &rawExec,
-                                             runnerOptions).isOK()) {
+            if ((tryCoveredProjection && attemptToGetExecutor(txn,
+                                                              collection,
+                                                              pExpCtx,
+                                                              queryObj,
+                                                              coveredProjection,
+                                                              sortObj,
+                                                              coveredRunnerOptions,
+                                                              &rawExec).isOK())
+                || attemptToGetExecutor(txn,
+                                        collection,
+                                        pExpCtx,
+                                        queryObj,
+                                        projectionForQuery,
+                                        sortObj,
+                                        runnerOptions,
+                                        &rawExec).isOK()) {
                 // success: The PlanExecutor will handle sorting for us using an index.
                 exec.reset(rawExec);
                 sortInRunner = true;
@@ -203,24 +369,51 @@ namespace {
             }
         }
 
+        // Without a $sort to push down, a leading $group can still stream its input if an index
+        // covering the query returns it in group key order. Only covered plans are tried so this
+        // never trades a collection scan for fetching every document through an index.
+        intrusive_ptr<DocumentSourceGroup> groupStage;
+        if (!exec.get() && tryCoveredProjection && !sources.empty()) {
+            groupStage = dynamic_cast<DocumentSourceGroup*>(sources.front().get());
+        }
+
+        if (groupStage) {
+            const BSONObj groupSort = groupStage->getKeyPattern();
+            PlanExecutor* rawExec;
+            if (!groupSort.isEmpty() && attemptToGetExecutor(txn,
+                                                             collection,
+                                                             pExpCtx,
+                                                             queryObj,
+                                                             coveredProjection,
+                                                             groupSort,
+                                                             coveredRunnerOptions,
+                                                             &rawExec).isOK()) {
+                exec.reset(rawExec);
+                sortObj = groupSort;
+                sortInRunner = true;
+            }
+        }
+
         if (!exec.get()) {
             const BSONObj noSort;
-            CanonicalQuery* cq;
-            uassertStatusOK(
-                CanonicalQuery::canonicalize(pExpCtx->ns,
-                                             queryObj,
-                                             noSort,
-                                             projectionForQuery,
-                                             &cq,
-                                             whereCallback));
-
             PlanExecutor* rawExec;
-            uassertStatusOK(getExecutor(txn,
-                                        collection,
-                                        cq,
-                                        PlanExecutor::YIELD_AUTO,
-                                        &rawExec,
-                                        runnerOptions));
+            if (!tryCoveredProjection || !attemptToGetExecutor(txn,
+                                                               collection,
+                                                               pExpCtx,
+                                                               queryObj,
+                                                               coveredProjection,
+                                                               noSort,
+                                                               coveredRunnerOptions,
+                                                               &rawExec).isOK()) {
+                uassertStatusOK(attemptToGetExecutor(txn,
+                                                     collection,
+                                                     pExpCtx,
+                                                     queryObj,
+                                                     projectionForQuery,
+                                                     noSort,
+                                                     runnerOptions,
+                                                     &rawExec));
+            }
             exec.reset(rawExec);
         }
 
@@ -250,4 +443,79 @@ namespace {
         return exec;
     }
 
+    bool PipelineD::prepareParallelGroup(OperationContext* txn,
+                                         Collection* collection,
+                                         const intrusive_ptr<Pipeline>& pPipeline,
+                                         const intrusive_ptr<ExpressionContext>& pExpCtx) {
+        // The partial groups run to completion here, while the caller holds the collection lock,
+        // since the iterators can't be used after it is released.
+        const int maxThreads = aggregationParallelGroupThreads;
+        if (maxThreads <= 0 || !collection || pPipeline->isExplain())
+            return false;
+
+        Pipeline::SourceContainer& sources = pPipeline->sources;
+        if (sources.empty())
+            return false;
+
+        intrusive_ptr<DocumentSourceGroup> group =
+            dynamic_cast<DocumentSourceGroup*>(sources.front().get());
+        if (!group)
+            return false;
+
+        // Orphaned documents would need a shard filter, which the raw iterators don't apply.
+        if (shardingState.needCollectionMetadata(pExpCtx->ns.ns()))
+            return false;
+
+        OwnedPointerVector<RecordIterator> iterators(collection->getManyIterators(txn));
+        if (iterators.size() <= 1)
+            return false;
+
+        const size_t numThreads = std::min(iterators.size(), size_t(maxThreads));
+        const BSONObj groupSpec = BSON("$group" << group->serialize().getDocument().toBson());
+        const DepsTracker deps = pPipeline->getDependencies(BSONObj());
+
+        std::vector<shared_ptr<PartialGroup> > partials;
+        for (size_t i = 0; i < numThreads; i++) {
+            intrusive_ptr<ExpressionContext> ctx = new ExpressionContext(NULL, pExpCtx->ns);
+            ctx->inShard = true; // the partial groups produce output for a merging group
+            ctx->extSortAllowed = pExpCtx->extSortAllowed;
+            ctx->tempDir = pExpCtx->tempDir;
+
+            shared_ptr<PartialGroup> partial = boost::make_shared<PartialGroup>();
+            partial->input = new RecordIteratorSource(ctx, deps.toParsedDeps());
+            partial->group = static_cast<DocumentSourceGroup*>(
+                DocumentSourceGroup::createFromBson(groupSpec.firstElement(), ctx).get());
+            partial->group->setSource(partial->input.get());
+            partials.push_back(partial);
+        }
+
+        // Hand the iterators out round-robin so each thread gets a similar share.
+        std::vector<RecordIterator*>& rawIterators = iterators.mutableVector();
+        for (size_t i = 0; i < rawIterators.size(); i++) {
+            partials[i % numThreads]->input->addIterator(rawIterators[i]);
+            rawIterators[i] = NULL;
+        }
+        rawIterators.clear();
+
+        {
+            boost::thread_group threads;
+            for (size_t i = 1; i < numThreads; i++) {
+                threads.create_thread(boost::bind(&PartialGroup::run, partials[i].get()));
+            }
+            partials[0]->run();
+            threads.join_all();
+        }
+
+        for (size_t i = 0; i < numThreads; i++) {
+            // The iterators must be released while the collection lock is still held.
+            partials[i]->input->dispose();
+            if (partials[i]->errorCode)
+                uasserted(partials[i]->errorCode, partials[i]->errorMessage);
+        }
+
+        sources.front() = group->getMergeSource();
+        pPipeline->addInitialSource(new PartialGroupResults(pExpCtx, partials));
+        return true;
+    }
+
 } // namespace mongo
@@ -80,6 +80,18 @@ namespace mongo {
 
     private:
         PipelineD(); // does not exist:  prevent instantiation
+
+        /**
+         * If the pipeline starts with a $group over the whole collection and parallel partial
+         * aggregation is enabled, computes partial results for that $group on several threads
+         * and replaces it with a merging $group over those results.
+         *
+         * Returns false if the pipeline was left unchanged.
+         */
+        static bool prepareParallelGroup(OperationContext* txn,
+                                         Collection* collection,
+                                         const boost::intrusive_ptr<Pipeline>& pPipeline,
+                                         const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
     };
 
 } // namespace mongo
@@ -38,6 +38,7 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/document.h"
+#include "mongo/util/bump_arena.h"
 #include "mongo/util/hex.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -934,6 +935,68 @@ namespace mongo {
         verify(false);
     }
 
+    bool Value::isInArena() const {
+        switch (getType()) {
+        case String:
+        case Symbol:
+        case Code:
+        case BinData:
+        case RegEx:
+            // Short strings are stored inline.
+            return _storage.refCounter
+                && static_cast<const RCString*>(_storage.genericRCPtr)->isInArena();
+
+        case Object:
+            return getDocument().isInArena();
+
+        case Array: {
+            const vector<Value>& array = getArray();
+            for (size_t i = 0; i < array.size(); i++) {
+                if (array[i].isInArena())
+                    return true;
+            }
+            return false;
+        }
+
+        default:
+            // Everything else is either inline or allocated on the heap.
+            return false;
+        }
+    }
+
+    Value Value::getOwned() const {
+        if (!isInArena())
+            return *this;
+
+        BumpArena::Scope heapScope(NULL);
+        switch (getType()) {
+        case String:    return Value(getStringData());
+        case Symbol:    return Value(BSONSymbol(getStringData()));
+        case Code:      return Value(BSONCode(getStringData()));
+        case RegEx:     return Value(BSONRegEx(getRegex(), getRegexFlags()));
+        case BinData:
+            return Value(BSONBinData(getStringData().rawData(),
+                                     getStringData().size(),
+                                     _storage.binDataType()));
+
+        case Object:
+            return Value(getDocument().getOwned());
+
+        case Array: {
+            const vector<Value>& array = getArray();
+            vector<Value> owned;
+            owned.reserve(array.size());
+            for (size_t i = 0; i < array.size(); i++) {
+                owned.push_back(array[i].getOwned());
+            }
+            return Value(owned);
+        }
+
+        default:
+            verify(false);
+        }
+    }
+
     void Value::serializeForSorter(BufBuilder& buf) const {
         buf.appendChar(getType());
         switch(getType()) {
@@ -155,6 +155,7 @@ namespace mongo {
         const char* getRegexFlags() const;
         std::string getSymbol() const;
         std::string getCode() const;
+        BSONBinData getBinData() const; // points into this Value
         int getInt() const;
         long long getLong() const;
         const std::vector<Value>& getArray() const { return _storage.getArray(); }
@@ -257,7 +258,12 @@ namespace mongo {
         void serializeForSorter(BufBuilder& buf) const;
         static Value deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&);
         int memUsageForSorter() const { return getApproximateSize(); }
-        Value getOwned() const { return *this; }
+
+        /// Like Document::getOwned(): deep-copies this Value if any part lives in a BumpArena.
+        Value getOwned() const;
+
+        /// True if this value or anything it holds lives in a BumpArena.
+        bool isInArena() const;
 
     private:
         /** This is a "honeypot" to prevent unexpected implicit conversions to the accepted argument
@@ -311,6 +317,12 @@ namespace mongo {
         return _storage.getString().toString();
     }
 
+    inline BSONBinData Value::getBinData() const {
+        verify(getType() == BinData);
+        StringData data = _storage.getString();
+        return BSONBinData(data.rawData(), data.size(), _storage.binDataType());
+    }
+
     inline OID Value::getOid() const {
         verify(getType() == jstOID);
         return OID(_storage.oid);
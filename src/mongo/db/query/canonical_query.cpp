@@ -30,9 +30,17 @@
 
 #include "mongo/db/query/canonical_query.h"
 
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <set>
+
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/matcher/expression_tree.h"
+#include "mongo/db/query/lru_key_value.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/util/log.h"
 
@@ -314,6 +322,135 @@ namespace {
         }
     }
 
+    /**
+     * What's needed to build the CanonicalQuery of a filter made only of equalities on top-level
+     * fields without running it through the parser: where each equality ends up after
+     * sortTree(), and the cache key. Both depend only on the field names, the sort and the
+     * projection, which make up the signature the template is looked up by.
+     */
+    struct ShapeTemplate {
+        // Positions in the filter of the equalities, in sorted order.
+        std::vector<size_t> fieldOrder;
+
+        PlanCacheKey cacheKey;
+    };
+
+    const size_t kMaxShapeTemplates = 1000;
+
+    boost::mutex shapeTemplatesMutex;
+    LRUKeyValue<string, ShapeTemplate> shapeTemplates(kMaxShapeTemplates);
+
+    /**
+     * If the filter of 'lpq' is only equalities on distinct top-level fields, writes the
+     * signature of its ShapeTemplate to 'signatureOut' and returns true.
+     */
+    bool getShapeTemplateSignature(const LiteParsedQuery& lpq, string* signatureOut) {
+        std::set<StringData> fieldNames;
+        BSONObjIterator it(lpq.getFilter());
+        while (it.more()) {
+            BSONElement elt = it.next();
+            switch (elt.type()) {
+            case Object:
+            case Array:
+            case RegEx:
+            case Undefined:
+                // Operators, or values the parser treats specially.
+                return false;
+            default:
+                break;
+            }
+
+            StringData fieldName = elt.fieldNameStringData();
+            if (fieldName.empty() || '$' == fieldName[0] || !fieldNames.insert(fieldName).second) {
+                return false;
+            }
+            signatureOut->append(fieldName.rawData(), fieldName.size());
+            signatureOut->push_back('\0');
+        }
+
+        signatureOut->push_back('\0');
+        signatureOut->append(lpq.getSort().objdata(), lpq.getSort().objsize());
+        signatureOut->append(lpq.getProj().objdata(), lpq.getProj().objsize());
+        return true;
+    }
+
+    /**
+     * Fills in 'templateOut' from 'root', the canonicalized tree of 'filter'. Returns false if
+     * 'root' isn't just the equalities of 'filter'.
+     */
+    bool makeShapeTemplate(const BSONObj& filter,
+                           const MatchExpression* root,
+                           const PlanCacheKey& cacheKey,
+                           ShapeTemplate* templateOut) {
+        std::vector<const MatchExpression*> equalities;
+        if (MatchExpression::EQ == root->matchType()) {
+            equalities.push_back(root);
+        }
+        else if (MatchExpression::AND == root->matchType() && root->numChildren() != 1) {
+            for (size_t i = 0; i < root->numChildren(); ++i) {
+                equalities.push_back(root->getChild(i));
+            }
+        }
+        else {
+            return false;
+        }
+
+        if (equalities.size() != static_cast<size_t>(filter.nFields())) {
+            return false;
+        }
+
+        for (size_t i = 0; i < equalities.size(); ++i) {
+            if (MatchExpression::EQ != equalities[i]->matchType()) {
+                return false;
+            }
+
+            size_t pos = 0;
+            BSONObjIterator it(filter);
+            while (it.more() && it.next().fieldNameStringData() != equalities[i]->path()) {
+                ++pos;
+            }
+            if (pos == equalities.size()) {
+                return false;
+            }
+            templateOut->fieldOrder.push_back(pos);
+        }
+
+        templateOut->cacheKey = cacheKey;
+        return true;
+    }
+
+    /**
+     * Builds the canonicalized tree of 'filter' from 'shapeTemplate'. Returns NULL if that isn't
+     * possible, in which case the filter should go through the parser, which explains why.
+     */
+    MatchExpression* instantiateShapeTemplate(const BSONObj& filter,
+                                              const ShapeTemplate& shapeTemplate) {
+        std::vector<BSONElement> elts;
+        BSONObjIterator it(filter);
+        while (it.more()) {
+            elts.push_back(it.next());
+        }
+
+        auto_ptr<AndMatchExpression> root(new AndMatchExpression());
+        for (size_t i = 0; i < shapeTemplate.fieldOrder.size(); ++i) {
+            const BSONElement& elt = elts[shapeTemplate.fieldOrder[i]];
+            auto_ptr<EqualityMatchExpression> eq(new EqualityMatchExpression());
+            if (!eq->init(elt.fieldName(), elt).isOK()) {
+                return NULL;
+            }
+            root->add(eq.release());
+        }
+
+        // A single equality isn't wrapped in an AND, as normalizeTree() would have removed it.
+        if (root->numChildren() == 1) {
+            MatchExpression* eq = root->getChild(0);
+            root->clearAndRelease();
+            return eq;
+        }
+
+        return root.release();
+    }
+
 } // namespace
 
 namespace mongo {
@@ -435,19 +572,10 @@ namespace mongo {
     Status CanonicalQuery::canonicalize(LiteParsedQuery* lpq,
                                         CanonicalQuery** out,
                                         const MatchExpressionParser::WhereCallback& whereCallback) {
-        auto_ptr<LiteParsedQuery> autoLpq(lpq);
-
-        // Make MatchExpression.
-        StatusWithMatchExpression swme = MatchExpressionParser::parse(autoLpq->getFilter(),
-                                                                      whereCallback);
-        if (!swme.isOK()) {
-            return swme.getStatus();
-        }
-
         // Make the CQ we'll hopefully return.
         auto_ptr<CanonicalQuery> cq(new CanonicalQuery());
-        // Takes ownership of lpq and the MatchExpression* in swme.
-        Status initStatus = cq->init(autoLpq.release(), whereCallback, swme.getValue());
+        // Takes ownership of lpq.
+        Status initStatus = cq->init(lpq, whereCallback);
 
         if (!initStatus.isOK()) { return initStatus; }
         *out = cq.release();
@@ -509,23 +637,75 @@ namespace mongo {
         if (!parseStatus.isOK()) {
             return parseStatus;
         }
-        auto_ptr<LiteParsedQuery> lpq(lpqRaw);
+
+        // Make the CQ we'll hopefully return.
+        auto_ptr<CanonicalQuery> cq(new CanonicalQuery());
+        // Takes ownership of lpqRaw.
+        Status initStatus = cq->init(lpqRaw, whereCallback);
+
+        if (!initStatus.isOK()) { return initStatus; }
+        *out = cq.release();
+        return Status::OK();
+    }
+
+    Status CanonicalQuery::init(LiteParsedQuery* lpq,
+                                const MatchExpressionParser::WhereCallback& whereCallback) {
+        auto_ptr<LiteParsedQuery> autoLpq(lpq);
+
+        // Filters of a shape seen before which are only equalities skip the parser, and the
+        // normalizing and sorting of the tree.
+        string signature;
+        const bool templatable = internalQueryCacheShapeTemplates
+                                 && getShapeTemplateSignature(*lpq, &signature);
+        if (templatable) {
+            ShapeTemplate shapeTemplate;
+            bool found = false;
+            {
+                boost::lock_guard<boost::mutex> lk(shapeTemplatesMutex);
+                ShapeTemplate* entry;
+                if (shapeTemplates.get(signature, &entry).isOK()) {
+                    shapeTemplate = *entry;
+                    found = true;
+                }
+            }
+
+            MatchExpression* root = found ? instantiateShapeTemplate(lpq->getFilter(),
+                                                                     shapeTemplate)
+                                          : NULL;
+            if (NULL != root) {
+                _isForWrite = false;
+                _pq.reset(autoLpq.release());
+                _root.reset(root);
+                Status validStatus = isValid(root, *_pq);
+                if (!validStatus.isOK()) {
+                    return validStatus;
+                }
+
+                _cacheKey = shapeTemplate.cacheKey;
+                return initProjection(whereCallback);
+            }
+        }
 
         // Build a parse tree from the BSONObj in the parsed query.
-        StatusWithMatchExpression swme = 
-                            MatchExpressionParser::parse(lpq->getFilter(), whereCallback);
+        StatusWithMatchExpression swme = MatchExpressionParser::parse(lpq->getFilter(),
+                                                                      whereCallback);
         if (!swme.isOK()) {
             return swme.getStatus();
         }
 
-        // Make the CQ we'll hopefully return.
-        auto_ptr<CanonicalQuery> cq(new CanonicalQuery());
         // Takes ownership of lpq and the MatchExpression* in swme.
-        Status initStatus = cq->init(lpq.release(), whereCallback, swme.getValue());
+        Status initStatus = init(autoLpq.release(), whereCallback, swme.getValue());
+        if (!initStatus.isOK() || !templatable) {
+            return initStatus;
+        }
 
-        if (!initStatus.isOK()) { return initStatus; }
-        *out = cq.release();
-        return Status::OK();
+        auto_ptr<ShapeTemplate> shapeTemplate(new ShapeTemplate());
+        if (makeShapeTemplate(_pq->getFilter(), _root.get(), _cacheKey, shapeTemplate.get())) {
+            boost::lock_guard<boost::mutex> lk(shapeTemplatesMutex);
+            shapeTemplates.add(signature, shapeTemplate.release());
+        }
+
+        return initStatus;
     }
 
     Status CanonicalQuery::init(LiteParsedQuery* lpq,
@@ -546,6 +726,11 @@ namespace mongo {
 
         this->generateCacheKey();
 
+        return initProjection(whereCallback);
+    }
+
+    Status CanonicalQuery::initProjection(
+            const MatchExpressionParser::WhereCallback& whereCallback) {
         // Validate the projection if there is one.
         if (!_pq->getProj().isEmpty()) {
             ParsedProjection* pp;
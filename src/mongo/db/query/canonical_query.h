@@ -225,6 +225,12 @@ namespace mongo {
          */
         void generateCacheKey(void);
 
+        /**
+         * Builds the tree from the filter of 'lpq'. Takes ownership of 'lpq'.
+         */
+        Status init(LiteParsedQuery* lpq,
+                    const MatchExpressionParser::WhereCallback& whereCallback);
+
         /**
          * Takes ownership of 'root' and 'lpq'.
          */
@@ -232,6 +238,11 @@ namespace mongo {
                     const MatchExpressionParser::WhereCallback& whereCallback,
                     MatchExpression* root);
 
+        /**
+         * Parses the projection, if there is one, against the tree.
+         */
+        Status initProjection(const MatchExpressionParser::WhereCallback& whereCallback);
+
         boost::scoped_ptr<LiteParsedQuery> _pq;
 
         // _root points into _pq->getFilter()
@@ -548,6 +548,43 @@ namespace {
         FAIL(ss);
     }
 
+    /**
+     * Canonicalizes 'queryStr' twice and checks both times that the tree is the one parsing,
+     * normalizing and sorting it gives, whether or not it was built from a shape template.
+     */
+    void testShapeTemplate(const char* queryStr) {
+        for (int i = 0; i < 2; ++i) {
+            auto_ptr<CanonicalQuery> cq(canonicalize(queryStr));
+            MatchExpression* expected = parseMatchExpression(fromjson(queryStr));
+            expected = CanonicalQuery::normalizeTree(expected);
+            CanonicalQuery::sortTree(expected);
+            auto_ptr<MatchExpression> autoExpected(expected);
+            ASSERT_EQUALS(expected->toString(), cq->root()->toString());
+            assertEquivalent(queryStr, expected, cq->root());
+        }
+    }
+
+    TEST(CanonicalQueryTest, ShapeTemplate) {
+        testShapeTemplate("{c: 1, a: 2, b: 3}");
+        // Same shape, other values.
+        testShapeTemplate("{c: 'x', a: null, b: 4.5}");
+        // Same field names, but not just equalities.
+        testShapeTemplate("{c: 1, a: /x/, b: 3}");
+        testShapeTemplate("{c: 1, a: {$gt: 2}, b: 3}");
+        testShapeTemplate("{c: 1, a: [1, 2], b: 3}");
+        // Other field order.
+        testShapeTemplate("{a: 1, b: 2, c: 3}");
+        testShapeTemplate("{a: 1}");
+        testShapeTemplate("{'a.b': 1}");
+        testShapeTemplate("{}");
+
+        // The cache key comes from the template too.
+        testGetPlanCacheKey("{c: 5, a: 6, b: 7}", "{}", "{}", "an[eqa,eqb,eqc]");
+        testGetPlanCacheKey("{c: 5, a: 6, b: 7}", "{}", "{}", "an[eqa,eqb,eqc]");
+        testGetPlanCacheKey("{c: 5, a: 6, b: 7}", "{a: 1}", "{}", "an[eqa,eqb,eqc]~aa");
+        testGetPlanCacheKey("{c: 5, a: 6, b: 7}", "{a: 1}", "{}", "an[eqa,eqb,eqc]~aa");
+    }
+
     TEST(PlanCacheTest, GetPlanCacheKey) {
         // Generated cache keys should be treated as opaque to the user.
 
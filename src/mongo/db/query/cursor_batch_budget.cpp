@@ -0,0 +1,60 @@
+// cursor_batch_budget.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/cursor_batch_budget.h"
+
+#include <algorithm>
+
+#include "mongo/bson/util/builder.h"
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+
+    // If positive, cursor batches are cut off once they cross this many bytes, instead of at the
+    // default for the kind of batch. Capped at the maximum user document size.
+    MONGO_EXPORT_SERVER_PARAMETER(cursorBatchTargetBytes, int, 0);
+
+    // If positive, cursor batches holding at least one result are sent once they have been
+    // building for this many milliseconds.
+    MONGO_EXPORT_SERVER_PARAMETER(cursorBatchMaxTimeMS, int, 0);
+
+    CursorBatchBudget::CursorBatchBudget(int defaultMaxBytes, bool mayReturnEarly)
+        : _maxBytes(defaultMaxBytes),
+          _maxTimeMillis(mayReturnEarly ? std::max(0, static_cast<int>(cursorBatchMaxTimeMS))
+                                        : 0) {
+        const int targetBytes = cursorBatchTargetBytes;
+        if (targetBytes > 0) {
+            _maxBytes = std::min(targetBytes, BSONObjMaxUserSize);
+        }
+    }
+
+}  // namespace mongo
@@ -0,0 +1,76 @@
+// cursor_batch_budget.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    /**
+     * Decides when a batch of cursor results is complete enough to send, for mongod's query,
+     * getMore and aggregate replies and for mongos's sharded cursors.
+     *
+     * Callers keep their own document count limits, and ask enough() after every result whether
+     * the batch should also stop because of its size or of how long it has been building. The
+     * byte threshold is the caller's default unless the cursorBatchTargetBytes server parameter
+     * replaces it. If cursorBatchMaxTimeMS is set, batches which already hold a result are sent
+     * once they have been building that long, so expensive filtered scans return partial
+     * batches early instead of making the client wait for a full one.
+     */
+    class CursorBatchBudget {
+    public:
+        /**
+         * Starts timing a batch whose byte threshold is 'defaultMaxBytes' by default. Batches
+         * which must hold every result, such as single batch queries, pass
+         * 'mayReturnEarly' false to ignore the time budget.
+         */
+        explicit CursorBatchBudget(int defaultMaxBytes, bool mayReturnEarly = true);
+
+        /**
+         * Returns true if a batch of 'numResults' results taking 'numBytes' bytes should be sent
+         * without adding more.
+         */
+        bool enough(int numResults, int numBytes) const {
+            if (numBytes > _maxBytes) {
+                return true;
+            }
+            return _maxTimeMillis > 0 && numResults > 0 && _timer.millis() >= _maxTimeMillis;
+        }
+
+        int maxBytes() const { return _maxBytes; }
+
+    private:
+        int _maxBytes;
+        int _maxTimeMillis; // 0 if batches are not sent early
+        Timer _timer;
+    };
+
+}  // namespace mongo
@@ -224,7 +224,8 @@ namespace mongo {
         // Some top-level exec stats get pulled out of the root stage.
         if (verbosity >= ExplainCommon::EXEC_STATS) {
             bob->appendNumber("nReturned", stats.common.advanced);
-            bob->appendNumber("executionTimeMillisEstimate", stats.common.executionTimeMillis);
+            bob->appendNumber("executionTimeMillisEstimate",
+                              stats.common.executionTimeNanos / 1000000);
             bob->appendNumber("works", stats.common.works);
             bob->appendNumber("advanced", stats.common.advanced);
             bob->appendNumber("needTime", stats.common.needTime);
@@ -245,6 +246,8 @@ namespace mongo {
 
                 bob->appendNumber("flaggedButPassed", spec->flaggedButPassed);
                 bob->appendNumber("flaggedInProgress", spec->flaggedInProgress);
+                bob->appendBool("compacted", spec->compacted);
+                bob->appendNumber("bloomFilterRejects", spec->bloomFilterRejects);
                 for (size_t i = 0; i < spec->mapAfterChild.size(); ++i) {
                     bob->appendNumber(string(stream() << "mapAfterChild_" << i),
                                       spec->mapAfterChild[i]);
@@ -263,6 +266,12 @@ namespace mongo {
                 }
             }
         }
+        else if (STAGE_CACHED_PLAN == stats.stageType) {
+            CachedPlanStats* spec = static_cast<CachedPlanStats*>(stats.specific.get());
+            if (verbosity >= ExplainCommon::EXEC_STATS) {
+                bob->appendBool("replanned", spec->replanned);
+            }
+        }
         else if (STAGE_COLLSCAN == stats.stageType) {
             CollectionScanStats* spec = static_cast<CollectionScanStats*>(stats.specific.get());
             bob->append("direction", spec->direction > 0 ? "forward" : "backward");
@@ -277,6 +286,10 @@ namespace mongo {
                 bob->appendNumber("nCounted", spec->nCounted);
                 bob->appendNumber("nSkipped", spec->nSkipped);
             }
+
+            if (spec->estimated) {
+                bob->appendBool("estimated", true);
+            }
         }
         else if (STAGE_COUNT_SCAN == stats.stageType) {
             CountScanStats* spec = static_cast<CountScanStats*>(stats.specific.get());
@@ -301,6 +314,7 @@ namespace mongo {
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("docsExamined", spec->docsExamined);
                 bob->appendNumber("alreadyHasObj", spec->alreadyHasObj);
+                bob->appendNumber("docsPrefetched", spec->docsPrefetched);
             }
         }
         else if (STAGE_GEO_NEAR_2D == stats.stageType
@@ -365,6 +379,7 @@ namespace mongo {
                 bob->appendNumber("dupsTested", spec->dupsTested);
                 bob->appendNumber("dupsDropped", spec->dupsDropped);
                 bob->appendNumber("locsForgotten", spec->locsForgotten);
+                bob->appendNumber("dedupMemUsage", spec->dedupMemUsage);
                 for (size_t i = 0; i < spec->matchTested.size(); ++i) {
                     bob->appendNumber(string(stream() << "matchTested_" << i),
                                       spec->matchTested[i]);
@@ -397,6 +412,7 @@ namespace mongo {
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("memUsage", spec->memUsage);
                 bob->appendNumber("memLimit", spec->memLimit);
+                bob->appendBool("usedDisk", spec->usedDisk);
             }
 
             if (spec->limit > 0) {
@@ -410,6 +426,7 @@ namespace mongo {
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("dupsTested", spec->dupsTested);
                 bob->appendNumber("dupsDropped", spec->dupsDropped);
+                bob->appendNumber("dedupMemUsage", spec->dedupMemUsage);
             }
         }
         else if (STAGE_TEXT == stats.stageType) {
@@ -544,7 +561,8 @@ namespace mongo {
             out->appendNumber("executionTimeMillis", totalTimeMillis);
         }
         else {
-            out->appendNumber("executionTimeMillisEstimate", stats->common.executionTimeMillis);
+            out->appendNumber("executionTimeMillisEstimate",
+                              stats->common.executionTimeNanos / 1000000);
         }
 
         // Flatten the stats tree into a list.
@@ -644,6 +662,11 @@ namespace mongo {
             long long totalTimeMillis = opCtx->getCurOp()->elapsedMillis();
             generateExecStats(winningStats.get(), verbosity, &execBob, totalTimeMillis);
 
+            // What the storage engine did for the whole operation, plan selection included.
+            BSONObjBuilder storageStatsBob(execBob.subobjStart("storageStats"));
+            opCtx->getCurOp()->storageStats().append(&storageStatsBob);
+            storageStatsBob.doneFast();
+
             // Also generate exec stats for all plans, if the verbosity level is high enough.
             // These stats reflect what happened during the trial period that ranked the plans.
             if (verbosity >= ExplainCommon::EXEC_ALL_PLANS) {
@@ -712,7 +735,7 @@ namespace mongo {
         // root stage of the plan tree.
         const CommonStats* common = root->getCommonStats();
         statsOut->nReturned = common->advanced;
-        statsOut->executionTimeMillis = common->executionTimeMillis;
+        statsOut->executionTimeMillis = common->executionTimeNanos / 1000000;
 
         // Generate the plan summary string.
         statsOut->summaryStr = getPlanSummary(root);
@@ -28,6 +28,7 @@
 
 #include "mongo/db/query/expression_index.h"
 
+#include <boost/thread/mutex.hpp>
 #include <iostream>
 
 #include "third_party/s2/s2regioncoverer.h"
@@ -36,12 +37,35 @@
 #include "mongo/db/geo/hash.h"
 #include "mongo/db/geo/r2_region_coverer.h"
 #include "mongo/db/hasher.h"
+#include "mongo/db/query/expression_index_knobs.h"
+#include "mongo/db/query/lru_key_value.h"
+#include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
-    BSONObj ExpressionMapping::hash(const BSONElement& value) {
+    namespace {
+
+        // Coverings of recently queried geometries, keyed by the coarsest indexed level and the
+        // BSON of the geometry. Created on first use, with internalGeoQueryCoveringCacheSize
+        // entries.
+        boost::mutex coveringCacheMutex;
+        LRUKeyValue<std::string, OrderedIntervalList>* coveringCache = NULL;
+
+        int getCoarsestIndexedLevel(const BSONObj& indexInfoObj) {
+            BSONElement ce = indexInfoObj["coarsestIndexedLevel"];
+            if (ce.isNumber()) {
+                return ce.numberInt();
+            }
+            return S2::kAvgEdge.GetClosestLevel(100 * 1000.0 / kRadiusOfEarthInMeters);
+        }
+
+    } // namespace
+
+    BSONObj ExpressionMapping::hash(const BSONElement& value, int hashVersion) {
         BSONObjBuilder bob;
-        bob.append("", BSONElementHasher::hash64(value, BSONElementHasher::DEFAULT_HASH_SEED));
+        bob.append("", BSONElementHasher::hash64(value,
+                                                 BSONElementHasher::DEFAULT_HASH_SEED,
+                                                 hashVersion));
         return bob.obj();
     }
 
@@ -100,17 +124,55 @@ namespace mongo {
     void ExpressionMapping::cover2dsphere(const S2Region& region,
                                           const BSONObj& indexInfoObj,
                                           OrderedIntervalList* oilOut) {
+        cover2dsphere(region, getCoarsestIndexedLevel(indexInfoObj), oilOut);
+    }
 
-        int coarsestIndexedLevel;
-        BSONElement ce = indexInfoObj["coarsestIndexedLevel"];
-        if (ce.isNumber()) {
-            coarsestIndexedLevel = ce.numberInt();
+    void ExpressionMapping::cover2dsphereCached(const BSONObj& geometry,
+                                                const S2Region& region,
+                                                const BSONObj& indexInfoObj,
+                                                OrderedIntervalList* oilOut) {
+        const int coarsestIndexedLevel = getCoarsestIndexedLevel(indexInfoObj);
+        if (internalGeoQueryCoveringCacheSize <= 0) {
+            cover2dsphere(region, coarsestIndexedLevel, oilOut);
+            return;
         }
-        else {
-            coarsestIndexedLevel =
-                S2::kAvgEdge.GetClosestLevel(100 * 1000.0 / kRadiusOfEarthInMeters);
+
+        std::string key = mongoutils::str::stream() << coarsestIndexedLevel << ':';
+        key.append(geometry.objdata(), geometry.objsize());
+
+        {
+            boost::mutex::scoped_lock lk(coveringCacheMutex);
+            if (NULL == coveringCache) {
+                coveringCache =
+                    new LRUKeyValue<std::string, OrderedIntervalList>(
+                        internalGeoQueryCoveringCacheSize);
+            }
+
+            OrderedIntervalList* cached;
+            if (coveringCache->get(key, &cached).isOK()) {
+                oilOut->intervals.insert(oilOut->intervals.end(),
+                                         cached->intervals.begin(),
+                                         cached->intervals.end());
+                return;
+            }
         }
 
+        // Computing the covering is what's expensive, so it's done without the lock. Two
+        // queries over a new geometry may both compute it, and the second one's add() replaces
+        // the first one's entry.
+        std::auto_ptr<OrderedIntervalList> covering(new OrderedIntervalList(oilOut->name));
+        cover2dsphere(region, coarsestIndexedLevel, covering.get());
+        oilOut->intervals.insert(oilOut->intervals.end(),
+                                 covering->intervals.begin(),
+                                 covering->intervals.end());
+
+        boost::mutex::scoped_lock lk(coveringCacheMutex);
+        coveringCache->add(key, covering.release());
+    }
+
+    void ExpressionMapping::cover2dsphere(const S2Region& region,
+                                          int coarsestIndexedLevel,
+                                          OrderedIntervalList* oilOut) {
         // The min level of our covering is the level whose cells are the closest match to the
         // *area* of the region (or the max indexed level, whichever is smaller) The max level
         // is 4 sizes larger.
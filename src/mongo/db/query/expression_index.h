@@ -44,7 +44,8 @@ namespace mongo {
     class ExpressionMapping {
     public:
 
-        static BSONObj hash(const BSONElement& value);
+        /** 'hashVersion' is the hashed index's, see HashVersion. */
+        static BSONObj hash(const BSONElement& value, int hashVersion);
 
         static void cover2d(const R2Region& region,
                             const BSONObj& indexInfoObj,
@@ -55,6 +56,21 @@ namespace mongo {
         static void cover2dsphere(const S2Region& region,
                                   const BSONObj& indexInfoObj,
                                   OrderedIntervalList* oilOut);
+
+        /**
+         * Like cover2dsphere(), but reuses the covering computed for an earlier query over the
+         * same 'geometry', the BSON 'region' was parsed from, and index parameters. Queries
+         * tend to be issued over the same regions again and again.
+         */
+        static void cover2dsphereCached(const BSONObj& geometry,
+                                        const S2Region& region,
+                                        const BSONObj& indexInfoObj,
+                                        OrderedIntervalList* oilOut);
+
+    private:
+        static void cover2dsphere(const S2Region& region,
+                                  int coarsestIndexedLevel,
+                                  OrderedIntervalList* oilOut);
     };
 
 }  // namespace mongo
@@ -44,4 +44,10 @@ namespace mongo {
      */
     extern int internalGeoNearQuery2DMaxCoveringCells;
 
+    /**
+     * How many 2dsphere query coverings are kept for reuse by later queries over the same
+     * geometry. Zero turns the cache off.
+     */
+    extern int internalGeoQueryCoveringCacheSize;
+
 }  // namespace mongo
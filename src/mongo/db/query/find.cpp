@@ -37,18 +37,23 @@
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/exec/collection_scan.h"
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/oplogstart.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/keypattern.h"
 #include "mongo/db/query/explain.h"
+#include "mongo/db/query/cursor_batch_budget.h"
 #include "mongo/db/query/find_constants.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/oplog_read_buffer.h"
 #include "mongo/db/query/qlog.h"
 #include "mongo/db/query/query_planner_params.h"
+#include "mongo/db/query/query_result_cache.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/server_parameters.h"
@@ -85,11 +90,34 @@ namespace {
      * The n limit (vs. size) is important when someone fetches only one small field from big
      * objects, which causes massive scanning server-side.
      */
-    bool enoughForFirstBatch(const mongo::LiteParsedQuery& pq, int n, int len) {
+    bool enoughForFirstBatch(const mongo::LiteParsedQuery& pq,
+                             const mongo::CursorBatchBudget& budget,
+                             int n,
+                             int len) {
+        if (budget.enough(n, len)) {
+            return true;
+        }
         if (0 == pq.getNumToReturn()) {
-            return (len > 1024 * 1024) || n >= 101;
+            return n >= 101;
         }
-        return n >= pq.getNumToReturn() || len > mongo::MaxBytesToReturnToClientAtOnce;
+        return n >= pq.getNumToReturn();
+    }
+
+    // The byte threshold of a query's first batch, unless cursorBatchTargetBytes is set.
+    int firstBatchMaxBytes(const mongo::LiteParsedQuery& pq) {
+        return 0 == pq.getNumToReturn() ? 1024 * 1024 : mongo::MaxBytesToReturnToClientAtOnce;
+    }
+
+    /**
+     * Returns true if the results of 'pq' may come from, and go into, the query result cache:
+     * it asked for that and it is answered by a single reply from the data alone.
+     */
+    bool canCacheResults(const mongo::LiteParsedQuery& pq) {
+        return pq.getOptions().cacheResults
+            && !pq.isExplain()
+            && !pq.getOptions().tailable
+            && !pq.getOptions().oplogReplay
+            && !pq.getOptions().exhaust;
     }
 
     bool enough(const mongo::LiteParsedQuery& pq, int n) {
@@ -115,6 +143,34 @@ namespace {
         return static_cast<const mongo::ComparisonMatchExpression*>(me)->getData();
     }
 
+    /**
+     * Returns the collection scan of 'cc' if its batches can be shared with other tailers through
+     * the OplogReadBuffer: it tails the oplog noting its position, and returns whole entries
+     * straight from the scan, filtered at most by a lower bound on "ts". As timestamps only grow,
+     * every entry after one such a cursor has returned passes its filter too.
+     */
+    mongo::CollectionScan* getSharableOplogScan(const mongo::NamespaceString& nss,
+                                                mongo::ClientCursor* cc) {
+        const int queryOptions = cc->queryOptions();
+        if (!nss.isOplog()
+                || cc->isAggCursor()
+                || !(queryOptions & mongo::QueryOption_CursorTailable)
+                || !(queryOptions & mongo::QueryOption_OplogReplay)) {
+            return NULL;
+        }
+
+        mongo::PlanStage* root = cc->getExecutor()->getRootStage();
+        if (mongo::STAGE_COLLSCAN != root->stageType()) {
+            return NULL;
+        }
+
+        mongo::CollectionScan* scan = static_cast<mongo::CollectionScan*>(root);
+        if (NULL != scan->getFilter() && !isOplogTsPred(scan->getFilter())) {
+            return NULL;
+        }
+        return scan;
+    }
+
 }  // namespace
 
 namespace mongo {
@@ -170,6 +226,156 @@ namespace mongo {
         RecoveryUnit* _txnPreviousRecoveryUnit;
     };
 
+namespace {
+
+    // Owned documents at least this big are referenced by replies rather than copied into them
+    const int kMinReferencedDocumentBytes = 4 * 1024;
+
+    /**
+     * Builds the documents of an OP_REPLY.  Small documents are copied into the reply, but large
+     * owned ones, which stay valid once the executor moves on and locks are released, are only
+     * referenced and are written to the socket from their own buffers with scatter/gather IO.
+     * Documents from mmapv1 point into the data files and so are always copied.
+     */
+    class ReplyBuilder {
+        MONGO_DISALLOW_COPYING(ReplyBuilder);
+    public:
+        /**
+         * If referenceOwned is false every document is copied, so the reply is one buffer.
+         */
+        ReplyBuilder(int initialSize, bool referenceOwned)
+            : _bb(new BufBuilder(initialSize)),
+              _len(sizeof(QueryResult::Value)),
+              _referenceOwned(referenceOwned) {
+            _bb->skip(sizeof(QueryResult::Value));
+        }
+
+        void append(const BSONObj& obj) {
+            _len += obj.objsize();
+            if (!_referenceOwned || !obj.isOwned() ||
+                    obj.objsize() < kMinReferencedDocumentBytes) {
+                _bb->appendBuf(obj.objdata(), obj.objsize());
+                return;
+            }
+
+            _flush();
+            _reply.appendReferencedData(obj.objdata(), obj.objsize(), obj.sharedBuffer());
+        }
+
+        /**
+         * Appends the 'size' bytes of documents in 'data', which are referenced as long as any
+         * owned documents are.
+         */
+        void appendDocuments(const SharedBuffer& data, int size) {
+            _len += size;
+            if (!_referenceOwned) {
+                _bb->appendBuf(data.get(), size);
+                return;
+            }
+
+            _flush();
+            _reply.appendReferencedData(data.get(), size, data);
+        }
+
+        /**
+         * Bytes in the reply so far, including the header.
+         */
+        int len() const { return _len; }
+
+        /**
+         * Moves the reply into 'result', which must be empty, and returns its header for the
+         * caller to fill out.
+         */
+        QueryResult::View done(Message* result) {
+            _flush();
+            *result = _reply;
+            QueryResult::View qr = result->header().view2ptr();
+            qr.msgdata().setOperation(opReply);
+            return qr;
+        }
+
+    private:
+        /**
+         * Moves the documents copied since the last referenced one into _reply.
+         */
+        void _flush() {
+            if (_bb->len() == 0) {
+                return;
+            }
+            _reply.appendData(_bb->buf(), _bb->len());
+            _bb->decouple();
+            _bb.reset(new BufBuilder());
+        }
+
+        scoped_ptr<BufBuilder> _bb;
+        Message _reply;
+        int _len;
+        const bool _referenceOwned;
+    };
+
+    /**
+     * Replies to a query with results from the query result cache.
+     */
+    void replyFromResultCache(const QueryResultCache::Result& cached,
+                              CurOp& curop,
+                              Message* result) {
+        BufBuilder bb(sizeof(QueryResult::Value) + cached.data.size());
+        bb.skip(sizeof(QueryResult::Value));
+        bb.appendBuf(cached.data.data(), cached.data.size());
+
+        QueryResult::View qr = bb.buf();
+        bb.decouple();
+        qr.setResultFlagsToOk();
+        qr.msgdata().setLen(bb.len());
+        curop.debug().responseLength = bb.len();
+        qr.msgdata().setOperation(opReply);
+        qr.setCursorId(0);
+        qr.setStartingFrom(0);
+        qr.setNReturned(cached.numResults);
+        result->setData(qr.view2ptr(), true);
+
+        curop.debug().nreturned = cached.numResults;
+        curop.debug().cursorid = -1;
+    }
+
+    /**
+     * Size and hit rate of the query result cache.
+     */
+    class QueryResultCacheSSS : public ServerStatusSection {
+    public:
+        QueryResultCacheSSS() : ServerStatusSection("queryResultCache") { }
+
+        virtual bool includeByDefault() const { return true; }
+
+        virtual BSONObj generateSection(OperationContext* txn,
+                                        const BSONElement& configElement) const {
+            BSONObjBuilder b;
+            QueryResultCache::get()->appendStats(&b);
+            return b.obj();
+        }
+
+    } queryResultCacheSSS;
+
+    /**
+     * How often oplog tailers were sent a batch another one read.
+     */
+    class OplogReadBufferSSS : public ServerStatusSection {
+    public:
+        OplogReadBufferSSS() : ServerStatusSection("oplogReadBuffer") { }
+
+        virtual bool includeByDefault() const { return true; }
+
+        virtual BSONObj generateSection(OperationContext* txn,
+                                        const BSONElement& configElement) const {
+            BSONObjBuilder b;
+            OplogReadBuffer::get()->appendStats(&b);
+            return b.obj();
+        }
+
+    } oplogReadBufferSSS;
+
+} // namespace
+
     /**
      * Called by db/instance.cpp.  This is the getMore entry point.
      *
@@ -185,7 +391,8 @@ namespace mongo {
                               int pass,
                               bool& exhaust,
                               bool* isCursorAuthorized,
-                              bool fromDBDirectClient) {
+                              bool fromDBDirectClient,
+                              Message* result) {
 
         // For testing, we may want to fail if we receive a getmore.
         if (MONGO_FAIL_POINT(failReceivedGetmore)) {
@@ -246,8 +453,8 @@ namespace mongo {
         const int InitialBufSize =
             512 + sizeof(QueryResult::Value) + MaxBytesToReturnToClientAtOnce;
 
-        BufBuilder bb(InitialBufSize);
-        bb.skip(sizeof(QueryResult::Value));
+        // DBDirectClient concatenates replies, so there is nothing to gain from referencing
+        ReplyBuilder bb(InitialBufSize, !fromDBDirectClient);
 
         if (NULL == cc) {
             cursorid = 0;
@@ -312,11 +519,51 @@ namespace mongo {
             // Get results out of the executor.
             exec->restoreState(txn);
 
+            // Tailers of the oplog waiting at the same entry share the batch read by the first of
+            // them to get to it.
+            CollectionScan* oplogScan = NULL;
+            OplogReadBuffer::Batch oplogBatch;
+            if (OplogReadBuffer::get()->enabled() && ctx) {
+                oplogScan = getSharableOplogScan(nss, cc);
+            }
+            if (oplogScan) {
+                oplogBatch.ns = nss.ns();
+                oplogBatch.truncateEpoch = ctx->getCollection()->getTruncateEpoch();
+                oplogBatch.after = cc->getSlaveReadTill();
+                oplogBatch.afterLoc = oplogScan->getLastSeenLoc();
+                if (oplogBatch.after.isNull() || oplogBatch.afterLoc.isNull()
+                        || oplogScan->isEOF()) {
+                    oplogScan = NULL;
+                }
+            }
+
+            OplogReadBuffer::Batch sharedBatch;
+            const bool useSharedBatch = oplogScan
+                && OplogReadBuffer::get()->lookup(oplogBatch.ns,
+                                                  oplogBatch.truncateEpoch,
+                                                  oplogBatch.after,
+                                                  oplogBatch.afterLoc,
+                                                  std::max(ntoreturn, 0),
+                                                  &sharedBatch);
+
             BSONObj obj;
-            PlanExecutor::ExecState state;
-            while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, NULL))) {
+            PlanExecutor::ExecState state = PlanExecutor::ADVANCED;
+            if (useSharedBatch) {
+                bb.appendDocuments(sharedBatch.data, sharedBatch.size);
+                numResults = sharedBatch.numResults;
+                slaveReadTill = sharedBatch.last;
+                oplogScan->resumeAfter(sharedBatch.lastLoc);
+            }
+
+            BufBuilder oplogBatchData;
+            const CursorBatchBudget budget(MaxBytesToReturnToClientAtOnce);
+            while (!useSharedBatch
+                    && PlanExecutor::ADVANCED == (state = exec->getNext(&obj, NULL))) {
                 // Add result to output buffer.
-                bb.appendBuf((void*)obj.objdata(), obj.objsize());
+                bb.append(obj);
+                if (oplogScan) {
+                    oplogBatchData.appendBuf(obj.objdata(), obj.objsize());
+                }
 
                 // Count the result.
                 ++numResults;
@@ -330,11 +577,24 @@ namespace mongo {
                 }
 
                 if ((ntoreturn && numResults >= ntoreturn)
-                    || bb.len() > MaxBytesToReturnToClientAtOnce) {
+                    || budget.enough(numResults, bb.len())) {
                     break;
                 }
             }
 
+            // Everything from the entry after 'oplogBatch.after' to the end of the oplog was read,
+            // which is what the other tailers waiting there need next.
+            if (oplogScan && !useSharedBatch && PlanExecutor::IS_EOF == state
+                    && numResults > 0 && !slaveReadTill.isNull()) {
+                oplogBatch.last = slaveReadTill;
+                oplogBatch.lastLoc = oplogScan->getLastSeenLoc();
+                oplogBatch.numResults = numResults;
+                oplogBatch.size = oplogBatchData.len();
+                oplogBatch.data = SharedBuffer::allocate(oplogBatch.size);
+                memcpy(oplogBatch.data.get(), oplogBatchData.buf(), oplogBatch.size);
+                OplogReadBuffer::get()->publish(oplogBatch);
+            }
+
             // We save the client cursor when there might be more results, and hence we may receive
             // another getmore. If we receive a EOF or an error, or 'exec' is dead, then we know
             // that we will not be producing more results. We indicate that the cursor is closed by
@@ -425,14 +685,11 @@ namespace mongo {
             }
         }
 
-        QueryResult::View qr = bb.buf();
-        qr.msgdata().setLen(bb.len());
-        qr.msgdata().setOperation(opReply);
+        QueryResult::View qr = bb.done(result);
         qr.setResultFlags(resultFlags);
         qr.setCursorId(cursorid);
         qr.setStartingFrom(startingResult);
         qr.setNReturned(numResults);
-        bb.decouple();
         QLOG() << "getMore returned " << numResults << " results\n";
         return qr;
     }
@@ -476,13 +733,12 @@ namespace mongo {
 
         boost::optional<RecordId> startLoc = boost::none;
 
-        // See if the RecordStore supports the oplogStartHack
+        // See if the RecordStore can seek to a ts.
         const BSONElement tsElem = extractOplogTsOptime(tsExpr);
         if (tsElem.type() == Timestamp) {
-            StatusWith<RecordId> goal = oploghack::keyForOptime(tsElem._opTime());
-            if (goal.isOK()) {
-                startLoc = collection->getRecordStore()->oplogStartHack(txn, goal.getValue());
-            }
+            startLoc = oploghack::seekToOptime(txn,
+                                               collection->getRecordStore(),
+                                               tsElem._opTime());
         }
 
         if (startLoc) {
@@ -492,7 +748,7 @@ namespace mongo {
             LOG(3) << "Using OplogStart stage";
 
             // Fallback to trying the OplogStart stage.
-            WorkingSet* oplogws = new WorkingSet();
+            WorkingSet* oplogws = WorkingSet::acquire();
             OplogStart* stage = new OplogStart(txn, collection, tsExpr, oplogws);
             PlanExecutor* rawExec;
 
@@ -528,7 +784,7 @@ namespace mongo {
         params.direction = CollectionScanParams::FORWARD;
         params.tailable = cq->getParsed().getOptions().tailable;
 
-        WorkingSet* ws = new WorkingSet();
+        WorkingSet* ws = WorkingSet::acquire();
         CollectionScan* cs = new CollectionScan(txn, params, ws, cq->root());
         // Takes ownership of 'ws', 'cs', and 'cq'.
         return PlanExecutor::make(txn, ws, cs, autoCq.release(), collection,
@@ -563,7 +819,9 @@ namespace mongo {
             BufBuilder bb;
             bb.skip(sizeof(QueryResult::Value));
 
-            BSONObjBuilder cmdResBuf;
+            // Build the command result in place after the reply header, so the buffer can be
+            // handed to the Message without copying the result.
+            BSONObjBuilder cmdResBuf(bb);
             if (!runCommands(txn, q.ns, q.query, curop, bb, cmdResBuf, false, q.queryOptions)) {
                 uasserted(13530, "bad or malformed command request?");
             }
@@ -614,6 +872,33 @@ namespace mongo {
 
         Collection* collection = ctx.getCollection();
 
+        // Queries which asked for it are answered from the result cache as long as their
+        // collection has not been written since they last ran. Results of sharded collections
+        // depend on more than the data, so they are never cached. The write epoch must be read
+        // before running the query, so that a write committing meanwhile makes the results stale.
+        std::string resultCacheKey;
+        unsigned long long writeEpoch = 0;
+        if (NULL != collection
+            && canCacheResults(cq->getParsed())
+            && !shardingState.needCollectionMetadata(nss.ns())) {
+            resultCacheKey = QueryResultCache::makeKey(nss.ns(), q);
+            writeEpoch = collection->getWriteEpoch();
+
+            QueryResultCache::Result cached;
+            if (QueryResultCache::get()->lookup(resultCacheKey, writeEpoch, &cached)) {
+                const LiteParsedQuery& pq = cq->getParsed();
+                bool slaveOK = pq.getOptions().slaveOk || pq.hasReadPref();
+                uassertStatusOK(repl::getGlobalReplicationCoordinator()->checkCanServeReadsFor(
+                        txn,
+                        nss,
+                        slaveOK));
+
+                curop.debug().ntoskip = pq.getSkip();
+                replyFromResultCache(cached, curop, &result);
+                return "";
+            }
+        }
+
         // We'll now try to get the query executor that will execute this query for us. There
         // are a few cases in which we know upfront which executor we should get and, therefore,
         // we shortcut the selection process here.
@@ -709,8 +994,7 @@ namespace mongo {
         // bb is used to hold query results
         // this buffer should contain either requested documents per query or
         // explain information, but not both
-        BufBuilder bb(32768);
-        bb.skip(sizeof(QueryResult::Value));
+        ReplyBuilder bb(32768, !fromDBDirectClient);
 
         // How many results have we obtained from the executor?
         int numResults = 0;
@@ -728,9 +1012,26 @@ namespace mongo {
         // Get summary info about which plan the executor is using.
         curop.debug().planSummary = Explain::getPlanSummary(exec.get());
 
+        // Queries answered in a single batch must not return part of it early.
+        const CursorBatchBudget budget(firstBatchMaxBytes(pq), pq.wantMore());
+
+        // The results to put in the query result cache, if any.
+        QueryResultCache::Result resultsToCache;
+        const size_t maxResultBytesToCache = QueryResultCache::get()->maxResultBytes();
+
         while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, NULL))) {
             // Add result to output buffer.
-            bb.appendBuf((void*)obj.objdata(), obj.objsize());
+            bb.append(obj);
+
+            if (!resultCacheKey.empty()) {
+                if (resultsToCache.data.size() + obj.objsize() > maxResultBytesToCache) {
+                    resultCacheKey.clear();
+                    resultsToCache.data.clear();
+                }
+                else {
+                    resultsToCache.data.append(obj.objdata(), obj.objsize());
+                }
+            }
 
             // Count the result.
             ++numResults;
@@ -750,7 +1051,7 @@ namespace mongo {
                                      || bb.len() >= MaxBytesToReturnToClientAtOnce)) {
                 break;
             }
-            else if (enoughForFirstBatch(pq, numResults, bb.len())) {
+            else if (enoughForFirstBatch(pq, budget, numResults, bb.len())) {
                 QLOG() << "Enough for first batch, wantMore=" << pq.wantMore()
                        << " numToReturn=" << pq.getNumToReturn()
                        << " numResults=" << numResults
@@ -815,6 +1116,18 @@ namespace mongo {
         curop.debug().nscannedObjects = summaryStats.totalDocsExamined;
         curop.debug().idhack = summaryStats.isIdhack;
 
+        // Add the query to the counters of its shape. A dead executor may have outlived its
+        // collection.
+        if (collection && PlanExecutor::DEAD != state) {
+            collection->infoCache()->getQueryShapeStats()->record(
+                *exec->getCanonicalQuery(),
+                curop.elapsedMicros(),
+                summaryStats.totalKeysExamined,
+                summaryStats.totalDocsExamined,
+                numResults,
+                curop.debug().planSummary.toString());
+        }
+
         // Set debug information for consumption by the profiler.
         if (dbProfilingLevel > 0 ||
             curop.elapsedMillis() > serverGlobalParams.slowMS ||
@@ -833,6 +1146,12 @@ namespace mongo {
             }
         }
 
+        // Only results sent whole in this reply can be replayed from the cache.
+        if (!resultCacheKey.empty() && !saveClientCursor && PlanExecutor::DEAD != state) {
+            resultsToCache.numResults = numResults;
+            QueryResultCache::get()->insert(resultCacheKey, writeEpoch, resultsToCache);
+        }
+
         long long ccId = 0;
         if (saveClientCursor) {
             // We won't use the executor until it's getMore'd.
@@ -888,15 +1207,12 @@ namespace mongo {
         }
 
         // Add the results from the query into the output buffer.
-        result.appendData(bb.buf(), bb.len());
-        bb.decouple();
+        QueryResult::View qr = bb.done(&result);
 
         // Fill out the output buffer's header.
-        QueryResult::View qr = result.header().view2ptr();
         qr.setCursorId(ccId);
         curop.debug().cursorid = (0 == ccId ? -1 : ccId);
         qr.setResultFlagsToOk();
-        qr.msgdata().setOperation(opReply);
         qr.setStartingFrom(0);
         qr.setNReturned(numResults);
 
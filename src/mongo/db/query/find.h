@@ -57,6 +57,9 @@ namespace mongo {
 
     /**
      * Called from the getMore entry point in ops/query.cpp.
+     *
+     * Places the reply in 'result', which must be empty, and returns its header, or returns a
+     * null view and leaves 'result' alone if an awaitData cursor has nothing to return yet.
      */
     QueryResult::View getMore(OperationContext* txn,
                               const char* ns,
@@ -66,7 +69,8 @@ namespace mongo {
                               int pass,
                               bool& exhaust,
                               bool* isCursorAuthorized,
-                              bool fromDBDirectClient);
+                              bool fromDBDirectClient,
+                              Message* result);
 
     /**
      * Run the query 'q' and place the result in 'result'.
@@ -37,6 +37,7 @@
 #include "mongo/base/error_codes.h"
 #include "mongo/base/parse_number.h"
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/db/catalog/index_catalog_entry.h"
 #include "mongo/db/exec/cached_plan.h"
 #include "mongo/db/exec/count.h"
 #include "mongo/db/exec/delete.h"
@@ -49,9 +50,11 @@
 #include "mongo/db/exec/subplan.h"
 #include "mongo/db/exec/update.h"
 #include "mongo/db/global_environment_experiment.h"
+#include "mongo/db/matcher/expression_algo.h"
 #include "mongo/db/ops/update_lifecycle.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/explain.h"
+#include "mongo/db/query/index_histogram.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/query/internal_plans.h"
@@ -116,12 +119,46 @@ namespace mongo {
                                                                                          false);
         while (ii.more()) {
             const IndexDescriptor* desc = ii.next();
+
+            // A partial index only holds the documents matching its filter, so it can only
+            // answer queries which imply that filter.
+            if (desc->isPartial()) {
+                const MatchExpression* filter =
+                    collection->getIndexCatalog()->getEntry(desc)->getFilterExpression();
+                if (!expression::isSubsetOf(canonicalQuery->root(), filter)) {
+                    continue;
+                }
+            }
+
             plannerParams->indices.push_back(IndexEntry(desc->keyPattern(),
                                                         desc->getAccessMethodName(),
                                                         desc->isMultikey(txn),
                                                         desc->isSparse(),
                                                         desc->indexName(),
                                                         desc->infoObj()));
+            if (plannerParams->indices.back().multikey) {
+                plannerParams->indices.back().multikeyPaths =
+                    collection->getIndexCatalog()->getEntry(desc)->getMultikeyPaths();
+            }
+        }
+
+        // Skip scans need to know how many values the first field of an index has, which only
+        // the index histograms tell us.
+        if (internalQueryPlannerEnableSkipScan) {
+            IndexStatistics* indexStats = collection->infoCache()->getIndexStatistics();
+            for (size_t i = 0; i < plannerParams->indices.size(); ++i) {
+                IndexEntry& entry = plannerParams->indices[i];
+                if (INDEX_BTREE != entry.type || entry.keyPattern.nFields() < 2) {
+                    continue;
+                }
+
+                boost::shared_ptr<const IndexHistogram> hist = indexStats->get(entry.keyPattern);
+                if (hist) {
+                    entry.numLeadingValues =
+                        static_cast<long long>(hist->estimateDistinct() + 0.5);
+                }
+            }
+            plannerParams->options |= QueryPlannerParams::SKIP_SCAN;
         }
 
         // If query supports index filters, filter params.indices by indices in query settings.
@@ -299,7 +336,8 @@ namespace mongo {
 
                     // Add a CachedPlanStage on top of the previous root. Takes ownership of
                     // '*rootOut', 'backupRoot', 'qs', and 'backupQs'.
-                    *rootOut = new CachedPlanStage(collection, canonicalQuery,
+                    *rootOut = new CachedPlanStage(opCtx, collection, ws, canonicalQuery,
+                                                   plannerParams, cs->decisionWorks,
                                                    *rootOut, qs,
                                                    backupRoot, backupQs);
                     return Status::OK();
@@ -317,7 +355,9 @@ namespace mongo {
             }
 
             vector<QuerySolution*> solutions;
-            Status status = QueryPlanner::plan(*canonicalQuery, plannerParams, &solutions);
+            Status status = QueryPlanner::planWithCandidateCache(
+                *canonicalQuery, plannerParams, collection->infoCache()->getPlanCache(),
+                &solutions);
             if (!status.isOK()) {
                 return Status(ErrorCodes::BadValue,
                               "error processing query: " + canonicalQuery->toString() +
@@ -357,6 +397,16 @@ namespace mongo {
                 }
             }
 
+            // Don't bother ranking the solutions the index histograms tell us are much worse
+            // than the best.
+            size_t numPruned =
+                collection->infoCache()->getIndexStatistics()->pruneSolutions(&solutions);
+            if (numPruned > 0) {
+                LOG(2) << "Index histograms pruned " << numPruned << " of "
+                       << numPruned + solutions.size() << " plans for "
+                       << canonicalQuery->toStringShort();
+            }
+
             if (1 == solutions.size()) {
                 // Only one possible plan.  Run it.  Build the stages from the solution.
                 verify(StageBuilder::build(opCtx, collection, *solutions[0], ws, rootOut));
@@ -402,7 +452,7 @@ namespace mongo {
                        PlanExecutor** out,
                        size_t plannerOptions) {
         auto_ptr<CanonicalQuery> canonicalQuery(rawCanonicalQuery);
-        auto_ptr<WorkingSet> ws(new WorkingSet());
+        auto_ptr<WorkingSet> ws(WorkingSet::acquire());
         PlanStage* root;
         QuerySolution* querySolution;
         Status status = prepareExecution(txn, collection, ws.get(), canonicalQuery.get(),
@@ -428,7 +478,7 @@ namespace mongo {
             LOG(2) << "Collection " << ns << " does not exist."
                    << " Using EOF stage: " << unparsedQuery.toString();
             EOFStage* eofStage = new EOFStage();
-            WorkingSet* ws = new WorkingSet();
+            WorkingSet* ws = WorkingSet::acquire();
             return PlanExecutor::make(txn, ws, eofStage, ns, yieldPolicy, out);
         }
 
@@ -448,7 +498,7 @@ namespace mongo {
 
         LOG(2) << "Using idhack: " << unparsedQuery.toString();
 
-        WorkingSet* ws = new WorkingSet();
+        WorkingSet* ws = WorkingSet::acquire();
         PlanStage* root = new IDHackStage(txn, collection, unparsedQuery["_id"].wrap(), ws);
 
         // Might have to filter out orphaned docs.
@@ -499,8 +549,10 @@ namespace mongo {
         deleteStageParams.shouldCallLogOp = request->shouldCallLogOp();
         deleteStageParams.fromMigrate = request->isFromMigrate();
         deleteStageParams.isExplain = request->isExplain();
+        deleteStageParams.returnDeleted = request->shouldReturnDeleted();
+        deleteStageParams.limit = request->getLimit();
 
-        auto_ptr<WorkingSet> ws(new WorkingSet());
+        auto_ptr<WorkingSet> ws(WorkingSet::acquire());
         PlanExecutor::YieldPolicy policy = parsedDelete->canYield() ? PlanExecutor::YIELD_AUTO :
                                                                       PlanExecutor::YIELD_MANUAL;
 
@@ -628,7 +680,7 @@ namespace mongo {
         PlanExecutor::YieldPolicy policy = parsedUpdate->canYield() ? PlanExecutor::YIELD_AUTO :
                                                                       PlanExecutor::YIELD_MANUAL;
 
-        auto_ptr<WorkingSet> ws(new WorkingSet());
+        auto_ptr<WorkingSet> ws(WorkingSet::acquire());
         UpdateStageParams updateStageParams(request, driver, opDebug);
 
         if (!parsedUpdate->hasParsedQuery()) {
@@ -710,7 +762,7 @@ namespace mongo {
             return Status(ErrorCodes::BadValue, "server-side JavaScript execution is disabled");
         }
 
-        auto_ptr<WorkingSet> ws(new WorkingSet());
+        auto_ptr<WorkingSet> ws(WorkingSet::acquire());
         PlanStage* root;
         QuerySolution* querySolution;
 
@@ -826,8 +878,8 @@ namespace mongo {
          * used with DistinctNode. Sets indexOut to the array index
          * of PlannerParams::indices.
          * Look for the index for the fewest fields.
-         * Criteria for suitable index is that the index cannot be special
-         * (geo, hashed, text, ...).
+         * Criteria for suitable index is that the index must be prefixed by 'field' and
+         * cannot be special (geo, hashed, text, ...).
          *
          * Multikey indices are not suitable for DistinctNode when the projection
          * is on an array element. Arrays are flattened in a multikey index which
@@ -844,6 +896,10 @@ namespace mongo {
             bool isDottedField = str::contains(field, '.');
             int minFields = std::numeric_limits<int>::max();
             for (size_t i = 0; i < indices.size(); ++i) {
+                // Without a query only an index prefixed by the field can be scanned.
+                if (field != indices[i].keyPattern.firstElement().fieldName()) {
+                    continue;
+                }
                 // Skip special indices.
                 if (!IndexNames::findPluginName(indices[i].keyPattern).empty()) {
                     continue;
@@ -937,7 +993,7 @@ namespace mongo {
                             const CountRequest& request,
                             PlanExecutor::YieldPolicy yieldPolicy,
                             PlanExecutor** execOut) {
-        auto_ptr<WorkingSet> ws(new WorkingSet());
+        auto_ptr<WorkingSet> ws(WorkingSet::acquire());
         PlanStage* root;
         QuerySolution* querySolution;
 
@@ -1014,53 +1070,134 @@ namespace mongo {
     // Distinct hack
     //
 
+    namespace {
+
+        /**
+         * Returns true if 'oil' is the single interval [MinKey, MaxKey] (or its reverse).
+         */
+        bool isAllValues(const OrderedIntervalList& oil) {
+            if (1 != oil.intervals.size()) {
+                return false;
+            }
+
+            const Interval& ival = oil.intervals[0];
+            if (!ival.startInclusive || !ival.endInclusive) {
+                return false;
+            }
+
+            return (MinKey == ival.start.type() && MaxKey == ival.end.type())
+                || (MaxKey == ival.start.type() && MinKey == ival.end.type());
+        }
+
+        /**
+         * Returns true if 'oil' is a single point interval.
+         */
+        bool isSinglePoint(const OrderedIntervalList& oil) {
+            return 1 == oil.intervals.size() && oil.intervals[0].isPoint();
+        }
+
+    }  // namespace
+
     bool turnIxscanIntoDistinctIxscan(QuerySolution* soln, const string& field) {
         QuerySolutionNode* root = soln->root.get();
 
-        // We're looking for a project on top of an ixscan.
-        if (STAGE_PROJECTION == root->getType() && (STAGE_IXSCAN == root->children[0]->getType())) {
-            IndexScanNode* isn = static_cast<IndexScanNode*>(root->children[0]);
+        // We're looking for a project on top of an ixscan, or, when the index is multikey, a
+        // project on top of an unfiltered fetch on top of an ixscan.
+        if (STAGE_PROJECTION != root->getType()) {
+            return false;
+        }
 
-            // An additional filter must be applied to the data in the key, so we can't just skip
-            // all the keys with a given value; we must examine every one to find the one that (may)
-            // pass the filter.
-            if (NULL != isn->filter.get()) {
+        ProjectionNode* pn = static_cast<ProjectionNode*>(root);
+        QuerySolutionNode* child = pn->children[0];
+        bool throughFetch = false;
+        if (STAGE_FETCH == child->getType()) {
+            // The fetch must not be applying any predicate that the index keys don't answer.
+            if (NULL != child->filter.get()) {
                 return false;
             }
+            child = child->children[0];
+            throughFetch = true;
+        }
 
-            // We only set this when we have special query modifiers (.max() or .min()) or other
-            // special cases.  Don't want to handle the interactions between those and distinct.
-            // Don't think this will ever really be true but if it somehow is, just ignore this
-            // soln.
-            if (isn->bounds.isSimpleRange) {
-                return false;
+        if (STAGE_IXSCAN != child->getType()) {
+            return false;
+        }
+
+        IndexScanNode* isn = static_cast<IndexScanNode*>(child);
+
+        // The planner only puts a fetch under the projection when the index can't cover it,
+        // which for the distinct projection means the index is multikey.
+        if (throughFetch && (!isn->indexIsMultiKey || str::contains(field, '.'))) {
+            return false;
+        }
+
+        // An additional filter must be applied to the data in the key, so we can't just skip
+        // all the keys with a given value; we must examine every one to find the one that (may)
+        // pass the filter.
+        if (NULL != isn->filter.get()) {
+            return false;
+        }
+
+        // We only set this when we have special query modifiers (.max() or .min()) or other
+        // special cases.  Don't want to handle the interactions between those and distinct.
+        // Don't think this will ever really be true but if it somehow is, just ignore this
+        // soln.
+        if (isn->bounds.isSimpleRange) {
+            return false;
+        }
+
+        // Figure out which field we're skipping to the next value of.
+        int fieldNo = 0;
+        BSONObjIterator it(isn->indexKeyPattern);
+        while (it.more()) {
+            if (field == it.next().fieldName()) {
+                break;
             }
+            fieldNo++;
+        }
 
-            // Make a new DistinctNode.  We swap this for the ixscan in the provided solution.
-            DistinctNode* dn = new DistinctNode();
-            dn->indexKeyPattern = isn->indexKeyPattern;
-            dn->direction = isn->direction;
-            dn->bounds = isn->bounds;
+        if (fieldNo >= static_cast<int>(isn->bounds.fields.size())) {
+            return false;
+        }
 
-            // Figure out which field we're skipping to the next value of.  TODO: We currently only
-            // try to distinct-hack when there is an index prefixed by the field we're distinct-ing
-            // over.  Consider removing this code if we stick with that policy.
-            dn->fieldNo = 0;
-            BSONObjIterator it(isn->indexKeyPattern);
-            while (it.more()) {
-                if (field == it.next().fieldName()) {
-                    break;
+        // Skipping to the next value of a suffix field only visits each value once when the
+        // fields before it are pinned by equality.
+        for (int i = 0; i < fieldNo; ++i) {
+            if (!isSinglePoint(isn->bounds.fields[i])) {
+                return false;
+            }
+        }
+
+        // A multikey document has one key per array element, and distinct must return every
+        // element of a matching document's array. The keys only give us all of them if nothing
+        // constrains the distinct field or the fields after it.
+        if (isn->indexIsMultiKey) {
+            for (size_t i = fieldNo; i < isn->bounds.fields.size(); ++i) {
+                if (!isAllValues(isn->bounds.fields[i])) {
+                    return false;
                 }
-                dn->fieldNo++;
             }
+        }
 
-            // Delete the old index scan, set the child of project to the fast distinct scan.
-            delete root->children[0];
-            root->children[0] = dn;
-            return true;
+        // Make a new DistinctNode.  We swap this for the ixscan in the provided solution.
+        DistinctNode* dn = new DistinctNode();
+        dn->indexKeyPattern = isn->indexKeyPattern;
+        dn->direction = isn->direction;
+        dn->bounds = isn->bounds;
+        dn->fieldNo = fieldNo;
+
+        // The projection now reads the distinct value out of the index key rather than a
+        // fetched document.
+        if (throughFetch) {
+            pn->projType = ProjectionNode::COVERED_ONE_INDEX;
+            pn->coveredKeyObj = dn->indexKeyPattern;
         }
 
-        return false;
+        // Delete the old index scan (and fetch), set the child of project to the fast distinct
+        // scan.
+        delete pn->children[0];
+        pn->children[0] = dn;
+        return true;
     }
 
     Status getExecutorDistinct(OperationContext* txn,
@@ -1089,9 +1226,10 @@ namespace mongo {
         IndexCatalog::IndexIterator ii = collection->getIndexCatalog()->getIndexIterator(txn,false);
         while (ii.more()) {
             const IndexDescriptor* desc = ii.next();
-            // The distinct hack can work if any field is in the index but it's not always clear
-            // if it's a win unless it's the first field.
-            if (desc->keyPattern().firstElement().fieldName() == field) {
+            // The distinct hack can work if any field is in the index. It is only a win when the
+            // fields before it are pinned by equality, which turnIxscanIntoDistinctIxscan checks.
+            // It can't use a partial index, which may be missing some of the values.
+            if (!desc->keyPattern()[field].eoo() && !desc->isPartial()) {
                 plannerParams.indices.push_back(IndexEntry(desc->keyPattern(),
                                                            desc->getAccessMethodName(),
                                                            desc->isMultikey(txn),
@@ -1118,7 +1256,7 @@ namespace mongo {
         }
 
         //
-        // If we're here, we have an index prefixed by the field we're distinct-ing over.
+        // If we're here, we have an index containing the field we're distinct-ing over.
         //
 
         // Applying a projection allows the planner to try to give us covered plans that we can turn
@@ -1158,7 +1296,7 @@ namespace mongo {
             QuerySolution* soln = QueryPlannerAnalysis::analyzeDataAccess(*cq, params, dn);
             invariant(soln);
 
-            WorkingSet* ws = new WorkingSet();
+            WorkingSet* ws = WorkingSet::acquire();
             PlanStage* root;
             verify(StageBuilder::build(txn, collection, *soln, ws, &root));
 
@@ -1188,7 +1326,7 @@ namespace mongo {
                 }
 
                 // Build and return the SSR over solutions[i].
-                WorkingSet* ws = new WorkingSet();
+                WorkingSet* ws = WorkingSet::acquire();
                 PlanStage* root;
                 verify(StageBuilder::build(txn, collection, *solutions[i], ws, &root));
 
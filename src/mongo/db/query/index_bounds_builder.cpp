@@ -243,6 +243,8 @@ namespace mongo {
         if (mongoutils::str::equals("hashed", elt.valuestrsafe())) {
             isHashed = true;
         }
+        // Hashed index bounds must use the hash function the index was built with.
+        const int hashVersion = isHashed ? index.infoObj["hashVersion"].numberInt() : 0;
 
         if (isHashed) {
             verify(MatchExpression::EQ == expr->matchType()
@@ -345,7 +347,7 @@ namespace mongo {
         }
         else if (MatchExpression::EQ == expr->matchType()) {
             const EqualityMatchExpression* node = static_cast<const EqualityMatchExpression*>(expr);
-            translateEquality(node->getData(), isHashed, oilOut, tightnessOut);
+            translateEquality(node->getData(), isHashed, hashVersion, oilOut, tightnessOut);
         }
         else if (MatchExpression::LTE == expr->matchType()) {
             const LTEMatchExpression* node = static_cast<const LTEMatchExpression*>(expr);
@@ -543,7 +545,7 @@ namespace mongo {
             IndexBoundsBuilder::BoundsTightness tightness;
             for (BSONElementSet::iterator it = afr.equalities().begin();
                  it != afr.equalities().end(); ++it) {
-                translateEquality(*it, isHashed, oilOut, &tightness);
+                translateEquality(*it, isHashed, hashVersion, oilOut, &tightness);
                 if (tightness != IndexBoundsBuilder::EXACT) {
                     *tightnessOut = tightness;
                 }
@@ -580,7 +582,8 @@ namespace mongo {
             if (mongoutils::str::equals("2dsphere", elt.valuestrsafe())) {
                 verify(gme->getGeoExpression().getGeometry().hasS2Region());
                 const S2Region& region = gme->getGeoExpression().getGeometry().getS2Region();
-                ExpressionMapping::cover2dsphere(region, index.infoObj, oilOut);
+                ExpressionMapping::cover2dsphereCached(gme->getRawObj(), region, index.infoObj,
+                                                       oilOut);
                 *tightnessOut = IndexBoundsBuilder::INEXACT_FETCH;
             }
             else if (mongoutils::str::equals("2d", elt.valuestrsafe())) {
@@ -687,48 +690,56 @@ namespace mongo {
         // This can happen.
         if (iv.empty()) { return; }
 
-        // Step 1: sort.
-        std::sort(iv.begin(), iv.end(), IntervalComparison);
+        // Step 1: sort.  Large $in lists usually arrive here already in order, so only pay for
+        // the sort when an interval is out of place.
+        for (size_t i = 1; i < iv.size(); ++i) {
+            if (IntervalComparison(iv[i], iv[i - 1])) {
+                std::sort(iv.begin(), iv.end(), IntervalComparison);
+                break;
+            }
+        }
 
-        // Step 2: Walk through and merge.
-        size_t i = 0;
-        while (i < iv.size() - 1) {
-            // Compare i with i + 1.
-            Interval::IntervalComparison cmp = iv[i].compare(iv[i + 1]);
+        // Step 2: Walk through and merge.  iv[last] is the most recent interval we've kept;
+        // each following interval is either folded into it or becomes the next kept interval,
+        // so the list is compacted in place in a single pass.
+        size_t last = 0;
+        for (size_t i = 1; i < iv.size(); ++i) {
+            // Compare the last kept interval with i.
+            Interval::IntervalComparison cmp = iv[last].compare(iv[i]);
 
             // This means our sort didn't work.
             verify(Interval::INTERVAL_SUCCEEDS != cmp);
 
             // Intervals are correctly ordered.
             if (Interval::INTERVAL_PRECEDES == cmp) {
-                // We can move to the next pair.
-                ++i;
+                // Keep interval i.
+                ++last;
+                if (last != i) {
+                    iv[last] = iv[i];
+                }
             }
             else if (Interval::INTERVAL_EQUALS == cmp || Interval::INTERVAL_WITHIN == cmp) {
-                // Interval 'i' is equal to i+1, or is contained within i+1.
-                // Remove interval i and don't move to the next value of 'i'.
-                iv.erase(iv.begin() + i);
+                // The last kept interval is equal to i, or is contained within i.  Replace it.
+                iv[last] = iv[i];
             }
             else if (Interval::INTERVAL_CONTAINS == cmp) {
-                // Interval 'i' contains i+1, remove i+1 and don't move to the next value of 'i'.
-                iv.erase(iv.begin() + i + 1);
+                // The last kept interval contains i, drop i.
             }
             else if (Interval::INTERVAL_OVERLAPS_BEFORE == cmp
                      || Interval::INTERVAL_PRECEDES_COULD_UNION == cmp) {
-                // We want to merge intervals i and i+1.
-                // Interval 'i' starts before interval 'i+1'.
+                // We want to merge the last kept interval and i.
+                // The last kept interval starts before interval i.
                 BSONObjBuilder bob;
-                bob.appendAs(iv[i].start, "");
-                bob.appendAs(iv[i + 1].end, "");
+                bob.appendAs(iv[last].start, "");
+                bob.appendAs(iv[i].end, "");
                 BSONObj data = bob.obj();
-                bool startInclusive = iv[i].startInclusive;
-                bool endInclusive = iv[i + 1].endInclusive;
-                iv.erase(iv.begin() + i);
-                // iv[i] is now the former iv[i + 1]
-                iv[i] = makeRangeInterval(data, startInclusive, endInclusive);
-                // Don't increment 'i'.
+                bool startInclusive = iv[last].startInclusive;
+                bool endInclusive = iv[i].endInclusive;
+                iv[last] = makeRangeInterval(data, startInclusive, endInclusive);
             }
         }
+
+        iv.resize(last + 1);
     }
 
     // static
@@ -810,13 +821,14 @@ namespace mongo {
 
     // static
     void IndexBoundsBuilder::translateEquality(const BSONElement& data, bool isHashed,
-                                               OrderedIntervalList* oil, BoundsTightness* tightnessOut) {
+                                               int hashVersion, OrderedIntervalList* oil,
+                                               BoundsTightness* tightnessOut) {
         // We have to copy the data out of the parse tree and stuff it into the index
         // bounds.  BSONValue will be useful here.
         if (Array != data.type()) {
             BSONObj dataObj;
             if (isHashed) {
-                dataObj = ExpressionMapping::hash(data);
+                dataObj = ExpressionMapping::hash(data, hashVersion);
             }
             else {
                 dataObj = objFromElement(data);
@@ -868,7 +880,9 @@ namespace mongo {
             oil->intervals.push_back(makePointInterval(objFromElement(firstEl)));
         }
 
-        std::sort(oil->intervals.begin(), oil->intervals.end(), IntervalComparison);
+        // Only the two intervals added above need ordering.  Callers building a list from many
+        // equalities (e.g. $in) unionize() it afterwards, which sorts the whole list once.
+        std::sort(oil->intervals.end() - 2, oil->intervals.end(), IntervalComparison);
         *tightnessOut = IndexBoundsBuilder::INEXACT_FETCH;
     }
 
@@ -456,6 +456,31 @@ namespace {
         ASSERT_EQUALS(tightness, IndexBoundsBuilder::INEXACT_FETCH);
     }
 
+    TEST(IndexBoundsBuilderTest, TranslateInManyArrays) {
+        IndexEntry testIndex = IndexEntry(BSONObj());
+        BSONObj obj = fromjson("{a: {$in: [[3], 2, [1], [2, 5], 1]}}");
+        auto_ptr<MatchExpression> expr(parseMatchExpression(obj));
+        BSONElement elt = obj.firstElement();
+        OrderedIntervalList oil;
+        IndexBoundsBuilder::BoundsTightness tightness;
+        IndexBoundsBuilder::translate(expr.get(), elt, testIndex, &oil, &tightness);
+        ASSERT_EQUALS(oil.name, "a");
+        ASSERT_EQUALS(oil.intervals.size(), 6U);
+        ASSERT_EQUALS(Interval::INTERVAL_EQUALS, oil.intervals[0].compare(
+            Interval(fromjson("{'': 1, '': 1}"), true, true)));
+        ASSERT_EQUALS(Interval::INTERVAL_EQUALS, oil.intervals[1].compare(
+            Interval(fromjson("{'': 2, '': 2}"), true, true)));
+        ASSERT_EQUALS(Interval::INTERVAL_EQUALS, oil.intervals[2].compare(
+            Interval(fromjson("{'': 3, '': 3}"), true, true)));
+        ASSERT_EQUALS(Interval::INTERVAL_EQUALS, oil.intervals[3].compare(
+            Interval(fromjson("{'': [1], '': [1]}"), true, true)));
+        ASSERT_EQUALS(Interval::INTERVAL_EQUALS, oil.intervals[4].compare(
+            Interval(fromjson("{'': [2, 5], '': [2, 5]}"), true, true)));
+        ASSERT_EQUALS(Interval::INTERVAL_EQUALS, oil.intervals[5].compare(
+            Interval(fromjson("{'': [3], '': [3]}"), true, true)));
+        ASSERT_EQUALS(tightness, IndexBoundsBuilder::INEXACT_FETCH);
+    }
+
     //
     // $exists tests
     //
@@ -546,6 +571,21 @@ namespace {
         ASSERT_EQUALS(tightness, IndexBoundsBuilder::EXACT);
     }
 
+    TEST(IndexBoundsBuilderTest, UnionUnsortedOverlapping) {
+        OrderedIntervalList oil;
+        oil.intervals.push_back(Interval(fromjson("{'': 7, '': 9}"), true, true));
+        oil.intervals.push_back(Interval(fromjson("{'': 1, '': 3}"), true, false));
+        oil.intervals.push_back(Interval(fromjson("{'': 2, '': 2}"), true, true));
+        oil.intervals.push_back(Interval(fromjson("{'': 3, '': 5}"), true, true));
+        oil.intervals.push_back(Interval(fromjson("{'': 8, '': 8}"), true, true));
+        IndexBoundsBuilder::unionize(&oil);
+        ASSERT_EQUALS(oil.intervals.size(), 2U);
+        ASSERT_EQUALS(Interval::INTERVAL_EQUALS, oil.intervals[0].compare(
+            Interval(fromjson("{'': 1, '': 5}"), true, true)));
+        ASSERT_EQUALS(Interval::INTERVAL_EQUALS, oil.intervals[1].compare(
+            Interval(fromjson("{'': 7, '': 9}"), true, true)));
+    }
+
     TEST(IndexBoundsBuilderTest, UnionGtLt) {
         IndexEntry testIndex = IndexEntry(BSONObj());
         vector<BSONObj> toUnion;
@@ -30,6 +30,7 @@
 
 #include <string>
 
+#include "mongo/db/index/multikey_paths.h"
 #include "mongo/db/index_names.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/util/mongoutils/str.h"
@@ -53,7 +54,8 @@ namespace mongo {
               multikey(mk),
               sparse(sp),
               name(n),
-              infoObj(io) {
+              infoObj(io),
+              numLeadingValues(-1) {
 
             type = IndexNames::nameToType(accessMethod);
         }
@@ -70,7 +72,8 @@ namespace mongo {
               multikey(mk),
               sparse(sp),
               name(n),
-              infoObj(io) {
+              infoObj(io),
+              numLeadingValues(-1) {
 
             type = IndexNames::nameToType(IndexNames::findPluginName(keyPattern));
         }     
@@ -83,7 +86,8 @@ namespace mongo {
               multikey(false),
               sparse(false),
               name("test_foo"),
-              infoObj(BSONObj()) {
+              infoObj(BSONObj()),
+              numLeadingValues(-1) {
 
             type = IndexNames::nameToType(IndexNames::findPluginName(keyPattern));
         }     
@@ -92,6 +96,9 @@ namespace mongo {
 
         bool multikey;
 
+        // Which fields of a multikey index are multikey. If empty, all of them are.
+        MultikeyPaths multikeyPaths;
+
         bool sparse;
 
         std::string name;
@@ -103,12 +110,31 @@ namespace mongo {
         // by the keyPattern?)
         IndexType type;
 
+        // How many distinct values we think the first field of the keys has, or -1 if we don't
+        // know.  Skip scans are only worth it over indexes with few of them.
+        long long numLeadingValues;
+
+        /**
+         * Returns true if the field at position 'pos' of the key pattern may be multikey, in
+         * which case bounds on it can't be intersected.
+         */
+        bool isMultikeyAt(size_t pos) const {
+            return multikey && (multikeyPaths.empty() || multikeyPaths[pos]);
+        }
+
         std::string toString() const {
             mongoutils::str::stream ss;
             ss << "kp: "  << keyPattern.toString();
 
             if (multikey) {
                 ss << " multikey";
+                if (!multikeyPaths.empty()) {
+                    ss << " multikeyPaths: [";
+                    for (size_t i = 0; i < multikeyPaths.size(); ++i) {
+                        ss << (i ? ", " : "") << (multikeyPaths[i] ? "true" : "false");
+                    }
+                    ss << "]";
+                }
             }
 
             if (sparse) {
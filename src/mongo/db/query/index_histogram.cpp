@@ -0,0 +1,335 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/query/query_solution.h"
+
+namespace mongo {
+
+    using boost::shared_ptr;
+    using std::vector;
+
+    namespace {
+
+        bool elementLessThan(const BSONObj& lhs, const BSONObj& rhs) {
+            return lhs.firstElement().woCompare(rhs.firstElement(), false) < 0;
+        }
+
+        int compareValues(const BSONObj& lhs, const BSONElement& rhs) {
+            return lhs.firstElement().woCompare(rhs, false);
+        }
+
+        bool isNumeric(const BSONElement& e) {
+            return e.isNumber() && !std::isnan(e.numberDouble()) && !std::isinf(e.numberDouble());
+        }
+
+    }  // namespace
+
+    //
+    // IndexHistogram
+    //
+
+    IndexHistogram::IndexHistogram(const vector<BSONObj>& sample,
+                                   long long numKeys,
+                                   size_t numBuckets,
+                                   long long writeOps)
+        : _numKeys(numKeys),
+          _writeOps(writeOps) {
+
+        if (sample.empty() || 0 == numBuckets) {
+            return;
+        }
+
+        vector<BSONObj> sorted(sample);
+        std::stable_sort(sorted.begin(), sorted.end(), elementLessThan);
+
+        const size_t sampleSize = sorted.size();
+        const size_t n = std::min(numBuckets, sampleSize);
+
+        // Each key sampled stands for this many keys of the index.
+        const double scale = static_cast<double>(numKeys) / sampleSize;
+
+        for (size_t i = 0; i < n; ++i) {
+            const size_t begin = i * sampleSize / n;
+            const size_t end = (i + 1) * sampleSize / n;
+
+            // Count the values sampled once, to estimate how many distinct values there are in
+            // the whole bucket with the GEE estimator: sqrt(scale) * f1 + (distinct - f1).
+            size_t distinct = 0;
+            size_t seenOnce = 0;
+            size_t run = 0;
+            for (size_t j = begin; j < end; ++j) {
+                ++run;
+                if (j + 1 == end || elementLessThan(sorted[j], sorted[j + 1])) {
+                    ++distinct;
+                    if (1 == run) {
+                        ++seenOnce;
+                    }
+                    run = 0;
+                }
+            }
+
+            Bucket bucket;
+            bucket.lower = sorted[begin].getOwned();
+            bucket.upper = sorted[end - 1].getOwned();
+            bucket.numKeys = scale * (end - begin);
+            bucket.numDistinct = std::max(1.0, std::sqrt(std::max(scale, 1.0)) * seenOnce
+                                               + (distinct - seenOnce));
+            _buckets.push_back(bucket);
+        }
+    }
+
+    double IndexHistogram::estimateDistinct() const {
+        double total = 0;
+        for (size_t i = 0; i < _buckets.size(); ++i) {
+            total += _buckets[i].numDistinct;
+        }
+        return total;
+    }
+
+    double IndexHistogram::estimateKeys(const OrderedIntervalList& oil) const {
+        double total = 0;
+        for (size_t i = 0; i < oil.intervals.size(); ++i) {
+            const Interval& interval = oil.intervals[i];
+            total += estimateKeys(interval.start, interval.startInclusive,
+                                  interval.end, interval.endInclusive);
+        }
+        return std::min(total, static_cast<double>(_numKeys));
+    }
+
+    double IndexHistogram::estimateKeys(const BSONElement& startArg, bool startInclusiveArg,
+                                        const BSONElement& endArg, bool endInclusiveArg) const {
+        // Intervals over descending fields go from high to low.
+        const bool reversed = startArg.woCompare(endArg, false) > 0;
+        const BSONElement& start = reversed ? endArg : startArg;
+        const BSONElement& end = reversed ? startArg : endArg;
+        const bool startInclusive = reversed ? endInclusiveArg : startInclusiveArg;
+        const bool endInclusive = reversed ? startInclusiveArg : endInclusiveArg;
+        const bool isPoint = 0 == start.woCompare(end, false);
+
+        double total = 0;
+        for (size_t i = 0; i < _buckets.size(); ++i) {
+            const Bucket& bucket = _buckets[i];
+
+            const int upperVsStart = compareValues(bucket.upper, start);
+            const int lowerVsEnd = compareValues(bucket.lower, end);
+            if (upperVsStart < 0 || (0 == upperVsStart && !startInclusive) ||
+                lowerVsEnd > 0 || (0 == lowerVsEnd && !endInclusive)) {
+                // The bucket is outside the interval.
+                continue;
+            }
+
+            const int lowerVsStart = compareValues(bucket.lower, start);
+            const int upperVsEnd = compareValues(bucket.upper, end);
+            if ((lowerVsStart > 0 || (0 == lowerVsStart && startInclusive)) &&
+                (upperVsEnd < 0 || (0 == upperVsEnd && endInclusive))) {
+                // The bucket is inside the interval.
+                total += bucket.numKeys;
+                continue;
+            }
+
+            if (isPoint) {
+                total += bucket.numKeys / bucket.numDistinct;
+                continue;
+            }
+
+            // The interval covers part of the bucket. Guess how much of it, if we can.
+            const BSONElement lower = bucket.lower.firstElement();
+            const BSONElement upper = bucket.upper.firstElement();
+            double fraction = 0.5;
+            if (isNumeric(lower) && isNumeric(upper) && isNumeric(start) && isNumeric(end)) {
+                const double from = std::max(lower.numberDouble(), start.numberDouble());
+                const double to = std::min(upper.numberDouble(), end.numberDouble());
+                const double width = upper.numberDouble() - lower.numberDouble();
+                if (width > 0) {
+                    fraction = std::max(0.0, std::min(1.0, (to - from) / width));
+                }
+            }
+            total += std::max(fraction * bucket.numKeys, bucket.numKeys / bucket.numDistinct);
+        }
+
+        return total;
+    }
+
+    void IndexHistogram::toBSON(BSONObjBuilder* builder) const {
+        builder->appendNumber("numKeys", _numKeys);
+        BSONArrayBuilder bucketsBuilder(builder->subarrayStart("buckets"));
+        for (size_t i = 0; i < _buckets.size(); ++i) {
+            const Bucket& bucket = _buckets[i];
+            BSONObjBuilder bucketBuilder(bucketsBuilder.subobjStart());
+            bucketBuilder.appendAs(bucket.lower.firstElement(), "lower");
+            bucketBuilder.appendAs(bucket.upper.firstElement(), "upper");
+            bucketBuilder.append("numKeys", bucket.numKeys);
+            bucketBuilder.append("numDistinct", bucket.numDistinct);
+            bucketBuilder.doneFast();
+        }
+        bucketsBuilder.doneFast();
+    }
+
+    //
+    // IndexStatistics
+    //
+
+    IndexStatistics::IndexStatistics() : _writeOps(0) { }
+
+    shared_ptr<const IndexHistogram> IndexStatistics::get(const BSONObj& keyPattern) const {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        HistogramMap::const_iterator it = _histograms.find(keyPattern);
+        if (it == _histograms.end() || isStale(*it->second)) {
+            return shared_ptr<const IndexHistogram>();
+        }
+        return it->second;
+    }
+
+    void IndexStatistics::set(const BSONObj& keyPattern,
+                              const shared_ptr<const IndexHistogram>& hist) {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        _histograms[keyPattern.getOwned()] = hist;
+    }
+
+    void IndexStatistics::clear() {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        _histograms.clear();
+    }
+
+    void IndexStatistics::notifyOfWriteOp() {
+        _writeOps.fetchAndAdd(1);
+    }
+
+    long long IndexStatistics::writeOps() const {
+        return _writeOps.load();
+    }
+
+    bool IndexStatistics::isStale(const IndexHistogram& hist) const {
+        const double writesSince = static_cast<double>(_writeOps.load() - hist.writeOps());
+        return writesSince > internalQueryHistogramMaxWriteFraction * hist.numKeys();
+    }
+
+    bool IndexStatistics::estimateKeysExamined(const QuerySolutionNode* node,
+                                               double* out) const {
+        switch (node->getType()) {
+        case STAGE_IXSCAN: {
+            const IndexScanNode* ixn = static_cast<const IndexScanNode*>(node);
+            shared_ptr<const IndexHistogram> hist = get(ixn->indexKeyPattern);
+            if (!hist) {
+                return false;
+            }
+
+            if (ixn->bounds.isSimpleRange) {
+                *out = hist->estimateKeys(ixn->bounds.startKey.firstElement(), true,
+                                          ixn->bounds.endKey.firstElement(), true);
+                return true;
+            }
+
+            if (ixn->bounds.fields.empty()) {
+                return false;
+            }
+            *out = hist->estimateKeys(ixn->bounds.fields[0]);
+            return true;
+        }
+        case STAGE_AND_HASH:
+        case STAGE_AND_SORTED:
+        case STAGE_OR:
+        case STAGE_SORT_MERGE: {
+            // Every child is scanned, possibly to the end.
+            double total = 0;
+            for (size_t i = 0; i < node->children.size(); ++i) {
+                double childKeys;
+                if (!estimateKeysExamined(node->children[i], &childKeys)) {
+                    return false;
+                }
+                total += childKeys;
+            }
+            *out = total;
+            return true;
+        }
+        case STAGE_FETCH:
+        case STAGE_SORT:
+        case STAGE_PROJECTION:
+        case STAGE_LIMIT:
+        case STAGE_SKIP:
+        case STAGE_KEEP_MUTATIONS:
+        case STAGE_SHARDING_FILTER:
+            if (1 != node->children.size()) {
+                return false;
+            }
+            return estimateKeysExamined(node->children[0], out);
+        default:
+            return false;
+        }
+    }
+
+    size_t IndexStatistics::pruneSolutions(vector<QuerySolution*>* solutions) const {
+        if (internalQueryHistogramPruneRatio <= 0 || solutions->size() < 2) {
+            return 0;
+        }
+
+        vector<double> estimates(solutions->size(), -1);
+        double best = -1;
+        for (size_t i = 0; i < solutions->size(); ++i) {
+            double keys;
+            if (NULL != (*solutions)[i]->root.get() &&
+                estimateKeysExamined((*solutions)[i]->root.get(), &keys)) {
+                estimates[i] = keys;
+                if (best < 0 || keys < best) {
+                    best = keys;
+                }
+            }
+        }
+
+        if (best < 0) {
+            return 0;
+        }
+
+        const double threshold = std::max(internalQueryHistogramPruneRatio * best,
+                                          static_cast<double>(internalQueryHistogramPruneMinKeys));
+
+        size_t numPruned = 0;
+        vector<QuerySolution*> kept;
+        for (size_t i = 0; i < solutions->size(); ++i) {
+            if (estimates[i] > threshold) {
+                delete (*solutions)[i];
+                ++numPruned;
+            }
+            else {
+                kept.push_back((*solutions)[i]);
+            }
+        }
+        solutions->swap(kept);
+        return numPruned;
+    }
+
+}  // namespace mongo
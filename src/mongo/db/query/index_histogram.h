@@ -0,0 +1,178 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    class QuerySolution;
+    class QuerySolutionNode;
+
+    /**
+     * An equi-depth histogram of the values of the first field of an index's keys, built from a
+     * sample of the keys. Each bucket holds about as many keys as the others, so frequent values
+     * get buckets of their own and rare ones share.
+     *
+     * Immutable once built.
+     */
+    class IndexHistogram {
+        MONGO_DISALLOW_COPYING(IndexHistogram);
+    public:
+        /**
+         * Builds a histogram with at most 'numBuckets' buckets for an index with 'numKeys' keys,
+         * from 'sample', the first fields of some of its keys, sorted by the index order.
+         * 'writeOps' is the IndexStatistics::writeOps() when the sample was taken.
+         */
+        IndexHistogram(const std::vector<BSONObj>& sample,
+                       long long numKeys,
+                       size_t numBuckets,
+                       long long writeOps);
+
+        /**
+         * Returns how many keys we think have a first field within 'oil'.
+         */
+        double estimateKeys(const OrderedIntervalList& oil) const;
+
+        /**
+         * Returns how many keys we think have a first field within the interval.
+         */
+        double estimateKeys(const BSONElement& start, bool startInclusive,
+                            const BSONElement& end, bool endInclusive) const;
+
+        /**
+         * Returns how many distinct first fields we think the keys have.
+         */
+        double estimateDistinct() const;
+
+        long long numKeys() const { return _numKeys; }
+
+        long long writeOps() const { return _writeOps; }
+
+        size_t numBuckets() const { return _buckets.size(); }
+
+        /**
+         * Appends a description of the buckets to 'builder', for commands.
+         */
+        void toBSON(BSONObjBuilder* builder) const;
+
+    private:
+        struct Bucket {
+            // The smallest and largest values sampled in the bucket, as single field objects.
+            BSONObj lower;
+            BSONObj upper;
+
+            // How many keys we think are in the bucket, and how many distinct values.
+            double numKeys;
+            double numDistinct;
+        };
+
+        std::vector<Bucket> _buckets;
+        long long _numKeys;
+        long long _writeOps;
+    };
+
+    /**
+     * The histograms of the indexes of a collection, by key pattern, for the planner to prune
+     * candidate plans with before ranking them. Histograms are built on demand, by the
+     * buildIndexHistograms command, and are ignored once enough writes have gone by to make
+     * them stale.
+     *
+     * Thread safe.
+     */
+    class IndexStatistics {
+        MONGO_DISALLOW_COPYING(IndexStatistics);
+    public:
+        IndexStatistics();
+
+        /**
+         * Returns the histogram of the index with 'keyPattern', or NULL if there is none or it
+         * is stale.
+         */
+        boost::shared_ptr<const IndexHistogram> get(const BSONObj& keyPattern) const;
+
+        /**
+         * Sets the histogram of the index with 'keyPattern'.
+         */
+        void set(const BSONObj& keyPattern, const boost::shared_ptr<const IndexHistogram>& hist);
+
+        /**
+         * Forgets all histograms. Called when the indexes of the collection change.
+         */
+        void clear();
+
+        /**
+         * Counts a write to the collection. Histograms go stale as writes pile up.
+         */
+        void notifyOfWriteOp();
+
+        /**
+         * How many writes we were told about so far.
+         */
+        long long writeOps() const;
+
+        /**
+         * Puts in 'out' how many index keys we think the plan rooted at 'node' examines, and
+         * returns true. Returns false if some index it scans has no histogram, or if it does
+         * something we can't tell the cost of, like a collection scan.
+         */
+        bool estimateKeysExamined(const QuerySolutionNode* node, double* out) const;
+
+        /**
+         * Deletes the solutions estimated to examine more than 'internalQueryHistogramPruneRatio'
+         * times the keys of the best estimated solution, unless they examine fewer than
+         * 'internalQueryHistogramPruneMinKeys'. Solutions we can't estimate, and at least one
+         * solution, are kept. Returns how many solutions were deleted.
+         */
+        size_t pruneSolutions(std::vector<QuerySolution*>* solutions) const;
+
+    private:
+        typedef std::map<BSONObj,
+                         boost::shared_ptr<const IndexHistogram>,
+                         BSONObjCmp> HistogramMap;
+
+        bool isStale(const IndexHistogram& hist) const;
+
+        // Protects '_histograms'.
+        mutable boost::mutex _mutex;
+
+        HistogramMap _histograms;
+
+        AtomicInt64 _writeOps;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,284 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/query/index_histogram.h
+ */
+
+#include "mongo/db/query/index_histogram.h"
+
+#include <vector>
+
+#include "mongo/db/json.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    using boost::scoped_ptr;
+    using boost::shared_ptr;
+    using std::vector;
+
+    /**
+     * Makes a sample with each value in ['from', 'to') once.
+     */
+    vector<BSONObj> makeSample(int from, int to) {
+        vector<BSONObj> sample;
+        for (int i = from; i < to; ++i) {
+            sample.push_back(BSON("" << i));
+        }
+        return sample;
+    }
+
+    Interval makeInterval(int start, bool startInclusive, int end, bool endInclusive) {
+        BSONObj obj = BSON("" << start << "" << end);
+        return Interval(obj, startInclusive, endInclusive);
+    }
+
+    double estimate(const IndexHistogram& hist, int start, bool startInclusive,
+                    int end, bool endInclusive) {
+        OrderedIntervalList oil("a");
+        oil.intervals.push_back(makeInterval(start, startInclusive, end, endInclusive));
+        return hist.estimateKeys(oil);
+    }
+
+    IndexScanNode* makeScan(const BSONObj& keyPattern, const Interval& interval) {
+        IndexScanNode* ixn = new IndexScanNode();
+        ixn->indexKeyPattern = keyPattern;
+        OrderedIntervalList oil(keyPattern.firstElementFieldName());
+        oil.intervals.push_back(interval);
+        ixn->bounds.fields.push_back(oil);
+        return ixn;
+    }
+
+    QuerySolution* makeScanSolution(const BSONObj& keyPattern, const Interval& interval) {
+        QuerySolution* soln = new QuerySolution();
+        soln->root.reset(makeScan(keyPattern, interval));
+        return soln;
+    }
+
+    TEST(IndexHistogramTest, EmptySample) {
+        IndexHistogram hist(vector<BSONObj>(), 0, 10, 0);
+        ASSERT_EQUALS(0U, hist.numBuckets());
+        ASSERT_EQUALS(0, estimate(hist, 0, true, 10, true));
+    }
+
+    TEST(IndexHistogramTest, UniformRange) {
+        IndexHistogram hist(makeSample(0, 10000), 10000, 100, 0);
+        ASSERT_EQUALS(100U, hist.numBuckets());
+        ASSERT_EQUALS(10000, hist.numKeys());
+
+        double keys = estimate(hist, 0, true, 999, true);
+        ASSERT_GREATER_THAN_OR_EQUALS(keys, 900);
+        ASSERT_LESS_THAN_OR_EQUALS(keys, 1100);
+
+        // A range in the middle of buckets.
+        keys = estimate(hist, 4050, true, 6050, false);
+        ASSERT_GREATER_THAN_OR_EQUALS(keys, 1800);
+        ASSERT_LESS_THAN_OR_EQUALS(keys, 2200);
+
+        // Descending bounds are the same range.
+        ASSERT_EQUALS(estimate(hist, 0, true, 999, true), estimate(hist, 999, true, 0, true));
+
+        // Everything.
+        ASSERT_EQUALS(10000, estimate(hist, -1, true, 20000, true));
+
+        // Nothing.
+        ASSERT_EQUALS(0, estimate(hist, 20000, true, 30000, true));
+    }
+
+    TEST(IndexHistogramTest, UniformPoint) {
+        IndexHistogram hist(makeSample(0, 10000), 10000, 100, 0);
+        double keys = estimate(hist, 5000, true, 5000, true);
+        ASSERT_GREATER_THAN_OR_EQUALS(keys, 0.5);
+        ASSERT_LESS_THAN_OR_EQUALS(keys, 10);
+    }
+
+    TEST(IndexHistogramTest, ScaledSample) {
+        // A tenth of the keys were sampled.
+        IndexHistogram hist(makeSample(0, 1000), 10000, 10, 0);
+        double keys = estimate(hist, 0, true, 499, true);
+        ASSERT_GREATER_THAN_OR_EQUALS(keys, 4500);
+        ASSERT_LESS_THAN_OR_EQUALS(keys, 5500);
+    }
+
+    TEST(IndexHistogramTest, FrequentValue) {
+        vector<BSONObj> sample = makeSample(0, 5000);
+        for (int i = 0; i < 5000; ++i) {
+            sample.push_back(BSON("" << 7));
+        }
+        IndexHistogram hist(sample, 10000, 100, 0);
+
+        double keys = estimate(hist, 7, true, 7, true);
+        ASSERT_GREATER_THAN_OR_EQUALS(keys, 4500);
+        ASSERT_LESS_THAN_OR_EQUALS(keys, 5500);
+
+        keys = estimate(hist, 3000, true, 3000, true);
+        ASSERT_LESS_THAN_OR_EQUALS(keys, 10);
+    }
+
+    TEST(IndexHistogramTest, ExclusiveBounds) {
+        vector<BSONObj> sample = makeSample(0, 100);
+        for (int i = 0; i < 1000; ++i) {
+            sample.push_back(BSON("" << 100));
+        }
+        IndexHistogram hist(sample, 1100, 20, 0);
+
+        // Leaving out the frequent value leaves out its buckets.
+        ASSERT_GREATER_THAN_OR_EQUALS(estimate(hist, 0, true, 100, true), 1000);
+        ASSERT_LESS_THAN_OR_EQUALS(estimate(hist, 0, true, 100, false), 200);
+        ASSERT_LESS_THAN_OR_EQUALS(estimate(hist, 100, false, 200, true), 100);
+    }
+
+    TEST(IndexHistogramTest, ToBSON) {
+        IndexHistogram hist(makeSample(0, 100), 100, 4, 0);
+        BSONObjBuilder bob;
+        hist.toBSON(&bob);
+        BSONObj obj = bob.obj();
+        ASSERT_EQUALS(100, obj["numKeys"].numberLong());
+
+        vector<BSONElement> buckets = obj["buckets"].Array();
+        ASSERT_EQUALS(4U, buckets.size());
+        ASSERT_EQUALS(0, buckets[0].Obj()["lower"].numberInt());
+        ASSERT_EQUALS(24, buckets[0].Obj()["upper"].numberInt());
+        ASSERT_EQUALS(99, buckets[3].Obj()["upper"].numberInt());
+        ASSERT_EQUALS(25, buckets[3].Obj()["numKeys"].numberDouble());
+    }
+
+    TEST(IndexStatisticsTest, GetSetClear) {
+        IndexStatistics stats;
+        ASSERT(NULL == stats.get(fromjson("{a: 1}")).get());
+
+        shared_ptr<const IndexHistogram> hist(new IndexHistogram(makeSample(0, 100), 100, 10, 0));
+        stats.set(fromjson("{a: 1}"), hist);
+        ASSERT(hist == stats.get(fromjson("{a: 1}")));
+        ASSERT(NULL == stats.get(fromjson("{a: -1}")).get());
+
+        stats.clear();
+        ASSERT(NULL == stats.get(fromjson("{a: 1}")).get());
+    }
+
+    TEST(IndexStatisticsTest, StaleAfterWrites) {
+        IndexStatistics stats;
+        for (int i = 0; i < 5; ++i) {
+            stats.notifyOfWriteOp();
+        }
+        ASSERT_EQUALS(5, stats.writeOps());
+
+        shared_ptr<const IndexHistogram> hist(
+            new IndexHistogram(makeSample(0, 100), 100, 10, stats.writeOps()));
+        stats.set(fromjson("{a: 1}"), hist);
+
+        // A fifth of the keys may be written before the histogram goes stale.
+        for (int i = 0; i < 20; ++i) {
+            stats.notifyOfWriteOp();
+        }
+        ASSERT(hist == stats.get(fromjson("{a: 1}")));
+
+        stats.notifyOfWriteOp();
+        ASSERT(NULL == stats.get(fromjson("{a: 1}")).get());
+    }
+
+    TEST(IndexStatisticsTest, EstimateKeysExamined) {
+        IndexStatistics stats;
+        shared_ptr<const IndexHistogram> hist(
+            new IndexHistogram(makeSample(0, 10000), 10000, 100, 0));
+        stats.set(fromjson("{a: 1}"), hist);
+
+        scoped_ptr<QuerySolution> soln(makeScanSolution(fromjson("{a: 1}"),
+                                                        makeInterval(0, true, 999, true)));
+        double keys;
+        ASSERT(stats.estimateKeysExamined(soln->root.get(), &keys));
+        ASSERT_GREATER_THAN_OR_EQUALS(keys, 900);
+        ASSERT_LESS_THAN_OR_EQUALS(keys, 1100);
+
+        // A fetch costs what its child does.
+        FetchNode fetch;
+        fetch.children.push_back(makeScan(fromjson("{a: 1}"), makeInterval(0, true, 999, true)));
+        double fetchKeys;
+        ASSERT(stats.estimateKeysExamined(&fetch, &fetchKeys));
+        ASSERT_EQUALS(keys, fetchKeys);
+
+        // No histogram, no estimate.
+        scoped_ptr<QuerySolution> other(makeScanSolution(fromjson("{b: 1}"),
+                                                         makeInterval(0, true, 999, true)));
+        ASSERT_FALSE(stats.estimateKeysExamined(other->root.get(), &keys));
+
+        // Neither for a collection scan.
+        CollectionScanNode csn;
+        ASSERT_FALSE(stats.estimateKeysExamined(&csn, &keys));
+    }
+
+    TEST(IndexStatisticsTest, PruneSolutions) {
+        IndexStatistics stats;
+        stats.set(fromjson("{a: 1}"), shared_ptr<const IndexHistogram>(
+            new IndexHistogram(makeSample(0, 10000), 1000000, 100, 0)));
+        stats.set(fromjson("{b: 1}"), shared_ptr<const IndexHistogram>(
+            new IndexHistogram(makeSample(0, 10000), 1000000, 100, 0)));
+
+        vector<QuerySolution*> solutions;
+        solutions.push_back(makeScanSolution(fromjson("{a: 1}"),
+                                             makeInterval(0, true, 9999, true)));
+        solutions.push_back(makeScanSolution(fromjson("{b: 1}"),
+                                             makeInterval(5, true, 5, true)));
+        solutions.push_back(makeScanSolution(fromjson("{c: 1}"),
+                                             makeInterval(0, true, 9999, true)));
+
+        // The scan of all of 'a' goes, the scan of 'c', which has no histogram, stays.
+        ASSERT_EQUALS(1U, stats.pruneSolutions(&solutions));
+        ASSERT_EQUALS(2U, solutions.size());
+        const IndexScanNode* first = static_cast<const IndexScanNode*>(solutions[0]->root.get());
+        ASSERT_EQUALS(fromjson("{b: 1}"), first->indexKeyPattern);
+
+        for (size_t i = 0; i < solutions.size(); ++i) {
+            delete solutions[i];
+        }
+    }
+
+    TEST(IndexStatisticsTest, PruneKeepsCheapSolutions) {
+        IndexStatistics stats;
+        stats.set(fromjson("{a: 1}"), shared_ptr<const IndexHistogram>(
+            new IndexHistogram(makeSample(0, 1000), 1000, 100, 0)));
+
+        // Both plans examine fewer keys than internalQueryHistogramPruneMinKeys.
+        vector<QuerySolution*> solutions;
+        solutions.push_back(makeScanSolution(fromjson("{a: 1}"),
+                                             makeInterval(0, true, 999, true)));
+        solutions.push_back(makeScanSolution(fromjson("{a: 1}"),
+                                             makeInterval(5, true, 5, true)));
+        ASSERT_EQUALS(0U, stats.pruneSolutions(&solutions));
+        ASSERT_EQUALS(2U, solutions.size());
+
+        for (size_t i = 0; i < solutions.size(); ++i) {
+            delete solutions[i];
+        }
+    }
+
+}  // namespace
@@ -434,6 +434,7 @@ namespace mongo {
         this->showDiskLoc = false;
         this->snapshot = false;
         this->hasReadPref = false;
+        this->cacheResults = false;
         this->tailable = false;
         this->slaveOk = false;
         this->oplogReplay = false;
@@ -543,6 +544,14 @@ namespace mongo {
 
                 out->snapshot = el.boolean();
             }
+            else if (mongoutils::str::equals(fieldName, "cacheResults")) {
+                Status status = checkFieldType(el, Bool);
+                if (!status.isOK()) {
+                    return status;
+                }
+
+                out->cacheResults = el.boolean();
+            }
             else if (mongoutils::str::equals(fieldName, "tailable")) {
                 Status status = checkFieldType(el, Bool);
                 if (!status.isOK()) {
@@ -791,6 +800,10 @@ namespace mongo {
                     // Won't throw.
                     _options.maxScan = e.numberInt();
                 }
+                else if (str::equals("cacheResults", name)) {
+                    // Won't throw.
+                    _options.cacheResults = e.trueValue();
+                }
                 else if (str::equals("showDiskLoc", name)) {
                     // Won't throw.
                     if (e.trueValue()) {
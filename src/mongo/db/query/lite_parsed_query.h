@@ -97,6 +97,9 @@ namespace mongo {
             bool snapshot;
             bool hasReadPref;
 
+            // Whether the results may be served from, and stored in, the query result cache.
+            bool cacheResults;
+
             // Options that can be specified in the OP_QUERY 'flags' header.
             bool tailable;
             bool slaveOk;
@@ -0,0 +1,170 @@
+// oplog_read_buffer.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/oplog_read_buffer.h"
+
+#include <boost/thread/locks.hpp>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+
+    // Bytes of oplog batches shared between tailers, in megabytes. 0 turns sharing off.
+    MONGO_EXPORT_SERVER_PARAMETER(oplogReadBufferSizeMB, int, 16);
+
+namespace {
+
+    // Allowance for the batch itself and its namespace.
+    const size_t kBatchOverheadBytes = 128;
+
+    size_t batchBytes(const OplogReadBuffer::Batch& batch) {
+        return batch.size + batch.ns.size() + kBatchOverheadBytes;
+    }
+
+    OplogReadBuffer globalOplogReadBuffer;
+
+} // namespace
+
+    OplogReadBuffer::OplogReadBuffer()
+        : _fixedMaxBytes(0),
+          _bytes(0),
+          _hits(0),
+          _misses(0),
+          _published(0),
+          _evictions(0) {
+    }
+
+    OplogReadBuffer::OplogReadBuffer(size_t maxBytes)
+        : _fixedMaxBytes(maxBytes),
+          _bytes(0),
+          _hits(0),
+          _misses(0),
+          _published(0),
+          _evictions(0) {
+        invariant(maxBytes > 0);
+    }
+
+    // static
+    OplogReadBuffer* OplogReadBuffer::get() {
+        return &globalOplogReadBuffer;
+    }
+
+    bool OplogReadBuffer::lookup(const StringData& ns,
+                                 unsigned long long truncateEpoch,
+                                 const OpTime& after,
+                                 const RecordId& afterLoc,
+                                 int maxResults,
+                                 Batch* out) {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+
+        // Tailers are mostly waiting at the end, so the newest batches are the likeliest.
+        for (BatchList::reverse_iterator it = _batches.rbegin(); it != _batches.rend(); ++it) {
+            if (it->truncateEpoch == truncateEpoch
+                    && it->after == after
+                    && it->afterLoc == afterLoc
+                    && it->ns == ns) {
+                if (maxResults && it->numResults > maxResults) {
+                    break;
+                }
+                ++_hits;
+                *out = *it;
+                return true;
+            }
+        }
+
+        ++_misses;
+        return false;
+    }
+
+    void OplogReadBuffer::publish(const Batch& batch) {
+        invariant(batch.numResults > 0);
+        const size_t maxBytes = _maxBytes();
+        const size_t bytes = batchBytes(batch);
+
+        // A batch taking up more than a quarter of the buffer would push out too much else.
+        if (bytes > maxBytes / 4) {
+            return;
+        }
+
+        boost::lock_guard<boost::mutex> lk(_mutex);
+
+        // Drop the batch this one replaces, which may end sooner, and any read before the oplog
+        // was last truncated, which can never be served again.
+        for (BatchList::iterator it = _batches.begin(); it != _batches.end(); ) {
+            if (it->ns == batch.ns
+                    && (it->truncateEpoch != batch.truncateEpoch
+                        || (it->after == batch.after && it->afterLoc == batch.afterLoc))) {
+                _bytes -= batchBytes(*it);
+                it = _batches.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        _batches.push_back(batch);
+        _bytes += bytes;
+        ++_published;
+
+        while (_bytes > maxBytes) {
+            _bytes -= batchBytes(_batches.front());
+            _batches.pop_front();
+            ++_evictions;
+        }
+    }
+
+    void OplogReadBuffer::clear() {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        _batches.clear();
+        _bytes = 0;
+    }
+
+    void OplogReadBuffer::appendStats(BSONObjBuilder* builder) const {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        builder->appendNumber("hits", _hits);
+        builder->appendNumber("misses", _misses);
+        builder->appendNumber("published", _published);
+        builder->appendNumber("evictions", _evictions);
+        builder->appendNumber("batches", static_cast<long long>(_batches.size()));
+        builder->appendNumber("bytes", static_cast<long long>(_bytes));
+    }
+
+    size_t OplogReadBuffer::_maxBytes() const {
+        if (_fixedMaxBytes) {
+            return _fixedMaxBytes;
+        }
+        const int sizeMB = oplogReadBufferSizeMB;
+        return sizeMB > 0 ? static_cast<size_t>(sizeMB) * 1024 * 1024 : 0;
+    }
+
+}  // namespace mongo
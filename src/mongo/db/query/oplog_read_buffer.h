@@ -0,0 +1,139 @@
+// oplog_read_buffer.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <string>
+
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/optime.h"
+#include "mongo/db/record_id.h"
+#include "mongo/util/shared_buffer.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * The most recent batches of oplog entries sent to tailable cursors that had caught up with
+     * the end of the oplog, kept as the reply-ready documents. When many tailers (secondaries
+     * syncing, change capture consumers) follow the oplog, they all wait at the same entry for
+     * the next writes; the first to wake up reads and publishes the batch, and the rest are sent
+     * the same bytes without running their cursors over it. A tailer for which no batch starts at
+     * its position, such as one lagging behind, reads the oplog as usual.
+     *
+     * A batch is only served while the oplog's truncate epoch (see Collection::getTruncateEpoch)
+     * is the one it was read at, so that entries removed by a rollback are never sent. Batches are
+     * evicted oldest first once the oplogReadBufferSizeMB server parameter is exceeded; 0 turns
+     * the buffer off.
+     */
+    class OplogReadBuffer {
+        MONGO_DISALLOW_COPYING(OplogReadBuffer);
+    public:
+        struct Batch {
+            Batch() : truncateEpoch(0), numResults(0), size(0) { }
+
+            std::string ns;
+            unsigned long long truncateEpoch;
+
+            // The entry before the batch, where a tailer has to be for the batch to be next.
+            OpTime after;
+            RecordId afterLoc;
+
+            // The last entry in the batch, where a tailer continues from.
+            OpTime last;
+            RecordId lastLoc;
+
+            int numResults;
+            SharedBuffer data; // the entries, back to back
+            int size;
+        };
+
+        /**
+         * Sized by the oplogReadBufferSizeMB server parameter.
+         */
+        OplogReadBuffer();
+
+        /**
+         * Holds at most 'maxBytes' bytes, whatever the server parameter says.
+         */
+        explicit OplogReadBuffer(size_t maxBytes);
+
+        /**
+         * The buffer shared by all the oplog tailers of this process.
+         */
+        static OplogReadBuffer* get();
+
+        bool enabled() const { return _maxBytes() > 0; }
+
+        /**
+         * Fills in 'out' and returns true if there is a batch on 'ns', at truncate epoch
+         * 'truncateEpoch', following the entry with timestamp 'after' at 'afterLoc', of at most
+         * 'maxResults' entries unless that is 0.
+         */
+        bool lookup(const StringData& ns,
+                    unsigned long long truncateEpoch,
+                    const OpTime& after,
+                    const RecordId& afterLoc,
+                    int maxResults,
+                    Batch* out);
+
+        /**
+         * Adds 'batch', which must have been read from the entry after 'batch.after' up to the
+         * end of the oplog, replacing any batch following the same entry.
+         */
+        void publish(const Batch& batch);
+
+        void clear();
+
+        void appendStats(BSONObjBuilder* builder) const;
+
+    private:
+        typedef std::deque<Batch> BatchList; // oldest first
+
+        size_t _maxBytes() const;
+
+        const size_t _fixedMaxBytes; // 0 to follow the server parameter
+
+        mutable boost::mutex _mutex;
+        BatchList _batches;
+        size_t _bytes;
+
+        long long _hits;
+        long long _misses;
+        long long _published;
+        long long _evictions;
+    };
+
+}  // namespace mongo
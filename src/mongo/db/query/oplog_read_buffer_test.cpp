@@ -0,0 +1,143 @@
+// oplog_read_buffer_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/query/oplog_read_buffer.h
+ */
+
+#include "mongo/db/query/oplog_read_buffer.h"
+
+#include <cstring>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    static const char* ns = "local.oplog.rs";
+
+    // A batch of 'numResults' entries following the one at 'after', taking 'bytes' bytes.
+    OplogReadBuffer::Batch makeBatch(unsigned after,
+                                     int numResults,
+                                     int bytes,
+                                     unsigned long long truncateEpoch = 1) {
+        OplogReadBuffer::Batch batch;
+        batch.ns = ns;
+        batch.truncateEpoch = truncateEpoch;
+        batch.after = OpTime(after, 0);
+        batch.afterLoc = RecordId(after);
+        batch.last = OpTime(after + numResults, 0);
+        batch.lastLoc = RecordId(after + numResults);
+        batch.numResults = numResults;
+        batch.data = SharedBuffer::allocate(bytes);
+        memset(batch.data.get(), 'x', bytes);
+        batch.size = bytes;
+        return batch;
+    }
+
+    BSONObj getStats(const OplogReadBuffer& buffer) {
+        BSONObjBuilder bob;
+        buffer.appendStats(&bob);
+        return bob.obj();
+    }
+
+    TEST(OplogReadBufferTest, ServesBatchFollowingTheTailersEntry) {
+        OplogReadBuffer buffer(1024 * 1024);
+        OplogReadBuffer::Batch out;
+        ASSERT_FALSE(buffer.lookup(ns, 1, OpTime(10, 0), RecordId(10), 0, &out));
+
+        buffer.publish(makeBatch(10, 3, 100));
+        ASSERT_TRUE(buffer.lookup(ns, 1, OpTime(10, 0), RecordId(10), 0, &out));
+        ASSERT_EQUALS(out.numResults, 3);
+        ASSERT_EQUALS(out.size, 100);
+        ASSERT_EQUALS(out.last, OpTime(13, 0));
+        ASSERT_EQUALS(out.lastLoc, RecordId(13));
+
+        // Not for a tailer asking for fewer entries.
+        ASSERT_FALSE(buffer.lookup(ns, 1, OpTime(10, 0), RecordId(10), 2, &out));
+        ASSERT_TRUE(buffer.lookup(ns, 1, OpTime(10, 0), RecordId(10), 3, &out));
+
+        // Not for a tailer anywhere else, or on another oplog.
+        ASSERT_FALSE(buffer.lookup(ns, 1, OpTime(13, 0), RecordId(13), 0, &out));
+        ASSERT_FALSE(buffer.lookup(ns, 1, OpTime(10, 0), RecordId(11), 0, &out));
+        ASSERT_FALSE(buffer.lookup("local.oplog.$main", 1, OpTime(10, 0), RecordId(10), 0, &out));
+
+        BSONObj stats = getStats(buffer);
+        ASSERT_EQUALS(stats["hits"].numberLong(), 2);
+        ASSERT_EQUALS(stats["misses"].numberLong(), 5);
+        ASSERT_EQUALS(stats["published"].numberLong(), 1);
+    }
+
+    TEST(OplogReadBufferTest, TruncationHidesEarlierBatches) {
+        OplogReadBuffer buffer(1024 * 1024);
+        buffer.publish(makeBatch(10, 3, 100, 1));
+
+        OplogReadBuffer::Batch out;
+        ASSERT_FALSE(buffer.lookup(ns, 2, OpTime(10, 0), RecordId(10), 0, &out));
+
+        // Publishing at the new epoch drops everything read before it.
+        buffer.publish(makeBatch(20, 1, 100, 2));
+        ASSERT_FALSE(buffer.lookup(ns, 1, OpTime(10, 0), RecordId(10), 0, &out));
+        ASSERT_TRUE(buffer.lookup(ns, 2, OpTime(20, 0), RecordId(20), 0, &out));
+        ASSERT_EQUALS(getStats(buffer)["batches"].numberLong(), 1);
+    }
+
+    TEST(OplogReadBufferTest, LaterBatchReplacesOneFollowingTheSameEntry) {
+        OplogReadBuffer buffer(1024 * 1024);
+        buffer.publish(makeBatch(10, 3, 100));
+        buffer.publish(makeBatch(10, 5, 200));
+
+        OplogReadBuffer::Batch out;
+        ASSERT_TRUE(buffer.lookup(ns, 1, OpTime(10, 0), RecordId(10), 0, &out));
+        ASSERT_EQUALS(out.numResults, 5);
+        ASSERT_EQUALS(getStats(buffer)["batches"].numberLong(), 1);
+    }
+
+    TEST(OplogReadBufferTest, EvictsOldestBatchesFirst) {
+        OplogReadBuffer buffer(8192);
+        for (unsigned after = 10; after < 15; after++) {
+            buffer.publish(makeBatch(after, 1, 1800));
+        }
+
+        // Each batch takes 1800 bytes plus overhead, so only four of them fit.
+        OplogReadBuffer::Batch out;
+        ASSERT_FALSE(buffer.lookup(ns, 1, OpTime(10, 0), RecordId(10), 0, &out));
+        ASSERT_TRUE(buffer.lookup(ns, 1, OpTime(11, 0), RecordId(11), 0, &out));
+        ASSERT_TRUE(buffer.lookup(ns, 1, OpTime(14, 0), RecordId(14), 0, &out));
+        ASSERT_EQUALS(getStats(buffer)["evictions"].numberLong(), 1);
+
+        // Too big to be worth keeping.
+        buffer.publish(makeBatch(15, 1, 2500));
+        ASSERT_FALSE(buffer.lookup(ns, 1, OpTime(15, 0), RecordId(15), 0, &out));
+    }
+
+}  // namespace
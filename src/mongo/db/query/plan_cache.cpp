@@ -35,6 +35,7 @@
 #include <algorithm>
 #include <math.h>
 #include <memory>
+#include <boost/functional/hash.hpp>
 #include "boost/thread/locks.hpp"
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/client/dbclientinterface.h"   // For QueryOption_foobar
@@ -109,6 +110,7 @@ namespace mongo {
         : plannerData(entry.plannerData.size()),
           backupSoln(entry.backupSoln),
           key(key),
+          decisionWorks(0),
           query(entry.query.getOwned()),
           sort(entry.sort.getOwned()),
           projection(entry.projection.getOwned()) {
@@ -118,6 +120,10 @@ namespace mongo {
             verify(entry.plannerData[i]);
             plannerData[i] = entry.plannerData[i]->clone();
         }
+
+        if (entry.decision && !entry.decision->stats.empty()) {
+            decisionWorks = entry.decision->stats[0]->common.works;
+        }
     }
 
     CachedSolution::~CachedSolution() {
@@ -280,6 +286,12 @@ namespace mongo {
         case COLLSCAN_SOLN:
             ss << "(collection scan)";
             break;
+        case SKIP_SCAN_SOLN:
+            verify(this->tree.get());
+            ss << "(skip scan solution: "
+               << "tree=" << this->tree->toString()
+               << ")";
+            break;
         case USE_INDEX_TAGS_SOLN:
             verify(this->tree.get());
             ss << "(index-tagged expression tree: "
@@ -289,16 +301,95 @@ namespace mongo {
         return ss;
     }
 
+    //
+    // PlanCacheCandidates
+    //
+
+    PlanCacheCandidates::~PlanCacheCandidates() {
+        for (size_t i = 0; i < plannerData.size(); ++i) {
+            delete plannerData[i];
+        }
+    }
+
+    PlanCacheCandidates* PlanCacheCandidates::clone() const {
+        PlanCacheCandidates* other = new PlanCacheCandidates();
+        for (size_t i = 0; i < plannerData.size(); ++i) {
+            other->plannerData.push_back(plannerData[i]->clone());
+        }
+        other->plannerOptions = plannerOptions;
+        other->indexFilterApplied = indexFilterApplied;
+        return other;
+    }
+
     //
     // PlanCache
     //
 
-    PlanCache::PlanCache() : _cache(internalQueryCacheSize) { }
+    // Enough that hundreds of concurrent queries of different shapes rarely contend, but small
+    // enough that each partition's LRU list still has a useful size. Must be a power of two.
+    const size_t PlanCache::kNumPartitions = 16;
 
-    PlanCache::PlanCache(const std::string& ns) : _cache(internalQueryCacheSize), _ns(ns) { }
+    PlanCache::Partition::~Partition() {
+        PendingFeedback* pending = popAllFeedback();
+        while (pending) {
+            PendingFeedback* next = pending->next;
+            delete pending;
+            pending = next;
+        }
+    }
+
+    void PlanCache::Partition::pushFeedback(PendingFeedback* pending) {
+        uint64_t head = pendingFeedback.load();
+        while (true) {
+            pending->next = reinterpret_cast<PendingFeedback*>(head);
+            const uint64_t old =
+                pendingFeedback.compareAndSwap(head, reinterpret_cast<uintptr_t>(pending));
+            if (old == head) {
+                return;
+            }
+            head = old;
+        }
+    }
+
+    PlanCache::PendingFeedback* PlanCache::Partition::popAllFeedback() {
+        PendingFeedback* pending = reinterpret_cast<PendingFeedback*>(pendingFeedback.swap(0));
+
+        // Reverse the stack, so feedback is applied in the order it was given
+        PendingFeedback* oldestFirst = NULL;
+        while (pending) {
+            PendingFeedback* next = pending->next;
+            pending->next = oldestFirst;
+            oldestFirst = pending;
+            pending = next;
+        }
+
+        return oldestFirst;
+    }
+
+    PlanCache::PlanCache() {
+        _createPartitions();
+    }
+
+    PlanCache::PlanCache(const std::string& ns) : _ns(ns) {
+        _createPartitions();
+    }
 
     PlanCache::~PlanCache() { }
 
+    void PlanCache::_createPartitions() {
+        // The total size is rounded up, so that the cache holds at least as many entries as before
+        // it was partitioned. Eviction is least recently used within each partition.
+        const size_t partitionSize = (internalQueryCacheSize + kNumPartitions - 1) / kNumPartitions;
+        for (size_t i = 0; i < kNumPartitions; i++) {
+            _partitions.mutableVector().push_back(new Partition(partitionSize));
+        }
+    }
+
+    PlanCache::Partition* PlanCache::_getPartition(const PlanCacheKey& key) const {
+        const size_t hash = boost::hash<PlanCacheKey>()(key);
+        return _partitions[hash & (kNumPartitions - 1)];
+    }
+
     Status PlanCache::add(const CanonicalQuery& query,
                           const std::vector<QuerySolution*>& solns,
                           PlanRankingDecision* why) {
@@ -340,8 +431,12 @@ namespace mongo {
             }
         }
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        std::auto_ptr<PlanCacheEntry> evictedEntry = _cache.add(query.getPlanCacheKey(), entry);
+        const PlanCacheKey& key = query.getPlanCacheKey();
+        Partition* partition = _getPartition(key);
+
+        boost::lock_guard<boost::mutex> cacheLock(partition->mutex);
+        _applyPendingFeedback(partition);
+        std::auto_ptr<PlanCacheEntry> evictedEntry = partition->cache.add(key, entry);
 
         if (NULL != evictedEntry.get()) {
             LOG(1) << _ns << ": plan cache maximum size exceeded - "
@@ -356,9 +451,12 @@ namespace mongo {
         const PlanCacheKey& key = query.getPlanCacheKey();
         verify(crOut);
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        Partition* partition = _getPartition(key);
+
+        boost::lock_guard<boost::mutex> cacheLock(partition->mutex);
+        _applyPendingFeedback(partition);
         PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(key, &entry);
+        Status cacheStatus = partition->cache.get(key, &entry);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
@@ -426,10 +524,39 @@ namespace mongo {
         }
         std::auto_ptr<PlanCacheEntryFeedback> autoFeedback(feedback);
         const PlanCacheKey& ck = cq.getPlanCacheKey();
+        Partition* partition = _getPartition(ck);
+
+        boost::unique_lock<boost::mutex> cacheLock(partition->mutex, boost::try_to_lock);
+        if (!cacheLock.owns_lock()) {
+            // Rather than waiting behind the lookups of queries of the same partition, leave the
+            // feedback for the next operation which locks it.
+            partition->pushFeedback(new PendingFeedback(ck, autoFeedback.release()));
+            return Status::OK();
+        }
+
+        _applyPendingFeedback(partition);
+        return _applyFeedback(partition, ck, autoFeedback.release());
+    }
+
+    void PlanCache::_applyPendingFeedback(Partition* partition) const {
+        PendingFeedback* pending = partition->popAllFeedback();
+        while (pending) {
+            // The entry may have been removed since the feedback was given, which is fine
+            _applyFeedback(partition, pending->key, pending->feedback.release());
+
+            PendingFeedback* next = pending->next;
+            delete pending;
+            pending = next;
+        }
+    }
+
+    Status PlanCache::_applyFeedback(Partition* partition,
+                                     const PlanCacheKey& ck,
+                                     PlanCacheEntryFeedback* feedback) const {
+        std::auto_ptr<PlanCacheEntryFeedback> autoFeedback(feedback);
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
         PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(ck, &entry);
+        Status cacheStatus = partition->cache.get(ck, &entry);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
@@ -441,7 +568,7 @@ namespace mongo {
             if (hasCachedPlanPerformanceDegraded(entry, autoFeedback.get())) {
                 LOG(1) << _ns << ": removing plan cache entry " << entry->toString()
                        << " - detected degradation in performance of cached solution.";
-                _cache.remove(ck);
+                partition->cache.remove(ck);
             }
         }
         else {
@@ -452,14 +579,62 @@ namespace mongo {
         return Status::OK();
     }
 
+    void PlanCache::addCandidates(const CanonicalQuery& query, PlanCacheCandidates* candidates) {
+        invariant(candidates);
+        const PlanCacheKey& key = query.getPlanCacheKey();
+        Partition* partition = _getPartition(key);
+
+        boost::lock_guard<boost::mutex> cacheLock(partition->mutex);
+        // An evicted entry is just deleted.
+        partition->candidates.add(key, candidates);
+    }
+
+    Status PlanCache::getCandidates(const CanonicalQuery& query,
+                                    PlanCacheCandidates** candidatesOut) const {
+        const PlanCacheKey& key = query.getPlanCacheKey();
+        verify(candidatesOut);
+
+        Partition* partition = _getPartition(key);
+
+        boost::lock_guard<boost::mutex> cacheLock(partition->mutex);
+        PlanCacheCandidates* candidates;
+        Status cacheStatus = partition->candidates.get(key, &candidates);
+        if (!cacheStatus.isOK()) {
+            return cacheStatus;
+        }
+        invariant(candidates);
+
+        *candidatesOut = candidates->clone();
+
+        return Status::OK();
+    }
+
     Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.remove(canonicalQuery.getPlanCacheKey());
+        const PlanCacheKey& key = canonicalQuery.getPlanCacheKey();
+        Partition* partition = _getPartition(key);
+
+        boost::lock_guard<boost::mutex> cacheLock(partition->mutex);
+        _applyPendingFeedback(partition);
+        // The candidates may have been enumerated under an index filter that no longer applies.
+        partition->candidates.remove(key);
+        return partition->cache.remove(key);
     }
 
     void PlanCache::clear() {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        _cache.clear();
+        _clear(true);
+    }
+
+    void PlanCache::_clear(bool includeCandidates) {
+        for (size_t i = 0; i < _partitions.size(); i++) {
+            Partition* partition = _partitions[i];
+
+            boost::lock_guard<boost::mutex> cacheLock(partition->mutex);
+            _applyPendingFeedback(partition);
+            partition->cache.clear();
+            if (includeCandidates) {
+                partition->candidates.clear();
+            }
+        }
         _writeOperations.store(0);
     }
 
@@ -467,9 +642,12 @@ namespace mongo {
         const PlanCacheKey& key = query.getPlanCacheKey();
         verify(entryOut);
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        Partition* partition = _getPartition(key);
+
+        boost::lock_guard<boost::mutex> cacheLock(partition->mutex);
+        _applyPendingFeedback(partition);
         PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(key, &entry);
+        Status cacheStatus = partition->cache.get(key, &entry);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
@@ -481,25 +659,41 @@ namespace mongo {
     }
 
     std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
         std::vector<PlanCacheEntry*> entries;
         typedef std::list< std::pair<PlanCacheKey, PlanCacheEntry*> >::const_iterator ConstIterator;
-        for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
-            PlanCacheEntry* entry = i->second;
-            entries.push_back(entry->clone());
+        for (size_t p = 0; p < _partitions.size(); p++) {
+            Partition* partition = _partitions[p];
+
+            boost::lock_guard<boost::mutex> cacheLock(partition->mutex);
+            _applyPendingFeedback(partition);
+            for (ConstIterator i = partition->cache.begin(); i != partition->cache.end(); i++) {
+                PlanCacheEntry* entry = i->second;
+                entries.push_back(entry->clone());
+            }
         }
 
         return entries;
     }
 
     bool PlanCache::contains(const CanonicalQuery& cq) const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.hasKey(cq.getPlanCacheKey());
+        const PlanCacheKey& key = cq.getPlanCacheKey();
+        Partition* partition = _getPartition(key);
+
+        boost::lock_guard<boost::mutex> cacheLock(partition->mutex);
+        _applyPendingFeedback(partition);
+        return partition->cache.hasKey(key);
     }
 
     size_t PlanCache::size() const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.size();
+        size_t size = 0;
+        for (size_t i = 0; i < _partitions.size(); i++) {
+            Partition* partition = _partitions[i];
+
+            boost::lock_guard<boost::mutex> cacheLock(partition->mutex);
+            _applyPendingFeedback(partition);
+            size += partition->cache.size();
+        }
+        return size;
     }
 
     void PlanCache::notifyOfWriteOp() {
@@ -512,7 +706,8 @@ namespace mongo {
         LOG(1) << _ns << ": clearing collection plan cache - "
                << internalQueryCacheWriteOpsBetweenFlush
                << " write operations detected since last refresh.";
-        clear();
+        // Writes change which plan is best, but not which plans are possible.
+        _clear(false);
     }
 
 }  // namespace mongo
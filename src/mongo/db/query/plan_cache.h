@@ -33,6 +33,7 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/index_tag.h"
@@ -151,6 +152,11 @@ namespace mongo {
             // The cached plan is a collection scan.
             COLLSCAN_SOLN,
 
+            // Indicates that the plan should skip scan the
+            // index in 'tree', hopping over the values of
+            // its first field.
+            SKIP_SCAN_SOLN,
+
             // Build the solution by using 'tree'
             // to tag the match expression.
             USE_INDEX_TAGS_SOLN
@@ -165,6 +171,31 @@ namespace mongo {
         bool indexFilterApplied;
     };
 
+    /**
+     * Every candidate solution the planner enumerated for a query shape. Later queries of the
+     * shape can rebuild the candidates with their own values from this, instead of enumerating
+     * the index assignments again.
+     *
+     * Which plans are possible doesn't depend on the data, so unlike a PlanCacheEntry these are
+     * kept when the cache is flushed because of writes.
+     */
+    struct PlanCacheCandidates {
+        PlanCacheCandidates() : plannerOptions(0), indexFilterApplied(false) { }
+
+        ~PlanCacheCandidates();
+
+        // Make a deep copy.
+        PlanCacheCandidates* clone() const;
+
+        // Owned here. In the order the planner output them.
+        std::vector<SolutionCacheData*> plannerData;
+
+        // The candidates are only valid for queries planned with the same options and index
+        // filter.
+        size_t plannerOptions;
+        bool indexFilterApplied;
+    };
+
     class PlanCacheEntry;
 
     /**
@@ -187,6 +218,10 @@ namespace mongo {
         // Key used to provide feedback on the entry.
         PlanCacheKey key;
 
+        // How many works the winning plan took during plan ranking, or zero if unknown. A
+        // cached plan which takes many more than this is replanned.
+        size_t decisionWorks;
+
         // For debugging.
         std::string toString() const;
 
@@ -340,13 +375,29 @@ namespace mongo {
         Status feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* feedback);
 
         /**
-         * Remove the entry corresponding to 'ck' from the cache.  Returns Status::OK() if the plan
-         * was present and removed and an error status otherwise.
+         * Remembers the candidate solutions enumerated for 'query', replacing any remembered
+         * before. Takes ownership of 'candidates'.
+         */
+        void addCandidates(const CanonicalQuery& query, PlanCacheCandidates* candidates);
+
+        /**
+         * Look up the candidate solutions remembered for the shape of 'query'.
+         *
+         * If there are none, returns an error Status. Otherwise populates 'candidatesOut' with a
+         * copy, which the caller owns, and returns Status::OK().
+         */
+        Status getCandidates(const CanonicalQuery& query,
+                             PlanCacheCandidates** candidatesOut) const;
+
+        /**
+         * Remove the entry corresponding to 'ck' from the cache, along with the candidates
+         * remembered for it.  Returns Status::OK() if the plan was present and removed and an
+         * error status otherwise.
          */
         Status remove(const CanonicalQuery& canonicalQuery);
 
         /**
-         * Remove *all* entries.
+         * Remove *all* entries and remembered candidates.
          */
         void clear();
 
@@ -371,7 +422,7 @@ namespace mongo {
 
         /**
          * Returns true if there is an entry in the cache for the 'query'.
-         * Internally calls hasKey() on the LRU cache.
+         * Internally calls hasKey() on the LRU cache of the partition for 'query'.
          */
         bool contains(const CanonicalQuery& cq) const;
 
@@ -388,20 +439,83 @@ namespace mongo {
         void notifyOfWriteOp();
 
     private:
+        /**
+         * Feedback which could not be applied right away, because the partition for its entry
+         * was locked.
+         */
+        struct PendingFeedback {
+            PendingFeedback(const PlanCacheKey& key, PlanCacheEntryFeedback* feedback)
+                : key(key), feedback(feedback), next(NULL) { }
+
+            PlanCacheKey key;
+            std::auto_ptr<PlanCacheEntryFeedback> feedback;
+            PendingFeedback* next;
+        };
+
+        /**
+         * The cache is split by the hash of the PlanCacheKey into partitions, each with its own
+         * LRU list and mutex, so that queries of different shapes don't contend with each other.
+         */
+        struct Partition {
+            Partition(size_t maxSize) : cache(maxSize), candidates(maxSize) { }
+            ~Partition();
+
+            /**
+             * Queues 'pending' for whoever next locks this partition. Does not block.
+             */
+            void pushFeedback(PendingFeedback* pending);
+
+            /**
+             * Removes all queued feedback and returns it, oldest first.
+             */
+            PendingFeedback* popAllFeedback();
+
+            LRUKeyValue<PlanCacheKey, PlanCacheEntry> cache;
+
+            LRUKeyValue<PlanCacheKey, PlanCacheCandidates> candidates;
+
+            /**
+             * Protects cache and candidates.
+             */
+            boost::mutex mutex;
+
+            /**
+             * Lock-free stack of PendingFeedback, newest first. The pointer is stored as an
+             * integer, since AtomicWord only supports those.
+             */
+            AtomicUInt64 pendingFeedback;
+        };
+
+        static const size_t kNumPartitions;
+
+        void _createPartitions();
 
         /**
-         * Releases resources associated with each cache entry
-         * and clears map.
-         * Invoked by clear() and during destruction.
+         * Removes all entries, and the remembered candidates too if 'includeCandidates' is true.
          */
-        void _clear();
+        void _clear(bool includeCandidates);
+
+        Partition* _getPartition(const PlanCacheKey& key) const;
 
-        LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
+        /**
+         * Applies the feedback queued for 'partition'. All operations which read entries do this
+         * after locking their partition, so queued feedback is never missed.
+         *
+         * MUST be called with partition->mutex held.
+         */
+        void _applyPendingFeedback(Partition* partition) const;
 
         /**
-         * Protects _cache.
+         * Adds 'feedback' to the entry for 'key', which may get removed as a result. Returns an
+         * error Status if there is no such entry. Takes ownership of 'feedback'.
+         *
+         * MUST be called with partition->mutex held.
          */
-        mutable boost::mutex _cacheMutex;
+        Status _applyFeedback(Partition* partition,
+                              const PlanCacheKey& key,
+                              PlanCacheEntryFeedback* feedback) const;
+
+        OwnedPointerVector<Partition> _partitions;
 
         /**
          * Counter for write notifications since initialization or last clear() invocation.
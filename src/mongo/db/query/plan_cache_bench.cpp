@@ -0,0 +1,132 @@
+// plan_cache_bench.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cache.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <memory>
+
+#include "mongo/db/exec/plan_stats.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+    using boost::scoped_ptr;
+    using std::auto_ptr;
+    using unittest::doNotOptimizeAway;
+
+    const char* kNs = "bench.plancache";
+
+    // Number of distinct query shapes in the cache being looked up in.
+    const int kNumShapes = 100;
+
+    CanonicalQuery* canonicalize(const BSONObj& query) {
+        CanonicalQuery* cq;
+        uassertStatusOK(CanonicalQuery::canonicalize(kNs, query, &cq));
+        return cq;
+    }
+
+    BSONObj makeQuery(int shape) {
+        return BSON(std::string(str::stream() << "f" << shape) << 1 << "x" << BSON("$gt" << 5));
+    }
+
+    PlanRankingDecision* createDecision() {
+        auto_ptr<PlanRankingDecision> why(new PlanRankingDecision());
+        CommonStats common("COLLSCAN");
+        auto_ptr<PlanStageStats> stats(new PlanStageStats(common, STAGE_COLLSCAN));
+        stats->specific.reset(new CollectionScanStats());
+        why->stats.mutableVector().push_back(stats.release());
+        why->scores.push_back(0U);
+        why->candidateOrder.push_back(0);
+        return why.release();
+    }
+
+    /**
+     * Fills 'planCache' with a collection scan for each of kNumShapes shapes.
+     */
+    void populate(PlanCache* planCache) {
+        QuerySolution qs;
+        qs.cacheData.reset(new SolutionCacheData());
+        qs.cacheData->solnType = SolutionCacheData::COLLSCAN_SOLN;
+        qs.cacheData->tree.reset(new PlanCacheIndexTree());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+
+        for (int i = 0; i < kNumShapes; i++) {
+            scoped_ptr<CanonicalQuery> cq(canonicalize(makeQuery(i)));
+            uassertStatusOK(planCache->add(*cq, solns, createDecision()));
+        }
+    }
+
+    BENCHMARK(PlanCache, GetHit) {
+        PlanCache planCache(kNs);
+        populate(&planCache);
+        scoped_ptr<CanonicalQuery> cq(canonicalize(makeQuery(kNumShapes / 2)));
+
+        while (state.keepRunning()) {
+            CachedSolution* cs;
+            doNotOptimizeAway(planCache.get(*cq, &cs));
+            delete cs;
+        }
+    }
+
+    BENCHMARK(PlanCache, ContainsMiss) {
+        PlanCache planCache(kNs);
+        populate(&planCache);
+        scoped_ptr<CanonicalQuery> cq(canonicalize(makeQuery(kNumShapes)));
+
+        while (state.keepRunning()) {
+            doNotOptimizeAway(planCache.contains(*cq));
+        }
+    }
+
+    BENCHMARK(PlanCache, CanonicalizeAndGet) {
+        PlanCache planCache(kNs);
+        populate(&planCache);
+        const BSONObj query = makeQuery(kNumShapes / 2);
+
+        while (state.keepRunning()) {
+            scoped_ptr<CanonicalQuery> cq(canonicalize(query));
+            CachedSolution* cs;
+            doNotOptimizeAway(planCache.get(*cq, &cs));
+            delete cs;
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
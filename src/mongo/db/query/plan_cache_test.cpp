@@ -422,6 +422,98 @@ namespace {
         ASSERT_EQUALS(planCache.size(), 1U);
     }
 
+    TEST(PlanCacheTest, ManyQueryShapes) {
+        PlanCache planCache;
+        QuerySolution qs;
+        qs.cacheData.reset(new SolutionCacheData());
+        qs.cacheData->tree.reset(new PlanCacheIndexTree());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+
+        // Enough shapes to be spread over all the partitions
+        OwnedPointerVector<CanonicalQuery> queries;
+        for (int i = 0; i < 100; ++i) {
+            const std::string field = mongoutils::str::stream() << "a" << i;
+            queries.mutableVector().push_back(canonicalize(BSON(field << 1)));
+            ASSERT_OK(planCache.add(*queries[i], solns, createDecision(1U)));
+        }
+        ASSERT_EQUALS(planCache.size(), 100U);
+
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_TRUE(planCache.contains(*queries[i]));
+        }
+
+        OwnedPointerVector<PlanCacheEntry> entries;
+        entries.mutableVector() = planCache.getAllEntries();
+        ASSERT_EQUALS(entries.size(), 100U);
+
+        ASSERT_OK(planCache.remove(*queries[50]));
+        ASSERT_FALSE(planCache.contains(*queries[50]));
+        ASSERT_EQUALS(planCache.size(), 99U);
+
+        planCache.clear();
+        ASSERT_EQUALS(planCache.size(), 0U);
+    }
+
+    TEST(PlanCacheTest, Candidates) {
+        PlanCache planCache;
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        PlanCacheCandidates* rawCandidates;
+        ASSERT_NOT_OK(planCache.getCandidates(*cq, &rawCandidates));
+
+        PlanCacheCandidates* candidates = new PlanCacheCandidates();
+        candidates->plannerData.push_back(new SolutionCacheData());
+        candidates->plannerData.back()->solnType = SolutionCacheData::COLLSCAN_SOLN;
+        candidates->plannerOptions = QueryPlannerParams::INCLUDE_COLLSCAN;
+        planCache.addCandidates(*cq, candidates);
+
+        // Other values of the same shape find the candidates.
+        auto_ptr<CanonicalQuery> otherCq(canonicalize("{a: 2}"));
+        ASSERT_OK(planCache.getCandidates(*otherCq, &rawCandidates));
+        boost::scoped_ptr<PlanCacheCandidates> copy(rawCandidates);
+        ASSERT_EQUALS(copy->plannerData.size(), 1U);
+        ASSERT_EQUALS(copy->plannerData[0]->solnType, SolutionCacheData::COLLSCAN_SOLN);
+        ASSERT_EQUALS(copy->plannerOptions, size_t(QueryPlannerParams::INCLUDE_COLLSCAN));
+
+        // Flushing the cache because of writes keeps the candidates.
+        for (int i = 0; i < internalQueryCacheWriteOpsBetweenFlush; ++i) {
+            planCache.notifyOfWriteOp();
+        }
+        ASSERT_OK(planCache.getCandidates(*cq, &rawCandidates));
+        delete rawCandidates;
+
+        planCache.clear();
+        ASSERT_NOT_OK(planCache.getCandidates(*cq, &rawCandidates));
+    }
+
+    TEST(PlanCacheTest, Feedback) {
+        PlanCache planCache;
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+
+        // There is no entry to give feedback for yet
+        PlanCacheEntryFeedback* feedback = new PlanCacheEntryFeedback();
+        feedback->stats.reset(new PlanStageStats(CommonStats("COLLSCAN"), STAGE_COLLSCAN));
+        feedback->score = 1;
+        ASSERT_NOT_OK(planCache.feedback(*cq, feedback));
+
+        QuerySolution qs;
+        qs.cacheData.reset(new SolutionCacheData());
+        qs.cacheData->tree.reset(new PlanCacheIndexTree());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+        ASSERT_OK(planCache.add(*cq, solns, createDecision(1U)));
+
+        feedback = new PlanCacheEntryFeedback();
+        feedback->stats.reset(new PlanStageStats(CommonStats("COLLSCAN"), STAGE_COLLSCAN));
+        feedback->score = 1;
+        ASSERT_OK(planCache.feedback(*cq, feedback));
+
+        PlanCacheEntry* entry;
+        ASSERT_OK(planCache.getEntry(*cq, &entry));
+        boost::scoped_ptr<PlanCacheEntry> autoEntry(entry);
+        ASSERT_EQUALS(entry->feedback.size(), 1U);
+    }
+
     /**
      * Each test in the CachePlanSelectionTest suite goes through
      * the following flow:
@@ -747,6 +839,42 @@ namespace {
     // Equality
     //
 
+    TEST_F(CachePlanSelectionTest, RebuildRememberedCandidates) {
+        addIndex(BSON("a" << 1));
+        addIndex(BSON("b" << 1));
+
+        PlanCache planCache;
+        OwnedPointerVector<QuerySolution> first;
+        auto_ptr<CanonicalQuery> firstCq(canonicalize("{a: 1, b: 1}"));
+        ASSERT_OK(QueryPlanner::planWithCandidateCache(*firstCq, params, &planCache,
+                                                       &first.mutableVector()));
+        // One scan of each index, plus the collection scan.
+        ASSERT_EQUALS(first.size(), 3U);
+
+        PlanCacheCandidates* rawCandidates;
+        ASSERT_OK(planCache.getCandidates(*firstCq, &rawCandidates));
+        delete rawCandidates;
+
+        // The second query's candidates are rebuilt with its own bounds.
+        runQuery(fromjson("{a: 5, b: 6}"));
+        size_t numPlanned = solns.size();
+        OwnedPointerVector<QuerySolution> second;
+        ASSERT_OK(QueryPlanner::planWithCandidateCache(*cq, params, &planCache,
+                                                       &second.mutableVector()));
+        ASSERT_EQUALS(second.size(), numPlanned);
+        for (size_t i = 0; i < second.size(); ++i) {
+            ASSERT(second[i]->cacheData.get());
+            ASSERT(QueryPlannerTestLib::solutionMatches(
+                "{fetch: {filter: {b: 6}, node: {ixscan: {pattern: {a: 1}, "
+                "bounds: {a: [[5, 5, true, true]]}}}}}", second[i]->root.get())
+                || QueryPlannerTestLib::solutionMatches(
+                "{fetch: {filter: {a: 5}, node: {ixscan: {pattern: {b: 1}, "
+                "bounds: {b: [[6, 6, true, true]]}}}}}", second[i]->root.get())
+                || QueryPlannerTestLib::solutionMatches(
+                "{cscan: {dir: 1, filter: {a: 5, b: 6}}}", second[i]->root.get()));
+        }
+    }
+
     TEST_F(CachePlanSelectionTest, EqualityIndexScan) {
         addIndex(BSON("x" << 1));
         runQuery(BSON("x" << 5));
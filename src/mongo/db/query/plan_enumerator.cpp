@@ -59,6 +59,25 @@ namespace {
             || CanonicalQuery::countNodes(node, MatchExpression::TEXT) > 0;
     }
 
+    /**
+     * Returns true if 'pred', a predicate tagged as relevant to 'index' outside of any
+     * $elemMatch, is over a field of 'index' which is not multikey.
+     */
+    bool isOverNonMultikeyField(const IndexEntry& index, const MatchExpression* pred) {
+        const RelevantTag* rt = static_cast<const RelevantTag*>(pred->getTag());
+        if (NULL != rt->elemMatchExpr) {
+            return false;
+        }
+
+        BSONObjIterator kpIt(index.keyPattern);
+        for (size_t pos = 0; kpIt.more(); ++pos) {
+            if (kpIt.next().fieldName() == rt->path) {
+                return !index.isMultikeyAt(pos);
+            }
+        }
+        return false;
+    }
+
 } // namespace
 
 
@@ -508,7 +527,8 @@ namespace mongo {
                     const vector<MatchExpression*>& couldCompound = compIt->second;
                     vector<MatchExpression*> tryCompound;
 
-                    getMultikeyCompoundablePreds(indexAssign.preds, couldCompound, &tryCompound);
+                    getMultikeyCompoundablePreds(thisIndex, indexAssign.preds, couldCompound,
+                                                 &tryCompound);
                     if (tryCompound.size()) {
                         compound(tryCompound, thisIndex, &indexAssign);
                     }
@@ -593,16 +613,25 @@ namespace mongo {
 
             const IndexEntry& thisIndex = (*_indices)[it->first];
 
-            // If the index is multikey, we only assign one pred to it.  We also skip
-            // compounding.  TODO: is this also true for 2d and 2dsphere indices?  can they be
-            // multikey but still compoundable?
+            // If the index is multikey, we only assign one pred to its leading field, unless
+            // that field is known not to be multikey.  We also skip compounding predicates that
+            // aren't multikey-safe.  TODO: is this also true for 2d and 2dsphere indices?  can
+            // they be multikey but still compoundable?
             if (thisIndex.multikey) {
-                // TODO: could pick better pred than first but not too worried since we should
-                // really be isecting indices here.  Just take the first pred.  We don't assign
-                // any other preds to this index.  The planner will intersect the preds and this
-                // enumeration strategy is just one index at a time.
-                indexAssign.preds.push_back(it->second[0]);
-                indexAssign.positions.push_back(0);
+                if (thisIndex.isMultikeyAt(0)) {
+                    // TODO: could pick better pred than first but not too worried since we
+                    // should really be isecting indices here.  Just take the first pred.  We
+                    // don't assign any other preds to this index.  The planner will intersect
+                    // the preds and this enumeration strategy is just one index at a time.
+                    indexAssign.preds.push_back(it->second[0]);
+                    indexAssign.positions.push_back(0);
+                }
+                else {
+                    // Every key of a document has the same value for the leading field, so
+                    // its bounds can be intersected.
+                    indexAssign.preds = it->second;
+                    indexAssign.positions.resize(indexAssign.preds.size(), 0);
+                }
 
                 // If there are any preds that could possibly be compounded with this
                 // index...
@@ -613,7 +642,8 @@ namespace mongo {
 
                     // ...select the predicates that are safe to compound and try to
                     // compound them.
-                    getMultikeyCompoundablePreds(indexAssign.preds, couldCompound, &tryCompound);
+                    getMultikeyCompoundablePreds(thisIndex, indexAssign.preds, couldCompound,
+                                                 &tryCompound);
                     if (tryCompound.size()) {
                         compound(tryCompound, thisIndex, &indexAssign);
                     }
@@ -697,8 +727,8 @@ namespace mongo {
 
             // We create a scan per predicate so if we have >1 predicate we'll already
             // have at least 2 scans (one predicate per scan as the planner can't
-            // intersect bounds when the index is multikey), so we stop here.
-            if (oneIndex.multikey && oneAssign.preds.size() > 1) {
+            // intersect bounds when the leading field is multikey), so we stop here.
+            if (oneIndex.isMultikeyAt(0) && oneAssign.preds.size() > 1) {
                 // One could imagine an enormous auto-generated $all query with too many clauses to
                 // have an ixscan per clause.
                 static const size_t kMaxSelfIntersections = 10;
@@ -742,7 +772,7 @@ namespace mongo {
                 // want to have it as an additional assignment.  Eventually, it1 will be
                 // equal to the current value of secondIt and we'll assign every pred for
                 // this mapping to the index.
-                if (secondIndex.multikey && secondIt->second.size() > 1) {
+                if (secondIndex.isMultikeyAt(0) && secondIt->second.size() > 1) {
                     continue;
                 }
 
@@ -969,7 +999,8 @@ namespace mongo {
         return true;
     }
 
-    void PlanEnumerator::getMultikeyCompoundablePreds(const vector<MatchExpression*>& assigned,
+    void PlanEnumerator::getMultikeyCompoundablePreds(const IndexEntry& index,
+                                                      const vector<MatchExpression*>& assigned,
                                                       const vector<MatchExpression*>& couldCompound,
                                                       vector<MatchExpression*>* out) {
         // Map from a particular $elemMatch expression to the set of prefixes
@@ -982,13 +1013,20 @@ namespace mongo {
         //
         // As we iterate over the available indexed predicates, we keep track
         // of the used prefixes both inside and outside of an $elemMatch context.
+        //
+        // Predicates over a field which isn't multikey are exempt: every key of a document
+        // has the same value for that field, whatever arrays the other fields come from.
         unordered_map<MatchExpression*, set<string> > used;
+        used[NULL];
 
         // Initialize 'used' with the starting predicates in 'assigned'. Begin by
         // initializing the top-level scope with the prefix of the full path.
         for (size_t i = 0; i < assigned.size(); i++) {
             const MatchExpression* assignedPred = assigned[i];
             invariant(NULL != assignedPred->getTag());
+            if (isOverNonMultikeyField(index, assignedPred)) {
+                continue;
+            }
             RelevantTag* usedRt = static_cast<RelevantTag*>(assignedPred->getTag());
             set<string> usedPrefixes;
             usedPrefixes.insert(getPathPrefix(usedRt->path));
@@ -1015,6 +1053,11 @@ namespace mongo {
             invariant(Indexability::nodeCanUseIndexOnOwnField(couldCompound[i]));
             RelevantTag* rt = static_cast<RelevantTag*>(couldCompound[i]->getTag());
 
+            if (isOverNonMultikeyField(index, couldCompound[i])) {
+                out->push_back(couldCompound[i]);
+                continue;
+            }
+
             if (used.end() == used.find(rt->elemMatchExpr)) {
                 // This is a new $elemMatch that we haven't seen before.
                 invariant(used.end() != used.find(NULL));
@@ -291,6 +291,9 @@ namespace mongo {
          *   "Any set of predicates for which no two predicates share a path
          *    prefix can be compounded."
          *
+         * Predicates over a field of 'index' which is known not to be multikey can
+         * always be compounded, as long as they are not inside an $elemMatch.
+         *
          * Suppose we have predicates over paths 'a.b' and 'a.c'. These cannot
          * be compounded because they share the prefix 'a'. Similarly, the bounds
          * for 'a' and 'a.b' cannot be compounded (in the case of multikey index
@@ -335,7 +338,8 @@ namespace mongo {
          *      and then not assign the $near because the $within is already assigned (and
          *      has the same path).
          */
-        void getMultikeyCompoundablePreds(const std::vector<MatchExpression*>& assigned,
+        void getMultikeyCompoundablePreds(const IndexEntry& index,
+                                          const std::vector<MatchExpression*>& assigned,
                                           const std::vector<MatchExpression*>& couldCompound,
                                           std::vector<MatchExpression*>* out);
 
@@ -31,6 +31,7 @@
 #include <boost/shared_ptr.hpp>
 
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/exec/cached_plan.h"
 #include "mongo/db/exec/multi_plan.h"
 #include "mongo/db/exec/pipeline_proxy.h"
 #include "mongo/db/exec/plan_stage.h"
@@ -40,6 +41,7 @@
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 
 #include "mongo/util/stacktrace.h"
@@ -151,7 +153,10 @@ namespace mongo {
           _qs(qs),
           _root(rt),
           _ns(ns),
-          _killed(false) {
+          _killed(false),
+          _batchPos(0),
+          _batchState(PlanStage::NEED_TIME),
+          _batchId(WorkingSet::INVALID_ID) {
         // We may still need to initialize _ns from either _collection or _cq.
         if (!_ns.empty()) {
             // We already have an _ns set, so there's nothing more to do.
@@ -179,6 +184,13 @@ namespace mongo {
             return subplan->pickBestPlan(_yieldPolicy.get());
         }
 
+        // A cached plan gets a trial, and is replanned if it does badly.
+        foundStage = getStageByType(_root.get(), STAGE_CACHED_PLAN);
+        if (foundStage) {
+            CachedPlanStage* cachedPlan = static_cast<CachedPlanStage*>(foundStage);
+            return cachedPlan->pickBestPlan(_yieldPolicy.get());
+        }
+
         // If we didn't have to do subplanning, we might still have to do regular
         // multi plan selection.
         foundStage = getStageByType(_root.get(), STAGE_MULTI_PLAN);
@@ -192,7 +204,11 @@ namespace mongo {
         return Status::OK();
     }
 
-    PlanExecutor::~PlanExecutor() { }
+    PlanExecutor::~PlanExecutor() {
+        // The stages may still refer to the working set while they're destroyed.
+        _root.reset();
+        WorkingSet::release(_workingSet.release());
+    }
 
     // static
     std::string PlanExecutor::statestr(ExecState s) {
@@ -235,6 +251,10 @@ namespace mongo {
         return _opCtx;
     }
 
+    long long PlanExecutor::getNumYields() const {
+        return _yieldPolicy ? _yieldPolicy->getNumYields() : 0;
+    }
+
     void PlanExecutor::saveState() {
         if (!_killed) {
             _root->saveState();
@@ -270,6 +290,56 @@ namespace mongo {
 
     void PlanExecutor::invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type) {
         if (!_killed) { _root->invalidate(txn, dl, type); }
+
+        // Results of the root's last batch which we haven't returned yet no longer have the stage
+        // which produced them looking after them, so we do the forced fetch which it would have.
+        if (!_killed && _collection) {
+            for (size_t i = _batchPos; i < _batch.size(); ++i) {
+                WorkingSetMember* member = _workingSet->get(_batch[i]);
+                if (member->hasLoc() && member->loc == dl) {
+                    WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+                }
+            }
+        }
+    }
+
+    PlanStage::StageState PlanExecutor::workRoot(WorkingSetID* id) {
+        if (_batchPos < _batch.size()) {
+            *id = _batch[_batchPos++];
+            if (_batchPos == _batch.size()) {
+                _batch.clear();
+                _batchPos = 0;
+            }
+            return PlanStage::ADVANCED;
+        }
+
+        if (PlanStage::NEED_TIME != _batchState) {
+            PlanStage::StageState state = _batchState;
+            *id = _batchId;
+            _batchState = PlanStage::NEED_TIME;
+            _batchId = WorkingSet::INVALID_ID;
+            return state;
+        }
+
+        // Writes stay one unit of work at a time, so that each of them is followed by a yield
+        // check.
+        const int batchSize = internalQueryExecBatchSize;
+        if (batchSize <= 1
+            || STAGE_UPDATE == _root->stageType()
+            || STAGE_DELETE == _root->stageType()) {
+            return _root->work(id);
+        }
+
+        PlanStage::StageState state = _root->workBatch(batchSize, &_batch, id);
+        if (_batch.empty()) {
+            return state;
+        }
+
+        if (PlanStage::ADVANCED != state && PlanStage::NEED_TIME != state) {
+            _batchState = state;
+            _batchId = *id;
+        }
+        return workRoot(id);
     }
 
     PlanExecutor::ExecState PlanExecutor::getNext(BSONObj* objOut, RecordId* dlOut) {
@@ -302,7 +372,7 @@ namespace mongo {
             fetcher.reset();
 
             WorkingSetID id = WorkingSet::INVALID_ID;
-            PlanStage::StageState code = _root->work(&id);
+            PlanStage::StageState code = workRoot(&id);
 
             if (PlanStage::ADVANCED == code) {
                 // Fast count.
@@ -378,7 +448,16 @@ namespace mongo {
     }
 
     bool PlanExecutor::isEOF() {
-        return _killed || _root->isEOF();
+        if (_killed) {
+            return true;
+        }
+
+        if (_batchPos < _batch.size()
+            || (PlanStage::NEED_TIME != _batchState && PlanStage::IS_EOF != _batchState)) {
+            return false;
+        }
+
+        return _root->isEOF();
     }
 
     void PlanExecutor::registerExec() {
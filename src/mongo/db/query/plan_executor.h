@@ -29,8 +29,10 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/invalidation_type.h"
 #include "mongo/db/query/query_solution.h"
 
@@ -205,6 +207,12 @@ namespace mongo {
          */
         OperationContext* getOpCtx() const;
 
+        /**
+         * How many times a YIELD_AUTO executor gave up its locks on its own so far. Always 0 for
+         * other yield policies.
+         */
+        long long getNumYields() const;
+
         /**
          * Generates a tree of stats objects with a separate lifetime from the execution
          * stage tree wrapped by this PlanExecutor. The caller owns the returned pointer.
@@ -371,6 +379,15 @@ namespace mongo {
          */
         Status pickBestPlan(YieldPolicy policy);
 
+        /**
+         * Gets the next state of the plan, with its id in 'id', for getNext() to act on.
+         *
+         * If internalQueryExecBatchSize is larger than one, works the root a batch at a time
+         * and hands out the results of the batch, then the state it ended in, before working
+         * the root again.
+         */
+        PlanStage::StageState workRoot(WorkingSetID* id);
+
         // The OperationContext that we're executing within.  We need this in order to release
         // locks.
         OperationContext* _opCtx;
@@ -380,7 +397,8 @@ namespace mongo {
         const Collection* _collection;
 
         boost::scoped_ptr<CanonicalQuery> _cq;
-        boost::scoped_ptr<WorkingSet> _workingSet;
+        // Handed back to WorkingSet::release() when we're destroyed.
+        std::auto_ptr<WorkingSet> _workingSet;
         boost::scoped_ptr<QuerySolution> _qs;
         std::auto_ptr<PlanStage> _root;
 
@@ -394,6 +412,14 @@ namespace mongo {
         // we'll be killed.
         bool _killed;
 
+        // The results of the root's last batch from '_batchPos' on are yet to be returned by
+        // getNext(), followed by '_batchState' (NEED_TIME if there is none), with its id in
+        // '_batchId'. Only used if internalQueryExecBatchSize is larger than one.
+        std::vector<WorkingSetID> _batch;
+        size_t _batchPos;
+        PlanStage::StageState _batchState;
+        WorkingSetID _batchId;
+
         // If the yield policy is YIELD_AUTO, this is used to enforce automatic yielding. The plan
         // may yield on any call to getNext() if this is non-NULL.
         boost::scoped_ptr<PlanYieldPolicy> _yieldPolicy;
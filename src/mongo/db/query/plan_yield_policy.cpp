@@ -30,19 +30,54 @@
 
 #include "mongo/db/query/plan_yield_policy.h"
 
+#include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/concurrency/admission_control.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_yield.h"
+#include "mongo/util/net/listen.h"
 
 namespace mongo {
 
+    // How many times did a plan find nobody waiting on it, and not yield when it otherwise would?
+    static Counter64 yieldsSkippedCounter;
+    static ServerStatusMetricField<Counter64> displayYieldsSkipped("queryExecutor.yieldsSkipped",
+                                                                   &yieldsSkippedCounter);
+
     PlanYieldPolicy::PlanYieldPolicy(PlanExecutor* exec)
         : _elapsedTracker(internalQueryExecYieldIterations, internalQueryExecYieldPeriodMS),
-          _planYielding(exec) { }
+          _lastYieldMillis(Listener::getElapsedTimeMillis()),
+          _planYielding(exec),
+          _numYields(0) { }
 
     bool PlanYieldPolicy::shouldYield() {
         invariant(!_planYielding->getOpCtx()->lockState()->inAWriteUnitOfWork());
-        return _elapsedTracker.intervalHasElapsed();
+        if (!_elapsedTracker.intervalHasElapsed()) {
+            return false;
+        }
+
+        if (!internalQueryExecYieldOnlyWhenContended || _othersAreWaiting()) {
+            return true;
+        }
+
+        if (Listener::getElapsedTimeMillis() - _lastYieldMillis >=
+                internalQueryExecUncontendedYieldPeriodMS) {
+            return true;
+        }
+
+        yieldsSkippedCounter.increment();
+        return false;
+    }
+
+    bool PlanYieldPolicy::_othersAreWaiting() const {
+        if (_planYielding->getOpCtx()->lockState()->hasLockWaiters()) {
+            return true;
+        }
+
+        // Yielding releases this operation's admission ticket along with the global lock.
+        AdmissionTickets* tickets = getGlobalAdmissionTickets();
+        return tickets && tickets->numQueued() > 0;
     }
 
     bool PlanYieldPolicy::yield(RecordFetcher* fetcher) {
@@ -65,8 +100,10 @@ namespace mongo {
 
         // Release and reacquire locks.
         QueryYield::yieldAllLocks(opCtx, fetcher);
+        ++_numYields;
 
         _elapsedTracker.resetLastTime();
+        _lastYieldMillis = Listener::getElapsedTimeMillis();
 
         return _planYielding->restoreState(opCtx);
     }
@@ -44,6 +44,11 @@ namespace mongo {
          * Used by YIELD_AUTO plan executors in order to check whether it is time to yield.
          * PlanExecutors give up their locks periodically in order to be fair to other
          * threads.
+         *
+         * Unless internalQueryExecYieldOnlyWhenContended is off, the yield period only says when
+         * to look for other operations waiting on this one: for a conflicting lock on something
+         * this operation holds, or for an admission ticket. Without any, yielding would only cost
+         * a save and restore, so it is put off until internalQueryExecUncontendedYieldPeriodMS.
          */
         bool shouldYield();
 
@@ -60,15 +65,30 @@ namespace mongo {
          */
         bool yield(RecordFetcher* fetcher = NULL);
 
+        /**
+         * How many times yield() gave up the locks so far.
+         */
+        long long getNumYields() const { return _numYields; }
+
     private:
         // Default constructor disallowed in order to ensure initialization of '_planYielding'.
         PlanYieldPolicy();
 
+        /**
+         * Whether another operation is waiting for something this one would give up by yielding.
+         */
+        bool _othersAreWaiting() const;
+
         ElapsedTracker _elapsedTracker;
 
+        // When yield() last gave up the locks, or when this policy was created.
+        long long _lastYieldMillis;
+
         // The plan executor which this yield policy is responsible for yielding. Must
         // not outlive the plan executor.
         PlanExecutor* _planYielding;
+
+        long long _numYields;
     };
 
 } // namespace mongo
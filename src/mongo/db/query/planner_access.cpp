@@ -39,6 +39,7 @@
 #include "mongo/db/query/indexability.h"
 #include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/query/index_tag.h"
+#include "mongo/db/query/planner_ixselect.h"
 #include "mongo/db/query/qlog.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
@@ -118,10 +119,18 @@ namespace mongo {
             BSONElement elt = index.keyPattern.firstElement();
             bool indexIs2D = (String == elt.type() && "2d" == elt.String());
 
+            // Lets the near stage size its annuli for the results the query actually wants.
+            size_t numWanted = 0;
+            if (0 != query.getParsed().getNumToReturn()) {
+                numWanted = size_t(query.getParsed().getNumToReturn()) +
+                            size_t(query.getParsed().getSkip());
+            }
+
             if (indexIs2D) {
                 GeoNear2DNode* ret = new GeoNear2DNode();
                 ret->indexKeyPattern = index.keyPattern;
                 ret->nq = &nearExpr->getData();
+                ret->numWanted = numWanted;
                 ret->baseBounds.fields.resize(index.keyPattern.nFields());
                 if (NULL != query.getProj()) {
                     ret->addPointMeta = query.getProj()->wantGeoNearPoint();
@@ -134,6 +143,7 @@ namespace mongo {
                 GeoNear2DSphereNode* ret = new GeoNear2DSphereNode();
                 ret->indexKeyPattern = index.keyPattern;
                 ret->nq = &nearExpr->getData();
+                ret->numWanted = numWanted;
                 ret->baseBounds.fields.resize(index.keyPattern.nFields());
                 if (NULL != query.getProj()) {
                     ret->addPointMeta = query.getProj()->wantGeoNearPoint();
@@ -241,8 +251,8 @@ namespace mongo {
         else {
             if (MatchExpression::AND == mergeType) {
                 // The bounds will be intersected. This is OK provided
-                // that the index is NOT multikey.
-                return !index.multikey;
+                // that the field is NOT multikey.
+                return !index.isMultikeyAt(pos);
             }
             else {
                 // The bounds will be unionized.
@@ -574,6 +584,78 @@ namespace mongo {
         IndexBoundsBuilder::alignBounds(bounds, index.keyPattern);
     }
 
+    // static
+    QuerySolutionNode* QueryPlannerAccess::skipScanIndex(const IndexEntry& index,
+                                                         const CanonicalQuery& query,
+                                                         const QueryPlannerParams& params) {
+        BSONObjIterator it(index.keyPattern);
+        BSONElement firstElt = it.next();
+        if (!it.more()) {
+            return NULL;
+        }
+        BSONElement secondElt = it.next();
+
+        // Only predicates AND-related to the rest of the query can bound the second field.
+        MatchExpression* root = query.root();
+        vector<MatchExpression*> preds;
+        if (MatchExpression::AND == root->matchType()) {
+            for (size_t i = 0; i < root->numChildren(); ++i) {
+                preds.push_back(root->getChild(i));
+            }
+        }
+        else {
+            preds.push_back(root);
+        }
+
+        vector<MatchExpression*> secondFieldPreds;
+        for (size_t i = 0; i < preds.size(); ++i) {
+            MatchExpression* pred = preds[i];
+            if (!Indexability::nodeCanUseIndexOnOwnField(pred)) {
+                continue;
+            }
+
+            if (pred->path() == firstElt.fieldNameStringData()) {
+                return NULL;
+            }
+
+            if (pred->path() == secondElt.fieldNameStringData()
+                && QueryPlannerIXSelect::compatible(secondElt, index, pred)) {
+                secondFieldPreds.push_back(pred);
+            }
+        }
+
+        if (secondFieldPreds.empty()) {
+            return NULL;
+        }
+
+        IndexScanNode* isn = new IndexScanNode();
+        isn->indexKeyPattern = index.keyPattern;
+        isn->indexIsMultiKey = index.multikey;
+        isn->bounds.fields.resize(index.keyPattern.nFields());
+        isn->maxScan = query.getParsed().getMaxScan();
+        isn->addKeyMetadata = query.getParsed().returnKey();
+
+        // The bounds of a multikey field can't be intersected, so we only use the first
+        // predicate.  The fetch below applies the whole query anyway.
+        IndexBoundsBuilder::BoundsTightness tightness;
+        IndexBoundsBuilder::translate(secondFieldPreds[0], secondElt, index,
+                                      &isn->bounds.fields[1], &tightness);
+        if (!index.isMultikeyAt(1)) {
+            for (size_t i = 1; i < secondFieldPreds.size(); ++i) {
+                IndexBoundsBuilder::translateAndIntersect(secondFieldPreds[i], secondElt, index,
+                                                          &isn->bounds.fields[1], &tightness);
+            }
+        }
+
+        // The first field and any past the second get all values.
+        finishLeafNode(isn, index);
+
+        FetchNode* fetch = new FetchNode();
+        fetch->filter.reset(root->shallowClone());
+        fetch->children.push_back(isn);
+        return fetch;
+    }
+
     // static
     void QueryPlannerAccess::findElemMatchChildren(const MatchExpression* node,
                                                    vector<MatchExpression*>* out,
@@ -1264,18 +1346,19 @@ namespace mongo {
             delete child;
         }
         else if (scanState->tightness == IndexBoundsBuilder::INEXACT_COVERED
-                 && (INDEX_TEXT == index.type || !index.multikey)) {
+                 && (INDEX_TEXT == index.type || !index.isMultikeyAt(scanState->ixtag->pos))) {
             // The bounds are not exact, but the information needed to
             // evaluate the predicate is in the index key. Remove the
             // MatchExpression from its parent and attach it to the filter
             // of the index scan we're building.
             //
-            // We can only use this optimization if the index is NOT multikey.
+            // We can only use this optimization if the field is NOT multikey.
             // Suppose that we had the multikey index {x: 1} and a document
             // {x: ["a", "b"]}. Now if we query for {x: /b/} the filter might
             // ever only be applied to the index key "a". We'd incorrectly
             // conclude that the document does not match the query :( so we
-            // gotta stick to non-multikey indices.
+            // gotta stick to non-multikey fields, whose value is the same in
+            // every key of a document.
             root->getChildVector()->erase(root->getChildVector()->begin() + scanState->curChild);
 
             addFilterToSolutionNode(scanState->currentScan.get(), child, root->matchType());
@@ -203,6 +203,19 @@ namespace mongo {
                                                  const QueryPlannerParams& params,
                                                  int direction = 1);
 
+        /**
+         * Return a plan that scans the compound index 'index' over all values of its first field
+         * and the values of its second field allowed by the predicates of 'query'.  The index
+         * scan skips from one value of the first field to the next, so it's cheap when the first
+         * field has few values.
+         *
+         * Returns NULL if the query has no predicate over the second field of the index that
+         * can use it, or has one over the first field, which the regular plans can use.
+         */
+        static QuerySolutionNode* skipScanIndex(const IndexEntry& index,
+                                                const CanonicalQuery& query,
+                                                const QueryPlannerParams& params);
+
         /**
          * Return a plan that scans the provided index from [startKey to endKey).
          */
@@ -512,6 +512,15 @@ namespace mongo {
             sort->limit = 0;
         }
 
+        // A top-k sort on the text score directly over the text stage only needs the text
+        // stage to produce the best 'limit' documents, which it can find without scoring them all.
+        if (0 != sort->limit && STAGE_TEXT == sort->children[0]->getType()
+            && 1 == sortObj.nFields()
+            && LiteParsedQuery::isTextScoreMeta(sortObj.firstElement())) {
+            TextNode* textNode = static_cast<TextNode*>(sort->children[0]);
+            textNode->limit = sort->limit;
+        }
+
         *blockingSortOut = true;
 
         return solnRoot;
@@ -699,6 +708,14 @@ namespace mongo {
                 }
             }
 
+            // If we're not allowed to fetch for the projection, bail out.
+            if ((params.options & QueryPlannerParams::NO_UNCOVERED_PROJECTIONS)
+                && solnRoot->fetched()) {
+                QLOG() << "PROJECTION: not covered and uncovered projections are not allowed";
+                delete solnRoot;
+                return NULL;
+            }
+
             // We now know we have whatever data is required for the projection.
             ProjectionNode* projNode = new ProjectionNode();
             projNode->children.push_back(solnRoot);
@@ -46,6 +46,18 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheWriteOpsBetweenFlush, int, 1000);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheEvictionRatio, double, 10.0);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheReuseCandidates, bool, true);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheShapeTemplates, bool, true);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryHistogramPruneRatio, double, 10.0);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryHistogramPruneMinKeys, int, 10000);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryHistogramMaxWriteFraction, double, 0.2);
+
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerMaxIndexedSolutions, int, 64);
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryEnumerationMaxOrSolutions, int, 10);
@@ -62,10 +74,31 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryMaxScansToExplode, int, 200);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableSkipScan, bool, true);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerSkipScanMaxLeadingValues, int, 1000);
+
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecMaxBlockingSortBytes, int, 32 * 1024 * 1024);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecAllowBlockingSortSpill, bool, false);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryShapeStatsMaxShapes, int, 1000);
+
     // Yield every 128 cycles or 10ms.
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldIterations, int, 128);
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldPeriodMS, int, 10);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldOnlyWhenContended, bool, true);
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecUncontendedYieldPeriodMS, int, 100);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecBatchSize, int, 0);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecFetchLookahead, int, 16);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecCompileFilters, bool, true);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceCursorBatchSizeBytes, int, 4 * 1024 * 1024);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceCursorBatchTargetMS, int, 5);
+
 }  // namespace mongo
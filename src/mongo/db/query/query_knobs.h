@@ -72,6 +72,32 @@ namespace mongo {
     // How many write ops should we allow in a collection before tossing all cache entries?
     extern int internalQueryCacheWriteOpsBetweenFlush;
 
+    // How many times the works it took when it was picked may a cached plan take in its trial
+    // before we evict it and replan?
+    extern double internalQueryCacheEvictionRatio;
+
+    // Do we remember every candidate plan enumerated for a query shape, and rebuild the candidates
+    // from them for later queries of that shape instead of enumerating again?
+    extern bool internalQueryCacheReuseCandidates;
+
+    // Do we build the tree of a query that only has equalities on top-level fields from a
+    // template for its shape, when there is one, rather than parsing it?
+    extern bool internalQueryCacheShapeTemplates;
+
+    //
+    // index histograms
+    //
+
+    // Do we prune plans estimated to examine more than this many times the keys of the best
+    // estimated plan? Zero turns pruning off.
+    extern double internalQueryHistogramPruneRatio;
+
+    // Plans estimated to examine fewer keys than this are never pruned.
+    extern int internalQueryHistogramPruneMinKeys;
+
+    // A histogram is stale once this fraction of its number of keys in writes went by.
+    extern double internalQueryHistogramMaxWriteFraction;
+
     //
     // Planning and enumeration.
     //
@@ -92,16 +118,59 @@ namespace mongo {
     // during explodeForSort?
     extern int internalQueryMaxScansToExplode;
 
+    // Do we consider skip scans over compound indexes whose first field the query doesn't
+    // constrain, jumping from one value of the first field to the next?
+    extern bool internalQueryPlannerEnableSkipScan;
+
+    // Skip scans are only considered over indexes whose histogram estimates at most this many
+    // distinct values of the first field.
+    extern int internalQueryPlannerSkipScanMaxLeadingValues;
+
     //
     // Query execution.
     //
 
     extern int internalQueryExecMaxBlockingSortBytes;
 
+    // If true, blocking sorts with no limit that go over internalQueryExecMaxBlockingSortBytes
+    // spill to disk rather than failing.
+    extern bool internalQueryExecAllowBlockingSortSpill;
+
+    // How many query shapes a collection's QueryShapeStats keeps counters for.
+    extern int internalQueryShapeStatsMaxShapes;
+
     // Yield after this many "should yield?" checks.
     extern int internalQueryExecYieldIterations;
 
     // Yield if it's been at least this many milliseconds since we last yielded.
     extern int internalQueryExecYieldPeriodMS;
 
+    // If true, the two knobs above only say how often a plan checks whether another operation
+    // waits for one of its locks or for an admission ticket. It yields only if one does, or if
+    // it hasn't yielded for internalQueryExecUncontendedYieldPeriodMS.
+    extern bool internalQueryExecYieldOnlyWhenContended;
+
+    extern int internalQueryExecUncontendedYieldPeriodMS;
+
+    // If larger than one, the PlanExecutor works read plans this many units of work at a time.
+    extern int internalQueryExecBatchSize;
+
+    // If positive, fetches on storage engines which can prefetch records read this many results
+    // of their child ahead, and have the storage engine start reading in their documents.
+    extern int internalQueryExecFetchLookahead;
+
+    // Do collection scans and fetches compile their filters for matching whole documents?
+    extern bool internalQueryExecCompileFilters;
+
+    //
+    // Aggregation.
+    //
+
+    // Most bytes of documents an aggregation reads from its cursor per batch, under one lock.
+    extern int internalDocumentSourceCursorBatchSizeBytes;
+
+    // How long an aggregation should hold the collection lock to read a batch. Batches grow while
+    // they are read quicker and shrink when they aren't.
+    extern int internalDocumentSourceCursorBatchTargetMS;
+
 }  // namespace mongo
@@ -44,6 +44,7 @@
 #include "mongo/db/query/planner_ixselect.h"
 #include "mongo/db/query/plan_enumerator.h"
 #include "mongo/db/query/qlog.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/util/log.h"
@@ -231,6 +232,30 @@ namespace mongo {
         return QueryPlannerAnalysis::analyzeDataAccess(query, params, solnRoot);
     }
 
+    QuerySolution* buildSkipScanSoln(const IndexEntry& index,
+                                     const CanonicalQuery& query,
+                                     const QueryPlannerParams& params) {
+
+        QuerySolutionNode* solnRoot = QueryPlannerAccess::skipScanIndex(index, query, params);
+        if (NULL == solnRoot) {
+            return NULL;
+        }
+        return QueryPlannerAnalysis::analyzeDataAccess(query, params, solnRoot);
+    }
+
+    /**
+     * Whether 'index', from a solution cached for another query of the same shape, is one this
+     * query may use. A partial index is only offered for the queries which imply its filter.
+     */
+    static bool isIndexAvailable(const IndexEntry& index, const QueryPlannerParams& params) {
+        for (size_t i = 0; i < params.indices.size(); ++i) {
+            if (0 == params.indices[i].keyPattern.woCompare(index.keyPattern)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     bool providesSort(const CanonicalQuery& query, const BSONObj& kp) {
         return query.getParsed().getSort().isPrefixOf(kp);
     }
@@ -338,6 +363,13 @@ namespace mongo {
                                        const QueryPlannerParams& params,
                                        const SolutionCacheData& cacheData,
                                        QuerySolution** out) {
+        if ((SolutionCacheData::WHOLE_IXSCAN_SOLN == cacheData.solnType ||
+             SolutionCacheData::SKIP_SCAN_SOLN == cacheData.solnType) &&
+            !isIndexAvailable(*cacheData.tree->entry, params)) {
+            return Status(ErrorCodes::BadValue,
+                          "plan cache error: cached index is not available to this query");
+        }
+
         if (SolutionCacheData::WHOLE_IXSCAN_SOLN == cacheData.solnType) {
             // The solution can be constructed by a scan over the entire index.
             QuerySolution* soln = buildWholeIXSoln(*cacheData.tree->entry,
@@ -353,6 +385,16 @@ namespace mongo {
                 return Status::OK();
             }
         }
+        else if (SolutionCacheData::SKIP_SCAN_SOLN == cacheData.solnType) {
+            QuerySolution* soln = buildSkipScanSoln(*cacheData.tree->entry, query, params);
+            if (soln == NULL) {
+                return Status(ErrorCodes::BadValue, "plan cache error: skip scan soln");
+            }
+            else {
+                *out = soln;
+                return Status::OK();
+            }
+        }
         else if (SolutionCacheData::COLLSCAN_SOLN == cacheData.solnType) {
             // The cached solution is a collection scan. We don't cache collscans
             // with tailable==true, hence the false below.
@@ -453,6 +495,70 @@ namespace mongo {
         return Status::OK();
     }
 
+    // static
+    Status QueryPlanner::planWithCandidateCache(const CanonicalQuery& query,
+                                                const QueryPlannerParams& params,
+                                                PlanCache* planCache,
+                                                std::vector<QuerySolution*>* out) {
+        if (!internalQueryCacheReuseCandidates
+            || NULL == planCache
+            || !PlanCache::shouldCacheQuery(query)) {
+            return plan(query, params, out);
+        }
+
+        PlanCacheCandidates* rawCandidates;
+        if (planCache->getCandidates(query, &rawCandidates).isOK()) {
+            boost::scoped_ptr<PlanCacheCandidates> candidates(rawCandidates);
+
+            if (candidates->plannerOptions == params.options
+                && candidates->indexFilterApplied == params.indexFiltersApplied) {
+                OwnedPointerVector<QuerySolution> solutions;
+                for (size_t i = 0; i < candidates->plannerData.size(); ++i) {
+                    const SolutionCacheData& cacheData = *candidates->plannerData[i];
+                    QuerySolution* soln;
+                    if (!planFromCache(query, params, cacheData, &soln).isOK()) {
+                        break;
+                    }
+                    soln->cacheData.reset(cacheData.clone());
+                    solutions.mutableVector().push_back(soln);
+                }
+
+                if (solutions.size() == candidates->plannerData.size()) {
+                    QLOG() << "Planner: rebuilt " << solutions.size()
+                           << " remembered candidate solutions" << endl;
+                    std::vector<QuerySolution*> rebuilt = solutions.release();
+                    out->insert(out->end(), rebuilt.begin(), rebuilt.end());
+                    return Status::OK();
+                }
+            }
+
+            // The candidates don't fit this query any more, so enumerate again below and
+            // replace them.
+            QLOG() << "Planner: can't rebuild remembered candidate solutions" << endl;
+        }
+
+        const size_t numBefore = out->size();
+        Status status = plan(query, params, out);
+        if (!status.isOK() || out->size() == numBefore) {
+            return status;
+        }
+
+        std::auto_ptr<PlanCacheCandidates> candidates(new PlanCacheCandidates());
+        candidates->plannerOptions = params.options;
+        candidates->indexFilterApplied = params.indexFiltersApplied;
+        for (size_t i = numBefore; i < out->size(); ++i) {
+            const QuerySolution* soln = (*out)[i];
+            if (NULL == soln->cacheData.get()) {
+                // Without cache data we couldn't rebuild this candidate.
+                return status;
+            }
+            candidates->plannerData.push_back(soln->cacheData->clone());
+        }
+
+        planCache->addCandidates(query, candidates.release());
+        return status;
+    }
+
     // static
     Status QueryPlanner::plan(const CanonicalQuery& query,
                               const QueryPlannerParams& params,
@@ -809,6 +915,41 @@ namespace mongo {
             }
         }
 
+        // A compound index whose first field the query doesn't constrain can still be scanned
+        // over the values of its second field that the query allows, once per value of the
+        // first field.  That's only worth it when the first field has few values.
+        if (hintIndex.isEmpty()
+            && (params.options & QueryPlannerParams::SKIP_SCAN)
+            && !QueryPlannerCommon::hasNode(query.root(), MatchExpression::GEO_NEAR)
+            && !QueryPlannerCommon::hasNode(query.root(), MatchExpression::TEXT)) {
+
+            for (size_t i = 0; i < params.indices.size(); ++i) {
+                if (out->size() >= params.maxIndexedSolutions) {
+                    break;
+                }
+
+                const IndexEntry& index = params.indices[i];
+                if (index.type != INDEX_BTREE
+                    || index.numLeadingValues < 0
+                    || index.numLeadingValues > internalQueryPlannerSkipScanMaxLeadingValues) {
+                    continue;
+                }
+
+                QuerySolution* soln = buildSkipScanSoln(index, query, params);
+                if (NULL != soln) {
+                    QLOG() << "Planner: outputting skip scan soln:" << endl << soln->toString();
+                    PlanCacheIndexTree* indexTree = new PlanCacheIndexTree();
+                    indexTree->setIndexEntry(index);
+                    SolutionCacheData* scd = new SolutionCacheData();
+                    scd->tree.reset(indexTree);
+                    scd->solnType = SolutionCacheData::SKIP_SCAN_SOLN;
+
+                    soln->cacheData.reset(scd);
+                    out->push_back(soln);
+                }
+            }
+        }
+
         // An index was hinted.  If there are any solutions, they use the hinted index.  If not, we
         // scan the entire index to provide results and output that as our plan.  This is the
         // desired behavior when an index is hinted that is not relevant to the query.
@@ -36,6 +36,7 @@ namespace mongo {
 
     class CachedSolution;
     class Collection;
+    class PlanCache;
 
     /**
      * QueryPlanner's job is to provide an entry point to the query planning and optimization
@@ -56,6 +57,18 @@ namespace mongo {
                            const QueryPlannerParams& params,
                            std::vector<QuerySolution*>* out);
 
+        /**
+         * Like plan(), but rebuilds the candidate solutions from those 'planCache' remembers for
+         * the shape of 'query' when it can, rather than enumerating them again. Otherwise plans
+         * from scratch and remembers the candidates for next time.
+         *
+         * Caller owns pointers in *out.
+         */
+        static Status planWithCandidateCache(const CanonicalQuery& query,
+                                             const QueryPlannerParams& params,
+                                             PlanCache* planCache,
+                                             std::vector<QuerySolution*>* out);
+
         /**
          * Helper that does most of the heavy lifting for the planFromCache
          * method which this overloads. Whereas the overloaded version plans
@@ -81,7 +81,16 @@ namespace mongo {
             // Set this if you want to handle batchSize properly with sort(). If limits on SORT
             // stages are always actually limits, then this should be left off. If they are
             // sometimes to be interpreted as batchSize, then this should be turned on.
-            SPLIT_LIMITED_SORT = 1 << 7
+            SPLIT_LIMITED_SORT = 1 << 7,
+
+            // Set this if you only want plans which compute the projection without fetching the
+            // documents, i.e. from index keys.  Plans which would need a fetch are dropped.
+            NO_UNCOVERED_PROJECTIONS = 1 << 8,
+
+            // Set this if you want plans which skip scan compound indexes whose first field the
+            // query doesn't constrain.  Only indexes with a known, small 'numLeadingValues' are
+            // considered.
+            SKIP_SCAN = 1 << 9
         };
 
         // See Options enum above.
@@ -90,6 +90,11 @@ namespace {
                                                 BSONObj()));
         }
 
+        void addIndex(BSONObj keyPattern, const MultikeyPaths& multikeyPaths) {
+            addIndex(keyPattern, true);
+            params.indices.back().multikeyPaths = multikeyPaths;
+        }
+
         void addIndex(BSONObj keyPattern, BSONObj infoObj) {
             params.indices.push_back(IndexEntry(keyPattern, false, false, "foo", infoObj));
         }
@@ -3602,6 +3607,70 @@ namespace {
         assertHasOneSolutionOf(alternates);
     }
 
+    /**
+     * The bounds on a field which isn't multikey can be intersected even though other fields
+     * of the index are multikey.
+     */
+    TEST_F(QueryPlannerTest, MultikeyPathsIntersectNonMultikeyLeadingField) {
+        MultikeyPaths paths(2, false);
+        paths[1] = true;
+        addIndex(BSON("a" << 1 << "b" << 1), paths);
+        runQuery(fromjson("{a: {$gt: 0, $lt: 5}}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: null, node: {ixscan: {filter: null, "
+                                "pattern: {a: 1, b: 1}, bounds: {a: [[0, 5, false, false]], "
+                                "b: [['MinKey','MaxKey',true,true]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, MultikeyPathsIntersectNonMultikeyTrailingField) {
+        MultikeyPaths paths(2, false);
+        paths[0] = true;
+        addIndex(BSON("a" << 1 << "b" << 1), paths);
+        runQuery(fromjson("{a: 1, b: {$gt: 0, $lt: 5}}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: null, node: {ixscan: {filter: null, "
+                                "pattern: {a: 1, b: 1}, bounds: {a: [[1, 1, true, true]], "
+                                "b: [[0, 5, false, false]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, MultikeyPathsStillNoIntersectOnMultikeyField) {
+        MultikeyPaths paths(2, false);
+        paths[0] = true;
+        addIndex(BSON("a" << 1 << "b" << 1), paths);
+        runQuery(fromjson("{a: {$gt: 0, $lt: 5}}"));
+
+        assertNumSolutions(2U);
+        vector<string> alternates;
+        alternates.push_back("{fetch: {filter: {a: {$lt: 5}}, node: {ixscan: {filter: null, "
+                                "pattern: {a: 1, b: 1}, bounds: {a: [[0, Infinity, false, true]], "
+                                "b: [['MinKey','MaxKey',true,true]]}}}}}");
+        alternates.push_back("{fetch: {filter: {a: {$gt: 0}}, node: {ixscan: {filter: null, "
+                                "pattern: {a: 1, b: 1}, bounds: {a: [[-Infinity, 5, true, false]], "
+                                "b: [['MinKey','MaxKey',true,true]]}}}}}");
+        assertHasOneSolutionOf(alternates);
+    }
+
+    /**
+     * Fields sharing a path prefix can be compounded when one of them isn't multikey, since
+     * the array they would have to come from can't be along that path.
+     */
+    TEST_F(QueryPlannerTest, MultikeyPathsCompoundSharedPrefix) {
+        MultikeyPaths paths(2, false);
+        paths[1] = true;
+        addIndex(BSON("a.b" << 1 << "a.c" << 1), paths);
+        runQuery(fromjson("{'a.b': 2, 'a.c': 3}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: null, node: {ixscan: {filter: null, "
+                                "pattern: {'a.b': 1, 'a.c': 1}, bounds: "
+                                "{'a.b': [[2,2,true,true]], 'a.c': [[3,3,true,true]]}}}}}");
+    }
+
     //
     // Index bounds related tests
     //
@@ -4336,6 +4405,89 @@ namespace {
                                 "{filter: null, pattern: {x: 1}}}}}");
     }
 
+    TEST_F(QueryPlannerTest, NoUncoveredProjectionsAllowedTest) {
+        params.options = QueryPlannerParams::NO_UNCOVERED_PROJECTIONS;
+        runQuerySortProj(fromjson("{a: 1}"), BSONObj(), fromjson("{_id: 0, a: 1}"));
+        assertNumSolutions(0U);
+
+        addIndex(BSON("a" << 1 << "b" << 1));
+
+        runQuerySortProj(fromjson("{a: 1}"), BSONObj(), fromjson("{_id: 0, a: 1, b: 1}"));
+        assertNumSolutions(1U);
+        assertSolutionExists("{proj: {spec: {_id: 0, a: 1, b: 1}, type: 'coveredIndex', node: "
+                                "{ixscan: {filter: null, pattern: {a: 1, b: 1}}}}}");
+
+        // The projection needs a field which is not in the index.
+        runQuerySortProj(fromjson("{a: 1}"), BSONObj(), fromjson("{_id: 0, a: 1, c: 1}"));
+        assertNumSolutions(0U);
+
+        // The filter needs a field which is not in the index.
+        runQuerySortProj(fromjson("{a: 1, c: 1}"), BSONObj(), fromjson("{_id: 0, a: 1}"));
+        assertNumSolutions(0U);
+
+        // Without a projection, the documents are always fetched.
+        runQuerySortProj(fromjson("{a: 1}"), BSONObj(), BSONObj());
+        assertNumSolutions(1U);
+        assertSolutionExists("{fetch: {filter: null, node: {ixscan: "
+                                "{filter: null, pattern: {a: 1, b: 1}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanUnconstrainedLeadingField) {
+        params.options = QueryPlannerParams::INCLUDE_COLLSCAN | QueryPlannerParams::SKIP_SCAN;
+        addIndex(BSON("a" << 1 << "b" << 1));
+        params.indices.back().numLeadingValues = 5;
+
+        runQuery(fromjson("{b: {$gte: 3, $lt: 7}}"));
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: {b: {$gte: 3, $lt: 7}}, node: {ixscan: "
+                                "{pattern: {a: 1, b: 1}, bounds: "
+                                "{a: [['MinKey','MaxKey',true,true]], "
+                                "b: [[3,7,true,false]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanNotUsedWithLeadingFieldPredicate) {
+        params.options = QueryPlannerParams::INCLUDE_COLLSCAN | QueryPlannerParams::SKIP_SCAN;
+        addIndex(BSON("a" << 1 << "b" << 1));
+        params.indices.back().numLeadingValues = 5;
+
+        runQuery(fromjson("{a: {$gt: 1}, b: 3}"));
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: null, node: {ixscan: "
+                                "{pattern: {a: 1, b: 1}, bounds: "
+                                "{a: [[1,Infinity,false,true]], b: [[3,3,true,true]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanNeedsFewLeadingValues) {
+        params.options = QueryPlannerParams::INCLUDE_COLLSCAN | QueryPlannerParams::SKIP_SCAN;
+        addIndex(BSON("a" << 1 << "b" << 1));
+
+        // We don't know how many values 'a' has.
+        runQuery(fromjson("{b: 3}"));
+        assertNumSolutions(1U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+
+        // Too many of them.
+        params.indices.back().numLeadingValues = internalQueryPlannerSkipScanMaxLeadingValues + 1;
+        runQuery(fromjson("{b: 3}"));
+        assertNumSolutions(1U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanMultikeyUsesOnePredicate) {
+        params.options = QueryPlannerParams::INCLUDE_COLLSCAN | QueryPlannerParams::SKIP_SCAN;
+        addIndex(BSON("a" << 1 << "b" << 1), true);
+        params.indices.back().numLeadingValues = 5;
+
+        runQuery(fromjson("{b: {$gte: 3, $lt: 7}}"));
+        assertNumSolutions(2U);
+        assertSolutionExists("{fetch: {filter: {b: {$gte: 3, $lt: 7}}, node: {ixscan: "
+                                "{pattern: {a: 1, b: 1}, bounds: "
+                                "{a: [['MinKey','MaxKey',true,true]], "
+                                "b: [[-Infinity,7,true,false]]}}}}}");
+    }
+
     TEST_F(QueryPlannerTest, NoTableScanBasic) {
         params.options = QueryPlannerParams::NO_TABLE_SCAN;
         runQuery(BSONObj());
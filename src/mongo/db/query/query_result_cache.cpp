@@ -0,0 +1,220 @@
+// query_result_cache.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_result_cache.h"
+
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    // Bytes of results the shared query result cache may hold, in megabytes. 0 turns it off.
+    MONGO_EXPORT_SERVER_PARAMETER(queryResultCacheSizeMB, int, 64);
+
+namespace {
+
+    // Allowance for the list node, hash table slot and string headers of an entry.
+    const size_t kEntryOverheadBytes = 128;
+
+    void appendKeyInt(std::string* key, int n) {
+        key->append(reinterpret_cast<const char*>(&n), sizeof(n));
+    }
+
+    void appendKeyObj(std::string* key, const BSONObj& obj) {
+        if (obj.isEmpty()) {
+            appendKeyInt(key, 0);
+            return;
+        }
+        key->append(obj.objdata(), obj.objsize());
+    }
+
+    QueryResultCache globalQueryResultCache;
+
+} // namespace
+
+    QueryResultCache::QueryResultCache()
+        : _fixedMaxBytes(0),
+          _bytes(0),
+          _hits(0),
+          _misses(0),
+          _staleMisses(0),
+          _inserts(0),
+          _evictions(0) {
+    }
+
+    QueryResultCache::QueryResultCache(size_t maxBytes)
+        : _fixedMaxBytes(maxBytes),
+          _bytes(0),
+          _hits(0),
+          _misses(0),
+          _staleMisses(0),
+          _inserts(0),
+          _evictions(0) {
+        invariant(maxBytes > 0);
+    }
+
+    // static
+    QueryResultCache* QueryResultCache::get() {
+        return &globalQueryResultCache;
+    }
+
+    // static
+    std::string QueryResultCache::makeKey(const StringData& ns, const QueryMessage& q) {
+        std::string key;
+        key.append(ns.rawData(), ns.size());
+        key.append(1, '\0');
+        key.append(1, 'q');
+        appendKeyInt(&key, q.ntoskip);
+        appendKeyInt(&key, q.ntoreturn);
+        appendKeyInt(&key, q.queryOptions);
+        appendKeyObj(&key, q.query);
+        appendKeyObj(&key, q.fields);
+        return key;
+    }
+
+    // static
+    std::string QueryResultCache::makeKey(const StringData& ns, const BSONObj& cmdObj) {
+        std::string key;
+        key.append(ns.rawData(), ns.size());
+        key.append(1, '\0');
+        key.append(1, 'c');
+        // Time limits don't change the results, so don't keep commands differing only in them
+        // apart.
+        BSONObjIterator it(cmdObj);
+        while (it.more()) {
+            const BSONElement e = it.next();
+            if (str::equals(e.fieldName(), "maxTimeMS")) {
+                continue;
+            }
+            key.append(e.rawdata(), e.size());
+        }
+        return key;
+    }
+
+    bool QueryResultCache::lookup(const std::string& key,
+                                  unsigned long long writeEpoch,
+                                  Result* out) {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+
+        EntryMap::iterator found = _index.find(key);
+        if (found == _index.end()) {
+            ++_misses;
+            return false;
+        }
+
+        EntryList::iterator it = found->second;
+        if (it->writeEpoch != writeEpoch) {
+            // Epochs never come back, so the entry can't be served again.
+            _remove(it);
+            ++_staleMisses;
+            return false;
+        }
+
+        _entries.splice(_entries.begin(), _entries, it);
+        *out = it->result;
+        ++_hits;
+        return true;
+    }
+
+    void QueryResultCache::insert(const std::string& key,
+                                  unsigned long long writeEpoch,
+                                  const Result& result) {
+        const size_t maxBytes = _maxBytes();
+
+        boost::lock_guard<boost::mutex> lk(_mutex);
+
+        EntryMap::iterator found = _index.find(key);
+        if (found != _index.end()) {
+            _remove(found->second);
+        }
+
+        const size_t entryBytes = _entryBytes(key, result);
+        if (entryBytes > maxBytes / 4) {
+            return;
+        }
+
+        _entries.push_front(Entry());
+        Entry& entry = _entries.front();
+        entry.key = key;
+        entry.writeEpoch = writeEpoch;
+        entry.result = result;
+        _index[key] = _entries.begin();
+        _bytes += entryBytes;
+        ++_inserts;
+
+        // The parameter may have shrunk since the last insert, so evict as many as it takes.
+        while (_bytes > maxBytes) {
+            _remove(--_entries.end());
+            ++_evictions;
+        }
+    }
+
+    void QueryResultCache::clear() {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        _entries.clear();
+        _index.clear();
+        _bytes = 0;
+    }
+
+    void QueryResultCache::appendStats(BSONObjBuilder* builder) const {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        builder->appendNumber("hits", _hits);
+        builder->appendNumber("misses", _misses);
+        builder->appendNumber("staleMisses", _staleMisses);
+        builder->appendNumber("inserts", _inserts);
+        builder->appendNumber("evictions", _evictions);
+        builder->appendNumber("entries", static_cast<long long>(_entries.size()));
+        builder->appendNumber("bytes", static_cast<long long>(_bytes));
+    }
+
+    // static
+    size_t QueryResultCache::_entryBytes(const std::string& key, const Result& result) {
+        // The key is held by both the entry and the index.
+        return key.size() * 2 + result.data.size() + kEntryOverheadBytes;
+    }
+
+    size_t QueryResultCache::_maxBytes() const {
+        if (_fixedMaxBytes) {
+            return _fixedMaxBytes;
+        }
+        const int sizeMB = queryResultCacheSizeMB;
+        return sizeMB > 0 ? static_cast<size_t>(sizeMB) * 1024 * 1024 : 0;
+    }
+
+    void QueryResultCache::_remove(EntryList::iterator it) {
+        _bytes -= _entryBytes(it->key, it->result);
+        _index.erase(it->key);
+        _entries.erase(it);
+    }
+
+}  // namespace mongo
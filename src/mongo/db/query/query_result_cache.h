@@ -0,0 +1,142 @@
+// query_result_cache.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <list>
+#include <string>
+
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/unordered_map.h"
+
+namespace mongo {
+
+    class QueryMessage;
+
+    /**
+     * Remembers the complete results of queries and aggregations which asked for it, so that
+     * repeating one returns the same bytes without running it again.
+     *
+     * Every result is stored with the write epoch its collection had before it was computed (see
+     * Collection::getWriteEpoch), and is only served while the collection still has that epoch.
+     * As a write moves the epoch on, results are never served once a write may have changed
+     * them, and there is nothing to invalidate eagerly: stale entries are dropped when next
+     * looked up or when they age out. Entries are evicted least recently used first once the
+     * queryResultCacheSizeMB server parameter is exceeded; 0 turns the cache off.
+     */
+    class QueryResultCache {
+        MONGO_DISALLOW_COPYING(QueryResultCache);
+    public:
+        struct Result {
+            Result() : numResults(0) { }
+
+            std::string data; // the result documents, back to back
+            int numResults;
+        };
+
+        /**
+         * Sized by the queryResultCacheSizeMB server parameter.
+         */
+        QueryResultCache();
+
+        /**
+         * Holds at most 'maxBytes' bytes, whatever the server parameter says.
+         */
+        explicit QueryResultCache(size_t maxBytes);
+
+        /**
+         * The cache shared by all the collections of this process.
+         */
+        static QueryResultCache* get();
+
+        /**
+         * Keys for an OP_QUERY and for a command on namespace 'ns'. Everything which can change
+         * the results is part of the key.
+         */
+        static std::string makeKey(const StringData& ns, const QueryMessage& q);
+        static std::string makeKey(const StringData& ns, const BSONObj& cmdObj);
+
+        /**
+         * Results larger than this are not worth caching, as they would push out too much else.
+         */
+        size_t maxResultBytes() const { return _maxBytes() / 4; }
+
+        /**
+         * Fills in 'out' and returns true if results for 'key' were computed while the collection
+         * had write epoch 'writeEpoch'.
+         */
+        bool lookup(const std::string& key, unsigned long long writeEpoch, Result* out);
+
+        /**
+         * Stores results for 'key' computed with the collection at write epoch 'writeEpoch', which
+         * must be read before running the query.
+         */
+        void insert(const std::string& key, unsigned long long writeEpoch, const Result& result);
+
+        void clear();
+
+        void appendStats(BSONObjBuilder* builder) const;
+
+    private:
+        struct Entry {
+            std::string key;
+            unsigned long long writeEpoch;
+            Result result;
+        };
+
+        typedef std::list<Entry> EntryList; // most recently used first
+        typedef unordered_map<std::string, EntryList::iterator> EntryMap;
+
+        static size_t _entryBytes(const std::string& key, const Result& result);
+
+        size_t _maxBytes() const;
+
+        // Must hold _mutex.
+        void _remove(EntryList::iterator it);
+
+        const size_t _fixedMaxBytes; // 0 to follow the server parameter
+
+        mutable boost::mutex _mutex;
+        EntryList _entries;
+        EntryMap _index;
+        size_t _bytes;
+
+        long long _hits;
+        long long _misses;
+        long long _staleMisses; // misses on results computed before the latest write
+        long long _inserts;
+        long long _evictions;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,137 @@
+// query_result_cache_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/query/query_result_cache.h
+ */
+
+#include "mongo/db/query/query_result_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/json.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    static const char* ns = "test.results";
+
+    QueryResultCache::Result makeResult(int numResults, size_t bytes) {
+        QueryResultCache::Result result;
+        result.data.assign(bytes, 'x');
+        result.numResults = numResults;
+        return result;
+    }
+
+    BSONObj getStats(const QueryResultCache& cache) {
+        BSONObjBuilder bob;
+        cache.appendStats(&bob);
+        return bob.obj();
+    }
+
+    TEST(QueryResultCacheTest, HitsOnlyAtTheSameWriteEpoch) {
+        QueryResultCache cache(1024 * 1024);
+        const std::string key =
+            QueryResultCache::makeKey(ns, fromjson("{aggregate: 'results', pipeline: []}"));
+
+        QueryResultCache::Result out;
+        ASSERT_FALSE(cache.lookup(key, 1, &out));
+
+        cache.insert(key, 1, makeResult(3, 100));
+        ASSERT_TRUE(cache.lookup(key, 1, &out));
+        ASSERT_EQUALS(out.numResults, 3);
+        ASSERT_EQUALS(out.data, std::string(100, 'x'));
+
+        // A write moved the epoch on, so the entry is gone for good.
+        ASSERT_FALSE(cache.lookup(key, 2, &out));
+        ASSERT_FALSE(cache.lookup(key, 1, &out));
+
+        BSONObj stats = getStats(cache);
+        ASSERT_EQUALS(stats["hits"].numberLong(), 1);
+        ASSERT_EQUALS(stats["misses"].numberLong(), 2);
+        ASSERT_EQUALS(stats["staleMisses"].numberLong(), 1);
+        ASSERT_EQUALS(stats["inserts"].numberLong(), 1);
+        ASSERT_EQUALS(stats["entries"].numberLong(), 0);
+        ASSERT_EQUALS(stats["bytes"].numberLong(), 0);
+    }
+
+    TEST(QueryResultCacheTest, KeysIgnoreTimeLimits) {
+        const BSONObj cmd = fromjson("{count: 'results', query: {a: 1}}");
+        ASSERT_EQUALS(QueryResultCache::makeKey(ns, cmd),
+                      QueryResultCache::makeKey(ns, fromjson("{count: 'results', query: {a: 1},"
+                                                             " maxTimeMS: 100}")));
+        ASSERT_NOT_EQUALS(QueryResultCache::makeKey(ns, cmd),
+                          QueryResultCache::makeKey(ns, fromjson("{count: 'results',"
+                                                                 " query: {a: 2}}")));
+        ASSERT_NOT_EQUALS(QueryResultCache::makeKey(ns, cmd),
+                          QueryResultCache::makeKey("test.other", cmd));
+    }
+
+    TEST(QueryResultCacheTest, EvictsLeastRecentlyUsed) {
+        // Room for four of the entries below.
+        QueryResultCache cache(4096);
+        std::vector<std::string> keys;
+        for (int i = 0; i < 5; ++i) {
+            keys.push_back(QueryResultCache::makeKey(ns, BSON("n" << i)));
+        }
+
+        QueryResultCache::Result out;
+        cache.insert(keys[0], 1, makeResult(1, 800));
+        cache.insert(keys[1], 1, makeResult(1, 800));
+        cache.insert(keys[2], 1, makeResult(1, 800));
+        // Using the first makes the second the least recently used.
+        ASSERT_TRUE(cache.lookup(keys[0], 1, &out));
+        cache.insert(keys[3], 1, makeResult(1, 800));
+        cache.insert(keys[4], 1, makeResult(1, 800));
+
+        BSONObj stats = getStats(cache);
+        ASSERT_EQUALS(stats["evictions"].numberLong(), 1);
+        ASSERT_EQUALS(stats["entries"].numberLong(), 4);
+        ASSERT_LESS_THAN_OR_EQUALS(stats["bytes"].numberLong(), 4096);
+        ASSERT_FALSE(cache.lookup(keys[1], 1, &out));
+        ASSERT_TRUE(cache.lookup(keys[0], 1, &out));
+        ASSERT_TRUE(cache.lookup(keys[4], 1, &out));
+    }
+
+    TEST(QueryResultCacheTest, SkipsResultsTooBigToCache) {
+        QueryResultCache cache(4096);
+        const std::string key = QueryResultCache::makeKey(ns, fromjson("{n: 1}"));
+
+        cache.insert(key, 1, makeResult(100, 2000));
+
+        QueryResultCache::Result out;
+        ASSERT_FALSE(cache.lookup(key, 1, &out));
+        ASSERT_EQUALS(getStats(cache)["inserts"].numberLong(), 0);
+    }
+
+}  // namespace
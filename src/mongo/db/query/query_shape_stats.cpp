@@ -0,0 +1,142 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_shape_stats.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/query/query_knobs.h"
+
+namespace mongo {
+
+    using std::vector;
+
+    namespace {
+
+        template <typename Iterator>
+        bool moreTotalMicros(const Iterator& lhs, const Iterator& rhs) {
+            return lhs->second.totalMicros > rhs->second.totalMicros;
+        }
+
+    }  // namespace
+
+    QueryShapeStats::Shape::Shape()
+        : count(0),
+          totalMicros(0),
+          maxMicros(0),
+          keysExamined(0),
+          docsExamined(0),
+          nReturned(0),
+          planChanges(0) { }
+
+    QueryShapeStats::QueryShapeStats() : _dropped(0) { }
+
+    void QueryShapeStats::record(const CanonicalQuery& cq,
+                                 long long micros,
+                                 long long keysExamined,
+                                 long long docsExamined,
+                                 long long nReturned,
+                                 const std::string& planSummary) {
+        const PlanCacheKey& key = cq.getPlanCacheKey();
+
+        boost::mutex::scoped_lock lk(_mutex);
+
+        ShapeMap::iterator it = _shapes.find(key);
+        if (it == _shapes.end()) {
+            if (static_cast<long long>(_shapes.size()) >= internalQueryShapeStatsMaxShapes) {
+                _dropped++;
+                return;
+            }
+
+            it = _shapes.insert(std::make_pair(key, Shape())).first;
+            const LiteParsedQuery& pq = cq.getParsed();
+            it->second.query = pq.getFilter().getOwned();
+            it->second.sort = pq.getSort().getOwned();
+            it->second.projection = pq.getProj().getOwned();
+        }
+
+        Shape& shape = it->second;
+        shape.count++;
+        shape.totalMicros += micros;
+        shape.maxMicros = std::max(shape.maxMicros, micros);
+        shape.keysExamined += keysExamined;
+        shape.docsExamined += docsExamined;
+        shape.nReturned += nReturned;
+
+        if (shape.planSummary != planSummary) {
+            if (!shape.planSummary.empty()) {
+                shape.planChanges++;
+            }
+            shape.planSummary = planSummary;
+        }
+    }
+
+    void QueryShapeStats::toBSON(BSONObjBuilder* builder) const {
+        boost::mutex::scoped_lock lk(_mutex);
+
+        vector<ShapeMap::const_iterator> sorted;
+        sorted.reserve(_shapes.size());
+        for (ShapeMap::const_iterator it = _shapes.begin(); it != _shapes.end(); ++it) {
+            sorted.push_back(it);
+        }
+        std::sort(sorted.begin(), sorted.end(), moreTotalMicros<ShapeMap::const_iterator>);
+
+        BSONArrayBuilder shapesBuilder(builder->subarrayStart("shapes"));
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            const Shape& shape = sorted[i]->second;
+
+            BSONObjBuilder shapeBuilder(shapesBuilder.subobjStart());
+            shapeBuilder.append("query", shape.query);
+            shapeBuilder.append("sort", shape.sort);
+            shapeBuilder.append("projection", shape.projection);
+            shapeBuilder.appendNumber("count", shape.count);
+            shapeBuilder.appendNumber("totalMicros", shape.totalMicros);
+            shapeBuilder.appendNumber("maxMicros", shape.maxMicros);
+            shapeBuilder.appendNumber("keysExamined", shape.keysExamined);
+            shapeBuilder.appendNumber("docsExamined", shape.docsExamined);
+            shapeBuilder.appendNumber("nReturned", shape.nReturned);
+            shapeBuilder.appendNumber("planChanges", shape.planChanges);
+            shapeBuilder.append("planSummary", shape.planSummary);
+            shapeBuilder.doneFast();
+        }
+        shapesBuilder.doneFast();
+
+        builder->appendNumber("dropped", _dropped);
+    }
+
+    void QueryShapeStats::clear() {
+        boost::mutex::scoped_lock lk(_mutex);
+        _shapes.clear();
+        _dropped = 0;
+    }
+
+}  // namespace mongo
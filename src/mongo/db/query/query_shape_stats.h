@@ -0,0 +1,109 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/mutex.hpp>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/platform/unordered_map.h"
+
+namespace mongo {
+
+    /**
+     * Execution counters of the queries on a collection, added up by query shape, that is by
+     * the PlanCacheKey of their CanonicalQuery. Lets the queries costing the most be found
+     * without going through the profiler or the logs.
+     *
+     * Keeps at most 'internalQueryShapeStatsMaxShapes' shapes, counting the executions of the
+     * others as dropped.
+     *
+     * Thread safe.
+     */
+    class QueryShapeStats {
+        MONGO_DISALLOW_COPYING(QueryShapeStats);
+    public:
+        QueryShapeStats();
+
+        /**
+         * Adds an execution of 'cq' which took 'micros', examined 'keysExamined' index keys and
+         * 'docsExamined' documents, returned 'nReturned', and used the plan 'planSummary'.
+         */
+        void record(const CanonicalQuery& cq,
+                    long long micros,
+                    long long keysExamined,
+                    long long docsExamined,
+                    long long nReturned,
+                    const std::string& planSummary);
+
+        /**
+         * Appends { shapes: [ { query, sort, projection, count, totalMicros, maxMicros,
+         * keysExamined, docsExamined, nReturned, planChanges, planSummary }, ... ], dropped },
+         * the shapes sorted by decreasing totalMicros.
+         */
+        void toBSON(BSONObjBuilder* builder) const;
+
+        /**
+         * Forgets all the counters.
+         */
+        void clear();
+
+    private:
+        struct Shape {
+            Shape();
+
+            BSONObj query;
+            BSONObj sort;
+            BSONObj projection;
+
+            long long count;
+            long long totalMicros;
+            long long maxMicros;
+            long long keysExamined;
+            long long docsExamined;
+            long long nReturned;
+
+            // How many times the plan used for the shape was not the one used the time before.
+            long long planChanges;
+            std::string planSummary; // of the latest execution
+        };
+
+        typedef unordered_map<PlanCacheKey, Shape> ShapeMap;
+
+        // Protects everything below.
+        mutable boost::mutex _mutex;
+
+        ShapeMap _shapes;
+
+        long long _dropped;
+    };
+
+}  // namespace mongo
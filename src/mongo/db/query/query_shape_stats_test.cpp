@@ -0,0 +1,127 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/query/query_shape_stats.h
+ */
+
+#include "mongo/db/query/query_shape_stats.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/json.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    using boost::scoped_ptr;
+
+    static const char* ns = "somebogusns";
+
+    CanonicalQuery* canonicalize(const char* queryStr) {
+        CanonicalQuery* cq;
+        Status result = CanonicalQuery::canonicalize(ns, fromjson(queryStr), &cq);
+        ASSERT_OK(result);
+        return cq;
+    }
+
+    BSONObj getShapes(const QueryShapeStats& stats) {
+        BSONObjBuilder bob;
+        stats.toBSON(&bob);
+        return bob.obj();
+    }
+
+    TEST(QueryShapeStatsTest, AddsUpQueriesOfTheSameShape) {
+        QueryShapeStats stats;
+        scoped_ptr<CanonicalQuery> first(canonicalize("{a: 1}"));
+        scoped_ptr<CanonicalQuery> second(canonicalize("{a: 5}"));
+        scoped_ptr<CanonicalQuery> other(canonicalize("{b: 1}"));
+
+        stats.record(*first, 100, 10, 5, 1, "IXSCAN { a: 1 }");
+        stats.record(*second, 300, 20, 15, 2, "IXSCAN { a: 1 }");
+        stats.record(*other, 50, 0, 100, 0, "COLLSCAN");
+
+        BSONObj result = getShapes(stats);
+        std::vector<BSONElement> shapes = result["shapes"].Array();
+        ASSERT_EQUALS(shapes.size(), 2U);
+
+        // Costliest first.
+        BSONObj shape = shapes[0].Obj();
+        ASSERT_EQUALS(shape["query"].Obj(), fromjson("{a: 1}"));
+        ASSERT_EQUALS(shape["count"].numberLong(), 2);
+        ASSERT_EQUALS(shape["totalMicros"].numberLong(), 400);
+        ASSERT_EQUALS(shape["maxMicros"].numberLong(), 300);
+        ASSERT_EQUALS(shape["keysExamined"].numberLong(), 30);
+        ASSERT_EQUALS(shape["docsExamined"].numberLong(), 20);
+        ASSERT_EQUALS(shape["nReturned"].numberLong(), 3);
+        ASSERT_EQUALS(shape["planChanges"].numberLong(), 0);
+
+        ASSERT_EQUALS(shapes[1].Obj()["query"].Obj(), fromjson("{b: 1}"));
+    }
+
+    TEST(QueryShapeStatsTest, CountsPlanChanges) {
+        QueryShapeStats stats;
+        scoped_ptr<CanonicalQuery> cq(canonicalize("{a: 1, b: 1}"));
+
+        stats.record(*cq, 1, 1, 1, 1, "IXSCAN { a: 1 }");
+        stats.record(*cq, 1, 1, 1, 1, "IXSCAN { b: 1 }");
+        stats.record(*cq, 1, 1, 1, 1, "IXSCAN { b: 1 }");
+        stats.record(*cq, 1, 1, 1, 1, "IXSCAN { a: 1 }");
+
+        BSONObj shape = getShapes(stats)["shapes"].Array()[0].Obj();
+        ASSERT_EQUALS(shape["planChanges"].numberLong(), 2);
+        ASSERT_EQUALS(shape["planSummary"].String(), "IXSCAN { a: 1 }");
+    }
+
+    TEST(QueryShapeStatsTest, DropsShapesOverTheLimit) {
+        const int oldMaxShapes = internalQueryShapeStatsMaxShapes;
+        internalQueryShapeStatsMaxShapes = 1;
+
+        QueryShapeStats stats;
+        scoped_ptr<CanonicalQuery> first(canonicalize("{a: 1}"));
+        scoped_ptr<CanonicalQuery> other(canonicalize("{b: 1}"));
+        stats.record(*first, 1, 1, 1, 1, "");
+        stats.record(*other, 1, 1, 1, 1, "");
+        stats.record(*first, 1, 1, 1, 1, "");
+
+        BSONObj result = getShapes(stats);
+        ASSERT_EQUALS(result["shapes"].Array().size(), 1U);
+        ASSERT_EQUALS(result["dropped"].numberLong(), 1);
+
+        stats.clear();
+        result = getShapes(stats);
+        ASSERT_EQUALS(result["shapes"].Array().size(), 0U);
+        ASSERT_EQUALS(result["dropped"].numberLong(), 0);
+
+        internalQueryShapeStatsMaxShapes = oldMaxShapes;
+    }
+
+}  // namespace
@@ -76,6 +76,10 @@ namespace mongo {
         *ss << "language = " << language << '\n';
         addIndent(ss, indent + 1);
         *ss << "indexPrefix = " << indexPrefix.toString() << '\n';
+        if (0 != limit) {
+            addIndent(ss, indent + 1);
+            *ss << "limit = " << limit << '\n';
+        }
         if (NULL != filter) {
             addIndent(ss, indent + 1);
             *ss << " filter = " << filter->toString();
@@ -92,6 +96,7 @@ namespace mongo {
         copy->query = this->query;
         copy->language = this->language;
         copy->indexPrefix = this->indexPrefix;
+        copy->limit = this->limit;
 
         return copy;
     }
@@ -721,6 +726,7 @@ namespace mongo {
         copy->indexKeyPattern = this->indexKeyPattern;
         copy->addPointMeta = this->addPointMeta;
         copy->addDistMeta = this->addDistMeta;
+        copy->numWanted = this->numWanted;
 
         return copy;
     }
@@ -754,6 +760,7 @@ namespace mongo {
         copy->indexKeyPattern = this->indexKeyPattern;
         copy->addPointMeta = this->addPointMeta;
         copy->addDistMeta = this->addDistMeta;
+        copy->numWanted = this->numWanted;
 
         return copy;
     }
@@ -218,7 +218,7 @@ namespace mongo {
     };
 
     struct TextNode : public QuerySolutionNode {
-        TextNode() { }
+        TextNode() : limit(0) { }
         virtual ~TextNode() { }
 
         virtual StageType getType() const { return STAGE_TEXT; }
@@ -244,6 +244,10 @@ namespace mongo {
         // text node while creating the text leaf node and convert them into a BSONObj index prefix
         // when we finish the text leaf node.
         BSONObj indexPrefix;
+
+        // Set when a top-k sort on the text score sits directly above this node, which then only
+        // needs to produce the best 'limit' results.  Zero otherwise.
+        size_t limit;
     };
 
     struct CollectionScanNode : public QuerySolutionNode {
@@ -568,7 +572,7 @@ namespace mongo {
 
     // This is a standalone stage.
     struct GeoNear2DNode : public QuerySolutionNode {
-        GeoNear2DNode() : addPointMeta(false), addDistMeta(false) { }
+        GeoNear2DNode() : addPointMeta(false), addDistMeta(false), numWanted(0) { }
         virtual ~GeoNear2DNode() { }
 
         virtual StageType getType() const { return STAGE_GEO_NEAR_2D; }
@@ -590,11 +594,14 @@ namespace mongo {
         BSONObj indexKeyPattern;
         bool addPointMeta;
         bool addDistMeta;
+
+        // Skip plus numToReturn of the query, or zero if not given. Only a sizing hint.
+        size_t numWanted;
     };
 
     // This is actually its own standalone stage.
     struct GeoNear2DSphereNode : public QuerySolutionNode {
-        GeoNear2DSphereNode() : addPointMeta(false), addDistMeta(false) { }
+        GeoNear2DSphereNode() : addPointMeta(false), addDistMeta(false), numWanted(0) { }
         virtual ~GeoNear2DSphereNode() { }
 
         virtual StageType getType() const { return STAGE_GEO_NEAR_2DSPHERE; }
@@ -616,6 +623,9 @@ namespace mongo {
         BSONObj indexKeyPattern;
         bool addPointMeta;
         bool addDistMeta;
+
+        // Skip plus numToReturn of the query, or zero if not given. Only a sizing hint.
+        size_t numWanted;
     };
 
     //
@@ -56,15 +56,20 @@ namespace mongo {
             return;
         }
 
-        // Top-level locks are freed, release any potential low-level (storage engine-specific
-        // locks). If we are yielding, we are at a safe place to do so.
-        txn->recoveryUnit()->commitAndRestart();
+        {
+            // Waiting to get the locks back counts as lock wait time, not as part of the yield.
+            CurOp::TimeScope yieldTime(txn->getCurOp(), CurOp::kYieldTime);
 
-        // Track the number of yields in CurOp.
-        txn->getCurOp()->yielded();
+            // Top-level locks are freed, release any potential low-level (storage
+            // engine-specific locks). If we are yielding, we are at a safe place to do so.
+            txn->recoveryUnit()->commitAndRestart();
 
-        if (fetcher) {
-            fetcher->fetch();
+            // Track the number of yields in CurOp.
+            txn->getCurOp()->yielded();
+
+            if (fetcher) {
+                fetcher->fetch();
+            }
         }
 
         locker->restoreLockState(snapshot);
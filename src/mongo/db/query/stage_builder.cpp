@@ -51,6 +51,7 @@
 #include "mongo/db/index/fts_access_method.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
@@ -98,6 +99,12 @@ namespace mongo {
             const FetchNode* fn = static_cast<const FetchNode*>(root);
             PlanStage* childStage = buildStages(txn, collection, qsol, fn->children[0], ws);
             if (NULL == childStage) { return NULL; }
+
+            // The fetch replaces any index keys with the document, and filters on that.
+            if (STAGE_AND_HASH == fn->children[0]->getType()
+                && NULL == fn->children[0]->filter.get()) {
+                static_cast<AndHashStage*>(childStage)->setOnlyRecordIdsNeeded();
+            }
             return new FetchStage(txn, ws, childStage, fn->filter.get(), collection);
         }
         else if (STAGE_SORT == root->getType()) {
@@ -109,6 +116,7 @@ namespace mongo {
             params.pattern = sn->pattern;
             params.query = sn->query;
             params.limit = sn->limit;
+            params.allowDiskUse = internalQueryExecAllowBlockingSortSpill;
             return new SortStage(params, ws, childStage);
         }
         else if (STAGE_PROJECTION == root->getType()) {
@@ -200,6 +208,7 @@ namespace mongo {
             params.filter = node->filter.get();
             params.addPointMeta = node->addPointMeta;
             params.addDistMeta = node->addDistMeta;
+            params.numWanted = node->numWanted;
 
             IndexDescriptor* twoDIndex = collection->getIndexCatalog()->findIndexByKeyPattern(txn,
                                                                                               node->indexKeyPattern);
@@ -223,6 +232,7 @@ namespace mongo {
             params.filter = node->filter.get();
             params.addPointMeta = node->addPointMeta;
             params.addDistMeta = node->addDistMeta;
+            params.numWanted = node->numWanted;
 
             IndexDescriptor* s2Index = collection->getIndexCatalog()->findIndexByKeyPattern(txn,
                                                                                             node->indexKeyPattern);
@@ -257,6 +267,7 @@ namespace mongo {
             params.index = index;
             params.spec = fam->getSpec();
             params.indexPrefix = node->indexPrefix;
+            params.limit = node->limit;
 
             const std::string& language = ("" == node->language
                                            ? fam->getSpec().defaultLanguage().str()
@@ -32,19 +32,108 @@
 
 #include "mongo/db/range_deleter_db_env.h"
 
+#include <algorithm>
+
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/dbhelpers.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/operation_context.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/write_concern_options.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/d_state.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/token_bucket.h"
 
 namespace mongo {
 
+    // Most documents deleted under one acquisition of the collection lock
+    MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterBatchSize, int, 100);
+
+    // Limits on the rate of the deletes of all the range deleter threads together, zero for no
+    // limit
+    MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterMaxDocsPerSecond, int, 0);
+    MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterMaxBytesPerSecond, long long, 0);
+
+namespace {
+
+    // Longest sleep between two checks for interruption while throttled
+    const long long kMaxThrottleSleepMicros = 100 * 1000;
+
+    /**
+     * Shares the docs/sec and bytes/sec budgets between all the deletes of ranges.
+     */
+    class DeleteThrottle : public Helpers::RemoveRangeThrottle {
+    public:
+        DeleteThrottle() : _mutex("RangeDeleterThrottle") {}
+
+        virtual long long getBatchSize() {
+            return rangeDeleterBatchSize;
+        }
+
+        virtual void batchDone(OperationContext* txn, long long docs, long long bytes) {
+            _deletedDocs.fetchAndAdd(docs);
+            _deletedBytes.fetchAndAdd(bytes);
+            _batches.fetchAndAdd(1);
+
+            long long waitMicros;
+            {
+                SimpleMutex::scoped_lock sl(_mutex);
+                const long long now = curTimeMicros64();
+
+                _docsBucket.setRate(rangeDeleterMaxDocsPerSecond);
+                _bytesBucket.setRate(rangeDeleterMaxBytesPerSecond);
+                waitMicros = std::max(_docsBucket.consume(docs, now),
+                                      _bytesBucket.consume(bytes, now));
+            }
+
+            if (waitMicros <= 0) {
+                return;
+            }
+
+            _throttledMicros.fetchAndAdd(waitMicros);
+
+            // Sleep in slices, so killOp and shutdown are not held up by a low budget
+            while (waitMicros > 0) {
+                txn->checkForInterrupt();
+                const long long sleepMicros = std::min(waitMicros, kMaxThrottleSleepMicros);
+                sleepmicros(sleepMicros);
+                waitMicros -= sleepMicros;
+            }
+        }
+
+        void appendStats(BSONObjBuilder* builder) const {
+            builder->append("deletedDocs", static_cast<long long>(_deletedDocs.load()));
+            builder->append("deletedBytes", static_cast<long long>(_deletedBytes.load()));
+            builder->append("batches", static_cast<long long>(_batches.load()));
+            builder->append("throttledMillis",
+                            static_cast<long long>(_throttledMicros.load() / 1000));
+        }
+
+    private:
+        // Protects the buckets
+        SimpleMutex _mutex;
+        TokenBucket _docsBucket;
+        TokenBucket _bytesBucket;
+
+        AtomicInt64 _deletedDocs;
+        AtomicInt64 _deletedBytes;
+        AtomicInt64 _batches;
+        AtomicInt64 _throttledMicros;
+    };
+
+    DeleteThrottle deleteThrottle;
+
+} // namespace
+
     void RangeDeleterDBEnv::initThread() {
         if ( currentClient.get() == NULL )
             Client::initThread( "RangeDeleter" );
@@ -57,7 +146,7 @@ namespace mongo {
      * 2. Grant this thread authorization to perform deletes.
      * 3. Temporarily enable mode to bypass shard version checks. TODO: Replace this hack.
      * 4. Setup callback to save deletes to moveChunk directory (only if moveParanoia is true).
-     * 5. Delete range.
+     * 5. Delete range, in batches paced by the rangeDeleter* server parameters.
      * 6. Wait until the majority of the secondaries catch up.
      */
     bool RangeDeleterDBEnv::deleteRange(OperationContext* txn,
@@ -109,7 +198,8 @@ namespace mongo {
                                              writeConcern,
                                              removeSaverPtr,
                                              fromMigrate,
-                                             onlyRemoveOrphans);
+                                             onlyRemoveOrphans,
+                                             &deleteThrottle);
 
                 if (*deletedDocs < 0) {
                     *errMsg = "collection or index dropped before data could be cleaned";
@@ -161,4 +251,8 @@ namespace mongo {
 
         collection->getCursorManager()->getCursorIds( openCursors );
     }
+
+    void RangeDeleterDBEnv::appendDeleteStats(BSONObjBuilder* builder) {
+        deleteThrottle.appendStats(builder);
+    }
 }
@@ -64,5 +64,11 @@ namespace mongo {
         virtual void getCursorIds(OperationContext* txn,
                                   const StringData& ns,
                                   std::set<CursorId>* openCursors);
+
+        /**
+         * Appends the number of documents and bytes deleted so far, the number of batches
+         * and the time spent waiting for the rate limits.
+         */
+        static void appendDeleteStats(BSONObjBuilder* builder);
     };
 }
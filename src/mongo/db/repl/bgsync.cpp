@@ -44,6 +44,7 @@
 #include "mongo/db/repl/replication_coordinator_impl.h"
 #include "mongo/db/repl/rs_rollback.h"
 #include "mongo/db/repl/rs_sync.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
@@ -57,8 +58,19 @@ namespace {
     const char hashFieldName[] = "h";
     int SleepToAllowBatchingMillis = 2;
     const int BatchIsSmallish = 40000; // bytes
+
+    // When streaming the oplog in exhaust mode, stop reading from the sync source once the buffer
+    // is more than this full, and start again once it has drained below the low water mark. The
+    // batches the sync source keeps sending wait in the socket buffers meanwhile, which makes it
+    // block until we catch up.
+    const double BufferHighWaterMark = 0.75;
+    const double BufferLowWaterMark = 0.5;
 } // namespace
 
+    // Tail the oplog of the sync source in exhaust mode, so it sends the batches without waiting
+    // for a getmore round trip each time.
+    MONGO_EXPORT_SERVER_PARAMETER(bgSyncOplogFetcherExhaust, bool, true);
+
     MONGO_FP_DECLARE(rsBgSyncProduce);
 
     BackgroundSync* BackgroundSync::s_instance = 0;
@@ -105,6 +117,7 @@ namespace {
                                        _lastAppliedHash(0),
                                        _lastFetchedHash(0),
                                        _pause(true),
+                                       _fetchingSuspended(false),
                                        _appliedBuffer(true),
                                        _replCoord(getGlobalReplicationCoordinator()),
                                        _initialSyncRequestedFlag(false),
@@ -187,9 +200,21 @@ namespace {
             sleepsecs(1);
             return;
         }
+
+        // Initial sync may still be applying oplog entries it fetched during its clone. We
+        // start after the last of them.
+        {
+            boost::unique_lock<boost::mutex> lock(_mutex);
+            if (_fetchingSuspended) {
+                lock.unlock();
+                sleepsecs(1);
+                return;
+            }
+        }
+
         // we want to unpause when we're no longer primary
         // start() also loads _lastOpTimeFetched, which we know is set from the "if"
-        else if (_pause) {
+        if (_pause) {
             start(&txn);
         }
 
@@ -260,6 +285,13 @@ namespace {
             return;
         }
 
+        // The rollback check above may need to query the sync source over the same connection,
+        // so only switch to an exhaust cursor once it has passed.
+        const bool exhaust = bgSyncOplogFetcherExhaust;
+        if (exhaust && !_startExhaustCursor(lastOpTimeFetched)) {
+            return;
+        }
+
         while (!inShutdown()) {
             if (!_syncSourceReader.moreInCurrentBatch()) {
                 // Check some things periodically
@@ -267,7 +299,14 @@ namespace {
                 // current cursor batch)
 
                 int bs = _syncSourceReader.currentBatchMessageSize();
-                if( bs > 0 && bs < BatchIsSmallish ) {
+                if (exhaust) {
+                    // The sync source keeps sending batches as they fill up, so there is no round
+                    // trip to save by waiting. Stop reading while the applier is behind instead.
+                    if (!_waitForBufferToDrain()) {
+                        return;
+                    }
+                }
+                else if( bs > 0 && bs < BatchIsSmallish ) {
                     // on a very low latency network, if we don't wait a little, we'll be 
                     // getting ops to write almost one at a time.  this will both be expensive
                     // for the upstream server as well as potentially defeating our parallel 
@@ -295,8 +334,8 @@ namespace {
                     //record time for each getmore
                     TimerHolder batchTimer(&getmoreReplStats);
                     
-                    // This calls receiveMore() on the oplogreader cursor.
-                    // It can wait up to five seconds for more data.
+                    // This calls receiveMore() on the oplogreader cursor, or just receives the
+                    // next batch when exhausting. It can wait up to five seconds for more data.
                     _syncSourceReader.more();
                 }
                 networkByteStats.increment(_syncSourceReader.currentBatchMessageSize());
@@ -356,6 +395,56 @@ namespace {
         }
     }
 
+    bool BackgroundSync::_startExhaustCursor(const OpTime& lastOpTimeFetched) {
+        long long lastFetchedHash;
+        {
+            boost::unique_lock<boost::mutex> lock(_mutex);
+            lastFetchedHash = _lastFetchedHash;
+        }
+
+        _syncSourceReader.resetCursor();
+        _syncSourceReader.exhaustTailingQueryGTE(rsoplog, lastOpTimeFetched);
+        if (!_syncSourceReader.haveCursor() || !_syncSourceReader.more()) {
+            return false;
+        }
+
+        // The sync source could have rolled back since the first query. If so, go around again
+        // and let _rollbackIfNeeded() deal with it over a fresh connection.
+        BSONObj o = _syncSourceReader.nextSafe();
+        if (o["ts"]._opTime() != lastOpTimeFetched ||
+                o[hashFieldName].numberLong() != lastFetchedHash) {
+            log() << "replSet sync source's oplog changed before streaming began, retrying";
+            return false;
+        }
+
+        LOG(1) << "replSet streaming oplog from " << _syncSourceReader.getHost()
+               << " starting after " << lastOpTimeFetched.toStringPretty();
+        return true;
+    }
+
+    bool BackgroundSync::_waitForBufferToDrain() {
+        const size_t maxSize = _buffer.maxSize();
+        if (_buffer.size() < maxSize * BufferHighWaterMark) {
+            return true;
+        }
+
+        LOG(2) << "replSet bgsync buffer has " << _buffer.size()
+               << " bytes, waiting for it to drain before reading more";
+        while (!_buffer.waitForSizeBelow(maxSize * BufferLowWaterMark, 1)) {
+            if (inShutdown() ||
+                    _replCoord->isWaitingForApplierToDrain() ||
+                    _replCoord->getMemberState().primary()) {
+                return false;
+            }
+
+            boost::unique_lock<boost::mutex> lock(_mutex);
+            if (_pause) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     bool BackgroundSync::shouldChangeSyncSource() {
         // is it even still around?
         if (getSyncTarget().empty() || _syncSourceReader.getHost().empty()) {
@@ -433,6 +522,11 @@ namespace {
         return _syncSourceHost;
     }
 
+    OpTime BackgroundSync::getLastOpTimeFetched() const {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        return _lastOpTimeFetched;
+    }
+
     void BackgroundSync::clearSyncTarget() {
         boost::unique_lock<boost::mutex> lock(_mutex);
         _syncSourceHost = HostAndPort();
@@ -521,6 +615,11 @@ namespace {
         _initialSyncRequestedFlag = value;
     }
 
+    void BackgroundSync::setFetchingSuspended(bool suspended) {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        _fetchingSuspended = suspended;
+    }
+
 
 } // namespace repl
 } // namespace mongo
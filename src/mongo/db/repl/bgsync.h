@@ -91,6 +91,9 @@ namespace repl {
 
         HostAndPort getSyncTarget();
 
+        // The newest op fetched from the sync source, which may still be in the buffer.
+        OpTime getLastOpTimeFetched() const;
+
         // Interface implementation
 
         virtual bool peek(BSONObj* op);
@@ -108,6 +111,10 @@ namespace repl {
         bool getInitialSyncRequestedFlag();
         void setInitialSyncRequestedFlag(bool value);
 
+        // While set, the producer thread does not fetch, even once initial sync has primed the
+        // oplog. Initial sync sets it while it applies oplog entries it fetched on its own.
+        void setFetchingSuspended(bool suspended);
+
         void setIndexPrefetchConfig(const IndexPrefetchConfig cfg) {
             _indexPrefetchConfig = cfg;
         }
@@ -138,6 +145,8 @@ namespace repl {
 
         // if produce thread should be running
         bool _pause;
+        // if initial sync is fetching for itself; see setFetchingSuspended()
+        bool _fetchingSuspended;
         bool _appliedBuffer;
         boost::condition _condvar;
 
@@ -153,6 +162,12 @@ namespace repl {
         void produce(OperationContext* txn);
         // Checks the criteria for rolling back and executes a rollback if warranted.
         bool _rollbackIfNeeded(OperationContext* txn, OplogReader& r);
+        // Replaces the cursor on the sync source with an exhaust one starting at
+        // lastOpTimeFetched. Returns false if that op is not the first one anymore.
+        bool _startExhaustCursor(const OpTime& lastOpTimeFetched);
+        // Waits for the applier to drain the buffer if it is nearly full. Returns false if we
+        // should stop fetching instead.
+        bool _waitForBufferToDrain();
 
         // Evaluate if the current sync target is still good
         bool shouldChangeSyncSource();
@@ -0,0 +1,323 @@
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kReplication
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/initial_sync_oplog_buffer.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/client.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/repl/oplog.h"
+#include "mongo/db/repl/oplogreader.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace repl {
+
+namespace {
+
+    // How many entries the applier reads from the collection at a time.
+    const int kEntriesPerLoad = 1000;
+
+    // How many times in a row the fetcher reconnects to the sync source before giving up.
+    const int kMaxReconnects = 3;
+
+} // namespace
+
+    const char InitialSyncOplogBuffer::kNamespace[] = "local.temp_oplog_buffer";
+
+    InitialSyncOplogBuffer::InitialSyncOplogBuffer(OperationContext* txn,
+                                                   BackgroundSync* bgsync,
+                                                   const HostAndPort& syncSource,
+                                                   const BSONObj& startOp)
+        : _txn(txn),
+          _bgsync(bgsync),
+          _syncSource(syncSource),
+          _startOpTime(startOp["ts"]._opTime()),
+          _startHash(startOp["h"].numberLong()),
+          _lastLoaded(_startOpTime),
+          _lastFetched(_startOpTime),
+          _numFetched(0),
+          _fetchStatus(Status::OK()),
+          _stopRequested(false) {
+
+        _bgsync->setFetchingSuspended(true);
+    }
+
+    InitialSyncOplogBuffer::~InitialSyncOplogBuffer() {
+        _stopFetching();
+        _bgsync->setFetchingSuspended(false);
+    }
+
+    void InitialSyncOplogBuffer::startFetching() {
+        invariant(!_fetcher);
+        _resetCollection(true);
+
+        log() << "initial sync buffering oplog entries from " << _syncSource.toString()
+              << " after " << _startOpTime.toStringPretty() << " in " << kNamespace;
+        _fetcher.reset(new boost::thread(
+                boost::bind(&InitialSyncOplogBuffer::_fetcherThread, this)));
+    }
+
+    void InitialSyncOplogBuffer::finish() {
+        _stopFetching();
+        _resetCollection(false);
+        _loaded.clear();
+    }
+
+    bool InitialSyncOplogBuffer::peek(BSONObj* op) {
+        if (_loaded.empty()) {
+            {
+                boost::lock_guard<boost::mutex> lk(_mutex);
+                if (!(_lastLoaded < _lastFetched)) {
+                    return false;
+                }
+            }
+
+            _load();
+            if (_loaded.empty()) {
+                return false;
+            }
+        }
+
+        *op = _loaded.front();
+        return true;
+    }
+
+    void InitialSyncOplogBuffer::consume() {
+        invariant(!_loaded.empty());
+        _loaded.pop_front();
+    }
+
+    void InitialSyncOplogBuffer::waitForMore() {
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        if (_lastLoaded < _lastFetched) {
+            return;
+        }
+
+        if (!_fetchStatus.isOK()) {
+            uasserted(28649,
+                      str::stream() << "initial sync stopped buffering the sync source's oplog "
+                                    << "after " << _lastFetched.toStringPretty() << ": "
+                                    << _fetchStatus.toString());
+        }
+
+        _fetchedMore.timed_wait(lk, boost::posix_time::seconds(1));
+    }
+
+    void InitialSyncOplogBuffer::_fetcherThread() {
+        Client::initThread("initialSyncOplogFetcher");
+        cc().getAuthorizationSession()->grantInternalAuthorization();
+
+        Status status = Status::OK();
+        try {
+            _fetch();
+            if (inShutdown()) {
+                status = Status(ErrorCodes::ShutdownInProgress, "shutting down");
+            }
+        }
+        catch (const DBException& e) {
+            status = e.toStatus();
+        }
+        catch (const std::exception& e) {
+            status = Status(ErrorCodes::InternalError, e.what());
+        }
+
+        {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            if (!status.isOK()) {
+                error() << "initial sync failed to buffer oplog entries after "
+                        << _lastFetched.toStringPretty() << ": " << status;
+            }
+            else {
+                LOG(1) << "initial sync buffered " << _numFetched << " oplog entries, up to "
+                       << _lastFetched.toStringPretty();
+            }
+            _fetchStatus = status;
+        }
+        _fetchedMore.notify_all();
+
+        cc().shutdown();
+    }
+
+    void InitialSyncOplogBuffer::_fetch() {
+        OperationContextImpl txn;
+        OplogReader reader;
+        OpTime lastFetched = _startOpTime;
+        long long lastHash = _startHash;
+        int reconnects = 0;
+
+        while (!_shouldStopFetching()) {
+            try {
+                if (!reader.haveCursor()) {
+                    // Start from the last op fetched, and check that the sync source still
+                    // has it. Otherwise its oplog rolled over or back since, and the ops in
+                    // between are lost.
+                    reader.resetConnection();
+                    uassert(28647,
+                            str::stream() << "couldn't connect to " << _syncSource.toString(),
+                            reader.connect(_syncSource));
+                    reader.tailingQueryGTE(rsoplog, lastFetched);
+                    uassert(28646,
+                            str::stream() << _syncSource.toString() << " no longer has oplog "
+                                          << "entry " << lastFetched.toStringPretty(),
+                            reader.haveCursor() && reader.more());
+
+                    const BSONObj first = reader.nextSafe();
+                    uassert(28648,
+                            str::stream() << "oplog entry " << lastFetched.toStringPretty()
+                                          << " on " << _syncSource.toString()
+                                          << " has changed, it may have rolled back",
+                            first["ts"]._opTime() == lastFetched &&
+                            first["h"].numberLong() == lastHash);
+                }
+
+                if (!reader.more()) {
+                    reader.tailCheck();
+                    continue;
+                }
+
+                std::vector<BSONObj> batch;
+                while (reader.moreInCurrentBatch()) {
+                    const BSONObj op = reader.nextSafe();
+
+                    BSONObjBuilder entry;
+                    entry.appendAs(op["ts"], "_id");
+                    entry.append("op", op);
+                    batch.push_back(entry.obj());
+
+                    lastFetched = op["ts"]._opTime();
+                    lastHash = op["h"].numberLong();
+                }
+
+                _insert(&txn, batch);
+                reconnects = 0;
+
+                {
+                    boost::lock_guard<boost::mutex> lk(_mutex);
+                    _lastFetched = lastFetched;
+                    _numFetched += batch.size();
+                }
+                _fetchedMore.notify_all();
+            }
+            catch (const SocketException& e) {
+                if (++reconnects > kMaxReconnects) {
+                    throw;
+                }
+
+                log() << "initial sync lost its connection to " << _syncSource.toString()
+                      << " while buffering oplog entries, reconnecting: " << e.toString();
+                reader.resetConnection();
+                sleepsecs(1);
+            }
+        }
+    }
+
+    void InitialSyncOplogBuffer::_insert(OperationContext* txn,
+                                         const std::vector<BSONObj>& ops) {
+        ScopedTransaction transaction(txn, MODE_IX);
+        AutoGetDb autoDb(txn, "local", MODE_X);
+        Collection* collection = autoDb.getDb() ?
+                autoDb.getDb()->getCollection(kNamespace) : NULL;
+        uassert(28650,
+                str::stream() << kNamespace << " was dropped while initial sync was using it",
+                collection);
+
+        WriteUnitOfWork wunit(txn);
+        std::vector<RecordId> locs;
+        uassertStatusOK(collection->insertDocuments(txn, ops, false, &locs));
+        wunit.commit();
+    }
+
+    void InitialSyncOplogBuffer::_load() {
+        BSONObjBuilder gt;
+        gt.appendTimestamp("$gt", _lastLoaded.asDate());
+        Query query(BSON("_id" << gt.obj()));
+        query.sort(BSON("_id" << 1));
+
+        DBDirectClient client(_txn);
+        std::auto_ptr<DBClientCursor> cursor = client.query(kNamespace, query, kEntriesPerLoad);
+        uassert(28651, str::stream() << "couldn't read " << kNamespace, cursor.get());
+
+        while (cursor->more()) {
+            const BSONObj entry = cursor->nextSafe();
+            _loaded.push_back(entry["op"].Obj().getOwned());
+            _lastLoaded = entry["_id"]._opTime();
+        }
+    }
+
+    bool InitialSyncOplogBuffer::_shouldStopFetching() {
+        if (inShutdown()) {
+            return true;
+        }
+
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        return _stopRequested;
+    }
+
+    void InitialSyncOplogBuffer::_stopFetching() {
+        if (!_fetcher) {
+            return;
+        }
+
+        {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            _stopRequested = true;
+        }
+        _fetcher->join();
+        _fetcher.reset();
+    }
+
+    void InitialSyncOplogBuffer::_resetCollection(bool recreate) {
+        AutoGetOrCreateDb autoDb(_txn, "local", MODE_X);
+        Database* db = autoDb.getDb();
+
+        WriteUnitOfWork wunit(_txn);
+        if (db->getCollection(kNamespace)) {
+            uassertStatusOK(db->dropCollection(_txn, kNamespace));
+        }
+        if (recreate) {
+            invariant(db->createCollection(_txn, kNamespace));
+        }
+        wunit.commit();
+    }
+
+} // namespace repl
+} // namespace mongo
@@ -0,0 +1,149 @@
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+#include <deque>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/bson/optime.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/repl/bgsync.h"
+#include "mongo/util/net/hostandport.h"
+
+namespace boost {
+    class thread;
+}
+
+namespace mongo {
+
+    class OperationContext;
+
+namespace repl {
+
+    /**
+     * Copies the sync source's oplog into a local collection while initial sync clones, and
+     * feeds the copied entries to the initial sync applier afterwards.
+     *
+     * Without it, initial sync fetches the oplog only once the clone is done, starting from
+     * the op it recorded before the clone. If the clone takes longer than the sync source's
+     * oplog window, that op is gone by then and initial sync has to start over. Entries
+     * copied here are not lost when the sync source's oplog rolls over.
+     *
+     * The BackgroundSync fetcher is suspended for the lifetime of the buffer, since the
+     * applier gets its entries from here instead. Once the buffer is destroyed, BackgroundSync
+     * picks up from the last op initial sync applied.
+     *
+     * The methods of BackgroundSyncInterface must be called from the thread that constructed
+     * the buffer, and use its OperationContext.
+     */
+    class InitialSyncOplogBuffer : public BackgroundSyncInterface {
+        MONGO_DISALLOW_COPYING(InitialSyncOplogBuffer);
+    public:
+        // The local collection holding the copied entries.
+        static const char kNamespace[];
+
+        /**
+         * 'startOp' is the op on 'syncSource' that initial sync applies first, on its own. Only
+         * the entries after it are buffered.
+         */
+        InitialSyncOplogBuffer(OperationContext* txn,
+                               BackgroundSync* bgsync,
+                               const HostAndPort& syncSource,
+                               const BSONObj& startOp);
+
+        /**
+         * Stops fetching, if finish() hasn't already, and lets BackgroundSync run again.
+         */
+        virtual ~InitialSyncOplogBuffer();
+
+        /**
+         * Replaces any collection left over from an earlier attempt with an empty one and
+         * starts copying entries from the sync source on a thread of its own.
+         */
+        void startFetching();
+
+        /**
+         * Stops fetching and drops the collection. Entries fetched but not yet applied are
+         * discarded; BackgroundSync fetches them again.
+         */
+        void finish();
+
+        // BackgroundSyncInterface, for the applier.
+
+        virtual bool peek(BSONObj* op);
+        virtual void consume();
+
+        // Throws if fetching has failed and all the entries fetched before have been applied,
+        // since no more will come.
+        virtual void waitForMore();
+
+    private:
+        void _fetcherThread();
+        void _fetch();
+
+        // Appends 'ops' to the collection. Called on the fetcher thread.
+        void _insert(OperationContext* txn, const std::vector<BSONObj>& ops);
+
+        // Reads the next entries after _lastLoaded from the collection into _loaded.
+        void _load();
+
+        bool _shouldStopFetching();
+        void _stopFetching();
+        // Drops the collection if it exists, and creates an empty one if 'recreate' is set.
+        void _resetCollection(bool recreate);
+
+        OperationContext* const _txn;
+        BackgroundSync* const _bgsync;
+        const HostAndPort _syncSource;
+        const OpTime _startOpTime;
+        const long long _startHash;
+
+        boost::scoped_ptr<boost::thread> _fetcher;
+
+        // Entries read from the collection but not applied yet, and the newest of them. Only
+        // used by the applier.
+        std::deque<BSONObj> _loaded;
+        OpTime _lastLoaded;
+
+        // Protects the members below, which are shared with the fetcher thread.
+        boost::mutex _mutex;
+        boost::condition _fetchedMore;
+        OpTime _lastFetched;
+        long long _numFetched;
+        Status _fetchStatus;
+        bool _stopRequested;
+    };
+
+} // namespace repl
+} // namespace mongo
@@ -58,6 +58,7 @@ namespace {
     const std::string kTagsFieldName = "tags";
     const std::string kMeFieldName = "me";
     const std::string kElectionIdFieldName = "electionId";
+    const std::string kLastWriteFieldName = "lastWrite";
 
     // field name constants that don't directly correspond to member variables
     const std::string kInfoFieldName = "info";
@@ -164,6 +165,8 @@ namespace {
         builder->append(kMeFieldName, _me.toString());
         if (_electionId.isSet())
             builder->append(kElectionIdFieldName, _electionId);
+        if (!_lastWrite.isNull())
+            builder->appendTimestamp(kLastWriteFieldName, _lastWrite.asDate());
     }
 
     BSONObj IsMasterResponse::toBSON() const {
@@ -358,6 +361,15 @@ namespace {
             _electionId = electionIdElem.OID();
         }
 
+        if (doc.hasField(kLastWriteFieldName)) {
+            BSONElement lastWriteElem;
+            status = bsonExtractTypedField(doc, kLastWriteFieldName, Timestamp, &lastWriteElem);
+            if (!status.isOK()) {
+                return status;
+            }
+            _lastWrite = lastWriteElem._opTime();
+        }
+
         std::string meString;
         status = bsonExtractStringField(doc, kMeFieldName, &meString);
         if (!status.isOK()) {
@@ -448,6 +460,10 @@ namespace {
         _electionId = electionId;
     }
 
+    void IsMasterResponse::setLastWrite(const OpTime& lastWrite) {
+        _lastWrite = lastWrite;
+    }
+
     void IsMasterResponse::markAsNoConfig() { _configSet = false; }
 
     void IsMasterResponse::markAsShutdownInProgress() { _shutdownInProgress = true; }
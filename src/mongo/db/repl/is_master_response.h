@@ -32,6 +32,7 @@
 #include <vector>
 
 #include "mongo/bson/oid.h"
+#include "mongo/bson/optime.h"
 #include "mongo/platform/unordered_map.h"
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/time_support.h"
@@ -109,6 +110,12 @@ namespace repl {
 
         const OID& getElectionId() const { return _electionId; }
 
+        /**
+         * The optime of the last operation the node applied, from which clients can tell how
+         * stale its data is.  Null if the response did not include it.
+         */
+        const OpTime& getLastWrite() const { return _lastWrite; }
+
         /**
          * If false, calls to toBSON/addToBSON will ignore all other fields and add a specific
          * message to indicate that we have no replica set config.
@@ -156,6 +163,8 @@ namespace repl {
 
         void setElectionId(const OID& electionId);
 
+        void setLastWrite(const OpTime& lastWrite);
+
         /**
          * Marks _configSet as false, which will cause future calls to toBSON/addToBSON to ignore
          * all other member variables and output a hardcoded response indicating that we have no
@@ -203,6 +212,7 @@ namespace repl {
         HostAndPort _me;
         bool _meSet;
         OID _electionId;
+        OpTime _lastWrite;
 
         // If _configSet is false this means we don't have a valid repl set config, so toBSON
         // will return a set of hardcoded values that indicate this.
@@ -128,12 +128,26 @@ namespace repl {
         cursor.reset( _conn->query( ns, query, 0, 0, fields, _tailingQueryOptions ).release() );
     }
 
+    namespace {
+        BSONObj gteQuery(OpTime optime) {
+            BSONObjBuilder gte;
+            gte.appendTimestamp("$gte", optime.asDate());
+            BSONObjBuilder query;
+            query.append("ts", gte.done());
+            return query.obj();
+        }
+    } // namespace
+
     void OplogReader::tailingQueryGTE(const char *ns, OpTime optime, const BSONObj* fields ) {
-        BSONObjBuilder gte;
-        gte.appendTimestamp("$gte", optime.asDate());
-        BSONObjBuilder query;
-        query.append("ts", gte.done());
-        tailingQuery(ns, query.done(), fields);
+        tailingQuery(ns, gteQuery(optime), fields);
+    }
+
+    void OplogReader::exhaustTailingQueryGTE(const char *ns, OpTime optime) {
+        verify( !haveCursor() );
+        const BSONObj query = gteQuery(optime);
+        LOG(2) << "repl: " << ns << ".find(" << query.toString() << ") exhaust" << endl;
+        cursor.reset( _conn->query( ns, query, 0, 0, 0,
+                                    _tailingQueryOptions | QueryOption_Exhaust ).release() );
     }
 
     HostAndPort OplogReader::getHost() const {
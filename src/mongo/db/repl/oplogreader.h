@@ -101,6 +101,12 @@ namespace repl {
 
         void tailingQueryGTE(const char *ns, OpTime t, const BSONObj* fields=0);
 
+        /* Like tailingQueryGTE(), but in exhaust mode: the server sends the batches as they fill
+           up without waiting for a getmore. Until the cursor dies, the connection can't be used
+           for anything else, so reset it instead of just the cursor when done.
+        */
+        void exhaustTailingQueryGTE(const char *ns, OpTime t);
+
         /* Do a tailing query, but only send the ts field back. */
         void ghostQueryGTE(const char *ns, OpTime t) {
             const BSONObj fields = BSON("ts" << 1 << "_id" << 0);
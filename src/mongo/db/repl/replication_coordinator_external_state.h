@@ -91,9 +91,10 @@ namespace repl {
         /**
          * Simple wrapper around SyncSourceFeedback::forwardSlaveProgress.  Signals to the
          * SyncSourceFeedback thread that it needs to wake up and send a replSetUpdatePosition
-         * command upstream.
+         * command upstream, right away if 'immediate', otherwise possibly coalesced with the
+         * next few position changes.
          */
-        virtual void forwardSlaveProgress() = 0;
+        virtual void forwardSlaveProgress(bool immediate) = 0;
 
         /**
          * Queries the singleton document in local.me.  If it exists and our hostname has not
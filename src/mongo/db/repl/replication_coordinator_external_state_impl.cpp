@@ -117,8 +117,8 @@ namespace {
         _syncSourceFeedback.forwardSlaveHandshake();
     }
 
-    void ReplicationCoordinatorExternalStateImpl::forwardSlaveProgress() {
-        _syncSourceFeedback.forwardSlaveProgress();
+    void ReplicationCoordinatorExternalStateImpl::forwardSlaveProgress(bool immediate) {
+        _syncSourceFeedback.forwardSlaveProgress(immediate);
     }
 
     OID ReplicationCoordinatorExternalStateImpl::ensureMe(OperationContext* txn) {
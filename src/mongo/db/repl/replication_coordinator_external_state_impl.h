@@ -50,7 +50,7 @@ namespace repl {
         virtual void shutdown();
         virtual void initiateOplog(OperationContext* txn);
         virtual void forwardSlaveHandshake();
-        virtual void forwardSlaveProgress();
+        virtual void forwardSlaveProgress(bool immediate);
         virtual OID ensureMe(OperationContext* txn);
         virtual bool isSelf(const HostAndPort& host);
         virtual StatusWith<BSONObj> loadLocalConfigDocument(OperationContext* txn);
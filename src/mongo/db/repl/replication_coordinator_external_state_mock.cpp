@@ -58,7 +58,7 @@ namespace repl {
     void ReplicationCoordinatorExternalStateMock::initiateOplog(OperationContext* txn) {}
     void ReplicationCoordinatorExternalStateMock::shutdown() {}
     void ReplicationCoordinatorExternalStateMock::forwardSlaveHandshake() {}
-    void ReplicationCoordinatorExternalStateMock::forwardSlaveProgress() {}
+    void ReplicationCoordinatorExternalStateMock::forwardSlaveProgress(bool immediate) {}
 
     OID ReplicationCoordinatorExternalStateMock::ensureMe(OperationContext*) {
         return OID::gen();
@@ -53,7 +53,7 @@ namespace repl {
         virtual void shutdown();
         virtual void initiateOplog(OperationContext* txn);
         virtual void forwardSlaveHandshake();
-        virtual void forwardSlaveProgress();
+        virtual void forwardSlaveProgress(bool immediate);
         virtual OID ensureMe(OperationContext*);
         virtual bool isSelf(const HostAndPort& host);
         virtual HostAndPort getClientHostAndPort(const OperationContext* txn);
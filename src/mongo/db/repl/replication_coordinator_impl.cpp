@@ -105,27 +105,51 @@ namespace {
     struct ReplicationCoordinatorImpl::WaiterInfo {
 
         /**
-         * Constructor takes the list of waiters and enqueues itself on the list, removing itself
-         * in the destructor.
+         * Constructor takes the list of waiters and enqueues itself on the list and in the index
+         * of waiters by mode, removing itself from both in the destructor.
          */
-        WaiterInfo(std::vector<WaiterInfo*>* _list,
+        WaiterInfo(WaiterList* _list,
+                   WaitersByMode* _byMode,
                    unsigned int _opID,
                    const OpTime* _opTime,
                    const WriteConcernOptions* _writeConcern,
                    boost::condition_variable* _condVar) : list(_list),
+                                                          byMode(_byMode),
                                                           master(true),
                                                           opID(_opID),
                                                           opTime(_opTime),
                                                           writeConcern(_writeConcern),
                                                           condVar(_condVar) {
-            list->push_back(this);
+            listPosition = list->insert(list->end(), this);
+            modePosition = byMode->insert(
+                    std::make_pair(modeKey(*writeConcern), WaitersByOpTime())).first;
+            opTimePosition = modePosition->second.insert(std::make_pair(*opTime, this));
         }
 
         ~WaiterInfo() {
-            list->erase(std::remove(list->begin(), list->end(), this), list->end());
+            list->erase(listPosition);
+            modePosition->second.erase(opTimePosition);
+            if (modePosition->second.empty()) {
+                byMode->erase(modePosition);
+            }
+        }
+
+        /**
+         * Waiters whose write concerns have the same key are satisfied by the same set of nodes
+         * reaching their OpTimes.
+         */
+        static std::string modeKey(const WriteConcernOptions& writeConcern) {
+            if (!writeConcern.wMode.empty()) {
+                return "mode:" + writeConcern.wMode;
+            }
+            return str::stream() << "w:" << writeConcern.wNumNodes;
         }
 
-        std::vector<WaiterInfo*>* list;
+        WaiterList* list;
+        WaitersByMode* byMode;
+        WaiterList::iterator listPosition;
+        WaitersByMode::iterator modePosition;
+        WaitersByOpTime::iterator opTimePosition;
         bool master; // Set to false to indicate that stepDown was called while waiting
         const unsigned int opID;
         const OpTime* opTime;
@@ -350,7 +374,7 @@ namespace {
                 return;
             }
             fassert(18823, _rsConfigState != kConfigStartingUp);
-            for (std::vector<WaiterInfo*>::iterator it = _replicationWaiterList.begin();
+            for (WaiterList::iterator it = _replicationWaiterList.begin();
                     it != _replicationWaiterList.end(); ++it) {
                 WaiterInfo* waiter = *it;
                 waiter->condVar->notify_all();
@@ -701,7 +725,7 @@ namespace {
             return;
         }
         lock->unlock();
-        _externalState->forwardSlaveProgress(); // Must do this outside _mutex
+        _externalState->forwardSlaveProgress(false); // Must do this outside _mutex
     }
 
     OpTime ReplicationCoordinatorImpl::getMyLastOptime() const {
@@ -792,7 +816,7 @@ namespace {
 
     void ReplicationCoordinatorImpl::interrupt(unsigned opId) {
         boost::lock_guard<boost::mutex> lk(_mutex);
-        for (std::vector<WaiterInfo*>::iterator it = _replicationWaiterList.begin();
+        for (WaiterList::iterator it = _replicationWaiterList.begin();
                 it != _replicationWaiterList.end(); ++it) {
             WaiterInfo* info = *it;
             if (info->opID == opId) {
@@ -809,7 +833,7 @@ namespace {
 
     void ReplicationCoordinatorImpl::interruptAll() {
         boost::lock_guard<boost::mutex> lk(_mutex);
-        for (std::vector<WaiterInfo*>::iterator it = _replicationWaiterList.begin();
+        for (WaiterList::iterator it = _replicationWaiterList.begin();
                 it != _replicationWaiterList.end(); ++it) {
             WaiterInfo* info = *it;
             info->condVar->notify_all();
@@ -953,9 +977,14 @@ namespace {
         }
 
         // Must hold _mutex before constructing waitInfo as it will modify _replicationWaiterList
+        // and _replicationWaitersByMode
         boost::condition_variable condVar;
-        WaiterInfo waitInfo(
-                &_replicationWaiterList, txn->getOpID(), &opTime, &writeConcern, &condVar);
+        WaiterInfo waitInfo(&_replicationWaiterList,
+                            &_replicationWaitersByMode,
+                            txn->getOpID(),
+                            &opTime,
+                            &writeConcern,
+                            &condVar);
         while (!_doneWaitingForReplication_inlock(opTime, writeConcern)) {
             const int elapsed = timer->millis();
 
@@ -1401,6 +1430,7 @@ namespace {
                        stdx::placeholders::_1,
                        response));
         _replExecutor.wait(cbh.getValue());
+        response->setLastWrite(getMyLastOptime());
         if (isWaitingForApplierToDrain()) {
             // Report that we are secondary to ismaster callers until drain completes.
             response->setIsMaster(false);
@@ -1902,7 +1932,7 @@ namespace {
         PostMemberStateUpdateAction result;
         if (_memberState.primary() || newState.removed()) {
             // Wake up any threads blocked in awaitReplication, close connections, etc.
-            for (std::vector<WaiterInfo*>::iterator it = _replicationWaiterList.begin();
+            for (WaiterList::iterator it = _replicationWaiterList.begin();
                  it != _replicationWaiterList.end(); ++it) {
                 WaiterInfo* info = *it;
                 info->master = false;
@@ -2072,10 +2102,15 @@ namespace {
      }
 
     void ReplicationCoordinatorImpl::_wakeReadyWaiters_inlock(){
-        for (std::vector<WaiterInfo*>::iterator it = _replicationWaiterList.begin();
-                it != _replicationWaiterList.end(); ++it) {
-            WaiterInfo* info = *it;
-            if (_doneWaitingForReplication_inlock(*info->opTime, *info->writeConcern)) {
+        for (WaitersByMode::iterator mode = _replicationWaitersByMode.begin();
+                mode != _replicationWaitersByMode.end(); ++mode) {
+            for (WaitersByOpTime::iterator it = mode->second.begin();
+                    it != mode->second.end(); ++it) {
+                WaiterInfo* info = it->second;
+                if (!_doneWaitingForReplication_inlock(*info->opTime, *info->writeConcern)) {
+                    // Nor are any of the waiters for later OpTimes.
+                    break;
+                }
                 info->condVar->notify_all();
             }
         }
@@ -2099,7 +2134,9 @@ namespace {
 
         if (somethingChanged && !_getMemberState_inlock().primary()) {
             lock.unlock();
-            _externalState->forwardSlaveProgress(); // Must do this outside _mutex
+            // Members chained through us have already coalesced their own updates, and a write
+            // concern waiter on the primary may be waiting for exactly this one.
+            _externalState->forwardSlaveProgress(true); // Must do this outside _mutex
         }
         return status;
     }
@@ -32,6 +32,9 @@
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition_variable.hpp>
+#include <list>
+#include <map>
+#include <string>
 #include <vector>
 
 #include "mongo/base/status.h"
@@ -287,6 +290,16 @@ namespace repl {
         // Struct that holds information about clients waiting for replication.
         struct WaiterInfo;
 
+        typedef std::list<WaiterInfo*> WaiterList;
+
+        // Waiters with the same write concern mode, ordered by the OpTime they wait for.  Any
+        // OpTime that satisfies a mode also satisfies every earlier one, so the waiters that are
+        // done waiting are always a prefix.
+        typedef std::multimap<OpTime, WaiterInfo*> WaitersByOpTime;
+
+        // Keyed by write concern mode, see WaiterInfo::modeKey().
+        typedef std::map<std::string, WaitersByOpTime> WaitersByMode;
+
         // Struct that holds information about nodes in this replication group, mainly used for
         // tracking replication progress for write concern satisfaction.
         struct SlaveInfo {
@@ -356,6 +369,8 @@ namespace repl {
 
         /**
          * Helper to wake waiters in _replicationWaiterList that are doneWaitingForReplication.
+         * Only evaluates the waiters of each write concern mode until the first one that is not
+         * done, rather than every waiter.
          */
         void _wakeReadyWaiters_inlock();
 
@@ -794,7 +809,10 @@ namespace repl {
 
         // list of information about clients waiting on replication.  Does *not* own the
         // WaiterInfos.
-        std::vector<WaiterInfo*> _replicationWaiterList;                                  // (M)
+        WaiterList _replicationWaiterList;                                                // (M)
+
+        // The waiters in _replicationWaiterList, indexed by write concern mode and OpTime.
+        WaitersByMode _replicationWaitersByMode;                                          // (M)
 
         // Set to true when we are in the process of shutting down replication.
         bool _inShutdown;                                                                 // (M)
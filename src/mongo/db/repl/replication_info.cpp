@@ -46,6 +46,7 @@
 #include "mongo/db/storage_options.h"
 #include "mongo/db/wire_version.h"
 #include "mongo/s/write_ops/batched_command_request.h"
+#include "mongo/util/net/message_compressor.h"
 
 namespace mongo {
 namespace repl {
@@ -214,6 +215,7 @@ namespace repl {
             result.appendDate("localTime", jsTime());
             result.append("maxWireVersion", maxWireVersion);
             result.append("minWireVersion", minWireVersion);
+            negotiateMessageCompression(cmdObj, txn->getClient()->port(), &result);
             return true;
         }
     } cmdismaster;
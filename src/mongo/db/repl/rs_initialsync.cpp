@@ -32,6 +32,8 @@
 
 #include "mongo/db/repl/rs_initialsync.h"
 
+#include <boost/scoped_ptr.hpp>
+
 #include "mongo/bson/optime.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_manager_global.h"
@@ -43,16 +45,25 @@
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/initial_sync.h"
+#include "mongo/db/repl/initial_sync_oplog_buffer.h"
 #include "mongo/db/repl/minvalid.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplogreader.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 namespace repl {
+
+    // Number of collections of a database whose data initial sync copies at the same time
+    MONGO_EXPORT_SERVER_PARAMETER(initialSyncCollectionCloners, int, 1);
+
+    // Whether initial sync copies the sync source's oplog while it clones, rather than after
+    MONGO_EXPORT_SERVER_PARAMETER(initialSyncBufferOplog, bool, true);
+
 namespace {
 
     /**
@@ -116,6 +127,7 @@ namespace {
             options.mayBeInterrupted = false;
             options.syncData = dataPass;
             options.syncIndexes = ! dataPass;
+            options.numCollectionCloners = initialSyncCollectionCloners;
 
             // Make database stable
             ScopedTransaction transaction(txn, MODE_IX);
@@ -233,7 +245,8 @@ namespace {
      *
      *     0. Add _initialSyncFlag to minValid collection to tell us to restart initial sync if we
      *        crash in the middle of this procedure
-     *     1. Record start time.
+     *     1. Record start time, and start copying the sync target's oplog from there into
+     *        local.temp_oplog_buffer.
      *     2. Clone.
      *     3. Set minValid1 to sync target's latest op time.
      *     4. Apply ops from start to minValid1, fetching missing docs as needed.
@@ -249,6 +262,10 @@ namespace {
      * this member should have consistent data.  8 is "cosmetic," it is only to get this member
      * closer to the latest op time before it can transition out of startup state
      *
+     * Steps 4, 6 and 9 apply the oplog copied in step 1, so initial sync does not depend on the
+     * sync target keeping its oplog from before the clone until after it. With
+     * initialSyncBufferOplog off, they fetch from the sync target through BackgroundSync instead.
+     *
      * Returns a Status with ErrorCode::ShutdownInProgress if the node enters shutdown,
      * ErrorCode::InitialSyncOplogSourceMissing if the node fails to find an sync source, Status::OK
      * if everything worked, and ErrorCode::InitialSyncFailure for all other error cases.
@@ -282,9 +299,6 @@ namespace {
             }
         }
 
-        InitialSync init(bgsync);
-        init.setHostname(r.getHost().toString());
-
         BSONObj lastOp = r.getLastOp(rsoplog);
         if ( lastOp.isEmpty() ) {
             std::string msg = "initial sync couldn't read remote oplog";
@@ -293,7 +307,20 @@ namespace {
             return Status(ErrorCodes::InitialSyncFailure, msg);
         }
 
-        if (getGlobalReplicationCoordinator()->getSettings().fastsync) {
+        const bool fastsync = getGlobalReplicationCoordinator()->getSettings().fastsync;
+
+        // Must outlive the InitialSync and SyncTail that read from it.
+        boost::scoped_ptr<InitialSyncOplogBuffer> oplogBuffer;
+        if (!fastsync && initialSyncBufferOplog) {
+            oplogBuffer.reset(new InitialSyncOplogBuffer(&txn, bgsync, r.getHost(), lastOp));
+        }
+        BackgroundSyncInterface* oplogSource = oplogBuffer ?
+            static_cast<BackgroundSyncInterface*>(oplogBuffer.get()) : bgsync;
+
+        InitialSync init(oplogSource);
+        init.setHostname(r.getHost().toString());
+
+        if (fastsync) {
             log() << "fastsync: skipping database clone";
 
             // prime oplog
@@ -316,6 +343,10 @@ namespace {
         log() << "initial sync drop all databases";
         dropAllDatabasesExceptLocal(&txn);
 
+        if (oplogBuffer) {
+            oplogBuffer->startFetching();
+        }
+
         log() << "initial sync clone all databases";
 
         list<string> dbs = r.conn()->getDatabaseNames();
@@ -359,7 +390,7 @@ namespace {
         msg = "oplog sync 3 of 3";
         log() << msg;
 
-        SyncTail tail(bgsync, multiSyncApply);
+        SyncTail tail(oplogSource, multiSyncApply);
         if (!_initialSyncApplyOplog(&txn, tail, &r)) {
             return Status(ErrorCodes::InitialSyncFailure,
                           str::stream() << "initial sync failed: " << msg);
@@ -375,6 +406,12 @@ namespace {
 
         log() << "initial sync finishing up";
 
+        // BackgroundSync takes over from the last op applied once the buffer is destroyed, on
+        // the way out of this function.
+        if (oplogBuffer) {
+            oplogBuffer->finish();
+        }
+
         {
             ScopedTransaction scopedXact(&txn, MODE_IX);
             AutoGetDb autodb(&txn, "local", MODE_X);
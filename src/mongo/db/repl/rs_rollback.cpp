@@ -34,6 +34,7 @@
 #include "mongo/db/repl/rs_rollback.h"
 
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_manager_global.h"
@@ -54,6 +55,9 @@
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/repl/replication_coordinator_impl.h"
 #include "mongo/db/repl/rslog.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/log.h"
 
 /* Scenarios
@@ -99,8 +103,16 @@ namespace mongo {
     using boost::shared_ptr;
 
 namespace repl {
+
+    // Number of connections over which rollback refetches documents from the sync source, each
+    // working through the batches of one collection at a time
+    MONGO_EXPORT_SERVER_PARAMETER(rollbackRefetchThreads, int, 4);
+
 namespace {
 
+    // Most _ids refetched with one $in query
+    const size_t kRefetchBatchSize = 1000;
+
     class RSFatalException : public std::exception {
     public:
         RSFatalException(std::string m = "replica set fatal exception")
@@ -373,6 +385,158 @@ namespace {
         return cloner.copyCollection(txn, ns, BSONObj(), errmsg, true, false, true, false);
     }
 
+    /**
+     * Refetches the current versions of the documents to roll back from the sync source, with
+     * one $in query per batch of _ids of a collection. The batches are shared by several
+     * threads, each with its own connection, so that different collections are fetched in
+     * parallel. No locks are needed, since only the sync source is read.
+     */
+    class Refetcher {
+    public:
+        Refetcher(const std::string& host, const set<DocID>& toRefetch)
+            : errCode(0),
+              _mutex("Refetcher"),
+              _host(host),
+              _docs(toRefetch.begin(), toRefetch.end()),
+              _goodVersions(_docs.size()),
+              _nextDoc(0),
+              _totalSize(0) {
+        }
+
+        /**
+         * Refetches all documents with 'numThreads' threads. Returns false and sets errCode and
+         * errmsg if any of them failed.
+         */
+        bool fetchAll(int numThreads) {
+            numThreads = std::max(1, numThreads);
+            boost::thread_group threads;
+            for (int i = 0; i < numThreads; i++) {
+                threads.create_thread(stdx::bind(&Refetcher::_run, this));
+            }
+            threads.join_all();
+            return !errCode;
+        }
+
+        /**
+         * The current version of each document in 'toRefetch', in the same order, or an empty
+         * object if it no longer exists on the sync source. Only valid after fetchAll().
+         */
+        void getGoodVersions(list< pair<DocID, BSONObj> >* out) const {
+            for (size_t i = 0; i < _docs.size(); i++) {
+                out->push_back(pair<DocID, BSONObj>(_docs[i], _goodVersions[i]));
+            }
+        }
+
+        int errCode;
+        string errmsg;
+
+    private:
+        /**
+         * Claims the next batch of documents, all of the same collection, as the range
+         * [*begin, *end) of _docs. Returns false when there is nothing left to do.
+         */
+        bool _next(size_t* begin, size_t* end) {
+            scoped_lock lk(_mutex);
+            if (errCode || _nextDoc == _docs.size())
+                return false;
+
+            *begin = _nextDoc;
+            *end = _nextDoc + 1;
+            while (*end < _docs.size() && *end - *begin < kRefetchBatchSize &&
+                   strcmp(_docs[*end].ns, _docs[*begin].ns) == 0) {
+                ++*end;
+            }
+            _nextDoc = *end;
+            return true;
+        }
+
+        void _addSize(int size) {
+            scoped_lock lk(_mutex);
+            _totalSize += size;
+            uassert(13410, "replSet too much data to roll back",
+                    _totalSize < 300 * 1024 * 1024);
+        }
+
+        void _fetchBatch(DBClientConnection* conn, size_t begin, size_t end) {
+            const char* ns = _docs[begin].ns;
+
+            // $in would match a regular expression _id as a pattern, so fetch those on their own
+            BSONArrayBuilder ids;
+            for (size_t i = begin; i < end; i++) {
+                const BSONElement& id = _docs[i]._id;
+                verify(!id.eoo());
+                if (id.type() == RegEx) {
+                    _goodVersions[i] = conn->findOne(ns, id.wrap(),
+                                                     NULL, QueryOption_SlaveOk).getOwned();
+                    _addSize(_goodVersions[i].objsize());
+                }
+                else {
+                    ids.append(id);
+                }
+            }
+
+            std::map<BSONElement, size_t, BSONElementCmpWithoutField> wanted;
+            for (size_t i = begin; i < end; i++) {
+                if (_docs[i]._id.type() != RegEx)
+                    wanted[_docs[i]._id] = i;
+            }
+            if (wanted.empty())
+                return;
+
+            auto_ptr<DBClientCursor> cursor =
+                conn->query(ns, BSON("_id" << BSON("$in" << ids.arr())),
+                            0, 0, NULL, QueryOption_SlaveOk);
+            uassert(ErrorCodes::HostUnreachable,
+                    str::stream() << "rollback could not query " << ns << " on " << _host,
+                    cursor.get());
+
+            while (cursor->more()) {
+                BSONObj good = cursor->nextSafe().getOwned();
+                std::map<BSONElement, size_t, BSONElementCmpWithoutField>::const_iterator it =
+                    wanted.find(good["_id"]);
+                if (it == wanted.end())
+                    continue;
+                _addSize(good.objsize());
+                _goodVersions[it->second] = good;
+            }
+            // documents the query did not return stay empty, indicating we should delete them
+        }
+
+        void _run() {
+            size_t begin = 0;
+            size_t end = 0;
+            try {
+                string err;
+                DBClientConnection conn;
+                uassert(ErrorCodes::HostUnreachable, err,
+                        conn.connect(HostAndPort(_host), err));
+                uassert(ErrorCodes::AuthenticationFailed,
+                        str::stream() << "rollback could not authenticate to " << _host,
+                        replAuthenticate(&conn));
+
+                while (_next(&begin, &end)) {
+                    _fetchBatch(&conn, begin, end);
+                }
+            }
+            catch (const DBException& e) {
+                scoped_lock lk(_mutex);
+                if (!errCode) {
+                    errmsg = str::stream() << "rollback couldn't re-get documents of "
+                                           << (begin < _docs.size() ? _docs[begin].ns : "")
+                                           << causedBy(e);
+                    errCode = e.getCode();
+                }
+            }
+        }
+
+        mongo::mutex _mutex; // protects _nextDoc, _totalSize, errCode and errmsg
+        const std::string _host;
+        const std::vector<DocID> _docs; // sorted by ns, then _id
+        std::vector<BSONObj> _goodVersions; // each written by the thread fetching its batch
+        size_t _nextDoc;
+        unsigned long long _totalSize;
+    };
+
     void syncFixUp(OperationContext* txn,
                    FixUpInfo& fixUpInfo,
                    OplogReader* oplogreader,
@@ -381,36 +545,30 @@ namespace {
 
         // fetch all first so we needn't handle interruption in a fancy way
 
-        unsigned long long totalSize = 0;
-
         list< pair<DocID, BSONObj> > goodVersions;
 
         BSONObj newMinValid;
 
         // fetch all the goodVersions of each document from current primary
-        DocID doc;
-        unsigned long long numFetched = 0;
         try {
-            for (set<DocID>::iterator it = fixUpInfo.toRefetch.begin();
-                    it != fixUpInfo.toRefetch.end();
-                    it++) {
-                doc = *it;
-
-                verify(!doc._id.eoo());
+            if (!fixUpInfo.toRefetch.empty()) {
+                Refetcher refetcher(them->getServerAddress(), fixUpInfo.toRefetch);
+                log() << "rollback refetching " << fixUpInfo.toRefetch.size() << " documents";
 
+                bool ok;
                 {
-                    // TODO : slow.  lots of round trips.
-                    numFetched++;
-                    BSONObj good = them->findOne(doc.ns, doc._id.wrap(),
-                                                     NULL, QueryOption_SlaveOk).getOwned();
-                    totalSize += good.objsize();
-                    uassert(13410, "replSet too much data to roll back",
-                            totalSize < 300 * 1024 * 1024);
-
-                    // note good might be eoo, indicating we should delete it
-                    goodVersions.push_back(pair<DocID, BSONObj>(doc,good));
+                    // Nothing else writes while we are in ROLLBACK, and the refetch only reads
+                    // from the sync source, so don't block everyone else for its duration.
+                    Lock::TempRelease release(txn->lockState());
+                    ok = refetcher.fetchAll(rollbackRefetchThreads);
+                }
+                if (!ok) {
+                    error() << refetcher.errmsg;
+                    uasserted(refetcher.errCode, refetcher.errmsg);
                 }
+                refetcher.getGoodVersions(&goodVersions);
             }
+
             newMinValid = oplogreader->getLastOp(rsoplog);
             if (newMinValid.isEmpty()) {
                 error() << "rollback error newMinValid empty?";
@@ -419,8 +577,6 @@ namespace {
         }
         catch (DBException& e) {
             LOG(1) << "rollback re-get objects: " << e.toString();
-            error() << "rollback couldn't re-get ns:" << doc.ns << " _id:" << doc._id << ' '
-                    << numFetched << '/' << fixUpInfo.toRefetch.size();
             throw e;
         }
 
@@ -44,9 +44,11 @@
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/log.h"
 #include "mongo/util/net/hostandport.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -55,7 +57,16 @@ namespace repl {
     // used in replAuthenticate
     static const BSONObj userReplQuery = fromjson("{\"user\":\"repl\"}");
 
+    // Minimum time between two updates of our own position sent upstream.  Position changes in
+    // between are coalesced into the next update, unless there are more than
+    // replFeedbackMaxCoalescedChanges of them.
+    MONGO_EXPORT_SERVER_PARAMETER(replFeedbackCoalesceMillis, int, 10);
+    MONGO_EXPORT_SERVER_PARAMETER(replFeedbackMaxCoalescedChanges, int, 100);
+
     SyncSourceFeedback::SyncSourceFeedback() : _positionChanged(false),
+                                               _positionChangeImmediate(false),
+                                               _positionChangesPending(0),
+                                               _lastUpdateMillis(0),
                                                _handshakeNeeded(false),
                                                _shutdownSignaled(false) {}
     SyncSourceFeedback::~SyncSourceFeedback() {}
@@ -186,12 +197,23 @@ namespace repl {
         _cond.notify_all();
     }
 
-    void SyncSourceFeedback::forwardSlaveProgress() {
+    void SyncSourceFeedback::forwardSlaveProgress(bool immediate) {
         boost::unique_lock<boost::mutex> lock(_mtx);
         _positionChanged = true;
+        _positionChangeImmediate = _positionChangeImmediate || immediate;
+        _positionChangesPending++;
         _cond.notify_all();
     }
 
+    long long SyncSourceFeedback::_millisUntilUpdateDue_inlock() const {
+        if (_positionChangeImmediate ||
+                _positionChangesPending > replFeedbackMaxCoalescedChanges) {
+            return 0;
+        }
+        const long long elapsed = curTimeMillis64() - _lastUpdateMillis;
+        return std::max(replFeedbackCoalesceMillis - elapsed, 0LL);
+    }
+
     Status SyncSourceFeedback::updateUpstream(OperationContext* txn) {
         ReplicationCoordinator* replCoord = getGlobalReplicationCoordinator();
         if (replCoord->getMemberState().primary()) {
@@ -252,8 +274,18 @@ namespace repl {
         while (!inShutdown()) { // TODO(spencer): Remove once legacy repl coordinator is gone.
             {
                 boost::unique_lock<boost::mutex> lock(_mtx);
-                while (!_positionChanged && !_handshakeNeeded && !_shutdownSignaled) {
-                    _cond.wait(lock);
+                while (!_handshakeNeeded && !_shutdownSignaled) {
+                    if (!_positionChanged) {
+                        _cond.wait(lock);
+                        continue;
+                    }
+
+                    // Give further position changes a chance to join this update.
+                    const long long waitMillis = _millisUntilUpdateDue_inlock();
+                    if (waitMillis == 0) {
+                        break;
+                    }
+                    _cond.timed_wait(lock, Milliseconds(waitMillis));
                 }
 
                 if (_shutdownSignaled) {
@@ -263,6 +295,8 @@ namespace repl {
                 positionChanged = _positionChanged;
                 handshakeNeeded = _handshakeNeeded;
                 _positionChanged = false;
+                _positionChangeImmediate = false;
+                _positionChangesPending = 0;
                 _handshakeNeeded = false;
             }
 
@@ -298,8 +332,9 @@ namespace repl {
             }
             if (positionChanged) {
                 Status status = updateUpstream(&txn);
+                boost::unique_lock<boost::mutex> lock(_mtx);
+                _lastUpdateMillis = curTimeMillis64();
                 if (!status.isOK()) {
-                    boost::unique_lock<boost::mutex> lock(_mtx);
                     _positionChanged = true;
                     if (status == ErrorCodes::NodeNotFound) {
                         _handshakeNeeded = true;
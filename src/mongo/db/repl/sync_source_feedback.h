@@ -56,8 +56,10 @@ namespace repl {
         void forwardSlaveHandshake();
 
         /// Notifies the SyncSourceFeedbackThread to wake up and send an update upstream of slave
-        /// replication progress.
-        void forwardSlaveProgress();
+        /// replication progress.  Unless 'immediate', the update may wait for up to
+        /// replFeedbackCoalesceMillis since the previous one, so that it covers several position
+        /// changes.
+        void forwardSlaveProgress(bool immediate);
 
         /// Loops continuously until shutdown() is called, passing updates when they are present.
         /// TODO(spencer): Currently also can terminate when the global inShutdown() function
@@ -96,6 +98,10 @@ namespace repl {
         /// Connect to sync target.
         bool _connect(OperationContext* txn, const HostAndPort& host);
 
+        /// Returns how long to wait before sending the pending position change upstream, or 0 if
+        /// it should be sent now.
+        long long _millisUntilUpdateDue_inlock() const;
+
         // stores our OID to be passed along in commands
         /// TODO(spencer): Remove this once the LegacyReplicationCoordinator is gone.
         BSONObj _me;
@@ -109,6 +115,12 @@ namespace repl {
         boost::condition _cond;
         // used to indicate a position change which has not yet been pushed along
         bool _positionChanged;
+        // used to indicate that the pending position change should not wait to be coalesced
+        bool _positionChangeImmediate;
+        // number of position changes coalesced into the pending one
+        int _positionChangesPending;
+        // when we last sent our position upstream, in curTimeMillis64() time
+        long long _lastUpdateMillis;
         // used to indicate a connection change which has not yet been shook on
         bool _handshakeNeeded;
         // Once this is set to true the _run method will terminate
@@ -33,12 +33,14 @@
 
 #include "mongo/db/repl/sync_tail.h"
 
+#include <map>
 #include <boost/functional/hash.hpp>
 #include <boost/ref.hpp>
 #include "third_party/murmurhash3/MurmurHash3.h"
 
 #include "mongo/base/counter.h"
 #include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/commands/fsync.h"
@@ -46,13 +48,17 @@
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/global_environment_experiment.h"
+#include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/prefetch.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/minvalid.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/stats/counters.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
@@ -61,15 +67,82 @@ namespace mongo {
 
 namespace repl {
 #if defined(MONGO_PLATFORM_64)
-    const int replWriterThreadCount = 16;
+    const int kDefaultWriterThreadCount = 16;
     const int replPrefetcherThreadCount = 16;
 #elif defined(MONGO_PLATFORM_32)
-    const int replWriterThreadCount = 2;
+    const int kDefaultWriterThreadCount = 2;
     const int replPrefetcherThreadCount = 2;
 #else
 #error need to include something that defines MONGO_PLATFORM_XX
 #endif
 
+    // Upper bound for the replWriterThreadCount parameter.
+    const int kMaxWriterThreadCount = 256;
+
+    // Number of writer threads, and of the partitions each batch of ops is split into for them.
+    int replWriterThreadCount = kDefaultWriterThreadCount;
+
+    // Whether each writer thread only runs on one CPU, so the ops it applies stay in its cache.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(replWriterPinThreads, bool, false);
+
+    namespace {
+        class ExportedWriterThreadCountParameter : public ExportedServerParameter<int> {
+        public:
+            ExportedWriterThreadCountParameter() :
+                ExportedServerParameter<int>(ServerParameterSet::getGlobal(),
+                                             "replWriterThreadCount",
+                                             &replWriterThreadCount,
+                                             true,
+                                             false) {}
+
+            virtual Status validate(const int& potentialNewValue) {
+                if (potentialNewValue < 1 || potentialNewValue > kMaxWriterThreadCount) {
+                    return Status(ErrorCodes::BadValue,
+                                  str::stream() << "replWriterThreadCount must be between 1 and "
+                                                << kMaxWriterThreadCount);
+                }
+                return Status::OK();
+            }
+        } exportedWriterThreadCountParameter;
+
+        /**
+         * Ops applied and time spent applying them by each writer partition, to show how evenly
+         * fillWriterVectors() spreads the work.  Reported as repl.apply.writers in the
+         * serverStatus metrics.
+         */
+        struct WriterStats {
+            AtomicUInt64 ops;
+            AtomicUInt64 micros;
+        };
+
+        WriterStats writerStats[kMaxWriterThreadCount];
+
+        class WriterStatsMetric : public ServerStatusMetric {
+        public:
+            WriterStatsMetric() : ServerStatusMetric("repl.apply.writers") { }
+
+            virtual void appendAtLeaf(BSONObjBuilder& b) const {
+                BSONArrayBuilder writers(b.subarrayStart(_leafName));
+                for (int i = 0; i < replWriterThreadCount; i++) {
+                    BSONObjBuilder writer(writers.subobjStart());
+                    writer.append("ops", static_cast<long long>(writerStats[i].ops.load()));
+                    writer.append("busyMillis",
+                                  static_cast<long long>(writerStats[i].micros.load() / 1000));
+                }
+            }
+        } writerStatsMetric;
+
+        void applyWriterVector(void (*applyFunc)(const std::vector<BSONObj>&, SyncTail*),
+                               const std::vector<BSONObj>& ops,
+                               SyncTail* st,
+                               int writerIndex) {
+            Timer timer;
+            applyFunc(ops, st);
+            writerStats[writerIndex].ops.fetchAndAdd(ops.size());
+            writerStats[writerIndex].micros.fetchAndAdd(timer.micros());
+        }
+    }
+
     static Counter64 opsAppliedStats;
 
     //The oplog entries applied
@@ -203,7 +276,7 @@ namespace repl {
         Sync(""), 
         _networkQueue(q), 
         _applyFunc(func),
-        _writerPool(replWriterThreadCount, "repl writer worker "),
+        _writerPool(replWriterThreadCount, "repl writer worker ", replWriterPinThreads),
         _prefetcherPool(replPrefetcherThreadCount, "repl prefetch worker ")
     {}
 
@@ -296,6 +369,65 @@ namespace repl {
         invariant(!"impossible");
     }
 
+    bool SyncTail::applyInsertGroup(OperationContext* txn,
+                                    std::vector<BSONObj>::const_iterator begin,
+                                    std::vector<BSONObj>::const_iterator end) {
+        if (inShutdown()) {
+            return false;
+        }
+
+        const std::string ns = begin->getStringField("ns");
+
+        std::vector<BSONObj> docs;
+        docs.reserve(end - begin);
+        for (std::vector<BSONObj>::const_iterator it = begin; it != end; ++it) {
+            docs.push_back(it->getObjectField("o"));
+        }
+
+        try {
+            Lock::DBLock dbLock(txn->lockState(), nsToDatabaseSubstring(ns), MODE_IX);
+            Lock::CollectionLock collLock(txn->lockState(), ns, MODE_IX);
+
+            Database* db = dbHolder().get(txn, nsToDatabaseSubstring(ns));
+            Collection* collection = db ? db->getCollection(ns) : NULL;
+
+            // Without an _id index a replayed insert would not be caught as a duplicate, and
+            // capped inserts delete as they go; both keep to the upsert-based single op path.
+            if (!collection ||
+                collection->isCapped() ||
+                !collection->getIndexCatalog()->findIdIndex(txn)) {
+                return false;
+            }
+
+            Client::Context ctx(txn, ns);
+            ctx.getClient()->curop()->reset();
+
+            WriteUnitOfWork wunit(txn);
+            std::vector<RecordId> locs;
+            if (!collection->insertDocuments(txn, docs, false, &locs).isOK()) {
+                return false;
+            }
+            wunit.commit();
+        }
+        catch (const WriteConflictException&) {
+            return false;
+        }
+        catch (const DBException& e) {
+            if (ErrorCodes::isInterruption(e.toStatus().code())) {
+                throw;
+            }
+            LOG(2) << "falling back to applying inserts one at a time on " << ns
+                   << causedBy(e);
+            return false;
+        }
+
+        for (size_t i = 0; i < docs.size(); i++) {
+            replOpCounters.gotInsert();
+            opsAppliedStats.increment();
+        }
+        return true;
+    }
+
     // The pool threads call this to prefetch each op
     void SyncTail::prefetchOp(const BSONObj& op) {
         initializePrefetchThread();
@@ -324,37 +456,41 @@ namespace repl {
 
     // Doles out all the work to the reader pool threads and waits for them to complete
     void SyncTail::prefetchOps(const std::deque<BSONObj>& ops) {
+        WorkStealingThreadPool::TaskGroup prefetches(&_prefetcherPool);
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
-            _prefetcherPool.schedule(&prefetchOp, *it);
+            prefetches.schedule(stdx::bind(&prefetchOp, *it));
         }
-        _prefetcherPool.join();
+        prefetches.join();
     }
     
     // Doles out all the work to the writer pool threads and waits for them to complete
     void SyncTail::applyOps(const std::vector< std::vector<BSONObj> >& writerVectors) {
         TimerHolder timer(&applyBatchStats);
-        for (std::vector< std::vector<BSONObj> >::const_iterator it = writerVectors.begin();
-             it != writerVectors.end();
-             ++it) {
-            if (!it->empty()) {
-                _writerPool.schedule(_applyFunc, boost::cref(*it), this);
+        WorkStealingThreadPool::TaskGroup writers(&_writerPool);
+        for (size_t i = 0; i < writerVectors.size(); i++) {
+            if (!writerVectors[i].empty()) {
+                writers.schedule(stdx::bind(&applyWriterVector,
+                                            _applyFunc,
+                                            boost::cref(writerVectors[i]),
+                                            this,
+                                            static_cast<int>(i)));
             }
         }
-        _writerPool.join();
+        writers.join();
     }
 
     // Doles out all the work to the writer pool threads and waits for them to complete
     OpTime SyncTail::multiApply(OperationContext* txn, std::deque<BSONObj>& ops) {
 
         if (getGlobalEnvironment()->getGlobalStorageEngine()->isMmapV1()) {
-            // Use a ThreadPool to prefetch all the operations in a batch.
+            // Use the prefetcher pool to prefetch all the operations in a batch.
             prefetchOps(ops);
         }
         
         std::vector< std::vector<BSONObj> > writerVectors(replWriterThreadCount);
-        fillWriterVectors(ops, &writerVectors);
+        fillWriterVectors(txn, ops, &writerVectors);
         LOG(2) << "replication batch size is " << ops.size() << endl;
         // We must grab this because we're going to grab write locks later.
         // We hold this mutex the entire time we're writing; it doesn't matter
@@ -377,9 +513,45 @@ namespace repl {
     }
 
 
-    void SyncTail::fillWriterVectors(const std::deque<BSONObj>& ops,
+    namespace {
+        // Whether ops on different documents of 'ns' may be applied in any order.  A unique
+        // secondary index rules that out: a document can take a key that another one in the
+        // same batch gave up, and applying them out of order would hit a duplicate key.
+        bool canPartitionById(OperationContext* txn, const StringData& ns) {
+            if (!nsIsFull(ns)) {
+                return false;
+            }
+
+            AutoGetCollectionForRead ctx(txn, ns.toString());
+            Collection* collection = ctx.getCollection();
+            if (!collection) {
+                // Created by this batch, so it can't have indexes beyond _id yet.
+                return true;
+            }
+
+            IndexCatalog::IndexIterator ii =
+                collection->getIndexCatalog()->getIndexIterator(txn, true);
+            while (ii.more()) {
+                const IndexDescriptor* desc = ii.next();
+                if (desc->unique() && !desc->isIdIndex()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    void SyncTail::fillWriterVectors(OperationContext* txn,
+                                     const std::deque<BSONObj>& ops,
                                      std::vector< std::vector<BSONObj> >* writerVectors) {
 
+        const bool supportsDocLocking =
+            getGlobalEnvironment()->getGlobalStorageEngine()->supportsDocLocking();
+
+        // canPartitionById() for each namespace in the batch.  Index builds and commands are
+        // always batched alone, so the answer holds for the whole batch.
+        std::map<std::string, bool> partitionById;
+
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
@@ -392,8 +564,17 @@ namespace repl {
 
             const char* opType = it->getField( "op" ).valuestrsafe();
 
-            if (getGlobalEnvironment()->getGlobalStorageEngine()->supportsDocLocking() &&
-                isCrudOpType(opType)) {
+            bool byId = false;
+            if (supportsDocLocking && isCrudOpType(opType)) {
+                std::map<std::string, bool>::iterator known = partitionById.find(ns);
+                if (known == partitionById.end()) {
+                    known = partitionById.insert(
+                        std::make_pair(std::string(ns), canPartitionById(txn, ns))).first;
+                }
+                byId = known->second;
+            }
+
+            if (byId) {
                 BSONElement id;
                 switch (opType[0]) {
                 case 'u':
@@ -576,12 +757,32 @@ namespace {
             // Set minValid to the last op to be applied in this next batch.
             // This will cause this node to go into RECOVERING state
             // if we should crash and restart before updating the oplog
-            OpTime minValid = lastOp["ts"]._opTime();
-            setMinValid(&txn, minValid);
+            const OpTime batchEnd = lastOp["ts"]._opTime();
+            if (getMinValid(&txn) < batchEnd) {
+                setMinValid(&txn, _minValidTarget(replCoord, batchEnd));
+            }
             multiApply(&txn, ops.getDeque());
         }
     }
 
+    OpTime SyncTail::_minValidTarget(ReplicationCoordinator* replCoord, const OpTime& batchEnd) {
+        // A RECOVERING member only goes live once it has applied up to minValid, which it might
+        // never do if each batch pushed minValid further ahead.
+        if (!replCoord->getMemberState().secondary()) {
+            return batchEnd;
+        }
+
+        // Setting minValid to what has already been fetched covers the next few batches too,
+        // so they don't each need their own minValid write.  Don't reach too far: after a
+        // crash we would be RECOVERING until we got that far again.
+        const OpTime fetched = BackgroundSync::get()->getLastOpTimeFetched();
+        if (fetched > batchEnd &&
+            fetched.getSecs() - batchEnd.getSecs() <= kMinValidLookaheadSecs) {
+            return fetched;
+        }
+        return batchEnd;
+    }
+
     // Copies ops out of the bgsync queue into the deque passed in as a parameter.
     // Returns true if the batch should be ended early.
     // Batch should end early if we encounter a command, or if
@@ -720,6 +921,45 @@ namespace {
         }
     }
 
+    // Most documents applied by one batched insert in multiSyncApply().
+    static const size_t kMaxInsertGroupSize = 64;
+
+    namespace {
+        // An insert of a regular document with an _id, which can go through the batched path.
+        bool isGroupableInsert(const BSONObj& op) {
+            if (*op.getStringField("op") != 'i') {
+                return false;
+            }
+
+            const StringData ns = op.getStringField("ns");
+            if (!nsIsFull(ns) || nsToCollectionSubstring(ns) == "system.indexes") {
+                return false;
+            }
+
+            const BSONElement o = op["o"];
+            return o.type() == Object && !o.Obj()["_id"].eoo();
+        }
+
+        // The end of the run of groupable inserts into one namespace starting at 'begin'.
+        std::vector<BSONObj>::const_iterator endOfInsertGroup(
+                std::vector<BSONObj>::const_iterator begin,
+                std::vector<BSONObj>::const_iterator end) {
+            if (!isGroupableInsert(*begin)) {
+                return begin + 1;
+            }
+
+            const StringData ns = begin->getStringField("ns");
+            std::vector<BSONObj>::const_iterator it = begin + 1;
+            while (it != end &&
+                   static_cast<size_t>(it - begin) < kMaxInsertGroupSize &&
+                   isGroupableInsert(*it) &&
+                   ns == it->getStringField("ns")) {
+                ++it;
+            }
+            return it;
+        }
+    }
+
     // This free function is used by the writer threads to apply each op
     void multiSyncApply(const std::vector<BSONObj>& ops, SyncTail* st) {
         initializeWriterThread();
@@ -731,9 +971,35 @@ namespace {
 
         bool convertUpdatesToUpserts = true;
 
+        // Where the current run of inserts into one namespace ends; ops before it have been
+        // applied as a group if that worked.
+        std::vector<BSONObj>::const_iterator groupEnd = ops.begin();
+
         for (std::vector<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
+            if (it >= groupEnd) {
+                groupEnd = endOfInsertGroup(it, ops.end());
+                if (groupEnd - it > 1) {
+                    try {
+                        if (st->applyInsertGroup(&txn, it, groupEnd)) {
+                            it = groupEnd - 1;
+                            continue;
+                        }
+                    }
+                    catch (const DBException& e) {
+                        error() << "writer worker caught exception: " << causedBy(e)
+                                << " on insert group starting at: " << it->toString();
+
+                        if (inShutdown()) {
+                            return;
+                        }
+
+                        fassertFailedNoTrace(28617);
+                    }
+                }
+            }
+
             try {
                 if (!st->syncApply(&txn, *it, convertUpdatesToUpserts)) {
                     fassertFailedNoTrace(16359);
@@ -29,10 +29,11 @@
 #pragma once
 
 #include <deque>
+#include <vector>
 
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/repl/sync.h"
-#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/concurrency/work_stealing_thread_pool.h"
 
 namespace mongo {
 
@@ -54,6 +55,16 @@ namespace repl {
                                const BSONObj &o,
                                bool convertUpdateToUpsert = false);
 
+        /**
+         * Applies the inserts in [begin, end), which all target one namespace, with a single
+         * batched insert in one unit of work.  Returns false, having changed nothing, if they
+         * can't all be applied that way (e.g. one was already applied, or the collection does not
+         * exist yet); the caller then applies them one at a time through syncApply().
+         */
+        bool applyInsertGroup(OperationContext* txn,
+                              std::vector<BSONObj>::const_iterator begin,
+                              std::vector<BSONObj>::const_iterator end);
+
         /**
          * Runs _applyOplogUntil(stopOpTime)
          */
@@ -131,14 +142,23 @@ namespace repl {
         // Doles out all the work to the writer pool threads and waits for them to complete
         void applyOps(const std::vector< std::vector<BSONObj> >& writerVectors);
 
-        void fillWriterVectors(const std::deque<BSONObj>& ops, 
+        // Splits 'ops' among the writer threads, by namespace and, where the storage engine
+        // allows it and the collection has no unique secondary indexes, by document _id.
+        void fillWriterVectors(OperationContext* txn,
+                               const std::deque<BSONObj>& ops,
                                std::vector< std::vector<BSONObj> >* writerVectors);
         void handleSlaveDelay(const BSONObj& op);
 
+        // How far past the current batch minValid may be set ahead, in seconds of oplog time.
+        static const unsigned int kMinValidLookaheadSecs = 10;
+
+        // The minValid to write before applying a batch ending at 'batchEnd'.
+        OpTime _minValidTarget(ReplicationCoordinator* replCoord, const OpTime& batchEnd);
+
         // persistent pool of worker threads for writing ops to the databases
-        threadpool::ThreadPool _writerPool;
+        WorkStealingThreadPool _writerPool;
         // persistent pool of worker threads for prefetching
-        threadpool::ThreadPool _prefetcherPool;
+        WorkStealingThreadPool _prefetcherPool;
 
     };
 
@@ -68,6 +68,10 @@ namespace {
     // Maximum number of retries for a failed heartbeat.
     const int kMaxHeartbeatRetries = 2;
 
+    // A new sync source is only preferred over the current one if we expect to lag behind it by
+    // this much less, so that ping noise does not make us flap between similar candidates.
+    const long long kSyncSourceChangeMarginMillis = 10;
+
     /**
      * Returns true if the only up heartbeats are auth errors.
      */
@@ -99,7 +103,9 @@ namespace {
         count(0),
         value(std::numeric_limits<unsigned int>::max()),
         _lastHeartbeatStartDate(0),
-        _numFailuresSinceLastStart(std::numeric_limits<int>::max()) {
+        _numFailuresSinceLastStart(std::numeric_limits<int>::max()),
+        _lastOpTimeDate(0),
+        _applyRate(-1) {
     }
 
     void PingStats::start(Date_t now) {
@@ -114,6 +120,18 @@ namespace {
             static_cast<unsigned long>((value * .8) + (millis * .2));
     }
 
+    void PingStats::noteOpTime(Date_t now, const OpTime& opTime) {
+        if (_lastOpTimeDate != Date_t(0) && now > _lastOpTimeDate) {
+            const double advancedSecs = opTime > _lastOpTime ?
+                double(opTime.getSecs()) - double(_lastOpTime.getSecs()) : 0.0;
+            const double elapsedSecs = (now.asInt64() - _lastOpTimeDate.asInt64()) / 1000.0;
+            const double rate = std::min(advancedSecs / elapsedSecs, 1.0);
+            _applyRate = _applyRate < 0 ? rate : (_applyRate * .8) + (rate * .2);
+        }
+        _lastOpTimeDate = now;
+        _lastOpTime = opTime;
+    }
+
     void PingStats::miss() {
         ++_numFailuresSinceLastStart;
     }
@@ -201,7 +219,21 @@ namespace {
             }
         }
 
-        // find the member with the lowest ping time that is ahead of me
+        // find the member that we expect to lag the least behind if we sync from it, measured
+        // against the freshest member we can see
+        OpTime freshestOpTime;
+        double freshestApplyRate = 1.0;
+        for (std::vector<MemberHeartbeatData>::const_iterator it = _hbdata.begin();
+             it != _hbdata.end();
+             ++it) {
+            if (indexOfIterator(_hbdata, it) == _selfIndex || !it->up() ||
+                    !it->getState().readable() || it->getOpTime() <= freshestOpTime) {
+                continue;
+            }
+            freshestOpTime = it->getOpTime();
+            freshestApplyRate = _pings[_rsConfig.getMemberAt(indexOfIterator(_hbdata, it))
+                                       .getHostAndPort()].getApplyRate();
+        }
 
         // Find primary's oplog time. Reject sync candidates that are more than
         // maxSyncSourceLagSecs seconds behind.
@@ -224,6 +256,12 @@ namespace {
         OpTime oldestSyncOpTime(primaryOpTime.getSecs() - _maxSyncSourceLagSecs.total_seconds(), 0);
 
         int closestIndex = -1;
+        long long closestLag = 0;
+
+        // Keep syncing from the current source if it is nearly as good as the best candidate.
+        const HostAndPort previousSyncSource = _syncSource;
+        int previousIndex = -1;
+        long long previousLag = 0;
 
         // Make two attempts.  The first attempt, we ignore those nodes with
         // slave delay higher than our own, hidden nodes, and nodes that are excessively lagged.
@@ -267,13 +305,6 @@ namespace {
                     continue;
                 }
 
-                // omit nodes that are more latent than anything we've already considered
-                if ((closestIndex != -1) &&
-                    (_getPing(itMemberConfig.getHostAndPort())
-                     > _getPing(_rsConfig.getMemberAt(closestIndex).getHostAndPort()))) {
-                    continue;
-                }
-
                 if (attempts == 0) {
                     if (_selfConfig().getSlaveDelay() < itMemberConfig.getSlaveDelay()
                         || itMemberConfig.isHidden()) {
@@ -285,10 +316,29 @@ namespace {
                     continue;
                 }
 
+                const long long lag =
+                    _getExpectedSyncLagMillis(itIndex, freshestOpTime, freshestApplyRate);
+                if (itMemberConfig.getHostAndPort() == previousSyncSource) {
+                    previousIndex = itIndex;
+                    previousLag = lag;
+                }
+
+                // omit nodes that we expect to lag more than anything we've already considered
+                if ((closestIndex != -1) && (lag > closestLag)) {
+                    continue;
+                }
+
                 // This candidate has passed all tests; set 'closestIndex'
                 closestIndex = itIndex;
+                closestLag = lag;
             }
             if (closestIndex != -1) break; // no need for second attempt
+            previousIndex = -1;
+        }
+
+        if ((closestIndex != -1) && (previousIndex != -1) &&
+            (previousLag <= closestLag + kSyncSourceChangeMarginMillis)) {
+            closestIndex = previousIndex;
         }
 
         if (closestIndex == -1) {
@@ -798,6 +848,9 @@ namespace {
         }
         else {
             hbStats.hit(networkRoundTripTime.total_milliseconds());
+            if (hbResponse.getValue().hasOpTime()) {
+                hbStats.noteOpTime(now, hbResponse.getValue().getOpTime());
+            }
             // Log diagnostics.
             if (hbResponse.getValue().isStateDisagreement()) {
                 LOG(1) << target <<
@@ -1808,6 +1861,24 @@ namespace {
         return _pings[host].getMillis();
     }
 
+    long long TopologyCoordinatorImpl::_getExpectedSyncLagMillis(int memberIndex,
+                                                                 const OpTime& freshestOpTime,
+                                                                 double freshestApplyRate) {
+        const PingStats& hbStats = _pings[_rsConfig.getMemberAt(memberIndex).getHostAndPort()];
+        const OpTime& opTime = _hbdata[memberIndex].getOpTime();
+
+        long long lagMillis = hbStats.getMillis();
+        if (opTime < freshestOpTime) {
+            lagMillis += (static_cast<long long>(freshestOpTime.getSecs()) - opTime.getSecs())
+                * 1000;
+        }
+        if (hbStats.getApplyRate() < freshestApplyRate) {
+            lagMillis += static_cast<long long>((freshestApplyRate - hbStats.getApplyRate())
+                                                * kHeartbeatInterval.total_milliseconds());
+        }
+        return lagMillis;
+    }
+
     void TopologyCoordinatorImpl::_setElectionTime(const OpTime& newElectionTime) {
         _electionTime = newElectionTime;
     }
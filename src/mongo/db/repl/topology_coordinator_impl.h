@@ -69,6 +69,12 @@ namespace repl {
          */
         void hit(int millis);
 
+        /**
+         * Records that a heartbeat response received at "now" reported the target's last applied
+         * optime as "opTime", updating the weighted average of how fast the target applies.
+         */
+        void noteOpTime(Date_t now, const OpTime& opTime);
+
         /**
          * Records that a heartbeat request failed.
          */
@@ -84,6 +90,12 @@ namespace repl {
          */
         unsigned int getMillis() const { return value; }
 
+        /**
+         * Gets the weighted average rate at which the target's last applied optime advances, in
+         * seconds of optime per second, capped at 1.  Assumes 1 until there are two samples.
+         */
+        double getApplyRate() const { return _applyRate < 0 ? 1.0 : _applyRate; }
+
         /**
          * Gets the date at which start() was last called, which is used to determine if
          * a heartbeat should be retried or if the time limit has expired.
@@ -103,6 +115,9 @@ namespace repl {
         unsigned int value;
         Date_t _lastHeartbeatStartDate;
         int _numFailuresSinceLastStart;
+        Date_t _lastOpTimeDate;
+        OpTime _lastOpTime;
+        double _applyRate; // negative until known
     };
 
     class TopologyCoordinatorImpl : public TopologyCoordinator {
@@ -236,6 +251,14 @@ namespace repl {
         // Returns the current "ping" value for the given member by their address
         int _getPing(const HostAndPort& host);
 
+        // Returns how far behind "freshestOpTime" we expect to be if we sync from the member at
+        // "memberIndex": its round trip time, plus how far it trails "freshestOpTime", plus what
+        // it will fall further behind by the next heartbeat when it applies slower than
+        // "freshestApplyRate".
+        long long _getExpectedSyncLagMillis(int memberIndex,
+                                            const OpTime& freshestOpTime,
+                                            double freshestApplyRate);
+
         // Determines if we will veto the member specified by "args.id", given that the last op
         // we have applied locally is "lastOpApplied".
         // If we veto, the errmsg will be filled in with a reason
@@ -43,7 +43,7 @@ namespace mongo {
             slowMS(100), defaultLocalThresholdMillis(15), moveParanoia(true),
             noUnixSocket(false), doFork(0), socket("/tmp"), maxConns(DEFAULT_MAX_CONN), 
             unixSocketPermissions(DEFAULT_UNIX_PERMS), logAppend(false), logRenameOnRotate(true),
-            logWithSyslog(false), isHttpInterfaceEnabled(false)
+            logAsyncQueueSize(0), logAsyncBlockOnOverflow(false), logWithSyslog(false), isHttpInterfaceEnabled(false)
         {
             started = time(0);
         }
@@ -92,6 +92,8 @@ namespace mongo {
         std::string logpath;   // Path to log file, if logging to a file; otherwise, empty.
         bool logAppend;        // True if logging to a file in append mode.
         bool logRenameOnRotate;// True if logging should rename log files on rotate
+        int logAsyncQueueSize; // Lines buffered for the log file writer thread; 0 logs synchronously.
+        bool logAsyncBlockOnOverflow; // True if loggers wait, rather than drop, when it is full.
         bool logWithSyslog;    // True if logging to syslog; must not be set if logpath is set.
         int syslogFacility;    // Facility used when appending messages to the syslog.
 
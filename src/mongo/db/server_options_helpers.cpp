@@ -231,6 +231,14 @@ namespace {
         options->addOptionChaining("systemLog.logRotate", "logRotate", moe::String,
                 "set the log rotation behavior (rename|reopen)");
 
+        options->addOptionChaining("systemLog.asyncQueueSize", "logAsyncQueueSize", moe::Int,
+                "write the log file from a background thread, buffering up to this many lines "
+                "(0 writes synchronously)");
+
+        options->addOptionChaining("systemLog.asyncOverflow", "logAsyncOverflow", moe::String,
+                "what to do with log lines when the async log queue is full (drop|block)")
+                                  .requires("systemLog.asyncQueueSize");
+
         options->addOptionChaining("systemLog.timeStampFormat", "timeStampFormat", moe::String,
                 "Desired format for timestamps in log messages. One of ctime, "
                 "iso8601-utc or iso8601-local");
@@ -888,6 +896,29 @@ namespace {
             }
         }
 
+        if (params.count("systemLog.asyncQueueSize")) {
+            int queueSize = params["systemLog.asyncQueueSize"].as<int>();
+            if (queueSize < 0) {
+                return Status(ErrorCodes::BadValue,
+                              "systemLog.asyncQueueSize must be greater than or equal to 0");
+            }
+            serverGlobalParams.logAsyncQueueSize = queueSize;
+        }
+
+        if (params.count("systemLog.asyncOverflow")) {
+            std::string overflowParam = params["systemLog.asyncOverflow"].as<string>();
+            if (overflowParam == "block") {
+                serverGlobalParams.logAsyncBlockOnOverflow = true;
+            }
+            else if (overflowParam == "drop") {
+                serverGlobalParams.logAsyncBlockOnOverflow = false;
+            }
+            else {
+                return Status(ErrorCodes::BadValue,
+                              "unsupported value for asyncOverflow " + overflowParam );
+            }
+        }
+
         if (!serverGlobalParams.logpath.empty() && serverGlobalParams.logWithSyslog) {
             return Status(ErrorCodes::BadValue, "Cant use both a logpath and syslog ");
         }
@@ -50,6 +50,7 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
 #include <snappy.h>
 
 #include "mongo/base/string_data.h"
@@ -401,7 +402,25 @@ namespace mongo {
                 , _settings(settings)
                 , _opts(opts)
                 , _memUsed(0)
-            { verify(_opts.limit == 0); }
+                , _maxRunBytes(opts.maxMemoryUsageBytes)
+            {
+                verify(_opts.limit == 0);
+
+                // Runs being spilled in the background still count against the memory limit,
+                // so split it between them and the run currently being filled.
+                if (_opts.spillThreads > 0)
+                    _maxRunBytes /= (_opts.spillThreads + 1);
+            }
+
+            ~NoLimitSorter() {
+                // Background spills use _comp and _settings, so they must not outlive us.
+                for (size_t i = 0; i < _spills.size(); i++) {
+                    DESTRUCTOR_GUARD(
+                        if (_spills[i]->thread.joinable())
+                            _spills[i]->thread.join();
+                    )
+                }
+            }
 
             void add(const Key& key, const Value& val) {
                 _data.push_back(std::make_pair(key, val));
@@ -409,17 +428,18 @@ namespace mongo {
                 _memUsed += key.memUsageForSorter();
                 _memUsed += val.memUsageForSorter();
 
-                if (_memUsed > _opts.maxMemoryUsageBytes)
+                if (_memUsed > _maxRunBytes)
                     spill();
             }
 
             Iterator* done() {
                 if (_iters.empty()) {
-                    sort();
+                    sort(_data, _comp);
                     return new InMemIterator<Key, Value>(_data);
                 }
 
                 spill();
+                waitForSpills(0);
                 return Iterator::merge(_iters, _opts, _comp);
             }
 
@@ -439,13 +459,83 @@ namespace mongo {
                 const Comparator& _comp;
             };
 
-            void sort() {
-                STLComparator less(_comp);
-                std::stable_sort(_data.begin(), _data.end(), less);
+            /**
+             * A run handed off to a background thread to be sorted and written to a file. Only
+             * the thread running it touches the task until it has been joined.
+             */
+            struct SpillTask {
+                SpillTask(const NoLimitSorter* sorter, size_t iterIndex)
+                    : sorter(sorter)
+                    , iterIndex(iterIndex)
+                    , errorCode(0)
+                {}
+
+                void run() {
+                    try {
+                        result.reset(writeRun(data, sorter->_comp, sorter->_opts,
+                                              sorter->_settings));
+                    }
+                    catch (const DBException& e) {
+                        errorCode = e.getCode();
+                        errorMessage = e.what();
+                    }
+                    catch (const std::exception& e) {
+                        errorCode = ErrorCodes::InternalError;
+                        errorMessage = e.what();
+                    }
+                }
+
+                const NoLimitSorter* const sorter;
+                const size_t iterIndex; // where the result goes in _iters
+                std::deque<Data> data;
+                boost::shared_ptr<Iterator> result;
+                int errorCode; // 0 if run() succeeded
+                std::string errorMessage;
+                boost::thread thread;
+            };
+
+            static void sort(std::deque<Data>& data, const Comparator& comp) {
+                STLComparator less(comp);
+                std::stable_sort(data.begin(), data.end(), less);
 
                 // Does 2x more compares than stable_sort
                 // TODO test on windows
-                //std::sort(_data.begin(), _data.end(), comp);
+                //std::sort(data.begin(), data.end(), comp);
+            }
+
+            /** Sorts 'data' and writes it to a new file, leaving 'data' empty. */
+            static Iterator* writeRun(std::deque<Data>& data,
+                                      const Comparator& comp,
+                                      const SortOptions& opts,
+                                      const Settings& settings) {
+                sort(data, comp);
+
+                SortedFileWriter<Key, Value> writer(opts, settings);
+                for ( ; !data.empty(); data.pop_front()) {
+                    writer.addAlreadySorted(data.front().first, data.front().second);
+                }
+
+                return writer.done();
+            }
+
+            /**
+             * Joins background spills, oldest first, until at most 'maxInProgress' remain.
+             * Rethrows the first error hit by a joined spill.
+             */
+            void waitForSpills(size_t maxInProgress) {
+                while (_spills.size() > maxInProgress) {
+                    boost::shared_ptr<SpillTask> task = _spills.front();
+                    _spills.pop_front();
+                    if (task->thread.joinable())
+                        task->thread.join();
+
+                    if (task->errorCode)
+                        msgasserted(task->errorCode, task->errorMessage);
+
+                    invariant(task->result);
+
+                    _iters[task->iterIndex] = task->result;
+                }
             }
 
             void spill() {
@@ -464,24 +554,32 @@ namespace mongo {
                         );
                 }
 
-                sort();
+                _memUsed = 0;
 
-                SortedFileWriter<Key, Value> writer(_opts, _settings);
-                for ( ; !_data.empty(); _data.pop_front()) {
-                    writer.addAlreadySorted(_data.front().first, _data.front().second);
+                if (_opts.spillThreads <= 0) {
+                    _iters.push_back(
+                        boost::shared_ptr<Iterator>(writeRun(_data, _comp, _opts, _settings)));
+                    return;
                 }
 
-                _iters.push_back(boost::shared_ptr<Iterator>(writer.done()));
-
-                _memUsed = 0;
+                // Keep the slot in _iters so the merge stays stable with respect to input order.
+                waitForSpills(_opts.spillThreads - 1);
+                boost::shared_ptr<SpillTask> task =
+                    boost::make_shared<SpillTask>(this, _iters.size());
+                _iters.push_back(boost::shared_ptr<Iterator>());
+                task->data.swap(_data);
+                _spills.push_back(task);
+                task->thread = boost::thread(&SpillTask::run, task.get());
             }
 
             const Comparator _comp;
             const Settings _settings;
             SortOptions _opts;
             size_t _memUsed;
+            size_t _maxRunBytes; // spill once _memUsed passes this
             std::deque<Data> _data; // the "current" data
             std::vector<boost::shared_ptr<Iterator> > _iters; // data that has already been spilled
+            std::deque<boost::shared_ptr<SpillTask> > _spills; // oldest first
         };
 
         template <typename Key, typename Value, typename Comparator>
@@ -98,11 +98,14 @@ namespace mongo {
         bool extSortAllowed; /// If false, uassert if more mem needed than allowed.
         std::string tempDir; /// Directory to directly place files in.
                              /// Must be explicitly set if extSortAllowed is true.
+        int spillThreads; /// Number of background threads sorting and writing spilled runs.
+                          /// 0 spills on the thread calling add(). Only used with no limit.
 
         SortOptions()
             : limit(0)
             , maxMemoryUsageBytes(64*1024*1024)
             , extSortAllowed(false)
+            , spillThreads(0)
         {}
 
         /// Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
@@ -126,6 +129,11 @@ namespace mongo {
             tempDir = newTempDir;
             return *this;
         }
+
+        SortOptions& SpillThreads(int newSpillThreads) {
+            spillThreads = newSpillThreads;
+            return *this;
+        }
     };
 
     /// This is the output from the sorting framework
@@ -0,0 +1,125 @@
+// sorter_bench.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/sorter/sorter.h"
+
+#include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <vector>
+
+#include "mongo/platform/random.h"
+#include "mongo/unittest/benchmark.h"
+
+#include "mongo/db/sorter/sorter.cpp"
+
+namespace mongo {
+namespace {
+
+    using boost::scoped_ptr;
+    using unittest::doNotOptimizeAway;
+
+    class IntWrapper {
+    public:
+        IntWrapper(int i=0) :_i(i) {}
+        operator const int& () const { return _i; }
+
+        /// members for Sorter
+        struct SorterDeserializeSettings {}; // unused
+        void serializeForSorter(BufBuilder& buf) const { buf.appendNum(_i); }
+        static IntWrapper deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&) {
+            return buf.read<int>();
+        }
+        int memUsageForSorter() const { return sizeof(IntWrapper); }
+        IntWrapper getOwned() const { return *this; }
+    private:
+        int _i;
+    };
+
+    typedef std::pair<IntWrapper, IntWrapper> IWPair;
+    typedef Sorter<IntWrapper, IntWrapper> IWSorter;
+
+    class IWComparator {
+    public:
+        int operator() (const IWPair& lhs, const IWPair& rhs) const {
+            if (lhs.first == rhs.first) return 0;
+            return lhs.first < rhs.first ? -1 : 1;
+        }
+    };
+
+    const int kNumInputs = 10 * 1000;
+
+    std::vector<int> makeInputs() {
+        PseudoRandom random(1);
+        std::vector<int> inputs;
+        for (int i = 0; i < kNumInputs; i++) {
+            inputs.push_back(random.nextInt32());
+        }
+        return inputs;
+    }
+
+    void sortAll(const std::vector<int>& inputs, const SortOptions& opts) {
+        scoped_ptr<IWSorter> sorter(IWSorter::make(opts, IWComparator()));
+        for (size_t i = 0; i < inputs.size(); i++) {
+            sorter->add(inputs[i], -inputs[i]);
+        }
+
+        scoped_ptr<IWSorter::Iterator> it(sorter->done());
+        int last = 0;
+        while (it->more()) {
+            last = it->next().first;
+        }
+        doNotOptimizeAway(last);
+    }
+
+    BENCHMARK(Sorter, InMemoryNoLimit) {
+        const std::vector<int> inputs = makeInputs();
+        while (state.keepRunning()) {
+            sortAll(inputs, SortOptions());
+        }
+    }
+
+    BENCHMARK(Sorter, InMemoryTopK) {
+        const std::vector<int> inputs = makeInputs();
+        while (state.keepRunning()) {
+            sortAll(inputs, SortOptions().Limit(100));
+        }
+    }
+
+    BENCHMARK(Sorter, LimitOne) {
+        const std::vector<int> inputs = makeInputs();
+        while (state.keepRunning()) {
+            sortAll(inputs, SortOptions().Limit(1));
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
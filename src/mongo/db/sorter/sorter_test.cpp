@@ -499,6 +499,12 @@ namespace mongo {
         };
 
 
+        class LotsOfDataLittleMemoryParallelSpills : public LotsOfDataLittleMemory</*random=*/true> {
+            SortOptions adjustSortOptions(SortOptions opts) {
+                return LotsOfDataLittleMemory<true>::adjustSortOptions(opts).SpillThreads(2);
+            }
+        };
+
         template <long long Limit, bool Random=true>
         class LotsOfDataWithLimit : public LotsOfDataLittleMemory<Random> {
             typedef LotsOfDataLittleMemory<Random> Parent;
@@ -539,6 +545,7 @@ namespace mongo {
             add<SorterTests::Dupes>();
             add<SorterTests::LotsOfDataLittleMemory</*random=*/false> >();
             add<SorterTests::LotsOfDataLittleMemory</*random=*/true> >();
+            add<SorterTests::LotsOfDataLittleMemoryParallelSpills>();
             add<SorterTests::LotsOfDataWithLimit<1,/*random=*/false> >(); // limit=1 is special case
             add<SorterTests::LotsOfDataWithLimit<1,/*random=*/true> >();  // limit=1 is special case
             add<SorterTests::LotsOfDataWithLimit<100,/*random=*/false> >(); // fits in mem
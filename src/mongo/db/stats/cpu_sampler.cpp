@@ -0,0 +1,405 @@
+// cpu_sampler.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/stats/cpu_sampler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/time.h>
+#endif
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/backtrace.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/threadlocal.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    // Samples per second of CPU time, 0 for none.
+    MONGO_EXPORT_SERVER_PARAMETER(cpuSamplerHz, int, 0);
+
+namespace {
+
+    const int kMaxFrames = 48;
+
+    // Frames of the signal handler itself and of the signal trampoline.
+    const int kSkipFrames = 2;
+
+    // Must hold all the samples taken between two passes of the aggregating thread.
+    const unsigned kNumSamples = 4096;
+
+    // Distinct stacks kept; the samples of any others are added up as one "[other]" stack.
+    const size_t kMaxStacks = 10000;
+
+    struct SamplerThreadTag {
+        SamplerThreadTag() : op(NULL), valid(1) {
+            ns[0] = '\0';
+        }
+
+        const char* op;
+        char ns[CpuSamplerTag::kMaxNsLength];
+
+        // 0 while op and ns are being written, so the signal handler can skip a torn tag.
+        volatile sig_atomic_t valid;
+    };
+
+    /**
+     * A sample waits in the ring, kReady, until the aggregating thread takes it, so that the
+     * signal handler never allocates nor takes a lock.
+     */
+    struct Sample {
+        enum State { kEmpty, kWriting, kReady };
+
+        AtomicUInt32 state;
+        int depth;
+        void* frames[kMaxFrames];
+        const char* op;
+        char ns[CpuSamplerTag::kMaxNsLength];
+    };
+
+    Sample samples[kNumSamples];
+    AtomicUInt32 nextSample;
+
+    AtomicInt64 numSamples;
+    AtomicInt64 numDropped;
+
+    void setTag(SamplerThreadTag* tag, const char* op, const char* ns) {
+        tag->valid = 0;
+#if !defined(_WIN32)
+        __sync_synchronize();
+#endif
+        tag->op = op;
+        strncpy(tag->ns, ns, CpuSamplerTag::kMaxNsLength - 1);
+        tag->ns[CpuSamplerTag::kMaxNsLength - 1] = '\0';
+#if !defined(_WIN32)
+        __sync_synchronize();
+#endif
+        tag->valid = 1;
+    }
+
+} // namespace
+
+    TSP_DECLARE(SamplerThreadTag, samplerThreadTag);
+    TSP_DEFINE(SamplerThreadTag, samplerThreadTag);
+
+    CpuSamplerTag::CpuSamplerTag(const char* op, const StringData& ns) {
+        SamplerThreadTag* tag = samplerThreadTag.getMake();
+        _savedOp = tag->op;
+        memcpy(_savedNs, tag->ns, sizeof(_savedNs));
+
+        char nsCopy[kMaxNsLength];
+        const size_t length = std::min(ns.size(), kMaxNsLength - 1);
+        memcpy(nsCopy, ns.rawData(), length);
+        nsCopy[length] = '\0';
+        setTag(tag, op, nsCopy);
+    }
+
+    CpuSamplerTag::~CpuSamplerTag() {
+        setTag(samplerThreadTag.get(), _savedOp, _savedNs);
+    }
+
+#if !defined(_WIN32)
+namespace {
+
+    /**
+     * The SIGPROF handler: async signal safe, so it only uses atomics, thread locals and
+     * backtrace(), which startCpuSampler() calls once beforehand so it has nothing to load.
+     */
+    void takeSample(int) {
+        const int savedErrno = errno;
+
+        Sample& sample = samples[nextSample.fetchAndAdd(1) % kNumSamples];
+        if (sample.state.compareAndSwap(Sample::kEmpty, Sample::kWriting) != Sample::kEmpty) {
+            // The aggregating thread is behind.
+            numDropped.fetchAndAdd(1);
+            errno = savedErrno;
+            return;
+        }
+
+        sample.depth = backtrace(sample.frames, kMaxFrames);
+
+        const SamplerThreadTag* tag = samplerThreadTag.get();
+        if (tag && tag->valid && tag->op) {
+            sample.op = tag->op;
+            memcpy(sample.ns, tag->ns, sizeof(sample.ns));
+        }
+        else {
+            sample.op = NULL;
+            sample.ns[0] = '\0';
+        }
+
+        sample.state.store(Sample::kReady);
+        errno = savedErrno;
+    }
+
+    /**
+     * Returns the function containing 'address', without its arguments.
+     */
+    std::string symbolize(void* address) {
+        Dl_info info;
+        if (!dladdr(address, &info) || !info.dli_sname) {
+            return str::stream() << address;
+        }
+
+        std::string name = info.dli_sname;
+        int status;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+        if (demangled) {
+            name = demangled;
+            free(demangled);
+        }
+
+        const size_t paren = name.find('(');
+        if (paren != std::string::npos && paren > 0) {
+            name.resize(paren);
+        }
+        return name;
+    }
+
+    /**
+     * Owns the aggregated samples, by folded stack.
+     */
+    class CpuSampler : public BackgroundJob {
+    public:
+        CpuSampler() : _hz(0) { }
+
+        virtual std::string name() const { return "CpuSampler"; }
+
+        virtual void run() {
+            while (!inShutdown()) {
+                sleepmillis(1000);
+                _setTimer();
+                _aggregate();
+            }
+        }
+
+        /**
+         * Appends the folded stacks, most sampled first.
+         */
+        void report(BSONObjBuilder* builder, bool reset) {
+            boost::mutex::scoped_lock lk(_mutex);
+
+            std::vector<std::pair<long long, const std::string*> > sorted;
+            sorted.reserve(_stacks.size());
+            for (StackMap::const_iterator it = _stacks.begin(); it != _stacks.end(); ++it) {
+                sorted.push_back(std::make_pair(it->second, &it->first));
+            }
+            std::sort(sorted.rbegin(), sorted.rend());
+
+            builder->append("hz", _hz);
+            builder->appendNumber("samples", numSamples.load());
+            builder->appendNumber("dropped", numDropped.load());
+
+            BSONArrayBuilder stacks(builder->subarrayStart("stacks"));
+            for (size_t i = 0; i < sorted.size(); i++) {
+                // Leave the rest out rather than go over the reply size limit.
+                if (stacks.len() > BSONObjMaxUserSize / 2) {
+                    break;
+                }
+                stacks.append(str::stream() << *sorted[i].second << ' ' << sorted[i].first);
+            }
+            stacks.done();
+
+            if (reset) {
+                _stacks.clear();
+                numSamples.store(0);
+                numDropped.store(0);
+            }
+        }
+
+    private:
+        typedef std::map<std::string, long long> StackMap;
+
+        void _setTimer() {
+            const int hz = std::min(std::max(static_cast<int>(cpuSamplerHz), 0), 1000);
+            if (hz == _hz) {
+                return;
+            }
+
+            struct itimerval timer;
+            timer.it_interval.tv_sec = 0;
+            timer.it_interval.tv_usec = hz > 0 ? 1000000 / hz : 0;
+            timer.it_value = timer.it_interval;
+            if (setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+                warning() << "failed to set the CPU sampling timer: " << errnoWithDescription();
+                return;
+            }
+
+            log() << "CPU sampling at " << hz << " Hz";
+            _hz = hz;
+        }
+
+        void _aggregate() {
+            boost::mutex::scoped_lock lk(_mutex);
+
+            for (unsigned i = 0; i < kNumSamples; i++) {
+                Sample& sample = samples[i];
+                if (sample.state.load() != Sample::kReady) {
+                    continue;
+                }
+
+                StringBuilder folded;
+                folded << (sample.op ? sample.op : "[none]") << ';'
+                       << (sample.ns[0] ? sample.ns : "[none]");
+                for (int frame = sample.depth - 1; frame >= kSkipFrames; frame--) {
+                    folded << ';' << _symbolize_inlock(sample.frames[frame]);
+                }
+                sample.state.store(Sample::kEmpty);
+
+                const std::string stack = folded.str();
+                StackMap::iterator it = _stacks.find(stack);
+                if (it == _stacks.end() && _stacks.size() >= kMaxStacks) {
+                    it = _stacks.insert(std::make_pair("[other]", 0)).first;
+                }
+                else if (it == _stacks.end()) {
+                    it = _stacks.insert(std::make_pair(stack, 0)).first;
+                }
+                it->second++;
+                numSamples.fetchAndAdd(1);
+            }
+        }
+
+        const std::string& _symbolize_inlock(void* address) {
+            std::map<void*, std::string>::iterator it = _symbols.find(address);
+            if (it == _symbols.end()) {
+                it = _symbols.insert(std::make_pair(address, symbolize(address))).first;
+            }
+            return it->second;
+        }
+
+        int _hz; // only used by the sampler thread
+
+        boost::mutex _mutex; // protects everything below
+        StackMap _stacks;
+        std::map<void*, std::string> _symbols;
+    };
+
+    CpuSampler* cpuSampler = NULL;
+
+} // namespace
+
+    void startCpuSampler() {
+        invariant(!cpuSampler);
+
+        // backtrace() may load libgcc and allocate the first time, which the signal handler
+        // must not do.
+        void* frames[1];
+        backtrace(frames, 1);
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = takeSample;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, NULL) != 0) {
+            warning() << "failed to install the CPU sampling signal handler: "
+                      << errnoWithDescription();
+            return;
+        }
+
+        cpuSampler = new CpuSampler();
+        cpuSampler->go();
+    }
+#else
+    void startCpuSampler() { }
+#endif
+
+namespace {
+
+    /**
+     * Returns the CPU samples taken while cpuSamplerHz is on, as folded stacks.
+     *
+     * { cpuSamples: 1, reset: <bool> }
+     */
+    class CmdCpuSamples : public Command {
+    public:
+        CmdCpuSamples() : Command("cpuSamples") { }
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+
+        virtual void help(std::stringstream& help) const {
+            help << "CPU samples aggregated as folded stacks, see the cpuSamplerHz parameter\n"
+                 << "{ cpuSamples: 1, reset: <bool> }";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::cpuProfiler);
+            out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+        }
+
+        virtual bool run(OperationContext* txn,
+                         const std::string& dbname,
+                         BSONObj& cmdObj,
+                         int,
+                         std::string& errmsg,
+                         BSONObjBuilder& result,
+                         bool fromRepl) {
+#if !defined(_WIN32)
+            if (cpuSampler) {
+                cpuSampler->report(&result, cmdObj["reset"].trueValue());
+                return true;
+            }
+#endif
+            errmsg = "the CPU sampler is not running";
+            return false;
+        }
+    } cmdCpuSamples;
+
+} // namespace
+
+} // namespace mongo
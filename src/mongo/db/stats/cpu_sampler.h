@@ -0,0 +1,75 @@
+// cpu_sampler.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+
+namespace mongo {
+
+    /**
+     * A sampling CPU profiler cheap enough to leave on. While the cpuSamplerHz server parameter
+     * is above 0, SIGPROF interrupts whichever thread is using the CPU that many times per
+     * second of CPU time, and the handler copies its stack and CpuSamplerTag into a ring of
+     * preallocated samples. A background thread adds the samples up by stack, which the
+     * cpuSamples command returns as folded stacks ("op;ns;outermost;...;innermost count"),
+     * ready for flame graph tools.
+     *
+     * Only supported where there is SIGPROF and backtrace(), and not together with the
+     * gperftools profiler, which uses SIGPROF too.
+     */
+
+    /**
+     * Tags the CPU samples taken on this thread while in scope with an operation type and
+     * namespace. Tags nest, restoring the enclosing one on destruction.
+     */
+    class CpuSamplerTag {
+        MONGO_DISALLOW_COPYING(CpuSamplerTag);
+    public:
+        static const size_t kMaxNsLength = 64;
+
+        /**
+         * 'op' must be a string literal, 'ns' is copied, truncated to kMaxNsLength - 1 bytes.
+         */
+        CpuSamplerTag(const char* op, const StringData& ns);
+        ~CpuSamplerTag();
+
+    private:
+        const char* _savedOp;
+        char _savedNs[kMaxNsLength];
+    };
+
+    /**
+     * Starts the thread following cpuSamplerHz and aggregating the samples.
+     */
+    void startCpuSampler();
+
+} // namespace mongo
@@ -0,0 +1,201 @@
+// latency_histogram.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/stats/latency_histogram.h"
+
+#include <cstring>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/concurrency/threadlocal.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+namespace {
+
+    AtomicUInt32 nextStripe;
+
+    /**
+     * The stripe of LatencyHistograms that a thread records into.
+     */
+    struct LatencyStripeIndex {
+        LatencyStripeIndex()
+            : index(nextStripe.fetchAndAdd(1) % LatencyHistogram::kNumStripes) { }
+
+        const unsigned index;
+    };
+
+    void appendHistogram(BSONObjBuilder* builder,
+                         const char* name,
+                         const LatencyHistogram& histogram) {
+        BSONObjBuilder histogramBuilder(builder->subobjStart(name));
+        histogram.snapshot().append(&histogramBuilder);
+        histogramBuilder.done();
+    }
+
+} // namespace
+
+    TSP_DECLARE(LatencyStripeIndex, latencyStripeIndex);
+    TSP_DEFINE(LatencyStripeIndex, latencyStripeIndex);
+
+    OpLatencyStats globalOpLatencyStats;
+
+    LatencyBuckets::LatencyBuckets() : count(0), totalMicros(0) {
+        memset(buckets, 0, sizeof(buckets));
+    }
+
+    LatencyBuckets::LatencyBuckets(const LatencyBuckets& older, const LatencyBuckets& newer) {
+        // like Top::UsageData, this won't be exact across a drop(), but it won't be negative
+        count = (newer.count >= older.count) ? (newer.count - older.count) : newer.count;
+        totalMicros = (newer.totalMicros >= older.totalMicros) ?
+            (newer.totalMicros - older.totalMicros) : newer.totalMicros;
+        for (int i = 0; i < kNumBuckets; i++) {
+            buckets[i] = (newer.buckets[i] >= older.buckets[i]) ?
+                (newer.buckets[i] - older.buckets[i]) : newer.buckets[i];
+        }
+    }
+
+    int LatencyBuckets::bucketFor(long long micros) {
+        int bucket = 0;
+        while (micros > 1 && bucket < kNumBuckets - 1) {
+            micros >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    void LatencyBuckets::record(long long micros) {
+        count++;
+        totalMicros += micros;
+        buckets[bucketFor(micros)]++;
+    }
+
+    void LatencyBuckets::add(const LatencyBuckets& other) {
+        count += other.count;
+        totalMicros += other.totalMicros;
+        for (int i = 0; i < kNumBuckets; i++) {
+            buckets[i] += other.buckets[i];
+        }
+    }
+
+    long long LatencyBuckets::percentileMicros(double percentile) const {
+        if (count == 0) {
+            return 0;
+        }
+
+        // The smallest number of operations that must be at or below the percentile
+        const long long rank = std::max(1LL, static_cast<long long>(count * percentile / 100));
+
+        long long seen = 0;
+        for (int i = 0; i < kNumBuckets - 1; i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return 2LL << i;
+            }
+        }
+        return 2LL << (kNumBuckets - 1);
+    }
+
+    void LatencyBuckets::append(BSONObjBuilder* builder) const {
+        builder->append("count", count);
+        builder->append("micros", totalMicros);
+        builder->append("p50", percentileMicros(50));
+        builder->append("p99", percentileMicros(99));
+        builder->append("p999", percentileMicros(99.9));
+
+        int numBuckets = kNumBuckets;
+        while (numBuckets > 0 && buckets[numBuckets - 1] == 0) {
+            numBuckets--;
+        }
+
+        BSONArrayBuilder bucketsBuilder(builder->subarrayStart("buckets"));
+        for (int i = 0; i < numBuckets; i++) {
+            bucketsBuilder.append(buckets[i]);
+        }
+        bucketsBuilder.done();
+    }
+
+    void LatencyHistogram::record(long long micros) {
+        Stripe& stripe = _stripes[latencyStripeIndex.getMake()->index];
+        stripe.count.fetchAndAdd(1);
+        stripe.totalMicros.fetchAndAdd(micros);
+        stripe.buckets[LatencyBuckets::bucketFor(micros)].fetchAndAdd(1);
+    }
+
+    LatencyBuckets LatencyHistogram::snapshot() const {
+        LatencyBuckets out;
+        for (int s = 0; s < kNumStripes; s++) {
+            const Stripe& stripe = _stripes[s];
+            out.count += stripe.count.load();
+            out.totalMicros += stripe.totalMicros.load();
+            for (int i = 0; i < LatencyBuckets::kNumBuckets; i++) {
+                out.buckets[i] += stripe.buckets[i].load();
+            }
+        }
+        return out;
+    }
+
+    void OpLatencyStats::record(int op, bool isCommand, long long micros) {
+        switch (op) {
+        case dbQuery:
+            if (isCommand)
+                _command.record(micros);
+            else
+                _query.record(micros);
+            break;
+        case dbGetMore:
+            _getmore.record(micros);
+            break;
+        case dbInsert:
+            _insert.record(micros);
+            break;
+        case dbUpdate:
+            _update.record(micros);
+            break;
+        case dbDelete:
+            _delete.record(micros);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void OpLatencyStats::append(BSONObjBuilder* builder) const {
+        appendHistogram(builder, "query", _query);
+        appendHistogram(builder, "getmore", _getmore);
+        appendHistogram(builder, "insert", _insert);
+        appendHistogram(builder, "update", _update);
+        appendHistogram(builder, "delete", _delete);
+        appendHistogram(builder, "command", _command);
+    }
+
+} // namespace mongo
@@ -0,0 +1,140 @@
+// latency_histogram.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * Latency counts in fixed, log-scale buckets: bucket 0 holds latencies under 2 microseconds,
+     * bucket i > 0 those in [2^i, 2^(i+1)) microseconds, and the last bucket everything above.
+     * Since the buckets are the same in every process, the histograms of several processes, such
+     * as all the mongos of a cluster, merge by adding their counts bucket by bucket.
+     *
+     * Not thread safe; see LatencyHistogram for concurrent recording.
+     */
+    struct LatencyBuckets {
+        static const int kNumBuckets = 32;
+
+        LatencyBuckets();
+
+        /**
+         * constructs a diff
+         */
+        LatencyBuckets(const LatencyBuckets& older, const LatencyBuckets& newer);
+
+        void record(long long micros);
+
+        /**
+         * Merges the counts of 'other' into these.
+         */
+        void add(const LatencyBuckets& other);
+
+        /**
+         * Returns the exclusive upper bound, in microseconds, of the bucket holding the latency at
+         * 'percentile' (0 to 100), or 0 if nothing was recorded.
+         */
+        long long percentileMicros(double percentile) const;
+
+        /**
+         * Appends { count, micros, p50, p99, p999, buckets: [ ... ] }, with the bucket counts up
+         * to the last non-empty bucket.
+         */
+        void append(BSONObjBuilder* builder) const;
+
+        static int bucketFor(long long micros);
+
+        long long count;
+        long long totalMicros;
+        long long buckets[kNumBuckets];
+    };
+
+    /**
+     * LatencyBuckets which many threads can record into at once. The counts are spread over
+     * stripes picked per thread, so that threads recording concurrently seldom write to the same
+     * cache line.
+     */
+    class LatencyHistogram {
+        MONGO_DISALLOW_COPYING(LatencyHistogram);
+    public:
+        static const int kNumStripes = 4;
+
+        LatencyHistogram() { }
+
+        void record(long long micros);
+
+        /**
+         * Returns the sum of all the stripes. Counts recorded meanwhile may or may not be in it.
+         */
+        LatencyBuckets snapshot() const;
+
+    private:
+        struct Stripe {
+            AtomicInt64 count;
+            AtomicInt64 totalMicros;
+            AtomicInt64 buckets[LatencyBuckets::kNumBuckets];
+            char pad[64];
+        };
+
+        Stripe _stripes[kNumStripes];
+    };
+
+    /**
+     * Latencies of the client operations of this process, by type of operation.
+     */
+    class OpLatencyStats {
+    public:
+        /**
+         * Records 'micros' for an operation of type 'op' (see the opcodes in message.h).
+         */
+        void record(int op, bool isCommand, long long micros);
+
+        /**
+         * Appends a sub-object per type of operation, see LatencyBuckets::append().
+         */
+        void append(BSONObjBuilder* builder) const;
+
+    private:
+        LatencyHistogram _query;
+        LatencyHistogram _getmore;
+        LatencyHistogram _insert;
+        LatencyHistogram _update;
+        LatencyHistogram _delete;
+        LatencyHistogram _command;
+    };
+
+    extern OpLatencyStats globalOpLatencyStats;
+
+} // namespace mongo
@@ -30,6 +30,9 @@
 
 #include "mongo/db/client.h"
 #include "mongo/db/commands/server_status.h"
+#include "mongo/db/concurrency/admission_control.h"
+#include "mongo/db/concurrency/lock_contention.h"
+#include "mongo/db/concurrency/lock_manager.h"
 #include "mongo/db/concurrency/lock_stats.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/operation_context.h"
@@ -142,5 +145,49 @@ namespace {
 
     } lockStatsServerStatusSection;
 
+
+    class LockContentionServerStatusSection : public ServerStatusSection {
+    public:
+        LockContentionServerStatusSection() : ServerStatusSection("lockContention") { }
+
+        virtual bool includeByDefault() const { return true; }
+
+        virtual BSONObj generateSection(OperationContext* txn,
+                                        const BSONElement& configElement) const {
+            BSONObjBuilder ret;
+            globalContendedResources.report(&ret);
+
+            BSONObjBuilder mutexes(ret.subobjStart("lockManagerMutexes"));
+            mutexes.append("contended",
+                           static_cast<long long>(lockManagerMutexStats.contended.load()));
+            mutexes.append("slept", static_cast<long long>(lockManagerMutexStats.slept.load()));
+            mutexes.done();
+
+            return ret.obj();
+        }
+
+    } lockContentionServerStatusSection;
+
+
+    class AdmissionControlServerStatusSection : public ServerStatusSection {
+    public:
+        AdmissionControlServerStatusSection() : ServerStatusSection("admissionControl") { }
+
+        virtual bool includeByDefault() const { return true; }
+
+        virtual BSONObj generateSection(OperationContext* txn,
+                                        const BSONElement& configElement) const {
+            AdmissionTickets* tickets = getGlobalAdmissionTickets();
+            if (!tickets) {
+                return BSONObj();
+            }
+
+            BSONObjBuilder ret;
+            tickets->report(&ret);
+            return ret.obj();
+        }
+
+    } admissionControlServerStatusSection;
+
 } // namespace
 } // namespace mongo
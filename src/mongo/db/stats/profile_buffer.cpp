@@ -0,0 +1,110 @@
+// profile_buffer.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/stats/profile_buffer.h"
+
+#include <algorithm>
+
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+
+    // Number of profile documents kept in memory instead of being written to system.profile as
+    // each operation ends. 0 writes them to system.profile directly.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(profileBufferSize, int, 0);
+
+    ProfileBuffer::ProfileBuffer(size_t numSlots)
+        : _numSlots(numSlots),
+          _slots(new Slot[numSlots]) {
+        invariant(numSlots > 0);
+    }
+
+    void ProfileBuffer::push(const StringData& db, const BSONObj& doc) {
+        const unsigned long long seq = _lastSeq.addAndFetch(1);
+        Slot& slot = _slots[seq % _numSlots];
+
+        scoped_spinlock lk(slot.lock);
+        if (slot.entry.seq > seq) {
+            // A whole lap of newer entries got here first, this one is already too old to keep.
+            return;
+        }
+        slot.entry.seq = seq;
+        slot.entry.db = db.toString();
+        slot.entry.doc = doc.getOwned();
+    }
+
+    unsigned long long ProfileBuffer::read(const StringData& db,
+                                           unsigned long long afterSeq,
+                                           int maxBytes,
+                                           std::vector<Entry>* out) const {
+        const unsigned long long last = _lastSeq.load();
+        const unsigned long long oldest = last >= _numSlots ? last - _numSlots + 1 : 1;
+
+        int bytes = 0;
+        for (unsigned long long seq = std::max(afterSeq + 1, oldest); seq <= last; seq++) {
+            const Slot& slot = _slots[seq % _numSlots];
+
+            Entry entry;
+            {
+                scoped_spinlock lk(slot.lock);
+                if (slot.entry.seq < seq) {
+                    // Still being pushed, pick it up on the next read.
+                    return seq - 1;
+                }
+                if (slot.entry.seq > seq) {
+                    // Overwritten since 'last' was read.
+                    continue;
+                }
+                entry = slot.entry;
+            }
+
+            if (!db.empty() && db != entry.db) {
+                continue;
+            }
+
+            if (!out->empty() && bytes + entry.doc.objsize() > maxBytes) {
+                return seq - 1;
+            }
+            bytes += entry.doc.objsize();
+            out->push_back(entry);
+        }
+
+        return std::max(last, afterSeq);
+    }
+
+    ProfileBuffer* getGlobalProfileBuffer() {
+        static ProfileBuffer* const buffer =
+            profileBufferSize > 0 ? new ProfileBuffer(profileBufferSize) : NULL;
+        return buffer;
+    }
+
+} // namespace mongo
@@ -0,0 +1,103 @@
+// profile_buffer.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/scoped_array.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/spin_lock.h"
+
+namespace mongo {
+
+    /**
+     * A fixed size, in-memory ring of the most recent profile documents, which the profiler
+     * writes into instead of system.profile when the profileBufferSize server parameter is set.
+     *
+     * Each document gets the next of an ever increasing sequence number, and goes in the slot
+     * that number maps to, overwriting the oldest document. Writers only ever contend on the lock
+     * of a single slot, and only if the ring wraps around while one of them is still copying.
+     */
+    class ProfileBuffer {
+        MONGO_DISALLOW_COPYING(ProfileBuffer);
+    public:
+        struct Entry {
+            Entry() : seq(0) { }
+
+            unsigned long long seq;
+            std::string db;
+            BSONObj doc;
+        };
+
+        explicit ProfileBuffer(size_t numSlots);
+
+        void push(const StringData& db, const BSONObj& doc);
+
+        /**
+         * Appends to 'out', oldest first, the entries of database 'db' (or of every database if
+         * 'db' is empty) numbered above 'afterSeq' which are still in the buffer, stopping once
+         * their documents add up to 'maxBytes'. Returns the number to pass as 'afterSeq' to read
+         * on from there.
+         */
+        unsigned long long read(const StringData& db,
+                                unsigned long long afterSeq,
+                                int maxBytes,
+                                std::vector<Entry>* out) const;
+
+        /**
+         * Number of the newest entry, 0 if none.
+         */
+        unsigned long long lastSeq() const { return _lastSeq.load(); }
+
+        size_t numSlots() const { return _numSlots; }
+
+    private:
+        struct Slot {
+            mutable SpinLock lock;
+            Entry entry;
+        };
+
+        const size_t _numSlots;
+        boost::scoped_array<Slot> _slots;
+        AtomicUInt64 _lastSeq;
+    };
+
+    /**
+     * Returns the buffer the profiler writes into, or NULL when profiling goes straight to
+     * system.profile.
+     */
+    ProfileBuffer* getGlobalProfileBuffer();
+
+} // namespace mongo
@@ -28,6 +28,7 @@
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/commands/server_status.h"
+#include "mongo/db/range_deleter_db_env.h"
 #include "mongo/db/range_deleter_service.h"
 
 namespace mongo {
@@ -38,6 +39,15 @@ namespace mongo {
      * Sample format:
      *
      * rangeDeleter: {
+     *   pendingDeletes: 2,
+     *   deletesInProgress: 1,
+     *   totalDeletes: 3,
+     *   throughput: {
+     *     deletedDocs: NumberLong(12000),
+     *     deletedBytes: NumberLong(1536000),
+     *     batches: NumberLong(120),
+     *     throttledMillis: NumberLong(350)
+     *   },
      *   lastDeleteStats: [
      *     {
      *       deleteDocs: NumberLong(5);
@@ -66,6 +76,17 @@ namespace mongo {
 
             BSONObjBuilder result;
 
+            result.appendNumber("pendingDeletes",
+                                static_cast<long long>(deleter->getPendingDeletes()));
+            result.appendNumber("deletesInProgress",
+                                static_cast<long long>(deleter->getDeletesInProgress()));
+            result.appendNumber("totalDeletes",
+                                static_cast<long long>(deleter->getTotalDeletes()));
+
+            BSONObjBuilder throughputBuilder(result.subobjStart("throughput"));
+            RangeDeleterDBEnv::appendDeleteStats(&throughputBuilder);
+            throughputBuilder.done();
+
             OwnedPointerVector<DeleteJobStats> statsList;
             deleter->getStatsHistory(&statsList.mutableVector());
             BSONArrayBuilder oldStatsBuilder;
@@ -40,12 +40,35 @@
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/privilege.h"
+#include "mongo/util/concurrency/threadlocal.h"
 #include "mongo/util/log.h"
 #include "mongo/util/net/message.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/commands/server_status.h"
 
 namespace mongo {
 
+    using boost::shared_ptr;
+
+namespace {
+
+    /**
+     * The counters of the collections a thread has recorded into. Holding them by shared_ptr
+     * keeps those of a dropped collection alive until every thread has let go of them.
+     */
+    struct TopThreadCache {
+        TopThreadCache() : owner(NULL), generation(0) { }
+
+        const Top* owner;
+        unsigned long long generation; // of the owner, when the entries were cached
+        StringMap< shared_ptr<Top::CollectionCounters> > entries;
+    };
+
+} // namespace
+
+    TSP_DECLARE(TopThreadCache, topThreadCache);
+    TSP_DEFINE(TopThreadCache, topThreadCache);
+
     Top::UsageData::UsageData( const UsageData& older, const UsageData& newer ) {
         // this won't be 100% accurate on rollovers and drop(), but at least it won't be negative
         time  = (newer.time  >= older.time)  ? (newer.time  - older.time)  : newer.time;
@@ -61,8 +84,31 @@ namespace mongo {
           insert( older.insert, newer.insert ),
           update( older.update, newer.update ),
           remove( older.remove, newer.remove ),
-          commands( older.commands, newer.commands ) {
+          commands( older.commands, newer.commands ),
+          latency( older.latency, newer.latency ) {
+
+    }
 
+    Top::UsageData Top::CollectionCounters::Usage::get() const {
+        UsageData data;
+        data.time = time.load();
+        data.count = count.load();
+        return data;
+    }
+
+    Top::CollectionData Top::CollectionCounters::get() const {
+        CollectionData data;
+        data.total = total.get();
+        data.readLock = readLock.get();
+        data.writeLock = writeLock.get();
+        data.queries = queries.get();
+        data.getmore = getmore.get();
+        data.insert = insert.get();
+        data.update = update.get();
+        data.remove = remove.get();
+        data.commands = commands.get();
+        data.latency = latency.snapshot();
+        return data;
     }
 
     void Top::record( const StringData& ns, int op, int lockType, long long micros, bool command ) {
@@ -70,19 +116,48 @@ namespace mongo {
             return;
 
         //cout << "record: " << ns << "\t" << op << "\t" << command << endl;
+        CollectionCounters* counters = _findCounters( ns, op, command );
+        if ( !counters )
+            return;
+
+        _record( *counters, op, lockType, micros, command );
+    }
+
+    Top::CollectionCounters* Top::_findCounters( const StringData& ns, int op, bool command ) {
+        TopThreadCache* cache = topThreadCache.getMake();
+        const unsigned long long generation = _generation.load();
+        if ( cache->owner != this || cache->generation != generation ) {
+            cache->entries = StringMap< shared_ptr<CollectionCounters> >();
+            cache->owner = this;
+            cache->generation = generation;
+        }
+
+        StringMap< shared_ptr<CollectionCounters> >::const_iterator it = cache->entries.find( ns );
+        if ( it != cache->entries.end() )
+            return it->second.get();
+
         SimpleMutex::scoped_lock lk(_lock);
 
         if ( ( command || op == dbQuery ) && ns == _lastDropped ) {
             _lastDropped = "";
-            return;
+            return NULL;
         }
 
-        CollectionData& coll = _usage[ns];
-        _record( coll, op, lockType, micros, command );
+        shared_ptr<CollectionCounters>& counters = _counters[ns];
+        if ( !counters )
+            counters.reset( new CollectionCounters() );
+
+        // Only cache if no drop came in since the generation was read, as the cache would
+        // otherwise keep counters that are no longer in _counters.
+        if ( _generation.load() == generation )
+            cache->entries[ns] = counters;
+
+        return counters.get();
     }
 
-    void Top::_record( CollectionData& c, int op, int lockType, long long micros, bool command ) {
+    void Top::_record( CollectionCounters& c, int op, int lockType, long long micros, bool command ) {
         c.total.inc( micros );
+        c.latency.record( micros );
 
         if ( lockType > 0 )
             c.writeLock.inc( micros );
@@ -125,21 +200,29 @@ namespace mongo {
 
     void Top::collectionDropped( const StringData& ns ) {
         SimpleMutex::scoped_lock lk(_lock);
-        _usage.erase(ns);
+        _counters.erase(ns);
         _lastDropped = ns.toString();
+        _generation.fetchAndAdd(1);
+        WriteConflictException::namespaceDropped(ns);
     }
 
     void Top::cloneMap(Top::UsageMap& out) const {
         SimpleMutex::scoped_lock lk(_lock);
-        out = _usage;
+        out = UsageMap();
+        for ( CountersMap::const_iterator i = _counters.begin(); i != _counters.end(); ++i ) {
+            out[i->first] = i->second->get();
+        }
     }
 
     void Top::append( BSONObjBuilder& b ) {
-        SimpleMutex::scoped_lock lk( _lock );
-        _appendToUsageMap( b, _usage );
+        UsageMap usage;
+        cloneMap( usage );
+        _appendToUsageMap( b, usage, WriteConflictException::getNamespaceStats() );
     }
 
-    void Top::_appendToUsageMap( BSONObjBuilder& b, const UsageMap& map ) const {
+    void Top::_appendToUsageMap( BSONObjBuilder& b,
+                                 const UsageMap& map,
+                                 const WriteConflictException::NamespaceStatsMap& conflicts ) const {
         // pull all the names into a vector so we can sort them for the user
 
         vector<string> names;
@@ -166,6 +249,20 @@ namespace mongo {
             _appendStatsEntry( b, "remove", coll.remove );
             _appendStatsEntry( b, "commands", coll.commands );
 
+            // Write conflicts retried, with the time spent backing off before the retries.
+            UsageData conflictUsage;
+            WriteConflictException::NamespaceStatsMap::const_iterator conflict =
+                conflicts.find( names[i] );
+            if ( conflict != conflicts.end() ) {
+                conflictUsage.time = conflict->second.backoffMicros;
+                conflictUsage.count = conflict->second.conflicts;
+            }
+            _appendStatsEntry( b, "writeConflicts", conflictUsage );
+
+            BSONObjBuilder latencyBuilder( b.subobjStart( "latency" ) );
+            coll.latency.append( &latencyBuilder );
+            latencyBuilder.done();
+
             bb.done();
         }
     }
@@ -204,6 +301,35 @@ namespace mongo {
 
     } topCmd;
 
+    /**
+     * Write conflicts by namespace. Not included by default, as there is an entry for every
+     * namespace which ever had one: ask with serverStatus({writeConflicts: 1}).
+     */
+    class WriteConflictsSSS : public ServerStatusSection {
+    public:
+        WriteConflictsSSS() : ServerStatusSection( "writeConflicts" ) { }
+
+        virtual bool includeByDefault() const { return false; }
+
+        virtual BSONObj generateSection( OperationContext* txn,
+                                         const BSONElement& configElement ) const {
+            const WriteConflictException::NamespaceStatsMap conflicts =
+                WriteConflictException::getNamespaceStats();
+
+            BSONObjBuilder b;
+            for ( WriteConflictException::NamespaceStatsMap::const_iterator i = conflicts.begin();
+                  i != conflicts.end();
+                  ++i ) {
+                BSONObjBuilder nsBuilder( b.subobjStart( i->first ) );
+                nsBuilder.appendNumber( "conflicts", i->second.conflicts );
+                nsBuilder.appendNumber( "backoffMicros", i->second.backoffMicros );
+                nsBuilder.done();
+            }
+            return b.obj();
+        }
+
+    } writeConflictsSSS;
+
     Top Top::global;
 
 }
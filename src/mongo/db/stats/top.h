@@ -30,7 +30,11 @@
 #pragma once
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/shared_ptr.hpp>
 
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/stats/latency_histogram.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/string_map.h"
 
@@ -38,6 +42,10 @@ namespace mongo {
 
     /**
      * tracks usage by collection
+     *
+     * record() runs at the end of every operation, so it only takes _lock the first time a
+     * thread sees a collection: each thread caches the counters of the collections it has used,
+     * and bumps them with atomic increments. The totals are only summed up when read.
      */
     class Top {
 
@@ -74,10 +82,45 @@ namespace mongo {
             UsageData update;
             UsageData remove;
             UsageData commands;
+
+            LatencyBuckets latency; // of all operations on the collection
         };
 
         typedef StringMap<CollectionData> UsageMap;
 
+        /**
+         * The live, atomically updated counters behind a CollectionData.
+         */
+        struct CollectionCounters {
+            struct Usage {
+                void inc( long long micros ) {
+                    count.fetchAndAdd( 1 );
+                    time.fetchAndAdd( micros );
+                }
+
+                UsageData get() const;
+
+                AtomicInt64 time;
+                AtomicInt64 count;
+            };
+
+            CollectionData get() const;
+
+            Usage total;
+
+            Usage readLock;
+            Usage writeLock;
+
+            Usage queries;
+            Usage getmore;
+            Usage insert;
+            Usage update;
+            Usage remove;
+            Usage commands;
+
+            LatencyHistogram latency;
+        };
+
     public:
         void record( const StringData& ns, int op, int lockType, long long micros, bool command );
         void append( BSONObjBuilder& b );
@@ -88,13 +131,21 @@ namespace mongo {
         static Top global;
 
     private:
-        void _appendToUsageMap( BSONObjBuilder& b, const UsageMap& map ) const;
+        void _appendToUsageMap( BSONObjBuilder& b,
+                                const UsageMap& map,
+                                const WriteConflictException::NamespaceStatsMap& conflicts ) const;
         void _appendStatsEntry( BSONObjBuilder& b, const char * statsName, const UsageData& map ) const;
-        void _record( CollectionData& c, int op, int lockType, long long micros, bool command );
+        void _record( CollectionCounters& c, int op, int lockType, long long micros, bool command );
+        CollectionCounters* _findCounters( const StringData& ns, int op, bool command );
+
+        typedef StringMap< boost::shared_ptr<CollectionCounters> > CountersMap;
 
-        mutable SimpleMutex _lock;
-        UsageMap _usage;
+        mutable SimpleMutex _lock; // protects _counters and _lastDropped
+        CountersMap _counters;
         std::string _lastDropped;
+
+        // Bumped when a collection is dropped, making every thread forget its cached counters.
+        AtomicUInt64 _generation;
     };
 
 } // namespace mongo
@@ -86,6 +86,16 @@ namespace mongo {
         return md.indexes[offset].multikey;
     }
 
+    MultikeyPaths BSONCollectionCatalogEntry::getIndexMultikeyPaths(
+            OperationContext* txn,
+            const StringData& indexName) const {
+        MetaData md = _getMetaData( txn );
+
+        int offset = md.findIndexOffset( indexName );
+        invariant( offset >= 0 );
+        return md.indexes[offset].multikeyPaths;
+    }
+
     RecordId BSONCollectionCatalogEntry::getIndexHead( OperationContext* txn,
                                                       const StringData& indexName ) const {
         MetaData md = _getMetaData( txn );
@@ -162,6 +172,13 @@ namespace mongo {
                 sub.append( "spec", indexes[i].spec );
                 sub.appendBool( "ready", indexes[i].ready );
                 sub.appendBool( "multikey", indexes[i].multikey );
+                if ( !indexes[i].multikeyPaths.empty() ) {
+                    BSONArrayBuilder paths( sub.subarrayStart( "multikeyPaths" ) );
+                    for ( unsigned j = 0; j < indexes[i].multikeyPaths.size(); j++ ) {
+                        paths.append( static_cast<bool>(indexes[i].multikeyPaths[j]) );
+                    }
+                    paths.done();
+                }
                 sub.append( "head", static_cast<long long>(indexes[i].head.repr()) );
                 sub.done();
             }
@@ -193,6 +210,12 @@ namespace mongo {
                                          idx["head_b"].Int() );
                 }
                 imd.multikey = idx["multikey"].trueValue();
+                if ( idx["multikeyPaths"].type() == Array ) {
+                    BSONObjIterator paths( idx["multikeyPaths"].Obj() );
+                    while ( paths.more() ) {
+                        imd.multikeyPaths.push_back( paths.next().trueValue() );
+                    }
+                }
                 indexes.push_back( imd );
             }
         }
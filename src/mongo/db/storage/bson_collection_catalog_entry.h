@@ -62,6 +62,9 @@ namespace mongo {
         virtual bool isIndexMultikey( OperationContext* txn,
                                       const StringData& indexName) const;
 
+        virtual MultikeyPaths getIndexMultikeyPaths(OperationContext* txn,
+                                                    const StringData& indexName) const;
+
         virtual RecordId getIndexHead( OperationContext* txn,
                                       const StringData& indexName ) const;
 
@@ -83,6 +86,9 @@ namespace mongo {
             bool ready;
             RecordId head;
             bool multikey;
+
+            // Empty unless 'multikey' and the multikey fields are known.
+            MultikeyPaths multikeyPaths;
         };
 
         struct MetaData {
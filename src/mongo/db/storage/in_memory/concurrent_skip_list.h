@@ -0,0 +1,307 @@
+// concurrent_skip_list.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <functional>
+#include <new>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/random.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    /**
+     * An ordered map from Key to Payload, built as a skip list that readers walk without taking
+     * any locks. Writers linking in or unlinking nodes serialize on a mutex, which is only held
+     * for the pointer updates; a payload is never moved once its node exists, so a Payload made
+     * of atomics can be updated in place without that mutex.
+     *
+     * Unlinking a node does not free it, as readers may still be positioned on it: remove()
+     * hands the node back and the caller frees it with destroyNode() once no reader can hold
+     * it any more. A node's own next pointers are left intact by removal, so a reader on an
+     * unlinked node still moves forward to the right place.
+     */
+    template <typename Key, typename Payload, typename Compare = std::less<Key> >
+    class ConcurrentSkipList : boost::noncopyable {
+    public:
+        typedef Key KeyType;
+
+        class Node : boost::noncopyable {
+        public:
+            const Key& key() const { return _key; }
+
+            Payload& payload() { return _payload; }
+            const Payload& payload() const { return _payload; }
+
+            /**
+             * The following node, or NULL at the end of the list.
+             */
+            Node* next() const { return _next[0].load(); }
+
+        private:
+            friend class ConcurrentSkipList;
+
+            Node(const Key& key, int height) : _key(key), _height(height) {}
+
+            const Key _key;
+            Payload _payload;
+            const int _height;
+            AtomicWord<Node*> _next[1]; // Really _height of them, see _newNode().
+        };
+
+        static const int kMaxHeight = 16;
+
+        explicit ConcurrentSkipList(const Compare& compare = Compare())
+            : _compare(compare),
+              _head(_newNode(Key(), kMaxHeight)),
+              _random(static_cast<int64_t>(reinterpret_cast<intptr_t>(this))) {
+            _height.store(1);
+        }
+
+        ~ConcurrentSkipList() {
+            Node* node = _head;
+            while (node) {
+                Node* next = node->_next[0].load();
+                destroyNode(node);
+                node = next;
+            }
+        }
+
+        /**
+         * Frees a node returned by remove().
+         */
+        static void destroyNode(Node* node) {
+            for (int i = 1; i < node->_height; i++) {
+                node->_next[i].~AtomicWord<Node*>();
+            }
+            node->~Node();
+            ::operator delete(node);
+        }
+
+        //
+        // Lock-free lookups. Each returns NULL if there is no such node.
+        //
+
+        Node* first() const { return _head->_next[0].load(); }
+
+        Node* last() const {
+            Node* node = _head;
+            int level = _height.load() - 1;
+            while (true) {
+                Node* next = node->_next[level].load();
+                if (next) {
+                    node = next;
+                }
+                else if (level == 0) {
+                    return node == _head ? NULL : node;
+                }
+                else {
+                    level--;
+                }
+            }
+        }
+
+        Node* find(const Key& key) const {
+            Node* node = seekGE(key);
+            return node && !_compare(key, node->_key) ? node : NULL;
+        }
+
+        /**
+         * The first node whose key is >= 'key'.
+         */
+        Node* seekGE(const Key& key) const { return _findGreaterOrEqual(key, NULL); }
+
+        /**
+         * The first node whose key is > 'key'.
+         */
+        Node* seekGT(const Key& key) const {
+            Node* node = _findGreaterOrEqual(key, NULL);
+            while (node && !_compare(key, node->_key)) {
+                node = node->_next[0].load();
+            }
+            return node;
+        }
+
+        /**
+         * The last node whose key is < 'key'.
+         */
+        Node* seekLT(const Key& key) const {
+            Node* node = _head;
+            int level = _height.load() - 1;
+            while (true) {
+                Node* next = node->_next[level].load();
+                if (next && _compare(next->_key, key)) {
+                    node = next;
+                }
+                else if (level == 0) {
+                    return node == _head ? NULL : node;
+                }
+                else {
+                    level--;
+                }
+            }
+        }
+
+        /**
+         * The last node whose key is <= 'key'.
+         */
+        Node* seekLE(const Key& key) const {
+            Node* node = seekGE(key);
+            if (node && !_compare(key, node->_key)) {
+                return node;
+            }
+            return seekLT(key);
+        }
+
+        //
+        // Writes.
+        //
+
+        /**
+         * Returns the node for 'key', linking in a new one with a default constructed Payload if
+         * there is none.
+         */
+        Node* getOrInsert(const Key& key) {
+            Node* node = find(key);
+            if (node) {
+                return node;
+            }
+
+            boost::mutex::scoped_lock lk(_writeMutex);
+
+            Node* prev[kMaxHeight];
+            node = _findGreaterOrEqual(key, prev);
+            if (node && !_compare(key, node->_key)) {
+                return node;
+            }
+
+            const int height = _randomHeight();
+            const int oldHeight = _height.load();
+            if (height > oldHeight) {
+                for (int i = oldHeight; i < height; i++) {
+                    prev[i] = _head;
+                }
+                // Readers seeing the new height before the node is linked in just find NULL
+                // at the top levels of _head and move down.
+                _height.store(height);
+            }
+
+            node = _newNode(key, height);
+            for (int i = 0; i < height; i++) {
+                // The node is not reachable yet, and becomes reachable at each level with the
+                // store to prev[i], after its own next pointer for that level is set.
+                node->_next[i].store(prev[i]->_next[i].load());
+                prev[i]->_next[i].store(node);
+            }
+            return node;
+        }
+
+        /**
+         * Unlinks the node for 'key' if it exists and 'predicate' returns true for it. The
+         * predicate runs with writers excluded, so nothing can be linked next to the node
+         * meanwhile. Returns the unlinked node, which the caller must eventually pass to
+         * destroyNode(), or NULL.
+         */
+        template <typename Predicate>
+        Node* remove(const Key& key, Predicate predicate) {
+            boost::mutex::scoped_lock lk(_writeMutex);
+
+            Node* prev[kMaxHeight];
+            Node* node = _findGreaterOrEqual(key, prev);
+            if (!node || _compare(key, node->_key) || !predicate(node)) {
+                return NULL;
+            }
+
+            for (int i = 0; i < node->_height; i++) {
+                invariant(prev[i]->_next[i].load() == node);
+                prev[i]->_next[i].store(node->_next[i].load());
+            }
+            return node;
+        }
+
+    private:
+        static Node* _newNode(const Key& key, int height) {
+            invariant(height >= 1 && height <= kMaxHeight);
+            void* memory = ::operator new(sizeof(Node) + (height - 1) * sizeof(AtomicWord<Node*>));
+            Node* node = new (memory) Node(key, height);
+            node->_next[0].store(NULL);
+            for (int i = 1; i < height; i++) {
+                new (&node->_next[i]) AtomicWord<Node*>(NULL);
+            }
+            return node;
+        }
+
+        /**
+         * Returns the first node >= 'key'. If 'prev' is not NULL, fills in the last node < 'key'
+         * at every level.
+         */
+        Node* _findGreaterOrEqual(const Key& key, Node** prev) const {
+            Node* node = _head;
+            int level = _height.load() - 1;
+            while (true) {
+                Node* next = node->_next[level].load();
+                if (next && _compare(next->_key, key)) {
+                    node = next;
+                    continue;
+                }
+
+                if (prev) {
+                    prev[level] = node;
+                }
+                if (level == 0) {
+                    return next;
+                }
+                level--;
+            }
+        }
+
+        // Called with _writeMutex held.
+        int _randomHeight() {
+            // Each level holds a quarter of the nodes of the one below.
+            int height = 1;
+            while (height < kMaxHeight && (_random.nextInt32() & 3) == 0) {
+                height++;
+            }
+            return height;
+        }
+
+        const Compare _compare;
+        Node* const _head; // sentinel holding no entry, at full height
+        AtomicWord<int> _height; // number of levels in use, at least 1
+
+        boost::mutex _writeMutex; // serializes linking and unlinking nodes
+        PseudoRandom _random; // protected by _writeMutex
+    };
+
+} // namespace mongo
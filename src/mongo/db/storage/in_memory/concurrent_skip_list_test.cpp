@@ -0,0 +1,160 @@
+// concurrent_skip_list_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/in_memory/concurrent_skip_list.h"
+
+#include <boost/thread/thread.hpp>
+#include <vector>
+
+#include "mongo/stdx/functional.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    typedef ConcurrentSkipList<int, int> IntList;
+
+    struct Always {
+        bool operator()(IntList::Node* node) const { return true; }
+    };
+
+    struct Never {
+        bool operator()(IntList::Node* node) const { return false; }
+    };
+
+    TEST(ConcurrentSkipList, Empty) {
+        IntList list;
+        ASSERT(!list.first());
+        ASSERT(!list.last());
+        ASSERT(!list.find(1));
+        ASSERT(!list.seekGE(1));
+        ASSERT(!list.seekLE(1));
+    }
+
+    TEST(ConcurrentSkipList, InsertKeepsOrder) {
+        IntList list;
+        for (int i = 0; i < 1000; i++) {
+            list.getOrInsert((i * 7919) % 1000)->payload() = i;
+        }
+
+        int expected = 0;
+        for (IntList::Node* node = list.first(); node; node = node->next()) {
+            ASSERT_EQUALS(expected, node->key());
+            expected++;
+        }
+        ASSERT_EQUALS(1000, expected);
+        ASSERT_EQUALS(999, list.last()->key());
+    }
+
+    TEST(ConcurrentSkipList, GetOrInsertFindsExisting) {
+        IntList list;
+        IntList::Node* node = list.getOrInsert(5);
+        node->payload() = 42;
+        ASSERT_EQUALS(node, list.getOrInsert(5));
+        ASSERT_EQUALS(42, list.find(5)->payload());
+    }
+
+    TEST(ConcurrentSkipList, Seeks) {
+        IntList list;
+        for (int i = 0; i < 10; i++) {
+            list.getOrInsert(i * 10);
+        }
+
+        ASSERT_EQUALS(20, list.seekGE(20)->key());
+        ASSERT_EQUALS(30, list.seekGE(21)->key());
+        ASSERT_EQUALS(30, list.seekGT(20)->key());
+        ASSERT_EQUALS(10, list.seekLT(20)->key());
+        ASSERT_EQUALS(20, list.seekLE(20)->key());
+        ASSERT_EQUALS(20, list.seekLE(29)->key());
+
+        ASSERT(!list.seekGT(90));
+        ASSERT(!list.seekLT(0));
+        ASSERT(!list.find(25));
+    }
+
+    TEST(ConcurrentSkipList, Remove) {
+        IntList list;
+        for (int i = 0; i < 10; i++) {
+            list.getOrInsert(i);
+        }
+
+        ASSERT(!list.remove(5, Never()));
+        ASSERT(list.find(5));
+
+        IntList::Node* removed = list.remove(5, Always());
+        ASSERT(removed);
+        ASSERT_EQUALS(5, removed->key());
+        ASSERT(!list.find(5));
+        ASSERT_EQUALS(6, list.seekGE(5)->key());
+        ASSERT_EQUALS(4, list.seekLT(6)->key());
+
+        // Readers still on the removed node can carry on past it.
+        ASSERT_EQUALS(6, removed->next()->key());
+        IntList::destroyNode(removed);
+
+        ASSERT(!list.remove(5, Always()));
+    }
+
+    void insertRange(IntList* list, int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            list->getOrInsert(i);
+        }
+    }
+
+    TEST(ConcurrentSkipList, ConcurrentInserts) {
+        const int kThreads = 4;
+        const int kPerThread = 10000;
+
+        IntList list;
+        std::vector<boost::thread*> threads;
+        for (int t = 0; t < kThreads; t++) {
+            // Overlapping ranges, so that threads race to insert the same keys.
+            threads.push_back(new boost::thread(stdx::bind(&insertRange,
+                                                           &list,
+                                                           t * kPerThread / 2,
+                                                           t * kPerThread / 2 + kPerThread)));
+        }
+        for (int t = 0; t < kThreads; t++) {
+            threads[t]->join();
+            delete threads[t];
+        }
+
+        int expected = 0;
+        for (IntList::Node* node = list.first(); node; node = node->next()) {
+            ASSERT_EQUALS(expected, node->key());
+            expected++;
+        }
+        ASSERT_EQUALS((kThreads + 1) * kPerThread / 2, expected);
+    }
+
+} // namespace
+} // namespace mongo
@@ -34,16 +34,20 @@
 
 #include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
-#include <set>
+#include <map>
+#include <string>
 
 #include "mongo/db/catalog/index_catalog_entry.h"
 #include "mongo/db/storage/index_entry_comparison.h"
 #include "mongo/db/storage/in_memory/in_memory_recovery_unit.h"
+#include "mongo/db/storage/key_string.h"
+#include "mongo/util/bufreader.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
     using boost::shared_ptr;
+    using std::string;
 
 namespace {
 
@@ -68,7 +72,42 @@ namespace {
         return bb.obj();
     }
 
-    typedef std::set<IndexKeyEntry, IndexEntryComparison> IndexSet;
+    /**
+     * Maps the KeyString encoding of each (key, RecordId) entry to the encoding of the key's
+     * TypeBits, which is empty if they are all zeros.  KeyStrings compare with memcmp, so the
+     * map is ordered without ever decoding a key.
+     */
+    typedef std::map<string, string> IndexSet;
+
+    string toEntry(const KeyString& ks) {
+        return string(ks.getBuffer(), ks.getSize());
+    }
+
+    string toTypeBits(const KeyString& ks) {
+        const KeyString::TypeBits& typeBits = ks.getTypeBits();
+        if (typeBits.isAllZeros())
+            return string();
+        return string(reinterpret_cast<const char*>(typeBits.getBuffer()), typeBits.getSize());
+    }
+
+    BSONObj decodeKey(const IndexSet::value_type& entry, const Ordering& ordering) {
+        BufReader br(entry.second.data(), entry.second.size());
+        return KeyString::toBson(entry.first.data(),
+                                 entry.first.size(),
+                                 ordering,
+                                 KeyString::TypeBits::fromBuffer(&br));
+    }
+
+    RecordId decodeRecordId(const IndexSet::value_type& entry) {
+        return KeyString::decodeRecordIdAtEnd(entry.first.data(), entry.first.size());
+    }
+
+    /**
+     * True if 'entry' starts with 'prefix', which is a KeyString without a RecordId.
+     */
+    bool hasKeyPrefix(const string& entry, const string& prefix) {
+        return entry.size() > prefix.size() && entry.compare(0, prefix.size(), prefix) == 0;
+    }
 
     // taken from btree_logic.cpp
     Status dupKeyError(const BSONObj& key) {
@@ -79,22 +118,28 @@ namespace {
         return Status(ErrorCodes::DuplicateKey, sb.str());
     }
 
-    bool isDup(const IndexSet& data, const BSONObj& key, RecordId loc) {
-        const IndexSet::const_iterator it = data.find(IndexKeyEntry(key, RecordId()));
-        if (it == data.end())
-            return false;
-
-        // Not a dup if the entry is for the same loc.
-        return it->loc != loc;
+    bool isDup(const IndexSet& data, const Ordering& ordering, const BSONObj& key, RecordId loc) {
+        const string prefix = toEntry(KeyString::make(key, ordering));
+        for (IndexSet::const_iterator it = data.lower_bound(prefix);
+             it != data.end() && hasKeyPrefix(it->first, prefix);
+             ++it) {
+            // Not a dup if the entry is for the same loc.
+            if (decodeRecordId(*it) != loc)
+                return true;
+        }
+        return false;
     }
 
     class InMemoryBtreeBuilderImpl : public SortedDataBuilderInterface {
     public:
-        InMemoryBtreeBuilderImpl(IndexSet* data, long long* currentKeySize, bool dupsAllowed)
+        InMemoryBtreeBuilderImpl(IndexSet* data,
+                                 const Ordering& ordering,
+                                 long long* currentKeySize,
+                                 bool dupsAllowed)
                 : _data(data),
+                  _ordering(ordering),
                   _currentKeySize( currentKeySize ),
-                  _dupsAllowed(dupsAllowed),
-                  _comparator(_data->key_comp()) {
+                  _dupsAllowed(dupsAllowed) {
             invariant(_data->empty());
         }
 
@@ -108,44 +153,54 @@ namespace {
             invariant(loc.isNormal());
             invariant(!hasFieldNames(key));
 
+            const KeyString keyOnly = KeyString::make(key, _ordering);
+            const string prefix = toEntry(keyOnly);
+
             if (!_data->empty()) {
                 // Compare specified key with last inserted key, ignoring its RecordId
-                int cmp = _comparator.compare(IndexKeyEntry(key, RecordId()), *_last);
-                if (cmp < 0 || (_dupsAllowed && cmp == 0 && loc < _last->loc)) {
+                int cmp = prefix.compare(_lastPrefix);
+                if (cmp < 0 || (_dupsAllowed && cmp == 0 && loc < _lastLoc)) {
                     return Status(ErrorCodes::InternalError,
                                   "expected ascending (key, RecordId) order in bulk builder");
                 }
-                else if (!_dupsAllowed && cmp == 0 && loc != _last->loc) {
+                else if (!_dupsAllowed && cmp == 0 && loc != _lastLoc) {
                     return dupKeyError(key);
                 }
             }
 
-            BSONObj owned = key.getOwned();
-            _last = _data->insert(_data->end(), IndexKeyEntry(owned, loc));
-            *_currentKeySize += key.objsize();
+            const KeyString ks = KeyString::make(key, _ordering, loc);
+            _data->insert(_data->end(), IndexSet::value_type(toEntry(ks), toTypeBits(ks)));
+            *_currentKeySize += ks.getSize();
+
+            _lastPrefix = prefix;
+            _lastLoc = loc;
 
             return Status::OK();
         }
 
     private:
         IndexSet* const _data;
+        const Ordering _ordering;
         long long* _currentKeySize;
         const bool _dupsAllowed;
 
-        IndexEntryComparison _comparator;  // used by the bulk builder to detect duplicate keys
-        IndexSet::const_iterator _last;    // or (key, RecordId) ordering violations
+        // Used by the bulk builder to detect duplicate keys or (key, RecordId) ordering
+        // violations.
+        string _lastPrefix;
+        RecordId _lastLoc;
     };
 
     class InMemoryBtreeImpl : public SortedDataInterface {
     public:
-        InMemoryBtreeImpl(IndexSet* data)
-            : _data(data) {
+        InMemoryBtreeImpl(IndexSet* data, const Ordering& ordering)
+            : _data(data),
+              _ordering(ordering) {
             _currentKeySize = 0;
         }
 
         virtual SortedDataBuilderInterface* getBulkBuilder(OperationContext* txn,
                                                            bool dupsAllowed) {
-            return new InMemoryBtreeBuilderImpl(_data, &_currentKeySize, dupsAllowed);
+            return new InMemoryBtreeBuilderImpl(_data, _ordering, &_currentKeySize, dupsAllowed);
         }
 
         virtual Status insert(OperationContext* txn,
@@ -164,12 +219,13 @@ namespace {
             }
 
             // TODO optimization: save the iterator from the dup-check to speed up insert
-            if (!dupsAllowed && isDup(*_data, key, loc))
+            if (!dupsAllowed && isDup(*_data, _ordering, key, loc))
                 return dupKeyError(key);
 
-            IndexKeyEntry entry(key.getOwned(), loc);
+            const KeyString ks = KeyString::make(key, _ordering, loc);
+            const IndexSet::value_type entry(toEntry(ks), toTypeBits(ks));
             if ( _data->insert(entry).second ) {
-                _currentKeySize += key.objsize();
+                _currentKeySize += ks.getSize();
                 txn->recoveryUnit()->registerChange(new IndexChange(_data, entry, true));
             }
             return Status::OK();
@@ -182,11 +238,12 @@ namespace {
             invariant(loc.isNormal());
             invariant(!hasFieldNames(key));
 
-            IndexKeyEntry entry(key.getOwned(), loc);
-            const size_t numDeleted = _data->erase(entry);
-            invariant(numDeleted <= 1);
-            if ( numDeleted == 1 ) {
-                _currentKeySize -= key.objsize();
+            const KeyString ks = KeyString::make(key, _ordering, loc);
+            IndexSet::iterator it = _data->find(toEntry(ks));
+            if ( it != _data->end() ) {
+                const IndexSet::value_type entry = *it;
+                _data->erase(it);
+                _currentKeySize -= ks.getSize();
                 txn->recoveryUnit()->registerChange(new IndexChange(_data, entry, false));
             }
         }
@@ -203,12 +260,12 @@ namespace {
         }
 
         virtual long long getSpaceUsedBytes( OperationContext* txn ) const {
-            return _currentKeySize + ( sizeof(IndexKeyEntry) * _data->size() );
+            return _currentKeySize + ( sizeof(IndexSet::value_type) * _data->size() );
         }
 
         virtual Status dupKeyCheck(OperationContext* txn, const BSONObj& key, const RecordId& loc) {
             invariant(!hasFieldNames(key));
-            if (isDup(*_data, key, loc))
+            if (isDup(*_data, _ordering, key, loc))
                 return dupKeyError(key);
             return Status::OK();
         }
@@ -224,10 +281,12 @@ namespace {
 
         class ForwardCursor : public SortedDataInterface::Cursor {
         public:
-            ForwardCursor(const IndexSet& data, OperationContext* txn)
+            ForwardCursor(const IndexSet& data, const Ordering& ordering, OperationContext* txn)
                 : _txn(txn),
                   _data(data),
-                  _it(data.end())
+                  _ordering(ordering),
+                  _it(data.end()),
+                  _keyFor(data.end())
             {}
 
             virtual int getDirection() const { return 1; }
@@ -244,16 +303,7 @@ namespace {
 
             virtual bool locate(const BSONObj& keyRaw, const RecordId& loc) {
                 const BSONObj key = stripFieldNames(keyRaw);
-                _it = _data.lower_bound(IndexKeyEntry(key, loc)); // lower_bound is >= key
-                if ( _it == _data.end() ) {
-                    return false;
-                }
-
-                if ( _it->key != key ) {
-                    return false;
-                }
-
-                return _it->loc == loc;
+                return _seek(toEntry(KeyString::make(key, _ordering, loc)));
             }
 
             virtual void customLocate(const BSONObj& keyBegin,
@@ -261,15 +311,15 @@ namespace {
                                       bool afterKey,
                                       const vector<const BSONElement*>& keyEnd,
                                       const vector<bool>& keyEndInclusive) {
-                // makeQueryObject handles stripping of fieldnames for us.
-                _it = _data.lower_bound(IndexKeyEntry(IndexEntryComparison::makeQueryObject(
-                                                        keyBegin,
-                                                        keyBeginLen,
-                                                        afterKey,
-                                                        keyEnd,
-                                                        keyEndInclusive,
-                                                        1), // forward
-                                                   RecordId()));
+                // makeQueryObject handles stripping of fieldnames for us.  Without a RecordId
+                // the KeyString sorts before every entry for an equal key.
+                const BSONObj query = IndexEntryComparison::makeQueryObject(keyBegin,
+                                                                            keyBeginLen,
+                                                                            afterKey,
+                                                                            keyEnd,
+                                                                            keyEndInclusive,
+                                                                            1); // forward
+                _seek(toEntry(KeyString::make(query, _ordering)));
             }
 
             void advanceTo(const BSONObj &keyBegin,
@@ -282,11 +332,15 @@ namespace {
             }
 
             virtual BSONObj getKey() const {
-                return _it->key;
+                if (_keyFor != _it) {
+                    _key = decodeKey(*_it, _ordering);
+                    _keyFor = _it;
+                }
+                return _key;
             }
 
             virtual RecordId getRecordId() const {
-                return _it->loc;
+                return decodeRecordId(*_it);
             }
 
             virtual void advance() {
@@ -301,39 +355,54 @@ namespace {
                 }
 
                 _savedAtEnd = false;
-                _savedKey = _it->key.getOwned();
-                _savedLoc = _it->loc;
+                _savedEntry = _it->first;
             }
 
             virtual void restorePosition(OperationContext* txn) {
+                // The decoded key may belong to an entry which is gone.
+                _keyFor = _data.end();
+
                 if (_savedAtEnd) {
                     _it = _data.end();
                 }
                 else {
-                    locate(_savedKey, _savedLoc);
+                    _seek(_savedEntry);
                 }
             }
 
         private:
+            /**
+             * Positions at the first entry >= 'target'.  Returns true if it is equal.
+             */
+            bool _seek(const string& target) {
+                _it = _data.lower_bound(target); // lower_bound is >= key
+                return _it != _data.end() && _it->first == target;
+            }
 
             OperationContext* _txn; // not owned
             const IndexSet& _data;
+            const Ordering _ordering;
             IndexSet::const_iterator _it;
 
+            // Cache of the decoded key at _keyFor.
+            mutable IndexSet::const_iterator _keyFor;
+            mutable BSONObj _key;
+
             // For save/restorePosition since _it may be invalidated durring a yield.
             bool _savedAtEnd;
-            BSONObj _savedKey;
-            RecordId _savedLoc;
+            string _savedEntry;
 
         };
 
         // TODO see if this can share any code with ForwardIterator
         class ReverseCursor : public SortedDataInterface::Cursor {
         public:
-            ReverseCursor(const IndexSet& data, OperationContext* txn)
+            ReverseCursor(const IndexSet& data, const Ordering& ordering, OperationContext* txn)
                 : _txn(txn),
                   _data(data),
-                  _it(data.rend())
+                  _ordering(ordering),
+                  _it(data.rend()),
+                  _keyFor(data.rend())
             {}
 
             virtual int getDirection() const { return -1; }
@@ -350,18 +419,12 @@ namespace {
 
             virtual bool locate(const BSONObj& keyRaw, const RecordId& loc) {
                 const BSONObj key = stripFieldNames(keyRaw);
-                _it = lower_bound(IndexKeyEntry(key, loc)); // lower_bound is <= query
 
-                if ( _it == _data.rend() ) {
-                    return false;
-                }
-
-
-                if ( _it->key != key ) {
-                    return false;
-                }
-
-                return _it->loc == loc;
+                // A null RecordId means any entry for the key, the last of which is the first
+                // one seen when moving backwards.
+                return _seek(toEntry(KeyString::make(key,
+                                                     _ordering,
+                                                     loc.isNull() ? RecordId::max() : loc)));
             }
 
             virtual void customLocate(const BSONObj& keyBegin,
@@ -369,15 +432,15 @@ namespace {
                                       bool afterKey,
                                       const vector<const BSONElement*>& keyEnd,
                                       const vector<bool>& keyEndInclusive) {
-                // makeQueryObject handles stripping of fieldnames for us.
-                _it = lower_bound(IndexKeyEntry(IndexEntryComparison::makeQueryObject(
-                                                  keyBegin,
-                                                  keyBeginLen,
-                                                  afterKey,
-                                                  keyEnd,
-                                                  keyEndInclusive,
-                                                  -1), // reverse
-                                             RecordId()));
+                // makeQueryObject handles stripping of fieldnames for us.  RecordId::max() sorts
+                // after every entry for an equal key.
+                const BSONObj query = IndexEntryComparison::makeQueryObject(keyBegin,
+                                                                            keyBeginLen,
+                                                                            afterKey,
+                                                                            keyEnd,
+                                                                            keyEndInclusive,
+                                                                            -1); // reverse
+                _seek(toEntry(KeyString::make(query, _ordering, RecordId::max())));
             }
 
             void advanceTo(const BSONObj &keyBegin,
@@ -390,11 +453,15 @@ namespace {
             }
 
             virtual BSONObj getKey() const {
-                return _it->key;
+                if (_keyFor != _it) {
+                    _key = decodeKey(*_it, _ordering);
+                    _keyFor = _it;
+                }
+                return _key;
             }
 
             virtual RecordId getRecordId() const {
-                return _it->loc;
+                return decodeRecordId(*_it);
             }
 
             virtual void advance() {
@@ -409,51 +476,57 @@ namespace {
                 }
 
                 _savedAtEnd = false;
-                _savedKey = _it->key.getOwned();
-                _savedLoc = _it->loc;
+                _savedEntry = _it->first;
             }
 
             virtual void restorePosition(OperationContext* txn) {
+                // The decoded key may belong to an entry which is gone.
+                _keyFor = _data.rend();
+
                 if (_savedAtEnd) {
                     _it = _data.rend();
                 }
                 else {
-                    locate(_savedKey, _savedLoc);
+                    _seek(_savedEntry);
                 }
             }
 
         private:
             /**
-             * Returns the first entry <= query. This is equivalent to ForwardCursors use of
-             * _data.lower_bound which returns the first entry >= query.
+             * Positions at the last entry <= 'target'.  Returns true if it is equal.  This is
+             * equivalent to ForwardCursor's use of _data.lower_bound which finds the first entry
+             * >= target.
              */
-            IndexSet::const_reverse_iterator lower_bound(const IndexKeyEntry& query) const {
+            bool _seek(const string& target) {
                 // using upper_bound since we want to the right-most entry matching the query.
-                IndexSet::const_iterator it = _data.upper_bound(query);
-
                 // upper_bound returns the entry to the right of the one we want. Helpfully,
                 // converting to a reverse_iterator moves one to the left. This also correctly
                 // handles the case where upper_bound returns end() by converting to rbegin(),
                 // meaning that all data is to the right of the query.
-                return IndexSet::const_reverse_iterator(it);
+                _it = IndexSet::const_reverse_iterator(_data.upper_bound(target));
+                return _it != _data.rend() && _it->first == target;
             }
 
             OperationContext* _txn; // not owned
             const IndexSet& _data;
+            const Ordering _ordering;
             IndexSet::const_reverse_iterator _it;
 
+            // Cache of the decoded key at _keyFor.
+            mutable IndexSet::const_reverse_iterator _keyFor;
+            mutable BSONObj _key;
+
             // For save/restorePosition since _it may be invalidated durring a yield.
             bool _savedAtEnd;
-            BSONObj _savedKey;
-            RecordId _savedLoc;
+            string _savedEntry;
         };
 
         virtual SortedDataInterface::Cursor* newCursor(OperationContext* txn, int direction) const {
             if (direction == 1)
-                return new ForwardCursor(*_data, txn);
+                return new ForwardCursor(*_data, _ordering, txn);
 
             invariant(direction == -1);
-            return new ReverseCursor(*_data, txn);
+            return new ReverseCursor(*_data, _ordering, txn);
         }
 
         virtual Status initAsEmpty(OperationContext* txn) {
@@ -464,25 +537,26 @@ namespace {
     private:
         class IndexChange : public RecoveryUnit::Change {
         public:
-            IndexChange(IndexSet* data, const IndexKeyEntry& entry, bool insert)
+            IndexChange(IndexSet* data, const IndexSet::value_type& entry, bool insert)
                 : _data(data), _entry(entry), _insert(insert)
             {}
 
             virtual void commit() {}
             virtual void rollback() {
                 if (_insert)
-                    _data->erase(_entry);
+                    _data->erase(_entry.first);
                 else
                     _data->insert(_entry);
             }
 
         private:
             IndexSet* _data;
-            const IndexKeyEntry _entry;
+            const IndexSet::value_type _entry;
             const bool _insert;
         };
 
         IndexSet* _data;
+        const Ordering _ordering;
         long long _currentKeySize;
     };
 } // namespace
@@ -493,9 +567,9 @@ namespace {
                                               boost::shared_ptr<void>* dataInOut) {
         invariant(dataInOut);
         if (!*dataInOut) {
-            *dataInOut = boost::make_shared<IndexSet>(IndexEntryComparison(ordering));
+            *dataInOut = boost::make_shared<IndexSet>();
         }
-        return new InMemoryBtreeImpl(static_cast<IndexSet*>(dataInOut->get()));
+        return new InMemoryBtreeImpl(static_cast<IndexSet*>(dataInOut->get()), ordering);
     }
 
 }  // namespace mongo
@@ -32,6 +32,7 @@
 #include "mongo/base/init.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/storage/in_memory/in_memory_engine.h"
+#include "mongo/db/storage/in_memory/in_memory_mvcc_engine.h"
 #include "mongo/db/storage/kv/kv_storage_engine.h"
 #include "mongo/db/storage_options.h"
 
@@ -73,6 +74,22 @@ namespace mongo {
             }
         };
 
+        class InMemoryMvccFactory : public InMemoryFactory {
+        public:
+            virtual ~InMemoryMvccFactory() { }
+            virtual StorageEngine* create(const StorageGlobalParams& params,
+                                          const StorageEngineLockFile& lockFile) const {
+                KVStorageEngineOptions options;
+                options.directoryPerDB = params.directoryperdb;
+                options.forRepair = params.repair;
+                return new KVStorageEngine(new InMemoryMvccEngine(), options);
+            }
+
+            virtual StringData getCanonicalName() const {
+                return "inMemoryMvccExperiment";
+            }
+        };
+
     } // namespace
 
     MONGO_INITIALIZER_WITH_PREREQUISITES(InMemoryEngineInit,
@@ -80,6 +97,8 @@ namespace mongo {
                                          (InitializerContext* context) {
 
         getGlobalEnvironment()->registerStorageEngine("inMemoryExperiment", new InMemoryFactory());
+        getGlobalEnvironment()->registerStorageEngine("inMemoryMvccExperiment",
+                                                      new InMemoryMvccFactory());
         return Status::OK();
     }
 
@@ -0,0 +1,251 @@
+// in_memory_mvcc.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/in_memory/in_memory_mvcc.h"
+
+#include <limits>
+
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/storage/in_memory/in_memory_mvcc_recovery_unit.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+
+    // The newest "version" of an entry unlinked from its list. Anyone finding it treats the
+    // entry as not existing.
+    MvccVersion removedMarker(0, true, SharedBuffer(), 0);
+
+} // namespace
+
+    void MvccVersion::destroyChain(MvccVersion* version) {
+        while (version) {
+            MvccVersion* older = version->older.load();
+            delete version;
+            version = older;
+        }
+    }
+
+    MvccEntry::~MvccEntry() {
+        MvccVersion* newest = _newest.load();
+        MvccVersion::destroyChain(newest == &removedMarker ? _chainAtRemoval : newest);
+    }
+
+    const MvccVersion* MvccEntry::visibleVersion(InMemoryMvccRecoveryUnit* ru) const {
+        for (MvccVersion* version = _newest.load(); version; version = version->older.load()) {
+            if (version == &removedMarker) {
+                return NULL;
+            }
+            if (ru->sees(version)) {
+                return version->tombstone ? NULL : version;
+            }
+        }
+        return NULL;
+    }
+
+    bool MvccEntry::write(InMemoryMvccRecoveryUnit* ru, MvccVersion* version) {
+        invariant(ru->inUnitOfWork());
+        invariant(version->writerId == ru->id());
+
+        const uint64_t snapshot = ru->snapshot();
+        while (true) {
+            MvccVersion* newest = _newest.load();
+            if (newest == &removedMarker) {
+                delete version;
+                return false;
+            }
+
+            if (newest) {
+                const uint64_t seq = newest->commitSeq.load();
+                if (seq == 0 ? newest->writerId != ru->id() : seq > snapshot) {
+                    delete version;
+                    throw WriteConflictException();
+                }
+            }
+
+            version->older.store(newest);
+            if (_newest.compareAndSwap(newest, version) == newest) {
+                break;
+            }
+        }
+
+        ru->_writes.push_back(std::make_pair(this, version));
+
+        // Nobody else can change the chain while our uncommitted version is on top of it.
+        _prune(version, ru->manager()->oldestActiveSnapshot());
+        return true;
+    }
+
+    void MvccEntry::writeCommitted(InMemoryMvccRecoveryUnit* ru, MvccVersion* version) {
+        while (true) {
+            MvccVersion* newest = _newest.load();
+            invariant(newest != &removedMarker);
+            invariant(!newest || newest->commitSeq.load() != 0);
+
+            version->older.store(newest);
+            if (_newest.compareAndSwap(newest, version) == newest) {
+                break;
+            }
+        }
+
+        ru->manager()->commitAlone(version);
+    }
+
+    bool MvccEntry::markRemoved(uint64_t oldestSnapshot) {
+        MvccVersion* newest = _newest.load();
+        if (newest == &removedMarker) {
+            return false;
+        }
+
+        if (newest) {
+            const uint64_t seq = newest->commitSeq.load();
+            if (!newest->tombstone || seq == 0 || seq > oldestSnapshot) {
+                return false;
+            }
+        }
+
+        if (_newest.compareAndSwap(newest, &removedMarker) != newest) {
+            return false; // written again meanwhile
+        }
+
+        _chainAtRemoval = newest;
+        return true;
+    }
+
+    void MvccEntry::_prune(MvccVersion* from, uint64_t oldestSnapshot) {
+        // Every reader stops at the first version committed at or before its snapshot, and no
+        // snapshot is older than oldestSnapshot, so nothing below such a version is read.
+        for (MvccVersion* version = from; version; version = version->older.load()) {
+            const uint64_t seq = version->commitSeq.load();
+            if (seq != 0 && seq <= oldestSnapshot) {
+                MvccVersion::destroyChain(version->older.swap(NULL));
+                return;
+            }
+        }
+    }
+
+    //
+    // MvccManager
+    //
+
+    MvccManager::MvccManager()
+        : _nextTransactionId(1),
+          _oldestActiveSnapshot(0),
+          _lastCommitted(0),
+          _epoch(0) {
+    }
+
+    MvccManager::~MvccManager() {
+        invariant(_activeEpochs.empty());
+        for (size_t i = 0; i < _retired.size(); i++) {
+            _retired[i].deleter(_retired[i].object);
+        }
+    }
+
+    void MvccManager::registerUnit(uint64_t* snapshot, uint64_t* epoch) {
+        boost::mutex::scoped_lock lk(_mutex);
+        *snapshot = _lastCommitted;
+        *epoch = _epoch;
+        _activeSnapshots.insert(*snapshot);
+        _activeEpochs.insert(*epoch);
+        _updateOldestActiveSnapshot_inlock();
+    }
+
+    void MvccManager::unregisterUnit(uint64_t snapshot, uint64_t epoch) {
+        std::vector<Retired> freeable;
+        {
+            boost::mutex::scoped_lock lk(_mutex);
+            _activeSnapshots.erase(_activeSnapshots.find(snapshot));
+            _activeEpochs.erase(_activeEpochs.find(epoch));
+            _updateOldestActiveSnapshot_inlock();
+
+            const uint64_t oldestEpoch = _activeEpochs.empty()
+                ? std::numeric_limits<uint64_t>::max()
+                : *_activeEpochs.begin();
+            while (!_retired.empty() && _retired.front().epoch < oldestEpoch) {
+                freeable.push_back(_retired.front());
+                _retired.pop_front();
+            }
+        }
+
+        for (size_t i = 0; i < freeable.size(); i++) {
+            freeable[i].deleter(freeable[i].object);
+        }
+    }
+
+    void MvccManager::refreshSnapshot(uint64_t* snapshot) {
+        boost::mutex::scoped_lock lk(_mutex);
+        _activeSnapshots.erase(_activeSnapshots.find(*snapshot));
+        *snapshot = _lastCommitted;
+        _activeSnapshots.insert(*snapshot);
+        _updateOldestActiveSnapshot_inlock();
+    }
+
+    void MvccManager::commit(const std::vector<MvccVersion*>& versions, uint64_t* snapshot) {
+        boost::mutex::scoped_lock lk(_mutex);
+
+        // Snapshots are only taken under _mutex, so no reader can see some of these versions
+        // committed and others not.
+        const uint64_t seq = ++_lastCommitted;
+        for (size_t i = 0; i < versions.size(); i++) {
+            versions[i]->commitSeq.store(seq);
+        }
+
+        _activeSnapshots.erase(_activeSnapshots.find(*snapshot));
+        *snapshot = seq;
+        _activeSnapshots.insert(*snapshot);
+        _updateOldestActiveSnapshot_inlock();
+    }
+
+    void MvccManager::commitAlone(MvccVersion* version) {
+        boost::mutex::scoped_lock lk(_mutex);
+        version->commitSeq.store(++_lastCommitted);
+        _updateOldestActiveSnapshot_inlock();
+    }
+
+    void MvccManager::retire(void* object, Deleter deleter) {
+        boost::mutex::scoped_lock lk(_mutex);
+        // Units registered from now on get a later epoch, and cannot find 'object'.
+        _retired.push_back(Retired(object, deleter, _epoch++));
+    }
+
+    void MvccManager::destroyVersion(void* version) {
+        delete static_cast<MvccVersion*>(version);
+    }
+
+    void MvccManager::_updateOldestActiveSnapshot_inlock() {
+        _oldestActiveSnapshot.store(_activeSnapshots.empty() ? _lastCommitted
+                                                             : *_activeSnapshots.begin());
+    }
+
+} // namespace mongo
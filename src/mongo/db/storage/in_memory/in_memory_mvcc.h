@@ -0,0 +1,248 @@
+// in_memory_mvcc.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <deque>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/shared_buffer.h"
+
+namespace mongo {
+
+    class InMemoryMvccRecoveryUnit;
+
+    /**
+     * One version of an entry in an inMemoryMvccExperiment record store or index. Versions are
+     * immutable once written except for commitSeq, which is set when the writer commits.
+     */
+    struct MvccVersion : boost::noncopyable {
+        MvccVersion(uint64_t writerId, bool tombstone, const SharedBuffer& data, int size)
+            : writerId(writerId), tombstone(tombstone), data(data), size(size) {}
+
+        /**
+         * Deletes 'version' and every older version.
+         */
+        static void destroyChain(MvccVersion* version);
+
+        const uint64_t writerId; // the InMemoryMvccRecoveryUnit::id() that wrote this
+        const bool tombstone; // true if this version deletes the entry
+        const SharedBuffer data;
+        const int size;
+
+        AtomicUInt64 commitSeq; // 0 until the writer commits
+        AtomicWord<MvccVersion*> older;
+    };
+
+    /**
+     * The payload of a skip list node: the versions of one entry, newest first. Uncommitted
+     * versions can only ever be at the top of the chain, as writing over another transaction's
+     * uncommitted version is a write conflict.
+     */
+    class MvccEntry : boost::noncopyable {
+    public:
+        MvccEntry() : _chainAtRemoval(NULL) {}
+        ~MvccEntry();
+
+        /**
+         * Returns the version 'ru' reads, or NULL if the entry does not exist for it.
+         */
+        const MvccVersion* visibleVersion(InMemoryMvccRecoveryUnit* ru) const;
+
+        /**
+         * Makes 'version', which must have been created for 'ru', the newest version of this
+         * entry until 'ru' commits or rolls back. Always takes ownership of 'version'.
+         *
+         * Throws WriteConflictException if another transaction has an uncommitted version of
+         * the entry, or committed one after the snapshot 'ru' reads. Returns false if the entry
+         * has been removed from its list, in which case the caller should look it up again.
+         */
+        bool write(InMemoryMvccRecoveryUnit* ru, MvccVersion* version);
+
+        /**
+         * Makes 'version' the newest version and commits it on its own, outside of any unit of
+         * work. Only for building an index nobody else can write to yet.
+         */
+        void writeCommitted(InMemoryMvccRecoveryUnit* ru, MvccVersion* version);
+
+        /**
+         * Marks the entry removed if its newest version is a tombstone committed at or before
+         * 'oldestSnapshot', so that no reader can see any of it, or if it has no versions left
+         * after its only writer rolled back. Returns true if the entry was marked; it must then
+         * be unlinked from its list.
+         */
+        bool markRemoved(uint64_t oldestSnapshot);
+
+    private:
+        friend class InMemoryMvccRecoveryUnit;
+
+        void _prune(MvccVersion* from, uint64_t oldestSnapshot);
+
+        AtomicWord<MvccVersion*> _newest;
+        MvccVersion* _chainAtRemoval; // the versions to delete with the entry once removed
+    };
+
+    /**
+     * Hands out commit sequence numbers and snapshots to the recovery units of one
+     * inMemoryMvccExperiment engine, and frees memory that readers may still be looking at once
+     * they are done.
+     *
+     * Every recovery unit registers with an epoch when it starts reading. Anything unlinked
+     * from a structure readers walk without locks is retired with the current epoch, and freed
+     * only after every unit registered at or before that epoch has unregistered.
+     */
+    class MvccManager : boost::noncopyable {
+    public:
+        typedef void (*Deleter)(void*);
+
+        MvccManager();
+        ~MvccManager();
+
+        uint64_t newTransactionId() { return _nextTransactionId.fetchAndAdd(1); }
+
+        /**
+         * The oldest snapshot any registered recovery unit reads from. Versions committed at or
+         * before it are visible to every reader.
+         */
+        uint64_t oldestActiveSnapshot() const { return _oldestActiveSnapshot.load(); }
+
+        void registerUnit(uint64_t* snapshot, uint64_t* epoch);
+        void unregisterUnit(uint64_t snapshot, uint64_t epoch);
+
+        /**
+         * Moves a registered unit's snapshot up to the newest commit.
+         */
+        void refreshSnapshot(uint64_t* snapshot);
+
+        /**
+         * Commits 'versions' atomically under a new sequence number, and moves the committing
+         * unit's 'snapshot' up to it.
+         */
+        void commit(const std::vector<MvccVersion*>& versions, uint64_t* snapshot);
+
+        /**
+         * Commits a single version, for writes made outside of a unit of work.
+         */
+        void commitAlone(MvccVersion* version);
+
+        /**
+         * Frees 'object' with 'deleter' once no recovery unit registered now can be using it.
+         */
+        void retire(void* object, Deleter deleter);
+
+        static void destroyVersion(void* version);
+
+    private:
+        struct Retired {
+            Retired(void* object, Deleter deleter, uint64_t epoch)
+                : object(object), deleter(deleter), epoch(epoch) {}
+
+            void* object;
+            Deleter deleter;
+            uint64_t epoch;
+        };
+
+        void _updateOldestActiveSnapshot_inlock();
+
+        AtomicUInt64 _nextTransactionId;
+        AtomicUInt64 _oldestActiveSnapshot;
+
+        boost::mutex _mutex; // protects everything below
+        uint64_t _lastCommitted;
+        uint64_t _epoch;
+        std::multiset<uint64_t> _activeSnapshots;
+        std::multiset<uint64_t> _activeEpochs;
+        std::deque<Retired> _retired; // in epoch order
+    };
+
+    /**
+     * Keys of entries deleted from a List (a ConcurrentSkipList of MvccEntry), waiting until
+     * every reader sees the delete so that their nodes can be unlinked.
+     */
+    template <typename List>
+    class MvccPurgeQueue : boost::noncopyable {
+    public:
+        typedef typename List::KeyType Key;
+        typedef typename List::Node Node;
+
+        void add(const Key& key, uint64_t commitSeq) {
+            boost::mutex::scoped_lock lk(_mutex);
+            _queue.push_back(std::make_pair(commitSeq, key));
+        }
+
+        /**
+         * Unlinks the nodes of the queued deletes that every reader now sees.
+         */
+        void purge(MvccManager* manager, List* list) {
+            const uint64_t oldestSnapshot = manager->oldestActiveSnapshot();
+
+            std::vector<Key> ready;
+            {
+                boost::mutex::scoped_lock lk(_mutex);
+                while (!_queue.empty() && _queue.front().first <= oldestSnapshot) {
+                    ready.push_back(_queue.front().second);
+                    _queue.pop_front();
+                }
+            }
+
+            for (size_t i = 0; i < ready.size(); i++) {
+                // The entry may have been written again since, in which case it stays.
+                Node* node = list->remove(ready[i], MarkRemoved(oldestSnapshot));
+                if (node) {
+                    manager->retire(node, &MvccPurgeQueue::_destroyNode);
+                }
+            }
+        }
+
+    private:
+        struct MarkRemoved {
+            explicit MarkRemoved(uint64_t oldestSnapshot) : oldestSnapshot(oldestSnapshot) {}
+
+            bool operator()(Node* node) const {
+                return node->payload().markRemoved(oldestSnapshot);
+            }
+
+            const uint64_t oldestSnapshot;
+        };
+
+        static void _destroyNode(void* node) {
+            List::destroyNode(static_cast<Node*>(node));
+        }
+
+        boost::mutex _mutex;
+        std::deque<std::pair<uint64_t, Key> > _queue; // (commit seq of the delete, key)
+    };
+
+} // namespace mongo
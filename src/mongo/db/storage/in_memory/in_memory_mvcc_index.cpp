@@ -0,0 +1,680 @@
+// in_memory_mvcc_index.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/in_memory/in_memory_mvcc_index.h"
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#include <cstring>
+#include <string>
+
+#include "mongo/db/operation_context.h"
+#include "mongo/db/storage/index_entry_comparison.h"
+#include "mongo/db/storage/in_memory/concurrent_skip_list.h"
+#include "mongo/db/storage/in_memory/in_memory_mvcc.h"
+#include "mongo/db/storage/in_memory/in_memory_mvcc_recovery_unit.h"
+#include "mongo/db/storage/key_string.h"
+#include "mongo/util/bufreader.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    using boost::shared_ptr;
+    using std::string;
+
+namespace {
+
+    const int TempKeyMaxSize = 1024; // this goes away with SERVER-3372
+
+    bool hasFieldNames(const BSONObj& obj) {
+        BSONForEach(e, obj) {
+            if (e.fieldName()[0])
+                return true;
+        }
+        return false;
+    }
+
+    BSONObj stripFieldNames(const BSONObj& query) {
+        if (!hasFieldNames(query))
+            return query;
+
+        BSONObjBuilder bb;
+        BSONForEach(e, query) {
+            bb.appendAs(e, StringData());
+        }
+        return bb.obj();
+    }
+
+    /**
+     * Maps the KeyString encoding of each (key, RecordId) entry to versions holding the key's
+     * TypeBits, which are empty if they are all zeros. A unique index also has entries for
+     * bare keys, without a RecordId, whose only versions are tombstones: inserting a key
+     * writes one first, so that concurrent inserts of the same key conflict on it.
+     */
+    typedef ConcurrentSkipList<string, MvccEntry> Entries;
+    typedef Entries::Node EntryNode;
+
+    struct IndexData {
+        Entries entries;
+        MvccPurgeQueue<Entries> purgeQueue;
+        AtomicInt64 keySize; // includes uncommitted changes
+    };
+
+    string toEntry(const KeyString& ks) {
+        return string(ks.getBuffer(), ks.getSize());
+    }
+
+    SharedBuffer toTypeBits(const KeyString& ks) {
+        const KeyString::TypeBits& typeBits = ks.getTypeBits();
+        if (typeBits.isAllZeros())
+            return SharedBuffer();
+
+        SharedBuffer buffer = SharedBuffer::allocate(typeBits.getSize());
+        memcpy(buffer.get(), typeBits.getBuffer(), typeBits.getSize());
+        return buffer;
+    }
+
+    int typeBitsSize(const KeyString& ks) {
+        const KeyString::TypeBits& typeBits = ks.getTypeBits();
+        return typeBits.isAllZeros() ? 0 : typeBits.getSize();
+    }
+
+    BSONObj decodeKey(const string& entry,
+                      const SharedBuffer& typeBits,
+                      int typeBitsSize,
+                      const Ordering& ordering) {
+        BufReader br(typeBits.get(), typeBitsSize);
+        return KeyString::toBson(entry.data(),
+                                 entry.size(),
+                                 ordering,
+                                 KeyString::TypeBits::fromBuffer(&br));
+    }
+
+    RecordId decodeRecordId(const string& entry) {
+        return KeyString::decodeRecordIdAtEnd(entry.data(), entry.size());
+    }
+
+    /**
+     * True if 'entry' starts with 'prefix', which is a KeyString without a RecordId.
+     */
+    bool hasKeyPrefix(const string& entry, const string& prefix) {
+        return entry.size() > prefix.size() && entry.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    // taken from btree_logic.cpp
+    Status dupKeyError(const BSONObj& key) {
+        StringBuilder sb;
+        sb << "E11000 duplicate key error ";
+        // sb << "index: " << _indexName << " "; // TODO
+        sb << "dup key: " << key;
+        return Status(ErrorCodes::DuplicateKey, sb.str());
+    }
+
+    /**
+     * Queues a written entry for unlinking once it holds nothing any reader can see: after a
+     * committed unindex, or after the rollback of the write that created it.
+     */
+    class PurgeChange : public RecoveryUnit::Change {
+    public:
+        PurgeChange(IndexData* data,
+                    InMemoryMvccRecoveryUnit* ru,
+                    const string& entry,
+                    bool isDelete)
+            : _data(data), _ru(ru), _entry(entry), _isDelete(isDelete) {}
+
+        virtual void commit() {
+            if (_isDelete) {
+                // Our snapshot has moved up to the commit of the delete.
+                _purge(_ru->snapshot());
+            }
+        }
+        virtual void rollback() {
+            _purge(0);
+        }
+
+    private:
+        void _purge(uint64_t commitSeq) {
+            _data->purgeQueue.add(_entry, commitSeq);
+            _data->purgeQueue.purge(_ru->manager(), &_data->entries);
+        }
+
+        IndexData* const _data;
+        InMemoryMvccRecoveryUnit* const _ru;
+        const string _entry;
+        const bool _isDelete;
+    };
+
+    class KeySizeChange : public RecoveryUnit::Change {
+    public:
+        KeySizeChange(IndexData* data, int64_t diff) : _data(data), _diff(diff) {}
+
+        virtual void commit() {}
+        virtual void rollback() {
+            _data->keySize.subtractAndFetch(_diff);
+        }
+
+    private:
+        IndexData* const _data;
+        const int64_t _diff;
+    };
+
+    const MvccVersion* visibleVersion(InMemoryMvccRecoveryUnit* ru,
+                                      const IndexData& data,
+                                      const string& entry) {
+        ru->snapshot(); // registers before we look at any node
+        EntryNode* node = data.entries.find(entry);
+        return node ? node->payload().visibleVersion(ru) : NULL;
+    }
+
+    /**
+     * Writes a new version of 'entry', which is created if need be, throwing
+     * WriteConflictException if another transaction wrote it concurrently.
+     */
+    void writeEntry(OperationContext* txn,
+                    IndexData* data,
+                    const string& entry,
+                    bool tombstone,
+                    const SharedBuffer& typeBits,
+                    int typeBitsSize) {
+        InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(txn);
+        ru->snapshot(); // registers before we look at any node
+        while (true) {
+            EntryNode* node = data->entries.getOrInsert(entry);
+            if (node->payload().write(ru, new MvccVersion(ru->id(),
+                                                          tombstone,
+                                                          typeBits,
+                                                          typeBitsSize))) {
+                txn->recoveryUnit()->registerChange(new PurgeChange(data, ru, entry, tombstone));
+                return;
+            }
+            // The node is being unlinked; a new one is linked in once it is gone.
+        }
+    }
+
+    bool isDup(InMemoryMvccRecoveryUnit* ru,
+               const IndexData& data,
+               const Ordering& ordering,
+               const BSONObj& key,
+               RecordId loc) {
+        ru->snapshot(); // registers before we look at any node
+        const string prefix = toEntry(KeyString::make(key, ordering));
+        for (EntryNode* node = data.entries.seekGT(prefix);
+             node && hasKeyPrefix(node->key(), prefix);
+             node = node->next()) {
+            // Not a dup if the entry is for the same loc.
+            if (node->payload().visibleVersion(ru) && decodeRecordId(node->key()) != loc)
+                return true;
+        }
+        return false;
+    }
+
+    class InMemoryMvccIndexBuilder : public SortedDataBuilderInterface {
+    public:
+        InMemoryMvccIndexBuilder(OperationContext* txn,
+                                 IndexData* data,
+                                 const Ordering& ordering,
+                                 bool dupsAllowed)
+                : _txn(txn),
+                  _data(data),
+                  _ordering(ordering),
+                  _dupsAllowed(dupsAllowed),
+                  _empty(true) {
+            invariant(!_data->entries.first());
+        }
+
+        Status addKey(const BSONObj& key, const RecordId& loc) {
+            // inserts should be in ascending (key, RecordId) order.
+
+            if ( key.objsize() >= TempKeyMaxSize ) {
+                return Status(ErrorCodes::KeyTooLong, "key too big");
+            }
+
+            invariant(loc.isNormal());
+            invariant(!hasFieldNames(key));
+
+            const KeyString keyOnly = KeyString::make(key, _ordering);
+            const string prefix = toEntry(keyOnly);
+
+            if (!_empty) {
+                // Compare specified key with last inserted key, ignoring its RecordId
+                int cmp = prefix.compare(_lastPrefix);
+                if (cmp < 0 || (_dupsAllowed && cmp == 0 && loc < _lastLoc)) {
+                    return Status(ErrorCodes::InternalError,
+                                  "expected ascending (key, RecordId) order in bulk builder");
+                }
+                else if (!_dupsAllowed && cmp == 0 && loc != _lastLoc) {
+                    return dupKeyError(key);
+                }
+            }
+
+            // Nobody else can write to an index being bulk built, so each entry is committed
+            // on its own without conflict checks.
+            InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(_txn);
+            const KeyString ks = KeyString::make(key, _ordering, loc);
+            EntryNode* node = _data->entries.getOrInsert(toEntry(ks));
+            node->payload().writeCommitted(ru, new MvccVersion(ru->id(),
+                                                               false,
+                                                               toTypeBits(ks),
+                                                               typeBitsSize(ks)));
+            _data->keySize.addAndFetch(ks.getSize());
+
+            _lastPrefix = prefix;
+            _lastLoc = loc;
+            _empty = false;
+
+            return Status::OK();
+        }
+
+    private:
+        OperationContext* const _txn;
+        IndexData* const _data;
+        const Ordering _ordering;
+        const bool _dupsAllowed;
+
+        // Used by the bulk builder to detect duplicate keys or (key, RecordId) ordering
+        // violations.
+        bool _empty;
+        string _lastPrefix;
+        RecordId _lastLoc;
+    };
+
+    /**
+     * What the forward and reverse cursors share: the entry they are on, if visible to their
+     * transaction, and its TypeBits.
+     */
+    class CursorBase : public SortedDataInterface::Cursor {
+    public:
+        CursorBase(const IndexData& data, const Ordering& ordering, OperationContext* txn)
+            : _txn(txn),
+              _data(data),
+              _ordering(ordering),
+              _eof(true),
+              _typeBitsSize(0),
+              _keyValid(false)
+        {}
+
+        virtual bool isEOF() const {
+            return _eof;
+        }
+
+        virtual bool pointsToSamePlaceAs(const SortedDataInterface::Cursor& otherBase) const {
+            const CursorBase& other = static_cast<const CursorBase&>(otherBase);
+            invariant(&_data == &other._data); // iterators over same index
+            if (_eof || other._eof)
+                return _eof == other._eof;
+            return _entry == other._entry;
+        }
+
+        virtual void advanceTo(const BSONObj &keyBegin,
+                               int keyBeginLen,
+                               bool afterKey,
+                               const vector<const BSONElement*>& keyEnd,
+                               const vector<bool>& keyEndInclusive) {
+            // XXX I think these do the same thing????
+            customLocate(keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive);
+        }
+
+        virtual BSONObj getKey() const {
+            if (!_keyValid) {
+                _key = decodeKey(_entry, _typeBits, _typeBitsSize, _ordering);
+                _keyValid = true;
+            }
+            return _key;
+        }
+
+        virtual RecordId getRecordId() const {
+            return decodeRecordId(_entry);
+        }
+
+        virtual void savePosition() {
+            // The entry is kept by key, which is all restorePosition() needs.
+        }
+
+    protected:
+        /**
+         * Positions on 'node' if it is not NULL, otherwise at EOF.
+         */
+        void _setPosition(EntryNode* node, const MvccVersion* version) {
+            _keyValid = false;
+            if (!node) {
+                _eof = true;
+                _typeBits = SharedBuffer();
+                return;
+            }
+
+            _eof = false;
+            _entry = node->key();
+
+            // Share the version's TypeBits, as the version may be pruned once we move on.
+            _typeBits = version->data;
+            _typeBitsSize = version->size;
+        }
+
+        InMemoryMvccRecoveryUnit* _ru() const {
+            InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(_txn);
+            ru->snapshot(); // registers before we look at any node
+            return ru;
+        }
+
+        OperationContext* _txn; // not owned
+        const IndexData& _data;
+        const Ordering _ordering;
+
+        bool _eof;
+        string _entry; // only valid if !_eof
+        SharedBuffer _typeBits; // of the version read at _entry
+        int _typeBitsSize;
+
+        // Cache of the decoded key at _entry.
+        mutable bool _keyValid;
+        mutable BSONObj _key;
+    };
+
+    class ForwardCursor : public CursorBase {
+    public:
+        ForwardCursor(const IndexData& data, const Ordering& ordering, OperationContext* txn)
+            : CursorBase(data, ordering, txn)
+        {}
+
+        virtual int getDirection() const { return 1; }
+
+        virtual bool locate(const BSONObj& keyRaw, const RecordId& loc) {
+            const BSONObj key = stripFieldNames(keyRaw);
+            return _seek(toEntry(KeyString::make(key, _ordering, loc)));
+        }
+
+        virtual void customLocate(const BSONObj& keyBegin,
+                                  int keyBeginLen,
+                                  bool afterKey,
+                                  const vector<const BSONElement*>& keyEnd,
+                                  const vector<bool>& keyEndInclusive) {
+            // makeQueryObject handles stripping of fieldnames for us.  Without a RecordId
+            // the KeyString sorts before every entry for an equal key.
+            const BSONObj query = IndexEntryComparison::makeQueryObject(keyBegin,
+                                                                        keyBeginLen,
+                                                                        afterKey,
+                                                                        keyEnd,
+                                                                        keyEndInclusive,
+                                                                        1); // forward
+            _seek(toEntry(KeyString::make(query, _ordering)));
+        }
+
+        virtual void advance() {
+            if (!_eof)
+                _positionAt(_data.entries.seekGT(_entry));
+        }
+
+        virtual void restorePosition(OperationContext* txn) {
+            _txn = txn;
+            if (!_eof)
+                _seek(_entry);
+        }
+
+    private:
+        /**
+         * Positions at the first visible entry >= 'target'.  Returns true if it is equal.
+         */
+        bool _seek(const string& target) {
+            _positionAt(_data.entries.seekGE(target));
+            return !_eof && _entry == target;
+        }
+
+        void _positionAt(EntryNode* node) {
+            InMemoryMvccRecoveryUnit* ru = _ru();
+            for (; node; node = node->next()) {
+                const MvccVersion* version = node->payload().visibleVersion(ru);
+                if (version) {
+                    _setPosition(node, version);
+                    return;
+                }
+            }
+            _setPosition(NULL, NULL);
+        }
+    };
+
+    class ReverseCursor : public CursorBase {
+    public:
+        ReverseCursor(const IndexData& data, const Ordering& ordering, OperationContext* txn)
+            : CursorBase(data, ordering, txn)
+        {}
+
+        virtual int getDirection() const { return -1; }
+
+        virtual bool locate(const BSONObj& keyRaw, const RecordId& loc) {
+            const BSONObj key = stripFieldNames(keyRaw);
+
+            // A null RecordId means any entry for the key, the last of which is the first
+            // one seen when moving backwards.
+            return _seek(toEntry(KeyString::make(key,
+                                                 _ordering,
+                                                 loc.isNull() ? RecordId::max() : loc)));
+        }
+
+        virtual void customLocate(const BSONObj& keyBegin,
+                                  int keyBeginLen,
+                                  bool afterKey,
+                                  const vector<const BSONElement*>& keyEnd,
+                                  const vector<bool>& keyEndInclusive) {
+            // makeQueryObject handles stripping of fieldnames for us.  RecordId::max() sorts
+            // after every entry for an equal key.
+            const BSONObj query = IndexEntryComparison::makeQueryObject(keyBegin,
+                                                                        keyBeginLen,
+                                                                        afterKey,
+                                                                        keyEnd,
+                                                                        keyEndInclusive,
+                                                                        -1); // reverse
+            _seek(toEntry(KeyString::make(query, _ordering, RecordId::max())));
+        }
+
+        virtual void advance() {
+            if (!_eof)
+                _positionAtOrBefore(_data.entries.seekLT(_entry));
+        }
+
+        virtual void restorePosition(OperationContext* txn) {
+            _txn = txn;
+            if (!_eof)
+                _seek(_entry);
+        }
+
+    private:
+        /**
+         * Positions at the last visible entry <= 'target'.  Returns true if it is equal.
+         */
+        bool _seek(const string& target) {
+            _positionAtOrBefore(_data.entries.seekLE(target));
+            return !_eof && _entry == target;
+        }
+
+        /**
+         * Nodes only link forwards, so each invisible entry skipped costs a search.
+         */
+        void _positionAtOrBefore(EntryNode* node) {
+            InMemoryMvccRecoveryUnit* ru = _ru();
+            while (node) {
+                const MvccVersion* version = node->payload().visibleVersion(ru);
+                if (version) {
+                    _setPosition(node, version);
+                    return;
+                }
+                node = _data.entries.seekLT(node->key());
+            }
+            _setPosition(NULL, NULL);
+        }
+    };
+
+    class InMemoryMvccIndex : public SortedDataInterface {
+    public:
+        InMemoryMvccIndex(IndexData* data, const Ordering& ordering)
+            : _data(data),
+              _ordering(ordering) {
+        }
+
+        virtual SortedDataBuilderInterface* getBulkBuilder(OperationContext* txn,
+                                                           bool dupsAllowed) {
+            return new InMemoryMvccIndexBuilder(txn, _data, _ordering, dupsAllowed);
+        }
+
+        virtual Status insert(OperationContext* txn,
+                              const BSONObj& key,
+                              const RecordId& loc,
+                              bool dupsAllowed) {
+
+            invariant(loc.isNormal());
+            invariant(!hasFieldNames(key));
+
+            if ( key.objsize() >= TempKeyMaxSize ) {
+                string msg = mongoutils::str::stream()
+                    << "InMemoryMvccIndex::insert: key too large to index, failing "
+                    << ' ' << key.objsize() << ' ' << key;
+                return Status(ErrorCodes::KeyTooLong, msg);
+            }
+
+            InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(txn);
+
+            if (!dupsAllowed) {
+                // Claim the key first, so that another transaction inserting it concurrently
+                // conflicts with us rather than missing our entry in its dup check.
+                const string keyOnly = toEntry(KeyString::make(key, _ordering));
+                writeEntry(txn, _data, keyOnly, true, SharedBuffer(), 0);
+
+                if (isDup(ru, *_data, _ordering, key, loc))
+                    return dupKeyError(key);
+            }
+
+            const KeyString ks = KeyString::make(key, _ordering, loc);
+            const string entry = toEntry(ks);
+            if (visibleVersion(ru, *_data, entry))
+                return Status::OK();
+
+            writeEntry(txn, _data, entry, false, toTypeBits(ks), typeBitsSize(ks));
+            _changeKeySize(txn, ks.getSize());
+            return Status::OK();
+        }
+
+        virtual void unindex(OperationContext* txn,
+                             const BSONObj& key,
+                             const RecordId& loc,
+                             bool dupsAllowed) {
+            invariant(loc.isNormal());
+            invariant(!hasFieldNames(key));
+
+            InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(txn);
+            const KeyString ks = KeyString::make(key, _ordering, loc);
+            const string entry = toEntry(ks);
+            if (!visibleVersion(ru, *_data, entry))
+                return;
+
+            writeEntry(txn, _data, entry, true, SharedBuffer(), 0);
+            _changeKeySize(txn, -ks.getSize());
+        }
+
+        virtual void fullValidate(OperationContext* txn, bool full, long long *numKeysOut,
+                                  BSONObjBuilder* output) const {
+            // TODO check invariants?
+            InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(txn);
+            ru->snapshot(); // registers before we look at any node
+
+            long long numKeys = 0;
+            for (EntryNode* node = _data->entries.first(); node; node = node->next()) {
+                if (node->payload().visibleVersion(ru))
+                    numKeys++;
+            }
+            *numKeysOut = numKeys;
+        }
+
+        virtual bool appendCustomStats(OperationContext* txn, BSONObjBuilder* output, double scale)
+            const {
+            return false;
+        }
+
+        virtual long long getSpaceUsedBytes( OperationContext* txn ) const {
+            return _data->keySize.load();
+        }
+
+        virtual Status dupKeyCheck(OperationContext* txn, const BSONObj& key, const RecordId& loc) {
+            invariant(!hasFieldNames(key));
+            if (isDup(InMemoryMvccRecoveryUnit::get(txn), *_data, _ordering, key, loc))
+                return dupKeyError(key);
+            return Status::OK();
+        }
+
+        virtual bool isEmpty(OperationContext* txn) {
+            InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(txn);
+            ru->snapshot(); // registers before we look at any node
+
+            for (EntryNode* node = _data->entries.first(); node; node = node->next()) {
+                if (node->payload().visibleVersion(ru))
+                    return false;
+            }
+            return true;
+        }
+
+        virtual Status touch(OperationContext* txn) const{
+            // already in memory...
+            return Status::OK();
+        }
+
+        virtual SortedDataInterface::Cursor* newCursor(OperationContext* txn, int direction) const {
+            if (direction == 1)
+                return new ForwardCursor(*_data, _ordering, txn);
+
+            invariant(direction == -1);
+            return new ReverseCursor(*_data, _ordering, txn);
+        }
+
+        virtual Status initAsEmpty(OperationContext* txn) {
+            // No-op
+            return Status::OK();
+        }
+
+    private:
+        void _changeKeySize(OperationContext* txn, int64_t diff) {
+            txn->recoveryUnit()->registerChange(new KeySizeChange(_data, diff));
+            _data->keySize.addAndFetch(diff);
+        }
+
+        IndexData* _data;
+        const Ordering _ordering;
+    };
+} // namespace
+
+    SortedDataInterface* getInMemoryMvccIndex(const Ordering& ordering,
+                                              boost::shared_ptr<void>* dataInOut) {
+        invariant(dataInOut);
+        if (!*dataInOut) {
+            *dataInOut = boost::make_shared<IndexData>();
+        }
+        return new InMemoryMvccIndex(static_cast<IndexData*>(dataInOut->get()), ordering);
+    }
+
+}  // namespace mongo
@@ -0,0 +1,127 @@
+// in_memory_mvcc_index_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/in_memory/in_memory_mvcc_index.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/storage/in_memory/in_memory_mvcc.h"
+#include "mongo/db/storage/in_memory/in_memory_mvcc_recovery_unit.h"
+#include "mongo/db/storage/sorted_data_interface_test_harness.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+
+    using boost::scoped_ptr;
+    using boost::shared_ptr;
+
+    class InMemoryMvccHarnessHelper : public HarnessHelper {
+    public:
+        InMemoryMvccHarnessHelper()
+            : _order( Ordering::make( BSONObj() ) ) {
+        }
+
+        virtual SortedDataInterface* newSortedDataInterface( bool unique ) {
+            return getInMemoryMvccIndex(_order, &_data);
+        }
+
+        virtual RecoveryUnit* newRecoveryUnit() {
+            return new InMemoryMvccRecoveryUnit(&_manager);
+        }
+
+    private:
+        MvccManager _manager;
+        shared_ptr<void> _data; // used by the index
+        Ordering _order;
+    };
+
+    HarnessHelper* newHarnessHelper() {
+        return new InMemoryMvccHarnessHelper();
+    }
+
+namespace {
+
+    TEST(InMemoryMvccIndex, ConcurrentUniqueInsertsConflict) {
+        InMemoryMvccHarnessHelper harness;
+        scoped_ptr<SortedDataInterface> sorted(harness.newSortedDataInterface(true));
+
+        scoped_ptr<OperationContext> first(harness.newOperationContext());
+        scoped_ptr<OperationContext> second(harness.newOperationContext());
+
+        const BSONObj key = BSON("" << 1);
+
+        WriteUnitOfWork uow1(first.get());
+        ASSERT_OK(sorted->insert(first.get(), key, RecordId(1, 1), false));
+
+        // Neither transaction sees the other's entry, so only the conflict stops a dup.
+        {
+            WriteUnitOfWork uow2(second.get());
+            ASSERT_THROWS(sorted->insert(second.get(), key, RecordId(1, 2), false),
+                          WriteConflictException);
+        }
+
+        uow1.commit();
+        second->recoveryUnit()->commitAndRestart();
+
+        WriteUnitOfWork uow2(second.get());
+        ASSERT_EQUALS(ErrorCodes::DuplicateKey,
+                      sorted->insert(second.get(), key, RecordId(1, 2), false));
+    }
+
+    TEST(InMemoryMvccIndex, UnindexIsInvisibleUntilCommit) {
+        InMemoryMvccHarnessHelper harness;
+        scoped_ptr<SortedDataInterface> sorted(harness.newSortedDataInterface(false));
+
+        scoped_ptr<OperationContext> writer(harness.newOperationContext());
+        scoped_ptr<OperationContext> reader(harness.newOperationContext());
+
+        const BSONObj key = BSON("" << 1);
+        {
+            WriteUnitOfWork uow(writer.get());
+            ASSERT_OK(sorted->insert(writer.get(), key, RecordId(1, 1), true));
+            uow.commit();
+        }
+
+        WriteUnitOfWork uow(writer.get());
+        sorted->unindex(writer.get(), key, RecordId(1, 1), true);
+        ASSERT(sorted->isEmpty(writer.get()));
+        ASSERT_FALSE(sorted->isEmpty(reader.get()));
+
+        scoped_ptr<SortedDataInterface::Cursor> cursor(sorted->newCursor(reader.get(), 1));
+        ASSERT(cursor->locate(key, RecordId(1, 1)));
+        ASSERT_EQUALS(key, cursor->getKey());
+    }
+
+} // namespace
+} // namespace mongo
@@ -0,0 +1,828 @@
+// in_memory_mvcc_record_store.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/in_memory/in_memory_mvcc_record_store.h"
+
+#include <boost/make_shared.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <cstring>
+#include <set>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/storage/in_memory/in_memory_mvcc_recovery_unit.h"
+#include "mongo/db/storage/oplog_hack.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    struct InMemoryMvccRecordStore::Data {
+        explicit Data(bool isOplog) : nextId(1), isOplog(isOplog) {}
+
+        Records records;
+        MvccPurgeQueue<Records> purgeQueue;
+
+        AtomicInt64 nextId;
+        AtomicInt64 numRecords; // includes uncommitted changes
+        AtomicInt64 dataSize; // includes uncommitted changes
+        const bool isOplog;
+
+        // Capped only.
+        boost::mutex uncommittedInsertsMutex;
+        std::multiset<RecordId> uncommittedInserts;
+        boost::mutex cappedDeleterMutex;
+        RecordId cappedFirstRecord; // where capped deletes resume, under cappedDeleterMutex
+    };
+
+    typedef InMemoryMvccRecordStore::Records::Node RecordNode;
+
+    class InMemoryMvccRecordStore::CountChange : public RecoveryUnit::Change {
+    public:
+        CountChange(const boost::shared_ptr<Data>& data,
+                    int64_t numRecordsDiff,
+                    int64_t dataSizeDiff)
+            : _data(data), _numRecordsDiff(numRecordsDiff), _dataSizeDiff(dataSizeDiff) {}
+
+        virtual void commit() {}
+        virtual void rollback() {
+            _data->numRecords.subtractAndFetch(_numRecordsDiff);
+            _data->dataSize.subtractAndFetch(_dataSizeDiff);
+        }
+
+    private:
+        const boost::shared_ptr<Data> _data;
+        const int64_t _numRecordsDiff;
+        const int64_t _dataSizeDiff;
+    };
+
+    /**
+     * Queues the node of a written record for unlinking once it holds nothing any reader can
+     * see: after a committed delete, or after the rollback of the write that created it.
+     */
+    class InMemoryMvccRecordStore::PurgeChange : public RecoveryUnit::Change {
+    public:
+        PurgeChange(const boost::shared_ptr<Data>& data,
+                    InMemoryMvccRecoveryUnit* ru,
+                    const RecordId& loc,
+                    bool isDelete)
+            : _data(data), _ru(ru), _loc(loc), _isDelete(isDelete) {}
+
+        virtual void commit() {
+            if (_isDelete) {
+                // Our snapshot has moved up to the commit of the delete.
+                _purge(_ru->snapshot());
+            }
+        }
+        virtual void rollback() {
+            _purge(0);
+        }
+
+    private:
+        void _purge(uint64_t commitSeq) {
+            _data->purgeQueue.add(_loc, commitSeq);
+            _data->purgeQueue.purge(_ru->manager(), &_data->records);
+        }
+
+        const boost::shared_ptr<Data> _data;
+        InMemoryMvccRecoveryUnit* const _ru;
+        const RecordId _loc;
+        const bool _isDelete;
+    };
+
+    class InMemoryMvccRecordStore::CappedInsertChange : public RecoveryUnit::Change {
+    public:
+        CappedInsertChange(const boost::shared_ptr<Data>& data, const RecordId& loc)
+            : _data(data), _loc(loc) {
+            boost::mutex::scoped_lock lk(_data->uncommittedInsertsMutex);
+            _data->uncommittedInserts.insert(_loc);
+        }
+
+        virtual void commit() { _done(); }
+        virtual void rollback() { _done(); }
+
+    private:
+        void _done() {
+            boost::mutex::scoped_lock lk(_data->uncommittedInsertsMutex);
+            _data->uncommittedInserts.erase(_data->uncommittedInserts.find(_loc));
+        }
+
+        const boost::shared_ptr<Data> _data;
+        const RecordId _loc;
+    };
+
+    class InMemoryMvccRecordStore::CappedDeleteChange : public RecoveryUnit::Change {
+    public:
+        explicit CappedDeleteChange(const boost::shared_ptr<Data>& data) : _data(data) {}
+
+        virtual void commit() {}
+        virtual void rollback() {
+            // The records we deleted are back, so start over from the beginning next time.
+            boost::mutex::scoped_lock lk(_data->cappedDeleterMutex);
+            _data->cappedFirstRecord = RecordId();
+        }
+
+    private:
+        const boost::shared_ptr<Data> _data;
+    };
+
+    //
+    // Iterators
+    //
+
+    class InMemoryMvccRecordStore::Iterator : public RecordIterator {
+    public:
+        Iterator(OperationContext* txn, const InMemoryMvccRecordStore& rs, const RecordId& start)
+            : _txn(txn),
+              _rs(rs),
+              _node(NULL),
+              _generation(0),
+              _readUntil(rs._isCapped ? rs._lowestUncommittedInsert() : RecordId::max()),
+              _killed(false) {
+            InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(_txn);
+            _generation = ru->generation();
+            if (start.isNull()) {
+                _positionAt(ru, _rs._data->records.first());
+            }
+            else {
+                _positionAt(ru, _rs._data->records.seekGE(start));
+            }
+        }
+
+        virtual bool isEOF() {
+            return _curr.isNull();
+        }
+
+        virtual RecordId curr() {
+            return _curr;
+        }
+
+        virtual RecordId getNext() {
+            if (_killed) {
+                return RecordId();
+            }
+
+            InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(_txn);
+            if (_curr.isNull()) {
+                // Capped collections may have grown since we hit the end, as for tailing.
+                if (!_rs._isCapped || _lastReturned.isNull()) {
+                    return RecordId();
+                }
+                _readUntil = _rs._lowestUncommittedInsert();
+                _positionAt(ru, _rs._data->records.seekGT(_lastReturned));
+                if (_curr.isNull()) {
+                    return RecordId();
+                }
+            }
+
+            const RecordId out = _curr;
+            _lastReturned = out;
+            _positionAt(ru, _nodeAfterCurr(ru));
+            return out;
+        }
+
+        virtual void invalidate(const RecordId& loc) {
+            // Not called for engines with document-level locking.
+        }
+
+        virtual void saveState() {
+        }
+
+        virtual bool restoreState(OperationContext* txn) {
+            _txn = txn;
+            if (_killed || _curr.isNull()) {
+                return !_killed;
+            }
+
+            InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(_txn);
+            if (_rs._visibleVersion(ru, _curr)) {
+                return true;
+            }
+
+            if (_rs._isCapped) {
+                // Capped iterators die if their record is deleted from under them.
+                _killed = true;
+                return false;
+            }
+
+            _positionAt(ru, _rs._data->records.seekGT(_curr));
+            return true;
+        }
+
+        virtual RecordData dataFor( const RecordId& loc ) const {
+            return _rs.dataFor(_txn, loc);
+        }
+
+    private:
+        /**
+         * Moves to the first record at or after 'node' that this transaction sees.
+         */
+        void _positionAt(InMemoryMvccRecoveryUnit* ru, RecordNode* node) {
+            for (; node; node = node->next()) {
+                if (node->key() >= _readUntil) {
+                    break;
+                }
+                if (node->payload().visibleVersion(ru)) {
+                    _node = node;
+                    _curr = node->key();
+                    _generation = ru->generation();
+                    return;
+                }
+            }
+
+            _node = NULL;
+            _curr = RecordId();
+        }
+
+        RecordNode* _nodeAfterCurr(InMemoryMvccRecoveryUnit* ru) {
+            ru->snapshot(); // keeps the nodes we walk from being freed
+            if (_node && _generation == ru->generation()) {
+                return _node->next();
+            }
+            return _rs._data->records.seekGT(_curr);
+        }
+
+        OperationContext* _txn;
+        const InMemoryMvccRecordStore& _rs;
+
+        RecordId _curr; // null at EOF
+        RecordNode* _node; // the node of _curr, only valid in _generation
+        uint64_t _generation;
+
+        RecordId _lastReturned;
+        RecordId _readUntil;
+        bool _killed;
+    };
+
+    class InMemoryMvccRecordStore::ReverseIterator : public RecordIterator {
+    public:
+        ReverseIterator(OperationContext* txn,
+                        const InMemoryMvccRecordStore& rs,
+                        const RecordId& start)
+            : _txn(txn), _rs(rs), _killed(false) {
+            InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(_txn);
+            if (start.isNull()) {
+                _positionAtOrBefore(ru, _rs._data->records.last());
+            }
+            else {
+                _positionAtOrBefore(ru, _rs._data->records.seekLE(start));
+            }
+        }
+
+        virtual bool isEOF() {
+            return _curr.isNull();
+        }
+
+        virtual RecordId curr() {
+            return _curr;
+        }
+
+        virtual RecordId getNext() {
+            if (_killed || _curr.isNull()) {
+                return RecordId();
+            }
+
+            InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(_txn);
+            const RecordId out = _curr;
+            _positionAtOrBefore(ru, _rs._data->records.seekLT(out));
+            return out;
+        }
+
+        virtual void invalidate(const RecordId& loc) {
+            // Not called for engines with document-level locking.
+        }
+
+        virtual void saveState() {
+        }
+
+        virtual bool restoreState(OperationContext* txn) {
+            _txn = txn;
+            if (_killed || _curr.isNull()) {
+                return !_killed;
+            }
+
+            InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(_txn);
+            if (_rs._visibleVersion(ru, _curr)) {
+                return true;
+            }
+
+            if (_rs._isCapped) {
+                _killed = true;
+                return false;
+            }
+
+            _positionAtOrBefore(ru, _rs._data->records.seekLT(_curr));
+            return true;
+        }
+
+        virtual RecordData dataFor( const RecordId& loc ) const {
+            return _rs.dataFor(_txn, loc);
+        }
+
+    private:
+        /**
+         * Moves to the last record at or before 'node' that this transaction sees. Going
+         * backwards means a search per record skipped, as nodes only link forwards.
+         */
+        void _positionAtOrBefore(InMemoryMvccRecoveryUnit* ru, RecordNode* node) {
+            while (node && !node->payload().visibleVersion(ru)) {
+                node = _rs._data->records.seekLT(node->key());
+            }
+            _curr = node ? node->key() : RecordId();
+        }
+
+        OperationContext* _txn;
+        const InMemoryMvccRecordStore& _rs;
+        RecordId _curr; // null at EOF
+        bool _killed;
+    };
+
+    //
+    // RecordStore
+    //
+
+    InMemoryMvccRecordStore::InMemoryMvccRecordStore(
+            const StringData& ns,
+            boost::shared_ptr<void>* dataInOut,
+            bool isCapped,
+            int64_t cappedMaxSize,
+            int64_t cappedMaxDocs,
+            CappedDocumentDeleteCallback* cappedDeleteCallback)
+        : RecordStore(ns),
+          _isCapped(isCapped),
+          _cappedMaxSize(cappedMaxSize),
+          _cappedMaxDocs(cappedMaxDocs),
+          _cappedDeleteCallback(cappedDeleteCallback),
+          _data(_getOrCreateData(dataInOut, NamespaceString::oplog(ns))) {
+
+        if (_isCapped) {
+            invariant(_cappedMaxSize > 0);
+            invariant(_cappedMaxDocs == -1 || _cappedMaxDocs > 0);
+        }
+        else {
+            invariant(_cappedMaxSize == -1);
+            invariant(_cappedMaxDocs == -1);
+        }
+    }
+
+    boost::shared_ptr<InMemoryMvccRecordStore::Data> InMemoryMvccRecordStore::_getOrCreateData(
+            boost::shared_ptr<void>* dataInOut,
+            bool isOplog) {
+        invariant(dataInOut);
+        if (!*dataInOut) {
+            boost::shared_ptr<Data> data = boost::make_shared<Data>(isOplog);
+            *dataInOut = data;
+            return data;
+        }
+        return boost::static_pointer_cast<Data>(*dataInOut);
+    }
+
+    const char* InMemoryMvccRecordStore::name() const { return "InMemoryMvcc"; }
+
+    long long InMemoryMvccRecordStore::dataSize(OperationContext* txn) const {
+        return _data->dataSize.load();
+    }
+
+    long long InMemoryMvccRecordStore::numRecords(OperationContext* txn) const {
+        return _data->numRecords.load();
+    }
+
+    const MvccVersion* InMemoryMvccRecordStore::_visibleVersion(InMemoryMvccRecoveryUnit* ru,
+                                                                const RecordId& loc) const {
+        ru->snapshot(); // registers before we look at any node
+        RecordNode* node = _data->records.find(loc);
+        return node ? node->payload().visibleVersion(ru) : NULL;
+    }
+
+    RecordData InMemoryMvccRecordStore::dataFor(OperationContext* txn,
+                                                const RecordId& loc) const {
+        const MvccVersion* version = _visibleVersion(InMemoryMvccRecoveryUnit::get(txn), loc);
+        if (!version) {
+            error() << "InMemoryMvccRecordStore::dataFor cannot find record for " << ns()
+                    << ":" << loc;
+        }
+        invariant(version);
+        return RecordData(version->data, version->size);
+    }
+
+    bool InMemoryMvccRecordStore::findRecord(OperationContext* txn,
+                                             const RecordId& loc,
+                                             RecordData* rd) const {
+        const MvccVersion* version = _visibleVersion(InMemoryMvccRecoveryUnit::get(txn), loc);
+        if (!version) {
+            return false;
+        }
+        *rd = RecordData(version->data, version->size);
+        return true;
+    }
+
+    void InMemoryMvccRecordStore::_write(OperationContext* txn,
+                                         const RecordId& loc,
+                                         bool tombstone,
+                                         const SharedBuffer& data,
+                                         int size) {
+        InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(txn);
+        ru->snapshot(); // registers before we look at any node
+        while (true) {
+            RecordNode* node = _data->records.getOrInsert(loc);
+            if (node->payload().write(ru, new MvccVersion(ru->id(), tombstone, data, size))) {
+                txn->recoveryUnit()->registerChange(new PurgeChange(_data, ru, loc, tombstone));
+                return;
+            }
+            // The node is being unlinked; a new one is linked in once it is gone.
+        }
+    }
+
+    void InMemoryMvccRecordStore::_changeCounts(OperationContext* txn,
+                                                int64_t numRecordsDiff,
+                                                int64_t dataSizeDiff) {
+        txn->recoveryUnit()->registerChange(new CountChange(_data, numRecordsDiff, dataSizeDiff));
+        _data->numRecords.addAndFetch(numRecordsDiff);
+        _data->dataSize.addAndFetch(dataSizeDiff);
+    }
+
+    void InMemoryMvccRecordStore::deleteRecord(OperationContext* txn, const RecordId& loc) {
+        const MvccVersion* old = _visibleVersion(InMemoryMvccRecoveryUnit::get(txn), loc);
+        if (!old) {
+            error() << "InMemoryMvccRecordStore::deleteRecord cannot find record for " << ns()
+                    << ":" << loc;
+        }
+        invariant(old);
+        _deleteRecord(txn, loc, old);
+    }
+
+    void InMemoryMvccRecordStore::_deleteRecord(OperationContext* txn,
+                                                const RecordId& loc,
+                                                const MvccVersion* old) {
+        const int oldSize = old->size;
+        _write(txn, loc, true, SharedBuffer(), 0);
+        _changeCounts(txn, -1, -oldSize);
+    }
+
+    bool InMemoryMvccRecordStore::_cappedAndNeedDelete() const {
+        if (!_isCapped)
+            return false;
+
+        if (_data->dataSize.load() > _cappedMaxSize)
+            return true;
+
+        if ((_cappedMaxDocs != -1) && (_data->numRecords.load() > _cappedMaxDocs))
+            return true;
+
+        return false;
+    }
+
+    void InMemoryMvccRecordStore::_cappedDeleteAsNeeded(OperationContext* txn,
+                                                        const RecordId& justInserted) {
+        if (!_cappedAndNeedDelete())
+            return;
+
+        // One inserter at a time does the deleting; the others carry on, as it will catch up
+        // with them.
+        boost::unique_lock<boost::mutex> lk(_data->cappedDeleterMutex, boost::try_to_lock);
+        if (!lk.owns_lock())
+            return;
+
+        InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(txn);
+        ru->snapshot(); // registers before we look at any node
+
+        // Deletes another inserter made but has not committed yet are invisible to us, so start
+        // after them rather than conflicting on them.
+        RecordNode* node = _data->cappedFirstRecord.isNull()
+            ? _data->records.first()
+            : _data->records.seekGE(_data->cappedFirstRecord);
+
+        txn->recoveryUnit()->registerChange(new CappedDeleteChange(_data));
+        while (_cappedAndNeedDelete() && node && node->key() != justInserted) {
+            const MvccVersion* old = node->payload().visibleVersion(ru);
+            if (old) {
+                const RecordId loc = node->key();
+                if (_cappedDeleteCallback) {
+                    uassertStatusOK(_cappedDeleteCallback->aboutToDeleteCapped(txn, loc));
+                }
+                _deleteRecord(txn, loc, old);
+            }
+            node = node->next();
+        }
+
+        _data->cappedFirstRecord = node ? node->key() : justInserted;
+    }
+
+    StatusWith<RecordId> InMemoryMvccRecordStore::_extractAndCheckLocForOplog(const char* data,
+                                                                             int len) const {
+        StatusWith<RecordId> status = oploghack::extractKey(data, len);
+        if (!status.isOK())
+            return status;
+
+        RecordNode* last = _data->records.last();
+        if (last && status.getValue() <= last->key())
+            return StatusWith<RecordId>(ErrorCodes::BadValue, "ts not higher than highest");
+
+        return status;
+    }
+
+    RecordId InMemoryMvccRecordStore::_lowestUncommittedInsert() const {
+        boost::mutex::scoped_lock lk(_data->uncommittedInsertsMutex);
+        if (_data->uncommittedInserts.empty()) {
+            return RecordId::max();
+        }
+        return *_data->uncommittedInserts.begin();
+    }
+
+    StatusWith<RecordId> InMemoryMvccRecordStore::_insertRecord(OperationContext* txn,
+                                                               const SharedBuffer& data,
+                                                               int len) {
+        RecordId loc;
+        if (_data->isOplog) {
+            StatusWith<RecordId> status = _extractAndCheckLocForOplog(data.get(), len);
+            if (!status.isOK())
+                return status;
+            loc = status.getValue();
+        }
+        else {
+            loc = RecordId(_data->nextId.fetchAndAdd(1));
+            invariant(loc < RecordId::max());
+        }
+
+        if (_isCapped) {
+            txn->recoveryUnit()->registerChange(new CappedInsertChange(_data, loc));
+        }
+
+        _write(txn, loc, false, data, len);
+        _changeCounts(txn, 1, len);
+
+        _cappedDeleteAsNeeded(txn, loc);
+
+        return StatusWith<RecordId>(loc);
+    }
+
+    StatusWith<RecordId> InMemoryMvccRecordStore::insertRecord(OperationContext* txn,
+                                                              const char* data,
+                                                              int len,
+                                                              bool enforceQuota) {
+        if (_isCapped && len > _cappedMaxSize) {
+            // We use dataSize for capped rollover and we don't want to delete everything if we know
+            // this won't fit.
+            return StatusWith<RecordId>(ErrorCodes::BadValue,
+                                       "object to insert exceeds cappedMaxSize");
+        }
+
+        SharedBuffer buffer = SharedBuffer::allocate(len);
+        memcpy(buffer.get(), data, len);
+        return _insertRecord(txn, buffer, len);
+    }
+
+    StatusWith<RecordId> InMemoryMvccRecordStore::insertRecord(OperationContext* txn,
+                                                              const DocWriter* doc,
+                                                              bool enforceQuota) {
+        const int len = doc->documentSize();
+        if (_isCapped && len > _cappedMaxSize) {
+            // We use dataSize for capped rollover and we don't want to delete everything if we know
+            // this won't fit.
+            return StatusWith<RecordId>(ErrorCodes::BadValue,
+                                       "object to insert exceeds cappedMaxSize");
+        }
+
+        SharedBuffer buffer = SharedBuffer::allocate(len);
+        doc->writeDocument(buffer.get());
+        return _insertRecord(txn, buffer, len);
+    }
+
+    StatusWith<RecordId> InMemoryMvccRecordStore::updateRecord(OperationContext* txn,
+                                                              const RecordId& loc,
+                                                              const char* data,
+                                                              int len,
+                                                              bool enforceQuota,
+                                                              UpdateMoveNotifier* notifier ) {
+        const MvccVersion* old = _visibleVersion(InMemoryMvccRecoveryUnit::get(txn), loc);
+        invariant(old);
+        const int oldLen = old->size;
+
+        if (_isCapped && len > oldLen) {
+            return StatusWith<RecordId>( ErrorCodes::InternalError,
+                                        "failing update: objects in a capped ns cannot grow",
+                                        10003 );
+        }
+
+        SharedBuffer buffer = SharedBuffer::allocate(len);
+        memcpy(buffer.get(), data, len);
+
+        _write(txn, loc, false, buffer, len);
+        _changeCounts(txn, 0, len - oldLen);
+
+        return StatusWith<RecordId>(loc);
+    }
+
+    bool InMemoryMvccRecordStore::updateWithDamagesSupported() const {
+        return true;
+    }
+
+    Status InMemoryMvccRecordStore::updateWithDamages( OperationContext* txn,
+                                                       const RecordId& loc,
+                                                       const RecordData& oldRec,
+                                                       const char* damageSource,
+                                                       const mutablebson::DamageVector& damages ) {
+        const MvccVersion* old = _visibleVersion(InMemoryMvccRecoveryUnit::get(txn), loc);
+        invariant(old);
+        const int len = old->size;
+
+        SharedBuffer buffer = SharedBuffer::allocate(len);
+        memcpy(buffer.get(), old->data.get(), len);
+
+        char* root = buffer.get();
+        mutablebson::DamageVector::const_iterator where = damages.begin();
+        const mutablebson::DamageVector::const_iterator end = damages.end();
+        for( ; where != end; ++where ) {
+            const char* sourcePtr = damageSource + where->sourceOffset;
+            char* targetPtr = root + where->targetOffset;
+            std::memcpy(targetPtr, sourcePtr, where->size);
+        }
+
+        _write(txn, loc, false, buffer, len);
+
+        return Status::OK();
+    }
+
+    RecordIterator* InMemoryMvccRecordStore::getIterator(
+            OperationContext* txn,
+            const RecordId& start,
+            const CollectionScanParams::Direction& dir) const {
+
+        if (dir == CollectionScanParams::FORWARD) {
+            return new Iterator(txn, *this, start);
+        }
+        else {
+            return new ReverseIterator(txn, *this, start);
+        }
+    }
+
+    std::vector<RecordIterator*> InMemoryMvccRecordStore::getManyIterators(
+            OperationContext* txn) const {
+        std::vector<RecordIterator*> out;
+        out.push_back(new Iterator(txn, *this, RecordId()));
+        return out;
+    }
+
+    Status InMemoryMvccRecordStore::truncate(OperationContext* txn) {
+        InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(txn);
+        ru->snapshot(); // registers before we look at any node
+
+        for (RecordNode* node = _data->records.first(); node; node = node->next()) {
+            const MvccVersion* old = node->payload().visibleVersion(ru);
+            if (old) {
+                _deleteRecord(txn, node->key(), old);
+            }
+        }
+        return Status::OK();
+    }
+
+    void InMemoryMvccRecordStore::temp_cappedTruncateAfter(OperationContext* txn,
+                                                           RecordId end,
+                                                           bool inclusive) {
+        InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(txn);
+        ru->snapshot(); // registers before we look at any node
+
+        RecordNode* node = inclusive ? _data->records.seekGE(end) : _data->records.seekGT(end);
+        for (; node; node = node->next()) {
+            const MvccVersion* old = node->payload().visibleVersion(ru);
+            if (old) {
+                _deleteRecord(txn, node->key(), old);
+            }
+        }
+    }
+
+    Status InMemoryMvccRecordStore::compact(OperationContext* txn,
+                                            RecordStoreCompactAdaptor* adaptor,
+                                            const CompactOptions* options,
+                                            CompactStats* stats) {
+        // Nothing to reclaim: deleted records are unlinked once no reader can see them.
+        invariant(!"compact not supported");
+    }
+
+    Status InMemoryMvccRecordStore::validate(OperationContext* txn,
+                                             bool full,
+                                             bool scanData,
+                                             ValidateAdaptor* adaptor,
+                                             ValidateResults* results,
+                                             BSONObjBuilder* output) {
+        InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(txn);
+        ru->snapshot(); // registers before we look at any node
+
+        results->valid = true;
+        long long nrecords = 0;
+        for (RecordNode* node = _data->records.first(); node; node = node->next()) {
+            const MvccVersion* version = node->payload().visibleVersion(ru);
+            if (!version) {
+                continue;
+            }
+
+            nrecords++;
+            if (scanData && full) {
+                size_t dataSize;
+                const Status status = adaptor->validate(RecordData(version->data.get(),
+                                                                   version->size),
+                                                        &dataSize);
+                if (!status.isOK()) {
+                    results->valid = false;
+                    results->errors.push_back("invalid object detected (see logs)");
+                    log() << "Invalid object detected in " << _ns << ": " << status.reason();
+                }
+            }
+        }
+
+        output->appendNumber( "nrecords", nrecords );
+
+        return Status::OK();
+    }
+
+    void InMemoryMvccRecordStore::appendCustomStats( OperationContext* txn,
+                                                     BSONObjBuilder* result,
+                                                     double scale ) const {
+        result->appendBool( "capped", _isCapped );
+        if ( _isCapped ) {
+            result->appendIntOrLL( "max", _cappedMaxDocs );
+            result->appendIntOrLL( "maxSize", _cappedMaxSize / scale );
+        }
+    }
+
+    Status InMemoryMvccRecordStore::touch(OperationContext* txn, BSONObjBuilder* output) const {
+        if (output) {
+            output->append("numRanges", 1);
+            output->append("millis", 0);
+        }
+        return Status::OK();
+    }
+
+    Status InMemoryMvccRecordStore::setCustomOption(
+                OperationContext* txn, const BSONElement& option, BSONObjBuilder* info) {
+        StringData name = option.fieldName();
+        if ( name == "usePowerOf2Sizes" ) {
+            // we ignore, so just say ok
+            return Status::OK();
+        }
+
+        return Status( ErrorCodes::InvalidOptions,
+                       mongoutils::str::stream()
+                       << "unknown custom option to InMemoryMvccRecordStore: "
+                       << name );
+    }
+
+    int64_t InMemoryMvccRecordStore::storageSize(OperationContext* txn,
+                                                 BSONObjBuilder* extraInfo,
+                                                 int infoLevel) const {
+        const int64_t recordOverhead = numRecords(txn) * (sizeof(RecordNode) +
+                                                          sizeof(MvccVersion));
+        return dataSize(txn) + recordOverhead;
+    }
+
+    boost::optional<RecordId> InMemoryMvccRecordStore::oplogStartHack(
+            OperationContext* txn,
+            const RecordId& startingPosition) const {
+
+        if (!_data->isOplog)
+            return boost::none;
+
+        InMemoryMvccRecoveryUnit* ru = InMemoryMvccRecoveryUnit::get(txn);
+        ru->snapshot(); // registers before we look at any node
+
+        RecordNode* node = _data->records.seekLE(startingPosition);
+        while (node && !node->payload().visibleVersion(ru)) {
+            node = _data->records.seekLT(node->key());
+        }
+        return node ? node->key() : RecordId();
+    }
+
+} // namespace mongo
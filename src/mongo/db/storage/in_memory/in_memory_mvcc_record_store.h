@@ -0,0 +1,197 @@
+// in_memory_mvcc_record_store.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+
+#include "mongo/db/storage/capped_callback.h"
+#include "mongo/db/storage/in_memory/concurrent_skip_list.h"
+#include "mongo/db/storage/in_memory/in_memory_mvcc.h"
+#include "mongo/db/storage/record_store.h"
+
+namespace mongo {
+
+    class InMemoryMvccRecoveryUnit;
+
+    /**
+     * A RecordStore for the inMemoryMvccExperiment engine. Records live in a ConcurrentSkipList
+     * keyed by RecordId, each holding its versions, so readers never block and writers only
+     * conflict when they touch the same record.
+     *
+     * @param cappedMaxSize - required if isCapped. limit uses dataSize() in this impl.
+     */
+    class InMemoryMvccRecordStore : public RecordStore {
+    public:
+        typedef ConcurrentSkipList<RecordId, MvccEntry> Records;
+
+        InMemoryMvccRecordStore(const StringData& ns,
+                                boost::shared_ptr<void>* dataInOut,
+                                bool isCapped = false,
+                                int64_t cappedMaxSize = -1,
+                                int64_t cappedMaxDocs = -1,
+                                CappedDocumentDeleteCallback* cappedDeleteCallback = NULL);
+
+        virtual const char* name() const;
+
+        virtual long long dataSize( OperationContext* txn ) const;
+
+        virtual long long numRecords( OperationContext* txn ) const;
+
+        virtual bool isCapped() const { return _isCapped; }
+
+        virtual void setCappedDeleteCallback(CappedDocumentDeleteCallback* cb) {
+            _cappedDeleteCallback = cb;
+        }
+
+        virtual int64_t storageSize( OperationContext* txn,
+                                     BSONObjBuilder* extraInfo = NULL,
+                                     int infoLevel = 0 ) const;
+
+        virtual RecordData dataFor( OperationContext* txn, const RecordId& loc ) const;
+
+        virtual bool findRecord( OperationContext* txn, const RecordId& loc, RecordData* rd ) const;
+
+        virtual void deleteRecord( OperationContext* txn, const RecordId& dl );
+
+        virtual StatusWith<RecordId> insertRecord( OperationContext* txn,
+                                                  const char* data,
+                                                  int len,
+                                                  bool enforceQuota );
+
+        virtual StatusWith<RecordId> insertRecord( OperationContext* txn,
+                                                  const DocWriter* doc,
+                                                  bool enforceQuota );
+
+        virtual StatusWith<RecordId> updateRecord( OperationContext* txn,
+                                                  const RecordId& oldLocation,
+                                                  const char* data,
+                                                  int len,
+                                                  bool enforceQuota,
+                                                  UpdateMoveNotifier* notifier );
+
+        virtual bool updateWithDamagesSupported() const;
+
+        virtual Status updateWithDamages( OperationContext* txn,
+                                          const RecordId& loc,
+                                          const RecordData& oldRec,
+                                          const char* damageSource,
+                                          const mutablebson::DamageVector& damages );
+
+        virtual RecordIterator* getIterator( OperationContext* txn,
+                                             const RecordId& start = RecordId(),
+                                             const CollectionScanParams::Direction& dir =
+                                             CollectionScanParams::FORWARD ) const;
+
+        virtual std::vector<RecordIterator*> getManyIterators( OperationContext* txn ) const;
+
+        virtual Status truncate( OperationContext* txn );
+
+        virtual void temp_cappedTruncateAfter( OperationContext* txn, RecordId end, bool inclusive );
+
+        virtual bool compactSupported() const { return false; }
+        virtual Status compact( OperationContext* txn,
+                                RecordStoreCompactAdaptor* adaptor,
+                                const CompactOptions* options,
+                                CompactStats* stats );
+
+        virtual Status validate( OperationContext* txn,
+                                 bool full,
+                                 bool scanData,
+                                 ValidateAdaptor* adaptor,
+                                 ValidateResults* results, BSONObjBuilder* output );
+
+        virtual void appendCustomStats( OperationContext* txn,
+                                        BSONObjBuilder* result,
+                                        double scale ) const;
+
+        virtual Status touch( OperationContext* txn, BSONObjBuilder* output ) const;
+
+        virtual Status setCustomOption( OperationContext* txn,
+                                        const BSONElement& option,
+                                        BSONObjBuilder* info = NULL );
+
+        virtual boost::optional<RecordId> oplogStartHack(OperationContext* txn,
+                                                         const RecordId& startingPosition) const;
+
+    private:
+        struct Data;
+        class Iterator;
+        class ReverseIterator;
+        class CountChange;
+        class PurgeChange;
+        class CappedInsertChange;
+        class CappedDeleteChange;
+
+        static boost::shared_ptr<Data> _getOrCreateData(boost::shared_ptr<void>* dataInOut,
+                                                        bool isOplog);
+
+        /**
+         * The version of the record at 'loc' that 'ru' reads, or NULL if it has none.
+         */
+        const MvccVersion* _visibleVersion(InMemoryMvccRecoveryUnit* ru,
+                                           const RecordId& loc) const;
+
+        void _write(OperationContext* txn,
+                    const RecordId& loc,
+                    bool tombstone,
+                    const SharedBuffer& data,
+                    int size);
+
+        void _changeCounts(OperationContext* txn, int64_t numRecordsDiff, int64_t dataSizeDiff);
+
+        StatusWith<RecordId> _insertRecord(OperationContext* txn,
+                                          const SharedBuffer& data,
+                                          int len);
+
+        void _deleteRecord(OperationContext* txn, const RecordId& loc, const MvccVersion* old);
+
+        StatusWith<RecordId> _extractAndCheckLocForOplog(const char* data, int len) const;
+
+        bool _cappedAndNeedDelete() const;
+        void _cappedDeleteAsNeeded(OperationContext* txn, const RecordId& justInserted);
+
+        /**
+         * The lowest RecordId of a capped insert that is not yet committed or rolled back, or
+         * RecordId::max() if there is none. Forward scans of a capped collection stop there, so
+         * that they never skip over a record that commits after they have moved past it.
+         */
+        RecordId _lowestUncommittedInsert() const;
+
+        const bool _isCapped;
+        const int64_t _cappedMaxSize;
+        const int64_t _cappedMaxDocs;
+        CappedDocumentDeleteCallback* _cappedDeleteCallback;
+
+        // This is the "persistent" data, shared with the engine.
+        const boost::shared_ptr<Data> _data;
+    };
+
+} // namespace mongo
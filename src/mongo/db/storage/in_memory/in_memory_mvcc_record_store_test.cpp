@@ -0,0 +1,169 @@
+// in_memory_mvcc_record_store_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/in_memory/in_memory_mvcc_record_store.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/db/storage/in_memory/in_memory_mvcc.h"
+#include "mongo/db/storage/in_memory/in_memory_mvcc_recovery_unit.h"
+#include "mongo/db/storage/record_store_test_harness.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+
+    using boost::scoped_ptr;
+
+    class InMemoryMvccHarnessHelper : public HarnessHelper {
+    public:
+        InMemoryMvccHarnessHelper() {
+        }
+
+        virtual RecordStore* newNonCappedRecordStore() {
+            return new InMemoryMvccRecordStore( "a.b", &data );
+        }
+
+        virtual RecoveryUnit* newRecoveryUnit() {
+            return new InMemoryMvccRecoveryUnit(&manager);
+        }
+
+        MvccManager manager;
+        boost::shared_ptr<void> data;
+    };
+
+    HarnessHelper* newHarnessHelper() {
+        return new InMemoryMvccHarnessHelper();
+    }
+
+namespace {
+
+    RecordId insert(OperationContext* txn, RecordStore* rs, const char* data) {
+        WriteUnitOfWork uow(txn);
+        StatusWith<RecordId> res = rs->insertRecord(txn, data, strlen(data) + 1, false);
+        ASSERT_OK(res.getStatus());
+        uow.commit();
+        return res.getValue();
+    }
+
+    TEST(InMemoryMvccRecordStore, ReadersSeeTheirSnapshot) {
+        InMemoryMvccHarnessHelper harness;
+        scoped_ptr<RecordStore> rs(harness.newNonCappedRecordStore());
+
+        scoped_ptr<OperationContext> writer(harness.newOperationContext());
+        scoped_ptr<OperationContext> reader(harness.newOperationContext());
+
+        const RecordId loc = insert(writer.get(), rs.get(), "a");
+        ASSERT_EQUALS(string("a"), rs->dataFor(reader.get(), loc).data());
+
+        {
+            WriteUnitOfWork uow(writer.get());
+            ASSERT_OK(rs->updateRecord(writer.get(), loc, "b", 2, false, NULL).getStatus());
+
+            // Uncommitted writes are only seen by their writer.
+            ASSERT_EQUALS(string("b"), rs->dataFor(writer.get(), loc).data());
+            ASSERT_EQUALS(string("a"), rs->dataFor(reader.get(), loc).data());
+            uow.commit();
+        }
+
+        // The reader keeps its snapshot until it is done with it.
+        ASSERT_EQUALS(string("a"), rs->dataFor(reader.get(), loc).data());
+        reader->recoveryUnit()->commitAndRestart();
+        ASSERT_EQUALS(string("b"), rs->dataFor(reader.get(), loc).data());
+    }
+
+    TEST(InMemoryMvccRecordStore, ConcurrentUpdatesConflict) {
+        InMemoryMvccHarnessHelper harness;
+        scoped_ptr<RecordStore> rs(harness.newNonCappedRecordStore());
+
+        scoped_ptr<OperationContext> first(harness.newOperationContext());
+        scoped_ptr<OperationContext> second(harness.newOperationContext());
+
+        const RecordId loc = insert(first.get(), rs.get(), "a");
+
+        WriteUnitOfWork uow1(first.get());
+        ASSERT_OK(rs->updateRecord(first.get(), loc, "b", 2, false, NULL).getStatus());
+
+        {
+            WriteUnitOfWork uow2(second.get());
+            ASSERT_THROWS(rs->updateRecord(second.get(), loc, "c", 2, false, NULL),
+                          WriteConflictException);
+        }
+
+        uow1.commit();
+        ASSERT_EQUALS(string("b"), rs->dataFor(second.get(), loc).data());
+    }
+
+    TEST(InMemoryMvccRecordStore, UpdateOfStaleSnapshotConflicts) {
+        InMemoryMvccHarnessHelper harness;
+        scoped_ptr<RecordStore> rs(harness.newNonCappedRecordStore());
+
+        scoped_ptr<OperationContext> first(harness.newOperationContext());
+        scoped_ptr<OperationContext> second(harness.newOperationContext());
+
+        const RecordId loc = insert(first.get(), rs.get(), "a");
+        ASSERT_EQUALS(string("a"), rs->dataFor(second.get(), loc).data());
+
+        {
+            WriteUnitOfWork uow(first.get());
+            rs->deleteRecord(first.get(), loc);
+            uow.commit();
+        }
+
+        // 'second' still reads the record, but cannot write over a newer commit.
+        ASSERT_EQUALS(string("a"), rs->dataFor(second.get(), loc).data());
+        WriteUnitOfWork uow(second.get());
+        ASSERT_THROWS(rs->updateRecord(second.get(), loc, "c", 2, false, NULL),
+                      WriteConflictException);
+    }
+
+    TEST(InMemoryMvccRecordStore, RollbackRestoresRecord) {
+        InMemoryMvccHarnessHelper harness;
+        scoped_ptr<RecordStore> rs(harness.newNonCappedRecordStore());
+        scoped_ptr<OperationContext> txn(harness.newOperationContext());
+
+        const RecordId loc = insert(txn.get(), rs.get(), "a");
+        {
+            WriteUnitOfWork uow(txn.get());
+            rs->deleteRecord(txn.get(), loc);
+            ASSERT_FALSE(rs->findRecord(txn.get(), loc, NULL));
+            ASSERT_EQUALS(0, rs->numRecords(txn.get()));
+        }
+
+        ASSERT_EQUALS(string("a"), rs->dataFor(txn.get(), loc).data());
+        ASSERT_EQUALS(1, rs->numRecords(txn.get()));
+    }
+
+} // namespace
+} // namespace mongo
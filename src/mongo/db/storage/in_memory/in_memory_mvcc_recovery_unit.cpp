@@ -0,0 +1,178 @@
+// in_memory_mvcc_recovery_unit.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/in_memory/in_memory_mvcc_recovery_unit.h"
+
+#include "mongo/db/operation_context.h"
+#include "mongo/db/storage/in_memory/in_memory_mvcc.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    InMemoryMvccRecoveryUnit::InMemoryMvccRecoveryUnit(MvccManager* manager)
+        : _manager(manager),
+          _id(manager->newTransactionId()),
+          _depth(0),
+          _registered(false),
+          _snapshot(0),
+          _epoch(0),
+          _generation(0) {
+    }
+
+    InMemoryMvccRecoveryUnit::~InMemoryMvccRecoveryUnit() {
+        invariant(_depth == 0);
+        invariant(_writes.empty());
+        if (_registered) {
+            _unregister();
+        }
+    }
+
+    InMemoryMvccRecoveryUnit* InMemoryMvccRecoveryUnit::get(OperationContext* txn) {
+        invariant(txn);
+        return dynamic_cast<InMemoryMvccRecoveryUnit*>(txn->recoveryUnit());
+    }
+
+    void InMemoryMvccRecoveryUnit::beginUnitOfWork() {
+        _depth++;
+    }
+
+    void InMemoryMvccRecoveryUnit::commitUnitOfWork() {
+        if (_depth > 1)
+            return;
+
+        _commitWrites();
+
+        for (Changes::iterator it = _changes.begin(), end = _changes.end(); it != end; ++it) {
+            (*it)->commit();
+        }
+        _changes.clear();
+    }
+
+    void InMemoryMvccRecoveryUnit::endUnitOfWork() {
+        _depth--;
+        if (_depth > 0)
+            return;
+
+        // Undo our versions before the changes, which may drop the structures holding them.
+        _rollbackWrites();
+
+        for (Changes::reverse_iterator it = _changes.rbegin(), end = _changes.rend();
+             it != end; ++it) {
+            (*it)->rollback();
+        }
+        _changes.clear();
+
+        if (_registered) {
+            _manager->refreshSnapshot(&_snapshot);
+        }
+    }
+
+    void InMemoryMvccRecoveryUnit::commitAndRestart() {
+        invariant(_depth == 0);
+        if (_registered) {
+            _unregister();
+        }
+    }
+
+    void InMemoryMvccRecoveryUnit::registerChange(Change* change) {
+        invariant(_depth > 0);
+        _changes.push_back(ChangePtr(change));
+    }
+
+    bool InMemoryMvccRecoveryUnit::sees(const MvccVersion* version) {
+        const uint64_t seq = version->commitSeq.load();
+        if (seq == 0) {
+            return version->writerId == _id;
+        }
+        return seq <= snapshot();
+    }
+
+    void InMemoryMvccRecoveryUnit::_register() {
+        invariant(!_registered);
+        _manager->registerUnit(&_snapshot, &_epoch);
+        _registered = true;
+    }
+
+    void InMemoryMvccRecoveryUnit::_unregister() {
+        invariant(_registered);
+        _registered = false;
+        _generation++;
+        _manager->unregisterUnit(_snapshot, _epoch);
+    }
+
+    void InMemoryMvccRecoveryUnit::_commitWrites() {
+        if (_writes.empty()) {
+            if (_registered) {
+                _manager->refreshSnapshot(&_snapshot);
+            }
+            return;
+        }
+
+        std::vector<MvccVersion*> toCommit;
+        for (Writes::const_iterator it = _writes.begin(); it != _writes.end(); ++it) {
+            MvccEntry* entry = it->first;
+            MvccVersion* version = it->second;
+            if (entry->_newest.load() != version) {
+                continue; // overwritten by a later write of ours
+            }
+
+            // Drop our own overwritten versions from under this one. Others may be walking
+            // past them, so they are retired rather than deleted.
+            MvccVersion* older = version->older.load();
+            while (older && older->commitSeq.load() == 0 && older->writerId == _id) {
+                MvccVersion* next = older->older.load();
+                _manager->retire(older, &MvccManager::destroyVersion);
+                older = next;
+            }
+            version->older.store(older);
+
+            toCommit.push_back(version);
+        }
+
+        _manager->commit(toCommit, &_snapshot);
+        _writes.clear();
+    }
+
+    void InMemoryMvccRecoveryUnit::_rollbackWrites() {
+        for (Writes::reverse_iterator it = _writes.rbegin(); it != _writes.rend(); ++it) {
+            MvccEntry* entry = it->first;
+            MvccVersion* version = it->second;
+
+            // Our uncommitted version blocks other writers, so it is still on top.
+            invariant(entry->_newest.load() == version);
+            entry->_newest.store(version->older.load());
+            _manager->retire(version, &MvccManager::destroyVersion);
+        }
+        _writes.clear();
+    }
+
+}
@@ -0,0 +1,130 @@
+// in_memory_mvcc_recovery_unit.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+#include <utility>
+#include <vector>
+
+#include "mongo/db/storage/recovery_unit.h"
+
+namespace mongo {
+
+    class MvccEntry;
+    class MvccManager;
+    class OperationContext;
+    struct MvccVersion;
+
+    /**
+     * A recovery unit reading a consistent snapshot of an inMemoryMvccExperiment engine.
+     *
+     * The snapshot is taken on first use and kept until commitAndRestart(), except that each
+     * outermost unit of work moves it up to the newest commit when it ends, so a unit of work
+     * sees its own committed writes afterwards.
+     */
+    class InMemoryMvccRecoveryUnit : public RecoveryUnit {
+    public:
+        explicit InMemoryMvccRecoveryUnit(MvccManager* manager);
+        virtual ~InMemoryMvccRecoveryUnit();
+
+        virtual void beginUnitOfWork();
+        virtual void commitUnitOfWork();
+        virtual void endUnitOfWork();
+
+        virtual bool awaitCommit() {
+            return true;
+        }
+
+        virtual void commitAndRestart();
+
+        virtual void registerChange(Change* change);
+
+        virtual void* writingPtr(void* data, size_t len) {
+            invariant(!"don't call writingPtr");
+        }
+
+        static InMemoryMvccRecoveryUnit* get(OperationContext* txn);
+
+        MvccManager* manager() const { return _manager; }
+
+        uint64_t id() const { return _id; }
+
+        bool inUnitOfWork() const { return _depth > 0; }
+
+        /**
+         * The newest commit this unit reads, taken on first use.
+         */
+        uint64_t snapshot() {
+            if (!_registered) {
+                _register();
+            }
+            return _snapshot;
+        }
+
+        /**
+         * Changes whenever this unit stops holding the skip list nodes it has read in place.
+         * Cursors that kept a node from an earlier generation must find their position again by
+         * key.
+         */
+        uint64_t generation() const { return _generation; }
+
+        /**
+         * Whether this unit reads 'version', given that it reads no newer one of its entry.
+         */
+        bool sees(const MvccVersion* version);
+
+    private:
+        friend class MvccEntry;
+
+        typedef boost::shared_ptr<Change> ChangePtr;
+        typedef std::vector<ChangePtr> Changes;
+        typedef std::vector<std::pair<MvccEntry*, MvccVersion*> > Writes;
+
+        void _register();
+        void _unregister();
+
+        void _commitWrites();
+        void _rollbackWrites();
+
+        MvccManager* const _manager; // not owned
+        const uint64_t _id;
+        int _depth;
+
+        bool _registered;
+        uint64_t _snapshot; // valid if _registered
+        uint64_t _epoch; // valid if _registered
+        uint64_t _generation;
+
+        Writes _writes; // uncommitted versions, in the order they were written
+        Changes _changes;
+    };
+
+}
@@ -499,8 +499,11 @@ namespace mongo {
             return RecordId();
 
         Records::const_iterator it = records.lower_bound(startingPosition);
-        if (it == records.end() || it->first > startingPosition)
+        if (it == records.end() || it->first > startingPosition) {
+            if (it == records.begin())
+                return RecordId(); // nothing <= startingPosition
             --it;
+        }
 
         return it->first;
     }
@@ -31,6 +31,7 @@
 #include "mongo/db/storage/kv/kv_collection_catalog_entry.h"
 
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/operation_context_noop.h"
 #include "mongo/db/storage/kv/kv_catalog.h"
 #include "mongo/db/storage/kv/kv_engine.h"
 
@@ -92,6 +93,20 @@ namespace mongo {
     KVCollectionCatalogEntry::~KVCollectionCatalogEntry() {
     }
 
+    RecordStore* KVCollectionCatalogEntry::_getRecordStore() const {
+        boost::mutex::scoped_lock lk( _recordStoreMutex );
+        if ( !_recordStore ) {
+            // Opened in its own recovery unit, as the caller may be in the middle of a unit of
+            // work of its own or hold no OperationContext at all.
+            OperationContextNoop opCtx( _engine->newRecoveryUnit() );
+            MetaData md = _catalog->getMetaData( &opCtx, ns().ns() );
+            _recordStore.reset( _engine->getRecordStore( &opCtx, ns().ns(), _ident,
+                                                         md.options ) );
+            invariant( _recordStore );
+        }
+        return _recordStore.get();
+    }
+
     bool KVCollectionCatalogEntry::setIndexIsMultikey(OperationContext* txn,
                                                       const StringData& indexName,
                                                       bool multikey ) {
@@ -102,6 +117,22 @@ namespace mongo {
         if ( md.indexes[offset].multikey == multikey )
             return false;
         md.indexes[offset].multikey = multikey;
+        if ( !multikey )
+            md.indexes[offset].multikeyPaths.clear();
+        _catalog->putMetaData( txn, ns().toString(), md );
+        return true;
+    }
+
+    bool KVCollectionCatalogEntry::setIndexMultikeyPaths(OperationContext* txn,
+                                                         const StringData& indexName,
+                                                         const MultikeyPaths& multikeyPaths) {
+        MetaData md = _getMetaData(txn);
+
+        int offset = md.findIndexOffset( indexName );
+        invariant( offset >= 0 );
+        if ( md.indexes[offset].multikeyPaths == multikeyPaths )
+            return false;
+        md.indexes[offset].multikeyPaths = multikeyPaths;
         _catalog->putMetaData( txn, ns().toString(), md );
         return true;
     }
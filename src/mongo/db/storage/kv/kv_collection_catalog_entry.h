@@ -30,6 +30,9 @@
 
 #pragma once
 
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include "mongo/db/catalog/collection_catalog_entry.h"
 #include "mongo/db/storage/bson_collection_catalog_entry.h"
 #include "mongo/db/storage/record_store.h"
@@ -41,6 +44,10 @@ namespace mongo {
 
     class KVCollectionCatalogEntry : public BSONCollectionCatalogEntry {
     public:
+        /**
+         * Takes ownership of 'rs'. If 'rs' is NULL, the record store is opened from the engine
+         * the first time it is asked for, so that startup does not open every collection.
+         */
         KVCollectionCatalogEntry( KVEngine* engine,
                                   KVCatalog* catalog,
                                   const StringData& ns,
@@ -55,6 +62,10 @@ namespace mongo {
                                         const StringData& indexName,
                                         bool multikey = true);
 
+        virtual bool setIndexMultikeyPaths(OperationContext* txn,
+                                           const StringData& indexName,
+                                           const MultikeyPaths& multikeyPaths);
+
         virtual void setIndexHead( OperationContext* txn,
                                    const StringData& indexName,
                                    const RecordId& newHead );
@@ -76,8 +87,8 @@ namespace mongo {
                                        const StringData& idxName,
                                        long long newExpireSeconds );
 
-        RecordStore* getRecordStore() { return _recordStore.get(); }
-        const RecordStore* getRecordStore() const { return _recordStore.get(); }
+        RecordStore* getRecordStore() { return _getRecordStore(); }
+        const RecordStore* getRecordStore() const { return _getRecordStore(); }
 
     protected:
         virtual MetaData _getMetaData( OperationContext* txn ) const;
@@ -86,10 +97,14 @@ namespace mongo {
         class AddIndexChange;
         class RemoveIndexChange;
 
+        RecordStore* _getRecordStore() const;
+
         KVEngine* _engine; // not owned
         KVCatalog* _catalog; // not owned
         std::string _ident;
-        boost::scoped_ptr<RecordStore> _recordStore; // owned
+
+        mutable boost::mutex _recordStoreMutex; // protects opening _recordStore
+        mutable boost::scoped_ptr<RecordStore> _recordStore; // owned, NULL until opened
     };
 
 }
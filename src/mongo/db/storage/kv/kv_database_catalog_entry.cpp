@@ -231,19 +231,16 @@ namespace mongo {
     void KVDatabaseCatalogEntry::initCollection( OperationContext* opCtx,
                                                  const std::string& ns ) {
         string ident = _engine->getCatalog()->getCollectionIdent( ns );
-        BSONCollectionCatalogEntry::MetaData md = _engine->getCatalog()->getMetaData( opCtx, ns );
-
-        RecordStore* rs = _engine->getEngine()->getRecordStore( opCtx, ns, ident, md.options );
-        invariant( rs );
 
         invariant(!_collections.count(ns));
 
-        // No change registration since this is only for committed collections
+        // No change registration since this is only for committed collections. The record store
+        // is opened on first use rather than here, so startup does not pay for every collection.
         _collections[ns] = new KVCollectionCatalogEntry( _engine->getEngine(),
                                                          _engine->getCatalog(),
                                                          ns,
                                                          ident,
-                                                         rs );
+                                                         NULL );
     }
 
     Status KVDatabaseCatalogEntry::renameCollection( OperationContext* txn,
@@ -36,6 +36,7 @@
 #include "mongo/base/status.h"
 #include "mongo/base/string_data.h"
 #include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/storage/storage_stats.h"
 
 namespace mongo {
 
@@ -97,6 +98,9 @@ namespace mongo {
 
         virtual bool isDurable() const = 0;
 
+        // optional, see StorageEngine::getThreadStorageStats
+        virtual StorageStats getThreadStorageStats() const { return StorageStats(); }
+
         /**
          * This must not change over the lifetime of the engine.
          */
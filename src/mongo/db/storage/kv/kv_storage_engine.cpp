@@ -32,7 +32,10 @@
 
 #include "mongo/db/storage/kv/kv_storage_engine.h"
 
+#include "mongo/db/concurrency/lock_state.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context_noop.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/kv/kv_database_catalog_entry.h"
 #include "mongo/db/storage/kv/kv_engine.h"
 #include "mongo/util/log.h"
@@ -41,8 +44,15 @@ namespace mongo {
 
     namespace {
         const std::string catalogInfo = "_mdb_catalog";
+
+        // How long a warm-up task waits for a lock before checking for shutdown again.
+        const unsigned kWarmUpLockTimeoutMs = 100;
     }
 
+    // Collections' record stores are opened on first use. When non-zero, this many threads
+    // also open them in the background once startup is done, so that first use is not slow.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(kvStorageEngineWarmUpThreads, int, 0);
+
     class KVStorageEngine::RemoveDBChange : public RecoveryUnit::Change {
     public:
         RemoveDBChange(KVStorageEngine* engine, const StringData& db, KVDatabaseCatalogEntry* entry)
@@ -72,6 +82,7 @@ namespace mongo {
         , _supportsDocLocking(_engine->supportsDocLocking()) {
 
         OperationContextNoop opCtx( _engine->newRecoveryUnit() );
+        std::vector<std::string> collections;
 
         if (options.forRepair && engine->hasIdent(&opCtx, catalogInfo)) {
             log() << "Repairing catalog metadata";
@@ -103,7 +114,6 @@ namespace mongo {
                                            _options.directoryForIndexes) );
             _catalog->init( &opCtx );
 
-            std::vector<std::string> collections;
             _catalog->getAllCollections( &collections );
 
             for ( size_t i = 0; i < collections.size(); i++ ) {
@@ -156,10 +166,57 @@ namespace mongo {
             }
         }
 
+        if ( kvStorageEngineWarmUpThreads > 0 && !collections.empty() ) {
+            _warmUpPool.reset( new threadpool::ThreadPool( kvStorageEngineWarmUpThreads,
+                                                           "kvWarmUp" ) );
+            for ( size_t i = 0; i < collections.size(); i++ ) {
+                _warmUpPool->schedule( &KVStorageEngine::_warmUpCollection, this,
+                                       collections[i] );
+            }
+        }
+    }
+
+    void KVStorageEngine::_warmUpCollection( const std::string& ns ) {
+        const NamespaceString nss( ns );
+        const ResourceId dbResId( RESOURCE_DATABASE, nss.db() );
+        DefaultLockerImpl locker;
+
+        // The database lock in MODE_IS keeps the collection from being dropped underneath us.
+        // Shutdown holds the global lock exclusively while it waits for these tasks, so only
+        // ever wait for locks briefly before checking whether to give up.
+        while ( true ) {
+            if ( _shuttingDown.load() )
+                return;
+            if ( locker.lockGlobal( MODE_IS, kWarmUpLockTimeoutMs ) != LOCK_OK )
+                continue;
+            if ( locker.lock( dbResId, MODE_IS, kWarmUpLockTimeoutMs ) == LOCK_OK )
+                break;
+            locker.unlockAll();
+        }
+
+        KVDatabaseCatalogEntry* db = NULL;
+        {
+            boost::mutex::scoped_lock lk( _dbsLock );
+            DBMap::const_iterator it = _dbs.find( nss.db().toString() );
+            if ( it != _dbs.end() )
+                db = it->second;
+        }
+
+        if ( db ) {
+            db->getRecordStore( ns );
+        }
+
+        locker.unlockAll();
     }
 
     void KVStorageEngine::cleanShutdown() {
 
+        if ( _warmUpPool ) {
+            _shuttingDown.store( 1 );
+            _warmUpPool->join();
+            _warmUpPool.reset( NULL );
+        }
+
         for ( DBMap::const_iterator it = _dbs.begin(); it != _dbs.end(); ++it ) {
             delete it->second;
         }
@@ -258,6 +315,10 @@ namespace mongo {
         return _engine->isDurable();
     }
 
+    StorageStats KVStorageEngine::getThreadStorageStats() const {
+        return _engine->getThreadStorageStats();
+    }
+
     Status KVStorageEngine::repairRecordStore(OperationContext* txn, const std::string& ns) {
         return _engine->repairIdent(txn, _catalog->getCollectionIdent(ns));
     }
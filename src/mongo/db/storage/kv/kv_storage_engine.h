@@ -39,6 +39,8 @@
 #include "mongo/db/storage/kv/kv_catalog.h"
 #include "mongo/db/storage/record_store.h"
 #include "mongo/db/storage/storage_engine.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/thread_pool.h"
 
 namespace mongo {
 
@@ -85,6 +87,8 @@ namespace mongo {
 
         virtual bool isDurable() const;
 
+        virtual StorageStats getThreadStorageStats() const;
+
         virtual Status repairRecordStore(OperationContext* txn, const std::string& ns);
 
         virtual void cleanShutdown();
@@ -100,6 +104,12 @@ namespace mongo {
     private:
         class RemoveDBChange;
 
+        /**
+         * Opens the record store of collection 'ns' ahead of its first use. Run on
+         * _warmUpPool; gives up once shutdown starts.
+         */
+        void _warmUpCollection( const std::string& ns );
+
         KVStorageEngineOptions _options;
 
         // This must be the first member so it is destroyed last.
@@ -113,6 +123,11 @@ namespace mongo {
         typedef std::map<std::string,KVDatabaseCatalogEntry*> DBMap;
         DBMap _dbs;
         mutable boost::mutex _dbsLock;
+
+        // Opens record stores in the background after startup; NULL unless
+        // kvStorageEngineWarmUpThreads is set.
+        boost::scoped_ptr<threadpool::ThreadPool> _warmUpPool;
+        AtomicUInt32 _shuttingDown; // Used as boolean - 0 = false, 1 = true
     };
 
 }
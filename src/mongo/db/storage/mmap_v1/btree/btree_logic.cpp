@@ -32,6 +32,7 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/btree/btree_logic.h"
 #include "mongo/db/storage/mmap_v1/btree/key.h"
 #include "mongo/db/storage/mmap_v1/diskloc.h"
@@ -42,6 +43,11 @@
 
 namespace mongo {
 
+    // When set, repacking a V1 bucket stores the prefix shared by all of its keys once and strips
+    // it from each key.  Buckets written this way can not be read by versions without support for
+    // the HasKeyPrefix bucket flag, so this is off by default.
+    MONGO_EXPORT_SERVER_PARAMETER(mmapv1BtreeKeyPrefixCompression, bool, false);
+
     // BtreeLogic::Builder algorithm
     //
     // Phase 1:
@@ -221,6 +227,27 @@ namespace mongo {
         return FullKey(bucket, i);
     }
 
+    template <class BtreeLayout>
+    const char* BtreeLogic<BtreeLayout>::FullKey::_expand(const BucketType* bucket,
+                                                          int suffixOfs) {
+        const int tdz = BtreeLayout::BucketBodySize;
+        const int prefixLen = _keyPrefixLength(bucket);
+
+        memcpy(_expanded, bucket->data + tdz - sizeof(unsigned short) - prefixLen, prefixLen);
+
+        // The suffix length is only known once the key is parsed, so copy as much as any key could
+        // need.  Everything after the suffix is still inside the bucket body.
+        const int suffixLen = std::min(BtreeLayout::KeyMax - prefixLen, tdz - suffixOfs);
+        memcpy(_expanded + prefixLen, bucket->data + suffixOfs, suffixLen);
+        return _expanded;
+    }
+
+    template <class BtreeLayout>
+    const char* BtreeLogic<BtreeLayout>::FullKey::_copyExpanded(const FullKey& other) {
+        memcpy(_expanded, other._expanded, other.data.dataSize());
+        return _expanded;
+    }
+
     // static
     template <class BtreeLayout>
     typename BtreeLogic<BtreeLayout>::KeyHeaderType&
@@ -355,6 +382,10 @@ namespace mongo {
 
         invariant(getKeyHeader(bucket, bucket->n - 1).isUsed());
 
+        // Builder buckets are never repacked, so keys are stored whole and keyDataOut can point
+        // into the bucket.
+        invariant(!getKeyHeader(bucket, bucket->n - 1).isPrefixStripped());
+
         FullKey kn = getFullKey(bucket, bucket->n - 1);
         *recordLocOut = kn.recordLoc;
         keyDataOut->assign(kn.data);
@@ -431,9 +462,9 @@ namespace mongo {
         invariant(keypos >= 0 && keypos <= bucket->n);
 
         int bytesNeeded = key.dataSize() + sizeof(KeyHeaderType);
-        if (bytesNeeded > bucket->emptySize) {
+        if (bytesNeeded > bucket->emptySize || !_keyDataFits(bucket, bytesNeeded)) {
             _pack(txn, bucket, bucketLoc, keypos);
-            if (bytesNeeded > bucket->emptySize) {
+            if (bytesNeeded > bucket->emptySize || !_keyDataFits(bucket, bytesNeeded)) {
                 return false;
             }
         }
@@ -486,6 +517,10 @@ namespace mongo {
     template <class BtreeLayout>
     int BtreeLogic<BtreeLayout>::_packedDataSize(BucketType* bucket, int refPos) {
         if (bucket->flags & Packed) {
+            // Callers size merges and balancing in whole keys.
+            if (bucket->flags & HasKeyPrefix) {
+                return _keyDataSize(bucket) + bucket->n * sizeof(KeyHeaderType);
+            }
             return BtreeLayout::BucketSize - bucket->emptySize - BucketType::HeaderSize;
         }
 
@@ -533,6 +568,17 @@ namespace mongo {
         int ofs = tdz;
         bucket->topSize = 0;
 
+        int prefixLen = _commonKeyPrefixLength(bucket, refPos);
+        if (prefixLen > 0) {
+            // Trailer: the prefix bytes followed by their length.  Any key will do as the source.
+            const unsigned short len = prefixLen;
+            ofs -= sizeof(len);
+            memcpy(temp + ofs, &len, sizeof(len));
+            ofs -= prefixLen;
+            memcpy(temp + ofs, _firstRetainedKey(bucket, refPos).data.data(), prefixLen);
+            bucket->topSize += prefixLen + sizeof(len);
+        }
+
         int i = 0;
         for (int j = 0; j < bucket->n; j++) {
             if (mayDropKey(bucket, j, refPos)) {
@@ -548,12 +594,15 @@ namespace mongo {
                 getKeyHeader(bucket, i) = getKeyHeader(bucket, j);
             }
 
-            short ofsold = getKeyHeader(bucket, i).keyDataOfs();
-            int sz = getFullKey(bucket, i).data.dataSize();
+            const FullKey kn = getFullKey(bucket, i);
+            int sz = kn.data.dataSize() - prefixLen;
             ofs -= sz;
             bucket->topSize += sz;
-            memcpy(temp + ofs, dataAt(bucket, ofsold), sz);
+            memcpy(temp + ofs, kn.data.data() + prefixLen, sz);
             getKeyHeader(bucket, i).setKeyDataOfsSavingUse(ofs);
+            if (prefixLen > 0) {
+                getKeyHeader(bucket, i).setPrefixStripped();
+            }
             ++i;
         }
 
@@ -568,10 +617,73 @@ namespace mongo {
         bucket->emptySize = tdz - dataUsed - bucket->n * sizeof(KeyHeaderType);
         int foo = bucket->emptySize;
         invariant( foo >= 0 );
+        if (prefixLen > 0) {
+            bucket->flags |= HasKeyPrefix;
+        }
+        else {
+            bucket->flags &= ~HasKeyPrefix;
+        }
         setPacked(bucket);
         assertValid(_indexName, bucket, _ordering);
     }
 
+    template <class BtreeLayout>
+    typename BtreeLogic<BtreeLayout>::FullKey
+    BtreeLogic<BtreeLayout>::_firstRetainedKey(BucketType* bucket, int refPos) {
+        for (int j = 0; j < bucket->n; j++) {
+            if (!mayDropKey(bucket, j, refPos)) {
+                return getFullKey(bucket, j);
+            }
+        }
+        invariant(false);
+        return getFullKey(bucket, 0); // just to compile
+    }
+
+    /**
+     * Returns the number of leading bytes shared by every key that a repack of 'bucket' would
+     * retain, or 0 if the bucket should be stored without a key prefix.
+     */
+    template <class BtreeLayout>
+    int BtreeLogic<BtreeLayout>::_commonKeyPrefixLength(BucketType* bucket, int refPos) {
+        if (!BtreeLayout::SupportsKeyPrefix || !mmapv1BtreeKeyPrefixCompression
+                || bucket->n < 2) {
+            return 0;
+        }
+
+        int prefixLen = -1;
+        int retained = 0;
+        const FullKey first = _firstRetainedKey(bucket, refPos);
+        for (int j = 0; j < bucket->n && prefixLen != 0; j++) {
+            if (mayDropKey(bucket, j, refPos)) {
+                continue;
+            }
+
+            const FullKey kn = getFullKey(bucket, j);
+
+            // toBson() on a bson format key points into the key data, which for a prefix stripped
+            // key is a FullKey temporary.
+            if (!kn.data.isCompactFormat()) {
+                return 0;
+            }
+
+            const int sz = kn.data.dataSize();
+            int len = 0;
+            const int limit = prefixLen == -1 ? sz : std::min(prefixLen, sz);
+            while (len < limit && kn.data.data()[len] == first.data.data()[len]) {
+                ++len;
+            }
+            prefixLen = len;
+            ++retained;
+        }
+
+        // Only worth it if the stripped bytes pay for the trailer.
+        if (retained < 2 || prefixLen * (retained - 1) <= int(sizeof(unsigned short))) {
+            return 0;
+        }
+
+        return prefixLen;
+    }
+
     template <class BtreeLayout>
     void BtreeLogic<BtreeLayout>::truncateTo(BucketType* bucket,
                                               int N,
@@ -605,7 +717,7 @@ namespace mongo {
         // When splitting a btree node, if the new key is greater than all the other keys, we should
         // not do an even split, but a 90/10 split.  see SERVER-983.  TODO I think we only want to
         // do the 90% split on the rhs node of the tree.
-        int rightSizeLimit = (bucket->topSize + sizeof(KeyHeaderType) * bucket->n)
+        int rightSizeLimit = (_keyDataSize(bucket) + sizeof(KeyHeaderType) * bucket->n)
                            / (keypos == bucket->n ? 10 : 2);
 
         for (int i = bucket->n - 1; i > -1; --i) {
@@ -627,6 +739,48 @@ namespace mongo {
         return split;
     }
 
+    template <class BtreeLayout>
+    int BtreeLogic<BtreeLayout>::_keyPrefixLength(const BucketType* bucket) {
+        invariant(bucket->flags & HasKeyPrefix);
+        const int tdz = BtreeLayout::BucketBodySize;
+        const int prefixLen =
+            *reinterpret_cast<const unsigned short*>(bucket->data + tdz - sizeof(unsigned short));
+        invariant(prefixLen <= BtreeLayout::KeyMax);
+        return prefixLen;
+    }
+
+    /**
+     * Bytes of key data in 'bucket', counting prefix stripped keys at their full size since that is
+     * what they occupy once moved to another bucket.  This is exact right after a repack, which
+     * strips every key, and an upper bound once whole keys or unused space are added.
+     */
+    template <class BtreeLayout>
+    int BtreeLogic<BtreeLayout>::_keyDataSize(const BucketType* bucket) {
+        if (!(bucket->flags & HasKeyPrefix)) {
+            return bucket->topSize;
+        }
+
+        const int prefixLen = _keyPrefixLength(bucket);
+        return bucket->topSize - prefixLen - sizeof(unsigned short) + prefixLen * bucket->n;
+    }
+
+    /**
+     * A prefix stripped bucket may hold more key bytes than fit in a bucket body, but splitting
+     * and balancing move keys out whole.  Bounding the whole size of a bucket's keys to 1.5 bodies,
+     * less room for the key that overshoots each half, keeps every half produced by splitPos() and
+     * _rebalancedSeparatorPos() within one body.
+     */
+    template <class BtreeLayout>
+    bool BtreeLogic<BtreeLayout>::_keyDataFits(const BucketType* bucket, int bytesNeeded) {
+        if (!(bucket->flags & HasKeyPrefix)) {
+            return true;
+        }
+
+        const int limit = BtreeLayout::BucketBodySize + BtreeLayout::BucketBodySize / 2
+                        - 2 * (BtreeLayout::KeyMax + sizeof(KeyHeaderType));
+        return _keyDataSize(bucket) + bucket->n * sizeof(KeyHeaderType) + bytesNeeded <= limit;
+    }
+
     template <class BtreeLayout>
     void BtreeLogic<BtreeLayout>::reserveKeysFront(BucketType* bucket, int nAdd) {
         invariant(bucket->emptySize >= int(sizeof(KeyHeaderType) * nAdd));
@@ -1499,11 +1653,11 @@ namespace mongo {
         const BucketType* r = childForPos(txn, bucket, leftIndex + 1);
 
         int KNS = sizeof(KeyHeaderType);
-        int rightSizeLimit = ( l->topSize
+        int rightSizeLimit = ( _keyDataSize(l)
                              + l->n * KNS
                              + getFullKey(bucket, leftIndex).data.dataSize()
                              + KNS
-                             + r->topSize
+                             + _keyDataSize(r)
                              + r->n * KNS ) / 2;
 
         // This constraint should be ensured by only calling this function
@@ -43,6 +43,9 @@ namespace mongo {
     class RecordStore;
     class SavedCursorRegistry;
 
+    // Whether repacked V1 buckets store their keys' common prefix once.  See HasKeyPrefix.
+    extern bool mmapv1BtreeKeyPrefixCompression;
+
     // Used for unit-testing only
     template <class BtreeLayout> class BtreeLogicTestBase;
     template <class BtreeLayout> class ArtificialTreeBuilder;
@@ -253,13 +256,26 @@ namespace mongo {
          * This object and its BSONObj 'key' will become invalid if the KeyHeaderType data that owns
          * this it is moved within the btree.  In general, a KeyWrapper should not be expected to be
          * valid after a write.
+         *
+         * If the key is stored prefix stripped, 'data' instead points at a copy of the key with the
+         * bucket's common prefix restored.
          */
         struct FullKey {
             FullKey(const BucketType* bucket, int i)
                 : header(getKeyHeader(bucket, i)),
                   prevChildBucket(header.prevChildBucket),
                   recordLoc(header.recordLoc),
-                  data(bucket->data + header.keyDataOfs()) { }
+                  data(BtreeLayout::SupportsKeyPrefix && header.isPrefixStripped()
+                       ? _expand(bucket, header.keyDataOfs())
+                       : bucket->data + header.keyDataOfs()) { }
+
+            FullKey(const FullKey& other)
+                : header(other.header),
+                  prevChildBucket(header.prevChildBucket),
+                  recordLoc(header.recordLoc),
+                  data(other.data.data() == other._expanded
+                       ? _copyExpanded(other)
+                       : other.data.data()) { }
 
             // This is actually a reference to something on-disk.
             const KeyHeaderType& header;
@@ -270,6 +286,15 @@ namespace mongo {
 
             // This is *not* memory-mapped but its members point to something on-disk.
             KeyDataType data;
+
+        private:
+            FullKey& operator=(const FullKey&);
+
+            const char* _expand(const BucketType* bucket, int suffixOfs);
+            const char* _copyExpanded(const FullKey& other);
+
+            // Only filled in for prefix stripped keys.
+            char _expanded[BtreeLayout::KeyMax];
         };
 
         //
@@ -312,6 +337,16 @@ namespace mongo {
 
         static int splitPos(BucketType* bucket, int keypos);
 
+        static int _keyPrefixLength(const BucketType* bucket);
+
+        static int _keyDataSize(const BucketType* bucket);
+
+        static bool _keyDataFits(const BucketType* bucket, int bytesNeeded);
+
+        static FullKey _firstRetainedKey(BucketType* bucket, int refPos);
+
+        static int _commonKeyPrefixLength(BucketType* bucket, int refPos);
+
         static void reserveKeysFront(BucketType* bucket, int nAdd);
 
         static void setKey(BucketType* bucket,
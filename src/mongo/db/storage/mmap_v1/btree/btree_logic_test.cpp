@@ -39,6 +39,7 @@
 #include "mongo/db/storage/mmap_v1/btree/btree_test_help.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 
 
 namespace mongo {
@@ -1353,6 +1354,64 @@ namespace mongo {
         }
     };
 
+    template<class OnDiskFormat>
+    class PackKeyPrefix : public BtreeLogicTestBase<OnDiskFormat> {
+    public:
+        void run() {
+            OperationContextNoop txn;
+            ArtificialTreeBuilder<OnDiskFormat> builder(&txn, &this->_helper);
+
+            const bool oldKeyPrefixCompression = mmapv1BtreeKeyPrefixCompression;
+            mmapv1BtreeKeyPrefixCompression = true;
+            ON_BLOCK_EXIT(restore, oldKeyPrefixCompression);
+
+            builder.makeTree("{commonprefix_a:null,commonprefix_b:null,"
+                               "commonprefix_c:null,commonprefix_d:null}");
+
+            ASSERT(this->unindex(BSON("" << "commonprefix_b")));
+
+            this->forcePackBucket(this->_helper.headManager.getHead(&txn));
+
+            typename BtreeLogicTestBase<OnDiskFormat>::BucketType* headBucket = this->head();
+            const int fullSize = this->bucketPackedDataSize(headBucket, 0);
+
+            int unused = 0;
+            this->truncateBucket(headBucket, headBucket->n, unused);
+
+            ASSERT_EQUALS(3, headBucket->n);
+            ASSERT_TRUE(headBucket->flags & Packed);
+            ASSERT_EQUALS(fullSize, this->bucketPackedDataSize(headBucket, 0));
+
+            const int storedSize = headBucket->topSize
+                                 + headBucket->n * sizeof(typename BtreeLogicTestBase<
+                                                              OnDiskFormat>::FixedWidthKeyType);
+            if (OnDiskFormat::SupportsKeyPrefix) {
+                ASSERT_TRUE(headBucket->flags & HasKeyPrefix);
+                ASSERT_LESS_THAN(storedSize, fullSize);
+            }
+            else {
+                ASSERT_FALSE(headBucket->flags & HasKeyPrefix);
+                ASSERT_EQUALS(storedSize, fullSize);
+            }
+
+            builder.checkStructure("{commonprefix_a:null,commonprefix_c:null,"
+                                     "commonprefix_d:null}");
+            this->locate(BSON("" << "commonprefix_c"), 1, true,
+                         this->_helper.headManager.getHead(&txn), 1);
+
+            // New keys are stored whole next to the prefix stripped ones.
+            ASSERT_OK(this->insert(BSON("" << "commonprefix_b"), this->_helper.dummyDiskLoc));
+            ASSERT_EQUALS(4, this->_helper.btree.fullValidate(&txn, NULL, true, false, 0));
+            builder.checkStructure("{commonprefix_a:null,commonprefix_b:null,"
+                                     "commonprefix_c:null,commonprefix_d:null}");
+        }
+
+    private:
+        static void restore(bool value) {
+            mmapv1BtreeKeyPrefixCompression = value;
+        }
+    };
+
     template<class OnDiskFormat>
     class BalanceSingleParentKeyPackParent : public BtreeLogicTestBase<OnDiskFormat> {
     public:
@@ -2275,6 +2334,7 @@ namespace mongo {
 
             add< PackEmptyBucket<OnDiskFormat> >();
             add< PackedDataSizeEmptyBucket<OnDiskFormat> >();
+            add< PackKeyPrefix<OnDiskFormat> >();
 
             add< BalanceSingleParentKeyPackParent<OnDiskFormat> >();
             add< BalanceSplitParent<OnDiskFormat> >();
@@ -67,21 +67,38 @@ namespace mongo {
         LocType recordLoc;
 
         /**
-         * Offset within current bucket of the variable width bson key for this _KeyNode.
+         * Offset within current bucket of the variable width bson key for this _KeyNode.  Offsets
+         * are always smaller than a bucket, so the high bits are free; PrefixStrippedFlag marks a
+         * key whose stored bytes omit the bucket's common key prefix (see BtreeBucketV1).
          */
         unsigned short _kdo;
 
+        enum { PrefixStrippedFlag = 0x4000 };
+
         //
         // Accessors / mutators
         //
 
         short keyDataOfs() const {
-            return static_cast<short>(_kdo);
+            return static_cast<short>(_kdo & ~PrefixStrippedFlag);
         }
 
         void setKeyDataOfs(short s) {
             _kdo = s;
             invariant(s>=0);
+            invariant(!(s & PrefixStrippedFlag));
+        }
+
+        /**
+         * True if the bytes at keyDataOfs() are only the suffix of this key, and the bucket's
+         * common key prefix must be prepended to read it.
+         */
+        bool isPrefixStripped() const {
+            return _kdo & PrefixStrippedFlag;
+        }
+
+        void setPrefixStripped() {
+            _kdo |= PrefixStrippedFlag;
         }
 
         void setKeyDataOfsSavingUse(short s) {
@@ -287,6 +304,12 @@ namespace mongo {
         std::string toString() const { return DiskLoc(*this).toString(); }
     };
 
+    /**
+     * When the HasKeyPrefix flag is set, the last bytes of the body hold a prefix shared by the
+     * bucket's prefix stripped keys: the prefix length is an unsigned short at
+     * data[BucketBodySize - 2] and the prefix bytes immediately precede it.  Both are accounted
+     * for in topSize.  Buckets without the flag are laid out exactly as before.
+     */
     struct BtreeBucketV1 {
         /** Parent bucket of this bucket, which isNull() for the root bucket. */
         DiskLoc56Bit parent;
@@ -318,7 +341,10 @@ namespace mongo {
                 == BtreeBucketV1::HeaderSize);
 
     enum Flags {
-        Packed = 1
+        Packed = 1,
+
+        // Only set on V1 buckets.  See BtreeBucketV1.
+        HasKeyPrefix = 2
     };
 
     struct BtreeLayoutV0 {
@@ -337,6 +363,9 @@ namespace mongo {
 
         static const int KeyMax = OldBucketSize / 10;
 
+        // V0 keys are stored as plain bson, which is referenced in place.
+        static const bool SupportsKeyPrefix = false;
+
         // A sentinel value sometimes used to identify a deallocated bucket.
         static const int INVALID_N_SENTINEL = -1;
 
@@ -360,6 +389,8 @@ namespace mongo {
 
         static const int KeyMax = 1024;
 
+        static const bool SupportsKeyPrefix = true;
+
         // A sentinel value sometimes used to identify a deallocated bucket.
         static const unsigned short INVALID_N_SENTINEL = 0xffff;
 
@@ -35,14 +35,96 @@
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/instance.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/mmap_v1/durable_mapped_file.h"
 #include "mongo/db/storage/mmap_v1/mmap_v1_options.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mmap.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
+    // When journaling, flush the data file chunks written during the previous syncdelay period
+    // evenly over the current one, instead of syncing every file at once.
+    MONGO_EXPORT_SERVER_PARAMETER(pacedDataFileSync, bool, true);
+
+    namespace {
+
+        // How often the paced flusher wakes up to write back its next share of chunks.
+        const int kPacedFlushStepMillis = 100;
+
+        struct DirtyChunk {
+            MongoFile* file;
+            uint64_t fileId;
+            unsigned chunk;
+        };
+
+        /**
+         * Takes the chunks of every data file written since the last call.  The returned files may
+         * be closed at any time, so they must be looked up again before use.
+         */
+        void takeDirtyChunks(std::vector<DirtyChunk>* out) {
+            LockMongoFilesShared lk;
+            const std::set<MongoFile*>& files = MongoFile::getAllFiles();
+            std::vector<unsigned> chunks;
+            for (std::set<MongoFile*>::const_iterator it = files.begin(); it != files.end(); ++it) {
+                if (!(*it)->isDurableMappedFile()) {
+                    continue;
+                }
+
+                chunks.clear();
+                ((DurableMappedFile*) *it)->takeDirtyChunks(&chunks);
+                for (size_t i = 0; i < chunks.size(); i++) {
+                    DirtyChunk dc = { *it, (*it)->getUniqueId(), chunks[i] };
+                    out->push_back(dc);
+                }
+            }
+        }
+
+        /**
+         * Writes back chunks [begin, end).  When 'syncFiles' is set also fsyncs each file these
+         * chunks belong to, which is cheap once their pages are clean and persists file metadata.
+         */
+        void flushDirtyChunks(const std::vector<DirtyChunk>& chunks,
+                              size_t begin,
+                              size_t end,
+                              bool syncFiles) {
+            LockMongoFilesShared lk;
+            const std::set<MongoFile*>& files = MongoFile::getAllFiles();
+            for (size_t i = begin; i < end; i++) {
+                const DirtyChunk& dc = chunks[i];
+                std::set<MongoFile*>::const_iterator it = files.find(dc.file);
+                if (it == files.end() || (*it)->getUniqueId() != dc.fileId) {
+                    // this was closed since the chunk was taken
+                    continue;
+                }
+
+                DurableMappedFile* mmf = (DurableMappedFile*) dc.file;
+                if (syncFiles) {
+                    if (i == begin || chunks[i - 1].file != dc.file) {
+                        mmf->flush(true);
+                    }
+                }
+#ifndef _WIN32
+                else {
+                    mmf->flushChunk(dc.chunk);
+                }
+#endif
+            }
+        }
+
+        bool usePacedFlush() {
+#ifdef _WIN32
+            return false;
+#else
+            return pacedDataFileSync && storageGlobalParams.dur;
+#endif
+        }
+
+    } // namespace
+
     DataFileSync dataFileSync;
 
     DataFileSync::DataFileSync()
@@ -74,6 +156,11 @@ namespace mongo {
                 continue;
             }
 
+            if (usePacedFlush()) {
+                _pacedFlush();
+                continue;
+            }
+
             sleepmillis((long long) std::max(0.0, (storageGlobalParams.syncdelay * 1000) - time_flushing));
 
             if ( inShutdown() ) {
@@ -94,6 +181,63 @@ namespace mongo {
         }
     }
 
+    /**
+     * Writes back, spread over one syncdelay period, the chunks written during the previous one.
+     * Once all of them are on disk everything journaled before the period started is durable in
+     * the data files, which is what the journal's pre/post flush notifications record.
+     */
+    void DataFileSync::_pacedFlush() {
+        const long long periodMillis = static_cast<long long>(storageGlobalParams.syncdelay * 1000);
+        const Date_t start = jsTime();
+
+        MongoFile::notifyPreFlush();
+        std::vector<DirtyChunk> chunks;
+        takeDirtyChunks(&chunks);
+
+        long long timeFlushing = 0;
+        size_t next = 0;
+        while (next < chunks.size()) {
+            if (inShutdown()) {
+                // shutdown flushes all files itself
+                return;
+            }
+
+            // Split what is left evenly over the steps left in this period.  If the device can not
+            // keep up the period simply runs long.
+            const long long elapsed = jsTime() - start;
+            const long long stepsLeft =
+                std::max(1LL, (periodMillis - elapsed) / kPacedFlushStepMillis);
+            const size_t n = static_cast<size_t>(
+                (chunks.size() - next + stepsLeft - 1) / stepsLeft);
+
+            Timer t;
+            flushDirtyChunks(chunks, next, next + n, false);
+            timeFlushing += t.millis();
+            next += n;
+
+            if (next < chunks.size()) {
+                sleepmillis(std::max(0, kPacedFlushStepMillis - t.millis()));
+            }
+        }
+
+        Timer t;
+        flushDirtyChunks(chunks, 0, chunks.size(), true);
+        timeFlushing += t.millis();
+        MongoFile::notifyPostFlush();
+
+        _flushed(static_cast<int>(timeFlushing));
+
+        if (logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1))) {
+            log() << "paced flush of " << chunks.size() << " chunks took " << timeFlushing
+                  << "ms over " << (jsTime() - start) << "ms" << endl;
+        }
+
+        const long long remaining = periodMillis - static_cast<long long>(jsTime() - start);
+        if (remaining > 0 && !inShutdown()) {
+            sleepmillis(remaining);
+        }
+    }
+
     BSONObj DataFileSync::generateSection(OperationContext* txn,
                                           const BSONElement& configElement) const {
         BSONObjBuilder b;
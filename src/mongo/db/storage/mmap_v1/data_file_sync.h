@@ -51,6 +51,8 @@ namespace mongo {
     private:
         void _flushed(int ms);
 
+        void _pacedFlush();
+
         long long _total_time;
         long long _flushes;
         int _last_time;
@@ -83,6 +83,7 @@
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/concurrency/lock_state.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/aligned_builder.h"
 #include "mongo/db/storage/mmap_v1/durable_mapped_file.h"
 #include "mongo/db/storage/mmap_v1/dur_commitjob.h"
@@ -124,6 +125,28 @@ namespace {
     // How frequently to reset the durability statistics
     enum { DurStatsResetIntervalMillis = 3 * 1000 };
 
+    // Once this many getLastError j:true requests are waiting, the flush thread commits right away
+    // instead of coalescing them until the end of the commit interval. Requests which arrive while
+    // a commit is in progress are still grouped into the next one.
+    MONGO_EXPORT_SERVER_PARAMETER(journalGroupCommitWaiters, int, 1);
+
+    // Same as above, for the number of bytes written since the last commit
+    MONGO_EXPORT_SERVER_PARAMETER(journalGroupCommitBytes, int, UncommittedBytesLimit / 2);
+
+    /**
+     * Returns whether enough is waiting to be committed that the flush thread should not wait
+     * for the rest of the commit interval.
+     */
+    bool groupCommitThresholdReached() {
+        const int waiters = journalGroupCommitWaiters;
+        if (waiters > 0 && commitNotify.nWaiting() >= static_cast<unsigned>(waiters)) {
+            return true;
+        }
+
+        const int bytes = journalGroupCommitBytes;
+        return bytes > 0 && commitJob.bytes() >= static_cast<size_t>(bytes);
+    }
+
 
     /**
      * MMAP V1 durability server status section.
@@ -302,6 +325,14 @@ namespace {
     }
 
     bool DurableImpl::awaitCommit() {
+        // Counting this request as waiting already, so that a single waiter is enough to reach the
+        // default threshold. If this notification is missed, because the flush thread is not
+        // waiting yet, it checks the thresholds itself before it starts to wait.
+        const int waiters = journalGroupCommitWaiters;
+        if (waiters > 0 && commitNotify.nWaiting() + 1 >= static_cast<unsigned>(waiters)) {
+            flushRequested.notify_one();
+        }
+
         commitNotify.awaitBeyondNow();
         return true;
     }
@@ -317,7 +348,14 @@ namespace {
     }
 
     bool DurableImpl::commitIfNeeded() {
-        if (MONGO_likely(commitJob.bytes() < UncommittedBytesLimit)) {
+        const size_t bytes = commitJob.bytes();
+        if (MONGO_likely(bytes < UncommittedBytesLimit)) {
+            const int groupCommitBytes = journalGroupCommitBytes;
+            if (groupCommitBytes > 0 && bytes >= static_cast<size_t>(groupCommitBytes)) {
+                // Start committing early, but there is no need to stall the writer
+                flushRequested.notify_one();
+            }
+
             return false;
         }
 
@@ -592,6 +630,13 @@ namespace {
                 boost::mutex::scoped_lock lock(flushMutex);
 
                 for (unsigned i = 0; i <= 2; i++) {
+                    if (groupCommitThresholdReached()) {
+                        // Enough getLastError j:true requests are pending or the number of
+                        // written bytes is growing. Checked before waiting as well, because the
+                        // notification could have been sent while the previous commit was running.
+                        break;
+                    }
+
                     if (flushRequested.timed_wait(lock, Milliseconds(oneThird))) {
                         // Someone forced a flush
                         break;
@@ -601,11 +646,6 @@ namespace {
                         // One or more getLastError j:true is pending
                         break;
                     }
-
-                    if (commitJob.bytes() > UncommittedBytesLimit / 2) {
-                        // The number of written bytes is growing
-                        break;
-                    }
                 }
 
                 // The commit logic itself
@@ -40,6 +40,7 @@
 
 #include "mongo/base/init.h"
 #include "mongo/db/client.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/aligned_builder.h"
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
 #include "mongo/db/storage/mmap_v1/dur_journalimpl.h"
@@ -83,6 +84,18 @@ namespace mongo {
         unsigned long long DataLimitPerJournalFile = (sizeof(void*)==4) ? 256 * 1024 * 1024 : 1 * 1024 * 1024 * 1024;
 #endif
 
+        // Commit sections larger than this are compressed by several threads, each of which
+        // gets at least this much of the section to compress.
+        const size_t MinBytesPerCompressionThread = 1024 * 1024;
+
+        // Maximum number of threads compressing a commit section, including the durability thread
+        MONGO_EXPORT_SERVER_PARAMETER(journalCompressionThreads, int, 4);
+
+        // Sections of a striped journal are split so that each stripe gets at least this much of
+        // the section.  Recovery computes the same split (see JStripeLayout), so changing this
+        // would make existing striped journals unreadable.
+        const unsigned MinBytesPerJournalStripe = 1024 * 1024;
+
         MONGO_INITIALIZER(InitializeJournalingParams)(InitializerContext* context) {
             if (mmapv1GlobalOptions.smallfiles == true) {
                 verify(dur::DataLimitPerJournalFile >= 128 * 1024 * 1024);
@@ -176,11 +189,28 @@ namespace mongo {
                 fileId = t&0xffffffff;
                 fileId |= static_cast<unsigned long long>( getMySecureRandomNumber() ) << 32;
             }
+            stripeCount = 0;
+            stripeIndex = 0;
             memset(reserved3, 0, sizeof(reserved3));
             txt2[0] = txt2[1] = '\n';
             n1 = n2 = n3 = n4 = '\n';
         }
 
+        JStripeLayout::JStripeLayout(unsigned sectionLenWithPadding, unsigned stripeCount) {
+            dassert( sectionLenWithPadding % Alignment == 0 );
+            unsigned n = sectionLenWithPadding / MinBytesPerJournalStripe;
+            if (n > stripeCount) {
+                n = stripeCount;
+            }
+            if (n < 1) {
+                n = 1;
+            }
+
+            chunkLen = ((sectionLenWithPadding + n - 1) / n + Alignment - 1) & (~(Alignment - 1));
+            numChunks = (sectionLenWithPadding + chunkLen - 1) / chunkLen;
+            dassert( numChunks <= n );
+        }
+
         Journal j;
 
         const unsigned long long LsnShutdownSentinel = ~((unsigned long long)0);
@@ -202,6 +232,14 @@ namespace mongo {
             return p;
         }
 
+        boost::filesystem::path Journal::getStripeFilePathFor(unsigned stripe,
+                                                              int filenumber) const {
+            verify(stripe >= 1 && stripe <= stripeDirs.size());
+            boost::filesystem::path p(stripeDirs[stripe - 1]);
+            p /= string(str::stream() << "j._" << filenumber);
+            return p;
+        }
+
         /** never throws
             @param anyFiles by default we only look at j._* files. If anyFiles is true, return true
                    if there are any files in the journal directory. acquirePathLock() uses this to
@@ -246,6 +284,21 @@ namespace mongo {
                         }
                     }
                 }
+                // the stripe directories only ever hold j._ files, which are never preallocated
+                for (unsigned s = 0; s < j.stripeDirs.size(); s++) {
+                    const boost::filesystem::path stripeDir(j.stripeDirs[s]);
+                    if (!boost::filesystem::exists(stripeDir))
+                        continue;
+                    for ( boost::filesystem::directory_iterator i( stripeDir );
+                            i != boost::filesystem::directory_iterator();
+                            ++i ) {
+                        string fileName = boost::filesystem::path(*i).leaf().string();
+                        if( str::startsWith(fileName, "j._") ) {
+                            boost::filesystem::remove(*i);
+                        }
+                    }
+                    flushMyDirectory(stripeDir / "file");
+                }
                 try {
                     boost::filesystem::remove(lsnPath());
                 }
@@ -506,6 +559,21 @@ namespace mongo {
                     throw;
                 }
             }
+
+            j.stripeDirs = mmapv1GlobalOptions.journalStripeDirs;
+            for (unsigned i = 0; i < j.stripeDirs.size(); i++) {
+                log() << "journal stripe " << i + 1 << " dir=" << j.stripeDirs[i] << endl;
+                if( !boost::filesystem::exists(j.stripeDirs[i]) ) {
+                    try {
+                        boost::filesystem::create_directory(j.stripeDirs[i]);
+                    }
+                    catch(std::exception& e) {
+                        log() << "error creating directory " << j.stripeDirs[i] << ' '
+                              << e.what() << endl;
+                        throw;
+                    }
+                }
+            }
         }
 
         void Journal::_open() {
@@ -535,12 +603,39 @@ namespace mongo {
                 }
             }
 
+            const int fileNumber = _nextFileNumber;
             _curLogFile = new LogFile(fname.string());
             _nextFileNumber++;
             {
                 JHeader h(fname.string());
                 _curFileId = h.fileId;
                 verify(_curFileId);
+
+                if (!stripeDirs.empty()) {
+                    h._version = JHeader::StripedVersion;
+                    h.stripeCount = stripeCount();
+
+                    // The stripe files get their headers first: once the primary file has a
+                    // header, recovery may need any of them.
+                    for (unsigned i = 1; i < stripeCount(); i++) {
+                        boost::filesystem::path sname = getStripeFilePathFor(i, fileNumber);
+                        _stripeLogFiles.push_back(new LogFile(sname.string()));
+
+                        JHeader sh(sname.string());
+                        sh._version = JHeader::StripedVersion;
+                        sh.fileId = _curFileId;
+                        sh.stripeCount = stripeCount();
+                        sh.stripeIndex = i;
+                        AlignedBuilder b(8192);
+                        b.appendStruct(sh);
+                        _stripeLogFiles.back()->synchronousAppend(b.buf(), b.len());
+                    }
+
+                    if (!_stripeWriters) {
+                        _stripeWriters.reset(new ThreadPool(stripeDirs.size(), "journal stripe "));
+                    }
+                }
+
                 AlignedBuilder b(8192);
                 b.appendStruct(h);
                 _curLogFile->synchronousAppend(b.buf(), b.len());
@@ -658,6 +753,11 @@ namespace mongo {
             JFile jf;
             jf.filename = _curLogFile->_name;
             jf.lastEventTimeMs = Listener::getElapsedTimeMillis();
+            for (unsigned i = 0; i < _stripeLogFiles.size(); i++) {
+                jf.stripeFilenames.push_back(_stripeLogFiles[i]->_name);
+                delete _stripeLogFiles[i]; // close
+            }
+            _stripeLogFiles.clear();
             _oldJournalFiles.push_back(jf);
 
             delete _curLogFile; // close
@@ -677,6 +777,15 @@ namespace mongo {
                     boost::filesystem::path p( f.filename );
                     log() << "old journal file will be removed: " << f.filename << endl;
                     removeOldJournalFile(p);
+                    for (unsigned i = 0; i < f.stripeFilenames.size(); i++) {
+                        try {
+                            boost::filesystem::remove(f.stripeFilenames[i]);
+                        }
+                        catch (const std::exception& e) {
+                            log() << "warning exception removing " << f.stripeFilenames[i]
+                                  << ": " << e.what() << endl;
+                        }
+                    }
                 }
                 else {
                     break;
@@ -700,6 +809,9 @@ namespace mongo {
 
             if( _curLogFile ) {
                 _curLogFile->truncate();
+                for (unsigned i = 0; i < _stripeLogFiles.size(); i++) {
+                    _stripeLogFiles[i]->truncate();
+                }
                 closeCurrentJournalFile();
                 removeUnneededJournalFiles();
             }
@@ -723,6 +835,47 @@ namespace mongo {
             @param uncompressed - a buffer that will be written to the journal after compression
             will not return until on disk
         */
+        /** appends one chunk of a striped section.  runs on a stripe writer thread. */
+        static void appendStripeChunk(LogFile* logFile, const char* buf, unsigned len,
+                                      Status* result) {
+            try {
+                logFile->synchronousAppend(buf, len);
+            }
+            catch (const DBException& e) {
+                *result = e.toStatus();
+            }
+            catch (const std::exception& e) {
+                *result = Status(ErrorCodes::InternalError, e.what());
+            }
+        }
+
+        /** appends the padded section [buf, buf+len) to the current journal file, split across the
+            stripe directories as described by JStripeLayout.  the chunks are written concurrently
+            and this does not return until all of them are on disk.
+            call from within _curLogFileMutex
+        */
+        void Journal::_appendStriped(const char* buf, unsigned len) {
+            const JStripeLayout layout(len, stripeCount());
+            verify( layout.numChunks <= _stripeLogFiles.size() + 1 );
+
+            vector<Status> results(layout.numChunks, Status::OK());
+            for (unsigned i = 1; i < layout.numChunks; i++) {
+                _stripeWriters->schedule(&appendStripeChunk,
+                                         _stripeLogFiles[i - 1],
+                                         buf + layout.chunkOffset(i),
+                                         layout.chunkLenFor(i, len),
+                                         &results[i]);
+            }
+            appendStripeChunk(_curLogFile, buf, layout.chunkLenFor(0, len), &results[0]);
+            if (layout.numChunks > 1) {
+                _stripeWriters->join();
+            }
+
+            for (unsigned i = 0; i < results.size(); i++) {
+                uassertStatusOK(results[i]);
+            }
+        }
+
         void WRITETOJOURNAL(const JSectHeader& h, const AlignedBuilder& uncompressed) {
             Timer t;
             j.journal(h, uncompressed);
@@ -745,7 +898,19 @@ namespace mongo {
             }
 
             size_t compressedLength = 0;
-            rawCompress(uncompressed.buf(), uncompressed.len(), b.cur(), &compressedLength);
+            {
+                const int threads = journalCompressionThreads;
+                size_t numThreads = uncompressed.len() / MinBytesPerCompressionThread;
+                if (threads < 1) {
+                    numThreads = 1;
+                }
+                else if (numThreads > static_cast<size_t>(threads)) {
+                    numThreads = threads;
+                }
+
+                rawCompressParallel(uncompressed.buf(), uncompressed.len(), b.cur(),
+                                    &compressedLength, numThreads);
+            }
             verify( compressedLength < 0xffffffff );
             verify( compressedLength < max );
             b.skip(compressedLength);
@@ -780,7 +945,12 @@ namespace mongo {
                 _written += w;
                 verify( w <= L );
                 stats.curr()->_journaledBytes += L;
-                _curLogFile->synchronousAppend((const void *) b.buf(), L);
+                if (_stripeLogFiles.empty()) {
+                    _curLogFile->synchronousAppend((const void *) b.buf(), L);
+                }
+                else {
+                    _appendStriped(b.buf(), L);
+                }
                 _rotate();
             }
             catch(std::exception& e) {
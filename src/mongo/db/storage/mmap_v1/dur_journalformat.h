@@ -53,10 +53,13 @@ namespace mongo {
 
             // x4142 is asci--readable if you look at the file with head/less -- thus the starting values were near
             // that.  simply incrementing the version # is safe on a fwd basis.
+            // StripedVersion is written instead of CurrentVersion when the journal is striped
+            // across several directories (--journalStripeDirs) so that older versions refuse to
+            // recover a journal whose sections they can't reassemble.
 #if defined(_NOCOMPRESS)
-            enum { CurrentVersion = 0x4148 };
+            enum { CurrentVersion = 0x4148, StripedVersion = 0x4158 };
 #else
-            enum { CurrentVersion = 0x4149 };
+            enum { CurrentVersion = 0x4149, StripedVersion = 0x4159 };
 #endif
             unsigned short _version;
 
@@ -69,10 +72,18 @@ namespace mongo {
 
             unsigned long long fileId; // unique identifier that will be in each JSectHeader. important as we recycle prealloced files
 
-            char reserved3[8026]; // 8KB total for the file header
+            // only meaningful in a striped journal.  the j._<n> files with the same n in each
+            // stripe directory form one journal file, and all carry the same fileId.
+            unsigned char stripeCount; // number of journal directories, including the primary
+            unsigned char stripeIndex; // 0 for the file in the primary journal directory
+
+            char reserved3[8024]; // 8KB total for the file header
             char txt2[2];         // "\n\n" at the end
 
-            bool versionOk() const { return _version == CurrentVersion; }
+            bool versionOk() const {
+                return _version == CurrentVersion || _version == StripedVersion;
+            }
+            bool striped() const { return _version == StripedVersion; }
             bool valid() const { return magic[0] == 'j' && txt2[1] == '\n' && fileId; }
         };
 
@@ -99,6 +110,28 @@ namespace mongo {
             }
         };
 
+        /** How a section of a striped journal is split up.  The section, padded to the Alignment,
+            is cut into numChunks consecutive chunks of chunkLen bytes (the last may be shorter).
+            Chunk i is appended to the journal file of stripe i, the primary directory being
+            stripe 0, so the JSectHeader is always in the primary file.  Sections too small to be
+            worth splitting are a single chunk and stay entirely in the primary file.  The layout
+            depends only on the section length and the stripe count, so recovery can compute it
+            from the JSectHeader and consume the stripe files in step with the primary.
+        */
+        struct JStripeLayout {
+            JStripeLayout(unsigned sectionLenWithPadding, unsigned stripeCount);
+
+            unsigned chunkLen;  // a multiple of Alignment
+            unsigned numChunks; // <= stripeCount
+
+            unsigned chunkOffset(unsigned i) const { return i * chunkLen; }
+            unsigned chunkLenFor(unsigned i, unsigned sectionLenWithPadding) const {
+                const unsigned ofs = chunkOffset(i);
+                return sectionLenWithPadding - ofs < chunkLen ? sectionLenWithPadding - ofs
+                                                              : chunkLen;
+            }
+        };
+
         /** an individual write operation within a group commit section.  Either the entire section should
             be applied, or nothing.  (We check the md5 for the whole section before doing anything on recovery.)
         */
@@ -30,7 +30,11 @@
 
 #pragma once
 
+#include <boost/scoped_ptr.hpp>
+#include <vector>
+
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/logfile.h"
 
 namespace mongo {
@@ -41,6 +45,10 @@ namespace mongo {
         public:
             std::string dir; // set by journalMakeDir() during initialization
 
+            // additional directories the journal is striped across (--journalStripeDirs).
+            // stripe i is stripeDirs[i-1], stripe 0 being dir.  set by journalMakeDir().
+            std::vector<std::string> stripeDirs;
+
             Journal();
 
             /** call during startup by journalMakeDir() */
@@ -59,6 +67,12 @@ namespace mongo {
 
             boost::filesystem::path getFilePathFor(int filenumber) const;
 
+            /** @param stripe 1 or more; stripe 0 is the file from getFilePathFor() */
+            boost::filesystem::path getStripeFilePathFor(unsigned stripe, int filenumber) const;
+
+            /** number of directories the journal is written to, including the primary */
+            unsigned stripeCount() const { return stripeDirs.size() + 1; }
+
             unsigned long long lastFlushTime() const { return _lastFlushTime; }
             void cleanup(bool log); // closes and removes journal files
 
@@ -80,6 +94,7 @@ namespace mongo {
             void _rotate();
 
             void _open();
+            void _appendStriped(const char* buf, unsigned len);
             void closeCurrentJournalFile();
             void removeUnneededJournalFiles();
 
@@ -91,8 +106,15 @@ namespace mongo {
             LogFile *_curLogFile; // use _curLogFileMutex
             unsigned long long _curFileId; // current file id see JHeader::fileId
 
+            // the current journal file in each of stripeDirs, use _curLogFileMutex
+            std::vector<LogFile*> _stripeLogFiles;
+
+            // writes the chunks of a striped section that don't go to the primary directory
+            boost::scoped_ptr<ThreadPool> _stripeWriters;
+
             struct JFile {
                 std::string filename;
+                std::vector<std::string> stripeFilenames;
                 unsigned long long lastEventTimeMs;
             };
 
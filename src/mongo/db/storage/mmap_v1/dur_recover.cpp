@@ -42,11 +42,14 @@
 #include <iostream>
 #include <sys/stat.h>
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/storage/mmap_v1/dur_commitjob.h"
 #include "mongo/db/storage/mmap_v1/dur_journal.h"
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
+#include "mongo/db/storage/mmap_v1/dur_journalimpl.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
 #include "mongo/db/storage/mmap_v1/durop.h"
 #include "mongo/db/storage/mmap_v1/durable_mapped_file.h"
@@ -59,6 +62,7 @@
 #include "mongo/util/hex.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/startup_test.h"
 
 namespace mongo {
@@ -74,6 +78,68 @@ namespace mongo {
 
     namespace dur {
 
+        // Number of threads replaying journaled writes at startup; 0 means one per core.
+        MONGO_EXPORT_STARTUP_SERVER_PARAMETER(journalReplayThreads, int, 0);
+
+        // Runs of basic writes shorter than this are replayed on the recovery thread.
+        static const size_t MinParallelReplayWrites = 64;
+
+        extern Journal j;
+
+        /** The part of a striped journal file that lives in one of the additional stripe
+            directories.  Its chunks are read in step with the sections of the primary file.  It is
+            only mapped once a section actually has a chunk in it, as a journal file whose sections
+            were all small has nothing past the header.
+        */
+        class JournalStripeFile : boost::noncopyable {
+        public:
+            JournalStripeFile(const boost::filesystem::path& path,
+                              unsigned long long fileId,
+                              unsigned stripeIndex)
+                : _path(path), _fileId(fileId), _stripeIndex(stripeIndex) { }
+
+            /** @return the next len bytes of this stripe.
+                throws BufReader::eof if the stripe ends early, as it does after a torn write.
+            */
+            const char* nextChunk(unsigned len) {
+                if (!_reader) {
+                    _open();
+                }
+                return static_cast<const char*>(_reader->skip(len));
+            }
+
+        private:
+            void _open() {
+                uassert(28642,
+                        str::stream() << "journal stripe file " << _path.string()
+                                      << " is missing; recovery must use the same "
+                                      << "--journalStripeDirs the journal was written with",
+                        boost::filesystem::exists(_path));
+
+                void* p = _file.mapWithOptions(_path.string().c_str(),
+                                               MongoFile::READONLY | MongoFile::SEQUENTIAL);
+                massert(28643, str::stream() << "recover error couldn't open " << _path.string(),
+                        p);
+                _reader.reset(new BufReader(p, static_cast<unsigned>(_file.length())));
+
+                JHeader h;
+                _reader->read(h);
+                uassert(28644,
+                        str::stream() << "journal stripe file " << _path.string()
+                                      << " doesn't belong to this journal; recovery must use "
+                                      << "the same --journalStripeDirs, in the same order, "
+                                      << "the journal was written with",
+                        h.valid() && h.striped() && h.fileId == _fileId
+                            && h.stripeIndex == _stripeIndex);
+            }
+
+            const boost::filesystem::path _path;
+            const unsigned long long _fileId;
+            const unsigned _stripeIndex;
+            MemoryMappedFile _file;
+            boost::scoped_ptr<BufReader> _reader;
+        };
+
         struct ParsedJournalEntry { /*copyable*/
             ParsedJournalEntry() : e(0) { }
 
@@ -297,6 +363,11 @@ namespace mongo {
                 void* dest = (char*)mmf->view_write() + entry.e->ofs;
                 memcpy(dest, entry.e->srcData(), entry.e->len);
                 stats.curr()->_writeToDataFilesBytes += entry.e->len;
+
+                if (!_recovering) {
+                    // Recovery flushes everything once it is done.
+                    mmf->noteWritten(entry.e->ofs, entry.e->len);
+                }
             }
             else {
                 massert(13622, "Trying to write past end of file in WRITETODATAFILES", _recovering);
@@ -363,6 +434,47 @@ namespace mongo {
             return mmf;
         }
 
+        /** replays the basic writes of one data file in journal order. runs on a replay thread */
+        static void applyWritesToFile(DurableMappedFile* mmf,
+                                      const vector<const JEntry*>* writes,
+                                      long long* bytesWritten) {
+            char* view = static_cast<char*>(mmf->view_write());
+            for (vector<const JEntry*>::const_iterator i = writes->begin(); i != writes->end(); ++i) {
+                const JEntry* e = *i;
+                // writes past the end of the file are skipped when recovering, see write()
+                if ((e->ofs + e->len) <= mmf->length()) {
+                    memcpy(view + e->ofs, e->srcData(), e->len);
+                    *bytesWritten += e->len;
+                }
+            }
+        }
+
+        /** Replays the basic writes [begin, end), one replay pool task per data file.  Writes to
+            different files are independent, and each file's writes keep their journal order.
+        */
+        void RecoveryJob::applyWritesInParallel(vector<ParsedJournalEntry>::const_iterator begin,
+                                                vector<ParsedJournalEntry>::const_iterator end) {
+            // Files are resolved (and opened if need be) here since that isn't threadsafe.
+            typedef map<DurableMappedFile*, vector<const JEntry*> > WritesByFile;
+            WritesByFile writesByFile;
+            Last last;
+            for (vector<ParsedJournalEntry>::const_iterator i = begin; i != end; ++i) {
+                writesByFile[last.newEntry(*i, *this)].push_back(i->e);
+            }
+
+            vector<long long> bytesWritten(writesByFile.size(), 0);
+            size_t n = 0;
+            for (WritesByFile::const_iterator i = writesByFile.begin(); i != writesByFile.end(); ++i) {
+                verify(i->first->view_write());
+                _replayPool->schedule(&applyWritesToFile, i->first, &i->second, &bytesWritten[n++]);
+            }
+            _replayPool->join();
+
+            for (size_t i = 0; i < bytesWritten.size(); i++) {
+                stats.curr()->_writeToDataFilesBytes += bytesWritten[i];
+            }
+        }
+
         void RecoveryJob::applyEntries(const vector<ParsedJournalEntry> &entries) {
             bool apply = (mmapv1GlobalOptions.journalOptions &
                           MMAPV1Options::JournalScanOnly) == 0;
@@ -372,8 +484,25 @@ namespace mongo {
                 log() << "BEGIN section" << endl;
 
             Last last;
-            for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
+            vector<ParsedJournalEntry>::const_iterator i = entries.begin();
+            while (i != entries.end()) {
+                if (apply && !dump && _replayPool && i->e) {
+                    // DurOps such as file creation or dropping a database order the basic writes
+                    // around them, so only runs of basic writes between them are split up.
+                    vector<ParsedJournalEntry>::const_iterator runEnd = i;
+                    while (runEnd != entries.end() && runEnd->e) {
+                        ++runEnd;
+                    }
+
+                    if (static_cast<size_t>(runEnd - i) >= MinParallelReplayWrites) {
+                        applyWritesInParallel(i, runEnd);
+                        i = runEnd;
+                        continue;
+                    }
+                }
+
                 applyEntry(last, *i, apply, dump);
+                ++i;
             }
 
             if( dump )
@@ -439,15 +568,45 @@ namespace mongo {
             applyEntries(entries);
         }
 
+        /** reads the chunks of a striped section (see JStripeLayout) from the primary file and the
+            stripe files, and copies them together.  a chunk missing because of a torn write throws
+            BufReader::eof; chunks that are present but don't belong together fail the section
+            checksum.
+            @return the section, valid until the next call
+        */
+        const char* RecoveryJob::reassembleStripedSection(
+                unsigned sectionLenWithPadding,
+                BufReader& primary,
+                const std::vector<JournalStripeFile*>& stripes) {
+            const JStripeLayout layout(sectionLenWithPadding, stripes.size() + 1);
+            if (layout.numChunks == 1) {
+                return static_cast<const char*>(primary.skip(sectionLenWithPadding));
+            }
+
+            _stripedSection.resize(sectionLenWithPadding);
+            for (unsigned i = 0; i < layout.numChunks; i++) {
+                const unsigned chunkLen = layout.chunkLenFor(i, sectionLenWithPadding);
+                const char* chunk = (i == 0)
+                                  ? static_cast<const char*>(primary.skip(chunkLen))
+                                  : stripes[i - 1]->nextChunk(chunkLen);
+                memcpy(&_stripedSection[layout.chunkOffset(i)], chunk, chunkLen);
+            }
+            return &_stripedSection[0];
+        }
+
         /** apply a specific journal file, that is already mmap'd
             @param p start of the memory mapped file
             @return true if this is detected to be the last file (ends abruptly)
         */
-        bool RecoveryJob::processFileBuffer(const void *p, unsigned len) {
+        bool RecoveryJob::processFileBuffer(const void *p, unsigned len,
+                                            const boost::filesystem::path& journalfile) {
             try {
                 unsigned long long fileId;
                 BufReader br(p,len);
 
+                // if the journal is striped, stripes[i-1] is stripe i of this file
+                OwnedPointerVector<JournalStripeFile> stripes;
+
                 {
                     // read file header
                     JHeader h;
@@ -474,6 +633,24 @@ namespace mongo {
                         MMAPV1Options::JournalDumpJournal) {
                         log() << "JHeader::fileId=" << fileId << endl;
                     }
+
+                    if (h.striped()) {
+                        uassert(28645,
+                                str::stream() << "journal file " << journalfile.string()
+                                              << " is striped across " << (int) h.stripeCount
+                                              << " directories but " << j.stripeCount()
+                                              << " are configured; recovery must use the same "
+                                              << "--journalStripeDirs the journal was written "
+                                              << "with",
+                                h.stripeCount == j.stripeCount());
+                        for (unsigned i = 1; i < h.stripeCount; i++) {
+                            stripes.push_back(new JournalStripeFile(
+                                    boost::filesystem::path(j.stripeDirs[i - 1])
+                                        / journalfile.filename(),
+                                    fileId,
+                                    i));
+                        }
+                    }
                 }
 
                 // read sections
@@ -490,7 +667,14 @@ namespace mongo {
                     }
                     unsigned slen = h.sectionLen();
                     unsigned dataLen = slen - sizeof(JSectHeader) - sizeof(JSectFooter);
-                    const char *hdr = (const char *) br.skip(h.sectionLenWithPadding());
+                    const char *hdr;
+                    if (stripes.empty()) {
+                        hdr = (const char *) br.skip(h.sectionLenWithPadding());
+                    }
+                    else {
+                        hdr = reassembleStripedSection(h.sectionLenWithPadding(), br,
+                                                       stripes.vector());
+                    }
                     const char *data = hdr + sizeof(JSectHeader);
                     const char *footer = data + dataLen;
                     processSection((const JSectHeader*) hdr, data, dataLen, (const JSectFooter*) footer);
@@ -530,7 +714,7 @@ namespace mongo {
             MemoryMappedFile f;
             void *p = f.mapWithOptions(journalfile.string().c_str(), MongoFile::READONLY | MongoFile::SEQUENTIAL);
             massert(13544, str::stream() << "recover error couldn't open " << journalfile.string(), p);
-            return processFileBuffer(p, (unsigned) f.length());
+            return processFileBuffer(p, (unsigned) f.length(), journalfile);
         }
 
         /** @param files all the j._0 style files we need to apply for recovery */
@@ -543,6 +727,13 @@ namespace mongo {
             _lastDataSyncedFromLastRun = journalReadLSN();
             log() << "recover lsn: " << _lastDataSyncedFromLastRun << endl;
 
+            const int replayThreads = journalReplayThreads > 0
+                                    ? journalReplayThreads
+                                    : static_cast<int>(ProcessInfo().getNumCores());
+            if (replayThreads > 1) {
+                _replayPool.reset(new ThreadPool(replayThreads, "journal replay "));
+            }
+
             for( unsigned i = 0; i != files.size(); ++i ) {
                 bool abruptEnd = processFile(files[i]);
                 if( abruptEnd && i+1 < files.size() ) {
@@ -553,6 +744,7 @@ namespace mongo {
             }
 
             close();
+            _replayPool.reset();
 
             if (mmapv1GlobalOptions.journalOptions & MMAPV1Options::JournalScanOnly) {
                 uasserted(13545, str::stream() << "--durOptions "
@@ -32,17 +32,22 @@
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 #include <list>
+#include <vector>
 
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/file.h"
 
 namespace mongo {
+    class BufReader;
     class DurableMappedFile;
 
     namespace dur {
+        class JournalStripeFile;
         struct ParsedJournalEntry;
 
         /** call go() to execute a recovery from existing journal files.
@@ -73,13 +78,25 @@ namespace mongo {
             void write(Last& last, const ParsedJournalEntry& entry); // actually writes to the file
             void applyEntry(Last& last, const ParsedJournalEntry& entry, bool apply, bool dump);
             void applyEntries(const std::vector<ParsedJournalEntry> &entries);
-            bool processFileBuffer(const void *, unsigned len);
+            void applyWritesInParallel(std::vector<ParsedJournalEntry>::const_iterator begin,
+                                       std::vector<ParsedJournalEntry>::const_iterator end);
+            bool processFileBuffer(const void *, unsigned len,
+                                   const boost::filesystem::path& journalfile);
+            const char* reassembleStripedSection(unsigned sectionLenWithPadding,
+                                                 BufReader& primary,
+                                                 const std::vector<JournalStripeFile*>& stripes);
             bool processFile(boost::filesystem::path journalfile);
             void _close(); // doesn't lock
             DurableMappedFile* getDurableMappedFile(const ParsedJournalEntry& entry);
 
             std::list<boost::shared_ptr<DurableMappedFile> > _mmfs;
 
+            // only set while recovering, if replay is spread over more than one thread
+            boost::scoped_ptr<ThreadPool> _replayPool;
+
+            // a striped section copied together from its chunks
+            std::vector<char> _stripedSection;
+
             unsigned long long _lastDataSyncedFromLastRun;
             unsigned long long _lastSeqMentionedInConsoleLog;
         public:
@@ -42,6 +42,10 @@
 
 namespace mongo {
 
+namespace {
+    const size_t kMaxReusedPreimageBytes = 1024 * 1024;
+}
+
     DurRecoveryUnit::DurRecoveryUnit() : _mustRollback(false) {
 
     }
@@ -86,6 +90,19 @@ namespace mongo {
         // no-op since we have no transaction
     }
 
+    bool DurRecoveryUnit::resetForReuse() {
+        if (inAUnitOfWork() || !_changes.empty() || !_writes.empty() || _mustRollback)
+            return false;
+
+        // Keep the buffers of ordinary writes, but not those of a large one for the life of the
+        // connection.
+        if (_preimageBuffer.capacity() > kMaxReusedPreimageBytes) {
+            std::string().swap(_preimageBuffer);
+            Writes().swap(_writes);
+        }
+        return true;
+    }
+
     void DurRecoveryUnit::commitChanges() {
         if (!inAUnitOfWork())
             return;
@@ -58,6 +58,8 @@ namespace mongo {
         //  The recovery unit takes ownership of change.
         virtual void registerChange(Change* change);
 
+        virtual bool resetForReuse();
+
     private:
         void commitChanges();
         void pushChangesToDurSubSystem();
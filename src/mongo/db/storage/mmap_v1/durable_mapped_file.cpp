@@ -273,7 +273,43 @@ namespace mongo {
         return false;
     }
 
-    DurableMappedFile::DurableMappedFile() : _willNeedRemap(false) {
+    void DurableMappedFile::noteWritten(unsigned long long ofs, unsigned len) {
+        if (len == 0) {
+            return;
+        }
+
+        const unsigned first = static_cast<unsigned>(ofs / DirtyChunkSize);
+        const unsigned last = static_cast<unsigned>((ofs + len - 1) / DirtyChunkSize);
+
+        SimpleMutex::scoped_lock lk(_dirtyMutex);
+        if (_dirtyChunks.size() <= last) {
+            _dirtyChunks.resize((length() + DirtyChunkSize - 1) / DirtyChunkSize);
+            invariant(_dirtyChunks.size() > last);
+        }
+        for (unsigned chunk = first; chunk <= last; chunk++) {
+            _dirtyChunks[chunk] = true;
+        }
+    }
+
+    void DurableMappedFile::takeDirtyChunks(std::vector<unsigned>* chunks) {
+        SimpleMutex::scoped_lock lk(_dirtyMutex);
+        for (unsigned chunk = 0; chunk < _dirtyChunks.size(); chunk++) {
+            if (_dirtyChunks[chunk]) {
+                chunks->push_back(chunk);
+                _dirtyChunks[chunk] = false;
+            }
+        }
+    }
+
+#ifndef _WIN32
+    void DurableMappedFile::flushChunk(unsigned chunk) {
+        flushRange(static_cast<unsigned long long>(chunk) * DirtyChunkSize, DirtyChunkSize);
+    }
+#endif
+
+    DurableMappedFile::DurableMappedFile()
+        : _willNeedRemap(false),
+          _dirtyMutex("DurableMappedFile::_dirtyMutex") {
         _view_write = _view_private = 0;
     }
 
@@ -31,6 +31,9 @@
 
 #pragma once
 
+#include <vector>
+
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/mmap.h"
 #include "mongo/util/paths.h"
 
@@ -99,6 +102,24 @@ namespace mongo {
 
         virtual bool isDurableMappedFile() { return true; }
 
+        /** Granularity at which writes to the write view are tracked for paced flushing. */
+        enum { DirtyChunkSize = 1024 * 1024 };
+
+        /** Records that [ofs, ofs + len) of the write view was modified.  threadsafe */
+        void noteWritten(unsigned long long ofs, unsigned len);
+
+        /** Appends the chunks modified since the last call to 'chunks' and forgets them.
+            threadsafe
+        */
+        void takeDirtyChunks(std::vector<unsigned>* chunks);
+
+#ifndef _WIN32
+        /** Synchronously writes back one chunk of the write view.  Caller must hold
+            LockMongoFilesShared.
+        */
+        void flushChunk(unsigned chunk);
+#endif
+
     private:
 
         void *_view_write;
@@ -107,6 +128,9 @@ namespace mongo {
         RelativePath _p;   // e.g. "somepath/dbname"
         int _fileSuffixNo;  // e.g. 3.  -1="ns"
 
+        SimpleMutex _dirtyMutex; // protects _dirtyChunks
+        std::vector<bool> _dirtyChunks;
+
         void setPath(const std::string& pathAndFileName);
         bool finishOpening();
     };
@@ -51,6 +51,7 @@
 #include "mongo/db/storage/mmap_v1/catalog/namespace_details_rsv1_metadata.h"
 #include "mongo/db/storage/mmap_v1/data_file.h"
 #include "mongo/db/storage/mmap_v1/record_store_v1_capped.h"
+#include "mongo/db/storage/mmap_v1/record_store_v1_compressed.h"
 #include "mongo/db/storage/mmap_v1/record_store_v1_simple.h"
 #include "mongo/util/log.h"
 
@@ -643,6 +644,13 @@ namespace {
                            str::stream() << "namespace already exists: " << ns );
         }
 
+        const bool compressed =
+            options.storageEngine.getObjectField( "mmapv1" )["compressed"].trueValue();
+        if ( compressed && options.capped ) {
+            return Status( ErrorCodes::InvalidOptions,
+                           "capped collections cannot be compressed" );
+        }
+
         BSONObj optionsAsBSON = options.toBSON();
         _addNamespaceToNamespaceCollection( txn, ns, &optionsAsBSON );
 
@@ -662,6 +670,11 @@ namespace {
                 // we set Flag_UsePowerOf2Sizes in case the user downgrades
                 md.setUserFlag(txn, NamespaceDetails::Flag_UsePowerOf2Sizes);
             }
+
+            // records are only readable by the store that wrote them, so this is never changed
+            if ( compressed ) {
+                md.setUserFlag( txn, NamespaceDetails::Flag_Compressed );
+            }
         }
         else if ( options.cappedMaxDocs > 0 ) {
             txn->recoveryUnit()->writingInt( _namespaceIndex.details( ns )->maxDocsInCapped ) =
@@ -763,6 +776,12 @@ namespace {
                                                              &_extentManager,
                                                              nss.coll() == "system.indexes"));
         }
+        else if (details->userFlags & NamespaceDetails::Flag_Compressed) {
+            entry->recordStore.reset(new CompressedRecordStoreV1(txn,
+                                                                 ns,
+                                                                 md.release(),
+                                                                 &_extentManager));
+        }
         else {
             entry->recordStore.reset(new SimpleRecordStoreV1(txn,
                                                              ns,
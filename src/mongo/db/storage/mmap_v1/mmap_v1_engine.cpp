@@ -37,16 +37,19 @@
 #include <fstream>
 
 #include "mongo/db/mongod_options.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/data_file_sync.h"
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/storage/mmap_v1/dur_journal.h"
 #include "mongo/db/storage/mmap_v1/dur_recover.h"
 #include "mongo/db/storage/mmap_v1/dur_recovery_unit.h"
 #include "mongo/db/storage/mmap_v1/mmap_v1_database_catalog_entry.h"
+#include "mongo/db/storage/mmap_v1/mmap_v1_extent_manager.h"
 #include "mongo/db/storage/mmap_v1/mmap_v1_options.h"
 #include "mongo/db/storage/storage_engine_lock_file.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/util/file_allocator.h"
+#include "mongo/util/huge_pages.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mmap.h"
 
@@ -55,6 +58,30 @@ namespace mongo {
 
 namespace {
 
+    // Whether the RecordAccessTracker's table goes on huge pages: "off", "transparent" or
+    // "explicit".
+    std::string mmapv1HugePages = "off";
+
+    class MMAPV1HugePagesParameter : public ExportedServerParameter<std::string> {
+    public:
+        MMAPV1HugePagesParameter()
+            : ExportedServerParameter<std::string>(ServerParameterSet::getGlobal(),
+                                                   "mmapv1HugePages",
+                                                   &mmapv1HugePages,
+                                                   true,
+                                                   false) {}
+
+        virtual Status validate(const std::string& potentialNewValue) {
+            return parseHugePageMode(potentialNewValue).getStatus();
+        }
+    } mmapv1HugePagesParameter;
+
+    HugePageMode recordAccessTrackerHugePages() {
+        const StatusWith<HugePageMode> mode = parseHugePageMode(mmapv1HugePages);
+        fassert(28638, mode.getStatus());
+        return mode.getValue();
+    }
+
 #if !defined(__sunos__)
     // if doingRepair is true don't consider unclean shutdown an error
     void acquirePathLock(MMAPV1Engine* storageEngine,
@@ -210,7 +237,8 @@ namespace {
     }
 } // namespace
 
-    MMAPV1Engine::MMAPV1Engine(const StorageEngineLockFile& lockFile) {
+    MMAPV1Engine::MMAPV1Engine(const StorageEngineLockFile& lockFile)
+        : _recordAccessTracker(recordAccessTrackerHugePages()) {
         // TODO check non-journal subdirs if using directory-per-db
         checkReadAhead(storageGlobalParams.dbpath);
 
@@ -325,6 +353,12 @@ namespace {
         return getDur().isDurable();
     }
 
+    StorageStats MMAPV1Engine::getThreadStorageStats() const {
+        StorageStats stats = StorageStats::forThisThread();
+        stats.ioWaitMicros = getThreadRecordFetchMicros();
+        return stats;
+    }
+
     RecordAccessTracker& MMAPV1Engine::getRecordAccessTracker() {
         return _recordAccessTracker;
     }
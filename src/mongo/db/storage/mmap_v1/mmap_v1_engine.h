@@ -60,6 +60,12 @@ namespace mongo {
 
         virtual bool isDurable() const;
 
+        /**
+         * Page faults are what MMAPv1 has for cache misses. The I/O wait is only the time spent
+         * paging in records after yielding, as a fault taken with locks held can't be timed.
+         */
+        virtual StorageStats getThreadStorageStats() const;
+
         virtual Status closeDatabase(OperationContext* txn, const StringData& db);
 
         virtual Status dropDatabase(OperationContext* txn, const StringData& db);
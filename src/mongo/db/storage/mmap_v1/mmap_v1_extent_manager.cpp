@@ -37,6 +37,7 @@
 #include "mongo/base/counter.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/storage/mmap_v1/data_file.h"
@@ -47,10 +48,14 @@
 #include "mongo/db/storage/mmap_v1/mmap_v1_options.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/concurrency/threadlocal.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/file.h"
+#include "mongo/util/file_allocator.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mmap.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -61,10 +66,38 @@ namespace mongo {
     static Counter64 needsFetchFailCounter;
     MONGO_FP_DECLARE(recordNeedsFetchFail);
 
+    // Upper bound on the number of data files requested ahead of the one just added.  How many
+    // are requested depends on how fast the database is filling files.  0 disables preallocation
+    // of files ahead of demand.
+    MONGO_EXPORT_SERVER_PARAMETER(dataFilePreallocAhead, int, 3);
+
+    static ServerStatusMetricField<Counter64> displayPreallocWaits(
+            "storage.preallocation.waits",
+            &FileAllocator::get()->waits() );
+
+    static ServerStatusMetricField<Counter64> displayPreallocWaitMicros(
+            "storage.preallocation.waitMicros",
+            &FileAllocator::get()->waitMicros() );
+
     // Used to make sure the compiler doesn't get too smart on us when we're
     // trying to touch records.
     volatile int __record_touch_dummy = 1;
 
+    namespace {
+        struct RecordFetchTime {
+            RecordFetchTime() : micros(0) { }
+            long long micros;
+        };
+    } // namespace
+
+    TSP_DECLARE(RecordFetchTime, recordFetchTime);
+    TSP_DEFINE(RecordFetchTime, recordFetchTime);
+
+    long long getThreadRecordFetchMicros() {
+        const RecordFetchTime* fetchTime = recordFetchTime.get();
+        return fetchTime ? fetchTime->micros : 0;
+    }
+
     class MmapV1RecordFetcher : public RecordFetcher {
         MONGO_DISALLOW_COPYING(MmapV1RecordFetcher);
     public:
@@ -84,7 +117,9 @@ namespace mongo {
 
             // Here's where we actually deference a pointer into the record. This is where
             // we expect a page fault to occur, so we should this out of the lock.
+            const unsigned long long start = curTimeMicros64();
             __record_touch_dummy += *recordChar;
+            recordFetchTime.getMake()->micros += curTimeMicros64() - start;
 
             // We're not going to touch the record anymore, so we can give up our
             // lock on mongo files. We do this here because we have to release the
@@ -107,7 +142,8 @@ namespace mongo {
         : _dbname(dbname.toString()),
           _path(path.toString()),
           _directoryPerDB(directoryPerDB),
-          _rid(RESOURCE_METADATA, dbname) {
+          _rid(RESOURCE_METADATA, dbname),
+          _lastFileAddedMillis(0) {
         StorageEngine* engine = getGlobalEnvironment()->getGlobalStorageEngine();
         invariant(engine->isMmapV1());
         MMAPV1Engine* mmapEngine = static_cast<MMAPV1Engine*>(engine);
@@ -247,16 +283,44 @@ namespace mongo {
 
         // Preallocate is asynchronous
         if (preallocateNextFile) {
-            auto_ptr<DataFile> nextFile(new DataFile(allocFileId + 1));
-            const string nextFileName = _fileName(allocFileId + 1).string();
-
-            nextFile->open(txn, nextFileName.c_str(), minSize, false);
+            _preallocateAhead(txn, allocFileId, minSize);
         }
 
         // Returns the last file added
         return _files[allocFileId];
     }
 
+    void MmapV1ExtentManager::_preallocateAhead(OperationContext* txn,
+                                                int lastFileId,
+                                                int minSize) {
+        const long long now = curTimeMillis64();
+        const long long sinceLastFile = now - _lastFileAddedMillis.swap(now);
+
+        const int maxAhead = std::min(dataFilePreallocAhead,
+                                      DiskLoc::MaxFiles - 1 - lastFileId);
+        if (maxAhead <= 0) {
+            return;
+        }
+
+        // Keep enough files in flight that the allocator, which writes one file at a time,
+        // finishes each before the database fills the ones ahead of it.
+        const long long allocMillis = FileAllocator::get()->expectedAllocationMillis(
+            _files[lastFileId]->getHeader()->fileLength);
+        long long ahead = 1;
+        if (sinceLastFile > 0) {
+            ahead += allocMillis / sinceLastFile;
+        }
+        ahead = std::min(ahead, static_cast<long long>(maxAhead));
+
+        for (int i = 1; i <= ahead; i++) {
+            DataFile nextFile(lastFileId + i);
+            const string nextFileName = _fileName(lastFileId + i).string();
+
+            // Only requests the allocation; a no-op if the file exists or was requested already.
+            nextFile.open(txn, nextFileName.c_str(), minSize, true);
+        }
+    }
+
     int MmapV1ExtentManager::numFiles() const {
         return _files.size();
     }
@@ -390,7 +454,7 @@ namespace mongo {
         // no space in an existing file
         // allocate files until we either get one big enough or hit maxSize
         for ( int i = 0; i < 8; i++ ) {
-            DataFile* f = _addAFile( txn, size, false );
+            DataFile* f = _addAFile( txn, size, true );
 
             if ( f->getHeader()->unusedLength >= size ) {
                 return _createExtentInFile( txn, numFiles() - 1, f, size, enforceQuota );
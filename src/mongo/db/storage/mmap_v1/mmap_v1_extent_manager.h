@@ -52,6 +52,12 @@ namespace mongo {
 
     struct Extent;
 
+    /**
+     * Microseconds the calling thread has spent paging in records, with its locks released,
+     * through the fetchers handed out by MmapV1ExtentManager::recordNeedsFetch.
+     */
+    long long getThreadRecordFetchMicros();
+
     /**
      * ExtentManager basics
      *  - one per database
@@ -167,6 +173,12 @@ namespace mongo {
 
         DataFile* _addAFile( OperationContext* txn, int sizeNeeded, bool preallocateNextFile );
 
+        /**
+         * Requests background allocation of the files after 'lastFileId'.  The number requested
+         * grows with the rate files are being added, up to dataFilePreallocAhead.
+         */
+        void _preallocateAhead( OperationContext* txn, int lastFileId, int minSize );
+
 
         /**
          * Shared record retrieval logic used by the public recordForV1() and likelyInPhysicalMem()
@@ -201,6 +213,9 @@ namespace mongo {
         // engine is valid. Not owned here.
         RecordAccessTracker* _recordAccessTracker;
 
+        // When the last file was added by _addAFile(), to estimate how fast files fill.
+        AtomicInt64 _lastFileAddedMillis;
+
         /**
          * Simple wrapper around an array object to allow append-only modification of the array,
          * as well as concurrent read-accesses. This class has a minimal interface to keep
@@ -54,6 +54,11 @@ namespace mongo {
 
             virtual Status validateCollectionStorageOptions(const BSONObj& options) const
             {
+                const BSONElement compressed = options["compressed"];
+                if (!compressed.eoo() && !compressed.isBoolean()) {
+                    return Status(ErrorCodes::BadValue,
+                                  "storageEngine.mmapv1.compressed must be a boolean");
+                }
                 return Status::OK();
             }
 
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 /*
  * This file defines the storage for options that come from the command line related to the
@@ -62,6 +63,13 @@ namespace mongo {
         // of the journal, at the expense of disk performance.
         unsigned journalCommitInterval; // group/batch commit interval ms
 
+        // --journalStripeDirs
+        // Additional directories, ideally each on its own device, that large journal sections
+        // are striped across. The journal directory under the dbpath is always the first stripe
+        // and the only one holding the lsn file. Recovery must be run with the same directories
+        // in the same order.
+        std::vector<std::string> journalStripeDirs;
+
         // --journalOptions 7            dump journal and terminate without doing anything further
         // --journalOptions 4            recover and terminate without listening
         enum { // bits to be ORed
@@ -295,14 +295,38 @@ namespace mongo {
     // RecordAccessTracker
     //
 
-    RecordAccessTracker::RecordAccessTracker()
-        : _blockSupported(blockSupported) {
+    RecordAccessTracker::RecordAccessTracker(HugePageMode hugePages)
+        : _blockSupported(blockSupported),
+          _hugePages(hugePages),
+          _rollingTable(NULL) {
         reset();
     }
 
+    RecordAccessTracker::~RecordAccessTracker() {
+        _destroyRollingTable();
+    }
+
     void RecordAccessTracker::reset() {
         PointerTable::reset(PointerTable::getData());
-        _rollingTable.reset(new Rolling[BigHashSize]);
+
+        _destroyRollingTable();
+        _rollingMemory.reset(new HugePageRegion(sizeof(Rolling) * BigHashSize, _hugePages));
+        Rolling* table = static_cast<Rolling*>(_rollingMemory->get());
+        for (int i = 0; i < BigHashSize; i++) {
+            new (&table[i]) Rolling();
+        }
+        _rollingTable = table;
+    }
+
+    void RecordAccessTracker::_destroyRollingTable() {
+        if (!_rollingTable) {
+            return;
+        }
+        for (int i = 0; i < BigHashSize; i++) {
+            _rollingTable[i].~Rolling();
+        }
+        _rollingTable = NULL;
+        _rollingMemory.reset();
     }
 
     void RecordAccessTracker::markAccessed(const void* record) {
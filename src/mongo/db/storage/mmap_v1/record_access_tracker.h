@@ -28,9 +28,10 @@
 
 #pragma once
 
-#include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/huge_pages.h"
 
 namespace mongo {
 
@@ -46,7 +47,12 @@ namespace mongo {
     class RecordAccessTracker {
         MONGO_DISALLOW_COPYING(RecordAccessTracker);
     public:
-        RecordAccessTracker();
+        /**
+         * The table of recent accesses, about 20MB looked up at random, goes on huge pages as
+         * 'hugePages' asks.
+         */
+        explicit RecordAccessTracker(HugePageMode hugePages = kHugePagesOff);
+        ~RecordAccessTracker();
 
         enum Constants {
             SliceSize = 1024,
@@ -153,8 +159,14 @@ namespace mongo {
         // Should this record tracker fallback to making a system call?
         bool _blockSupported;
 
-        // An array of Rolling instances for tracking record accesses.
-        boost::scoped_array<Rolling> _rollingTable;
+        void _destroyRollingTable();
+
+        const HugePageMode _hugePages;
+
+        // An array of BigHashSize Rolling instances for tracking record accesses, constructed in
+        // _rollingMemory.
+        boost::scoped_ptr<HugePageRegion> _rollingMemory;
+        Rolling* _rollingTable;
     };
 
 } // namespace
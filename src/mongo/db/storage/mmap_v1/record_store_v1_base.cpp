@@ -32,7 +32,9 @@
 
 #include "mongo/db/storage/mmap_v1/record_store_v1_base.h"
 
+#include <algorithm>
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/operation_context.h"
@@ -40,6 +42,8 @@
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
 #include "mongo/db/storage/mmap_v1/record.h"
 #include "mongo/db/storage/mmap_v1/record_store_v1_repair_iterator.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/log.h"
 #include "mongo/util/progress_meter.h"
 #include "mongo/util/timer.h"
@@ -155,7 +159,7 @@ namespace mongo {
     }
 
     RecordData RecordStoreV1Base::dataFor( OperationContext* txn, const RecordId& loc ) const {
-        return recordFor(DiskLoc::fromRecordId(loc))->toRecordData();
+        return recordDataFor(DiskLoc::fromRecordId(loc));
     }
 
     bool RecordStoreV1Base::findRecord( OperationContext* txn,
@@ -167,7 +171,7 @@ namespace mongo {
         if ( !rec ) {
             return false;
         }
-        *rd = rec->toRecordData();
+        *rd = recordDataFor(DiskLoc::fromRecordId(loc));
         return true;
     }
 
@@ -175,6 +179,10 @@ namespace mongo {
         return _extentManager->recordForV1( loc );
     }
 
+    RecordData RecordStoreV1Base::recordDataFor( const DiskLoc& loc ) const {
+        return recordFor( loc )->toRecordData();
+    }
+
     const DeletedRecord* RecordStoreV1Base::deletedRecordFor( const DiskLoc& loc ) const {
         invariant( loc.a() != -1 );
         return reinterpret_cast<const DeletedRecord*>( recordFor( loc ) );
@@ -735,7 +743,7 @@ namespace mongo {
 
                     if (full){
                         size_t dataSize = 0;
-                        const Status status = adaptor->validate( r->toRecordData(), &dataSize );
+                        const Status status = adaptor->validate( recordDataFor(cl), &dataSize );
                         if (!status.isOK()) {
                             results->valid = false;
                             if (nInvalid == 0) // only log once;
@@ -865,7 +873,27 @@ namespace mongo {
         struct touch_location {
             const char* root;
             size_t length;
+
+            bool operator<( const touch_location& other ) const { return root < other.root; }
         };
+
+        // Threads reading ranges in at once for touch. Extents are spread over several data
+        // files, so more outstanding reads keep more of the disks busy.
+        const size_t kTouchThreads = 4;
+
+        /**
+         * Touches ranges, taking the next one from 'next', until they run out or 'stop' is set.
+         */
+        void touchRanges( const std::vector<touch_location>* ranges,
+                          AtomicUInt32* next,
+                          const AtomicUInt32* stop ) {
+            while ( !stop->load() ) {
+                const unsigned i = next->fetchAndAdd( 1 );
+                if ( i >= ranges->size() )
+                    return;
+                touch_pages( (*ranges)[i].root, (*ranges)[i].length );
+            }
+        }
     }
 
     Status RecordStoreV1Base::touch( OperationContext* txn, BSONObjBuilder* output ) const {
@@ -889,16 +917,55 @@ namespace mongo {
             }
         }
 
+        // Extents that follow each other in a data file are read as one range, in file order.
+        std::sort( ranges.begin(), ranges.end() );
+        std::vector<touch_location> coalesced;
+        for ( size_t i = 0; i < ranges.size(); i++ ) {
+            if ( !coalesced.empty() &&
+                 coalesced.back().root + coalesced.back().length == ranges[i].root ) {
+                coalesced.back().length += ranges[i].length;
+            }
+            else {
+                coalesced.push_back( ranges[i] );
+            }
+        }
+        ranges.swap( coalesced );
+
         std::string progress_msg = "touch " + std::string(txn->getNS()) + " extents";
         ProgressMeterHolder pm(*txn->setMessage(progress_msg.c_str(),
                                                 "Touch Progress",
                                                 ranges.size()));
 
-        for ( std::vector<touch_location>::iterator it = ranges.begin(); it != ranges.end(); ++it ) {
-            touch_pages( it->root, it->length );
-            pm.hit();
-            txn->checkForInterrupt();
+        AtomicUInt32 next;
+        AtomicUInt32 stop;
+        boost::thread_group threads;
+        for ( size_t i = 1; i < std::min( kTouchThreads, ranges.size() ); i++ ) {
+            threads.create_thread( stdx::bind( touchRanges, &ranges, &next, &stop ) );
+        }
+
+        // This thread reads ranges too, and reports progress and checks for interruption
+        // between them.
+        Status status = Status::OK();
+        unsigned reported = 0;
+        while ( true ) {
+            const unsigned i = next.fetchAndAdd( 1 );
+            if ( i >= ranges.size() )
+                break;
+            touch_pages( ranges[i].root, ranges[i].length );
+
+            const unsigned started = std::min( next.load(), static_cast<unsigned>(ranges.size()) );
+            pm.hit( started - reported );
+            reported = started;
+
+            status = txn->checkForInterruptNoAssert();
+            if ( !status.isOK() ) {
+                stop.store( 1 );
+                break;
+            }
         }
+        threads.join_all();
+        if ( !status.isOK() )
+            return status;
         pm.finished();
 
         if ( output ) {
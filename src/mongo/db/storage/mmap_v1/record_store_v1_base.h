@@ -163,6 +163,7 @@ namespace mongo {
         enum UserFlags {
             Flag_UsePowerOf2Sizes = 1 << 0,
             Flag_NoPadding = 1 << 1,
+            Flag_Compressed = 1 << 2, // see CompressedRecordStoreV1, only set at creation
         };
 
         // ------------
@@ -266,6 +267,12 @@ namespace mongo {
 
         virtual Record* recordFor( const DiskLoc& loc ) const;
 
+        /**
+         * The document stored in the record at 'loc', as returned by dataFor() and findRecord()
+         * and checked by validate().  By default this points into the record itself.
+         */
+        virtual RecordData recordDataFor( const DiskLoc& loc ) const;
+
         const DeletedRecord* deletedRecordFor( const DiskLoc& loc ) const;
 
         virtual bool isCapped() const = 0;
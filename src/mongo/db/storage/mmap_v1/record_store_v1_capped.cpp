@@ -32,6 +32,8 @@
 
 #include "mongo/db/storage/mmap_v1/record_store_v1_capped.h"
 
+#include <map>
+
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/storage/mmap_v1/extent.h"
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
@@ -166,14 +168,13 @@ namespace mongo {
                     continue;
                 }
 
-                const RecordId fr = theCapExtent()->firstRecord.toRecordId();
-                Status status = _deleteCallback->aboutToDeleteCapped( txn, fr );
-                if ( !status.isOK() )
-                    return StatusWith<DiskLoc>( status );
-                deleteRecord( txn, fr );
+                StatusWith<int> deleted = _deleteOldestToFit( txn, lenToAlloc );
+                if ( !deleted.isOK() )
+                    return StatusWith<DiskLoc>( deleted.getStatus() );
 
-                compact(txn);
-                if ((++passes % 5000) == 0) {
+                const int prevPasses = passes;
+                passes += deleted.getValue();
+                if ( passes / 5000 != prevPasses / 5000 ) {
                     StringBuilder sb;
                     log() << "passes = " << passes << " in CappedRecordStoreV1::allocRecord:"
                           << " ns: " << _ns
@@ -310,6 +311,72 @@ namespace mongo {
 
     }
 
+    StatusWith<int> CappedRecordStoreV1::_deleteOldestToFit( OperationContext* txn,
+                                                              int lenToAlloc ) {
+        // Deleting one record at a time and compacting after each, the way a single allocation
+        // used to wrap around, costs a pass over the cap extent's deleted records per record
+        // deleted. Instead track how compact() will merge the freed records with their deleted
+        // neighbors, so it only has to run once for all of them.
+        const int lenNeeded = lenToAlloc + 24; // see __capAlloc()
+
+        std::map<int, int> drecLengths; // offset -> length of the cap extent's deleted records
+        bool fits = false;
+        for ( DiskLoc i = cappedFirstDeletedInCurExtent();
+              !i.isNull() && inCapExtent( i );
+              i = drec( i )->nextDeleted() ) {
+            drecLengths[i.getOfs()] = drec( i )->lengthWithHeaders();
+            fits = fits || drec( i )->lengthWithHeaders() >= lenNeeded;
+        }
+
+        int deleted = 0;
+        while ( 1 ) {
+            const DiskLoc fr = theCapExtent()->firstRecord;
+            if ( fr.isNull() || fr == _details->capFirstNewRecord() ) {
+                // allocRecord() decides what to do next.
+                break;
+            }
+
+            const int ofs = fr.getOfs();
+            const int len = recordFor( fr )->lengthWithHeaders();
+
+            Status status = _deleteCallback->aboutToDeleteCapped( txn, fr.toRecordId() );
+            if ( !status.isOK() ) {
+                if ( deleted )
+                    compact(txn);
+                return StatusWith<int>( status );
+            }
+            deleteRecord( txn, fr.toRecordId() );
+            deleted++;
+
+            // Merge with the deleted records right before and after, like compact() will.
+            int mergedOfs = ofs;
+            int mergedLen = len;
+            std::map<int, int>::iterator before = drecLengths.lower_bound( ofs );
+            if ( before != drecLengths.begin() ) {
+                --before;
+                if ( before->first + before->second == ofs ) {
+                    mergedOfs = before->first;
+                    mergedLen += before->second;
+                    drecLengths.erase( before );
+                }
+            }
+            std::map<int, int>::iterator after = drecLengths.find( ofs + len );
+            if ( after != drecLengths.end() ) {
+                mergedLen += after->second;
+                drecLengths.erase( after );
+            }
+            drecLengths[mergedOfs] = mergedLen;
+
+            fits = fits || mergedLen >= lenNeeded;
+            if ( fits && _details->numRecords() < _details->maxCappedDocs() )
+                break;
+        }
+
+        invariant( deleted > 0 );
+        compact(txn);
+        return StatusWith<int>( deleted );
+    }
+
     DiskLoc CappedRecordStoreV1::cappedFirstDeletedInCurExtent() const {
         if ( cappedLastDelRecLastExtent().isNull() )
             return cappedListOfAllDeletedRecords();
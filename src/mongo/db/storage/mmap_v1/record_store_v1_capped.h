@@ -129,6 +129,16 @@ namespace mongo {
 
         // -- end copy from cap.cpp --
 
+        /**
+         * Deletes the oldest records of the cap extent until the space they free, merged with
+         * the adjacent deleted records, fits a record of 'lenToAlloc' bytes and the collection is
+         * under its document limit, then compacts the cap extent's deleted records once.
+         *
+         * Stops early at the end of the extent's old records. Returns the number of records
+         * deleted, which is at least one.
+         */
+        StatusWith<int> _deleteOldestToFit( OperationContext* txn, int lenToAlloc );
+
         CappedDocumentDeleteCallback* _deleteCallback;
 
         OwnedPointerVector<ExtentManager::CacheHint> _extentAdvice;
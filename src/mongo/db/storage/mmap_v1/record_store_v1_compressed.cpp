@@ -0,0 +1,256 @@
+// record_store_v1_compressed.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/mmap_v1/record_store_v1_compressed.h"
+
+#include <boost/thread/locks.hpp>
+
+#include "mongo/base/data_view.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/storage/mmap_v1/record.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/compress.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+namespace {
+
+    /**
+     * Appends the record for the 'len' byte document 'data' to 'out': the length of the
+     * compressed document, then the compressed document.
+     */
+    void compressDocument( const char* data, int len, BufBuilder* out ) {
+        const size_t maxLength = maxCompressedLength( len );
+        char* dest = out->skip( sizeof(int32_t) + maxLength );
+
+        size_t compressedLength;
+        rawCompress( data, len, dest + sizeof(int32_t), &compressedLength );
+        invariant( compressedLength <= maxLength );
+
+        DataView( dest ).writeLE<int32_t>( compressedLength );
+        out->setlen( sizeof(int32_t) + compressedLength );
+    }
+
+} // namespace
+
+    class CompressedRecordStoreV1::InvalidateOnRollback : public RecoveryUnit::Change {
+    public:
+        InvalidateOnRollback( CompressedRecordStoreV1* rs, const DiskLoc& loc )
+            : _rs( rs )
+            , _loc( loc )
+        {}
+
+        virtual void commit() {}
+        virtual void rollback() { _rs->_forget( _loc ); }
+
+    private:
+        CompressedRecordStoreV1* const _rs;
+        const DiskLoc _loc;
+    };
+
+    CompressedRecordStoreV1::CompressedRecordStoreV1( OperationContext* txn,
+                                                      const StringData& ns,
+                                                      RecordStoreV1MetaData* details,
+                                                      ExtentManager* em )
+        : SimpleRecordStoreV1( txn, ns, details, em, false ) {
+        invariant( details->isUserFlagSet( Flag_Compressed ) );
+    }
+
+    CompressedRecordStoreV1::~CompressedRecordStoreV1() { }
+
+    StatusWith<RecordId> CompressedRecordStoreV1::insertRecord( OperationContext* txn,
+                                                                const char* data,
+                                                                int len,
+                                                                bool enforceQuota ) {
+        if ( len < 4 ) {
+            return StatusWith<RecordId>( ErrorCodes::InvalidLength, "record has to be >= 4 bytes" );
+        }
+
+        BufBuilder compressed;
+        compressDocument( data, len, &compressed );
+        if ( compressed.len() + Record::HeaderSize > MaxAllowedAllocation ) {
+            return StatusWith<RecordId>( ErrorCodes::InvalidLength, "record has to be <= 16.5MB" );
+        }
+
+        StatusWith<RecordId> loc = _insertRecord( txn,
+                                                  compressed.buf(),
+                                                  compressed.len(),
+                                                  enforceQuota );
+        if ( loc.isOK() )
+            _invalidate( txn, DiskLoc::fromRecordId( loc.getValue() ) );
+        return loc;
+    }
+
+    StatusWith<RecordId> CompressedRecordStoreV1::insertRecord( OperationContext* txn,
+                                                                const DocWriter* doc,
+                                                                bool enforceQuota ) {
+        // The document has to be compressed before its size on disk is known, so it is written
+        // out to a buffer first rather than into the record.
+        const int docSize = doc->documentSize();
+        if ( docSize < 4 ) {
+            return StatusWith<RecordId>( ErrorCodes::InvalidLength, "record has to be >= 4 bytes" );
+        }
+
+        BufBuilder raw( docSize );
+        doc->writeDocument( raw.skip( docSize ) );
+        return insertRecord( txn, raw.buf(), docSize, enforceQuota );
+    }
+
+    StatusWith<RecordId> CompressedRecordStoreV1::updateRecord( OperationContext* txn,
+                                                                const RecordId& oldLocation,
+                                                                const char* data,
+                                                                int len,
+                                                                bool enforceQuota,
+                                                                UpdateMoveNotifier* notifier ) {
+        const DiskLoc oldLoc = DiskLoc::fromRecordId( oldLocation );
+
+        BufBuilder compressed;
+        compressDocument( data, len, &compressed );
+
+        Record* oldRecord = recordFor( oldLoc );
+        if ( oldRecord->netLength() >= compressed.len() ) {
+            // we fit
+            _invalidate( txn, oldLoc );
+            memcpy( txn->recoveryUnit()->writingPtr( oldRecord->data(), compressed.len() ),
+                    compressed.buf(),
+                    compressed.len() );
+            return StatusWith<RecordId>( oldLocation );
+        }
+
+        // we have to move
+        if ( compressed.len() + Record::HeaderSize > MaxAllowedAllocation ) {
+            return StatusWith<RecordId>( ErrorCodes::InvalidLength, "record has to be <= 16.5MB" );
+        }
+
+        StatusWith<RecordId> newLocation = _insertRecord( txn,
+                                                          compressed.buf(),
+                                                          compressed.len(),
+                                                          enforceQuota );
+        if ( !newLocation.isOK() )
+            return newLocation;
+        _invalidate( txn, DiskLoc::fromRecordId( newLocation.getValue() ) );
+
+        // insert worked, so we delete old record
+        if ( notifier ) {
+            // The notifier expects the document, not the compressed record.
+            const RecordData oldData = recordDataFor( oldLoc );
+            Status moveStatus = notifier->recordStoreGoingToMove( txn,
+                                                                  oldLocation,
+                                                                  oldData.data(),
+                                                                  oldData.size() );
+            if ( !moveStatus.isOK() )
+                return StatusWith<RecordId>( moveStatus );
+        }
+
+        deleteRecord( txn, oldLocation );
+
+        return newLocation;
+    }
+
+    void CompressedRecordStoreV1::deleteRecord( OperationContext* txn, const RecordId& dl ) {
+        _invalidate( txn, DiskLoc::fromRecordId( dl ) );
+        SimpleRecordStoreV1::deleteRecord( txn, dl );
+    }
+
+    Status CompressedRecordStoreV1::truncate( OperationContext* txn ) {
+        {
+            boost::lock_guard<boost::mutex> lk( _cacheMutex );
+            for ( int i = 0; i < kCacheSlots; i++ ) {
+                _cache[i] = CacheSlot();
+            }
+        }
+        return SimpleRecordStoreV1::truncate( txn );
+    }
+
+    void CompressedRecordStoreV1::appendCustomStats( OperationContext* txn,
+                                                     BSONObjBuilder* result,
+                                                     double scale ) const {
+        SimpleRecordStoreV1::appendCustomStats( txn, result, scale );
+        result->appendBool( "compressed", true );
+    }
+
+    RecordData CompressedRecordStoreV1::recordDataFor( const DiskLoc& loc ) const {
+        CacheSlot& slot = _cache[_slotFor( loc )];
+        {
+            boost::lock_guard<boost::mutex> lk( _cacheMutex );
+            if ( slot.loc == loc )
+                return RecordData( slot.data, slot.size );
+        }
+
+        const Record* rec = recordFor( loc );
+        const int compressedLength = ConstDataView( rec->data() ).readLE<int32_t>();
+        const char* compressed = rec->data() + sizeof(int32_t);
+
+        size_t size = 0;
+        massert( 28640,
+                 str::stream() << "corrupt compressed record " << loc.toString() << " in " << _ns,
+                 compressedLength > 0
+                 && compressedLength <= rec->netLength() - static_cast<int>(sizeof(int32_t))
+                 && uncompressedLength( compressed, compressedLength, &size )
+                 && size <= static_cast<size_t>( MaxAllowedAllocation ) );
+
+        SharedBuffer data = SharedBuffer::allocate( size );
+        massert( 28641,
+                 str::stream() << "corrupt compressed record " << loc.toString() << " in " << _ns,
+                 rawUncompress( compressed, compressedLength, data.get() ) );
+
+        if ( size <= static_cast<size_t>( kMaxCachedDocumentSize ) ) {
+            boost::lock_guard<boost::mutex> lk( _cacheMutex );
+            slot.loc = loc;
+            slot.data = data;
+            slot.size = size;
+        }
+
+        return RecordData( data, size );
+    }
+
+    void CompressedRecordStoreV1::_invalidate( OperationContext* txn, const DiskLoc& loc ) {
+        txn->recoveryUnit()->registerChange( new InvalidateOnRollback( this, loc ) );
+        _forget( loc );
+    }
+
+    void CompressedRecordStoreV1::_forget( const DiskLoc& loc ) {
+        boost::lock_guard<boost::mutex> lk( _cacheMutex );
+        CacheSlot& slot = _cache[_slotFor( loc )];
+        if ( slot.loc == loc )
+            slot = CacheSlot();
+    }
+
+    int CompressedRecordStoreV1::_slotFor( const DiskLoc& loc ) {
+        // Records are 4 byte aligned, so the low bits of the offset are always zero.
+        const unsigned hash = static_cast<unsigned>( loc.a() ) * 131
+                            + ( static_cast<unsigned>( loc.getOfs() ) >> 2 );
+        return hash % kCacheSlots;
+    }
+
+}
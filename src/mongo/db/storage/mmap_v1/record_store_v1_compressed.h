@@ -0,0 +1,125 @@
+// record_store_v1_compressed.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/db/storage/mmap_v1/record_store_v1_simple.h"
+#include "mongo/util/shared_buffer.h"
+
+namespace mongo {
+
+    /**
+     * A SimpleRecordStoreV1 whose records hold snappy compressed documents, for collections
+     * created with {storageEngine: {mmapv1: {compressed: true}}} (Flag_Compressed).
+     *
+     * Each record holds the length of the compressed document followed by the compressed bytes.
+     * Readers get an owned, uncompressed copy, the most recent of which are kept in a small cache
+     * so that a document fetched repeatedly is only uncompressed once.
+     *
+     * Documents cannot be patched in place, so updates are written whole: in place if the
+     * compressed document still fits in the record, as a move otherwise.  Compaction copies raw
+     * records and is not supported.
+     */
+    class CompressedRecordStoreV1 : public SimpleRecordStoreV1 {
+    public:
+        CompressedRecordStoreV1( OperationContext* txn,
+                                 const StringData& ns,
+                                 RecordStoreV1MetaData* details,
+                                 ExtentManager* em );
+
+        virtual ~CompressedRecordStoreV1();
+
+        const char* name() const { return "CompressedRecordStoreV1"; }
+
+        virtual StatusWith<RecordId> insertRecord( OperationContext* txn,
+                                                   const char* data,
+                                                   int len,
+                                                   bool enforceQuota );
+
+        virtual StatusWith<RecordId> insertRecord( OperationContext* txn,
+                                                   const DocWriter* doc,
+                                                   bool enforceQuota );
+
+        virtual StatusWith<RecordId> updateRecord( OperationContext* txn,
+                                                   const RecordId& oldLocation,
+                                                   const char* data,
+                                                   int len,
+                                                   bool enforceQuota,
+                                                   UpdateMoveNotifier* notifier );
+
+        virtual bool updateWithDamagesSupported() const { return false; }
+
+        virtual void deleteRecord( OperationContext* txn, const RecordId& dl );
+
+        virtual Status truncate( OperationContext* txn );
+
+        virtual bool compactSupported() const { return false; }
+
+        virtual bool compactIncrementalSupported() const { return false; }
+
+        virtual void appendCustomStats( OperationContext* txn,
+                                        BSONObjBuilder* result,
+                                        double scale ) const;
+
+        // Number of uncompressed documents kept, and the largest one worth keeping.
+        static const int kCacheSlots = 256;
+        static const int kMaxCachedDocumentSize = 64 * 1024;
+
+    protected:
+        virtual RecordData recordDataFor( const DiskLoc& loc ) const;
+
+    private:
+        class InvalidateOnRollback;
+
+        struct CacheSlot {
+            CacheSlot() : size( 0 ) { }
+
+            DiskLoc loc;
+            SharedBuffer data;
+            int size;
+        };
+
+        /**
+         * Forgets any cached copy of the record at 'loc', now and again if 'txn' rolls back, as
+         * the record's contents are about to change.
+         */
+        void _invalidate( OperationContext* txn, const DiskLoc& loc );
+
+        void _forget( const DiskLoc& loc );
+
+        static int _slotFor( const DiskLoc& loc );
+
+        mutable boost::mutex _cacheMutex;
+        mutable CacheSlot _cache[kCacheSlots];
+    };
+
+}
@@ -0,0 +1,198 @@
+// record_store_v1_compressed_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/storage/mmap_v1/record_store_v1_compressed.h"
+
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/db/storage/mmap_v1/record.h"
+#include "mongo/db/storage/mmap_v1/record_store_v1_test_help.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    // A document that compresses well, like a log entry repeating the same text.
+    BSONObj compressibleDoc( int id, int size ) {
+        return BSON( "_id" << id << "msg" << std::string( size, 'x' ) );
+    }
+
+    // A document that barely compresses at all.
+    BSONObj incompressibleDoc( int id, int size ) {
+        std::string junk( size, '\0' );
+        unsigned seed = id;
+        for ( int i = 0; i < size; i++ ) {
+            seed = seed * 1103515245 + 12345;
+            junk[i] = static_cast<char>( seed >> 16 );
+        }
+        BSONObjBuilder b;
+        b.append( "_id", id );
+        b.appendBinData( "junk", size, BinDataGeneral, junk.data() );
+        return b.obj();
+    }
+
+    class BsonDocWriter : public DocWriter {
+    public:
+        BsonDocWriter( const BSONObj& obj ) : _obj( obj ) {}
+
+        virtual void writeDocument( char* buf ) const {
+            memcpy( buf, _obj.objdata(), _obj.objsize() );
+        }
+        virtual size_t documentSize() const { return _obj.objsize(); }
+
+    private:
+        BSONObj _obj;
+    };
+
+    class RecordingMoveNotifier : public UpdateMoveNotifier {
+    public:
+        virtual Status recordStoreGoingToMove( OperationContext* txn,
+                                               const RecordId& oldLocation,
+                                               const char* oldBuffer,
+                                               size_t oldSize ) {
+            moved.push_back( BSONObj( oldBuffer ).getOwned() );
+            return Status::OK();
+        }
+
+        std::vector<BSONObj> moved;
+    };
+
+    TEST(CompressedRecordStoreV1, InsertStoresCompressedDocument) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md =
+            new DummyRecordStoreV1MetaData( false, RecordStoreV1Base::Flag_Compressed );
+        CompressedRecordStoreV1 rs( &txn, "test.foo", md, &em );
+
+        BSONObj obj = compressibleDoc( 1, 10000 );
+        StatusWith<RecordId> result = rs.insertRecord( &txn, obj.objdata(), obj.objsize(), false );
+        ASSERT_OK( result.getStatus() );
+
+        // The record is a fraction of the size of the document it holds.
+        ASSERT_LESS_THAN( rs.dataSize( &txn ) * 4, obj.objsize() );
+
+        RecordData rd = rs.dataFor( &txn, result.getValue() );
+        ASSERT_EQUALS( obj.objsize(), rd.size() );
+        ASSERT_EQUALS( obj, rd.toBson() );
+
+        // Read again, from the cache this time.
+        ASSERT_EQUALS( obj, rs.dataFor( &txn, result.getValue() ).toBson() );
+    }
+
+    TEST(CompressedRecordStoreV1, InsertWithDocWriter) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md =
+            new DummyRecordStoreV1MetaData( false, RecordStoreV1Base::Flag_Compressed );
+        CompressedRecordStoreV1 rs( &txn, "test.foo", md, &em );
+
+        BSONObj obj = compressibleDoc( 1, 1000 );
+        BsonDocWriter docWriter( obj );
+        StatusWith<RecordId> result = rs.insertRecord( &txn, &docWriter, false );
+        ASSERT_OK( result.getStatus() );
+
+        RecordData rd;
+        ASSERT_TRUE( rs.findRecord( &txn, result.getValue(), &rd ) );
+        ASSERT_EQUALS( obj, rd.toBson() );
+    }
+
+    TEST(CompressedRecordStoreV1, UpdateInPlaceWhenCompressedDocumentFits) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md =
+            new DummyRecordStoreV1MetaData( false, RecordStoreV1Base::Flag_Compressed );
+        CompressedRecordStoreV1 rs( &txn, "test.foo", md, &em );
+
+        BSONObj obj = compressibleDoc( 1, 5000 );
+        StatusWith<RecordId> loc = rs.insertRecord( &txn, obj.objdata(), obj.objsize(), false );
+        ASSERT_OK( loc.getStatus() );
+        ASSERT_EQUALS( obj, rs.dataFor( &txn, loc.getValue() ).toBson() );
+
+        // Longer, but compresses to about the same size.
+        BSONObj newObj = compressibleDoc( 1, 6000 );
+        RecordingMoveNotifier notifier;
+        StatusWith<RecordId> newLoc = rs.updateRecord( &txn,
+                                                       loc.getValue(),
+                                                       newObj.objdata(),
+                                                       newObj.objsize(),
+                                                       false,
+                                                       &notifier );
+        ASSERT_OK( newLoc.getStatus() );
+        ASSERT_EQUALS( loc.getValue(), newLoc.getValue() );
+        ASSERT_EQUALS( 0U, notifier.moved.size() );
+
+        // Not the cached copy of the old document.
+        ASSERT_EQUALS( newObj, rs.dataFor( &txn, loc.getValue() ).toBson() );
+    }
+
+    TEST(CompressedRecordStoreV1, UpdateMovesWhenCompressedDocumentGrows) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md =
+            new DummyRecordStoreV1MetaData( false, RecordStoreV1Base::Flag_Compressed );
+        CompressedRecordStoreV1 rs( &txn, "test.foo", md, &em );
+
+        BSONObj obj = compressibleDoc( 1, 5000 );
+        StatusWith<RecordId> loc = rs.insertRecord( &txn, obj.objdata(), obj.objsize(), false );
+        ASSERT_OK( loc.getStatus() );
+        ASSERT_EQUALS( obj, rs.dataFor( &txn, loc.getValue() ).toBson() );
+
+        BSONObj newObj = incompressibleDoc( 1, 5000 );
+        RecordingMoveNotifier notifier;
+        StatusWith<RecordId> newLoc = rs.updateRecord( &txn,
+                                                       loc.getValue(),
+                                                       newObj.objdata(),
+                                                       newObj.objsize(),
+                                                       false,
+                                                       &notifier );
+        ASSERT_OK( newLoc.getStatus() );
+        ASSERT_NOT_EQUALS( loc.getValue(), newLoc.getValue() );
+        ASSERT_EQUALS( 1, rs.numRecords( &txn ) );
+
+        // The notifier sees the old document, not its compressed record.
+        ASSERT_EQUALS( 1U, notifier.moved.size() );
+        ASSERT_EQUALS( obj, notifier.moved[0] );
+
+        ASSERT_EQUALS( newObj, rs.dataFor( &txn, newLoc.getValue() ).toBson() );
+    }
+
+    TEST(CompressedRecordStoreV1, NoDamageUpdatesOrCompaction) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md =
+            new DummyRecordStoreV1MetaData( false, RecordStoreV1Base::Flag_Compressed );
+        CompressedRecordStoreV1 rs( &txn, "test.foo", md, &em );
+
+        ASSERT_FALSE( rs.updateWithDamagesSupported() );
+        ASSERT_FALSE( rs.compactSupported() );
+        ASSERT_FALSE( rs.compactIncrementalSupported() );
+    }
+
+}
@@ -34,6 +34,8 @@
 
 #include "mongo/db/storage/mmap_v1/record_store_v1_simple.h"
 
+#include <algorithm>
+
 #include "mongo/base/counter.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/curop.h"
@@ -42,6 +44,7 @@
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
 #include "mongo/db/storage/mmap_v1/record.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/record_store_v1_simple_iterator.h"
 #include "mongo/util/log.h"
 #include "mongo/util/progress_meter.h"
@@ -51,6 +54,10 @@
 
 namespace mongo {
 
+    // Collections with more records than this are not coalesced, since the pass reads every
+    // record header and journals a write for each free run.
+    MONGO_EXPORT_SERVER_PARAMETER(freelistCoalesceMaxRecords, int, 100 * 1000);
+
     static Counter64 freelistAllocs;
     static Counter64 freelistBucketExhausted;
     static Counter64 freelistIterations;
@@ -65,6 +72,11 @@ namespace mongo {
     static ServerStatusMetricField<Counter64> dFreelist3( "storage.freelist.search.scanned",
                                                           &freelistIterations );
 
+    static Counter64 freelistCoalescePasses;
+
+    static ServerStatusMetricField<Counter64> dFreelist4( "storage.freelist.coalesce.passes",
+                                                          &freelistCoalescePasses );
+
     SimpleRecordStoreV1::SimpleRecordStoreV1( OperationContext* txn,
                                               const StringData& ns,
                                               RecordStoreV1MetaData* details,
@@ -74,6 +86,7 @@ namespace mongo {
 
         invariant( !details->isCapped() );
         _normalCollection = NamespaceString::normal( ns );
+        _mayCoalesce = true;
     }
 
     SimpleRecordStoreV1::~SimpleRecordStoreV1() {
@@ -158,6 +171,17 @@ namespace mongo {
         if ( !loc.isNull() )
             return StatusWith<DiskLoc>( loc );
 
+        // Before growing, see whether merging neighboring free space makes room. Index
+        // namespaces are skipped since their extents may start with alignment padding.
+        if ( _mayCoalesce &&
+             _normalCollection &&
+             _details->numRecords() <= freelistCoalesceMaxRecords ) {
+            _coalesceDeletedRecords( txn );
+            loc = _allocFromExistingExtents( txn, lengthWithHeaders );
+            if ( !loc.isNull() )
+                return StatusWith<DiskLoc>( loc );
+        }
+
         LOG(1) << "allocating new extent";
 
         increaseStorageSize( txn,
@@ -191,6 +215,11 @@ namespace mongo {
         return StatusWith<DiskLoc>( ErrorCodes::InternalError, "cannot allocate space" );
     }
 
+    void SimpleRecordStoreV1::deleteRecord( OperationContext* txn, const RecordId& dl ) {
+        RecordStoreV1Base::deleteRecord( txn, dl );
+        _mayCoalesce = true;
+    }
+
     Status SimpleRecordStoreV1::truncate(OperationContext* txn) {
         const DiskLoc firstExtLoc = _details->firstExtent(txn);
         if (firstExtLoc.isNull() || !firstExtLoc.isValid()) {
@@ -215,6 +244,7 @@ namespace mongo {
         }
 
         // Make the first (now only) extent a single large deleted record.
+        _setIncrementalCompactExtent(txn, DiskLoc());
         *txn->recoveryUnit()->writing(&firstExt->firstRecord) = DiskLoc();
         *txn->recoveryUnit()->writing(&firstExt->lastRecord) = DiskLoc();
         _details->orphanDeletedList(txn);
@@ -231,11 +261,62 @@ namespace mongo {
 
         DEBUGGING log() << "TEMP: add deleted rec " << dloc.toString() << ' ' << hex << d->extentOfs() << endl;
 
+        if ( !_incrementalCompactExtent.isNull() &&
+             DiskLoc( dloc.a(), d->extentOfs() ) == _incrementalCompactExtent ) {
+            // Being emptied; the space is reclaimed along with the whole extent.
+            return;
+        }
+
         int b = bucket(d->lengthWithHeaders());
         *txn->recoveryUnit()->writing(&d->nextDeleted()) = _details->deletedListEntry(b);
         _details->setDeletedListEntry(txn, b, dloc);
     }
 
+    void SimpleRecordStoreV1::_coalesceDeletedRecords( OperationContext* txn ) {
+        freelistCoalescePasses.increment();
+
+        // Everything in an extent that is not a record is free, whether or not it is on a
+        // deleted list, so rebuild the lists from the gaps between the records.
+        _details->orphanDeletedList( txn );
+
+        vector< pair<int, int> > records; // offset and length of each record in the extent
+        const Extent* ext;
+        for ( DiskLoc extLoc = _details->firstExtent(txn); !extLoc.isNull(); extLoc = ext->xnext ) {
+            ext = _getExtent( txn, extLoc );
+
+            records.clear();
+            for ( DiskLoc recLoc = ext->firstRecord;
+                  !recLoc.isNull();
+                  recLoc = getNextRecordInExtent( txn, recLoc ) ) {
+                records.push_back( make_pair( recLoc.getOfs(),
+                                              recordFor( recLoc )->lengthWithHeaders() ) );
+            }
+            std::sort( records.begin(), records.end() );
+
+            const int extentEnd = extLoc.getOfs() + ext->length;
+            int freeStart = extLoc.getOfs() + Extent::HeaderSize();
+            for ( size_t i = 0; i <= records.size(); i++ ) {
+                const int freeEnd = i < records.size() ? records[i].first : extentEnd;
+                const int freeLength = freeEnd - freeStart;
+
+                // Gaps smaller than the smallest bucket stay unused, as when splitting.
+                if ( freeLength >= bucketSizes[0] ) {
+                    const DiskLoc freeLoc( extLoc.a(), freeStart );
+                    DeletedRecord* d = txn->recoveryUnit()->writing( drec( freeLoc ) );
+                    d->lengthWithHeaders() = freeLength;
+                    d->extentOfs() = extLoc.getOfs();
+                    d->nextDeleted().Null();
+                    addDeletedRec( txn, freeLoc );
+                }
+
+                if ( i < records.size() )
+                    freeStart = records[i].first + records[i].second;
+            }
+        }
+
+        _mayCoalesce = false;
+    }
+
     RecordIterator* SimpleRecordStoreV1::getIterator( OperationContext* txn,
                                                       const RecordId& start,
                                                       const CollectionScanParams::Direction& dir) const {
@@ -287,6 +368,35 @@ namespace mongo {
         size_t _allocationSize;
     };
 
+    unsigned SimpleRecordStoreV1::_compactAllocationSize( const Record* recOld,
+                                                          unsigned rawDataSize,
+                                                          const CompactOptions* compactOptions ) const {
+        // Allocation sizes include the headers and possibly some padding.
+        const unsigned minAllocationSize = rawDataSize + Record::HeaderSize;
+        unsigned allocationSize = minAllocationSize;
+        switch( compactOptions->paddingMode ) {
+        case CompactOptions::NONE: // default padding
+            if (shouldPadInserts()) {
+                allocationSize = quantizeAllocationSpace(minAllocationSize);
+            }
+            break;
+
+        case CompactOptions::PRESERVE: // keep original padding
+            allocationSize = recOld->lengthWithHeaders();
+            break;
+
+        case CompactOptions::MANUAL: // user specified how much padding to use
+            allocationSize = compactOptions->computeRecordSize(minAllocationSize);
+            if (allocationSize < minAllocationSize
+                    || allocationSize > BSONObjMaxUserSize / 2 ) {
+                allocationSize = minAllocationSize;
+            }
+            break;
+        }
+        invariant(allocationSize >= minAllocationSize);
+        return allocationSize;
+    }
+
     void SimpleRecordStoreV1::_compactExtent(OperationContext* txn,
                                              const DiskLoc extentLoc,
                                              int extentNumber,
@@ -346,29 +456,8 @@ namespace mongo {
                     oldObjSize += rawDataSize;
                     oldObjSizeWithPadding += recOld->netLength();
 
-                    // Allocation sizes include the headers and possibly some padding.
-                    const unsigned minAllocationSize = rawDataSize + Record::HeaderSize;
-                    unsigned allocationSize = minAllocationSize;
-                    switch( compactOptions->paddingMode ) {
-                    case CompactOptions::NONE: // default padding
-                        if (shouldPadInserts()) {
-                            allocationSize = quantizeAllocationSpace(minAllocationSize);
-                        }
-                        break;
-
-                    case CompactOptions::PRESERVE: // keep original padding
-                        allocationSize = recOld->lengthWithHeaders();
-                        break;
-
-                    case CompactOptions::MANUAL: // user specified how much padding to use
-                        allocationSize = compactOptions->computeRecordSize(minAllocationSize);
-                        if (allocationSize < minAllocationSize
-                                || allocationSize > BSONObjMaxUserSize / 2 ) {
-                            allocationSize = minAllocationSize;
-                        }
-                        break;
-                    }
-                    invariant(allocationSize >= minAllocationSize);
+                    const unsigned allocationSize =
+                        _compactAllocationSize( recOld, rawDataSize, compactOptions );
 
                     // Copy the data to a new record. Because we orphaned the record freelist at the
                     // start of the compact, this insert will allocate a record in a new extent.
@@ -457,6 +546,12 @@ namespace mongo {
             log() << "compact orphan deleted lists" << endl;
             _details->orphanDeletedList(txn);
 
+            // Coalescing would hand the space in the old extents back to the inserts below.
+            _mayCoalesce = false;
+
+            // Every extent is emptied below, so there is no need to keep any off the lists.
+            _setIncrementalCompactExtent(txn, DiskLoc());
+
             // Start over from scratch with our extent sizing and growth
             _details->setLastExtentSize( txn, 0 );
 
@@ -489,4 +584,158 @@ namespace mongo {
         return Status::OK();
     }
 
+    class SimpleRecordStoreV1::SetIncrementalCompactExtentChange : public RecoveryUnit::Change {
+    public:
+        SetIncrementalCompactExtentChange(SimpleRecordStoreV1* rs, DiskLoc oldLoc)
+            : _rs(rs)
+            , _oldLoc(oldLoc)
+        {}
+
+        virtual void commit() {}
+        virtual void rollback() { _rs->_incrementalCompactExtent = _oldLoc; }
+
+    private:
+        SimpleRecordStoreV1* const _rs;
+        const DiskLoc _oldLoc;
+    };
+
+    void SimpleRecordStoreV1::_setIncrementalCompactExtent( OperationContext* txn,
+                                                            const DiskLoc& extentLoc ) {
+        if ( _incrementalCompactExtent == extentLoc )
+            return;
+        txn->recoveryUnit()->registerChange(
+            new SetIncrementalCompactExtentChange( this, _incrementalCompactExtent ) );
+        _incrementalCompactExtent = extentLoc;
+    }
+
+    DiskLoc SimpleRecordStoreV1::_pickIncrementalCompactExtent(
+            OperationContext* txn,
+            const CompactOptions* options ) const {
+        const DiskLoc lastExtentLoc = _details->lastExtent(txn);
+
+        DiskLoc best;
+        double bestFill = options->maxExtentFill;
+        const Extent* ext;
+        for ( DiskLoc extLoc = _details->firstExtent(txn);
+              extLoc != lastExtentLoc;
+              extLoc = ext->xnext ) {
+            ext = _getExtent( txn, extLoc );
+
+            long long used = 0;
+            for ( DiskLoc recLoc = ext->firstRecord;
+                  !recLoc.isNull();
+                  recLoc = getNextRecordInExtent( txn, recLoc ) ) {
+                used += recordFor( recLoc )->lengthWithHeaders();
+            }
+
+            const double fill = static_cast<double>( used ) / ( ext->length - Extent::HeaderSize() );
+            if ( fill < bestFill ) {
+                best = extLoc;
+                bestFill = fill;
+            }
+        }
+
+        return best;
+    }
+
+    void SimpleRecordStoreV1::_freeEmptyExtent( OperationContext* txn, const DiskLoc& extentLoc ) {
+        Extent* const ext = _extentManager->getExtent( extentLoc );
+        invariant( ext->firstRecord.isNull() );
+        invariant( ext->lastRecord.isNull() );
+        invariant( !ext->xnext.isNull() );
+
+        *txn->recoveryUnit()->writing(&_extentManager->getExtent( ext->xnext )->xprev) = ext->xprev;
+        if ( ext->xprev.isNull() ) {
+            _details->setFirstExtent( txn, ext->xnext );
+        }
+        else {
+            *txn->recoveryUnit()->writing(&_extentManager->getExtent( ext->xprev )->xnext) =
+                ext->xnext;
+        }
+
+        _extentManager->freeExtent( txn, extentLoc );
+    }
+
+    Status SimpleRecordStoreV1::compactIncremental( OperationContext* txn,
+                                                    RecordStoreCompactAdaptor* adaptor,
+                                                    UpdateMoveNotifier* notifier,
+                                                    const CompactOptions* options,
+                                                    int maxRecords,
+                                                    CompactStats* stats,
+                                                    bool* done ) {
+        *done = false;
+
+        if ( _incrementalCompactExtent.isNull() ) {
+            const DiskLoc extentLoc = _pickIncrementalCompactExtent( txn, options );
+            if ( extentLoc.isNull() ) {
+                *done = true;
+                return Status::OK();
+            }
+
+            LOG(1) << "incremental compact of " << _ns << " emptying extent " << extentLoc;
+
+            // Rebuilding the deleted lists leaves out the free space in the chosen extent, so
+            // the copies made below, and any other inserts, go elsewhere.
+            WriteUnitOfWork wunit(txn);
+            _setIncrementalCompactExtent( txn, extentLoc );
+            _coalesceDeletedRecords( txn );
+            wunit.commit();
+        }
+
+        Extent* const sourceExtent = _extentManager->getExtent( _incrementalCompactExtent );
+        for ( int i = 0; i < maxRecords && !sourceExtent->firstRecord.isNull(); i++ ) {
+            txn->checkForInterrupt();
+
+            WriteUnitOfWork wunit(txn);
+            const DiskLoc oldLoc = sourceExtent->firstRecord;
+            const Record* recOld = recordFor( oldLoc );
+            const RecordData oldData = recOld->toRecordData();
+
+            if ( options->validateDocuments && !adaptor->isDataValid( oldData ) ) {
+                // Unlike compact(), never drop documents from a collection that is in use.
+                return Status( ErrorCodes::InvalidBSON,
+                               str::stream() << "incremental compact found a corrupt document at "
+                                             << oldLoc.toString() << " in " << _ns );
+            }
+
+            const unsigned rawDataSize = adaptor->dataSize( oldData );
+            CompactDocWriter writer( recOld,
+                                     rawDataSize,
+                                     _compactAllocationSize( recOld, rawDataSize, options ) );
+            StatusWith<RecordId> newLocation = insertRecord( txn, &writer, false );
+            if ( !newLocation.isOK() )
+                return newLocation.getStatus();
+
+            const DiskLoc newLoc = DiskLoc::fromRecordId( newLocation.getValue() );
+            const Record* newRec = recordFor( newLoc );
+            invariant( newRec->myExtentLoc( newLoc ) != _incrementalCompactExtent );
+
+            Status status = notifier->recordStoreGoingToMove( txn,
+                                                              oldLoc.toRecordId(),
+                                                              recOld->data(),
+                                                              recOld->netLength() );
+            if ( !status.isOK() )
+                return status;
+
+            deleteRecord( txn, oldLoc.toRecordId() );
+            adaptor->inserted( newRec->toRecordData(), newLocation.getValue() );
+
+            wunit.commit();
+            stats->recordsMoved++;
+        }
+
+        if ( sourceExtent->firstRecord.isNull() ) {
+            LOG(1) << "incremental compact of " << _ns << " freeing extent "
+                   << _incrementalCompactExtent;
+
+            WriteUnitOfWork wunit(txn);
+            _freeEmptyExtent( txn, _incrementalCompactExtent );
+            _setIncrementalCompactExtent( txn, DiskLoc() );
+            wunit.commit();
+            stats->extentsFreed++;
+        }
+
+        return Status::OK();
+    }
+
 }
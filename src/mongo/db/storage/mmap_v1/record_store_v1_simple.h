@@ -55,6 +55,8 @@ namespace mongo {
 
         virtual std::vector<RecordIterator*> getManyIterators(OperationContext* txn) const;
 
+        virtual void deleteRecord( OperationContext* txn, const RecordId& dl );
+
         virtual Status truncate(OperationContext* txn);
 
         virtual void temp_cappedTruncateAfter(OperationContext* txn, RecordId end, bool inclusive) {
@@ -67,6 +69,21 @@ namespace mongo {
                                 const CompactOptions* options,
                                 CompactStats* stats );
 
+        virtual bool compactIncrementalSupported() const { return true; }
+
+        /**
+         * Empties the least used extent, other than the last, a few records at a time, and
+         * returns it to the extent manager once nothing is left in it.  Picking an extent reads
+         * every record header in the store, so is done once per extent rather than per batch.
+         */
+        virtual Status compactIncremental( OperationContext* txn,
+                                           RecordStoreCompactAdaptor* adaptor,
+                                           UpdateMoveNotifier* notifier,
+                                           const CompactOptions* options,
+                                           int maxRecords,
+                                           CompactStats* stats,
+                                           bool* done );
+
     protected:
         virtual bool isCapped() const { return false; }
         virtual bool shouldPadInserts() const { return !_details->isUserFlagSet(Flag_NoPadding); }
@@ -78,9 +95,17 @@ namespace mongo {
         virtual void addDeletedRec(OperationContext* txn,
                                    const DiskLoc& dloc);
     private:
+        class SetIncrementalCompactExtentChange;
+
         DiskLoc _allocFromExistingExtents( OperationContext* txn,
                                            int lengthWithHeaders );
 
+        /**
+         * Rebuilds the deleted lists so that each run of adjacent free space in an extent is a
+         * single DeletedRecord, reclaiming fragments too small to have been kept on their own.
+         */
+        void _coalesceDeletedRecords( OperationContext* txn );
+
         void _compactExtent(OperationContext* txn,
                             const DiskLoc diskloc,
                             int extentNumber,
@@ -88,8 +113,41 @@ namespace mongo {
                             const CompactOptions* compactOptions,
                             CompactStats* stats );
 
+        /**
+         * Size, including headers, of the new record compaction allocates for a copy of 'recOld'
+         * holding 'rawDataSize' bytes of data.
+         */
+        unsigned _compactAllocationSize( const Record* recOld,
+                                         unsigned rawDataSize,
+                                         const CompactOptions* compactOptions ) const;
+
+        /**
+         * Returns the extent with the smallest fraction of its space in use, if below
+         * options->maxExtentFill, or a null DiskLoc.  The last extent is never picked.
+         */
+        DiskLoc _pickIncrementalCompactExtent( OperationContext* txn,
+                                               const CompactOptions* options ) const;
+
+        void _setIncrementalCompactExtent( OperationContext* txn, const DiskLoc& extentLoc );
+
+        /**
+         * Unlinks an empty extent, which must not be the last, and returns it to the extent
+         * manager.
+         */
+        void _freeEmptyExtent( OperationContext* txn, const DiskLoc& extentLoc );
+
         bool _normalCollection;
 
+        // False once the deleted lists have been coalesced, until a record is deleted again.
+        // Only kept in memory, so the first allocation that needs a new extent after startup
+        // always coalesces.
+        bool _mayCoalesce;
+
+        // The extent compactIncremental() is emptying, or null.  Free space in it is kept off the
+        // deleted lists so nothing is allocated there.  Only kept in memory; if it is forgotten
+        // the free space in the extent is recovered by the next coalescing pass.
+        DiskLoc _incrementalCompactExtent;
+
         friend class SimpleRecordStoreV1Iterator;
     };
 
@@ -30,6 +30,7 @@
 
 #include "mongo/db/storage/mmap_v1/record_store_v1_simple.h"
 
+#include "mongo/db/catalog/collection.h"
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/storage/mmap_v1/extent.h"
 #include "mongo/db/storage/mmap_v1/record.h"
@@ -498,6 +499,153 @@ namespace {
         }
     }
 
+    /**
+     * alloc() merges adjacent free space before allocating a new extent
+     */
+    TEST(SimpleRecordStoreV1, AllocCoalescesBeforeGrowing) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 512},
+                {DiskLoc(0, 1712), 512},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1512), 100},
+                {DiskLoc(0, 1612), 100},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, NULL, &em, md);
+        }
+        const int extentLength = em.getExtent(DiskLoc(0, 0))->length;
+
+        BsonDocWriter docWriter(docForRecordSize( 200 ), false);
+        StatusWith<RecordId> actualLocation = rs.insertRecord(&txn, &docWriter, false);
+        ASSERT_OK( actualLocation.getStatus() );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 512},
+                {DiskLoc(0, 1712), 512},
+                {DiskLoc(0, 1512), 200},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, Extent::HeaderSize()), 1000 - Extent::HeaderSize()},
+                {DiskLoc(0, 2224), extentLength - 2224},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, NULL, &em, md);
+        }
+    }
+
+    // -----------------
+
+    class RecordingCompactAdaptor : public RecordStoreCompactAdaptor {
+    public:
+        virtual bool isDataValid( const RecordData& recData ) { return true; }
+        virtual size_t dataSize( const RecordData& recData ) { return recData.size(); }
+        virtual void inserted( const RecordData& recData, const RecordId& newLocation ) {
+            newLocations.push_back( newLocation );
+        }
+
+        std::vector<RecordId> newLocations;
+    };
+
+    class RecordingMoveNotifier : public UpdateMoveNotifier {
+    public:
+        virtual Status recordStoreGoingToMove( OperationContext* txn,
+                                               const RecordId& oldLocation,
+                                               const char* oldBuffer,
+                                               size_t oldSize ) {
+            moved.push_back( oldLocation );
+            return Status::OK();
+        }
+
+        std::vector<RecordId> moved;
+    };
+
+    /**
+     * compactIncremental() moves the records out of a sparse extent and frees it
+     */
+    TEST(SimpleRecordStoreV1, CompactIncrementalEmptiesSparseExtent) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(1, 1000), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(1, 1100), 1000},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, NULL, &em, md);
+        }
+
+        CompactOptions options;
+        CompactStats stats;
+        RecordingCompactAdaptor adaptor;
+        RecordingMoveNotifier notifier;
+        bool done = false;
+
+        ASSERT_OK( rs.compactIncremental( &txn, &adaptor, &notifier, &options, 10, &stats, &done ) );
+        ASSERT_FALSE( done );
+        ASSERT_EQUALS( 1, stats.recordsMoved );
+        ASSERT_EQUALS( 1, stats.extentsFreed );
+
+        ASSERT_EQUALS( 1U, notifier.moved.size() );
+        ASSERT_EQUALS( DiskLoc(0, 1000), DiskLoc::fromRecordId( notifier.moved[0] ) );
+        ASSERT_EQUALS( 1U, adaptor.newLocations.size() );
+        ASSERT_EQUALS( 1, DiskLoc::fromRecordId( adaptor.newLocations[0] ).a() );
+
+        ASSERT_EQUALS( DiskLoc(1, 0), md->firstExtent( &txn ) );
+        ASSERT_EQUALS( 2, md->numRecords() );
+
+        // Only the last extent is left, and that is never emptied.
+        ASSERT_OK( rs.compactIncremental( &txn, &adaptor, &notifier, &options, 10, &stats, &done ) );
+        ASSERT_TRUE( done );
+        ASSERT_EQUALS( 1, stats.recordsMoved );
+    }
+
+    /**
+     * compactIncremental() leaves extents that are mostly in use alone
+     */
+    TEST(SimpleRecordStoreV1, CompactIncrementalSkipsFullExtents) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 1000},
+                {DiskLoc(1, 1000), 100},
+                {}
+            };
+            initializeV1RS(&txn, recs, NULL, NULL, &em, md);
+        }
+
+        CompactOptions options;
+        CompactStats stats;
+        RecordingCompactAdaptor adaptor;
+        RecordingMoveNotifier notifier;
+        bool done = false;
+
+        ASSERT_OK( rs.compactIncremental( &txn, &adaptor, &notifier, &options, 10, &stats, &done ) );
+        ASSERT_TRUE( done );
+        ASSERT_EQUALS( 0, stats.recordsMoved );
+        ASSERT_EQUALS( DiskLoc(0, 0), md->firstExtent( &txn ) );
+    }
+
     // -----------------
 
     TEST( SimpleRecordStoreV1, FullSimple1 ) {
@@ -37,6 +37,7 @@
 #include "mongo/bson/optime.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/storage/record_store.h"
 
 namespace mongo {
 namespace oploghack {
@@ -76,5 +77,15 @@ namespace oploghack {
         return keyForOptime(elem._opTime());
     }
 
+    boost::optional<RecordId> seekToOptime(OperationContext* txn,
+                                           const RecordStore* rs,
+                                           const OpTime& opTime) {
+        const StatusWith<RecordId> key = keyForOptime(opTime);
+        if (!key.isOK())
+            return boost::none;
+
+        return rs->oplogStartHack(txn, key.getValue());
+    }
+
 }  // namespace oploghack
 } // namespace mongo
@@ -28,12 +28,16 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
+
 #include "mongo/base/status.h"
 #include "mongo/base/status_with.h"
 
 namespace mongo {
-    class RecordId;
+    class OperationContext;
     class OpTime;
+    class RecordId;
+    class RecordStore;
 
 namespace oploghack {
 
@@ -48,5 +52,18 @@ namespace oploghack {
      */
     StatusWith<RecordId> extractKey(const char* data, int len);
 
+    /**
+     * Seeks the oplog "rs" to "opTime": returns the RecordId of the latest entry whose ts is not
+     * after "opTime", or RecordId() if there is no such entry. Storage engines which key their
+     * oplog by ts answer this with a single seek in their ordered RecordId index through
+     * RecordStore::oplogStartHack().
+     *
+     * Returns boost::none if "rs" cannot seek by ts, or "opTime" cannot be a key, in which case
+     * callers fall back to the OplogStart stage.
+     */
+    boost::optional<RecordId> seekToOptime(OperationContext* txn,
+                                           const RecordStore* rs,
+                                           const OpTime& opTime);
+
 }  // namespace oploghack
 }  // namespace mongo
@@ -0,0 +1,332 @@
+// page_cache_warmer.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/page_cache_warmer.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/scoped_array.hpp>
+#include <cctype>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mongo/bson/bson_validate.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/util/background.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    // Seconds between recordings of the data file ranges in the page cache, 0 to neither record
+    // them nor read them back in at startup.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(pageCacheWarmerIntervalSecs, int, 300);
+
+#if !defined(_WIN32)
+namespace {
+
+    namespace fs = boost::filesystem;
+
+    const char kHotRangesFileName[] = "mongod.hotranges";
+
+    // Data files are recorded and read back in chunks of this size.
+    const size_t kChunkBytes = 1024 * 1024;
+
+    // A chunk is recorded once this share of its pages is in the page cache.
+    const size_t kMinResidentPagesPercent = 25;
+
+    // Leaves room in the mongod.hotranges document once this many bytes of ranges are recorded.
+    const int kMaxRangesBytes = 8 * 1024 * 1024;
+
+    /**
+     * Files holding collection and index data: mmapv1's .ns and numbered files and WiredTiger's
+     * .wt files. Anything else under the dbpath, such as the journal, is left alone.
+     */
+    bool isDataFile(const fs::path& path) {
+        const std::string name = path.filename().string();
+        const size_t dot = name.rfind('.');
+        if (dot == std::string::npos || dot + 1 == name.size()) {
+            return false;
+        }
+
+        const std::string extension = name.substr(dot + 1);
+        if (extension == "ns" || extension == "wt") {
+            return true;
+        }
+        for (size_t i = 0; i < extension.size(); i++) {
+            if (!isdigit(static_cast<unsigned char>(extension[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void listDataFiles(const fs::path& dir, std::vector<fs::path>* files) {
+        boost::system::error_code ec;
+        for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            const fs::path& path = it->path();
+            if (fs::is_directory(path, ec)) {
+                if (path.filename() != "journal") {
+                    listDataFiles(path, files);
+                }
+            }
+            else if (fs::is_regular_file(path, ec) && isDataFile(path)) {
+                files->push_back(path);
+            }
+        }
+    }
+
+    /**
+     * Appends {file, offset, length} for each run of chunks of 'path' that are mostly in the
+     * page cache. Returns false once the ranges reach kMaxRangesBytes.
+     */
+    bool appendResidentRanges(const fs::path& path,
+                              const std::string& fileName,
+                              BSONArrayBuilder* ranges) {
+        const int fd = open(path.string().c_str(), O_RDONLY);
+        if (fd < 0) {
+            return true;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return true;
+        }
+
+        const size_t fileBytes = st.st_size;
+        void* view = mmap(NULL, fileBytes, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (view == MAP_FAILED) {
+            return true;
+        }
+
+        const size_t pageSize = ProcessInfo::getPageSize();
+        const size_t numPages = (fileBytes + pageSize - 1) / pageSize;
+        std::vector<char> resident;
+        const bool ok = ProcessInfo::pagesInMemory(view, numPages, &resident);
+        munmap(view, fileBytes);
+        if (!ok) {
+            return true;
+        }
+
+        const size_t pagesPerChunk = kChunkBytes / pageSize;
+        long long rangeStart = -1;
+        for (size_t chunk = 0; chunk * pagesPerChunk < numPages; chunk++) {
+            const size_t firstPage = chunk * pagesPerChunk;
+            const size_t endPage = std::min(firstPage + pagesPerChunk, numPages);
+
+            size_t residentPages = 0;
+            for (size_t page = firstPage; page < endPage; page++) {
+                residentPages += resident[page] ? 1 : 0;
+            }
+
+            const bool hot =
+                residentPages * 100 >= (endPage - firstPage) * kMinResidentPagesPercent;
+            if (hot && rangeStart < 0) {
+                rangeStart = firstPage * pageSize;
+            }
+            if (!hot && rangeStart >= 0) {
+                ranges->append(BSON("file" << fileName <<
+                                    "offset" << rangeStart <<
+                                    "length" << static_cast<long long>(firstPage * pageSize) -
+                                                rangeStart));
+                rangeStart = -1;
+                if (ranges->len() > kMaxRangesBytes) {
+                    return false;
+                }
+            }
+        }
+        if (rangeStart >= 0) {
+            ranges->append(BSON("file" << fileName <<
+                                "offset" << rangeStart <<
+                                "length" << static_cast<long long>(fileBytes) - rangeStart));
+        }
+        return ranges->len() <= kMaxRangesBytes;
+    }
+
+    /**
+     * Replaces mongod.hotranges with the ranges of the data files now in the page cache.
+     */
+    void recordHotRanges() {
+        const fs::path dbpath(storageGlobalParams.dbpath);
+
+        std::vector<fs::path> files;
+        listDataFiles(dbpath, &files);
+
+        BSONObjBuilder builder;
+        builder.append("recorded", jsTime());
+        BSONArrayBuilder ranges(builder.subarrayStart("ranges"));
+        const size_t prefixLength = dbpath.string().size() + 1;
+        for (size_t i = 0; i < files.size() && !inShutdown(); i++) {
+            if (!appendResidentRanges(files[i], files[i].string().substr(prefixLength), &ranges)) {
+                break;
+            }
+        }
+        ranges.done();
+        const BSONObj obj = builder.obj();
+
+        // Write the new list aside first, so a crash never leaves half of one behind.
+        const fs::path path = dbpath / kHotRangesFileName;
+        const fs::path tmpPath = dbpath / (std::string(kHotRangesFileName) + ".tmp");
+        {
+            std::ofstream out(tmpPath.string().c_str(), std::ios::out | std::ios::binary);
+            out.write(obj.objdata(), obj.objsize());
+            if (!out.good()) {
+                warning() << "failed to write " << tmpPath.string();
+                return;
+            }
+        }
+        boost::system::error_code ec;
+        fs::rename(tmpPath, path, ec);
+        if (ec) {
+            warning() << "failed to rename " << tmpPath.string() << ": " << ec.message();
+        }
+    }
+
+    /**
+     * Reads back in the ranges recorded in mongod.hotranges by an earlier run.
+     */
+    void warmHotRanges() {
+        const fs::path dbpath(storageGlobalParams.dbpath);
+        const fs::path path = dbpath / kHotRangesFileName;
+
+        std::ifstream in(path.string().c_str(), std::ios::in | std::ios::binary);
+        if (!in.is_open()) {
+            return;
+        }
+        in.seekg(0, std::ios::end);
+        const std::streamoff size = in.tellg();
+        if (size < 5 || size > BSONObjMaxInternalSize) {
+            return;
+        }
+        in.seekg(0, std::ios::beg);
+        boost::scoped_array<char> data(new char[size]);
+        in.read(data.get(), size);
+        if (!in.good() || !validateBSON(data.get(), size).isOK()) {
+            warning() << "ignoring invalid " << path.string();
+            return;
+        }
+        const BSONObj obj(data.get());
+
+        Date_t start = jsTime();
+        long long bytesRead = 0;
+        boost::scoped_array<char> buffer(new char[kChunkBytes]);
+        std::string openFileName;
+        int fd = -1;
+
+        BSONObjIterator it(obj.getObjectField("ranges"));
+        while (it.more() && !inShutdown()) {
+            const BSONObj range = it.next().Obj();
+            const std::string fileName = range["file"].str();
+
+            if (fileName != openFileName) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+                openFileName = fileName;
+                fd = open((dbpath / fileName).string().c_str(), O_RDONLY);
+            }
+            if (fd < 0) {
+                continue;
+            }
+
+            long long offset = range["offset"].numberLong();
+            const long long end = offset + range["length"].numberLong();
+            while (offset < end && !inShutdown()) {
+                const ssize_t n = pread(fd, buffer.get(),
+                                        std::min(static_cast<long long>(kChunkBytes),
+                                                 end - offset),
+                                        offset);
+                if (n <= 0) {
+                    break;
+                }
+                offset += n;
+                bytesRead += n;
+            }
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        log() << "read " << bytesRead / (1024 * 1024) << "MB of data files recorded in "
+              << kHotRangesFileName << " into the page cache in "
+              << (jsTime() - start) / 1000 << " seconds";
+    }
+
+    class PageCacheWarmer : public BackgroundJob {
+    public:
+        PageCacheWarmer() : BackgroundJob(true /* selfDelete */) { }
+
+        virtual std::string name() const { return "PageCacheWarmer"; }
+
+        virtual void run() {
+            warmHotRanges();
+
+            while (!inShutdown()) {
+                for (int i = 0; i < pageCacheWarmerIntervalSecs && !inShutdown(); i++) {
+                    sleepsecs(1);
+                }
+                if (!inShutdown()) {
+                    recordHotRanges();
+                }
+            }
+        }
+    };
+
+} // namespace
+
+    void startPageCacheWarmer() {
+        if (pageCacheWarmerIntervalSecs <= 0 || !ProcessInfo::blockCheckSupported()) {
+            return;
+        }
+        (new PageCacheWarmer())->go();
+    }
+#else
+    void startPageCacheWarmer() { }
+#endif
+
+} // namespace mongo
@@ -0,0 +1,48 @@
+// page_cache_warmer.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+namespace mongo {
+
+    /**
+     * Shortens the time it takes a restarted mongod to reach steady-state latency.
+     *
+     * Every pageCacheWarmerIntervalSecs, a background thread records which ranges of the data
+     * files under the dbpath are in the operating system's page cache, in the mongod.hotranges
+     * file. On startup, it reads those ranges back in sequentially, alongside accepting traffic,
+     * so they don't have to fault in one random page at a time. Both mmapv1, whose data files
+     * are mapped, and WiredTiger, whose reads go through the page cache, benefit.
+     *
+     * Only supported where mincore() is available.
+     */
+    void startPageCacheWarmer();
+
+} // namespace mongo
@@ -31,6 +31,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <vector>
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/bson/mutable/damage_vector.h"
@@ -169,6 +170,31 @@ namespace mongo {
                                                   const DocWriter* doc,
                                                   bool enforceQuota ) = 0;
 
+        /**
+         * Inserts 'records' in order, appending the RecordId of each to 'locsOut'.
+         *
+         * On error, the records inserted before the failure have been appended to 'locsOut'
+         * and the caller must roll back the enclosing WriteUnitOfWork.
+         *
+         * The default implementation calls insertRecord() for each record.  Engines which can
+         * amortize per-record setup across a batch should override it.
+         */
+        virtual Status insertRecords( OperationContext* txn,
+                                      const std::vector<RecordData>& records,
+                                      bool enforceQuota,
+                                      std::vector<RecordId>* locsOut ) {
+            for ( size_t i = 0; i < records.size(); i++ ) {
+                StatusWith<RecordId> loc = insertRecord( txn,
+                                                         records[i].data(),
+                                                         records[i].size(),
+                                                         enforceQuota );
+                if ( !loc.isOK() )
+                    return loc.getStatus();
+                locsOut->push_back( loc.getValue() );
+            }
+            return Status::OK();
+        }
+
         /**
          * @param notifier - this is called if the document is moved
          *                   it is to be called after the document has been written to new
@@ -215,6 +241,23 @@ namespace mongo {
         virtual RecordFetcher* recordNeedsFetch( OperationContext* txn,
                                                  const RecordId& loc ) const { return NULL; }
 
+        /**
+         * Returns true if prefetchRecords() does anything, so that callers know whether it is
+         * worth collecting the RecordIds they are about to read.
+         */
+        virtual bool prefetchSupported() const { return false; }
+
+        /**
+         * Tells the storage engine that the records at 'locs' are about to be read, so that it
+         * can start reading them into memory in the background. This is only a hint: it must not
+         * block on I/O, and the records may have been deleted by the time the hint is acted on.
+         *
+         * Storage engines which support document-level locking read records without yielding,
+         * so this is how they get I/O to overlap with query execution instead.
+         */
+        virtual void prefetchRecords( OperationContext* txn,
+                                      const std::vector<RecordId>& locs ) const { }
+
         /**
          * returned iterator owned by caller
          * Default arguments return all items in record store.
@@ -240,6 +283,17 @@ namespace mongo {
          */
         virtual std::vector<RecordIterator*> getManyIterators( OperationContext* txn ) const = 0;
 
+        /**
+         * Appends up to 'count' records picked at random, possibly more than once, to 'out'.
+         * Fewer are appended only if the store is empty. Returns false, leaving 'out' untouched,
+         * if the store cannot pick records at random.
+         */
+        virtual bool sampleRecords( OperationContext* txn,
+                                    size_t count,
+                                    std::vector<RecordData>* out ) const {
+            return false;
+        }
+
         // higher level
 
 
@@ -266,6 +320,26 @@ namespace mongo {
                                 const CompactOptions* options,
                                 CompactStats* stats ) = 0;
 
+        // does this RecordStore support compactIncremental()
+        virtual bool compactIncrementalSupported() const { return false; }
+
+        /**
+         * Moves at most 'maxRecords' records out of the least used part of the store so that
+         * its space can be reclaimed, without requiring exclusive use of the store between
+         * calls.  For each record, 'notifier' is told the old copy is going away and then
+         * 'adaptor' is told where the new copy is.  Sets *done once nothing is worth moving.
+         */
+        virtual Status compactIncremental( OperationContext* txn,
+                                           RecordStoreCompactAdaptor* adaptor,
+                                           UpdateMoveNotifier* notifier,
+                                           const CompactOptions* options,
+                                           int maxRecords,
+                                           CompactStats* stats,
+                                           bool* done ) {
+            return Status( ErrorCodes::CommandNotSupported,
+                           "incremental compaction not supported by this record store" );
+        }
+
         /**
          * @param full - does more checks
          * @param scanData - scans each document
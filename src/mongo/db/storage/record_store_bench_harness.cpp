@@ -0,0 +1,263 @@
+// record_store_bench_harness.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * Benchmarks of RecordStore operations, run against whichever engine provides
+ * newHarnessHelper() in the program they are linked into.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/record_store_test_harness.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/bson/mutable/damage_vector.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/random.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/unittest/benchmark.h"
+
+namespace mongo {
+namespace {
+
+    using boost::scoped_ptr;
+    using boost::shared_ptr;
+    using unittest::BenchmarkState;
+    using unittest::doNotOptimizeAway;
+
+    // Records in the store before the read and update benchmarks start.
+    const int kNumPreloaded = 10 * 1000;
+
+    const int kRecordSize = 100;
+    const int kScanLength = 100;
+
+    /**
+     * A record store and the operations being measured on it, which may run on several threads
+     * at once. On engines without document-level locking, which rely on the server holding a
+     * collection lock, the operations are serialized by a mutex instead.
+     */
+    class RecordStoreBench {
+    public:
+        typedef void (RecordStoreBench::*Op)(PseudoRandom* random);
+
+        explicit RecordStoreBench(int numPreloaded)
+            : _harness(newHarnessHelper()),
+              _rs(_harness->newNonCappedRecordStore()),
+              _data(kRecordSize - 1, 'x'),
+              _serialize(!_harness->supportsDocLocking()) {
+
+            for (int i = 0; i < numPreloaded; i++) {
+                _locs.push_back(_insert());
+            }
+        }
+
+        void insert(PseudoRandom* random) {
+            _insert();
+        }
+
+        void findRandom(PseudoRandom* random) {
+            const RecordId loc = _pick(random);
+
+            scoped_ptr<OperationContext> txn(_harness->newOperationContext());
+            boost::unique_lock<boost::mutex> lk(_mutex, boost::defer_lock);
+            if (_serialize) {
+                lk.lock();
+            }
+
+            RecordData rd;
+            doNotOptimizeAway(_rs->findRecord(txn.get(), loc, &rd));
+        }
+
+        void scanRandom(PseudoRandom* random) {
+            const RecordId start = _pick(random);
+
+            scoped_ptr<OperationContext> txn(_harness->newOperationContext());
+            boost::unique_lock<boost::mutex> lk(_mutex, boost::defer_lock);
+            if (_serialize) {
+                lk.lock();
+            }
+
+            scoped_ptr<RecordIterator> it(_rs->getIterator(txn.get(), start));
+            int bytes = 0;
+            for (int i = 0; i < kScanLength && !it->isEOF(); i++) {
+                bytes += it->dataFor(it->getNext()).size();
+            }
+            doNotOptimizeAway(bytes);
+        }
+
+        /**
+         * Overwrites a few bytes of a record, through updateWithDamages() where the engine
+         * supports it and by rewriting the whole record where it does not.
+         */
+        void updateRandom(PseudoRandom* random) {
+            const RecordId loc = _pick(random);
+            const std::string newData(kRecordSize - 1, 'a' + random->nextInt32(26));
+
+            scoped_ptr<OperationContext> txn(_harness->newOperationContext());
+            boost::unique_lock<boost::mutex> lk(_mutex, boost::defer_lock);
+            if (_serialize) {
+                lk.lock();
+            }
+
+            WriteUnitOfWork uow(txn.get());
+            if (_rs->updateWithDamagesSupported()) {
+                mutablebson::DamageVector damages(1);
+                damages[0].sourceOffset = 0;
+                damages[0].targetOffset = 10;
+                damages[0].size = 8;
+
+                const RecordData oldRec = _rs->dataFor(txn.get(), loc);
+                invariantOK(_rs->updateWithDamages(txn.get(), loc, oldRec, newData.c_str(),
+                                                   damages));
+            }
+            else {
+                // Same-size updates stay in place, so 'loc' remains valid.
+                invariantOK(_rs->updateRecord(txn.get(), loc, newData.c_str(), kRecordSize,
+                                              false, NULL).getStatus());
+            }
+            uow.commit();
+        }
+
+        /**
+         * 50% point reads, 10% short scans, 25% updates and 15% inserts.
+         */
+        void mixed(PseudoRandom* random) {
+            const int choice = random->nextInt32(100);
+            if (choice < 50) {
+                findRandom(random);
+            }
+            else if (choice < 60) {
+                scanRandom(random);
+            }
+            else if (choice < 85) {
+                updateRandom(random);
+            }
+            else {
+                insert(random);
+            }
+        }
+
+    private:
+        RecordId _insert() {
+            scoped_ptr<OperationContext> txn(_harness->newOperationContext());
+            boost::unique_lock<boost::mutex> lk(_mutex, boost::defer_lock);
+            if (_serialize) {
+                lk.lock();
+            }
+
+            WriteUnitOfWork uow(txn.get());
+            StatusWith<RecordId> res =
+                _rs->insertRecord(txn.get(), _data.c_str(), kRecordSize, false);
+            invariantOK(res.getStatus());
+            uow.commit();
+            return res.getValue();
+        }
+
+        // Only picks among the preloaded records, so that _locs is never written concurrently.
+        RecordId _pick(PseudoRandom* random) const {
+            return _locs[random->nextInt32(_locs.size())];
+        }
+
+        scoped_ptr<HarnessHelper> _harness;
+        scoped_ptr<RecordStore> _rs;
+        std::vector<RecordId> _locs; // the preloaded records
+        const std::string _data;
+        const bool _serialize;
+        boost::mutex _mutex; // only used if _serialize
+    };
+
+    void runInBackground(RecordStoreBench* bench,
+                         RecordStoreBench::Op op,
+                         int32_t seed,
+                         AtomicUInt32* stop) {
+        PseudoRandom random(seed);
+        while (!stop->load()) {
+            (bench->*op)(&random);
+        }
+    }
+
+    /**
+     * Times 'op' on the calling thread while state.threads() - 1 other threads run it too, so
+     * that what is measured is its latency under that much concurrent load.
+     */
+    void runConcurrently(BenchmarkState& state, RecordStoreBench* bench, RecordStoreBench::Op op) {
+        AtomicUInt32 stop;
+        std::vector<shared_ptr<boost::thread> > threads;
+        for (int i = 1; i < state.threads(); i++) {
+            threads.push_back(shared_ptr<boost::thread>(new boost::thread(
+                stdx::bind(runInBackground, bench, op, i, &stop))));
+        }
+
+        PseudoRandom random(0);
+        while (state.keepRunning()) {
+            (bench->*op)(&random);
+        }
+
+        stop.store(1);
+        for (size_t i = 0; i < threads.size(); i++) {
+            threads[i]->join();
+        }
+    }
+
+    BENCHMARK(RecordStore, Insert) {
+        RecordStoreBench bench(0);
+        runConcurrently(state, &bench, &RecordStoreBench::insert);
+    }
+
+    BENCHMARK(RecordStore, PointRead) {
+        RecordStoreBench bench(kNumPreloaded);
+        runConcurrently(state, &bench, &RecordStoreBench::findRandom);
+    }
+
+    BENCHMARK(RecordStore, RangeScan) {
+        RecordStoreBench bench(kNumPreloaded);
+        runConcurrently(state, &bench, &RecordStoreBench::scanRandom);
+    }
+
+    BENCHMARK(RecordStore, UpdateWithDamages) {
+        RecordStoreBench bench(kNumPreloaded);
+        runConcurrently(state, &bench, &RecordStoreBench::updateRandom);
+    }
+
+    BENCHMARK(RecordStore, Mixed) {
+        RecordStoreBench bench(kNumPreloaded);
+        runConcurrently(state, &bench, &RecordStoreBench::mixed);
+    }
+
+}  // namespace
+}  // namespace mongo
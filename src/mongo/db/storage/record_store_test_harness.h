@@ -48,6 +48,12 @@ namespace mongo {
         virtual OperationContext* newOperationContext() {
             return new OperationContextNoop( newRecoveryUnit() );
         }
+
+        /**
+         * Whether the record stores may be used from several threads at once without a
+         * collection lock.
+         */
+        virtual bool supportsDocLocking() { return false; }
     };
 
     HarnessHelper* newHarnessHelper();
@@ -52,6 +52,14 @@ namespace mongo {
         virtual void beingReleasedFromOperationContext() {}
         virtual void beingSetOnOperationContext() {}
 
+        /**
+         * Called when the OperationContext that owns this recovery unit ends. Returns it to the
+         * state of a newly constructed one, so that the client's next OperationContext can use
+         * it instead of a new one, and returns true. Returns false if it must be deleted instead,
+         * which is all that engines not implementing this do.
+         */
+        virtual bool resetForReuse() { return false; }
+
         /**
          * These should be called through WriteUnitOfWork rather than directly.
          *
@@ -37,19 +37,27 @@
 #include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <rocksdb/cache.h>
+#include <rocksdb/compaction_filter.h>
 #include <rocksdb/comparator.h>
 #include <rocksdb/db.h>
+#include <rocksdb/filter_policy.h>
 #include <rocksdb/slice.h>
 #include <rocksdb/options.h>
+#include <rocksdb/perf_context.h>
+#include <rocksdb/table.h>
 #include <rocksdb/utilities/write_batch_with_index.h>
 
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/rocks/rocks_prefetcher.h"
 #include "mongo/db/storage/rocks/rocks_record_store.h"
 #include "mongo/db/storage/rocks/rocks_recovery_unit.h"
 #include "mongo/db/storage/rocks/rocks_sorted_data_impl.h"
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
 
 #define ROCKS_TRACE log()
 
@@ -60,17 +68,94 @@ namespace mongo {
 
     using boost::shared_ptr;
 
+    // Number of threads reading records in ahead of queries. Zero disables prefetching.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(rocksdbPrefetchThreads, int, 4);
+
+    // Block cache shared by the column families of collections and secondary indexes, and the
+    // one reserved for _id indexes.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(rocksdbBlockCacheSizeMB, int, 256);
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(rocksdbIdIndexBlockCacheSizeMB, int, 64);
+
+    // Whether operations time the block reads they reported, at the cost of timing much else
+    // RocksDB does for them too. Otherwise the reads are only counted.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(rocksdbTimeBlockReads, bool, false);
+
+    namespace {
+        const char kRocksEngineName[] = "rocksExperiment";
+
+        // Bloom filter bits per key of indexes which don't say, enough for about 1% false
+        // positives on the point lookups of unique index checks.
+        const int kDefaultIndexBloomFilterBitsPerKey = 10;
+
+        // Extra room FIFO compaction leaves a capped collection over its size before dropping
+        // its oldest table file, so that only files of records capped deletion has already
+        // removed get dropped.
+        const long long kFifoCompactionSlackBytes = 64 * 1024 * 1024;
+
+        BSONObj getEngineOptions(const BSONObj& storageEngine) {
+            return storageEngine.getObjectField(kRocksEngineName);
+        }
+
+        // Prefixes of the counters record stores and indexes keep in the default column family,
+        // each followed by the ident it belongs to.
+        const char* const kIdentCounterPrefixes[] = {"datasize-", "numrecords-", "numentries-"};
+    } // namespace
+
+    /**
+     * Discards, as the default column family gets compacted, the counters left behind by
+     * idents which have since been dropped. The idents' own data goes with their column
+     * families, but nothing else ever deletes these keys.
+     */
+    class RocksEngine::DroppedIdentFilter : public rocksdb::CompactionFilter {
+    public:
+        explicit DroppedIdentFilter(const RocksEngine* engine) : _engine(engine) {}
+
+        virtual bool Filter(int level, const rocksdb::Slice& key,
+                            const rocksdb::Slice& existingValue, std::string* newValue,
+                            bool* valueChanged) const override {
+            if (!_engine->_identsLoaded.load()) {
+                return false;
+            }
+
+            for (const char* prefix : kIdentCounterPrefixes) {
+                rocksdb::Slice ident(key);
+                if (!ident.starts_with(prefix)) {
+                    continue;
+                }
+                ident.remove_prefix(strlen(prefix));
+                boost::mutex::scoped_lock lk(_engine->_identColumnFamilyMapMutex);
+                return _engine->_identColumnFamilyMap.find(
+                    StringData(ident.data(), ident.size())) == _engine->_identColumnFamilyMap.end();
+            }
+            return false;
+        }
+
+        virtual const char* Name() const override {
+            return "mongo.DroppedIdentFilter";
+        }
+
+    private:
+        const RocksEngine* const _engine;
+    };
+
     const std::string RocksEngine::kOrderingPrefix("indexordering-");
     const std::string RocksEngine::kCollectionPrefix("collection-");
+    const std::string RocksEngine::kIdentConfigPrefix("identconfig-");
 
     RocksEngine::RocksEngine(const std::string& path, bool durable)
         : _path(path),
+          _droppedIdentFilter(new DroppedIdentFilter(this)),
+          _identsLoaded(false),
           _collectionComparator(RocksRecordStore::newRocksCollectionComparator()),
+          _blockCache(rocksdb::NewLRUCache(static_cast<size_t>(rocksdbBlockCacheSizeMB) << 20)),
+          _idIndexBlockCache(
+              rocksdb::NewLRUCache(static_cast<size_t>(rocksdbIdIndexBlockCacheSizeMB) << 20)),
           _durable(durable) {
 
         auto columnFamilyNames = _loadColumnFamilies();       // vector of column family names
         std::unordered_map<std::string, Ordering> orderings;  // column family name -> Ordering
         std::set<std::string> collections;                    // set of collection names
+        std::unordered_map<std::string, BSONObj> configs;     // column family name -> config
 
         if (columnFamilyNames.empty()) {  // new DB
             columnFamilyNames.push_back(rocksdb::kDefaultColumnFamilyName);
@@ -82,6 +167,7 @@ namespace mongo {
             auto itr = dbReadOnly->NewIterator(rocksdb::ReadOptions());
             orderings = _loadOrderingMetaData(itr);
             collections = _loadCollections(itr);
+            configs = _loadIdentConfigs(itr);
             delete itr;
             delete dbReadOnly;
         }
@@ -99,16 +185,19 @@ namespace mongo {
             bool isIndex = orderings_iter != orderings.end();
             bool isCollection = collections_iter != collections.end();
             invariant(!isIndex || !isCollection);
+            // Idents created before per-ident configs existed have none, and get the defaults.
+            auto configs_iter = configs.find(cf);
+            BSONObj config = configs_iter != configs.end() ? configs_iter->second : BSONObj();
             if (isIndex) {
-                columnFamilies.emplace_back(cf, _indexOptions(orderings_iter->second));
+                columnFamilies.emplace_back(cf, _indexOptions(orderings_iter->second, config));
             } else if (isCollection) {
-                columnFamilies.emplace_back(cf, _collectionOptions());
+                columnFamilies.emplace_back(cf, _collectionOptions(config));
             } else {
                 // TODO support this from inside of rocksdb, by using
                 // Options::drop_unopened_column_families.
                 // This can happen because write and createColumnFamily are not atomic
                 toDropColumnFamily.insert(cf);
-                columnFamilies.emplace_back(cf, _collectionOptions());
+                columnFamilies.emplace_back(cf, _collectionOptions(BSONObj()));
             }
         }
 
@@ -129,14 +218,33 @@ namespace mongo {
             }
         }
         _db.reset(db);
+        _identsLoaded.store(true);
+
+        if (rocksdbPrefetchThreads > 0) {
+            _prefetcher.reset(new RocksPrefetcher(_db.get(), rocksdbPrefetchThreads));
+        }
     }
 
-    RocksEngine::~RocksEngine() {}
+    RocksEngine::~RocksEngine() {
+        _prefetcher.reset();
+    }
 
     RecoveryUnit* RocksEngine::newRecoveryUnit() {
+        // The perf context getThreadStorageStats() reads is kept per thread, and recovery units
+        // are made on the thread of the operation they are for.
+        rocksdb::SetPerfLevel(rocksdbTimeBlockReads ? rocksdb::kEnableTime
+                                                    : rocksdb::kEnableCount);
         return new RocksRecoveryUnit(&_transactionEngine, _db.get(), _durable);
     }
 
+    StorageStats RocksEngine::getThreadStorageStats() const {
+        StorageStats stats;
+        stats.bytesRead = rocksdb::perf_context.block_read_byte;
+        stats.cacheMisses = rocksdb::perf_context.block_read_count;
+        stats.ioWaitMicros = rocksdb::perf_context.block_read_time / 1000;
+        return stats;
+    }
+
     Status RocksEngine::createRecordStore(OperationContext* opCtx,
                                           const StringData& ns,
                                           const StringData& ident,
@@ -144,8 +252,28 @@ namespace mongo {
         if (_existsColumnFamily(ident)) {
             return Status::OK();
         }
-        _db->Put(rocksdb::WriteOptions(), kCollectionPrefix + ident.toString(), rocksdb::Slice());
-        return _createColumnFamily(_collectionOptions(), ident);
+
+        BSONObj engineOptions = getEngineOptions(options.storageEngine);
+        Status status = validateIdentOptions(engineOptions);
+        if (!status.isOK()) {
+            return status;
+        }
+        if (str::equals(engineOptions.getStringField("compactionStyle"), "fifo") &&
+            !options.capped) {
+            return Status(ErrorCodes::InvalidOptions,
+                          "fifo compaction is only supported for capped collections");
+        }
+        BSONObj config = _makeCollectionConfig(engineOptions, options);
+
+        rocksdb::WriteBatch wb;
+        wb.Put(kCollectionPrefix + ident.toString(), rocksdb::Slice());
+        wb.Put(kIdentConfigPrefix + ident.toString(),
+               rocksdb::Slice(config.objdata(), config.objsize()));
+        auto s = _db->Write(rocksdb::WriteOptions(), &wb);
+        if (!s.ok()) {
+            return toMongoStatus(s);
+        }
+        return _createColumnFamily(_collectionOptions(config), ident);
     }
 
     RecordStore* RocksEngine::getRecordStore(OperationContext* opCtx, const StringData& ns,
@@ -156,9 +284,10 @@ namespace mongo {
             return new RocksRecordStore(
                 ns, ident, _db.get(), columnFamily, true,
                 options.cappedSize ? options.cappedSize : 4096,  // default size
-                options.cappedMaxDocs ? options.cappedMaxDocs : -1);
+                options.cappedMaxDocs ? options.cappedMaxDocs : -1, NULL, _prefetcher.get());
         } else {
-            return new RocksRecordStore(ns, ident, _db.get(), columnFamily);
+            return new RocksRecordStore(ns, ident, _db.get(), columnFamily, false, -1, -1, NULL,
+                                        _prefetcher.get());
         }
     }
 
@@ -169,9 +298,31 @@ namespace mongo {
         }
         auto keyPattern = desc->keyPattern();
 
-        _db->Put(rocksdb::WriteOptions(), kOrderingPrefix + ident.toString(),
-                 rocksdb::Slice(keyPattern.objdata(), keyPattern.objsize()));
-        return _createColumnFamily(_indexOptions(Ordering::make(keyPattern)), ident);
+        BSONObj engineOptions;
+        BSONElement storageEngine = desc->getInfoElement("storageEngine");
+        if (storageEngine.isABSONObj()) {
+            engineOptions = getEngineOptions(storageEngine.Obj());
+        }
+        Status status = validateIdentOptions(engineOptions);
+        if (!status.isOK()) {
+            return status;
+        }
+        if (str::equals(engineOptions.getStringField("compactionStyle"), "fifo")) {
+            return Status(ErrorCodes::InvalidOptions,
+                          "fifo compaction is only supported for capped collections");
+        }
+        BSONObj config = _makeIndexConfig(engineOptions, desc);
+
+        rocksdb::WriteBatch wb;
+        wb.Put(kOrderingPrefix + ident.toString(),
+               rocksdb::Slice(keyPattern.objdata(), keyPattern.objsize()));
+        wb.Put(kIdentConfigPrefix + ident.toString(),
+               rocksdb::Slice(config.objdata(), config.objsize()));
+        auto s = _db->Write(rocksdb::WriteOptions(), &wb);
+        if (!s.ok()) {
+            return toMongoStatus(s);
+        }
+        return _createColumnFamily(_indexOptions(Ordering::make(keyPattern), config), ident);
     }
 
     SortedDataInterface* RocksEngine::getSortedDataInterface(OperationContext* opCtx,
@@ -186,6 +337,7 @@ namespace mongo {
         // TODO is there a more efficient way?
         wb.Delete(kOrderingPrefix + ident.toString());
         wb.Delete(kCollectionPrefix + ident.toString());
+        wb.Delete(kIdentConfigPrefix + ident.toString());
         auto s = _db->Write(rocksdb::WriteOptions(), &wb);
         if (!s.ok()) {
             return toMongoStatus(s);
@@ -201,6 +353,32 @@ namespace mongo {
         return indents;
     }
 
+    Status RocksEngine::validateIdentOptions(const BSONObj& options) {
+        BSONForEach(elem, options) {
+            StringData name = elem.fieldNameStringData();
+            if (name == "bloomFilterBitsPerKey") {
+                if (!elem.isNumber() || elem.numberInt() < 0 || elem.numberInt() > 64) {
+                    return Status(ErrorCodes::InvalidOptions,
+                                  "bloomFilterBitsPerKey must be a number between 0 and 64");
+                }
+            }
+            else if (name == "compactionStyle") {
+                if (elem.type() != String || (elem.valueStringData() != "level" &&
+                                              elem.valueStringData() != "universal" &&
+                                              elem.valueStringData() != "fifo")) {
+                    return Status(ErrorCodes::InvalidOptions,
+                                  "compactionStyle must be one of level, universal or fifo");
+                }
+            }
+            else {
+                return Status(ErrorCodes::InvalidOptions,
+                              str::stream() << "unknown " << kRocksEngineName
+                                            << " option: " << name);
+            }
+        }
+        return Status::OK();
+    }
+
     // non public api
 
     rocksdb::ReadOptions RocksEngine::readOptionsWithSnapshot( OperationContext* opCtx ) {
@@ -281,6 +459,21 @@ namespace mongo {
         return collections;
     }
 
+    std::unordered_map<std::string, BSONObj> RocksEngine::_loadIdentConfigs(
+        rocksdb::Iterator* itr) {
+        std::unordered_map<std::string, BSONObj> configs;
+        for (itr->Seek(kIdentConfigPrefix); itr->Valid(); itr->Next()) {
+            rocksdb::Slice key(itr->key());
+            if (!key.starts_with(kIdentConfigPrefix)) {
+                break;
+            }
+            key.remove_prefix(kIdentConfigPrefix.size());
+            configs.insert({key.ToString(), BSONObj(itr->value().data()).getOwned()});
+        }
+        ROCKS_STATUS_OK(itr->status());
+        return configs;
+    }
+
     std::vector<std::string> RocksEngine::_loadColumnFamilies() {
         std::vector<std::string> names;
         if (boost::filesystem::exists(_path)) {
@@ -313,26 +506,91 @@ namespace mongo {
         return options;
     }
 
-    rocksdb::ColumnFamilyOptions RocksEngine::_defaultCFOptions() {
+    rocksdb::ColumnFamilyOptions RocksEngine::_defaultCFOptions() const {
         rocksdb::ColumnFamilyOptions options;
+        options.compaction_filter = _droppedIdentFilter.get();
         // TODO pass or set appropriate options for default CF.
         return options;
     }
 
-    rocksdb::ColumnFamilyOptions RocksEngine::_collectionOptions() const {
+    BSONObj RocksEngine::_makeCollectionConfig(const BSONObj& options,
+                                               const CollectionOptions& collectionOptions) {
+        BSONObjBuilder builder;
+        // Collections are read by RecordIds that exist, so bloom filters would only cost memory.
+        builder.append("bloomFilterBitsPerKey", options["bloomFilterBitsPerKey"].numberInt());
+
+        // Capped collections are written at one end and deleted from the other, which level
+        // compaction spends most of its time rewriting for nothing.
+        StringData style = options.getStringField("compactionStyle");
+        if (style.empty()) {
+            style = collectionOptions.capped ? "universal" : "level";
+        }
+        builder.append("compactionStyle", style);
+
+        if (style == "fifo") {
+            const long long cappedSize = collectionOptions.cappedSize ?
+                collectionOptions.cappedSize : 4096;
+            builder.append("maxTableFilesSize", 2 * cappedSize + kFifoCompactionSlackBytes);
+        }
+        return builder.obj();
+    }
+
+    BSONObj RocksEngine::_makeIndexConfig(const BSONObj& options, const IndexDescriptor* desc) {
+        BSONObjBuilder builder;
+        BSONElement bits = options["bloomFilterBitsPerKey"];
+        builder.append("bloomFilterBitsPerKey",
+                       bits.eoo() ? kDefaultIndexBloomFilterBitsPerKey : bits.numberInt());
+        StringData style = options.getStringField("compactionStyle");
+        builder.append("compactionStyle", style.empty() ? StringData("level") : style);
+        builder.append("idIndex", desc->isIdIndex());
+        return builder.obj();
+    }
+
+    rocksdb::ColumnFamilyOptions RocksEngine::_collectionOptions(const BSONObj& config) const {
         rocksdb::ColumnFamilyOptions options;
         invariant( _collectionComparator.get() );
         options.comparator = _collectionComparator.get();
+        _applyIdentConfig(config, &options);
         return options;
     }
 
-    rocksdb::ColumnFamilyOptions RocksEngine::_indexOptions(const Ordering& order) const {
+    rocksdb::ColumnFamilyOptions RocksEngine::_indexOptions(const Ordering& order,
+                                                            const BSONObj& config) const {
         rocksdb::ColumnFamilyOptions options;
         invariant( _collectionComparator.get() );
         options.comparator = RocksSortedDataImpl::newRocksComparator(order);
+        // Indexes without a config predate per-ident configs, but still benefit from filters.
+        BSONObj indexConfig = config.isEmpty() ?
+            BSON("bloomFilterBitsPerKey" << kDefaultIndexBloomFilterBitsPerKey) : config;
+        _applyIdentConfig(indexConfig, &options);
         return options;
     }
 
+    void RocksEngine::_applyIdentConfig(const BSONObj& config,
+                                        rocksdb::ColumnFamilyOptions* options) const {
+        rocksdb::BlockBasedTableOptions tableOptions;
+        tableOptions.block_cache = config["idIndex"].trueValue() ? _idIndexBlockCache
+                                                                 : _blockCache;
+        // Whole key filters, which is what the point lookups of unique index checks and
+        // findRecord use. Prefix filters would need a prefix extractor agreeing with the index
+        // comparators, which compare BSON values rather than bytes.
+        const int bloomBits = config["bloomFilterBitsPerKey"].numberInt();
+        if (bloomBits > 0) {
+            tableOptions.filter_policy.reset(rocksdb::NewBloomFilterPolicy(bloomBits));
+        }
+        options->table_factory.reset(rocksdb::NewBlockBasedTableFactory(tableOptions));
+
+        StringData style = config.getStringField("compactionStyle");
+        if (style == "universal") {
+            options->compaction_style = rocksdb::kCompactionStyleUniversal;
+        }
+        else if (style == "fifo") {
+            options->compaction_style = rocksdb::kCompactionStyleFIFO;
+            options->compaction_options_fifo.max_table_files_size =
+                config["maxTableFilesSize"].numberLong();
+        }
+    }
+
     Status toMongoStatus( rocksdb::Status s ) {
         if ( s.ok() )
             return Status::OK();
@@ -31,6 +31,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <list>
 #include <map>
 #include <string>
@@ -50,7 +51,9 @@
 #include "mongo/util/string_map.h"
 
 namespace rocksdb {
+    class Cache;
     class ColumnFamilyHandle;
+    class CompactionFilter;
     struct ColumnFamilyDescriptor;
     struct ColumnFamilyOptions;
     class DB;
@@ -62,6 +65,8 @@ namespace rocksdb {
 
 namespace mongo {
 
+    class RocksPrefetcher;
+
     struct CollectionOptions;
 
     class RocksEngine : public KVEngine {
@@ -101,6 +106,12 @@ namespace mongo {
 
         virtual bool isDurable() const override { return _durable; }
 
+        /**
+         * Blocks read from SST files, which are block cache misses, from the thread's perf
+         * context.
+         */
+        virtual StorageStats getThreadStorageStats() const override;
+
         virtual int64_t getIdentSize(OperationContext* opCtx,
                                       const StringData& ident) {
           // TODO: return correct size.
@@ -124,7 +135,16 @@ namespace mongo {
          */
         static rocksdb::ReadOptions readOptionsWithSnapshot( OperationContext* opCtx );
 
+        /**
+         * Checks this engine's section of a collection's or an index's storageEngine options.
+         * Recognized fields are "bloomFilterBitsPerKey" (0 turns bloom filters off) and
+         * "compactionStyle": "level", "universal" or, for capped collections only, "fifo".
+         */
+        static Status validateIdentOptions(const BSONObj& options);
+
     private:
+        class DroppedIdentFilter;
+
         bool _existsColumnFamily(const StringData& ident);
         Status _createColumnFamily(const rocksdb::ColumnFamilyOptions& options,
                                    const StringData& ident);
@@ -133,19 +153,44 @@ namespace mongo {
 
         std::unordered_map<std::string, Ordering> _loadOrderingMetaData(rocksdb::Iterator* itr);
         std::set<std::string> _loadCollections(rocksdb::Iterator* itr);
+        std::unordered_map<std::string, BSONObj> _loadIdentConfigs(rocksdb::Iterator* itr);
         std::vector<std::string> _loadColumnFamilies();
 
-        rocksdb::ColumnFamilyOptions _collectionOptions() const;
-        rocksdb::ColumnFamilyOptions _indexOptions(const Ordering& order) const;
+        /**
+         * The per-ident config persisted under kIdentConfigPrefix: the storageEngine 'options'
+         * given at create time, completed with defaults chosen by what the ident is.
+         */
+        static BSONObj _makeCollectionConfig(const BSONObj& options,
+                                             const CollectionOptions& collectionOptions);
+        static BSONObj _makeIndexConfig(const BSONObj& options, const IndexDescriptor* desc);
+
+        rocksdb::ColumnFamilyOptions _collectionOptions(const BSONObj& config) const;
+        rocksdb::ColumnFamilyOptions _indexOptions(const Ordering& order,
+                                                   const BSONObj& config) const;
+        void _applyIdentConfig(const BSONObj& config, rocksdb::ColumnFamilyOptions* options) const;
 
         rocksdb::Options _dbOptions() const;
 
-        static rocksdb::ColumnFamilyOptions _defaultCFOptions();
+        rocksdb::ColumnFamilyOptions _defaultCFOptions() const;
 
         std::string _path;
+
+        // Set on the default column family, so declared before _db to outlive it.
+        boost::scoped_ptr<rocksdb::CompactionFilter> _droppedIdentFilter;
+        // Until set, _identColumnFamilyMap is still being loaded and the filter keeps everything.
+        std::atomic<bool> _identsLoaded;
+
         boost::scoped_ptr<rocksdb::DB> _db;
         boost::scoped_ptr<rocksdb::Comparator> _collectionComparator;
 
+        // Shared by all column families, except those of _id indexes which get one of their own
+        // so that their blocks are not pushed out by collection and secondary index reads.
+        std::shared_ptr<rocksdb::Cache> _blockCache;
+        std::shared_ptr<rocksdb::Cache> _idIndexBlockCache;
+
+        // NULL if prefetching is disabled. Declared after _db so that it is destroyed first.
+        boost::scoped_ptr<RocksPrefetcher> _prefetcher;
+
         const bool _durable;
 
         // Default column family is owned by the rocksdb::DB instance.
@@ -160,6 +205,7 @@ namespace mongo {
 
         static const std::string kOrderingPrefix;
         static const std::string kCollectionPrefix;
+        static const std::string kIdentConfigPrefix;
     };
 
     Status toMongoStatus( rocksdb::Status s );
@@ -36,10 +36,14 @@
 #include <rocksdb/options.h>
 #include <rocksdb/slice.h>
 
+#include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/operation_context_noop.h"
 #include "mongo/db/storage/kv/kv_engine.h"
 #include "mongo/db/storage/kv/kv_engine_test_harness.h"
+#include "mongo/db/storage/record_store.h"
 #include "mongo/db/storage/rocks/rocks_engine.h"
 #include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
 
 namespace mongo {
     class RocksEngineHarnessHelper : public KVHarnessHelper {
@@ -66,4 +70,41 @@ namespace mongo {
     };
 
     KVHarnessHelper* KVHarnessHelper::create() { return new RocksEngineHarnessHelper(); }
+
+    TEST(RocksEngineTest, ValidateIdentOptions) {
+        ASSERT_OK(RocksEngine::validateIdentOptions(BSONObj()));
+        ASSERT_OK(RocksEngine::validateIdentOptions(
+            BSON("bloomFilterBitsPerKey" << 16 << "compactionStyle" << "universal")));
+        ASSERT_NOT_OK(RocksEngine::validateIdentOptions(BSON("bloomFilterBitsPerKey" << -1)));
+        ASSERT_NOT_OK(RocksEngine::validateIdentOptions(BSON("compactionStyle" << "tiered")));
+        ASSERT_NOT_OK(RocksEngine::validateIdentOptions(BSON("blockSize" << 4096)));
+    }
+
+    TEST(RocksEngineTest, IdentOptionsSurviveRestart) {
+        RocksEngineHarnessHelper helper;
+
+        CollectionOptions capped;
+        capped.capped = true;
+        capped.cappedSize = 1024 * 1024;
+        capped.storageEngine = BSON("rocksExperiment" << BSON("compactionStyle" << "fifo"));
+
+        CollectionOptions fifoNotCapped;
+        fifoNotCapped.storageEngine = capped.storageEngine;
+
+        {
+            OperationContextNoop opCtx(helper.getEngine()->newRecoveryUnit());
+            ASSERT_OK(helper.getEngine()->createRecordStore(&opCtx, "a.capped", "capped",
+                                                            capped));
+            ASSERT_NOT_OK(helper.getEngine()->createRecordStore(&opCtx, "a.b", "notcapped",
+                                                                fifoNotCapped));
+        }
+
+        KVEngine* engine = helper.restartEngine();
+        OperationContextNoop opCtx(engine->newRecoveryUnit());
+        boost::scoped_ptr<RecordStore> rs(engine->getRecordStore(&opCtx, "a.capped", "capped",
+                                                                 capped));
+        ASSERT(rs);
+        ASSERT(engine->hasIdent(&opCtx, "capped"));
+        ASSERT(!engine->hasIdent(&opCtx, "notcapped"));
+    }
 }
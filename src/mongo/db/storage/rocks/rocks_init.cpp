@@ -55,11 +55,11 @@ namespace mongo {
             }
 
             virtual Status validateCollectionStorageOptions(const BSONObj& options) const {
-                return Status::OK();
+                return RocksEngine::validateIdentOptions(options);
             }
 
             virtual Status validateIndexStorageOptions(const BSONObj& options) const {
-                return Status::OK();
+                return RocksEngine::validateIdentOptions(options);
             }
 
             virtual Status validateMetadata(const StorageEngineMetadata& metadata,
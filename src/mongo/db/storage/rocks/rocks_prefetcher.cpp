@@ -0,0 +1,80 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/rocks/rocks_prefetcher.h"
+
+#include <rocksdb/db.h>
+#include <rocksdb/options.h>
+#include <rocksdb/slice.h>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    using boost::shared_ptr;
+    using std::string;
+    using std::vector;
+
+    RocksPrefetcher::RocksPrefetcher(rocksdb::DB* db, int numThreads)
+        : _db(db),
+          _maxQueued(4 * numThreads),
+          _pool(numThreads, "RocksPrefetch") {
+        invariant(numThreads > 0);
+    }
+
+    RocksPrefetcher::~RocksPrefetcher() {
+        shutdown();
+    }
+
+    void RocksPrefetcher::schedule(shared_ptr<rocksdb::ColumnFamilyHandle> columnFamily,
+                                   const vector<string>& keys) {
+        if (_shuttingDown.load() || _pool.tasks_remaining() >= _maxQueued) {
+            return;
+        }
+        _pool.schedule(&RocksPrefetcher::_prefetch, this, columnFamily, keys);
+    }
+
+    void RocksPrefetcher::shutdown() {
+        _shuttingDown.store(1);
+        _pool.join();
+    }
+
+    void RocksPrefetcher::_prefetch(shared_ptr<rocksdb::ColumnFamilyHandle> columnFamily,
+                                    const vector<string>& keys) {
+        // No snapshot: we only want the blocks in the cache, whatever version they hold.
+        rocksdb::ReadOptions options;
+        string value;
+        for (size_t i = 0; i < keys.size() && !_shuttingDown.load(); ++i) {
+            // Not finding the record is fine, it may have been deleted since.
+            _db->Get(options, columnFamily.get(), rocksdb::Slice(keys[i]), &value);
+        }
+    }
+
+}  // namespace mongo
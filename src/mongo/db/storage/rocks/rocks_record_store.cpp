@@ -49,6 +49,7 @@
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/storage/rocks/rocks_prefetcher.h"
 #include "mongo/db/storage/rocks/rocks_recovery_unit.h"
 #include "mongo/db/storage/oplog_hack.h"
 #include "mongo/util/log.h"
@@ -137,7 +138,8 @@ namespace mongo {
                                        rocksdb::DB* db,  // not owned here
                                        boost::shared_ptr<rocksdb::ColumnFamilyHandle> columnFamily,
                                        bool isCapped, int64_t cappedMaxSize, int64_t cappedMaxDocs,
-                                       CappedDocumentDeleteCallback* cappedDeleteCallback)
+                                       CappedDocumentDeleteCallback* cappedDeleteCallback,
+                                       RocksPrefetcher* prefetcher)
         : RecordStore(ns),
           _db(db),
           _columnFamily(columnFamily),
@@ -152,7 +154,8 @@ namespace mongo {
                                                            : nullptr),
           _ident(id.toString()),
           _dataSizeKey("datasize-" + id.toString()),
-          _numRecordsKey("numrecords-" + id.toString()) {
+          _numRecordsKey("numrecords-" + id.toString()),
+          _prefetcher(prefetcher) {
         invariant( _db );
         invariant( _columnFamily );
 
@@ -727,6 +730,19 @@ namespace mongo {
         return true;
     }
 
+    void RocksRecordStore::prefetchRecords( OperationContext* txn,
+                                            const std::vector<RecordId>& locs ) const {
+        if ( !_prefetcher )
+            return;
+
+        std::vector<std::string> keys;
+        keys.reserve( locs.size() );
+        for ( size_t i = 0; i < locs.size(); ++i ) {
+            keys.push_back( _makeKey( locs[i] ).ToString() );
+        }
+        _prefetcher->schedule( _columnFamily, keys );
+    }
+
     RecordData RocksRecordStore::_getDataFor(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* cf,
                                              OperationContext* txn, const RecordId& loc) {
         RocksRecoveryUnit* ru = RocksRecoveryUnit::getRocksRecoveryUnit(txn);
@@ -77,6 +77,7 @@ namespace mongo {
         RecordId _oplog_highestSeen;
     };
 
+    class RocksPrefetcher;
     class RocksRecoveryUnit;
 
     class RocksRecordStore : public RecordStore {
@@ -85,7 +86,8 @@ namespace mongo {
                          boost::shared_ptr<rocksdb::ColumnFamilyHandle> columnFamily,
                          bool isCapped = false, int64_t cappedMaxSize = -1,
                          int64_t cappedMaxDocs = -1,
-                         CappedDocumentDeleteCallback* cappedDeleteCallback = NULL);
+                         CappedDocumentDeleteCallback* cappedDeleteCallback = NULL,
+                         RocksPrefetcher* prefetcher = NULL);
 
         virtual ~RocksRecordStore() { }
 
@@ -110,6 +112,11 @@ namespace mongo {
                                  const RecordId& loc,
                                  RecordData* out ) const;
 
+        virtual bool prefetchSupported() const { return _prefetcher != NULL; }
+
+        virtual void prefetchRecords( OperationContext* txn,
+                                      const std::vector<RecordId>& locs ) const;
+
         virtual void deleteRecord( OperationContext* txn, const RecordId& dl );
 
         virtual StatusWith<RecordId> insertRecord( OperationContext* txn,
@@ -265,5 +272,7 @@ namespace mongo {
 
         const string _dataSizeKey;
         const string _numRecordsKey;
+
+        RocksPrefetcher* _prefetcher; // not owned, can be NULL
     };
 }
@@ -90,6 +90,8 @@ namespace mongo {
             return new RocksRecoveryUnit(&_transactionEngine, _db.get(), true);
         }
 
+        virtual bool supportsDocLocking() { return true; }
+
     private:
         string _testNamespace = "mongo-rocks-record-store-test";
         unittest::TempDir _tempDir;
@@ -140,7 +140,7 @@ namespace mongo {
             // _transaction.recordSnapshotId() and _db->GetSnapshot() and
             rocksdb::WriteOptions writeOptions;
             writeOptions.disableWAL = !_durable;
-            auto status = _db->Write(rocksdb::WriteOptions(), _writeBatch->GetWriteBatch());
+            auto status = _db->Write(writeOptions, _writeBatch->GetWriteBatch());
             if (!status.ok()) {
                 log() << "uh oh: " << status.ToString();
                 invariant(!"rocks write batch commit failed");
@@ -34,12 +34,14 @@
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <algorithm>
 #include <cstdlib>
 #include <string>
 
 #include <rocksdb/comparator.h>
 #include <rocksdb/db.h>
 #include <rocksdb/iterator.h>
+#include <rocksdb/write_batch.h>
 #include <rocksdb/utilities/write_batch_with_index.h>
 
 #include "mongo/bson/bsonobjbuilder.h"
@@ -380,31 +382,79 @@ namespace mongo {
                 const IndexEntryComparison _indexComparator;
         };
 
-        class RocksBulkSortedBuilderImpl : public SortedDataBuilderInterface {
-        public:
-            RocksBulkSortedBuilderImpl(RocksSortedDataImpl* index, OperationContext* txn,
-                                       bool dupsAllowed)
-                : _index(index), _txn(txn), _dupsAllowed(dupsAllowed) {
-                invariant(index->isEmpty(txn));
+    } // namespace
+
+    /**
+     * Bulk loads an empty index from keys in ascending order. The keys are written straight
+     * into RocksDB in large batches, outside of the builder's transaction: nobody else can write
+     * to or read from an index being bulk built, so there is no need for per-key dup-check reads
+     * or conflict tracking, and duplicates are found by comparing each key with the previous one.
+     */
+    class RocksSortedDataImpl::BulkBuilder : public SortedDataBuilderInterface {
+    public:
+        // Flush the batch to RocksDB once it holds this many bytes.
+        static const size_t kBatchBytes = 4 * 1024 * 1024;
+
+        BulkBuilder(RocksSortedDataImpl* index, OperationContext* txn, bool dupsAllowed)
+            : _index(index), _dupsAllowed(dupsAllowed), _numKeys(0) {
+            invariant(index->isEmpty(txn));
+        }
+
+        virtual Status addKey(const BSONObj& key, const RecordId& loc) {
+            if (key.objsize() >= kTempKeyMaxSize) {
+                return Status(ErrorCodes::KeyTooLong, "key too big");
             }
 
-            Status addKey(const BSONObj& key, const RecordId& loc) {
-                // TODO maybe optimize based on a fact that index is empty?
-                return _index->insert(_txn, key, loc, _dupsAllowed);
+            BSONObj strippedKey = stripFieldNames(key);
+
+            if (_numKeys > 0) {
+                const int cmp = strippedKey.woCompare(_lastKey, _index->_order, false);
+                if (cmp < 0 || (_dupsAllowed && cmp == 0 && loc < _lastLoc)) {
+                    return Status(ErrorCodes::InternalError,
+                                  "expected ascending (key, RecordId) order in bulk builder");
+                }
+                else if (!_dupsAllowed && cmp == 0 && loc != _lastLoc) {
+                    return Status(ErrorCodes::DuplicateKey, dupKeyError(strippedKey));
+                }
             }
 
-            void commit(bool mayInterrupt) {
-                WriteUnitOfWork uow(_txn);
-                uow.commit();
+            _batch.Put(_index->_columnFamily.get(), makeString(strippedKey, loc), emptyByteSlice);
+            if (_batch.GetDataSize() >= kBatchBytes) {
+                _flush();
             }
 
-        private:
-            RocksSortedDataImpl* _index;
-            OperationContext* _txn;
-            bool _dupsAllowed;
-        };
+            _numKeys++;
+            _lastKey = strippedKey;
+            _lastLoc = loc;
+            return Status::OK();
+        }
 
-    } // namespace
+        virtual void commit(bool mayInterrupt) {
+            const long long numEntries = _index->_numEntries.fetch_add(_numKeys) + _numKeys;
+
+            // Stored the way RocksRecoveryUnit stores the counters it commits.
+            const char* nr_ptr = reinterpret_cast<const char*>(&numEntries);
+            _batch.Put(_index->_numEntriesKey, rocksdb::Slice(nr_ptr, sizeof(long long)));
+            _flush();
+        }
+
+    private:
+        void _flush() {
+            auto status = _index->_db->Write(rocksdb::WriteOptions(), &_batch);
+            if (!status.ok()) {
+                log() << "uh oh: " << status.ToString();
+                invariant(!"rocks bulk build write failed");
+            }
+            _batch.Clear();
+        }
+
+        RocksSortedDataImpl* const _index;
+        const bool _dupsAllowed;
+        rocksdb::WriteBatch _batch;
+        long long _numKeys;
+        BSONObj _lastKey;
+        RecordId _lastLoc;
+    };
 
     // RocksSortedDataImpl***********
 
@@ -431,7 +481,7 @@ namespace mongo {
 
     SortedDataBuilderInterface* RocksSortedDataImpl::getBulkBuilder(OperationContext* txn,
                                                                     bool dupsAllowed) {
-        return new RocksBulkSortedBuilderImpl(this, txn, dupsAllowed);
+        return new BulkBuilder(this, txn, dupsAllowed);
     }
 
     Status RocksSortedDataImpl::insert(OperationContext* txn,
@@ -548,6 +598,49 @@ namespace mongo {
             ru->getDeltaCounter(_numEntriesKey);
     }
 
+    bool RocksSortedDataImpl::estimateRangeCount(OperationContext* txn,
+                                                 const BSONObj& startKey,
+                                                 bool startKeyInclusive,
+                                                 const BSONObj& endKey,
+                                                 bool endKeyInclusive,
+                                                 long long* estimateOut) const {
+        const long long entries = numEntries(txn);
+        auto ru = RocksRecoveryUnit::getRocksRecoveryUnit(txn);
+        boost::scoped_ptr<rocksdb::Iterator> it(ru->NewIterator(_columnFamily.get()));
+        it->SeekToFirst();
+        if (entries <= 0 || !it->Valid()) {
+            *estimateOut = 0;
+            return true;
+        }
+
+        // RocksDB can tell us roughly how many bytes of sst files a key range covers, but not how
+        // many entries. Scale our exact entry count by the share of the index's bytes which falls
+        // inside the requested range.
+        const string firstKey = it->key().ToString();
+        it->SeekToLast();
+        invariant(it->Valid());
+        const string lastKey = makeString(makeIndexKeyEntry(it->key()).key, RecordId::max());
+
+        const string rangeStart = makeString(stripFieldNames(startKey),
+                                             startKeyInclusive ? RecordId::min() : RecordId::max());
+        const string rangeEnd = makeString(stripFieldNames(endKey),
+                                           endKeyInclusive ? RecordId::max() : RecordId::min());
+
+        rocksdb::Range ranges[2] = { rocksdb::Range(firstKey, lastKey),
+                                     rocksdb::Range(rangeStart, rangeEnd) };
+        uint64_t sizes[2];
+        _db->GetApproximateSizes(_columnFamily.get(), ranges, 2, sizes);
+
+        if (sizes[0] == 0) {
+            // Everything is still in the memtables, which GetApproximateSizes() does not see.
+            return false;
+        }
+
+        const double fraction = std::min(1.0, static_cast<double>(sizes[1]) / sizes[0]);
+        *estimateOut = static_cast<long long>(fraction * entries);
+        return true;
+    }
+
     SortedDataInterface::Cursor* RocksSortedDataImpl::newCursor(OperationContext* txn,
                                                                 int direction) const {
         invariant( ( direction == 1 || direction == -1 ) && "invalid value for direction" );
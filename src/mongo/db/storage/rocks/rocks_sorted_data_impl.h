@@ -95,6 +95,13 @@ namespace mongo {
 
         virtual long long numEntries(OperationContext* txn) const;
 
+        virtual bool estimateRangeCount(OperationContext* txn,
+                                        const BSONObj& startKey,
+                                        bool startKeyInclusive,
+                                        const BSONObj& endKey,
+                                        bool endKeyInclusive,
+                                        long long* estimateOut) const;
+
         virtual Cursor* newCursor(OperationContext* txn, int direction) const;
 
         virtual Status initAsEmpty(OperationContext* txn);
@@ -108,6 +115,8 @@ namespace mongo {
         static rocksdb::Comparator* newRocksComparator( const Ordering& order );
 
     private:
+        class BulkBuilder;
+
         std::string _getTransactionID(const BSONObj& key) const;
 
         rocksdb::DB* _db; // not owned
@@ -28,9 +28,11 @@
  *    it in the license file.
  */
 
+
 #include "mongo/db/storage/rocks/rocks_transaction.h"
 
 #include <atomic>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -39,36 +41,54 @@
 #include "mongo/util/assert_util.h"
 
 namespace mongo {
-    RocksTransactionEngine::RocksTransactionEngine() : _latestSnapshotId(1), _nextTransactionId(1) {}
+    RocksTransactionEngine::RocksTransactionEngine()
+        : _latestSnapshotId(1),
+          _nextTransactionId(1),
+          _oldestActiveSnapshotId(std::numeric_limits<uint64_t>::max()) {}
+
+    RocksTransactionEngine::Shard& RocksTransactionEngine::_getShard(const std::string& key) {
+        return _shards[std::hash<std::string>()(key) % kNumShards];
+    }
 
     std::list<uint64_t>::iterator RocksTransactionEngine::_getLatestSnapshotId_inlock() {
-        return _activeSnapshots.insert(_activeSnapshots.end(), _latestSnapshotId);
+        auto iter = _activeSnapshots.insert(_activeSnapshots.end(), _latestSnapshotId.load());
+        if (iter == _activeSnapshots.begin()) {
+            _oldestActiveSnapshotId.store(*iter);
+        }
+        return iter;
     }
 
-    bool RocksTransactionEngine::_isKeyCommittedAfterSnapshot_inlock(const std::string& key,
+    bool RocksTransactionEngine::_isKeyCommittedAfterSnapshot_inlock(const Shard& shard,
+                                                                     const std::string& key,
                                                                      uint64_t snapshotId) {
-        auto iter = _keyInfo.find(key);
-        return iter != _keyInfo.end() && iter->second.first > snapshotId;
+        auto iter = shard.keyInfo.find(key);
+        return iter != shard.keyInfo.end() && iter->second.first > snapshotId;
     }
 
-    void RocksTransactionEngine::_registerCommittedKey_inlock(const std::string& key,
+    void RocksTransactionEngine::_registerCommittedKey_inlock(Shard* shard,
+                                                              const std::string& key,
                                                               uint64_t newSnapshotId) {
-        auto iter = _keyInfo.find(key);
-        if (iter != _keyInfo.end()) {
-            _keysSortedBySnapshot.erase(iter->second.second);
-            _keyInfo.erase(iter);
+        _cleanUpKeysCommittedBeforeSnapshot_inlock(shard, _oldestActiveSnapshotId.load());
+
+        auto iter = shard->keyInfo.find(key);
+        if (iter != shard->keyInfo.end()) {
+            shard->keysSortedBySnapshot.erase(iter->second.second);
+            shard->keyInfo.erase(iter);
         }
 
-        auto listIter = _keysSortedBySnapshot.insert(_keysSortedBySnapshot.end(), {key, newSnapshotId});
-        _keyInfo.insert({key, {newSnapshotId, listIter}});
+        auto listIter = shard->keysSortedBySnapshot.insert(shard->keysSortedBySnapshot.end(),
+                                                           {key, newSnapshotId});
+        shard->keyInfo.insert({key, {newSnapshotId, listIter}});
     }
 
-    void RocksTransactionEngine::_cleanUpKeysCommittedBeforeSnapshot_inlock(uint64_t snapshotId) {
-        while (!_keysSortedBySnapshot.empty() && _keysSortedBySnapshot.begin()->second <= snapshotId) {
-            auto keyInfoIter = _keyInfo.find(_keysSortedBySnapshot.begin()->first);
-            invariant(keyInfoIter != _keyInfo.end());
-            _keyInfo.erase(keyInfoIter);
-            _keysSortedBySnapshot.pop_front();
+    void RocksTransactionEngine::_cleanUpKeysCommittedBeforeSnapshot_inlock(Shard* shard,
+                                                                            uint64_t snapshotId) {
+        auto& keys = shard->keysSortedBySnapshot;
+        while (!keys.empty() && keys.begin()->second <= snapshotId) {
+            auto keyInfoIter = shard->keyInfo.find(keys.begin()->first);
+            invariant(keyInfoIter != shard->keyInfo.end());
+            shard->keyInfo.erase(keyInfoIter);
+            keys.pop_front();
         }
     }
 
@@ -77,9 +97,9 @@ namespace mongo {
         bool needCleanup = _activeSnapshots.begin() == snapshotIter;
         _activeSnapshots.erase(snapshotIter);
         if (needCleanup) {
-            _cleanUpKeysCommittedBeforeSnapshot_inlock(_activeSnapshots.empty()
-                                                           ? std::numeric_limits<uint64_t>::max()
-                                                           : *_activeSnapshots.begin());
+            _oldestActiveSnapshotId.store(_activeSnapshots.empty()
+                                              ? std::numeric_limits<uint64_t>::max()
+                                              : *_activeSnapshots.begin());
         }
     }
 
@@ -87,40 +107,42 @@ namespace mongo {
         if (_writtenKeys.empty()) {
             return;
         }
-        uint64_t newSnapshotId = 0;
-        {
-            boost::mutex::scoped_lock lk(_transactionEngine->_lock);
-            for (const auto& key : _writtenKeys) {
-                invariant(
-                    !_transactionEngine->_isKeyCommittedAfterSnapshot_inlock(key, _snapshotId));
-                invariant(_transactionEngine->_uncommittedTransactionId[key] == _transactionId);
-                _transactionEngine->_uncommittedTransactionId.erase(key);
-            }
-            newSnapshotId = _transactionEngine->_latestSnapshotId + 1;
-            for (const auto& key : _writtenKeys) {
-                _transactionEngine->_registerCommittedKey_inlock(key, newSnapshotId);
-            }
-            _cleanup_inlock();
-            _transactionEngine->_latestSnapshotId = newSnapshotId;
+        // The batch is already written to the DB, so whoever takes a snapshot from now on sees
+        // our writes: bump the snapshot ID before registering the keys as committed. Until they
+        // are, they still belong to us and conflict with every other writer.
+        uint64_t newSnapshotId = _transactionEngine->_latestSnapshotId.fetch_add(1) + 1;
+        for (const auto& key : _writtenKeys) {
+            auto& shard = _transactionEngine->_getShard(key);
+            boost::mutex::scoped_lock lk(shard.lock);
+            invariant(!RocksTransactionEngine::_isKeyCommittedAfterSnapshot_inlock(shard, key,
+                                                                                  _snapshotId));
+            auto uncommittedIter = shard.uncommittedTransactionId.find(key);
+            invariant(uncommittedIter != shard.uncommittedTransactionId.end() &&
+                      uncommittedIter->second == _transactionId);
+            shard.uncommittedTransactionId.erase(uncommittedIter);
+            _transactionEngine->_registerCommittedKey_inlock(&shard, key, newSnapshotId);
         }
+        _cleanupSnapshot();
         // cleanup
         _writtenKeys.clear();
     }
 
     bool RocksTransaction::registerWrite(const std::string& key) {
-        boost::mutex::scoped_lock lk(_transactionEngine->_lock);
-        if (_transactionEngine->_isKeyCommittedAfterSnapshot_inlock(key, _snapshotId)) {
+        auto& shard = _transactionEngine->_getShard(key);
+        boost::mutex::scoped_lock lk(shard.lock);
+        if (RocksTransactionEngine::_isKeyCommittedAfterSnapshot_inlock(shard, key,
+                                                                        _snapshotId)) {
             // write-committed write conflict
             return false;
         }
-        auto uncommittedTransactionIter = _transactionEngine->_uncommittedTransactionId.find(key);
-        if (uncommittedTransactionIter != _transactionEngine->_uncommittedTransactionId.end() &&
+        auto uncommittedTransactionIter = shard.uncommittedTransactionId.find(key);
+        if (uncommittedTransactionIter != shard.uncommittedTransactionId.end() &&
             uncommittedTransactionIter->second != _transactionId) {
             // write-uncommitted write conflict
             return false;
         }
         _writtenKeys.insert(key);
-        _transactionEngine->_uncommittedTransactionId[key] = _transactionId;
+        shard.uncommittedTransactionId[key] = _transactionId;
         return true;
     }
 
@@ -128,28 +150,28 @@ namespace mongo {
         if (_writtenKeys.empty() && !_snapshotInitialized) {
             return;
         }
-        {
-            boost::mutex::scoped_lock lk(_transactionEngine->_lock);
-            for (const auto& key : _writtenKeys) {
-                _transactionEngine->_uncommittedTransactionId.erase(key);
-            }
-            _cleanup_inlock();
+        for (const auto& key : _writtenKeys) {
+            auto& shard = _transactionEngine->_getShard(key);
+            boost::mutex::scoped_lock lk(shard.lock);
+            shard.uncommittedTransactionId.erase(key);
         }
+        _cleanupSnapshot();
         _writtenKeys.clear();
     }
 
     void RocksTransaction::recordSnapshotId() {
+        _cleanupSnapshot();
         {
-            boost::mutex::scoped_lock lk(_transactionEngine->_lock);
-            _cleanup_inlock();
+            boost::mutex::scoped_lock lk(_transactionEngine->_snapshotsLock);
             _activeSnapshotsIter = _transactionEngine->_getLatestSnapshotId_inlock();
         }
         _snapshotId = *_activeSnapshotsIter;
         _snapshotInitialized = true;
     }
 
-    void RocksTransaction::_cleanup_inlock() {
+    void RocksTransaction::_cleanupSnapshot() {
         if (_snapshotInitialized) {
+            boost::mutex::scoped_lock lk(_transactionEngine->_snapshotsLock);
             _transactionEngine->_cleanupSnapshot_inlock(_activeSnapshotsIter);
             _snapshotInitialized = false;
             _snapshotId = std::numeric_limits<uint64_t>::max();
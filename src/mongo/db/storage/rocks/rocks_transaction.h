@@ -28,9 +28,11 @@
  *    it in the license file.
  */
 
+
 #pragma once
 
 #include <atomic>
+#include <limits>
 #include <set>
 #include <unordered_map>
 #include <memory>
@@ -47,10 +49,41 @@ namespace mongo {
         RocksTransactionEngine();
 
     private:
-        // REQUIRES: transaction engine lock locked
+        // The keys are split over this many shards, each with its own lock, so that
+        // transactions writing different keys don't serialize on a single mutex.
+        static const size_t kNumShards = 64;
+
+        typedef std::list<std::pair<std::string, uint64_t>> KeysSortedBySnapshotList;
+        typedef std::list<std::pair<std::string, uint64_t>>::iterator KeysSortedBySnapshotListIter;
+
+        // The following data structures keep information about when were the keys committed.
+        // They can answer the following questions:
+        // * Which stored committed key has the earliest snapshot
+        // * When was a certain key committed
+        // keysSortedBySnapshot is a list of {key, sequence_id}, roughly sorted by the
+        // sequence_id: keys are pushed to the end as they commit, and transactions can register
+        // their commits slightly out of order. That only delays cleaning some keys up.
+        // keyInfo is a map from the key to the two-part information about the key:
+        // * snapshot ID of the last commit to this key
+        // * an iterator pointing to the corresponding entry in keysSortedBySnapshot. This is used
+        // to update the list at the same time as we update the keyInfo
+        // TODO optimize these structures to store only one key instead of two
+        struct Shard {
+            // Lock when mutating state here
+            boost::mutex lock;
+            KeysSortedBySnapshotList keysSortedBySnapshot;
+            // map of key -> pair{seq_id, pointer to corresponding keysSortedBySnapshot}
+            std::unordered_map<std::string, std::pair<uint64_t, KeysSortedBySnapshotListIter>>
+                keyInfo;
+            std::unordered_map<std::string, uint64_t> uncommittedTransactionId;
+        };
+
+        Shard& _getShard(const std::string& key);
+
+        // REQUIRES: snapshots lock locked
         std::list<uint64_t>::iterator _getLatestSnapshotId_inlock();
 
-        // REQUIRES: transaction engine lock locked
+        // REQUIRES: snapshots lock locked
         // Cleans up the snapshot from the _activeSnapshots list
         void _cleanupSnapshot_inlock(const std::list<uint64_t>::iterator& snapshotIter);
 
@@ -60,43 +93,35 @@ namespace mongo {
 
         // returns true if the key was committed after the snapshotId, thus causing a write
         // conflict
-        // REQUIRES: transaction engine lock locked
-        bool _isKeyCommittedAfterSnapshot_inlock(const std::string& key, uint64_t snapshotId);
+        // REQUIRES: shard lock locked
+        static bool _isKeyCommittedAfterSnapshot_inlock(const Shard& shard,
+                                                        const std::string& key,
+                                                        uint64_t snapshotId);
 
-        // REQUIRES: transaction engine lock locked
-        void _registerCommittedKey_inlock(const std::string& key, uint64_t newSnapshotId);
+        // REQUIRES: shard lock locked
+        void _registerCommittedKey_inlock(Shard* shard,
+                                          const std::string& key,
+                                          uint64_t newSnapshotId);
 
-        // REQUIRES: transaction engine lock locked
-        void _cleanUpKeysCommittedBeforeSnapshot_inlock(uint64_t snapshotId);
+        // REQUIRES: shard lock locked
+        static void _cleanUpKeysCommittedBeforeSnapshot_inlock(Shard* shard, uint64_t snapshotId);
 
         friend class RocksTransaction;
-        uint64_t _latestSnapshotId;
+        std::atomic<uint64_t> _latestSnapshotId;
         std::atomic<uint64_t> _nextTransactionId;
-        // Lock when mutating state here
-        boost::mutex _lock;
 
-        // The following data structures keep information about when were the keys committed.
-        // They can answer the following questions:
-        // * Which stored committed key has the earliest snapshot
-        // * When was a certain key committed
-        // _keysSortedBySnapshot is a list of {key, sequence_id} and it's sorted by the sequence_id.
-        // Committing keys are always monotonically increasing, so to keep it sorted we just need to
-        // push to the end.
-        // _keyInfo is a map from the key to the two-part information about the key:
-        // * snapshot ID of the last commit to this key
-        // * an iterator pointing to the corresponding entry in _keysSortedBySnapshot. This is used
-        // to update the list at the same time as we update the _keyInfo
-        // TODO optimize these structures to store only one key instead of two
-        typedef std::list<std::pair<std::string, uint64_t>> KeysSortedBySnapshotList;
-        typedef std::list<std::pair<std::string, uint64_t>>::iterator KeysSortedBySnapshotListIter;
-        KeysSortedBySnapshotList _keysSortedBySnapshot;
-        // map of key -> pair{seq_id, pointer to corresponding _keysSortedBySnapshot}
-        std::unordered_map<std::string, std::pair<uint64_t, KeysSortedBySnapshotListIter>> _keyInfo;
+        // Snapshot ID of the oldest active snapshot, or the maximum uint64_t when there are
+        // none. Commits committed at or before it can no longer conflict with anyone, and the
+        // shards drop them as they go.
+        std::atomic<uint64_t> _oldestActiveSnapshotId;
 
-        std::unordered_map<std::string, uint64_t> _uncommittedTransactionId;
+        // Lock when mutating _activeSnapshots. Taken once per snapshot rather than per write.
+        boost::mutex _snapshotsLock;
 
         // this list is sorted
         std::list<uint64_t> _activeSnapshots;
+
+        Shard _shards[kNumShards];
     };
 
     class RocksTransaction {
@@ -120,8 +145,7 @@ namespace mongo {
         void recordSnapshotId();
 
     private:
-        // REQUIRES: transaction engine lock locked
-        void _cleanup_inlock();
+        void _cleanupSnapshot();
 
         friend class RocksTransactionEngine;
         bool _snapshotInitialized;
@@ -0,0 +1,124 @@
+// rocks_transaction_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/db/storage/rocks/rocks_transaction.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+    TEST(RocksTransactionTest, UncommittedWriteConflicts) {
+        RocksTransactionEngine engine;
+        RocksTransaction a(&engine);
+        RocksTransaction b(&engine);
+        a.recordSnapshotId();
+        b.recordSnapshotId();
+
+        ASSERT_TRUE(a.registerWrite("k"));
+        ASSERT_TRUE(a.registerWrite("k"));
+        ASSERT_FALSE(b.registerWrite("k"));
+        ASSERT_TRUE(b.registerWrite("other"));
+
+        a.abort();
+        ASSERT_TRUE(b.registerWrite("k"));
+    }
+
+    TEST(RocksTransactionTest, CommitConflictsWithOlderSnapshots) {
+        RocksTransactionEngine engine;
+        RocksTransaction old(&engine);
+        old.recordSnapshotId();
+
+        {
+            RocksTransaction writer(&engine);
+            writer.recordSnapshotId();
+            ASSERT_TRUE(writer.registerWrite("k"));
+            writer.commit();
+        }
+
+        ASSERT_FALSE(old.registerWrite("k"));
+
+        RocksTransaction young(&engine);
+        young.recordSnapshotId();
+        ASSERT_TRUE(young.registerWrite("k"));
+    }
+
+    TEST(RocksTransactionTest, CommittedKeysForgottenWithoutActiveSnapshots) {
+        RocksTransactionEngine engine;
+        {
+            RocksTransaction writer(&engine);
+            writer.recordSnapshotId();
+            ASSERT_TRUE(writer.registerWrite("k"));
+            writer.commit();
+        }
+
+        // No snapshot predates the commit, so nobody can conflict with it.
+        RocksTransaction next(&engine);
+        next.recordSnapshotId();
+        ASSERT_TRUE(next.registerWrite("k"));
+        next.commit();
+    }
+
+    void writeDistinctKeys(RocksTransactionEngine* engine, int thread, AtomicUInt32* conflicts) {
+        for (int i = 0; i < 1000; i++) {
+            RocksTransaction txn(engine);
+            txn.recordSnapshotId();
+            if (!txn.registerWrite(str::stream() << thread << "-" << i)) {
+                conflicts->fetchAndAdd(1);
+            }
+            txn.commit();
+        }
+    }
+
+    TEST(RocksTransactionTest, ConcurrentWritersOfDistinctKeysDoNotConflict) {
+        RocksTransactionEngine engine;
+        AtomicUInt32 conflicts;
+        std::vector<boost::thread*> threads;
+        for (int t = 0; t < 8; t++) {
+            threads.push_back(new boost::thread(boost::bind(&writeDistinctKeys,
+                                                            &engine, t, &conflicts)));
+        }
+        for (size_t t = 0; t < threads.size(); t++) {
+            threads[t]->join();
+            delete threads[t];
+        }
+        ASSERT_EQUALS(0U, conflicts.load());
+    }
+
+}  // namespace
+}  // namespace mongo
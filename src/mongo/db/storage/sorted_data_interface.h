@@ -178,6 +178,23 @@ namespace mongo {
             return x;
         }
 
+        /**
+         * Estimates the number of entries whose keys lie between 'startKey' and 'endKey', with
+         * each bound included or excluded as its flag says. Implementations should answer from
+         * the structure of the index (file sizes, page statistics) without visiting the entries
+         * in the range, so the answer is approximate.
+         *
+         * Returns false, leaving 'estimateOut' untouched, if this index cannot make an estimate.
+         */
+        virtual bool estimateRangeCount(OperationContext* txn,
+                                        const BSONObj& startKey,
+                                        bool startKeyInclusive,
+                                        const BSONObj& endKey,
+                                        bool endKeyInclusive,
+                                        long long* estimateOut) const {
+            return false;
+        }
+
         /**
          * Navigation
          *
@@ -365,6 +382,9 @@ namespace mongo {
          *
          * 'key' must be > or >= the last key passed to this function (depends on _dupsAllowed).  If
          * this is violated an error Status (ErrorCodes::InternalError) will be returned.
+         *
+         * Implementations may buffer keys or write them outside of the caller's WriteUnitOfWork,
+         * so they need not be visible in the index until commit() returns.
          */
         virtual Status addKey(const BSONObj& key, const RecordId& loc) = 0;
 
@@ -0,0 +1,129 @@
+// sorted_data_interface_bench_harness.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * Benchmarks of SortedDataInterface operations, run against whichever engine provides
+ * newHarnessHelper() in the program they are linked into.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/sorted_data_interface_test_harness.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/operation_context.h"
+#include "mongo/db/storage/sorted_data_interface.h"
+#include "mongo/platform/random.h"
+#include "mongo/unittest/benchmark.h"
+
+namespace mongo {
+namespace {
+
+    using boost::scoped_ptr;
+    using unittest::doNotOptimizeAway;
+
+    // Keys in the index before the read benchmarks start.
+    const int kNumPreloaded = 10 * 1000;
+
+    const int kScanLength = 100;
+
+    BSONObj makeKey(int64_t i) {
+        return BSON("" << static_cast<long long>(i));
+    }
+
+    void insertKey(HarnessHelper* harness, SortedDataInterface* sorted, int64_t i) {
+        scoped_ptr<OperationContext> txn(harness->newOperationContext());
+        WriteUnitOfWork uow(txn.get());
+        invariantOK(sorted->insert(txn.get(), makeKey(i), RecordId(i + 1), true));
+        uow.commit();
+    }
+
+    BENCHMARK(SortedDataInterface, InsertRandom) {
+        scoped_ptr<HarnessHelper> harness(newHarnessHelper());
+        scoped_ptr<SortedDataInterface> sorted(harness->newSortedDataInterface(false));
+
+        PseudoRandom random(0);
+        while (state.keepRunning()) {
+            insertKey(harness.get(), sorted.get(), random.nextInt32() & 0x7fffffff);
+        }
+    }
+
+    BENCHMARK(SortedDataInterface, InsertAscending) {
+        scoped_ptr<HarnessHelper> harness(newHarnessHelper());
+        scoped_ptr<SortedDataInterface> sorted(harness->newSortedDataInterface(false));
+
+        int64_t i = 0;
+        while (state.keepRunning()) {
+            insertKey(harness.get(), sorted.get(), i++);
+        }
+    }
+
+    BENCHMARK(SortedDataInterface, Seek) {
+        scoped_ptr<HarnessHelper> harness(newHarnessHelper());
+        scoped_ptr<SortedDataInterface> sorted(harness->newSortedDataInterface(false));
+        for (int i = 0; i < kNumPreloaded; i++) {
+            insertKey(harness.get(), sorted.get(), i);
+        }
+
+        PseudoRandom random(0);
+        while (state.keepRunning()) {
+            const int64_t i = random.nextInt32(kNumPreloaded);
+            scoped_ptr<OperationContext> txn(harness->newOperationContext());
+            scoped_ptr<SortedDataInterface::Cursor> cursor(sorted->newCursor(txn.get(), 1));
+            doNotOptimizeAway(cursor->locate(makeKey(i), RecordId(i + 1)));
+        }
+    }
+
+    BENCHMARK(SortedDataInterface, RangeScan) {
+        scoped_ptr<HarnessHelper> harness(newHarnessHelper());
+        scoped_ptr<SortedDataInterface> sorted(harness->newSortedDataInterface(false));
+        for (int i = 0; i < kNumPreloaded; i++) {
+            insertKey(harness.get(), sorted.get(), i);
+        }
+
+        PseudoRandom random(0);
+        while (state.keepRunning()) {
+            const int64_t start = random.nextInt32(kNumPreloaded);
+            scoped_ptr<OperationContext> txn(harness->newOperationContext());
+            scoped_ptr<SortedDataInterface::Cursor> cursor(sorted->newCursor(txn.get(), 1));
+            cursor->locate(makeKey(start), RecordId(start + 1));
+
+            int keys = 0;
+            for (int i = 0; i < kScanLength && !cursor->isEOF(); i++) {
+                keys += cursor->getKey().objsize();
+                cursor->advance();
+            }
+            doNotOptimizeAway(keys);
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
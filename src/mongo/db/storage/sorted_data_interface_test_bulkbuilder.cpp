@@ -200,4 +200,39 @@ namespace mongo {
         }
     }
 
+    // Bulk load enough keys that builders batching their writes have to flush more than once,
+    // and verify they all end up in the index in order.
+    TEST( SortedDataInterface, BuilderAddManyKeys ) {
+        const int nKeys = 10000;
+
+        scoped_ptr<HarnessHelper> harnessHelper( newHarnessHelper() );
+        scoped_ptr<SortedDataInterface> sorted( harnessHelper->newSortedDataInterface( true ) );
+
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            scoped_ptr<SortedDataBuilderInterface> builder(
+                    sorted->getBulkBuilder( opCtx.get(), false ) );
+
+            for ( int i = 0; i < nKeys; i++ ) {
+                ASSERT_OK( builder->addKey( BSON( "" << i ), RecordId( 42, i * 2 ) ) );
+            }
+            builder->commit( false );
+        }
+
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            ASSERT_EQUALS( nKeys, sorted->numEntries( opCtx.get() ) );
+
+            scoped_ptr<SortedDataInterface::Cursor> cursor( sorted->newCursor( opCtx.get(), 1 ) );
+            ASSERT( !cursor->locate( minKey, RecordId::min() ) );
+            for ( int i = 0; i < nKeys; i++ ) {
+                ASSERT( !cursor->isEOF() );
+                ASSERT_EQUALS( BSON( "" << i ), cursor->getKey() );
+                ASSERT_EQUALS( RecordId( 42, i * 2 ), cursor->getRecordId() );
+                cursor->advance();
+            }
+            ASSERT( cursor->isEOF() );
+        }
+    }
+
 } // namespace mongo
@@ -35,6 +35,7 @@
 
 #include "mongo/base/status.h"
 #include "mongo/bson/bsonobj.h"
+#include "mongo/db/storage/storage_stats.h"
 
 namespace mongo {
 
@@ -158,6 +159,13 @@ namespace mongo {
          */
         virtual bool isMmapV1() const { return false; }
 
+        /**
+         * Returns what the engine has done on behalf of the calling thread since it started, as
+         * counters which only grow. CurOp reports the growth over an operation. Must be cheap, as
+         * it is called at the start and end of every operation.
+         */
+        virtual StorageStats getThreadStorageStats() const { return StorageStats(); }
+
         /**
          * Closes all file handles associated with a database.
          */
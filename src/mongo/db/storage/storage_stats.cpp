@@ -0,0 +1,83 @@
+// storage_stats.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/storage_stats.h"
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+#include "mongo/bson/bsonobjbuilder.h"
+
+namespace mongo {
+
+    // static
+    StorageStats StorageStats::forThisThread() {
+        StorageStats stats;
+#if defined(__linux__) && defined(RUSAGE_THREAD)
+        struct rusage usage;
+        if (getrusage(RUSAGE_THREAD, &usage) == 0) {
+            // ru_inblock counts 512 byte blocks, whatever the device's block size.
+            stats.bytesRead = static_cast<long long>(usage.ru_inblock) * 512;
+            stats.cacheMisses = usage.ru_majflt;
+        }
+#endif
+        return stats;
+    }
+
+    StorageStats StorageStats::since(const StorageStats& earlier) const {
+        StorageStats delta;
+        delta.bytesRead = bytesRead - earlier.bytesRead;
+        delta.cacheMisses = cacheMisses - earlier.cacheMisses;
+        delta.ioWaitMicros = ioWaitMicros - earlier.ioWaitMicros;
+        return delta;
+    }
+
+    void StorageStats::append(BSONObjBuilder* builder) const {
+        builder->appendNumber("bytesRead", bytesRead);
+        builder->appendNumber("cacheMisses", cacheMisses);
+        builder->appendNumber("ioWaitMicros", ioWaitMicros);
+    }
+
+    void StorageStats::report(StringBuilder& s) const {
+        if (bytesRead) {
+            s << " storageBytesRead:" << bytesRead;
+        }
+        if (cacheMisses) {
+            s << " storageCacheMisses:" << cacheMisses;
+        }
+        if (ioWaitMicros) {
+            s << " storageIOWaitMicros:" << ioWaitMicros;
+        }
+    }
+
+} // namespace mongo
@@ -0,0 +1,68 @@
+// storage_stats.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/bson/util/builder.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * What the storage engine did underneath an operation: how much it had to read from disk
+     * rather than find in memory. Counters an engine can't measure stay 0.
+     */
+    struct StorageStats {
+        StorageStats() : bytesRead(0), cacheMisses(0), ioWaitMicros(0) { }
+
+        /**
+         * The bytes read from disk and the major page faults of the calling thread since it
+         * started, from getrusage(RUSAGE_THREAD). All 0 where that isn't supported.
+         */
+        static StorageStats forThisThread();
+
+        /** The counters of 'this' minus those of 'earlier'. */
+        StorageStats since(const StorageStats& earlier) const;
+
+        bool isEmpty() const { return !bytesRead && !cacheMisses && !ioWaitMicros; }
+
+        /** Appends all counters, zero or not. */
+        void append(BSONObjBuilder* builder) const;
+
+        /** Appends the non-zero counters for the slow operation log line. */
+        void report(StringBuilder& s) const;
+
+        long long bytesRead;     // read from disk, not counting what the OS had cached
+        long long cacheMisses;   // reads the engine's cache couldn't serve; page faults on MMAPv1
+        long long ioWaitMicros;  // time spent waiting for those reads
+    };
+
+} // namespace mongo
@@ -330,6 +330,27 @@ namespace {
         return Status::OK();
     }
 
+    Status WiredTigerIndex::touch(OperationContext* txn) const {
+        // Reading every key through a cursor brings the whole index into the cache.
+        WiredTigerCursor curwrap(_uri, _instanceId, false, txn);
+        WT_CURSOR *c = curwrap.get();
+        invariant(c);
+        long long numKeys = 0;
+        int ret;
+        while ((ret = c->next(c)) == 0) {
+            WT_ITEM key;
+            invariantWTOK(c->get_key(c, &key));
+            if (++numKeys % 1024 == 0) {
+                Status status = txn->checkForInterruptNoAssert();
+                if (!status.isOK())
+                    return status;
+            }
+        }
+        if (ret != WT_NOTFOUND)
+            return wtRCToStatus(ret);
+        return Status::OK();
+    }
+
     bool WiredTigerIndex::isEmpty(OperationContext* txn) {
         WiredTigerCursor curwrap(_uri, _instanceId, false, txn);
         WT_CURSOR *c = curwrap.get();
@@ -33,13 +33,16 @@
 
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/operations.hpp>
 
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_global_options.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_index.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_prefetcher.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
@@ -47,6 +50,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/util/log.h"
 #include "mongo/util/processinfo.h"
+#include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/scopeguard.h"
 
 #if !defined(__has_feature)
@@ -55,6 +59,13 @@
 
 namespace mongo {
 
+    // Number of threads reading records in ahead of queries. Zero disables prefetching.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(wiredTigerPrefetchThreads, int, 4);
+
+    // How often the record counts and data sizes of changed collections are written to the
+    // sizeStorer table in the background. Zero writes them only at checkpoints and shutdown.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(wiredTigerSizeStorerSyncPeriodSecs, int, 60);
+
     namespace {
         int mdb_handle_error(WT_EVENT_HANDLER *handler, WT_SESSION *session,
                              int errorCode, const char *message) {
@@ -103,7 +114,7 @@ namespace mongo {
                                             bool repair )
         : _path( path ),
           _durable( durable ),
-          _sizeStorerSyncTracker( 100000, 60 * 1000 ) {
+          _sizeStorerThreadStop( false ) {
 
         if (repair) {
             // This should be done once before we try to access any data.
@@ -171,6 +182,11 @@ namespace mongo {
 
         _sessionCache.reset( new WiredTigerSessionCache( this ) );
 
+        if ( wiredTigerPrefetchThreads > 0 ) {
+            _prefetcher.reset( new WiredTigerPrefetcher( _sessionCache.get(),
+                                                         wiredTigerPrefetchThreads ) );
+        }
+
         _sizeStorerUri = "table:sizeStorer";
         {
             WiredTigerSession session(_conn);
@@ -182,6 +198,11 @@ namespace mongo {
             ss->loadFrom( &session, _sizeStorerUri );
             _sizeStorer.reset( ss );
         }
+
+        if ( wiredTigerSizeStorerSyncPeriodSecs > 0 ) {
+            _sizeStorerSyncThread = boost::thread(
+                boost::bind( &WiredTigerKVEngine::_sizeStorerSyncLoop, this ) );
+        }
     }
 
 
@@ -192,13 +213,26 @@ namespace mongo {
 
         _sizeStorer.reset( NULL );
 
+        _prefetcher.reset( NULL );
         _sessionCache.reset( NULL );
     }
 
     void WiredTigerKVEngine::cleanShutdown() {
         log() << "WiredTigerKVEngine shutting down";
+        if ( _sizeStorerSyncThread.joinable() ) {
+            {
+                boost::mutex::scoped_lock lk( _sizeStorerThreadMutex );
+                _sizeStorerThreadStop = true;
+            }
+            _sizeStorerThreadCondition.notify_one();
+            _sizeStorerSyncThread.join();
+        }
         syncSizeInfo(true);
         if (_conn) {
+            if (_prefetcher) {
+                _prefetcher->shutdown();
+            }
+
             // this must be the last thing we do before _conn->close();
             _sessionCache->shuttingDown();
 
@@ -277,6 +311,7 @@ namespace mongo {
         if ( !_sizeStorer )
             return;
 
+        boost::mutex::scoped_lock lk( _sizeStorerSyncMutex );
         try {
             WiredTigerSession session(_conn);
             WT_SESSION* s = session.getSession();
@@ -331,11 +366,13 @@ namespace mongo {
                                              options.cappedSize ? options.cappedSize : 4096,
                                              options.cappedMaxDocs ? options.cappedMaxDocs : -1,
                                              NULL,
-                                             _sizeStorer.get() );
+                                             _sizeStorer.get(),
+                                             _prefetcher.get() );
         }
         else {
             return new WiredTigerRecordStore(opCtx, ns, _uri(ident),
-                                             false, -1, -1, NULL, _sizeStorer.get() );
+                                             false, -1, -1, NULL, _sizeStorer.get(),
+                                             _prefetcher.get() );
         }
     }
 
@@ -392,6 +429,7 @@ namespace mongo {
             {
                 boost::mutex::scoped_lock lk( _identToDropMutex );
                 _identToDrop.insert( uri );
+                _identToDropCount.store( _identToDrop.size() );
             }
             _sessionCache->closeAll();
             return false;
@@ -402,12 +440,29 @@ namespace mongo {
     }
 
     bool WiredTigerKVEngine::haveDropsQueued() const {
-        if ( _sizeStorerSyncTracker.intervalHasElapsed() ) {
-            _sizeStorerSyncTracker.resetLastTime();
-            syncSizeInfo(false);
+        return _identToDropCount.load() != 0;
+    }
+
+    void WiredTigerKVEngine::_sizeStorerSyncLoop() {
+        setThreadName( "WTSizeStorerSync" );
+        const boost::posix_time::seconds period( wiredTigerSizeStorerSyncPeriodSecs );
+
+        boost::mutex::scoped_lock lk( _sizeStorerThreadMutex );
+        while ( !_sizeStorerThreadStop ) {
+            _sizeStorerThreadCondition.timed_wait( lk, period );
+            if ( _sizeStorerThreadStop ) {
+                break;
+            }
+
+            lk.unlock();
+            try {
+                syncSizeInfo(false);
+            }
+            catch ( const std::exception& e ) {
+                warning() << "failed to sync the WiredTiger size storer: " << e.what();
+            }
+            lk.lock();
         }
-        boost::mutex::scoped_lock lk( _identToDropMutex );
-        return !_identToDrop.empty();
     }
 
     void WiredTigerKVEngine::dropAllQueued() {
@@ -445,6 +500,7 @@ namespace mongo {
             for ( set<string>::const_iterator it = deleted.begin(); it != deleted.end(); ++it ) {
                 _identToDrop.erase( *it );
             }
+            _identToDropCount.store( _identToDrop.size() );
         }
     }
 
@@ -35,17 +35,20 @@
 #include <string>
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <wiredtiger.h>
 
 #include "mongo/bson/ordering.h"
 #include "mongo/db/storage/kv/kv_engine.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
-#include "mongo/util/elapsed_tracker.h"
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo {
 
+    class WiredTigerPrefetcher;
     class WiredTigerSessionCache;
     class WiredTigerSizeStorer;
 
@@ -64,6 +67,15 @@ namespace mongo {
 
         virtual bool isDurable() const { return _durable; }
 
+        /**
+         * The WiredTiger we build with has no per-session statistics, so this is what the OS
+         * counted for the thread: data files are read with pread or mapped, so reads which missed
+         * both WiredTiger's cache and the OS's show up as block reads or major page faults.
+         */
+        virtual StorageStats getThreadStorageStats() const {
+            return StorageStats::forThisThread();
+        }
+
         virtual RecoveryUnit* newRecoveryUnit();
 
         virtual Status createRecordStore( OperationContext* opCtx,
@@ -113,6 +125,7 @@ namespace mongo {
         int reconfigure(const char* str);
 
         WT_CONNECTION* getConnection() { return _conn; }
+        WiredTigerSessionCache* getSessionCache() { return _sessionCache.get(); }
         void dropAllQueued();
         bool haveDropsQueued() const;
 
@@ -125,12 +138,19 @@ namespace mongo {
 
         bool _hasUri(WT_SESSION* session, const std::string& uri) const;
 
+        // Body of _sizeStorerSyncThread: syncs the size info in the background every
+        // wiredTigerSizeStorerSyncPeriodSecs until cleanShutdown().
+        void _sizeStorerSyncLoop();
+
         string _uri( const StringData& ident ) const;
         bool _drop( const StringData& ident );
 
         WT_CONNECTION* _conn;
         WT_EVENT_HANDLER _eventHandler;
         boost::scoped_ptr<WiredTigerSessionCache> _sessionCache;
+
+        // NULL if prefetching is disabled.
+        boost::scoped_ptr<WiredTigerPrefetcher> _prefetcher;
         std::string _path;
         bool _durable;
 
@@ -140,9 +160,20 @@ namespace mongo {
         std::set<std::string> _identToDrop;
         mutable boost::mutex _identToDropMutex;
 
+        // Mirrors _identToDrop.size(), so that haveDropsQueued() can be checked without the
+        // mutex on every session release.
+        AtomicUInt32 _identToDropCount;
+
         boost::scoped_ptr<WiredTigerSizeStorer> _sizeStorer;
         string _sizeStorerUri;
-        mutable ElapsedTracker _sizeStorerSyncTracker;
+
+        // Serializes syncSizeInfo(), whose transactions would otherwise conflict.
+        mutable boost::mutex _sizeStorerSyncMutex;
+
+        boost::thread _sizeStorerSyncThread;
+        boost::mutex _sizeStorerThreadMutex;
+        boost::condition_variable _sizeStorerThreadCondition;
+        bool _sizeStorerThreadStop; // guarded by _sizeStorerThreadMutex
     };
 
 }
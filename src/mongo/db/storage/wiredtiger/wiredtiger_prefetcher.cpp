@@ -0,0 +1,97 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_prefetcher.h"
+
+#include <wiredtiger.h>
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+    using std::string;
+    using std::vector;
+
+    WiredTigerPrefetcher::WiredTigerPrefetcher(WiredTigerSessionCache* sessionCache,
+                                               int numThreads)
+        : _sessionCache(sessionCache),
+          _maxQueued(4 * numThreads),
+          _pool(numThreads, "WiredTigerPrefetch") {
+        invariant(numThreads > 0);
+    }
+
+    WiredTigerPrefetcher::~WiredTigerPrefetcher() {
+        shutdown();
+    }
+
+    void WiredTigerPrefetcher::schedule(const string& uri, const vector<int64_t>& keys) {
+        if (_shuttingDown.load() || _pool.tasks_remaining() >= _maxQueued) {
+            return;
+        }
+        _pool.schedule(&WiredTigerPrefetcher::_prefetch, this, uri, keys);
+    }
+
+    void WiredTigerPrefetcher::shutdown() {
+        _shuttingDown.store(1);
+        _pool.join();
+    }
+
+    void WiredTigerPrefetcher::_prefetch(const string& uri, const vector<int64_t>& keys) {
+        if (_shuttingDown.load()) {
+            return;
+        }
+
+        WiredTigerSession* session = _sessionCache->getSession();
+        WT_SESSION* s = session->getSession();
+
+        // The table might be being dropped, so we open a cursor of our own rather than a cached
+        // one, and can live with not getting it.
+        WT_CURSOR* c = NULL;
+        int ret = s->open_cursor(s, uri.c_str(), NULL, NULL, &c);
+        if (ret != 0) {
+            LOG(3) << "not prefetching from " << uri << ": " << wiredtiger_strerror(ret);
+        }
+        else {
+            for (size_t i = 0; i < keys.size() && !_shuttingDown.load(); ++i) {
+                c->set_key(c, keys[i]);
+                // Not finding the record is fine, it may have been deleted since.
+                c->search(c);
+            }
+            c->close(c);
+        }
+
+        _sessionCache->releaseSession(session);
+    }
+
+}  // namespace mongo
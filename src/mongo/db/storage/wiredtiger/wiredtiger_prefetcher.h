@@ -0,0 +1,84 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/thread_pool.h"
+
+namespace mongo {
+
+    class WiredTigerSessionCache;
+
+    /**
+     * Reads records into the WiredTiger cache in the background, ahead of their being read by
+     * queries. Each batch of keys is searched for with a cursor of its own, on a session taken
+     * from the session cache, and what is found is thrown away: only the pages read in matter.
+     *
+     * Hints are dropped rather than queued when the prefetch threads have fallen behind, since
+     * by the time they would get to them the query has likely read the records itself.
+     */
+    class WiredTigerPrefetcher : boost::noncopyable {
+    public:
+        /**
+         * 'sessionCache' must outlive the prefetcher, or at least its shutdown().
+         */
+        WiredTigerPrefetcher(WiredTigerSessionCache* sessionCache, int numThreads);
+
+        ~WiredTigerPrefetcher();
+
+        /**
+         * Schedules reading the records with keys 'keys' of table 'uri'. Doesn't block.
+         */
+        void schedule(const std::string& uri, const std::vector<int64_t>& keys);
+
+        /**
+         * Makes the batches still queued return without reading anything, and waits for the
+         * ones being read. No batches should be scheduled afterwards.
+         */
+        void shutdown();
+
+    private:
+        void _prefetch(const std::string& uri, const std::vector<int64_t>& keys);
+
+        WiredTigerSessionCache* const _sessionCache; // not owned
+
+        // Batches scheduled but not read yet, at most a few per thread.
+        const int _maxQueued;
+
+        AtomicUInt32 _shuttingDown; // Used as boolean - 0 = false, 1 = true
+
+        ThreadPool _pool;
+    };
+
+}  // namespace mongo
@@ -35,23 +35,34 @@
 
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 
+#include <algorithm>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_array.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
 #include <wiredtiger.h>
 
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/oplog_hack.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_global_options.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_prefetcher.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_size_storer.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
 
 //#define RS_ITERATOR_TRACE(x) log() << "WTRS::Iterator " << x
 #define RS_ITERATOR_TRACE(x)
@@ -81,6 +92,292 @@ namespace {
 
     const long long WiredTigerRecordStore::kCollectionScanOnCreationThreshold = 10000;
 
+    // Whether the oplog is deleted from by a background thread, a whole oplog stone at a time,
+    // rather than record by record by the threads inserting into it.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(wiredTigerOplogBackgroundDeletion, bool, true);
+
+    /**
+     * Splits the oplog into "stones": runs of consecutive records holding about
+     * cappedMaxSize / kNumStones bytes each, of which only the newest RecordId and the totals
+     * are kept. Once the oplog is over its cap, a background thread removes the oldest stone
+     * with a single WT_SESSION::truncate, so inserts never pay for deleting old entries.
+     *
+     * At startup the stones are rebuilt by scanning a small oplog, or, for a large one, by
+     * putting their boundaries at sorted random samples of its keys, which is close enough for
+     * deciding what to truncate.
+     */
+    class WiredTigerRecordStore::OplogStones : boost::noncopyable {
+    public:
+        struct Stone {
+            Stone() : records(0), bytes(0) { }
+            Stone(int64_t records, int64_t bytes, const RecordId& lastRecord)
+                : records(records), bytes(bytes), lastRecord(lastRecord) { }
+
+            int64_t records;
+            int64_t bytes;
+            RecordId lastRecord; // the newest record in the stone
+        };
+
+        // Number of stones a full oplog is split into.
+        static const int64_t kNumStones = 100;
+
+        // Random keys sampled per stone when placing the stones of a large oplog at startup.
+        static const int64_t kRandomSamplesPerStone = 10;
+
+        OplogStones(OperationContext* txn, WiredTigerRecordStore* rs);
+
+        /**
+         * Stops and waits for the background thread, if started.
+         */
+        ~OplogStones();
+
+        /**
+         * Starts the background thread truncating stones while the oplog is over its cap.
+         */
+        void start();
+
+        /**
+         * Adds the record of 'bytes' bytes inserted at 'loc' to the stone being filled, once
+         * 'txn' commits.
+         */
+        void registerInsert(OperationContext* txn, int64_t bytes, const RecordId& loc);
+
+        /**
+         * Removes the oldest stone into 'out'. Returns false if there are no whole stones.
+         */
+        bool popOldest(Stone* out);
+
+        /**
+         * Puts back a stone taken by popOldest() that could not be truncated.
+         */
+        void pushOldest(const Stone& stone);
+
+        /**
+         * Forgets the stones reaching 'end' or past it, and the one being filled, after the
+         * newest records have been removed by something other than a stone truncate.
+         */
+        void removeStonesAfter(const RecordId& end);
+
+        void clear();
+
+        WiredTigerSessionCache* sessionCache() const { return _sessionCache; }
+
+    private:
+        class InsertChange;
+
+        void _noteInsert(int64_t bytes, const RecordId& loc);
+        void _initialScan(OperationContext* txn);
+        void _initialSample(OperationContext* txn, int64_t numRecords, int64_t dataSize);
+        bool _hasExcess_inlock() const;
+        void _run();
+
+        WiredTigerRecordStore* const _rs;
+        WiredTigerSessionCache* const _sessionCache; // not owned
+        const int64_t _minBytesPerStone;
+
+        boost::mutex _mutex; // protects everything below
+        boost::condition_variable _excessCond; // notified on new stones and on shutdown
+        std::deque<Stone> _stones; // oldest first
+        int64_t _currentRecords; // in the stone being filled
+        int64_t _currentBytes; // in the stone being filled
+        bool _shuttingDown;
+
+        boost::scoped_ptr<boost::thread> _thread;
+    };
+
+    class WiredTigerRecordStore::OplogStones::InsertChange : public RecoveryUnit::Change {
+    public:
+        InsertChange(OplogStones* stones, int64_t bytes, const RecordId& loc)
+            : _stones(stones), _bytes(bytes), _loc(loc) {
+        }
+
+        virtual void commit() {
+            _stones->_noteInsert(_bytes, _loc);
+        }
+
+        virtual void rollback() {}
+
+    private:
+        OplogStones* _stones;
+        int64_t _bytes;
+        RecordId _loc;
+    };
+
+    WiredTigerRecordStore::OplogStones::OplogStones(OperationContext* txn,
+                                                    WiredTigerRecordStore* rs)
+        : _rs(rs),
+          _sessionCache(WiredTigerRecoveryUnit::get(txn)->getSessionCache()),
+          _minBytesPerStone(std::max(rs->_cappedMaxSize / kNumStones, int64_t(1))),
+          _currentRecords(0),
+          _currentBytes(0),
+          _shuttingDown(false) {
+
+        const int64_t numRecords = rs->_numRecords.load();
+        const int64_t dataSize = rs->_dataSize.load();
+        if (numRecords <= 0 || dataSize <= 0) {
+            return;
+        }
+
+        // Sampling only pays off when it reads far fewer records than a scan would.
+        const int64_t numSamples = (dataSize / _minBytesPerStone) * kRandomSamplesPerStone;
+        if (numRecords < kCollectionScanOnCreationThreshold || numSamples * 2 >= numRecords) {
+            _initialScan(txn);
+        }
+        else {
+            _initialSample(txn, numRecords, dataSize);
+        }
+
+        LOG(1) << "placed " << _stones.size() << " oplog stones of about " << _minBytesPerStone
+               << " bytes for " << rs->ns();
+    }
+
+    WiredTigerRecordStore::OplogStones::~OplogStones() {
+        {
+            boost::mutex::scoped_lock lk(_mutex);
+            _shuttingDown = true;
+            _excessCond.notify_one();
+        }
+
+        if (_thread) {
+            _thread->join();
+        }
+    }
+
+    void WiredTigerRecordStore::OplogStones::start() {
+        invariant(!_thread);
+        _thread.reset(new boost::thread(stdx::bind(&OplogStones::_run, this)));
+    }
+
+    void WiredTigerRecordStore::OplogStones::registerInsert(OperationContext* txn,
+                                                            int64_t bytes,
+                                                            const RecordId& loc) {
+        txn->recoveryUnit()->registerChange(new InsertChange(this, bytes, loc));
+    }
+
+    bool WiredTigerRecordStore::OplogStones::popOldest(Stone* out) {
+        boost::mutex::scoped_lock lk(_mutex);
+        if (_stones.empty()) {
+            return false;
+        }
+        *out = _stones.front();
+        _stones.pop_front();
+        return true;
+    }
+
+    void WiredTigerRecordStore::OplogStones::pushOldest(const Stone& stone) {
+        boost::mutex::scoped_lock lk(_mutex);
+        _stones.push_front(stone);
+    }
+
+    void WiredTigerRecordStore::OplogStones::removeStonesAfter(const RecordId& end) {
+        boost::mutex::scoped_lock lk(_mutex);
+        while (!_stones.empty() && _stones.back().lastRecord >= end) {
+            _stones.pop_back();
+        }
+        _currentRecords = 0;
+        _currentBytes = 0;
+    }
+
+    void WiredTigerRecordStore::OplogStones::clear() {
+        boost::mutex::scoped_lock lk(_mutex);
+        _stones.clear();
+        _currentRecords = 0;
+        _currentBytes = 0;
+    }
+
+    void WiredTigerRecordStore::OplogStones::_noteInsert(int64_t bytes, const RecordId& loc) {
+        boost::mutex::scoped_lock lk(_mutex);
+        _currentRecords++;
+        _currentBytes += bytes;
+        if (_currentBytes < _minBytesPerStone) {
+            return;
+        }
+
+        _stones.push_back(Stone(_currentRecords, _currentBytes, loc));
+        _currentRecords = 0;
+        _currentBytes = 0;
+        _excessCond.notify_one();
+    }
+
+    void WiredTigerRecordStore::OplogStones::_initialScan(OperationContext* txn) {
+        scoped_ptr<RecordIterator> iterator(_rs->getIterator(txn));
+        while (!iterator->isEOF()) {
+            RecordId loc = iterator->getNext();
+            _noteInsert(iterator->dataFor(loc).size(), loc);
+        }
+    }
+
+    void WiredTigerRecordStore::OplogStones::_initialSample(OperationContext* txn,
+                                                            int64_t numRecords,
+                                                            int64_t dataSize) {
+        const int64_t numStones = dataSize / _minBytesPerStone;
+
+        WiredTigerSession* session = WiredTigerRecoveryUnit::get(txn)->getSession();
+        WT_SESSION* s = session->getSession();
+
+        WT_CURSOR* c;
+        invariantWTOK(s->open_cursor(s, _rs->_uri.c_str(), NULL, "next_random=true", &c));
+        ON_BLOCK_EXIT(c->close, c);
+
+        std::vector<int64_t> keys;
+        keys.reserve(numStones * kRandomSamplesPerStone);
+        for (int64_t i = 0; i < numStones * kRandomSamplesPerStone; i++) {
+            int ret = c->next(c);
+            if (ret == WT_NOTFOUND) {
+                break;
+            }
+            invariantWTOK(ret);
+
+            int64_t key;
+            invariantWTOK(c->get_key(c, &key));
+            keys.push_back(key);
+        }
+
+        if (keys.empty()) {
+            return;
+        }
+        std::sort(keys.begin(), keys.end());
+
+        // The whole stones take up the first numStones * _minBytesPerStone of the dataSize
+        // bytes, so stone i ends that fraction of the way through the sorted sample.
+        const int64_t numKeys = keys.size();
+        const int64_t recordsPerStone = numRecords * _minBytesPerStone / dataSize;
+        for (int64_t i = 1; i <= numStones; i++) {
+            int64_t index = i * _minBytesPerStone * numKeys / dataSize;
+            index = std::min(std::max(index, int64_t(1)), numKeys);
+            _stones.push_back(Stone(recordsPerStone, _minBytesPerStone,
+                                    _fromKey(keys[index - 1])));
+        }
+
+        _currentRecords = std::max(numRecords - numStones * recordsPerStone, int64_t(0));
+        _currentBytes = dataSize - numStones * _minBytesPerStone;
+    }
+
+    bool WiredTigerRecordStore::OplogStones::_hasExcess_inlock() const {
+        return !_stones.empty() && _rs->_dataSize.load() > _rs->_cappedMaxSize;
+    }
+
+    void WiredTigerRecordStore::OplogStones::_run() {
+        setThreadName("WTOplogStones");
+
+        boost::mutex::scoped_lock lk(_mutex);
+        while (!_shuttingDown) {
+            if (!_hasExcess_inlock()) {
+                _excessCond.wait(lk);
+                continue;
+            }
+
+            lk.unlock();
+            int truncated = _rs->reclaimOplog();
+            lk.lock();
+
+            if (truncated == 0 && !_shuttingDown) {
+                // The truncate conflicted with a writer; back off rather than spin.
+                _excessCond.timed_wait(lk, boost::posix_time::milliseconds(100));
+            }
+        }
+    }
+
     // static
     StatusWith<std::string> WiredTigerRecordStore::generateCreateString(
         const StringData& ns,
@@ -160,7 +457,8 @@ namespace {
                                                  int64_t cappedMaxSize,
                                                  int64_t cappedMaxDocs,
                                                  CappedDocumentDeleteCallback* cappedDeleteCallback,
-                                                 WiredTigerSizeStorer* sizeStorer)
+                                                 WiredTigerSizeStorer* sizeStorer,
+                                                 WiredTigerPrefetcher* prefetcher)
     : RecordStore( ns ),
               _uri( uri.toString() ),
               _instanceId( WiredTigerSession::genCursorId() ),
@@ -172,7 +470,7 @@ namespace {
               _cappedDeleteCheckCount(0),
               _useOplogHack(shouldUseOplogHack(ctx, _uri)),
               _sizeStorer( sizeStorer ),
-              _sizeStorerCounter(0)
+              _prefetcher( prefetcher )
     {
         Status versionStatus = WiredTigerUtil::checkApplicationMetadataFormatVersion(
             ctx, uri, kMinimumRecordStoreVersion, kMaximumRecordStoreVersion);
@@ -235,10 +533,17 @@ namespace {
 
         }
 
+        if ( _isCapped && _isOplog && wiredTigerOplogBackgroundDeletion ) {
+            _oplogStones.reset( new OplogStones( ctx, this ) );
+            _oplogStones->start();
+        }
     }
 
     WiredTigerRecordStore::~WiredTigerRecordStore() {
         LOG(1) << "~WiredTigerRecordStore for: " << ns();
+        // Stop the oplog's deletion thread before anything it uses goes away.
+        _oplogStones.reset();
+
         if ( _sizeStorer ) {
             _sizeStorer->onDestroy( this );
             _sizeStorer->store( _uri, _numRecords.load(), _dataSize.load() );
@@ -328,6 +633,19 @@ namespace {
         return true;
     }
 
+    void WiredTigerRecordStore::prefetchRecords( OperationContext* txn,
+                                                 const std::vector<RecordId>& locs ) const {
+        if ( !_prefetcher )
+            return;
+
+        std::vector<int64_t> keys;
+        keys.reserve( locs.size() );
+        for ( size_t i = 0; i < locs.size(); ++i ) {
+            keys.push_back( _makeKey( locs[i] ) );
+        }
+        _prefetcher->schedule( _uri, keys );
+    }
+
     void WiredTigerRecordStore::deleteRecord( OperationContext* txn, const RecordId& loc ) {
         WiredTigerCursor cursor( _uri, _instanceId, true, txn );
         cursor.assertInActiveTxn();
@@ -457,6 +775,62 @@ namespace {
         txn->setRecoveryUnit( realRecoveryUnit );
     }
 
+    int WiredTigerRecordStore::reclaimOplog() {
+        if ( !_oplogStones )
+            return 0;
+
+        int truncated = 0;
+        OplogStones::Stone stone;
+        while ( _dataSize.load() > _cappedMaxSize && _oplogStones->popOldest( &stone ) ) {
+            WiredTigerSessionCache* sc = _oplogStones->sessionCache();
+            WiredTigerSession* session = sc->getSession();
+            WT_SESSION* s = session->getSession();
+            invariantWTOK( s->begin_transaction( s, NULL ) );
+
+            WT_CURSOR* c = session->getCursor( _uri, _instanceId, true );
+            invariant( c );
+
+            // With no start cursor, truncate removes everything up to and including the stop
+            // cursor, so position it on the stone's last record, or the one before it.
+            c->set_key( c, _makeKey( stone.lastRecord ) );
+            int cmp;
+            int ret = c->search_near( c, &cmp );
+            if ( ret == 0 && cmp > 0 )
+                ret = c->prev( c );
+            if ( ret == 0 )
+                ret = s->truncate( s, NULL, NULL, c, NULL );
+
+            if ( ret == 0 ) {
+                ret = s->commit_transaction( s, NULL );
+            }
+            else {
+                invariantWTOK( s->rollback_transaction( s, NULL ) );
+            }
+
+            session->releaseCursor( _instanceId, c );
+            sc->releaseSession( session );
+
+            if ( ret == WT_ROLLBACK ) {
+                _oplogStones->pushOldest( stone );
+                break;
+            }
+            // WT_NOTFOUND means the stone's records are already gone.
+            if ( ret != WT_NOTFOUND )
+                invariantWTOK( ret );
+
+            if ( _numRecords.addAndFetch( -stone.records ) < 0 )
+                _numRecords.store( 0 );
+            if ( _dataSize.addAndFetch( -stone.bytes ) < 0 )
+                _dataSize.store( 0 );
+
+            LOG(2) << "truncated oplog stone of " << stone.records << " records and "
+                   << stone.bytes << " bytes up to " << stone.lastRecord << " from " << ns();
+            ++truncated;
+        }
+
+        return truncated;
+    }
+
     StatusWith<RecordId> WiredTigerRecordStore::extractAndCheckLocForOplog(const char* data,
                                                                            int len) {
         return oploghack::extractKey(data, len);
@@ -510,11 +884,55 @@ namespace {
         _changeNumRecords( txn, 1 );
         _increaseDataSize( txn, len );
 
-        cappedDeleteAsNeeded(txn, loc);
+        if ( _oplogStones ) {
+            // The background thread deletes from the oplog, a whole stone at a time.
+            _oplogStones->registerInsert( txn, len, loc );
+        }
+        else {
+            cappedDeleteAsNeeded(txn, loc);
+        }
 
         return StatusWith<RecordId>( loc );
     }
 
+    Status WiredTigerRecordStore::insertRecords( OperationContext* txn,
+                                                 const std::vector<RecordData>& records,
+                                                 bool enforceQuota,
+                                                 std::vector<RecordId>* locsOut ) {
+        if ( _isCapped ) {
+            // Capped collections track uncommitted RecordIds and may delete as they go, which
+            // insertRecord() takes care of.
+            return RecordStore::insertRecords( txn, records, enforceQuota, locsOut );
+        }
+
+        WiredTigerCursor curwrap( _uri, _instanceId, true, txn);
+        curwrap.assertInActiveTxn();
+        WT_CURSOR *c = curwrap.get();
+        invariant( c );
+
+        int64_t totalLength = 0;
+        for ( size_t i = 0; i < records.size(); i++ ) {
+            const RecordId loc = _nextId();
+
+            c->set_key(c, _makeKey(loc));
+            WiredTigerItem value(records[i].data(), records[i].size());
+            c->set_value(c, value.Get());
+            int ret = c->insert(c);
+            if ( ret ) {
+                return wtRCToStatus( ret, "WiredTigerRecordStore::insertRecords" );
+            }
+
+            locsOut->push_back( loc );
+            totalLength += records[i].size();
+        }
+
+        // The caller rolls back on error, so the sizes only need adjusting once for the batch.
+        _changeNumRecords( txn, records.size() );
+        _increaseDataSize( txn, static_cast<int>( totalLength ) );
+
+        return Status::OK();
+    }
+
     void WiredTigerRecordStore::dealtWithCappedLoc( const RecordId& loc ) {
         boost::mutex::scoped_lock lk( _uncommittedDiskLocsMutex );
         SortedDiskLocs::iterator it = std::find(_uncommittedDiskLocs.begin(),
@@ -577,7 +995,7 @@ namespace {
     }
 
     bool WiredTigerRecordStore::updateWithDamagesSupported() const {
-        return false;
+        return true;
     }
 
     Status WiredTigerRecordStore::updateWithDamages( OperationContext* txn,
@@ -585,7 +1003,41 @@ namespace {
                                                      const RecordData& oldRec,
                                                      const char* damageSource,
                                                      const mutablebson::DamageVector& damages ) {
-        invariant(false);
+        // This version of WiredTiger can't modify part of a value, so the value is still written
+        // whole; what this saves is the caller serializing the whole updated document.
+        WiredTigerCursor curwrap( _uri, _instanceId, true, txn);
+        curwrap.assertInActiveTxn();
+        WT_CURSOR *c = curwrap.get();
+        invariant( c );
+        c->set_key(c, _makeKey(loc));
+        int ret = c->search(c);
+        invariantWTOK(ret);
+
+        WT_ITEM old_value;
+        ret = c->get_value(c, &old_value);
+        invariantWTOK(ret);
+
+        // Apply the damages to a copy of the current value: the cursor owns old_value's memory.
+        const int len = old_value.size;
+        boost::scoped_array<char> data( new char[len] );
+        memcpy( data.get(), old_value.data, len );
+
+        mutablebson::DamageVector::const_iterator where = damages.begin();
+        const mutablebson::DamageVector::const_iterator end = damages.end();
+        for( ; where != end; ++where ) {
+            invariant( where->targetOffset + where->size <= static_cast<size_t>( len ) );
+            memcpy( data.get() + where->targetOffset,
+                    damageSource + where->sourceOffset,
+                    where->size );
+        }
+
+        c->set_key(c, _makeKey(loc));
+        WiredTigerItem value(data.get(), len);
+        c->set_value(c, value.Get());
+        ret = c->insert(c);
+        invariantWTOK(ret);
+
+        return Status::OK();
     }
 
     void WiredTigerRecordStore::_oplogSetStartHack( WiredTigerRecoveryUnit* wru ) const {
@@ -627,6 +1079,41 @@ namespace {
         return iterators;
     }
 
+    bool WiredTigerRecordStore::sampleRecords( OperationContext* txn,
+                                               size_t count,
+                                               std::vector<RecordData>* out ) const {
+        // Records of capped collections can be hidden until the ones before them commit, which a
+        // random cursor knows nothing about.
+        if ( _isCapped ) {
+            return false;
+        }
+
+        WiredTigerSession* session = WiredTigerRecoveryUnit::get(txn)->getSession();
+        WT_SESSION* s = session->getSession();
+
+        WT_CURSOR* c;
+        invariantWTOK( s->open_cursor( s, _uri.c_str(), NULL, "next_random=true", &c ) );
+        ON_BLOCK_EXIT(c->close, c);
+
+        // Each call to next() on a random cursor moves it to another random record
+        for ( size_t i = 0; i < count; i++ ) {
+            int ret = c->next(c);
+            if ( ret == WT_NOTFOUND ) {
+                break;
+            }
+            invariantWTOK( ret );
+
+            WT_ITEM value;
+            invariantWTOK( c->get_value(c, &value) );
+
+            SharedBuffer data = SharedBuffer::allocate(value.size);
+            memcpy( data.get(), value.data, value.size );
+            out->push_back( RecordData(data.moveFrom(), value.size) );
+        }
+
+        return true;
+    }
+
     Status WiredTigerRecordStore::truncate( OperationContext* txn ) {
         // TODO: use a WiredTiger fast truncate
         boost::scoped_ptr<RecordIterator> iter( getIterator( txn ) );
@@ -635,6 +1122,10 @@ namespace {
             deleteRecord( txn, loc );
         }
 
+        if ( _oplogStones ) {
+            _oplogStones->clear();
+        }
+
         // WiredTigerRecoveryUnit* ru = _getRecoveryUnit( txn );
 
         return Status::OK();
@@ -769,9 +1260,29 @@ namespace {
     }
 
     Status WiredTigerRecordStore::touch( OperationContext* txn, BSONObjBuilder* output ) const {
+        Timer t;
+
+        // Reading every record through a cursor brings the whole table into the cache.
+        WiredTigerCursor curwrap( _uri, _instanceId, true, txn );
+        WT_CURSOR *c = curwrap.get();
+        invariant( c );
+        long long numRecords = 0;
+        int ret;
+        while ( ( ret = c->next( c ) ) == 0 ) {
+            WT_ITEM value;
+            invariantWTOK( c->get_value( c, &value ) );
+            if ( ++numRecords % 1024 == 0 ) {
+                Status status = txn->checkForInterruptNoAssert();
+                if ( !status.isOK() )
+                    return status;
+            }
+        }
+        if ( ret != WT_NOTFOUND )
+            return wtRCToStatus( ret );
+
         if (output) {
             output->append("numRanges", 1);
-            output->append("millis", 0);
+            output->append("millis", t.millis());
         }
         return Status::OK();
     }
@@ -922,10 +1433,6 @@ namespace {
                 _dataSize.store( 0 );
             }
         }
-
-        if ( _sizeStorer && _sizeStorerCounter++ % 1000 == 0 ) {
-            _sizeStorer->store( _uri, _numRecords.load(), _dataSize.load() );
-        }
     }
 
     int64_t WiredTigerRecordStore::_makeKey( const RecordId& loc ) {
@@ -1170,5 +1677,9 @@ namespace {
             }
         }
         wuow.commit();
+
+        if ( _oplogStones ) {
+            _oplogStones->removeStonesAfter( end );
+        }
     }
 }
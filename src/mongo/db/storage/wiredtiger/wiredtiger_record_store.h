@@ -46,6 +46,7 @@ namespace mongo {
 
     class RecoveryUnit;
     class WiredTigerCursor;
+    class WiredTigerPrefetcher;
     class WiredTigerRecoveryUnit;
     class WiredTigerSizeStorer;
 
@@ -83,7 +84,8 @@ namespace mongo {
                               int64_t cappedMaxSize = -1,
                               int64_t cappedMaxDocs = -1,
                               CappedDocumentDeleteCallback* cappedDeleteCallback = NULL,
-                              WiredTigerSizeStorer* sizeStorer = NULL );
+                              WiredTigerSizeStorer* sizeStorer = NULL,
+                              WiredTigerPrefetcher* prefetcher = NULL );
 
         virtual ~WiredTigerRecordStore();
 
@@ -106,6 +108,11 @@ namespace mongo {
 
         virtual bool findRecord( OperationContext* txn, const RecordId& loc, RecordData* out ) const;
 
+        virtual bool prefetchSupported() const { return _prefetcher != NULL; }
+
+        virtual void prefetchRecords( OperationContext* txn,
+                                      const std::vector<RecordId>& locs ) const;
+
         virtual void deleteRecord( OperationContext* txn, const RecordId& dl );
 
         virtual StatusWith<RecordId> insertRecord( OperationContext* txn,
@@ -117,6 +124,11 @@ namespace mongo {
                                                   const DocWriter* doc,
                                                   bool enforceQuota );
 
+        virtual Status insertRecords( OperationContext* txn,
+                                      const std::vector<RecordData>& records,
+                                      bool enforceQuota,
+                                      std::vector<RecordId>* locsOut );
+
         virtual StatusWith<RecordId> updateRecord( OperationContext* txn,
                                                   const RecordId& oldLocation,
                                                   const char* data,
@@ -139,6 +151,10 @@ namespace mongo {
 
         virtual std::vector<RecordIterator*> getManyIterators( OperationContext* txn ) const;
 
+        virtual bool sampleRecords( OperationContext* txn,
+                                    size_t count,
+                                    std::vector<RecordData>* out ) const;
+
         virtual Status truncate( OperationContext* txn );
 
         virtual bool compactSupported() const { return true; }
@@ -192,6 +208,13 @@ namespace mongo {
         void dealtWithCappedLoc( const RecordId& loc );
         bool isCappedHidden( const RecordId& loc ) const;
 
+        /**
+         * Truncates whole oplog stones off the start of the oplog for as long as it is over its
+         * size cap. Normally called by the oplog's background deletion thread, and a no-op when
+         * there is none. Returns the number of stones truncated.
+         */
+        int reclaimOplog();
+
     private:
 
         class Iterator : public RecordIterator {
@@ -233,6 +256,7 @@ namespace mongo {
         class CappedInsertChange;
         class NumRecordsChange;
         class DataSizeChange;
+        class OplogStones;
 
         static WiredTigerRecoveryUnit* _getRecoveryUnit( OperationContext* txn );
 
@@ -275,7 +299,12 @@ namespace mongo {
         AtomicInt64 _dataSize;
         AtomicInt64 _numRecords;
 
-        WiredTigerSizeStorer* _sizeStorer; // not owned, can be NULL
-        int _sizeStorerCounter;
+        // Not owned, can be NULL. Reads _numRecords and _dataSize when it stores the sizes.
+        WiredTigerSizeStorer* _sizeStorer;
+
+        WiredTigerPrefetcher* _prefetcher; // not owned, can be NULL
+
+        // Non-NULL only for the oplog, when it is deleted from in the background.
+        boost::scoped_ptr<OplogStones> _oplogStones;
     };
 }
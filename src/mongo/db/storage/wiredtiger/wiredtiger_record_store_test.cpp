@@ -39,6 +39,7 @@
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/json.h"
 #include "mongo/db/operation_context_noop.h"
+#include "mongo/db/storage/oplog_hack.h"
 #include "mongo/db/storage/record_store_test_harness.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
@@ -47,6 +48,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -136,6 +138,9 @@ namespace mongo {
         virtual RecoveryUnit* newRecoveryUnit() {
             return new WiredTigerRecoveryUnit( _sessionCache );
         }
+
+        virtual bool supportsDocLocking() { return true; }
+
     private:
         unittest::TempDir _dbpath;
         WT_CONNECTION* _conn;
@@ -269,6 +274,62 @@ namespace mongo {
         }
     }
 
+    TEST(WiredTigerRecordStoreTest, SampleRecords) {
+        scoped_ptr<HarnessHelper> harnessHelper( newHarnessHelper() );
+        scoped_ptr<RecordStore> rs( harnessHelper->newNonCappedRecordStore() );
+
+        {
+            // An empty store has nothing to sample
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            std::vector<RecordData> samples;
+            ASSERT( rs->sampleRecords( opCtx.get(), 10, &samples ) );
+            ASSERT_EQUALS( 0U, samples.size() );
+        }
+
+        const int N = 1000;
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            WriteUnitOfWork uow( opCtx.get() );
+            for ( int i = 0; i < N; i++ ) {
+                BSONObj obj = BSON( "x" << i );
+                StatusWith<RecordId> res = rs->insertRecord( opCtx.get(),
+                                                             obj.objdata(),
+                                                             obj.objsize(),
+                                                             false );
+                ASSERT_OK( res.getStatus() );
+            }
+            uow.commit();
+        }
+
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            std::vector<RecordData> samples;
+            ASSERT( rs->sampleRecords( opCtx.get(), 100, &samples ) );
+            ASSERT_EQUALS( 100U, samples.size() );
+
+            std::set<int> distinct;
+            for ( size_t i = 0; i < samples.size(); i++ ) {
+                int x = samples[i].toBson()["x"].numberInt();
+                ASSERT_GREATER_THAN_OR_EQUALS( x, 0 );
+                ASSERT_LESS_THAN( x, N );
+                distinct.insert( x );
+            }
+
+            // The samples are spread over the store
+            ASSERT_GREATER_THAN( distinct.size(), 1U );
+        }
+    }
+
+    TEST(WiredTigerRecordStoreTest, SampleRecordsCapped) {
+        WiredTigerHarnessHelper harnessHelper;
+        scoped_ptr<RecordStore> rs( harnessHelper.newCappedRecordStore( "a.b", 100000, 10000 ) );
+
+        scoped_ptr<OperationContext> opCtx( harnessHelper.newOperationContext() );
+        std::vector<RecordData> samples;
+        ASSERT_FALSE( rs->sampleRecords( opCtx.get(), 10, &samples ) );
+        ASSERT_EQUALS( 0U, samples.size() );
+    }
+
     TEST(WiredTigerRecordStoreTest, SizeStorer1 ) {
         scoped_ptr<HarnessHelper> harnessHelper( newHarnessHelper() );
         scoped_ptr<RecordStore> rs( harnessHelper->newNonCappedRecordStore() );
@@ -350,6 +411,51 @@ namespace mongo {
         rs.reset( NULL ); // this has to be deleted before ss
     }
 
+    TEST(WiredTigerRecordStoreTest, SizeStorerOnlyStoresChangedEntries) {
+        scoped_ptr<HarnessHelper> harnessHelper( newHarnessHelper() );
+        scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+        WiredTigerSession* session = WiredTigerRecoveryUnit::get( opCtx.get() )->getSession();
+
+        WiredTigerSizeStorer ss;
+        ss.store( "table:a", 1, 10 );
+        ss.store( "table:b", 2, 20 );
+
+        {
+            WriteUnitOfWork uow( opCtx.get() );
+            ss.storeInto( session, "table:sizes1" );
+            uow.commit();
+        }
+
+        // Only the entry stored since is written to a second table.
+        ss.store( "table:b", 3, 30 );
+        {
+            WriteUnitOfWork uow( opCtx.get() );
+            ss.storeInto( session, "table:sizes2" );
+            uow.commit();
+        }
+
+        long long numRecords;
+        long long dataSize;
+
+        WiredTigerSizeStorer ss1;
+        ss1.loadFrom( session, "table:sizes1" );
+        ss1.load( "table:a", &numRecords, &dataSize );
+        ASSERT_EQUALS( 1, numRecords );
+        ASSERT_EQUALS( 10, dataSize );
+        ss1.load( "table:b", &numRecords, &dataSize );
+        ASSERT_EQUALS( 2, numRecords );
+        ASSERT_EQUALS( 20, dataSize );
+
+        WiredTigerSizeStorer ss2;
+        ss2.loadFrom( session, "table:sizes2" );
+        ss2.load( "table:a", &numRecords, &dataSize );
+        ASSERT_EQUALS( 0, numRecords );
+        ASSERT_EQUALS( 0, dataSize );
+        ss2.load( "table:b", &numRecords, &dataSize );
+        ASSERT_EQUALS( 3, numRecords );
+        ASSERT_EQUALS( 30, dataSize );
+    }
+
 namespace {
 
     class GoodValidateAdaptor : public ValidateAdaptor {
@@ -556,6 +662,15 @@ namespace {
             ASSERT_EQ(rs->oplogStartHack(opCtx.get(), RecordId(2,1)), RecordId(1,2)); // between
             ASSERT_EQ(rs->oplogStartHack(opCtx.get(), RecordId(2,2)), RecordId(2,2)); // ==
             ASSERT_EQ(rs->oplogStartHack(opCtx.get(), RecordId(2,3)), RecordId(2,2)); // > highest
+
+            // seek by ts
+            ASSERT_EQ(oploghack::seekToOptime(opCtx.get(), rs.get(), OpTime(0,1)), RecordId());
+            ASSERT_EQ(oploghack::seekToOptime(opCtx.get(), rs.get(), OpTime(2,1)),
+                      RecordId(1,2));
+            ASSERT_EQ(oploghack::seekToOptime(opCtx.get(), rs.get(), OpTime(2,2)),
+                      RecordId(2,2));
+            ASSERT_EQ(oploghack::seekToOptime(opCtx.get(), rs.get(), OpTime(2,-1)),
+                      boost::none); // not a valid key
         }
 
         {
@@ -800,5 +915,41 @@ namespace {
         ASSERT_EQUALS(creationStringElement.type(), String);
     }
 
+    TEST(WiredTigerRecordStoreTest, OplogStonesTruncateInBackground) {
+        scoped_ptr<WiredTigerHarnessHelper> harnessHelper( new WiredTigerHarnessHelper() );
+        scoped_ptr<RecordStore> rs(harnessHelper->newCappedRecordStore("local.oplog.foo",
+                                                                       10000,
+                                                                       -1));
+
+        RecordId first;
+        for ( int i = 1; i <= 2000; i++ ) {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            WriteUnitOfWork uow( opCtx.get() );
+            RecordId loc = _oplogOrderInsertOplog( opCtx.get(), rs, i );
+            if ( i == 1 )
+                first = loc;
+            uow.commit();
+        }
+
+        // Inserting never deletes; the oplog shrinks back under its cap as the background
+        // thread truncates whole stones.
+        scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+        for ( int i = 0; i < 1000 && rs->dataSize( opCtx.get() ) > 10000; i++ ) {
+            sleepmillis( 10 );
+        }
+        ASSERT_LESS_THAN_OR_EQUALS( rs->dataSize( opCtx.get() ), 10000 );
+        ASSERT_GREATER_THAN( rs->dataSize( opCtx.get() ), 5000 );
+
+        long long numRecords = 0;
+        scoped_ptr<RecordIterator> it( rs->getIterator( opCtx.get() ) );
+        ASSERT( !it->isEOF() );
+        ASSERT_GREATER_THAN( it->curr(), first );
+        while ( !it->isEOF() ) {
+            it->getNext();
+            numRecords++;
+        }
+        ASSERT_EQUALS( numRecords, rs->numRecords( opCtx.get() ) );
+    }
+
 
 }  // namespace mongo
@@ -240,6 +240,26 @@ namespace mongo {
         _currentlySquirreled = false;
     }
 
+    bool WiredTigerRecoveryUnit::resetForReuse() {
+        if ( _depth != 0 || _currentlySquirreled )
+            return false;
+
+        // What the destructor does: the session goes back to the cache rather than staying with
+        // an idle connection.
+        _abort();
+        if ( _session ) {
+            _sessionCache->releaseSession( _session );
+            _session = NULL;
+        }
+
+        // _myTransactionCount keeps counting, so that nothing mistakes the next operation's
+        // transactions for this one's.
+        _everStartedWrite = false;
+        _syncing = false;
+        _oplogReadTill = RecordId();
+        return true;
+    }
+
 
     // ---------------------
 
@@ -70,6 +70,8 @@ namespace mongo {
         virtual void beingReleasedFromOperationContext();
         virtual void beingSetOnOperationContext();
 
+        virtual bool resetForReuse();
+
         virtual void commitAndRestart();
 
         // un-used API
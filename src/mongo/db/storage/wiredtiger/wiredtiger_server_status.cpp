@@ -77,6 +77,11 @@ namespace mongo {
             bob.append("reason", status.reason());
         }
 
+        {
+            BSONObjBuilder sessionCacheBuilder(bob.subobjStart("sessionCache"));
+            _engine->getSessionCache()->appendStats(&sessionCacheBuilder);
+        }
+
         return bob.obj();
     }
 
@@ -139,11 +139,18 @@ namespace mongo {
         if (_shuttingDown.load()) return;
         _shuttingDown.store(1);
 
-        {
-            // This ensures that any calls, which are currently inside of getSession/releaseSession
-            // will be able to complete before we start cleaning up the pool. Any others, which are
-            // about to enter will return immediately because of _shuttingDown == true.
-            boost::lock_guard<boost::shared_mutex> lk(_shutdownLock);
+        // This ensures that any calls, which are currently inside of getSession/releaseSession
+        // will be able to complete before we start cleaning up the pool. Any others, which are
+        // about to enter will return immediately because of _shuttingDown == true.
+        for (int i = 0; i < NumSessionCachePartitions; i++) {
+            while (true) {
+                {
+                    boost::unique_lock<SpinLock> scopedLock(_cache[i].lock);
+                    if (_cache[i].opening == 0)
+                        break;
+                }
+                boost::this_thread::yield();
+            }
         }
 
         closeAll();
@@ -168,39 +175,95 @@ namespace mongo {
         }
     }
 
-    WiredTigerSession* WiredTigerSessionCache::getSession() {
-        boost::shared_lock<boost::shared_mutex> shutdownLock(_shutdownLock);
+    void WiredTigerSessionCache::appendStats(BSONObjBuilder* builder) {
+        long long hits = 0;
+        long long misses = 0;
+        long long cached = 0;
+
+        for (int i = 0; i < NumSessionCachePartitions; i++) {
+            boost::unique_lock<SpinLock> scopedLock(_cache[i].lock);
+            hits += _cache[i].hits;
+            misses += _cache[i].misses;
+            cached += _cache[i].pool.size();
+        }
+
+        builder->appendNumber("hits", hits);
+        builder->appendNumber("misses", misses);
+        builder->appendNumber("cached sessions", cached);
+    }
+
+    namespace {
+        // Partition assigned to the current thread, plus one.  Zero means not yet assigned.
+#if defined(MONGO_HAVE___THREAD)
+        __thread int threadCachePartition;
+#elif defined(MONGO_HAVE___DECLSPEC_THREAD)
+        __declspec( thread ) int threadCachePartition;
+#endif
+    }
+
+    // static
+    int WiredTigerSessionCache::_threadCachePartition() {
+#if defined(MONGO_HAVE___THREAD) || defined(MONGO_HAVE___DECLSPEC_THREAD)
+        if (!threadCachePartition) {
+            threadCachePartition =
+                1 + cachePartitionGen.addAndFetch(1) % NumSessionCachePartitions;
+        }
+        return threadCachePartition - 1;
+#else
+        // Spread sessions uniformly across the cache partitions
+        return cachePartitionGen.addAndFetch(1) % NumSessionCachePartitions;
+#endif
+    }
+
+    // static
+    void WiredTigerSessionCache::_assertIdle(WiredTigerSession* session) {
+        // This checks that we are only caching idle sessions and not something which might hold
+        // locks or otherwise prevent truncation.
+        WT_SESSION* ss = session->getSession();
+        uint64_t range;
+        invariantWTOK(ss->transaction_pinned_range(ss, &range));
+        invariant(range == 0);
+    }
 
+    WiredTigerSession* WiredTigerSessionCache::getSession() {
         // We should never be able to get here after _shuttingDown is set, because no new
         // operations should be allowed to start.
         invariant(!_shuttingDown.loadRelaxed());
 
-        // Spread sessions uniformly across the cache partitions
-        const int cachePartition = cachePartitionGen.addAndFetch(1) % NumSessionCachePartitions;
+        const int cachePartition = _threadCachePartition();
+        SessionCachePartition& partition = _cache[cachePartition];
 
         int epoch;
 
         {
-            boost::unique_lock<SpinLock> cachePartitionLock(_cache[cachePartition].lock);
-            epoch = _cache[cachePartition].epoch;
+            boost::unique_lock<SpinLock> cachePartitionLock(partition.lock);
+            invariant(!_shuttingDown.loadRelaxed());
+            epoch = partition.epoch;
 
-            if (!_cache[cachePartition].pool.empty()) {
-                WiredTigerSession* cachedSession = _cache[cachePartition].pool.back();
-                _cache[cachePartition].pool.pop_back();
+            if (!partition.pool.empty()) {
+                WiredTigerSession* cachedSession = partition.pool.back();
+                partition.pool.pop_back();
+                partition.hits++;
 
                 return cachedSession;
             }
+
+            partition.misses++;
+            partition.opening++;
         }
 
         // Outside of the cache partition lock, but on release will be put back on the cache
-        return new WiredTigerSession(_conn, cachePartition, epoch);
+        WiredTigerSession* session = new WiredTigerSession(_conn, cachePartition, epoch);
+
+        boost::unique_lock<SpinLock> cachePartitionLock(partition.lock);
+        partition.opening--;
+        return session;
     }
 
     void WiredTigerSessionCache::releaseSession( WiredTigerSession* session ) {
         invariant( session );
         invariant(session->cursorsOut() == 0);
 
-        boost::shared_lock<boost::shared_mutex> shutdownLock(_shutdownLock);
         if (_shuttingDown.loadRelaxed()) {
             // Leak the session in order to avoid race condition with clean shutdown, where the
             // storage engine is ripped from underneath transactions, which are not "active"
@@ -209,31 +272,30 @@ namespace mongo {
             return;
         }
 
-        // This checks that we are only caching idle sessions and not something which might hold
-        // locks or otherwise prevent truncation.
-        {
-            WT_SESSION* ss = session->getSession();
-            uint64_t range;
-            invariantWTOK(ss->transaction_pinned_range(ss, &range));
-            invariant(range == 0);
-        }
-
         const int cachePartition = session->_getCachePartition();
-        bool returnedToCache = false;
 
         if (cachePartition >= 0) {
             boost::unique_lock<SpinLock> cachePartitionLock(_cache[cachePartition].lock);
 
+            if (_shuttingDown.loadRelaxed()) {
+                // Shutdown started after the check above, leak the session as well.
+                return;
+            }
+
+            _assertIdle(session);
             invariant(session->_getEpoch() <= _cache[cachePartition].epoch);
 
             if (session->_getEpoch() == _cache[cachePartition].epoch) {
                 _cache[cachePartition].pool.push_back(session);
-                returnedToCache = true;
+            }
+            else {
+                // Sessions from an older epoch are rare, so closing them under the lock keeps
+                // them from racing with shutdown.
+                delete session;
             }
         }
-
-        // Do all cleanup outside of the cache partition spinlock.
-        if (!returnedToCache) {
+        else {
+            _assertIdle(session);
             delete session;
         }
 
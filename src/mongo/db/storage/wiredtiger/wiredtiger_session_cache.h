@@ -36,10 +36,10 @@
 #include <vector>
 
 #include <boost/thread/mutex.hpp>
-#include <boost/thread/shared_mutex.hpp>
 
 #include <wiredtiger.h>
 
+#include "mongo/db/jsobj.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/spin_lock.h"
 
@@ -120,22 +120,42 @@ namespace mongo {
 
         void shuttingDown();
 
+        /**
+         * Appends cache hit and miss counts and the number of idle cached sessions.
+         */
+        void appendStats( BSONObjBuilder* builder );
+
     private:
         typedef std::vector<WiredTigerSession*> SessionPool;
 
         enum { NumSessionCachePartitions = 64 };
 
         struct SessionCachePartition {
-            SessionCachePartition() : epoch(0) { }
+            SessionCachePartition() : epoch(0), opening(0), hits(0), misses(0) { }
             ~SessionCachePartition() {
                 invariant(pool.empty());
             }
 
             SpinLock lock;
             int epoch;
+
+            // Number of sessions being opened outside of the lock for this partition.
+            int opening;
+
+            long long hits;
+            long long misses;
+
             SessionPool pool;
         };
 
+        /**
+         * Each thread sticks to one partition, so that it usually gets back the session it
+         * released last and only contends with the few threads sharing its partition.
+         */
+        static int _threadCachePartition();
+
+        static void _assertIdle(WiredTigerSession* session);
+
 
         WiredTigerKVEngine* _engine; // not owned, might be NULL
         WT_CONNECTION* _conn; // not owned
@@ -145,10 +165,9 @@ namespace mongo {
         // to have some form of balance between the partitions.
         SessionCachePartition _cache[NumSessionCachePartitions];
 
-        // Regular operations take it in shared mode. Shutdown sets the _shuttingDown flag and
-        // then takes it in exclusive mode. This ensures that all threads, which would return
-        // sessions to the cache would leak them.
-        boost::shared_mutex _shutdownLock;
+        // Checked under the partition lock.  Shutdown sets it and then waits on the lock of every
+        // partition until no session is being opened, so that all threads which would return
+        // sessions to the cache afterwards leak them instead.
         AtomicUInt32 _shuttingDown; // Used as boolean - 0 = false, 1 = true
     };
 
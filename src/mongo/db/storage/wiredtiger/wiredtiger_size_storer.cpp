@@ -168,9 +168,15 @@ namespace mongo {
                 if ( !entry.dirty )
                     continue;
                 myMap[uriKey] = entry;
+
+                // Only entries that changed since they were last written are written again.
+                entry.dirty = false;
             }
         }
 
+        if ( myMap.empty() )
+            return;
+
         WT_SESSION* s = session->getSession();
         WT_CURSOR* c = NULL;
         int ret = s->open_cursor( s, uri.c_str(), NULL, NULL, &c );
@@ -199,7 +205,6 @@ namespace mongo {
             c->set_key( c, key.Get() );
             c->set_value( c, value.Get() );
             invariantWTOK( c->insert(c) );
-            entry.dirty = false;
 
             c->reset(c);
         }
@@ -43,6 +43,12 @@ namespace mongo {
     class WiredTigerRecordStore;
     class WiredTigerSession;
 
+    /**
+     * Keeps the record count and data size of every record store, and persists them in a WT
+     * table. Record stores registered with onCreate() are not told about each change: their
+     * counters are read when the sizes are stored, and only the ones that changed since they were
+     * last stored are written.
+     */
     class WiredTigerSizeStorer {
     public:
         WiredTigerSizeStorer();
@@ -58,6 +64,11 @@ namespace mongo {
                    long long* numRecords, long long* dataSize ) const;
 
         void loadFrom( WiredTigerSession* cursor, const std::string& uri );
+
+        /**
+         * Writes the entries that changed since the last call, in the session's transaction.
+         * Calls must be serialized, and an entry is not written again if the transaction aborts.
+         */
         void storeInto( WiredTigerSession* cursor, const std::string& uri );
 
     private:
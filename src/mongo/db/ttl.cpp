@@ -34,25 +34,38 @@
 
 #include "mongo/db/ttl.h"
 
+#include <map>
+
 #include "mongo/base/counter.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/user_name.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands/fsync.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/catalog/collection_catalog_entry.h"
 #include "mongo/db/catalog/database_catalog_entry.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/delete.h"
 #include "mongo/db/operation_context_impl.h"
-#include "mongo/db/ops/delete.h"
+#include "mongo/db/ops/delete_request.h"
+#include "mongo/db/ops/parsed_delete.h"
+#include "mongo/db/query/get_executor.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/background.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
+#include "mongo/util/token_bucket.h"
 
 namespace mongo {
 
@@ -64,6 +77,176 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorEnabled, bool, true );
 
+    // Seconds between the start of two passes over the TTL indexes
+    MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorSleepSecs, int, 60 );
+
+    // Threads deleting expired documents, each working through one collection at a time
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER( ttlMonitorThreads, int, 2 );
+
+    // Most documents deleted through one TTL index under one acquisition of the collection lock,
+    // zero for no limit
+    MONGO_EXPORT_SERVER_PARAMETER( ttlDeleteBatchSize, int, 1000 );
+
+    // Limit on the rate of the deletes of all the TTL threads together, zero for no limit
+    MONGO_EXPORT_SERVER_PARAMETER( ttlMaxDocsPerSecond, int, 0 );
+
+namespace {
+
+    // Longest sleep between two checks for shutdown while throttled
+    const long long kMaxThrottleSleepMicros = 100 * 1000;
+
+    /**
+     * Shares the docs/sec budget between the TTL threads.
+     */
+    class TTLThrottle {
+    public:
+        TTLThrottle() : _mutex("TTLThrottle") {}
+
+        void batchDone(long long docs) {
+            long long waitMicros;
+            {
+                SimpleMutex::scoped_lock sl(_mutex);
+                _docsBucket.setRate(ttlMaxDocsPerSecond);
+                waitMicros = _docsBucket.consume(docs, curTimeMicros64());
+            }
+
+            if (waitMicros <= 0) {
+                return;
+            }
+
+            _throttledMicros.fetchAndAdd(waitMicros);
+
+            // Sleep in slices, so shutdown is not held up by a low budget
+            while (waitMicros > 0 && !inShutdown()) {
+                const long long sleepMicros = std::min(waitMicros, kMaxThrottleSleepMicros);
+                sleepmicros(sleepMicros);
+                waitMicros -= sleepMicros;
+            }
+        }
+
+        long long throttledMillis() const {
+            return _throttledMicros.load() / 1000;
+        }
+
+    private:
+        // Protects the bucket
+        SimpleMutex _mutex;
+        TokenBucket _docsBucket;
+
+        AtomicInt64 _throttledMicros;
+    };
+
+    /**
+     * Deletion progress of each TTL index, so a backlog of expired documents shows in
+     * serverStatus. Entries for indexes not seen in a whole pass are dropped.
+     */
+    class TTLIndexStats {
+    public:
+        TTLIndexStats() : _mutex("TTLIndexStats"), _pass(0) {}
+
+        void passStarted() {
+            SimpleMutex::scoped_lock sl(_mutex);
+            _pass++;
+        }
+
+        void passDone() {
+            SimpleMutex::scoped_lock sl(_mutex);
+            for (IndexMap::iterator it = _indexes.begin(); it != _indexes.end(); ) {
+                if (it->second.pass != _pass) {
+                    _indexes.erase(it++);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+
+        void indexStarted(const string& index) {
+            SimpleMutex::scoped_lock sl(_mutex);
+            Stats& stats = _indexes[index];
+            stats.pass = _pass;
+            stats.passDeleted = 0;
+        }
+
+        /**
+         * 'full' is whether the batch hit the batch size, so more expired documents may be left.
+         */
+        void batchDone(const string& index, long long docs, bool full) {
+            SimpleMutex::scoped_lock sl(_mutex);
+            Stats& stats = _indexes[index];
+            stats.deletedDocuments += docs;
+            stats.batches++;
+            stats.passDeleted += docs;
+            stats.behind = full;
+        }
+
+        void indexDone(const string& index, long long millis) {
+            SimpleMutex::scoped_lock sl(_mutex);
+            Stats& stats = _indexes[index];
+            stats.lastPassDeleted = stats.passDeleted;
+            stats.lastPassMillis = millis;
+            stats.passDeleted = 0;
+        }
+
+        void append(BSONObjBuilder* builder) const {
+            SimpleMutex::scoped_lock sl(_mutex);
+            for (IndexMap::const_iterator it = _indexes.begin(); it != _indexes.end(); ++it) {
+                const Stats& stats = it->second;
+                BSONObjBuilder indexBuilder(builder->subobjStart(it->first));
+                indexBuilder.append("deletedDocuments", stats.deletedDocuments);
+                indexBuilder.append("batches", stats.batches);
+                indexBuilder.append("currentPassDeleted", stats.passDeleted);
+                indexBuilder.append("lastPassDeleted", stats.lastPassDeleted);
+                indexBuilder.append("lastPassMillis", stats.lastPassMillis);
+                indexBuilder.append("behind", stats.behind);
+                indexBuilder.doneFast();
+            }
+        }
+
+    private:
+        struct Stats {
+            Stats() : pass(0), deletedDocuments(0), batches(0), passDeleted(0),
+                      lastPassDeleted(0), lastPassMillis(0), behind(false) {}
+
+            long long pass;
+            long long deletedDocuments;
+            long long batches;
+            long long passDeleted;
+            long long lastPassDeleted;
+            long long lastPassMillis;
+            bool behind;
+        };
+
+        typedef std::map<string, Stats> IndexMap;
+
+        // Protects everything below
+        mutable SimpleMutex _mutex;
+        long long _pass;
+        IndexMap _indexes;
+    };
+
+    TTLThrottle ttlThrottle;
+    TTLIndexStats ttlIndexStats;
+
+    class TTLServerStatusSection : public ServerStatusSection {
+    public:
+        TTLServerStatusSection() : ServerStatusSection("ttl") {}
+
+        virtual bool includeByDefault() const { return true; }
+
+        BSONObj generateSection(OperationContext* txn,
+                                const BSONElement& configElement) const {
+            BSONObjBuilder b;
+            b.append("throttledMillis", ttlThrottle.throttledMillis());
+            BSONObjBuilder indexesBuilder(b.subobjStart("indexes"));
+            ttlIndexStats.append(&indexesBuilder);
+            indexesBuilder.doneFast();
+            return b.obj();
+        }
+    } ttlServerStatusSection;
+
+} // namespace
+
     class TTLMonitor : public BackgroundJob {
     public:
         TTLMonitor(){}
@@ -77,8 +260,10 @@ namespace mongo {
             Client::initThread( name().c_str() );
             cc().getAuthorizationSession()->grantInternalAuthorization();
 
+            ThreadPool workers( std::max( ttlMonitorThreads, 1 ), "TTLMonitorWorker" );
+
             while ( ! inShutdown() ) {
-                sleepsecs( 60 );
+                sleepsecs( std::max( ttlMonitorSleepSecs, 1 ) );
 
                 LOG(3) << "TTLMonitor thread awake" << endl;
 
@@ -107,21 +292,31 @@ namespace mongo {
                 dbHolder().getAllShortNames( dbs );
 
                 ttlPasses.increment();
+                ttlIndexStats.passStarted();
 
+                // Collections are independent, so spread them over the workers, and have each
+                // worker go through the TTL indexes of its collection in turn.
                 for ( set<string>::const_iterator i=dbs.begin(); i!=dbs.end(); ++i ) {
                     string db = *i;
 
                     vector<BSONObj> indexes;
                     getTTLIndexesForDB(&txn, db, &indexes);
 
+                    std::map<string, vector<BSONObj> > indexesByCollection;
                     for ( vector<BSONObj>::const_iterator it = indexes.begin();
                           it != indexes.end(); ++it ) {
+                        indexesByCollection[(*it)["ns"].String()].push_back( *it );
+                    }
 
-                        if ( !doTTLForIndex( &txn, db, *it ) ) {
-                            break;  // stop processing TTL indexes on this database
-                        }
+                    for ( std::map<string, vector<BSONObj> >::const_iterator it =
+                              indexesByCollection.begin();
+                          it != indexesByCollection.end(); ++it ) {
+                        workers.schedule( &TTLMonitor::doTTLForCollection, this, db, it->second );
                     }
                 }
+
+                workers.join();
+                ttlIndexStats.passDone();
             }
         }
 
@@ -175,13 +370,36 @@ namespace mongo {
             }
         }
 
+        /**
+         * Runs on a worker of the pool: removes the expired documents of one collection,
+         * through each of its TTL indexes in turn.
+         */
+        void doTTLForCollection( const string& dbName, const vector<BSONObj>& indexes ) {
+            if ( !haveClient() ) {
+                Client::initThread( getThreadName().c_str() );
+                cc().getAuthorizationSession()->grantInternalAuthorization();
+            }
+
+            OperationContextImpl txn;
+            for ( vector<BSONObj>::const_iterator it = indexes.begin();
+                  it != indexes.end(); ++it ) {
+
+                if ( !doTTLForIndex( &txn, dbName, *it ) ) {
+                    break;  // stop processing TTL indexes on this collection
+                }
+            }
+        }
+
         /**
          * Remove documents from the collection using the specified TTL index
          * after a sufficient amount of time has passed according to its expiry
          * specification.
          *
-         * @return true if caller should continue processing TTL indexes of collections
-         *         on the specified database, and false otherwise
+         * The documents are removed in batches of ttlDeleteBatchSize, each under its own
+         * acquisition of the locks, and the batches are paced by ttlMaxDocsPerSecond.
+         *
+         * @return true if caller should continue processing TTL indexes of the
+         *         collection, and false otherwise
          */
         bool doTTLForIndex( OperationContext* txn, const string& dbName, const BSONObj& idx ) {
             BSONObj key = idx["key"].Obj();
@@ -204,17 +422,72 @@ namespace mongo {
                 query = BSON( key.firstElement().fieldName() << b.obj() );
             }
 
+            // Only the documents a partial index holds expire, and asking for just those lets
+            // the deletion use the index.
+            BSONElement filter = idx["partialFilterExpression"];
+            if ( filter.type() == Object ) {
+                query = BSON( "$and" << BSON_ARRAY( query << filter.Obj() ) );
+            }
+
             LOG(1) << "TTL: " << key << " \t " << query << endl;
 
+            const string ns = idx["ns"].String();
+            const string statsName = ns + ".$" + idx["name"].String();
+            const long long batchSize = std::max( ttlDeleteBatchSize, 0 );
+
+            ttlIndexStats.indexStarted( statsName );
+            Timer timer;
+
             long long numDeleted = 0;
+            bool keepGoing = true;
+            while ( !inShutdown() ) {
+                long long batchDeleted = 0;
+                if ( !deleteExpiredBatch( txn, dbName, ns, key, query, batchSize,
+                                          &batchDeleted, &keepGoing ) ) {
+                    break;
+                }
+
+                numDeleted += batchDeleted;
+                ttlDeletedDocuments.increment( batchDeleted );
+
+                const bool full = batchSize > 0 && batchDeleted >= batchSize;
+                ttlIndexStats.batchDone( statsName, batchDeleted, full );
+                if ( !full ) {
+                    break;
+                }
+
+                ttlThrottle.batchDone( batchDeleted );
+            }
+
+            ttlIndexStats.indexDone( statsName, timer.millis() );
+            LOG(1) << "\tTTL deleted: " << numDeleted << endl;
+            return keepGoing;
+        }
+
+        /**
+         * Deletes at most 'limit' documents matching 'query', or all of them if 'limit' is zero,
+         * under one acquisition of the collection lock. The deletion yields as any other.
+         *
+         * @return false if nothing could be deleted through the index this time, setting
+         *         '*keepGoing' to false if the caller should also skip the other TTL indexes
+         *         of the collection
+         */
+        bool deleteExpiredBatch( OperationContext* txn,
+                                 const string& dbName,
+                                 const string& ns,
+                                 const BSONObj& key,
+                                 const BSONObj& query,
+                                 long long limit,
+                                 long long* numDeleted,
+                                 bool* keepGoing ) {
+            const NamespaceString nss( ns );
             int attempt = 1;
             while (1) {
-                const string ns = idx["ns"].String();
-
                 ScopedTransaction scopedXact(txn, MODE_IX);
                 AutoGetDb autoDb(txn, dbName, MODE_IX);
                 Database* db = autoDb.getDb();
                 if (!db) {
+                    *keepGoing = false;
                     return false;
                 }
 
@@ -223,39 +496,47 @@ namespace mongo {
                 Collection* collection = db->getCollection( ns );
                 if ( !collection ) {
                     // collection was dropped
-                    return true;
+                    *keepGoing = false;
+                    return false;
                 }
 
                 if (!repl::getGlobalReplicationCoordinator()->canAcceptWritesForDatabase(dbName)) {
                     // we've stepped down since we started this function,
                     // so we should stop working as we only do deletes on the primary
+                    *keepGoing = false;
                     return false;
                 }
 
                 if ( collection->getIndexCatalog()->findIndexByKeyPattern( txn, key ) == NULL ) {
                     // index not finished yet
                     LOG(1) << " skipping index because not finished";
-                    return true;
+                    return false;
                 }
 
                 try {
-                    numDeleted = deleteObjects(txn,
-                                               db,
-                                               ns,
-                                               query,
-                                               PlanExecutor::YIELD_AUTO,
-                                               false,
-                                               true);
-                    break;
+                    DeleteRequest request( nss );
+                    request.setQuery( query );
+                    request.setMulti();
+                    request.setUpdateOpLog();
+                    request.setLimit( limit );
+                    request.setYieldPolicy( PlanExecutor::YIELD_AUTO );
+
+                    ParsedDelete parsedDelete( txn, &request );
+                    uassertStatusOK( parsedDelete.parseRequest() );
+
+                    PlanExecutor* rawExec;
+                    uassertStatusOK( getExecutorDelete( txn, collection, &parsedDelete,
+                                                        &rawExec ) );
+                    boost::scoped_ptr<PlanExecutor> exec( rawExec );
+
+                    uassertStatusOK( exec->executePlan() );
+                    *numDeleted = DeleteStage::getNumDeleted( exec.get() );
+                    return true;
                 }
                 catch (const WriteConflictException& dle) {
                     WriteConflictException::logAndBackoff(attempt++, "ttl", ns);
                 }
             }
-
-            ttlDeletedDocuments.increment(numDeleted);
-            LOG(1) << "\tTTL deleted: " << numDeleted << endl;
-            return true;
         }
     };
 
@@ -32,6 +32,7 @@
 
 #include "mongo/base/counter.h"
 #include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
@@ -145,6 +146,8 @@ namespace mongo {
         // We assume all options have been validated earlier, if not, programming error
         dassert( validateWriteConcern( writeConcern ).isOK() );
 
+        CurOp::TimeScope writeConcernTime(txn->getCurOp(), CurOp::kWriteConcernTime);
+
         // Next handle blocking on disk
 
         Timer syncTimer;
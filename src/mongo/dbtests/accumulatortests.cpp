@@ -842,6 +842,168 @@ namespace AccumulatorTests {
         
     } // namespace Sum
 
+    namespace ApproxCountDistinct {
+
+        /** Count 'n' distinct ints starting at 'first', each seen twice. */
+        static void processRange( Accumulator* accumulator, int first, int n ) {
+            for ( int i = first; i < first + n; ++i ) {
+                accumulator->process( Value( i ), false );
+                accumulator->process( Value( i ), false );
+            }
+        }
+
+        /** Assert 'actual' is within 'relativeError' of 'expected'. */
+        static void assertNear( double expected, double actual, double relativeError ) {
+            ASSERT_LESS_THAN_OR_EQUALS( fabs( actual - expected ), expected * relativeError );
+        }
+
+        /** No documents evaluated. */
+        class None {
+        public:
+            void run() {
+                intrusive_ptr<Accumulator> accumulator = AccumulatorApproxCountDistinct::create();
+                ASSERT_EQUALS( string( "$approxCountDistinct" ), accumulator->getOpName() );
+                ASSERT_EQUALS( Value( 0LL ), accumulator->getValue( false ) );
+            }
+        };
+
+        /** Numbers comparing equal count once, missing values not at all. */
+        class EqualNumbers {
+        public:
+            void run() {
+                intrusive_ptr<Accumulator> accumulator = AccumulatorApproxCountDistinct::create();
+                accumulator->process( Value( 1 ), false );
+                accumulator->process( Value( 1LL ), false );
+                accumulator->process( Value( 1.0 ), false );
+                accumulator->process( Value(), false );
+                accumulator->process( Value( "a" ), false );
+                ASSERT_EQUALS( Value( 2LL ), accumulator->getValue( false ) );
+            }
+        };
+
+        /** Small counts, kept sparse, are close to exact. */
+        class Small {
+        public:
+            void run() {
+                intrusive_ptr<Accumulator> accumulator = AccumulatorApproxCountDistinct::create();
+                processRange( accumulator.get(), 0, 200 );
+                assertNear( 200, accumulator->getValue( false ).getLong(), 0.05 );
+                ASSERT_EQUALS( Array, accumulator->getValue( true ).getType() );
+            }
+        };
+
+        /** Large counts are estimated in a fixed amount of memory. */
+        class Large {
+        public:
+            void run() {
+                intrusive_ptr<Accumulator> accumulator = AccumulatorApproxCountDistinct::create();
+                processRange( accumulator.get(), 0, 100000 );
+                assertNear( 100000, accumulator->getValue( false ).getLong(), 0.06 );
+                ASSERT_EQUALS( BinData, accumulator->getValue( true ).getType() );
+                ASSERT_LESS_THAN( accumulator->memUsageForSorter(),
+                                  int( 2 * AccumulatorApproxCountDistinct::kNumRegisters ) );
+            }
+        };
+
+        /** Shard results merge into the count of their union. */
+        class Merge {
+        public:
+            void run() {
+                intrusive_ptr<Accumulator> denseShard = AccumulatorApproxCountDistinct::create();
+                processRange( denseShard.get(), 0, 60000 );
+                intrusive_ptr<Accumulator> otherDenseShard =
+                    AccumulatorApproxCountDistinct::create();
+                processRange( otherDenseShard.get(), 40000, 60000 );
+                intrusive_ptr<Accumulator> sparseShard = AccumulatorApproxCountDistinct::create();
+                processRange( sparseShard.get(), 100000, 100 );
+
+                intrusive_ptr<Accumulator> router = AccumulatorApproxCountDistinct::create();
+                router->process( sparseShard->getValue( true ), true );
+                router->process( denseShard->getValue( true ), true );
+                router->process( otherDenseShard->getValue( true ), true );
+                assertNear( 100100, router->getValue( false ).getLong(), 0.06 );
+            }
+        };
+
+    } // namespace ApproxCountDistinct
+
+    namespace ApproxPercentile {
+
+        /** The {input: <x>, p: <p>} object $approxPercentile evaluates. */
+        static Value input( const Value& x, double p ) {
+            return Value( DOC( "input" << x << "p" << p ) );
+        }
+
+        /** Process 1, 2, ... 'n', shuffled, and return the accumulator. */
+        static intrusive_ptr<Accumulator> processRange( int n, double p ) {
+            intrusive_ptr<Accumulator> accumulator = AccumulatorApproxPercentile::create();
+            for ( int i = 0; i < n; ++i ) {
+                accumulator->process( input( Value( ( i * 7919 ) % n + 1 ), p ), false );
+            }
+            return accumulator;
+        }
+
+        /** No numeric input gives null. */
+        class None {
+        public:
+            void run() {
+                intrusive_ptr<Accumulator> accumulator = AccumulatorApproxPercentile::create();
+                ASSERT_EQUALS( string( "$approxPercentile" ), accumulator->getOpName() );
+                accumulator->process( input( Value( "a" ), 0.5 ), false );
+                ASSERT_EQUALS( jstNULL, accumulator->getValue( false ).getType() );
+            }
+        };
+
+        /** The input has to be an object with p between 0 and 1. */
+        class BadInput {
+        public:
+            void run() {
+                intrusive_ptr<Accumulator> accumulator = AccumulatorApproxPercentile::create();
+                ASSERT_THROWS( accumulator->process( Value( 1 ), false ), UserException );
+                ASSERT_THROWS( accumulator->process( input( Value( 1 ), 1.5 ), false ),
+                               UserException );
+                ASSERT_THROWS( accumulator->process( Value( DOC( "input" << 1 ) ), false ),
+                               UserException );
+            }
+        };
+
+        /** Percentiles of many values are close, and the extremes exact. */
+        class Estimates {
+        public:
+            void run() {
+                const double ps[] = { 0, 0.01, 0.25, 0.5, 0.9, 0.99, 1 };
+                for ( size_t i = 0; i < sizeof( ps ) / sizeof( ps[0] ); ++i ) {
+                    intrusive_ptr<Accumulator> accumulator = processRange( 10000, ps[i] );
+                    const double estimate = accumulator->getValue( false ).getDouble();
+                    ASSERT_LESS_THAN_OR_EQUALS( fabs( estimate - ( 1 + ps[i] * 9999 ) ), 50 );
+                    ASSERT_LESS_THAN( accumulator->memUsageForSorter(), 32 * 1024 );
+                }
+                ASSERT_EQUALS( 1, processRange( 10000, 0 )->getValue( false ).getDouble() );
+                ASSERT_EQUALS( 10000, processRange( 10000, 1 )->getValue( false ).getDouble() );
+            }
+        };
+
+        /** Shard results merge into the percentile of their union. */
+        class Merge {
+        public:
+            void run() {
+                intrusive_ptr<Accumulator> lowShard = AccumulatorApproxPercentile::create();
+                intrusive_ptr<Accumulator> highShard = AccumulatorApproxPercentile::create();
+                for ( int i = 1; i <= 5000; ++i ) {
+                    lowShard->process( input( Value( i ), 0.9 ), false );
+                    highShard->process( input( Value( i + 5000 ), 0.9 ), false );
+                }
+
+                intrusive_ptr<Accumulator> router = AccumulatorApproxPercentile::create();
+                router->process( lowShard->getValue( true ), true );
+                router->process( highShard->getValue( true ), true );
+                const double estimate = router->getValue( false ).getDouble();
+                ASSERT_LESS_THAN_OR_EQUALS( fabs( estimate - 9000 ), 50 );
+            }
+        };
+
+    } // namespace ApproxPercentile
+
     class All : public Suite {
     public:
         All() : Suite( "accumulator" ) {
@@ -918,6 +1080,17 @@ namespace AccumulatorTests {
             add<Sum::IntNull>();
             add<Sum::IntUndefined>();
             add<Sum::NoOverflowBeforeDouble>();
+
+            add<ApproxCountDistinct::None>();
+            add<ApproxCountDistinct::EqualNumbers>();
+            add<ApproxCountDistinct::Small>();
+            add<ApproxCountDistinct::Large>();
+            add<ApproxCountDistinct::Merge>();
+
+            add<ApproxPercentile::None>();
+            add<ApproxPercentile::BadInput>();
+            add<ApproxPercentile::Estimates>();
+            add<ApproxPercentile::Merge>();
         }
     };
 
@@ -527,6 +527,42 @@ namespace BasicTests {
         }
     } ctest1;
 
+    class ParallelCompression {
+    public:
+        void run() {
+            // Sizes around the compressor's block size of 64KB
+            const size_t sizes[] = { 0, 100, 64 * 1024, 64 * 1024 + 1, 7 * 64 * 1024 + 13,
+                                     4 * 1024 * 1024 + 5 };
+
+            for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+                std::string input;
+                for (size_t j = 0; j < sizes[i]; j++) {
+                    input += static_cast<char>((j % 7 == 0) ? (j / 1000) : 'a' + (j % 13));
+                }
+
+                std::vector<char> expected(maxCompressedLength(input.size()));
+                size_t expectedLength = 0;
+                rawCompress(input.data(), input.size(), &expected[0], &expectedLength);
+
+                for (size_t numThreads = 1; numThreads <= 5; numThreads++) {
+                    std::vector<char> compressed(maxCompressedLength(input.size()));
+                    size_t compressedLength = 0;
+                    rawCompressParallel(input.data(), input.size(), &compressed[0],
+                                        &compressedLength, numThreads);
+
+                    ASSERT_EQUALS(expectedLength, compressedLength);
+                    ASSERT(std::equal(compressed.begin(),
+                                      compressed.begin() + compressedLength,
+                                      expected.begin()));
+
+                    std::string out;
+                    ASSERT(uncompress(&compressed[0], compressedLength, &out));
+                    ASSERT(out == input);
+                }
+            }
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "basic" ) {
@@ -558,6 +594,7 @@ namespace BasicTests {
             add< RelativePathTest >();
 
             add< CompressionTest1 >();
+            add< ParallelCompression >();
 
         }
     };
@@ -104,6 +104,60 @@ namespace mongo {
         int _max;
     };
 
+    /** Counts the batches of deletes of Helpers::removeRange. */
+    class CountingThrottle : public Helpers::RemoveRangeThrottle {
+    public:
+        CountingThrottle( long long batchSize ) :
+                _batchSize( batchSize ), _batches( 0 ), _docs( 0 ), _bytes( 0 )
+        {
+        }
+
+        virtual long long getBatchSize() { return _batchSize; }
+
+        virtual void batchDone( OperationContext* txn, long long docs, long long bytes ) {
+            ASSERT( !txn->lockState()->isLocked() );
+            ASSERT_LESS_THAN_OR_EQUALS( docs, _batchSize );
+            _batches++;
+            _docs += docs;
+            _bytes += bytes;
+        }
+
+        const long long _batchSize;
+        int _batches;
+        long long _docs;
+        long long _bytes;
+    };
+
+    /** Helpers::RemoveRange deletes in batches when given a throttle. */
+    class RemoveRangeBatched {
+    public:
+        void run() {
+            const char* const batchedNs = "unittests.removetests_batched";
+
+            OperationContextImpl txn;
+            DBDirectClient client(&txn);
+            client.dropCollection( batchedNs );
+
+            for ( int i = 0; i < 10; ++i ) {
+                client.insert( batchedNs, BSON( "_id" << i ) );
+            }
+
+            KeyRange range( batchedNs,
+                            BSON( "_id" << 1 ),
+                            BSON( "_id" << 8 ),
+                            BSON( "_id" << 1 ) );
+            mongo::WriteConcernOptions dummyWriteConcern;
+            CountingThrottle throttle( 3 );
+            ASSERT_EQUALS( 7, Helpers::removeRange( &txn, range, false, dummyWriteConcern,
+                                                    NULL, false, false, &throttle ) );
+
+            ASSERT_EQUALS( 3, throttle._batches );
+            ASSERT_EQUALS( 7, throttle._docs );
+            ASSERT_EQUALS( 7 * BSON( "_id" << 1 ).objsize(), throttle._bytes );
+            ASSERT_EQUALS( 3U, client.count( batchedNs ) );
+        }
+    };
+
     class All: public Suite {
     public:
         All() :
@@ -112,6 +166,7 @@ namespace mongo {
         }
         void setupTests() {
             add<RemoveRange>();
+            add<RemoveRangeBatched>();
         }
     } myall;
 
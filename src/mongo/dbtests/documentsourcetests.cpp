@@ -44,6 +44,7 @@
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/dbtests/dbtests.h"
 
@@ -336,6 +337,48 @@ namespace DocumentSourceTests {
             }
         };
 
+        /** Batches grow while they are read within the time target, and explain reports them. */
+        class AdaptiveBatchSize : public Base {
+        public:
+            AdaptiveBatchSize()
+                : _targetMS(internalDocumentSourceCursorBatchTargetMS) {
+                // No batch is slow enough to shrink the next one.
+                internalDocumentSourceCursorBatchTargetMS = 1000 * 1000;
+            }
+            ~AdaptiveBatchSize() {
+                internalDocumentSourceCursorBatchTargetMS = _targetMS;
+            }
+            void run() {
+                const string filler(10 * 1024, 'x');
+                for (int i = 0; i < 200; ++i) {
+                    client.insert(ns, BSON("_id" << i << "filler" << filler));
+                }
+                createSource();
+
+                // The first batch reads a little past its initial budget of 256KB.
+                ASSERT(bool(source()->getNext()));
+                Document batching = batchingStats();
+                ASSERT_EQUALS(Value(1), batching["batches"]);
+                ASSERT_GREATER_THAN(batching["bytes"].getLong(), 256 * 1024);
+                ASSERT_EQUALS(Value(0), batching["slowBatches"]);
+                ASSERT_EQUALS(Value(512 * 1024), batching["nextBatchBytes"]);
+
+                // Draining it loads a second, larger batch.
+                const long long firstBatchBytes = batching["bytes"].getLong();
+                while (batchingStats()["batches"].getLong() == 1) {
+                    ASSERT(bool(source()->getNext()));
+                }
+                batching = batchingStats();
+                ASSERT_GREATER_THAN(batching["bytes"].getLong() - firstBatchBytes, 512 * 1024);
+                ASSERT_EQUALS(Value(1024 * 1024), batching["nextBatchBytes"]);
+            }
+        private:
+            Document batchingStats() {
+                Document explain = source()->serialize(true).getDocument();
+                return explain["$cursor"]["batching"].getDocument();
+            }
+            const int _targetMS;
+        };
 
     } // namespace DocumentSourceCursor
 
@@ -905,6 +948,54 @@ namespace DocumentSourceTests {
             string expectedResultSetString() { return "[{_id:[1,2,3],a:[[4,5,6]]}]"; }
         };
 
+        /** Returns a fixed list of documents, reporting them as sorted on 'a'. */
+        class SortedOnA : public DocumentSource {
+        public:
+            SortedOnA(const intrusive_ptr<ExpressionContext>& ctx, const vector<BSONObj>& docs)
+                : DocumentSource(ctx), _docs(docs), _next(0) {
+            }
+            virtual boost::optional<Document> getNext() {
+                if (_next == _docs.size())
+                    return boost::none;
+                return Document(_docs[_next++]);
+            }
+            virtual BSONObj getOutputSort() const { return BSON("a" << 1); }
+            size_t consumed() const { return _next; }
+        private:
+            virtual Value serialize(bool explain) const { return Value(); }
+            vector<BSONObj> _docs;
+            size_t _next;
+        };
+
+        /** Input sorted on the group key is grouped as it streams. */
+        class StreamingSortedInput : public Base {
+        public:
+            void run() {
+                vector<BSONObj> docs;
+                docs.push_back(BSON("a" << 1 << "x" << 1));
+                docs.push_back(BSON("a" << 1 << "x" << 2));
+                docs.push_back(BSON("a" << 2 << "x" << 3));
+                docs.push_back(BSON("x" << 4)); // missing and null keys are held back to the end
+                docs.push_back(BSON("a" << 3 << "x" << 5));
+                docs.push_back(BSON("a" << BSONNULL << "x" << 6));
+                intrusive_ptr<SortedOnA> input = new SortedOnA(ctx(), docs);
+
+                BSONObj spec = BSON("$group" << fromjson("{_id:'$a',s:{$sum:'$x'}}"));
+                intrusive_ptr<DocumentSource> group =
+                        DocumentSourceGroup::createFromBson(spec.firstElement(), ctx());
+                group->setSource(input.get());
+
+                // Each group comes out as soon as the next one starts.
+                ASSERT_EQUALS(BSON("_id" << 1 << "s" << 3), group->getNext()->toBson());
+                ASSERT_EQUALS(3U, input->consumed());
+                ASSERT_EQUALS(BSON("_id" << 2 << "s" << 3), group->getNext()->toBson());
+                ASSERT_EQUALS(5U, input->consumed());
+                ASSERT_EQUALS(BSON("_id" << 3 << "s" << 5), group->getNext()->toBson());
+                ASSERT_EQUALS(BSON("_id" << BSONNULL << "s" << 10), group->getNext()->toBson());
+                ASSERT(!group->getNext());
+            }
+        };
+
     } // namespace DocumentSourceGroup
 
     namespace DocumentSourceProject {
@@ -1899,6 +1990,7 @@ namespace DocumentSourceTests {
             add<DocumentSourceCursor::Dispose>();
             add<DocumentSourceCursor::IterateDispose>();
             add<DocumentSourceCursor::LimitCoalesce>();
+            add<DocumentSourceCursor::AdaptiveBatchSize>();
 
             add<DocumentSourceLimit::DisposeSource>();
             add<DocumentSourceLimit::DisposeSourceCascade>();
@@ -1939,6 +2031,7 @@ namespace DocumentSourceTests {
             add<DocumentSourceGroup::Dependencies>();
             add<DocumentSourceGroup::StringConstantIdAndAccumulatorExpressions>();
             add<DocumentSourceGroup::ArrayConstantAccumulatorExpression>();
+            add<DocumentSourceGroup::StreamingSortedInput>();
 
             add<DocumentSourceProject::Inclusion>();
             add<DocumentSourceProject::Optimize>();
@@ -292,6 +292,29 @@ namespace DocumentTests {
             }
         };
 
+        /** getOwned() copies documents built in a BumpArena back to the heap. */
+        class GetOwnedLeavesArena {
+        public:
+            void run() {
+                const std::string longString(100, 'x');
+                BumpArena arena;
+                Document inArena;
+                {
+                    BumpArena::Scope arenaScope(&arena);
+                    inArena = DOC("a" << longString << "b" << DOC("c" << 1)
+                                      << "d" << DOC_ARRAY(longString));
+                }
+                ASSERT(inArena.isInArena());
+
+                const Document owned = inArena.getOwned();
+                ASSERT(!owned.isInArena());
+                ASSERT_EQUALS(inArena, owned);
+
+                // Documents already on the heap are not copied.
+                ASSERT_EQUALS(owned.getPtr(), owned.getOwned().getPtr());
+            }
+        };
+
         /** Shallow copy clone of a multi field Document. */
         class CloneMultipleFields {
         public:
@@ -1428,6 +1451,7 @@ namespace DocumentTests {
             add<Document::CompareNamedNull>();
             add<Document::Clone>();
             add<Document::CloneMultipleFields>();
+            add<Document::GetOwnedLeavesArena>();
             add<Document::FieldIteratorEmpty>();
             add<Document::FieldIteratorSingle>();
             add<Document::FieldIteratorMultiple>();
@@ -885,7 +885,136 @@ namespace ExpressionTests {
         };
         
     } // namespace Compare
-    
+
+    namespace CompiledArithmetic {
+
+        /** Parse 'spec' into an expression, unoptimized. */
+        static intrusive_ptr<Expression> parse( const BSONObj& spec ) {
+            BSONObj specObject = BSON( "" << spec );
+            VariablesIdGenerator idGenerator;
+            VariablesParseState vps( &idGenerator );
+            return Expression::parseOperand( specObject.firstElement(), vps );
+        }
+
+        /** Optimizing an arithmetic tree compiles it, leaving its serialization alone. */
+        class Compiles {
+        public:
+            void run() {
+                BSONObj spec = BSON( "$add" << BSON_ARRAY( "$a" << BSON( "$multiply" <<
+                                                           BSON_ARRAY( "$b" << 2 ) ) ) );
+                intrusive_ptr<Expression> optimized = parse( spec )->optimize();
+                ASSERT( dynamic_cast<ExpressionCompiledArithmetic*>( optimized.get() ) );
+                ASSERT_EQUALS( constify( spec ), expressionToBson( optimized ) );
+                // Compiling again is a no-op.
+                ASSERT( optimized == optimized->optimize() );
+            }
+        };
+
+        /** Nested $adds are still flattened and their constants folded together. */
+        class FlattensNested {
+        public:
+            void run() {
+                BSONObj spec = BSON( "$add" << BSON_ARRAY( "$a" << BSON( "$add" <<
+                                                           BSON_ARRAY( "$b" << 1 ) ) << 2 ) );
+                intrusive_ptr<Expression> optimized = parse( spec )->optimize();
+                ASSERT( dynamic_cast<ExpressionCompiledArithmetic*>( optimized.get() ) );
+                ASSERT_EQUALS( constify( BSON( "$add" << BSON_ARRAY( "$a" << "$b" << 3 ) ) ),
+                               expressionToBson( optimized ) );
+                ASSERT_EQUALS( BSON( "" << 6 ),
+                               toBson( optimized->evaluate( fromBson( BSON( "a" << 1 <<
+                                                                            "b" << 2 ) ) ) ) );
+            }
+        };
+
+        /** Arithmetic under another operator is compiled too. */
+        class CompilesOperand {
+        public:
+            void run() {
+                BSONObj spec = BSON( "$concat" << BSON_ARRAY( "x" << BSON( "$substr" <<
+                    BSON_ARRAY( "$s" << BSON( "$subtract" << BSON_ARRAY( "$a" << 1 ) ) << 2 ) ) ) );
+                intrusive_ptr<Expression> optimized = parse( spec )->optimize();
+                ASSERT_EQUALS( constify( spec ), expressionToBson( optimized ) );
+                ASSERT_EQUALS( BSON( "" << "xbc" ),
+                               toBson( optimized->evaluate( fromBson( BSON( "s" << "abcd" <<
+                                                                            "a" << 2 ) ) ) ) );
+            }
+        };
+
+        /** A non numeric constant operand leaves the tree as it is. */
+        class NonNumericConstant {
+        public:
+            void run() {
+                intrusive_ptr<Expression> optimized =
+                    parse( BSON( "$add" << BSON_ARRAY( "$a" << Date_t(5) ) ) )->optimize();
+                ASSERT( !dynamic_cast<ExpressionCompiledArithmetic*>( optimized.get() ) );
+            }
+        };
+
+        /**
+         * The compiled program gives the same results, down to the numeric type, as evaluating the
+         * tree, including for operands the program gives up on.
+         */
+        class MatchesTree {
+        public:
+            void run() {
+                const BSONObj specs[] = {
+                    BSON( "$add" << BSON_ARRAY( "$a" << "$b" << "$c" ) ),
+                    BSON( "$multiply" << BSON_ARRAY( "$a" << "$b" ) ),
+                    BSON( "$subtract" << BSON_ARRAY( BSON( "$multiply" << BSON_ARRAY( "$a" << "$b" ) )
+                                                     << BSON( "$mod" << BSON_ARRAY( "$a" << "$c" ) ) ) ),
+                    BSON( "$divide" << BSON_ARRAY( BSON( "$add" << BSON_ARRAY( "$a" << "$b" ) )
+                                                   << "$c" ) ),
+                    BSON( "$mod" << BSON_ARRAY( "$b" << "$c" ) ),
+                    BSON( "$subtract" << BSON_ARRAY( "$a" << BSON( "$add" << BSON_ARRAY( "$b" << 1 ) ) ) ),
+                };
+                const BSONObj inputs[] = {
+                    BSON( "a" << 7 << "b" << 3 << "c" << 2 ),
+                    BSON( "a" << 2000000000 << "b" << 2000000000 << "c" << 3 ),
+                    BSON( "a" << 5LL << "b" << 3 << "c" << 4 ),
+                    BSON( "a" << 1.5 << "b" << 3 << "c" << 0.5 ),
+                    BSON( "a" << 10 << "b" << 7.0 << "c" << 2.0 ),
+                    BSON( "a" << 10 << "b" << 7 << "c" << 2.5 ),
+                    BSON( "a" << -9 << "b" << 4LL << "c" << 3LL ),
+                    BSON( "a" << 1 << "b" << BSONNULL << "c" << 2 ),
+                    BSON( "a" << 1 << "c" << 2 ),
+                    BSON( "a" << Date_t(1000) << "b" << 1 << "c" << 3 ),
+                };
+
+                for ( size_t i = 0; i < sizeof( specs ) / sizeof( specs[0] ); ++i ) {
+                    intrusive_ptr<Expression> tree = parse( specs[i] );
+                    intrusive_ptr<Expression> compiled = parse( specs[i] )->optimize();
+                    ASSERT( dynamic_cast<ExpressionCompiledArithmetic*>( compiled.get() ) );
+
+                    for ( size_t j = 0; j < sizeof( inputs ) / sizeof( inputs[0] ); ++j ) {
+                        Document input = fromBson( inputs[j] );
+                        BSONObj expected;
+                        try {
+                            expected = toBson( tree->evaluate( input ) );
+                        }
+                        catch ( const UserException& ) {
+                            ASSERT_THROWS( compiled->evaluate( input ), UserException );
+                            continue;
+                        }
+                        assertBinaryEqual( expected, toBson( compiled->evaluate( input ) ) );
+                    }
+                }
+            }
+        };
+
+        /** Dividing by zero fails as it does uncompiled. */
+        class DivideByZero {
+        public:
+            void run() {
+                intrusive_ptr<Expression> compiled =
+                    parse( BSON( "$divide" << BSON_ARRAY( "$a" << "$b" ) ) )->optimize();
+                ASSERT( dynamic_cast<ExpressionCompiledArithmetic*>( compiled.get() ) );
+                ASSERT_THROWS( compiled->evaluate( fromBson( BSON( "a" << 1 << "b" << 0 ) ) ),
+                               UserException );
+            }
+        };
+
+    } // namespace CompiledArithmetic
+
     namespace Constant {
 
         /** Create an ExpressionConstant from a Value. */
@@ -3542,6 +3671,12 @@ namespace ExpressionTests {
             add<Compare::OptimizeGte>();
             add<Compare::OptimizeGteReverse>();
 
+            add<CompiledArithmetic::Compiles>();
+            add<CompiledArithmetic::FlattensNested>();
+            add<CompiledArithmetic::CompilesOperand>();
+            add<CompiledArithmetic::NonNumericConstant>();
+            add<CompiledArithmetic::MatchesTree>();
+            add<CompiledArithmetic::DivideByZero>();
             add<Constant::Create>();
             add<Constant::CreateFromBsonElement>();
             add<Constant::Optimize>();
@@ -38,6 +38,7 @@
 #include "mongo/util/assert_util.h"
 
 using mongo::DBDirectClient;
+using mongo::GridFile;
 using mongo::GridFS;
 using mongo::MsgAssertionException;
 
@@ -60,6 +61,61 @@ namespace {
         virtual ~SetChunkSizeTest() {}
     };
 
+    class SetUploadConnectionsTest {
+    public:
+        virtual void run() {
+            OperationContextImpl txn;
+            DBDirectClient client(&txn);
+
+            GridFS grid(client, "gridtest");
+            ASSERT_EQUALS( 1U, grid.getUploadConnections() );
+            grid.setUploadConnections( 4 );
+
+            ASSERT_EQUALS( 4U, grid.getUploadConnections() );
+            ASSERT_THROWS( grid.setUploadConnections( 0 ), MsgAssertionException );
+            ASSERT_EQUALS( 4U, grid.getUploadConnections() );
+        }
+
+        virtual ~SetUploadConnectionsTest() {}
+    };
+
+    class WriteRangeTest {
+    public:
+        virtual void run() {
+            OperationContextImpl txn;
+            DBDirectClient client(&txn);
+
+            GridFS grid(client, "gridtest");
+            grid.setChunkSize( 5 );
+
+            const std::string data = "abcdefghijklmnopqrstuvw";
+            grid.storeFile( data.c_str(), data.size(), "writerange" );
+            GridFile file = grid.findFile( "writerange" );
+            ASSERT_EQUALS( 5, file.getNumChunks() );
+
+            // Whole file, within one chunk, across chunks, and running off the end
+            ASSERT_EQUALS( data, write( file, 0, data.size() ) );
+            ASSERT_EQUALS( "gh", write( file, 6, 2 ) );
+            ASSERT_EQUALS( "defghijklm", write( file, 3, 10 ) );
+            ASSERT_EQUALS( "uvw", write( file, 20, 100 ) );
+            ASSERT_EQUALS( "", write( file, 23, 1 ) );
+
+            grid.removeFile( "writerange" );
+        }
+
+        virtual ~WriteRangeTest() {}
+
+    private:
+        static std::string write( const GridFile& file,
+                                  mongo::gridfs_offset offset,
+                                  mongo::gridfs_offset length ) {
+            std::stringstream ss;
+            const mongo::gridfs_offset written = file.write( ss, offset, length );
+            ASSERT_EQUALS( ss.str().size(), written );
+            return ss.str();
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "gridfs" ) {
@@ -67,6 +123,8 @@ namespace {
 
         void setupTests() {
             add< SetChunkSizeTest >();
+            add< SetUploadConnectionsTest >();
+            add< WriteRangeTest >();
         }
     };
 
@@ -40,6 +40,7 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
+#include "mongo/db/json_fast_path.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/util/log.h"
 
@@ -2672,6 +2673,145 @@ namespace JsonTests {
 
     } // namespace FromJsonTests
 
+    namespace FastPathTests {
+
+        /** Strict JSON that fromjsonFastPath() parses itself, matching the full parser. */
+        class Base {
+        public:
+            virtual ~Base() {}
+            void run() {
+                const string json = this->json();
+                BSONObj fast;
+                int fastLen = -1;
+                ASSERT( fromjsonFastPath( json, &fast, &fastLen ) );
+                ASSERT( fast.binaryEqual( bson() ) );
+
+                int len = -1;
+                ASSERT( fromjson( json.c_str(), &len ).binaryEqual( bson() ) );
+                ASSERT_EQUALS( fastLen, len );
+            }
+        protected:
+            virtual BSONObj bson() const = 0;
+            virtual string json() const = 0;
+        };
+
+        /** Input the fast path leaves to the full parser. */
+        class Declined {
+        public:
+            virtual ~Declined() {}
+            void run() {
+                BSONObj obj;
+                int len = -1;
+                ASSERT( !fromjsonFastPath( json(), &obj, &len ) );
+                ASSERT( obj.isEmpty() );
+                ASSERT_EQUALS( -1, len );
+            }
+        protected:
+            virtual string json() const = 0;
+        };
+
+        class AllTypes : public Base {
+            virtual BSONObj bson() const {
+                return BSON( "s" << "str" << "i" << -3 << "l" << 4294967296LL << "d" << 1.5e-3
+                             << "big" << 1e20 << "t" << true << "f" << false
+                             << "n" << BSONNULL << "o" << BSON( "a" << BSON_ARRAY( 1 << "x" ) )
+                             << "e" << BSONObj() << "ea" << BSONArray() );
+            }
+            virtual string json() const {
+                return "{ \"s\" : \"str\", \"i\" : -3, \"l\" : 4294967296, \"d\" : 1.5e-3, "
+                       "\"big\" : 100000000000000000000, \"t\" : true, \"f\" : false, "
+                       "\"n\" : null, \"o\" : { \"a\" : [ 1, \"x\" ] }, \"e\" : {}, \"ea\" : [] }";
+            }
+        };
+
+        class Escapes : public Base {
+            virtual BSONObj bson() const {
+                return BSON( "k\"\\" << "\"\\/\b\f\n\r\t" );
+            }
+            virtual string json() const {
+                return "{\"k\\\"\\\\\":\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"}";
+            }
+        };
+
+        /** Longer than one 16 byte block, with the special characters at each offset. */
+        class LongStrings : public Base {
+            virtual BSONObj bson() const {
+                BSONObjBuilder b;
+                for ( int i = 0; i < 40; ++i ) {
+                    b.append( BSONObjBuilder::numStr( i ),
+                              string( i, 'x' ) + "\n" + string( 40 - i, 'y' ) );
+                }
+                return b.obj();
+            }
+            virtual string json() const {
+                string json = "{";
+                for ( int i = 0; i < 40; ++i ) {
+                    if ( i ) json += ",";
+                    json += "\"" + BSONObjBuilder::numStr( i ) + "\":\"" + string( i, 'x' ) + "\\n" +
+                        string( 40 - i, 'y' ) + "\"";
+                }
+                return json + "}";
+            }
+        };
+
+        class TopLevelArray : public Base {
+            virtual BSONObj bson() const {
+                return BSON( "0" << 1 << "1" << BSON_ARRAY( 2 ) );
+            }
+            virtual string json() const {
+                return " [ 1, [ 2 ] ] ";
+            }
+        };
+
+        class TrailingInput {
+        public:
+            void run() {
+                BSONObj obj;
+                int len = -1;
+                ASSERT( fromjsonFastPath( "{\"a\":1} {\"b\":2}", &obj, &len ) );
+                ASSERT( obj.binaryEqual( BSON( "a" << 1 ) ) );
+                ASSERT_EQUALS( 7, len );
+            }
+        };
+
+        class ReservedFirstField : public Declined {
+            virtual string json() const { return "{ \"a\" : { \"$date\" : 0 } }"; }
+        };
+
+        class UnquotedField : public Declined {
+            virtual string json() const { return "{ a : 1 }"; }
+        };
+
+        class SingleQuotes : public Declined {
+            virtual string json() const { return "{ 'a' : 1 }"; }
+        };
+
+        class UnicodeEscape : public Declined {
+            virtual string json() const { return "{ \"a\" : \"\\u0041\" }"; }
+        };
+
+        class Constructor : public Declined {
+            virtual string json() const { return "{ \"a\" : ObjectId(\"000000000000000000000000\") }"; }
+        };
+
+        class LeadingZero : public Declined {
+            virtual string json() const { return "{ \"a\" : 01 }"; }
+        };
+
+        class TrailingComma : public Declined {
+            virtual string json() const { return "{ \"a\" : 1, }"; }
+        };
+
+        class ControlCharacter : public Declined {
+            virtual string json() const { return "{ \"a\" : \"\x01\" }"; }
+        };
+
+        class Unterminated : public Declined {
+            virtual string json() const { return "{ \"a\" : [ 1, 2 }"; }
+        };
+
+    } // namespace FastPathTests
+
     class All : public Suite {
     public:
         All() : Suite( "json" ) {
@@ -2933,6 +3073,21 @@ namespace JsonTests {
             add< FromJsonTests::NullFieldUnquoted >();
             add< FromJsonTests::MinKey >();
             add< FromJsonTests::MaxKey >();
+
+            add< FastPathTests::AllTypes >();
+            add< FastPathTests::Escapes >();
+            add< FastPathTests::LongStrings >();
+            add< FastPathTests::TopLevelArray >();
+            add< FastPathTests::TrailingInput >();
+            add< FastPathTests::ReservedFirstField >();
+            add< FastPathTests::UnquotedField >();
+            add< FastPathTests::SingleQuotes >();
+            add< FastPathTests::UnicodeEscape >();
+            add< FastPathTests::Constructor >();
+            add< FastPathTests::LeadingZero >();
+            add< FastPathTests::TrailingComma >();
+            add< FastPathTests::ControlCharacter >();
+            add< FastPathTests::Unterminated >();
         }
     };
 
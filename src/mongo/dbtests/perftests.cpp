@@ -4,6 +4,9 @@
           a long time to run.  Obviously we need those too, but they will be separate.
 
           These tests use DBDirectClient; they are a bit white-boxish.
+
+          Microbenchmarks of single components belong in the "microbench" program instead (see
+          unittest/benchmark.h), which reports warmed-up, repeated measurements.
 */
 
 /**
@@ -46,23 +49,28 @@
 #include <iostream>
 #include <fstream>
 
+#include "mongo/bson/mutable/document.h"
 #include "mongo/db/db.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/json.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/ops/update_driver.h"
 #include "mongo/db/storage/mmap_v1/durable_mapped_file.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
 #include "mongo/db/storage/mmap_v1/btree/key.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/dbtests/framework_options.h"
+#include "mongo/platform/unordered_map.h"
 #include "mongo/util/allocator.h"
 #include "mongo/util/checksum.h"
 #include "mongo/util/compress.h"
+#include "mongo/util/concurrency/adaptive_mutex.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mmap.h"
+#include "mongo/util/string_map.h"
 #include "mongo/util/timer.h"
 #include "mongo/util/version.h"
 #include "mongo/util/version_reporting.h"
@@ -473,6 +481,82 @@ namespace PerfTests {
         }
     };
 
+    /** a Document per update, as successive update operations use them */
+    class MutableBSONDocument : public NonDurTest {
+    public:
+        int n;
+        bo b;
+        string name() { return "mutablebson::Document"; }
+        MutableBSONDocument() {
+            n = 0;
+            b = BSON( "_id" << OID() << "x" << 3 << "yaaaaaa" << 3.00009 << "zz" << 1 << "q" << false << "zzzzzzz" << "a string a string" );
+        }
+        void timed() {
+            mutablebson::Document doc(b, mutablebson::Document::kInPlaceDisabled);
+            verify( doc.root()["x"].setValueInt(n).isOK() );
+            verify( doc.root().appendInt("n", n).isOK() );
+            n += doc.getObject().objsize();
+        }
+    };
+
+    /** one Document reset per update, as UpdateStage does within an operation; compare with MutableBSONDocument */
+    class MutableBSONDocumentReset : public MutableBSONDocument {
+    public:
+        mutablebson::Document doc;
+        string name() { return "mutablebson::Document-reset"; }
+        void timed() {
+            doc.reset(b, mutablebson::Document::kInPlaceDisabled);
+            verify( doc.root()["x"].setValueInt(n).isOK() );
+            verify( doc.root().appendInt("n", n).isOK() );
+            n += doc.getObject().objsize();
+        }
+    };
+
+    /** a whole UpdateDriver per update, as each update operation builds one */
+    class UpdateDriverInc : public MutableBSONDocument {
+    public:
+        bo mod;
+        string name() { return "UpdateDriver-inc"; }
+        UpdateDriverInc() : mod(BSON( "$inc" << BSON( "x" << 1 ) << "$set" << BSON( "n" << 1 ) )) {}
+        void timed() {
+            UpdateDriver::Options opts;
+            UpdateDriver driver(opts);
+            verify( driver.parse(mod).isOK() );
+            mutablebson::Document& doc = driver.getDocument();
+            doc.reset(b, mutablebson::Document::kInPlaceDisabled);
+            verify( driver.update(StringData(), &doc).isOK() );
+            n += doc.getObject().objsize();
+        }
+    };
+
+    /** strict JSON, which fromjson parses on its fast path */
+    class FromJsonStrict : public NonDurTest {
+    public:
+        int n;
+        string json;
+        string name() { return "fromjson-strict"; }
+        FromJsonStrict() {
+            n = 0;
+            json = BSON( "_id" << 12345 << "name" << "a string a string a string"
+                         << "tags" << BSON_ARRAY( "x" << "yy" << "zzz" ) << "score" << 3.25
+                         << "nested" << BSON( "a" << 1 << "b" << false << "c" << BSONNULL ) )
+                .jsonString( Strict );
+        }
+        void timed() {
+            n += fromjson( json ).objsize();
+        }
+    };
+
+    /** the same document in extended JSON, which only the full parser handles */
+    class FromJsonExtended : public FromJsonStrict {
+    public:
+        string name() { return "fromjson-extended"; }
+        FromJsonExtended() {
+            json = "{ _id : 12345, name : 'a string a string a string', tags : [ 'x', 'yy', 'zzz' ],"
+                   " score : 3.25, nested : { a : 1, b : false, c : null } }";
+        }
+    };
+
     class KeyTest : public B {
     public:
         KeyV1Owned a,b,c;
@@ -490,6 +574,46 @@ namespace PerfTests {
         }
     };
 
+    /** lookups of field-name-like keys, half of them present; compare with StdMapLookup */
+    class StringMapLookup : public B {
+    public:
+        StringMapLookup() : found(0) {
+            for( int i = 0; i < 128; i++ ) {
+                keys.push_back( str::stream() << "field_" << i );
+                if( i % 2 == 0 )
+                    m[keys.back()] = i;
+            }
+        }
+        string name() { return "StringMap-lookup"; }
+        virtual int howLongMillis() { return 3000; }
+        virtual bool showDurStats() { return false; }
+        void timed() {
+            for( size_t i = 0; i < keys.size(); i++ ) {
+                if( m.find( keys[i] ) != m.end() )
+                    found++;
+            }
+        }
+        vector<string> keys;
+        StringMap<int> m;
+        unsigned long long found;
+    };
+
+    class StdMapLookup : public StringMapLookup {
+    public:
+        StdMapLookup() {
+            for( StringMap<int>::const_iterator i = m.begin(); i != m.end(); ++i )
+                um[i->first] = i->second;
+        }
+        string name() { return "unordered_map-lookup"; }
+        void timed() {
+            for( size_t i = 0; i < keys.size(); i++ ) {
+                if( um.find( keys[i] ) != um.end() )
+                    found++;
+            }
+        }
+        unordered_map<string, int> um;
+    };
+
     unsigned long long aaa;
 
     class Timer : public B {
@@ -537,6 +661,7 @@ namespace PerfTests {
     std::timed_mutex mstd_timed;
 #endif
     SpinLock s;
+    AdaptiveMutex am;
     boost::condition c;
 
     class NotifyOne : public B {
@@ -613,6 +738,41 @@ namespace PerfTests {
             mongo::scoped_spinlock lk(s);
         }
     };
+    class adaptivemutexspeed : public B {
+    public:
+        string name() { return "adaptivemutex"; }
+        virtual int howLongMillis() { return 500; }
+        virtual bool showDurStats() { return false; }
+        void timed() {
+            AdaptiveMutex::scoped_lock lk(am);
+        }
+    };
+
+    // The same mutexes taken by several threads at once (see B::launchThreads).
+    class simplemutex_contended : public simplemutexspeed {
+    public:
+        string name() { return "simplemutex_contended"; }
+        virtual bool testThreaded() { return true; }
+        void timed2(DBClientBase*) {
+            SimpleMutex::scoped_lock lk(m);
+        }
+    };
+    class spinlock_contended : public spinlockspeed {
+    public:
+        string name() { return "spinlock_contended"; }
+        virtual bool testThreaded() { return true; }
+        void timed2(DBClientBase*) {
+            mongo::scoped_spinlock lk(s);
+        }
+    };
+    class adaptivemutex_contended : public adaptivemutexspeed {
+    public:
+        string name() { return "adaptivemutex_contended"; }
+        virtual bool testThreaded() { return true; }
+        void timed2(DBClientBase*) {
+            AdaptiveMutex::scoped_lock lk(am);
+        }
+    };
     int cas;
     class casspeed : public B {
     public:
@@ -1479,17 +1639,28 @@ namespace PerfTests {
                 add< stdtimed_mutexspeed >();
 #endif
                 add< spinlockspeed >();
+                add< adaptivemutexspeed >();
+                add< simplemutex_contended >();
+                add< spinlock_contended >();
+                add< adaptivemutex_contended >();
 #ifdef RUNCOMPARESWAP
                 add< casspeed >();
 #endif
                 add< CTM >();
                 add< CTMicros >();
                 add< KeyTest >();
+                add< StringMapLookup >();
+                add< StdMapLookup >();
                 add< Bldr >();
                 add< StkBldr >();
                 add< BSONIter >();
                 add< BSONGetFields1 >();
                 add< BSONGetFields2 >();
+                add< MutableBSONDocument >();
+                add< MutableBSONDocumentReset >();
+                add< UpdateDriverInc >();
+                add< FromJsonStrict >();
+                add< FromJsonExtended >();
                 //add< TaskQueueTest >();
                 add< InsertDup >();
                 add< Insert1 >();
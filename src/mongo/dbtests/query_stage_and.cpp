@@ -447,6 +447,179 @@ namespace QueryStageAnd {
         }
     };
 
+    // If only RecordIds are needed, going over the buffer limit while reading the first child
+    // drops the buffered keys rather than failing.
+    class QueryStageAndHashCompactFirstChild : public QueryStageAndBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(&_txn, ns());
+            Database* db = ctx.db();
+            Collection* coll = ctx.getCollection();
+            if (!coll) {
+                WriteUnitOfWork wuow(&_txn);
+                coll = db->createCollection(&_txn, ns());
+                wuow.commit();
+            }
+
+            std::string big(512, 'a');
+            for (int i = 0; i < 50; ++i) {
+                insert(BSON("foo" << i << "bar" << i << "baz" << i << "big" << big));
+            }
+
+            addIndex(BSON("foo" << 1 << "big" << 1));
+            addIndex(BSON("bar" << 1));
+            addIndex(BSON("baz" << 1));
+
+            // The limit is hit before the 21 keys of the first child are read.
+            WorkingSet ws;
+            scoped_ptr<AndHashStage> ah(new AndHashStage(&ws, NULL, coll, 10 * big.size()));
+            ah->setOnlyRecordIdsNeeded();
+
+            // Foo <= 20
+            IndexScanParams params;
+            params.descriptor = getIndex(BSON("foo" << 1 << "big" << 1), coll);
+            params.bounds.isSimpleRange = true;
+            params.bounds.startKey = BSON("" << 20 << "" << big);
+            params.bounds.endKey = BSONObj();
+            params.bounds.endKeyInclusive = true;
+            params.direction = -1;
+            ah->addChild(new IndexScan(&_txn, params, &ws, NULL));
+
+            // Bar >= 10
+            params.descriptor = getIndex(BSON("bar" << 1), coll);
+            params.bounds.startKey = BSON("" << 10);
+            params.bounds.endKey = BSONObj();
+            params.bounds.endKeyInclusive = true;
+            params.direction = 1;
+            ah->addChild(new IndexScan(&_txn, params, &ws, NULL));
+
+            // Baz <= 15
+            params.descriptor = getIndex(BSON("baz" << 1), coll);
+            params.bounds.startKey = BSON("" << 15);
+            params.bounds.endKey = BSONObj();
+            params.bounds.endKeyInclusive = true;
+            params.direction = -1;
+            ah->addChild(new IndexScan(&_txn, params, &ws, NULL));
+
+            // Results come in the order of the last child, with only its keys.
+            int expected = 15;
+            while (!ah->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState status = ah->work(&id);
+                ASSERT_NOT_EQUALS(PlanStage::FAILURE, status);
+                if (PlanStage::ADVANCED != status) { continue; }
+
+                WorkingSetMember* member = ws.get(id);
+                BSONElement elt;
+                ASSERT_TRUE(member->getFieldDotted("baz", &elt));
+                ASSERT_EQUALS(expected, elt.numberInt());
+                ASSERT_FALSE(member->getFieldDotted("foo", &elt));
+                --expected;
+            }
+            ASSERT_EQUALS(9, expected);
+
+            scoped_ptr<PlanStageStats> stats(ah->getStats());
+            const AndHashStats* specific = static_cast<const AndHashStats*>(stats->specific.get());
+            ASSERT_TRUE(specific->compacted);
+            ASSERT_LESS_THAN_OR_EQUALS(ah->getMemUsage(), 21 * sizeof(RecordId));
+        }
+    };
+
+    // Invalidate a RecordId after the hashed AND dropped the keys it buffered.
+    class QueryStageAndHashCompactInvalidation : public QueryStageAndBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(&_txn, ns());
+            Database* db = ctx.db();
+            Collection* coll = ctx.getCollection();
+            if (!coll) {
+                WriteUnitOfWork wuow(&_txn);
+                coll = db->createCollection(&_txn, ns());
+                wuow.commit();
+            }
+
+            std::string big(512, 'a');
+            for (int i = 0; i < 50; ++i) {
+                insert(BSON("foo" << i << "bar" << i << "big" << big));
+            }
+
+            addIndex(BSON("foo" << 1 << "big" << 1));
+            addIndex(BSON("bar" << 1));
+
+            WorkingSet ws;
+            scoped_ptr<AndHashStage> ah(new AndHashStage(&ws, NULL, coll, 10 * big.size()));
+            ah->setOnlyRecordIdsNeeded();
+
+            // Foo <= 40
+            IndexScanParams params;
+            params.descriptor = getIndex(BSON("foo" << 1 << "big" << 1), coll);
+            params.bounds.isSimpleRange = true;
+            params.bounds.startKey = BSON("" << 40 << "" << big);
+            params.bounds.endKey = BSONObj();
+            params.bounds.endKeyInclusive = true;
+            params.direction = -1;
+            ah->addChild(new IndexScan(&_txn, params, &ws, NULL));
+
+            // Bar >= 10
+            params.descriptor = getIndex(BSON("bar" << 1), coll);
+            params.bounds.startKey = BSON("" << 10);
+            params.bounds.endKey = BSONObj();
+            params.bounds.endKeyInclusive = true;
+            params.direction = 1;
+            ah->addChild(new IndexScan(&_txn, params, &ws, NULL));
+
+            // Read foo=40 down to about foo=10, going over the limit on the way.
+            for (int i = 0; i < 30; ++i) {
+                WorkingSetID out;
+                PlanStage::StageState status = ah->work(&out);
+                ASSERT_EQUALS(PlanStage::NEED_TIME, status);
+            }
+
+            ah->saveState();
+            set<RecordId> data;
+            getLocs(&data, coll);
+            for (set<RecordId>::const_iterator it = data.begin(); it != data.end(); ++it) {
+                if (coll->docFor(&_txn, *it)["foo"].numberInt() == 15) {
+                    ah->invalidate(&_txn, *it, INVALIDATION_DELETION);
+                    remove(coll->docFor(&_txn, *it));
+                    break;
+                }
+            }
+            ah->restoreState(&_txn);
+
+            // The document is flagged for review.
+            const unordered_set<WorkingSetID>& flagged = ws.getFlagged();
+            ASSERT_EQUALS(size_t(1), flagged.size());
+            WorkingSetMember* member = ws.get(*flagged.begin());
+            ASSERT_EQUALS(WorkingSetMember::OWNED_OBJ, member->state);
+            BSONElement elt;
+            ASSERT_TRUE(member->getFieldDotted("foo", &elt));
+            ASSERT_EQUALS(15, elt.numberInt());
+
+            // 10 <= foo <= 40, but for 15.
+            int count = 0;
+            while (!ah->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState status = ah->work(&id);
+                ASSERT_NOT_EQUALS(PlanStage::FAILURE, status);
+                if (PlanStage::ADVANCED != status) { continue; }
+
+                ++count;
+                member = ws.get(id);
+                ASSERT_TRUE(member->getFieldDotted("bar", &elt));
+                ASSERT_GREATER_THAN_OR_EQUALS(elt.numberInt(), 10);
+                ASSERT_LESS_THAN_OR_EQUALS(elt.numberInt(), 40);
+                ASSERT_NOT_EQUALS(15, elt.numberInt());
+            }
+            ASSERT_EQUALS(30, count);
+
+            scoped_ptr<PlanStageStats> stats(ah->getStats());
+            const AndHashStats* specific = static_cast<const AndHashStats*>(stats->specific.get());
+            ASSERT_TRUE(specific->compacted);
+            ASSERT_EQUALS(size_t(1), specific->flaggedInProgress);
+        }
+    };
+
     // An AND with three children.
     // Add large keys (512 bytes) to index of last child to verify that
     // keys in last child are not buffered
@@ -1406,6 +1579,8 @@ namespace QueryStageAnd {
             add<QueryStageAndHashInvalidateLookahead>();
             add<QueryStageAndHashFirstChildFetched>();
             add<QueryStageAndHashSecondChildFetched>();
+            add<QueryStageAndHashCompactFirstChild>();
+            add<QueryStageAndHashCompactInvalidation>();
             add<QueryStageAndSortedInvalidation>();
             add<QueryStageAndSortedThreeLeaf>();
             add<QueryStageAndSortedWithNothing>();
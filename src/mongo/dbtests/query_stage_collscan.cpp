@@ -376,6 +376,55 @@ namespace QueryStageCollectionScan {
         }
     };
 
+    //
+    // Working the scan a batch at a time returns the same objects in the same order, with the
+    // same stats, as working it one unit of work at a time.
+    //
+    class QueryStageCollscanBatchForwardWithMatch : public QueryStageCollectionScanBase {
+    public:
+        void run() {
+            AutoGetCollectionForRead ctx(&_txn, ns());
+
+            CollectionScanParams params;
+            params.collection = ctx.getCollection();
+            params.direction = CollectionScanParams::FORWARD;
+            params.tailable = false;
+
+            // Only every other object passes the filter, so batches mix ADVANCED and NEED_TIME.
+            StatusWithMatchExpression swme =
+                MatchExpressionParser::parse(BSON("foo" << BSON("$mod" << BSON_ARRAY(2 << 0))));
+            verify(swme.isOK());
+            auto_ptr<MatchExpression> filterExpr(swme.getValue());
+
+            const size_t batchSizes[] = { 1, 3, 16, 1000 };
+            for (size_t b = 0; b < sizeof(batchSizes) / sizeof(batchSizes[0]); ++b) {
+                WorkingSet ws;
+                scoped_ptr<CollectionScan> scan(
+                    new CollectionScan(&_txn, params, &ws, filterExpr.get()));
+
+                int count = 0;
+                PlanStage::StageState state = PlanStage::NEED_TIME;
+                while (PlanStage::IS_EOF != state) {
+                    std::vector<WorkingSetID> batch;
+                    WorkingSetID id = WorkingSet::INVALID_ID;
+                    state = scan->workBatch(batchSizes[b], &batch, &id);
+                    ASSERT_LESS_THAN_OR_EQUALS(batch.size(), batchSizes[b]);
+                    for (size_t i = 0; i < batch.size(); ++i) {
+                        ASSERT_EQUALS(2 * count, ws.get(batch[i])->obj["foo"].numberInt());
+                        ws.free(batch[i]);
+                        ++count;
+                    }
+                }
+
+                ASSERT_EQUALS(numObj() / 2, count);
+
+                const CommonStats* stats = scan->getCommonStats();
+                ASSERT_EQUALS(static_cast<size_t>(numObj() / 2), stats->advanced);
+                ASSERT_EQUALS(stats->works, stats->advanced + stats->needTime + 1);
+            }
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "QueryStageCollectionScan" ) {}
@@ -390,6 +439,7 @@ namespace QueryStageCollectionScan {
             add<QueryStageCollscanObjectsInOrderBackward>();
             add<QueryStageCollscanInvalidateUpcomingObject>();
             add<QueryStageCollscanInvalidateUpcomingObjectBackward>();
+            add<QueryStageCollscanBatchForwardWithMatch>();
         }
     };
 
@@ -216,6 +216,7 @@ namespace QueryStageCount {
             request.limit = limit;
             request.skip = skip;
             request.explain = false;
+            request.approximate = false;
             request.hint = BSONObj();
             return request;
         }
@@ -77,6 +77,39 @@ namespace {
         return count;
     }
 
+    /**
+     * Like countResults(), but works 'stage' 'maxWorks' units of work at a time. Checks that the
+     * results come out in the order getMS() queued them.
+     */
+    int countBatchResults(PlanStage* stage, WorkingSet* ws, size_t maxWorks) {
+        int count = 0;
+        int lastX = -1;
+        while (!stage->isEOF()) {
+            std::vector<WorkingSetID> batch;
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState status = stage->workBatch(maxWorks, &batch, &id);
+            ASSERT_LESS_THAN_OR_EQUALS(batch.size(), maxWorks);
+            for (size_t i = 0; i < batch.size(); ++i) {
+                int x = ws->get(batch[i])->obj["x"].numberInt();
+                ASSERT_LESS_THAN(lastX, x);
+                lastX = x;
+                ws->free(batch[i]);
+                ++count;
+            }
+            if (PlanStage::ADVANCED == status) {
+                ASSERT_FALSE(batch.empty());
+            }
+            else if (PlanStage::IS_EOF == status) {
+                break;
+            }
+            else {
+                ASSERT_EQUALS(PlanStage::NEED_TIME, status);
+                ASSERT_TRUE(batch.empty());
+            }
+        }
+        return count;
+    }
+
     //
     // Insert 50 objects.  Filter/skip 0, 1, 2, ..., 100 objects and expect the right # of results.
     //
@@ -95,12 +128,45 @@ namespace {
         }
     };
 
+    //
+    // Same as above, but a batch at a time, with batches smaller and larger than the work a
+    // single result takes.
+    //
+    class QueryStageLimitSkipBatchTest {
+    public:
+        void run() {
+            const size_t batchSizes[] = { 1, 2, 3, 7, 1000 };
+            for (size_t b = 0; b < sizeof(batchSizes) / sizeof(batchSizes[0]); ++b) {
+                for (int i = 0; i < 2 * N; ++i) {
+                    WorkingSet ws;
+
+                    scoped_ptr<PlanStage> skip(new SkipStage(i, &ws, getMS(&ws)));
+                    ASSERT_EQUALS(max(0, N - i), countBatchResults(skip.get(), &ws, batchSizes[b]));
+                    ASSERT_EQUALS(static_cast<size_t>(max(0, N - i)),
+                                  skip->getCommonStats()->advanced);
+
+                    scoped_ptr<PlanStage> limit(new LimitStage(i, &ws, getMS(&ws)));
+                    ASSERT_EQUALS(min(N, i), countBatchResults(limit.get(), &ws, batchSizes[b]));
+                    ASSERT_EQUALS(static_cast<size_t>(min(N, i)),
+                                  limit->getCommonStats()->advanced);
+
+                    // A skip under a limit, which the child's batch can cross.
+                    scoped_ptr<PlanStage> both(
+                        new LimitStage(i, &ws, new SkipStage(N / 2, &ws, getMS(&ws))));
+                    ASSERT_EQUALS(min(N - N / 2, i),
+                                  countBatchResults(both.get(), &ws, batchSizes[b]));
+                }
+            }
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "query_stage_limit_skip" ) { }
 
         void setupTests() {
             add<QueryStageLimitSkipBasicTest>();
+            add<QueryStageLimitSkipBatchTest>();
         }
     };
 
@@ -35,6 +35,7 @@
 #include "mongo/db/exec/sort.h"
 #include "mongo/db/json.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/dbtests/dbtests.h"
@@ -120,6 +121,7 @@ namespace QueryStageSortTests {
             params.collection = coll;
             params.pattern = BSON("foo" << direction);
             params.limit = limit();
+            params.allowDiskUse = allowDiskUse();
 
             // Must fetch so we can look at the doc as a BSONObj.
             PlanExecutor* rawExec;
@@ -173,6 +175,9 @@ namespace QueryStageSortTests {
         // Leave as 0 to disable limit.
         virtual int limit() const { return 0; };
 
+        // Returns whether the sort may spill to disk.
+        virtual bool allowDiskUse() const { return false; }
+
 
         static const char* ns() { return "unittests.QueryStageSort"; }
 
@@ -251,6 +256,131 @@ namespace QueryStageSortTests {
         }
     };
 
+    // Sort more than fits in memory, spilling to disk.
+    class QueryStageSortSpill : public QueryStageSortTestBase {
+    public:
+        QueryStageSortSpill() : _oldMaxBytes(internalQueryExecMaxBlockingSortBytes) {
+            internalQueryExecMaxBlockingSortBytes = 10 * 1024;
+        }
+
+        virtual ~QueryStageSortSpill() {
+            internalQueryExecMaxBlockingSortBytes = _oldMaxBytes;
+        }
+
+        virtual int numObj() { return 10000; }
+
+        virtual bool allowDiskUse() const { return true; }
+
+        void run() {
+            Client::WriteContext ctx(&_txn, ns());
+            Database* db = ctx.ctx().db();
+            Collection* coll = db->getCollection(ns());
+            if (!coll) {
+                WriteUnitOfWork wuow(&_txn);
+                coll = db->createCollection(&_txn, ns());
+                wuow.commit();
+            }
+
+            fillData();
+            sortAndCheck(1, coll);
+            sortAndCheck(-1, coll);
+
+            // Without the disk the sort fails.
+            WorkingSet* ws = new WorkingSet();
+            QueuedDataStage* ms = new QueuedDataStage(ws);
+            insertVarietyOfObjects(ms, coll);
+
+            SortStageParams params;
+            params.collection = coll;
+            params.pattern = BSON("foo" << 1);
+
+            PlanExecutor* rawExec;
+            Status status =
+                PlanExecutor::make(&_txn,
+                                   ws,
+                                   new FetchStage(&_txn, ws,
+                                                  new SortStage(params, ws, ms), NULL, coll),
+                                   coll, PlanExecutor::YIELD_MANUAL, &rawExec);
+            ASSERT_OK(status);
+            boost::scoped_ptr<PlanExecutor> exec(rawExec);
+            ASSERT_EQUALS(PlanExecutor::FAILURE, exec->getNext(NULL, NULL));
+        }
+
+    private:
+        const int _oldMaxBytes;
+    };
+
+    // Invalidation of results which were spilled to disk.
+    class QueryStageSortSpillInvalidation : public QueryStageSortSpill {
+    public:
+        virtual int numObj() { return 2000; }
+
+        void run() {
+            Client::WriteContext ctx(&_txn, ns());
+            Database* db = ctx.ctx().db();
+            Collection* coll = db->getCollection(ns());
+            if (!coll) {
+                WriteUnitOfWork wuow(&_txn);
+                coll = db->createCollection(&_txn, ns());
+                wuow.commit();
+            }
+
+            fillData();
+
+            set<RecordId> locs;
+            getLocs(&locs, coll);
+
+            WorkingSet ws;
+            auto_ptr<QueuedDataStage> ms(new QueuedDataStage(&ws));
+            insertVarietyOfObjects(ms.get(), coll);
+
+            SortStageParams params;
+            params.collection = coll;
+            params.pattern = BSON("foo" << 1);
+            params.allowDiskUse = true;
+            auto_ptr<SortStage> ss(new SortStage(params, &ws, ms.get()));
+
+            // Read everything in, which spills.
+            while (!ms->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                ASSERT_NOT_EQUALS(PlanStage::FAILURE, ss->work(&id));
+            }
+            ms.release();
+
+            // Invalidate half of the results.
+            ss->saveState();
+            size_t numInvalidated = 0;
+            for (set<RecordId>::iterator it = locs.begin(); it != locs.end(); ++it) {
+                if (numInvalidated++ % 2) {
+                    ss->invalidate(&_txn, *it, INVALIDATION_DELETION);
+                }
+            }
+            ss->restoreState(&_txn);
+
+            // Every result comes back, those invalidated without their RecordId.
+            int count = 0;
+            int withLoc = 0;
+            while (!ss->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState status = ss->work(&id);
+                ASSERT_NOT_EQUALS(PlanStage::FAILURE, status);
+                if (PlanStage::ADVANCED != status) { continue; }
+                WorkingSetMember* member = ws.get(id);
+                ASSERT(member->hasObj());
+                ASSERT_EQUALS(count, member->obj["foo"].numberInt());
+                if (member->hasLoc()) {
+                    ++withLoc;
+                }
+                ++count;
+            }
+            ASSERT_EQUALS(numObj(), count);
+            ASSERT_EQUALS(numObj() / 2, withLoc);
+
+            boost::scoped_ptr<PlanStageStats> stats(ss->getStats());
+            ASSERT(static_cast<const SortStats*>(stats->specific.get())->usedDisk);
+        }
+    };
+
     // Invalidation of everything fed to sort.
     class QueryStageSortInvalidation : public QueryStageSortTestBase {
     public:
@@ -405,6 +535,8 @@ namespace QueryStageSortTests {
             // and a special case for limit == 1
             add<QueryStageSortDecWithLimit<1> >();
             add<QueryStageSortExt>();
+            add<QueryStageSortSpill>();
+            add<QueryStageSortSpillInvalidation>();
             add<QueryStageSortInvalidation>();
             add<QueryStageSortInvalidationWithLimit<10> >();
             add<QueryStageSortInvalidationWithLimit<1> >();
@@ -1431,6 +1431,47 @@ namespace mongo_test {
         monitor->startOrContinueRefresh().refreshAll();
     }
 
+    TEST_F(ReplicaSetMonitorTest, RefreshAllConcurrently) {
+        MockReplicaSet* replSet = getReplSet();
+
+        set<HostAndPort> seedList;
+        seedList.insert(HostAndPort(replSet->getPrimary()));
+        ReplicaSetMonitor::createIfNeeded(replSet->getSetName(), seedList);
+
+        ReplicaSetMonitorPtr monitor = ReplicaSetMonitor::get(replSet->getSetName());
+        monitor->startOrContinueRefresh().refreshAllConcurrently();
+
+        ASSERT(monitor->isPrimary(HostAndPort(replSet->getPrimary())));
+        const vector<string> secondaries = replSet->getSecondaries();
+        for (vector<string>::const_iterator it = secondaries.begin();
+                it != secondaries.end(); ++it) {
+            ASSERT(monitor->isHostUp(HostAndPort(*it)));
+        }
+    }
+
+    TEST_F(ReplicaSetMonitorTest, GetHostWaitsForBackgroundRefresh) {
+        MockReplicaSet* replSet = getReplSet();
+
+        set<HostAndPort> seedList;
+        seedList.insert(HostAndPort(replSet->getPrimary()));
+        ReplicaSetMonitor::createIfNeeded(replSet->getSetName(), seedList);
+
+        ReplicaSetMonitorPtr monitor = ReplicaSetMonitor::get(replSet->getSetName());
+        monitor->startBackgroundRefresh();
+
+        // Waits for the refresh already running, rather than starting its own
+        const HostAndPort primary = monitor->getHostOrRefresh(
+            ReadPreferenceSetting(mongo::ReadPreference_PrimaryOnly, TagSet()));
+        ASSERT_EQUALS(replSet->getPrimary(), primary.toString());
+
+        // Nothing matches once every host is down
+        replSet->kill(replSet->getPrimary());
+        replSet->kill(replSet->getSecondaries());
+        monitor->failedHost(primary);
+        ASSERT(monitor->getHostOrRefresh(
+            ReadPreferenceSetting(mongo::ReadPreference_PrimaryOnly, TagSet())).empty());
+    }
+
 namespace {
     /**
      * Takes a ReplicaSetConfig and a node to remove and returns a new config with equivalent
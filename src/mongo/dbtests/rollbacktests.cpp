@@ -719,6 +719,58 @@ namespace {
         }
     };
 
+    template<bool rollback>
+    class ReuseRecoveryUnit {
+    public:
+        void run() {
+            NamespaceString nss( "unittests.rollback_reuse_recovery_unit" );
+            BSONObj doc = BSON( "_id" << "foo" );
+            {
+                OperationContextImpl txn;
+                dropDatabase( &txn, nss );
+                createCollection( &txn, nss );
+            }
+
+            RecoveryUnit* firstUnit;
+            {
+                OperationContextImpl txn;
+                firstUnit = txn.recoveryUnit();
+
+                ScopedTransaction transaction( &txn, MODE_IX );
+                Lock::DBLock dbXLock( txn.lockState(), nss.db(), MODE_X );
+
+                WriteUnitOfWork uow( &txn );
+                insertRecord( &txn, nss, doc );
+                if ( !rollback ) {
+                    uow.commit();
+                }
+            }
+
+            // The next operation on this client gets the same recovery unit if the storage
+            // engine could reset it, and must not see anything left over from the last one.
+            RecoveryUnit* cached = cc().releaseCachedRecoveryUnit();
+            bool reused = cached != NULL;
+            if ( reused ) {
+                ASSERT_EQUALS( firstUnit, cached );
+                cc().cacheRecoveryUnit( cached );
+            }
+
+            OperationContextImpl txn;
+            if ( reused ) {
+                ASSERT_EQUALS( firstUnit, txn.recoveryUnit() );
+            }
+
+            ScopedTransaction transaction( &txn, MODE_IS );
+            Lock::DBLock dbISLock( txn.lockState(), nss.db(), MODE_IS );
+            if ( rollback ) {
+                assertEmpty( &txn, nss );
+            }
+            else {
+                assertOnlyRecord( &txn, nss, doc );
+            }
+        }
+    };
+
 
     class All : public Suite {
     public:
@@ -752,6 +804,7 @@ namespace {
             addAll< CreateDropIndex >();
             addAll< SetIndexHead >();
             addAll< CreateCollectionAndIndexes >();
+            addAll< ReuseRecoveryUnit >();
         }
     };
 
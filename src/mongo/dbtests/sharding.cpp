@@ -303,6 +303,78 @@ namespace ShardingTests {
 
     };
 
+    //
+    // Tests that lookups in the routing table find the same chunks as lookups in the chunk map,
+    // including for keys of other types than the chunk bounds.
+    //
+    class ChunkRoutingTableTest {
+    public:
+
+        void addChunk( ChunkMap* chunks, const BSONObj& min, const BSONObj& max ){
+            ChunkPtr chunk( new Chunk( NULL, min, max, Shard(), ChunkVersion( 1, 0, OID() ) ) );
+            (*chunks)[max] = chunk;
+        }
+
+        void run(){
+            vector<BSONObj> bounds;
+            bounds.push_back( BSON( "a" << MINKEY ) );
+            bounds.push_back( BSON( "a" << -10.5 ) );
+            bounds.push_back( BSON( "a" << 0 ) );
+            bounds.push_back( BSON( "a" << 7LL ) );
+            for( int i = 10; i < 1000; i += 10 ){
+                bounds.push_back( BSON( "a" << i ) );
+            }
+            bounds.push_back( BSON( "a" << "abc" ) );
+            bounds.push_back( BSON( "a" << "abd" ) );
+            bounds.push_back( BSON( "a" << BSON( "x" << 1 ) ) );
+            bounds.push_back( BSON( "a" << MAXKEY ) );
+
+            ChunkMap chunks;
+            for( size_t i = 1; i < bounds.size(); i++ ){
+                addChunk( &chunks, bounds[i - 1], bounds[i] );
+            }
+
+            shared_ptr<const ChunkRoutingTable> table = ChunkRoutingTable::make( chunks );
+            ASSERT( table );
+            ASSERT_EQUALS( chunks.size(), table->size() );
+
+            vector<BSONObj> keys( bounds );
+            keys.push_back( BSON( "a" << -11 ) );
+            keys.push_back( BSON( "a" << -10 ) );
+            keys.push_back( BSON( "a" << -0.0 ) );
+            keys.push_back( BSON( "a" << 7.0 ) );
+            keys.push_back( BSON( "a" << 7.5 ) );
+            keys.push_back( BSON( "a" << 15LL ) );
+            keys.push_back( BSON( "a" << 2000 ) );
+            keys.push_back( BSON( "a" << "" ) );
+            keys.push_back( BSON( "a" << "abcd" ) );
+            keys.push_back( BSON( "a" << "zzz" ) );
+            keys.push_back( BSON( "a" << BSONObj() ) );
+            keys.push_back( BSON( "a" << BSON( "x" << 2 ) ) );
+            keys.push_back( BSON( "a" << BSONNULL ) );
+            keys.push_back( BSON( "a" << OID() ) );
+            keys.push_back( BSON( "a" << true ) );
+
+            for( vector<BSONObj>::iterator it = keys.begin(); it != keys.end(); ++it ){
+                ChunkMap::const_iterator expected = chunks.upper_bound( *it );
+                ChunkPtr chunk = table->upperBound( *it );
+                if( expected == chunks.end() ){
+                    ASSERT( !chunk );
+                }
+                else {
+                    ASSERT( chunk == expected->second );
+                }
+            }
+
+            // Bounds too large to encode leave the lookups to the chunk map
+            ChunkMap bigChunks;
+            addChunk( &bigChunks, BSON( "a" << MINKEY ),
+                      BSON( "a" << string( ShardKeyPattern::kMaxShardKeySizeBytes, 'x' ) ) );
+            ASSERT( !ChunkRoutingTable::make( bigChunks ) );
+        }
+
+    };
+
     class ChunkDiffUnitTest {
     public:
 
@@ -674,6 +746,7 @@ namespace ShardingTests {
             add< ChunkManagerCreateBasicTest >();
             add< ChunkManagerCreateFullTest >();
             add< ChunkManagerLoadBasicTest >();
+            add< ChunkRoutingTableTest >();
             add< ChunkDiffUnitTestNormal >();
             add< ChunkDiffUnitTestInverse >();
         }
@@ -0,0 +1,159 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/logger/async_log_writer.h"
+
+#include <set>
+
+#include "mongo/stdx/functional.h"
+#include "mongo/util/concurrency/thread_name.h"
+
+namespace mongo {
+namespace logger {
+
+namespace {
+    // Every live AsyncLogWriter, for flushAsyncLogWriters().  Allocated on first use and never
+    // freed, so that it outlives writers that are never destroyed.
+    boost::mutex* writersMutex = new boost::mutex;
+    std::set<AsyncLogWriter*>* liveWriters = new std::set<AsyncLogWriter*>;
+}  // namespace
+
+    void flushAsyncLogWriters() {
+        boost::mutex::scoped_lock lk(*writersMutex);
+        for (std::set<AsyncLogWriter*>::const_iterator it = liveWriters->begin();
+             it != liveWriters->end(); ++it) {
+            (*it)->flush();
+        }
+    }
+
+    AsyncLogWriter::AsyncLogWriter(RotatableFileWriter* writer,
+                                   size_t capacity,
+                                   OverflowPolicy policy,
+                                   Counter64* droppedLines)
+        : _writer(writer),
+          _policy(policy),
+          _droppedLines(droppedLines),
+          _ring(capacity),
+          _head(0),
+          _size(0),
+          _pushed(0),
+          _written(0),
+          _shutdown(false),
+          _thread(stdx::bind(&AsyncLogWriter::_run, this)) {
+        boost::mutex::scoped_lock lk(*writersMutex);
+        liveWriters->insert(this);
+    }
+
+    AsyncLogWriter::~AsyncLogWriter() {
+        {
+            boost::mutex::scoped_lock lk(*writersMutex);
+            liveWriters->erase(this);
+        }
+        {
+            boost::mutex::scoped_lock lk(_mutex);
+            _shutdown = true;
+            _pendingCondition.notify_one();
+        }
+        _thread.join();
+    }
+
+    void AsyncLogWriter::push(std::string* line) {
+        boost::mutex::scoped_lock lk(_mutex);
+        while (_size == _ring.size()) {
+            if (_policy == kDropOnOverflow) {
+                _droppedLines->increment();
+                return;
+            }
+            _writtenCondition.wait(lk);
+        }
+
+        _ring[(_head + _size) % _ring.size()].swap(*line);
+        _size++;
+        _pushed++;
+        _pendingCondition.notify_one();
+    }
+
+    void AsyncLogWriter::flush() {
+        boost::mutex::scoped_lock lk(_mutex);
+        const long long target = _pushed;
+        while (_written < target) {
+            _writtenCondition.wait(lk);
+        }
+    }
+
+    void AsyncLogWriter::_run() {
+        setThreadName("logWriter");
+
+        std::vector<std::string> batch;
+        while (true) {
+            {
+                boost::mutex::scoped_lock lk(_mutex);
+                while (_size == 0 && !_shutdown) {
+                    _pendingCondition.wait(lk);
+                }
+                if (_size == 0)
+                    return; // shut down with nothing left to write
+
+                // Take every pending line; the ring keeps the (now empty) strings' capacity.
+                batch.resize(_size);
+                for (size_t i = 0; i < _size; i++) {
+                    batch[i].swap(_ring[(_head + i) % _ring.size()]);
+                }
+                _head = (_head + _size) % _ring.size();
+                _size = 0;
+                // Room for more lines now, for threads blocked in push().
+                _writtenCondition.notify_all();
+            }
+
+            {
+                RotatableFileWriter::Use useWriter(_writer);
+                if (useWriter.status().isOK()) {
+                    std::ostream& os = useWriter.stream();
+                    for (size_t i = 0; i < batch.size(); i++) {
+                        os << batch[i];
+                        batch[i].clear();
+                    }
+                    os.flush();
+                }
+                else {
+                    for (size_t i = 0; i < batch.size(); i++) {
+                        batch[i].clear();
+                    }
+                }
+            }
+
+            boost::mutex::scoped_lock lk(_mutex);
+            _written += batch.size();
+            _writtenCondition.notify_all();
+        }
+    }
+
+}  // namespace logger
+}  // namespace mongo
@@ -0,0 +1,115 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/base/counter.h"
+#include "mongo/base/disallow_copying.h"
+#include "mongo/logger/rotatable_file_writer.h"
+
+namespace mongo {
+namespace logger {
+
+    /**
+     * Writes log lines to a RotatableFileWriter from a background thread.
+     *
+     * Threads that log only move their formatted line into a bounded ring of pending lines, so a
+     * slow disk delays the log file rather than the threads doing the logging. When the ring is
+     * full, the line is dropped and counted, or the logging thread waits for room, depending on
+     * the OverflowPolicy.
+     */
+    class AsyncLogWriter {
+        MONGO_DISALLOW_COPYING(AsyncLogWriter);
+    public:
+        enum OverflowPolicy {
+            kDropOnOverflow,
+            kBlockOnOverflow,
+        };
+
+        /**
+         * Starts the writer thread. The caller keeps ownership of "writer" and "droppedLines",
+         * which count the lines dropped on overflow, and must keep them alive at least as long
+         * as the constructed AsyncLogWriter.
+         */
+        AsyncLogWriter(RotatableFileWriter* writer,
+                       size_t capacity,
+                       OverflowPolicy policy,
+                       Counter64* droppedLines);
+
+        /**
+         * Writes the pending lines and stops the writer thread.
+         */
+        ~AsyncLogWriter();
+
+        /**
+         * Queues "line" to be written, taking its contents. Lines are written in the order they
+         * are pushed.
+         */
+        void push(std::string* line);
+
+        /**
+         * Waits until every line pushed before the call has been written and flushed.
+         */
+        void flush();
+
+    private:
+        void _run();
+
+        RotatableFileWriter* const _writer;
+        const OverflowPolicy _policy;
+        Counter64* const _droppedLines;
+
+        // Everything below is guarded by _mutex, except _thread.
+        boost::mutex _mutex;
+        boost::condition_variable _pendingCondition; // signaled when lines are pushed
+        boost::condition_variable _writtenCondition; // signaled when lines are written
+
+        std::vector<std::string> _ring;
+        size_t _head;       // index of the oldest pending line
+        size_t _size;       // number of pending lines
+        long long _pushed;  // lines pushed since construction
+        long long _written; // lines written (or given up on) since construction
+        bool _shutdown;
+
+        boost::thread _thread;
+    };
+
+    /**
+     * Calls flush() on every live AsyncLogWriter.  Call before exiting the process, so that the
+     * lines logged on the way out are not lost.
+     */
+    void flushAsyncLogWriters();
+
+}  // namespace logger
+}  // namespace mongo
@@ -0,0 +1,106 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <fstream>
+
+#include "mongo/logger/async_log_writer.h"
+#include "mongo/logger/rotatable_file_writer.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+    using namespace mongo;
+    using namespace mongo::logger;
+
+    const std::string logFileName("LogTest_AsyncLogWriter.txt");
+
+    class AsyncLogWriterTest : public mongo::unittest::Test {
+    public:
+        AsyncLogWriterTest() {
+            unlink(logFileName.c_str());
+            ASSERT_OK(RotatableFileWriter::Use(&_fileWriter).setFileName(logFileName, false));
+        }
+
+        virtual ~AsyncLogWriterTest() {
+            unlink(logFileName.c_str());
+        }
+
+        std::vector<std::string> readLines() {
+            std::vector<std::string> lines;
+            std::ifstream ifs(logFileName.c_str());
+            std::string input;
+            while (std::getline(ifs, input)) {
+                lines.push_back(input);
+            }
+            return lines;
+        }
+
+    protected:
+        RotatableFileWriter _fileWriter;
+        Counter64 _droppedLines;
+    };
+
+    TEST_F(AsyncLogWriterTest, WritesLinesInOrder) {
+        AsyncLogWriter writer(&_fileWriter, 4, AsyncLogWriter::kBlockOnOverflow, &_droppedLines);
+        for (int i = 0; i < 100; i++) {
+            std::string line = str::stream() << "message " << i << '\n';
+            writer.push(&line);
+        }
+        writer.flush();
+
+        std::vector<std::string> lines = readLines();
+        ASSERT_EQUALS(100U, lines.size());
+        for (int i = 0; i < 100; i++) {
+            ASSERT_EQUALS(std::string(str::stream() << "message " << i), lines[i]);
+        }
+        ASSERT_EQUALS(0, _droppedLines.get());
+    }
+
+    TEST_F(AsyncLogWriterTest, DropsLinesWhenFull) {
+        {
+            AsyncLogWriter writer(&_fileWriter, 2, AsyncLogWriter::kDropOnOverflow,
+                                  &_droppedLines);
+            {
+                // Holding the file stalls the writer thread after it takes at most one batch,
+                // so at most 4 of these 5 lines fit.
+                RotatableFileWriter::Use stallWriter(&_fileWriter);
+                for (int i = 0; i < 5; i++) {
+                    std::string line = str::stream() << "message " << i << '\n';
+                    writer.push(&line);
+                }
+            }
+            writer.flush();
+        }
+
+        ASSERT_GREATER_THAN_OR_EQUALS(_droppedLines.get(), 1);
+        ASSERT_EQUALS(5, static_cast<long long>(readLines().size()) + _droppedLines.get());
+    }
+
+}  // namespace
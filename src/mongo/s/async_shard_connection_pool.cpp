@@ -0,0 +1,280 @@
+// async_shard_connection_pool.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/async_shard_connection_pool.h"
+
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/s/shard.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(useAsyncShardConnectionPool, bool, false);
+
+    // Connections opened to one host before commands start queueing on them.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(asyncShardPoolMaxConnsPerHost, int, 4);
+
+    AsyncShardConnectionPool asyncShardConnectionPool;
+
+    /**
+     * A connection commands are pipelined over.  Shared by the pool and its reader thread,
+     * which exits once the connection fails.
+     */
+    class AsyncShardConnectionPool::Connection
+        : public boost::enable_shared_from_this<AsyncShardConnectionPool::Connection> {
+        MONGO_DISALLOW_COPYING(Connection);
+    public:
+        explicit Connection(DBClientBase* conn) : _conn(conn), _failed(false) { }
+
+        /**
+         * Starts the reader thread.
+         */
+        void start() {
+            boost::thread reader(stdx::bind(&Connection::_readReplies, shared_from_this()));
+        }
+
+        RequestPtr send(Message& toSend) {
+            boost::mutex::scoped_lock lk(_mutex);
+            uassert(28618,
+                    str::stream() << "connection to " << _conn->getServerAddress() << " failed",
+                    !_failed);
+
+            try {
+                _conn->say(toSend);
+            }
+            catch (const DBException& ex) {
+                _fail_inlock(ex.toStatus());
+                throw;
+            }
+
+            // The reader can't look for the reply before we let go of _mutex.
+            RequestPtr request(new Request());
+            _pending[toSend.header().getId()] = request;
+            _pendingCond.notify_one();
+            return request;
+        }
+
+        bool isFailed() const {
+            boost::mutex::scoped_lock lk(_mutex);
+            return _failed;
+        }
+
+        size_t numInFlight() const {
+            boost::mutex::scoped_lock lk(_mutex);
+            return _pending.size();
+        }
+
+        bool supportsWireVersion(int wireVersion) const {
+            return _conn->getMinWireVersion() <= wireVersion &&
+                   _conn->getMaxWireVersion() >= wireVersion;
+        }
+
+    private:
+        typedef std::map<MSGID, RequestPtr> PendingMap;
+
+        void _readReplies() {
+            setThreadName("asyncShardConn");
+
+            while (true) {
+                {
+                    boost::mutex::scoped_lock lk(_mutex);
+                    while (_pending.empty() && !_failed) {
+                        _pendingCond.wait(lk);
+                    }
+                    if (_failed) {
+                        return;
+                    }
+                }
+
+                Message reply;
+                bool ok = false;
+                try {
+                    ok = _conn->recv(reply);
+                }
+                catch (const DBException& ex) {
+                    LOG(1) << "error reading from " << _conn->getServerAddress()
+                           << causedBy(ex);
+                }
+
+                RequestPtr request;
+                {
+                    boost::mutex::scoped_lock lk(_mutex);
+                    if (!ok) {
+                        _fail_inlock(Status(ErrorCodes::HostUnreachable,
+                                            str::stream() << "error receiving from "
+                                                          << _conn->getServerAddress()));
+                        return;
+                    }
+
+                    PendingMap::iterator it = _pending.find(reply.header().getResponseTo());
+                    if (it == _pending.end()) {
+                        warning() << "dropping unexpected reply from "
+                                  << _conn->getServerAddress() << " to message "
+                                  << reply.header().getResponseTo();
+                        continue;
+                    }
+                    request = it->second;
+                    _pending.erase(it);
+                }
+
+                QueryResult::View result = reply.singleData().view2ptr();
+                if (result.getNReturned() != 1) {
+                    request->_finish(Status(ErrorCodes::FailedToParse,
+                                            str::stream() << "expected one command result from "
+                                                          << _conn->getServerAddress()
+                                                          << ", got " << result.getNReturned()),
+                                     BSONObj());
+                    continue;
+                }
+                request->_finish(Status::OK(), BSONObj(result.data()).getOwned());
+            }
+        }
+
+        void _fail_inlock(const Status& status) {
+            _failed = true;
+            for (PendingMap::iterator it = _pending.begin(); it != _pending.end(); ++it) {
+                it->second->_finish(status, BSONObj());
+            }
+            _pending.clear();
+            _pendingCond.notify_one();
+        }
+
+        const boost::scoped_ptr<DBClientBase> _conn;
+
+        mutable boost::mutex _mutex; // protects everything below, and writes to _conn
+        boost::condition_variable _pendingCond; // notified when _pending grows or on failure
+        PendingMap _pending; // requests sent and waiting for their reply, by message id
+        bool _failed;
+    };
+
+    Status AsyncShardConnectionPool::Request::wait(int timeoutMillis, BSONObj* result) {
+        boost::mutex::scoped_lock lk(_mutex);
+        if (timeoutMillis > 0) {
+            const boost::system_time deadline =
+                boost::get_system_time() + boost::posix_time::milliseconds(timeoutMillis);
+            while (!_done) {
+                if (!_doneCond.timed_wait(lk, deadline)) {
+                    if (_done) {
+                        break;
+                    }
+                    return Status(ErrorCodes::ExceededTimeLimit,
+                                  str::stream() << "no reply within " << timeoutMillis << "ms");
+                }
+            }
+        }
+        else {
+            while (!_done) {
+                _doneCond.wait(lk);
+            }
+        }
+
+        *result = _result;
+        return _status;
+    }
+
+    bool AsyncShardConnectionPool::Request::isDone() {
+        boost::mutex::scoped_lock lk(_mutex);
+        return _done;
+    }
+
+    void AsyncShardConnectionPool::Request::_finish(const Status& status,
+                                                    const BSONObj& result) {
+        boost::mutex::scoped_lock lk(_mutex);
+        _done = true;
+        _status = status;
+        _result = result;
+        _doneCond.notify_all();
+    }
+
+    AsyncShardConnectionPool::RequestPtr AsyncShardConnectionPool::sendCommand(
+            const ConnectionString& endpoint,
+            int minWireVersion,
+            Message& toSend) {
+        ConnectionPtr conn = _getConnection(endpoint);
+        uassert(28619,
+                str::stream() << "cannot send command to server " << endpoint.toString()
+                              << ", it does not support wire version " << minWireVersion,
+                conn->supportsWireVersion(minWireVersion));
+        return conn->send(toSend);
+    }
+
+    AsyncShardConnectionPool::ConnectionPtr AsyncShardConnectionPool::_getConnection(
+            const ConnectionString& endpoint) {
+        const std::string host = endpoint.toString();
+        {
+            boost::mutex::scoped_lock lk(_mutex);
+            ConnectionList& conns = _connections[host];
+
+            ConnectionPtr best;
+            size_t bestInFlight = 0;
+            for (ConnectionList::iterator it = conns.begin(); it != conns.end();) {
+                if ((*it)->isFailed()) {
+                    it = conns.erase(it);
+                    continue;
+                }
+
+                const size_t inFlight = (*it)->numInFlight();
+                if (!best || inFlight < bestInFlight) {
+                    best = *it;
+                    bestInFlight = inFlight;
+                }
+                ++it;
+            }
+
+            if (best &&
+                (bestInFlight == 0 ||
+                 conns.size() >= static_cast<size_t>(asyncShardPoolMaxConnsPerHost))) {
+                return best;
+            }
+        }
+
+        // Connect without holding _mutex.  Threads racing here may open a connection or two
+        // past the limit, which is harmless.
+        ConnectionPtr conn(new Connection(shardConnectionPool.get(endpoint, 0)));
+        conn->start();
+
+        boost::mutex::scoped_lock lk(_mutex);
+        _connections[host].push_back(conn);
+        return conn;
+    }
+
+}
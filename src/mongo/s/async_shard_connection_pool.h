@@ -0,0 +1,135 @@
+// async_shard_connection_pool.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    /**
+     * Whether mongos sends write commands to the shards through the
+     * AsyncShardConnectionPool rather than over a pooled connection of their own.
+     */
+    extern bool useAsyncShardConnectionPool;
+
+    /**
+     * A pool of connections to the shards that many threads send commands over at once.
+     * Commands are written to a connection as soon as they are issued, without waiting for the
+     * replies to earlier ones, and a reader thread per connection hands each reply to the
+     * request whose message id it carries in responseTo.
+     *
+     * A shard still runs the commands arriving on one connection one at a time, so the pool
+     * opens a new connection to a host whenever all of its connections are busy, up to
+     * asyncShardPoolMaxConnsPerHost; past that, commands queue on the least loaded one.  Only
+     * use it for commands that carry everything they need with them (e.g. write commands with
+     * their shard version), since consecutive commands from one caller may go over different
+     * connections.
+     *
+     * Connections come from shardConnectionPool, so they are authenticated the same way, but
+     * never go back to it.
+     */
+    class AsyncShardConnectionPool {
+        MONGO_DISALLOW_COPYING(AsyncShardConnectionPool);
+    public:
+        class Request;
+        typedef boost::shared_ptr<Request> RequestPtr;
+
+        AsyncShardConnectionPool() { }
+
+        /**
+         * Sends the command query 'toSend' to 'endpoint' and returns without waiting for the
+         * reply, which Request::wait() collects.  The server must speak at least
+         * 'minWireVersion'.
+         *
+         * THROWS if no connection to 'endpoint' could be made, the server is too old, or the
+         * command could not be sent.
+         */
+        RequestPtr sendCommand(const ConnectionString& endpoint,
+                               int minWireVersion,
+                               Message& toSend);
+
+    private:
+        class Connection;
+        typedef boost::shared_ptr<Connection> ConnectionPtr;
+        typedef std::vector<ConnectionPtr> ConnectionList;
+
+        ConnectionPtr _getConnection(const ConnectionString& endpoint);
+
+        boost::mutex _mutex; // protects _connections
+        std::map<std::string, ConnectionList> _connections; // by host
+    };
+
+    /**
+     * One command in flight through an AsyncShardConnectionPool.
+     */
+    class AsyncShardConnectionPool::Request {
+        MONGO_DISALLOW_COPYING(Request);
+    public:
+        Request() : _done(false), _status(Status::OK()) { }
+
+        /**
+         * Waits for the reply and stores the command's result in 'result'.  Gives up after
+         * 'timeoutMillis' milliseconds unless it is 0.  Returns an error if the connection
+         * failed or the reply did not come in time.
+         */
+        Status wait(int timeoutMillis, BSONObj* result);
+
+        /**
+         * Returns true once the reply or an error is in, so that wait() would not block.
+         */
+        bool isDone();
+
+    private:
+        friend class AsyncShardConnectionPool::Connection;
+
+        void _finish(const Status& status, const BSONObj& result);
+
+        boost::mutex _mutex; // protects everything below
+        boost::condition_variable _doneCond;
+        bool _done;
+        Status _status;
+        BSONObj _result; // owned
+    };
+
+    extern AsyncShardConnectionPool asyncShardConnectionPool;
+
+}
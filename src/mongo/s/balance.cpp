@@ -33,11 +33,15 @@
 #include "mongo/s/balance.h"
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "mongo/base/owned_pointer_map.h"
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/write_concern.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/write_concern_options.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/cluster_write.h"
@@ -53,6 +57,8 @@
 #include "mongo/s/type_mongos.h"
 #include "mongo/s/type_settings.h"
 #include "mongo/s/type_tags.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
@@ -72,83 +78,232 @@ namespace mongo {
     Balancer::~Balancer() {
     }
 
+    // Number of migrations the balancer runs at once, each between shards that take no part in
+    // the others. 1 issues the migrations of a round one after the other.
+    MONGO_EXPORT_SERVER_PARAMETER(balancerMaxConcurrentMigrations, int, 1);
+
+    // Time limit of each migration issued by the balancer, in milliseconds. 0 means none.
+    MONGO_EXPORT_SERVER_PARAMETER(balancerMigrationMaxTimeMS, int, 0);
+
+    namespace {
+
+        /**
+         * Runs the migrations of a balancing round in background threads, starting each as soon
+         * as neither its donor nor its recipient shard takes part in a running migration.
+         */
+        class MigrationScheduler : boost::noncopyable {
+        public:
+            typedef boost::shared_ptr<MigrateInfo> MigrateInfoPtr;
+            typedef stdx::function<int (const MigrateInfo&, int)> MoveFunction;
+
+            MigrationScheduler(const MoveFunction& move, int maxConcurrent)
+                : _move(move), _maxConcurrent(maxConcurrent), _running(0), _movedCount(0) {}
+
+            /**
+             * Runs all of 'migrations' and returns the sum of what the move function returned.
+             */
+            int run(const vector<MigrateInfoPtr>& migrations) {
+                vector<bool> started(migrations.size(), false);
+                size_t numStarted = 0;
+
+                boost::unique_lock<boost::mutex> lk(_mutex);
+                while (numStarted < migrations.size()) {
+                    bool startedAny = false;
+                    for (size_t i = 0; i < migrations.size(); i++) {
+                        if (_running >= _maxConcurrent) {
+                            break;
+                        }
+
+                        const MigrateInfo& info = *migrations[i];
+                        if (started[i] || _busyShards.count(info.from) ||
+                                _busyShards.count(info.to)) {
+                            continue;
+                        }
+
+                        _busyShards.insert(info.from);
+                        _busyShards.insert(info.to);
+                        _running++;
+
+                        try {
+                            boost::thread t(stdx::bind(&MigrationScheduler::_runInThread,
+                                                       this,
+                                                       &info,
+                                                       _running));
+                        }
+                        catch (const boost::thread_resource_error&) {
+                            // Run out of threads, so run it here and retry the others later
+                            lk.unlock();
+                            _runOne(&info, _running);
+                            lk.lock();
+                        }
+
+                        started[i] = true;
+                        numStarted++;
+                        startedAny = true;
+                    }
+
+                    if (!startedAny) {
+                        _migrationDone.wait(lk);
+                    }
+                }
+
+                while (_running > 0) {
+                    _migrationDone.wait(lk);
+                }
+
+                return _movedCount;
+            }
+
+        private:
+            void _runInThread(const MigrateInfo* info, int concurrentMigrations) {
+                setThreadName("BalancerMigration");
+                _runOne(info, concurrentMigrations);
+            }
+
+            void _runOne(const MigrateInfo* info, int concurrentMigrations) {
+                int moved = 0;
+                try {
+                    moved = _move(*info, concurrentMigrations);
+                }
+                catch (const std::exception& ex) {
+                    warning() << "could not move chunk " << info->chunk.toString()
+                              << ", continuing balancing round" << causedBy(ex) << endl;
+                }
+
+                boost::lock_guard<boost::mutex> lk(_mutex);
+                _busyShards.erase(info->from);
+                _busyShards.erase(info->to);
+                _running--;
+                _movedCount += moved;
+                _migrationDone.notify_all();
+            }
+
+            const MoveFunction _move;
+            const int _maxConcurrent;
+
+            // Protects the members below
+            boost::mutex _mutex;
+            boost::condition_variable _migrationDone;
+
+            // Shards taking part in a running migration
+            set<string> _busyShards;
+            int _running;
+            int _movedCount;
+        };
+
+    } // namespace
+
     int Balancer::_moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
                               const WriteConcernOptions* writeConcern,
                               bool waitForDelete)
     {
+        // The policy proposes one chunk per collection, and a collection's metadata can only be
+        // locked by one migration at a time, so the migrations that run at once move chunks of
+        // different collections.
+        const int maxConcurrent = balancerMaxConcurrentMigrations;
+        if ( maxConcurrent > 1 && candidateChunks->size() > 1 ) {
+            MigrationScheduler scheduler( stdx::bind( &Balancer::_moveChunk,
+                                                      stdx::placeholders::_1,
+                                                      writeConcern,
+                                                      waitForDelete,
+                                                      stdx::placeholders::_2 ),
+                                          maxConcurrent );
+            return scheduler.run( *candidateChunks );
+        }
+
         int movedCount = 0;
 
         for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin(); it != candidateChunks->end(); ++it ) {
-            const CandidateChunk& chunkInfo = *it->get();
+            movedCount += _moveChunk( *it->get(), writeConcern, waitForDelete, 1 );
+        }
 
-            // Changes to metadata, borked metadata, and connectivity problems should cause us to
-            // abort this chunk move, but shouldn't cause us to abort the entire round of chunks.
-            // TODO: Handle all these things more cleanly, since they're expected problems
-            try {
+        return movedCount;
+    }
 
-                DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
-                verify( cfg );
+    int Balancer::_moveChunk(const CandidateChunk& chunkInfo,
+                             const WriteConcernOptions* writeConcern,
+                             bool waitForDelete,
+                             int concurrentMigrations)
+    {
+        // Changes to metadata, borked metadata, and connectivity problems should cause us to
+        // abort this chunk move, but shouldn't cause us to abort the entire round of chunks.
+        // TODO: Handle all these things more cleanly, since they're expected problems
+        try {
 
-                // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
-                // tried to do so once.
-                ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
-                verify( cm );
+            DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
+            verify( cfg );
 
-                ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
-                if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                    // likely a split happened somewhere
-                    cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
-                    verify( cm );
+            // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
+            // tried to do so once.
+            ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
+            verify( cm );
 
-                    c = cm->findIntersectingChunk( chunkInfo.chunk.min );
-                    if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                        log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
-                        continue;
-                    }
-                }
+            ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+            if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
+                // likely a split happened somewhere
+                cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
+                verify( cm );
 
-                BSONObj res;
-                if (c->moveAndCommit(Shard::make(chunkInfo.to),
-                                     Chunk::MaxChunkSize,
-                                     writeConcern,
-                                     waitForDelete,
-                                     0, /* maxTimeMS */
-                                     res)) {
-                    movedCount++;
-                    continue;
+                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+                if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
+                    log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
+                    return 0;
                 }
+            }
 
-                // the move requires acquiring the collection metadata's lock, which can fail
-                log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
-                      << " chunk: " << chunkInfo.chunk << endl;
+            BSONObj res;
+            Timer moveTimer;
+            const bool moved = c->moveAndCommit(Shard::make(chunkInfo.to),
+                                                Chunk::MaxChunkSize,
+                                                writeConcern,
+                                                waitForDelete,
+                                                balancerMigrationMaxTimeMS,
+                                                res);
+
+            configServer.logChange( "balancer.moveChunk",
+                                    chunkInfo.ns,
+                                    BSON( "min" << chunkInfo.chunk.min <<
+                                          "max" << chunkInfo.chunk.max <<
+                                          "from" << chunkInfo.from <<
+                                          "to" << chunkInfo.to <<
+                                          "executionTimeMillis" << moveTimer.millis() <<
+                                          "concurrentMigrations" << concurrentMigrations <<
+                                          "ok" << moved ) );
+
+            if ( moved ) {
+                return 1;
+            }
 
-                if ( res["chunkTooBig"].trueValue() ) {
-                    // reload just to be safe
-                    cm = cfg->getChunkManager( chunkInfo.ns );
-                    verify( cm );
-                    c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+            // the move requires acquiring the collection metadata's lock, which can fail
+            log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
+                  << " chunk: " << chunkInfo.chunk << endl;
 
-                    log() << "performing a split because migrate failed for size reasons";
+            if ( res["chunkTooBig"].trueValue() ) {
+                // reload just to be safe
+                cm = cfg->getChunkManager( chunkInfo.ns );
+                verify( cm );
+                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
 
-                    Status status = c->split(Chunk::normal, NULL, NULL);
-                    log() << "split results: " << status << endl;
+                log() << "performing a split because migrate failed for size reasons";
 
-                    if ( !status.isOK() ) {
-                        log() << "marking chunk as jumbo: " << c->toString() << endl;
-                        c->markAsJumbo();
-                        // we increment moveCount so we do another round right away
-                        movedCount++;
-                    }
+                Status status = c->split(Chunk::normal, NULL, NULL);
+                log() << "split results: " << status << endl;
 
+                if ( !status.isOK() ) {
+                    log() << "marking chunk as jumbo: " << c->toString() << endl;
+                    c->markAsJumbo();
+                    // we increment moveCount so we do another round right away
+                    return 1;
                 }
+
             }
-            catch( const DBException& ex ) {
-                warning() << "could not move chunk " << chunkInfo.chunk.toString()
-                          << ", continuing balancing round" << causedBy( ex ) << endl;
-            }
+        }
+        catch( const DBException& ex ) {
+            warning() << "could not move chunk " << chunkInfo.chunk.toString()
+                      << ", continuing balancing round" << causedBy( ex ) << endl;
         }
 
-        return movedCount;
+        return 0;
     }
 
     void Balancer::_ping( bool waiting ) {
@@ -101,7 +101,8 @@ namespace mongo {
         void _doBalanceRound( DBClientBase& conn, std::vector<CandidateChunkPtr>* candidateChunks );
 
         /**
-         * Issues chunk migration request, one at a time.
+         * Issues chunk migration requests, up to balancerMaxConcurrentMigrations at a time as
+         * long as no shard is the donor or the recipient of more than one of them.
          *
          * @param candidateChunks possible chunks to move
          * @param writeConcern detailed write concern. NULL means the default write concern.
@@ -112,6 +113,18 @@ namespace mongo {
                         const WriteConcernOptions* writeConcern,
                         bool waitForDelete);
 
+        /**
+         * Issues a single chunk migration request, splitting the chunk if it is too big to move,
+         * and records its outcome in the config server's changelog.
+         *
+         * @param concurrentMigrations number of migrations running, this one included
+         * @return 1 if the chunk was moved or marked as jumbo, 0 otherwise
+         */
+        static int _moveChunk(const CandidateChunk& chunkInfo,
+                              const WriteConcernOptions* writeConcern,
+                              bool waitForDelete,
+                              int concurrentMigrations);
+
         /**
          * Marks this balancer as being live on the config server(s).
          */
@@ -45,6 +45,7 @@
 #include "mongo/db/lasterror.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/platform/random.h"
 #include "mongo/s/balancer_policy.h"
 #include "mongo/s/chunk_diff.h"
@@ -59,6 +60,7 @@
 #include "mongo/s/strategy.h"
 #include "mongo/s/type_collection.h"
 #include "mongo/s/type_settings.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/log.h"
 #include "mongo/util/print.h"
@@ -93,6 +95,14 @@ namespace mongo {
     // Can be overridden from command line
     bool Chunk::ShouldAutoSplit = true;
 
+    // Config writes creating the chunks of a newly sharded collection which may be in flight at
+    // once. Each one waits on every config server, so writing many chunks one at a time is slow.
+    MONGO_EXPORT_SERVER_PARAMETER(initialChunkWriteThreads, int, 16);
+
+    // Number of random documents the shards may estimate the split points of a chunk from,
+    // instead of walking the whole chunk, when splitting it because it grew. 0 always walks.
+    MONGO_EXPORT_SERVER_PARAMETER(autoSplitSampleSize, int, 1000);
+
     /**
      * Attempts to move the given chunk to another shard.
      *
@@ -313,7 +323,8 @@ namespace mongo {
     void Chunk::pickSplitVector(vector<BSONObj>& splitPoints,
                                 long long chunkSize /* bytes */,
                                 int maxPoints,
-                                int maxObjs) const {
+                                int maxObjs,
+                                int sampleSize) const {
         // Ask the mongod holding this chunk to figure out the split points.
         ScopedDbConnection conn(getShard().getConnString());
         BSONObj result;
@@ -325,6 +336,9 @@ namespace mongo {
         cmd.append( "maxChunkSizeBytes" , chunkSize );
         cmd.append( "maxSplitPoints" , maxPoints );
         cmd.append( "maxChunkObjects" , maxObjs );
+        if ( sampleSize > 0 ) {
+            cmd.append( "sampleSize" , sampleSize );
+        }
         BSONObj cmdObj = cmd.obj();
 
         if ( ! conn->runCommand( "admin" , cmdObj , result )) {
@@ -364,7 +378,7 @@ namespace mongo {
                 chunkSize = std::min(_dataWritten, Chunk::MaxChunkSize);
             }
 
-            pickSplitVector(*splitPoints, chunkSize, 0, MaxObjectPerChunk);
+            pickSplitVector(*splitPoints, chunkSize, 0, MaxObjectPerChunk, autoSplitSampleSize);
 
             if ( splitPoints->size() <= 1 ) {
                 // no split points means there isn't enough data to split on
@@ -855,6 +869,8 @@ namespace mongo {
                     const_cast<set<Shard>&>(_shards).swap(shards);
                     const_cast<ShardVersionMap&>(_shardVersions).swap(shardVersions);
                     const_cast<ChunkRangeManager&>(_chunkRanges).reloadAll(_chunkMap);
+                    const_cast<boost::shared_ptr<const ChunkRoutingTable>&>(_routingTable) =
+                        ChunkRoutingTable::make(_chunkMap);
 
                     return;
                 }
@@ -1097,6 +1113,24 @@ namespace mongo {
         }
     }
 
+    /**
+     * Writes the config document of a chunk of a newly sharded collection into 'status'.
+     */
+    static void writeFirstChunk( const BSONObj& chunkObj, const string& name, Status* status ) {
+        try {
+            *status = clusterUpdate( ChunkType::ConfigNS,
+                                     BSON(ChunkType::name(name)),
+                                     chunkObj,
+                                     true, // upsert
+                                     false, // multi
+                                     WriteConcernOptions::AllConfigs,
+                                     NULL );
+        }
+        catch ( const DBException& e ) {
+            *status = e.toStatus();
+        }
+    }
+
     void ChunkManager::createFirstChunks( const string& config,
                                           const Shard& primary,
                                           const vector<BSONObj>* initPoints,
@@ -1130,6 +1164,9 @@ namespace mongo {
                                        << existingChunks << " chunks", existingChunks == 0 );
         conn.done();
 
+        // Every chunk gets its version up front, so the documents can be written in any order.
+        vector<BSONObj> chunkObjs;
+        vector<string> chunkNames;
         for ( unsigned i=0; i<=splitPoints.size(); i++ ) {
             BSONObj min = i == 0 ? _keyPattern.getKeyPattern().globalMin() : splitPoints[i-1];
             BSONObj max = i < splitPoints.size() ?
@@ -1139,21 +1176,32 @@ namespace mongo {
 
             BSONObjBuilder chunkBuilder;
             temp.serialize( chunkBuilder );
-            BSONObj chunkObj = chunkBuilder.obj();
-
-            Status result = clusterUpdate( ChunkType::ConfigNS,
-                                           BSON(ChunkType::name(temp.genID())),
-                                           chunkObj,
-                                           true, // upsert
-                                           false, // multi
-                                           WriteConcernOptions::AllConfigs,
-                                           NULL );
+            chunkObjs.push_back( chunkBuilder.obj() );
+            chunkNames.push_back( temp.genID() );
 
             version.incMinor();
+        }
 
-            if ( !result.isOK() ) {
+        vector<Status> results( chunkObjs.size(), Status::OK() );
+        const int numThreads = std::min( static_cast<int>( chunkObjs.size() ),
+                                         static_cast<int>( initialChunkWriteThreads ) );
+        if ( numThreads <= 1 ) {
+            for ( size_t i = 0; i < chunkObjs.size(); i++ ) {
+                writeFirstChunk( chunkObjs[i], chunkNames[i], &results[i] );
+            }
+        }
+        else {
+            ThreadPool writers( numThreads, "createFirstChunks" );
+            for ( size_t i = 0; i < chunkObjs.size(); i++ ) {
+                writers.schedule( writeFirstChunk, chunkObjs[i], chunkNames[i], &results[i] );
+            }
+            writers.join();
+        }
+
+        for ( size_t i = 0; i < results.size(); i++ ) {
+            if ( !results[i].isOK() ) {
                 string ss = str::stream() << "creating first chunks failed. result: "
-                                          << result.reason();
+                                          << results[i].reason();
                 error() << ss << endl;
                 msgasserted( 15903 , ss );
             }
@@ -1164,12 +1212,13 @@ namespace mongo {
 
     ChunkPtr ChunkManager::findIntersectingChunk( const BSONObj& shardKey ) const {
         {
-            BSONObj chunkMin;
             ChunkPtr chunk;
-            {
+            if ( _routingTable && ChunkRoutingTable::canEncode( shardKey ) ) {
+                chunk = _routingTable->upperBound( shardKey );
+            }
+            else {
                 ChunkMap::const_iterator it = _chunkMap.upper_bound( shardKey );
                 if (it != _chunkMap.end()) {
-                    chunkMin = it->first;
                     chunk = it->second;
                 }
             }
@@ -1179,7 +1228,6 @@ namespace mongo {
                     return chunk;
                 }
 
-                PRINT(chunkMin);
                 PRINT(*chunk);
                 PRINT( shardKey );
 
@@ -1207,11 +1255,6 @@ namespace mongo {
         
         uassert(status.code(), status.reason(), status.isOK());
 
-        // Query validation
-        if (QueryPlannerCommon::hasNode(canonicalQuery->root(), MatchExpression::GEO_NEAR)) {
-            uassert(13501, "use geoNear command rather than $near query", false);
-        }
-
         // Transforms query into bounds for each field in the shard key
         // for example :
         //   Key { a: 1, b: 1 },
@@ -1269,11 +1312,13 @@ namespace mongo {
     }
 
     IndexBounds ChunkManager::getIndexBoundsForQuery(const BSONObj& key, const CanonicalQuery* canonicalQuery) {
-        // $text is not allowed in planning since we don't have text index on mongos.
+        // $text and $near are not allowed in planning since we don't have text or geo indexes on
+        // mongos.
         //
-        // TODO: Treat $text query as a no-op in planning. So with shard key {a: 1},
+        // TODO: Treat $text and $near queries as a no-op in planning. So with shard key {a: 1},
         //       the query { a: 2, $text: { ... } } will only target to {a: 2}.
-        if (QueryPlannerCommon::hasNode(canonicalQuery->root(), MatchExpression::TEXT)) {
+        if (QueryPlannerCommon::hasNode(canonicalQuery->root(), MatchExpression::TEXT) ||
+            QueryPlannerCommon::hasNode(canonicalQuery->root(), MatchExpression::GEO_NEAR)) {
             IndexBounds bounds;
             IndexBoundsBuilder::allValuesBounds(key, &bounds); // [minKey, maxKey]
             return bounds;
@@ -1573,6 +1618,63 @@ namespace mongo {
         }
     }
 
+    namespace {
+        // Chunk bounds compare as BSONObjCmp does, with all fields ascending
+        const Ordering kRoutingOrdering = Ordering::make(BSONObj());
+    }
+
+    shared_ptr<const ChunkRoutingTable> ChunkRoutingTable::make(const ChunkMap& chunks) {
+        for (ChunkMap::const_iterator it = chunks.begin(); it != chunks.end(); ++it) {
+            if (!canEncode(it->first)) {
+                return shared_ptr<const ChunkRoutingTable>();
+            }
+        }
+
+        return shared_ptr<const ChunkRoutingTable>(new ChunkRoutingTable(chunks));
+    }
+
+    ChunkRoutingTable::ChunkRoutingTable(const ChunkMap& chunks) {
+        _entries.reserve(chunks.size());
+
+        KeyString ks;
+        for (ChunkMap::const_iterator it = chunks.begin(); it != chunks.end(); ++it) {
+            ks.resetToKey(it->first, kRoutingOrdering);
+            _keys.append(ks.getBuffer(), ks.getSize());
+            _entries.push_back(Entry(_keys.size(), it->second));
+        }
+    }
+
+    bool ChunkRoutingTable::canEncode(const BSONObj& shardKey) {
+        // An encoded key is at most about twice as large as the BSON, so anything that is a
+        // valid shard key fits in a KeyString.
+        return shardKey.objsize() <= ShardKeyPattern::kMaxShardKeySizeBytes;
+    }
+
+    StringData ChunkRoutingTable::_key(size_t i) const {
+        const size_t begin = i == 0 ? 0 : _entries[i - 1].end;
+        return StringData(_keys.data() + begin, _entries[i].end - begin);
+    }
+
+    ChunkPtr ChunkRoutingTable::upperBound(const BSONObj& shardKey) const {
+        const KeyString ks = KeyString::make(shardKey, kRoutingOrdering);
+        const StringData key(ks.getBuffer(), ks.getSize());
+
+        // Find the first max bound greater than the key
+        size_t low = 0;
+        size_t high = _entries.size();
+        while (low < high) {
+            const size_t mid = low + (high - low) / 2;
+            if (key.compare(_key(mid)) < 0) {
+                high = mid;
+            }
+            else {
+                low = mid + 1;
+            }
+        }
+
+        return low < _entries.size() ? _entries[low].chunk : ChunkPtr();
+    }
+
     int ChunkManager::getCurrentDesiredChunkSize() const {
         // split faster in early chunks helps spread out an initial load better
         const int minChunkSize = 1 << 20;  // 1 MBytes
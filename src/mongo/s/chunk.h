@@ -177,11 +177,14 @@ namespace mongo {
          * @param chunkSize chunk size to target in bytes
          * @param maxPoints limits the number of split points that are needed, zero is max (optional)
          * @param maxObjs limits the number of objects in each chunk, zero is as max (optional)
+         * @param sampleSize if not zero, lets the shard estimate the split points from this many
+         *        random documents rather than walk the chunk (optional)
          */
         void pickSplitVector(std::vector<BSONObj>& splitPoints,
                              long long chunkSize,
                              int maxPoints = 0,
-                             int maxObjs = 0) const;
+                             int maxObjs = 0,
+                             int sampleSize = 0) const;
 
         //
         // migration support
@@ -373,6 +376,53 @@ namespace mongo {
         ChunkRangeMap _ranges;
     };
 
+    /**
+     * An immutable routing table from shard keys to the chunks which contain them, built from a
+     * ChunkMap. The max bounds of the chunks are KeyString encoded into one contiguous buffer, so
+     * a lookup is a binary search of memcmp's instead of walking the nodes of the map and doing a
+     * BSON comparison at each, which matters for collections with very many chunks. Since it is
+     * immutable, it is shared rather than copied.
+     */
+    class ChunkRoutingTable : boost::noncopyable {
+    public:
+        /**
+         * Builds the table for 'chunks'. Returns an empty pointer if one of the bounds is too
+         * large to be encoded, in which case lookups have to go through the ChunkMap.
+         */
+        static boost::shared_ptr<const ChunkRoutingTable> make(const ChunkMap& chunks);
+
+        /**
+         * Returns the first chunk whose max bound is greater than 'shardKey', like
+         * ChunkMap::upper_bound, or an empty pointer if there is none.
+         */
+        ChunkPtr upperBound(const BSONObj& shardKey) const;
+
+        size_t size() const { return _entries.size(); }
+
+        /**
+         * Returns whether 'shardKey' is small enough to be encoded for a lookup. Larger keys can
+         * never be routed to a chunk through the table and must go through the ChunkMap.
+         */
+        static bool canEncode(const BSONObj& shardKey);
+
+    private:
+        explicit ChunkRoutingTable(const ChunkMap& chunks);
+
+        struct Entry {
+            Entry(size_t end, const ChunkPtr& chunk) : end(end), chunk(chunk) {}
+
+            // Offset in _keys just past the encoded max bound of 'chunk'
+            size_t end;
+            ChunkPtr chunk;
+        };
+
+        StringData _key(size_t i) const;
+
+        // Encoded max bounds of all the chunks, in order
+        std::string _keys;
+        std::vector<Entry> _entries;
+    };
+
     /* config.sharding
          { ns: 'alleyinsider.fs.chunks' ,
            key: { ts : 1 } ,
@@ -400,6 +450,11 @@ namespace mongo {
          */
         unsigned long long getSequenceNumber() const { return _sequenceNumber; }
 
+        /**
+         * The sequence number of the newest ChunkManager so far; any created later has a larger one.
+         */
+        static unsigned long long getLastSequenceNumber() { return NextSequenceNumber.load(); }
+
         //
         // After constructor is invoked, we need to call loadExistingRanges.  If this is a new
         // sharded collection, we can call createFirstChunks first.
@@ -511,6 +566,9 @@ namespace mongo {
         const ChunkMap _chunkMap;
         const ChunkRangeManager _chunkRanges;
 
+        // Built from _chunkMap when it is loaded, used by findIntersectingChunk. May be empty.
+        const boost::shared_ptr<const ChunkRoutingTable> _routingTable;
+
         const std::set<Shard> _shards;
 
         const ShardVersionMap _shardVersions; // max version per shard
@@ -451,6 +451,9 @@ namespace mongo {
 
         ConfigCoordinator exec( &dispatcher, configHosts );
         exec.executeBatch( request, response, fsyncCheck );
+
+        // Don't serve stale settings or collection options that this mongos just changed itself
+        grid.invalidateConfigDocs( request.getNS() );
     }
 
     void ClusterWriterStats::setShardStats( BatchWriteExecStats* shardStats ) {
@@ -30,7 +30,10 @@
 
 #include "mongo/s/collection_metadata.h"
 
+#include <cstring>
+
 #include "mongo/bson/util/builder.h" // for StringBuilder
+#include "mongo/db/storage/key_string.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -38,6 +41,21 @@ namespace mongo {
 
     using mongoutils::str::stream;
 
+    namespace {
+
+        /**
+         * Encodes a shard key so that it sorts byte-wise the way BSONObj::woCompare() orders it.
+         * KeyString takes index keys, so the field names are dropped first.
+         */
+        void encodeRangeKey( const BSONObj& key, KeyString* out ) {
+            BSONObjBuilder unnamed;
+            BSONForEach( elem, key ) {
+                unnamed.appendAs( elem, "" );
+            }
+            out->resetToKey( unnamed.done(), Ordering::make( BSONObj() ) );
+        }
+    }
+
     CollectionMetadata::CollectionMetadata() { }
 
     CollectionMetadata::~CollectionMetadata() { }
@@ -201,6 +219,8 @@ namespace mongo {
         metadata->_pendingMap.erase( pending.getMin() );
         metadata->_chunksMap = this->_chunksMap;
         metadata->_rangesMap = this->_rangesMap;
+        metadata->_rangeKeyData = this->_rangeKeyData;
+        metadata->_rangeKeyOffsets = this->_rangeKeyOffsets;
         metadata->_shardVersion = _shardVersion;
         metadata->_collVersion = _collVersion;
 
@@ -236,6 +256,8 @@ namespace mongo {
         metadata->_pendingMap = this->_pendingMap;
         metadata->_chunksMap = this->_chunksMap;
         metadata->_rangesMap = this->_rangesMap;
+        metadata->_rangeKeyData = this->_rangeKeyData;
+        metadata->_rangeKeyOffsets = this->_rangeKeyOffsets;
         metadata->_shardVersion = _shardVersion;
         metadata->_collVersion = _collVersion;
 
@@ -426,6 +448,8 @@ namespace mongo {
         metadata->_pendingMap = this->_pendingMap;
         metadata->_chunksMap = this->_chunksMap;
         metadata->_rangesMap = this->_rangesMap;
+        metadata->_rangeKeyData = this->_rangeKeyData;
+        metadata->_rangeKeyOffsets = this->_rangeKeyOffsets;
         metadata->_shardVersion = newShardVersion;
         metadata->_collVersion =
                 newShardVersion > _collVersion ? newShardVersion : this->_collVersion;
@@ -447,29 +471,39 @@ namespace mongo {
             return true;
         }
 
-        if ( _rangesMap.size() <= 0 ) {
+        if ( _rangeKeyOffsets.size() < 2 ) {
             return false;
         }
 
-        RangeMap::const_iterator it = _rangesMap.upper_bound( key );
-        if ( it != _rangesMap.begin() ) it--;
-
-        bool good = rangeContains( it->first, it->second, key );
-
-#if 0
-        // DISABLED because of SERVER-11175 - huge amount of logging
-        // Logs if the point doesn't belong here.
-        if ( !good ) {
-            log() << "bad: " << key << " " << it->first << " " << key.woCompare( it->first ) << " "
-                  << key.woCompare( it->second ) << endl;
+        KeyString encodedKey;
+        encodeRangeKey( key, &encodedKey );
 
-            for ( RangeMap::const_iterator i = _rangesMap.begin(); i != _rangesMap.end(); ++i ) {
-                log() << "\t" << i->first << "\t" << i->second << "\t" << endl;
+        // Count the range bounds at or below the key. The bounds alternate min, max, min, ...
+        // in order, so the key is inside a range exactly when that count is odd.
+        size_t low = 0;
+        size_t high = _rangeKeyOffsets.size() - 1;
+        while ( low < high ) {
+            size_t mid = low + ( high - low ) / 2;
+            if ( compareRangeKey( mid, encodedKey.getBuffer(), encodedKey.getSize() ) <= 0 ) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
             }
         }
-#endif
 
-        return good;
+        return low % 2 == 1;
+    }
+
+    int CollectionMetadata::compareRangeKey( size_t bound, const char* key, size_t size ) const {
+        const char* boundData = _rangeKeyData.data() + _rangeKeyOffsets[bound];
+        size_t boundSize = _rangeKeyOffsets[bound + 1] - _rangeKeyOffsets[bound];
+
+        int cmp = memcmp( boundData, key, std::min( boundSize, size ) );
+        if ( cmp != 0 ) {
+            return cmp;
+        }
+        return boundSize < size ? -1 : ( boundSize == size ? 0 : 1 );
     }
 
     bool CollectionMetadata::keyIsPending( const BSONObj& key ) const {
@@ -733,6 +767,26 @@ namespace mongo {
         dassert(!min.isEmpty());
 
         _rangesMap.insert(make_pair(min, max));
+
+        fillRangeKeys();
+    }
+
+    void CollectionMetadata::fillRangeKeys() {
+        _rangeKeyData.clear();
+        _rangeKeyOffsets.clear();
+        _rangeKeyOffsets.reserve(_rangesMap.size() * 2 + 1);
+
+        KeyString encoded;
+        for (RangeMap::const_iterator it = _rangesMap.begin(); it != _rangesMap.end(); ++it) {
+            _rangeKeyOffsets.push_back(_rangeKeyData.size());
+            encodeRangeKey(it->first, &encoded);
+            _rangeKeyData.append(encoded.getBuffer(), encoded.getSize());
+
+            _rangeKeyOffsets.push_back(_rangeKeyData.size());
+            encodeRangeKey(it->second, &encoded);
+            _rangeKeyData.append(encoded.getBuffer(), encoded.getSize());
+        }
+        _rangeKeyOffsets.push_back(_rangeKeyData.size());
     }
 
     void CollectionMetadata::fillKeyPatternFields() {
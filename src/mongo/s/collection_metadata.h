@@ -29,6 +29,8 @@
 #pragma once
 
 #include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/base/owned_pointer_vector.h"
@@ -301,6 +303,12 @@ namespace mongo {
         // installations.
         RangeMap _rangesMap;
 
+        // The bounds of _rangesMap in order (min, max, min, max, ...), KeyString-encoded back to
+        // back into one buffer so that keyBelongsToMe() compares bytes rather than BSON. Bound i
+        // is _rangeKeyData[_rangeKeyOffsets[i], _rangeKeyOffsets[i + 1]).
+        std::string _rangeKeyData;
+        std::vector<size_t> _rangeKeyOffsets;
+
         /**
          * Returns true if this metadata was loaded with all necessary information.
          */
@@ -311,6 +319,17 @@ namespace mongo {
          */
         void fillRanges();
 
+        /**
+         * Encodes the bounds of _rangesMap into _rangeKeyData and _rangeKeyOffsets
+         */
+        void fillRangeKeys();
+
+        /**
+         * Compares the encoded range bound 'bound' with the encoded key 'key' of 'size' bytes,
+         * returning <0, 0 or >0 like memcmp
+         */
+        int compareRangeKey( size_t bound, const char* key, size_t size ) const;
+
         /**
          * Creates the _keyField* local data
          */
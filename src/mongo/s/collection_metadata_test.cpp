@@ -1231,6 +1231,16 @@ namespace {
         ASSERT_FALSE( getCollMetadata().keyBelongsToMe(BSON("a" << MAXKEY)) );
     }
 
+    TEST_F(ThreeChunkWithRangeGapFixture, RangeBoundsAcrossNumericTypes) {
+        ASSERT( getCollMetadata().keyBelongsToMe(BSON("a" << MINKEY)) );
+        ASSERT( getCollMetadata().keyBelongsToMe(BSON("a" << 19.5)) );
+        ASSERT( getCollMetadata().keyBelongsToMe(BSON("a" << 30.0)) );
+        ASSERT( getCollMetadata().keyBelongsToMe(BSON("a" << "abc")) );
+        ASSERT_FALSE( getCollMetadata().keyBelongsToMe(BSON("a" << 20LL)) );
+        ASSERT_FALSE( getCollMetadata().keyBelongsToMe(BSON("a" << 29.5)) );
+        ASSERT_FALSE( getCollMetadata().keyBelongsToMe(BSONObj()) );
+    }
+
     TEST_F(ThreeChunkWithRangeGapFixture, GetNextFromEmpty) {
         ChunkType nextChunk;
         ASSERT( getCollMetadata().getNextChunk( getCollMetadata().getMinKey(), &nextChunk ) );
@@ -37,6 +37,7 @@
 
 #include "mongo/client/connpool.h"
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/client/parallel.h"
 #include "mongo/client/replica_set_monitor.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/auth/action_set.h"
@@ -73,6 +74,7 @@
 #include "mongo/util/log.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compressor.h"
 #include "mongo/util/print.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
@@ -448,6 +450,96 @@ namespace mongo {
 
         // ------------ collection level commands -------------
 
+        /**
+         * Runs 'cmdObj' on database 'db' of each of 'shards' at once, and returns the responses
+         * in the same order.
+         */
+        static vector<BSONObj> runOnShards( const vector<Shard>& shards,
+                                            const string& db,
+                                            const BSONObj& cmdObj ) {
+            vector< shared_ptr<Future::CommandResult> > futures;
+            for ( size_t i = 0; i < shards.size(); i++ ) {
+                futures.push_back( Future::spawnCommand( shards[i].getConnString(),
+                                                         db,
+                                                         cmdObj,
+                                                         0 ) );
+            }
+
+            vector<BSONObj> responses;
+            for ( size_t i = 0; i < futures.size(); i++ ) {
+                futures[i]->join();
+                responses.push_back( futures[i]->result() );
+            }
+            return responses;
+        }
+
+        /**
+         * Creates the empty collection 'ns' on each of 'shards' with the options and indexes it
+         * has on the primary shard, which is what migrating a first chunk to them would do, so
+         * that they can be given chunks directly. Returns the shards which are ready; shards
+         * which already hold documents of 'ns', or which fail, are logged and left out.
+         */
+        static vector<Shard> prepareShardsForInitialChunks( const string& ns,
+                                                            const BSONObj& collectionOptions,
+                                                            const list<BSONObj>& indexSpecs,
+                                                            const vector<Shard>& shards ) {
+            const NamespaceString nss( ns );
+
+            vector<Shard> empty;
+            vector<BSONObj> responses = runOnShards( shards,
+                                                     nss.db().toString(),
+                                                     BSON( "count" << nss.coll() ) );
+            for ( size_t i = 0; i < shards.size(); i++ ) {
+                if ( !responses[i]["ok"].trueValue() || responses[i]["n"].numberLong() != 0 ) {
+                    warning() << "not placing initial chunks of " << ns << " on shard "
+                              << shards[i] << " as it already has documents of it: "
+                              << responses[i];
+                    continue;
+                }
+                empty.push_back( shards[i] );
+            }
+
+            BSONObjBuilder createCmd;
+            createCmd.append( "create", nss.coll() );
+            createCmd.appendElements( collectionOptions );
+
+            vector<Shard> created;
+            responses = runOnShards( empty, nss.db().toString(), createCmd.obj() );
+            for ( size_t i = 0; i < empty.size(); i++ ) {
+                if ( !responses[i]["ok"].trueValue()
+                    && responses[i]["code"].numberInt() != ErrorCodes::NamespaceExists ) {
+                    warning() << "not placing initial chunks of " << ns << " on shard "
+                              << empty[i] << " as it could not create the collection: "
+                              << responses[i];
+                    continue;
+                }
+                created.push_back( empty[i] );
+            }
+
+            BSONArrayBuilder indexes;
+            for ( list<BSONObj>::const_iterator it = indexSpecs.begin();
+                  it != indexSpecs.end();
+                  ++it ) {
+                indexes.append( it->removeField( "ns" ) );
+            }
+
+            vector<Shard> ready;
+            responses = runOnShards( created,
+                                     nss.db().toString(),
+                                     BSON( "createIndexes" << nss.coll()
+                                           << "indexes" << indexes.arr() ) );
+            for ( size_t i = 0; i < created.size(); i++ ) {
+                if ( !responses[i]["ok"].trueValue() ) {
+                    warning() << "not placing initial chunks of " << ns << " on shard "
+                              << created[i] << " as it could not create the indexes: "
+                              << responses[i];
+                    continue;
+                }
+                ready.push_back( created[i] );
+            }
+            return ready;
+        }
+
         class ShardCollectionCmd : public GridAdminCmd {
         public:
             ShardCollectionCmd() : GridAdminCmd( "shardCollection" ) {}
@@ -565,7 +657,8 @@ namespace mongo {
                 //         ii. is not sparse
                 //         iii. contains no null values
                 //         iv. is not multikey (maybe lift this restriction later)
-                //         v. if a hashed index, has default seed (lift this restriction later)
+                //         v. if a hashed index, has default seed and hash version (lift this
+                //            restriction later)
                 //
                 // 3. If the proposed shard key is specified as unique, there must exist a useful,
                 //    unique index exactly equal to the proposedKey (not just a prefix).
@@ -621,6 +714,18 @@ namespace mongo {
                             return false;
                         }
 
+                        // mongos hashes shard key values with the original hash function.
+                        if ( isHashedShardKey
+                            && idx["hashVersion"].numberInt() != MD5_HASH_VERSION ) {
+                            errmsg = str::stream()
+                                    << "can't shard collection " << ns << " with hashed shard key "
+                                    << proposedKey
+                                    << " because the hashed index uses hashVersion "
+                                    << idx["hashVersion"].numberInt();
+                            conn.done();
+                            return false;
+                        }
+
                         hasUsefulIndexForKey = true;
                     }
                 }
@@ -697,24 +802,34 @@ namespace mongo {
 
                 bool isEmpty = ( conn->count( ns ) == 0 );
 
+                // What the shards given initial chunks of a pre-split collection need to have.
+                BSONObj collectionOptions;
+                list<BSONObj> indexSpecs;
+                if ( isHashedShardKey && isEmpty ) {
+                    list<BSONObj> infos = conn->getCollectionInfos( nsStr.db().toString(),
+                                                                    BSON( "name" << nsStr.coll() ) );
+                    if ( !infos.empty() ) {
+                        collectionOptions = infos.front().getObjectField( "options" ).getOwned();
+                    }
+                    indexSpecs = conn->getIndexSpecs( ns );
+                }
+
                 conn.done();
 
                 // Pre-splitting:
                 // For new collections which use hashed shard keys, we can can pre-split the
                 // range of possible hashes into a large number of chunks, and distribute them
-                // evenly at creation time. Until we design a better initialization scheme, the
-                // safest way to pre-split is to
-                // 1. make one big chunk for each shard
-                // 2. move them one at a time
-                // 3. split the big chunks to achieve the desired total number of initial chunks
+                // evenly at creation time. As the collection is empty, no data has to move: each
+                // shard gets the collection and its indexes, and the chunks are created on their
+                // shards directly, without any migrations.
 
                 vector<Shard> shards;
                 Shard primary = config->getPrimary();
                 primary.getAllShards( shards );
                 int numShards = shards.size();
 
-                vector<BSONObj> initSplits;  // there will be at most numShards-1 of these
                 vector<BSONObj> allSplits;   // all of the initial desired split points
+                vector<Shard> initShards;    // the shards to place the initial chunks on
 
                 // only pre-split when using a hashed shard key and collection is still empty
                 if ( isHashedShardKey && isEmpty ){
@@ -742,14 +857,19 @@ namespace mongo {
                     }
                     sort( allSplits.begin() , allSplits.end() );
 
-                    // 1. the initial splits define the "big chunks" that we will subdivide later
-                    int lastIndex = -1;
-                    for ( int i = 1; i < numShards; i++ ){
-                        if ( lastIndex < (i*numChunks)/numShards - 1 ){
-                            lastIndex = (i*numChunks)/numShards - 1;
-                            initSplits.push_back( allSplits[ lastIndex ] );
+                    vector<Shard> otherShards;
+                    for ( int i = 0; i < numShards; i++ ) {
+                        if ( shards[i] != primary ) {
+                            otherShards.push_back( shards[i] );
                         }
                     }
+
+                    initShards.push_back( primary );
+                    vector<Shard> ready = prepareShardsForInitialChunks( ns,
+                                                                         collectionOptions,
+                                                                         indexSpecs,
+                                                                         otherShards );
+                    initShards.insert( initShards.end(), ready.begin(), ready.end() );
                 }
 
                 LOG(0) << "CMD: shardcollection: " << cmdObj << endl;
@@ -762,80 +882,10 @@ namespace mongo {
                 config->shardCollection(ns,
                                         proposedShardKey,
                                         careAboutUnique,
-                                        &initSplits);
+                                        &allSplits,
+                                        &initShards);
 
                 result << "collectionsharded" << ns;
-
-                // only initially move chunks when using a hashed shard key
-                if (isHashedShardKey && isEmpty) {
-
-                    // Reload the new config info.  If we created more than one initial chunk, then
-                    // we need to move them around to balance.
-                    ChunkManagerPtr chunkManager = config->getChunkManager( ns , true );
-                    ChunkMap chunkMap = chunkManager->getChunkMap();
-                    // 2. Move and commit each "big chunk" to a different shard.
-                    int i = 0;
-                    for ( ChunkMap::const_iterator c = chunkMap.begin(); c != chunkMap.end(); ++c,++i ){
-                        Shard to = shards[ i % numShards ];
-                        ChunkPtr chunk = c->second;
-
-                        // can't move chunk to shard it's already on
-                        if ( to == chunk->getShard() )
-                            continue;
-
-                        BSONObj moveResult;
-                        WriteConcernOptions noThrottle;
-                        if (!chunk->moveAndCommit(to, Chunk::MaxChunkSize,
-                                                  &noThrottle, true, 0, moveResult)) {
-                            warning() << "couldn't move chunk " << chunk->toString()
-                                      << " to shard " << to
-                                      << " while sharding collection " << ns
-                                      << ". Reason: " <<  moveResult;
-                        }
-                    }
-
-                    if (allSplits.empty()) {
-                        return true;
-                    }
-
-                    // Reload the config info, after all the migrations
-                    chunkManager = config->getChunkManager( ns , true );
-
-                    // 3. Subdivide the big chunks by splitting at each of the points in "allSplits"
-                    //    that we haven't already split by.
-                    ChunkPtr currentChunk = chunkManager->findIntersectingChunk( allSplits[0] );
-                    vector<BSONObj> subSplits;
-                    for ( unsigned i = 0 ; i <= allSplits.size(); i++){
-                        if ( i == allSplits.size() ||
-                                ! currentChunk->containsKey( allSplits[i] ) ) {
-                            if ( ! subSplits.empty() ){
-                                Status status = currentChunk->multiSplit(subSplits, NULL);
-                                if ( !status.isOK() ){
-                                    warning() << "couldn't split chunk "
-                                              << currentChunk->toString()
-                                              << " while sharding collection " << ns
-                                              << causedBy(status);
-                                }
-                                subSplits.clear();
-                            }
-                            if ( i < allSplits.size() )
-                                currentChunk = chunkManager->findIntersectingChunk( allSplits[i] );
-                        } else {
-                            BSONObj splitPoint(allSplits[i]);
-                            if ( currentChunk->getMin().woCompare( splitPoint ) == 0 ) {
-                                // Do not split on the boundaries.
-                                continue;
-                            }
-
-                            subSplits.push_back( splitPoint );
-                        }
-                    }
-
-                    // Proactively refresh the chunk manager. Not really necessary, but this way it's
-                    // immediately up-to-date the next time it's used.
-                    config->getChunkManager( ns , true );
-                }
-
                 return true;
             }
         } shardCollectionCmd;
@@ -1586,6 +1636,7 @@ namespace mongo {
                 // compiled for.
                 result.append("maxWireVersion", maxWireVersion);
                 result.append("minWireVersion", minWireVersion);
+                negotiateMessageCompression(cmdObj, ClientBasic::getCurrent()->port(), &result);
 
                 return true;
             }
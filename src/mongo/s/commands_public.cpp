@@ -34,6 +34,7 @@
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <queue>
 
 #include "mongo/base/init.h"
 #include "mongo/client/connpool.h"
@@ -50,6 +51,7 @@
 #include "mongo/db/commands/rename_collection.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/dbmessage.h"
+#include "mongo/db/hasher.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/pipeline/document_source.h"
@@ -1708,7 +1710,10 @@ namespace mongo {
                     shardArray.append(i->getName());
                 }
 
-                multimap<double, BSONObj> results; // TODO: maybe use merge-sort instead
+                // Each shard returns its results in distance order, so they are merged in place
+                // rather than copied and sorted, and merging stops after 'limit' results.
+                vector<BSONObjIterator> shardResults;
+                priority_queue<NearResult> nextResults;
                 string nearStr;
                 double time = 0;
                 double btreelocs = 0;
@@ -1736,11 +1741,9 @@ namespace mongo {
                         objectsLoaded += res->result()["stats"]["objectsLoaded"].Number();
                     }
 
-                    BSONForEach(obj, res->result()["results"].embeddedObject()) {
-                        results.insert(make_pair(obj["dis"].Number(), obj.embeddedObject().getOwned()));
-                    }
-
-                    // TODO: maybe shrink results if size() > limit
+                    // The results stay valid as long as 'futures' holds the shard's response.
+                    shardResults.push_back(BSONObjIterator(res->result()["results"].embeddedObject()));
+                    pushNext(shardResults, shardResults.size() - 1, &nextResults);
                 }
 
                 result.append("ns" , fullns);
@@ -1751,11 +1754,15 @@ namespace mongo {
                 double maxDistance = 0;
                 {
                     BSONArrayBuilder sub (result.subarrayStart("results"));
-                    for (multimap<double, BSONObj>::const_iterator it(results.begin()), end(results.end()); it!= end && outCount < limit; ++it, ++outCount) {
-                        totalDistance += it->first;
-                        maxDistance = it->first; // guaranteed to be highest so far
+                    for (; !nextResults.empty() && outCount < limit; ++outCount) {
+                        const NearResult next = nextResults.top();
+                        nextResults.pop();
 
-                        sub.append(it->second);
+                        totalDistance += next.distance;
+                        maxDistance = next.distance; // guaranteed to be highest so far
+
+                        sub.append(next.obj);
+                        pushNext(shardResults, next.shard, &nextResults);
                     }
                     sub.done();
                 }
@@ -1774,6 +1781,35 @@ namespace mongo {
 
                 return true;
             }
+
+        private:
+            /** The next result of one shard, ordered so that a priority_queue pops the nearest. */
+            struct NearResult {
+                NearResult(double distance, size_t shard, const BSONObj& obj)
+                    : distance(distance), shard(shard), obj(obj) {}
+
+                bool operator<(const NearResult& other) const {
+                    if (distance != other.distance) {
+                        return distance > other.distance;
+                    }
+                    // Equally distant results come out in shard order.
+                    return shard > other.shard;
+                }
+
+                double distance;
+                size_t shard;
+                BSONObj obj;
+            };
+
+            static void pushNext(vector<BSONObjIterator>& shardResults,
+                                 size_t shard,
+                                 priority_queue<NearResult>* nextResults) {
+                if (!shardResults[shard].more()) {
+                    return;
+                }
+                const BSONObj obj = shardResults[shard].next().embeddedObject();
+                nextResults->push(NearResult(obj["dis"].Number(), shard, obj));
+            }
         } geo2dFindNearCmd;
 
         /**
@@ -2339,6 +2375,11 @@ namespace mongo {
             void uassertCanMergeInMongos(intrusive_ptr<Pipeline> mergePipeline, BSONObj cmdObj);
             void uassertAllShardsSupportExplain(
                 const vector<Strategy::CommandResult>& shardResults);
+            Shard pickMergingShard(intrusive_ptr<Pipeline> mergePipeline,
+                                   DBConfigPtr conf,
+                                   const string& fullns,
+                                   BSONObj shardedCommand,
+                                   const vector<Strategy::CommandResult>& shardResults);
 
             void noCursorFallback(intrusive_ptr<Pipeline> shardPipeline,
                                   intrusive_ptr<Pipeline> mergePipeline,
@@ -2435,12 +2476,16 @@ namespace mongo {
             vector<Strategy::CommandResult> shardResults;
             STRATEGY->commandOp(dbName, shardedCommand, options, fullns, shardQuery, &shardResults);
 
+            const Shard mergingShard =
+                pickMergingShard(pPipeline, conf, fullns, shardedCommand, shardResults);
+
             if (pPipeline->isExplain()) {
                 // This must be checked before we start modifying result.
                 uassertAllShardsSupportExplain(shardResults);
 
                 result << "splitPipeline" << DOC("shardsPart" << pShardPipeline->writeExplainOps()
                                               << "mergerPart" << pPipeline->writeExplainOps());
+                result << "mergingShard" << mergingShard.getName();
 
                 BSONObjBuilder shardExplains(result.subobjStart("shards"));
                 for (size_t i = 0; i < shardResults.size(); i++) {
@@ -2478,9 +2523,9 @@ namespace mongo {
                 outputNsOrEmpty = out->getOutputNs().ns();
             }
 
-            // Run merging command on primary shard of database. Need to use ShardConnection so
-            // that the merging mongod is sent the config servers on connection init.
-            const string mergeServer = conf->getPrimary().getConnString();
+            // Run merging command on the merging shard. Need to use ShardConnection so that the
+            // merging mongod is sent the config servers on connection init.
+            const string mergeServer = mergingShard.getConnString();
             ShardConnection conn(mergeServer, outputNsOrEmpty);
             BSONObj mergedResults = aggRunCommand(conn.get(),
                                                   dbName,
@@ -2506,6 +2551,27 @@ namespace mongo {
             return ok;
         }
 
+        Shard PipelineCommand::pickMergingShard(
+                intrusive_ptr<Pipeline> mergePipeline,
+                DBConfigPtr conf,
+                const string& fullns,
+                BSONObj shardedCommand,
+                const vector<Strategy::CommandResult>& shardResults) {
+            if (mergePipeline->needsPrimaryShardMerger() || shardResults.empty())
+                return conf->getPrimary();
+
+            // Spread merges over the shards holding the data, rather than running all of them on
+            // the primary. The choice hashes the collection and the shards' part of the pipeline,
+            // which carries the $group key, so that the same aggregation keeps merging on the
+            // same shard.
+            const BSONObj mergeKey = BSON("" << BSON("ns" << fullns
+                                                  << "pipeline" << shardedCommand["pipeline"]));
+            const unsigned long long hash =
+                BSONElementHasher::hash64(mergeKey.firstElement(),
+                                          BSONElementHasher::DEFAULT_HASH_SEED);
+            return shardResults[hash % shardResults.size()].shardTarget;
+        }
+
         void PipelineCommand::uassertCanMergeInMongos(intrusive_ptr<Pipeline> mergePipeline,
                                                       BSONObj cmdObj) {
             uassert(17020, "All shards must support cursors to get a cursor back from aggregation",
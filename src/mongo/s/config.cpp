@@ -244,25 +244,34 @@ namespace mongo {
             verify( manager.get() );
         }
 
-        // Tell the primary mongod to refresh it's data
+        // Tell the primary mongod, and any other shard given initial chunks, to refresh its data
         // TODO:  Think the real fix here is for mongos to just assume all collections sharded, when we get there
-        for( int i = 0; i < 4; i++ ){
-            if( i == 3 ){
-                warning() << "too many tries updating initial version of " << ns << " on shard primary " << getPrimary() <<
-                             ", other mongoses may not see the collection as sharded immediately" << endl;
-                break;
-            }
-            try {
-                ShardConnection conn( getPrimary(), ns );
-                conn.setVersion();
-                conn.done();
-                break;
-            }
-            catch( DBException& e ){
-                warning() << "could not update initial version of " << ns << " on shard primary " << getPrimary() <<
-                             causedBy( e ) << endl;
+        set<Shard> shardsToRefresh;
+        shardsToRefresh.insert( getPrimary() );
+        if ( initShards ) {
+            shardsToRefresh.insert( initShards->begin(), initShards->end() );
+        }
+        for ( set<Shard>::const_iterator it = shardsToRefresh.begin();
+              it != shardsToRefresh.end();
+              ++it ) {
+            for( int i = 0; i < 4; i++ ){
+                if( i == 3 ){
+                    warning() << "too many tries updating initial version of " << ns << " on shard " << *it <<
+                                 ", other mongoses may not see the collection as sharded immediately" << endl;
+                    break;
+                }
+                try {
+                    ShardConnection conn( *it, ns );
+                    conn.setVersion();
+                    conn.done();
+                    break;
+                }
+                catch( DBException& e ){
+                    warning() << "could not update initial version of " << ns << " on shard " << *it <<
+                                 causedBy( e ) << endl;
+                }
+                sleepsecs( i );
             }
-            sleepsecs( i );
         }
 
         // Record finish in changelog
@@ -362,6 +371,11 @@ namespace mongo {
         ChunkVersion oldVersion;
         ChunkManagerPtr oldManager;
 
+        // Any chunk manager loaded for ns with a larger sequence number than this started
+        // loading after we decided we needed one, so it is as fresh as what we'd load ourselves.
+        const unsigned long long lastSequenceNumberOnEntry =
+            ChunkManager::getLastSequenceNumber();
+
         {
             scoped_lock lk( _lock );
             
@@ -386,30 +400,8 @@ namespace mongo {
         }
         
         verify( ! key.isEmpty() );
-        
-        // TODO: We need to keep this first one-chunk check in until we have a more efficient way of
-        // creating/reusing a chunk manager, as doing so requires copying the full set of chunks currently
-
-        BSONObj newest;
-        if ( oldVersion.isSet() && ! forceReload ) {
-            ScopedDbConnection conn(configServer.modelServer(), 30.0);
-            newest = conn->findOne(ChunkType::ConfigNS,
-                                   Query(BSON(ChunkType::ns(ns))).sort(
-                                           ChunkType::DEPRECATED_lastmod(), -1));
-            conn.done();
-            
-            if ( ! newest.isEmpty() ) {
-                ChunkVersion v = ChunkVersion::fromBSON(newest, ChunkType::DEPRECATED_lastmod());
-                if ( v.equals( oldVersion ) ) {
-                    scoped_lock lk( _lock );
-                    CollectionInfo& ci = _collections[ns];
-                    uassert( 15885 , str::stream() << "not sharded after reloading from chunks : " << ns , ci.isSharded() );
-                    return ci.getCM();
-                }
-            }
 
-        }
-        else if( ! oldVersion.isSet() ){
+        if( ! oldVersion.isSet() ){
             warning() << "version 0 found when " << ( forceReload ? "reloading" : "checking" ) << " chunk manager"
                       << ", collection '" << ns << "' initially detected as sharded" << endl;
         }
@@ -419,30 +411,47 @@ namespace mongo {
         auto_ptr<ChunkManager> temp;
 
         {
+            // Threads finding ns stale at the same time queue up here, and only the first one
+            // goes to the config server; the others pick up what it loaded.
             scoped_lock lll ( _hitConfigServerLock );
-            
-            if ( ! newest.isEmpty() && ! forceReload ) {
-                // if we have a target we're going for
-                // see if we've hit already
-                
+
+            {
                 scoped_lock lk( _lock );
                 CollectionInfo& ci = _collections[ns];
-                if ( ci.isSharded() && ci.getCM() ) {
+                uassert( 10181 ,  (string)"not sharded:" + ns , ci.isSharded() );
+
+                if ( ci.getCM()->getSequenceNumber() > lastSequenceNumberOnEntry ) {
+                    return ci.getCM();
+                }
+
+                // Diff against the newest manager, which may have moved on since we looked.
+                oldManager = ci.getCM();
+                oldVersion = oldManager->getVersion();
+            }
 
+            // TODO: We need to keep this first one-chunk check in until we have a more efficient way of
+            // creating/reusing a chunk manager, as doing so requires copying the full set of chunks currently
+            if ( oldVersion.isSet() && ! forceReload ) {
+                ScopedDbConnection conn(configServer.modelServer(), 30.0);
+                BSONObj newest = conn->findOne(ChunkType::ConfigNS,
+                                               Query(BSON(ChunkType::ns(ns))).sort(
+                                                   ChunkType::DEPRECATED_lastmod(), -1));
+                conn.done();
+
+                if ( ! newest.isEmpty() ) {
                     ChunkVersion currentVersion =
                         ChunkVersion::fromBSON(newest, ChunkType::DEPRECATED_lastmod());
 
                     // Only reload if the version we found is newer than our own in the same
                     // epoch
-                    if( currentVersion <= ci.getCM()->getVersion() &&
-                        ci.getCM()->getVersion().hasEqualEpoch( currentVersion ) )
+                    if( currentVersion <= oldVersion &&
+                        oldVersion.hasEqualEpoch( currentVersion ) )
                     {
-                        return ci.getCM();
+                        return oldManager;
                     }
                 }
-                
             }
-            
+
             temp.reset(new ChunkManager(oldManager->getns(),
                                         oldManager->getShardKeyPattern(),
                                         oldManager->isUnique()));
@@ -132,8 +132,9 @@ namespace mongo {
          * distributed in a round-robin fashion onto a set of initial shards.  If no initial shards
          * are specified, only the primary will be used.
          *
-         * WARNING: It's not safe to place initial chunks onto non-primary shards using this method.
-         * The initShards parameter allows legacy behavior expected by map-reduce.
+         * WARNING: It's only safe to place initial chunks onto non-primary shards if the
+         * collection is empty and those shards already have it with its indexes, as for the
+         * pre-split collections of shardCollection and the output collections of map-reduce.
          */
         ChunkManagerPtr shardCollection(const std::string& ns,
                                         const ShardKeyPattern& fieldsAndOrder,
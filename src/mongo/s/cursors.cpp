@@ -48,6 +48,7 @@
 #include "mongo/db/commands.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/max_time.h"
+#include "mongo/db/query/cursor_batch_budget.h"
 #include "mongo/util/concurrency/task.h"
 #include "mongo/util/log.h"
 #include "mongo/util/net/listen.h"
@@ -165,6 +166,8 @@ namespace mongo {
         const bool sendMoreBatches = ntoreturn == 0 || ntoreturn > 1;
         ntoreturn = abs( ntoreturn );
 
+        const CursorBatchBudget budget( maxSize, sendMoreBatches );
+
         bool cursorHasMore = true;
         while ( ( cursorHasMore = _cursor->more() ) ) {
             BSONObj o = _cursor->next();
@@ -177,7 +180,7 @@ namespace mongo {
                 _cursor->setBatchSize(ntoreturn - docCount);
             }
 
-            if ( buffer.len() > maxSize ) {
+            if ( budget.enough( docCount, buffer.len() ) ) {
                 break;
             }
 
@@ -56,6 +56,7 @@
 #include "mongo/db/catalog/index_create.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/concurrency/lock_state.h"
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/exec/plan_stage.h"
@@ -70,8 +71,10 @@
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/logger/ramlog.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
@@ -79,7 +82,9 @@
 #include "mongo/s/distlock.h"
 #include "mongo/s/shard.h"
 #include "mongo/s/type_chunk.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/elapsed_tracker.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
@@ -87,6 +92,7 @@
 #include "mongo/util/processinfo.h"
 #include "mongo/util/queue.h"
 #include "mongo/util/startup_test.h"
+#include "mongo/util/token_bucket.h"
 
 // Pause while a fail point is enabled.
 #define MONGO_FP_PAUSE_WHILE(symbol) while (MONGO_FAIL_POINT(symbol)) { sleepmillis(100); }
@@ -99,6 +105,9 @@ namespace {
     using mongo::repl::ReplicationCoordinator;
 
     const int kDefaultWTimeoutMs = 60 * 1000;
+
+    // Number of documents the recipient of a migration writes each time it locks the collection
+    const int kMaxDocsPerWriteLock = 100;
     const WriteConcernOptions DefaultWriteConcern(2, WriteConcernOptions::NONE, kDefaultWTimeoutMs);
 
     /**
@@ -131,6 +140,113 @@ namespace mongo {
 
     Tee* migrateLog = RamLog::get("migrate");
 
+    // Limits on the rate at which this shard copies chunk documents, as donor and recipient of
+    // migrations together, zero for no limit
+    MONGO_EXPORT_SERVER_PARAMETER(migrationMaxDocsPerSecond, int, 0);
+    MONGO_EXPORT_SERVER_PARAMETER(migrationMaxBytesPerSecond, long long, 0);
+
+    /**
+     * Shares the docs/sec and bytes/sec budgets between the cloning done for all the migrations
+     * this shard takes part in, so that they can run alongside the regular workload.
+     */
+    class MigrationThrottle {
+    public:
+        // Longest sleep between two checks for interruption while throttled
+        static const long long kMaxThrottleSleepMicros = 100 * 1000;
+
+        MigrationThrottle() : _mutex("MigrationThrottle") {}
+
+        /**
+         * Charges 'docs' documents of 'bytes' bytes, which were just cloned for a migration
+         * donated by this shard if 'donor' or received otherwise, and sleeps off any debt.
+         * Must not be called with locks held.
+         */
+        void cloned(OperationContext* txn, bool donor, long long docs, long long bytes) {
+            if (donor) {
+                _donorDocs.fetchAndAdd(docs);
+                _donorBytes.fetchAndAdd(bytes);
+            }
+            else {
+                _recipientDocs.fetchAndAdd(docs);
+                _recipientBytes.fetchAndAdd(bytes);
+            }
+
+            long long waitMicros;
+            {
+                SimpleMutex::scoped_lock sl(_mutex);
+                const long long now = curTimeMicros64();
+
+                _docsBucket.setRate(migrationMaxDocsPerSecond);
+                _bytesBucket.setRate(migrationMaxBytesPerSecond);
+                waitMicros = std::max(_docsBucket.consume(docs, now),
+                                      _bytesBucket.consume(bytes, now));
+            }
+
+            if (waitMicros <= 0) {
+                return;
+            }
+
+            _throttledMicros.fetchAndAdd(waitMicros);
+
+            // Sleep in slices, so killOp, aborts and shutdown are not held up by a low budget
+            while (waitMicros > 0) {
+                txn->checkForInterrupt();
+                const long long sleepMicros = std::min(waitMicros, kMaxThrottleSleepMicros);
+                sleepmicros(sleepMicros);
+                waitMicros -= sleepMicros;
+            }
+        }
+
+        void appendStats(BSONObjBuilder* builder) const {
+            builder->append("maxDocsPerSecond", migrationMaxDocsPerSecond);
+            builder->append("maxBytesPerSecond", migrationMaxBytesPerSecond);
+            builder->append("donorDocs", static_cast<long long>(_donorDocs.load()));
+            builder->append("donorBytes", static_cast<long long>(_donorBytes.load()));
+            builder->append("recipientDocs", static_cast<long long>(_recipientDocs.load()));
+            builder->append("recipientBytes", static_cast<long long>(_recipientBytes.load()));
+            builder->append("throttledMillis",
+                            static_cast<long long>(_throttledMicros.load() / 1000));
+        }
+
+    private:
+        // Protects the buckets
+        SimpleMutex _mutex;
+        TokenBucket _docsBucket;
+        TokenBucket _bytesBucket;
+
+        AtomicInt64 _donorDocs;
+        AtomicInt64 _donorBytes;
+        AtomicInt64 _recipientDocs;
+        AtomicInt64 _recipientBytes;
+        AtomicInt64 _throttledMicros;
+    } migrationThrottle;
+
+    /**
+     * Sample format:
+     *
+     * migrationThrottle: {
+     *   maxDocsPerSecond: 5000,
+     *   maxBytesPerSecond: NumberLong(10485760),
+     *   donorDocs: NumberLong(120000),
+     *   donorBytes: NumberLong(15360000),
+     *   recipientDocs: NumberLong(0),
+     *   recipientBytes: NumberLong(0),
+     *   throttledMillis: NumberLong(1200)
+     * }
+     */
+    class MigrationThrottleServerStatusSection : public ServerStatusSection {
+    public:
+        MigrationThrottleServerStatusSection() : ServerStatusSection("migrationThrottle") {}
+        bool includeByDefault() const { return true; }
+
+        BSONObj generateSection(OperationContext* txn,
+                                const BSONElement& configElement) const {
+            BSONObjBuilder result;
+            migrationThrottle.appendStats(&result);
+            return result.obj();
+        }
+    } migrationThrottleServerStatusSection;
+
     class MoveTimingHelper {
     public:
         MoveTimingHelper(OperationContext* txn,
@@ -671,6 +787,10 @@ namespace mongo {
                 }
             }
 
+            // Hold back the reply, with no locks held, if this shard is over its budget
+            migrationThrottle.cloned(txn, true, clonedDocsArrayBuilder.arrSize(),
+                                     clonedDocsArrayBuilder.len());
+
             result.appendArray("objects", clonedDocsArrayBuilder.arr());
             return true;
         }
@@ -1760,6 +1880,59 @@ namespace mongo {
     MONGO_FP_DECLARE(migrateThreadHangAtStep4);
     MONGO_FP_DECLARE(migrateThreadHangAtStep5);
 
+    /**
+     * Runs a command against the donor shard of a migration on a background thread, so that the
+     * recipient can apply the reply to the previous one in the meantime. The connection must not
+     * be used until wait() returns.
+     */
+    class BackgroundDonorCommand : boost::noncopyable {
+    public:
+        BackgroundDonorCommand(DBClientBase* conn, const BSONObj& cmd)
+            : _conn(conn),
+              _cmd(cmd),
+              _ok(false),
+              _thread(stdx::bind(&BackgroundDonorCommand::_run, this)) {
+        }
+
+        ~BackgroundDonorCommand() {
+            if (_thread.joinable()) {
+                _thread.join();
+            }
+        }
+
+        /**
+         * Waits for the reply of the donor and returns whether the command succeeded.
+         */
+        bool wait(BSONObj* res) {
+            if (_thread.joinable()) {
+                _thread.join();
+            }
+
+            *res = _res;
+            return _ok;
+        }
+
+    private:
+        void _run() {
+            try {
+                _ok = _conn->runCommand("admin", _cmd, _res);
+            }
+            catch (const DBException& ex) {
+                _ok = false;
+                _res = BSON("ok" << 0 << "errmsg" << ex.toString());
+            }
+        }
+
+        DBClientBase* const _conn;
+        const BSONObj _cmd;
+
+        bool _ok;
+        BSONObj _res;
+
+        // Last, so it starts once the members above are initialized
+        boost::thread _thread;
+    };
+
     class MigrateStatus {
     public:
         enum State {
@@ -2062,9 +2235,12 @@ namespace mongo {
                 // 3. initial bulk clone
                 setState(CLONE);
 
+                // gets array of objects to copy, in disk order
+                BSONObj res;
+                bool cloneOk = conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res );
+
                 while ( true ) {
-                    BSONObj res;
-                    if ( ! conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res ) ) {  // gets array of objects to copy, in disk order
+                    if ( ! cloneOk ) {
                         setState(FAIL);
                         errmsg = "_migrateClone failed: ";
                         errmsg += res.toString();
@@ -2074,7 +2250,12 @@ namespace mongo {
                     }
 
                     BSONObj arr = res["objects"].Obj();
-                    int thisTime = 0;
+                    if ( arr.isEmpty() )
+                        break;
+
+                    // The donor hands out each document once, so the next batch can be fetched
+                    // while this one is being inserted.
+                    BackgroundDonorCommand nextBatch( conn.get(), BSON( "_migrateClone" << 1 ) );
 
                     BSONObjIterator i( arr );
                     while( i.more() ) {
@@ -2087,42 +2268,49 @@ namespace mongo {
                             return;
                         }
 
-                        BSONObj docToClone = i.next().Obj();
+                        int thisTime = 0;
+                        long long thisTimeBytes = 0;
                         {
                             Client::WriteContext cx(txn, ns );
 
-                            BSONObj localDoc;
-                            if (willOverrideLocalId(txn,
-                                                    ns,
-                                                    min,
-                                                    max,
-                                                    shardKeyPattern,
-                                                    cx.ctx().db(),
-                                                    docToClone,
-                                                    &localDoc)) {
-                                string errMsg =
-                                    str::stream() << "cannot migrate chunk, local document "
-                                    << localDoc
-                                    << " has same _id as cloned "
-                                    << "remote document " << docToClone;
-
-                                warning() << errMsg << endl;
-
-                                // Exception will abort migration cleanly
-                                uasserted( 16976, errMsg );
+                            for ( ; i.more() && thisTime < kMaxDocsPerWriteLock; thisTime++ ) {
+                                BSONObj docToClone = i.next().Obj();
+
+                                BSONObj localDoc;
+                                if (willOverrideLocalId(txn,
+                                                        ns,
+                                                        min,
+                                                        max,
+                                                        shardKeyPattern,
+                                                        cx.ctx().db(),
+                                                        docToClone,
+                                                        &localDoc)) {
+                                    string errMsg =
+                                        str::stream() << "cannot migrate chunk, local document "
+                                        << localDoc
+                                        << " has same _id as cloned "
+                                        << "remote document " << docToClone;
+
+                                    warning() << errMsg << endl;
+
+                                    // Exception will abort migration cleanly
+                                    uasserted( 16976, errMsg );
+                                }
+
+                                Helpers::upsert( txn, ns, docToClone, true );
+                                thisTimeBytes += docToClone.objsize();
                             }
-
-                            Helpers::upsert( txn, ns, docToClone, true );
                         }
-                        thisTime++;
 
                         {
                             scoped_lock statsLock(_mutex);
-                            _numCloned++;
-                            _clonedBytes += docToClone.objsize();
+                            _numCloned += thisTime;
+                            _clonedBytes += thisTimeBytes;
                         }
 
-                        if (writeConcern.shouldWaitForOtherNodes() && thisTime > 0) {
+                        migrationThrottle.cloned(txn, false, thisTime, thisTimeBytes);
+
+                        if (writeConcern.shouldWaitForOtherNodes()) {
                             repl::ReplicationCoordinator::StatusAndDuration replStatus =
                                     repl::getGlobalReplicationCoordinator()->awaitReplication(
                                             txn,
@@ -2138,8 +2326,7 @@ namespace mongo {
                         }
                     }
 
-                    if ( thisTime == 0 )
-                        break;
+                    cloneOk = nextBatch.wait( &res );
                 }
 
                 timing.done(3);
@@ -2331,39 +2518,43 @@ namespace mongo {
                 Lock::DBLock dlk(txn->lockState(), nsToDatabaseSubstring(ns), MODE_IX);
                 Helpers::RemoveSaver rs( "moveChunk" , ns , "removedDuring" );
 
+                // The deletes and the reloads are each applied in groups, so the collection
+                // lock is taken once per group rather than once per document.
                 BSONObjIterator i( xfer["deleted"].Obj() );
                 while ( i.more() ) {
                     Lock::CollectionLock clk(txn->lockState(), ns, MODE_X);
                     Client::Context ctx(txn, ns);
 
-                    BSONObj id = i.next().Obj();
+                    for ( int n = 0; i.more() && n < kMaxDocsPerWriteLock; n++ ) {
+                        BSONObj id = i.next().Obj();
 
-                    // do not apply deletes if they do not belong to the chunk being migrated
-                    BSONObj fullObj;
-                    if (Helpers::findById(txn, ctx.db(), ns.c_str(), id, fullObj)) {
-                        if (!isInRange(fullObj , min , max , shardKeyPattern)) {
-                            log() << "not applying out of range deletion: " << fullObj << migrateLog;
+                        // do not apply deletes if they do not belong to the chunk being migrated
+                        BSONObj fullObj;
+                        if (Helpers::findById(txn, ctx.db(), ns.c_str(), id, fullObj)) {
+                            if (!isInRange(fullObj , min , max , shardKeyPattern)) {
+                                log() << "not applying out of range deletion: " << fullObj << migrateLog;
 
-                            continue;
+                                continue;
+                            }
                         }
-                    }
 
-                    if (serverGlobalParams.moveParanoia) {
-                        rs.goingToDelete(fullObj);
-                    }
-
-                    deleteObjects(txn,
-                                  ctx.db(),
-                                  ns,
-                                  id,
-                                  PlanExecutor::YIELD_MANUAL,
-                                  true /* justOne */,
-                                  true /* logOp */,
-                                  false /* god */,
-                                  true /* fromMigrate */);
+                        if (serverGlobalParams.moveParanoia) {
+                            rs.goingToDelete(fullObj);
+                        }
 
-                    *lastOpApplied = ctx.getClient()->getLastOp().asDate();
-                    didAnything = true;
+                        deleteObjects(txn,
+                                      ctx.db(),
+                                      ns,
+                                      id,
+                                      PlanExecutor::YIELD_MANUAL,
+                                      true /* justOne */,
+                                      true /* logOp */,
+                                      false /* god */,
+                                      true /* fromMigrate */);
+
+                        *lastOpApplied = ctx.getClient()->getLastOp().asDate();
+                        didAnything = true;
+                    }
                 }
             }
 
@@ -2372,34 +2563,36 @@ namespace mongo {
                 while ( i.more() ) {
                     Client::WriteContext cx(txn, ns);
 
-                    BSONObj updatedDoc = i.next().Obj();
-
-                    BSONObj localDoc;
-                    if (willOverrideLocalId(txn,
-                                            ns,
-                                            min,
-                                            max,
-                                            shardKeyPattern,
-                                            cx.ctx().db(),
-                                            updatedDoc,
-                                            &localDoc)) {
-                        string errMsg =
-                            str::stream() << "cannot migrate chunk, local document "
-                                          << localDoc
-                                          << " has same _id as reloaded remote document "
-                                          << updatedDoc;
-
-                        warning() << errMsg << endl;
-
-                        // Exception will abort migration cleanly
-                        uasserted( 16977, errMsg );
-                    }
+                    for ( int n = 0; i.more() && n < kMaxDocsPerWriteLock; n++ ) {
+                        BSONObj updatedDoc = i.next().Obj();
+
+                        BSONObj localDoc;
+                        if (willOverrideLocalId(txn,
+                                                ns,
+                                                min,
+                                                max,
+                                                shardKeyPattern,
+                                                cx.ctx().db(),
+                                                updatedDoc,
+                                                &localDoc)) {
+                            string errMsg =
+                                str::stream() << "cannot migrate chunk, local document "
+                                              << localDoc
+                                              << " has same _id as reloaded remote document "
+                                              << updatedDoc;
+
+                            warning() << errMsg << endl;
+
+                            // Exception will abort migration cleanly
+                            uasserted( 16977, errMsg );
+                        }
 
-                    // We are in write lock here, so sure we aren't killing
-                    Helpers::upsert( txn, ns , updatedDoc , true );
+                        // We are in write lock here, so sure we aren't killing
+                        Helpers::upsert( txn, ns , updatedDoc , true );
 
-                    *lastOpApplied = cx.ctx().getClient()->getLastOp().asDate();
-                    didAnything = true;
+                        *lastOpApplied = cx.ctx().getClient()->getLastOp().asDate();
+                        didAnything = true;
+                    }
                 }
             }
 
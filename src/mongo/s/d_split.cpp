@@ -32,6 +32,7 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <map>
 #include <string>
 #include <vector>
@@ -50,6 +51,7 @@
 #include "mongo/db/instance.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/storage/record_store.h"
 #include "mongo/s/chunk.h" // for static genID only
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
@@ -212,6 +214,95 @@ namespace mongo {
         return key.replaceFieldNames(keyPattern).clientReadable();
     }
 
+    namespace {
+
+        // Upper bound on the 'sampleSize' a splitVector caller can ask for
+        const int kMaxSplitVectorSampleSize = 100 * 1000;
+
+        // Fewer sampled documents than this in a chunk are too few to place its split points
+        const size_t kMinSampledKeysInChunk = 100;
+
+        /**
+         * Estimates the split points of the chunk [min, max) from 'sampleSize' documents picked at
+         * random from the collection, as if the index had been walked and every 'keyCount'-th key
+         * had been picked. The number of documents in the chunk is estimated from the fraction of
+         * the sample falling in it. An empty min or max stands for MinKey or MaxKey.
+         *
+         * Returns false if the storage engine can't sample or the sample can't be trusted, in
+         * which case the index has to be walked.
+         */
+        bool sampleSplitPoints(OperationContext* txn,
+                               Collection* collection,
+                               const BSONObj& keyPattern,
+                               const BSONObj& min,
+                               const BSONObj& max,
+                               long long keyCount,
+                               long long maxSplitPoints,
+                               int sampleSize,
+                               vector<BSONObj>* splitKeys) {
+            ShardKeyPattern shardKeyPattern(keyPattern);
+            if (!shardKeyPattern.isValid()) {
+                return false;
+            }
+
+            vector<RecordData> samples;
+            if (!collection->getRecordStore()->sampleRecords(txn, sampleSize, &samples) ||
+                    samples.empty()) {
+                return false;
+            }
+
+            vector<BSONObj> keys;
+            for (vector<RecordData>::const_iterator it = samples.begin();
+                 it != samples.end();
+                 ++it) {
+                BSONObj key = shardKeyPattern.extractShardKeyFromDoc(it->toBson());
+                if (key.isEmpty()) {
+                    // Documents without a shard key sort as null in the index
+                    return false;
+                }
+
+                if ((min.isEmpty() || key.woCompare(min) >= 0) &&
+                        (max.isEmpty() || key.woCompare(max) < 0)) {
+                    keys.push_back(key.getOwned());
+                }
+            }
+
+            if (keys.size() < kMinSampledKeysInChunk) {
+                return false;
+            }
+
+            std::sort(keys.begin(), keys.end(), BSONObjCmp());
+
+            // The walk picks the key after every 'keyCount' keys, skipping the first key of the
+            // chunk and repeats of the last split key. In the collection, every sampled document
+            // stands for numRecords / samples.size() documents.
+            const double keysPerSample =
+                static_cast<double>(collection->numRecords(txn)) / samples.size();
+
+            for (long long n = 1; ; n++) {
+                if (maxSplitPoints && static_cast<long long>(splitKeys->size()) >= maxSplitPoints) {
+                    break;
+                }
+
+                const size_t i = static_cast<size_t>(n * (keyCount + 1) / keysPerSample);
+                if (i >= keys.size()) {
+                    break;
+                }
+
+                const BSONObj& key = keys[i];
+                if (key.woCompare(keys.front()) == 0 ||
+                        (!splitKeys->empty() && key.woCompare(splitKeys->back()) == 0)) {
+                    continue;
+                }
+
+                splitKeys->push_back(key);
+            }
+
+            return true;
+        }
+
+    } // namespace
+
     class SplitVector : public Command {
     public:
         SplitVector() : Command( "splitVector" , false ) {}
@@ -224,6 +315,7 @@ namespace mongo {
                  "  { splitVector : \"blog.post\" , keyPattern:{x:1} , min:{x:10} , max:{x:20}, maxChunkSize:200 }\n"
                  "  maxChunkSize unit in MBs\n"
                  "  May optionally specify 'maxSplitPoints' and 'maxChunkObjects' to avoid traversing the whole chunk\n"
+                 "  May optionally specify 'sampleSize' to estimate the split points from that many random documents\n"
                  "  \n"
                  "  { splitVector : \"blog.post\" , keyPattern:{x:1} , min:{x:10} , max:{x:20}, force: true }\n"
                  "  'force' will produce one split point even if data is small; defaults to false\n"
@@ -277,6 +369,17 @@ namespace mongo {
                 maxChunkObjects = MaxChunkObjectsElem.numberLong();
             }
 
+            // If set, split points are estimated from this many random documents when possible
+            int sampleSize = 0;
+            BSONElement sampleSizeElem = jsobj[ "sampleSize" ];
+            if ( sampleSizeElem.isNumber() ) {
+                sampleSize = std::min( sampleSizeElem.numberInt(), kMaxSplitVectorSampleSize );
+            }
+
+            // The bounds of the chunk in shard key format, for the sampled documents
+            const BSONObj chunkMin = min;
+            const BSONObj chunkMax = max;
+
             vector<BSONObj> splitKeys;
 
             {
@@ -372,13 +475,37 @@ namespace mongo {
                     keyCount = maxChunkObjects;
                 }
                 
+                Timer timer;
+
                 //
-                // 2. Traverse the index and add the keyCount-th key to the result vector. If that key
-                //    appeared in the vector before, we omit it. The invariant here is that all the
-                //    instances of a given key value live in the same chunk.
+                // 2.a If asked to, estimate the split points from a random sample of the documents
+                //     instead of walking the index. The cost doesn't grow with the chunk then.
+                //
+
+                if ( sampleSize > 0 && !forceMedianSplit ) {
+                    if ( sampleSplitPoints( txn, collection, keyPattern, chunkMin, chunkMax,
+                                            keyCount, maxSplitPoints, sampleSize, &splitKeys ) ) {
+                        LOG(1) << "estimated " << splitKeys.size() << " split points for chunk "
+                               << ns << " " << min << " -->> " << max << " from a sample of "
+                               << sampleSize << " documents" << endl;
+
+                        result.append( "timeMillis", timer.millis() );
+                        result.appendBool( "sampled", true );
+                        result.append( "splitKeys" , splitKeys );
+                        return true;
+                    }
+
+                    LOG(1) << "could not estimate split points from a sample, walking the index"
+                           << endl;
+                    splitKeys.clear();
+                }
+
+                //
+                // 2.b Traverse the index and add the keyCount-th key to the result vector. If that key
+                //     appeared in the vector before, we omit it. The invariant here is that all the
+                //     instances of a given key value live in the same chunk.
                 //
                 
-                Timer timer;
                 long long currCount = 0;
                 long long numChunks = 0;
                 
@@ -39,6 +39,8 @@
 #include "mongo/s/write_ops/batched_command_request.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/socket_poll.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -50,6 +52,7 @@ namespace mongo {
         endpoint( endpoint ),
         dbName( dbName.toString() ),
         cmdObj( cmdObj ),
+        sent( false ),
         conn( NULL ),
         status( Status::OK() ) {
     }
@@ -85,9 +88,9 @@ namespace mongo {
         }
     }
 
-    // THROWS
-    static void sayAsCmd( DBClientBase* conn, const StringData& dbName, const BSONObj& cmdObj ) {
-        Message toSend;
+    static void buildCmdMessage( const StringData& dbName,
+                                 const BSONObj& cmdObj,
+                                 Message* toSend ) {
         BSONObjBuilder usersBuilder;
         usersBuilder.appendElements(cmdObj);
         audit::appendImpersonatedUsers(&usersBuilder);
@@ -99,7 +102,13 @@ namespace mongo {
         bufB.appendNum( 0 ); // ntoskip (0 for command)
         bufB.appendNum( 1 ); // ntoreturn (1 for command)
         usersBuilder.obj().appendSelfToBufBuilder( bufB );
-        toSend.setData( dbQuery, bufB.buf(), bufB.len() );
+        toSend->setData( dbQuery, bufB.buf(), bufB.len() );
+    }
+
+    // THROWS
+    static void sayAsCmd( DBClientBase* conn, const StringData& dbName, const BSONObj& cmdObj ) {
+        Message toSend;
+        buildCmdMessage( dbName, cmdObj, &toSend );
 
         // Send our command
         conn->say( toSend );
@@ -125,8 +134,28 @@ namespace mongo {
             it != _pendingCommands.end(); ++it ) {
 
             PendingCommand* command = *it;
+            if ( command->sent ) continue;
+
+            // Commands may be added and sent while earlier ones are still in flight
+            command->sent = true;
             dassert( NULL == command->conn );
 
+            if ( useAsyncShardConnectionPool ) {
+                try {
+                    Message toSend;
+                    buildCmdMessage( command->dbName, command->cmdObj, &toSend );
+                    command->asyncRequest = asyncShardConnectionPool.sendCommand(
+                        command->endpoint,
+                        isBatchWriteCommand( command->cmdObj ) ? BATCH_COMMANDS
+                                                               : RELEASE_2_4_AND_BEFORE,
+                        toSend );
+                }
+                catch ( const DBException& ex ) {
+                    command->status = ex.toStatus();
+                }
+                continue;
+            }
+
             try {
                 dassert( command->endpoint.type() == ConnectionString::MASTER ||
                     command->endpoint.type() == ConnectionString::CUSTOM );
@@ -169,14 +198,90 @@ namespace mongo {
         return static_cast<int>( _pendingCommands.size() );
     }
 
+    DBClientMultiCommand::PendingQueue::iterator DBClientMultiCommand::_waitForReady() {
+
+        // How often to look again at replies which can't be polled for on a socket
+        const int kPollIntervalMillis = 10;
+
+        dassert( !_pendingCommands.empty() );
+        if ( _pendingCommands.size() == 1 || !isPollSupported() ) {
+            return _pendingCommands.begin();
+        }
+
+        const long long startMillis = curTimeMillis64();
+        while ( true ) {
+
+            vector<pollfd> pollFDs;
+            vector<PendingQueue::iterator> polled;
+            bool hasAsync = false;
+
+            for ( PendingQueue::iterator it = _pendingCommands.begin();
+                it != _pendingCommands.end(); ++it ) {
+
+                PendingCommand* command = *it;
+                dassert( command->sent );
+                if ( !command->status.isOK() ) return it;
+
+                if ( command->asyncRequest ) {
+                    if ( command->asyncRequest->isDone() ) return it;
+                    hasAsync = true;
+                    continue;
+                }
+
+                // Nothing to poll on, so just block on this one
+                DBClientConnection* conn = dynamic_cast<DBClientConnection*>( command->conn );
+                if ( NULL == conn ) return it;
+
+                pollfd pfd;
+                pfd.fd = conn->port().psock->rawFD();
+                pfd.events = POLLIN;
+                pfd.revents = 0;
+                pollFDs.push_back( pfd );
+                polled.push_back( it );
+            }
+
+            // Once past the timeout, block on the oldest command so its recv times out
+            if ( _timeoutMillis > 0 && curTimeMillis64() - startMillis > _timeoutMillis ) {
+                return _pendingCommands.begin();
+            }
+
+            int timeout = hasAsync || _timeoutMillis > 0 ? kPollIntervalMillis : -1;
+            if ( pollFDs.empty() ) {
+                sleepmillis( timeout );
+                continue;
+            }
+
+            int ready = socketPoll( &pollFDs[0], pollFDs.size(), timeout );
+            if ( ready < 0 ) return _pendingCommands.begin();
+
+            for ( size_t i = 0; ready > 0 && i < pollFDs.size(); ++i ) {
+                if ( pollFDs[i].revents != 0 ) return polled[i];
+            }
+        }
+    }
+
     Status DBClientMultiCommand::recvAny( ConnectionString* endpoint, BSONSerializable* response ) {
 
-        scoped_ptr<PendingCommand> command( _pendingCommands.front() );
-        _pendingCommands.pop_front();
+        // Take whichever response comes back first, so one slow host doesn't hold up the rest
+        PendingQueue::iterator ready = _waitForReady();
+        scoped_ptr<PendingCommand> command( *ready );
+        _pendingCommands.erase( ready );
 
         *endpoint = command->endpoint;
         if ( !command->status.isOK() ) return command->status;
 
+        if ( command->asyncRequest ) {
+            BSONObj result;
+            Status status = command->asyncRequest->wait( _timeoutMillis, &result );
+            if ( !status.isOK() ) return status;
+
+            string errMsg;
+            if ( !response->parseBSON( result, &errMsg ) || !response->isValid( &errMsg ) ) {
+                return Status( ErrorCodes::FailedToParse, errMsg );
+            }
+            return Status::OK();
+        }
+
         dassert( NULL != command->conn );
 
         try {
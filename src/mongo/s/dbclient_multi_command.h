@@ -31,6 +31,7 @@
 #include <deque>
 
 #include "mongo/bson/bsonobj.h"
+#include "mongo/s/async_shard_connection_pool.h"
 #include "mongo/s/multi_command_dispatch.h"
 
 namespace mongo {
@@ -74,14 +75,24 @@ namespace mongo {
             const std::string dbName;
             const BSONObj cmdObj;
 
+            // Whether sendAll() has dealt with it yet
+            bool sent;
+
             // Where to send it
             DBClientBase* conn;
 
+            // Set instead of conn when sent through the asyncShardConnectionPool
+            AsyncShardConnectionPool::RequestPtr asyncRequest;
+
             // If anything goes wrong
             Status status;
         };
 
         typedef std::deque<PendingCommand*> PendingQueue;
+
+        // Returns the sent command whose response can be received soonest
+        PendingQueue::iterator _waitForReady();
+
         PendingQueue _pendingCommands;
         int _timeoutMillis;
     };
@@ -102,6 +102,9 @@ namespace mongo {
     class DistributedLockPinger {
     public:
 
+        // Number of pings between sweeps of old lockpings entries
+        static const int kPingsPerCleanup = 10;
+
         DistributedLockPinger()
             : _mutex( "DistributedLockPinger" ) {
         }
@@ -119,6 +122,7 @@ namespace mongo {
                                                << " (sleeping for " << sleepTime << "ms)" << endl;
 
             static int loops = 0;
+            int pingsSinceCleanup = 0;
             Date_t lastPingTime = jsTime();
             while( ! inShutdown() && ! shouldKill( addr, process ) ) {
 
@@ -161,43 +165,47 @@ namespace mongo {
                     // and no new instance came up to replace it for a quite a while.
                     // NOTE this is NOT the same as the standard take-over mechanism, which forces
                     // the lock entry.
-                    BSONObj fieldsToReturn = BSON( LocksType::state() << 1 <<
-                                                   LocksType::process() << 1 );
-                    auto_ptr<DBClientCursor> activeLocks =
-                        conn->query( LocksType::ConfigNS,
-                                     BSON( LocksType::state() << GT << 0 ) );
-
-                    uassert( 16060,
-                             str::stream() << "cannot query locks collection on config server "
-                                           << conn.getHost(),
-                             activeLocks.get() );
-
-                    set<string> pids;
-                    while ( activeLocks->more() ) {
-                        BSONObj lock = activeLocks->nextSafe();
-
-                        if ( !lock[LocksType::process()].eoo() ) {
-                            pids.insert( lock[LocksType::process()].str() );
-                        }
-                        else {
-                            warning() << "found incorrect lock document during lock ping cleanup: "
-                                      << lock.toString() << endl;
+                    // Entries only go after four days, so most pings renew with the single
+                    // update above and leave the scan of the locks collection for later.
+                    if ( pingsSinceCleanup++ % kPingsPerCleanup == 0 ) {
+                        BSONObj fieldsToReturn = BSON( LocksType::state() << 1 <<
+                                                       LocksType::process() << 1 );
+                        auto_ptr<DBClientCursor> activeLocks =
+                            conn->query( LocksType::ConfigNS,
+                                         BSON( LocksType::state() << GT << 0 ) );
+
+                        uassert( 16060,
+                                 str::stream() << "cannot query locks collection on config server "
+                                               << conn.getHost(),
+                                 activeLocks.get() );
+
+                        set<string> pids;
+                        while ( activeLocks->more() ) {
+                            BSONObj lock = activeLocks->nextSafe();
+
+                            if ( !lock[LocksType::process()].eoo() ) {
+                                pids.insert( lock[LocksType::process()].str() );
+                            }
+                            else {
+                                warning() << "found incorrect lock document during lock ping cleanup: "
+                                          << lock.toString() << endl;
+                            }
                         }
-                    }
 
-                    Date_t fourDays = pingTime - ( 4 * 86400 * 1000 ); // 4 days
-                    conn->remove( LockpingsType::ConfigNS,
-                                  BSON( LockpingsType::process() << NIN << pids <<
-                                        LockpingsType::ping() << LT << fourDays ) );
-                    err = conn->getLastError();
-                    if ( ! err.empty() ) {
-                        warning() << "ping cleanup for distributed lock pinger '" << pingId << " failed."
-                                  << causedBy( err ) << endl;
-                        conn.done();
-
-                        // Sleep for normal ping time
-                        sleepmillis(sleepTime);
-                        continue;
+                        Date_t fourDays = pingTime - ( 4 * 86400 * 1000 ); // 4 days
+                        conn->remove( LockpingsType::ConfigNS,
+                                      BSON( LockpingsType::process() << NIN << pids <<
+                                            LockpingsType::ping() << LT << fourDays ) );
+                        err = conn->getLastError();
+                        if ( ! err.empty() ) {
+                            warning() << "ping cleanup for distributed lock pinger '" << pingId << " failed."
+                                      << causedBy( err ) << endl;
+                            conn.done();
+
+                            // Sleep for normal ping time
+                            sleepmillis(sleepTime);
+                            continue;
+                        }
                     }
 
                     LOG( DistributedLock::logLvl - ( loops % 10 == 0 ? 1 : 0 ) ) << "cluster " << addr << " pinged successfully at " << pingTime
@@ -625,6 +633,60 @@ namespace mongo {
 
         ScopedDbConnection conn(_conn.toString(), timeout );
 
+        // Fast path: a lock nobody holds is taken and finalized with one conditional update,
+        // which also bumps the lock's lease term. On consistent config servers this is the same
+        // as the state 1 then state 2 updates below. A missing or held lock document goes
+        // through the full protocol.
+        if ( !reenter ) {
+
+            BSONObj lockDetails = BSON( LocksType::state(2)
+                    << LocksType::who(getDistLockId())
+                    << LocksType::process(_processId)
+                    << "when" << jsTime()
+                    << LocksType::why(why)
+                    << LocksType::lockID(OID::gen()) );
+
+            BSONObjBuilder ourLockBuilder;
+            ourLockBuilder.append( LocksType::name(), _name );
+            ourLockBuilder.appendElements( lockDetails );
+            BSONObj ourLock = ourLockBuilder.obj();
+
+            string lockName = _name + string("/") + _processId;
+
+            try {
+                conn->update( LocksType::ConfigNS,
+                              BSON( LocksType::name(_name) << LocksType::state(0) ),
+                              BSON( "$set" << lockDetails << "$inc" << BSON( "term" << 1 ) ) );
+
+                BSONObj err = conn->getLastErrorDetailed();
+                string errMsg = DBClientWithCommands::getLastErrorString(err);
+
+                if ( errMsg.empty() && err["n"].type() && err["n"].numberInt() >= 1 ) {
+                    resetLastPing();
+                    *other = ourLock;
+                    LOG( logLvl - 1 ) << "distributed lock '" << lockName << "' acquired, ts : "
+                                      << lockDetails[LocksType::lockID()].OID() << endl;
+                    conn.done();
+                    return true;
+                }
+            }
+            catch( UpdateNotTheSame& up ) {
+
+                // Only some config servers took the lock, so it isn't held. Undo it where it was
+                // set; other processes can't take those over until the lock times out otherwise.
+                warning() << "distributed lock '" << lockName << "' did not propagate properly, "
+                          << "releasing it" << causedBy( up ) << endl;
+                conn.done();
+                unlock( &ourLock );
+                return false;
+            }
+            catch( std::exception& e ) {
+                conn.done();
+                throw LockException( str::stream() << "exception creating distributed lock "
+                                     << lockName << causedBy( e ), 13663 );
+            }
+        }
+
         BSONObjBuilder queryBuilder;
         queryBuilder.append( LocksType::name() , _name );
         queryBuilder.append( LocksType::state() , 0 );
@@ -873,7 +935,7 @@ namespace mongo {
                 << "when" << jsTime()
                 << LocksType::why(why)
                 << LocksType::lockID(OID::gen()) );
-        BSONObj whatIWant = BSON( "$set" << lockDetails );
+        BSONObj whatIWant = BSON( "$set" << lockDetails << "$inc" << BSON( "term" << 1 ) );
 
         BSONObj query = queryBuilder.obj();
 
@@ -103,6 +103,10 @@ namespace mongo {
      * 0 -> 1
      * 1 -> 2
      * 2 -> 0
+     * 0 -> 2 (uncontended, with a single conditional update)
+     *
+     * Every time the lock is taken its "term" field is incremented, so each holder of a lock
+     * has a distinct, increasing lease term.
      *
      * Note that at any point in time, a lock can be force unlocked if the ping for the lock
      * becomes too stale.
@@ -41,6 +41,7 @@
 #include "mongo/client/replica_set_monitor.h"
 #include "mongo/db/json.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/s/cluster_write.h"
 #include "mongo/s/grid.h"
@@ -59,6 +60,10 @@ namespace mongo {
 
     MONGO_FP_DECLARE(neverBalance);
 
+    // How long mongos trusts its copy of a config.settings or config.collections document before
+    // reading it again; 0 reads the config servers every time.
+    MONGO_EXPORT_SERVER_PARAMETER(configMetadataCacheSecs, int, 10);
+
     DBConfigPtr Grid::getDBConfig( const StringData& ns , bool create , const string& shardNameHint ) {
         string database = nsToDatabase( ns );
 
@@ -534,10 +539,20 @@ namespace mongo {
     }
 
     bool Grid::getConfigShouldBalance() const {
+        BSONObj balancerDoc;
+
+        try {
+            balancerDoc = findCachedConfigDoc(SettingsType::ConfigNS, "balancer");
+        }
+        catch (const DBException& ex) {
+            warning() << "failed to read balancer settings: " << causedBy(ex);
+            return false;
+        }
+
         SettingsType balSettings;
         string errMsg;
 
-        if (!getBalancerSettings(&balSettings, &errMsg)) {
+        if (!balSettings.parseBSON(balancerDoc, &errMsg)) {
             warning() << errMsg;
             return false;
         }
@@ -552,16 +567,13 @@ namespace mongo {
 
     bool Grid::getCollShouldBalance(const std::string& ns) const {
         BSONObj collDoc;
-        ScopedDbConnection conn(configServer.getPrimary().getConnString(), 30);
 
         try {
-            collDoc = conn->findOne(CollectionType::ConfigNS, BSON(CollectionType::ns(ns)));
-            conn.done();
+            collDoc = findCachedConfigDoc(CollectionType::ConfigNS, ns);
         }
         catch (const DBException& e){
-            conn.kill();
             warning() << "could not determine whether balancer should be running, error getting"
-                      << "config data from " << conn.getHost() << causedBy(e) << endl;
+                      << " config data" << causedBy(e) << endl;
             // if anything goes wrong, we shouldn't try balancing
             return false;
         }
@@ -624,17 +636,61 @@ namespace mongo {
     }
 
     void Grid::flushConfig() {
-        scoped_lock lk( _lock );
-        _databases.clear();
+        {
+            scoped_lock lk( _lock );
+            _databases.clear();
+        }
+        invalidateConfigDocs();
     }
 
     BSONObj Grid::getConfigSetting( const std::string& name ) const {
+        return findCachedConfigDoc( SettingsType::ConfigNS, name );
+    }
+
+    BSONObj Grid::findCachedConfigDoc( const std::string& ns, const std::string& id ) const {
+        const ConfigDocMap::key_type key( ns, id );
+        const long long maxAgeMillis = configMetadataCacheSecs * 1000LL;
+        unsigned long long version;
+
+        {
+            scoped_lock lk( _configDocsLock );
+            ConfigDocMap::const_iterator it = _configDocs.find( key );
+            if ( it != _configDocs.end() &&
+                 curTimeMillis64() - it->second.fetchedMillis < maxAgeMillis ) {
+                return it->second.doc;
+            }
+            version = _configDocsVersion;
+        }
+
         ScopedDbConnection conn(configServer.getPrimary().getConnString(), 30);
-        BSONObj result = conn->findOne( SettingsType::ConfigNS,
-                                        BSON( SettingsType::key(name) ) );
+        BSONObj doc = conn->findOne( ns, BSON( "_id" << id ) ).getOwned();
         conn.done();
 
-        return result;
+        if ( maxAgeMillis > 0 ) {
+            scoped_lock lk( _configDocsLock );
+            if ( version == _configDocsVersion ) {
+                CachedConfigDoc& cached = _configDocs[key];
+                cached.doc = doc;
+                cached.fetchedMillis = curTimeMillis64();
+            }
+        }
+
+        return doc;
+    }
+
+    void Grid::invalidateConfigDocs( const std::string& ns ) {
+        scoped_lock lk( _configDocsLock );
+        _configDocsVersion++;
+
+        if ( ns.empty() ) {
+            _configDocs.clear();
+            return;
+        }
+
+        ConfigDocMap::iterator it = _configDocs.lower_bound( make_pair( ns, string() ) );
+        while ( it != _configDocs.end() && it->first.first == ns ) {
+            _configDocs.erase( it++ );
+        }
     }
 
     Grid grid;
@@ -46,7 +46,8 @@ namespace mongo {
      */
     class Grid {
     public:
-        Grid() : _lock( "Grid" ) , _allowLocalShard( true ) { }
+        Grid() : _lock( "Grid" ) , _allowLocalShard( true ) ,
+                 _configDocsLock( "Grid::configDocs" ) , _configDocsVersion( 0 ) { }
 
         /**
          * gets the config the db.
@@ -141,6 +142,19 @@ namespace mongo {
          */
         BSONObj getConfigSetting( const std::string& name ) const;
 
+        /**
+         * Returns the document with _id 'id' in the config collection 'ns', or an empty object if
+         * there is none.  A local copy is used if it was read less than configMetadataCacheSecs
+         * ago and nothing invalidated it since.  THROWS if the config server can't be read.
+         */
+        BSONObj findCachedConfigDoc( const std::string& ns, const std::string& id ) const;
+
+        /**
+         * Drops the local copies of the documents of config collection 'ns', or of every config
+         * collection if 'ns' is empty, so that the next lookup reads the config servers.
+         */
+        void invalidateConfigDocs( const std::string& ns = "" );
+
         unsigned long long getNextOpTime() const;
         
         void flushConfig();
@@ -159,6 +173,18 @@ namespace mongo {
         std::map<std::string, DBConfigPtr > _databases;       // maps ns to DBConfig's
         bool                      _allowLocalShard; // can 'localhost' be used in shard addresses?
 
+        struct CachedConfigDoc {
+            BSONObj doc;                // owned; empty if there was no such document
+            long long fetchedMillis;    // when it was read from the config server
+        };
+        typedef std::map<std::pair<std::string, std::string>, CachedConfigDoc> ConfigDocMap;
+
+        mutable mongo::mutex _configDocsLock;   // protects the two members below
+        mutable ConfigDocMap _configDocs;       // maps (ns, _id) to the last document read
+
+        // Bumped by every invalidation, so that a read racing with one isn't cached
+        unsigned long long _configDocsVersion;
+
         /**
          * @param name is the chose name for the shard. Parameter is mandatory.
          * @return true if it managed to generate a shard name. May return false if (currently)
@@ -65,6 +65,9 @@ namespace mongo {
          * without waiting for responses.  May block on full send queue (though this should be
          * rare).
          *
+         * Commands may be added and sent again while earlier commands are still pending; only
+         * those not yet sent are sent.
+         *
          * Any error which occurs during sendAll will be reported on recvAny, *does not throw.*
          */
         virtual void sendAll() = 0;
@@ -40,6 +40,7 @@
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/latency_histogram.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/client_info.h"
 #include "mongo/s/config.h"
@@ -136,6 +137,8 @@ namespace mongo {
             // globalOpCounters are handled by write commands.
         }
 
+        globalOpLatencyStats.record( op, iscmd, t.micros() );
+
         LOG(3) << "Request::process end ns: " << getns()
                << " msg id: " << msgId
                << " op: " << op
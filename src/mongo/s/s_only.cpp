@@ -147,6 +147,7 @@ namespace mongo {
 
         std::string errmsg;
         bool ok;
+        Timer runTimer;
         try {
             ok = c->run( txn, dbname , cmdObj, queryOptions, errmsg, result, false );
         }
@@ -154,6 +155,7 @@ namespace mongo {
             ok = false;
             int code = e.getCode();
             if (code == RecvStaleConfigCode) { // code for StaleConfigException
+                c->_latency.record( runTimer.micros() );
                 throw;
             }
 
@@ -163,6 +165,8 @@ namespace mongo {
             result.append( "code" , code );
         }
 
+        c->_latency.record( runTimer.micros() );
+
         if ( !ok ) {
             c->_commandsFailed.increment();
         }
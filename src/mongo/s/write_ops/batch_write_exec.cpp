@@ -32,6 +32,8 @@
 
 #include "mongo/s/write_ops/batch_write_exec.h"
 
+#include <boost/scoped_ptr.hpp>
+
 #include "mongo/base/error_codes.h"
 #include "mongo/base/owned_pointer_map.h"
 #include "mongo/base/status.h"
@@ -43,6 +45,8 @@
 
 namespace mongo {
 
+    using boost::scoped_ptr;
+
     BatchWriteExec::BatchWriteExec( NSTargeter* targeter,
                                     ShardResolver* resolver,
                                     MultiCommandDispatch* dispatcher ) :
@@ -151,21 +155,31 @@ namespace mongo {
             //
             // Send all child batches
             //
+            // Each host has at most one child batch in flight; batches for a busy host wait
+            // until its response is in.  Unordered batches also stream: once every targeted
+            // batch is out, each response prompts targeting the remaining writes again, so the
+            // shard that answered gets its next batch right away instead of waiting for the
+            // slowest shard of the round.
+            //
+
+            const bool streaming = !clientRequest.getOrdered();
+            bool stopStreaming = !targetStatus.isOK();
 
             size_t numSent = 0;
             size_t numToSend = childBatches.size();
             bool remoteMetadataChanging = false;
-            while ( numSent != numToSend ) {
 
-                // Collect batches out on the network, mapped by endpoint
-                OwnedHostBatchMap ownedPendingBatches;
-                OwnedHostBatchMap::MapType& pendingBatches = ownedPendingBatches.mutableMap();
+            // Collect batches out on the network, mapped by endpoint
+            OwnedHostBatchMap ownedPendingBatches;
+            OwnedHostBatchMap::MapType& pendingBatches = ownedPendingBatches.mutableMap();
+
+            while ( numSent != numToSend || !pendingBatches.empty() ) {
 
                 //
                 // Send side
                 //
 
-                // Get as many batches as we can at once
+                // Send every batch whose host has nothing in flight
                 for ( vector<TargetedWriteBatch*>::iterator it = childBatches.begin();
                     it != childBatches.end(); ++it ) {
 
@@ -231,6 +245,7 @@ namespace mongo {
                     // endpoints for the same host, so this should be pretty efficient without
                     // moving stuff around.
                     *it = NULL;
+                    ++numSent;
 
                     // Recv-side is responsible for cleaning up the nextBatch when used
                     pendingBatches.insert( make_pair( shardHost, nextBatch ) );
@@ -238,22 +253,28 @@ namespace mongo {
 
                 // Send them all out
                 _dispatcher->sendAll();
-                numSent += pendingBatches.size();
+
+                if ( pendingBatches.empty() ) {
+                    // Nothing could be sent
+                    dassert( numSent == numToSend );
+                    break;
+                }
 
                 //
                 // Recv side
                 //
 
-                while ( _dispatcher->numPending() > 0 ) {
-
+                {
                     // Get the response
                     ConnectionString shardHost;
                     BatchedCommandResponse response;
                     Status dispatchStatus = _dispatcher->recvAny( &shardHost, &response );
 
                     // Get the TargetedWriteBatch to find where to put the response
-                    dassert( pendingBatches.find( shardHost ) != pendingBatches.end() );
-                    TargetedWriteBatch* batch = pendingBatches.find( shardHost )->second;
+                    OwnedHostBatchMap::MapType::iterator pendingIt = pendingBatches.find( shardHost );
+                    dassert( pendingIt != pendingBatches.end() );
+                    scoped_ptr<TargetedWriteBatch> batch( pendingIt->second );
+                    pendingBatches.erase( pendingIt );
 
                     if ( dispatchStatus.isOK() ) {
 
@@ -273,6 +294,9 @@ namespace mongo {
                         if ( staleErrors.size() > 0 ) {
                             noteStaleResponses( staleErrors, _targeter );
                             ++_stats->numStaleBatches;
+
+                            // Retarget only after the targeter has been refreshed
+                            stopStreaming = true;
                         }
 
                         // Remember if the shard is actively changing metadata right now
@@ -307,6 +331,27 @@ namespace mongo {
                         batchOp.noteBatchError( *batch, error );
                     }
                 }
+
+                //
+                // Streaming: target the writes not yet sent once all targeted batches are out
+                //
+
+                if ( streaming && !stopStreaming && numSent == numToSend ) {
+
+                    const size_t numTargeted = childBatches.size();
+                    Status retargetStatus = batchOp.targetBatch( *_targeter,
+                                                                 recordTargetErrors,
+                                                                 &childBatches );
+                    if ( !retargetStatus.isOK() ) {
+                        // Leave the rest to the next round, after a targeter refresh
+                        _targeter->noteCouldNotTarget();
+                        refreshedTargeter = true;
+                        ++_stats->numTargetErrors;
+                        stopStreaming = true;
+                    }
+
+                    numToSend += childBatches.size() - numTargeted;
+                }
             }
 
             ++rounds;
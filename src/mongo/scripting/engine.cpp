@@ -38,11 +38,15 @@
 #include <boost/scoped_array.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/platform/unordered_set.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/exit.h"
 #include "mongo/util/file.h"
 #include "mongo/util/log.h"
 #include "mongo/util/text.h"
@@ -299,12 +303,21 @@ namespace {
     }
 
 namespace {
+    /**
+     * Keeps recently used scopes for reuse by later operations on the same pool, so they don't
+     * pay for creating a scope or for recompiling functions the scope has already compiled.
+     *
+     * Once pooled scopes are in demand, a background thread also keeps up to one freshly created
+     * scope per scope in use (at most kMaxPrewarmedScopes), which operations that find no scope
+     * for their pool take instead of creating one themselves.
+     */
     class ScopeCache {
     public:
-        ScopeCache() : _mutex("ScopeCache") {}
+        ScopeCache() : _mutex("ScopeCache"), _inUse(0), _prewarming(false) {}
 
         void release(const string& poolName, const boost::shared_ptr<Scope>& scope) {
             scoped_lock lk(_mutex);
+            --_inUse;
 
             if (scope->hasOutOfMemoryException()) {
                 // make some room
@@ -346,18 +359,91 @@ namespace {
             return boost::shared_ptr<Scope>();
         }
 
+        /**
+         * Returns a scope that has never been used, if the prewarming thread has one ready.
+         */
+        boost::shared_ptr<Scope> tryAcquirePrewarmed(OperationContext* txn) {
+            scoped_lock lk(_mutex);
+
+            if (!_prewarming) {
+                boost::thread t(&ScopeCache::_prewarmScopes, this);
+                _prewarming = true;
+            }
+            _prewarmNeeded.notify_one();
+
+            if (_prewarmed.empty()) {
+                return boost::shared_ptr<Scope>();
+            }
+
+            boost::shared_ptr<Scope> scope = _prewarmed.front();
+            _prewarmed.pop_front();
+            scope->registerOperation(txn);
+            return scope;
+        }
+
+        /**
+         * Records that a pooled scope was handed out; release() records its return.
+         */
+        void noteAcquired() {
+            scoped_lock lk(_mutex);
+            ++_inUse;
+        }
+
     private:
         struct ScopeAndPool {
             boost::shared_ptr<Scope> scope;
             string poolName;
         };
 
+        int _prewarmTarget_inlock() const {
+            if (_inUse <= 1) {
+                return 1;
+            }
+            return _inUse < kMaxPrewarmedScopes ? _inUse : kMaxPrewarmedScopes;
+        }
+
+        void _prewarmScopes() {
+            setThreadName("ScopePrewarmer");
+            scoped_lock lk(_mutex);
+            while (!inShutdown()) {
+                if (static_cast<int>(_prewarmed.size()) >= _prewarmTarget_inlock()) {
+                    _prewarmNeeded.wait(lk.boost());
+                    continue;
+                }
+
+                boost::shared_ptr<Scope> scope;
+                {
+                    // Scope creation is the slow part, so don't hold up other operations on it.
+                    lk.boost().unlock();
+                    try {
+                        scope.reset(globalScriptEngine->newScope());
+                    }
+                    catch (const std::exception& e) {
+                        warning() << "Failed to create a JS scope ahead of time: " << e.what();
+                    }
+                    lk.boost().lock();
+                }
+                if (!scope) {
+                    // Leave creating scopes to the operations that need them
+                    _prewarming = false;
+                    return;
+                }
+                _prewarmed.push_back(scope);
+            }
+        }
+
         // Note: if these numbers change, reconsider choice of datastructure for _pools
         static const unsigned kMaxPoolSize = 10;
         static const int kMaxScopeReuse = 10;
 
+        static const int kMaxPrewarmedScopes = 4;
+
         typedef deque<ScopeAndPool> Pools; // More-recently used Scopes are kept at the front.
         Pools _pools;    // protected by _mutex
+        deque<boost::shared_ptr<Scope> > _prewarmed;  // protected by _mutex
+        int _inUse;  // protected by _mutex
+        bool _prewarming;  // protected by _mutex
+        boost::condition _prewarmNeeded;
         mongo::mutex _mutex;
     };
 
@@ -369,7 +455,7 @@ namespace {
         PooledScope(const std::string& pool, const boost::shared_ptr<Scope>& real)
             : _pool(pool)
             , _real(real) {
-
+            scopeCache.noteAcquired();
         }
 
         virtual ~PooledScope() {
@@ -450,6 +536,9 @@ namespace {
                                                  const string& scopeType) {
         const string fullPoolName = db + scopeType;
         boost::shared_ptr<Scope> s = scopeCache.tryAcquire(txn, fullPoolName);
+        if (!s) {
+            s = scopeCache.tryAcquirePrewarmed(txn);
+        }
         if (!s) {
             s.reset(newScope());
             s->registerOperation(txn);
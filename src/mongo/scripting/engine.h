@@ -31,11 +31,12 @@
 
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/platform/unordered_map.h"
 
 namespace mongo {
     typedef unsigned long long ScriptingFunction;
     typedef BSONObj (*NativeFunction)(const BSONObj& args, void* data);
-    typedef std::map<std::string, ScriptingFunction> FunctionCacheMap;
+    typedef unordered_map<std::string, ScriptingFunction> FunctionCacheMap;
 
     class DBClientWithCommands;
     class DBClientBase;
@@ -886,7 +886,7 @@ namespace mongo {
             // find the source script based on the resource name supplied to v8::Script::Compile().
             // this is accomplished by converting the integer after the '_funcs' prefix.
             unsigned int funcNum = str::toUnsigned(resourceNameString.substr(6));
-            for (map<string, ScriptingFunction>::iterator it = getFunctionCache().begin();
+            for (FunctionCacheMap::iterator it = getFunctionCache().begin();
                  it != getFunctionCache().end();
                  ++it) {
                 if (it->second == funcNum) {
@@ -39,6 +39,8 @@
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #include "mongo/db/namespace_string.h"
@@ -92,6 +94,97 @@ namespace mongo {
         _totalTimeMicros += other._totalTimeMicros;
     }
 
+    namespace {
+        // Values below this have a bucket each; above it, each power of two is split into
+        // kSubBuckets buckets.
+        const long long kExactBelow = 32;
+        const int kSubBucketBits = 4;
+        const long long kSubBuckets = 1 << kSubBucketBits;
+        const int kFirstSplitPower = 5; // log2(kExactBelow)
+        const size_t kNumBuckets = kExactBelow + (63 - kFirstSplitPower) * kSubBuckets;
+    }  // namespace
+
+    BenchRunHistogram::BenchRunHistogram() {
+        reset();
+    }
+
+    void BenchRunHistogram::reset() {
+        _buckets.assign(kNumBuckets, 0);
+        _count = 0;
+        _totalMicros = 0;
+        _maxMicros = 0;
+    }
+
+    size_t BenchRunHistogram::bucketFor(long long micros) {
+        if (micros < kExactBelow) {
+            return std::max(micros, 0LL);
+        }
+
+        int power = kFirstSplitPower;
+        while ((micros >> (power + 1)) > 0) {
+            power++;
+        }
+
+        // The top kSubBucketBits + 1 bits of micros, less the leading one.
+        const long long subBucket = (micros >> (power - kSubBucketBits)) - kSubBuckets;
+        return kExactBelow + (power - kFirstSplitPower) * kSubBuckets + subBucket;
+    }
+
+    long long BenchRunHistogram::bucketUpperBound(size_t bucket) {
+        if (bucket < static_cast<size_t>(kExactBelow)) {
+            return bucket;
+        }
+
+        const int power = kFirstSplitPower + (bucket - kExactBelow) / kSubBuckets;
+        const long long subBucket = (bucket - kExactBelow) % kSubBuckets;
+        return ((kSubBuckets + subBucket + 1) << (power - kSubBucketBits)) - 1;
+    }
+
+    void BenchRunHistogram::record(long long micros) {
+        micros = std::max(micros, 0LL);
+        _buckets[bucketFor(micros)]++;
+        _count++;
+        _totalMicros += micros;
+        _maxMicros = std::max(_maxMicros, micros);
+    }
+
+    void BenchRunHistogram::updateFrom(const BenchRunHistogram& other) {
+        for (size_t i = 0; i < kNumBuckets; i++) {
+            _buckets[i] += other._buckets[i];
+        }
+        _count += other._count;
+        _totalMicros += other._totalMicros;
+        _maxMicros = std::max(_maxMicros, other._maxMicros);
+    }
+
+    long long BenchRunHistogram::percentile(double p) const {
+        const unsigned long long rank =
+            std::max(1ULL, static_cast<unsigned long long>(std::ceil(p / 100 * _count)));
+
+        unsigned long long seen = 0;
+        for (size_t i = 0; i < kNumBuckets; i++) {
+            seen += _buckets[i];
+            if (seen >= rank) {
+                return std::min(bucketUpperBound(i), _maxMicros);
+            }
+        }
+        return _maxMicros;
+    }
+
+    void BenchRunHistogram::appendTo(BSONObjBuilder* builder) const {
+        builder->append("count", static_cast<long long>(_count));
+        if (_count == 0) {
+            return;
+        }
+
+        builder->append("averageMicros", static_cast<double>(_totalMicros) / _count);
+        builder->append("p50Micros", percentile(50));
+        builder->append("p90Micros", percentile(90));
+        builder->append("p99Micros", percentile(99));
+        builder->append("p999Micros", percentile(99.9));
+        builder->append("maxMicros", _maxMicros);
+    }
+
     BenchRunStats::BenchRunStats() {
         reset();
     }
@@ -108,6 +201,7 @@ namespace mongo {
         deleteCounter.reset();
         queryCounter.reset();
 
+        opLatencies.clear();
         trappedErrors.clear();
     }
 
@@ -122,6 +216,12 @@ namespace mongo {
         deleteCounter.updateFrom(other.deleteCounter);
         queryCounter.updateFrom(other.queryCounter);
 
+        for (BenchRunLatencies::const_iterator it = other.opLatencies.begin();
+             it != other.opLatencies.end();
+             ++it) {
+            opLatencies[it->first].updateFrom(it->second);
+        }
+
         for (size_t i = 0; i < other.trappedErrors.size(); ++i)
             trappedErrors.push_back(other.trappedErrors[i]);
     }
@@ -148,6 +248,8 @@ namespace mongo {
         noWatchPattern.reset();
 
         ops = BSONObj();
+        openLoop = false;
+        intervalSeconds = 0;
 
         throwGLE = false;
         breakOnTrap = true;
@@ -185,6 +287,8 @@ namespace mongo {
             this->throwGLE = args["throwGLE"].trueValue();
         if ( ! args["breakOnTrap"].eoo() )
             this->breakOnTrap = args["breakOnTrap"].trueValue();
+        if ( args["intervalSeconds"].isNumber() )
+            this->intervalSeconds = args["intervalSeconds"].number();
 
         uassert(16164, "loopCommands config not supported", args["loopCommands"].eoo());
 
@@ -213,6 +317,22 @@ namespace mongo {
         }
 
         this->ops = args["ops"].Obj().getOwned();
+
+        size_t numRated = 0;
+        size_t numOps = 0;
+        BSONObjIterator i( this->ops );
+        while ( i.more() ) {
+            BSONElement rate = i.next()["rate"];
+            numOps++;
+            if ( rate.eoo() )
+                continue;
+            uassert( 28622, "benchRun op rate must be a positive number",
+                     rate.isNumber() && rate.number() > 0 );
+            numRated++;
+        }
+        uassert( 28623, "benchRun ops must either all have a rate or all not have one",
+                 numRated == 0 || numRated == numOps );
+        this->openLoop = numRated > 0;
     }
 
     DBClientBase *BenchRunConfig::createConnection() const {
@@ -316,7 +436,7 @@ namespace mongo {
     }
 
     BenchRunWorker::BenchRunWorker(size_t id, const BenchRunConfig *config, BenchRunState *brState)
-        : _id(id), _config(config), _brState(brState) {
+        : _id(id), _config(config), _brState(brState), _numOps(0) {
     }
 
     BenchRunWorker::~BenchRunWorker() {}
@@ -333,8 +453,6 @@ namespace mongo {
 
     void BenchRunWorker::generateLoadOnConnection( DBClientBase* conn ) {
         verify( conn );
-        long long count = 0;
-        mongo::Timer timer;
 
         BsonTemplateEvaluator bsonTemplateEvaluator;
         invariant(bsonTemplateEvaluator.setId(_id) == BsonTemplateEvaluator::StatusSuccess);
@@ -346,369 +464,447 @@ namespace mongo {
             }
         }
 
-        while ( !shouldStop() ) {
-            BSONObjIterator i( _config->ops );
-            while ( i.more() ) {
+        if ( _config->openLoop ) {
+            if ( !generateOpenLoopLoad( conn, &bsonTemplateEvaluator ) )
+                return;
+        }
+        else {
+            while ( !shouldStop() ) {
+                BSONObjIterator i( _config->ops );
+                while ( i.more() ) {
+
+                    if ( shouldStop() ) break;
 
-                if ( shouldStop() ) break;
+                    BSONElement e = i.next();
 
-                BSONElement e = i.next();
+                    Timer timer;
+                    if ( !runOp( conn, e, &bsonTemplateEvaluator ) )
+                        return;
+                    recordLatency( e["op"].String(), timer.micros() );
 
-                string ns = e["ns"].String();
-                string op = e["op"].String();
+                    int delay = e["delay"].eoo() ? 0 : e["delay"].Int();
+                    if (delay > 0)
+                        sleepmillis( delay );
+                }
+            }
+        }
 
-                int delay = e["delay"].eoo() ? 0 : e["delay"].Int();
+        conn->getLastError();
+    }
 
-                // Let's default to writeCmd == false.
-                bool useWriteCmd = e["writeCmd"].eoo() ? false : 
-                    e["writeCmd"].Bool();
+    bool BenchRunWorker::generateOpenLoopLoad( DBClientBase* conn,
+                                               BsonTemplateEvaluator* bsonTemplateEvaluator ) {
+        // Every op has its own schedule: this worker issues its share of the op's rate at even
+        // intervals, with the workers' schedules staggered across the interval.
+        std::vector<BSONElement> ops;
+        std::vector<long long> intervalMicros;
+        std::vector<long long> dueMicros;
 
-                BSONObj context = e["context"].eoo() ? BSONObj() : e["context"].Obj();
+        BSONObjIterator i( _config->ops );
+        while ( i.more() ) {
+            BSONElement e = i.next();
+            const long long interval = static_cast<long long>(
+                1000 * 1000 * _config->parallel / e["rate"].number() );
+            ops.push_back( e );
+            intervalMicros.push_back( std::max( interval, 1LL ) );
+            dueMicros.push_back( intervalMicros.back() * _id / _config->parallel );
+        }
 
-                auto_ptr<Scope> scope;
-                ScriptingFunction scopeFunc = 0;
-                BSONObj scopeObj;
+        Timer clock;
+        while ( !shouldStop() ) {
+            const size_t next =
+                std::min_element( dueMicros.begin(), dueMicros.end() ) - dueMicros.begin();
+            const long long due = dueMicros[next];
+            dueMicros[next] += intervalMicros[next];
+
+            // Don't sleep past a request to stop.
+            long long wait;
+            while ( ( wait = due - clock.micros() ) > 0 && !shouldStop() ) {
+                sleepmicros( std::min( wait, 100 * 1000LL ) );
+            }
+            if ( shouldStop() ) break;
 
-                bool check = ! e["check"].eoo();
-                if( check ){
-                    if ( e["check"].type() == CodeWScope || e["check"].type() == Code || e["check"].type() == String ) {
-                        OperationContextNoop txn;
-                        scope = globalScriptEngine->getPooledScope(&txn, ns, "benchrun");
-                        verify( scope.get() );
-
-                        if ( e.type() == CodeWScope ) {
-                            scopeFunc = scope->createFunction( e["check"].codeWScopeCode() );
-                            scopeObj = BSONObj( e.codeWScopeScopeDataUnsafe() );
-                        }
-                        else {
-                            scopeFunc = scope->createFunction( e["check"].valuestr() );
-                        }
+            const BSONElement& e = ops[next];
+            if ( !runOp( conn, e, bsonTemplateEvaluator ) )
+                return false;
 
-                        scope->init( &scopeObj );
-                        invariant(scopeFunc);
-                    }
-                    else {
-                        warning() << "Invalid check type detected in benchRun op : " << e << endl;
-                        check = false;
-                    }
-                }
+            // If this worker has fallen behind schedule, the op was issued late, and that delay
+            // is part of its latency.
+            recordLatency( e["op"].String(), clock.micros() - due );
+        }
 
-                try {
-                    if ( op == "nop") {
-                        // do nothing
-                    }
-                    else if ( op == "findOne" ) {
+        return true;
+    }
 
-                        BSONObj result;
-                        {
-                            BenchRunEventTrace _bret(&_stats.findOneCounter);
-                            result = conn->findOne( ns , fixQuery( e["query"].Obj(),
-                                                                   bsonTemplateEvaluator ) );
-                        }
+    bool BenchRunWorker::runOp( DBClientBase* conn,
+                                const BSONElement& e,
+                                BsonTemplateEvaluator* bsonTemplateEvaluator ) {
+        string ns = e["ns"].String();
+        string op = e["op"].String();
 
-                        if( check ){
-                            int err = scope->invoke( scopeFunc , 0 , &result,  1000 * 60 , false );
-                            if( err ){
-                                log() << "Error checking in benchRun thread [findOne]" << causedBy( scope->getError() ) << endl;
+        // Let's default to writeCmd == false.
+        bool useWriteCmd = e["writeCmd"].eoo() ? false : 
+            e["writeCmd"].Bool();
 
-                                _stats.errCount++;
+        BSONObj context = e["context"].eoo() ? BSONObj() : e["context"].Obj();
 
-                                return;
-                            }
-                        }
+        auto_ptr<Scope> scope;
+        ScriptingFunction scopeFunc = 0;
+        BSONObj scopeObj;
 
-                        if( ! _config->hideResults || e["showResult"].trueValue() ) log() << "Result from benchRun thread [findOne] : " << result << endl;
+        bool check = ! e["check"].eoo();
+        if( check ){
+            if ( e["check"].type() == CodeWScope || e["check"].type() == Code || e["check"].type() == String ) {
+                OperationContextNoop txn;
+                scope = globalScriptEngine->getPooledScope(&txn, ns, "benchrun");
+                verify( scope.get() );
 
-                    }
-                    else if ( op == "command" ) {
+                if ( e.type() == CodeWScope ) {
+                    scopeFunc = scope->createFunction( e["check"].codeWScopeCode() );
+                    scopeObj = BSONObj( e.codeWScopeScopeDataUnsafe() );
+                }
+                else {
+                    scopeFunc = scope->createFunction( e["check"].valuestr() );
+                }
 
-                        BSONObj result;
-                        conn->runCommand( ns, fixQuery( e["command"].Obj(), bsonTemplateEvaluator ),
-                                          result, e["options"].numberInt() );
+                scope->init( &scopeObj );
+                invariant(scopeFunc);
+            }
+            else {
+                warning() << "Invalid check type detected in benchRun op : " << e << endl;
+                check = false;
+            }
+        }
 
-                        if( check ){
-                            int err = scope->invoke( scopeFunc , 0 , &result,  1000 * 60 , false );
-                            if( err ){
-                                log() << "Error checking in benchRun thread [command]" << causedBy( scope->getError() ) << endl;
+        try {
+            if ( op == "nop") {
+                // do nothing
+            }
+            else if ( op == "findOne" ) {
 
-                                _stats.errCount++;
+                BSONObj result;
+                {
+                    BenchRunEventTrace _bret(&_stats.findOneCounter);
+                    result = conn->findOne( ns , fixQuery( e["query"].Obj(),
+                                                           *bsonTemplateEvaluator ) );
+                }
 
-                                return;
-                            }
-                        }
+                if( check ){
+                    int err = scope->invoke( scopeFunc , 0 , &result,  1000 * 60 , false );
+                    if( err ){
+                        log() << "Error checking in benchRun thread [findOne]" << causedBy( scope->getError() ) << endl;
 
-                        if( ! _config->hideResults || e["showResult"].trueValue() ) log() << "Result from benchRun thread [command] : " << result << endl;
+                        _stats.errCount++;
 
+                        return false;
                     }
-                    else if( op == "find" || op == "query" ) {
+                }
+
+                if( ! _config->hideResults || e["showResult"].trueValue() ) log() << "Result from benchRun thread [findOne] : " << result << endl;
 
-                        int limit = e["limit"].eoo() ? 0 : e["limit"].numberInt();
-                        int skip = e["skip"].eoo() ? 0 : e["skip"].Int();
-                        int options = e["options"].eoo() ? 0 : e["options"].Int();
-                        int batchSize = e["batchSize"].eoo() ? 0 : e["batchSize"].Int();
-                        BSONObj filter = e["filter"].eoo() ? BSONObj() : e["filter"].Obj();
-                        int expected = e["expected"].eoo() ? -1 : e["expected"].Int();
+            }
+            else if ( op == "command" ) {
 
-                        auto_ptr<DBClientCursor> cursor;
-                        int count;
+                BSONObj result;
+                conn->runCommand( ns, fixQuery( e["command"].Obj(), *bsonTemplateEvaluator ),
+                                  result, e["options"].numberInt() );
 
-                        BSONObj fixedQuery = fixQuery(e["query"].Obj(), bsonTemplateEvaluator);
+                if( check ){
+                    int err = scope->invoke( scopeFunc , 0 , &result,  1000 * 60 , false );
+                    if( err ){
+                        log() << "Error checking in benchRun thread [command]" << causedBy( scope->getError() ) << endl;
 
-                        // use special query function for exhaust query option
-                        if (options & QueryOption_Exhaust) {
-                            BenchRunEventTrace _bret(&_stats.queryCounter);
-                            stdx::function<void (const BSONObj&)> castedDoNothing(doNothing);
-                            count =  conn->query(castedDoNothing, ns, fixedQuery, &filter, options);
-                        }
-                        else {
-                            BenchRunEventTrace _bret(&_stats.queryCounter);
-                            cursor = conn->query(ns, fixedQuery, limit, skip, &filter, options,
-                                                 batchSize);
-                            count = cursor->itcount();
-                        }
+                        _stats.errCount++;
 
-                        if ( expected >= 0 &&  count != expected ) {
-                            cout << "bench query on: " << ns << " expected: " << expected << " got: " << count << endl;
-                            verify(false);
-                        }
+                        return false;
+                    }
+                }
 
-                        if( check ){
-                            BSONObj thisValue = BSON( "count" << count << "context" << context );
-                            int err = scope->invoke( scopeFunc , 0 , &thisValue, 1000 * 60 , false );
-                            if( err ){
-                                log() << "Error checking in benchRun thread [find]" << causedBy( scope->getError() ) << endl;
+                if( ! _config->hideResults || e["showResult"].trueValue() ) log() << "Result from benchRun thread [command] : " << result << endl;
 
-                                _stats.errCount++;
+            }
+            else if( op == "find" || op == "query" ) {
 
-                                return;
-                            }
-                        }
+                int limit = e["limit"].eoo() ? 0 : e["limit"].numberInt();
+                int skip = e["skip"].eoo() ? 0 : e["skip"].Int();
+                int options = e["options"].eoo() ? 0 : e["options"].Int();
+                int batchSize = e["batchSize"].eoo() ? 0 : e["batchSize"].Int();
+                BSONObj filter = e["filter"].eoo() ? BSONObj() : e["filter"].Obj();
+                int expected = e["expected"].eoo() ? -1 : e["expected"].Int();
 
-                        if( ! _config->hideResults || e["showResult"].trueValue() ) log() << "Result from benchRun thread [query] : " << count << endl;
+                auto_ptr<DBClientCursor> cursor;
+                int count;
 
-                    }
-                    else if( op == "update" ) {
-
-                        bool multi = e["multi"].trueValue();
-                        bool upsert = e["upsert"].trueValue();
-                        BSONObj queryOrginal = e["query"].eoo() ? BSONObj() : e["query"].Obj();
-                        BSONObj updateOriginal = e["update"].Obj();
-                        BSONObj result;
-                        bool safe = e["safe"].trueValue();
-
-                        {
-                            BenchRunEventTrace _bret(&_stats.updateCounter);
-                            BSONObj query = fixQuery(queryOrginal, bsonTemplateEvaluator);
-                            BSONObj update = fixQuery(updateOriginal, bsonTemplateEvaluator);
-
-                            if (useWriteCmd) {
-                                // TODO: Replace after SERVER-11774.
-                                BSONObjBuilder builder;
-                                builder.append("update",
-                                    nsToCollectionSubstring(ns));
-                                BSONArrayBuilder docBuilder(
-                                    builder.subarrayStart("updates"));
-                                docBuilder.append(BSON("q" << query <<
-                                                       "u" << update <<
-                                                       "multi" << multi <<
-                                                       "upsert" << upsert));
-                                docBuilder.done();
-                                conn->runCommand(
-                                    nsToDatabaseSubstring(ns).toString(),
-                                    builder.done(), result);
-                            }
-                            else {
-                                conn->update(ns, query, update,
-                                            upsert , multi);
-                                if (safe)
-                                    result = conn->getLastErrorDetailed();
-                            }
-                        }
+                BSONObj fixedQuery = fixQuery(e["query"].Obj(), *bsonTemplateEvaluator);
 
-                        if( safe ){
-                            if( check ){
-                                int err = scope->invoke( scopeFunc , 0 , &result, 1000 * 60 , false );
-                                if( err ){
-                                    log() << "Error checking in benchRun thread [update]" << causedBy( scope->getError() ) << endl;
+                // use special query function for exhaust query option
+                if (options & QueryOption_Exhaust) {
+                    BenchRunEventTrace _bret(&_stats.queryCounter);
+                    stdx::function<void (const BSONObj&)> castedDoNothing(doNothing);
+                    count =  conn->query(castedDoNothing, ns, fixedQuery, &filter, options);
+                }
+                else {
+                    BenchRunEventTrace _bret(&_stats.queryCounter);
+                    cursor = conn->query(ns, fixedQuery, limit, skip, &filter, options,
+                                         batchSize);
+                    count = cursor->itcount();
+                }
 
-                                    _stats.errCount++;
+                if ( expected >= 0 &&  count != expected ) {
+                    cout << "bench query on: " << ns << " expected: " << expected << " got: " << count << endl;
+                    verify(false);
+                }
 
-                                    return;
-                                }
-                            }
+                if( check ){
+                    BSONObj thisValue = BSON( "count" << count << "context" << context );
+                    int err = scope->invoke( scopeFunc , 0 , &thisValue, 1000 * 60 , false );
+                    if( err ){
+                        log() << "Error checking in benchRun thread [find]" << causedBy( scope->getError() ) << endl;
 
-                            if( ! _config->hideResults || e["showResult"].trueValue() ) log() << "Result from benchRun thread [safe update] : " << result << endl;
+                        _stats.errCount++;
 
-                            if( ! result["err"].eoo() && result["err"].type() == String && ( _config->throwGLE || e["throwGLE"].trueValue() ) )
-                                throw DBException( (string)"From benchRun GLE" + causedBy( result["err"].String() ),
-                                                   result["code"].eoo() ? 0 : result["code"].Int() );
-                        }
+                        return false;
                     }
-                    else if( op == "insert" ) {
-                        bool safe = e["safe"].trueValue();
-                        BSONObj result;
-
-                        {
-                            BenchRunEventTrace _bret(&_stats.insertCounter);
-
-                            BSONObj insertDoc = fixQuery(e["doc"].Obj(), bsonTemplateEvaluator);
-
-                            if (useWriteCmd) {
-                                BSONObjBuilder builder;
-                                builder.append("insert", nsToCollectionSubstring(ns));
-                                BSONArrayBuilder docBuilder(
-                                    builder.subarrayStart("documents"));
-                                docBuilder.append(insertDoc);
-                                docBuilder.done();
-                                // TODO: Replace after SERVER-11774.
-                                conn->runCommand(
-                                    nsToDatabaseSubstring(ns).toString(),
-                                    builder.done(), result);
-                            }
-                            else {
-                                conn->insert(ns, insertDoc);
-                                if (safe)
-                                    result = conn->getLastErrorDetailed();
-                            }
-                        }
+                }
 
-                        if( safe ){
-                            if( check ){
-                                int err = scope->invoke( scopeFunc , 0 , &result, 1000 * 60 , false );
-                                if( err ){
-                                    log() << "Error checking in benchRun thread [insert]" << causedBy( scope->getError() ) << endl;
+                if( ! _config->hideResults || e["showResult"].trueValue() ) log() << "Result from benchRun thread [query] : " << count << endl;
 
-                                    _stats.errCount++;
+            }
+            else if( op == "update" ) {
+
+                bool multi = e["multi"].trueValue();
+                bool upsert = e["upsert"].trueValue();
+                BSONObj queryOrginal = e["query"].eoo() ? BSONObj() : e["query"].Obj();
+                BSONObj updateOriginal = e["update"].Obj();
+                BSONObj result;
+                bool safe = e["safe"].trueValue();
+
+                {
+                    BenchRunEventTrace _bret(&_stats.updateCounter);
+                    BSONObj query = fixQuery(queryOrginal, *bsonTemplateEvaluator);
+                    BSONObj update = fixQuery(updateOriginal, *bsonTemplateEvaluator);
+
+                    if (useWriteCmd) {
+                        // TODO: Replace after SERVER-11774.
+                        BSONObjBuilder builder;
+                        builder.append("update",
+                            nsToCollectionSubstring(ns));
+                        BSONArrayBuilder docBuilder(
+                            builder.subarrayStart("updates"));
+                        docBuilder.append(BSON("q" << query <<
+                                               "u" << update <<
+                                               "multi" << multi <<
+                                               "upsert" << upsert));
+                        docBuilder.done();
+                        conn->runCommand(
+                            nsToDatabaseSubstring(ns).toString(),
+                            builder.done(), result);
+                    }
+                    else {
+                        conn->update(ns, query, update,
+                                    upsert , multi);
+                        if (safe)
+                            result = conn->getLastErrorDetailed();
+                    }
+                }
 
-                                    return;
-                                }
-                            }
+                if( safe ){
+                    if( check ){
+                        int err = scope->invoke( scopeFunc , 0 , &result, 1000 * 60 , false );
+                        if( err ){
+                            log() << "Error checking in benchRun thread [update]" << causedBy( scope->getError() ) << endl;
 
-                            if( ! _config->hideResults || e["showResult"].trueValue() ) log() << "Result from benchRun thread [safe insert] : " << result << endl;
+                            _stats.errCount++;
 
-                            if( ! result["err"].eoo() && result["err"].type() == String && ( _config->throwGLE || e["throwGLE"].trueValue() ) )
-                                throw DBException( (string)"From benchRun GLE" + causedBy( result["err"].String() ),
-                                                   result["code"].eoo() ? 0 : result["code"].Int() );
+                            return false;
                         }
                     }
-                    else if( op == "delete" || op == "remove" ) {
-
-                        bool multi = e["multi"].eoo() ? true : e["multi"].trueValue();
-                        BSONObj query = e["query"].eoo() ? BSONObj() : e["query"].Obj();
-                        bool safe = e["safe"].trueValue();
-                        BSONObj result;
-                        {
-                            BenchRunEventTrace _bret(&_stats.deleteCounter);
-                            BSONObj predicate = fixQuery(query, bsonTemplateEvaluator);
-                            if (useWriteCmd) {
-
-                                // TODO: Replace after SERVER-11774.
-                                BSONObjBuilder builder;
-                                builder.append("delete",
-                                    nsToCollectionSubstring(ns));
-                                BSONArrayBuilder docBuilder(
-                                    builder.subarrayStart("deletes"));
-                                int limit = (multi == true) ? 0 : 1;
-                                docBuilder.append(
-                                        BSON("q" << predicate <<
-                                             "limit" << limit));
-                                docBuilder.done();
-                                conn->runCommand(
-                                    nsToDatabaseSubstring(ns).toString(),
-                                    builder.done(), result);
-                            }
-                            else {
-                                conn->remove(ns, predicate, !multi);
-                                if (safe)
-                                    result = conn->getLastErrorDetailed();
-                            }
-                        }
 
-                        if( safe ){
-                            if( check ){
-                                int err = scope->invoke( scopeFunc , 0 , &result, 1000 * 60 , false );
-                                if( err ){
-                                    log() << "Error checking in benchRun thread [delete]" << causedBy( scope->getError() ) << endl;
+                    if( ! _config->hideResults || e["showResult"].trueValue() ) log() << "Result from benchRun thread [safe update] : " << result << endl;
 
-                                    _stats.errCount++;
+                    if( ! result["err"].eoo() && result["err"].type() == String && ( _config->throwGLE || e["throwGLE"].trueValue() ) )
+                        throw DBException( (string)"From benchRun GLE" + causedBy( result["err"].String() ),
+                                           result["code"].eoo() ? 0 : result["code"].Int() );
+                }
+            }
+            else if( op == "insert" ) {
+                bool safe = e["safe"].trueValue();
+                BSONObj result;
+
+                {
+                    BenchRunEventTrace _bret(&_stats.insertCounter);
+
+                    BSONObj insertDoc = fixQuery(e["doc"].Obj(), *bsonTemplateEvaluator);
+
+                    if (useWriteCmd) {
+                        BSONObjBuilder builder;
+                        builder.append("insert", nsToCollectionSubstring(ns));
+                        BSONArrayBuilder docBuilder(
+                            builder.subarrayStart("documents"));
+                        docBuilder.append(insertDoc);
+                        docBuilder.done();
+                        // TODO: Replace after SERVER-11774.
+                        conn->runCommand(
+                            nsToDatabaseSubstring(ns).toString(),
+                            builder.done(), result);
+                    }
+                    else {
+                        conn->insert(ns, insertDoc);
+                        if (safe)
+                            result = conn->getLastErrorDetailed();
+                    }
+                }
 
-                                    return;
-                                }
-                            }
+                if( safe ){
+                    if( check ){
+                        int err = scope->invoke( scopeFunc , 0 , &result, 1000 * 60 , false );
+                        if( err ){
+                            log() << "Error checking in benchRun thread [insert]" << causedBy( scope->getError() ) << endl;
 
-                            if( ! _config->hideResults || e["showResult"].trueValue() ) log() << "Result from benchRun thread [safe remove] : " << result << endl;
+                            _stats.errCount++;
 
-                            if( ! result["err"].eoo() && result["err"].type() == String && ( _config->throwGLE || e["throwGLE"].trueValue() ) )
-                                throw DBException( (string)"From benchRun GLE " + causedBy( result["err"].String() ),
-                                                   result["code"].eoo() ? 0 : result["code"].Int() );
+                            return false;
                         }
                     }
-                    else if ( op == "createIndex" ) {
-                        conn->ensureIndex( ns , e["key"].Obj() , false , "" , false );
-                    }
-                    else if ( op == "dropIndex" ) {
-                        conn->dropIndex( ns , e["key"].Obj()  );
-                    }
-                    else if( op == "let" ) {
-                        string target = e["target"].eoo() ? string() : e["target"].String();
-                        BSONElement value = e["value"].eoo() ? BSONElement() : e["value"];
-                        BSONObjBuilder valBuilder;
-                        BSONObjBuilder templateBuilder;
-                        valBuilder.append(value);
-                        bsonTemplateEvaluator.evaluate(valBuilder.done(), templateBuilder);
-                        bsonTemplateEvaluator.setVariable(target, templateBuilder.done().firstElement());
+
+                    if( ! _config->hideResults || e["showResult"].trueValue() ) log() << "Result from benchRun thread [safe insert] : " << result << endl;
+
+                    if( ! result["err"].eoo() && result["err"].type() == String && ( _config->throwGLE || e["throwGLE"].trueValue() ) )
+                        throw DBException( (string)"From benchRun GLE" + causedBy( result["err"].String() ),
+                                           result["code"].eoo() ? 0 : result["code"].Int() );
+                }
+            }
+            else if( op == "delete" || op == "remove" ) {
+
+                bool multi = e["multi"].eoo() ? true : e["multi"].trueValue();
+                BSONObj query = e["query"].eoo() ? BSONObj() : e["query"].Obj();
+                bool safe = e["safe"].trueValue();
+                BSONObj result;
+                {
+                    BenchRunEventTrace _bret(&_stats.deleteCounter);
+                    BSONObj predicate = fixQuery(query, *bsonTemplateEvaluator);
+                    if (useWriteCmd) {
+
+                        // TODO: Replace after SERVER-11774.
+                        BSONObjBuilder builder;
+                        builder.append("delete",
+                            nsToCollectionSubstring(ns));
+                        BSONArrayBuilder docBuilder(
+                            builder.subarrayStart("deletes"));
+                        int limit = (multi == true) ? 0 : 1;
+                        docBuilder.append(
+                                BSON("q" << predicate <<
+                                     "limit" << limit));
+                        docBuilder.done();
+                        conn->runCommand(
+                            nsToDatabaseSubstring(ns).toString(),
+                            builder.done(), result);
                     }
                     else {
-                        log() << "don't understand op: " << op << endl;
-                        _stats.error = true;
-                        return;
+                        conn->remove(ns, predicate, !multi);
+                        if (safe)
+                            result = conn->getLastErrorDetailed();
                     }
                 }
-                catch( DBException& ex ){
-                    if( ! _config->hideErrors || e["showError"].trueValue() ){
-
-                        bool yesWatch = ( _config->watchPattern && _config->watchPattern->FullMatch( ex.what() ) );
-                        bool noWatch = ( _config->noWatchPattern && _config->noWatchPattern->FullMatch( ex.what() ) );
 
-                        if( ( ! _config->watchPattern && _config->noWatchPattern && ! noWatch ) || // If we're just ignoring things
-                            ( ! _config->noWatchPattern && _config->watchPattern && yesWatch ) || // If we're just watching things
-                            ( _config->watchPattern && _config->noWatchPattern && yesWatch && ! noWatch ) )
-                            log() << "Error in benchRun thread for op " << e << causedBy( ex ) << endl;
-                    }
+                if( safe ){
+                    if( check ){
+                        int err = scope->invoke( scopeFunc , 0 , &result, 1000 * 60 , false );
+                        if( err ){
+                            log() << "Error checking in benchRun thread [delete]" << causedBy( scope->getError() ) << endl;
 
-                    bool yesTrap = ( _config->trapPattern && _config->trapPattern->FullMatch( ex.what() ) );
-                    bool noTrap = ( _config->noTrapPattern && _config->noTrapPattern->FullMatch( ex.what() ) );
+                            _stats.errCount++;
 
-                    if( ( ! _config->trapPattern && _config->noTrapPattern && ! noTrap ) ||
-                        ( ! _config->noTrapPattern && _config->trapPattern && yesTrap ) ||
-                        ( _config->trapPattern && _config->noTrapPattern && yesTrap && ! noTrap ) ){
-                        {
-                            _stats.trappedErrors.push_back( BSON( "error" << ex.what() << "op" << e << "count" << count ) );
+                            return false;
                         }
-                        if( _config->breakOnTrap ) return;
                     }
-                    if( ! _config->handleErrors && ! e["handleError"].trueValue() ) return;
 
-                    _stats.errCount++;
-                }
-                catch( ... ){
-                    if( ! _config->hideErrors || e["showError"].trueValue() ) log() << "Error in benchRun thread caused by unknown error for op " << e << endl;
-                    if( ! _config->handleErrors && ! e["handleError"].trueValue() ) return;
+                    if( ! _config->hideResults || e["showResult"].trueValue() ) log() << "Result from benchRun thread [safe remove] : " << result << endl;
 
-                    _stats.errCount++;
+                    if( ! result["err"].eoo() && result["err"].type() == String && ( _config->throwGLE || e["throwGLE"].trueValue() ) )
+                        throw DBException( (string)"From benchRun GLE " + causedBy( result["err"].String() ),
+                                           result["code"].eoo() ? 0 : result["code"].Int() );
                 }
+            }
+            else if ( op == "createIndex" ) {
+                conn->ensureIndex( ns , e["key"].Obj() , false , "" , false );
+            }
+            else if ( op == "dropIndex" ) {
+                conn->dropIndex( ns , e["key"].Obj()  );
+            }
+            else if( op == "let" ) {
+                string target = e["target"].eoo() ? string() : e["target"].String();
+                BSONElement value = e["value"].eoo() ? BSONElement() : e["value"];
+                BSONObjBuilder valBuilder;
+                BSONObjBuilder templateBuilder;
+                valBuilder.append(value);
+                bsonTemplateEvaluator->evaluate(valBuilder.done(), templateBuilder);
+                bsonTemplateEvaluator->setVariable(target, templateBuilder.done().firstElement());
+            }
+            else {
+                log() << "don't understand op: " << op << endl;
+                _stats.error = true;
+                return false;
+            }
+        }
+        catch( DBException& ex ){
+            if( ! _config->hideErrors || e["showError"].trueValue() ){
 
-                if (++count % 100 == 0 && !useWriteCmd) {
-                    conn->getLastError();
-                }
+                bool yesWatch = ( _config->watchPattern && _config->watchPattern->FullMatch( ex.what() ) );
+                bool noWatch = ( _config->noWatchPattern && _config->noWatchPattern->FullMatch( ex.what() ) );
+
+                if( ( ! _config->watchPattern && _config->noWatchPattern && ! noWatch ) || // If we're just ignoring things
+                    ( ! _config->noWatchPattern && _config->watchPattern && yesWatch ) || // If we're just watching things
+                    ( _config->watchPattern && _config->noWatchPattern && yesWatch && ! noWatch ) )
+                    log() << "Error in benchRun thread for op " << e << causedBy( ex ) << endl;
+            }
 
-                if (delay > 0)
-                    sleepmillis( delay );
+            bool yesTrap = ( _config->trapPattern && _config->trapPattern->FullMatch( ex.what() ) );
+            bool noTrap = ( _config->noTrapPattern && _config->noTrapPattern->FullMatch( ex.what() ) );
 
+            if( ( ! _config->trapPattern && _config->noTrapPattern && ! noTrap ) ||
+                ( ! _config->noTrapPattern && _config->trapPattern && yesTrap ) ||
+                ( _config->trapPattern && _config->noTrapPattern && yesTrap && ! noTrap ) ){
+                {
+                    _stats.trappedErrors.push_back( BSON( "error" << ex.what() << "op" << e << "count" << _numOps ) );
+                }
+                if( _config->breakOnTrap ) return false;
             }
+            if( ! _config->handleErrors && ! e["handleError"].trueValue() ) return false;
+
+            _stats.errCount++;
         }
+        catch( ... ){
+            if( ! _config->hideErrors || e["showError"].trueValue() ) log() << "Error in benchRun thread caused by unknown error for op " << e << endl;
+            if( ! _config->handleErrors && ! e["handleError"].trueValue() ) return false;
 
-        conn->getLastError();
+            _stats.errCount++;
+        }
+
+        if (++_numOps % 100 == 0 && !useWriteCmd) {
+            conn->getLastError();
+        }
+
+        return true;
+    }
+
+    void BenchRunWorker::recordLatency(const std::string& opName, long long micros) {
+        _stats.opLatencies[opName].record(micros);
+
+        if (_config->intervalSeconds > 0) {
+            boost::mutex::scoped_lock lk(_intervalMutex);
+            _intervalLatencies[opName].record(micros);
+        }
+    }
+
+    void BenchRunWorker::takeIntervalLatencies(BenchRunLatencies* latencies) {
+        boost::mutex::scoped_lock lk(_intervalMutex);
+        for (BenchRunLatencies::const_iterator it = _intervalLatencies.begin();
+             it != _intervalLatencies.end();
+             ++it) {
+            (*latencies)[it->first].updateFrom(it->second);
+        }
+        _intervalLatencies.clear();
     }
 
     namespace {
@@ -794,6 +990,50 @@ namespace mongo {
              before = before.getOwned();
              _brTimer = new mongo::Timer();
          }
+
+         if (_config->intervalSeconds > 0) {
+             _intervalReporter.reset(
+                 new boost::thread(stdx::bind(&BenchRunner::reportIntervals, this)));
+         }
+     }
+
+     void BenchRunner::reportIntervals() {
+         const long long intervalMicros =
+             static_cast<long long>(1000 * 1000 * _config->intervalSeconds);
+         Timer sinceStart;
+
+         for (long long n = 1; ; n++) {
+             long long wait;
+             while ((wait = n * intervalMicros - sinceStart.micros()) > 0 &&
+                    !_brState.shouldWorkerFinish()) {
+                 sleepmicros(std::min(wait, 100 * 1000LL));
+             }
+             if (_brState.shouldWorkerFinish()) {
+                 return;
+             }
+
+             BenchRunLatencies latencies;
+             for (size_t i = 0; i < _workers.size(); ++i) {
+                 _workers[i]->takeIntervalLatencies(&latencies);
+             }
+
+             BSONObjBuilder intervalBuilder;
+             intervalBuilder.append("elapsedSeconds", n * _config->intervalSeconds);
+             BSONObjBuilder opsBuilder(intervalBuilder.subobjStart("ops"));
+             for (BenchRunLatencies::const_iterator it = latencies.begin();
+                  it != latencies.end();
+                  ++it) {
+                 BSONObjBuilder opBuilder(opsBuilder.subobjStart(it->first));
+                 opBuilder.append("opsPerSecond",
+                                  it->second.getCount() / _config->intervalSeconds);
+                 it->second.appendTo(&opBuilder);
+             }
+             opsBuilder.doneFast();
+
+             const BSONObj interval = intervalBuilder.obj();
+             log() << "benchRun interval: " << interval << endl;
+             _intervals.push_back(interval);
+         }
      }
 
      void BenchRunner::stop() {
@@ -802,6 +1042,10 @@ namespace mongo {
          _microsElapsed = _brTimer->micros();
          delete _brTimer;
 
+         if (_intervalReporter) {
+             _intervalReporter->join();
+         }
+
          {
              boost::scoped_ptr<DBClientBase> conn( _config->createConnection() );
              if (_config->username != "") {
@@ -888,6 +1132,24 @@ namespace mongo {
          appendAverageMicrosIfAvailable(buf, "updateLatencyAverageMicros", stats.updateCounter);
          appendAverageMicrosIfAvailable(buf, "queryLatencyAverageMicros", stats.queryCounter);
 
+         if (runner->config().openLoop) {
+             buf.append("openLoop", true);
+         }
+
+         {
+             BSONObjBuilder latenciesBuilder(buf.subobjStart("opLatencies"));
+             for (BenchRunLatencies::const_iterator it = stats.opLatencies.begin();
+                  it != stats.opLatencies.end();
+                  ++it) {
+                 BSONObjBuilder opBuilder(latenciesBuilder.subobjStart(it->first));
+                 it->second.appendTo(&opBuilder);
+             }
+         }
+
+         if (!runner->_intervals.empty()) {
+             buf.append("intervals", runner->_intervals);
+         }
+
          {
              BSONObjIterator i( after );
              while ( i.more() ) {
@@ -28,13 +28,16 @@
 
 #pragma once
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/condition.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/jsobj.h"
@@ -47,6 +50,8 @@ namespace pcrecpp {
 
 namespace mongo {
 
+    class BsonTemplateEvaluator;
+
     /**
      * Configuration object describing a bench run activity.
      */
@@ -118,12 +123,27 @@ namespace mongo {
          * Every thread in a benchRun job will perform these operations in sequence, restarting at
          * the beginning when the end is reached, until the job is stopped.
          *
+         * If the operations have a "rate" field, the job runs open-loop instead: each operation
+         * is issued "rate" times per second across all threads, on a fixed schedule that does
+         * not wait for slow responses, and its latency is measured from when it was scheduled
+         * rather than from when it was sent, so that time spent queued behind slow operations
+         * is counted.  Either all operations have a rate or none do.
+         *
          * TODO: Document the operation objects.
          *
          * TODO: Introduce support for performing each operation exactly N times.
          */
         BSONObj ops;
 
+        /// True if the operations have target rates; see "ops".
+        bool openLoop;
+
+        /**
+         * If positive, log and keep the per-operation throughput and latency percentiles of
+         * every interval of this many seconds during the run.
+         */
+        double intervalSeconds;
+
         bool throwGLE;
         bool breakOnTrap;
 
@@ -176,6 +196,47 @@ namespace mongo {
         long long _totalTimeMicros;
     };
 
+    /**
+     * A histogram of operation latencies in microseconds, in the style of HdrHistogram: values
+     * under 32 have a bucket each, and every higher power of two is split into 16 equal
+     * buckets, so percentiles are reported within 1/16 of the true value at any magnitude.
+     *
+     * Not thread safe.
+     */
+    class BenchRunHistogram {
+    public:
+        BenchRunHistogram();
+
+        void reset();
+
+        void record(long long micros);
+
+        void updateFrom(const BenchRunHistogram& other);
+
+        unsigned long long getCount() const { return _count; }
+
+        /**
+         * Returns the upper bound of the bucket holding the "p"th percentile, 0 < p <= 100.
+         */
+        long long percentile(double p) const;
+
+        /**
+         * Appends the count, average, maximum and the 50th, 90th, 99th and 99.9th percentiles.
+         */
+        void appendTo(BSONObjBuilder* builder) const;
+
+    private:
+        static size_t bucketFor(long long micros);
+        static long long bucketUpperBound(size_t bucket);
+
+        std::vector<unsigned long long> _buckets;
+        unsigned long long _count;
+        long long _totalMicros;
+        long long _maxMicros;
+    };
+
+    typedef std::map<std::string, BenchRunHistogram> BenchRunLatencies; // by op name
+
     /**
      * RAII object for tracing an event.
      *
@@ -244,6 +305,9 @@ namespace mongo {
         BenchRunEventCounter deleteCounter;
         BenchRunEventCounter queryCounter;
 
+        // Latency of every op, measured from when it was scheduled in open-loop runs.
+        BenchRunLatencies opLatencies;
+
         std::map<std::string, long long> opcounters;
         std::vector<BSONObj> trappedErrors;
     };
@@ -341,6 +405,12 @@ namespace mongo {
          */
         const BenchRunStats &stats() const { return _stats; }
 
+        /**
+         * Adds the latencies recorded since the last call into "latencies", and forgets them.
+         * Safe to call while the worker runs.
+         */
+        void takeIntervalLatencies(BenchRunLatencies* latencies);
+
     private:
         /// The main method of the worker, executed inside the thread launched by start().
         void run();
@@ -348,6 +418,20 @@ namespace mongo {
         /// The function that actually sets about generating the load described in "_config".
         void generateLoadOnConnection( DBClientBase *conn );
 
+        /// Issues each op at its target rate until stopped, for open-loop configurations.
+        bool generateOpenLoopLoad( DBClientBase* conn,
+                                   BsonTemplateEvaluator* bsonTemplateEvaluator );
+
+        /**
+         * Performs the single op described by "e".  Returns false if the worker should stop,
+         * because of an error it is not configured to carry on after.
+         */
+        bool runOp( DBClientBase* conn,
+                    const BSONElement& e,
+                    BsonTemplateEvaluator* bsonTemplateEvaluator );
+
+        void recordLatency(const std::string& opName, long long micros);
+
         /// Predicate, used to decide whether or not it's time to terminate the worker.
         bool shouldStop() const;
 
@@ -355,6 +439,10 @@ namespace mongo {
         const BenchRunConfig *_config;
         BenchRunState *_brState;
         BenchRunStats _stats;
+        long long _numOps;
+
+        boost::mutex _intervalMutex; // protects _intervalLatencies
+        BenchRunLatencies _intervalLatencies;
     };
 
     /**
@@ -421,6 +509,9 @@ namespace mongo {
         static BSONObj benchRunSync(const BSONObj& argsFake, void* data);
 
     private:
+        /// Body of the thread collecting interval stats, when configured.
+        void reportIntervals();
+
         // TODO: Same as for createWithConfig.
         static boost::mutex _staticMutex;
         static std::map< OID, BenchRunner* > _activeRuns;
@@ -432,6 +523,9 @@ namespace mongo {
         boost::scoped_ptr<BenchRunConfig> _config;
         std::vector<BenchRunWorker *> _workers;
 
+        boost::scoped_ptr<boost::thread> _intervalReporter;
+        std::vector<BSONObj> _intervals; // only touched by _intervalReporter until it's joined
+
         BSONObj before;
         BSONObj after;
     };
@@ -0,0 +1,431 @@
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/*
+ * mongoreplay: sends the requests of a workload capture file, recorded by mongosniff --record,
+ * to a server, with the timing they were captured with or scaled, and reports the latencies
+ * the server had for each type of operation.
+ */
+
+#define MONGO_PCH_WHITELISTED
+#include "mongo/platform/basic.h"
+#include "mongo/pch.h"
+#undef MONGO_PCH_WHITELISTED
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mongo/base/data_view.h"
+#include "mongo/base/initializer.h"
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/stats/latency_histogram.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/tools/workload_capture.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/queue.h"
+#include "mongo/util/quick_exit.h"
+#include "mongo/util/text.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
+
+using namespace mongo;
+using namespace std;
+
+namespace {
+
+    // How many bytes of records may wait for each replay thread.
+    const size_t kMaxQueuedBytesPerThread = 16 * 1024 * 1024;
+
+    size_t recordSize(const WorkloadRecord& record) {
+        return record.data.size() + 1;
+    }
+
+    /**
+     * Counts shared by all the replay threads.
+     */
+    struct ReplayStats {
+        OpLatencyStats latencies;
+        AtomicInt64 sent;
+        AtomicInt64 skipped;
+        AtomicInt64 failed;
+        AtomicInt64 connections;
+        AtomicInt64 maxLagMicros;
+    };
+
+    /**
+     * Where the cursor id of a getMore is, in place.
+     */
+    char* getMoreCursorId(Message& m) {
+        char* p = m.singleData().data() + sizeof(int);
+        p += strlen(p) + 1;
+        return p + sizeof(int);
+    }
+
+    /**
+     * Replays the captured connections assigned to it, each on a connection of its own to the
+     * target, in the order their records were captured in.
+     */
+    class ReplayThread {
+    public:
+        ReplayThread(const HostAndPort& target,
+                     double speed,
+                     ReplayStats* stats)
+            : _target(target),
+              _speed(speed),
+              _stats(stats),
+              _queue(kMaxQueuedBytesPerThread, &recordSize),
+              _startMicros(0),
+              _firstCapturedMicros(0) {
+        }
+
+        void start(unsigned long long startMicros, long long firstCapturedMicros) {
+            _startMicros = startMicros;
+            _firstCapturedMicros = firstCapturedMicros;
+            _thread.reset(new boost::thread(boost::bind(&ReplayThread::_run, this)));
+        }
+
+        void push(const WorkloadRecord& record) {
+            _queue.push(record);
+        }
+
+        // Waits for the records pushed so far to be replayed.
+        void finish() {
+            _queue.push(WorkloadRecord());
+            _thread->join();
+        }
+
+    private:
+        // The original request id of a request sent to the target, and what became of the
+        // cursor it used or opened.
+        struct SentRequest {
+            SentRequest() : capturedCursorId(0), targetCursorId(0) { }
+
+            long long capturedCursorId;
+            long long targetCursorId;
+        };
+
+        struct ReplayConnection {
+            boost::shared_ptr<DBClientConnection> conn;
+
+            // Captured cursor id -> cursor id on the target.
+            map<long long, long long> cursors;
+
+            // Captured request id -> the request, until its captured reply comes.
+            map<int, SentRequest> awaitingReply;
+        };
+
+        void _run() {
+            while (true) {
+                const WorkloadRecord record = _queue.blockingPop();
+                if (record.data.empty()) {
+                    return;
+                }
+
+                _waitForScheduledTime(record.micros);
+
+                ReplayConnection& rc = _connections[record.connectionId];
+                if (record.isReply()) {
+                    _processReply(&rc, record);
+                    continue;
+                }
+
+                try {
+                    _send(&rc, record);
+                }
+                catch (const DBException& e) {
+                    cerr << "error replaying request of connection " << record.connectionId
+                         << ": " << e.toString() << endl;
+                    _stats->failed.fetchAndAdd(1);
+                    rc.conn.reset();
+                }
+            }
+        }
+
+        void _waitForScheduledTime(long long capturedMicros) {
+            if (_speed <= 0) {
+                return;
+            }
+
+            const long long due = _startMicros +
+                static_cast<long long>((capturedMicros - _firstCapturedMicros) / _speed);
+            const long long now = curTimeMicros64();
+            if (due > now) {
+                sleepmicros(due - now);
+                return;
+            }
+
+            const long long lag = now - due;
+            long long maxLag = _stats->maxLagMicros.load();
+            while (lag > maxLag) {
+                const long long seen = _stats->maxLagMicros.compareAndSwap(maxLag, lag);
+                if (seen == maxLag) {
+                    break;
+                }
+                maxLag = seen;
+            }
+        }
+
+        void _processReply(ReplayConnection* rc, const WorkloadRecord& record) {
+            const QueryResult::ConstView reply = record.data.data();
+            map<int, SentRequest>::iterator it =
+                rc->awaitingReply.find(reply.msgdata().getResponseTo());
+            if (it == rc->awaitingReply.end()) {
+                return;
+            }
+
+            const long long capturedCursorId = reply.getCursorId();
+            if (it->second.capturedCursorId != 0 && capturedCursorId == 0) {
+                rc->cursors.erase(it->second.capturedCursorId);
+            }
+            else if (capturedCursorId != 0 && it->second.targetCursorId != 0) {
+                rc->cursors[capturedCursorId] = it->second.targetCursorId;
+            }
+            rc->awaitingReply.erase(it);
+        }
+
+        void _send(ReplayConnection* rc, const WorkloadRecord& record) {
+            Message m;
+            record.toMessage(&m);
+            const int capturedRequestId = m.header().getId();
+            const int op = m.operation();
+
+            SentRequest sent;
+            if (op == dbGetMore) {
+                // The cursor of a query we didn't replay, or one the target has exhausted
+                // already.
+                DataView cursorId(getMoreCursorId(m));
+                sent.capturedCursorId = cursorId.readLE<long long>();
+                map<long long, long long>::const_iterator it =
+                    rc->cursors.find(sent.capturedCursorId);
+                if (it == rc->cursors.end()) {
+                    _stats->skipped.fetchAndAdd(1);
+                    return;
+                }
+                cursorId.writeLE<long long>(it->second);
+            }
+            else if (op == dbKillCursors) {
+                char* p = m.singleData().data() + sizeof(int);
+                const int n = ConstDataView(p).readLE<int>();
+                p += sizeof(int);
+                for (int i = 0; i < n; i++, p += sizeof(long long)) {
+                    const long long captured = ConstDataView(p).readLE<long long>();
+                    map<long long, long long>::iterator it = rc->cursors.find(captured);
+                    DataView(p).writeLE<long long>(it == rc->cursors.end() ? 0 : it->second);
+                    if (it != rc->cursors.end()) {
+                        rc->cursors.erase(it);
+                    }
+                }
+            }
+
+            if (!rc->conn) {
+                rc->conn.reset(new DBClientConnection());
+                string errmsg;
+                uassert(28658,
+                        str::stream() << "couldn't connect to " << _target.toString() << ": "
+                                      << errmsg,
+                        rc->conn->connect(_target, errmsg));
+                _stats->connections.fetchAndAdd(1);
+            }
+
+            bool isCommand = false;
+            if (op == dbQuery) {
+                DbMessage d(m);
+                isCommand = nsIsFull(d.getns()) &&
+                    nsToCollectionSubstring(d.getns()) == "$cmd";
+            }
+
+            Timer timer;
+            if (op == dbQuery || op == dbGetMore) {
+                Message response;
+                uassert(28659, "connection closed by the target",
+                        rc->conn->port().call(m, response));
+                QueryResult::View result = response.singleData().view2ptr();
+                if (!(result.getResultFlags() & ResultFlag_CursorNotFound)) {
+                    sent.targetCursorId = result.getCursorId();
+                }
+                rc->awaitingReply[capturedRequestId] = sent;
+            }
+            else {
+                // Fire and forget, as the client sent them. Their latency is that of sending
+                // them; a getLastError sent after them waits for them on the target.
+                rc->conn->port().say(m);
+            }
+
+            _stats->latencies.record(op, isCommand, timer.micros());
+            _stats->sent.fetchAndAdd(1);
+        }
+
+        const HostAndPort _target;
+        const double _speed;
+        ReplayStats* const _stats;
+
+        BlockingQueue<WorkloadRecord> _queue;
+        boost::scoped_ptr<boost::thread> _thread;
+        unsigned long long _startMicros;
+        long long _firstCapturedMicros;
+
+        // Only used by the thread.
+        map<unsigned, ReplayConnection> _connections;
+    };
+
+    void usage() {
+        cout <<
+             "Usage: mongoreplay [--help] --host <host:port> [--threads <n>] [--speed <x>] <file>\n"
+             "--help          Print this help message.\n"
+             "--host          Server to send the captured requests to.\n"
+             "--threads       Number of threads replaying captured connections, 8 by default.\n"
+             "                All the requests of a captured connection are sent by the same\n"
+             "                thread, in order, on a connection of its own.\n"
+             "--speed         Replay at this many times the captured pace, 1 by default. With 0,\n"
+             "                each thread sends its requests as fast as the target answers.\n"
+             "<file>          Capture file written by mongosniff --record.\n"
+             "\n"
+             "Queries, getMores and commands are timed until their reply comes. Inserts,\n"
+             "updates and deletes are fire and forget, like the clients sent them, so only\n"
+             "the time to send them is. Once done, mongoreplay prints the latencies by type\n"
+             "of operation, in microseconds.\n"
+             << endl;
+    }
+
+} // namespace
+
+int toolMain(int argc, char** argv, char** envp) {
+    mongo::runGlobalInitializersOrDie(argc, argv, envp);
+
+    string host;
+    string file;
+    int numThreads = 8;
+    double speed = 1.0;
+
+    for (int i = 1; i < argc; ++i) {
+        const string arg = argv[i];
+        if (arg == "--help") {
+            usage();
+            return 0;
+        }
+        else if (arg == "--host" && i + 1 < argc) {
+            host = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            numThreads = atoi(argv[++i]);
+        }
+        else if (arg == "--speed" && i + 1 < argc) {
+            speed = atof(argv[++i]);
+        }
+        else if (file.empty() && arg.compare(0, 2, "--") != 0) {
+            file = arg;
+        }
+        else {
+            usage();
+            return -1;
+        }
+    }
+
+    if (host.empty() || file.empty() || numThreads < 1 || speed < 0) {
+        usage();
+        return -1;
+    }
+
+    try {
+        const HostAndPort target(host);
+        WorkloadCaptureReader reader(file);
+
+        WorkloadRecord record;
+        if (!reader.next(&record)) {
+            cout << file << " holds no requests" << endl;
+            return 0;
+        }
+
+        ReplayStats stats;
+        vector<boost::shared_ptr<ReplayThread> > threads;
+        const unsigned long long startMicros = curTimeMicros64();
+        const long long firstCapturedMicros = record.micros;
+        for (int i = 0; i < numThreads; i++) {
+            threads.push_back(boost::shared_ptr<ReplayThread>(
+                new ReplayThread(target, speed, &stats)));
+            threads.back()->start(startMicros, firstCapturedMicros);
+        }
+
+        long long lastCapturedMicros = record.micros;
+        do {
+            lastCapturedMicros = record.micros;
+            threads[record.connectionId % numThreads]->push(record);
+        } while (reader.next(&record));
+
+        for (size_t i = 0; i < threads.size(); i++) {
+            threads[i]->finish();
+        }
+        const long long elapsedMicros = curTimeMicros64() - startMicros;
+
+        cout << "replayed " << stats.sent.load() << " requests over "
+             << stats.connections.load() << " connections in " << elapsedMicros / 1000
+             << "ms, captured over " << (lastCapturedMicros - firstCapturedMicros) / 1000
+             << "ms" << endl;
+        cout << "skipped " << stats.skipped.load() << " getMores of unknown cursors, "
+             << stats.failed.load() << " requests failed, fell up to "
+             << stats.maxLagMicros.load() / 1000 << "ms behind schedule" << endl;
+
+        BSONObjBuilder latencies;
+        stats.latencies.append(&latencies);
+        cout << latencies.obj().jsonString(Strict, 1) << endl;
+    }
+    catch (const DBException& e) {
+        cerr << "mongoreplay: " << e.toString() << endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+#if defined(_WIN32)
+// In Windows, wmain() is an alternate entry point for main(), and receives the same parameters
+// as main() but encoded in Windows Unicode (UTF-16); "wide" 16-bit wchar_t characters.  The
+// WindowsCommandLine object converts these wide character strings to a UTF-8 coded equivalent
+// and makes them available through the argv() and envp() members.  This enables toolMain()
+// to process UTF-8 encoded arguments and environment variables without regard to platform.
+int wmain(int argc, wchar_t* argvW[], wchar_t* envpW[]) {
+    WindowsCommandLine wcl(argc, argvW, envpW);
+    int exitCode = toolMain(argc, wcl.argv(), wcl.envp());
+    mongo::quickExit(exitCode);
+}
+#else
+int main(int argc, char* argv[], char** envp) {
+    int exitCode = toolMain(argc, argv, envp);
+    mongo::quickExit(exitCode);
+}
+#endif
@@ -46,9 +46,11 @@
 #undef max
 #endif
 
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 #include <ctype.h>
 #include <errno.h>
+#include <signal.h>
 #include <iostream>
 #include <map>
 #include <pcap.h>
@@ -68,7 +70,9 @@
 #include "mongo/bson/util/builder.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/dbmessage.h"
+#include "mongo/tools/workload_capture.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compressor.h"
 #include "mongo/util/mmap.h"
 #include "mongo/util/quick_exit.h"
 #include "mongo/util/text.h"
@@ -81,6 +85,7 @@ using mongo::BSONObj;
 using mongo::BufBuilder;
 using mongo::DBClientConnection;
 using mongo::MemoryMappedFile;
+using mongo::WorkloadCaptureWriter;
 
 #define SNAP_LEN 65535
 
@@ -171,6 +176,19 @@ map< Connection, boost::shared_ptr<DBClientConnection> > forwarder;
 map< Connection, long long > lastCursor;
 map< Connection, map< long long, long long > > mapCursor;
 
+// Set with --record. The capture time of the packet being processed, and the ids given to the
+// client connections seen, by their client to server direction.
+boost::scoped_ptr<WorkloadCaptureWriter> recorder;
+long long packetMicros = 0;
+map< Connection, unsigned > connectionIds;
+
+// Stops pcap_loop() on SIGINT or SIGTERM while recording, so that the capture file is complete.
+pcap_t *sniffHandle = NULL;
+void stopSniffing( int sig ) {
+    if ( sniffHandle )
+        pcap_breakloop( sniffHandle );
+}
+
 void processMessage( Connection& c , Message& d );
 
 void got_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *packet) {
@@ -222,6 +240,8 @@ void got_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *pa
 
     expectedSeq[ c ] = ntohl( tcp->th_seq ) + size_payload;
 
+    packetMicros = header->ts.tv_sec * 1000000LL + header->ts.tv_usec;
+
     Message m;
 
     if ( bytesRemainingInMessage[ c ] == 0 ) {
@@ -282,7 +302,26 @@ public:
     }
 };
 
+void recordMessage( Connection& c , Message& m ) {
+    Connection client = ( m.operation() == mongo::opReply ) ? c.reverse() : c;
+    map< Connection, unsigned >::iterator i = connectionIds.find( client );
+    if ( i == connectionIds.end() ) {
+        unsigned id = connectionIds.size();
+        i = connectionIds.insert( make_pair( client, id ) ).first;
+    }
+    recorder->append( packetMicros, i->second, m );
+}
+
 void processMessage( Connection& c , Message& m ) {
+    if ( m.operation() == mongo::dbCompressed && !mongo::decompressMessage( &m ) ) {
+        cerr << "Error decompressing message" << endl;
+        return;
+    }
+
+    if ( recorder ) {
+        recordMessage( c , m );
+    }
+
     AuditingDbMessage d(m);
 
     if ( m.operation() == mongo::opReply )
@@ -440,7 +479,7 @@ void processDiagLog( const char * file ) {
 
 void usage() {
     cout <<
-         "Usage: mongosniff [--help] [--forward host:port] [--objcheck] [--source (NET <interface> | (FILE | DIAGLOG) <filename>)] [<port0> <port1> ... ]\n"
+         "Usage: mongosniff [--help] [--forward host:port] [--objcheck] [--record <file>] [--source (NET <interface> | (FILE | DIAGLOG) <filename>)] [<port0> <port1> ... ]\n"
          "--help          Print this help message.\n"
          "--forward       Forward all parsed request messages to mongod instance at \n"
          "                specified host:port\n"
@@ -449,6 +488,10 @@ void usage() {
          "                or a file containing output from mongod's --diaglog option.\n"
          "                If no source is specified, mongosniff will attempt to sniff\n"
          "                from one of the machine's network interfaces.\n"
+         "--record        Write the messages sniffed to a workload capture file for\n"
+         "                mongoreplay, with the time they were captured at, instead of\n"
+         "                printing them. Messages read from a diaglog have no time, so\n"
+         "                mongoreplay sends them as fast as it can.\n"
          "--objcheck      Log hex representation of invalid BSON documents and nothing\n"
          "                else.  Spurious messages about invalid documents may result\n"
          "                when there are dropped tcp packets.\n"
@@ -481,6 +524,7 @@ int toolMain(int argc, char **argv, char** envp) {
     bool replay = false;
     bool diaglog = false;
     const char *file = 0;
+    const char *recordFile = 0;
 
     vector< const char * > args;
     for( int i = 1; i < argc; ++i )
@@ -507,6 +551,10 @@ int toolMain(int argc, char **argv, char** envp) {
                 else
                     dev = args[ ++i ];
             }
+            else if ( arg == string( "--record" ) ) {
+                uassert( 28660 ,  "--record needs a file name" , args.size() > i + 1 );
+                recordFile = args[ ++i ];
+            }
             else if ( arg == string( "--objcheck" ) ) {
                 objcheck = true;
                 outPtr = &nullStream;
@@ -524,8 +572,23 @@ int toolMain(int argc, char **argv, char** envp) {
     if ( !serverPorts.size() )
         serverPorts.insert( 27017 );
 
+    if ( recordFile ) {
+        try {
+            recorder.reset( new WorkloadCaptureWriter( recordFile ) );
+        }
+        catch ( const mongo::DBException& e ) {
+            cerr << e.what() << endl;
+            return -1;
+        }
+        outPtr = &nullStream;
+    }
+
     if ( diaglog ) {
         processDiagLog( file );
+        if ( recorder ) {
+            cout << "recorded " << recorder->numRecords() << " messages" << endl;
+            recorder.reset();
+        }
         return 0;
     }
     else if ( replay ) {
@@ -575,8 +638,19 @@ int toolMain(int argc, char **argv, char** envp) {
         cout << *i << " ";
     cout << endl;
 
+    if ( recorder ) {
+        sniffHandle = handle;
+        signal( SIGINT , stopSniffing );
+        signal( SIGTERM , stopSniffing );
+    }
+
     pcap_loop(handle, 0 , got_packet, NULL);
 
+    if ( recorder ) {
+        cout << "recorded " << recorder->numRecords() << " messages" << endl;
+        recorder.reset();
+    }
+
     pcap_freecode(&fp);
     pcap_close(handle);
 
@@ -0,0 +1,149 @@
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/tools/workload_capture.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "mongo/base/data_view.h"
+#include "mongo/db/dbmessage.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+namespace {
+
+    const char kMagic[] = "MDBWLCAP";
+    const size_t kMagicLength = 8;
+    const int kVersion = 1;
+
+    const size_t kFileHeaderLength = kMagicLength + 2 * sizeof(int);
+    const size_t kRecordHeaderLength = sizeof(long long) + 2 * sizeof(int);
+
+    // The header of a reply and its fields up to and including nReturned.
+    const int kReplyPrefixLength = sizeof(QueryResult::Layout);
+
+    // Larger than any message a server accepts, so anything longer is a corrupt file.
+    const int kMaxRecordLength = 64 * 1024 * 1024;
+
+} // namespace
+
+    WorkloadCaptureWriter::WorkloadCaptureWriter(const std::string& path)
+        : _path(path),
+          _out(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc),
+          _numRecords(0) {
+
+        uassert(28652, str::stream() << "couldn't create capture file " << path, _out.good());
+
+        char header[kFileHeaderLength];
+        memcpy(header, kMagic, kMagicLength);
+        DataView(header).writeLE<int>(kVersion, kMagicLength);
+        DataView(header).writeLE<int>(0, kMagicLength + sizeof(int));
+        _out.write(header, sizeof(header));
+        uassert(28653, str::stream() << "couldn't write to capture file " << _path, _out.good());
+    }
+
+    void WorkloadCaptureWriter::append(long long micros,
+                                       unsigned connectionId,
+                                       const Message& m) {
+        int length = m.header().getLen();
+        if (m.operation() == opReply) {
+            length = std::min(length, kReplyPrefixLength);
+        }
+
+        char header[kRecordHeaderLength];
+        DataView(header).writeLE<long long>(micros);
+        DataView(header).writeLE<unsigned>(connectionId, sizeof(long long));
+        DataView(header).writeLE<int>(length, sizeof(long long) + sizeof(int));
+
+        _out.write(header, sizeof(header));
+        _out.write(m.singleData().view2ptr(), length);
+        uassert(28653, str::stream() << "couldn't write to capture file " << _path, _out.good());
+        _numRecords++;
+    }
+
+    bool WorkloadRecord::isReply() const {
+        return MSGHEADER::ConstView(data.data()).getOpCode() == opReply;
+    }
+
+    void WorkloadRecord::toMessage(Message* m) const {
+        invariant(!isReply());
+        char* buf = static_cast<char*>(mongoMalloc(data.size()));
+        memcpy(buf, data.data(), data.size());
+        m->setData(buf, true);
+    }
+
+    WorkloadCaptureReader::WorkloadCaptureReader(const std::string& path)
+        : _path(path),
+          _in(path.c_str(), std::ios::in | std::ios::binary) {
+
+        uassert(28654, str::stream() << "couldn't open capture file " << path, _in.good());
+
+        char header[kFileHeaderLength];
+        _in.read(header, sizeof(header));
+        uassert(28655, str::stream() << path << " is not a workload capture file",
+                _in.good() && memcmp(header, kMagic, kMagicLength) == 0);
+
+        const int version = ConstDataView(header).readLE<int>(kMagicLength);
+        uassert(28655, str::stream() << path << " has unsupported capture file version "
+                                     << version,
+                version == kVersion);
+    }
+
+    bool WorkloadCaptureReader::next(WorkloadRecord* record) {
+        char header[kRecordHeaderLength];
+        _in.read(header, sizeof(header));
+        if (_in.gcount() == 0 && _in.eof()) {
+            return false;
+        }
+        uassert(28656, str::stream() << "capture file " << _path << " is truncated",
+                _in.good());
+
+        record->micros = ConstDataView(header).readLE<long long>();
+        record->connectionId = ConstDataView(header).readLE<unsigned>(sizeof(long long));
+        const int length =
+            ConstDataView(header).readLE<int>(sizeof(long long) + sizeof(int));
+        uassert(28657, str::stream() << "capture file " << _path << " has a record of invalid "
+                                     << "length " << length,
+                length >= static_cast<int>(sizeof(MSGHEADER::Value)) &&
+                length <= kMaxRecordLength);
+
+        record->data.resize(length);
+        _in.read(&record->data[0], length);
+        uassert(28656, str::stream() << "capture file " << _path << " is truncated",
+                _in.good());
+        return true;
+    }
+
+} // namespace mongo
@@ -0,0 +1,115 @@
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+
+namespace mongo {
+
+    class Message;
+
+    /**
+     * A workload capture file holds the messages clients sent to a server, in the order and
+     * with the timing they were captured in, for mongoreplay to send to another server.
+     *
+     * It starts with the 8 byte magic "MDBWLCAP", followed by a little endian int32 version and
+     * an int32 reserved for flags. Then come the records, each with a little endian header:
+     *
+     *     int64  capture time, in microseconds since the epoch
+     *     int32  id of the client connection the message was captured on
+     *     int32  length of the message bytes that follow
+     *
+     * Requests are stored whole. Of replies, only the header and the fixed fields of the reply
+     * are, up to and including nReturned: the replayer only needs their cursor ids, to map the
+     * cursors of captured getMores and killCursors onto those of the target.
+     */
+    class WorkloadCaptureWriter {
+        MONGO_DISALLOW_COPYING(WorkloadCaptureWriter);
+    public:
+        /**
+         * Creates or truncates the capture file at 'path'. Throws if it can't.
+         */
+        explicit WorkloadCaptureWriter(const std::string& path);
+
+        /**
+         * Appends 'm', sent at 'micros' on the client connection identified by 'connectionId'.
+         */
+        void append(long long micros, unsigned connectionId, const Message& m);
+
+        long long numRecords() const { return _numRecords; }
+
+    private:
+        std::string _path;
+        std::ofstream _out;
+        long long _numRecords;
+    };
+
+    /**
+     * A record read from a capture file.
+     */
+    struct WorkloadRecord {
+        WorkloadRecord() : micros(0), connectionId(0) { }
+
+        bool isReply() const;
+
+        /**
+         * Fills the empty 'm' with a copy of the captured request. Not for replies, which are
+         * truncated.
+         */
+        void toMessage(Message* m) const;
+
+        long long micros;
+        unsigned connectionId;
+        std::string data;
+    };
+
+    class WorkloadCaptureReader {
+        MONGO_DISALLOW_COPYING(WorkloadCaptureReader);
+    public:
+        /**
+         * Opens the capture file at 'path' and checks its header. Throws if it can't.
+         */
+        explicit WorkloadCaptureReader(const std::string& path);
+
+        /**
+         * Reads the next record into 'record'. Returns false at the end of the file, and throws
+         * if the file ends in the middle of a record.
+         */
+        bool next(WorkloadRecord* record);
+
+    private:
+        std::string _path;
+        std::ifstream _in;
+    };
+
+} // namespace mongo
@@ -0,0 +1,128 @@
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/tools/workload_capture.h"
+
+#include <fstream>
+#include <string>
+
+#include "mongo/db/dbmessage.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+namespace {
+
+    TEST(WorkloadCapture, RoundTrip) {
+        unittest::TempDir dir("workload_capture_test");
+        const std::string path = dir.path() + "/capture";
+
+        const std::string body(1000, 'q');
+        Message query;
+        query.setData(dbQuery, body.data(), body.size());
+        query.header().setId(42);
+
+        const std::string replyBody(500, 'r');
+        Message reply;
+        reply.setData(opReply, replyBody.data(), replyBody.size());
+        reply.header().setResponseTo(42);
+        QueryResult::View(reply.singleData().view2ptr()).setCursorId(1234);
+
+        {
+            WorkloadCaptureWriter writer(path);
+            writer.append(1000000, 3, query);
+            writer.append(1000250, 3, reply);
+            ASSERT_EQUALS(2, writer.numRecords());
+        }
+
+        WorkloadCaptureReader reader(path);
+        WorkloadRecord record;
+
+        ASSERT_TRUE(reader.next(&record));
+        ASSERT_EQUALS(1000000, record.micros);
+        ASSERT_EQUALS(3U, record.connectionId);
+        ASSERT_FALSE(record.isReply());
+        Message replayed;
+        record.toMessage(&replayed);
+        ASSERT_EQUALS(dbQuery, replayed.operation());
+        ASSERT_EQUALS(42, replayed.header().getId());
+        ASSERT_EQUALS(query.size(), replayed.size());
+        ASSERT_EQUALS(body, std::string(replayed.singleData().data(), body.size()));
+
+        // Only the fixed fields of replies are kept.
+        ASSERT_TRUE(reader.next(&record));
+        ASSERT_EQUALS(1000250, record.micros);
+        ASSERT_TRUE(record.isReply());
+        ASSERT_EQUALS(sizeof(QueryResult::Layout), record.data.size());
+        const QueryResult::ConstView replyView = record.data.data();
+        ASSERT_EQUALS(42, replyView.msgdata().getResponseTo());
+        ASSERT_EQUALS(1234, replyView.getCursorId());
+
+        ASSERT_FALSE(reader.next(&record));
+    }
+
+    TEST(WorkloadCapture, RejectsOtherFiles) {
+        unittest::TempDir dir("workload_capture_test");
+        const std::string path = dir.path() + "/notACapture";
+        {
+            std::ofstream out(path.c_str());
+            out << "this is not a workload capture file";
+        }
+        ASSERT_THROWS(WorkloadCaptureReader reader(path), UserException);
+    }
+
+    TEST(WorkloadCapture, TruncatedRecordThrows) {
+        unittest::TempDir dir("workload_capture_test");
+        const std::string path = dir.path() + "/capture";
+
+        const std::string body(100, 'q');
+        Message query;
+        query.setData(dbQuery, body.data(), body.size());
+        {
+            WorkloadCaptureWriter writer(path);
+            writer.append(1, 1, query);
+        }
+        {
+            std::ifstream in(path.c_str(), std::ios::binary);
+            std::string contents((std::istreambuf_iterator<char>(in)),
+                                 std::istreambuf_iterator<char>());
+            std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+            out.write(contents.data(), contents.size() - 10);
+        }
+
+        WorkloadCaptureReader reader(path);
+        WorkloadRecord record;
+        ASSERT_THROWS(reader.next(&record), UserException);
+    }
+
+} // namespace
+} // namespace mongo
@@ -0,0 +1,264 @@
+// benchmark.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/unittest/benchmark.h"
+
+#include <algorithm>
+#include <boost/scoped_ptr.hpp>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace unittest {
+
+    const volatile void* benchmarkSink = NULL;
+
+namespace {
+
+    typedef std::map<std::string, Benchmark::Factory> BenchmarkMap;
+
+    BenchmarkMap& benchmarks() {
+        static BenchmarkMap* theBenchmarks = new BenchmarkMap();
+        return *theBenchmarks;
+    }
+
+    // Never grow the iteration count by more than this much between calibration runs, since
+    // the first few runs are too short to predict much from.
+    const double kMaxCalibrationGrowth = 100.0;
+
+    long long runOnce(Benchmark* benchmark, long long iterations, int threads) {
+        BenchmarkState state(iterations, threads);
+        benchmark->run(state);
+        uassert(28620, "benchmark body returned before keepRunning() returned false",
+                state.elapsedMicros() >= 0);
+        return state.elapsedMicros();
+    }
+
+    /**
+     * Returns an iteration count for which one run of 'benchmark' takes at least
+     * options.minRepetitionMicros.
+     */
+    long long calibrate(Benchmark* benchmark, const BenchmarkOptions& options) {
+        const long long minMicros = options.minRepetitionMicros;
+        long long iterations = 1;
+        while (true) {
+            const long long elapsed = runOnce(benchmark, iterations, options.threads);
+            if (elapsed >= minMicros) {
+                return iterations;
+            }
+
+            double growth = elapsed > 0 ? 1.4 * minMicros / elapsed : kMaxCalibrationGrowth;
+            growth = std::min(std::max(growth, 2.0), kMaxCalibrationGrowth);
+            iterations = static_cast<long long>(std::ceil(iterations * growth));
+        }
+    }
+
+    BenchmarkResult runBenchmark(const std::string& name,
+                                 Benchmark::Factory factory,
+                                 const BenchmarkOptions& options) {
+        boost::scoped_ptr<Benchmark> benchmark(factory());
+
+        BenchmarkResult result;
+        result.name = name;
+        result.iterations = calibrate(benchmark.get(), options);
+
+        for (int i = 0; i < options.warmupRepetitions; i++) {
+            runOnce(benchmark.get(), result.iterations, options.threads);
+        }
+
+        for (int i = 0; i < options.repetitions; i++) {
+            const long long elapsed =
+                runOnce(benchmark.get(), result.iterations, options.threads);
+            result.nanosPerIteration.push_back(1000.0 * elapsed / result.iterations);
+        }
+
+        std::sort(result.nanosPerIteration.begin(), result.nanosPerIteration.end());
+        return result;
+    }
+
+    void logResult(const BenchmarkResult& result) {
+        std::ostringstream line;
+        line << std::left << std::setw(48) << result.name << std::right << std::fixed
+             << std::setprecision(1)
+             << " iters: " << std::setw(10) << result.iterations
+             << " mean: " << std::setw(12) << result.mean()
+             << " stddev: " << std::setw(10) << result.stddev()
+             << " p50: " << std::setw(12) << result.percentile(50)
+             << " p90: " << std::setw(12) << result.percentile(90)
+             << " p99: " << std::setw(12) << result.percentile(99)
+             << " ns/iter";
+        log() << line.str();
+    }
+
+    void writeJson(const std::string& fileName,
+                   const BenchmarkOptions& options,
+                   const std::vector<BenchmarkResult>& results) {
+        BSONObjBuilder builder;
+        builder.append("unit", "ns/iter");
+        builder.append("warmupRepetitions", options.warmupRepetitions);
+        builder.append("repetitions", options.repetitions);
+        builder.append("minRepetitionMicros", options.minRepetitionMicros);
+        builder.append("threads", options.threads);
+
+        BSONArrayBuilder benchmarksBuilder(builder.subarrayStart("benchmarks"));
+        for (size_t i = 0; i < results.size(); i++) {
+            BSONObjBuilder resultBuilder(benchmarksBuilder.subobjStart());
+            results[i].appendTo(&resultBuilder);
+        }
+        benchmarksBuilder.doneFast();
+
+        const std::string json = builder.obj().jsonString(Strict, 1);
+        if (fileName == "-") {
+            std::cout << json << std::endl;
+            return;
+        }
+
+        std::ofstream out(fileName.c_str());
+        uassert(28621, str::stream() << "couldn't open " << fileName << " for writing",
+                out.good());
+        out << json << std::endl;
+    }
+
+}  // namespace
+
+    void Benchmark::registerBenchmark(const std::string& name, Factory factory) {
+        invariant(benchmarks().insert(std::make_pair(name, factory)).second);
+    }
+
+    double BenchmarkResult::percentile(double p) const {
+        if (nanosPerIteration.empty()) {
+            return 0;
+        }
+
+        // Nearest rank, so every percentile is an actual measurement.
+        const size_t n = nanosPerIteration.size();
+        size_t rank = static_cast<size_t>(std::ceil(p / 100 * n));
+        rank = std::min(std::max(rank, size_t(1)), n);
+        return nanosPerIteration[rank - 1];
+    }
+
+    double BenchmarkResult::mean() const {
+        if (nanosPerIteration.empty()) {
+            return 0;
+        }
+
+        double sum = 0;
+        for (size_t i = 0; i < nanosPerIteration.size(); i++) {
+            sum += nanosPerIteration[i];
+        }
+        return sum / nanosPerIteration.size();
+    }
+
+    double BenchmarkResult::stddev() const {
+        if (nanosPerIteration.size() < 2) {
+            return 0;
+        }
+
+        const double m = mean();
+        double sumSquares = 0;
+        for (size_t i = 0; i < nanosPerIteration.size(); i++) {
+            sumSquares += (nanosPerIteration[i] - m) * (nanosPerIteration[i] - m);
+        }
+        return std::sqrt(sumSquares / (nanosPerIteration.size() - 1));
+    }
+
+    void BenchmarkResult::appendTo(BSONObjBuilder* builder) const {
+        builder->append("name", name);
+        builder->append("iterations", iterations);
+        builder->append("mean", mean());
+        builder->append("stddev", stddev());
+        builder->append("min", percentile(0));
+        builder->append("p50", percentile(50));
+        builder->append("p90", percentile(90));
+        builder->append("p99", percentile(99));
+        builder->append("max", percentile(100));
+        builder->append("samples", nanosPerIteration);
+    }
+
+    std::vector<std::string> getBenchmarkNames() {
+        std::vector<std::string> names;
+        for (BenchmarkMap::const_iterator it = benchmarks().begin();
+             it != benchmarks().end();
+             ++it) {
+            names.push_back(it->first);
+        }
+        return names;
+    }
+
+    int runBenchmarks(const BenchmarkOptions& options) {
+        std::vector<BenchmarkResult> results;
+        int failures = 0;
+
+        for (BenchmarkMap::const_iterator it = benchmarks().begin();
+             it != benchmarks().end();
+             ++it) {
+            if (!options.filter.empty() && it->first.find(options.filter) == std::string::npos) {
+                continue;
+            }
+
+            try {
+                results.push_back(runBenchmark(it->first, it->second, options));
+                logResult(results.back());
+            }
+            catch (const std::exception& e) {
+                error() << it->first << " failed: " << e.what();
+                failures++;
+            }
+        }
+
+        if (!options.jsonFile.empty()) {
+            try {
+                writeJson(options.jsonFile, options, results);
+            }
+            catch (const std::exception& e) {
+                error() << "failed to write benchmark results: " << e.what();
+                failures++;
+            }
+        }
+
+        log() << "ran " << results.size() << " benchmarks, " << failures << " failed";
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+}  // namespace unittest
+}  // namespace mongo
@@ -0,0 +1,222 @@
+// benchmark.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/*
+ * A microbenchmark harness, in the spirit of the unit test framework in unittest.h.
+ *
+ * Usage:
+ *
+ *     BENCHMARK(BSONObjBuilder, TenInts) {
+ *         // Untimed setup goes here.
+ *         while (state.keepRunning()) {
+ *             BSONObjBuilder bob;
+ *             ...
+ *             doNotOptimizeAway(bob.obj());
+ *         }
+ *     }
+ *
+ * Each benchmark is first calibrated to an iteration count that makes one repetition last at
+ * least BenchmarkOptions::minRepetitionMicros, then run for some untimed warmup repetitions,
+ * then for the measured ones. The per-iteration times of the measured repetitions are
+ * summarized as mean, standard deviation and percentiles, and optionally written out as JSON.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/compiler.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+namespace unittest {
+
+    /**
+     * Handed to the body of a benchmark, which must run the code being measured for as long as
+     * keepRunning() returns true. Only the time between the first and the last call to
+     * keepRunning() is measured.
+     */
+    class BenchmarkState {
+        MONGO_DISALLOW_COPYING(BenchmarkState);
+    public:
+        BenchmarkState(long long iterations, int threads)
+            : _iterations(iterations),
+              _threads(threads),
+              _remaining(iterations),
+              _elapsedMicros(-1) {}
+
+        bool keepRunning() {
+            if (MONGO_likely(_remaining > 0)) {
+                if (MONGO_unlikely(_remaining == _iterations)) {
+                    _timer.reset();
+                }
+                _remaining--;
+                return true;
+            }
+            _elapsedMicros = _timer.micros();
+            return false;
+        }
+
+        long long iterations() const { return _iterations; }
+
+        /**
+         * Returns the number of threads, including the calling one, that benchmarks measuring
+         * behavior under concurrency should run their workload on. Others can ignore it.
+         */
+        int threads() const { return _threads; }
+
+        /**
+         * Returns the time taken by all the iterations, or -1 if the body has not finished its
+         * loop.
+         */
+        long long elapsedMicros() const { return _elapsedMicros; }
+
+    private:
+        const long long _iterations;
+        const int _threads;
+        long long _remaining;
+        long long _elapsedMicros;
+        Timer _timer;
+    };
+
+    /**
+     * Keeps the compiler from discarding the computation of 'value' as dead code.
+     */
+    template <typename T>
+    inline void doNotOptimizeAway(const T& value) {
+#if defined(__GNUC__)
+        asm volatile("" : : "r"(&value) : "memory");
+#else
+        extern const volatile void* benchmarkSink;
+        benchmarkSink = &value;
+#endif
+    }
+
+    /**
+     * Base class of the classes defined by the BENCHMARK macro. One instance runs all the
+     * repetitions of its benchmark.
+     */
+    class Benchmark {
+        MONGO_DISALLOW_COPYING(Benchmark);
+    public:
+        typedef Benchmark* (*Factory)();
+
+        Benchmark() {}
+        virtual ~Benchmark() {}
+
+        virtual void run(BenchmarkState& state) = 0;
+
+        template <typename T>
+        class RegistrationAgent {
+            MONGO_DISALLOW_COPYING(RegistrationAgent);
+        public:
+            RegistrationAgent(const std::string& suiteName, const std::string& benchmarkName) {
+                registerBenchmark(suiteName + "." + benchmarkName, &create);
+            }
+
+        private:
+            static Benchmark* create() { return new T(); }
+        };
+
+    private:
+        static void registerBenchmark(const std::string& name, Factory factory);
+    };
+
+    struct BenchmarkOptions {
+        BenchmarkOptions()
+            : warmupRepetitions(2), repetitions(10), minRepetitionMicros(10 * 1000), threads(1) {}
+
+        std::string filter; // only run benchmarks whose name contains this, if not empty
+        int warmupRepetitions;
+        int repetitions;
+        long long minRepetitionMicros;
+        int threads; // see BenchmarkState::threads()
+        std::string jsonFile; // write the results here as JSON, if not empty; "-" for stdout
+    };
+
+    /**
+     * The measurements of one benchmark, in nanoseconds per iteration.
+     */
+    struct BenchmarkResult {
+        BenchmarkResult() : iterations(0) {}
+
+        /**
+         * Returns the 'p'th percentile, 0 <= p <= 100, of the repetition times.
+         */
+        double percentile(double p) const;
+        double mean() const;
+        double stddev() const;
+
+        void appendTo(BSONObjBuilder* builder) const;
+
+        std::string name;
+        long long iterations; // per repetition
+        std::vector<double> nanosPerIteration; // one per measured repetition, sorted
+    };
+
+    /**
+     * Returns the names of the registered benchmarks, sorted.
+     */
+    std::vector<std::string> getBenchmarkNames();
+
+    /**
+     * Runs the registered benchmarks selected by 'options', logging a line per benchmark.
+     * Returns a process exit code.
+     */
+    int runBenchmarks(const BenchmarkOptions& options);
+
+}  // namespace unittest
+}  // namespace mongo
+
+#define BENCHMARK(SUITE_NAME, BENCHMARK_NAME) \
+    class _BENCHMARK_TYPE_NAME(SUITE_NAME, BENCHMARK_NAME) \
+            : public ::mongo::unittest::Benchmark { \
+    public: \
+        virtual void run(::mongo::unittest::BenchmarkState& state); \
+    private: \
+        static const RegistrationAgent<_BENCHMARK_TYPE_NAME(SUITE_NAME, BENCHMARK_NAME) > \
+            _agent; \
+    }; \
+    const ::mongo::unittest::Benchmark::RegistrationAgent< \
+            _BENCHMARK_TYPE_NAME(SUITE_NAME, BENCHMARK_NAME) > \
+        _BENCHMARK_TYPE_NAME(SUITE_NAME, BENCHMARK_NAME)::_agent(#SUITE_NAME, #BENCHMARK_NAME); \
+    void _BENCHMARK_TYPE_NAME(SUITE_NAME, BENCHMARK_NAME)::run( \
+            ::mongo::unittest::BenchmarkState& state)
+
+/**
+ * Macro to construct a type name for a benchmark. Do not use directly.
+ */
+#define _BENCHMARK_TYPE_NAME(SUITE_NAME, BENCHMARK_NAME) \
+    UnitBenchmark__##SUITE_NAME##__##BENCHMARK_NAME
@@ -0,0 +1,110 @@
+// benchmark_main.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mongo/base/initializer.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/signal_handlers_synchronous.h"
+
+namespace {
+
+    void usage(const char* program) {
+        std::cerr << "usage: " << program << " [options]\n"
+                  << "  --list                 list the benchmarks and exit\n"
+                  << "  --filter <substring>   only run benchmarks whose name contains this\n"
+                  << "  --warmup <n>           untimed repetitions per benchmark\n"
+                  << "  --repetitions <n>      timed repetitions per benchmark\n"
+                  << "  --minTimeMicros <n>    minimum duration of one repetition\n"
+                  << "  --threads <n>          threads for benchmarks that measure concurrency\n"
+                  << "  --json <file>          write the results as JSON, '-' for stdout\n";
+    }
+
+}  // namespace
+
+int main(int argc, char** argv, char** envp) {
+    ::mongo::setupSynchronousSignalHandlers();
+    ::mongo::runGlobalInitializersOrDie(1, argv, envp);
+
+    ::mongo::unittest::BenchmarkOptions options;
+    bool list = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--list") {
+            list = true;
+        }
+        else if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        }
+        else if (arg == "--warmup" && hasValue) {
+            options.warmupRepetitions = std::atoi(argv[++i]);
+        }
+        else if (arg == "--repetitions" && hasValue) {
+            options.repetitions = std::atoi(argv[++i]);
+        }
+        else if (arg == "--minTimeMicros" && hasValue) {
+            options.minRepetitionMicros = std::atoll(argv[++i]);
+        }
+        else if (arg == "--threads" && hasValue) {
+            options.threads = std::atoi(argv[++i]);
+        }
+        else if (arg == "--json" && hasValue) {
+            options.jsonFile = argv[++i];
+        }
+        else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (options.repetitions < 1 || options.warmupRepetitions < 0
+            || options.minRepetitionMicros < 1 || options.threads < 1) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (list) {
+        const std::vector<std::string> names = ::mongo::unittest::getBenchmarkNames();
+        for (size_t i = 0; i < names.size(); i++) {
+            std::cout << names[i] << std::endl;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    return ::mongo::unittest::runBenchmarks(options);
+}
@@ -0,0 +1,161 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/bump_arena.h"
+
+#include <boost/thread/tss.hpp>
+#include <cstdlib>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/allocator.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    namespace {
+        // Every allocation is preceded by a header telling free() where it came from. Its size
+        // keeps the allocations aligned on 16 bytes, like malloc().
+        union AllocationHeader {
+            void* chunk; // the BumpArena::Chunk, or NULL if the allocation came from the heap
+            char pad[16];
+        };
+        BOOST_STATIC_ASSERT(sizeof(AllocationHeader) == 16);
+
+        size_t alignUp(size_t bytes) {
+            return (bytes + 15) & ~size_t(15);
+        }
+
+        AllocationHeader* headerOf(const void* ptr) {
+            return reinterpret_cast<AllocationHeader*>(const_cast<char*>(
+                static_cast<const char*>(ptr) - sizeof(AllocationHeader)));
+        }
+
+        void noCleanup(BumpArena* arena) {}
+
+        // The arena isn't owned by the thread, so nothing is cleaned up on thread exit.
+        boost::thread_specific_ptr<BumpArena>& currentArena() {
+            static boost::thread_specific_ptr<BumpArena> arena(noCleanup);
+            return arena;
+        }
+    }  // namespace
+
+    struct BumpArena::Chunk {
+        // Live allocations, plus one while the chunk is the current one of its arena.
+        AtomicUInt32 refs;
+
+        // Bytes handed out so far, past the chunk header.
+        size_t used;
+
+        // The allocations start past the chunk header, aligned like the rest.
+        static size_t dataOffset() { return alignUp(sizeof(Chunk)); }
+        static size_t capacity() { return kChunkSize - dataOffset(); }
+        char* data() { return reinterpret_cast<char*>(this) + dataOffset(); }
+
+        void release() {
+            if (refs.subtractAndFetch(1) == 0) {
+                std::free(this);
+            }
+        }
+    };
+
+    BumpArena::BumpArena() : _current(NULL), _numChunksAllocated(0) {}
+
+    BumpArena::~BumpArena() {
+        if (_current) {
+            _current->release();
+        }
+    }
+
+    void* BumpArena::allocate(size_t bytes) {
+        BumpArena* arena = currentArena().get();
+        if (arena && bytes <= kMaxArenaAllocation) {
+            return arena->_allocate(bytes);
+        }
+
+        AllocationHeader* header =
+            static_cast<AllocationHeader*>(mongoMalloc(sizeof(AllocationHeader) + bytes));
+        header->chunk = NULL;
+        return header + 1;
+    }
+
+    void BumpArena::free(void* ptr) {
+        if (!ptr) {
+            return;
+        }
+
+        AllocationHeader* header = headerOf(ptr);
+        if (header->chunk) {
+            static_cast<Chunk*>(header->chunk)->release();
+        }
+        else {
+            std::free(header);
+        }
+    }
+
+    bool BumpArena::isInArena(const void* ptr) {
+        return headerOf(ptr)->chunk != NULL;
+    }
+
+    void* BumpArena::_allocate(size_t bytes) {
+        const size_t needed = alignUp(sizeof(AllocationHeader) + bytes);
+
+        // Only this thread takes references to the current chunk, so if ours is the only one
+        // left, nothing allocated from the chunk is alive and we can start it over.
+        if (_current && _current->refs.load() == 1) {
+            _current->used = 0;
+        }
+
+        if (!_current || _current->used + needed > Chunk::capacity()) {
+            if (_current) {
+                _current->release();
+            }
+            _current = static_cast<Chunk*>(mongoMalloc(kChunkSize));
+            new (&_current->refs) AtomicUInt32(1);
+            _current->used = 0;
+            ++_numChunksAllocated;
+        }
+
+        AllocationHeader* header =
+            reinterpret_cast<AllocationHeader*>(_current->data() + _current->used);
+        _current->used += needed;
+        _current->refs.addAndFetch(1);
+        header->chunk = _current;
+        return header + 1;
+    }
+
+    BumpArena::Scope::Scope(BumpArena* arena) : _previous(currentArena().get()) {
+        currentArena().reset(arena);
+    }
+
+    BumpArena::Scope::~Scope() {
+        currentArena().reset(_previous);
+    }
+
+}  // namespace mongo
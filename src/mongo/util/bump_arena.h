@@ -0,0 +1,116 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "mongo/base/disallow_copying.h"
+
+namespace mongo {
+
+    /**
+     * A bump allocator for the short-lived objects of a single operation, such as the documents
+     * and strings an aggregation pipeline builds for each result. Memory is carved out of large
+     * chunks one allocation after the other, instead of going through malloc() every time.
+     *
+     * Allocations go through the static allocate() and free(), which use the arena made current
+     * on this thread by a BumpArena::Scope, or the heap when there is none or the allocation is
+     * large. free() handles both, so code allocating this way doesn't need to know where its
+     * memory came from.
+     *
+     * Each chunk counts the allocations still alive in it. The current chunk is reused from the
+     * start once all of them are freed, which happens between batches when nothing outlives the
+     * batch that made it. A chunk still holding live allocations when it fills up, or when the
+     * arena goes away, is freed with its last allocation: objects escaping the arena pin memory
+     * but never dangle. Callers keeping objects for long should still copy them out of the arena
+     * (see isInArena()) so that they don't pin whole chunks.
+     *
+     * An arena is only used by one thread at a time, but its allocations may be freed from any.
+     */
+    class BumpArena {
+        MONGO_DISALLOW_COPYING(BumpArena);
+    public:
+        // Size of the chunks allocations are carved out of.
+        static const size_t kChunkSize = 64 * 1024;
+
+        // Allocations larger than this always go to the heap.
+        static const size_t kMaxArenaAllocation = 4 * 1024;
+
+        BumpArena();
+
+        ~BumpArena();
+
+        /**
+         * Returns 'bytes' bytes aligned on 16 bytes, from the current arena of this thread if any.
+         * Must be freed with free().
+         */
+        static void* allocate(size_t bytes);
+
+        /**
+         * Frees memory returned by allocate(). NULL is ignored.
+         */
+        static void free(void* ptr);
+
+        /**
+         * Returns true if 'ptr', returned by allocate(), came from an arena rather than the heap.
+         */
+        static bool isInArena(const void* ptr);
+
+        /**
+         * Makes 'arena' the current arena of this thread until the Scope is destroyed, at which
+         * point the previous one is current again. A NULL 'arena' sends allocations to the heap.
+         */
+        class Scope {
+            MONGO_DISALLOW_COPYING(Scope);
+        public:
+            explicit Scope(BumpArena* arena);
+            ~Scope();
+
+        private:
+            BumpArena* const _previous;
+        };
+
+        /**
+         * How many chunks this arena started, for tests and stats.
+         */
+        size_t numChunksAllocated() const { return _numChunksAllocated; }
+
+    private:
+        struct Chunk;
+
+        void* _allocate(size_t bytes);
+
+        // The chunk allocations are carved out of, or NULL before the first one. The arena holds
+        // a reference to it, so it isn't freed when its allocations are.
+        Chunk* _current;
+
+        size_t _numChunksAllocated;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,115 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/bump_arena.h"
+
+namespace {
+
+    using mongo::BumpArena;
+
+    TEST(BumpArena, HeapWithoutScope) {
+        void* ptr = BumpArena::allocate(32);
+        ASSERT_FALSE(BumpArena::isInArena(ptr));
+        BumpArena::free(ptr);
+        BumpArena::free(NULL);
+    }
+
+    TEST(BumpArena, AllocatesFromCurrentArena) {
+        BumpArena arena;
+        BumpArena::Scope scope(&arena);
+
+        void* small = BumpArena::allocate(100);
+        void* large = BumpArena::allocate(BumpArena::kMaxArenaAllocation + 1);
+        ASSERT_TRUE(BumpArena::isInArena(small));
+        ASSERT_FALSE(BumpArena::isInArena(large));
+        ASSERT_EQUALS(0U, reinterpret_cast<size_t>(small) % 16);
+        ASSERT_EQUALS(0U, reinterpret_cast<size_t>(large) % 16);
+        BumpArena::free(small);
+        BumpArena::free(large);
+        ASSERT_EQUALS(1U, arena.numChunksAllocated());
+    }
+
+    TEST(BumpArena, NullScopeUsesHeap) {
+        BumpArena arena;
+        BumpArena::Scope scope(&arena);
+        {
+            BumpArena::Scope heapScope(NULL);
+            void* ptr = BumpArena::allocate(16);
+            ASSERT_FALSE(BumpArena::isInArena(ptr));
+            BumpArena::free(ptr);
+        }
+        void* ptr = BumpArena::allocate(16);
+        ASSERT_TRUE(BumpArena::isInArena(ptr));
+        BumpArena::free(ptr);
+    }
+
+    TEST(BumpArena, ReusesChunkOnceEverythingIsFreed) {
+        BumpArena arena;
+        BumpArena::Scope scope(&arena);
+
+        // Far more than a chunk in total, but never more than one batch alive at a time.
+        for (int batch = 0; batch < 100; batch++) {
+            void* ptrs[10];
+            for (int i = 0; i < 10; i++) {
+                ptrs[i] = BumpArena::allocate(1000);
+            }
+            for (int i = 0; i < 10; i++) {
+                BumpArena::free(ptrs[i]);
+            }
+        }
+        ASSERT_EQUALS(1U, arena.numChunksAllocated());
+    }
+
+    TEST(BumpArena, StartsNewChunkWhenFull) {
+        BumpArena arena;
+        BumpArena::Scope scope(&arena);
+
+        void* pinned = BumpArena::allocate(16);
+        for (int i = 0; i < 100; i++) {
+            BumpArena::free(BumpArena::allocate(1000));
+        }
+        ASSERT_GREATER_THAN(arena.numChunksAllocated(), 1U);
+        BumpArena::free(pinned);
+    }
+
+    TEST(BumpArena, AllocationOutlivesArena) {
+        char* ptr;
+        {
+            BumpArena arena;
+            BumpArena::Scope scope(&arena);
+            ptr = static_cast<char*>(BumpArena::allocate(64));
+            memset(ptr, 'x', 64);
+        }
+        ASSERT_EQUALS('x', ptr[63]);
+        BumpArena::free(ptr);
+    }
+
+}  // namespace
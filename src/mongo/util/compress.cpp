@@ -30,10 +30,54 @@
 
 #include "mongo/util/compress.h"
 
+#include <boost/bind.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include "snappy.h"
 
 namespace mongo {
 
+namespace {
+
+    /**
+     * A compressed stream starts with the length of its uncompressed input, encoded as a varint,
+     * followed by the compressed blocks of kBlockSize bytes of input each. Since no block refers
+     * to data from another one, the input can be compressed in parts, which start at multiples
+     * of kBlockSize, and those can be joined by dropping their lengths.
+     */
+    struct CompressPart {
+        const char* input;
+        size_t length;
+        boost::scoped_array<char> compressed;
+        size_t compressedLength;
+    };
+
+    void compressPart(CompressPart* part) {
+        rawCompress(part->input, part->length, part->compressed.get(), &part->compressedLength);
+    }
+
+    // Appends the varint encoding of 'value' to 'out' and returns the end of it
+    char* encodeVarint(char* out, size_t value) {
+        while (value >= 0x80) {
+            *out++ = static_cast<char>(value | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<char>(value);
+        return out;
+    }
+
+    size_t varintLength(size_t value) {
+        char buf[10];
+        return encodeVarint(buf, value) - buf;
+    }
+
+} // namespace
+
     void rawCompress(const char* input,
         size_t input_length,
         char* compressed,
@@ -54,4 +98,74 @@ namespace mongo {
         return snappy::Uncompress(compressed, compressed_length, uncompressed);
     }
 
+    bool uncompressedLength(const char* compressed, size_t compressed_length, size_t* result) {
+        return snappy::GetUncompressedLength(compressed, compressed_length, result);
+    }
+
+    bool rawUncompress(const char* compressed, size_t compressed_length, char* uncompressed) {
+        return snappy::RawUncompress(compressed, compressed_length, uncompressed);
+    }
+
+    void rawCompressParallel(const char* input,
+        size_t input_length,
+        char* compressed,
+        size_t* compressed_length,
+        size_t numThreads)
+    {
+        const size_t numBlocks = (input_length + snappy::kBlockSize - 1) / snappy::kBlockSize;
+        if (numThreads > numBlocks) {
+            numThreads = numBlocks;
+        }
+
+        if (numThreads <= 1) {
+            rawCompress(input, input_length, compressed, compressed_length);
+            return;
+        }
+
+        const size_t partLength =
+            ((numBlocks + numThreads - 1) / numThreads) * snappy::kBlockSize;
+
+        // Allocate everything up front, so only starting the threads can fail below
+        std::vector<boost::shared_ptr<CompressPart> > parts;
+        for (size_t offset = 0; offset < input_length; offset += partLength) {
+            boost::shared_ptr<CompressPart> part(new CompressPart());
+            part->input = input + offset;
+            part->length = std::min(partLength, input_length - offset);
+            part->compressed.reset(new char[maxCompressedLength(part->length)]);
+            part->compressedLength = 0;
+            parts.push_back(part);
+        }
+
+        std::vector<boost::shared_ptr<boost::thread> > threads;
+        try {
+            for (size_t i = 1; i < parts.size(); i++) {
+                threads.push_back(boost::shared_ptr<boost::thread>(
+                    new boost::thread(boost::bind(compressPart, parts[i].get()))));
+            }
+        }
+        catch (...) {
+            for (size_t i = 0; i < threads.size(); i++) {
+                threads[i]->join();
+            }
+            throw;
+        }
+
+        compressPart(parts[0].get());
+
+        for (size_t i = 0; i < threads.size(); i++) {
+            threads[i]->join();
+        }
+
+        // Join the parts under the length of the whole input
+        char* out = encodeVarint(compressed, input_length);
+        for (size_t i = 0; i < parts.size(); i++) {
+            const size_t headerLength = varintLength(parts[i]->length);
+            const size_t blocksLength = parts[i]->compressedLength - headerLength;
+            memcpy(out, parts[i]->compressed.get() + headerLength, blocksLength);
+            out += blocksLength;
+        }
+
+        *compressed_length = out - compressed;
+    }
+
 }
@@ -38,12 +38,35 @@ namespace mongo {
 
     bool uncompress(const char* compressed, size_t compressed_length, std::string* uncompressed);
 
+    /**
+     * Sets 'result' to the length 'compressed' uncompresses to. Returns false if the header of
+     * 'compressed' is corrupt.
+     */
+    bool uncompressedLength(const char* compressed, size_t compressed_length, size_t* result);
+
+    /**
+     * Uncompresses 'compressed' into 'uncompressed', which must have room for
+     * uncompressedLength() bytes. Returns false if 'compressed' is corrupt.
+     */
+    bool rawUncompress(const char* compressed, size_t compressed_length, char* uncompressed);
+
     size_t maxCompressedLength(size_t source_len);
     void rawCompress(const char* input,
         size_t input_length,
         char* compressed,
         size_t* compressed_length);
 
+    /**
+     * Same as rawCompress, and gives exactly the same output, but compresses the input in up to
+     * 'numThreads' parts concurrently. The calling thread compresses one of them. 'compressed'
+     * must have room for maxCompressedLength(input_length) bytes.
+     */
+    void rawCompressParallel(const char* input,
+        size_t input_length,
+        char* compressed,
+        size_t* compressed_length,
+        size_t numThreads);
+
 }
 
 
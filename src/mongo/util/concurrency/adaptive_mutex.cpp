@@ -0,0 +1,141 @@
+// adaptive_mutex.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/adaptive_mutex.h"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "mongo/bson/inline_decls.h"
+
+namespace mongo {
+
+namespace {
+
+    // Bounds on how many times a contended lock() retries before sleeping.
+    const int kMinSpins = 10;
+    const int kMaxSpins = 100;
+
+    /**
+     * Spinning only helps while the holder is running on another CPU.
+     */
+    bool spinningCanHelp() {
+#if defined(__linux__)
+        return sysconf(_SC_NPROCESSORS_ONLN) > 1;
+#else
+        return true;
+#endif
+    }
+
+    const bool kSpin = spinningCanHelp();
+
+    inline void cpuRelax() {
+#if defined(__i386__) || defined(__x86_64__)
+        asm volatile ("pause");
+#endif
+    }
+
+#if defined(__linux__)
+    void futexWait(volatile int* addr, int expected) {
+        // Returns early if *addr is no longer 'expected', or on a signal. Callers recheck.
+        syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+    }
+
+    void futexWakeOne(volatile int* addr) {
+        syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+#endif
+
+} // namespace
+
+    AdaptiveMutex::AdaptiveMutex(Stats* stats)
+        :
+#if defined(__linux__)
+          _state(kUnlocked),
+#endif
+          _spinEstimate(kMinSpins * 8),
+          _stats(stats) {}
+
+    NOINLINE_DECL void AdaptiveMutex::_lockContended() {
+        if (_stats) {
+            _stats->contended.fetchAndAdd(1);
+        }
+
+        if (kSpin) {
+            const int maxSpins = std::min(kMaxSpins, 2 * (_spinEstimate / 8) + kMinSpins);
+            for (int spins = 1; spins <= maxSpins; spins++) {
+                cpuRelax();
+#if defined(__linux__)
+                if (_state != kUnlocked) {
+                    continue;
+                }
+#endif
+                if (try_lock()) {
+                    _spinEstimate += spins - _spinEstimate / 8;
+                    return;
+                }
+            }
+        }
+
+        if (_stats) {
+            _stats->slept.fetchAndAdd(1);
+        }
+
+#if defined(__linux__)
+        // Mark the mutex as having waiters before sleeping, so that unlock() wakes one up. Once
+        // marked it stays so until unlocked, even if this thread is the last waiter, which only
+        // costs an unneeded wakeup.
+        while (__sync_lock_test_and_set(&_state, kLockedWithWaiters) != kUnlocked) {
+            futexWait(&_state, kLockedWithWaiters);
+        }
+#else
+        _mutex.lock();
+#endif
+
+        // Spinning wasn't long enough, so spin for longer next time.
+        _spinEstimate += kMaxSpins - _spinEstimate / 8;
+    }
+
+#if defined(__linux__)
+    NOINLINE_DECL void AdaptiveMutex::_unlockContended() {
+        // _state was kLockedWithWaiters, and is now kLocked until this releases it.
+        __sync_lock_release(&_state);
+        futexWakeOne(&_state);
+    }
+#endif
+
+} // namespace mongo
@@ -0,0 +1,127 @@
+// adaptive_mutex.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#if !defined(__linux__)
+#include <boost/thread/mutex.hpp>
+#endif
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/compiler.h"
+
+namespace mongo {
+
+    /**
+     * A mutex for short critical sections on hot paths, to use where SpinLock would waste CPU
+     * once contended. A thread finding it locked spins for a while, in case the holder is about
+     * to release it, and then sleeps until woken by unlock(). How long it spins adapts to how
+     * long past acquisitions had to spin to succeed, as with glibc's adaptive pthread mutexes.
+     *
+     * On Linux the lock is a single futex word: locking and unlocking without contention are one
+     * atomic instruction each, with no system call. Elsewhere it spins on a boost::mutex.
+     *
+     * Contention can be profiled by passing a Stats, which may be shared by many mutexes, such as
+     * all the buckets of a hash table. Acquisitions without contention are not counted, so cost
+     * nothing extra.
+     */
+    class AdaptiveMutex {
+        MONGO_DISALLOW_COPYING(AdaptiveMutex);
+    public:
+        struct Stats {
+            // Acquisitions which found the mutex locked.
+            AtomicUInt64 contended;
+
+            // Of those, the ones which stopped spinning and slept.
+            AtomicUInt64 slept;
+        };
+
+        explicit AdaptiveMutex(Stats* stats = NULL);
+
+        void lock() {
+            if (MONGO_likely(try_lock())) {
+                return;
+            }
+            _lockContended();
+        }
+
+#if defined(__linux__)
+        bool try_lock() {
+            return __sync_bool_compare_and_swap(&_state, kUnlocked, kLocked);
+        }
+
+        void unlock() {
+            if (MONGO_unlikely(__sync_fetch_and_sub(&_state, 1) != kLocked)) {
+                _unlockContended();
+            }
+        }
+#else
+        bool try_lock() { return _mutex.try_lock(); }
+        void unlock() { _mutex.unlock(); }
+#endif
+
+        class scoped_lock {
+            MONGO_DISALLOW_COPYING(scoped_lock);
+        public:
+            explicit scoped_lock(AdaptiveMutex& m) : _m(m) { _m.lock(); }
+            ~scoped_lock() { _m.unlock(); }
+
+        private:
+            AdaptiveMutex& _m;
+        };
+
+    private:
+        void _lockContended();
+
+#if defined(__linux__)
+        void _unlockContended();
+
+        enum State {
+            kUnlocked = 0,
+            kLocked = 1,
+
+            // Locked, and there may be threads asleep waiting for it.
+            kLockedWithWaiters = 2,
+        };
+
+        volatile int _state;
+#else
+        boost::mutex _mutex;
+#endif
+
+        // Running average of the spins needed by acquisitions which spun and then succeeded,
+        // times 8. Only written while holding the mutex.
+        volatile int _spinEstimate;
+
+        Stats* const _stats;
+    };
+
+} // namespace mongo
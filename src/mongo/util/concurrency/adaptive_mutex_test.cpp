@@ -0,0 +1,104 @@
+// adaptive_mutex_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/thread/thread.hpp>
+
+#include "mongo/stdx/functional.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/adaptive_mutex.h"
+
+namespace mongo {
+namespace {
+
+    void incrementUnderMutex(AdaptiveMutex* mutex, int* counter, int increments) {
+        for (int i = 0; i < increments; i++) {
+            AdaptiveMutex::scoped_lock lk(*mutex);
+            ++(*counter);
+        }
+    }
+
+    TEST(AdaptiveMutex, TryLock) {
+        AdaptiveMutex mutex;
+        ASSERT(mutex.try_lock());
+        ASSERT(!mutex.try_lock());
+        mutex.unlock();
+        ASSERT(mutex.try_lock());
+        mutex.unlock();
+    }
+
+    TEST(AdaptiveMutex, UncontendedIsNotCounted) {
+        AdaptiveMutex::Stats stats;
+        AdaptiveMutex mutex(&stats);
+        int counter = 0;
+        incrementUnderMutex(&mutex, &counter, 1000);
+        ASSERT_EQUALS(1000, counter);
+        ASSERT_EQUALS(0U, stats.contended.load());
+        ASSERT_EQUALS(0U, stats.slept.load());
+    }
+
+    TEST(AdaptiveMutex, ConcurrentIncs) {
+        AdaptiveMutex::Stats stats;
+        AdaptiveMutex mutex(&stats);
+        int counter = 0;
+
+        const int threads = 64;
+        const int incs = 50000;
+        boost::thread_group group;
+        for (int i = 0; i < threads; i++) {
+            group.create_thread(stdx::bind(&incrementUnderMutex, &mutex, &counter, incs));
+        }
+        group.join_all();
+
+        ASSERT_EQUALS(threads * incs, counter);
+        ASSERT_LESS_THAN_OR_EQUALS(stats.slept.load(), stats.contended.load());
+    }
+
+    TEST(AdaptiveMutex, WakesSleepers) {
+        // Holding the mutex long enough for the other thread to stop spinning and sleep.
+        AdaptiveMutex::Stats stats;
+        AdaptiveMutex mutex(&stats);
+        int counter = 0;
+
+        mutex.lock();
+        boost::thread other(stdx::bind(&incrementUnderMutex, &mutex, &counter, 1));
+        while (stats.slept.load() == 0) {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        }
+        mutex.unlock();
+        other.join();
+
+        ASSERT_EQUALS(1, counter);
+        ASSERT_EQUALS(1U, stats.contended.load());
+    }
+
+} // namespace
+} // namespace mongo
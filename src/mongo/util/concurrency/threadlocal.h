@@ -99,6 +99,12 @@ namespace mongo {
                 reset( t = new T() );
             return t;
         }
+        /** detaches the current value from this thread without deleting it */
+        T* release() {
+            T* t = tsp.release();
+            reset( 0 );
+            return t;
+        }
     };
 
 # if defined(MONGO_HAVE___DECLSPEC_THREAD)
@@ -164,6 +170,13 @@ namespace mongo {
             }
             return t;
         }
+
+        /** detaches the current value from this thread without deleting it */
+        T* release() {
+            T* t = get();
+            verify( pthread_setspecific( _key, 0 ) == 0 );
+            return t;
+        }
     };
 
 #  define TSP_DECLARE(T,p) extern TSP<T> p;
@@ -184,6 +197,8 @@ namespace mongo {
                 reset( t = new T() );
             return t;
         }
+        /** detaches the current value from this thread without deleting it */
+        T* release() { return tsp.release(); }
     };
 
 #  define TSP_DECLARE(T,p) extern TSP<T> p;
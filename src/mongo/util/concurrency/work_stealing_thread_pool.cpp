@@ -0,0 +1,300 @@
+// work_stealing_thread_pool.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kControl
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/work_stealing_thread_pool.h"
+
+#include <algorithm>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+namespace {
+
+    /**
+     * Which pool, and which worker in it, the current thread is.
+     */
+    struct CurrentWorker {
+        CurrentWorker(const WorkStealingThreadPool* pool, int index)
+            : pool(pool), index(index) {}
+
+        const WorkStealingThreadPool* pool;
+        int index;
+    };
+
+    boost::thread_specific_ptr<CurrentWorker> currentWorker;
+
+    void pinToCpu(int index) {
+#if defined(__linux__)
+        const long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+        if (numCpus <= 0) {
+            return;
+        }
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(index % numCpus, &cpus);
+        const int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (err != 0) {
+            warning() << "could not pin thread " << getThreadName() << " to CPU "
+                      << index % numCpus << ": " << errnoWithDescription(err);
+        }
+#endif
+    }
+
+} // namespace
+
+    class WorkStealingThreadPool::Worker : boost::noncopyable {
+    public:
+        boost::mutex mutex;
+        std::deque<QueuedTask> tasks;
+        boost::scoped_ptr<boost::thread> thread;
+    };
+
+    WorkStealingThreadPool::TaskGroup::TaskGroup(WorkStealingThreadPool* pool)
+        : _pool(pool), _remaining(0) {}
+
+    WorkStealingThreadPool::TaskGroup::~TaskGroup() {
+        join();
+    }
+
+    void WorkStealingThreadPool::TaskGroup::schedule(const Task& task) {
+        {
+            boost::mutex::scoped_lock lk(_mutex);
+            _remaining++;
+        }
+        _pool->_schedule(QueuedTask(task, this));
+    }
+
+    void WorkStealingThreadPool::TaskGroup::join() {
+        while (true) {
+            {
+                boost::mutex::scoped_lock lk(_mutex);
+                if (_remaining == 0) {
+                    return;
+                }
+            }
+
+            if (_pool->_helpWhileWaiting()) {
+                continue;
+            }
+
+            // Wake up now and then to help with tasks scheduled since.
+            boost::mutex::scoped_lock lk(_mutex);
+            if (_remaining == 0) {
+                return;
+            }
+            _done.timed_wait(lk, boost::posix_time::milliseconds(2));
+        }
+    }
+
+    void WorkStealingThreadPool::TaskGroup::_taskDone() {
+        boost::mutex::scoped_lock lk(_mutex);
+        if (--_remaining == 0) {
+            _done.notify_all();
+        }
+    }
+
+    WorkStealingThreadPool::WorkStealingThreadPool(int nThreads,
+                                                   const std::string& threadNamePrefix,
+                                                   bool pinThreads)
+        : _shutdown(false) {
+        nThreads = std::max(nThreads, 1);
+
+        // All the deques exist before any worker can steal from them.
+        for (int i = 0; i < nThreads; i++) {
+            _workers.push_back(new Worker());
+        }
+        for (int i = 0; i < nThreads; i++) {
+            const std::string threadName = str::stream() << threadNamePrefix << i;
+            _workers[i]->thread.reset(new boost::thread(
+                stdx::bind(&WorkStealingThreadPool::_workerLoop, this, i, threadName,
+                           pinThreads)));
+        }
+    }
+
+    WorkStealingThreadPool::~WorkStealingThreadPool() {
+        join();
+
+        {
+            boost::mutex::scoped_lock lk(_sleepMutex);
+            _shutdown = true;
+        }
+        _wakeup.notify_all();
+
+        for (size_t i = 0; i < _workers.size(); i++) {
+            _workers[i]->thread->join();
+            delete _workers[i];
+        }
+    }
+
+    void WorkStealingThreadPool::schedule(const Task& task) {
+        _schedule(QueuedTask(task, NULL));
+    }
+
+    void WorkStealingThreadPool::join() {
+        boost::mutex::scoped_lock lk(_sleepMutex);
+        while (_remaining.load() > 0) {
+            _idle.wait(lk);
+        }
+    }
+
+    void WorkStealingThreadPool::_schedule(const QueuedTask& task) {
+        _remaining.fetchAndAdd(1);
+
+        const CurrentWorker* current = currentWorker.get();
+        const size_t target = (current && current->pool == this) ?
+            current->index : _nextWorker.fetchAndAdd(1) % _workers.size();
+
+        // Counted before it is queued, so that _queued never goes below 0. A worker may look
+        // for it a little early.
+        _queued.fetchAndAdd(1);
+        {
+            boost::mutex::scoped_lock lk(_workers[target]->mutex);
+            _workers[target]->tasks.push_back(task);
+        }
+
+        if (_sleepers.load() > 0) {
+            boost::mutex::scoped_lock lk(_sleepMutex);
+            _wakeup.notify_one();
+        }
+    }
+
+    bool WorkStealingThreadPool::_takeTask(int self, QueuedTask* out) {
+        if (self >= 0) {
+            Worker* worker = _workers[self];
+            boost::mutex::scoped_lock lk(worker->mutex);
+            if (!worker->tasks.empty()) {
+                *out = worker->tasks.back();
+                worker->tasks.pop_back();
+                _queued.fetchAndSubtract(1);
+                return true;
+            }
+        }
+
+        const size_t numWorkers = _workers.size();
+        const size_t start = self >= 0 ? self + 1 : 0;
+        for (size_t i = 0; i < numWorkers; i++) {
+            const size_t victim = (start + i) % numWorkers;
+            if (static_cast<int>(victim) == self) {
+                continue;
+            }
+            Worker* worker = _workers[victim];
+            boost::mutex::scoped_lock lk(worker->mutex);
+            if (!worker->tasks.empty()) {
+                *out = worker->tasks.front();
+                worker->tasks.pop_front();
+                _queued.fetchAndSubtract(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void WorkStealingThreadPool::_runTask(QueuedTask* task) {
+        try {
+            task->task();
+        }
+        catch (const DBException& e) {
+            log() << "Unhandled DBException: " << e.toString();
+        }
+        catch (const std::exception& e) {
+            log() << "Unhandled std::exception in worker thread: " << e.what();
+        }
+        catch (...) {
+            log() << "Unhandled non-exception in worker thread";
+        }
+
+        // The group may be destroyed as soon as this is done, so it is not touched after.
+        if (task->group) {
+            task->group->_taskDone();
+        }
+
+        if (_remaining.subtractAndFetch(1) == 0) {
+            boost::mutex::scoped_lock lk(_sleepMutex);
+            _idle.notify_all();
+        }
+    }
+
+    bool WorkStealingThreadPool::_helpWhileWaiting() {
+        const CurrentWorker* current = currentWorker.get();
+        if (!current || current->pool != this) {
+            return false;
+        }
+
+        QueuedTask task(Task(), NULL);
+        if (!_takeTask(current->index, &task)) {
+            return false;
+        }
+        _runTask(&task);
+        return true;
+    }
+
+    void WorkStealingThreadPool::_workerLoop(int self, const std::string& threadName, bool pin) {
+        setThreadName(threadName);
+        currentWorker.reset(new CurrentWorker(this, self));
+        if (pin) {
+            pinToCpu(self);
+        }
+
+        while (true) {
+            QueuedTask task(Task(), NULL);
+            if (_takeTask(self, &task)) {
+                _runTask(&task);
+                continue;
+            }
+
+            boost::mutex::scoped_lock lk(_sleepMutex);
+            if (_shutdown) {
+                return;
+            }
+            _sleepers.fetchAndAdd(1);
+            while (_queued.load() == 0 && !_shutdown) {
+                _wakeup.wait(lk);
+            }
+            _sleepers.fetchAndSubtract(1);
+        }
+    }
+
+} // namespace mongo
@@ -0,0 +1,164 @@
+// work_stealing_thread_pool.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/functional.h"
+
+namespace mongo {
+
+    /**
+     * A thread pool for many small tasks. Each worker has its own task deque, so threads
+     * scheduling tasks and workers taking them don't all meet on one mutex the way they do in
+     * ThreadPool:
+     *
+     * - Tasks scheduled from outside the pool are dealt round-robin to the workers' deques.
+     * - Tasks a worker schedules go to the back of its own deque, and it takes its next task from
+     *   there too, while it's still in cache.
+     * - A worker whose deque is empty steals from the front of the others' before going to
+     *   sleep.
+     *
+     * Tasks can be scheduled in a TaskGroup to wait for just those tasks, rather than for
+     * everything in the pool. A worker waiting for a group runs queued tasks while it waits, so
+     * groups can be nested without running out of workers.
+     *
+     * Exceptions escaping a task are logged and otherwise ignored, as in ThreadPool.
+     */
+    class WorkStealingThreadPool : boost::noncopyable {
+    public:
+        typedef stdx::function<void()> Task;
+
+        /**
+         * Tasks which can be waited for together. Must not outlive its pool.
+         */
+        class TaskGroup : boost::noncopyable {
+        public:
+            explicit TaskGroup(WorkStealingThreadPool* pool);
+
+            // Waits for the group's tasks.
+            ~TaskGroup();
+
+            void schedule(const Task& task);
+
+            /**
+             * Returns once every task scheduled in this group so far has finished.
+             */
+            void join();
+
+        private:
+            friend class WorkStealingThreadPool;
+
+            void _taskDone();
+
+            WorkStealingThreadPool* const _pool;
+
+            // Protects _remaining. Taken by the last task to finish even after it drops
+            // _remaining to 0, so join() takes it too before letting the group be destroyed.
+            boost::mutex _mutex;
+            boost::condition_variable _done;
+            int _remaining;
+        };
+
+        /**
+         * Starts 'nThreads' workers, named 'threadNamePrefix' followed by their number. With
+         * 'pinThreads', worker i only runs on CPU i modulo the number of CPUs, where supported.
+         */
+        WorkStealingThreadPool(int nThreads,
+                               const std::string& threadNamePrefix,
+                               bool pinThreads = false);
+
+        // Waits for all tasks, then stops the workers.
+        ~WorkStealingThreadPool();
+
+        void schedule(const Task& task);
+
+        /**
+         * Waits for all tasks scheduled so far, in groups or not.
+         */
+        void join();
+
+        int getNumThreads() const { return _workers.size(); }
+
+    private:
+        struct QueuedTask {
+            QueuedTask(const Task& task, TaskGroup* group) : task(task), group(group) {}
+
+            Task task;
+            TaskGroup* group;
+        };
+
+        class Worker;
+
+        void _schedule(const QueuedTask& task);
+
+        /**
+         * Takes a task from the back of worker 'self's deque, or else from the front of another
+         * worker's. 'self' is -1 for threads outside the pool.
+         */
+        bool _takeTask(int self, QueuedTask* out);
+
+        void _runTask(QueuedTask* task);
+
+        /**
+         * Runs one queued task on behalf of a worker waiting for a group, if there is one.
+         * Threads outside the pool never run tasks, as they may hold locks or an
+         * OperationContext the tasks would trip over.
+         */
+        bool _helpWhileWaiting();
+
+        void _workerLoop(int self, const std::string& threadName, bool pin);
+
+        std::vector<Worker*> _workers;
+
+        // Where the next task scheduled from outside the pool goes.
+        AtomicUInt32 _nextWorker;
+
+        // Tasks in the deques, and scheduled but not finished.
+        AtomicUInt32 _queued;
+        AtomicUInt32 _remaining;
+
+        // Idle workers sleep on _wakeup, and join() on _idle.
+        boost::mutex _sleepMutex;
+        boost::condition_variable _wakeup;
+        boost::condition_variable _idle;
+        AtomicUInt32 _sleepers;
+        bool _shutdown;
+    };
+
+} // namespace mongo
@@ -0,0 +1,124 @@
+// work_stealing_thread_pool_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/work_stealing_thread_pool.h"
+
+namespace mongo {
+namespace {
+
+    void increment(AtomicUInt32* counter) {
+        counter->fetchAndAdd(1);
+    }
+
+    void throwException() {
+        throw std::exception();
+    }
+
+    TEST(WorkStealingThreadPool, JoinWaitsForAllTasks) {
+        AtomicUInt32 counter;
+        WorkStealingThreadPool pool(4, "test worker ");
+        for (int i = 0; i < 1000; i++) {
+            pool.schedule(stdx::bind(&increment, &counter));
+        }
+        pool.join();
+        ASSERT_EQUALS(1000U, counter.load());
+    }
+
+    TEST(WorkStealingThreadPool, ExceptionsDoNotStopWorkers) {
+        AtomicUInt32 counter;
+        WorkStealingThreadPool pool(2, "test worker ");
+        for (int i = 0; i < 100; i++) {
+            pool.schedule(&throwException);
+            pool.schedule(stdx::bind(&increment, &counter));
+        }
+        pool.join();
+        ASSERT_EQUALS(100U, counter.load());
+    }
+
+    TEST(WorkStealingThreadPool, GroupsJoinSeparately) {
+        AtomicUInt32 first;
+        AtomicUInt32 second;
+        WorkStealingThreadPool pool(3, "test worker ");
+        WorkStealingThreadPool::TaskGroup firstGroup(&pool);
+        WorkStealingThreadPool::TaskGroup secondGroup(&pool);
+        for (int i = 0; i < 500; i++) {
+            firstGroup.schedule(stdx::bind(&increment, &first));
+            secondGroup.schedule(stdx::bind(&increment, &second));
+        }
+        firstGroup.join();
+        ASSERT_EQUALS(500U, first.load());
+        secondGroup.join();
+        ASSERT_EQUALS(500U, second.load());
+
+        // A group can be reused once joined.
+        firstGroup.schedule(stdx::bind(&increment, &first));
+        firstGroup.join();
+        ASSERT_EQUALS(501U, first.load());
+    }
+
+    void scheduleChildren(WorkStealingThreadPool* pool, AtomicUInt32* counter) {
+        WorkStealingThreadPool::TaskGroup children(pool);
+        for (int i = 0; i < 10; i++) {
+            children.schedule(stdx::bind(&increment, counter));
+        }
+        children.join();
+    }
+
+    TEST(WorkStealingThreadPool, NestedGroupsOnOneWorker) {
+        // Each task waits for tasks of its own; with a single worker that only finishes because
+        // it runs them while it waits.
+        AtomicUInt32 counter;
+        WorkStealingThreadPool pool(1, "test worker ");
+        WorkStealingThreadPool::TaskGroup parents(&pool);
+        for (int i = 0; i < 20; i++) {
+            parents.schedule(stdx::bind(&scheduleChildren, &pool, &counter));
+        }
+        parents.join();
+        ASSERT_EQUALS(200U, counter.load());
+    }
+
+    TEST(WorkStealingThreadPool, PinnedThreads) {
+        AtomicUInt32 counter;
+        WorkStealingThreadPool pool(2, "test worker ", true);
+        ASSERT_EQUALS(2, pool.getNumThreads());
+        for (int i = 0; i < 100; i++) {
+            pool.schedule(stdx::bind(&increment, &counter));
+        }
+        pool.join();
+        ASSERT_EQUALS(100U, counter.load());
+    }
+
+} // namespace
+} // namespace mongo
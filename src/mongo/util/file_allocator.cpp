@@ -159,11 +159,16 @@ namespace mongo {
             _pending.insert( i, name );
         }
         _pendingUpdated.notify_all();
+        if ( !inProgress( name ) )
+            return;
+
+        Timer t;
         while( inProgress( name ) ) {
             checkFailure();
             _pendingUpdated.wait( lk.boost() );
         }
-
+        _waits.increment();
+        _waitMicros.increment( t.micros() );
     }
 
     void FileAllocator::waitUntilFinished() const {
@@ -174,6 +179,14 @@ namespace mongo {
             _pendingUpdated.wait( lk.boost() );
     }
 
+    long long FileAllocator::expectedAllocationMillis( long long size ) const {
+        const long long bytes = _allocatedBytes.get();
+        if ( bytes == 0 )
+            return 0;
+        return static_cast<long long>( static_cast<double>( size ) / bytes *
+                                       _allocationMicros.get() / 1000 );
+    }
+
     // TODO: pull this out to per-OS files once they exist
     static bool useSparseFiles(int fd) {
 
@@ -247,6 +260,16 @@ namespace mongo {
 #endif
 
 #if defined(__linux__)
+#if defined(FALLOC_FL_ZERO_RANGE)
+        // Marks the extents as allocated and zeroed in the filesystem metadata, so nothing is
+        // written.  Only some filesystems support it (ext4 and xfs on 3.15+ kernels).
+        if ( fallocate( fd, FALLOC_FL_ZERO_RANGE, 0, size ) == 0 )
+            return;
+
+        LOG(1) << "FileAllocator: fallocate(FALLOC_FL_ZERO_RANGE) failed: "
+               << errnoWithDescription() << " falling back" << endl;
+#endif
+
         int ret = posix_fallocate(fd,0,size);
         if ( ret == 0 )
             return;
@@ -418,6 +441,9 @@ namespace mongo {
                           << " took " << ((double)t.millis())/1000.0 << " secs"
                           << endl;
 
+                    fa->_allocatedBytes.increment( size );
+                    fa->_allocationMicros.increment( t.micros() );
+
                     // no longer in a failed state. allow new writers.
                     fa->_failed = false;
                 }
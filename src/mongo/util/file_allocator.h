@@ -37,6 +37,7 @@
 #include <boost/noncopyable.hpp>
 #include <boost/thread/condition.hpp>
 
+#include "mongo/base/counter.h"
 #include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
@@ -72,6 +73,18 @@ namespace mongo {
 
         static void ensureLength(int fd, long size);
 
+        /** Number of allocateAsap() calls that had to wait for the file to be written. */
+        const Counter64& waits() const { return _waits; }
+
+        /** Total time allocateAsap() callers spent waiting, in microseconds. */
+        const Counter64& waitMicros() const { return _waitMicros; }
+
+        /**
+         * Expected time to allocate a file of 'size' bytes, based on the throughput of the
+         * allocations done so far.  Returns 0 before the first allocation completes.
+         */
+        long long expectedAllocationMillis(long long size) const;
+
         /** @return the singleton */
         static FileAllocator * get();
         
@@ -105,6 +118,11 @@ namespace mongo {
 
         bool _failed;
 
+        Counter64 _waits;
+        Counter64 _waitMicros;
+        Counter64 _allocatedBytes;
+        Counter64 _allocationMicros;
+
         static FileAllocator* _instance;
 
     };
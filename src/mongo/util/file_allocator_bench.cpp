@@ -53,6 +53,7 @@
 #include "mongo/util/quick_exit.h"
 #include "mongo/util/scopeguard.h"
 #include "mongo/util/signal_handlers_synchronous.h"
+#include "mongo/util/time_support.h"
 
 using namespace mongo;
 
@@ -67,6 +68,8 @@ namespace {
     const file::path DEFAULT_PATH = file::temp_directory_path();
     const int DEFAULT_NTRIALS = 10;
     const bool DEFAULT_BSON_OUT = false;
+    const int DEFAULT_AHEAD = 0;
+    const int DEFAULT_FILL_MILLIS = 0;
 
     // used to convert B/usec to MB/sec
     const double MICROSEC_PER_SEC = 1e6;
@@ -83,6 +86,8 @@ struct BenchmarkParams {
     bytes_t bytes;
     file::path path;
     int ntrials;
+    int ahead;
+    int fillMillis;
     bool quiet;
     bool jsonReportEnabled;
     std::string jsonReportOut;
@@ -92,6 +97,8 @@ class FileAllocatorBenchmark {
 public:
     FileAllocatorBenchmark(const BenchmarkParams& params)
         : _fa(FileAllocator::get())
+        , _waits(0)
+        , _waitMicros(0)
         , _params(params) {
         _fa->start();
 
@@ -110,13 +117,31 @@ public:
     void run() {
         if (!_params.quiet) {
             std::cout << "Allocating " << _params.ntrials << " files of size "
-                      << _params.bytes << " bytes in " << _params.path << std::endl;
+                      << _params.bytes << " bytes in " << _params.path;
+            if (_params.ahead > 0) {
+                std::cout << ", requesting " << _params.ahead << " ahead every "
+                          << _params.fillMillis << " ms";
+            }
+            std::cout << std::endl;
         }
 
+        const long long waitsBefore = _fa->waits().get();
+        const long long waitMicrosBefore = _fa->waitMicros().get();
+
         for (int n = 0; n < _params.ntrials; ++n) {
-            const std::string fileName = str::stream() << "garbage-" << n;
-            file::path filePath = _params.path / fileName;
+            file::path filePath = _filePath(n);
             _files.push_back(filePath);
+
+            // Simulate a database that requests the next files in the background while it
+            // spends fillMillis filling the current one.
+            for (int i = 1; i <= _params.ahead && n + i < _params.ntrials; ++i) {
+                long size_requested = _params.bytes;
+                _fa->requestAllocation(_filePath(n + i).string(), size_requested);
+            }
+            if (_params.fillMillis > 0 && n > 0) {
+                sleepmillis(_params.fillMillis);
+            }
+
             bytes_t size_allocated = _params.bytes;
             const ptime::ptime start = ptime::microsec_clock::universal_time();
 
@@ -139,6 +164,9 @@ public:
 
         _fa->waitUntilFinished();
 
+        _waits = _fa->waits().get() - waitsBefore;
+        _waitMicros = _fa->waitMicros().get() - waitMicrosBefore;
+
         if (!_params.quiet) {
             textReport();
         }
@@ -149,6 +177,11 @@ public:
     }
 
 private:
+    file::path _filePath(int n) const {
+        const std::string fileName = str::stream() << "garbage-" << n;
+        return _params.path / fileName;
+    }
+
     struct benchResults {
         micros_t avg;
         micros_t max;
@@ -179,6 +212,8 @@ private:
         printResult("avg", results.avg, _params.bytes);
         printResult("max", results.max, _params.bytes);
         printResult("min", results.min, _params.bytes);
+        std::cout << "waited for allocation " << _waits << " times, "
+                  << _waitMicros << " usec total" << std::endl;
     }
 
     void addResult(BSONObjBuilder& obj, const std::string& name,
@@ -197,6 +232,8 @@ private:
         addResult(obj, "avg", results.avg, _params.bytes);
         addResult(obj, "max", results.max, _params.bytes);
         addResult(obj, "min", results.min, _params.bytes);
+        obj.append("waits", _waits);
+        obj.append("waitMicros", _waitMicros);
 
         obj.append("raw", _results);
 
@@ -218,6 +255,8 @@ private:
     FileAllocator* const _fa;
     std::vector<micros_t> _results;
     std::vector<file::path> _files;
+    long long _waits;
+    long long _waitMicros;
 
     const BenchmarkParams& _params;
 };
@@ -241,6 +280,15 @@ Status addFileAllocatorBenchOptions(moe::OptionSection& options) {
                               "The number of trials to perform")
         .setDefault(moe::Value(DEFAULT_NTRIALS));
 
+    options.addOptionChaining("ahead", "ahead", moe::Int,
+                              str::stream() << "The number of files to request in the background "
+                                            << "ahead of each timed allocation")
+        .setDefault(moe::Value(DEFAULT_AHEAD));
+
+    options.addOptionChaining("fillMillis", "fillMillis", moe::Int,
+                              "Milliseconds to wait between allocations, to simulate filling a file")
+        .setDefault(moe::Value(DEFAULT_FILL_MILLIS));
+
     options.addOptionChaining("quiet", "quiet", moe::Switch,
                               "Suppress the plaintext report");
 
@@ -288,6 +336,8 @@ Status storeFileAllocatorBenchOptions(const moe::Environment& env) {
     benchParams.path = rootPath / file::unique_path("allocator-bench-%%%%%%%%");
 
     ret = env.get(moe::Key("ntrials"), &benchParams.ntrials);
+    ret = env.get(moe::Key("ahead"), &benchParams.ahead);
+    ret = env.get(moe::Key("fillMillis"), &benchParams.fillMillis);
     ret = env.get(moe::Key("quiet"), &benchParams.quiet);
 
     benchParams.jsonReportEnabled = true;
@@ -0,0 +1,153 @@
+// huge_pages.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/huge_pages.h"
+
+#include <cstdlib>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    HugePageStats hugePageStats;
+
+namespace {
+
+    // The usual huge page size on x86-64. Transparent huge pages are always this size, and
+    // explicit ones are unless the kernel was booted with another default.
+    const size_t kHugePageSize = 2 * 1024 * 1024;
+
+    size_t roundUpToHugePage(size_t bytes) {
+        return (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    }
+
+} // namespace
+
+    StatusWith<HugePageMode> parseHugePageMode(const StringData& name) {
+        if (name == "off") {
+            return StatusWith<HugePageMode>(kHugePagesOff);
+        }
+        if (name == "transparent") {
+            return StatusWith<HugePageMode>(kHugePagesTransparent);
+        }
+        if (name == "explicit") {
+            return StatusWith<HugePageMode>(kHugePagesExplicit);
+        }
+        return StatusWith<HugePageMode>(ErrorCodes::BadValue,
+                                        str::stream() << "huge page mode must be \"off\", "
+                                                      << "\"transparent\" or \"explicit\", not \""
+                                                      << name << "\"");
+    }
+
+#if defined(__linux__)
+    HugePageRegion::HugePageRegion(size_t bytes, HugePageMode mode)
+        : _data(NULL), _mapping(NULL), _mappingSize(0), _mode(mode) {
+
+        if (_mode == kHugePagesExplicit) {
+            _mappingSize = roundUpToHugePage(bytes);
+            _mapping = mmap(NULL, _mappingSize, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (_mapping != MAP_FAILED) {
+                _data = _mapping;
+                hugePageStats.explicitBytes.fetchAndAdd(_mappingSize);
+                return;
+            }
+
+            const int err = errno;
+            if (hugePageStats.explicitFallbacks.fetchAndAdd(1) == 0) {
+                warning() << "could not map " << _mappingSize << " bytes of explicit huge pages, "
+                          << "using transparent huge pages instead. Reserve more with "
+                          << "vm.nr_hugepages: " << errnoWithDescription(err);
+            }
+            _mode = kHugePagesTransparent;
+        }
+
+        // Transparent huge pages only back whole aligned huge pages, so map enough to align
+        // within, and leave the rest of the mapping unused.
+        _mappingSize = _mode == kHugePagesTransparent ? roundUpToHugePage(bytes) + kHugePageSize
+                                                      : bytes;
+        _mapping = mmap(NULL, _mappingSize, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (_mapping == MAP_FAILED) {
+            const int err = errno;
+            msgasserted(28637, str::stream() << "could not map " << _mappingSize << " bytes: "
+                                             << errnoWithDescription(err));
+        }
+        _data = _mapping;
+
+        if (_mode == kHugePagesTransparent) {
+            const size_t address = reinterpret_cast<size_t>(_mapping);
+            _data = reinterpret_cast<void*>(roundUpToHugePage(address));
+            if (madvise(_data, roundUpToHugePage(bytes), MADV_HUGEPAGE) == 0) {
+                hugePageStats.transparentBytes.fetchAndAdd(_mappingSize);
+            }
+            else {
+                const int err = errno;
+                LOG(1) << "madvise(MADV_HUGEPAGE) failed: " << errnoWithDescription(err);
+                _mode = kHugePagesOff;
+            }
+        }
+    }
+
+    HugePageRegion::~HugePageRegion() {
+        if (_mode == kHugePagesExplicit) {
+            hugePageStats.explicitBytes.subtractAndFetch(_mappingSize);
+        }
+        else if (_mode == kHugePagesTransparent) {
+            hugePageStats.transparentBytes.subtractAndFetch(_mappingSize);
+        }
+        munmap(_mapping, _mappingSize);
+    }
+#else
+    HugePageRegion::HugePageRegion(size_t bytes, HugePageMode mode)
+        : _data(NULL), _mapping(NULL), _mappingSize(bytes), _mode(kHugePagesOff) {
+        _mapping = calloc(1, bytes);
+        if (!_mapping) {
+            msgasserted(28637, str::stream() << "could not allocate " << bytes << " bytes");
+        }
+        _data = _mapping;
+    }
+
+    HugePageRegion::~HugePageRegion() {
+        free(_mapping);
+    }
+#endif
+
+} // namespace mongo
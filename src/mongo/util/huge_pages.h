@@ -0,0 +1,107 @@
+// huge_pages.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status_with.h"
+#include "mongo/base/string_data.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    /**
+     * How a large, randomly accessed structure asks for huge pages, cutting the TLB misses of
+     * looking it up.
+     */
+    enum HugePageMode {
+        // Regular pages.
+        kHugePagesOff,
+
+        // Transparent huge pages, by madvise(MADV_HUGEPAGE). Used when
+        // /sys/kernel/mm/transparent_hugepage/enabled is "always" or "madvise", which is how the
+        // startup warnings recommend it is set.
+        kHugePagesTransparent,
+
+        // Pages reserved through vm.nr_hugepages, by MAP_HUGETLB. Falls back to transparent huge
+        // pages when not enough are free.
+        kHugePagesExplicit,
+    };
+
+    /**
+     * Parses "off", "transparent" or "explicit".
+     */
+    StatusWith<HugePageMode> parseHugePageMode(const StringData& name);
+
+    /**
+     * Bytes currently held in each kind of huge page by HugePageRegions. Reported in serverStatus
+     * under hugePages.
+     */
+    struct HugePageStats {
+        AtomicInt64 transparentBytes;
+        AtomicInt64 explicitBytes;
+
+        // Explicit requests which found too few reserved pages.
+        AtomicInt64 explicitFallbacks;
+    };
+
+    extern HugePageStats hugePageStats;
+
+    /**
+     * Zero-filled memory of its own mapping, on huge pages as 'mode' asks where supported, and on
+     * regular pages otherwise. Only Linux supports huge pages.
+     */
+    class HugePageRegion {
+        MONGO_DISALLOW_COPYING(HugePageRegion);
+    public:
+        HugePageRegion(size_t bytes, HugePageMode mode);
+        ~HugePageRegion();
+
+        void* get() const { return _data; }
+
+        /**
+         * What the region ended up on: kHugePagesExplicit, kHugePagesTransparent if asked for
+         * them or after falling back, or kHugePagesOff.
+         */
+        HugePageMode getMode() const { return _mode; }
+
+    private:
+        void* _data;
+
+        // The whole mapping, which _data is aligned within.
+        void* _mapping;
+        size_t _mappingSize;
+
+        HugePageMode _mode;
+    };
+
+} // namespace mongo
@@ -0,0 +1,90 @@
+// huge_pages_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <cstring>
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/huge_pages.h"
+
+namespace mongo {
+namespace {
+
+    TEST(HugePages, ParseMode) {
+        ASSERT_EQUALS(kHugePagesOff, parseHugePageMode("off").getValue());
+        ASSERT_EQUALS(kHugePagesTransparent, parseHugePageMode("transparent").getValue());
+        ASSERT_EQUALS(kHugePagesExplicit, parseHugePageMode("explicit").getValue());
+        ASSERT_EQUALS(ErrorCodes::BadValue, parseHugePageMode("on").getStatus().code());
+    }
+
+    void checkRegion(HugePageMode mode) {
+        const size_t bytes = 3 * 1024 * 1024 + 17;
+        const long long transparentBefore = hugePageStats.transparentBytes.load();
+        const long long explicitBefore = hugePageStats.explicitBytes.load();
+        {
+            HugePageRegion region(bytes, mode);
+            const char* data = static_cast<const char*>(region.get());
+            ASSERT(data);
+            for (size_t i = 0; i < bytes; i += 4096) {
+                ASSERT_EQUALS(0, data[i]);
+            }
+            memset(region.get(), 'x', bytes);
+
+            if (mode == kHugePagesOff) {
+                ASSERT_EQUALS(kHugePagesOff, region.getMode());
+            }
+            if (region.getMode() == kHugePagesTransparent) {
+                ASSERT_EQUALS(0U, reinterpret_cast<size_t>(data) % (2 * 1024 * 1024));
+                ASSERT_GREATER_THAN(hugePageStats.transparentBytes.load(), transparentBefore);
+            }
+            if (region.getMode() == kHugePagesExplicit) {
+                ASSERT_GREATER_THAN(hugePageStats.explicitBytes.load(), explicitBefore);
+            }
+        }
+        ASSERT_EQUALS(transparentBefore, hugePageStats.transparentBytes.load());
+        ASSERT_EQUALS(explicitBefore, hugePageStats.explicitBytes.load());
+    }
+
+    TEST(HugePages, RegularPages) {
+        checkRegion(kHugePagesOff);
+    }
+
+    TEST(HugePages, TransparentHugePages) {
+        checkRegion(kHugePagesTransparent);
+    }
+
+    TEST(HugePages, ExplicitHugePages) {
+        // Usually falls back to transparent huge pages, as none are reserved.
+        checkRegion(kHugePagesExplicit);
+    }
+
+} // namespace
+} // namespace mongo
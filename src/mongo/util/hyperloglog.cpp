@@ -0,0 +1,111 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/hyperloglog.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/platform/bits.h"
+
+namespace mongo {
+
+    HyperLogLog::HyperLogLog() {
+        clear();
+    }
+
+    void HyperLogLog::add(uint64_t hash) {
+        const int index = static_cast<int>(hash & (NumRegisters - 1));
+        const uint64_t rest = hash >> IndexBits;
+        const unsigned rank = rest ? countTrailingZeros64(rest) + 1 : 64 - IndexBits + 1;
+
+        AtomicUInt32& word = _words[index / 4];
+        const int shift = (index % 4) * 8;
+        unsigned old = word.loadRelaxed();
+        while (((old >> shift) & 0xff) < rank) {
+            const unsigned updated = (old & ~(0xffU << shift)) | (rank << shift);
+            const unsigned actual = word.compareAndSwap(old, updated);
+            if (actual == old) {
+                return;
+            }
+            old = actual;
+        }
+    }
+
+    double HyperLogLog::estimate() const {
+        unsigned char registers[NumRegisters];
+        for (int i = 0; i < NumRegisters; i++) {
+            registers[i] = _register(i);
+        }
+        return _estimate(registers);
+    }
+
+    double HyperLogLog::estimateUnion(const HyperLogLog& other) const {
+        unsigned char registers[NumRegisters];
+        for (int i = 0; i < NumRegisters; i++) {
+            registers[i] = std::max(_register(i), other._register(i));
+        }
+        return _estimate(registers);
+    }
+
+    void HyperLogLog::clear() {
+        for (int i = 0; i < NumRegisters / 4; i++) {
+            _words[i].store(0);
+        }
+    }
+
+    unsigned char HyperLogLog::_register(int i) const {
+        return static_cast<unsigned char>(_words[i / 4].loadRelaxed() >> ((i % 4) * 8));
+    }
+
+    double HyperLogLog::_estimate(const unsigned char* registers) {
+        const double m = NumRegisters;
+        const double alpha = 0.7213 / (1 + 1.079 / m);
+
+        double sum = 0;
+        int zeros = 0;
+        for (int i = 0; i < NumRegisters; i++) {
+            sum += std::ldexp(1.0, -registers[i]);
+            if (registers[i] == 0) {
+                zeros++;
+            }
+        }
+
+        const double raw = alpha * m * m / sum;
+        if (raw <= 2.5 * m && zeros > 0) {
+            // Small range correction: linear counting over the empty registers.
+            return m * std::log(m / zeros);
+        }
+
+        // With 64 bit hashes there is no need for a large range correction.
+        return raw;
+    }
+
+} // namespace mongo
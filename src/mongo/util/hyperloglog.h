@@ -0,0 +1,71 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+
+    /**
+     * HyperLogLog estimate of the number of distinct values added to it.  Values are added as
+     * well mixed 64 bit hashes: the low IndexBits bits pick one of NumRegisters registers and the
+     * rest feed its rank.  The standard error is about 1.04 / sqrt(NumRegisters), 6.5% here.
+     *
+     * add() is threadsafe and lock free.  Registers are packed four to a word and only written
+     * when they grow, so adding a value already seen costs a single load.
+     */
+    class HyperLogLog {
+        MONGO_DISALLOW_COPYING(HyperLogLog);
+    public:
+        enum { IndexBits = 8, NumRegisters = 1 << IndexBits };
+
+        HyperLogLog();
+
+        void add(uint64_t hash);
+
+        /** Estimated number of distinct hashes added since the last clear(). */
+        double estimate() const;
+
+        /** Estimated number of distinct hashes added to either this or 'other'. */
+        double estimateUnion(const HyperLogLog& other) const;
+
+        /** Not atomic with respect to concurrent add() calls, which may land either side. */
+        void clear();
+
+    private:
+        unsigned char _register(int i) const;
+
+        static double _estimate(const unsigned char* registers);
+
+        AtomicUInt32 _words[NumRegisters / 4];
+    };
+
+} // namespace mongo
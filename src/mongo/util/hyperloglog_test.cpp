@@ -0,0 +1,101 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/hyperloglog.h"
+
+namespace {
+
+    using mongo::HyperLogLog;
+
+    // splitmix64, so consecutive integers make well mixed hashes.
+    uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    void assertWithin(double expected, double actual, double fraction) {
+        ASSERT_LESS_THAN_OR_EQUALS(std::abs(actual - expected), expected * fraction);
+    }
+
+    TEST(HyperLogLog, EmptyIsZero) {
+        HyperLogLog hll;
+        ASSERT_EQUALS(0.0, hll.estimate());
+    }
+
+    TEST(HyperLogLog, SmallCountsAreClose) {
+        HyperLogLog hll;
+        for (uint64_t i = 0; i < 100; i++) {
+            hll.add(mix(i));
+        }
+        assertWithin(100, hll.estimate(), 0.1);
+    }
+
+    TEST(HyperLogLog, DuplicatesAreNotCounted) {
+        HyperLogLog hll;
+        for (int round = 0; round < 10; round++) {
+            for (uint64_t i = 0; i < 10000; i++) {
+                hll.add(mix(i));
+            }
+        }
+        assertWithin(10000, hll.estimate(), 0.2);
+    }
+
+    TEST(HyperLogLog, LargeCountsAreClose) {
+        HyperLogLog hll;
+        for (uint64_t i = 0; i < 1000000; i++) {
+            hll.add(mix(i));
+        }
+        assertWithin(1000000, hll.estimate(), 0.2);
+    }
+
+    TEST(HyperLogLog, Union) {
+        HyperLogLog a;
+        HyperLogLog b;
+        for (uint64_t i = 0; i < 20000; i++) {
+            a.add(mix(i));
+            b.add(mix(i + 10000));
+        }
+        assertWithin(30000, a.estimateUnion(b), 0.2);
+        assertWithin(30000, b.estimateUnion(a), 0.2);
+    }
+
+    TEST(HyperLogLog, Clear) {
+        HyperLogLog hll;
+        for (uint64_t i = 0; i < 1000; i++) {
+            hll.add(mix(i));
+        }
+        hll.clear();
+        ASSERT_EQUALS(0.0, hll.estimate());
+    }
+
+} // namespace
@@ -33,6 +33,7 @@
 #include "mongo/platform/atomic_word.h"
 #include "mongo/base/string_data.h"
 #include "mongo/util/allocator.h"
+#include "mongo/util/bump_arena.h"
 
 namespace mongo {
 
@@ -117,19 +118,25 @@ namespace mongo {
 
         static boost::intrusive_ptr<const RCString> create(StringData s);
 
+        /// True if this string lives in a BumpArena and should be copied before being kept.
+        bool isInArena() const { return BumpArena::isInArena(this); }
+
 // MSVC: C4291: 'declaration' : no matching operator delete found; memory will not be freed if 
 // initialization throws an exception
 // We simply rely on the default global placement delete since a local placement delete would be 
 // ambiguous for some compilers
 #pragma warning(push)
 #pragma warning(disable : 4291) 
-        void operator delete (void* ptr) { free(ptr); }
+        void operator delete (void* ptr) { BumpArena::free(ptr); }
 #pragma warning(pop)
 
     private:
         // these can only be created by calling create()
         RCString() {};
-        void* operator new (size_t objSize, size_t realSize) { return mongoMalloc(realSize); }
+        // Strings come from the current BumpArena, if any, like the documents holding them.
+        void* operator new (size_t objSize, size_t realSize) {
+            return BumpArena::allocate(realSize);
+        }
 
         int _size; // does NOT include trailing NUL byte.
         // char[_size+1] array allocated past end of class
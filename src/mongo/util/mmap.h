@@ -213,6 +213,15 @@ namespace mongo {
         void flush(bool sync);
         virtual Flushable * prepareFlush();
 
+#ifndef _WIN32
+        /**
+         * Synchronously writes back the modified pages in [offset, offset + length) of the view
+         * used for flushing.  'offset' must be page aligned.  The caller must hold
+         * LockMongoFilesShared so the file can not be closed underneath the call.
+         */
+        void flushRange(unsigned long long offset, unsigned long long length);
+#endif
+
         long shortLength() const          { return (long) len; }
         unsigned long long length() const { return len; }
         HANDLE getFd() const              { return fd; }
@@ -270,6 +270,20 @@ namespace mongo {
         }
     }
 
+    void MemoryMappedFile::flushRange(unsigned long long offset, unsigned long long length) {
+        char* view = static_cast<char*>(viewForFlushing());
+        if ( view == NULL || fd == 0 || offset >= len )
+            return;
+
+        length = std::min(length, len - offset);
+        if ( msync(view + offset, length, MS_SYNC) ) {
+            // msync failed, this is very bad
+            log() << "msync failed: " << errnoWithDescription()
+                  << " file: " << filename() << endl;
+            dataSyncFailedHandler();
+        }
+    }
+
     class PosixFlushable : public MemoryMappedFile::Flushable {
     public:
         PosixFlushable( MemoryMappedFile* theFile, void* view , HANDLE fd , long len)
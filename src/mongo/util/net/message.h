@@ -40,6 +40,7 @@
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/net/sock.h"
 #include "mongo/util/print.h"
+#include "mongo/util/shared_buffer.h"
 
 namespace mongo {
 
@@ -63,7 +64,8 @@ namespace mongo {
         dbQuery = 2004,
         dbGetMore = 2005,
         dbDelete = 2006,
-        dbKillCursors = 2007
+        dbKillCursors = 2007,
+        dbCompressed = 2012 /* another message, compressed. see message_compressor.h */
     };
 
     bool doesOpGetAResponse( int op );
@@ -79,6 +81,7 @@ namespace mongo {
         case dbGetMore: return "getmore";
         case dbDelete: return "remove";
         case dbKillCursors: return "killcursors";
+        case dbCompressed: return "compressed";
         default:
             massert( 16141, str::stream() << "cannot translate opcode " << op, !op );
             return "";
@@ -94,6 +97,7 @@ namespace mongo {
         case dbQuery:
         case dbGetMore:
         case dbKillCursors:
+        case dbCompressed:
             return false;
 
         case dbUpdate:
@@ -400,6 +404,7 @@ namespace mongo {
             if ( r._data.size() > 0 ) {
                 _data.swap( r._data );
             }
+            _referenced.swap( r._referenced );
             r._freeIt = false;
             _freeIt = true;
             return *this;
@@ -410,13 +415,21 @@ namespace mongo {
                 if ( _buf ) {
                     free( _buf );
                 }
+                // _referenced is in the same order as those buffers appear in _data
+                size_t nextReferenced = 0;
                 for (std::vector< std::pair< char *, int > >::const_iterator i = _data.begin();
                      i != _data.end(); ++i) {
+                    if ( nextReferenced < _referenced.size() &&
+                         _referenced[nextReferenced].first == i->first ) {
+                        ++nextReferenced;
+                        continue;
+                    }
                     free(i->first);
                 }
             }
             _buf = 0;
             _data.clear();
+            _referenced.clear();
             _freeIt = false;
         }
 
@@ -441,6 +454,24 @@ namespace mongo {
             header().setLen(header().getLen() + size);
         }
 
+        // use to add a buffer owned by 'owner' rather than by the message, which holds on to
+        // 'owner' until it is reset.  the buffer is sent from where it is, without being copied.
+        // the message must already have a first buffer of its own, holding the header.
+        void appendReferencedData(const char *d, int size, const SharedBuffer& owner) {
+            if ( size <= 0 ) {
+                return;
+            }
+            verify( !empty() );
+            verify( _freeIt );
+            if ( _buf ) {
+                _data.push_back(std::make_pair(_buf, MsgData::ConstView(_buf).getLen()));
+                _buf = 0;
+            }
+            _data.push_back(std::make_pair(const_cast<char*>(d), size));
+            _referenced.push_back(std::make_pair(d, owner));
+            header().setLen(header().getLen() + size);
+        }
+
         // use to set first buffer if empty
         void setData(char* d, bool freeIt) {
             verify( empty() );
@@ -477,6 +508,8 @@ namespace mongo {
         // byte buffer(s) - the first must contain at least a full MsgData unless using _buf for storage instead
         typedef std::vector< std::pair< char*, int > > MsgVec;
         MsgVec _data;
+        // buffers in _data added by appendReferencedData, which aren't freed, and their owners
+        std::vector< std::pair< const char*, SharedBuffer > > _referenced;
         bool _freeIt;
     };
 
@@ -0,0 +1,108 @@
+// message_bench.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+namespace {
+
+    using unittest::doNotOptimizeAway;
+
+    /**
+     * Appends the body of an OP_QUERY message, as a client would send it, to 'b'.
+     */
+    void makeQueryBody(BufBuilder* b) {
+        b->appendNum(0); // flags
+        b->appendStr("bench.collection");
+        b->appendNum(0); // nToSkip
+        b->appendNum(100); // nToReturn
+        BSON("status" << "active" << "qty" << BSON("$gt" << 10)).appendSelfToBufBuilder(*b);
+        BSON("name" << 1 << "qty" << 1).appendSelfToBufBuilder(*b);
+    }
+
+    /**
+     * Appends the body of an OP_INSERT message carrying 'numDocs' documents to 'b'.
+     */
+    void makeInsertBody(BufBuilder* b, int numDocs) {
+        b->appendNum(0); // flags
+        b->appendStr("bench.collection");
+        for (int i = 0; i < numDocs; i++) {
+            BSON("_id" << i << "name" << "widget" << "qty" << i * 10).appendSelfToBufBuilder(*b);
+        }
+    }
+
+    BENCHMARK(Message, ParseQuery) {
+        BufBuilder body;
+        makeQueryBody(&body);
+
+        while (state.keepRunning()) {
+            Message m;
+            m.setData(dbQuery, body.buf(), body.len());
+            DbMessage d(m);
+            QueryMessage q(d);
+            doNotOptimizeAway(q.query);
+        }
+    }
+
+    BENCHMARK(Message, ParseInsertBatch) {
+        BufBuilder body;
+        makeInsertBody(&body, 100);
+
+        while (state.keepRunning()) {
+            Message m;
+            m.setData(dbInsert, body.buf(), body.len());
+            DbMessage d(m);
+            d.getns();
+            int numDocs = 0;
+            while (d.moreJSObjs()) {
+                d.nextJsObj();
+                numDocs++;
+            }
+            doNotOptimizeAway(numDocs);
+        }
+    }
+
+    BENCHMARK(Message, BuildReply) {
+        const BSONObj result = BSON("ok" << 1 << "n" << 100 << "nModified" << 100);
+
+        while (state.keepRunning()) {
+            Message reply;
+            replyToQuery(0, reply, result);
+            doNotOptimizeAway(reply.size());
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
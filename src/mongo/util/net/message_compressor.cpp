@@ -0,0 +1,208 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/message_compressor.h"
+
+#include "mongo/base/data_view.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/allocator.h"
+#include "mongo/util/compress.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+    // Ask for, and agree to, compression of the messages on our connections
+    MONGO_EXPORT_SERVER_PARAMETER(networkMessageCompression, bool, true);
+
+    // Smaller messages are not worth compressing
+    MONGO_EXPORT_SERVER_PARAMETER(networkMessageCompressionMinBytes, int, 1024);
+
+namespace {
+
+    const char kCompressionFieldName[] = "compression";
+    const char kSnappyCompressorName[] = "snappy";
+
+    const size_t kOriginalOpcodeOffset = 0;
+    const size_t kUncompressedSizeOffset = 4;
+    const size_t kCompressorIdOffset = 8;
+    const size_t kCompressedBodyOffset = 9;
+
+    AtomicInt64 messagesOut;
+    AtomicInt64 bytesOut;
+    AtomicInt64 uncompressedBytesOut;
+    AtomicInt64 messagesIn;
+    AtomicInt64 bytesIn;
+    AtomicInt64 uncompressedBytesIn;
+
+} // namespace
+
+    bool isMessageCompressionEnabled() {
+        return networkMessageCompression;
+    }
+
+    bool compressMessage(Message& toSend, Message* compressed) {
+        if (!networkMessageCompression ||
+                toSend.operation() == dbCompressed ||
+                toSend.size() < networkMessageCompressionMinBytes) {
+            return false;
+        }
+
+        toSend.concat();
+        const MsgData::View original = toSend.singleData();
+        const size_t bodyLen = original.dataLen();
+        const size_t maxLen = MsgData::MsgDataHeaderSize + kCompressedBodyOffset +
+            maxCompressedLength(bodyLen);
+
+        MsgData::View md = reinterpret_cast<char*>(mongoMalloc(maxLen));
+        ScopeGuard guard = MakeGuard(free, md.view2ptr());
+
+        DataView(md.data())
+            .writeLE<int32_t>(original.getOperation(), kOriginalOpcodeOffset)
+            .writeLE<int32_t>(bodyLen, kUncompressedSizeOffset)
+            .writeLE<uint8_t>(kMessageCompressorSnappy, kCompressorIdOffset);
+
+        size_t compressedLen;
+        rawCompress(original.data(), bodyLen, md.data() + kCompressedBodyOffset, &compressedLen);
+
+        const int len = MsgData::MsgDataHeaderSize + kCompressedBodyOffset + compressedLen;
+        if (len >= original.getLen()) {
+            return false;
+        }
+
+        md.setLen(len);
+        md.setId(original.getId());
+        md.setResponseTo(original.getResponseTo());
+        md.setOperation(dbCompressed);
+
+        guard.Dismiss();
+        compressed->setData(md.view2ptr(), true);
+
+        messagesOut.fetchAndAdd(1);
+        bytesOut.fetchAndAdd(len);
+        uncompressedBytesOut.fetchAndAdd(original.getLen());
+        return true;
+    }
+
+    bool decompressMessage(Message* m) {
+        const MsgData::View md = m->singleData();
+        if (md.getOperation() != dbCompressed ||
+                md.dataLen() < static_cast<int>(kCompressedBodyOffset)) {
+            return false;
+        }
+
+        const ConstDataView prefix(md.data());
+        const int32_t originalOpcode = prefix.readLE<int32_t>(kOriginalOpcodeOffset);
+        const int32_t uncompressedSize = prefix.readLE<int32_t>(kUncompressedSizeOffset);
+        const uint8_t compressorId = prefix.readLE<uint8_t>(kCompressorIdOffset);
+        if (compressorId != kMessageCompressorSnappy ||
+                originalOpcode == dbCompressed ||
+                uncompressedSize < 0 ||
+                static_cast<size_t>(uncompressedSize) >
+                    MaxMessageSizeBytes - MsgData::MsgDataHeaderSize) {
+            return false;
+        }
+
+        const char* compressedBody = md.data() + kCompressedBodyOffset;
+        const size_t compressedLen = md.dataLen() - kCompressedBodyOffset;
+        size_t len;
+        if (!uncompressedLength(compressedBody, compressedLen, &len) ||
+                len != static_cast<size_t>(uncompressedSize)) {
+            return false;
+        }
+
+        MsgData::View out = reinterpret_cast<char*>(
+            mongoMalloc(MsgData::MsgDataHeaderSize + len));
+        ScopeGuard guard = MakeGuard(free, out.view2ptr());
+        if (!rawUncompress(compressedBody, compressedLen, out.data())) {
+            return false;
+        }
+
+        out.setLen(MsgData::MsgDataHeaderSize + len);
+        out.setId(md.getId());
+        out.setResponseTo(md.getResponseTo());
+        out.setOperation(originalOpcode);
+
+        messagesIn.fetchAndAdd(1);
+        bytesIn.fetchAndAdd(md.getLen());
+        uncompressedBytesIn.fetchAndAdd(out.getLen());
+
+        guard.Dismiss();
+        m->reset();
+        m->setData(out.view2ptr(), true);
+        return true;
+    }
+
+    void appendMessageCompressionRequest(BSONObjBuilder* isMasterCmd) {
+        BSONArrayBuilder compressors(isMasterCmd->subarrayStart(kCompressionFieldName));
+        compressors.append(kSnappyCompressorName);
+        compressors.done();
+    }
+
+    bool isMessageCompressionAccepted(const BSONObj& isMasterReply) {
+        BSONElement compressors = isMasterReply[kCompressionFieldName];
+        if (compressors.type() != Array) {
+            return false;
+        }
+
+        BSONObjIterator it(compressors.Obj());
+        while (it.more()) {
+            BSONElement e = it.next();
+            if (e.type() == String && e.valueStringData() == kSnappyCompressorName) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void negotiateMessageCompression(const BSONObj& isMasterCmd,
+                                     AbstractMessagingPort* port,
+                                     BSONObjBuilder* result) {
+        if (!port || !networkMessageCompression || !isMessageCompressionAccepted(isMasterCmd)) {
+            return;
+        }
+
+        appendMessageCompressionRequest(result);
+        port->setCompressMessages(true);
+    }
+
+    void appendMessageCompressionStats(BSONObjBuilder* b) {
+        b->appendNumber("messagesOut", messagesOut.load());
+        b->appendNumber("bytesOut", bytesOut.load());
+        b->appendNumber("uncompressedBytesOut", uncompressedBytesOut.load());
+        b->appendNumber("messagesIn", messagesIn.load());
+        b->appendNumber("bytesIn", bytesIn.load());
+        b->appendNumber("uncompressedBytesIn", uncompressedBytesIn.load());
+    }
+
+} // namespace mongo
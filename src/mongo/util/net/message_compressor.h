@@ -0,0 +1,98 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+namespace mongo {
+
+    class AbstractMessagingPort;
+    class BSONObj;
+    class BSONObjBuilder;
+    class Message;
+
+    /**
+     * A dbCompressed message carries another message, whose body is compressed. The header keeps
+     * the id and responseTo of the original message, and the body is laid out as:
+     *
+     *     int32 originalOpcode
+     *     int32 uncompressedSize   // of the original body, without the header
+     *     uint8 compressorId       // a MessageCompressorId
+     *     char  compressedBody[]
+     *
+     * Peers only send each other dbCompressed messages once they agreed on a compressor through
+     * the "compression" field of isMaster, but MessagingPort::recv() always uncompresses them.
+     */
+    enum MessageCompressorId {
+        kMessageCompressorNoop = 0,
+        kMessageCompressorSnappy = 1
+    };
+
+    /**
+     * Whether this process asks for, and agrees to, compression of the messages on its
+     * connections. Set through the networkMessageCompression server parameter.
+     */
+    bool isMessageCompressionEnabled();
+
+    /**
+     * Fills in 'compressed' with the dbCompressed form of 'toSend' if compression is enabled,
+     * 'toSend' is at least networkMessageCompressionMinBytes long and compressing it makes it
+     * smaller. Returns whether it did. May join the buffers of 'toSend' into one.
+     */
+    bool compressMessage(Message& toSend, Message* compressed);
+
+    /**
+     * Replaces the dbCompressed message 'm' with the one it carries. Returns false if 'm' is
+     * corrupt or uses an unknown compressor, in which case 'm' is left alone.
+     */
+    bool decompressMessage(Message* m);
+
+    /**
+     * Appends the compressors this process supports to the isMaster request 'isMasterCmd'.
+     */
+    void appendMessageCompressionRequest(BSONObjBuilder* isMasterCmd);
+
+    /**
+     * Returns whether the isMaster reply 'isMasterReply' agreed to compress messages.
+     */
+    bool isMessageCompressionAccepted(const BSONObj& isMasterReply);
+
+    /**
+     * Handles the "compression" field of the isMaster request 'isMasterCmd' received on 'port':
+     * if both sides support a compressor, appends it to 'result' and starts compressing the
+     * messages sent on 'port'. Does nothing when 'port' is NULL.
+     */
+    void negotiateMessageCompression(const BSONObj& isMasterCmd,
+                                     AbstractMessagingPort* port,
+                                     BSONObjBuilder* result);
+
+    /**
+     * Appends the number of messages and bytes sent and received compressed to 'b'.
+     */
+    void appendMessageCompressionStats(BSONObjBuilder* b);
+
+} // namespace mongo
@@ -0,0 +1,163 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/message_compressor.h"
+
+#include <string>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_port.h"
+
+namespace mongo {
+namespace {
+
+    void makeMessage(const std::string& body, Message* m) {
+        m->setData(dbQuery, body.data(), body.size());
+        m->header().setId(42);
+        m->header().setResponseTo(7);
+    }
+
+    TEST(MessageCompressor, RoundTrip) {
+        const std::string body(10000, 'x');
+        Message m;
+        makeMessage(body, &m);
+
+        Message compressed;
+        ASSERT_TRUE(compressMessage(m, &compressed));
+        ASSERT_EQUALS(dbCompressed, compressed.operation());
+        ASSERT_LESS_THAN(compressed.size(), m.size());
+        ASSERT_EQUALS(42U, compressed.header().getId());
+        ASSERT_EQUALS(7U, compressed.header().getResponseTo());
+
+        // The original message is left alone
+        ASSERT_EQUALS(dbQuery, m.operation());
+
+        ASSERT_TRUE(decompressMessage(&compressed));
+        ASSERT_EQUALS(dbQuery, compressed.operation());
+        ASSERT_EQUALS(m.size(), compressed.size());
+        ASSERT_EQUALS(42U, compressed.header().getId());
+        ASSERT_EQUALS(7U, compressed.header().getResponseTo());
+        ASSERT_EQUALS(body, std::string(compressed.singleData().data(), body.size()));
+    }
+
+    TEST(MessageCompressor, MultipleBuffers) {
+        const std::string body(5000, 'y');
+        Message m;
+        makeMessage(body, &m);
+        char* more = static_cast<char*>(malloc(body.size()));
+        memcpy(more, body.data(), body.size());
+        m.appendData(more, body.size());
+
+        Message compressed;
+        ASSERT_TRUE(compressMessage(m, &compressed));
+        ASSERT_TRUE(decompressMessage(&compressed));
+        ASSERT_EQUALS(m.size(), compressed.size());
+        ASSERT_EQUALS(body + body,
+                      std::string(compressed.singleData().data(), 2 * body.size()));
+    }
+
+    TEST(MessageCompressor, SmallMessagesAreNotCompressed) {
+        Message m;
+        makeMessage(std::string(100, 'x'), &m);
+        Message compressed;
+        ASSERT_FALSE(compressMessage(m, &compressed));
+        ASSERT_TRUE(compressed.empty());
+    }
+
+    TEST(MessageCompressor, IncompressibleMessagesAreNotCompressed) {
+        PseudoRandom random(1);
+        std::string body;
+        for (int i = 0; i < 10000; i++) {
+            body += static_cast<char>(random.nextInt32());
+        }
+        Message m;
+        makeMessage(body, &m);
+        Message compressed;
+        ASSERT_FALSE(compressMessage(m, &compressed));
+    }
+
+    TEST(MessageCompressor, CorruptMessagesAreRejected) {
+        Message m;
+        makeMessage(std::string(10000, 'x'), &m);
+        Message compressed;
+        ASSERT_TRUE(compressMessage(m, &compressed));
+
+        // Unknown compressor
+        Message badCompressor;
+        makeMessage(std::string(compressed.singleData().data(), compressed.dataSize()),
+                    &badCompressor);
+        badCompressor.header().setOperation(dbCompressed);
+        badCompressor.header().data()[8] = 5;
+        ASSERT_FALSE(decompressMessage(&badCompressor));
+        ASSERT_EQUALS(dbCompressed, badCompressor.operation());
+
+        // Truncated body
+        Message truncated;
+        makeMessage(std::string(compressed.singleData().data(), compressed.dataSize() / 2),
+                    &truncated);
+        truncated.header().setOperation(dbCompressed);
+        ASSERT_FALSE(decompressMessage(&truncated));
+    }
+
+    TEST(MessageCompressor, Negotiation) {
+        BSONObjBuilder request;
+        request.append("isMaster", 1);
+        appendMessageCompressionRequest(&request);
+        const BSONObj cmd = request.obj();
+        ASSERT_TRUE(isMessageCompressionAccepted(cmd));
+        ASSERT_TRUE(isMessageCompressionAccepted(BSON("compression" << BSON_ARRAY("zlib" <<
+                                                                                  "snappy"))));
+        ASSERT_FALSE(isMessageCompressionAccepted(BSON("compression" << BSON_ARRAY("zlib"))));
+        ASSERT_FALSE(isMessageCompressionAccepted(BSON("compression" << "snappy")));
+        ASSERT_FALSE(isMessageCompressionAccepted(BSON("isMaster" << 1)));
+
+        MessagingPort port;
+        ASSERT_FALSE(port.compressMessages());
+
+        BSONObjBuilder ignored;
+        negotiateMessageCompression(BSON("isMaster" << 1), &port, &ignored);
+        ASSERT_FALSE(port.compressMessages());
+        ASSERT_TRUE(ignored.obj().isEmpty());
+
+        BSONObjBuilder noPort;
+        negotiateMessageCompression(cmd, NULL, &noPort);
+        ASSERT_TRUE(noPort.obj().isEmpty());
+
+        BSONObjBuilder reply;
+        negotiateMessageCompression(cmd, &port, &reply);
+        ASSERT_TRUE(port.compressMessages());
+        ASSERT_TRUE(isMessageCompressionAccepted(reply.obj()));
+    }
+
+} // namespace
+} // namespace mongo
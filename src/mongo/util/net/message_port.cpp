@@ -42,6 +42,7 @@
 #include "mongo/util/log.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compressor.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/net/ssl_options.h"
 #include "mongo/util/scopeguard.h"
@@ -242,6 +243,12 @@ again:
 
             guard.Dismiss();
             m.setData(md.view2ptr(), true);
+
+            if ( md.getOperation() == dbCompressed && !decompressMessage( &m ) ) {
+                LOG(0) << "recv(): compressed message of len " << len << " is invalid";
+                m.reset();
+                return false;
+            }
             return true;
 
         }
@@ -301,20 +308,25 @@ again:
         toSend.header().setId(nextMessageId());
         toSend.header().setResponseTo(responseTo);
 
+        // toSend itself is left alone, callers may still look at it once it is sent
+        Message compressed;
+        Message& wire = compressMessages() && compressMessage( toSend, &compressed ) ?
+            compressed : toSend;
+
         if ( piggyBackData && piggyBackData->len() ) {
             mmm( log() << "*     have piggy back" << endl; )
-            if ( ( piggyBackData->len() + toSend.header().getLen() ) > 1300 ) {
+            if ( ( piggyBackData->len() + wire.header().getLen() ) > 1300 ) {
                 // won't fit in a packet - so just send it off
                 piggyBackData->flush();
             }
             else {
-                piggyBackData->append( toSend );
+                piggyBackData->append( wire );
                 piggyBackData->flush();
                 return;
             }
         }
 
-        toSend.send( *this, "say" );
+        wire.send( *this, "say" );
     }
 
     void MessagingPort::piggyBack( Message& toSend , int responseTo ) {
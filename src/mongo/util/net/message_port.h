@@ -43,7 +43,7 @@ namespace mongo {
 
     class AbstractMessagingPort : boost::noncopyable {
     public:
-        AbstractMessagingPort() : tag(0), _connectionId(0) {}
+        AbstractMessagingPort() : tag(0), _connectionId(0), _compressMessages(false) {}
         virtual ~AbstractMessagingPort() { }
         virtual void reply(Message& received, Message& response, MSGID responseTo) = 0; // like the reply below, but doesn't rely on received.data still being available
         virtual void reply(Message& received, Message& response) = 0;
@@ -64,6 +64,13 @@ namespace mongo {
         long long connectionId() const { return _connectionId; }
         void setConnectionId( long long connectionId );
 
+        /**
+         * Whether the messages sent on this port are compressed when worthwhile. Only turn this
+         * on once the other side agreed to it, see message_compressor.h.
+         */
+        bool compressMessages() const { return _compressMessages; }
+        void setCompressMessages( bool compressMessages ) { _compressMessages = compressMessages; }
+
     public:
         // TODO make this private with some helpers
 
@@ -73,6 +80,7 @@ namespace mongo {
     private:
         long long _connectionId;
         std::string _x509SubjectName;
+        bool _compressMessages;
     };
 
     class MessagingPort : public AbstractMessagingPort {
@@ -62,6 +62,41 @@ namespace mongo {
          * called once when a socket is disconnected
          */
         virtual void disconnected( AbstractMessagingPort* p ) = 0;
+
+        /**
+         * Per-connection state which connected() binds to the calling thread.  Handlers
+         * which can move that state between threads allow connections to be serviced by
+         * a shared pool of worker threads instead of one thread per connection.
+         *
+         * A ConnectionThreadState is created while attached and must be detached before
+         * it is destroyed.  Destroying it frees the state it owns.
+         */
+        class ConnectionThreadState {
+        public:
+            virtual ~ConnectionThreadState() {}
+
+            /** binds the state to the calling thread */
+            virtual void attach() = 0;
+
+            /** unbinds the state from the calling thread, keeping ownership of it */
+            virtual void detach() = 0;
+        };
+
+        /**
+         * Called on the thread which runs connected(), before it runs, when the server
+         * dispatches requests from a worker pool.  The returned state starts out attached and
+         * takes over whatever connected() binds to the thread on its first detach().
+         * Returns NULL if this handler keeps state which cannot leave the thread, which is
+         * the default.
+         */
+        virtual ConnectionThreadState* makeConnectionThreadState( AbstractMessagingPort* p ) {
+            return NULL;
+        }
+
+        /**
+         * Whether makeConnectionThreadState() returns non-NULL for this handler.
+         */
+        virtual bool supportsConnectionThreadHandoff() const { return false; }
     };
 
     class MessageServer {
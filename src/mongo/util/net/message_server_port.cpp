@@ -38,9 +38,11 @@
 #include "mongo/base/disallow_copying.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/server_options.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/stdx/functional.h"
 #include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/log.h"
@@ -50,9 +52,11 @@
 #include "mongo/util/net/message_port.h"
 #include "mongo/util/net/message_server.h"
 #include "mongo/util/net/ssl_manager.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/scopeguard.h"
 
 #ifdef __linux__  // TODO: consider making this ifndef _WIN32
+# include <sys/epoll.h>
 # include <sys/resource.h>
 #endif
 
@@ -84,6 +88,260 @@ namespace {
         MessageHandler* const _handler;
     };
 
+    // When non-zero, connections are serviced by this many shared worker threads instead of
+    // one thread per connection.  Idle connections then cost no thread at all.  Only used on
+    // Linux, without SSL, and with handlers that can move connection state between threads.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(connectionWorkerThreads, int, 0);
+
+    // When set, each connection thread only runs on the CPUs of one NUMA node and allocates its
+    // memory there, with connections dealt to the nodes by connection id.  Only used with a
+    // thread per connection.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(numaPinConnections, bool, false);
+
+    void bindConnectionThreadToNumaNode(long long connectionId) {
+        const size_t numNodes = ProcessInfo().getNumaNodeCpus().size();
+        if (numNodes > 0) {
+            ProcessInfo::bindThreadToNumaNode(static_cast<unsigned>(connectionId % numNodes));
+        }
+    }
+
+    void logEndConnection(MessagingPortWithHandler* portWithHandler) {
+        if (!serverGlobalParams.quiet) {
+            int conns = Listener::globalTicketHolder.used()-1;
+            const char* word = (conns == 1 ? " connection" : " connections");
+            log() << "end connection " << portWithHandler->psock->remoteString()
+                  << " (" << conns << word << " now open)" << endl;
+        }
+    }
+
+    /**
+     * Must be called from within a catch block.  Logs the in-flight exception and closes the
+     * connection, or terminates the server for exceptions which are not DBExceptions.
+     */
+    void closeConnectionOnException(MessagingPortWithHandler* portWithHandler) {
+        try {
+            throw;
+        }
+        catch ( AssertionException& e ) {
+            log() << "AssertionException handling request, closing client connection: " << e << endl;
+            portWithHandler->shutdown();
+        }
+        catch ( SocketException& e ) {
+            log() << "SocketException handling request, closing client connection: " << e << endl;
+            portWithHandler->shutdown();
+        }
+        catch ( const DBException& e ) { // must be right above std::exception to avoid catching subclasses
+            log() << "DBException handling request, closing client connection: " << e << endl;
+            portWithHandler->shutdown();
+        }
+        catch ( std::exception &e ) {
+            error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+            dbexit( EXIT_UNCAUGHT );
+        }
+    }
+
+    /**
+     * Receives and processes one message from the client.
+     *
+     * @return false if the client closed the connection.
+     */
+    bool handleOneMessage(MessagingPortWithHandler* portWithHandler, Message& m, LastError* le) {
+        m.reset();
+        portWithHandler->psock->clearCounters();
+
+        if (!portWithHandler->recv(m)) {
+            logEndConnection(portWithHandler);
+            portWithHandler->shutdown();
+            return false;
+        }
+
+        portWithHandler->getHandler()->process(m, portWithHandler, le);
+        networkCounter.hit(portWithHandler->psock->getBytesIn(),
+                           portWithHandler->psock->getBytesOut());
+        return true;
+    }
+
+#ifdef __linux__
+    /**
+     * Services connections from a fixed pool of worker threads.
+     *
+     * Each connection is registered with an epoll set in one-shot mode while it waits for its
+     * next request.  When a request arrives, a single reactor thread hands the connection to a
+     * worker, which attaches the connection's thread state, processes the message and re-arms
+     * the connection.  One-shot registration guarantees a connection is owned by at most one
+     * worker at a time, so requests on a connection are still handled in order.
+     *
+     * The dispatcher lives until the process exits, as do the threads of the thread per
+     * connection model.
+     */
+    class ConnectionDispatcher {
+        MONGO_DISALLOW_COPYING(ConnectionDispatcher);
+    public:
+        explicit ConnectionDispatcher(int nWorkers)
+            : _epfd(epoll_create(1024)),
+              _workers(nWorkers, "connWorker") {
+            if (_epfd < 0) {
+                const int err = errno;
+                severe() << "epoll_create failed: " << errnoWithDescription(err);
+                fassertFailed(28601);
+            }
+            boost::thread reactor(stdx::bind(&ConnectionDispatcher::_reactorLoop, this));
+        }
+
+        /**
+         * Takes ownership of the port and schedules the handler's connected() call.
+         */
+        void add(MessagingPortWithHandler* portWithHandler) {
+            _workers.schedule(&ConnectionDispatcher::_startConnection,
+                              this,
+                              new Connection(portWithHandler));
+        }
+
+    private:
+        struct Connection {
+            explicit Connection(MessagingPortWithHandler* portWithHandler)
+                : port(portWithHandler) {}
+
+            boost::scoped_ptr<MessagingPortWithHandler> port;
+
+            // Both are owned here while the connection is waiting for a request and by the
+            // servicing thread otherwise.
+            boost::scoped_ptr<MessageHandler::ConnectionThreadState> threadState;
+            LastError* le;
+        };
+
+        void _reactorLoop() {
+            setThreadName("connReactor");
+
+            const int kMaxEvents = 128;
+            struct epoll_event events[kMaxEvents];
+
+            while (!inShutdown()) {
+                const int n = epoll_wait(_epfd, events, kMaxEvents, 1000);
+                if (n < 0) {
+                    const int err = errno;
+                    if (err == EINTR)
+                        continue;
+                    severe() << "epoll_wait failed: " << errnoWithDescription(err);
+                    fassertFailed(28602);
+                }
+
+                for (int i = 0; i < n; i++) {
+                    _workers.schedule(&ConnectionDispatcher::_serviceConnection,
+                                      this,
+                                      static_cast<Connection*>(events[i].data.ptr));
+                }
+            }
+        }
+
+        void _attach(Connection* conn) {
+            setThreadName(std::string(str::stream() << "conn" << conn->port->connectionId()));
+            lastError.reset(conn->le);
+            conn->threadState->attach();
+        }
+
+        void _detach(Connection* conn) {
+            conn->threadState->detach();
+            conn->le = lastError.get();
+            lastError.release();
+        }
+
+        /**
+         * Waits for the next request on the connection, or registers it the first time.
+         */
+        bool _arm(Connection* conn, int op) {
+            struct epoll_event event;
+            event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            event.data.ptr = conn;
+            if (epoll_ctl(_epfd, op, conn->port->psock->rawFD(), &event) != 0) {
+                const int err = errno;
+                log() << "failed to wait for requests on connection " << conn->port->connectionId()
+                      << ", closing it: " << errnoWithDescription(err);
+                return false;
+            }
+            return true;
+        }
+
+        void _startConnection(Connection* conn) {
+            MessagingPortWithHandler* const port = conn->port.get();
+
+            setThreadName(std::string(str::stream() << "conn" << port->connectionId()));
+            port->psock->setLogLevel(logger::LogSeverity::Debug(1));
+
+            conn->le = new LastError();
+            lastError.reset(conn->le); // lastError now has ownership
+
+            conn->threadState.reset(port->getHandler()->makeConnectionThreadState(port));
+            invariant(conn->threadState);
+
+            try {
+                port->getHandler()->connected(port);
+            }
+            catch (...) {
+                closeConnectionOnException(port);
+                _endConnection(conn, false);
+                return;
+            }
+
+            _detach(conn);
+            if (!_arm(conn, EPOLL_CTL_ADD)) {
+                _attach(conn);
+                port->shutdown();
+                _endConnection(conn, false);
+            }
+        }
+
+        void _serviceConnection(Connection* conn) {
+            _attach(conn);
+
+            bool keepOpen = false;
+            try {
+                Message m;
+                keepOpen = !inShutdown() && handleOneMessage(conn->port.get(), m, conn->le);
+            }
+            catch (...) {
+                closeConnectionOnException(conn->port.get());
+            }
+
+            if (keepOpen) {
+                _detach(conn);
+                if (_arm(conn, EPOLL_CTL_MOD))
+                    return;
+                _attach(conn);
+                conn->port->shutdown();
+            }
+
+            _endConnection(conn, true);
+        }
+
+        /**
+         * Disconnects and frees a connection whose thread state is attached to this thread.
+         */
+        void _endConnection(Connection* conn, bool registered) {
+            TicketHolderReleaser connTicketReleaser(&Listener::globalTicketHolder);
+
+            if (registered) {
+                // Make sure the reactor will not report the connection once it is freed.
+                epoll_ctl(_epfd, EPOLL_CTL_DEL, conn->port->psock->rawFD(), NULL);
+            }
+
+#ifdef MONGO_SSL
+            SSLManagerInterface* manager = getSSLManager();
+            if (manager)
+                manager->cleanupThreadLocals();
+#endif
+            conn->port->getHandler()->disconnected(conn->port.get());
+
+            conn->threadState->detach();
+            lastError.reset(NULL);
+            delete conn;
+        }
+
+        const int _epfd;
+        ThreadPool _workers;
+    };
+#endif  // __linux__
+
 }  // namespace
 
     class PortMessageServer : public MessageServer , public Listener {
@@ -109,6 +367,14 @@ namespace {
                 return;
             }
 
+#ifdef __linux__
+            if (_dispatcher) {
+                _dispatcher->add(portWithHandler.release());
+                sleepAfterClosingPort.Dismiss();
+                return;
+            }
+#endif
+
             try {
 #ifndef __linux__  // TODO: consider making this ifdef _WIN32
                 {
@@ -169,6 +435,42 @@ namespace {
         }
 
         void run() {
+#ifdef __linux__
+            if (connectionWorkerThreads > 0) {
+                if (!_handler->supportsConnectionThreadHandoff()) {
+                    warning() << "connectionWorkerThreads is not supported by this server, "
+                              << "using a thread per connection" << endl;
+                }
+#ifdef MONGO_SSL
+                else if (getSSLManager()) {
+                    warning() << "connectionWorkerThreads is not supported with SSL, "
+                              << "using a thread per connection" << endl;
+                }
+#endif
+                else {
+                    log() << "servicing connections with " << connectionWorkerThreads
+                          << " worker threads" << endl;
+                    _dispatcher.reset(new ConnectionDispatcher(connectionWorkerThreads));
+                }
+            }
+#endif
+            if (numaPinConnections) {
+                const size_t numNodes = ProcessInfo().getNumaNodeCpus().size();
+                if (numNodes == 0) {
+                    warning() << "numaPinConnections has no effect on a host with one NUMA node"
+                              << endl;
+                }
+#ifdef __linux__
+                else if (_dispatcher) {
+                    warning() << "numaPinConnections is not supported with "
+                              << "connectionWorkerThreads" << endl;
+                }
+#endif
+                else {
+                    log() << "pinning connection threads to " << numNodes << " NUMA nodes"
+                          << endl;
+                }
+            }
             initAndListen();
         }
 
@@ -176,6 +478,9 @@ namespace {
 
     private:
         MessageHandler* _handler;
+#ifdef __linux__
+        boost::scoped_ptr<ConnectionDispatcher> _dispatcher;
+#endif
 
         /**
          * Handles incoming messages from a given socket.
@@ -199,6 +504,9 @@ namespace {
 
             setThreadName(std::string(str::stream() << "conn" << portWithHandler->connectionId()));
             portWithHandler->psock->setLogLevel(logger::LogSeverity::Debug(1));
+            if (numaPinConnections) {
+                bindConnectionThreadToNumaNode(portWithHandler->connectionId());
+            }
 
             Message m;
             try {
@@ -208,40 +516,13 @@ namespace {
                 handler->connected(portWithHandler.get());
 
                 while ( ! inShutdown() ) {
-                    m.reset();
-                    portWithHandler->psock->clearCounters();
-
-                    if (!portWithHandler->recv(m)) {
-                        if (!serverGlobalParams.quiet) {
-                            int conns = Listener::globalTicketHolder.used()-1;
-                            const char* word = (conns == 1 ? " connection" : " connections");
-                            log() << "end connection " << portWithHandler->psock->remoteString()
-                                  << " (" << conns << word << " now open)" << endl;
-                        }
-                        portWithHandler->shutdown();
+                    if (!handleOneMessage(portWithHandler.get(), m, le)) {
                         break;
                     }
-
-                    handler->process(m, portWithHandler.get(), le);
-                    networkCounter.hit(portWithHandler->psock->getBytesIn(),
-                                       portWithHandler->psock->getBytesOut());
                 }
             }
-            catch ( AssertionException& e ) {
-                log() << "AssertionException handling request, closing client connection: " << e << endl;
-                portWithHandler->shutdown();
-            }
-            catch ( SocketException& e ) {
-                log() << "SocketException handling request, closing client connection: " << e << endl;
-                portWithHandler->shutdown();
-            }
-            catch ( const DBException& e ) { // must be right above std::exception to avoid catching subclasses
-                log() << "DBException handling request, closing client connection: " << e << endl;
-                portWithHandler->shutdown();
-            }
-            catch ( std::exception &e ) {
-                error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
-                dbexit( EXIT_UNCAUGHT );
+            catch (...) {
+                closeConnectionOnException(portWithHandler.get());
             }
 
             // Normal disconnect path.
@@ -33,6 +33,10 @@
 
 #include "mongo/util/net/sock.h"
 
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
 #if !defined(_WIN32)
 # include <sys/socket.h>
 # include <sys/types.h>
@@ -621,15 +625,53 @@ namespace mongo {
     }
 
     void Socket::_send( const vector< pair< char *, int > > &data, const char *context ) {
+        // Each SSL_write makes at least one TLS record, so rather than writing a message's header
+        // and body separately, pack consecutive buffers together up to the largest record size.
+        // Buffers which would fill a record by themselves are written as they are.
+        const int maxCoalesced = 16 * 1024;
+        char coalesced[maxCoalesced];
+        int used = 0;
+
         for (vector< pair<char *, int> >::const_iterator i = data.begin(); 
              i != data.end(); 
              ++i) {
-            char * data = i->first;
+            const char * data = i->first;
             int len = i->second;
-            send( data, len, context );
+
+            while ( len > 0 ) {
+                if ( used == 0 && len >= maxCoalesced ) {
+                    send( data, len, context );
+                    break;
+                }
+
+                const int n = std::min( len, maxCoalesced - used );
+                memcpy( coalesced + used, data, n );
+                used += n;
+                data += n;
+                len -= n;
+
+                if ( used == maxCoalesced ) {
+                    send( coalesced, used, context );
+                    used = 0;
+                }
+            }
+        }
+
+        if ( used > 0 ) {
+            send( coalesced, used, context );
         }
     }
 
+#if !defined(_WIN32)
+namespace {
+#if defined(IOV_MAX)
+    const size_t maxIovecs = IOV_MAX;
+#else
+    const size_t maxIovecs = 16; // the least POSIX allows
+#endif
+} // namespace
+#endif
+
     /** sends all data or throws an exception
      * @param context descriptive for logging
      */
@@ -661,9 +703,13 @@ namespace mongo {
         struct msghdr meta;
         memset( &meta, 0, sizeof( meta ) );
         meta.msg_iov = &d[ 0 ];
-        meta.msg_iovlen = d.size();
 
-        while( meta.msg_iovlen > 0 ) {
+        // Replies may reference many separate documents, but sendmsg takes at most IOV_MAX
+        // buffers at a time
+        size_t remaining = i;
+        while( remaining > 0 ) {
+            meta.msg_iovlen = std::min( remaining, maxIovecs );
+
             int ret = -1;
             if (MONGO_FAIL_POINT(throwSockExcep)) {
 #if defined(_WIN32)
@@ -699,7 +745,7 @@ namespace mongo {
                     else {
                         ret -= i->iov_len;
                         ++i;
-                        --(meta.msg_iovlen);
+                        --remaining;
                     }
                 }
             }
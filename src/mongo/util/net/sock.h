@@ -291,7 +291,7 @@ namespace mongo {
     private:
         void _init();
 
-        /** sends dumbly, just each buffer at a time */
+        /** sends the buffers with as few writes as copying up to 16KB of them allows */
         void _send( const std::vector< std::pair< char *, int > > &data, const char *context );
 
         /** raw send, same semantics as ::send with an additional context parameter */
@@ -35,6 +35,7 @@
 #include <boost/thread/recursive_mutex.hpp>
 #include <boost/thread/tss.hpp>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -231,6 +232,23 @@ namespace mongo {
             bool _allowInvalidHostnames;
             SSLConfiguration _sslConfiguration;
 
+            // Sessions of outgoing connections by remote address, resumed by the next connection
+            // to the same address to skip a full handshake. Each holds a reference.
+            typedef std::map<std::string, SSL_SESSION*> SessionMap;
+            SimpleMutex _clientSessionsMutex;
+            SessionMap _clientSessions;
+
+            /**
+             * Sets the session saved for remote, if any, to be resumed by conn.
+             */
+            void _resumeClientSession(SSLConnection* conn, const std::string& remote);
+
+            /**
+             * Saves the session conn established with remote, or forgets the session saved for
+             * remote if the handshake failed.
+             */
+            void _saveClientSession(SSLConnection* conn, const std::string& remote, bool ok);
+
             /**
              * creates an SSL object to be used for this file descriptor.
              * caller must SSL_free it.
@@ -415,12 +433,24 @@ namespace mongo {
 
     SSLManagerInterface::~SSLManagerInterface() {}
 
+    namespace {
+        // How long sessions may be resumed for
+        const long kSessionTimeoutSecs = 60 * 60;
+
+        // At most this many client sessions are kept, which is one per remote address
+        const size_t kMaxClientSessions = 1024;
+
+        // Sessions are only resumed by contexts with the same id
+        const unsigned char kSessionIdContext[] = "MongoDB";
+    }
+
     SSLManager::SSLManager(const Params& params, bool isServer) :
         _serverContext(NULL),
         _clientContext(NULL),
         _weakValidation(params.weakCertificateValidation),
         _allowInvalidCertificates(params.allowInvalidCertificates),
-        _allowInvalidHostnames(params.allowInvalidHostnames) {
+        _allowInvalidHostnames(params.allowInvalidHostnames),
+        _clientSessionsMutex("SSLManager client sessions") {
 
         SSL_library_init();
         SSL_load_error_strings();
@@ -491,6 +521,10 @@ namespace mongo {
         if (NULL != _clientContext) {
             SSL_CTX_free(_clientContext);
         }
+        for (SessionMap::iterator it = _clientSessions.begin(); it != _clientSessions.end();
+             ++it) {
+            SSL_SESSION_free(it->second);
+        }
     }
 
     int SSLManager::password_cb(char *buf,int num, int rwflag,void *userdata) {
@@ -595,8 +629,20 @@ namespace mongo {
         // Note: this is for blocking sockets only.
         SSL_CTX_set_mode(*context, SSL_MODE_AUTO_RETRY);
 
-        // Disable session caching (see SERVER-10261)
-        SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_OFF);
+        // Let reconnecting clients resume their session, from the server's session cache or a
+        // session ticket, instead of making a full handshake. Setting the session id context is
+        // what lets sessions be resumed when client certificates are requested (see SERVER-10261).
+        // Clients keep their own sessions by remote address, see _resumeClientSession.
+        if (context == &_serverContext) {
+            SSL_CTX_set_session_id_context(*context,
+                                           kSessionIdContext,
+                                           sizeof(kSessionIdContext) - 1);
+            SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_SERVER);
+        }
+        else {
+            SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_OFF);
+        }
+        SSL_CTX_set_timeout(*context, kSessionTimeoutSecs);
  
         // Use the clusterfile for internal outgoing SSL connections if specified 
         if (context == &_clientContext && !params.clusterfile.empty()) {
@@ -860,18 +906,59 @@ namespace mongo {
         }
     }
 
+    void SSLManager::_resumeClientSession(SSLConnection* conn, const std::string& remote) {
+        SimpleMutex::scoped_lock lk(_clientSessionsMutex);
+        SessionMap::const_iterator it = _clientSessions.find(remote);
+        if (it != _clientSessions.end()) {
+            // Takes its own reference, so the session outlives its removal from the map
+            SSL_set_session(conn->ssl, it->second);
+        }
+    }
+
+    void SSLManager::_saveClientSession(SSLConnection* conn, const std::string& remote, bool ok) {
+        if (ok && SSL_session_reused(conn->ssl)) {
+            return;
+        }
+
+        SSL_SESSION* session = ok ? SSL_get1_session(conn->ssl) : NULL;
+
+        SimpleMutex::scoped_lock lk(_clientSessionsMutex);
+        SessionMap::iterator it = _clientSessions.find(remote);
+        if (it != _clientSessions.end()) {
+            SSL_SESSION_free(it->second);
+            _clientSessions.erase(it);
+        }
+        if (!session) {
+            return;
+        }
+        if (_clientSessions.size() >= kMaxClientSessions) {
+            SSL_SESSION_free(_clientSessions.begin()->second);
+            _clientSessions.erase(_clientSessions.begin());
+        }
+        _clientSessions[remote] = session;
+    }
+
     SSLConnection* SSLManager::connect(Socket* socket) {
         SSLConnection* sslConn = new SSLConnection(_clientContext, socket, NULL, 0);
         ScopeGuard sslGuard = MakeGuard(::SSL_free, sslConn->ssl);
         ScopeGuard bioGuard = MakeGuard(::BIO_free, sslConn->networkBIO);
+
+        const std::string remote = socket->remoteString();
+        _resumeClientSession(sslConn, remote);
  
         int ret;
         do {
             ret = ::SSL_connect(sslConn->ssl);
         } while(!_doneWithSSLOp(sslConn, ret));
+
+        _saveClientSession(sslConn, remote, ret == 1);
  
         if (ret != 1)
             _handleSSLError(SSL_get_error(sslConn, ret), ret);
+
+        LOG(3) << "SSL connection to " << remote << (SSL_session_reused(sslConn->ssl) ?
+                                                     " resumed its session" :
+                                                     " made a full handshake");
  
         sslGuard.Dismiss();
         bioGuard.Dismiss();
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "mongo/platform/cstdint.h"
 #include "mongo/platform/process_id.h"
@@ -97,6 +98,29 @@ namespace mongo {
          */
         bool hasNumaEnabled() const { return sysInfo().hasNuma; }
 
+        /**
+         * Get the CPUs of each NUMA node, indexed by node. Empty on hosts with a single node and
+         * where NUMA topology isn't known.
+         */
+        const std::vector<std::vector<int> >& getNumaNodeCpus() const {
+            return sysInfo().numaNodeCpus;
+        }
+
+        /**
+         * Restricts the calling thread to the CPUs of NUMA node 'node', and makes it allocate
+         * memory on that node when it can, whatever policy the process was started with.
+         *
+         * @return false if unsupported or on failure
+         */
+        static bool bindThreadToNumaNode(unsigned node);
+
+        /**
+         * Appends { nodes: [ { node, residentPages } ] }, the pages of this process resident on
+         * each NUMA node. Reads all of /proc/self/numa_maps on Linux, so is slow for processes
+         * with many mappings. Appends nothing where unsupported.
+         */
+        static void appendNumaStats(BSONObjBuilder& info);
+
         /**
          * Determine if file zeroing is necessary for newly allocated data files.
          */
@@ -160,6 +184,7 @@ namespace mongo {
             unsigned long long pageSize;
             std::string cpuArch;
             bool hasNuma;
+            std::vector<std::vector<int> > numaNodeCpus;
             BSONObj _extraStats;
 
             // This is an OS specific value, which determines whether files should be zero-filled
@@ -198,6 +198,12 @@ namespace mongo {
         return false;
     }
 
+    bool ProcessInfo::bindThreadToNumaNode(unsigned node) {
+        return false;
+    }
+
+    void ProcessInfo::appendNumaStats(BSONObjBuilder& info) {}
+
     bool ProcessInfo::blockCheckSupported() {
         return true;
     }
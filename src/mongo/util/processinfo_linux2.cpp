@@ -30,10 +30,15 @@
 #define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kControl
 
 #include <malloc.h>
+#include <fstream>
 #include <iostream>
+#include <linux/mempolicy.h>
+#include <sched.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <gnu/libc-version.h>
 #include <sys/utsname.h>
 
@@ -41,6 +46,7 @@
 #include "boost/filesystem.hpp"
 #include <mongo/util/file.h>
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
 
 using namespace std;
 
@@ -350,6 +356,45 @@ namespace mongo {
         /**
         * Get system memory total
         */
+        /**
+        * Get the CPUs of each NUMA node from sysfs, if there is more than one node
+        */
+        static void getNumaNodeCpus(vector<vector<int> >* nodes) {
+            for (int node = 0; ; node++) {
+                const string path =
+                    str::stream() << "/sys/devices/system/node/node" << node << "/cpulist";
+                if (!boost::filesystem::exists(path)) {
+                    break;
+                }
+
+                // A list of ranges, such as "0-7,16-23".
+                vector<int> cpus;
+                const string list = readLineFromFile(path.c_str());
+                const char* p = list.c_str();
+                while (*p) {
+                    char* end;
+                    const long first = strtol(p, &end, 10);
+                    if (end == p) {
+                        break;
+                    }
+                    long last = first;
+                    if (*end == '-') {
+                        p = end + 1;
+                        last = strtol(p, &end, 10);
+                    }
+                    for (long cpu = first; cpu <= last; cpu++) {
+                        cpus.push_back(static_cast<int>(cpu));
+                    }
+                    p = (*end == ',') ? end + 1 : "";
+                }
+                nodes->push_back(cpus);
+            }
+
+            if (nodes->size() < 2) {
+                nodes->clear();
+            }
+        }
+
         static unsigned long long getSystemMemorySize() {
             string meminfo = readLineFromFile( "/proc/meminfo" );
             size_t lineOff= 0;
@@ -432,7 +477,14 @@ namespace mongo {
         pageSize = static_cast<unsigned long long>(sysconf( _SC_PAGESIZE ));
         cpuArch = unameData.machine;
         hasNuma = checkNumaEnabled();
-        
+        try {
+            LinuxSysHelper::getNumaNodeCpus(&numaNodeCpus);
+        }
+        catch (boost::filesystem::filesystem_error& e) {
+            log() << "Unable to read NUMA topology: " << e.what();
+            numaNodeCpus.clear();
+        }
+
         BSONObjBuilder bExtra;
         bExtra.append( "versionString", LinuxSysHelper::readLineFromFile( "/proc/version" ) );
         bExtra.append( "libcVersion", gnu_get_libc_version() );
@@ -481,6 +533,65 @@ namespace mongo {
         return false;
     }
 
+    bool ProcessInfo::bindThreadToNumaNode(unsigned node) {
+        const vector<vector<int> >& nodes = systemInfo->numaNodeCpus;
+        const unsigned kMaxNodes = 1024;
+        if (node >= nodes.size() || node >= kMaxNodes) {
+            return false;
+        }
+
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (size_t i = 0; i < nodes[node].size(); i++) {
+            CPU_SET(nodes[node][i], &cpus);
+        }
+        if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+            log() << "sched_setaffinity failed: " << errnoWithDescription() << endl;
+            return false;
+        }
+
+        // Threads start with the process' memory policy, which is interleaved when started under
+        // numactl --interleave. Prefer the node's own memory instead.
+        const unsigned bitsPerLong = sizeof(unsigned long) * 8;
+        unsigned long nodeMask[kMaxNodes / (sizeof(unsigned long) * 8)] = {0};
+        nodeMask[node / bitsPerLong] |= 1UL << (node % bitsPerLong);
+        if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, nodeMask, kMaxNodes) != 0) {
+            log() << "set_mempolicy failed: " << errnoWithDescription() << endl;
+            return false;
+        }
+        return true;
+    }
+
+    void ProcessInfo::appendNumaStats(BSONObjBuilder& info) {
+        const size_t numNodes = systemInfo->numaNodeCpus.size();
+        if (numNodes == 0) {
+            return;
+        }
+
+        vector<long long> pages(numNodes, 0);
+        ifstream maps("/proc/self/numa_maps");
+        string line;
+        while (getline(maps, line)) {
+            // Each mapping lists its resident pages on each node as N<node>=<pages>.
+            size_t pos = 0;
+            while ((pos = line.find(" N", pos)) != string::npos) {
+                pos += 2;
+                char* end;
+                const unsigned long node = strtoul(line.c_str() + pos, &end, 10);
+                if (*end != '=' || node >= numNodes) {
+                    continue;
+                }
+                pages[node] += strtoll(end + 1, NULL, 10);
+            }
+        }
+
+        BSONArrayBuilder nodes(info.subarrayStart("nodes"));
+        for (size_t i = 0; i < numNodes; i++) {
+            nodes.append(BSON("node" << static_cast<int>(i) << "residentPages" << pages[i]));
+        }
+        nodes.done();
+    }
+
     bool ProcessInfo::blockCheckSupported() {
         return true;
     }
@@ -179,6 +179,12 @@ namespace mongo {
         return true;
     }
 
+    bool ProcessInfo::bindThreadToNumaNode(unsigned node) {
+        return false;
+    }
+
+    void ProcessInfo::appendNumaStats(BSONObjBuilder& info) {}
+
     bool ProcessInfo::blockCheckSupported() {
         return true;
     }
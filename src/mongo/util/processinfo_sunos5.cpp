@@ -207,6 +207,12 @@ namespace mongo {
         return groups > 1;
     }
 
+    bool ProcessInfo::bindThreadToNumaNode(unsigned node) {
+        return false;
+    }
+
+    void ProcessInfo::appendNumaStats(BSONObjBuilder& info) {}
+
     bool ProcessInfo::blockCheckSupported() {
         return true;
     }
@@ -376,6 +376,12 @@ namespace mongo {
         return numaNodeCount > 1;
     }
 
+    bool ProcessInfo::bindThreadToNumaNode(unsigned node) {
+        return false;
+    }
+
+    void ProcessInfo::appendNumaStats(BSONObjBuilder& info) {}
+
     bool ProcessInfo::blockCheckSupported() {
         return psapiGlobal->supported;
     }
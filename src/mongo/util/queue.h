@@ -169,6 +169,23 @@ namespace mongo {
             return true;
         }
 
+        /**
+         * blocks until the size of the queue drops below 'size' or maxSecondsToWait passes
+         * returns whether the size is below 'size'
+         */
+        bool waitForSizeBelow( size_t size, int maxSecondsToWait ) {
+            boost::xtime xt;
+            boost::xtime_get(&xt, MONGO_BOOST_TIME_UTC);
+            xt.sec += maxSecondsToWait;
+
+            scoped_lock l( _lock );
+            while( _currentSize >= size ) {
+                if ( ! _cvNoLongerFull.timed_wait( l.boost() , xt ) )
+                    return _currentSize < size;
+            }
+            return true;
+        }
+
         // Obviously, this should only be used when you have
         // only one consumer
         bool blockingPeek(T& t, int maxSecondsToWait) {
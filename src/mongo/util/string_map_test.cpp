@@ -143,6 +143,40 @@ namespace {
         ASSERT_EQUALS( before, m.capacity() );
     }
 
+    TEST( StringMapTest, EraseMany ) {
+        StringMap<int> m;
+        char buf[64];
+
+        for ( int i = 0; i < 10000; i++ ) {
+            sprintf( buf, "foo%d", i );
+            m[buf] = i;
+        }
+        for ( int i = 0; i < 10000; i += 2 ) {
+            sprintf( buf, "foo%d", i );
+            ASSERT_EQUALS( 1U, m.erase( buf ) );
+        }
+        ASSERT_EQUALS( 5000U, m.size() );
+
+        for ( int i = 0; i < 10000; i++ ) {
+            sprintf( buf, "foo%d", i );
+            StringMap<int>::const_iterator it = m.find( buf );
+            if ( i % 2 ) {
+                ASSERT( it != m.end() );
+                ASSERT_EQUALS( i, it->second );
+            }
+            else {
+                ASSERT( it == m.end() );
+            }
+        }
+
+        size_t count = 0;
+        for ( StringMap<int>::const_iterator it = m.begin(); it != m.end(); ++it ) {
+            ASSERT_EQUALS( 1, it->second % 2 );
+            count++;
+        }
+        ASSERT_EQUALS( 5000U, count );
+    }
+
     TEST( StringMapTest, Erase2 ) {
         StringMap<int> m;
         m["eliot"] = 5;
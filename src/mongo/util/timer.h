@@ -72,6 +72,16 @@ namespace mongo {
             return ((now() - _old) * microsPerSecond) / _countsPerSecond;
         }
 
+        /**
+         * Nanoseconds elapsed. Converts whole seconds and the remaining ticks separately so that
+         * long intervals do not overflow at nanosecond resolution.
+         */
+        inline long long nanos() const {
+            const long long ticks = now() - _old;
+            return (ticks / _countsPerSecond) * nanosPerSecond +
+                ((ticks % _countsPerSecond) * nanosPerSecond) / _countsPerSecond;
+        }
+
         inline void reset() { _old = now(); }
 
         /**
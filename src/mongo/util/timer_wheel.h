@@ -0,0 +1,200 @@
+// timer_wheel.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <list>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    /**
+     * Hierarchical timer wheel: schedules values to expire at a deadline, in milliseconds of a
+     * clock owned by the caller, and hands them back once the wheel is advanced past it.
+     * Scheduling, cancelling and expiring each cost O(1), however many timers are pending,
+     * instead of a walk over all of them on every sweep.
+     *
+     * Deadlines are rounded up to whole ticks, so a timer never expires early but can expire up
+     * to one tick late. Level 0 has one slot per tick; each level above has slots covering a
+     * whole turn of the level below, and a slot's timers are moved down a level when the level
+     * below comes back around to it. Deadlines beyond the top level are parked in it and moved
+     * down again as the wheel turns.
+     *
+     * Not thread safe.
+     */
+    template <typename T>
+    class TimerWheel {
+        MONGO_DISALLOW_COPYING(TimerWheel);
+
+        struct Entry {
+            Entry(const T& value, long long deadlineTick) : value(value),
+                                                            deadlineTick(deadlineTick),
+                                                            level(0),
+                                                            slot(0) {}
+            T value;
+            long long deadlineTick;
+            int level;
+            int slot;
+        };
+
+        typedef std::list<Entry> Slot;
+
+    public:
+        typedef typename Slot::iterator Handle;
+
+        static const int kLevels = 4;
+        static const int kSlotBits = 6;
+        static const int kSlots = 1 << kSlotBits;
+
+        /**
+         * 'tickMillis' is the resolution of the wheel, and 'nowMillis' the time it starts at.
+         */
+        TimerWheel(long long tickMillis, long long nowMillis)
+            : _tickMillis(tickMillis),
+              _nowTick(nowMillis / tickMillis),
+              _size(0) {
+            invariant(tickMillis > 0);
+        }
+
+        /**
+         * Schedules 'value' to expire once the wheel is advanced to 'deadlineMillis' or later. A
+         * deadline already passed expires at the next tick. The handle stays valid until the
+         * timer expires or is cancelled.
+         */
+        Handle schedule(long long deadlineMillis, const T& value) {
+            const long long deadlineTick =
+                std::max((deadlineMillis + _tickMillis - 1) / _tickMillis, _nowTick + 1);
+            Slot scratch;
+            scratch.push_back(Entry(value, deadlineTick));
+            const Handle handle = scratch.begin();
+            _place(&scratch, handle);
+            _size++;
+            return handle;
+        }
+
+        void cancel(Handle handle) {
+            _slots[handle->level][handle->slot].erase(handle);
+            _size--;
+        }
+
+        /**
+         * Moves the wheel forward to 'nowMillis', appending the values of the timers expiring on
+         * the way to 'expired'.
+         */
+        void advance(long long nowMillis, std::vector<T>* expired) {
+            const long long targetTick = nowMillis / _tickMillis;
+            while (_nowTick < targetTick) {
+                if (_size == 0) {
+                    _nowTick = targetTick;
+                    return;
+                }
+
+                _nowTick++;
+
+                // Bring down the timers of the higher levels whose slot comes up, lowest first
+                for (int level = 1; level < kLevels; level++) {
+                    if (_index(_nowTick, level - 1) != 0) {
+                        break;
+                    }
+                    _cascade(&_slots[level][_index(_nowTick, level)]);
+                }
+
+                Slot& due = _slots[0][_index(_nowTick, 0)];
+                while (!due.empty()) {
+                    const Handle handle = due.begin();
+                    if (handle->deadlineTick > _nowTick) {
+                        // Parked beyond the top level
+                        _place(&due, handle);
+                        continue;
+                    }
+                    expired->push_back(handle->value);
+                    due.erase(handle);
+                    _size--;
+                }
+            }
+        }
+
+        void clear() {
+            for (int level = 0; level < kLevels; level++) {
+                for (int slot = 0; slot < kSlots; slot++) {
+                    _slots[level][slot].clear();
+                }
+            }
+            _size = 0;
+        }
+
+        size_t size() const { return _size; }
+
+    private:
+        static int _index(long long tick, int level) {
+            return static_cast<int>((tick >> (level * kSlotBits)) & (kSlots - 1));
+        }
+
+        /**
+         * Moves the entry at 'handle' out of 'from' into the slot its deadline falls in. The
+         * deadline must not have passed, though it can be the current tick while cascading, as
+         * the current level 0 slot is only expired after that.
+         */
+        void _place(Slot* from, Handle handle) {
+            long long tick = handle->deadlineTick;
+            const long long delta = tick - _nowTick;
+
+            int level = 0;
+            while (level < kLevels - 1 && delta >= (1LL << ((level + 1) * kSlotBits))) {
+                level++;
+            }
+            if (delta >= (1LL << (kLevels * kSlotBits))) {
+                tick = _nowTick + (1LL << (kLevels * kSlotBits)) - 1;
+            }
+
+            handle->level = level;
+            handle->slot = _index(tick, level);
+            Slot& to = _slots[level][handle->slot];
+            to.splice(to.end(), *from, handle);
+        }
+
+        void _cascade(Slot* slot) {
+            while (!slot->empty()) {
+                _place(slot, slot->begin());
+            }
+        }
+
+        const long long _tickMillis;
+        long long _nowTick;
+        size_t _size;
+
+        Slot _slots[kLevels][kSlots];
+    };
+
+} // namespace mongo
@@ -0,0 +1,138 @@
+// timer_wheel_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/timer_wheel.h"
+
+namespace {
+
+    using mongo::TimerWheel;
+
+    typedef TimerWheel<int> Wheel;
+
+    std::vector<int> advance(Wheel* wheel, long long nowMillis) {
+        std::vector<int> expired;
+        wheel->advance(nowMillis, &expired);
+        std::sort(expired.begin(), expired.end());
+        return expired;
+    }
+
+    /**
+     * Advances 'wheel' to 'nowMillis', expecting exactly one timer to expire, and returns it.
+     */
+    int advanceOne(Wheel* wheel, long long nowMillis) {
+        const std::vector<int> expired = advance(wheel, nowMillis);
+        ASSERT_EQUALS(1U, expired.size());
+        return expired[0];
+    }
+
+    TEST(TimerWheel, ExpiresAtDeadline) {
+        Wheel wheel(10, 0);
+        wheel.schedule(50, 1);
+        wheel.schedule(55, 2);
+        ASSERT_EQUALS(2U, wheel.size());
+
+        ASSERT(advance(&wheel, 49).empty());
+        ASSERT_EQUALS(1, advanceOne(&wheel, 50));
+        // Rounded up to the next tick
+        ASSERT(advance(&wheel, 59).empty());
+        ASSERT_EQUALS(2, advanceOne(&wheel, 60));
+        ASSERT_EQUALS(0U, wheel.size());
+    }
+
+    TEST(TimerWheel, PastDeadlineExpiresAtNextTick) {
+        Wheel wheel(10, 1000);
+        wheel.schedule(0, 1);
+        ASSERT(advance(&wheel, 1009).empty());
+        ASSERT_EQUALS(1, advanceOne(&wheel, 1010));
+    }
+
+    TEST(TimerWheel, Cancel) {
+        Wheel wheel(1, 0);
+        Wheel::Handle handle = wheel.schedule(100, 1);
+        wheel.schedule(100, 2);
+        wheel.cancel(handle);
+        ASSERT_EQUALS(2, advanceOne(&wheel, 100));
+    }
+
+    TEST(TimerWheel, CancelAfterCascade) {
+        Wheel wheel(1, 0);
+        Wheel::Handle handle = wheel.schedule(10000, 1);
+        wheel.schedule(10000, 2);
+        // Both moved down from the higher levels on the way
+        ASSERT(advance(&wheel, 9990).empty());
+        wheel.cancel(handle);
+        ASSERT_EQUALS(2, advanceOne(&wheel, 10000));
+    }
+
+    TEST(TimerWheel, AllLevels) {
+        Wheel wheel(1, 0);
+        const long long deadlines[] = {1, 63, 64, 65, 4095, 4096, 4097, 262143, 262144, 300000,
+                                       16777215, 16777216, 20000000, 40000000};
+        const int n = sizeof(deadlines) / sizeof(deadlines[0]);
+        for (int i = 0; i < n; i++) {
+            wheel.schedule(deadlines[i], i);
+        }
+
+        // Each expires on its own tick, in order, however far the wheel moves at a time
+        long long now = 0;
+        for (int i = 0; i < n; i++) {
+            ASSERT(advance(&wheel, deadlines[i] - 1).empty());
+            ASSERT_EQUALS(i, advanceOne(&wheel, deadlines[i]));
+            now = deadlines[i];
+        }
+        ASSERT_EQUALS(0U, wheel.size());
+        ASSERT(advance(&wheel, now * 2).empty());
+    }
+
+    TEST(TimerWheel, ManyAtOnce) {
+        Wheel wheel(1000, 0);
+        for (int i = 0; i < 10000; i++) {
+            wheel.schedule(600 * 1000 + (i % 10) * 1000, i);
+        }
+        ASSERT(advance(&wheel, 599 * 1000).empty());
+        ASSERT_EQUALS(1000U, advance(&wheel, 600 * 1000).size());
+        ASSERT_EQUALS(9000U, advance(&wheel, 610 * 1000).size());
+    }
+
+    TEST(TimerWheel, Clear) {
+        Wheel wheel(1, 0);
+        wheel.schedule(5, 1);
+        wheel.schedule(5000, 2);
+        wheel.clear();
+        ASSERT_EQUALS(0U, wheel.size());
+        ASSERT(advance(&wheel, 10000).empty());
+    }
+
+} // namespace
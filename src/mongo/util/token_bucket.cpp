@@ -0,0 +1,88 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/token_bucket.h"
+
+#include <algorithm>
+
+namespace mongo {
+
+    TokenBucket::TokenBucket()
+        : _rate(0),
+          _tokens(0),
+          _lastRefillMicros(-1) {
+    }
+
+    void TokenBucket::setRate(long long tokensPerSecond) {
+        if (tokensPerSecond == _rate) {
+            return;
+        }
+
+        if (_rate <= 0) {
+            // Coming from no limit, start with a full bucket
+            _lastRefillMicros = -1;
+        }
+
+        _rate = tokensPerSecond;
+        _tokens = std::min(_tokens, static_cast<double>(_rate));
+    }
+
+    void TokenBucket::_refill(long long nowMicros) {
+        if (_lastRefillMicros < 0) {
+            _tokens = _rate;
+            _lastRefillMicros = nowMicros;
+            return;
+        }
+
+        if (nowMicros <= _lastRefillMicros) {
+            return;
+        }
+
+        const double added = (nowMicros - _lastRefillMicros) * (_rate / 1000000.0);
+        _tokens = std::min(_tokens + added, static_cast<double>(_rate));
+        _lastRefillMicros = nowMicros;
+    }
+
+    long long TokenBucket::consume(long long tokens, long long nowMicros) {
+        if (_rate <= 0) {
+            return 0;
+        }
+
+        _refill(nowMicros);
+        _tokens -= tokens;
+
+        if (_tokens >= 0) {
+            return 0;
+        }
+
+        return static_cast<long long>(-_tokens * 1000000.0 / _rate);
+    }
+
+} // namespace mongo
@@ -0,0 +1,74 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+
+    /**
+     * Token bucket for limiting the rate of some activity, like the number of documents or bytes
+     * deleted per second. The bucket holds at most one second worth of tokens, so a caller idle
+     * for a while can burst for up to one second before being throttled.
+     *
+     * Callers take the tokens for work they already did and then wait for the time returned, so
+     * the bucket can go into debt. Not thread safe.
+     */
+    class TokenBucket {
+    public:
+        TokenBucket();
+
+        /**
+         * Sets the number of tokens added per second. A rate of zero or less turns off the limit.
+         * The tokens in the bucket are capped at the new rate.
+         */
+        void setRate(long long tokensPerSecond);
+
+        long long getRate() const { return _rate; }
+
+        /**
+         * Takes 'tokens' out of the bucket at time 'nowMicros' and returns the number of
+         * microseconds the caller must wait for the bucket to be out of debt again. Returns zero
+         * if there is no limit or there were enough tokens.
+         */
+        long long consume(long long tokens, long long nowMicros);
+
+    private:
+        void _refill(long long nowMicros);
+
+        long long _rate;
+
+        // Can be negative, when the bucket is in debt
+        double _tokens;
+
+        // Time of the last refill, or -1 if the bucket was never used since the last rate change
+        long long _lastRefillMicros;
+    };
+
+} // namespace mongo
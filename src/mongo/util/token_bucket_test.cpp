@@ -0,0 +1,88 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/token_bucket.h"
+
+namespace {
+
+    using mongo::TokenBucket;
+
+    TEST(TokenBucket, NoLimitNeverWaits) {
+        TokenBucket bucket;
+        ASSERT_EQUALS(0, bucket.consume(1000000, 0));
+        bucket.setRate(0);
+        ASSERT_EQUALS(0, bucket.consume(1000000, 0));
+    }
+
+    TEST(TokenBucket, StartsFull) {
+        TokenBucket bucket;
+        bucket.setRate(100);
+        ASSERT_EQUALS(0, bucket.consume(100, 0));
+        // Empty now, one token takes 1/100th of a second
+        ASSERT_EQUALS(10000, bucket.consume(1, 0));
+    }
+
+    TEST(TokenBucket, Debt) {
+        TokenBucket bucket;
+        bucket.setRate(10);
+        // Twice the capacity, one second worth of debt
+        ASSERT_EQUALS(1000000, bucket.consume(20, 0));
+        // Paid back after one second
+        ASSERT_EQUALS(0, bucket.consume(0, 1000000));
+        ASSERT_EQUALS(100000, bucket.consume(1, 1000000));
+    }
+
+    TEST(TokenBucket, RefillIsCapped) {
+        TokenBucket bucket;
+        bucket.setRate(10);
+        ASSERT_EQUALS(0, bucket.consume(10, 0));
+        // A long idle time only refills one second worth of tokens
+        ASSERT_EQUALS(0, bucket.consume(10, 60 * 1000000LL));
+        ASSERT_EQUALS(100000, bucket.consume(1, 60 * 1000000LL));
+    }
+
+    TEST(TokenBucket, ClockGoingBack) {
+        TokenBucket bucket;
+        bucket.setRate(10);
+        ASSERT_EQUALS(0, bucket.consume(10, 1000000));
+        ASSERT_EQUALS(100000, bucket.consume(1, 0));
+    }
+
+    TEST(TokenBucket, LowerRateCapsTokens) {
+        TokenBucket bucket;
+        bucket.setRate(100);
+        ASSERT_EQUALS(0, bucket.consume(0, 0));
+        bucket.setRate(10);
+        ASSERT_EQUALS(0, bucket.consume(10, 0));
+        ASSERT_EQUALS(100000, bucket.consume(1, 0));
+    }
+
+} // namespace
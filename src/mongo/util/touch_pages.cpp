@@ -28,11 +28,23 @@
 
 #include "mongo/util/touch_pages.h"
 
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace mongo {
 
     char _touch_pages_char_reader; // goes in .bss
 
     void touch_pages( const char* buf, size_t length, size_t pageSize ) {
+#if !defined(_WIN32)
+        // Have the kernel read the whole range ahead in large requests, so the loop below mostly
+        // finds pages already resident rather than faulting them in one at a time.
+        static const size_t systemPageSize = sysconf( _SC_PAGESIZE );
+        const size_t misalignment = reinterpret_cast<size_t>( buf ) % systemPageSize;
+        madvise( const_cast<char*>( buf - misalignment ), length + misalignment, MADV_WILLNEED );
+#endif
         // read first byte of every page, in order
         for( size_t i = 0; i < length; i += pageSize ) {
             _touch_pages_char_reader += buf[i];
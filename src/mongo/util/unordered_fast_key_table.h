@@ -31,7 +31,13 @@
 
 #include <boost/smart_ptr/scoped_array.hpp>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MONGO_UNORDERED_FAST_KEY_TABLE_SSE2
+#include <emmintrin.h>
+#endif
+
 #include "mongo/base/disallow_copying.h"
+#include "mongo/platform/bits.h"
 
 namespace mongo {
 
@@ -42,6 +48,85 @@ namespace mongo {
         }
     };
 
+    /**
+     * The control bytes of kWidth consecutive slots of an UnorderedFastKeyTable.
+     *
+     * Every slot has a control byte: kEmpty, kDeleted, or for a used slot the low 7 bits of the
+     * hash of its key.  A lookup compares a whole group of control bytes against those 7 bits at
+     * once (with SSE2 where the compiler targets it), and only compares keys for the slots that
+     * match.
+     */
+    class UnorderedFastKeyTableGroup {
+    public:
+        enum {
+            kWidth = 16,
+            kEmpty = -128,
+            kDeleted = -2,
+        };
+
+        explicit UnorderedFastKeyTableGroup( const signed char* ctrl ) {
+#ifdef MONGO_UNORDERED_FAST_KEY_TABLE_SSE2
+            _ctrl = _mm_loadu_si128( reinterpret_cast<const __m128i*>( ctrl ) );
+#else
+            _ctrl = ctrl;
+#endif
+        }
+
+        /**
+         * @return a bitmask of the slots whose control byte is "h2"
+         */
+        unsigned match( signed char h2 ) const {
+#ifdef MONGO_UNORDERED_FAST_KEY_TABLE_SSE2
+            return _mm_movemask_epi8( _mm_cmpeq_epi8( _ctrl, _mm_set1_epi8( h2 ) ) );
+#else
+            unsigned mask = 0;
+            for ( unsigned i = 0; i < kWidth; i++ ) {
+                if ( _ctrl[i] == h2 )
+                    mask |= 1U << i;
+            }
+            return mask;
+#endif
+        }
+
+        /**
+         * @return a bitmask of the empty slots
+         */
+        unsigned matchEmpty() const {
+            return match( static_cast<signed char>( kEmpty ) );
+        }
+
+        /**
+         * @return a bitmask of the slots that are empty or deleted
+         */
+        unsigned matchUnused() const {
+#ifdef MONGO_UNORDERED_FAST_KEY_TABLE_SSE2
+            // Only the unused control bytes are negative.
+            return _mm_movemask_epi8( _ctrl );
+#else
+            unsigned mask = 0;
+            for ( unsigned i = 0; i < kWidth; i++ ) {
+                if ( _ctrl[i] < 0 )
+                    mask |= 1U << i;
+            }
+            return mask;
+#endif
+        }
+
+        /**
+         * @return the index of the lowest set bit of a non-zero mask
+         */
+        static unsigned lowestBit( unsigned mask ) {
+            return countTrailingZeros64( mask );
+        }
+
+    private:
+#ifdef MONGO_UNORDERED_FAST_KEY_TABLE_SSE2
+        __m128i _ctrl;
+#else
+        const signed char* _ctrl;
+#endif
+    };
+
     template< typename K_L, // key lookup
               typename K_S, // key storage
               typename V, // value
@@ -57,34 +142,64 @@ namespace mongo {
         typedef V mapped_type;
 
     private:
-        struct Entry {
-            Entry()
-                : used( false ), everUsed( false ) {
-            }
+        typedef UnorderedFastKeyTableGroup Group;
 
-            bool used;
-            bool everUsed;
+        struct Entry {
             size_t curHash;
             value_type data;
         };
 
+        /**
+         * The slots, in groups of Group::kWidth.  A key is looked up starting at the group picked
+         * by the high bits of its hash, and moving on to other groups only while they are full.
+         */
         struct Area {
-            Area( unsigned capacity, double maxProbeRatio );
+            explicit Area( unsigned capacity );
             Area( const Area& other );
 
-            int find( const K_L& key, size_t hash, int* firstEmpty, const UnorderedFastKeyTable& sm ) const;
+            /**
+             * @return offset into _entries or -1 if not there
+             */
+            int find( const K_L& key, size_t hash, const UnorderedFastKeyTable& sm ) const;
 
-            bool transfer( Area* newArea, const UnorderedFastKeyTable& sm ) const;
+            /**
+             * @return the first unused slot on the probe sequence for "hash"
+             */
+            unsigned findUnused( size_t hash ) const;
+
+            /**
+             * Marks "pos", which must be unused, as holding a key with "hash".
+             */
+            void setUsed( unsigned pos, size_t hash );
+
+            /**
+             * Marks "pos", which must be used, as unused.
+             */
+            void setUnused( unsigned pos );
+
+            bool isUsed( unsigned pos ) const { return _ctrl[pos] >= 0; }
+
+            void transfer( Area* newArea ) const;
 
             void swap( Area* other ) {
                 using std::swap;
                 swap( _capacity, other->_capacity );
-                swap( _maxProbe, other->_maxProbe );
+                swap( _growthLeft, other->_growthLeft );
+                swap( _ctrl, other->_ctrl );
                 swap( _entries, other->_entries );
             }
 
-            unsigned _capacity;
-            unsigned _maxProbe;
+            static signed char h2( size_t hash ) { return static_cast<signed char>( hash & 0x7f ); }
+
+            /**
+             * @return how many slots of "capacity" may be filled (used or deleted) before
+             *         probe sequences get too long
+             */
+            static unsigned maxLoad( unsigned capacity ) { return capacity - capacity / 8; }
+
+            unsigned _capacity; // a power of two, at least Group::kWidth
+            unsigned _growthLeft; // empty slots that may be filled before we rehash
+            boost::scoped_array<signed char> _ctrl;
             boost::scoped_array<Entry> _entries;
         };
 
@@ -93,12 +208,9 @@ namespace mongo {
 
         /**
          * @param startingCapacity how many buckets should exist on initial creation
-         *                         DEFAULT_STARTING_CAPACITY
-         * @param maxProbeRatio the percentage of buckets we're willing to probe
-         *                      no defined default as you can't have a static const double on windows
+         *                         DEFAULT_STARTING_CAPACITY, rounded up to a power of two
          */
-        UnorderedFastKeyTable( unsigned startingCapacity = DEFAULT_STARTING_CAPACITY,
-                               double maxProbeRatio = 0.05 );
+        UnorderedFastKeyTable( unsigned startingCapacity = DEFAULT_STARTING_CAPACITY );
 
         UnorderedFastKeyTable( const UnorderedFastKeyTable& other );
 
@@ -173,7 +285,7 @@ namespace mongo {
 
             void _skip() {
                 while ( true ) {
-                    if ( _area->_entries[_position].used )
+                    if ( _area->isUsed( _position ) )
                         break;
                     if ( _position >= _max ) {
                         _position = -1;
@@ -200,19 +312,15 @@ namespace mongo {
         const_iterator end() const;
 
     private:
-        /*
-         * @param firstEmpty, if we return -1, and firstEmpty != NULL,
-         *                    this will be set to the first empty bucket we found
-         * @retrun offset into _entries or -1 if not there
+        /**
+         * Makes room for at least one more entry, by dropping deleted slots or, if the table is
+         * mostly in use, doubling its capacity.
          */
-        int _find( const K_L& key, int hash, int* firstEmpty ) const;
-
-        void _grow();
+        void _rehash();
 
         // ----
 
         size_t _size;
-        double _maxProbeRatio;
         Area _area;
 
         H _hash;
@@ -224,4 +332,3 @@ namespace mongo {
 }
 
 #include "mongo/util/unordered_fast_key_table_internal.h"
-
@@ -28,103 +28,134 @@
  *    then also delete it in the license file.
  */
 
+#include <cstring>
+
 #include "mongo/util/assert_util.h"
 
 namespace mongo {
+
+    inline unsigned unorderedFastKeyTableCapacity( unsigned startingCapacity ) {
+        unsigned capacity = UnorderedFastKeyTableGroup::kWidth;
+        while ( capacity < startingCapacity )
+            capacity *= 2;
+        return capacity;
+    }
+
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
-    inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::Area(unsigned capacity,
-                                                                   double maxProbeRatio)
+    inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::Area( unsigned capacity )
         : _capacity( capacity ),
-          _maxProbe( static_cast<unsigned>( capacity * maxProbeRatio ) ),
+          _growthLeft( maxLoad( capacity ) ),
+          _ctrl( new signed char[_capacity] ),
           _entries( new Entry[_capacity] ) {
+        MONGO_dassert( _capacity % Group::kWidth == 0 );
+        MONGO_dassert( ( _capacity & ( _capacity - 1 ) ) == 0 );
+        memset( _ctrl.get(), Group::kEmpty, _capacity );
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
-    inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::Area(const Area& other )
+    inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::Area( const Area& other )
         : _capacity( other._capacity ),
-          _maxProbe( other._maxProbe ),
+          _growthLeft( other._growthLeft ),
+          _ctrl( new signed char[_capacity] ),
           _entries( new Entry[_capacity] ) {
+        memcpy( _ctrl.get(), other._ctrl.get(), _capacity );
         for ( unsigned i = 0; i < _capacity; i++ ) {
-            _entries[i] = other._entries[i];
+            if ( isUsed( i ) )
+                _entries[i] = other._entries[i];
         }
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
-    inline int UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::find(
-            const K_L& key,
-            size_t hash,
-            int* firstEmpty,
-            const UnorderedFastKeyTable& sm ) const {
-        if ( firstEmpty )
-            *firstEmpty = -1;
+    inline int UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::find( const K_L& key,
+                                 size_t hash,
+                                 const UnorderedFastKeyTable& sm ) const {
+        const unsigned groupMask = _capacity / Group::kWidth - 1;
+        unsigned group = ( hash >> 7 ) & groupMask;
+
+        // Triangular probing visits every group once when the number of groups is a power of 2.
+        for ( unsigned probe = 1; probe <= groupMask + 1; probe++ ) {
+            const unsigned base = group * Group::kWidth;
+            const Group g( &_ctrl[base] );
+
+            for ( unsigned m = g.match( h2( hash ) ); m; m &= m - 1 ) {
+                const unsigned pos = base + Group::lowestBit( m );
+                if ( _entries[pos].curHash == hash &&
+                     sm._equals( key, sm._convertor( _entries[pos].data.first ) ) ) {
+                    return pos;
+                }
+            }
 
-        for ( unsigned probe = 0; probe < _maxProbe; probe++ ) {
-            unsigned pos = (hash + probe) % _capacity;
+            // A key is only ever placed past a group that was full.
+            if ( g.matchEmpty() )
+                return -1;
 
-            if ( ! _entries[pos].used ) {
-                // space is empty
-                if ( firstEmpty && *firstEmpty == -1 )
-                    *firstEmpty = pos;
-                if ( ! _entries[pos].everUsed )
-                    return -1;
-                continue;
-            }
+            group = ( group + probe ) & groupMask;
+        }
+        return -1;
+    }
 
-            if ( _entries[pos].curHash != hash ) {
-                // space has something else
-                continue;
-            }
+    template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
+    inline unsigned UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::findUnused( size_t hash ) const {
+        const unsigned groupMask = _capacity / Group::kWidth - 1;
+        unsigned group = ( hash >> 7 ) & groupMask;
+
+        for ( unsigned probe = 1; ; probe++ ) {
+            const unsigned base = group * Group::kWidth;
+            const unsigned m = Group( &_ctrl[base] ).matchUnused();
+            if ( m )
+                return base + Group::lowestBit( m );
+
+            // The load limit guarantees that some group has an unused slot.
+            MONGO_dassert( probe <= groupMask );
+            group = ( group + probe ) & groupMask;
+        }
+    }
 
-            if ( ! sm._equals(key, sm._convertor( _entries[pos].data.first ) ) ) {
-                // hashes match
-                // strings are not equals
-                continue;
-            }
+    template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
+    inline void UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::setUsed( unsigned pos, size_t hash ) {
+        if ( _ctrl[pos] == Group::kEmpty )
+            _growthLeft--;
+        _ctrl[pos] = h2( hash );
+        _entries[pos].curHash = hash;
+    }
 
-            // hashes and strings are equal
-            // yay!
-            return pos;
+    template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
+    inline void UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::setUnused( unsigned pos ) {
+        // If this slot's group still has an empty slot, it was never full, so no probe sequence
+        // went past it and the slot can be empty again.  Otherwise leave a tombstone, which
+        // lookups step over.
+        const unsigned base = pos - pos % Group::kWidth;
+        if ( Group( &_ctrl[base] ).matchEmpty() ) {
+            _ctrl[pos] = Group::kEmpty;
+            _growthLeft++;
         }
-        return -1;
+        else {
+            _ctrl[pos] = Group::kDeleted;
+        }
+        _entries[pos].data = value_type();
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
-    inline bool UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::transfer(
-            Area* newArea,
-            const UnorderedFastKeyTable& sm) const {
+    inline void UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::transfer( Area* newArea ) const {
         for ( unsigned i = 0; i < _capacity; i++ ) {
-            if ( ! _entries[i].used )
+            if ( ! isUsed( i ) )
                 continue;
 
-            int firstEmpty = -1;
-            int loc = newArea->find( sm._convertor( _entries[i].data.first ),
-                                     _entries[i].curHash,
-                                     &firstEmpty,
-                                     sm );
-
-            verify( loc == -1 );
-            if ( firstEmpty < 0 ) {
-                return false;
-            }
-
-            newArea->_entries[firstEmpty] = _entries[i];
+            const unsigned pos = newArea->findUnused( _entries[i].curHash );
+            newArea->setUsed( pos, _entries[i].curHash );
+            newArea->_entries[pos].data = _entries[i].data;
         }
-        return true;
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
-    inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::UnorderedFastKeyTable(
-            unsigned startingCapacity,
-            double maxProbeRatio)
-        : _maxProbeRatio( maxProbeRatio ), _area( startingCapacity, maxProbeRatio ) {
+    inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::UnorderedFastKeyTable( unsigned startingCapacity )
+        : _area( unorderedFastKeyTableCapacity( startingCapacity ) ) {
         _size = 0;
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
-    inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::UnorderedFastKeyTable(
-            const UnorderedFastKeyTable& other )
+    inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::UnorderedFastKeyTable( const UnorderedFastKeyTable& other )
         : _size( other._size ),
-          _maxProbeRatio( other._maxProbeRatio ),
           _area( other._area ),
           _hash( other._hash ),
           _equals( other._equals ),
@@ -135,7 +166,6 @@ namespace mongo {
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
     inline void UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::copyTo( UnorderedFastKeyTable* out ) const {
         out->_size = _size;
-        out->_maxProbeRatio = _maxProbeRatio;
         Area x( _area );
         out->_area.swap( &x );
     }
@@ -145,69 +175,57 @@ namespace mongo {
 
         const size_t hash = _hash( key );
 
-        for ( int numGrowTries = 0; numGrowTries < 5; numGrowTries++ ) {
-            int firstEmpty = -1;
-            int pos = _area.find( key, hash, &firstEmpty, *this );
-            if ( pos >= 0 )
-                return _area._entries[pos].data.second;
-
-            // key not in map
-            // need to add
-            if ( firstEmpty >= 0 ) {
-                _size++;
-                _area._entries[firstEmpty].used = true;
-                _area._entries[firstEmpty].everUsed = true;
-                _area._entries[firstEmpty].curHash = hash;
-                _area._entries[firstEmpty].data.first = _convertorOther(key);
-                return _area._entries[firstEmpty].data.second;
-            }
+        int pos = _area.find( key, hash, *this );
+        if ( pos >= 0 )
+            return _area._entries[pos].data.second;
 
-            // no space left in map
-            _grow();
+        // key not in map
+        // need to add
+        unsigned slot = _area.findUnused( hash );
+        if ( _area._ctrl[slot] == Group::kEmpty && _area._growthLeft == 0 ) {
+            _rehash();
+            slot = _area.findUnused( hash );
         }
-        msgasserted( 16471, "UnorderedFastKeyTable couldn't add entry after growing many times" );
+
+        _size++;
+        _area.setUsed( slot, hash );
+        _area._entries[slot].data.first = _convertorOther(key);
+        return _area._entries[slot].data.second;
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
     inline size_t UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::erase( const K_L& key ) {
 
         const size_t hash = _hash( key );
-        int pos = _area.find( key, hash, NULL, *this );
+        int pos = _area.find( key, hash, *this );
 
         if ( pos < 0 )
             return 0;
 
         --_size;
-        _area._entries[pos].used = false;
-        _area._entries[pos].data.second = V();
+        _area.setUnused( pos );
         return 1;
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
     void UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::erase( const_iterator it ) {
-        dassert(it._position >= 0);
-        dassert(it._area == &_area);
+        MONGO_dassert(it._position >= 0);
+        MONGO_dassert(it._area == &_area);
 
         --_size;
-        _area._entries[it._position].used = false;
-        _area._entries[it._position].data.second = V();
+        _area.setUnused( it._position );
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
-    inline void UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::_grow() {
+    inline void UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::_rehash() {
+        // Only grow if at least half the load is live entries rather than tombstones.
         unsigned capacity = _area._capacity;
-        for ( int numGrowTries = 0; numGrowTries < 5; numGrowTries++ ) {
+        if ( _size >= Area::maxLoad( capacity ) / 2 )
             capacity *= 2;
-            Area newArea( capacity, _maxProbeRatio );
-            bool success = _area.transfer( &newArea, *this );
-            if ( !success ) {
-                continue;
-            }
-            _area.swap( &newArea );
-            return;
-        }
-        msgasserted( 16845,
-                     "UnorderedFastKeyTable::_grow couldn't add entry after growing many times" );
+
+        Area newArea( capacity );
+        _area.transfer( &newArea );
+        _area.swap( &newArea );
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
@@ -215,7 +233,7 @@ namespace mongo {
     UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::find( const K_L& key ) const {
         if ( _size == 0 )
             return const_iterator();
-        int pos = _area.find( key, _hash(key), 0, *this );
+        int pos = _area.find( key, _hash(key), *this );
         if ( pos < 0 )
             return const_iterator();
         return const_iterator( &_area, pos );